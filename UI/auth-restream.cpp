@@ -123,7 +123,6 @@ void RestreamAuth::LoadUI()
 	OBSBasic::InitBrowserPanelSafeBlock();
 	OBSBasic *main = OBSBasic::Get();
 
-	QCefWidget *browser;
 	std::string url;
 	std::string script;
 
@@ -141,8 +140,7 @@ void RestreamAuth::LoadUI()
 	chat->setWindowTitle(QTStr("Auth.Chat"));
 	chat->setAllowedAreas(Qt::AllDockWidgetAreas);
 
-	browser = cef->create_widget(chat.data(), url, panel_cookies);
-	chat->SetWidget(browser);
+	chat->SetDeferredWidget(url, panel_cookies);
 
 	main->addDockWidget(Qt::RightDockWidgetArea, chat.data());
 	chatMenu.reset(main->AddDockWidget(chat.data()));
@@ -158,8 +156,7 @@ void RestreamAuth::LoadUI()
 	info->setWindowTitle(QTStr("Auth.StreamInfo"));
 	info->setAllowedAreas(Qt::AllDockWidgetAreas);
 
-	browser = cef->create_widget(info.data(), url, panel_cookies);
-	info->SetWidget(browser);
+	info->SetDeferredWidget(url, panel_cookies);
 
 	main->addDockWidget(Qt::LeftDockWidgetArea, info.data());
 	infoMenu.reset(main->AddDockWidget(info.data()));
@@ -175,8 +172,7 @@ void RestreamAuth::LoadUI()
 	channels->setWindowTitle(QTStr("RestreamAuth.Channels"));
 	channels->setAllowedAreas(Qt::AllDockWidgetAreas);
 
-	browser = cef->create_widget(channels.data(), url, panel_cookies);
-	channels->SetWidget(browser);
+	channels->SetDeferredWidget(url, panel_cookies);
 
 	main->addDockWidget(Qt::LeftDockWidgetArea, channels.data());
 	channelMenu.reset(main->AddDockWidget(channels.data()));
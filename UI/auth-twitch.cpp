@@ -206,7 +206,6 @@ void TwitchAuth::LoadUI()
 	OBSBasic::InitBrowserPanelSafeBlock();
 	OBSBasic *main = OBSBasic::Get();
 
-	QCefWidget *browser;
 	std::string url;
 	std::string script;
 
@@ -240,8 +239,6 @@ void TwitchAuth::LoadUI()
 	chat->setWindowTitle(QTStr("Auth.Chat"));
 	chat->setAllowedAreas(Qt::AllDockWidgetAreas);
 
-	browser = cef->create_widget(chat.data(), url, panel_cookies);
-	chat->SetWidget(browser);
 	cef->add_force_popup_url(moderation_tools_url, chat.data());
 
 	if (App()->IsThemeDark()) {
@@ -259,7 +256,7 @@ void TwitchAuth::LoadUI()
 			script += ffz_script;
 	}
 
-	browser->setStartupScript(script);
+	chat->SetDeferredWidget(url, panel_cookies, script);
 
 	main->addDockWidget(Qt::RightDockWidgetArea, chat.data());
 	chatMenu.reset(main->AddDockWidget(chat.data()));
@@ -288,7 +285,6 @@ void TwitchAuth::LoadSecondaryUIPanes()
 {
 	OBSBasic *main = OBSBasic::Get();
 
-	QCefWidget *browser;
 	std::string url;
 	std::string script;
 
@@ -328,9 +324,7 @@ void TwitchAuth::LoadSecondaryUIPanes()
 	info->setWindowTitle(QTStr("Auth.StreamInfo"));
 	info->setAllowedAreas(Qt::AllDockWidgetAreas);
 
-	browser = cef->create_widget(info.data(), url, panel_cookies);
-	info->SetWidget(browser);
-	browser->setStartupScript(script);
+	info->SetDeferredWidget(url, panel_cookies, script);
 
 	main->addDockWidget(Qt::RightDockWidgetArea, info.data());
 	infoMenu.reset(main->AddDockWidget(info.data()));
@@ -348,9 +342,7 @@ void TwitchAuth::LoadSecondaryUIPanes()
 	stat->setWindowTitle(QTStr("TwitchAuth.Stats"));
 	stat->setAllowedAreas(Qt::AllDockWidgetAreas);
 
-	browser = cef->create_widget(stat.data(), url, panel_cookies);
-	stat->SetWidget(browser);
-	browser->setStartupScript(script);
+	stat->SetDeferredWidget(url, panel_cookies, script);
 
 	main->addDockWidget(Qt::RightDockWidgetArea, stat.data());
 	statMenu.reset(main->AddDockWidget(stat.data()));
@@ -369,9 +361,7 @@ void TwitchAuth::LoadSecondaryUIPanes()
 	feed->setWindowTitle(QTStr("TwitchAuth.Feed"));
 	feed->setAllowedAreas(Qt::AllDockWidgetAreas);
 
-	browser = cef->create_widget(feed.data(), url, panel_cookies);
-	feed->SetWidget(browser);
-	browser->setStartupScript(script);
+	feed->SetDeferredWidget(url, panel_cookies, script);
 
 	main->addDockWidget(Qt::RightDockWidgetArea, feed.data());
 	feedMenu.reset(main->AddDockWidget(feed.data()));
@@ -1,5 +1,4 @@
 #include <QFile>
-#include <QTextStream>
 #include <QScrollBar>
 #include <QFont>
 #include <QFontDatabase>
@@ -12,6 +11,13 @@
 #include "log-viewer.hpp"
 #include "qt-wrappers.hpp"
 
+/* Older lines are dropped from the view (not the file) past this point */
+#define MAX_LOG_LINES 20000
+/* Only the end of the current log is loaded when the viewer is opened */
+#define MAX_LOG_LOAD_SIZE (4 * 1024 * 1024)
+/* New lines are added in batches at most this often */
+#define FLUSH_INTERVAL_MS 100
+
 OBSLogViewer::OBSLogViewer(QWidget *parent)
 	: QDialog(parent), ui(new Ui::OBSLogViewer)
 {
@@ -20,6 +26,12 @@ OBSLogViewer::OBSLogViewer(QWidget *parent)
 	setAttribute(Qt::WA_DeleteOnClose);
 
 	ui->setupUi(this);
+	ui->textArea->setMaximumBlockCount(MAX_LOG_LINES);
+
+	flushTimer.setSingleShot(true);
+	flushTimer.setInterval(FLUSH_INTERVAL_MS);
+	connect(&flushTimer, &QTimer::timeout, this,
+		&OBSLogViewer::FlushLines);
 
 	bool showLogViewerOnStartup = config_get_bool(
 		App()->GlobalConfig(), "LogViewer", "ShowLogStartup");
@@ -65,23 +77,27 @@ void OBSLogViewer::InitLog()
 	QFile file(QT_UTF8(path.c_str()));
 
 	if (file.open(QIODevice::ReadOnly)) {
-		QTextStream in(&file);
-#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
-		in.setCodec("UTF-8");
-#endif
+		qint64 size = file.size();
+		bool partial = size > MAX_LOG_LOAD_SIZE;
+
+		if (partial)
+			file.seek(size - MAX_LOG_LOAD_SIZE);
+
+		QByteArray data = file.readAll();
+		file.close();
+
+		/* skip the line the seek landed in the middle of */
+		if (partial) {
+			int start = data.indexOf('\n');
+			data.remove(0, start + 1);
+		}
 
 		QTextDocument *doc = ui->textArea->document();
 		QTextCursor cursor(doc);
 		cursor.movePosition(QTextCursor::End);
-		cursor.beginEditBlock();
-		while (!in.atEnd()) {
-			QString line = in.readLine();
-			cursor.insertText(line);
+		cursor.insertText(QString::fromUtf8(data));
+		if (!data.isEmpty() && !data.endsWith('\n'))
 			cursor.insertBlock();
-		}
-		cursor.endEditBlock();
-
-		file.close();
 	}
 	QScrollBar *scroll = ui->textArea->verticalScrollBar();
 	scroll->setValue(scroll->maximum());
@@ -105,20 +121,32 @@ void OBSLogViewer::AddLine(int type, const QString &str)
 		break;
 	}
 
+	pendingLines << msg;
+
+	if (!flushTimer.isActive())
+		flushTimer.start();
+}
+
+void OBSLogViewer::FlushLines()
+{
+	if (pendingLines.isEmpty())
+		return;
+
 	QScrollBar *scroll = ui->textArea->verticalScrollBar();
 	bool bottomScrolled = scroll->value() >= scroll->maximum() - 10;
 
-	if (bottomScrolled)
-		scroll->setValue(scroll->maximum());
-
 	QTextDocument *doc = ui->textArea->document();
 	QTextCursor cursor(doc);
 	cursor.movePosition(QTextCursor::End);
 	cursor.beginEditBlock();
-	cursor.insertHtml(msg);
-	cursor.insertBlock();
+	for (const QString &msg : pendingLines) {
+		cursor.insertHtml(msg);
+		cursor.insertBlock();
+	}
 	cursor.endEditBlock();
 
+	pendingLines.clear();
+
 	if (bottomScrolled)
 		scroll->setValue(scroll->maximum());
 }
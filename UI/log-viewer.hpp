@@ -2,6 +2,8 @@
 
 #include <QDialog>
 #include <QPlainTextEdit>
+#include <QStringList>
+#include <QTimer>
 #include "obs-app.hpp"
 
 #include "ui_OBSLogViewer.h"
@@ -11,10 +13,14 @@ class OBSLogViewer : public QDialog {
 
 	std::unique_ptr<Ui::OBSLogViewer> ui;
 
+	QTimer flushTimer;
+	QStringList pendingLines;
+
 	void InitLog();
 
 private slots:
 	void AddLine(int type, const QString &text);
+	void FlushLines();
 	void on_openButton_clicked();
 	void on_showStartup_clicked(bool checked);
 
@@ -25,6 +25,8 @@ Multiview::~Multiview()
 	gs_vertexbuffer_destroy(leftLine);
 	gs_vertexbuffer_destroy(topLine);
 	gs_vertexbuffer_destroy(rightLine);
+	gs_texrender_destroy(previewTexrender);
+	gs_texrender_destroy(atlasTexrender);
 	obs_leave_graphics();
 }
 
@@ -65,11 +67,13 @@ static OBSSource CreateLabel(const char *name, size_t h)
 }
 
 void Multiview::Update(MultiviewLayout multiviewLayout, bool drawLabel,
-		       bool drawSafeArea)
+		       bool drawSafeArea, int sceneFPS)
 {
 	this->multiviewLayout = multiviewLayout;
 	this->drawLabel = drawLabel;
 	this->drawSafeArea = drawSafeArea;
+	this->sceneFPS = sceneFPS;
+	atlasDirty = true;
 
 	multiviewScenes.clear();
 	multiviewLabels.clear();
@@ -227,6 +231,75 @@ void Multiview::Render(uint32_t cx, uint32_t cy)
 	OBSSource programSrc = main->GetProgramSource();
 	bool studioMode = main->IsPreviewProgramMode();
 
+	// The main texture already holds the program scene unless a
+	// transition is in progress, so it doesn't need rendering again
+	OBSSourceAutoRelease transition = obs_get_output_source(0);
+	OBSSourceAutoRelease transitionSrc =
+		obs_transition_get_source(transition, OBS_TRANSITION_SOURCE_A);
+	OBSSourceAutoRelease transitionDest =
+		obs_transition_get_source(transition, OBS_TRANSITION_SOURCE_B);
+	bool programTexture = programSrc && transitionSrc == programSrc &&
+			      !transitionDest && obs_get_main_texture();
+
+	auto renderPreviewTexture = [&]() {
+		const uint32_t srcCX = obs_source_get_width(previewSrc);
+		const uint32_t srcCY = obs_source_get_height(previewSrc);
+		const enum gs_color_space space = gs_get_color_space();
+		const enum gs_color_format format =
+			gs_get_format_from_space(space);
+
+		if (previewTexrender &&
+		    gs_texrender_get_format(previewTexrender) != format) {
+			gs_texrender_destroy(previewTexrender);
+			previewTexrender = nullptr;
+		}
+		if (!previewTexrender)
+			previewTexrender =
+				gs_texrender_create(format, GS_ZS_NONE);
+
+		gs_texrender_reset(previewTexrender);
+		if (!gs_texrender_begin_with_color_space(
+			    previewTexrender, srcCX, srcCY, space))
+			return false;
+
+		struct vec4 clearColor;
+		vec4_zero(&clearColor);
+		gs_clear(GS_CLEAR_COLOR, &clearColor, 0.0f, 0);
+		gs_ortho(0.0f, float(srcCX), 0.0f, float(srcCY), -100.0f,
+			 100.0f);
+		obs_source_video_render(previewSrc);
+		gs_texrender_end(previewTexrender);
+		return true;
+	};
+
+	auto drawTexture = [&](gs_texture_t *tex, uint32_t x, uint32_t y,
+			       uint32_t cx, uint32_t cy) {
+		gs_effect_t *effect = obs_get_base_effect(OBS_EFFECT_DEFAULT);
+		gs_eparam_t *image =
+			gs_effect_get_param_by_name(effect, "image");
+
+		const bool previous = gs_framebuffer_srgb_enabled();
+		gs_enable_framebuffer_srgb(true);
+		gs_effect_set_texture_srgb(image, tex);
+
+		gs_blend_state_push();
+		gs_blend_function(GS_BLEND_ONE, GS_BLEND_INVSRCALPHA);
+		while (gs_effect_loop(effect, "Draw"))
+			gs_draw_sprite_subregion(tex, 0, x, y, cx, cy);
+		gs_blend_state_pop();
+
+		gs_enable_framebuffer_srgb(previous);
+	};
+
+	auto drawPreviewTexture = [&]() {
+		gs_texture_t *tex = gs_texrender_get_texture(previewTexrender);
+		drawTexture(tex, 0, 0, gs_texture_get_width(tex),
+			    gs_texture_get_height(tex));
+	};
+
+	bool previewTexture = studioMode && previewSrc &&
+			      renderPreviewTexture();
+
 	auto drawBox = [&](float cx, float cy, uint32_t colorVal) {
 		gs_effect_t *solid = obs_get_base_effect(OBS_EFFECT_SOLID);
 		gs_eparam_t *color =
@@ -251,6 +324,112 @@ void Multiview::Render(uint32_t cx, uint32_t cy)
 		startRegion(vX, vY, vCX, vCY, oL, oR, oT, oB);
 	};
 
+	// Renders a share of the scene cells into one texture each frame, so
+	// every scene is updated sceneFPS times a second instead of every
+	// frame.  The program and preview scenes are always drawn live.
+	auto renderAtlas = [&]() {
+		const uint32_t cellCX = uint32_t(siCX * scale);
+		const uint32_t cellCY = uint32_t(siCY * scale);
+		const enum gs_color_space space = gs_get_color_space();
+		const enum gs_color_format format =
+			gs_get_format_from_space(space);
+
+		if (!cellCX || !cellCY)
+			return false;
+
+		uint32_t cols = 1;
+		while (cols * cols < maxSrcs)
+			cols++;
+		uint32_t rows = uint32_t((maxSrcs + cols - 1) / cols);
+
+		if (atlasTexrender &&
+		    gs_texrender_get_format(atlasTexrender) != format) {
+			gs_texrender_destroy(atlasTexrender);
+			atlasTexrender = nullptr;
+		}
+		if (!atlasTexrender) {
+			atlasTexrender =
+				gs_texrender_create(format, GS_ZS_NONE);
+			atlasDirty = true;
+		}
+		if (cols != atlasCols || cellCX != atlasCellCX ||
+		    cellCY != atlasCellCY) {
+			atlasCols = cols;
+			atlasCellCX = cellCX;
+			atlasCellCY = cellCY;
+			atlasDirty = true;
+		}
+
+		size_t count = numSrcs;
+		if (atlasDirty) {
+			atlasNextCell = 0;
+			atlasBudget = 0.0;
+		} else {
+			video_t *video = obs_get_video();
+			double fps = video_output_get_frame_rate(video);
+			if (fps > 0.0)
+				atlasBudget += double(numSrcs) * sceneFPS / fps;
+			else
+				atlasBudget = double(numSrcs);
+
+			count = size_t(atlasBudget);
+			atlasBudget -= double(count);
+			if (count > numSrcs)
+				count = numSrcs;
+			if (!count)
+				return true;
+		}
+
+		gs_texrender_reset(atlasTexrender);
+		if (!gs_texrender_begin_with_color_space(atlasTexrender,
+							 cols * cellCX,
+							 rows * cellCY, space))
+			return false;
+
+		for (size_t j = 0; j < count; j++) {
+			size_t i = atlasNextCell % numSrcs;
+			atlasNextCell = i + 1;
+
+			OBSSource src = OBSGetStrongRef(multiviewScenes[i]);
+			if (!atlasDirty && (src == programSrc ||
+					    (studioMode && src == previewSrc)))
+				continue;
+
+			gs_set_viewport(int(i % cols * cellCX),
+					int(i / cols * cellCY), int(cellCX),
+					int(cellCY));
+			gs_ortho(0.0f, fw, 0.0f, fh, -100.0f, 100.0f);
+
+			// The whole target is cleared by gs_clear, so
+			// overwrite just this cell instead
+			gs_blend_state_push();
+			gs_enable_blending(false);
+			drawBox(fw, fh, 0);
+			gs_blend_state_pop();
+
+			if (src)
+				obs_source_video_render(src);
+		}
+
+		gs_texrender_end(atlasTexrender);
+		atlasDirty = false;
+		return true;
+	};
+
+	auto drawAtlasCell = [&](size_t i) {
+		gs_texture_t *tex = gs_texrender_get_texture(atlasTexrender);
+
+		gs_matrix_push();
+		gs_matrix_scale3f(fw / float(atlasCellCX),
+				  fh / float(atlasCellCY), 1.0f);
+		drawTexture(tex, uint32_t(i % atlasCols * atlasCellCX),
+			    uint32_t(i / atlasCols * atlasCellCY), atlasCellCX,
+			    atlasCellCY);
+		gs_matrix_pop();
+	};
+
+	bool atlasTexture = sceneFPS > 0 && numSrcs && renderAtlas();
+
 	auto calcBaseSource = [&](size_t i) {
 		switch (multiviewLayout) {
 		case MultiviewLayout::HORIZONTAL_TOP_18_SCENES:
@@ -424,7 +603,15 @@ void Multiview::Render(uint32_t cx, uint32_t cy)
 		gs_matrix_translate3f(siX, siY, 0.0f);
 		gs_matrix_scale3f(siScaleX, siScaleY, 1.0f);
 		setRegion(siX, siY, siCX, siCY);
-		obs_source_video_render(src);
+		if (programTexture && src == programSrc)
+			obs_render_main_texture();
+		else if (previewTexture && src == previewSrc)
+			drawPreviewTexture();
+		else if (atlasTexture && src != programSrc &&
+			 !(studioMode && src == previewSrc))
+			drawAtlasCell(i);
+		else
+			obs_source_video_render(src);
 		endRegion();
 		gs_matrix_pop();
 
@@ -474,7 +661,9 @@ void Multiview::Render(uint32_t cx, uint32_t cy)
 	gs_matrix_translate3f(sourceX, sourceY, 0.0f);
 	gs_matrix_scale3f(ppiScaleX, ppiScaleY, 1.0f);
 	setRegion(sourceX, sourceY, ppiCX, ppiCY);
-	if (studioMode)
+	if (previewTexture)
+		drawPreviewTexture();
+	else if (studioMode)
 		obs_source_video_render(previewSrc);
 	else
 		obs_render_main_texture();
@@ -21,7 +21,7 @@ public:
 	Multiview();
 	~Multiview();
 	void Update(MultiviewLayout multiviewLayout, bool drawLabel,
-		    bool drawSafeArea);
+		    bool drawSafeArea, int sceneFPS = 0);
 	void Render(uint32_t cx, uint32_t cy);
 	OBSSource GetSourceByPosition(int x, int y);
 
@@ -36,6 +36,17 @@ private:
 	gs_vertbuffer_t *topLine = nullptr;
 	gs_vertbuffer_t *rightLine = nullptr;
 
+	// Studio mode preview, rendered once for both places it's shown
+	gs_texrender_t *previewTexrender = nullptr;
+
+	// Scene cells, updated round-robin at sceneFPS when it's set
+	int sceneFPS = 0;
+	gs_texrender_t *atlasTexrender = nullptr;
+	uint32_t atlasCols = 0, atlasCellCX = 0, atlasCellCY = 0;
+	size_t atlasNextCell = 0;
+	double atlasBudget = 0.0;
+	bool atlasDirty = true;
+
 	std::vector<OBSWeakSource> multiviewScenes;
 	std::vector<OBSSource> multiviewLabels;
 
@@ -83,6 +83,8 @@ bool portable_mode = false;
 static bool multi = false;
 static bool log_verbose = false;
 static bool unfiltered_log = false;
+static bool log_async = false;
+static bool profiler_trace = false;
 bool opt_start_streaming = false;
 bool opt_start_recording = false;
 bool opt_studio_mode = false;
@@ -400,7 +402,9 @@ static void do_log(int log_level, const char *msg, va_list args, void *param)
 #ifndef _WIN32
 		def_log_handler(log_level, msg, args2, nullptr);
 #endif
-		if (!too_many_repeated_entries(logFile, msg, str))
+		/* repeated entries are already collapsed by libobs when
+		 * logging asynchronously */
+		if (log_async || !too_many_repeated_entries(logFile, msg, str))
 			LogStringChunk(logFile, str, log_level);
 	}
 
@@ -428,6 +432,10 @@ bool OBSApp::InitGlobalConfigDefaults()
 				true);
 
 	config_set_default_bool(globalConfig, "General", "ConfirmOnExit", true);
+	config_set_default_bool(globalConfig, "General", "DeferSourceLoading",
+				true);
+	config_set_default_bool(globalConfig, "General",
+				"DiscardHiddenBrowserDocks", false);
 
 #if _WIN32
 	config_set_default_string(globalConfig, "Video", "Renderer",
@@ -494,6 +502,10 @@ bool OBSApp::InitGlobalConfigDefaults()
 	config_set_default_bool(globalConfig, "BasicWindow",
 				"MultiviewDrawAreas", true);
 
+	/* 0 renders every scene in the multiview every frame */
+	config_set_default_int(globalConfig, "BasicWindow",
+			       "MultiviewSceneFPS", 0);
+
 #ifdef _WIN32
 	uint32_t winver = GetWindowsVersion();
 
@@ -817,7 +829,7 @@ bool OBSApp::InitGlobalConfig()
 	}
 
 	if (changed)
-		config_save_safe(globalConfig, "tmp", nullptr);
+		config_save_safe_deferred(globalConfig, "tmp", nullptr);
 
 	return InitGlobalConfigDefaults();
 }
@@ -2064,6 +2076,9 @@ static void create_log_file(fstream &logFile)
 	if (logFile.is_open()) {
 		delete_oldest_file(false, "obs-studio/logs");
 		base_set_log_handler(do_log, &logFile);
+		base_set_log_repeat_limit(unfiltered_log ? 0 : 30);
+		base_set_log_async(true);
+		log_async = true;
 	} else {
 		blog(LOG_ERROR, "Failed to open log file");
 	}
@@ -2094,26 +2109,45 @@ ProfilerSnapshot GetSnapshot()
 	return ProfilerSnapshot{profile_snapshot_create(), SnapshotRelease};
 }
 
-static void SaveProfilerData(const ProfilerSnapshot &snap)
+static BPtr<char> GetProfilerDataPath(const char *extension)
 {
 	if (currentLogFile.empty())
-		return;
+		return nullptr;
 
 	auto pos = currentLogFile.rfind('.');
 	if (pos == currentLogFile.npos)
-		return;
+		return nullptr;
 
 #define LITERAL_SIZE(x) x, (sizeof(x) - 1)
 	ostringstream dst;
 	dst.write(LITERAL_SIZE("obs-studio/profiler_data/"));
 	dst.write(currentLogFile.c_str(), pos);
-	dst.write(LITERAL_SIZE(".csv.gz"));
+	dst << extension;
 #undef LITERAL_SIZE
 
-	BPtr<char> path = GetConfigPathPtr(dst.str().c_str());
+	return GetConfigPathPtr(dst.str().c_str());
+}
+
+static void SaveProfilerData(const ProfilerSnapshot &snap)
+{
+	BPtr<char> path = GetProfilerDataPath(".csv.gz");
+	if (!path)
+		return;
+
 	if (!profiler_snapshot_dump_csv_gz(snap.get(), path))
 		blog(LOG_WARNING, "Could not save profiler data to '%s'",
 		     static_cast<const char *>(path));
+
+	if (!profiler_trace)
+		return;
+
+	path = GetProfilerDataPath(".trace.json");
+	if (profiler_trace_dump_json(path))
+		blog(LOG_INFO, "Saved profiler trace to '%s'",
+		     static_cast<const char *>(path));
+	else
+		blog(LOG_WARNING, "Could not save profiler trace to '%s'",
+		     static_cast<const char *>(path));
 }
 
 static auto ProfilerFree = [](void *) {
@@ -2123,6 +2157,7 @@ static auto ProfilerFree = [](void *) {
 
 	profiler_print(snap.get());
 	profiler_print_time_between_calls(snap.get());
+	profiler_print_alloc_sites(snap.get(), 50);
 
 	SaveProfilerData(snap);
 
@@ -2151,6 +2186,8 @@ static int run_program(fstream &logFile, int argc, char *argv[])
 		static_cast<void *>(&ProfilerFree), ProfilerFree);
 
 	profiler_start();
+	if (profiler_trace)
+		profiler_trace_start();
 	profile_register_root(run_program_init, 0);
 
 	ScopeProfiler prof{run_program_init};
@@ -2939,6 +2976,12 @@ int main(int argc, char *argv[])
 		} else if (arg_is(argv[i], "--always-on-top", nullptr)) {
 			opt_always_on_top = true;
 
+		} else if (arg_is(argv[i], "--profiler-trace", nullptr)) {
+			profiler_trace = true;
+
+		} else if (arg_is(argv[i], "--track-allocations", nullptr)) {
+			bmem_start_tracking();
+
 		} else if (arg_is(argv[i], "--unfiltered_log", nullptr)) {
 			unfiltered_log = true;
 
@@ -3004,7 +3047,9 @@ int main(int argc, char *argv[])
 				"--multi, -m: Don't warn when launching multiple instances.\n\n"
 				"--verbose: Make log more verbose.\n"
 				"--always-on-top: Start in 'always on top' mode.\n\n"
-				"--unfiltered_log: Make log unfiltered.\n\n"
+				"--unfiltered_log: Make log unfiltered.\n"
+				"--track-allocations: Log where memory was allocated from on exit.\n"
+				"--profiler-trace: Save a trace of the last few seconds before exiting to the profiler data directory.\n\n"
 				"--disable-updater: Disable built-in updater (Windows/Mac only)\n\n"
 				"--disable-missing-files-check: Disable the missing files dialog which can appear on startup.\n\n"
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
@@ -3070,6 +3115,7 @@ int main(int argc, char *argv[])
 #endif
 
 	blog(LOG_INFO, "Number of memory leaks: %ld", bnum_allocs());
+	base_set_log_async(false);
 	base_set_log_handler(nullptr, nullptr);
 	return ret;
 }
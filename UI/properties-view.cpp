@@ -111,6 +111,8 @@ void OBSPropertiesView::RefreshProperties()
 	int h, v;
 	GetScrollPos(h, v);
 
+	refreshQueued = false;
+
 	children.clear();
 	if (widget)
 		widget->deleteLater();
@@ -192,6 +194,7 @@ OBSPropertiesView::OBSPropertiesView(OBSData settings_, obs_object_t *obj,
 	  minSize(minSize_)
 {
 	setFrameShape(QFrame::NoFrame);
+	InitVisUpdates();
 	QMetaObject::invokeMethod(this, "ReloadProperties",
 				  Qt::QueuedConnection);
 }
@@ -211,6 +214,7 @@ OBSPropertiesView::OBSPropertiesView(OBSData settings_, void *obj,
 	  minSize(minSize_)
 {
 	setFrameShape(QFrame::NoFrame);
+	InitVisUpdates();
 	QMetaObject::invokeMethod(this, "ReloadProperties",
 				  Qt::QueuedConnection);
 }
@@ -230,6 +234,56 @@ OBSPropertiesView::OBSPropertiesView(OBSData settings_, const char *type_,
 				  Qt::QueuedConnection);
 }
 
+OBSPropertiesView::~OBSPropertiesView()
+{
+	FlushVisUpdate();
+}
+
+/* Sliders and spin boxes can change many times per frame while dragged.
+ * Sending each change to the object straight away just makes it redo work
+ * nobody gets to see, so changes are sent at most once per video frame. */
+void OBSPropertiesView::InitVisUpdates()
+{
+	uint64_t interval_ns = obs_get_frame_interval_ns();
+	int interval_ms = interval_ns ? (int)(interval_ns / 1000000) : 16;
+
+	visUpdateTimer.setSingleShot(true);
+	visUpdateTimer.setInterval(interval_ms ? interval_ms : 1);
+	connect(&visUpdateTimer, &QTimer::timeout, this,
+		&OBSPropertiesView::FlushVisUpdate);
+}
+
+void OBSPropertiesView::QueueVisUpdate()
+{
+	if (!visUpdateTimer.isActive())
+		visUpdateTimer.start();
+}
+
+void OBSPropertiesView::FlushVisUpdate()
+{
+	if (!visUpdateTimer.isActive())
+		return;
+
+	visUpdateTimer.stop();
+
+	OBSObject strongObj = GetObject();
+	void *obj = strongObj ? strongObj.Get() : rawObj;
+	if (obj && visUpdateCb && !deferUpdate)
+		visUpdateCb(obj, settings);
+}
+
+/* Several controls can trigger a refresh before the queued one runs, and
+ * rebuilding every widget more than once for that is wasted work */
+void OBSPropertiesView::QueueRefresh()
+{
+	if (refreshQueued)
+		return;
+
+	refreshQueued = true;
+	QMetaObject::invokeMethod(this, "RefreshProperties",
+				  Qt::QueuedConnection);
+}
+
 void OBSPropertiesView::resizeEvent(QResizeEvent *event)
 {
 	emit PropertiesResized();
@@ -1968,10 +2022,8 @@ void WidgetInfo::ButtonClicked()
 	if (view->rawObj || view->weakObj) {
 		OBSObject strongObj = view->GetObject();
 		void *obj = strongObj ? strongObj.Get() : view->rawObj;
-		if (obs_property_button_clicked(property, obj)) {
-			QMetaObject::invokeMethod(view, "RefreshProperties",
-						  Qt::QueuedConnection);
-		}
+		if (obs_property_button_clicked(property, obj))
+			view->QueueRefresh();
 	}
 }
 
@@ -2067,19 +2119,14 @@ void WidgetInfo::ControlChanged()
 		blog(LOG_DEBUG, "No update timer or no callback!");
 	}
 
-	if (view->visUpdateCb && !view->deferUpdate) {
-		OBSObject strongObj = view->GetObject();
-		void *obj = strongObj ? strongObj.Get() : view->rawObj;
-		if (obj)
-			view->visUpdateCb(obj, view->settings);
-	}
+	if (view->visUpdateCb && !view->deferUpdate)
+		view->QueueVisUpdate();
 
 	view->SignalChanged();
 
 	if (obs_property_modified(property, view->settings)) {
 		view->lastFocused = setting;
-		QMetaObject::invokeMethod(view, "RefreshProperties",
-					  Qt::QueuedConnection);
+		view->QueueRefresh();
 	}
 }
 
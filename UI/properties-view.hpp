@@ -107,6 +107,13 @@ private:
 	std::string lastFocused;
 	QWidget *lastWidget = nullptr;
 	bool deferUpdate;
+	QTimer visUpdateTimer;
+	bool refreshQueued = false;
+
+	void InitVisUpdates();
+	void QueueVisUpdate();
+	void FlushVisUpdate();
+	void QueueRefresh();
 
 	QWidget *NewWidget(obs_property_t *prop, QWidget *widget,
 			   const char *signal);
@@ -165,6 +172,7 @@ public:
 	OBSPropertiesView(OBSData settings, const char *type,
 			  PropertiesReloadCallback reloadCallback,
 			  int minSize = 0);
+	~OBSPropertiesView();
 
 #define obj_constructor(type)                                              \
 	inline OBSPropertiesView(OBSData settings, obs_##type##_t *type,   \
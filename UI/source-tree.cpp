@@ -12,6 +12,8 @@
 
 #include <string>
 
+#include <QSet>
+
 #include <QLabel>
 #include <QLineEdit>
 #include <QSpacerItem>
@@ -692,17 +694,26 @@ void SourceTreeModel::SceneChanged()
 	obs_scene_enum_items(scene, enumItem, &items);
 	endResetModel();
 
-	UpdateGroupState(false);
 	st->ResetWidgets();
 
+	/* select everything in one go, selecting row by row emits a
+	 * selection change (and selects the scene item) for every row */
+	QItemSelection selection;
 	for (int i = 0; i < items.count(); i++) {
-		bool select = obs_sceneitem_selected(items[i]);
-		QModelIndex index = createIndex(i, 0);
+		if (!obs_sceneitem_selected(items[i]))
+			continue;
 
-		st->selectionModel()->select(
-			index, select ? QItemSelectionModel::Select
-				      : QItemSelectionModel::Deselect);
+		int end = i;
+		while (end + 1 < items.count() &&
+		       obs_sceneitem_selected(items[end + 1]))
+			end++;
+
+		selection.select(createIndex(i, 0), createIndex(end, 0));
+		i = end;
 	}
+
+	st->selectionModel()->select(selection,
+				     QItemSelectionModel::ClearAndSelect);
 }
 
 /* moves a scene item index (blame linux distros for using older Qt builds) */
@@ -722,9 +733,9 @@ void SourceTreeModel::ReorderItems()
 	QVector<OBSSceneItem> newitems;
 	obs_scene_enum_items(scene, enumItem, &newitems);
 
-	/* if item list has changed size, do full reset */
+	/* if items were added or removed, insert/remove just those rows */
 	if (newitems.count() != items.count()) {
-		SceneChanged();
+		UpdateItems();
 		return;
 	}
 
@@ -792,10 +803,75 @@ void SourceTreeModel::ReorderItems()
 	}
 }
 
+/* brings the list in line with the scene without resetting the model, so
+ * rows (and their widgets) that are still there are left alone */
+void SourceTreeModel::UpdateItems()
+{
+	OBSScene scene = GetCurrentScene();
+
+	QVector<OBSSceneItem> newitems;
+	obs_scene_enum_items(scene, enumItem, &newitems);
+
+	QSet<obs_sceneitem_t *> oldSet;
+	QSet<obs_sceneitem_t *> newSet;
+	for (obs_sceneitem_t *item : items)
+		oldSet.insert(item);
+	for (obs_sceneitem_t *item : newitems)
+		newSet.insert(item);
+
+	/* remove rows that are gone, a contiguous run at a time */
+	for (int i = items.count() - 1; i >= 0; i--) {
+		if (newSet.contains(items[i]))
+			continue;
+
+		int end = i;
+		while (i > 0 && !newSet.contains(items[i - 1]))
+			i--;
+
+		beginRemoveRows(QModelIndex(), i, end);
+		items.remove(i, end - i + 1);
+		endRemoveRows();
+	}
+
+	/* insert new rows, close to where they go; anything out of place
+	 * afterwards is moved by ReorderItems */
+	for (int i = 0; i < newitems.count(); i++) {
+		if (oldSet.contains(newitems[i]))
+			continue;
+
+		int end = i;
+		while (end + 1 < newitems.count() &&
+		       !oldSet.contains(newitems[end + 1]))
+			end++;
+
+		int row = i < items.count() ? i : items.count();
+		int count = end - i + 1;
+
+		beginInsertRows(QModelIndex(), row, row + count - 1);
+		for (int j = 0; j < count; j++)
+			items.insert(row + j, newitems[i + j]);
+		endInsertRows();
+
+		for (int j = row; j < row + count; j++) {
+			QModelIndex index = createIndex(j, 0);
+			st->UpdateWidget(index, items[j]);
+
+			if (obs_sceneitem_selected(items[j]))
+				st->selectionModel()->select(
+					index, QItemSelectionModel::Select);
+		}
+
+		i = end;
+	}
+
+	ReorderItems();
+	UpdateGroupState(true);
+}
+
 void SourceTreeModel::Add(obs_sceneitem_t *item)
 {
 	if (obs_sceneitem_is_group(item)) {
-		SceneChanged();
+		UpdateItems();
 	} else {
 		beginInsertRows(QModelIndex(), 0, 0);
 		items.insert(0, item);
@@ -992,7 +1068,7 @@ void SourceTreeModel::UngroupSelectedGroups(QModelIndexList &indices)
 		obs_sceneitem_group_ungroup(item);
 	}
 
-	SceneChanged();
+	UpdateItems();
 
 	OBSData redoData = main->BackupScene(scene);
 	main->CreateSceneUndoRedoAction(QTStr("Basic.Main.Ungroup"), undoData,
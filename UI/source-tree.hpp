@@ -119,6 +119,7 @@ class SourceTreeModel : public QAbstractListModel {
 	void Clear();
 	void SceneChanged();
 	void ReorderItems();
+	void UpdateItems();
 
 	void Add(obs_sceneitem_t *item);
 	void Remove(obs_sceneitem_t *item);
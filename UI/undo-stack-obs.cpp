@@ -3,6 +3,7 @@
 #include <util/util.hpp>
 
 #define MAX_STACK_SIZE 5000
+#define MAX_STACK_MEMORY (64 * 1024 * 1024)
 
 undo_stack::undo_stack(ui_ptr ui) : ui(ui)
 {
@@ -21,6 +22,7 @@ void undo_stack::clear()
 {
 	undo_items.clear();
 	redo_items.clear();
+	data_size = 0;
 	last_is_repeatable = false;
 
 	ui->actionMainUndo->setText(QTStr("Undo.Undo"));
@@ -39,7 +41,7 @@ void undo_stack::add_action(const QString &name, const undo_redo_cb &undo,
 		return;
 
 	while (undo_items.size() >= MAX_STACK_SIZE) {
-		undo_redo_t item = undo_items.back();
+		data_size -= undo_items.back().size();
 		undo_items.pop_back();
 	}
 
@@ -48,8 +50,10 @@ void undo_stack::add_action(const QString &name, const undo_redo_cb &undo,
 	}
 
 	if (last_is_repeatable && repeatable && name == undo_items[0].name) {
+		data_size -= undo_items[0].redo_data.size();
 		undo_items[0].redo = redo;
 		undo_items[0].redo_data = redo_data;
+		data_size += redo_data.size();
 		return;
 	}
 
@@ -57,8 +61,16 @@ void undo_stack::add_action(const QString &name, const undo_redo_cb &undo,
 
 	last_is_repeatable = repeatable;
 	undo_items.push_front(n);
+	data_size += n.size();
 	clear_redo();
 
+	/* drop the oldest actions once the history gets too large, but
+	 * always keep the one just added */
+	while (data_size > MAX_STACK_MEMORY && undo_items.size() > 1) {
+		data_size -= undo_items.back().size();
+		undo_items.pop_back();
+	}
+
 	ui->actionMainUndo->setText(QTStr("Undo.Item.Undo").arg(name));
 	ui->actionMainUndo->setEnabled(true);
 
@@ -161,5 +173,7 @@ void undo_stack::pop_disabled()
 
 void undo_stack::clear_redo()
 {
+	for (const undo_redo_t &item : redo_items)
+		data_size -= item.size();
 	redo_items.clear();
 }
@@ -24,11 +24,17 @@ class undo_stack : public QObject {
 		std::string redo_data;
 		undo_redo_cb undo;
 		undo_redo_cb redo;
+
+		inline size_t size() const
+		{
+			return undo_data.size() + redo_data.size();
+		}
 	};
 
 	ui_ptr ui;
 	std::deque<undo_redo_t> undo_items;
 	std::deque<undo_redo_t> redo_items;
+	size_t data_size = 0;
 	int disable_refs = 0;
 	bool enabled = true;
 	bool last_is_repeatable = false;
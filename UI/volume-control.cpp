@@ -68,6 +68,7 @@ void VolControl::VolumeMuted(bool muted)
 		mute->setChecked(muted);
 
 	volMeter->muted = muted;
+	volMeter->update();
 }
 
 void VolControl::SetMuted(bool checked)
@@ -546,6 +547,7 @@ QColor VolumeMeter::getMajorTickColor() const
 void VolumeMeter::setMajorTickColor(QColor c)
 {
 	majorTickColor = std::move(c);
+	background = QPixmap();
 }
 
 QColor VolumeMeter::getMinorTickColor() const
@@ -556,6 +558,7 @@ QColor VolumeMeter::getMinorTickColor() const
 void VolumeMeter::setMinorTickColor(QColor c)
 {
 	minorTickColor = std::move(c);
+	background = QPixmap();
 }
 
 int VolumeMeter::getMeterThickness() const
@@ -849,6 +852,7 @@ inline void VolumeMeter::doLayout()
 	QMutexLocker locker(&dataMutex);
 
 	recalculateLayout = false;
+	background = QPixmap();
 
 	tickFont = font();
 	QFontInfo info(tickFont);
@@ -876,6 +880,15 @@ inline void VolumeMeter::doLayout()
 	resetLevels();
 }
 
+// Once a meter has been painted without any levels, there is nothing to
+// redraw until the source sends levels again.
+bool VolumeMeter::needBarRedraw()
+{
+	uint64_t ts = os_gettime_ns();
+	double timeSinceLastUpdate = (ts - currentLastUpdateTime) * 0.000000001;
+	return !paintedIdle || timeSinceLastUpdate <= 0.5;
+}
+
 inline bool VolumeMeter::detectIdle(uint64_t ts)
 {
 	double timeSinceLastUpdate = (ts - currentLastUpdateTime) * 0.000000001;
@@ -1316,24 +1329,35 @@ void VolumeMeter::paintEvent(QPaintEvent *event)
 		if (needLayoutChange())
 			doLayout();
 
-		// Paint window background color (as widget is opaque)
-		QColor background =
-			palette().color(QPalette::ColorRole::Window);
-		painter.fillRect(widgetRect, background);
-
-		if (vertical) {
-			paintVTicks(painter,
-				    displayNrAudioChannels *
-						    (meterThickness + 1) -
-					    1,
-				    0, height - (INDICATOR_THICKNESS + 3));
-		} else {
-			paintHTicks(painter, INDICATOR_THICKNESS + 3,
-				    displayNrAudioChannels *
-						    (meterThickness + 1) -
-					    1,
-				    width - (INDICATOR_THICKNESS + 3));
+		// The background and scale only change with the layout, so
+		// they're painted once and reused for every full repaint.
+		qreal dpr = devicePixelRatioF();
+		if (background.isNull() ||
+		    background.size() != widgetRect.size() * dpr) {
+			background = QPixmap(widgetRect.size() * dpr);
+			background.setDevicePixelRatio(dpr);
+
+			// Paint window background color (as widget is opaque)
+			QPainter bgPainter(&background);
+			bgPainter.fillRect(
+				widgetRect,
+				palette().color(QPalette::ColorRole::Window));
+
+			int barSize = displayNrAudioChannels *
+					      (meterThickness + 1) -
+				      1;
+
+			if (vertical) {
+				paintVTicks(bgPainter, barSize, 0,
+					    height - (INDICATOR_THICKNESS + 3));
+			} else {
+				paintHTicks(bgPainter, INDICATOR_THICKNESS + 3,
+					    barSize,
+					    width - (INDICATOR_THICKNESS + 3));
+			}
 		}
+
+		painter.drawPixmap(0, 0, background);
 	}
 
 	if (vertical) {
@@ -1384,6 +1408,7 @@ void VolumeMeter::paintEvent(QPaintEvent *event)
 					displayInputPeakHold[channelNrFixed]);
 	}
 
+	paintedIdle = idle;
 	lastRedrawTime = ts;
 }
 
@@ -1401,7 +1426,8 @@ QRect VolumeMeter::getBarRect() const
 
 void VolumeMeter::changeEvent(QEvent *e)
 {
-	if (e->type() == QEvent::StyleChange)
+	if (e->type() == QEvent::StyleChange ||
+	    e->type() == QEvent::PaletteChange)
 		recalculateLayout = true;
 
 	QWidget::changeEvent(e);
@@ -1419,11 +1445,20 @@ void VolumeMeterTimer::RemoveVolControl(VolumeMeter *meter)
 
 void VolumeMeterTimer::timerEvent(QTimerEvent *)
 {
+	// Nobody is looking closely at the meters while another application
+	// has focus, so only redraw them every fourth tick (~15 fps)
+	tick++;
+	if (!QApplication::activeWindow() && (tick % 4) != 0)
+		return;
+
 	for (VolumeMeter *meter : volumeMeters) {
+		if (!meter->isVisible())
+			continue;
+
 		if (meter->needLayoutChange()) {
 			// Tell paintEvent to update layout and paint everything
 			meter->update();
-		} else {
+		} else if (meter->needBarRedraw()) {
 			// Tell paintEvent to paint only the bars
 			meter->update(meter->getBarRect());
 		}
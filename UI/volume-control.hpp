@@ -3,6 +3,7 @@
 #include <obs.hpp>
 #include <QWidget>
 #include <QPaintEvent>
+#include <QPixmap>
 #include <QSharedPointer>
 #include <QTimer>
 #include <QMutex>
@@ -122,6 +123,8 @@ private:
 	QMutex dataMutex;
 
 	bool recalculateLayout = true;
+	bool paintedIdle = false;
+	QPixmap background;
 	uint64_t currentLastUpdateTime = 0;
 	float currentMagnitude[MAX_AUDIO_CHANNELS];
 	float currentPeak[MAX_AUDIO_CHANNELS];
@@ -192,6 +195,7 @@ public:
 		       const float inputPeak[MAX_AUDIO_CHANNELS]);
 	QRect getBarRect() const;
 	bool needLayoutChange();
+	bool needBarRedraw();
 
 	QColor getBackgroundNominalColor() const;
 	void setBackgroundNominalColor(QColor c);
@@ -270,6 +274,7 @@ public:
 protected:
 	void timerEvent(QTimerEvent *event) override;
 	QList<VolumeMeter *> volumeMeters;
+	unsigned int tick = 0;
 };
 
 class QLabel;
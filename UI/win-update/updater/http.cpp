@@ -349,7 +349,7 @@ static bool ReadHTTPFile(HANDLE updateFile, const uint8_t *buffer,
 
 bool HTTPGetFile(HINTERNET hConnect, const wchar_t *url,
 		 const wchar_t *outputPath, const wchar_t *extraHeaders,
-		 int *responseCode)
+		 int *responseCode, DWORD resumeFrom)
 {
 	HttpHandle hRequest;
 
@@ -466,21 +466,58 @@ bool HTTPGetFile(HINTERNET hConnect, const wchar_t *url,
 
 	*responseCode = wcstoul(statusCode, nullptr, 10);
 
+	/* a resumed download is only appended to the existing file if the
+	 * server sent the rest of it, a full response starts it over */
+	bool append = resumeFrom && *responseCode == 206;
+
+	if (append) {
+		wchar_t range[64];
+		DWORD rangeLen = sizeof(range);
+		const wchar_t *start = nullptr;
+
+		if (WinHttpQueryHeaders(hRequest, WINHTTP_QUERY_CONTENT_RANGE,
+					WINHTTP_HEADER_NAME_BY_INDEX, range,
+					&rangeLen, WINHTTP_NO_HEADER_INDEX)) {
+			range[_countof(range) - 1] = 0;
+			start = wcschr(range, L' ');
+		}
+
+		if (!start || gzip ||
+		    wcstoul(start + 1, nullptr, 10) != resumeFrom) {
+			*responseCode = -15;
+			return true;
+		}
+	}
+
 	/* are we supposed to return true here? */
-	if (!bResults || *responseCode != 200)
+	if (!bResults || (*responseCode != 200 && !append))
 		return true;
 
 	BYTE buffer[READ_BUF_SIZE];
 	DWORD dwSize, outSize;
 	int lastPosition = 0;
 
-	WinHandle updateFile = CreateFile(outputPath, GENERIC_WRITE, 0, nullptr,
-					  CREATE_ALWAYS, 0, nullptr);
+	WinHandle updateFile =
+		CreateFile(outputPath, GENERIC_WRITE, 0, nullptr,
+			   append ? OPEN_EXISTING : CREATE_ALWAYS, 0, nullptr);
 	if (!updateFile.Valid()) {
 		*responseCode = -7;
 		return false;
 	}
 
+	if (append) {
+		LARGE_INTEGER pos;
+		pos.QuadPart = resumeFrom;
+
+		if (!SetFilePointerEx(updateFile, pos, nullptr, FILE_BEGIN) ||
+		    !SetEndOfFile(updateFile)) {
+			*responseCode = -16;
+			return false;
+		}
+
+		completedFileSize += resumeFrom;
+	}
+
 	do {
 		/* Check for available data. */
 		dwSize = 0;
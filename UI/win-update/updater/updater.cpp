@@ -314,11 +314,10 @@ struct update_t {
 			} else {
 				DeleteFile(outputPath.c_str());
 			}
-			if (state == STATE_INSTALL_FAILED)
-				DeleteFile(tempPath.c_str());
-		} else if (state == STATE_DOWNLOADED) {
-			DeleteFile(tempPath.c_str());
 		}
+
+		/* downloads are kept for the next attempt, see
+		 * DownloadUpdateFile */
 	}
 
 	inline update_t &operator=(const update_t &from)
@@ -369,46 +368,91 @@ static inline void CleanupPartialUpdates()
 
 /* ----------------------------------------------------------------------- */
 
-bool DownloadWorkerThread()
+/* Downloads are kept in the updates folder until the update has been
+ * installed, so an update that was interrupted or failed only fetches what's
+ * missing the next time.  Partial files are continued with a range request,
+ * which is sent without gzip so that the offset is one into the file itself.
+ * If the joined file doesn't match its hash, it's downloaded again from the
+ * start. */
+static DWORD GetDownloadedSize(const wchar_t *path)
 {
-	const DWORD tlsProtocols = WINHTTP_FLAG_SECURE_PROTOCOL_TLS1_2 |
-				   WINHTTP_FLAG_SECURE_PROTOCOL_TLS1_3;
+	WIN32_FILE_ATTRIBUTE_DATA attr;
 
-	const DWORD enableHTTP2Flag = WINHTTP_PROTOCOL_FLAG_HTTP2;
+	if (!GetFileAttributesExW(path, GetFileExInfoStandard, &attr))
+		return 0;
+	if (attr.nFileSizeHigh)
+		return 0;
+	return attr.nFileSizeLow;
+}
 
-	HttpHandle hSession = WinHttpOpen(L"OBS Studio Updater/2.1",
-					  WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
-					  WINHTTP_NO_PROXY_NAME,
-					  WINHTTP_NO_PROXY_BYPASS, 0);
-	if (!hSession) {
-		downloadThreadFailure = true;
-		Status(L"Update failed: Couldn't open obsproject.com");
+static bool IsDownloadValid(const update_t &update)
+{
+	BYTE downloadHash[BLAKE2_HASH_LENGTH];
+
+	if (!CalculateFileHash(update.tempPath.c_str(), downloadHash))
 		return false;
-	}
+	return memcmp(update.downloadhash, downloadHash,
+		      BLAKE2_HASH_LENGTH) == 0;
+}
 
-	WinHttpSetOption(hSession, WINHTTP_OPTION_SECURE_PROTOCOLS,
-			 (LPVOID)&tlsProtocols, sizeof(tlsProtocols));
+static bool DownloadUpdateFile(HINTERNET hConnect, update_t &update)
+{
+	const wchar_t *path = update.tempPath.c_str();
+	DWORD resumeFrom = GetDownloadedSize(path);
+	int responseCode;
 
-	WinHttpSetOption(hSession, WINHTTP_OPTION_ENABLE_HTTP_PROTOCOL,
-			 (LPVOID)&enableHTTP2Flag, sizeof(enableHTTP2Flag));
+	if (resumeFrom >= update.fileSize) {
+		if (resumeFrom == update.fileSize && IsDownloadValid(update)) {
+			completedFileSize += resumeFrom;
+			return true;
+		}
+		resumeFrom = 0;
+	}
 
-	HttpHandle hConnect = WinHttpConnect(hSession,
-					     L"cdn-fastly.obsproject.com",
-					     INTERNET_DEFAULT_HTTPS_PORT, 0);
-	if (!hConnect) {
-		downloadThreadFailure = true;
-		Status(L"Update failed: Couldn't connect to cdn-fastly.obsproject.com");
+	wstring headers = L"Accept-Encoding: gzip";
+	if (resumeFrom)
+		headers = L"Range: bytes=" + to_wstring(resumeFrom) + L"-";
+
+	if (!HTTPGetFile(hConnect, update.sourceURL.c_str(), path,
+			 headers.c_str(), &responseCode, resumeFrom)) {
+		/* whatever made it to disk is continued next time */
+		Status(L"Update failed: Could not download "
+		       L"%s (error code %d)",
+		       update.outputPath.c_str(), responseCode);
 		return false;
 	}
 
+	bool received = responseCode == 200 ||
+			(resumeFrom && responseCode == 206);
+	if (received && IsDownloadValid(update))
+		return true;
+
+	if (received)
+		completedFileSize -= (int)GetDownloadedSize(path);
+	DeleteFile(path);
+
+	if (resumeFrom)
+		return DownloadUpdateFile(hConnect, update);
+
+	if (received)
+		Status(L"Update failed: Integrity check "
+		       L"failed on %s",
+		       update.outputPath.c_str());
+	else
+		Status(L"Update failed: Could not download "
+		       L"%s (error code %d)",
+		       update.outputPath.c_str(), responseCode);
+	return false;
+}
+
+bool DownloadWorkerThread(HINTERNET hConnect)
+{
 	for (;;) {
 		bool foundWork = false;
 
 		unique_lock<mutex> ulock(updateMutex);
 
 		for (update_t &update : updates) {
-			int responseCode;
-
 			DWORD waitResult =
 				WaitForSingleObject(cancelRequested, 0);
 			if (waitResult == WAIT_OBJECT_0) {
@@ -430,46 +474,9 @@ bool DownloadWorkerThread()
 
 			Status(L"Downloading %s", update.outputPath.c_str());
 
-			if (!HTTPGetFile(hConnect, update.sourceURL.c_str(),
-					 update.tempPath.c_str(),
-					 L"Accept-Encoding: gzip",
-					 &responseCode)) {
-
-				downloadThreadFailure = true;
-				DeleteFile(update.tempPath.c_str());
-				Status(L"Update failed: Could not download "
-				       L"%s (error code %d)",
-				       update.outputPath.c_str(), responseCode);
-				return 1;
-			}
-
-			if (responseCode != 200) {
-				downloadThreadFailure = true;
-				DeleteFile(update.tempPath.c_str());
-				Status(L"Update failed: Could not download "
-				       L"%s (error code %d)",
-				       update.outputPath.c_str(), responseCode);
-				return 1;
-			}
-
-			BYTE downloadHash[BLAKE2_HASH_LENGTH];
-			if (!CalculateFileHash(update.tempPath.c_str(),
-					       downloadHash)) {
-				downloadThreadFailure = true;
-				DeleteFile(update.tempPath.c_str());
-				Status(L"Update failed: Couldn't verify "
-				       L"integrity of %s",
-				       update.outputPath.c_str());
-				return 1;
-			}
-
-			if (memcmp(update.downloadhash, downloadHash, 20)) {
+			if (!DownloadUpdateFile(hConnect, update)) {
 				downloadThreadFailure = true;
-				DeleteFile(update.tempPath.c_str());
-				Status(L"Update failed: Integrity check "
-				       L"failed on %s",
-				       update.outputPath.c_str());
-				return 1;
+				return false;
 			}
 
 			ulock.lock();
@@ -489,26 +496,98 @@ bool DownloadWorkerThread()
 	return true;
 }
 
+/* The workers share one session, so WinHTTP can keep its connections to the
+ * CDN open between files and multiplex the requests over HTTP/2 instead of
+ * every worker doing its own TLS handshake. */
 static bool RunDownloadWorkers(int num)
 try {
+	const DWORD tlsProtocols = WINHTTP_FLAG_SECURE_PROTOCOL_TLS1_2 |
+				   WINHTTP_FLAG_SECURE_PROTOCOL_TLS1_3;
+
+	const DWORD enableHTTP2Flag = WINHTTP_PROTOCOL_FLAG_HTTP2;
+
+	HttpHandle hSession = WinHttpOpen(L"OBS Studio Updater/2.1",
+					  WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
+					  WINHTTP_NO_PROXY_NAME,
+					  WINHTTP_NO_PROXY_BYPASS, 0);
+	if (!hSession) {
+		Status(L"Update failed: Couldn't open obsproject.com");
+		return false;
+	}
+
+	WinHttpSetOption(hSession, WINHTTP_OPTION_SECURE_PROTOCOLS,
+			 (LPVOID)&tlsProtocols, sizeof(tlsProtocols));
+
+	WinHttpSetOption(hSession, WINHTTP_OPTION_ENABLE_HTTP_PROTOCOL,
+			 (LPVOID)&enableHTTP2Flag, sizeof(enableHTTP2Flag));
+
+	HttpHandle hConnect = WinHttpConnect(hSession,
+					     L"cdn-fastly.obsproject.com",
+					     INTERNET_DEFAULT_HTTPS_PORT, 0);
+	if (!hConnect) {
+		Status(L"Update failed: Couldn't connect to cdn-fastly.obsproject.com");
+		return false;
+	}
+
 	vector<future<bool>> thread_success_results;
 	thread_success_results.resize(num);
 
 	for (future<bool> &result : thread_success_results) {
-		result = async(DownloadWorkerThread);
+		result = async(DownloadWorkerThread, (HINTERNET)hConnect);
 	}
+
+	/* wait for every worker before the handles are closed */
+	bool success = true;
 	for (future<bool> &result : thread_success_results) {
 		if (!result.get()) {
-			return false;
+			success = false;
 		}
 	}
 
-	return true;
+	return success;
 
 } catch (...) {
 	return false;
 }
 
+/* deletes downloads left over from an earlier update that this one doesn't
+ * need any more */
+static void PurgeStaleDownloads()
+{
+	wchar_t pattern[MAX_PATH];
+	WIN32_FIND_DATAW wfd;
+	HANDLE hFind;
+
+	StringCbPrintf(pattern, sizeof(pattern), L"%s\\*", tempPath);
+
+	hFind = FindFirstFileW(pattern, &wfd);
+	if (hFind == INVALID_HANDLE_VALUE)
+		return;
+
+	do {
+		if (wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+			continue;
+
+		wstring path = tempPath;
+		path += L"\\";
+		path += wfd.cFileName;
+
+		bool used = false;
+		for (const update_t &update : updates) {
+			if (_wcsicmp(update.tempPath.c_str(), path.c_str()) ==
+			    0) {
+				used = true;
+				break;
+			}
+		}
+
+		if (!used)
+			DeleteFile(path.c_str());
+	} while (FindNextFileW(hFind, &wfd));
+
+	FindClose(hFind);
+}
+
 /* ----------------------------------------------------------------------- */
 
 #define WAITIFOBS_SUCCESS 0
@@ -1343,27 +1422,23 @@ static bool Update(wchar_t *cmdLine)
 	 * Get download path                     */
 
 	wchar_t manifestPath[MAX_PATH];
-	wchar_t tempDirName[MAX_PATH];
 
 	manifestPath[0] = 0;
-	tempDirName[0] = 0;
 
 	StringCbPrintf(manifestPath, sizeof(manifestPath),
 		       L"%s\\updates\\manifest.json", lpAppDataPath);
-	if (!GetTempPathW(_countof(tempDirName), tempDirName)) {
-		Status(L"Update failed: Failed to get temp path: %ld",
-		       GetLastError());
-		return false;
-	}
-	if (!GetTempFileNameW(tempDirName, L"obs-studio", 0, tempPath)) {
-		Status(L"Update failed: Failed to create temp dir name: %ld",
+
+	/* not a random temp folder, so that the next attempt can continue
+	 * the downloads of one that failed */
+	StringCbPrintf(tempPath, sizeof(tempPath),
+		       L"%s\\updates\\downloads", lpAppDataPath);
+	if (!CreateDirectory(tempPath, nullptr) &&
+	    GetLastError() != ERROR_ALREADY_EXISTS) {
+		Status(L"Update failed: Failed to create download folder: %ld",
 		       GetLastError());
 		return false;
 	}
 
-	DeleteFile(tempPath);
-	CreateDirectory(tempPath, nullptr);
-
 	/* ------------------------------------- *
 	 * Load manifest file                    */
 
@@ -1412,6 +1487,7 @@ static bool Update(wchar_t *cmdLine)
 	 * Exit if updates already installed     */
 
 	if (!updates.size()) {
+		PurgeStaleDownloads();
 		Status(L"All available updates are already installed.");
 		SetDlgItemText(hwndMain, IDC_BUTTON, L"Launch OBS");
 		return true;
@@ -1552,6 +1628,8 @@ static bool Update(wchar_t *cmdLine)
 	/* ------------------------------------- *
 	 * Download Updates                      */
 
+	PurgeStaleDownloads();
+
 	if (!RunDownloadWorkers(4))
 		return false;
 
@@ -78,9 +78,11 @@
 #include <json11.hpp>
 #include "resource.h"
 
+/* if resumeFrom isn't 0 and the server answers with the rest of the file,
+ * it's appended to the first resumeFrom bytes of outputPath */
 bool HTTPGetFile(HINTERNET hConnect, const wchar_t *url,
 		 const wchar_t *outputPath, const wchar_t *extraHeaders,
-		 int *responseCode);
+		 int *responseCode, DWORD resumeFrom = 0);
 bool HTTPPostData(const wchar_t *url, const BYTE *data, int dataLen,
 		  const wchar_t *extraHeaders, int *responseCode,
 		  std::string &response);
@@ -4,6 +4,8 @@
 
 #include <obs.hpp>
 #include <util/platform.h>
+#include <util/threading.h>
+#include <util/dstr.h>
 #include <util/util_uint64.h>
 #include <graphics/vec4.h>
 #include <graphics/graphics.h>
@@ -175,19 +177,6 @@ void AutoConfigTestPage::TestBandwidthThread()
 	QMetaObject::invokeMethod(this, "UpdateMessage",
 				  Q_ARG(QString, QStringLiteral("")));
 
-	/* -----------------------------------*/
-	/* create obs objects                 */
-
-	const char *serverType = wiz->customServer ? "rtmp_custom"
-						   : "rtmp_common";
-
-	OBSEncoderAutoRelease vencoder = obs_video_encoder_create(
-		"obs_x264", "test_x264", nullptr, nullptr);
-	OBSEncoderAutoRelease aencoder = obs_audio_encoder_create(
-		"ffmpeg_aac", "test_aac", nullptr, 0, nullptr);
-	OBSServiceAutoRelease service = obs_service_create(
-		serverType, "test_service", nullptr, nullptr);
-
 	/* -----------------------------------*/
 	/* configure settings                 */
 
@@ -259,6 +248,25 @@ void AutoConfigTestPage::TestBandwidthThread()
 		servers.resize(2);
 	}
 
+	/* -----------------------------------*/
+	/* probe RTMP servers concurrently    */
+
+	if (ProbeBandwidth(servers, key, bind_ip))
+		return;
+
+	/* -----------------------------------*/
+	/* create obs objects                 */
+
+	const char *serverType = wiz->customServer ? "rtmp_custom"
+						   : "rtmp_common";
+
+	OBSEncoderAutoRelease vencoder = obs_video_encoder_create(
+		"obs_x264", "test_x264", nullptr, nullptr);
+	OBSEncoderAutoRelease aencoder = obs_audio_encoder_create(
+		"ffmpeg_aac", "test_aac", nullptr, 0, nullptr);
+	OBSServiceAutoRelease service = obs_service_create(
+		serverType, "test_service", nullptr, nullptr);
+
 	/* -----------------------------------*/
 	/* apply service settings             */
 
@@ -428,6 +436,12 @@ void AutoConfigTestPage::TestBandwidthThread()
 		success = true;
 	}
 
+	FinishBandwidthTest(servers, success);
+}
+
+void AutoConfigTestPage::FinishBandwidthTest(std::vector<ServerInfo> &servers,
+					     bool success)
+{
 	if (!success) {
 		QMetaObject::invokeMethod(this, "Failure",
 					  Q_ARG(QString,
@@ -459,6 +473,134 @@ void AutoConfigTestPage::TestBandwidthThread()
 	QMetaObject::invokeMethod(this, "NextStage");
 }
 
+static bool CanProbeServer(const std::string &address)
+{
+	return astrcmpi_n(address.c_str(), "rtmp://", 7) == 0 ||
+	       astrcmpi_n(address.c_str(), "rtmps://", 8) == 0;
+}
+
+/* Probes every server at once through the RTMP output's bandwidth probe
+ * rather than streaming to each in turn with a real encoder.  Each probe
+ * paces its payload at an equal share of the starting bitrate, so together
+ * they put the same load on the uplink as the single-server test.  Returns
+ * false if the servers can't be probed or none of the probes succeeded, in
+ * which case the full test runs instead. */
+bool AutoConfigTestPage::ProbeBandwidth(std::vector<ServerInfo> &servers,
+					const std::string &key,
+					const char *bind_ip)
+{
+	if (servers.empty())
+		return false;
+
+	for (auto &server : servers) {
+		if (!CanProbeServer(server.address))
+			return false;
+	}
+
+	const int count = (int)servers.size();
+	const int share = wiz->startingBitrate / count;
+	std::vector<std::thread> threads;
+	std::vector<int> results(servers.size(), 0);
+	bool available = true;
+	int remaining = count;
+	os_event_t *stop;
+
+	if (os_event_init(&stop, OS_EVENT_TYPE_MANUAL) != 0)
+		return false;
+
+	QString names;
+	for (auto &server : servers) {
+		if (!names.isEmpty())
+			names += ", ";
+		names += server.name.c_str();
+	}
+
+	QMetaObject::invokeMethod(this, "Progress", Q_ARG(int, 0));
+	QMetaObject::invokeMethod(
+		this, "UpdateMessage",
+		Q_ARG(QString, QTStr(TEST_BW_SERVER).arg(names)));
+
+	for (size_t i = 0; i < servers.size(); i++) {
+		threads.emplace_back([&, i]() {
+			ServerInfo &server = servers[i];
+			calldata_t cd = {0};
+
+			calldata_set_string(&cd, "server",
+					    server.address.c_str());
+			calldata_set_string(&cd, "key", key.c_str());
+			calldata_set_string(&cd, "bind_ip", bind_ip);
+			calldata_set_int(&cd, "bitrate", share);
+			calldata_set_int(&cd, "duration_ms", 4000);
+			calldata_set_ptr(&cd, "stop_event", stop);
+
+			proc_handler_t *ph = obs_get_proc_handler();
+			bool called = proc_handler_call(
+				ph, "rtmp_bandwidth_probe", &cd);
+
+			unique_lock<mutex> lock(m);
+			if (!called)
+				available = false;
+			else if (calldata_bool(&cd, "success"))
+				results[i] = (int)calldata_int(
+					&cd, "measured_bitrate");
+			else
+				results[i] = -1;
+			server.ms = (int)calldata_int(&cd, "connect_ms");
+			remaining--;
+			cv.notify_one();
+			lock.unlock();
+
+			calldata_free(&cd);
+		});
+	}
+
+	{
+		unique_lock<mutex> ul(m);
+		while (remaining && !cancel)
+			cv.wait(ul);
+		if (cancel)
+			os_event_signal(stop);
+	}
+
+	for (auto &thread : threads)
+		thread.join();
+	os_event_destroy(stop);
+
+	unique_lock<mutex> ul(m);
+	if (cancel)
+		return true;
+	ul.unlock();
+
+	if (!available)
+		return false;
+
+	bool success = false;
+
+	for (size_t i = 0; i < servers.size(); i++) {
+		ServerInfo &server = servers[i];
+		int bitrate = results[i];
+
+		if (bitrate < 0)
+			continue;
+
+		/* a probe only got its share of the uplink */
+		if (bitrate < share * 75 / 100)
+			server.bitrate = bitrate * count * 70 / 100;
+		else
+			server.bitrate = wiz->startingBitrate;
+		success = true;
+	}
+
+	/* servers may refuse the probe payload, let the full test have a go
+	 * before giving up */
+	if (!success)
+		return false;
+
+	QMetaObject::invokeMethod(this, "Progress", Q_ARG(int, 100));
+	FinishBandwidthTest(servers, true);
+	return true;
+}
+
 /* this is used to estimate the lower bitrate limit for a given
  * resolution/fps.  yes, it is a totally arbitrary equation that gets
  * the closest to the expected values */
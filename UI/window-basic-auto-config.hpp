@@ -255,6 +255,10 @@ class AutoConfigTestPage : public QWizardPage {
 	};
 
 	void GetServers(std::vector<ServerInfo> &servers);
+	bool ProbeBandwidth(std::vector<ServerInfo> &servers,
+			    const std::string &key, const char *bind_ip);
+	void FinishBandwidthTest(std::vector<ServerInfo> &servers,
+				 bool success);
 
 public:
 	AutoConfigTestPage(QWidget *parent = nullptr);
@@ -21,6 +21,8 @@
 #include <cstddef>
 #include <ctime>
 #include <functional>
+#include <unordered_map>
+#include <unordered_set>
 #include <obs-data.h>
 #include <obs.h>
 #include <obs.hpp>
@@ -707,7 +709,74 @@ obs_data_array_t *OBSBasic::SaveProjectors()
 	return savedProjectors;
 }
 
-void OBSBasic::Save(const char *file)
+static bool WriteSaveData(const std::string &file, const std::string &json)
+{
+	bool success = os_quick_write_utf8_file_safe(
+		file.c_str(), json.c_str(), json.size(), false, "tmp", "bak");
+	if (!success)
+		blog(LOG_ERROR, "Could not save scene data to %s",
+		     file.c_str());
+	return success;
+}
+
+void OBSBasic::SaveThread()
+{
+	std::unique_lock<std::mutex> lock(saveMutex);
+
+	for (;;) {
+		saveCondition.wait(lock, [this] {
+			return savePending || stopSaveThread;
+		});
+		if (!savePending)
+			break;
+
+		std::string file = std::move(pendingSavePath);
+		std::string json = std::move(pendingSaveJson);
+		savePending = false;
+		saveWriting = true;
+
+		lock.unlock();
+		bool success = WriteSaveData(file, json);
+		lock.lock();
+
+		saveWriting = false;
+		if (success) {
+			lastSavedPath = std::move(file);
+			lastSavedJson = std::move(json);
+		}
+		saveCondition.notify_all();
+	}
+}
+
+void OBSBasic::WaitForSaves()
+{
+	std::unique_lock<std::mutex> lock(saveMutex);
+	saveCondition.wait(lock,
+			   [this] { return !savePending && !saveWriting; });
+}
+
+void OBSBasic::QueueSave(const char *file, const char *json)
+{
+	std::unique_lock<std::mutex> lock(saveMutex);
+
+	/* a save for another collection must not replace this one */
+	if (savePending && pendingSavePath != file)
+		saveCondition.wait(lock, [this] { return !savePending; });
+
+	if (!savePending && !saveWriting && lastSavedPath == file &&
+	    lastSavedJson == json)
+		return;
+
+	pendingSavePath = file;
+	pendingSaveJson = json;
+	savePending = true;
+
+	if (!saveThread.joinable())
+		saveThread = std::thread([this]() { SaveThread(); });
+	saveCondition.notify_all();
+}
+
+void OBSBasic::Save(const char *file, bool async)
 {
 	OBSScene scene = GetCurrentScene();
 	OBSSource curProgramScene = OBSGetStrongRef(programScene);
@@ -741,8 +810,26 @@ void OBSBasic::Save(const char *file)
 		obs_data_set_obj(saveData, "modules", moduleObj);
 	}
 
-	if (!obs_data_save_json_safe(saveData, file, "tmp", "bak"))
-		blog(LOG_ERROR, "Could not save scene data to %s", file);
+	/* serializing has to happen here, the data references live source
+	 * settings */
+	const char *json = obs_data_get_json(saveData);
+	if (!json)
+		return;
+
+	if (async) {
+		QueueSave(file, json);
+		return;
+	}
+
+	WaitForSaves();
+
+	std::lock_guard<std::mutex> lock(saveMutex);
+	if (lastSavedPath == file && lastSavedJson == json)
+		return;
+	if (WriteSaveData(file, json)) {
+		lastSavedPath = file;
+		lastSavedJson = json;
+	}
 }
 
 void OBSBasic::DeferSaveBegin()
@@ -993,6 +1080,38 @@ static inline void AddMissingFiles(void *data, obs_source_t *source)
 	obs_missing_files_destroy(sf);
 }
 
+typedef std::unordered_map<std::string, obs_data_t *> SourceDataMap;
+
+static void AddNeededSources(const SourceDataMap &sources, const char *name,
+			     std::unordered_set<std::string> &needed)
+{
+	if (!name || !*name || !needed.insert(name).second)
+		return;
+
+	auto it = sources.find(name);
+	if (it == sources.end())
+		return;
+
+	/* scenes and groups list their sources as items */
+	OBSDataAutoRelease settings = obs_data_get_obj(it->second, "settings");
+	OBSDataArrayAutoRelease items = obs_data_get_array(settings, "items");
+	size_t count = obs_data_array_count(items);
+
+	for (size_t i = 0; i < count; i++) {
+		OBSDataAutoRelease item = obs_data_array_item(items, i);
+		AddNeededSources(sources, obs_data_get_string(item, "name"),
+				 needed);
+	}
+}
+
+static bool DeferUnneededSource(void *data, obs_data_t *source_data)
+{
+	auto &needed = *static_cast<std::unordered_set<std::string> *>(data);
+	const char *name = obs_data_get_string(source_data, "name");
+
+	return needed.find(name) == needed.end();
+}
+
 void OBSBasic::LoadData(obs_data_t *data, const char *file)
 {
 	ClearSceneData();
@@ -1062,7 +1181,34 @@ void OBSBasic::LoadData(obs_data_t *data, const char *file)
 	}
 
 	obs_missing_files_t *files = obs_missing_files_create();
-	obs_load_sources(sources, AddMissingFiles, files);
+
+	/* only the sources of the scenes shown right away are created now,
+	 * the others are created by libobs when they're first shown */
+	if (config_get_bool(App()->GlobalConfig(), "General",
+			    "DeferSourceLoading")) {
+		std::unordered_set<std::string> needed;
+		SourceDataMap sourceData;
+		size_t count = obs_data_array_count(sources);
+
+		for (size_t i = 0; i < count; i++) {
+			obs_data_t *source = obs_data_array_item(sources, i);
+			const char *name = obs_data_get_string(source, "name");
+
+			if (!sourceData.emplace(name, source).second)
+				obs_data_release(source);
+		}
+
+		AddNeededSources(sourceData, sceneName, needed);
+		AddNeededSources(sourceData, programSceneName, needed);
+
+		obs_load_sources_deferred(sources, AddMissingFiles, files,
+					  DeferUnneededSource, &needed);
+
+		for (auto &source : sourceData)
+			obs_data_release(source.second);
+	} else {
+		obs_load_sources(sources, AddMissingFiles, files);
+	}
 
 	if (transitions)
 		LoadTransitions(transitions, AddMissingFiles, files);
@@ -1370,7 +1516,7 @@ bool OBSBasic::InitBasicConfigDefaults()
 	/* ----------------------------------------------------- */
 
 	if (changed)
-		config_save_safe(basicConfig, "tmp", nullptr);
+		config_save_safe_deferred(basicConfig, "tmp", nullptr);
 
 	/* ----------------------------------------------------- */
 
@@ -1450,7 +1596,7 @@ bool OBSBasic::InitBasicConfigDefaults()
 	    !config_has_user_value(basicConfig, "Video", "BaseCY")) {
 		config_set_uint(basicConfig, "Video", "BaseCX", cx);
 		config_set_uint(basicConfig, "Video", "BaseCY", cy);
-		config_save_safe(basicConfig, "tmp", nullptr);
+		config_save_safe_deferred(basicConfig, "tmp", nullptr);
 	}
 
 	config_set_default_string(basicConfig, "Output", "FilenameFormatting",
@@ -1491,7 +1637,7 @@ bool OBSBasic::InitBasicConfigDefaults()
 	    !config_has_user_value(basicConfig, "Video", "OutputCY")) {
 		config_set_uint(basicConfig, "Video", "OutputCX", scale_cx);
 		config_set_uint(basicConfig, "Video", "OutputCY", scale_cy);
-		config_save_safe(basicConfig, "tmp", nullptr);
+		config_save_safe_deferred(basicConfig, "tmp", nullptr);
 	}
 
 	config_set_default_uint(basicConfig, "Video", "FPSType", 0);
@@ -1989,7 +2135,8 @@ void OBSBasic::OBSInit()
 					"ResetDockLock23", true);
 			config_remove_value(App()->GlobalConfig(),
 					    "BasicWindow", "DocksLocked");
-			config_save_safe(App()->GlobalConfig(), "tmp", nullptr);
+			config_save_safe_deferred(App()->GlobalConfig(),
+						  "tmp", nullptr);
 		}
 	}
 
@@ -2016,7 +2163,8 @@ void OBSBasic::OBSInit()
 	if (!first_run) {
 		config_set_bool(App()->GlobalConfig(), "General", "FirstRun",
 				true);
-		config_save_safe(App()->GlobalConfig(), "tmp", nullptr);
+		config_save_safe_deferred(App()->GlobalConfig(),
+					  "tmp", nullptr);
 	}
 
 	if (!first_run && !has_last_version && !Active())
@@ -2213,7 +2361,7 @@ void OBSBasic::ReceivedIntroJson(const QString &text)
 
 	config_set_int(App()->GlobalConfig(), "General", "InfoIncrement",
 		       info_increment);
-	config_save_safe(App()->GlobalConfig(), "tmp", nullptr);
+	config_save_safe_deferred(App()->GlobalConfig(), "tmp", nullptr);
 
 	cef->init_browser();
 
@@ -2603,6 +2751,15 @@ OBSBasic::~OBSBasic()
 	if (updateCheckThread && updateCheckThread->isRunning())
 		updateCheckThread->wait();
 
+	if (saveThread.joinable()) {
+		{
+			std::lock_guard<std::mutex> lock(saveMutex);
+			stopSaveThread = true;
+		}
+		saveCondition.notify_all();
+		saveThread.join();
+	}
+
 	delete screenshotData;
 	delete multiviewProjectorMenu;
 	delete previewProjector;
@@ -2737,7 +2894,7 @@ void OBSBasic::SaveProjectNow()
 		return;
 
 	projectChanged = true;
-	SaveProjectDeferred();
+	SaveProjectFile(false);
 }
 
 void OBSBasic::SaveProject()
@@ -2751,6 +2908,11 @@ void OBSBasic::SaveProject()
 }
 
 void OBSBasic::SaveProjectDeferred()
+{
+	SaveProjectFile(true);
+}
+
+void OBSBasic::SaveProjectFile(bool async)
 {
 	if (disableSaving)
 		return;
@@ -2779,7 +2941,7 @@ void OBSBasic::SaveProjectDeferred()
 	if (ret <= 0)
 		return;
 
-	Save(savePath);
+	Save(savePath, async);
 }
 
 OBSSource OBSBasic::GetProgramSource()
@@ -4416,6 +4578,10 @@ int OBSBasic::ResetVideo()
 		config_get_uint(App()->GlobalConfig(), "Video", "AdapterIdx");
 	ovi.gpu_conversion = true;
 	ovi.scale_type = GetScaleType(basicConfig);
+	ovi.staging_surfaces = (uint32_t)config_get_uint(
+		basicConfig, "Video", "StagingSurfaces");
+	ovi.zero_copy_readback =
+		config_get_bool(basicConfig, "Video", "ZeroCopyReadback");
 
 	if (ovi.base_width < 8 || ovi.base_height < 8) {
 		ovi.base_width = 1920;
@@ -4501,6 +4667,8 @@ bool OBSBasic::ResetAudio()
 	if (lowLatencyAudioBuffering) {
 		ai.max_buffering_ms = 20;
 		ai.fixed_buffering = true;
+	} else {
+		ai.adaptive_buffering = true;
 	}
 
 	return obs_reset_audio2(&ai);
@@ -4735,6 +4903,10 @@ void OBSBasic::closeEvent(QCloseEvent *event)
 
 	blog(LOG_INFO, SHUTDOWN_SEPARATOR);
 
+	/* keep the trace buffers holding what happened before closing rather
+	 * than the shutdown itself */
+	profiler_trace_stop();
+
 	closing = true;
 
 	if (introCheckThread)
@@ -5362,6 +5534,10 @@ QMenu *OBSBasic::AddDeinterlacingMenu(QMenu *menu, obs_source_t *source)
 	ADD_MODE("Deinterlacing.Linear2x", OBS_DEINTERLACE_MODE_LINEAR_2X);
 	ADD_MODE("Deinterlacing.Yadif", OBS_DEINTERLACE_MODE_YADIF);
 	ADD_MODE("Deinterlacing.Yadif2x", OBS_DEINTERLACE_MODE_YADIF_2X);
+	ADD_MODE("Deinterlacing.MotionAdaptive",
+		 OBS_DEINTERLACE_MODE_MOTION_ADAPTIVE);
+	ADD_MODE("Deinterlacing.MotionAdaptive2x",
+		 OBS_DEINTERLACE_MODE_MOTION_ADAPTIVE_2X);
 #undef ADD_MODE
 
 	menu->addSeparator();
@@ -6509,7 +6685,8 @@ void OBSBasic::ShowYouTubeAutoStartWarning()
 		if (cb->isChecked()) {
 			config_set_bool(App()->GlobalConfig(), "General",
 					"WarnedAboutYouTubeAutoStart", true);
-			config_save_safe(App()->GlobalConfig(), "tmp", nullptr);
+			config_save_safe_deferred(App()->GlobalConfig(),
+						  "tmp", nullptr);
 		}
 	};
 
@@ -7347,7 +7524,8 @@ void OBSBasic::ShowReplayBufferPauseWarning()
 		if (cb->isChecked()) {
 			config_set_bool(App()->GlobalConfig(), "General",
 					"WarnedAboutReplayBufferPausing", true);
-			config_save_safe(App()->GlobalConfig(), "tmp", nullptr);
+			config_save_safe_deferred(App()->GlobalConfig(),
+						  "tmp", nullptr);
 		}
 	};
 
@@ -9783,7 +9961,7 @@ void OBSBasic::ResizeOutputSizeOfSource()
 
 	ResetVideo();
 	ResetOutputs();
-	config_save_safe(basicConfig, "tmp", nullptr);
+	config_save_safe_deferred(basicConfig, "tmp", nullptr);
 	on_actionFitToScreen_triggered();
 }
 
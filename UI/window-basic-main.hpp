@@ -26,6 +26,9 @@
 #include <obs.hpp>
 #include <vector>
 #include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include "window-main.hpp"
 #include "window-basic-interaction.hpp"
 #include "window-basic-properties.hpp"
@@ -226,6 +229,19 @@ private:
 	bool loaded = false;
 	long disableSaving = 1;
 	bool projectChanged = false;
+
+	/* scene collection files are written on a separate thread, only
+	 * the newest pending save is kept */
+	std::thread saveThread;
+	std::mutex saveMutex;
+	std::condition_variable saveCondition;
+	std::string pendingSavePath;
+	std::string pendingSaveJson;
+	std::string lastSavedPath;
+	std::string lastSavedJson;
+	bool savePending = false;
+	bool saveWriting = false;
+	bool stopSaveThread = false;
 	bool previewEnabled = true;
 	ContextBarSize contextBarSize = ContextBarSize_Normal;
 
@@ -356,7 +372,11 @@ private:
 
 	void UploadLog(const char *subdir, const char *file, const bool crash);
 
-	void Save(const char *file);
+	void Save(const char *file, bool async);
+	void SaveThread();
+	void QueueSave(const char *file, const char *json);
+	void WaitForSaves();
+	void SaveProjectFile(bool async);
 	void LoadData(obs_data_t *data, const char *file);
 	void Load(const char *file);
 
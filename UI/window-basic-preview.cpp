@@ -713,6 +713,53 @@ void OBSBasicPreview::ProcessClick(const vec2 &pos)
 		DoSelect(pos);
 }
 
+/* removes the items a transform didn't touch from both states, so undo
+ * history grows with the items that changed rather than the scene size */
+static void RemoveUnchangedTransforms(obs_data_t *undo, obs_data_t *redo)
+{
+	OBSDataArrayAutoRelease undoScenes =
+		obs_data_get_array(undo, "scenes_and_groups");
+	OBSDataArrayAutoRelease redoScenes =
+		obs_data_get_array(redo, "scenes_and_groups");
+	size_t numScenes = obs_data_array_count(undoScenes);
+
+	if (numScenes != obs_data_array_count(redoScenes))
+		return;
+
+	for (size_t i = 0; i < numScenes; i++) {
+		OBSDataAutoRelease undoScene =
+			obs_data_array_item(undoScenes, i);
+		OBSDataAutoRelease redoScene =
+			obs_data_array_item(redoScenes, i);
+
+		if (strcmp(obs_data_get_string(undoScene, "scene_name"),
+			   obs_data_get_string(redoScene, "scene_name")) != 0)
+			continue;
+
+		OBSDataArrayAutoRelease undoItems =
+			obs_data_get_array(undoScene, "items");
+		OBSDataArrayAutoRelease redoItems =
+			obs_data_get_array(redoScene, "items");
+		size_t numItems = obs_data_array_count(undoItems);
+
+		if (numItems != obs_data_array_count(redoItems))
+			continue;
+
+		for (size_t j = numItems; j > 0; j--) {
+			OBSDataAutoRelease undoItem =
+				obs_data_array_item(undoItems, j - 1);
+			OBSDataAutoRelease redoItem =
+				obs_data_array_item(redoItems, j - 1);
+
+			if (strcmp(obs_data_get_json(undoItem),
+				   obs_data_get_json(redoItem)) == 0) {
+				obs_data_array_erase(undoItems, j - 1);
+				obs_data_array_erase(redoItems, j - 1);
+			}
+		}
+	}
+}
+
 void OBSBasicPreview::mouseReleaseEvent(QMouseEvent *event)
 {
 	if (scrollMode)
@@ -797,6 +844,8 @@ void OBSBasicPreview::mouseReleaseEvent(QMouseEvent *event)
 	};
 
 	if (wrapper && rwrapper) {
+		RemoveUnchangedTransforms(wrapper, rwrapper);
+
 		std::string undo_data(obs_data_get_json(wrapper));
 		std::string redo_data(obs_data_get_json(rwrapper));
 		if (changed && undo_data.compare(redo_data) != 0)
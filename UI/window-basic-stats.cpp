@@ -80,6 +80,7 @@ OBSBasicStats::OBSBasicStats(QWidget *parent, bool closeable)
 	hddSpace = new QLabel(this);
 	recordTimeLeft = new QLabel(this);
 	memUsage = new QLabel(this);
+	audioBuffering = new QLabel(this);
 
 	QString str = MakeTimeLeftText(99999, 59);
 	int textWidth = recordTimeLeft->fontMetrics().boundingRect(str).width();
@@ -89,6 +90,7 @@ OBSBasicStats::OBSBasicStats(QWidget *parent, bool closeable)
 	newStat("HDDSpaceAvailable", hddSpace, 0);
 	newStat("DiskFullIn", recordTimeLeft, 0);
 	newStat("MemoryUsage", memUsage, 0);
+	newStat("AudioBuffering", audioBuffering, 0);
 
 	fps = new QLabel(this);
 	renderTime = new QLabel(this);
@@ -354,6 +356,12 @@ void OBSBasicStats::Update()
 
 	/* ------------------ */
 
+	str = QString::number(obs_get_audio_buffering_ms()) +
+	      QStringLiteral(" ms");
+	audioBuffering->setText(str);
+
+	/* ------------------ */
+
 	num = (long double)obs_get_average_frame_time_ns() / 1000000.0l;
 
 	str = QString::number(num, 'f', 1) + QStringLiteral(" ms");
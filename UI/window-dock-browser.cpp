@@ -1,6 +1,103 @@
 #include "window-dock-browser.hpp"
+#include "obs-app.hpp"
+#include "qt-wrappers.hpp"
 #include <QCloseEvent>
 
+/* how long a dock has to stay hidden before its browser is discarded */
+#define DISCARD_DELAY_MS 60000
+
+static int panel_version()
+{
+	static int version = -1;
+	if (version == -1) {
+		version = obs_browser_qcef_version();
+	}
+	return version;
+}
+
+BrowserDock::BrowserDock() : OBSDock()
+{
+	setAttribute(Qt::WA_NativeWindow);
+
+	discardTimer.setSingleShot(true);
+	discardTimer.setInterval(DISCARD_DELAY_MS);
+	connect(&discardTimer, &QTimer::timeout, this,
+		&BrowserDock::DiscardBrowser);
+
+	connect(this, &QDockWidget::visibilityChanged, this,
+		&BrowserDock::VisibilityChanged);
+}
+
+void BrowserDock::SetDeferredWidget(const std::string &url_,
+				    QCefCookieManager *cookies_,
+				    const std::string &script,
+				    bool allowAllPopups_)
+{
+	deferred = true;
+	url = url_;
+	cookies = cookies_;
+	startupScript = script;
+	allowAllPopups = allowAllPopups_;
+
+	if (isVisible())
+		CreateBrowser();
+}
+
+void BrowserDock::SetURL(const std::string &url_)
+{
+	url = url_;
+
+	if (cefWidget)
+		cefWidget->setURL(url);
+}
+
+void BrowserDock::CreateBrowser()
+{
+	QCefWidget *browser = cef->create_widget(this, url, cookies);
+	if (!browser)
+		return;
+
+	if (allowAllPopups && panel_version() >= 1)
+		browser->allowAllPopups(true);
+	if (!startupScript.empty())
+		browser->setStartupScript(startupScript);
+
+	SetWidget(browser);
+
+	blog(LOG_INFO, "Created browser for dock '%s'",
+	     QT_TO_UTF8(windowTitle()));
+}
+
+void BrowserDock::DiscardBrowser()
+{
+	if (!cefWidget || isVisible())
+		return;
+
+	if (panel_version() >= 2)
+		cefWidget->closeBrowser();
+	cefWidget.reset();
+
+	blog(LOG_INFO, "Discarded browser of hidden dock '%s'",
+	     QT_TO_UTF8(windowTitle()));
+}
+
+void BrowserDock::VisibilityChanged(bool visible)
+{
+	if (!deferred)
+		return;
+
+	if (visible) {
+		discardTimer.stop();
+		if (!cefWidget)
+			CreateBrowser();
+
+	} else if (cefWidget &&
+		   config_get_bool(App()->GlobalConfig(), "General",
+				   "DiscardHiddenBrowserDocks")) {
+		discardTimer.start();
+	}
+}
+
 void BrowserDock::closeEvent(QCloseEvent *event)
 {
 	OBSDock::closeEvent(event);
@@ -9,12 +106,7 @@ void BrowserDock::closeEvent(QCloseEvent *event)
 		return;
 	}
 
-	static int panel_version = -1;
-	if (panel_version == -1) {
-		panel_version = obs_browser_qcef_version();
-	}
-
-	if (panel_version >= 2 && !!cefWidget) {
+	if (panel_version() >= 2 && !!cefWidget) {
 		cefWidget->closeBrowser();
 	}
 }
@@ -2,6 +2,9 @@
 
 #include "window-dock.hpp"
 #include <QScopedPointer>
+#include <QTimer>
+
+#include <string>
 
 #include <browser-panel.hpp>
 extern QCef *cef;
@@ -9,7 +12,7 @@ extern QCefCookieManager *panel_cookies;
 
 class BrowserDock : public OBSDock {
 public:
-	inline BrowserDock() : OBSDock() { setAttribute(Qt::WA_NativeWindow); }
+	BrowserDock();
 
 	QScopedPointer<QCefWidget> cefWidget;
 
@@ -19,5 +22,27 @@ public:
 		cefWidget.reset(widget_);
 	}
 
+	/* Only creates the browser once the dock is first made visible, so
+	 * hidden or tabbed away docks don't start a renderer.  If enabled, the
+	 * browser is also discarded again after the dock stays hidden. */
+	void SetDeferredWidget(const std::string &url,
+			       QCefCookieManager *cookies,
+			       const std::string &script = std::string(),
+			       bool allowAllPopups = false);
+	void SetURL(const std::string &url);
+
 	void closeEvent(QCloseEvent *event) override;
+
+private:
+	void CreateBrowser();
+	void DiscardBrowser();
+	void VisibilityChanged(bool visible);
+
+	bool deferred = false;
+	std::string url;
+	std::string startupScript;
+	QCefCookieManager *cookies = nullptr;
+	bool allowAllPopups = false;
+
+	QTimer discardTimer;
 };
@@ -182,7 +182,7 @@ void ExtraBrowsersModel::UpdateItem(Item &item)
 	main->extraBrowserDockActions[idx]->setText(item.title);
 
 	if (main->extraBrowserDockTargets[idx] != item.url) {
-		dock->cefWidget->setURL(QT_TO_UTF8(item.url));
+		dock->SetURL(QT_TO_UTF8(item.url));
 		main->extraBrowserDockTargets[idx] = item.url;
 	}
 }
@@ -522,11 +522,6 @@ void OBSBasic::ManageExtraBrowserDocks()
 void OBSBasic::AddExtraBrowserDock(const QString &title, const QString &url,
 				   const QString &uuid, bool firstCreate)
 {
-	static int panel_version = -1;
-	if (panel_version == -1) {
-		panel_version = obs_browser_qcef_version();
-	}
-
 	BrowserDock *dock = new BrowserDock();
 	QString bId(uuid.isEmpty() ? QUuid::createUuid().toString() : uuid);
 	bId.replace(QRegularExpression("[{}-]"), "");
@@ -537,12 +532,7 @@ void OBSBasic::AddExtraBrowserDock(const QString &title, const QString &url,
 	dock->setWindowTitle(title);
 	dock->setAllowedAreas(Qt::AllDockWidgetAreas);
 
-	QCefWidget *browser =
-		cef->create_widget(dock, QT_TO_UTF8(url), nullptr);
-	if (browser && panel_version >= 1)
-		browser->allowAllPopups(true);
-
-	dock->SetWidget(browser);
+	std::string script;
 
 	/* Add support for Twitch Dashboard panels */
 	if (url.contains("twitch.tv/popout") &&
@@ -551,17 +541,17 @@ void OBSBasic::AddExtraBrowserDock(const QString &title, const QString &url,
 		QRegularExpressionMatch match = re.match(url);
 		QString username = match.captured(1);
 		if (username.length() > 0) {
-			std::string script;
 			script =
 				"Object.defineProperty(document, 'referrer', { get: () => '";
 			script += "https://twitch.tv/";
 			script += QT_TO_UTF8(username);
 			script += "/dashboard/live";
 			script += "'});";
-			browser->setStartupScript(script);
 		}
 	}
 
+	dock->SetDeferredWidget(QT_TO_UTF8(url), nullptr, script, true);
+
 	addDockWidget(Qt::RightDockWidgetArea, dock);
 
 	if (firstCreate) {
@@ -318,7 +318,10 @@ void OBSProjector::UpdateMultiview()
 	transitionOnDoubleClick = config_get_bool(
 		GetGlobalConfig(), "BasicWindow", "TransitionOnDoubleClick");
 
-	multiview->Update(multiviewLayout, drawLabel, drawSafeArea);
+	int sceneFPS = (int)config_get_int(GetGlobalConfig(), "BasicWindow",
+					   "MultiviewSceneFPS");
+
+	multiview->Update(multiviewLayout, drawLabel, drawSafeArea, sceneFPS);
 }
 
 void OBSProjector::UpdateProjectorTitle(QString name)
@@ -35,6 +35,7 @@
 #include "qt-wrappers.hpp"
 #include "window-basic-main.hpp"
 
+#include <algorithm>
 #include <memory>
 #include <cmath>
 
@@ -582,6 +583,17 @@ void RemuxQueueModel::endProcessing()
 			 index(queue.length(), RemuxEntryColumn::State));
 }
 
+int RemuxQueueModel::pendingCount() const
+{
+	int count = 0;
+
+	for (const RemuxQueueEntry &entry : queue)
+		if (entry.state == RemuxEntryState::Pending)
+			count++;
+
+	return count;
+}
+
 bool RemuxQueueModel::beginNextEntry(QString &inputPath, QString &outputPath)
 {
 	bool anyStarted = false;
@@ -606,11 +618,12 @@ bool RemuxQueueModel::beginNextEntry(QString &inputPath, QString &outputPath)
 	return anyStarted;
 }
 
-void RemuxQueueModel::finishEntry(bool success)
+void RemuxQueueModel::finishEntry(const QString &inputPath, bool success)
 {
 	for (int row = 0; row < queue.length(); row++) {
 		RemuxQueueEntry &entry = queue[row];
-		if (entry.state == RemuxEntryState::InProgress) {
+		if (entry.state == RemuxEntryState::InProgress &&
+		    entry.sourcePath == inputPath) {
 			if (success)
 				entry.state = RemuxEntryState::Complete;
 			else
@@ -632,7 +645,6 @@ void RemuxQueueModel::finishEntry(bool success)
 OBSRemux::OBSRemux(const char *path, QWidget *parent, bool autoRemux_)
 	: QDialog(parent),
 	  queueModel(new RemuxQueueModel),
-	  worker(new RemuxWorker()),
 	  ui(new Ui::OBSRemux),
 	  recPath(path),
 	  autoRemux(autoRemux_)
@@ -694,17 +706,31 @@ OBSRemux::OBSRemux(const char *path, QWidget *parent, bool autoRemux_)
 	connect(ui->buttonBox->button(QDialogButtonBox::Close),
 		SIGNAL(clicked()), this, SLOT(close()));
 
-	worker->moveToThread(&remuxer);
-	remuxer.start();
+	/* remuxing is mostly disk bound, beyond a few files at once they
+	 * just compete for the same drive */
+	int threads = autoRemux ? 1
+				: std::clamp(QThread::idealThreadCount() / 2,
+					     1, 4);
+
+	for (int i = 0; i < threads; i++) {
+		Remuxer *remuxer = new Remuxer;
+		remuxers.emplace_back(remuxer);
+
+		RemuxWorker *worker = new RemuxWorker();
+		remuxer->worker = worker;
+		worker->moveToThread(&remuxer->thread);
+		remuxer->thread.start();
+
+		connect(worker, &RemuxWorker::updateProgress, this,
+			&OBSRemux::updateProgress);
+		connect(&remuxer->thread, &QThread::finished, worker,
+			&QObject::deleteLater);
+		connect(worker, &RemuxWorker::remuxFinished, this,
+			&OBSRemux::remuxFinished);
+	}
 
-	//gcc-4.8 can't use QPointer<RemuxWorker> below
-	RemuxWorker *worker_ = worker;
-	connect(worker_, &RemuxWorker::updateProgress, this,
-		&OBSRemux::updateProgress);
-	connect(&remuxer, &QThread::finished, worker_, &QObject::deleteLater);
-	connect(worker_, &RemuxWorker::remuxFinished, this,
-		&OBSRemux::remuxFinished);
-	connect(this, &OBSRemux::remux, worker_, &RemuxWorker::remux);
+	connect(this, &OBSRemux::remux, remuxers[0]->worker.data(),
+		&RemuxWorker::remux);
 
 	// Guessing the GCC bug mentioned above would also affect
 	// QPointer<RemuxQueueModel>? Unsure.
@@ -721,15 +747,34 @@ OBSRemux::OBSRemux(const char *path, QWidget *parent, bool autoRemux_)
 				  Q_ARG(const QModelIndex &, index));
 }
 
+bool OBSRemux::isWorking() const
+{
+	for (const auto &remuxer : remuxers)
+		if (remuxer->busy || remuxer->worker->isWorking)
+			return true;
+
+	return false;
+}
+
+OBSRemux::Remuxer *OBSRemux::findRemuxer(QObject *worker)
+{
+	for (auto &remuxer : remuxers)
+		if (remuxer->worker == worker)
+			return remuxer.get();
+
+	return nullptr;
+}
+
 bool OBSRemux::stopRemux()
 {
-	if (!worker->isWorking)
+	if (!isWorking())
 		return true;
 
-	// By locking the worker thread's mutex, we ensure that its
-	// update poll will be blocked as long as we're in here with
+	// By locking the worker threads' mutexes, we ensure that their
+	// update polls will be blocked as long as we're in here with
 	// the popup open.
-	QMutexLocker lock(&worker->updateMutex);
+	for (auto &remuxer : remuxers)
+		remuxer->worker->updateMutex.lock();
 
 	bool exit = false;
 
@@ -741,20 +786,27 @@ bool OBSRemux::stopRemux()
 	}
 
 	if (exit) {
-		// Inform the worker it should no longer be
-		// working. It will interrupt accordingly in
-		// its next update callback.
-		worker->isWorking = false;
+		// Inform the workers they should no longer be
+		// working. They will interrupt accordingly in
+		// their next update callback.
+		stopping = true;
+		for (auto &remuxer : remuxers)
+			remuxer->worker->isWorking = false;
 	}
 
+	for (auto &remuxer : remuxers)
+		remuxer->worker->updateMutex.unlock();
+
 	return exit;
 }
 
 OBSRemux::~OBSRemux()
 {
 	stopRemux();
-	remuxer.quit();
-	remuxer.wait();
+	for (auto &remuxer : remuxers) {
+		remuxer->thread.quit();
+		remuxer->thread.wait();
+	}
 }
 
 void OBSRemux::rowCountChanged(const QModelIndex &, int, int)
@@ -822,13 +874,13 @@ void OBSRemux::dropEvent(QDropEvent *ev)
 
 void OBSRemux::dragEnterEvent(QDragEnterEvent *ev)
 {
-	if (ev->mimeData()->hasUrls() && !worker->isWorking)
+	if (ev->mimeData()->hasUrls() && !isWorking())
 		ev->accept();
 }
 
 void OBSRemux::beginRemux()
 {
-	if (worker->isWorking) {
+	if (isWorking()) {
 		stopRemux();
 		return;
 	}
@@ -855,6 +907,11 @@ void OBSRemux::beginRemux()
 	// Set all jobs to "pending" first.
 	queueModel->beginProcessing();
 
+	stopping = false;
+	remuxTotal = queueModel->pendingCount();
+	remuxDone = 0;
+	ui->progressBar->setValue(0);
+
 	ui->progressBar->setVisible(true);
 	ui->buttonBox->button(QDialogButtonBox::Ok)
 		->setText(QTStr("Remux.Stop"));
@@ -874,12 +931,28 @@ void OBSRemux::AutoRemux(QString inFile, QString outFile)
 
 void OBSRemux::remuxNextEntry()
 {
-	worker->lastProgress = 0.f;
+	bool busy = false;
+
+	for (auto &remuxer : remuxers) {
+		QString inputPath, outputPath;
+
+		if (!remuxer->busy && !stopping &&
+		    queueModel->beginNextEntry(inputPath, outputPath)) {
+			remuxer->worker->lastProgress = 0.f;
+			remuxer->sourcePath = inputPath;
+			remuxer->progress = 0.f;
+			remuxer->busy = true;
+
+			QMetaObject::invokeMethod(remuxer->worker, "remux",
+						  Qt::QueuedConnection,
+						  Q_ARG(QString, inputPath),
+						  Q_ARG(QString, outputPath));
+		}
 
-	QString inputPath, outputPath;
-	if (queueModel->beginNextEntry(inputPath, outputPath)) {
-		emit remux(inputPath, outputPath);
-	} else {
+		busy = busy || remuxer->busy;
+	}
+
+	if (!busy) {
 		queueModel->autoRemux = autoRemux;
 		queueModel->endProcessing();
 
@@ -918,16 +991,46 @@ void OBSRemux::reject()
 	QDialog::reject();
 }
 
+void OBSRemux::updateTotalProgress()
+{
+	float total = remuxDone * 100.f;
+
+	for (const auto &remuxer : remuxers)
+		if (remuxer->busy)
+			total += remuxer->progress;
+
+	ui->progressBar->setValue(total * 10.f / remuxTotal);
+}
+
 void OBSRemux::updateProgress(float percent)
 {
-	ui->progressBar->setValue(percent * 10);
+	Remuxer *remuxer = findRemuxer(sender());
+
+	/* auto remux doesn't go through the queue */
+	if (!remuxer || !remuxer->busy || !remuxTotal) {
+		ui->progressBar->setValue(percent * 10);
+		return;
+	}
+
+	remuxer->progress = percent;
+	updateTotalProgress();
 }
 
 void OBSRemux::remuxFinished(bool success)
 {
+	Remuxer *remuxer = findRemuxer(sender());
+
 	ui->buttonBox->button(QDialogButtonBox::Ok)->setEnabled(true);
 
-	queueModel->finishEntry(success);
+	if (remuxer && remuxer->busy) {
+		queueModel->finishEntry(remuxer->sourcePath, success);
+		remuxer->busy = false;
+		remuxer->sourcePath.clear();
+		remuxDone++;
+
+		if (remuxTotal)
+			updateTotalProgress();
+	}
 
 	if (autoRemux && autoRemuxFile != "") {
 		QTimer::singleShot(3000, this, SLOT(close()));
@@ -23,6 +23,7 @@
 #include <QThread>
 #include <QStyledItemDelegate>
 #include <memory>
+#include <vector>
 #include "ui_OBSRemux.h"
 
 #include <media-io/media-remux.h>
@@ -46,8 +47,21 @@ class OBSRemux : public QDialog {
 	Q_OBJECT
 
 	QPointer<RemuxQueueModel> queueModel;
-	QThread remuxer;
-	QPointer<RemuxWorker> worker;
+
+	/* files are remuxed on several threads at once, each entry has a
+	 * worker and tracks the file it's working on */
+	struct Remuxer {
+		QThread thread;
+		QPointer<RemuxWorker> worker;
+		QString sourcePath;
+		bool busy = false;
+		float progress = 0.f;
+	};
+
+	std::vector<std::unique_ptr<Remuxer>> remuxers;
+	bool stopping = false;
+	int remuxTotal = 0;
+	int remuxDone = 0;
 
 	std::unique_ptr<Ui::OBSRemux> ui;
 
@@ -56,6 +70,10 @@ class OBSRemux : public QDialog {
 	virtual void closeEvent(QCloseEvent *event) override;
 	virtual void reject() override;
 
+	bool isWorking() const;
+	Remuxer *findRemuxer(QObject *worker);
+	void updateTotalProgress();
+
 	bool autoRemux;
 	QString autoRemuxFile;
 
@@ -112,8 +130,9 @@ public:
 	bool checkForErrors() const;
 	void beginProcessing();
 	void endProcessing();
+	int pendingCount() const;
 	bool beginNextEntry(QString &inputPath, QString &outputPath);
-	void finishEntry(bool success);
+	void finishEntry(const QString &inputPath, bool success);
 	bool canClearFinished() const;
 	void clearFinished();
 	void clearAll();
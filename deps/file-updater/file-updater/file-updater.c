@@ -33,6 +33,7 @@ struct update_info {
 	char *etag_remote;
 
 	confirm_file_callback_t callback;
+	update_finished_callback_t finished_callback;
 	void *param;
 
 	pthread_t thread;
@@ -462,6 +463,9 @@ static void *update_thread(void *data)
 	update_remote_version(info, cur_version);
 	os_rmdir(info->temp);
 
+	if (info->finished_callback)
+		info->finished_callback(info->param);
+
 	if (info->etag_local)
 		bfree(info->etag_local);
 	if (info->etag_remote)
@@ -476,6 +480,17 @@ update_info_t *update_info_create(const char *log_prefix,
 				  const char *cache_dir,
 				  confirm_file_callback_t confirm_callback,
 				  void *param)
+{
+	return update_info_create_with_finished_callback(
+		log_prefix, user_agent, update_url, local_dir, cache_dir,
+		confirm_callback, NULL, param);
+}
+
+update_info_t *update_info_create_with_finished_callback(
+	const char *log_prefix, const char *user_agent, const char *update_url,
+	const char *local_dir, const char *cache_dir,
+	confirm_file_callback_t confirm_callback,
+	update_finished_callback_t finished_callback, void *param)
 {
 	struct update_info *info;
 	struct dstr dir = {0};
@@ -509,6 +524,7 @@ update_info_t *update_info_create(const char *log_prefix,
 	info->cache = bstrdup(cache_dir);
 	info->url = get_path(update_url, "package.json");
 	info->callback = confirm_callback;
+	info->finished_callback = finished_callback;
 	info->param = param;
 
 	if (pthread_create(&info->thread, NULL, update_thread, info) == 0)
@@ -14,6 +14,7 @@ struct file_download_data {
 
 typedef bool (*confirm_file_callback_t)(void *param,
 					struct file_download_data *file);
+typedef void (*update_finished_callback_t)(void *param);
 
 update_info_t *update_info_create(const char *log_prefix,
 				  const char *user_agent,
@@ -21,6 +22,13 @@ update_info_t *update_info_create(const char *log_prefix,
 				  const char *cache_dir,
 				  confirm_file_callback_t confirm_callback,
 				  void *param);
+/* finished_callback is called on the update thread once the cache directory
+ * is up to date, whether or not anything was updated */
+update_info_t *update_info_create_with_finished_callback(
+	const char *log_prefix, const char *user_agent, const char *update_url,
+	const char *local_dir, const char *cache_dir,
+	confirm_file_callback_t confirm_callback,
+	update_finished_callback_t finished_callback, void *param);
 update_info_t *update_info_create_single(
 	const char *log_prefix, const char *user_agent, const char *file_url,
 	confirm_file_callback_t confirm_callback, void *param);
@@ -17,7 +17,11 @@
 #include "decode.h"
 
 #include "media.h"
+#include <util/platform.h>
 #include <libavutil/mastering_display_metadata.h>
+#ifdef MP_GPU_FRAMES
+#include <libavutil/hwcontext.h>
+#endif
 
 #if LIBAVCODEC_VERSION_INT > AV_VERSION_INT(58, 4, 100)
 #define USE_NEW_HARDWARE_CODEC_METHOD
@@ -71,10 +75,72 @@ static void init_hw_decoder(struct mp_decode *d, AVCodecContext *c)
 		c->opaque = d;
 		d->hw_ctx = hw_ctx;
 		d->hw = true;
+
+#ifdef MP_GPU_FRAMES
+		if (d->gpu && *priority == AV_HWDEVICE_TYPE_VAAPI) {
+#if LIBAVCODEC_VERSION_MAJOR >= 59
+			/* frames are held by libobs until they're drawn */
+			c->extra_hw_frames = 4;
+#endif
+		} else {
+			d->gpu = false;
+		}
+#endif
 	}
 }
 #endif
 
+/* software video decoders split the cores between them by resolution, rather
+ * than every decoder starting a thread per core no matter how many others
+ * are running */
+static pthread_mutex_t thread_budget_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int64_t thread_budget_pixels = 0;
+
+#define MAX_DECODE_THREADS 16
+
+static int mp_reserve_threads(struct mp_decode *d, const AVCodecContext *c)
+{
+	int64_t pixels = (int64_t)c->width * (int64_t)c->height;
+	int64_t total;
+	int threads;
+
+	if (pixels <= 0)
+		pixels = 1920 * 1080;
+
+	pthread_mutex_lock(&thread_budget_mutex);
+	thread_budget_pixels += pixels;
+	total = thread_budget_pixels;
+	pthread_mutex_unlock(&thread_budget_mutex);
+
+	d->thread_pixels = pixels;
+
+	/* past about a thread per 720p worth of pixels the extra threads
+	 * mostly add latency */
+	int max_threads = (int)(pixels / (1280 * 720)) + 1;
+	if (max_threads > MAX_DECODE_THREADS)
+		max_threads = MAX_DECODE_THREADS;
+
+	threads = (int)((int64_t)os_get_logical_cores() * pixels / total);
+	if (threads > max_threads)
+		threads = max_threads;
+	if (threads < 1)
+		threads = 1;
+
+	return threads;
+}
+
+static void mp_release_threads(struct mp_decode *d)
+{
+	if (!d->thread_pixels)
+		return;
+
+	pthread_mutex_lock(&thread_budget_mutex);
+	thread_budget_pixels -= d->thread_pixels;
+	pthread_mutex_unlock(&thread_budget_mutex);
+
+	d->thread_pixels = 0;
+}
+
 static int mp_open_codec(struct mp_decode *d, bool hw)
 {
 	AVCodecContext *c;
@@ -99,6 +165,8 @@ static int mp_open_codec(struct mp_decode *d, bool hw)
 #ifdef USE_NEW_HARDWARE_CODEC_METHOD
 	if (hw)
 		init_hw_decoder(d, c);
+	if (!d->hw)
+		d->gpu = false;
 #else
 	UNUSED_PARAMETER(hw);
 #endif
@@ -106,8 +174,25 @@ static int mp_open_codec(struct mp_decode *d, bool hw)
 	if (c->thread_count == 1 && c->codec_id != AV_CODEC_ID_PNG &&
 	    c->codec_id != AV_CODEC_ID_TIFF &&
 	    c->codec_id != AV_CODEC_ID_JPEG2000 &&
-	    c->codec_id != AV_CODEC_ID_MPEG4 && c->codec_id != AV_CODEC_ID_WEBP)
-		c->thread_count = 0;
+	    c->codec_id != AV_CODEC_ID_MPEG4 &&
+	    c->codec_id != AV_CODEC_ID_WEBP) {
+		if (!d->audio && !d->hw) {
+			c->thread_count = mp_reserve_threads(d, c);
+
+			/* frame threads delay output by a frame each, which
+			 * only matters for live input */
+			c->thread_type = d->m->is_local_file
+						 ? FF_THREAD_FRAME |
+							   FF_THREAD_SLICE
+						 : FF_THREAD_SLICE;
+
+			blog(LOG_DEBUG, "MP: Decoding %dx%d video with %d %s",
+			     c->width, c->height, c->thread_count,
+			     c->thread_count == 1 ? "thread" : "threads");
+		} else {
+			c->thread_count = 0;
+		}
+	}
 
 	ret = avcodec_open2(c, d->codec, NULL);
 	if (ret < 0)
@@ -117,6 +202,7 @@ static int mp_open_codec(struct mp_decode *d, bool hw)
 	return ret;
 
 fail:
+	mp_release_threads(d);
 	avcodec_free_context(&c);
 	avcodec_free_context(&d->decoder);
 
@@ -161,6 +247,9 @@ bool mp_decode_init(mp_media_t *m, enum AVMediaType type, bool hw)
 	memset(d, 0, sizeof(*d));
 	d->m = m;
 	d->audio = type == AVMEDIA_TYPE_AUDIO;
+#ifdef MP_GPU_FRAMES
+	d->gpu = !d->audio && m->gpu_frames;
+#endif
 
 	ret = av_find_best_stream(m->fmt, type, -1, -1, NULL, 0);
 	if (ret < 0)
@@ -220,6 +309,12 @@ bool mp_decode_init(mp_media_t *m, enum AVMediaType type, bool hw)
 		}
 
 		d->in_frame = d->hw_frame;
+
+		if (d->gpu) {
+			d->gpu_frame = av_frame_alloc();
+			if (!d->gpu_frame)
+				d->gpu = false;
+		}
 	} else {
 		d->in_frame = d->sw_frame;
 	}
@@ -257,6 +352,9 @@ void mp_decode_free(struct mp_decode *d)
 	av_packet_free(&d->pkt);
 	av_packet_free(&d->orig_pkt);
 
+	if (d->gpu_frame)
+		av_frame_free(&d->gpu_frame);
+
 	if (d->hw_frame) {
 		av_frame_unref(d->hw_frame);
 		av_free(d->hw_frame);
@@ -265,6 +363,8 @@ void mp_decode_free(struct mp_decode *d)
 	if (d->decoder)
 		avcodec_free_context(&d->decoder);
 
+	mp_release_threads(d);
+
 	if (d->sw_frame) {
 		av_frame_unref(d->sw_frame);
 		av_free(d->sw_frame);
@@ -304,6 +404,39 @@ static inline int64_t get_estimated_duration(struct mp_decode *d,
 	}
 }
 
+#ifdef MP_GPU_FRAMES
+static bool map_gpu_frame(struct mp_decode *d)
+{
+	AVHWFramesContext *frames;
+	int ret;
+
+	if (!d->hw_frame->hw_frames_ctx)
+		return false;
+
+	frames = (AVHWFramesContext *)d->hw_frame->hw_frames_ctx->data;
+	if (frames->sw_format != AV_PIX_FMT_NV12 &&
+	    frames->sw_format != AV_PIX_FMT_P010LE)
+		return false;
+
+	av_frame_unref(d->gpu_frame);
+	d->gpu_frame->format = AV_PIX_FMT_DRM_PRIME;
+
+	ret = av_hwframe_map(d->gpu_frame, d->hw_frame, AV_HWFRAME_MAP_READ);
+	if (ret < 0) {
+		blog(LOG_INFO,
+		     "MP: Failed to map hardware frame (%s), "
+		     "copying frames to system memory instead",
+		     av_err2str(ret));
+		d->gpu = false;
+		return false;
+	}
+
+	av_frame_copy_props(d->gpu_frame, d->hw_frame);
+	d->gpu_sw_format = frames->sw_format;
+	return true;
+}
+#endif
+
 static int decode_packet(struct mp_decode *d, int *got_frame)
 {
 	int ret;
@@ -345,17 +478,18 @@ static int decode_packet(struct mp_decode *d, int *got_frame)
 			return ret;
 		}
 
-		int err = av_hwframe_transfer_data(d->sw_frame, d->hw_frame, 0);
-		if (err) {
+#ifdef MP_GPU_FRAMES
+		if (d->gpu && map_gpu_frame(d)) {
+			d->frame = d->gpu_frame;
+			return ret;
+		}
+#endif
+
+		if (!mp_decode_download_frame(d)) {
 			ret = 0;
 			*got_frame = false;
-		} else {
-			d->sw_frame->color_range = d->hw_frame->color_range;
-			d->sw_frame->color_primaries =
-				d->hw_frame->color_primaries;
-			d->sw_frame->color_trc = d->hw_frame->color_trc;
-			d->sw_frame->colorspace = d->hw_frame->colorspace;
 		}
+		return ret;
 	}
 #endif
 
@@ -363,6 +497,27 @@ static int decode_packet(struct mp_decode *d, int *got_frame)
 	return ret;
 }
 
+/* copies the current hardware frame to system memory, used when it can't be
+ * drawn from directly */
+bool mp_decode_download_frame(struct mp_decode *d)
+{
+#ifdef USE_NEW_HARDWARE_CODEC_METHOD
+	int err = av_hwframe_transfer_data(d->sw_frame, d->hw_frame, 0);
+	if (err)
+		return false;
+
+	d->sw_frame->color_range = d->hw_frame->color_range;
+	d->sw_frame->color_primaries = d->hw_frame->color_primaries;
+	d->sw_frame->color_trc = d->hw_frame->color_trc;
+	d->sw_frame->colorspace = d->hw_frame->colorspace;
+	d->frame = d->sw_frame;
+	return true;
+#else
+	UNUSED_PARAMETER(d);
+	return false;
+#endif
+}
+
 bool mp_decode_next(struct mp_decode *d)
 {
 	bool eof = d->m->eof;
@@ -36,6 +36,13 @@ extern "C" {
 #pragma warning(pop)
 #endif
 
+#if (defined(__linux__) || defined(__FreeBSD__)) && \
+	LIBAVCODEC_VERSION_INT > AV_VERSION_INT(58, 4, 100)
+/* VAAPI frames are mapped to DMA-BUFs and drawn from directly instead of
+ * being downloaded to system memory */
+#define MP_GPU_FRAMES
+#endif
+
 #if LIBAVCODEC_VERSION_MAJOR >= 58
 #define CODEC_CAP_TRUNC AV_CODEC_CAP_TRUNCATED
 #define CODEC_FLAG_TRUNC AV_CODEC_FLAG_TRUNCATED
@@ -61,13 +68,17 @@ struct mp_decode {
 	AVFrame *in_frame;
 	AVFrame *sw_frame;
 	AVFrame *hw_frame;
+	AVFrame *gpu_frame;
 	AVFrame *frame;
 	enum AVPixelFormat hw_format;
+	enum AVPixelFormat gpu_sw_format;
 	bool got_first_keyframe;
 	bool frame_ready;
 	bool eof;
 	bool hw;
+	bool gpu;
 	uint16_t max_luminance;
+	int64_t thread_pixels;
 
 	AVPacket *orig_pkt;
 	AVPacket *pkt;
@@ -83,6 +94,7 @@ extern void mp_decode_clear_packets(struct mp_decode *decode);
 
 extern void mp_decode_push_packet(struct mp_decode *decode, AVPacket *pkt);
 extern bool mp_decode_next(struct mp_decode *decode);
+extern bool mp_decode_download_frame(struct mp_decode *decode);
 extern void mp_decode_flush(struct mp_decode *decode);
 
 #ifdef __cplusplus
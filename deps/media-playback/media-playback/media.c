@@ -25,6 +25,9 @@
 
 #include <libavdevice/avdevice.h>
 #include <libavutil/imgutils.h>
+#ifdef MP_GPU_FRAMES
+#include <libavutil/hwcontext_drm.h>
+#endif
 
 static int64_t base_sys_ts = 0;
 
@@ -170,11 +173,247 @@ static inline struct mp_decode *get_packet_decoder(mp_media_t *media,
 void mp_media_free_packet(struct mp_media *media, AVPacket *pkt)
 {
 	av_packet_unref(pkt);
+
+	if (media->read_ahead)
+		pthread_mutex_lock(&media->io_mutex);
 	da_push_back(media->packet_pool, &pkt);
+	if (media->read_ahead)
+		pthread_mutex_unlock(&media->io_mutex);
+}
+
+static int64_t packet_ts_ns(mp_media_t *m, const AVPacket *pkt)
+{
+	int64_t ts = pkt->dts != AV_NOPTS_VALUE ? pkt->dts : pkt->pts;
+	if (ts == AV_NOPTS_VALUE)
+		return AV_NOPTS_VALUE;
+
+	return av_rescale_q(ts, m->fmt->streams[pkt->stream_index]->time_base,
+			    (AVRational){1, 1000000000});
+}
+
+/* io_mutex must be held for the io_* helpers */
+static int64_t io_queued_ns(mp_media_t *m)
+{
+	AVPacket *first, *last;
+	int64_t first_ts, last_ts;
+
+	if (!m->io_packets.size)
+		return 0;
+
+	circlebuf_peek_front(&m->io_packets, &first, sizeof(first));
+	circlebuf_peek_back(&m->io_packets, &last, sizeof(last));
+
+	first_ts = packet_ts_ns(m, first);
+	last_ts = packet_ts_ns(m, last);
+	if (first_ts == AV_NOPTS_VALUE || last_ts == AV_NOPTS_VALUE ||
+	    last_ts < first_ts)
+		return 0;
+
+	return last_ts - first_ts;
+}
+
+static inline bool io_queue_has(mp_media_t *m, int64_t bytes, int64_t ns)
+{
+	return (int64_t)m->io_size >= bytes || io_queued_ns(m) >= ns;
+}
+
+static inline bool io_queue_full(mp_media_t *m)
+{
+	return io_queue_has(m, m->read_ahead_bytes, m->read_ahead_ns);
+}
+
+/* after running dry, playback waits for the queue to refill halfway rather
+ * than stalling again on every packet */
+static inline bool io_queue_refilled(mp_media_t *m)
+{
+	return io_queue_has(m, m->read_ahead_bytes / 2, m->read_ahead_ns / 2);
+}
+
+static void *mp_media_io_thread(void *opaque)
+{
+	mp_media_t *m = opaque;
+
+	os_set_thread_name("mp_media_io_thread");
+
+	for (;;) {
+		AVPacket *pkt = NULL;
+		AVPacket **cached;
+		bool full, stop;
+		int ret;
+
+		pthread_mutex_lock(&m->mutex);
+		stop = m->io_stop;
+		pthread_mutex_unlock(&m->mutex);
+
+		if (stop)
+			break;
+
+		pthread_mutex_lock(&m->io_mutex);
+		full = io_queue_full(m);
+		if (!full) {
+			cached = da_end(m->packet_pool);
+			if (cached) {
+				pkt = *cached;
+				da_pop_back(m->packet_pool);
+			}
+		}
+		pthread_mutex_unlock(&m->io_mutex);
+
+		if (full) {
+			os_event_timedwait(m->io_space, 10);
+			continue;
+		}
+
+		if (!pkt)
+			pkt = av_packet_alloc();
+
+		ret = av_read_frame(m->fmt, pkt);
+		if (ret < 0) {
+			if (ret != AVERROR_EOF && ret != AVERROR_EXIT)
+				blog(LOG_WARNING,
+				     "MP: av_read_frame failed: %s (%d)",
+				     av_err2str(ret), ret);
+
+			av_packet_free(&pkt);
+
+			pthread_mutex_lock(&m->io_mutex);
+			m->io_ret = ret;
+			pthread_mutex_unlock(&m->io_mutex);
+			os_event_signal(m->io_data);
+			break;
+		}
+
+		if (!pkt->size || !get_packet_decoder(m, pkt)) {
+			mp_media_free_packet(m, pkt);
+			continue;
+		}
+
+		pthread_mutex_lock(&m->io_mutex);
+		circlebuf_push_back(&m->io_packets, &pkt, sizeof(pkt));
+		m->io_size += pkt->size;
+		pthread_mutex_unlock(&m->io_mutex);
+
+		os_event_signal(m->io_data);
+	}
+
+	return NULL;
+}
+
+static bool mp_media_io_interrupted(mp_media_t *m)
+{
+	bool stop;
+
+	pthread_mutex_lock(&m->mutex);
+	stop = m->kill || m->stopping;
+	pthread_mutex_unlock(&m->mutex);
+
+	return stop;
+}
+
+static int mp_media_next_queued_packet(mp_media_t *m)
+{
+	AVPacket *pkt = NULL;
+	uint64_t wait_start = 0;
+	int ret = 0;
+
+	pthread_mutex_lock(&m->io_mutex);
+
+	for (;;) {
+		if (m->io_packets.size &&
+		    (!m->io_rebuffering || m->io_ret < 0 ||
+		     io_queue_refilled(m))) {
+			circlebuf_pop_front(&m->io_packets, &pkt, sizeof(pkt));
+			m->io_size -= pkt->size;
+			m->io_rebuffering = false;
+			break;
+		}
+
+		if (!m->io_packets.size && m->io_ret < 0) {
+			ret = m->io_ret;
+			break;
+		}
+
+		if (!m->io_packets.size && !m->io_rebuffering) {
+			m->io_rebuffering = true;
+			m->io_underruns++;
+		}
+
+		pthread_mutex_unlock(&m->io_mutex);
+
+		if (mp_media_io_interrupted(m))
+			return AVERROR_EXIT;
+
+		if (!wait_start)
+			wait_start = os_gettime_ns();
+		os_event_timedwait(m->io_data, 100);
+
+		pthread_mutex_lock(&m->io_mutex);
+	}
+
+	/* the initial fill isn't a rebuffer */
+	if (wait_start && m->io_underruns)
+		m->io_rebuffer_ns += os_gettime_ns() - wait_start;
+
+	pthread_mutex_unlock(&m->io_mutex);
+
+	if (!pkt)
+		return ret;
+
+	os_event_signal(m->io_space);
+	mp_decode_push_packet(get_packet_decoder(m, pkt), pkt);
+	return 0;
+}
+
+static bool mp_media_start_io(mp_media_t *m)
+{
+	if (os_event_init(&m->io_data, OS_EVENT_TYPE_AUTO) != 0 ||
+	    os_event_init(&m->io_space, OS_EVENT_TYPE_AUTO) != 0) {
+		blog(LOG_WARNING, "MP: Failed to init read ahead events");
+		return false;
+	}
+
+	/* buffer up halfway before playback starts */
+	m->io_rebuffering = true;
+
+	if (pthread_create(&m->io_thread, NULL, mp_media_io_thread, m) != 0) {
+		blog(LOG_WARNING, "MP: Could not create read ahead thread");
+		return false;
+	}
+
+	m->io_thread_valid = true;
+	return true;
+}
+
+static void mp_media_stop_io(mp_media_t *m)
+{
+	if (m->io_thread_valid) {
+		pthread_mutex_lock(&m->mutex);
+		m->io_stop = true;
+		pthread_mutex_unlock(&m->mutex);
+		os_event_signal(m->io_space);
+
+		pthread_join(m->io_thread, NULL);
+		m->io_thread_valid = false;
+	}
+
+	while (m->io_packets.size) {
+		AVPacket *pkt;
+		circlebuf_pop_front(&m->io_packets, &pkt, sizeof(pkt));
+		av_packet_free(&pkt);
+	}
+
+	circlebuf_free(&m->io_packets);
+	os_event_destroy(m->io_data);
+	os_event_destroy(m->io_space);
+	m->io_data = NULL;
+	m->io_space = NULL;
 }
 
 static int mp_media_next_packet(mp_media_t *media)
 {
+	if (media->io_thread_valid)
+		return mp_media_next_queued_packet(media);
+
 	AVPacket *pkt;
 	AVPacket **const cached = da_end(media->packet_pool);
 	if (cached) {
@@ -301,8 +540,13 @@ static bool mp_media_prepare_frames(mp_media_t *m)
 	}
 
 	if (m->has_video && m->v.frame_ready && !m->swscale) {
-		m->scale_format = closest_format(m->v.frame->format);
-		if (m->scale_format != m->v.frame->format) {
+		enum AVPixelFormat format = m->v.frame->format;
+#ifdef MP_GPU_FRAMES
+		if (format == AV_PIX_FMT_DRM_PRIME)
+			format = m->v.gpu_sw_format;
+#endif
+		m->scale_format = closest_format(format);
+		if (m->scale_format != format) {
 			if (!mp_media_init_scaling(m)) {
 				return false;
 			}
@@ -392,10 +636,33 @@ static inline int64_t mp_media_get_base_pts(mp_media_t *m)
 
 static inline bool mp_media_can_play_frame(mp_media_t *m, struct mp_decode *d)
 {
+	if (m->prefetching)
+		return d->frame_ready;
+
 	return d->frame_ready && (d->frame_pts <= m->next_pts_ns ||
 				  (d->frame_pts - m->next_pts_ns > MAX_TS_VAR));
 }
 
+static inline void clear_cache(mp_media_t *m);
+
+/* once the file doesn't fit in the cache budget the cache is dropped and
+ * every loop is decoded again */
+static bool mp_media_cache_reserve(mp_media_t *m, int64_t size)
+{
+	if (m->cache_budget && m->cache_size + size > m->cache_budget) {
+		blog(LOG_INFO,
+		     "MP: '%s' does not fit in the %d MB cache budget, "
+		     "disabling caching",
+		     m->path, (int)(m->cache_budget / (1024 * 1024)));
+		clear_cache(m);
+		m->enable_caching = false;
+		return false;
+	}
+
+	m->cache_size += size;
+	return true;
+}
+
 static void mp_media_next_audio(mp_media_t *m)
 {
 	if (!m->process_audio) {
@@ -454,7 +721,9 @@ static void mp_media_next_audio(mp_media_t *m)
 			return;
 		}
 
-		if (m->enable_caching) {
+		if (m->enable_caching &&
+		    mp_media_cache_reserve(
+			    m, (int64_t)f->linesize[0] * f->channels)) {
 			if (m->audio.index > 0) {
 				struct obs_source_audio *previous_frame =
 					m->audio.data.array[m->audio.index - 1];
@@ -474,7 +743,7 @@ static void mp_media_next_audio(mp_media_t *m)
 
 	m->audio.index++;
 
-	if (audio) {
+	if (audio && !m->prefetching) {
 		m->a_cb(m->opaque, audio);
 	}
 
@@ -486,6 +755,137 @@ static void mp_media_next_audio(mp_media_t *m)
 	}
 }
 
+#ifdef MP_GPU_FRAMES
+#define MP_FOURCC(a, b, c, d)                                  \
+	((uint32_t)(a) | ((uint32_t)(b) << 8) | ((uint32_t)(c) << 16) | \
+	 ((uint32_t)(d) << 24))
+
+#define MP_DRM_FORMAT_R8 MP_FOURCC('R', '8', ' ', ' ')
+#define MP_DRM_FORMAT_GR88 MP_FOURCC('G', 'R', '8', '8')
+#define MP_DRM_FORMAT_R16 MP_FOURCC('R', '1', '6', ' ')
+#define MP_DRM_FORMAT_GR1616 MP_FOURCC('G', 'R', '3', '2')
+
+/* if the graphics driver can't import decoder surfaces, every media source
+ * goes back to downloading frames */
+static volatile bool gpu_import_failed = false;
+
+struct mp_gpu_frame {
+	AVFrame *frame;
+	enum AVPixelFormat sw_format;
+	gs_texture_t *tex[2];
+	bool failed;
+};
+
+static gs_texture_t *import_plane(const AVDRMFrameDescriptor *desc,
+				  const AVDRMPlaneDescriptor *plane,
+				  uint32_t width, uint32_t height,
+				  uint32_t drm_format,
+				  enum gs_color_format format)
+{
+	const AVDRMObjectDescriptor *obj = &desc->objects[plane->object_index];
+	int fd = obj->fd;
+	uint32_t stride = (uint32_t)plane->pitch;
+	uint32_t offset = (uint32_t)plane->offset;
+	uint64_t modifier = obj->format_modifier;
+
+	return gs_texture_create_from_dmabuf(width, height, drm_format, format,
+					     1, &fd, &stride, &offset,
+					     &modifier);
+}
+
+/* decoders export NV12 and P010 either as one layer with two planes or as
+ * a layer per plane, both are imported as separate Y and UV textures */
+static bool import_gpu_frame(struct mp_gpu_frame *g)
+{
+	const AVDRMFrameDescriptor *desc =
+		(const AVDRMFrameDescriptor *)g->frame->data[0];
+	const AVDRMPlaneDescriptor *planes[2] = {NULL, NULL};
+	const bool p010 = g->sw_format == AV_PIX_FMT_P010LE;
+	uint32_t cx = (uint32_t)g->frame->width;
+	uint32_t cy = (uint32_t)g->frame->height;
+	size_t count = 0;
+
+	for (int i = 0; i < desc->nb_layers && count < 2; i++) {
+		const AVDRMLayerDescriptor *layer = &desc->layers[i];
+		for (int j = 0; j < layer->nb_planes && count < 2; j++)
+			planes[count++] = &layer->planes[j];
+	}
+
+	if (count != 2)
+		return false;
+
+	g->tex[0] = import_plane(desc, planes[0], cx, cy,
+				 p010 ? MP_DRM_FORMAT_R16 : MP_DRM_FORMAT_R8,
+				 p010 ? GS_R16 : GS_R8);
+	g->tex[1] = import_plane(desc, planes[1], (cx + 1) / 2, (cy + 1) / 2,
+				 p010 ? MP_DRM_FORMAT_GR1616
+				      : MP_DRM_FORMAT_GR88,
+				 p010 ? GS_RG16 : GS_R8G8);
+
+	if (!g->tex[0] || !g->tex[1]) {
+		gs_texture_destroy(g->tex[0]);
+		gs_texture_destroy(g->tex[1]);
+		g->tex[0] = NULL;
+		g->tex[1] = NULL;
+		return false;
+	}
+
+	return true;
+}
+
+static bool mp_gpu_frame_get_textures(void *param,
+				      gs_texture_t *tex[MAX_AV_PLANES])
+{
+	struct mp_gpu_frame *g = param;
+
+	if (!g->tex[0] && !g->failed && !import_gpu_frame(g)) {
+		if (!os_atomic_set_bool(&gpu_import_failed, true))
+			blog(LOG_WARNING, "MP: Failed to import decoded "
+					  "frames, copying frames to system "
+					  "memory instead");
+		g->failed = true;
+	}
+
+	tex[0] = g->tex[0];
+	tex[1] = g->tex[1];
+	return !g->failed;
+}
+
+static void mp_gpu_frame_release(void *param)
+{
+	struct mp_gpu_frame *g = param;
+
+	if (g->tex[0]) {
+		obs_enter_graphics();
+		gs_texture_destroy(g->tex[0]);
+		gs_texture_destroy(g->tex[1]);
+		obs_leave_graphics();
+	}
+
+	av_frame_free(&g->frame);
+	bfree(g);
+}
+
+static bool mp_gpu_frame_attach(struct obs_source_frame *frame, AVFrame *f,
+				enum AVPixelFormat sw_format)
+{
+	struct mp_gpu_frame *g = bzalloc(sizeof(*g));
+
+	g->frame = av_frame_clone(f);
+	g->sw_format = sw_format;
+
+	if (!g->frame) {
+		bfree(g);
+		return false;
+	}
+
+	frame->gpu.get_textures = mp_gpu_frame_get_textures;
+	frame->gpu.release = mp_gpu_frame_release;
+	frame->gpu.param = g;
+	return true;
+}
+#endif
+
 static void mp_media_next_video(mp_media_t *m, bool preload)
 {
 	if (!m->process_video) {
@@ -499,6 +899,7 @@ static void mp_media_next_video(mp_media_t *m, bool preload)
 	enum video_range_type new_range;
 	AVFrame *f = d->frame;
 	struct obs_source_frame *frame;
+	bool gpu = false;
 
 	if (m->video.index_eof < 0 || !m->enable_caching) {
 		if (!preload) {
@@ -517,7 +918,29 @@ static void mp_media_next_video(mp_media_t *m, bool preload)
 
 		struct obs_source_frame *current_frame = &m->obsframe;
 		bool flip = false;
-		if (m->swscale) {
+
+		memset(&current_frame->gpu, 0, sizeof(current_frame->gpu));
+
+#ifdef MP_GPU_FRAMES
+		gpu = f->format == AV_PIX_FMT_DRM_PRIME;
+
+		/* preloaded and seek frames are copied by libobs */
+		if (gpu && (preload || m->swscale ||
+			    os_atomic_load_bool(&gpu_import_failed))) {
+			if (!mp_decode_download_frame(d))
+				return;
+			f = d->frame;
+			gpu = false;
+		}
+#endif
+
+		if (gpu) {
+			for (size_t i = 0; i < MAX_AV_PLANES; i++) {
+				current_frame->data[i] = NULL;
+				current_frame->linesize[i] = 0;
+			}
+
+		} else if (m->swscale) {
 			int ret = sws_scale(m->swscale,
 					    (const uint8_t *const *)f->data,
 					    f->linesize, 0, f->height,
@@ -548,6 +971,10 @@ static void mp_media_next_video(mp_media_t *m, bool preload)
 				current_frame->linesize[0] * (f->height - 1);
 
 		new_format = convert_pixel_format(m->scale_format);
+#ifdef MP_GPU_FRAMES
+		if (gpu)
+			new_format = convert_pixel_format(d->gpu_sw_format);
+#endif
 		new_space = convert_color_space(f->colorspace, f->color_trc,
 						f->color_primaries);
 		new_range = m->force_range == VIDEO_RANGE_DEFAULT
@@ -617,7 +1044,11 @@ static void mp_media_next_video(mp_media_t *m, bool preload)
 		if (!m->pix_format)
 			m->pix_format = current_frame->format;
 
-		if (m->enable_caching) {
+		if (m->enable_caching &&
+		    mp_media_cache_reserve(
+			    m, av_image_get_buffer_size(
+				       m->swscale ? m->scale_format : f->format,
+				       f->width, f->height, 1))) {
 			struct obs_source_frame *new_frame =
 				obs_source_frame_create(current_frame->format,
 							current_frame->width,
@@ -646,13 +1077,18 @@ static void mp_media_next_video(mp_media_t *m, bool preload)
 	}
 	m->video.index++;
 
+#ifdef MP_GPU_FRAMES
+	if (gpu && !mp_gpu_frame_attach(frame, f, d->gpu_sw_format))
+		return;
+#endif
+
 	if (preload) {
 		if (m->seek_next_ts && m->v_seek_cb) {
 			m->v_seek_cb(m->opaque, frame);
 		} else {
 			m->v_preload_cb(m->opaque, frame);
 		}
-	} else {
+	} else if (!m->prefetching) {
 		m->v_cb(m->opaque, frame);
 	}
 }
@@ -694,10 +1130,16 @@ static inline void clear_cache(mp_media_t *m)
 						      m->audio.data.array[i])
 					     ->data[j]);
 			}
+			free(m->audio.data.array[i]);
 		}
 	}
 	da_free(m->video.data);
 	da_free(m->audio.data);
+	m->video.index = 0;
+	m->video.index_eof = -1;
+	m->audio.index = 0;
+	m->audio.index_eof = -1;
+	m->cache_size = 0;
 }
 
 static void seek_to(mp_media_t *m, int64_t pos)
@@ -840,7 +1282,7 @@ static int interrupt_callback(void *data)
 
 	if ((ts - m->interrupt_poll_ts) > 20000000) {
 		pthread_mutex_lock(&m->mutex);
-		stop = m->kill || m->stopping;
+		stop = m->kill || m->stopping || m->io_stop;
 		pthread_mutex_unlock(&m->mutex);
 
 		m->interrupt_poll_ts = ts;
@@ -936,6 +1378,9 @@ static bool init_avformat(mp_media_t *m)
 		return false;
 	}
 
+	if (m->read_ahead && !mp_media_start_io(m))
+		return false;
+
 	return true;
 }
 
@@ -947,6 +1392,60 @@ static void reset_ts(mp_media_t *m)
 	m->next_ns = 0;
 }
 
+static void mp_media_fill_cache(mp_media_t *m)
+{
+	bool interrupted = false;
+
+	if (!m->enable_caching || m->video.index_eof >= 0 ||
+	    m->audio.index_eof >= 0)
+		return;
+
+	/* drop anything cached by a play that was stopped part way */
+	clear_cache(m);
+	m->prefetching = true;
+
+	while (m->enable_caching) {
+		bool stop;
+
+		pthread_mutex_lock(&m->mutex);
+		stop = m->active || m->kill;
+		pthread_mutex_unlock(&m->mutex);
+
+		if (stop) {
+			interrupted = true;
+			break;
+		}
+
+		bool v_ended = !m->has_video || !m->v.frame_ready;
+		bool a_ended = !m->has_audio || !m->a.frame_ready;
+		if (v_ended && a_ended) {
+			m->video.index_eof = m->video.index;
+			m->audio.index_eof = m->audio.index;
+			break;
+		}
+
+		m->process_video = true;
+		m->process_audio = true;
+		if (m->has_video)
+			mp_media_next_video(m, false);
+		if (m->has_audio)
+			mp_media_next_audio(m);
+
+		if (!mp_media_prepare_frames(m)) {
+			interrupted = true;
+			break;
+		}
+	}
+
+	m->prefetching = false;
+
+	/* a partially filled cache can't be continued from the start */
+	if (interrupted && m->enable_caching)
+		clear_cache(m);
+
+	mp_media_reset(m);
+}
+
 static inline bool mp_media_thread(mp_media_t *m)
 {
 	os_set_thread_name("mp_media_thread");
@@ -961,7 +1460,7 @@ static inline bool mp_media_thread(mp_media_t *m)
 		m->ready_cb(m->opaque);
 
 	for (;;) {
-		bool reset, kill, is_active, seek, pause, reset_time;
+		bool reset, kill, is_active, seek, pause, reset_time, prefetch;
 		int64_t seek_pos;
 		bool timeout = false;
 
@@ -993,6 +1492,8 @@ static inline bool mp_media_thread(mp_media_t *m)
 		reset_time = m->reset_ts;
 		m->seek = false;
 		m->reset_ts = false;
+		prefetch = m->prefetch;
+		m->prefetch = false;
 
 		pthread_mutex_unlock(&m->mutex);
 
@@ -1004,6 +1505,11 @@ static inline bool mp_media_thread(mp_media_t *m)
 			continue;
 		}
 
+		if (prefetch) {
+			mp_media_fill_cache(m);
+			continue;
+		}
+
 		if (seek) {
 			m->seek_next_ts = true;
 			seek_to(m, seek_pos);
@@ -1151,6 +1657,10 @@ static inline bool mp_media_init_internal(mp_media_t *m,
 		blog(LOG_WARNING, "MP: Failed to init semaphore");
 		return false;
 	}
+	if (pthread_mutex_init(&m->io_mutex, NULL) != 0) {
+		blog(LOG_WARNING, "MP: Failed to init read ahead mutex");
+		return false;
+	}
 
 	m->path = info->path ? bstrdup(info->path) : NULL;
 	m->format_name = info->format ? bstrdup(info->format) : NULL;
@@ -1177,6 +1687,7 @@ bool mp_media_init(mp_media_t *media, const struct mp_media_info *info)
 {
 	memset(media, 0, sizeof(*media));
 	pthread_mutex_init_value(&media->mutex);
+	pthread_mutex_init_value(&media->io_mutex);
 	media->opaque = info->opaque;
 	media->v_cb = info->v_cb;
 	media->a_cb = info->a_cb;
@@ -1190,6 +1701,14 @@ bool mp_media_init(mp_media_t *media, const struct mp_media_info *info)
 	media->speed = info->speed;
 	media->is_local_file = info->is_local_file;
 	media->enable_caching = info->enable_caching;
+	media->cache_budget = info->cache_budget;
+	media->read_ahead = !info->is_local_file && info->read_ahead_ms > 0;
+	media->read_ahead_ns = (int64_t)info->read_ahead_ms * 1000000;
+	media->read_ahead_bytes = info->read_ahead_bytes > 0
+					  ? info->read_ahead_bytes
+					  : INT64_MAX;
+	/* cached frames are copied, which needs them in system memory */
+	media->gpu_frames = info->hardware_decoding && !info->enable_caching;
 	media->volume = info->volume;
 	da_init(media->packet_pool);
 
@@ -1237,6 +1756,7 @@ void mp_media_free(mp_media_t *media)
 
 	mp_media_stop(media);
 	mp_kill_thread(media);
+	mp_media_stop_io(media);
 	mp_decode_free(&media->v);
 	mp_decode_free(&media->a);
 	for (size_t i = 0; i < media->packet_pool.num; i++)
@@ -1244,6 +1764,7 @@ void mp_media_free(mp_media_t *media)
 	da_free(media->packet_pool);
 	avformat_close_input(&media->fmt);
 	pthread_mutex_destroy(&media->mutex);
+	pthread_mutex_destroy(&media->io_mutex);
 	os_sem_destroy(media->sem);
 	sws_freeContext(media->swscale);
 	av_freep(&media->scale_pic[0]);
@@ -1251,6 +1772,7 @@ void mp_media_free(mp_media_t *media)
 	bfree(media->format_name);
 	memset(media, 0, sizeof(*media));
 	pthread_mutex_init_value(&media->mutex);
+	pthread_mutex_init_value(&media->io_mutex);
 }
 
 void mp_media_play(mp_media_t *m, bool loop, bool reconnecting)
@@ -1299,6 +1821,32 @@ void mp_media_stop(mp_media_t *m)
 	os_sem_post(m->sem);
 }
 
+void mp_media_prefetch(mp_media_t *m)
+{
+	pthread_mutex_lock(&m->mutex);
+	if (!m->active)
+		m->prefetch = true;
+	pthread_mutex_unlock(&m->mutex);
+
+	os_sem_post(m->sem);
+}
+
+bool mp_media_get_io_stats(mp_media_t *m, struct mp_media_io_stats *stats)
+{
+	memset(stats, 0, sizeof(*stats));
+
+	if (!m->read_ahead)
+		return false;
+
+	pthread_mutex_lock(&m->io_mutex);
+	stats->buffered_bytes = (int64_t)m->io_size;
+	stats->buffered_ms = io_queued_ns(m) / 1000000;
+	stats->underruns = m->io_underruns;
+	stats->rebuffer_ms = m->io_rebuffer_ns / 1000000;
+	pthread_mutex_unlock(&m->io_mutex);
+	return true;
+}
+
 int64_t mp_get_current_time(mp_media_t *m)
 {
 	return mp_media_get_base_pts(m) * (int64_t)m->speed / 100000000LL;
@@ -84,6 +84,7 @@ struct mp_media {
 	bool is_file;
 	bool eof;
 	bool hw;
+	bool gpu_frames;
 
 	struct obs_source_frame obsframe;
 	enum video_colorspace cur_space;
@@ -111,7 +112,29 @@ struct mp_media {
 	bool thread_valid;
 	pthread_t thread;
 
+	/* network input is read ahead on its own thread, so a stall in the
+	 * connection doesn't stall playback right away */
+	bool read_ahead;
+	int64_t read_ahead_bytes;
+	int64_t read_ahead_ns;
+	pthread_mutex_t io_mutex;
+	os_event_t *io_data;
+	os_event_t *io_space;
+	struct circlebuf io_packets;
+	size_t io_size;
+	int io_ret;
+	bool io_stop;
+	bool io_rebuffering;
+	uint64_t io_underruns;
+	uint64_t io_rebuffer_ns;
+	bool io_thread_valid;
+	pthread_t io_thread;
+
 	bool enable_caching;
+	int64_t cache_budget;
+	int64_t cache_size;
+	bool prefetch;
+	bool prefetching;
 	struct cached_data video;
 	struct cached_data audio;
 	bool process_audio;
@@ -147,10 +170,22 @@ struct mp_media_info {
 	bool hardware_decoding;
 	bool is_local_file;
 	bool enable_caching;
+	/* in bytes, 0 for no limit */
+	int64_t cache_budget;
+	/* network input only, read ahead is off when read_ahead_ms is 0 */
+	int read_ahead_ms;
+	int read_ahead_bytes;
 	bool reconnecting;
 	int64_t volume;
 };
 
+struct mp_media_io_stats {
+	int64_t buffered_bytes;
+	int64_t buffered_ms;
+	uint64_t underruns;
+	uint64_t rebuffer_ms;
+};
+
 extern bool mp_media_init(mp_media_t *media, const struct mp_media_info *info);
 extern void mp_media_free(mp_media_t *media);
 
@@ -160,6 +195,14 @@ extern void mp_media_play_pause(mp_media_t *media, bool pause);
 extern int64_t mp_get_current_time(mp_media_t *m);
 extern void mp_media_seek_to(mp_media_t *m, int64_t pos);
 
+/* decodes the whole file into the frame cache while stopped, so the first
+ * play doesn't have to decode.  does nothing unless caching is enabled */
+extern void mp_media_prefetch(mp_media_t *m);
+
+/* returns false if the media isn't being read ahead */
+extern bool mp_media_get_io_stats(mp_media_t *m,
+				  struct mp_media_io_stats *stats);
+
 /* #define DETAILED_DEBUG_INFO */
 
 #ifdef __cplusplus
@@ -78,11 +78,38 @@ static inline void get_callback_from_table_(lua_State *script, int idx,
 #define get_callback_from_table(script, idx, name, p_reg_idx) \
 	get_callback_from_table_(script, idx, name, p_reg_idx, __FUNCTION__)
 
+/* the cache is only touched with the script's lock held, the same as the
+ * lua state itself */
+static swig_type_info *query_type(lua_State *script, const char *type)
+{
+	struct obs_lua_script *data = current_lua_script;
+	swig_type_info *info;
+
+	if (!data || data->script != script)
+		return SWIG_TypeQuery(script, type);
+
+	for (size_t i = 0; i < data->type_cache_size; i++) {
+		struct lua_type_cache *entry = &data->type_cache[i];
+		if (entry->type == type || strcmp(entry->type, type) == 0)
+			return entry->info;
+	}
+
+	info = SWIG_TypeQuery(script, type);
+	if (info && data->type_cache_size < LUA_TYPE_CACHE_SIZE) {
+		struct lua_type_cache *entry =
+			&data->type_cache[data->type_cache_size++];
+		entry->type = type;
+		entry->info = info;
+	}
+
+	return info;
+}
+
 bool ls_get_libobs_obj_(lua_State *script, const char *type, int lua_idx,
 			void *libobs_out, const char *id, const char *func,
 			int line)
 {
-	swig_type_info *info = SWIG_TypeQuery(script, type);
+	swig_type_info *info = query_type(script, type);
 	if (info == NULL) {
 		warn("%s:%d: SWIG could not find type: %s%s%s", func, line,
 		     id ? id : "", id ? "::" : "", type);
@@ -108,7 +135,7 @@ bool ls_push_libobs_obj_(lua_State *script, const char *type, void *libobs_in,
 			 bool ownership, const char *id, const char *func,
 			 int line)
 {
-	swig_type_info *info = SWIG_TypeQuery(script, type);
+	swig_type_info *info = query_type(script, type);
 	if (info == NULL) {
 		warn("%s:%d: SWIG could not find type: %s%s%s", func, line,
 		     id ? id : "", id ? "::" : "", type);
@@ -159,6 +159,11 @@ static bool load_lua_script(struct obs_lua_script *data)
 		pthread_mutex_unlock(&tick_mutex);
 	}
 
+	lua_getglobal(script, "script_tick_interval");
+	if (lua_isnumber(script, -1))
+		data->tick_interval = (float)lua_tonumber(script, -1);
+	lua_pop(script, 1);
+
 	lua_getglobal(script, "script_properties");
 	if (lua_isfunction(script, -1))
 		data->get_properties = luaL_ref(script, LUA_REGISTRYINDEX);
@@ -1057,15 +1062,25 @@ static void lua_tick(void *param, float seconds)
 	data = first_tick_script;
 	while (data) {
 		lua_State *script = data->script;
+
+		/* scripts that set script_tick_interval are only called
+		 * once that much time has gone by, with the total elapsed */
+		data->tick_elapsed += seconds;
+		if (data->tick_elapsed < data->tick_interval) {
+			data = data->next_tick;
+			continue;
+		}
+
 		current_lua_script = data;
 
 		pthread_mutex_lock(&data->mutex);
 
-		lua_pushnumber(script, (double)seconds);
+		lua_pushnumber(script, (double)data->tick_elapsed);
 		call_func_(script, data->tick, 1, 0, "tick", __FUNCTION__);
 
 		pthread_mutex_unlock(&data->mutex);
 
+		data->tick_elapsed = 0.0f;
 		data = data->next_tick;
 	}
 	current_lua_script = NULL;
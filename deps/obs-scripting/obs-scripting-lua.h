@@ -64,6 +64,15 @@ extern THREAD_LOCAL struct obs_lua_script *current_lua_script;
 
 struct lua_obs_callback;
 
+/* SWIG looks types up by name, which is a search through every type in the
+ * module, so the types a script actually uses are cached per script */
+#define LUA_TYPE_CACHE_SIZE 16
+
+struct lua_type_cache {
+	const char *type;
+	swig_type_info *info;
+};
+
 struct obs_lua_script {
 	obs_script_t base;
 
@@ -80,9 +89,14 @@ struct obs_lua_script {
 	int save;
 
 	int tick;
+	float tick_interval;
+	float tick_elapsed;
 	struct obs_lua_script *next_tick;
 	struct obs_lua_script **p_prev_next_tick;
 
+	struct lua_type_cache type_cache[LUA_TYPE_CACHE_SIZE];
+	size_t type_cache_size;
+
 	bool defined_sources;
 };
 
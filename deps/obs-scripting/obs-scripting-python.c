@@ -276,6 +276,18 @@ static bool load_python_script(struct obs_python_script *data)
 		PyErr_Clear();
 	}
 
+	PyObject *py_interval =
+		PyObject_GetAttrString(py_module, "script_tick_interval");
+	if (py_interval) {
+		double interval = PyFloat_AsDouble(py_interval);
+		if (!PyErr_Occurred())
+			data->tick_interval = (float)interval;
+		PyErr_Clear();
+		Py_DECREF(py_interval);
+	} else {
+		PyErr_Clear();
+	}
+
 	py_load = PyObject_GetAttrString(py_module, "script_load");
 	if (py_load) {
 		PyObject *py_s;
@@ -1514,11 +1526,23 @@ void obs_python_script_save(obs_script_t *s)
 static void python_tick(void *param, float seconds)
 {
 	struct obs_python_script *data;
-	bool valid;
+	bool python_locked = false;
+	bool valid = false;
 	uint64_t ts = obs_get_video_frame_time();
 
+	/* scripts that set script_tick_interval are only called once that
+	 * much time has gone by, so the GIL isn't taken at all on frames
+	 * where nothing is due */
 	pthread_mutex_lock(&tick_mutex);
-	valid = !!first_tick_script;
+	data = first_tick_script;
+	while (data) {
+		data->tick_elapsed += seconds;
+		data->tick_due = data->tick_elapsed >= data->tick_interval;
+		if (data->tick_due)
+			valid = true;
+
+		data = data->next_tick;
+	}
 	pthread_mutex_unlock(&tick_mutex);
 
 	/* --------------------------------- */
@@ -1532,13 +1556,27 @@ static void python_tick(void *param, float seconds)
 		pthread_mutex_lock(&tick_mutex);
 		data = first_tick_script;
 		while (data) {
+			if (!data->tick_due) {
+				data = data->next_tick;
+				continue;
+			}
+
 			cur_python_script = data;
 
+			PyObject *script_args = args;
+			if (data->tick_elapsed != seconds)
+				script_args = Py_BuildValue(
+					"(f)", data->tick_elapsed);
+
 			PyObject *py_ret =
-				PyObject_CallObject(data->tick, args);
+				PyObject_CallObject(data->tick, script_args);
 			Py_XDECREF(py_ret);
+			if (script_args != args)
+				Py_XDECREF(script_args);
 			py_error();
 
+			data->tick_elapsed = 0.0f;
+			data->tick_due = false;
 			data = data->next_tick;
 		}
 
@@ -1565,17 +1603,23 @@ static void python_tick(void *param, float seconds)
 		} else {
 			uint64_t elapsed = ts - timer->last_ts;
 
+			/* the GIL is held across every timer that's due
+			 * rather than being taken for each one */
 			if (elapsed >= timer->interval) {
-				lock_python();
-				timer_call(&cb->base);
-				unlock_python();
+				if (!python_locked) {
+					lock_python();
+					python_locked = true;
+				}
 
+				timer_call(&cb->base);
 				timer->last_ts += timer->interval;
 			}
 		}
 
 		timer = next;
 	}
+	if (python_locked)
+		unlock_python();
 	pthread_mutex_unlock(&timer_mutex);
 
 	UNUSED_PARAMETER(param);
@@ -78,6 +78,9 @@ struct obs_python_script {
 	struct script_callback *first_callback;
 
 	PyObject *tick;
+	float tick_interval;
+	float tick_elapsed;
+	bool tick_due;
 	struct obs_python_script *next_tick;
 	struct obs_python_script **p_prev_next_tick;
 };
@@ -44,6 +44,8 @@ void gs_duplicator::Start()
 	if (!get_monitor(device, idx, output.Assign()))
 		throw "Invalid monitor index";
 
+	full_copy = true;
+
 	hr = output->QueryInterface(IID_PPV_ARGS(output5.Assign()));
 	if (SUCCEEDED(hr)) {
 		constexpr DXGI_FORMAT supportedFormats[]{
@@ -73,7 +75,8 @@ gs_duplicator::gs_duplicator(gs_device_t *device_, int monitor_idx)
 	  texture(nullptr),
 	  idx(monitor_idx),
 	  refs(1),
-	  updated(false)
+	  updated(false),
+	  full_copy(true)
 {
 	Start();
 }
@@ -224,7 +227,65 @@ EXPORT void gs_duplicator_destroy(gs_duplicator_t *duplicator)
 	}
 }
 
-static inline void copy_texture(gs_duplicator_t *d, ID3D11Texture2D *tex)
+static inline void copy_rect(gs_duplicator_t *d, ID3D11Texture2D *tex,
+			     const RECT &rect)
+{
+	const D3D11_BOX box = {(UINT)rect.left,  (UINT)rect.top,    0,
+			       (UINT)rect.right, (UINT)rect.bottom, 1};
+	if (box.left >= box.right || box.top >= box.bottom ||
+	    box.right > d->texture->width || box.bottom > d->texture->height)
+		return;
+
+	d->device->context->CopySubresourceRegion(d->texture->texture, 0,
+						  box.left, box.top, 0, tex, 0,
+						  &box);
+}
+
+/* the acquired image already holds the final contents, so the destination
+ * of a move is copied from it like any dirty rect rather than moved within
+ * the texture */
+static bool copy_changed_rects(gs_duplicator_t *d, ID3D11Texture2D *tex,
+			       const DXGI_OUTDUPL_FRAME_INFO &info)
+{
+	if (!info.TotalMetadataBufferSize)
+		return false;
+
+	if (d->metadata.size() < info.TotalMetadataBufferSize)
+		d->metadata.resize(info.TotalMetadataBufferSize);
+
+	uint8_t *const buffer = d->metadata.data();
+	const UINT buffer_size = (UINT)d->metadata.size();
+	UINT move_size = 0;
+	UINT dirty_size = 0;
+	HRESULT hr;
+
+	hr = d->duplicator->GetFrameMoveRects(
+		buffer_size, (DXGI_OUTDUPL_MOVE_RECT *)buffer, &move_size);
+	if (FAILED(hr))
+		return false;
+
+	hr = d->duplicator->GetFrameDirtyRects(buffer_size - move_size,
+					       (RECT *)(buffer + move_size),
+					       &dirty_size);
+	if (FAILED(hr))
+		return false;
+
+	const DXGI_OUTDUPL_MOVE_RECT *moves =
+		(const DXGI_OUTDUPL_MOVE_RECT *)buffer;
+	const size_t move_count = move_size / sizeof(*moves);
+	for (size_t i = 0; i < move_count; i++)
+		copy_rect(d, tex, moves[i].DestinationRect);
+
+	const RECT *dirty = (const RECT *)(buffer + move_size);
+	const size_t dirty_count = dirty_size / sizeof(*dirty);
+	for (size_t i = 0; i < dirty_count; i++)
+		copy_rect(d, tex, dirty[i]);
+
+	return true;
+}
+
+static inline void copy_texture(gs_duplicator_t *d, ID3D11Texture2D *tex,
+				const DXGI_OUTDUPL_FRAME_INFO &info)
 {
 	D3D11_TEXTURE2D_DESC desc;
 	tex->GetDesc(&desc);
@@ -238,10 +299,16 @@ static inline void copy_texture(gs_duplicator_t *d, ID3D11Texture2D *tex)
 		delete d->texture;
 		d->texture = (gs_texture_2d *)gs_texture_create(
 			desc.Width, desc.Height, general_format, 1, nullptr, 0);
+		d->full_copy = true;
 	}
 
-	if (d->texture)
+	if (!d->texture)
+		return;
+
+	if (d->full_copy || !copy_changed_rects(d, tex, info)) {
 		d->device->context->CopyResource(d->texture->texture, tex);
+		d->full_copy = false;
+	}
 }
 
 EXPORT bool gs_duplicator_update_frame(gs_duplicator_t *d)
@@ -273,6 +340,15 @@ EXPORT bool gs_duplicator_update_frame(gs_duplicator_t *d)
 		return true;
 	}
 
+	/* only the mouse moved, the desktop image is unchanged */
+	const bool image_updated = info.AccumulatedFrames != 0 &&
+				   info.LastPresentTime.QuadPart != 0;
+	if (!image_updated && d->texture && !d->full_copy) {
+		d->duplicator->ReleaseFrame();
+		d->updated = true;
+		return true;
+	}
+
 	hr = res->QueryInterface(__uuidof(ID3D11Texture2D),
 				 (void **)tex.Assign());
 	if (FAILED(hr)) {
@@ -284,7 +360,7 @@ EXPORT bool gs_duplicator_update_frame(gs_duplicator_t *d)
 		return true;
 	}
 
-	copy_texture(d, tex);
+	copy_texture(d, tex, info);
 	d->duplicator->ReleaseFrame();
 	d->updated = true;
 	return true;
@@ -17,6 +17,7 @@
 
 #include "d3d11-subsystem.hpp"
 #include "d3d11-shaderprocessor.hpp"
+#include <util/platform.h>
 #include <graphics/vec2.h>
 #include <graphics/vec3.h>
 #include <graphics/matrix3.h>
@@ -47,7 +48,6 @@ gs_vertex_shader::gs_vertex_shader(gs_device_t *device, const char *file,
 	  nTexUnits(0)
 {
 	ShaderProcessor processor(device);
-	ComPtr<ID3D10Blob> shaderBlob;
 	string outputString;
 	HRESULT hr;
 
@@ -58,10 +58,7 @@ gs_vertex_shader::gs_vertex_shader(gs_device_t *device, const char *file,
 	GetBuffersExpected(layoutData);
 	BuildConstantBuffer();
 
-	Compile(outputString.c_str(), file, "vs_4_0", shaderBlob.Assign());
-
-	data.resize(shaderBlob->GetBufferSize());
-	memcpy(&data[0], shaderBlob->GetBufferPointer(), data.size());
+	Compile(outputString.c_str(), file, "vs_4_0");
 
 	hr = device->device->CreateVertexShader(data.data(), data.size(), NULL,
 						shader.Assign());
@@ -87,7 +84,6 @@ gs_pixel_shader::gs_pixel_shader(gs_device_t *device, const char *file,
 	: gs_shader(device, gs_type::gs_pixel_shader, GS_SHADER_PIXEL)
 {
 	ShaderProcessor processor(device);
-	ComPtr<ID3D10Blob> shaderBlob;
 	string outputString;
 	HRESULT hr;
 
@@ -97,10 +93,7 @@ gs_pixel_shader::gs_pixel_shader(gs_device_t *device, const char *file,
 	processor.BuildSamplers(samplers);
 	BuildConstantBuffer();
 
-	Compile(outputString.c_str(), file, "ps_4_0", shaderBlob.Assign());
-
-	data.resize(shaderBlob->GetBufferSize());
-	memcpy(&data[0], shaderBlob->GetBufferPointer(), data.size());
+	Compile(outputString.c_str(), file, "ps_4_0");
 
 	hr = device->device->CreatePixelShader(data.data(), data.size(), NULL,
 					       shader.Assign());
@@ -177,9 +170,11 @@ void gs_shader::BuildConstantBuffer()
 		}
 
 		param.pos = constantSize;
+		param.size = size;
 		constantSize += size;
 	}
 
+	constData.resize(constantSize);
 	memset(&bd, 0, sizeof(bd));
 
 	if (constantSize) {
@@ -200,19 +195,129 @@ void gs_shader::BuildConstantBuffer()
 		gs_shader_set_default(&params[i]);
 }
 
+/*
+ * Compiled shaders are cached in the program data directory, named after a
+ * hash of the generated HLSL, the target profile and the compiler flags, in a
+ * directory for each compiler version.  Each file starts with a hash of the
+ * bytecode so a truncated or corrupted file is just compiled again.
+ */
+
+#define SHADER_COMPILE_FLAGS D3D10_SHADER_OPTIMIZATION_LEVEL1
+#define MAX_CACHED_SHADER_SIZE (16 * 1024 * 1024)
+
+static inline uint64_t fnv1a_hash(const void *data, size_t size,
+				  uint64_t hash = 0xcbf29ce484222325ULL)
+{
+	const uint8_t *bytes = (const uint8_t *)data;
+
+	for (size_t i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ULL;
+	}
+
+	return hash;
+}
+
+static bool GetShaderCachePath(gs_device_t *device, const char *shaderString,
+			       size_t len, const char *target, string &path)
+{
+	uint32_t flags = SHADER_COMPILE_FLAGS;
+	char name[32];
+	uint64_t hash;
+	char *dir;
+
+	dir = os_get_program_data_path_ptr("obs-studio/shader-cache");
+	if (!dir)
+		return false;
+
+	hash = fnv1a_hash(target, strlen(target) + 1);
+	hash = fnv1a_hash(&flags, sizeof(flags), hash);
+	hash = fnv1a_hash(shaderString, len, hash);
+
+	snprintf(name, sizeof(name), "/%d/%016llx.bin",
+		 device->d3dCompilerVersion, (unsigned long long)hash);
+	path = dir;
+	path += name;
+	bfree(dir);
+	return true;
+}
+
+static bool LoadCachedShader(const char *path, vector<uint8_t> &data)
+{
+	uint64_t hash = 0;
+	int64_t size;
+	bool success;
+	FILE *f;
+
+	f = os_fopen(path, "rb");
+	if (!f)
+		return false;
+
+	size = os_fgetsize(f) - (int64_t)sizeof(hash);
+	success = size > 0 && size < MAX_CACHED_SHADER_SIZE &&
+		  fread(&hash, sizeof(hash), 1, f) == 1;
+	if (success) {
+		data.resize((size_t)size);
+		success = fread(data.data(), 1, data.size(), f) == data.size();
+	}
+
+	fclose(f);
+
+	if (success)
+		success = fnv1a_hash(data.data(), data.size()) == hash;
+	if (!success)
+		data.clear();
+
+	return success;
+}
+
+/* written to a temporary file first so another instance never reads a
+ * partially written shader */
+static void SaveCachedShader(const string &path, const vector<uint8_t> &data)
+{
+	uint64_t hash = fnv1a_hash(data.data(), data.size());
+	string dir = path.substr(0, path.rfind('/'));
+	string temp = path + "." + to_string(GetCurrentProcessId()) + ".tmp";
+	bool success;
+	FILE *f;
+
+	if (os_mkdirs(dir.c_str()) == MKDIR_ERROR)
+		return;
+
+	f = os_fopen(temp.c_str(), "wb");
+	if (!f)
+		return;
+
+	success = fwrite(&hash, sizeof(hash), 1, f) == 1 &&
+		  fwrite(data.data(), 1, data.size(), f) == data.size();
+	success = fclose(f) == 0 && success;
+
+	if (!success || os_rename(temp.c_str(), path.c_str()) != 0)
+		os_unlink(temp.c_str());
+}
+
 void gs_shader::Compile(const char *shaderString, const char *file,
-			const char *target, ID3D10Blob **shader)
+			const char *target)
 {
+	ComPtr<ID3D10Blob> shaderBlob;
 	ComPtr<ID3D10Blob> errorsBlob;
+	string cachePath;
+	bool cacheable;
+	size_t len;
 	HRESULT hr;
 
 	if (!shaderString)
 		throw "No shader string specified";
 
-	hr = device->d3dCompile(shaderString, strlen(shaderString), file, NULL,
-				NULL, "main", target,
-				D3D10_SHADER_OPTIMIZATION_LEVEL1, 0, shader,
-				errorsBlob.Assign());
+	len = strlen(shaderString);
+	cacheable = GetShaderCachePath(device, shaderString, len, target,
+				       cachePath);
+	if (cacheable && LoadCachedShader(cachePath.c_str(), data))
+		return;
+
+	hr = device->d3dCompile(shaderString, len, file, NULL, NULL, "main",
+				target, SHADER_COMPILE_FLAGS, 0,
+				shaderBlob.Assign(), errorsBlob.Assign());
 	if (FAILED(hr)) {
 		if (errorsBlob != NULL && errorsBlob->GetBufferSize())
 			throw ShaderError(errorsBlob, hr);
@@ -220,14 +325,19 @@ void gs_shader::Compile(const char *shaderString, const char *file,
 			throw HRError("Failed to compile shader", hr);
 	}
 
+	data.resize(shaderBlob->GetBufferSize());
+	memcpy(data.data(), shaderBlob->GetBufferPointer(), data.size());
+
+	if (cacheable)
+		SaveCachedShader(cachePath, data);
+
 #ifdef DISASSEMBLE_SHADERS
 	ComPtr<ID3D10Blob> asmBlob;
 
 	if (!device->d3dDisassemble)
 		return;
 
-	hr = device->d3dDisassemble((*shader)->GetBufferPointer(),
-				    (*shader)->GetBufferSize(), 0, nullptr,
+	hr = device->d3dDisassemble(data.data(), data.size(), 0, nullptr,
 				    &asmBlob);
 
 	if (SUCCEEDED(hr) && !!asmBlob && asmBlob->GetBufferSize()) {
@@ -238,26 +348,19 @@ void gs_shader::Compile(const char *shaderString, const char *file,
 #endif
 }
 
-inline void gs_shader::UpdateParam(vector<uint8_t> &constData,
-				   gs_shader_param &param, bool &upload)
+inline void gs_shader::UpdateParam(gs_shader_param &param, bool &upload)
 {
 	if (param.type != GS_SHADER_PARAM_TEXTURE) {
 		if (!param.curValue.size())
 			throw "Not all shader parameters were set";
 
-		/* padding in case the constant needs to start at a new
-		 * register */
-		if (param.pos > constData.size()) {
-			uint8_t zero = 0;
-
-			constData.insert(constData.end(),
-					 param.pos - constData.size(), zero);
-		}
-
-		constData.insert(constData.end(), param.curValue.begin(),
-				 param.curValue.end());
-
 		if (param.changed) {
+			if (param.curValue.size() != param.size)
+				throw "Invalid constant data size given "
+				      "to shader";
+
+			memcpy(constData.data() + param.pos,
+			       param.curValue.data(), param.size);
 			upload = true;
 			param.changed = false;
 		}
@@ -283,16 +386,10 @@ inline void gs_shader::UpdateParam(vector<uint8_t> &constData,
 
 void gs_shader::UploadParams()
 {
-	vector<uint8_t> constData;
 	bool upload = false;
 
-	constData.reserve(constantSize);
-
 	for (size_t i = 0; i < params.size(); i++)
-		UpdateParam(constData, params[i], upload);
-
-	if (constData.size() != constantSize)
-		throw "Invalid constant data size given to shader";
+		UpdateParam(params[i], upload);
 
 	if (upload) {
 		D3D11_MAPPED_SUBRESOURCE map;
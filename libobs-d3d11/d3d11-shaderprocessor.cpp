@@ -157,6 +157,8 @@ gs_shader_param::gs_shader_param(shader_var &var, uint32_t &texCounter)
 	  type(get_shader_param_type(var.type)),
 	  textureID(texCounter),
 	  arrayCount(var.array_count),
+	  pos(0),
+	  size(0),
 	  changed(false)
 {
 	defaultValue.resize(var.default_val.num);
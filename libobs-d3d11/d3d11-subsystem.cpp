@@ -334,6 +334,7 @@ void gs_device::InitCompiler()
 				module, "D3DDisassemble");
 #endif
 			if (d3dCompile) {
+				d3dCompilerVersion = ver;
 				CoTaskMemFree(path);
 				SetDllDirectory(nullptr);
 				return;
@@ -648,6 +649,15 @@ void gs_device::InitDevice(uint32_t adapterIdx)
 	blog(LOG_INFO, "D3D11 loaded successfully, feature level used: %x",
 	     (unsigned int)levelUsed);
 
+	/* whether the driver builds command lists from deferred contexts
+	 * natively rather than having the runtime emulate them */
+	D3D11_FEATURE_DATA_THREADING threading = {};
+	hr = device->CheckFeatureSupport(D3D11_FEATURE_THREADING, &threading,
+					 sizeof(threading));
+	driverCommandLists = SUCCEEDED(hr) && threading.DriverCommandLists;
+	blog(LOG_INFO, "D3D11 driver command lists: %s",
+	     driverCommandLists ? "supported" : "emulated");
+
 	/* prevent stalls sometimes seen in Present calls */
 	if (!increase_maximum_frame_latency(device)) {
 		blog(LOG_INFO, "DXGI increase maximum frame latency failed");
@@ -3021,6 +3031,13 @@ bool gs_timer_get_data(gs_timer_t *timer, uint64_t *ticks)
 	return succeeded;
 }
 
+bool gs_timer_ready(gs_timer_t *timer)
+{
+	HRESULT hr = timer->device->context->GetData(
+		timer->query_end, nullptr, 0, D3D11_ASYNC_GETDATA_DONOTFLUSH);
+	return hr == S_OK;
+}
+
 void gs_timer_range_destroy(gs_timer_range_t *range)
 {
 	delete range;
@@ -3057,6 +3074,14 @@ bool gs_timer_range_get_data(gs_timer_range_t *range, bool *disjoint,
 	return succeeded;
 }
 
+bool gs_timer_range_ready(gs_timer_range_t *range)
+{
+	HRESULT hr = range->device->context->GetData(
+		range->query_disjoint, nullptr, 0,
+		D3D11_ASYNC_GETDATA_DONOTFLUSH);
+	return hr == S_OK;
+}
+
 gs_timer::gs_timer(gs_device_t *device) : gs_obj(device, gs_type::gs_timer)
 {
 	Rebuild(device->device);
@@ -680,6 +680,7 @@ struct gs_shader_param {
 	int arrayCount;
 
 	size_t pos;
+	size_t size;
 
 	vector<uint8_t> curValue;
 	vector<uint8_t> defaultValue;
@@ -704,16 +705,19 @@ struct gs_shader : gs_obj {
 	ComPtr<ID3D11Buffer> constants;
 	size_t constantSize;
 
+	/* copy of the constant buffer, only changed parameters are written
+	 * to it before it's uploaded */
+	vector<uint8_t> constData;
+
 	D3D11_BUFFER_DESC bd = {};
 	vector<uint8_t> data;
 
-	inline void UpdateParam(vector<uint8_t> &constData,
-				gs_shader_param &param, bool &upload);
+	inline void UpdateParam(gs_shader_param &param, bool &upload);
 	void UploadParams();
 
 	void BuildConstantBuffer();
 	void Compile(const char *shaderStr, const char *file,
-		     const char *target, ID3D10Blob **shader);
+		     const char *target);
 
 	inline gs_shader(gs_device_t *device, gs_type obj_type,
 			 gs_shader_type type)
@@ -783,6 +787,11 @@ struct gs_duplicator : gs_obj {
 	long refs;
 	bool updated;
 
+	/* set whenever the texture contents can't be trusted, otherwise only
+	 * the moved and dirty rects of each frame are copied */
+	bool full_copy;
+	vector<uint8_t> metadata;
+
 	void Start();
 
 	inline void Release() { duplicator.Release(); }
@@ -987,6 +996,7 @@ struct gs_device {
 	uint32_t adpIdx = 0;
 	bool nv12Supported = false;
 	bool p010Supported = false;
+	bool driverCommandLists = false;
 
 	gs_texture_2d *curRenderTarget = nullptr;
 	gs_zstencil_buffer *curZStencilBuffer = nullptr;
@@ -1020,6 +1030,7 @@ struct gs_device {
 	D3D11_PRIMITIVE_TOPOLOGY curToplogy;
 
 	pD3DCompile d3dCompile = nullptr;
+	int d3dCompilerVersion = 0;
 #ifdef DISASSEMBLE_SHADERS
 	pD3DDisassemble d3dDisassemble = nullptr;
 #endif
@@ -16,12 +16,15 @@
 ******************************************************************************/
 
 #include <assert.h>
+#include <stdio.h>
 
 #include <graphics/vec2.h>
 #include <graphics/vec3.h>
 #include <graphics/vec4.h>
 #include <graphics/matrix3.h>
 #include <graphics/matrix4.h>
+#include <util/dstr.h>
+#include <util/platform.h>
 #include "gl-subsystem.h"
 #include "gl-shaderparser.h"
 
@@ -189,6 +192,21 @@ static inline bool gl_process_attribs(struct gs_shader *shader,
 	return true;
 }
 
+static inline uint64_t fnv1a_hash(const void *data, size_t size,
+				  uint64_t hash)
+{
+	const uint8_t *bytes = data;
+
+	for (size_t i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ULL;
+	}
+
+	return hash;
+}
+
+#define FNV1A_BASIS 0xcbf29ce484222325ULL
+
 static bool gl_shader_init(struct gs_shader *shader,
 			   struct gl_shader_parser *glsp, const char *file,
 			   char **error_string)
@@ -197,6 +215,9 @@ static bool gl_shader_init(struct gs_shader *shader,
 	int compiled = 0;
 	bool success = true;
 
+	shader->hash = fnv1a_hash(glsp->gl_string.array, glsp->gl_string.len,
+				  FNV1A_BASIS);
+
 	shader->obj = glCreateShader(type);
 	if (!gl_success("glCreateShader") || !shader->obj)
 		return false;
@@ -637,27 +658,157 @@ static inline bool assign_program_params(struct gs_program *program)
 	return true;
 }
 
-struct gs_program *gs_program_create(struct gs_device *device)
+/*
+ * Linked programs are cached with glGetProgramBinary in a directory named
+ * after a hash of the driver's vendor, renderer and version strings, so a
+ * driver update never sees binaries from an older driver.  Most drivers do
+ * their real compiling when linking, so that's the part being skipped.  Each
+ * file is [GLenum format][uint64_t hash of the binary][binary].
+ */
+
+#define MAX_PROGRAM_BINARY_SIZE (16 * 1024 * 1024)
+
+void gl_init_program_cache(struct gs_device *device)
 {
-	struct gs_program *program = bzalloc(sizeof(*program));
-	int linked = false;
+	const char *strings[] = {
+		(const char *)glGetString(GL_VENDOR),
+		(const char *)glGetString(GL_RENDERER),
+		(const char *)glGetString(GL_VERSION),
+	};
+	uint64_t hash = FNV1A_BASIS;
+	GLint formats = 0;
+	char name[64];
 
-	program->device = device;
-	program->vertex_shader = device->cur_vertex_shader;
-	program->pixel_shader = device->cur_pixel_shader;
+	if (!GLAD_GL_VERSION_4_1 && !GLAD_GL_ARB_get_program_binary)
+		return;
 
-	program->obj = glCreateProgram();
-	if (!gl_success("glCreateProgram"))
-		goto error_detach_neither;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+	if (!gl_success("glGetIntegerv") || formats <= 0)
+		return;
+
+	for (size_t i = 0; i < sizeof(strings) / sizeof(strings[0]); i++) {
+		if (strings[i])
+			hash = fnv1a_hash(strings[i], strlen(strings[i]) + 1,
+					  hash);
+	}
+
+	snprintf(name, sizeof(name), "obs-studio/shader-cache/gl/%016llx",
+		 (unsigned long long)hash);
+	device->program_cache_dir = os_get_config_path_ptr(name);
+}
+
+static inline void get_program_cache_path(struct gs_program *program,
+					  struct dstr *path)
+{
+	dstr_printf(path, "%s/%016llx-%016llx.bin",
+		    program->device->program_cache_dir,
+		    (unsigned long long)program->vertex_shader->hash,
+		    (unsigned long long)program->pixel_shader->hash);
+}
+
+static bool load_program_binary(struct gs_program *program, const char *path)
+{
+	GLenum format = 0;
+	uint64_t hash = 0;
+	void *binary = NULL;
+	int64_t size;
+	GLint linked = GL_FALSE;
+	bool success;
+	FILE *f;
+
+	f = os_fopen(path, "rb");
+	if (!f)
+		return false;
+
+	size = os_fgetsize(f) - (int64_t)(sizeof(format) + sizeof(hash));
+	success = size > 0 && size < MAX_PROGRAM_BINARY_SIZE &&
+		  fread(&format, sizeof(format), 1, f) == 1 &&
+		  fread(&hash, sizeof(hash), 1, f) == 1;
+	if (success) {
+		binary = bmalloc((size_t)size);
+		success = fread(binary, 1, (size_t)size, f) == (size_t)size &&
+			  fnv1a_hash(binary, (size_t)size, FNV1A_BASIS) == hash;
+	}
+
+	fclose(f);
+
+	if (success) {
+		glProgramBinary(program->obj, format, binary, (GLsizei)size);
+		success = gl_success("glProgramBinary");
+	}
+	if (success) {
+		glGetProgramiv(program->obj, GL_LINK_STATUS, &linked);
+		success = gl_success("glGetProgramiv") && linked == GL_TRUE;
+	}
+
+	bfree(binary);
+	return success;
+}
+
+static void save_program_binary(struct gs_program *program, const char *path)
+{
+	struct dstr temp = {0};
+	GLint size = 0;
+	GLsizei written = 0;
+	GLenum format = 0;
+	uint64_t hash;
+	void *binary;
+	bool success;
+	FILE *f;
+
+	glGetProgramiv(program->obj, GL_PROGRAM_BINARY_LENGTH, &size);
+	if (!gl_success("glGetProgramiv") || size <= 0)
+		return;
+
+	binary = bmalloc(size);
+	glGetProgramBinary(program->obj, size, &written, &format, binary);
+	if (!gl_success("glGetProgramBinary") || written <= 0)
+		goto exit;
+
+	if (os_mkdirs(program->device->program_cache_dir) == MKDIR_ERROR)
+		goto exit;
+
+	/* written to a temporary file first so another instance never reads
+	 * a partially written binary */
+	hash = fnv1a_hash(binary, written, FNV1A_BASIS);
+	dstr_printf(&temp, "%s.tmp", path);
+
+	f = os_fopen(temp.array, "wb");
+	if (!f)
+		goto exit;
+
+	success = fwrite(&format, sizeof(format), 1, f) == 1 &&
+		  fwrite(&hash, sizeof(hash), 1, f) == 1 &&
+		  fwrite(binary, 1, written, f) == (size_t)written;
+	success = fclose(f) == 0 && success;
+
+	if (!success || os_rename(temp.array, path) != 0)
+		os_unlink(temp.array);
+
+exit:
+	dstr_free(&temp);
+	bfree(binary);
+}
+
+static bool link_program(struct gs_program *program)
+{
+	int linked = false;
 
 	glAttachShader(program->obj, program->vertex_shader->obj);
 	if (!gl_success("glAttachShader (vertex)"))
-		goto error_detach_neither;
+		return false;
 
 	glAttachShader(program->obj, program->pixel_shader->obj);
 	if (!gl_success("glAttachShader (pixel)"))
 		goto error_detach_vertex;
 
+	if (program->device->program_cache_dir) {
+		glProgramParameteri(program->obj,
+				    GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+				    GL_TRUE);
+		gl_success("glProgramParameteri");
+	}
+
 	glLinkProgram(program->obj);
 	if (!gl_success("glLinkProgram"))
 		goto error;
@@ -671,16 +822,54 @@ struct gs_program *gs_program_create(struct gs_device *device)
 		goto error;
 	}
 
-	if (!assign_program_attribs(program))
-		goto error;
-	if (!assign_program_params(program))
-		goto error;
-
 	glDetachShader(program->obj, program->vertex_shader->obj);
 	gl_success("glDetachShader (vertex)");
 
 	glDetachShader(program->obj, program->pixel_shader->obj);
 	gl_success("glDetachShader (pixel)");
+	return true;
+
+error:
+	glDetachShader(program->obj, program->pixel_shader->obj);
+	gl_success("glDetachShader (pixel)");
+
+error_detach_vertex:
+	glDetachShader(program->obj, program->vertex_shader->obj);
+	gl_success("glDetachShader (vertex)");
+	return false;
+}
+
+struct gs_program *gs_program_create(struct gs_device *device)
+{
+	struct gs_program *program = bzalloc(sizeof(*program));
+	struct dstr cache_path = {0};
+
+	program->device = device;
+	program->vertex_shader = device->cur_vertex_shader;
+	program->pixel_shader = device->cur_pixel_shader;
+
+	program->obj = glCreateProgram();
+	if (!gl_success("glCreateProgram"))
+		goto error;
+
+	if (device->program_cache_dir) {
+		get_program_cache_path(program, &cache_path);
+
+		if (!load_program_binary(program, cache_path.array)) {
+			if (!link_program(program))
+				goto error;
+			save_program_binary(program, cache_path.array);
+		}
+	} else if (!link_program(program)) {
+		goto error;
+	}
+
+	if (!assign_program_attribs(program))
+		goto error;
+	if (!assign_program_params(program))
+		goto error;
+
+	dstr_free(&cache_path);
 
 	program->next = device->first_program;
 	program->prev_next = &device->first_program;
@@ -691,14 +880,7 @@ struct gs_program *gs_program_create(struct gs_device *device)
 	return program;
 
 error:
-	glDetachShader(program->obj, program->pixel_shader->obj);
-	gl_success("glDetachShader (pixel)");
-
-error_detach_vertex:
-	glDetachShader(program->obj, program->vertex_shader->obj);
-	gl_success("glDetachShader (vertex)");
-
-error_detach_neither:
+	dstr_free(&cache_path);
 	gs_program_destroy(program);
 	return NULL;
 }
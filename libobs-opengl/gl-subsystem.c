@@ -254,6 +254,8 @@ int device_create(gs_device_t **p_device, uint32_t adapter)
 	     "language %s",
 	     glVersion, glShadingLanguage);
 
+	gl_init_program_cache(device);
+
 	gl_enable(GL_CULL_FACE);
 	gl_gen_vertex_arrays(1, &device->empty_vao);
 
@@ -300,6 +302,7 @@ void device_destroy(gs_device_t *device)
 
 		da_free(device->proj_stack);
 		gl_platform_destroy(device->plat);
+		bfree(device->program_cache_dir);
 		bfree(device);
 	}
 }
@@ -1600,6 +1603,14 @@ bool gs_timer_get_data(gs_timer_t *timer, uint64_t *ticks)
 	return true;
 }
 
+bool gs_timer_ready(gs_timer_t *timer)
+{
+	GLint available = 0;
+	glGetQueryObjectiv(timer->queries[1], GL_QUERY_RESULT_AVAILABLE,
+			   &available);
+	return gl_success("glGetQueryObjectiv") && available;
+}
+
 void gs_timer_range_destroy(gs_timer_range_t *range)
 {
 	UNUSED_PARAMETER(range);
@@ -1625,6 +1636,13 @@ bool gs_timer_range_get_data(gs_timer_range_t *range, bool *disjoint,
 	return true;
 }
 
+bool gs_timer_range_ready(gs_timer_range_t *range)
+{
+	UNUSED_PARAMETER(range);
+
+	return true;
+}
+
 void device_rebuild(gs_device_t *device)
 {
 	/* Do nothing - GL */
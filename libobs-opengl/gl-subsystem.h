@@ -480,6 +480,7 @@ struct gs_shader {
 	gs_device_t *device;
 	enum gs_shader_type type;
 	GLuint obj;
+	uint64_t hash; /* of the GLSL, for the program binary cache */
 
 	struct gs_shader_param *viewproj;
 	struct gs_shader_param *world;
@@ -507,6 +508,7 @@ struct gs_program {
 	struct gs_program *next;
 };
 
+extern void gl_init_program_cache(struct gs_device *device);
 extern struct gs_program *gs_program_create(struct gs_device *device);
 extern void gs_program_destroy(struct gs_program *program);
 extern void program_update_params(struct gs_program *shader);
@@ -656,6 +658,7 @@ struct gs_device {
 	enum gs_color_space cur_color_space;
 
 	struct gs_program *first_program;
+	char *program_cache_dir; /* NULL if program binaries are unsupported */
 
 	enum gs_cull_mode cur_cull_mode;
 	struct gs_rect cur_viewport;
@@ -45,6 +45,22 @@ static bool upload_texture_2d(struct gs_texture_2d *tex, const uint8_t **data)
 	return success;
 }
 
+static GLsizeiptr get_unpack_buffer_size(const struct gs_texture_2d *tex)
+{
+	GLsizeiptr size = tex->width * gs_get_format_bpp(tex->base.format);
+
+	if (!gs_is_compressed_format(tex->base.format)) {
+		size /= 8;
+		size = (size + 3) & 0xFFFFFFFC;
+		size *= tex->height;
+	} else {
+		size *= tex->height;
+		size /= 8;
+	}
+
+	return size;
+}
+
 static bool create_pixel_unpack_buffer(struct gs_texture_2d *tex)
 {
 	GLsizeiptr size;
@@ -56,15 +72,7 @@ static bool create_pixel_unpack_buffer(struct gs_texture_2d *tex)
 	if (!gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, tex->unpack_buffer))
 		return false;
 
-	size = tex->width * gs_get_format_bpp(tex->base.format);
-	if (!gs_is_compressed_format(tex->base.format)) {
-		size /= 8;
-		size = (size + 3) & 0xFFFFFFFC;
-		size *= tex->height;
-	} else {
-		size *= tex->height;
-		size /= 8;
-	}
+	size = get_unpack_buffer_size(tex);
 
 	glBufferData(GL_PIXEL_UNPACK_BUFFER, size, 0, GL_DYNAMIC_DRAW);
 	if (!gl_success("glBufferData"))
@@ -212,8 +220,13 @@ bool gs_texture_map(gs_texture_t *tex, uint8_t **ptr, uint32_t *linesize)
 	if (!gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, tex2d->unpack_buffer))
 		goto fail;
 
-	*ptr = glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
-	if (!gl_success("glMapBuffer"))
+	/* invalidating lets the driver hand out fresh memory instead of
+	 * waiting for the previous upload from this buffer to finish, and
+	 * the mapping can stay open while other work is submitted */
+	*ptr = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0,
+				get_unpack_buffer_size(tex2d),
+				GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	if (!gl_success("glMapBufferRange") || !*ptr)
 		goto fail;
 
 	gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
@@ -243,9 +256,10 @@ void gs_texture_unmap(gs_texture_t *tex)
 	if (!gl_bind_texture(GL_TEXTURE_2D, tex2d->base.texture))
 		goto failed;
 
-	glTexImage2D(GL_TEXTURE_2D, 0, tex->gl_internal_format, tex2d->width,
-		     tex2d->height, 0, tex->gl_format, tex->gl_type, 0);
-	if (!gl_success("glTexImage2D"))
+	/* the storage already exists, so only copy into it */
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, tex2d->width, tex2d->height,
+			tex->gl_format, tex->gl_type, 0);
+	if (!gl_success("glTexSubImage2D"))
 		goto failed;
 
 	gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
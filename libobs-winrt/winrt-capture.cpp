@@ -46,6 +46,66 @@ try {
 	return false;
 }
 
+/* GraphicsCaptureSession::DirtyRegionMode was added in the 22621 SDK */
+#if defined(NTDDI_WIN10_NI)
+#define WINRT_CAPTURE_DIRTY_REGIONS 1
+#else
+#define WINRT_CAPTURE_DIRTY_REGIONS 0
+#endif
+
+#define DEFAULT_FRAME_POOL_SIZE 2
+#define MAX_FRAME_POOL_SIZE 8
+
+static bool winrt_capture_dirty_region_supported()
+try {
+#if WINRT_CAPTURE_DIRTY_REGIONS
+	return winrt::Windows::Foundation::Metadata::ApiInformation::
+		IsPropertyPresent(
+			L"Windows.Graphics.Capture.GraphicsCaptureSession",
+			L"DirtyRegionMode");
+#else
+	return false;
+#endif
+} catch (const winrt::hresult_error &err) {
+	blog(LOG_ERROR, "winrt_capture_dirty_region_supported (0x%08X): %ls",
+	     err.code().value, err.message().c_str());
+	return false;
+} catch (...) {
+	blog(LOG_ERROR, "winrt_capture_dirty_region_supported (0x%08X)",
+	     winrt::to_hresult().value);
+	return false;
+}
+
+/* frames only report what changed, which lets mostly static windows skip
+ * nearly all of the copy */
+static bool winrt_capture_enable_dirty_regions(
+	const winrt::Windows::Graphics::Capture::GraphicsCaptureSession
+		&session)
+{
+#if WINRT_CAPTURE_DIRTY_REGIONS
+	if (!winrt_capture_dirty_region_supported())
+		return false;
+
+	try {
+		session.DirtyRegionMode(winrt::Windows::Graphics::Capture::
+						GraphicsCaptureDirtyRegionMode::
+							ReportAndRender);
+		return true;
+	} catch (const winrt::hresult_error &err) {
+		blog(LOG_ERROR,
+		     "GraphicsCaptureSession::DirtyRegionMode (0x%08X): %ls",
+		     err.code().value, err.message().c_str());
+	} catch (...) {
+		blog(LOG_ERROR,
+		     "GraphicsCaptureSession::DirtyRegionMode (0x%08X)",
+		     winrt::to_hresult().value);
+	}
+#else
+	UNUSED_PARAMETER(session);
+#endif
+	return false;
+}
+
 template<typename T>
 static winrt::com_ptr<T> GetDXGIInterfaceFromObject(
 	winrt::Windows::Foundation::IInspectable const &object)
@@ -154,8 +214,14 @@ struct winrt_capture {
 	uint32_t texture_width;
 	uint32_t texture_height;
 	D3D11_BOX client_box;
+	D3D11_BOX last_client_box;
+
+	bool dirty_regions;
+	int32_t frame_pool_size;
+	volatile long requested_frame_pool_size;
 
 	BOOL active;
+	long refs;
 	struct winrt_capture *next;
 
 	void on_closed(
@@ -165,6 +231,50 @@ struct winrt_capture {
 		active = FALSE;
 	}
 
+	/* copies nothing at all when the frame reports no changes */
+	void copy_dirty_regions(
+		ID3D11Texture2D *dst, ID3D11Texture2D *src,
+		const winrt::Windows::Graphics::Capture::Direct3D11CaptureFrame
+			&frame,
+		const D3D11_BOX &src_box)
+	{
+#if WINRT_CAPTURE_DIRTY_REGIONS
+		const auto regions = frame.DirtyRegions();
+		const uint32_t count = regions.Size();
+
+		for (uint32_t i = 0; i < count; i++) {
+			const winrt::Windows::Graphics::RectInt32 rect =
+				regions.GetAt(i);
+			if (rect.Width <= 0 || rect.Height <= 0)
+				continue;
+
+			D3D11_BOX box;
+			box.left = max((uint32_t)max(rect.X, 0), src_box.left);
+			box.top = max((uint32_t)max(rect.Y, 0), src_box.top);
+			box.right = min((uint32_t)max(rect.X + rect.Width, 0),
+					src_box.right);
+			box.bottom =
+				min((uint32_t)max(rect.Y + rect.Height, 0),
+				    src_box.bottom);
+			box.front = 0;
+			box.back = 1;
+
+			if (box.left >= box.right || box.top >= box.bottom)
+				continue;
+
+			context->CopySubresourceRegion(
+				dst, 0, box.left - src_box.left,
+				box.top - src_box.top, 0, src, 0, &box);
+		}
+
+#else
+		UNUSED_PARAMETER(dst);
+		UNUSED_PARAMETER(src);
+		UNUSED_PARAMETER(frame);
+		UNUSED_PARAMETER(src_box);
+#endif
+	}
+
 	void on_frame_arrived(winrt::Windows::Graphics::Capture::
 				      Direct3D11CaptureFramePool const &sender,
 			      winrt::Windows::Foundation::IInspectable const &)
@@ -211,6 +321,17 @@ struct winrt_capture {
 					}
 				}
 
+				/* a new texture or a moved client area
+				 * invalidates what was already copied */
+				bool full_copy = !texture || !texture_written ||
+						 !dirty_regions;
+				if (client_area &&
+				    memcmp(&client_box, &last_client_box,
+					   sizeof(client_box)) != 0) {
+					last_client_box = client_box;
+					full_copy = true;
+				}
+
 				if (!texture) {
 					const gs_color_format color_format =
 						desc.Format == DXGI_FORMAT_R16G16B16A16_FLOAT
@@ -221,35 +342,49 @@ struct winrt_capture {
 						color_format, 1, NULL, 0);
 				}
 
-				if (client_area) {
+				ID3D11Texture2D *const dst =
+					(ID3D11Texture2D *)gs_texture_get_obj(
+						texture);
+
+				if (!full_copy) {
+					D3D11_BOX src_box = {0, 0, 0,
+							     desc.Width,
+							     desc.Height, 1};
+					if (client_area)
+						src_box = client_box;
+
+					copy_dirty_regions(dst,
+							   frame_surface.get(),
+							   frame, src_box);
+				} else if (client_area) {
 					context->CopySubresourceRegion(
-						(ID3D11Texture2D *)
-							gs_texture_get_obj(
-								texture),
-						0, 0, 0, 0, frame_surface.get(),
-						0, &client_box);
+						dst, 0, 0, 0, 0,
+						frame_surface.get(), 0,
+						&client_box);
 				} else {
 					/* if they gave an SRV, we could avoid this copy */
 					context->CopyResource(
-						(ID3D11Texture2D *)
-							gs_texture_get_obj(
-								texture),
-						frame_surface.get());
+						dst, frame_surface.get());
 				}
 
 				texture_written = true;
 			}
 
+			const int32_t pool_size =
+				(int32_t)requested_frame_pool_size;
+
 			if (frame_content_size.Width != last_size.Width ||
-			    frame_content_size.Height != last_size.Height) {
+			    frame_content_size.Height != last_size.Height ||
+			    pool_size != frame_pool_size) {
 				format = desc.Format;
+				frame_pool_size = pool_size;
 				frame_pool.Recreate(
 					device,
 					static_cast<
 						winrt::Windows::Graphics::DirectX::
 							DirectXPixelFormat>(
 						format),
-					2, frame_content_size);
+					frame_pool_size, frame_content_size);
 
 				last_size = frame_content_size;
 			}
@@ -395,10 +530,13 @@ static void winrt_capture_device_loss_rebuild(void *device_void, void *data)
 				static_cast<winrt::Windows::Graphics::DirectX::
 						    DirectXPixelFormat>(
 					capture->format),
-				2, capture->last_size);
+				capture->frame_pool_size, capture->last_size);
 	const winrt::Windows::Graphics::Capture::GraphicsCaptureSession session =
 		frame_pool.CreateCaptureSession(item);
 
+	capture->dirty_regions = winrt_capture_enable_dirty_regions(session);
+	capture->texture_written = false;
+
 	if (winrt_capture_border_toggle_supported()) {
 		winrt::Windows::Graphics::Capture::GraphicsCaptureAccess::
 			RequestAccessAsync(
@@ -475,10 +613,12 @@ try {
 				device,
 				static_cast<winrt::Windows::Graphics::DirectX::
 						    DirectXPixelFormat>(format),
-				2, size);
+				DEFAULT_FRAME_POOL_SIZE, size);
 	const winrt::Windows::Graphics::Capture::GraphicsCaptureSession session =
 		frame_pool.CreateCaptureSession(item);
 
+	const bool dirty_regions = winrt_capture_enable_dirty_regions(session);
+
 	if (winrt_capture_border_toggle_supported()) {
 		winrt::Windows::Graphics::Capture::GraphicsCaptureAccess::
 			RequestAccessAsync(
@@ -500,6 +640,9 @@ try {
 	capture->force_sdr = force_sdr;
 	capture->monitor = monitor;
 	capture->format = format;
+	capture->dirty_regions = dirty_regions;
+	capture->frame_pool_size = DEFAULT_FRAME_POOL_SIZE;
+	capture->requested_frame_pool_size = DEFAULT_FRAME_POOL_SIZE;
 	capture->capture_cursor = cursor && cursor_toggle_supported;
 	capture->cursor_visible = cursor;
 	capture->item = item;
@@ -513,6 +656,7 @@ try {
 	capture->frame_arrived = frame_pool.FrameArrived(
 		winrt::auto_revoke,
 		{capture, &winrt_capture::on_frame_arrived});
+	capture->refs = 1;
 	capture->next = capture_list;
 	capture_list = capture;
 
@@ -545,15 +689,36 @@ winrt_capture_init_window(BOOL cursor, HWND window, BOOL client_area,
 					   force_sdr, NULL);
 }
 
+/* monitor captures with the same settings share one session, so extra
+ * sources of the same monitor (crops, zooms) cost nothing to capture */
+static struct winrt_capture *find_monitor_capture(BOOL cursor,
+						  HMONITOR monitor)
+{
+	for (struct winrt_capture *capture = capture_list; capture;
+	     capture = capture->next) {
+		if (!capture->window && capture->monitor == monitor &&
+		    capture->cursor_visible == cursor && capture->active)
+			return capture;
+	}
+
+	return nullptr;
+}
+
 extern "C" EXPORT struct winrt_capture *
 winrt_capture_init_monitor(BOOL cursor, HMONITOR monitor)
 {
+	struct winrt_capture *capture = find_monitor_capture(cursor, monitor);
+	if (capture) {
+		capture->refs++;
+		return capture;
+	}
+
 	return winrt_capture_init_internal(cursor, NULL, false, false, monitor);
 }
 
 extern "C" EXPORT void winrt_capture_free(struct winrt_capture *capture)
 {
-	if (capture) {
+	if (capture && --capture->refs == 0) {
 		struct winrt_capture *current = capture_list;
 		if (current == capture) {
 			capture_list = capture->next;
@@ -610,6 +775,20 @@ extern "C" EXPORT BOOL winrt_capture_active(const struct winrt_capture *capture)
 	return capture->active;
 }
 
+extern "C" EXPORT void
+winrt_capture_set_frame_pool_size(struct winrt_capture *capture,
+				  uint32_t size)
+{
+	if (size < 1)
+		size = 1;
+	else if (size > MAX_FRAME_POOL_SIZE)
+		size = MAX_FRAME_POOL_SIZE;
+
+	/* applied with the next frame, where the pool is recreated anyway
+	 * when the size changes */
+	InterlockedExchange(&capture->requested_frame_pool_size, (long)size);
+}
+
 extern "C" EXPORT BOOL winrt_capture_show_cursor(struct winrt_capture *capture,
 						 BOOL visible)
 {
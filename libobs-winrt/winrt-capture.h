@@ -14,11 +14,18 @@ EXPORT BOOL winrt_capture_cursor_toggle_supported();
 EXPORT struct winrt_capture *winrt_capture_init_window(BOOL cursor, HWND window,
 						       BOOL client_area,
 						       BOOL force_sdr);
+/* captures of the same monitor with the same cursor setting are shared and
+ * reference counted, each one still has to be passed to winrt_capture_free */
 EXPORT struct winrt_capture *winrt_capture_init_monitor(BOOL cursor,
 							HMONITOR monitor);
 EXPORT void winrt_capture_free(struct winrt_capture *capture);
 
 EXPORT BOOL winrt_capture_active(const struct winrt_capture *capture);
+
+/* number of frames the capture frame pool can hold (1-8, default 2).  more
+ * frames smooth out uneven delivery at the cost of latency and memory */
+EXPORT void winrt_capture_set_frame_pool_size(struct winrt_capture *capture,
+					      uint32_t size);
 EXPORT BOOL winrt_capture_show_cursor(struct winrt_capture *capture,
 				      BOOL visible);
 EXPORT enum gs_color_space
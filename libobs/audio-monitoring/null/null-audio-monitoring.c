@@ -26,3 +26,9 @@ void audio_monitor_destroy(struct audio_monitor *monitor)
 {
 	UNUSED_PARAMETER(monitor);
 }
+
+uint64_t audio_monitor_get_latency_ns(struct audio_monitor *monitor)
+{
+	UNUSED_PARAMETER(monitor);
+	return 0;
+}
@@ -24,6 +24,10 @@ struct audio_monitor {
 	size_t buffer_size;
 	size_t wait_size;
 	uint32_t channels;
+	uint32_t sample_rate;
+
+	bool low_latency;
+	uint64_t latency_ns;
 
 	volatile bool active;
 	bool paused;
@@ -101,6 +105,26 @@ static void on_audio_playback(void *param, obs_source_t *source,
 	pthread_mutex_lock(&monitor->mutex);
 	circlebuf_push_back(&monitor->new_data, resample_data[0], bytes);
 
+	/* in low latency mode, drop audio that would wait behind more than
+	 * two queue buffers */
+	if (monitor->low_latency && !monitor->paused &&
+	    monitor->new_data.size > monitor->buffer_size * 2) {
+		size_t excess = monitor->new_data.size - monitor->buffer_size * 2;
+		excess -= excess % (sizeof(float) * monitor->channels);
+		circlebuf_pop_front(&monitor->new_data, NULL, excess);
+	}
+
+	size_t queued = monitor->new_data.size +
+			(3 - monitor->empty_buffers.size /
+				     sizeof(AudioQueueBufferRef)) *
+				monitor->buffer_size;
+	uint64_t latency =
+		audio_monitor_input_lag_ns(source, audio_data->timestamp) +
+		util_mul_div64(queued / (sizeof(float) * monitor->channels),
+			       1000000000ULL, monitor->sample_rate);
+	monitor->latency_ns =
+		audio_monitor_smooth_latency(monitor->latency_ns, latency);
+
 	if (monitor->new_data.size >= monitor->wait_size) {
 		monitor->wait_size = 0;
 
@@ -164,8 +188,13 @@ static bool audio_monitor_init(struct audio_monitor *monitor,
 	monitor->source = source;
 
 	monitor->channels = channels;
-	monitor->buffer_size =
-		channels * sizeof(float) * info->samples_per_sec / 100 * 3;
+	monitor->sample_rate = info->samples_per_sec;
+	monitor->low_latency = obs->audio.monitoring_low_latency;
+
+	/* 30ms queue buffers normally, 10ms in low latency mode */
+	monitor->buffer_size = channels * sizeof(float) *
+			       info->samples_per_sec / 100 *
+			       (monitor->low_latency ? 1 : 3);
 	monitor->wait_size = monitor->buffer_size * 3;
 
 	pthread_mutex_init_value(&monitor->mutex);
@@ -240,7 +269,8 @@ static bool audio_monitor_init(struct audio_monitor *monitor,
 				   .speakers = info->speakers,
 				   .format = AUDIO_FORMAT_FLOAT};
 
-	monitor->resampler = audio_resampler_create(&to, &from);
+	monitor->resampler = audio_resampler_create2(
+		&to, &from, AUDIO_RESAMPLER_QUALITY_LOW_LATENCY);
 	if (!monitor->resampler) {
 		blog(LOG_WARNING, "%s: %s", __FUNCTION__,
 		     "Failed to create resampler");
@@ -324,6 +354,11 @@ void audio_monitor_reset(struct audio_monitor *monitor)
 		audio_monitor_init_final(monitor);
 }
 
+uint64_t audio_monitor_get_latency_ns(struct audio_monitor *monitor)
+{
+	return monitor->ignore ? 0 : monitor->latency_ns;
+}
+
 void audio_monitor_destroy(struct audio_monitor *monitor)
 {
 	if (monitor) {
@@ -22,6 +22,10 @@ struct audio_monitor {
 	audio_resampler_t *resampler;
 	size_t bytesRemaining;
 
+	bool low_latency;
+	uint64_t input_lag;
+	uint64_t latency_ns;
+
 	bool ignore;
 	pthread_mutex_t playback_mutex;
 };
@@ -185,6 +189,32 @@ void process_volume(const struct audio_monitor *monitor, float vol,
 	}
 }
 
+static void update_latency(struct audio_monitor *data)
+{
+	pa_usec_t usec = 0;
+	int negative = 0;
+	int ret;
+
+	if (!data->stream)
+		return;
+
+	pulseaudio_lock();
+	ret = pa_stream_get_latency(data->stream, &usec, &negative);
+	pulseaudio_unlock();
+
+	if (ret < 0 || negative)
+		usec = 0;
+
+	pthread_mutex_lock(&data->playback_mutex);
+	uint64_t queued = data->new_data.size / data->bytes_per_frame;
+	uint64_t latency = data->input_lag + usec * 1000 +
+			   util_mul_div64(queued, 1000000000ULL,
+					  data->samples_per_sec);
+	data->latency_ns =
+		audio_monitor_smooth_latency(data->latency_ns, latency);
+	pthread_mutex_unlock(&data->playback_mutex);
+}
+
 static void do_stream_write(void *param)
 {
 	PULSE_DATA(param);
@@ -210,6 +240,8 @@ static void do_stream_write(void *param)
 
 		data->bytesRemaining -= bytesToFill;
 	}
+
+	update_latency(data);
 }
 
 static void on_audio_playback(void *param, obs_source_t *source,
@@ -253,6 +285,18 @@ static void on_audio_playback(void *param, obs_source_t *source,
 	monitor->packets++;
 	monitor->frames += resample_frames;
 
+	/* in low latency mode, never hold more than the target length on top
+	 * of what the server has already asked for */
+	if (monitor->low_latency &&
+	    monitor->new_data.size > monitor->attr.tlength) {
+		size_t excess = monitor->new_data.size - monitor->attr.tlength;
+		excess -= excess % monitor->bytes_per_frame;
+		circlebuf_pop_front(&monitor->new_data, NULL, excess);
+	}
+
+	monitor->input_lag =
+		audio_monitor_input_lag_ns(source, audio_data->timestamp);
+
 unlock:
 	pthread_mutex_unlock(&monitor->playback_mutex);
 	do_stream_write(param);
@@ -463,7 +507,8 @@ static bool audio_monitor_init(struct audio_monitor *monitor,
 			pulseaudio_channels_to_obs_speakers(monitor->channels),
 		.format = pulseaudio_to_obs_audio_format(monitor->format)};
 
-	monitor->resampler = audio_resampler_create(&to, &from);
+	monitor->resampler = audio_resampler_create2(
+		&to, &from, AUDIO_RESAMPLER_QUALITY_LOW_LATENCY);
 	if (!monitor->resampler) {
 		blog(LOG_WARNING, "%s: %s", __FUNCTION__,
 		     "Failed to create resampler");
@@ -486,11 +531,18 @@ static bool audio_monitor_init(struct audio_monitor *monitor,
 	monitor->attr.maxlength = (uint32_t)-1;
 	monitor->attr.minreq = (uint32_t)-1;
 	monitor->attr.prebuf = (uint32_t)-1;
-	monitor->attr.tlength = pa_usec_to_bytes(25000, &spec);
+	monitor->low_latency = obs->audio.monitoring_low_latency;
+	monitor->attr.tlength =
+		pa_usec_to_bytes(monitor->low_latency ? 10000 : 25000, &spec);
 
 	pa_stream_flags_t flags = PA_STREAM_INTERPOLATE_TIMING |
 				  PA_STREAM_AUTO_TIMING_UPDATE;
 
+	/* lets the server (and PipeWire's pulse layer) size its own
+	 * buffering, and with it the quantum, to our target length */
+	if (monitor->low_latency)
+		flags |= PA_STREAM_ADJUST_LATENCY;
+
 	if (pthread_mutex_init(&monitor->playback_mutex, NULL) != 0) {
 		blog(LOG_WARNING, "%s: %s", __FUNCTION__,
 		     "Failed to init mutex");
@@ -585,6 +637,11 @@ void audio_monitor_reset(struct audio_monitor *monitor)
 	}
 }
 
+uint64_t audio_monitor_get_latency_ns(struct audio_monitor *monitor)
+{
+	return monitor->ignore ? 0 : monitor->latency_ns;
+}
+
 void audio_monitor_destroy(struct audio_monitor *monitor)
 {
 	if (monitor) {
@@ -27,6 +27,8 @@ ACTUALLY_DEFINE_GUID(IID_IAudioClient, 0x1CB9AD4C, 0xDBFA, 0x4C32, 0xB1, 0x78,
 		     0xC2, 0xF5, 0x68, 0xA7, 0x03, 0xB2);
 ACTUALLY_DEFINE_GUID(IID_IAudioRenderClient, 0xF294ACFC, 0x3146, 0x4483, 0xA7,
 		     0xBF, 0xAD, 0xDC, 0xA7, 0xC2, 0x60, 0xE2);
+ACTUALLY_DEFINE_GUID(IID_IAudioClient3, 0x7ED4EE07, 0x8E67, 0x4CD4, 0x8C, 0x1A,
+		     0x2B, 0x7A, 0x59, 0x87, 0xAD, 0x42);
 
 struct audio_monitor {
 	obs_source_t *source;
@@ -46,6 +48,11 @@ struct audio_monitor {
 	struct circlebuf delay_buffer;
 	uint32_t delay_size;
 
+	bool low_latency;
+	uint32_t max_pad;
+	uint64_t stream_latency;
+	uint64_t latency_ns;
+
 	DARRAY(float) buf;
 	SRWLOCK playback_mutex;
 };
@@ -158,6 +165,56 @@ static enum speaker_layout convert_speaker_layout(DWORD layout, WORD channels)
 	return (enum speaker_layout)channels;
 }
 
+/* allow the device period twice over plus a typical capture packet before
+ * dropping queued audio */
+static void init_max_pad(struct audio_monitor *monitor,
+			 const WAVEFORMATEX *wfex, uint32_t period)
+{
+	if (!period) {
+		REFERENCE_TIME def = 0;
+		REFERENCE_TIME min = 0;
+
+		monitor->client->lpVtbl->GetDevicePeriod(monitor->client, &def,
+							 &min);
+		period = (uint32_t)util_mul_div64(def, wfex->nSamplesPerSec,
+						  10000000);
+	}
+
+	monitor->max_pad = period * 2 + wfex->nSamplesPerSec / 50;
+}
+
+/* IAudioClient3 lets shared mode streams run at the engine's minimum
+ * period (often ~2.5ms instead of 10ms) */
+static bool init_low_latency(struct audio_monitor *monitor, WAVEFORMATEX *wfex)
+{
+	IAudioClient3 *client3 = NULL;
+	UINT32 def, fundamental, min, max;
+	HRESULT hr;
+
+	hr = monitor->client->lpVtbl->QueryInterface(
+		monitor->client, &IID_IAudioClient3, (void **)&client3);
+	if (FAILED(hr))
+		return false;
+
+	hr = client3->lpVtbl->GetSharedModeEnginePeriod(
+		client3, wfex, &def, &fundamental, &min, &max);
+	if (SUCCEEDED(hr))
+		hr = client3->lpVtbl->InitializeSharedAudioStream(client3, 0,
+								  min, wfex,
+								  NULL);
+	safe_release(client3);
+
+	if (FAILED(hr)) {
+		debug("%s: IAudioClient3 unavailable: %08lX", __FUNCTION__,
+		      hr);
+		return false;
+	}
+
+	info("monitoring with a %u frame device period", min);
+	init_max_pad(monitor, wfex, min);
+	return true;
+}
+
 static bool audio_monitor_init_wasapi(struct audio_monitor *monitor)
 {
 	bool success = false;
@@ -211,14 +268,26 @@ static bool audio_monitor_init_wasapi(struct audio_monitor *monitor)
 		goto fail;
 	}
 
-	hr = monitor->client->lpVtbl->Initialize(monitor->client,
-						 AUDCLNT_SHAREMODE_SHARED, 0,
-						 10000000, 0, wfex, NULL);
-	if (FAILED(hr)) {
-		warn("%s: Failed to initialize: %08lX", __FUNCTION__, hr);
-		goto fail;
+	monitor->low_latency = obs->audio.monitoring_low_latency;
+	if (!monitor->low_latency || !init_low_latency(monitor, wfex)) {
+		hr = monitor->client->lpVtbl->Initialize(
+			monitor->client, AUDCLNT_SHAREMODE_SHARED, 0, 10000000,
+			0, wfex, NULL);
+		if (FAILED(hr)) {
+			warn("%s: Failed to initialize: %08lX", __FUNCTION__,
+			     hr);
+			goto fail;
+		}
+
+		if (monitor->low_latency)
+			init_max_pad(monitor, wfex, 0);
 	}
 
+	REFERENCE_TIME stream_latency = 0;
+	monitor->client->lpVtbl->GetStreamLatency(monitor->client,
+						  &stream_latency);
+	monitor->stream_latency = (uint64_t)stream_latency * 100;
+
 	/* ------------------------------------------ *
 	 * Init resampler                             */
 
@@ -239,7 +308,8 @@ static bool audio_monitor_init_wasapi(struct audio_monitor *monitor)
 
 	monitor->sample_rate = (uint32_t)wfex->nSamplesPerSec;
 	monitor->channels = wfex->nChannels;
-	monitor->resampler = audio_resampler_create(&to, &from);
+	monitor->resampler = audio_resampler_create2(
+		&to, &from, AUDIO_RESAMPLER_QUALITY_LOW_LATENCY);
 	if (!monitor->resampler) {
 		goto fail;
 	}
@@ -337,6 +407,24 @@ static void on_audio_playback(void *param, obs_source_t *source,
 		goto free_for_reconnect;
 	}
 
+	/* in low latency mode, drop whatever would queue up past the device
+	 * period instead of letting it add delay */
+	if (monitor->low_latency && pad + resample_frames > monitor->max_pad) {
+		uint32_t excess = pad + resample_frames - monitor->max_pad;
+		if (excess >= resample_frames)
+			goto unlock;
+
+		resample_data[0] += excess * monitor->channels * sizeof(float);
+		resample_frames -= excess;
+	}
+
+	uint64_t latency =
+		audio_monitor_input_lag_ns(source, audio_data->timestamp) +
+		util_mul_div64(pad, 1000000000ULL, monitor->sample_rate) +
+		monitor->stream_latency;
+	monitor->latency_ns =
+		audio_monitor_smooth_latency(monitor->latency_ns, latency);
+
 	bool decouple_audio = source->async_unbuffered &&
 			      source->async_decoupled;
 
@@ -487,6 +575,11 @@ void audio_monitor_reset(struct audio_monitor *monitor)
 	}
 }
 
+uint64_t audio_monitor_get_latency_ns(struct audio_monitor *monitor)
+{
+	return monitor->ignore ? 0 : monitor->latency_ns;
+}
+
 void audio_monitor_destroy(struct audio_monitor *monitor)
 {
 	if (monitor) {
@@ -65,7 +65,10 @@ static inline const char *cd_serialize_string(uint8_t **pos)
 	return (size != 0) ? str : NULL;
 }
 
-static bool cd_getparam(const calldata_t *data, const char *name, uint8_t **pos)
+/* name_len includes the null terminator, the same as the stored name sizes,
+ * so most parameters are rejected without looking at their names at all */
+static bool cd_getparam(const calldata_t *data, const char *name,
+			size_t name_len, uint8_t **pos)
 {
 	size_t name_size;
 
@@ -80,7 +83,8 @@ static bool cd_getparam(const calldata_t *data, const char *name, uint8_t **pos)
 		size_t param_size;
 
 		*pos += name_size;
-		if (strcmp(param_name, name) == 0)
+		if (name_size == name_len &&
+		    memcmp(param_name, name, name_len) == 0)
 			return true;
 
 		param_size = cd_serialize_size(pos);
@@ -95,9 +99,6 @@ static bool cd_getparam(const calldata_t *data, const char *name, uint8_t **pos)
 
 static inline void cd_copy_string(uint8_t **pos, const char *str, size_t len)
 {
-	if (!len)
-		len = strlen(str) + 1;
-
 	memcpy(*pos, &len, sizeof(size_t));
 	*pos += sizeof(size_t);
 	memcpy(*pos, str, len);
@@ -116,11 +117,11 @@ static inline void cd_copy_data(uint8_t **pos, const void *in, size_t size)
 }
 
 static inline void cd_set_first_param(calldata_t *data, const char *name,
-				      const void *in, size_t size)
+				      size_t name_len, const void *in,
+				      size_t size)
 {
 	uint8_t *pos;
 	size_t capacity;
-	size_t name_len = strlen(name) + 1;
 
 	capacity = sizeof(size_t) * 3 + name_len + size;
 	data->size = capacity;
@@ -174,7 +175,7 @@ bool calldata_get_data(const calldata_t *data, const char *name, void *out,
 	if (!data || !name || !*name)
 		return false;
 
-	if (!cd_getparam(data, name, &pos))
+	if (!cd_getparam(data, name, strlen(name) + 1, &pos))
 		return false;
 
 	data_size = cd_serialize_size(&pos);
@@ -189,16 +190,19 @@ void calldata_set_data(calldata_t *data, const char *name, const void *in,
 		       size_t size)
 {
 	uint8_t *pos = NULL;
+	size_t name_len;
 
 	if (!data || !name || !*name)
 		return;
 
+	name_len = strlen(name) + 1;
+
 	if (!data->fixed && !data->stack) {
-		cd_set_first_param(data, name, in, size);
+		cd_set_first_param(data, name, name_len, in, size);
 		return;
 	}
 
-	if (cd_getparam(data, name, &pos)) {
+	if (cd_getparam(data, name, name_len, &pos)) {
 		size_t cur_size;
 		memcpy(&cur_size, pos, sizeof(size_t));
 
@@ -222,13 +226,12 @@ void calldata_set_data(calldata_t *data, const char *name, const void *in,
 		cd_copy_data(&pos, in, size);
 
 	} else {
-		size_t name_len = strlen(name) + 1;
 		size_t offset = name_len + size + sizeof(size_t) * 2;
 		if (!cd_ensure_capacity(data, &pos, data->size + offset))
 			return;
 		data->size += offset;
 
-		cd_copy_string(&pos, name, 0);
+		cd_copy_string(&pos, name, name_len);
 		cd_copy_data(&pos, in, size);
 		memset(pos, 0, sizeof(size_t));
 	}
@@ -241,7 +244,7 @@ bool calldata_get_string(const calldata_t *data, const char *name,
 	if (!data || !name || !*name)
 		return false;
 
-	if (!cd_getparam(data, name, &pos))
+	if (!cd_getparam(data, name, strlen(name) + 1, &pos))
 		return false;
 
 	*str = cd_serialize_string(&pos);
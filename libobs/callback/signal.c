@@ -29,19 +29,38 @@ struct signal_callback {
 
 struct signal_info {
 	struct decl_info func;
+	uint32_t hash;
 	DARRAY(struct signal_callback) callbacks;
 	pthread_mutex_t mutex;
 	bool signalling;
 
+	/* copy of callbacks.num that can be read without the mutex, so
+	 * signals no one is connected to don't have to lock anything */
+	volatile long num_callbacks;
+
 	struct signal_info *next;
 };
 
+static inline uint32_t signal_hash(const char *name)
+{
+	uint32_t hash = 2166136261u;
+
+	while (*name) {
+		hash ^= (uint8_t)*(name++);
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
 static inline struct signal_info *signal_info_create(struct decl_info *info)
 {
 	struct signal_info *si = bmalloc(sizeof(struct signal_info));
 	si->func = *info;
+	si->hash = signal_hash(info->name);
 	si->next = NULL;
 	si->signalling = false;
+	si->num_callbacks = 0;
 	da_init(si->callbacks);
 
 	if (pthread_mutex_init_recursive(&si->mutex) != 0) {
@@ -79,6 +98,11 @@ static inline size_t signal_get_callback_idx(struct signal_info *si,
 	return DARRAY_INVALID;
 }
 
+static inline void signal_update_num_callbacks(struct signal_info *si)
+{
+	os_atomic_set_long(&si->num_callbacks, (long)si->callbacks.num);
+}
+
 struct global_callback_info {
 	global_signal_callback_t callback;
 	void *data;
@@ -86,13 +110,18 @@ struct global_callback_info {
 	bool remove;
 };
 
+/* signals are only ever appended to the list, and num_signals is only
+ * incremented once a new signal is fully linked in, so the list can be
+ * searched without the mutex up to num_signals entries */
 struct signal_handler {
 	struct signal_info *first;
 	pthread_mutex_t mutex;
+	volatile long num_signals;
 	volatile long refs;
 
 	DARRAY(struct global_callback_info) global_callbacks;
 	pthread_mutex_t global_callbacks_mutex;
+	volatile long num_global_callbacks;
 };
 
 static struct signal_info *getsignal(signal_handler_t *handler,
@@ -100,10 +129,11 @@ static struct signal_info *getsignal(signal_handler_t *handler,
 				     struct signal_info **p_last)
 {
 	struct signal_info *signal, *last = NULL;
+	uint32_t hash = signal_hash(name);
 
 	signal = handler->first;
 	while (signal != NULL) {
-		if (strcmp(signal->func.name, name) == 0)
+		if (signal->hash == hash && strcmp(signal->func.name, name) == 0)
 			break;
 
 		last = signal;
@@ -115,6 +145,28 @@ static struct signal_info *getsignal(signal_handler_t *handler,
 	return signal;
 }
 
+static struct signal_info *getsignal_unlocked(signal_handler_t *handler,
+					      const char *name)
+{
+	struct signal_info *sig;
+	uint32_t hash;
+	long count;
+
+	if (!handler)
+		return NULL;
+
+	hash = signal_hash(name);
+	count = os_atomic_load_long(&handler->num_signals);
+	sig = handler->first;
+
+	for (long i = 0; i < count && sig; i++, sig = sig->next) {
+		if (sig->hash == hash && strcmp(sig->func.name, name) == 0)
+			return sig;
+	}
+
+	return NULL;
+}
+
 /* ------------------------------------------------------------------------- */
 
 signal_handler_t *signal_handler_create(void)
@@ -182,10 +234,16 @@ bool signal_handler_add(signal_handler_t *handler, const char *signal_decl)
 		success = false;
 	} else {
 		sig = signal_info_create(&func);
-		if (!last)
-			handler->first = sig;
-		else
-			last->next = sig;
+		if (!sig) {
+			success = false;
+		} else {
+			if (!last)
+				handler->first = sig;
+			else
+				last->next = sig;
+
+			os_atomic_inc_long(&handler->num_signals);
+		}
 	}
 
 	pthread_mutex_unlock(&handler->mutex);
@@ -198,17 +256,13 @@ static void signal_handler_connect_internal(signal_handler_t *handler,
 					    signal_callback_t callback,
 					    void *data, bool keep_ref)
 {
-	struct signal_info *sig, *last;
+	struct signal_info *sig = getsignal_unlocked(handler, signal);
 	struct signal_callback cb_data = {callback, data, false, keep_ref};
 	size_t idx;
 
 	if (!handler)
 		return;
 
-	pthread_mutex_lock(&handler->mutex);
-	sig = getsignal(handler, signal, &last);
-	pthread_mutex_unlock(&handler->mutex);
-
 	if (!sig) {
 		blog(LOG_WARNING,
 		     "signal_handler_connect: "
@@ -228,6 +282,7 @@ static void signal_handler_connect_internal(signal_handler_t *handler,
 	if (keep_ref || idx == DARRAY_INVALID)
 		da_push_back(sig->callbacks, &cb_data);
 
+	signal_update_num_callbacks(sig);
 	pthread_mutex_unlock(&sig->mutex);
 }
 
@@ -243,25 +298,10 @@ void signal_handler_connect_ref(signal_handler_t *handler, const char *signal,
 	signal_handler_connect_internal(handler, signal, callback, data, true);
 }
 
-static inline struct signal_info *getsignal_locked(signal_handler_t *handler,
-						   const char *name)
-{
-	struct signal_info *sig;
-
-	if (!handler)
-		return NULL;
-
-	pthread_mutex_lock(&handler->mutex);
-	sig = getsignal(handler, name, NULL);
-	pthread_mutex_unlock(&handler->mutex);
-
-	return sig;
-}
-
 void signal_handler_disconnect(signal_handler_t *handler, const char *signal,
 			       signal_callback_t callback, void *data)
 {
-	struct signal_info *sig = getsignal_locked(handler, signal);
+	struct signal_info *sig = getsignal_unlocked(handler, signal);
 	bool keep_ref = false;
 	size_t idx;
 
@@ -280,6 +320,7 @@ void signal_handler_disconnect(signal_handler_t *handler, const char *signal,
 		}
 	}
 
+	signal_update_num_callbacks(sig);
 	pthread_mutex_unlock(&sig->mutex);
 
 	if (keep_ref && os_atomic_dec_long(&handler->refs) == 0) {
@@ -301,12 +342,15 @@ void signal_handler_remove_current(void)
 void signal_handler_signal(signal_handler_t *handler, const char *signal,
 			   calldata_t *params)
 {
-	struct signal_info *sig = getsignal_locked(handler, signal);
+	struct signal_info *sig = getsignal_unlocked(handler, signal);
 	long remove_refs = 0;
 
 	if (!sig)
 		return;
 
+	if (!os_atomic_load_long(&sig->num_callbacks))
+		goto global_callbacks;
+
 	pthread_mutex_lock(&sig->mutex);
 	sig->signalling = true;
 
@@ -329,9 +373,14 @@ void signal_handler_signal(signal_handler_t *handler, const char *signal,
 		}
 	}
 
+	signal_update_num_callbacks(sig);
 	sig->signalling = false;
 	pthread_mutex_unlock(&sig->mutex);
 
+global_callbacks:
+	if (!os_atomic_load_long(&handler->num_global_callbacks))
+		goto finish;
+
 	pthread_mutex_lock(&handler->global_callbacks_mutex);
 
 	if (handler->global_callbacks.num) {
@@ -357,8 +406,11 @@ void signal_handler_signal(signal_handler_t *handler, const char *signal,
 		}
 	}
 
+	os_atomic_set_long(&handler->num_global_callbacks,
+			   (long)handler->global_callbacks.num);
 	pthread_mutex_unlock(&handler->global_callbacks_mutex);
 
+finish:
 	if (remove_refs) {
 		os_atomic_set_long(&handler->refs,
 				   os_atomic_load_long(&handler->refs) -
@@ -382,6 +434,8 @@ void signal_handler_connect_global(signal_handler_t *handler,
 	if (idx == DARRAY_INVALID)
 		da_push_back(handler->global_callbacks, &cb_data);
 
+	os_atomic_set_long(&handler->num_global_callbacks,
+			   (long)handler->global_callbacks.num);
 	pthread_mutex_unlock(&handler->global_callbacks_mutex);
 }
 
@@ -408,5 +462,7 @@ void signal_handler_disconnect_global(signal_handler_t *handler,
 			da_erase(handler->global_callbacks, idx);
 	}
 
+	os_atomic_set_long(&handler->num_global_callbacks,
+			   (long)handler->global_callbacks.num);
 	pthread_mutex_unlock(&handler->global_callbacks_mutex);
 }
@@ -151,6 +151,7 @@ struct gs_effect {
 	bool processing;
 	bool cached;
 	char *effect_path, *effect_dir;
+	uint64_t path_hash, content_hash;
 
 	DARRAY(struct gs_effect_param) params;
 	DARRAY(struct gs_effect_technique) techniques;
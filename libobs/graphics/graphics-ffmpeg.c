@@ -1,4 +1,5 @@
 #include "graphics.h"
+#include "graphics-internal.h"
 
 #include "half.h"
 #include "srgb.h"
@@ -918,3 +919,166 @@ uint8_t *gs_create_texture_file_data3(const char *file,
 
 	return data;
 }
+
+/* ------------------------------------------------------------------------- */
+/* animated images (APNG, animated WebP), decoded one frame at a time */
+
+struct gs_image_anim {
+	struct ffmpeg_image info;
+	enum gs_image_alpha_mode alpha_mode;
+	struct SwsContext *sws_ctx;
+	AVFrame *frame;
+	AVRational time_base;
+	bool draining;
+};
+
+static bool gs_image_anim_receive(struct gs_image_anim *anim)
+{
+	AVPacket packet = {0};
+	int ret;
+
+	for (;;) {
+		ret = avcodec_receive_frame(anim->info.decoder_ctx,
+					    anim->frame);
+		if (ret == 0)
+			return true;
+		if (ret != AVERROR(EAGAIN) || anim->draining)
+			return false;
+
+		ret = av_read_frame(anim->info.fmt_ctx, &packet);
+		if (ret < 0) {
+			anim->draining = true;
+			avcodec_send_packet(anim->info.decoder_ctx, NULL);
+			continue;
+		}
+
+		ret = avcodec_send_packet(anim->info.decoder_ctx, &packet);
+		av_packet_unref(&packet);
+
+		if (ret < 0 && ret != AVERROR(EAGAIN)) {
+			blog(LOG_WARNING, "Failed to decode frame for '%s': %s",
+			     anim->info.file, av_err2str(ret));
+			return false;
+		}
+	}
+}
+
+void gs_image_anim_destroy(struct gs_image_anim *anim)
+{
+	if (!anim)
+		return;
+
+	sws_freeContext(anim->sws_ctx);
+	av_frame_free(&anim->frame);
+	ffmpeg_image_free(&anim->info);
+	bfree((char *)anim->info.file);
+	bfree(anim);
+}
+
+struct gs_image_anim *gs_image_anim_create(const char *file,
+					   enum gs_image_alpha_mode alpha_mode,
+					   uint32_t *cx, uint32_t *cy)
+{
+	struct gs_image_anim *anim = bzalloc(sizeof(*anim));
+	char *path = bstrdup(file);
+	int idx;
+
+	if (!ffmpeg_image_init(&anim->info, path)) {
+		bfree(path);
+		bfree(anim);
+		return NULL;
+	}
+
+	anim->alpha_mode = alpha_mode;
+	anim->frame = av_frame_alloc();
+
+	idx = av_find_best_stream(anim->info.fmt_ctx, AVMEDIA_TYPE_VIDEO, -1,
+				  -1, NULL, 0);
+	if (idx < 0 || !anim->frame)
+		goto not_animated;
+
+	anim->time_base = anim->info.fmt_ctx->streams[idx]->time_base;
+
+	/* static PNGs go through the regular PNG decoder, only APNG files
+	 * get the APNG one */
+	if (anim->info.decoder_ctx->codec_id == AV_CODEC_ID_PNG)
+		goto not_animated;
+
+	if (anim->info.cx <= 0 || anim->info.cy <= 0 ||
+	    anim->info.cx > 4096 || anim->info.cy > 4096)
+		goto not_animated;
+
+	/* anything with a single frame is loaded as a still image */
+	if (!gs_image_anim_receive(anim) || !gs_image_anim_receive(anim))
+		goto not_animated;
+	if (!gs_image_anim_rewind(anim))
+		goto not_animated;
+
+	*cx = (uint32_t)anim->info.cx;
+	*cy = (uint32_t)anim->info.cy;
+	return anim;
+
+not_animated:
+	gs_image_anim_destroy(anim);
+	return NULL;
+}
+
+bool gs_image_anim_rewind(struct gs_image_anim *anim)
+{
+	int ret = av_seek_frame(anim->info.fmt_ctx, -1, 0,
+				AVSEEK_FLAG_BACKWARD);
+	if (ret < 0) {
+		blog(LOG_WARNING, "Failed to rewind '%s': %s", anim->info.file,
+		     av_err2str(ret));
+		return false;
+	}
+
+	avcodec_flush_buffers(anim->info.decoder_ctx);
+	anim->draining = false;
+	return true;
+}
+
+bool gs_image_anim_decode(struct gs_image_anim *anim, uint8_t *data,
+			  uint64_t *duration_ns)
+{
+	AVFrame *frame = anim->frame;
+	const size_t texels = (size_t)anim->info.cx * anim->info.cy;
+	uint8_t *pointers[4] = {data};
+	int linesizes[4] = {anim->info.cx * 4};
+	int64_t duration;
+
+	if (!gs_image_anim_receive(anim))
+		return false;
+
+	anim->sws_ctx = sws_getCachedContext(
+		anim->sws_ctx, frame->width, frame->height, frame->format,
+		anim->info.cx, anim->info.cy, AV_PIX_FMT_RGBA, SWS_POINT, NULL,
+		NULL, NULL);
+	if (!anim->sws_ctx) {
+		blog(LOG_WARNING, "Failed to create scale context for '%s'",
+		     anim->info.file);
+		av_frame_unref(frame);
+		return false;
+	}
+
+	sws_scale(anim->sws_ctx, (const uint8_t *const *)frame->data,
+		  frame->linesize, 0, frame->height, pointers, linesizes);
+
+	if (anim->alpha_mode == GS_IMAGE_ALPHA_PREMULTIPLY_SRGB)
+		gs_premultiply_xyza_srgb_loop(data, texels);
+	else if (anim->alpha_mode == GS_IMAGE_ALPHA_PREMULTIPLY)
+		gs_premultiply_xyza_loop(data, texels);
+
+#if LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(57, 30, 100)
+	duration = frame->duration;
+#else
+	duration = frame->pkt_duration;
+#endif
+	*duration_ns = duration > 0 ? (uint64_t)av_rescale_q(
+					      duration, anim->time_base,
+					      (AVRational){1, 1000000000})
+				    : 0;
+
+	av_frame_unref(frame);
+	return true;
+}
@@ -23,6 +23,35 @@
 #include "matrix3.h"
 #include "matrix4.h"
 
+/* animated images other than gifs, implemented by the image loader.
+ * frames come out as RGBA in playback order, create returns NULL for files
+ * with only one frame */
+struct gs_image_anim;
+
+struct gs_image_anim *gs_image_anim_create(const char *file,
+					   enum gs_image_alpha_mode alpha_mode,
+					   uint32_t *cx, uint32_t *cy);
+void gs_image_anim_destroy(struct gs_image_anim *anim);
+bool gs_image_anim_rewind(struct gs_image_anim *anim);
+bool gs_image_anim_decode(struct gs_image_anim *anim, uint8_t *data,
+			  uint64_t *duration_ns);
+
+/* render targets given back by texrenders, reused by the next texrender
+ * that needs the same size and format.  entries that go unused for
+ * TEXRENDER_POOL_MAX_IDLE_FRAMES frames are destroyed */
+#define TEXRENDER_POOL_MAX_IDLE_FRAMES 120
+
+struct texrender_buffers {
+	gs_texture_t *target;
+	gs_zstencil_t *zs;
+	uint32_t cx, cy;
+	enum gs_color_format format;
+	enum gs_zstencil_format zsformat;
+	uint64_t released_frame;
+};
+
+void gs_texrender_pool_trim(graphics_t *graphics, bool all);
+
 struct gs_exports {
 	const char *(*device_get_name)(void);
 	int (*device_get_type)(void);
@@ -243,6 +272,8 @@ struct gs_exports {
 	bool (*gs_timer_range_end)(gs_timer_range_t *range);
 	bool (*gs_timer_range_get_data)(gs_timer_range_t *range, bool *disjoint,
 					uint64_t *frequency);
+	bool (*gs_timer_ready)(gs_timer_t *timer);
+	bool (*gs_timer_range_ready)(gs_timer_range_t *range);
 
 	void (*gs_shader_destroy)(gs_shader_t *shader);
 	int (*gs_shader_get_num_params)(const gs_shader_t *shader);
@@ -414,4 +445,7 @@ struct graphics_subsystem {
 	DARRAY(struct blend_state) blend_state_stack;
 
 	bool linear_srgb;
+
+	DARRAY(struct texrender_buffers) texrender_pool;
+	uint64_t frame;
 };
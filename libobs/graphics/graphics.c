@@ -239,6 +239,8 @@ void gs_destroy(graphics_t *graphics)
 			effect = next;
 		}
 
+		gs_texrender_pool_trim(graphics, true);
+
 		graphics->exports.gs_vertexbuffer_destroy(
 			graphics->sprite_buffer);
 		graphics->exports.gs_vertexbuffer_destroy(
@@ -253,6 +255,7 @@ void gs_destroy(graphics_t *graphics)
 	da_free(graphics->matrix_stack);
 	da_free(graphics->viewport_stack);
 	da_free(graphics->blend_state_stack);
+	da_free(graphics->texrender_pool);
 	if (graphics->module)
 		os_dlclose(graphics->module);
 	bfree(graphics);
@@ -793,16 +796,37 @@ gs_effect_t *gs_get_effect(void)
 	return thread_graphics ? thread_graphics->cur_effect : NULL;
 }
 
-static inline struct gs_effect *find_cached_effect(const char *filename)
+static inline uint64_t effect_hash(const char *str)
+{
+	uint64_t hash = 0xcbf29ce484222325ULL;
+
+	while (*str) {
+		hash ^= (uint8_t)*str++;
+		hash *= 0x100000001b3ULL;
+	}
+
+	return hash;
+}
+
+/* a NULL content hash matches any effect loaded from the path */
+static struct gs_effect *find_cached_effect(const char *filename,
+					    uint64_t path_hash,
+					    const uint64_t *content_hash)
 {
-	struct gs_effect *effect = thread_graphics->first_effect;
+	struct gs_effect *effect;
+
+	pthread_mutex_lock(&thread_graphics->effect_mutex);
 
+	effect = thread_graphics->first_effect;
 	while (effect) {
-		if (strcmp(effect->effect_path, filename) == 0)
+		if (effect->path_hash == path_hash &&
+		    (!content_hash || effect->content_hash == *content_hash) &&
+		    strcmp(effect->effect_path, filename) == 0)
 			break;
 		effect = effect->next;
 	}
 
+	pthread_mutex_unlock(&thread_graphics->effect_mutex);
 	return effect;
 }
 
@@ -814,7 +838,7 @@ gs_effect_t *gs_effect_create_from_file(const char *file, char **error_string)
 	if (!gs_valid_p("gs_effect_create_from_file", file))
 		return NULL;
 
-	effect = find_cached_effect(file);
+	effect = find_cached_effect(file, effect_hash(file), NULL);
 	if (effect)
 		return effect;
 
@@ -836,12 +860,26 @@ gs_effect_t *gs_effect_create(const char *effect_string, const char *filename,
 	if (!gs_valid_p("gs_effect_create", effect_string))
 		return NULL;
 
+	const uint64_t path_hash = filename ? effect_hash(filename) : 0;
+	const uint64_t content_hash = effect_hash(effect_string);
+
+	/* named effects are shared, so the same source doesn't need to be
+	 * parsed and compiled again */
+	if (filename) {
+		struct gs_effect *cached =
+			find_cached_effect(filename, path_hash, &content_hash);
+		if (cached)
+			return cached;
+	}
+
 	struct gs_effect *effect = bzalloc(sizeof(struct gs_effect));
 	struct effect_parser parser;
 	bool success;
 
 	effect->graphics = thread_graphics;
 	effect->effect_path = bstrdup(filename);
+	effect->path_hash = path_hash;
+	effect->content_hash = content_hash;
 
 	ep_init(&parser);
 	success = ep_parse(&parser, effect, effect_string, filename);
@@ -1886,6 +1924,9 @@ void gs_begin_frame(void)
 	if (!gs_valid("gs_begin_frame"))
 		return;
 
+	graphics->frame++;
+	gs_texrender_pool_trim(graphics, false);
+
 	graphics->exports.device_begin_frame(graphics->device);
 }
 
@@ -2836,6 +2877,30 @@ bool gs_timer_range_get_data(gs_timer_range_t *range, bool *disjoint,
 								frequency);
 }
 
+bool gs_timer_ready(gs_timer_t *timer)
+{
+	if (!gs_valid_p("gs_timer_ready", timer))
+		return false;
+
+	/* without a non-blocking query, report ready so callers fall back to
+	 * the blocking gs_timer_get_data */
+	if (!thread_graphics->exports.gs_timer_ready)
+		return true;
+
+	return thread_graphics->exports.gs_timer_ready(timer);
+}
+
+bool gs_timer_range_ready(gs_timer_range_t *range)
+{
+	if (!gs_valid("gs_timer_range_ready"))
+		return false;
+
+	if (!thread_graphics->exports.gs_timer_range_ready)
+		return true;
+
+	return thread_graphics->exports.gs_timer_range_ready(range);
+}
+
 bool gs_nv12_available(void)
 {
 	if (!gs_valid("gs_nv12_available"))
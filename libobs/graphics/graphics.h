@@ -477,6 +477,10 @@ EXPORT gs_texture_t *gs_texrender_get_texture(const gs_texrender_t *texrender);
 EXPORT enum gs_color_format
 gs_texrender_get_format(const gs_texrender_t *texrender);
 
+/* gives the texrender's texture back to a shared pool for other texrenders
+ * of the same size and format to reuse.  the next begin takes a new one */
+EXPORT void gs_texrender_release_buffers(gs_texrender_t *texrender);
+
 /* ---------------------------------------------------
  * graphics subsystem
  * --------------------------------------------------- */
@@ -849,11 +853,13 @@ EXPORT void gs_timer_destroy(gs_timer_t *timer);
 EXPORT void gs_timer_begin(gs_timer_t *timer);
 EXPORT void gs_timer_end(gs_timer_t *timer);
 EXPORT bool gs_timer_get_data(gs_timer_t *timer, uint64_t *ticks);
+EXPORT bool gs_timer_ready(gs_timer_t *timer);
 EXPORT void gs_timer_range_destroy(gs_timer_range_t *timer);
 EXPORT void gs_timer_range_begin(gs_timer_range_t *range);
 EXPORT void gs_timer_range_end(gs_timer_range_t *range);
 EXPORT bool gs_timer_range_get_data(gs_timer_range_t *range, bool *disjoint,
 				    uint64_t *frequency);
+EXPORT bool gs_timer_range_ready(gs_timer_range_t *range);
 
 EXPORT bool gs_nv12_available(void);
 EXPORT bool gs_p010_available(void);
@@ -16,6 +16,7 @@
 ******************************************************************************/
 
 #include "image-file.h"
+#include "graphics-internal.h"
 #include "../util/base.h"
 #include "../util/platform.h"
 #include "../util/dstr.h"
@@ -72,11 +73,152 @@ static inline void *alloc_mem(gs_image_file_t *image, uint64_t *mem_usage,
 	return bzalloc(size);
 }
 
+/* ------------------------------------------------------------------------- */
+/* frame ring for animations that are decoded as they play */
+
+/* upper bound on slots when the frame count isn't known or there's no
+ * limit, slot memory is only allocated once a frame is decoded into it */
+#define MAX_FRAME_RING_SLOTS 4096
+
+struct gs_image_frame_slot {
+	int frame;
+	uint8_t *data;
+};
+
+static size_t get_frame_ring_slots(uint64_t frame_size, uint64_t frames,
+				   uint64_t anim_mem_limit)
+{
+	uint64_t slots = anim_mem_limit ? anim_mem_limit / frame_size
+					: MAX_FRAME_RING_SLOTS;
+
+	if (frames && slots > frames)
+		slots = frames;
+	if (slots > MAX_FRAME_RING_SLOTS)
+		slots = MAX_FRAME_RING_SLOTS;
+	return slots ? (size_t)slots : 1;
+}
+
+static void init_frame_ring(gs_image_file_t *image, size_t slots)
+{
+	image->frame_ring = bmalloc(slots * sizeof(*image->frame_ring));
+	image->frame_ring_size = slots;
+
+	for (size_t i = 0; i < slots; i++) {
+		image->frame_ring[i].frame = -1;
+		image->frame_ring[i].data = NULL;
+	}
+}
+
+static void free_frame_ring(gs_image_file_t *image)
+{
+	for (size_t i = 0; i < image->frame_ring_size; i++)
+		bfree(image->frame_ring[i].data);
+	bfree(image->frame_ring);
+}
+
+static inline struct gs_image_frame_slot *get_slot(gs_image_file_t *image,
+						   int frame)
+{
+	struct gs_image_frame_slot *slot =
+		&image->frame_ring[(size_t)frame % image->frame_ring_size];
+
+	if (!slot->data)
+		slot->data = bmalloc((size_t)image->cx * image->cy * 4);
+	return slot;
+}
+
+/* libnsgif only keeps the last decoded frame, so frames have to be decoded
+ * in order, starting over from the first frame when going back */
+static uint8_t *decode_gif_frame(gs_image_file_t *image, int frame,
+				 enum gs_image_alpha_mode alpha_mode)
+{
+	const size_t area = (size_t)image->cx * image->cy;
+	struct gs_image_frame_slot *slot;
+	int first = frame >= image->last_decoded_frame
+			    ? image->last_decoded_frame + 1
+			    : 0;
+
+	for (int i = first; i <= frame; i++) {
+		if (gif_decode_frame(&image->gif, i) != GIF_OK)
+			return NULL;
+		image->last_decoded_frame = i;
+	}
+
+	slot = get_slot(image, frame);
+
+	if (alpha_mode == GS_IMAGE_ALPHA_PREMULTIPLY_SRGB) {
+		gs_premultiply_xyza_srgb_loop_restrict(
+			slot->data, image->gif.frame_image, area);
+	} else if (alpha_mode == GS_IMAGE_ALPHA_PREMULTIPLY) {
+		gs_premultiply_xyza_loop_restrict(slot->data,
+						  image->gif.frame_image, area);
+	} else {
+		memcpy(slot->data, image->gif.frame_image, area * 4);
+	}
+
+	slot->frame = frame;
+	return slot->data;
+}
+
+static uint8_t *decode_anim_frame(gs_image_file_t *image, int frame)
+{
+	if (image->anim_frame_count && frame >= image->anim_frame_count)
+		return NULL;
+
+	if (frame <= image->anim_decoded_frame) {
+		if (!gs_image_anim_rewind(image->anim))
+			return NULL;
+		image->anim_decoded_frame = -1;
+	}
+
+	while (image->anim_decoded_frame < frame) {
+		int next = image->anim_decoded_frame + 1;
+		struct gs_image_frame_slot *slot = get_slot(image, next);
+		uint64_t duration;
+
+		slot->frame = -1;
+
+		if (!gs_image_anim_decode(image->anim, slot->data,
+					  &duration)) {
+			if (next)
+				image->anim_frame_count = next;
+			return NULL;
+		}
+
+		if (!duration)
+			duration = 100000000;
+		if ((size_t)next == image->anim_durations.num)
+			da_push_back(image->anim_durations, &duration);
+
+		slot->frame = next;
+		image->anim_decoded_frame = next;
+	}
+
+	return get_slot(image, frame)->data;
+}
+
+static uint8_t *get_frame(gs_image_file_t *image, int frame,
+			  enum gs_image_alpha_mode alpha_mode)
+{
+	struct gs_image_frame_slot *slot =
+		&image->frame_ring[(size_t)frame % image->frame_ring_size];
+
+	if (slot->frame == frame)
+		return slot->data;
+
+	return image->anim ? decode_anim_frame(image, frame)
+			   : decode_gif_frame(image, frame, alpha_mode);
+}
+
+/* ------------------------------------------------------------------------- */
+
 static bool init_animated_gif(gs_image_file_t *image, const char *path,
 			      uint64_t *mem_usage,
-			      enum gs_image_alpha_mode alpha_mode)
+			      enum gs_image_alpha_mode alpha_mode,
+			      uint64_t anim_mem_limit)
 {
 	bool is_animated_gif = true;
+	bool streaming;
 	gif_result result;
 	uint64_t max_size;
 	size_t size, size_read;
@@ -127,15 +269,39 @@ static bool init_animated_gif(gs_image_file_t *image, const char *path,
 
 	max_size = (uint64_t)image->gif.width * (uint64_t)image->gif.height *
 		   (uint64_t)image->gif.frame_count * 4LLU;
+	streaming = anim_mem_limit && max_size > anim_mem_limit;
 
-	if ((uint64_t)get_full_decoded_gif_size(image) != max_size) {
+	if (!streaming &&
+	    (uint64_t)get_full_decoded_gif_size(image) != max_size) {
 		blog(LOG_WARNING, "Gif '%s' overflowed maximum pointer size",
 		     path);
 		goto fail;
 	}
 
 	image->is_animated_gif = (image->gif.frame_count > 1 && result >= 0);
-	if (image->is_animated_gif) {
+	if (image->is_animated_gif && streaming) {
+		const uint64_t frame_size =
+			(uint64_t)image->gif.width * image->gif.height * 4;
+		size_t slots = get_frame_ring_slots(
+			frame_size, image->gif.frame_count, anim_mem_limit);
+
+		image->cx = (uint32_t)image->gif.width;
+		image->cy = (uint32_t)image->gif.height;
+		image->format = GS_RGBA;
+
+		init_frame_ring(image, slots);
+		if (!get_frame(image, 0, alpha_mode)) {
+			blog(LOG_WARNING, "Couldn't decode first frame of '%s'",
+			     path);
+			goto fail;
+		}
+
+		if (mem_usage) {
+			*mem_usage += slots * frame_size;
+			*mem_usage += size;
+		}
+
+	} else if (image->is_animated_gif) {
 		gif_decode_frame(&image->gif, 0);
 
 		image->animation_frame_cache =
@@ -191,10 +357,103 @@ not_animated:
 	return is_animated_gif;
 }
 
+/* APNG and animated WebP always go through the frame ring, their frame count
+ * isn't known without decoding the whole file */
+static bool init_animation(gs_image_file_t *image, const char *path,
+			   uint64_t *mem_usage,
+			   enum gs_image_alpha_mode alpha_mode,
+			   uint64_t anim_mem_limit)
+{
+	uint64_t frame_size;
+	size_t slots;
+
+	image->anim = gs_image_anim_create(path, alpha_mode, &image->cx,
+					   &image->cy);
+	if (!image->anim)
+		return false;
+
+	image->format = GS_RGBA;
+	image->anim_decoded_frame = -1;
+
+	frame_size = (uint64_t)image->cx * image->cy * 4;
+	slots = get_frame_ring_slots(frame_size, 0, anim_mem_limit);
+	init_frame_ring(image, slots);
+
+	if (!get_frame(image, 0, alpha_mode)) {
+		blog(LOG_WARNING, "Couldn't decode first frame of '%s'", path);
+		gs_image_file_free(image);
+		return true;
+	}
+
+	if (mem_usage)
+		*mem_usage += slots * frame_size;
+
+	image->is_animated_gif = true;
+	image->loaded = true;
+	return true;
+}
+
+static inline uint32_t read_be32(const uint8_t *p)
+{
+	return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+	       ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+/* APNG files have an acTL chunk before the first IDAT chunk, animated WebP
+ * files set the animation flag in the VP8X chunk.  checking the header keeps
+ * still images from being opened twice */
+static bool is_animated_image(const char *path)
+{
+	static const uint8_t png_sig[8] = {0x89, 'P', 'N', 'G',
+					   '\r', '\n', 0x1A, '\n'};
+	bool animated = false;
+	uint8_t buf[21];
+	FILE *file;
+
+	file = os_fopen(path, "rb");
+	if (!file)
+		return false;
+
+	if (fread(buf, 1, 8, file) != 8)
+		goto done;
+
+	if (memcmp(buf, png_sig, 8) == 0) {
+		while (fread(buf, 1, 8, file) == 8) {
+			uint32_t len = read_be32(buf);
+
+			if (memcmp(buf + 4, "acTL", 4) == 0) {
+				animated = true;
+				break;
+			}
+			if (memcmp(buf + 4, "IDAT", 4) == 0)
+				break;
+			if (os_fseeki64(file, (int64_t)len + 4, SEEK_CUR) != 0)
+				break;
+		}
+
+	} else if (memcmp(buf, "RIFF", 4) == 0 &&
+		   fread(buf + 8, 1, 13, file) == 13) {
+		animated = memcmp(buf + 8, "WEBPVP8X", 8) == 0 &&
+			   (buf[20] & 0x02) != 0;
+	}
+
+done:
+	fclose(file);
+	return animated;
+}
+
+static inline bool is_animation_ext(const char *file, size_t len)
+{
+	return (len > 4 && astrcmpi(file + len - 4, ".png") == 0) ||
+	       (len > 5 && astrcmpi(file + len - 5, ".apng") == 0) ||
+	       (len > 5 && astrcmpi(file + len - 5, ".webp") == 0);
+}
+
 static void gs_image_file_init_internal(gs_image_file_t *image,
 					const char *file, uint64_t *mem_usage,
 					enum gs_color_space *space,
-					enum gs_image_alpha_mode alpha_mode)
+					enum gs_image_alpha_mode alpha_mode,
+					uint64_t anim_mem_limit)
 {
 	size_t len;
 
@@ -209,7 +468,13 @@ static void gs_image_file_init_internal(gs_image_file_t *image,
 	len = strlen(file);
 
 	if (len > 4 && astrcmpi(file + len - 4, ".gif") == 0) {
-		if (init_animated_gif(image, file, mem_usage, alpha_mode)) {
+		if (init_animated_gif(image, file, mem_usage, alpha_mode,
+				      anim_mem_limit)) {
+			return;
+		}
+	} else if (is_animation_ext(file, len) && is_animated_image(file)) {
+		if (init_animation(image, file, mem_usage, alpha_mode,
+				   anim_mem_limit)) {
 			return;
 		}
 	}
@@ -234,7 +499,8 @@ void gs_image_file_init(gs_image_file_t *image, const char *file)
 {
 	enum gs_color_space unused;
 	gs_image_file_init_internal(image, file, NULL, &unused,
-				    GS_IMAGE_ALPHA_STRAIGHT);
+				    GS_IMAGE_ALPHA_STRAIGHT,
+				    GS_IMAGE_ANIM_MEM_LIMIT);
 }
 
 void gs_image_file_free(gs_image_file_t *image)
@@ -243,7 +509,7 @@ void gs_image_file_free(gs_image_file_t *image)
 		return;
 
 	if (image->loaded) {
-		if (image->is_animated_gif) {
+		if (image->is_animated_gif && !image->anim) {
 			gif_finalise(&image->gif);
 			bfree(image->animation_frame_cache);
 			bfree(image->animation_frame_data);
@@ -252,6 +518,9 @@ void gs_image_file_free(gs_image_file_t *image)
 		gs_texture_destroy(image->texture);
 	}
 
+	gs_image_anim_destroy(image->anim);
+	free_frame_ring(image);
+	da_free(image->anim_durations);
 	bfree(image->texture_data);
 	bfree(image->gif_data);
 	memset(image, 0, sizeof(*image));
@@ -261,7 +530,8 @@ void gs_image_file2_init(gs_image_file2_t *if2, const char *file)
 {
 	enum gs_color_space unused;
 	gs_image_file_init_internal(&if2->image, file, &if2->mem_usage, &unused,
-				    GS_IMAGE_ALPHA_STRAIGHT);
+				    GS_IMAGE_ALPHA_STRAIGHT,
+				    GS_IMAGE_ANIM_MEM_LIMIT);
 }
 
 void gs_image_file3_init(gs_image_file3_t *if3, const char *file,
@@ -270,7 +540,7 @@ void gs_image_file3_init(gs_image_file3_t *if3, const char *file,
 	enum gs_color_space unused;
 	gs_image_file_init_internal(&if3->image2.image, file,
 				    &if3->image2.mem_usage, &unused,
-				    alpha_mode);
+				    alpha_mode, GS_IMAGE_ANIM_MEM_LIMIT);
 	if3->alpha_mode = alpha_mode;
 }
 
@@ -279,8 +549,98 @@ void gs_image_file4_init(gs_image_file4_t *if4, const char *file,
 {
 	gs_image_file_init_internal(&if4->image3.image2.image, file,
 				    &if4->image3.image2.mem_usage, &if4->space,
-				    alpha_mode);
+				    alpha_mode, GS_IMAGE_ANIM_MEM_LIMIT);
+	if4->image3.alpha_mode = alpha_mode;
+}
+
+/* box filters by a whole factor, so the image stays at least min_cx x min_cy
+ * and no resampling is needed */
+static void downscale_texture_data(gs_image_file_t *image, uint32_t min_cx,
+				   uint32_t min_cy)
+{
+	uint32_t factor, cx, cy, area;
+	uint8_t *data;
+
+	if (!min_cx || !min_cy)
+		return;
+
+	switch (image->format) {
+	case GS_RGBA:
+	case GS_BGRX:
+	case GS_BGRA:
+		break;
+	default:
+		return;
+	}
+
+	factor = image->cx / min_cx;
+	if (image->cy / min_cy < factor)
+		factor = image->cy / min_cy;
+	if (factor < 2)
+		return;
+
+	cx = image->cx / factor;
+	cy = image->cy / factor;
+	area = factor * factor;
+	data = bmalloc((size_t)cx * cy * 4);
+
+	for (uint32_t y = 0; y < cy; y++) {
+		for (uint32_t x = 0; x < cx; x++) {
+			uint32_t sum[4] = {0};
+
+			for (uint32_t sy = 0; sy < factor; sy++) {
+				const uint8_t *in =
+					image->texture_data +
+					((size_t)(y * factor + sy) * image->cx +
+					 (size_t)x * factor) *
+						4;
+
+				for (uint32_t sx = 0; sx < factor; sx++) {
+					sum[0] += in[0];
+					sum[1] += in[1];
+					sum[2] += in[2];
+					sum[3] += in[3];
+					in += 4;
+				}
+			}
+
+			uint8_t *out = data + ((size_t)y * cx + x) * 4;
+			for (size_t i = 0; i < 4; i++)
+				out[i] = (uint8_t)((sum[i] + area / 2) / area);
+		}
+	}
+
+	bfree(image->texture_data);
+	image->texture_data = data;
+	image->cx = cx;
+	image->cy = cy;
+}
+
+void gs_image_file4_init_downscaled(gs_image_file4_t *if4, const char *file,
+				    enum gs_image_alpha_mode alpha_mode,
+				    uint32_t min_cx, uint32_t min_cy)
+{
+	gs_image_file4_init_ex(if4, file, alpha_mode, min_cx, min_cy,
+			       GS_IMAGE_ANIM_MEM_LIMIT);
+}
+
+void gs_image_file4_init_ex(gs_image_file4_t *if4, const char *file,
+			    enum gs_image_alpha_mode alpha_mode,
+			    uint32_t min_cx, uint32_t min_cy,
+			    uint64_t anim_mem_limit)
+{
+	gs_image_file_t *image = &if4->image3.image2.image;
+
+	gs_image_file_init_internal(image, file, &if4->image3.image2.mem_usage,
+				    &if4->space, alpha_mode, anim_mem_limit);
 	if4->image3.alpha_mode = alpha_mode;
+
+	if (!image->loaded || image->is_animated_gif)
+		return;
+
+	downscale_texture_data(image, min_cx, min_cy);
+	if4->image3.image2.mem_usage =
+		image->cx * image->cy * gs_get_format_bpp(image->format) / 8;
 }
 
 void gs_image_file_init_texture(gs_image_file_t *image)
@@ -289,9 +649,12 @@ void gs_image_file_init_texture(gs_image_file_t *image)
 		return;
 
 	if (image->is_animated_gif) {
-		image->texture = gs_texture_create(
-			image->cx, image->cy, image->format, 1,
-			(const uint8_t **)&image->gif.frame_image, GS_DYNAMIC);
+		const uint8_t *data = image->frame_ring
+					      ? image->frame_ring[0].data
+					      : image->gif.frame_image;
+		image->texture = gs_texture_create(image->cx, image->cy,
+						   image->format, 1, &data,
+						   GS_DYNAMIC);
 
 	} else {
 		image->texture = gs_texture_create(
@@ -335,10 +698,36 @@ static inline int calculate_new_frame(gs_image_file_t *image,
 	return new_frame;
 }
 
+static int calculate_new_anim_frame(gs_image_file_t *image,
+				    uint64_t elapsed_time_ns,
+				    enum gs_image_alpha_mode alpha_mode)
+{
+	int new_frame = image->cur_frame;
+
+	image->cur_time += elapsed_time_ns;
+	while ((size_t)new_frame < image->anim_durations.num) {
+		uint64_t t = image->anim_durations.array[new_frame];
+		if (image->cur_time <= t)
+			break;
+
+		image->cur_time -= t;
+
+		/* the next frame has to be decoded to know how long it's
+		 * shown for, failing to decode it means the end was hit */
+		if (++new_frame == image->anim_frame_count ||
+		    !get_frame(image, new_frame, alpha_mode))
+			new_frame = 0;
+	}
+
+	return new_frame;
+}
+
 static void decode_new_frame(gs_image_file_t *image, int new_frame,
 			     enum gs_image_alpha_mode alpha_mode)
 {
-	if (!image->animation_frame_cache[new_frame]) {
+	if (image->frame_ring) {
+		get_frame(image, new_frame, alpha_mode);
+	} else if (!image->animation_frame_cache[new_frame]) {
 		int last_frame;
 
 		/* if looped, decode frame 0 */
@@ -387,6 +776,18 @@ static bool gs_image_file_tick_internal(gs_image_file_t *image,
 	if (!image->is_animated_gif || !image->loaded)
 		return false;
 
+	if (image->anim) {
+		int new_frame = calculate_new_anim_frame(
+			image, elapsed_time_ns, alpha_mode);
+
+		if (new_frame != image->cur_frame) {
+			image->cur_frame = new_frame;
+			return true;
+		}
+
+		return false;
+	}
+
 	loops = image->gif.loop_count;
 	if (loops >= 0xFFFF)
 		loops = 0;
@@ -434,6 +835,14 @@ gs_image_file_update_texture_internal(gs_image_file_t *image,
 	if (!image->is_animated_gif || !image->loaded)
 		return;
 
+	if (image->frame_ring) {
+		uint8_t *data = get_frame(image, image->cur_frame, alpha_mode);
+		if (data)
+			gs_texture_set_image(image->texture, data,
+					     image->cx * 4, false);
+		return;
+	}
+
 	if (!image->animation_frame_cache[image->cur_frame])
 		decode_new_frame(image, image->cur_frame, alpha_mode);
 
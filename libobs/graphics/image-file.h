@@ -19,16 +19,25 @@
 
 #include "graphics.h"
 #include "libnsgif/libnsgif.h"
+#include "../util/darray.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+struct gs_image_anim;
+struct gs_image_frame_slot;
+
+/* default limit for the decoded frames of an animated image, animations
+ * bigger than this are decoded as they play */
+#define GS_IMAGE_ANIM_MEM_LIMIT (256ULL * 1024 * 1024)
+
 struct gs_image_file {
 	gs_texture_t *texture;
 	enum gs_color_format format;
 	uint32_t cx;
 	uint32_t cy;
+	/* set for any animated image, not just gifs */
 	bool is_animated_gif;
 	bool frame_updated;
 	bool loaded;
@@ -44,6 +53,17 @@ struct gs_image_file {
 
 	uint8_t *texture_data;
 	gif_bitmap_callback_vt bitmap_callbacks;
+
+	/* frames decoded on demand, frame n lives in slot n % frame_ring_size
+	 * until a later frame replaces it */
+	struct gs_image_frame_slot *frame_ring;
+	size_t frame_ring_size;
+
+	/* APNG and animated WebP, frame count is 0 until the end is found */
+	struct gs_image_anim *anim;
+	DARRAY(uint64_t) anim_durations;
+	int anim_frame_count;
+	int anim_decoded_frame;
 };
 
 struct gs_image_file2 {
@@ -90,6 +110,21 @@ EXPORT void gs_image_file3_update_texture(gs_image_file3_t *if3);
 EXPORT void gs_image_file4_init(gs_image_file4_t *if4, const char *file,
 				enum gs_image_alpha_mode alpha_mode);
 
+/* like gs_image_file4_init, but still images that are at least twice
+ * min_cx x min_cy are shrunk by a whole factor that keeps them at least that
+ * size.  animated images and high bit depth images are loaded as is */
+EXPORT void gs_image_file4_init_downscaled(gs_image_file4_t *if4,
+					   const char *file,
+					   enum gs_image_alpha_mode alpha_mode,
+					   uint32_t min_cx, uint32_t min_cy);
+
+/* like gs_image_file4_init_downscaled, anim_mem_limit caps the memory used
+ * for the decoded frames of an animated image (0 for no limit) */
+EXPORT void gs_image_file4_init_ex(gs_image_file4_t *if4, const char *file,
+				   enum gs_image_alpha_mode alpha_mode,
+				   uint32_t min_cx, uint32_t min_cy,
+				   uint64_t anim_mem_limit);
+
 EXPORT bool gs_image_file4_tick(gs_image_file4_t *if4,
 				uint64_t elapsed_time_ns);
 EXPORT void gs_image_file4_update_texture(gs_image_file4_t *if4);
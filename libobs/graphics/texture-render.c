@@ -21,7 +21,7 @@
  */
 
 #include <assert.h>
-#include "graphics.h"
+#include "graphics-internal.h"
 
 struct gs_texture_render {
 	gs_texture_t *target, *prev_target;
@@ -47,29 +47,110 @@ gs_texrender_t *gs_texrender_create(enum gs_color_format format,
 	return texrender;
 }
 
+static inline void destroy_buffers(struct texrender_buffers *buffers)
+{
+	gs_texture_destroy(buffers->target);
+	gs_zstencil_destroy(buffers->zs);
+}
+
+void gs_texrender_pool_trim(graphics_t *graphics, bool all)
+{
+	for (size_t i = graphics->texrender_pool.num; i > 0; i--) {
+		struct texrender_buffers *buffers =
+			&graphics->texrender_pool.array[i - 1];
+
+		if (all || graphics->frame - buffers->released_frame >
+				   TEXRENDER_POOL_MAX_IDLE_FRAMES) {
+			destroy_buffers(buffers);
+			da_erase(graphics->texrender_pool, i - 1);
+		}
+	}
+}
+
+/* hands the texrender's buffers to the pool, destroys them if there's no
+ * graphics context to give them to */
+static void release_buffers(gs_texrender_t *texrender)
+{
+	graphics_t *graphics = gs_get_context();
+	struct texrender_buffers buffers = {
+		.target = texrender->target,
+		.zs = texrender->zs,
+		.cx = texrender->cx,
+		.cy = texrender->cy,
+		.format = texrender->format,
+		.zsformat = texrender->zsformat,
+	};
+
+	texrender->target = NULL;
+	texrender->zs = NULL;
+	texrender->cx = 0;
+	texrender->cy = 0;
+
+	if (!buffers.target)
+		return;
+
+	if (!graphics) {
+		destroy_buffers(&buffers);
+		return;
+	}
+
+	buffers.released_frame = graphics->frame;
+	da_push_back(graphics->texrender_pool, &buffers);
+}
+
+/* takes the most recently released matching buffers from the pool */
+static bool acquire_buffers(gs_texrender_t *texrender, uint32_t cx,
+			    uint32_t cy)
+{
+	graphics_t *graphics = gs_get_context();
+	if (!graphics)
+		return false;
+
+	for (size_t i = graphics->texrender_pool.num; i > 0; i--) {
+		struct texrender_buffers *buffers =
+			&graphics->texrender_pool.array[i - 1];
+
+		if (buffers->cx == cx && buffers->cy == cy &&
+		    buffers->format == texrender->format &&
+		    buffers->zsformat == texrender->zsformat) {
+			texrender->target = buffers->target;
+			texrender->zs = buffers->zs;
+			da_erase(graphics->texrender_pool, i - 1);
+			return true;
+		}
+	}
+
+	return false;
+}
+
 void gs_texrender_destroy(gs_texrender_t *texrender)
 {
 	if (texrender) {
-		gs_texture_destroy(texrender->target);
-		gs_zstencil_destroy(texrender->zs);
+		release_buffers(texrender);
 		bfree(texrender);
 	}
 }
 
+void gs_texrender_release_buffers(gs_texrender_t *texrender)
+{
+	if (texrender)
+		release_buffers(texrender);
+}
+
 static bool texrender_resetbuffer(gs_texrender_t *texrender, uint32_t cx,
 				  uint32_t cy)
 {
 	if (!texrender)
 		return false;
 
-	gs_texture_destroy(texrender->target);
-	gs_zstencil_destroy(texrender->zs);
+	release_buffers(texrender);
 
-	texrender->target = NULL;
-	texrender->zs = NULL;
 	texrender->cx = cx;
 	texrender->cy = cy;
 
+	if (acquire_buffers(texrender, cx, cy))
+		return true;
+
 	texrender->target = gs_texture_create(cx, cy, texrender->format, 1,
 					      NULL, GS_RENDER_TARGET);
 	if (!texrender->target)
@@ -26,15 +26,10 @@
 #include "../util/util_uint64.h"
 
 #include "audio-io.h"
+#include "audio-kernels.h"
 #include "audio-resampler.h"
 #include "obs-internal.h"
 
-#ifdef _WIN32
-#define WIN32_LEAN_AND_MEAN
-#include <Windows.h>
-#include <avrt.h>
-#endif
-
 extern profiler_name_store_t *obs_get_profiler_name_store(void);
 
 /* #define DEBUG_AUDIO */
@@ -44,24 +39,49 @@ extern profiler_name_store_t *obs_get_profiler_name_store(void);
 		int invalid = 0; \
 	} while (0)
 
-struct audio_input {
+/* inputs of a mix that ask for the same conversion receive identical
+ * data, so they share one resampler that runs once per tick */
+struct mix_resampler {
 	struct audio_convert_info conversion;
 	audio_resampler_t *resampler;
+	long refs;
+
+	bool resampled;
+	bool success;
+	struct audio_data output;
+};
+
+struct audio_input {
+	struct audio_convert_info conversion;
+	struct mix_resampler *resampler;
 
 	audio_output_callback_t callback;
 	void *param;
 };
 
-static inline void audio_input_free(struct audio_input *input)
-{
-	audio_resampler_destroy(input->resampler);
-}
-
 struct audio_mix {
 	DARRAY(struct audio_input) inputs;
+	DARRAY(struct mix_resampler *) resamplers;
 	float buffer[MAX_AUDIO_CHANNELS][AUDIO_OUTPUT_FRAMES];
 };
 
+static void release_mix_resampler(struct audio_mix *mix,
+				  struct mix_resampler *mr)
+{
+	if (!mr || --mr->refs > 0)
+		return;
+
+	da_erase_item(mix->resamplers, &mr);
+	audio_resampler_destroy(mr->resampler);
+	bfree(mr);
+}
+
+static inline void audio_input_free(struct audio_mix *mix,
+				    struct audio_input *input)
+{
+	release_mix_resampler(mix, input->resampler);
+}
+
 struct audio_output {
 	struct audio_output_info info;
 	size_t block_size;
@@ -77,6 +97,8 @@ struct audio_output {
 	void *input_param;
 	pthread_mutex_t input_mutex;
 	struct audio_mix mixes[MAX_AUDIO_MIXES];
+
+	volatile uint64_t output_ns;
 };
 
 /* ------------------------------------------------------------------------- */
@@ -84,26 +106,31 @@ struct audio_output {
 static bool resample_audio_output(struct audio_input *input,
 				  struct audio_data *data)
 {
-	bool success = true;
+	struct mix_resampler *mr = input->resampler;
 
-	if (input->resampler) {
+	if (!mr)
+		return true;
+
+	if (!mr->resampled) {
 		uint8_t *output[MAX_AV_PLANES];
-		uint32_t frames;
-		uint64_t offset;
+		uint32_t frames = 0;
+		uint64_t offset = 0;
 
 		memset(output, 0, sizeof(output));
 
-		success = audio_resampler_resample(
-			input->resampler, output, &frames, &offset,
+		mr->success = audio_resampler_resample(
+			mr->resampler, output, &frames, &offset,
 			(const uint8_t *const *)data->data, data->frames);
 
 		for (size_t i = 0; i < MAX_AV_PLANES; i++)
-			data->data[i] = output[i];
-		data->frames = frames;
-		data->timestamp -= offset;
+			mr->output.data[i] = output[i];
+		mr->output.frames = frames;
+		mr->output.timestamp = data->timestamp - offset;
+		mr->resampled = true;
 	}
 
-	return success;
+	*data = mr->output;
+	return mr->success;
 }
 
 static inline void do_audio_output(struct audio_output *audio, size_t mix_idx,
@@ -114,6 +141,9 @@ static inline void do_audio_output(struct audio_output *audio, size_t mix_idx,
 
 	pthread_mutex_lock(&audio->input_mutex);
 
+	for (size_t i = 0; i < mix->resamplers.num; i++)
+		mix->resamplers.array[i]->resampled = false;
+
 	for (size_t i = mix->inputs.num; i > 0; i--) {
 		struct audio_input *input = mix->inputs.array + (i - 1);
 
@@ -129,7 +159,8 @@ static inline void do_audio_output(struct audio_output *audio, size_t mix_idx,
 	pthread_mutex_unlock(&audio->input_mutex);
 }
 
-static inline void clamp_audio_output(struct audio_output *audio, size_t bytes)
+static inline void clamp_audio_output(struct audio_output *audio, size_t bytes,
+				      uint32_t active_mixes)
 {
 	size_t float_size = bytes / sizeof(float);
 
@@ -137,21 +168,11 @@ static inline void clamp_audio_output(struct audio_output *audio, size_t bytes)
 		struct audio_mix *mix = &audio->mixes[mix_idx];
 
 		/* do not process mixing if a specific mix is inactive */
-		if (!mix->inputs.num)
+		if ((active_mixes & (1 << mix_idx)) == 0)
 			continue;
 
-		for (size_t plane = 0; plane < audio->planes; plane++) {
-			float *mix_data = mix->buffer[plane];
-			float *mix_end = &mix_data[float_size];
-
-			while (mix_data < mix_end) {
-				float val = *mix_data;
-				val = (val == val) ? val : 0.0f;
-				val = (val > 1.0f) ? 1.0f : val;
-				val = (val < -1.0f) ? -1.0f : val;
-				*(mix_data++) = val;
-			}
-		}
+		for (size_t plane = 0; plane < audio->planes; plane++)
+			audio_kernel_clamp(mix->buffer[plane], float_size);
 	}
 }
 
@@ -179,11 +200,12 @@ static void input_and_output(struct audio_output *audio, uint64_t audio_time,
 	}
 	pthread_mutex_unlock(&audio->input_mutex);
 
-	/* clear mix buffers */
+	/* clear mix buffers, unconnected mixes are neither mixed nor output */
 	for (size_t mix_idx = 0; mix_idx < MAX_AUDIO_MIXES; mix_idx++) {
 		struct audio_mix *mix = &audio->mixes[mix_idx];
 
-		memset(mix->buffer, 0, sizeof(mix->buffer));
+		if ((active_mixes & (1 << mix_idx)) != 0)
+			memset(mix->buffer, 0, sizeof(mix->buffer));
 
 		for (size_t i = 0; i < audio->planes; i++)
 			data[mix_idx].data[i] = mix->buffer[i];
@@ -196,19 +218,22 @@ static void input_and_output(struct audio_output *audio, uint64_t audio_time,
 		return;
 
 	/* clamps audio data to -1.0..1.0 */
-	clamp_audio_output(audio, bytes);
+	clamp_audio_output(audio, bytes, active_mixes);
 
 	/* output */
-	for (size_t i = 0; i < MAX_AUDIO_MIXES; i++)
-		do_audio_output(audio, i, new_ts, AUDIO_OUTPUT_FRAMES);
+	uint64_t output_start = os_gettime_ns();
+
+	for (size_t i = 0; i < MAX_AUDIO_MIXES; i++) {
+		if ((active_mixes & (1 << i)) != 0)
+			do_audio_output(audio, i, new_ts, AUDIO_OUTPUT_FRAMES);
+	}
+
+	audio->output_ns = os_gettime_ns() - output_start;
 }
 
 static void *audio_thread(void *param)
 {
-#ifdef _WIN32
-	DWORD unused = 0;
-	const HANDLE handle = AvSetMmThreadCharacteristics(L"Audio", &unused);
-#endif
+	os_thread_role_t *role = os_set_thread_role(OS_THREAD_ROLE_AUDIO);
 
 	struct audio_output *audio = param;
 	size_t rate = audio->info.samples_per_sec;
@@ -241,11 +266,7 @@ static void *audio_thread(void *param)
 		profile_reenable_thread();
 	}
 
-#ifdef _WIN32
-	if (handle)
-		AvRevertMmThreadCharacteristics(handle);
-#endif
-
+	os_reset_thread_role(role);
 	return NULL;
 }
 
@@ -266,23 +287,58 @@ static size_t audio_get_input_idx(const audio_t *audio, size_t mix_idx,
 	return DARRAY_INVALID;
 }
 
+static inline bool same_conversion(const struct audio_convert_info *a,
+				   const struct audio_convert_info *b)
+{
+	return a->format == b->format &&
+	       a->samples_per_sec == b->samples_per_sec &&
+	       a->speakers == b->speakers;
+}
+
+static struct mix_resampler *get_mix_resampler(struct audio_output *audio,
+					       struct audio_mix *mix,
+					       const struct audio_convert_info *cv)
+{
+	struct mix_resampler *mr;
+
+	for (size_t i = 0; i < mix->resamplers.num; i++) {
+		mr = mix->resamplers.array[i];
+		if (same_conversion(&mr->conversion, cv)) {
+			mr->refs++;
+			return mr;
+		}
+	}
+
+	struct resample_info from = {
+		.format = audio->info.format,
+		.samples_per_sec = audio->info.samples_per_sec,
+		.speakers = audio->info.speakers};
+
+	struct resample_info to = {.format = cv->format,
+				   .samples_per_sec = cv->samples_per_sec,
+				   .speakers = cv->speakers};
+
+	audio_resampler_t *resampler = audio_resampler_create(&to, &from);
+	if (!resampler)
+		return NULL;
+
+	mr = bzalloc(sizeof(*mr));
+	mr->conversion = *cv;
+	mr->resampler = resampler;
+	mr->refs = 1;
+	da_push_back(mix->resamplers, &mr);
+	return mr;
+}
+
 static inline bool audio_input_init(struct audio_input *input,
-				    struct audio_output *audio)
+				    struct audio_output *audio,
+				    struct audio_mix *mix)
 {
 	if (input->conversion.format != audio->info.format ||
 	    input->conversion.samples_per_sec != audio->info.samples_per_sec ||
 	    input->conversion.speakers != audio->info.speakers) {
-		struct resample_info from = {
-			.format = audio->info.format,
-			.samples_per_sec = audio->info.samples_per_sec,
-			.speakers = audio->info.speakers};
-
-		struct resample_info to = {
-			.format = input->conversion.format,
-			.samples_per_sec = input->conversion.samples_per_sec,
-			.speakers = input->conversion.speakers};
-
-		input->resampler = audio_resampler_create(&to, &from);
+		input->resampler =
+			get_mix_resampler(audio, mix, &input->conversion);
 		if (!input->resampler) {
 			blog(LOG_ERROR, "audio_input_init: Failed to "
 					"create resampler");
@@ -329,7 +385,7 @@ bool audio_output_connect(audio_t *audio, size_t mi,
 			input.conversion.samples_per_sec =
 				audio->info.samples_per_sec;
 
-		success = audio_input_init(&input, audio);
+		success = audio_input_init(&input, audio, mix);
 		if (success)
 			da_push_back(mix->inputs, &input);
 	}
@@ -350,7 +406,7 @@ void audio_output_disconnect(audio_t *audio, size_t mix_idx,
 	size_t idx = audio_get_input_idx(audio, mix_idx, callback, param);
 	if (idx != DARRAY_INVALID) {
 		struct audio_mix *mix = &audio->mixes[mix_idx];
-		audio_input_free(mix->inputs.array + idx);
+		audio_input_free(mix, mix->inputs.array + idx);
 		da_erase(mix->inputs, idx);
 	}
 
@@ -421,9 +477,10 @@ void audio_output_close(audio_t *audio)
 		struct audio_mix *mix = &audio->mixes[mix_idx];
 
 		for (size_t i = 0; i < mix->inputs.num; i++)
-			audio_input_free(mix->inputs.array + i);
+			audio_input_free(mix, mix->inputs.array + i);
 
 		da_free(mix->inputs);
+		da_free(mix->resamplers);
 	}
 	bfree(audio);
 }
@@ -433,6 +490,11 @@ const struct audio_output_info *audio_output_get_info(const audio_t *audio)
 	return audio ? &audio->info : NULL;
 }
 
+uint64_t audio_output_get_output_time_ns(const audio_t *audio)
+{
+	return audio ? audio->output_ns : 0;
+}
+
 bool audio_output_active(const audio_t *audio)
 {
 	if (!audio)
@@ -222,6 +222,9 @@ EXPORT void audio_output_disconnect(audio_t *video, size_t mix_idx,
 
 EXPORT bool audio_output_active(const audio_t *audio);
 
+/** Gets how long the last tick spent in output (encoder) callbacks */
+EXPORT uint64_t audio_output_get_output_time_ns(const audio_t *audio);
+
 EXPORT size_t audio_output_get_block_size(const audio_t *audio);
 EXPORT size_t audio_output_get_planes(const audio_t *audio);
 EXPORT size_t audio_output_get_channels(const audio_t *audio);
@@ -0,0 +1,352 @@
+/******************************************************************************
+    Copyright (C) 2023 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+/*
+ * Float sample kernels used by the audio mixing paths.  These use SSE2
+ * through sse-intrin.h, which SIMDe maps to NEON on ARM, and operate on
+ * unaligned buffers so callers can pass offsets into mix buffers.
+ */
+
+#include <math.h>
+#include <float.h>
+
+#include "../util/c99defs.h"
+#include "../util/sse-intrin.h"
+
+/* dst[i] += src[i] */
+static inline void audio_kernel_add(float *dst, const float *src,
+				    size_t count)
+{
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		__m128 a0 = _mm_loadu_ps(dst + i);
+		__m128 a1 = _mm_loadu_ps(dst + i + 4);
+		__m128 b0 = _mm_loadu_ps(src + i);
+		__m128 b1 = _mm_loadu_ps(src + i + 4);
+		_mm_storeu_ps(dst + i, _mm_add_ps(a0, b0));
+		_mm_storeu_ps(dst + i + 4, _mm_add_ps(a1, b1));
+	}
+
+	for (; i < count; i++)
+		dst[i] += src[i];
+}
+
+/* data[i] *= mul */
+static inline void audio_kernel_mul(float *data, float mul, size_t count)
+{
+	const __m128 m = _mm_set1_ps(mul);
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		__m128 a0 = _mm_loadu_ps(data + i);
+		__m128 a1 = _mm_loadu_ps(data + i + 4);
+		_mm_storeu_ps(data + i, _mm_mul_ps(a0, m));
+		_mm_storeu_ps(data + i + 4, _mm_mul_ps(a1, m));
+	}
+
+	for (; i < count; i++)
+		data[i] *= mul;
+}
+
+/* data[i] *= mul[i] */
+static inline void audio_kernel_mul_buf(float *data, const float *mul,
+					size_t count)
+{
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		__m128 a0 = _mm_loadu_ps(data + i);
+		__m128 a1 = _mm_loadu_ps(data + i + 4);
+		__m128 m0 = _mm_loadu_ps(mul + i);
+		__m128 m1 = _mm_loadu_ps(mul + i + 4);
+		_mm_storeu_ps(data + i, _mm_mul_ps(a0, m0));
+		_mm_storeu_ps(data + i + 4, _mm_mul_ps(a1, m1));
+	}
+
+	for (; i < count; i++)
+		data[i] *= mul[i];
+}
+
+/* returns the sum of data[i] * data[i] */
+static inline float audio_kernel_sum_squares(const float *data, size_t count)
+{
+	__m128 sum0 = _mm_setzero_ps();
+	__m128 sum1 = _mm_setzero_ps();
+	float sums[4];
+	float sum;
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		__m128 a0 = _mm_loadu_ps(data + i);
+		__m128 a1 = _mm_loadu_ps(data + i + 4);
+		sum0 = _mm_add_ps(sum0, _mm_mul_ps(a0, a0));
+		sum1 = _mm_add_ps(sum1, _mm_mul_ps(a1, a1));
+	}
+
+	_mm_storeu_ps(sums, _mm_add_ps(sum0, sum1));
+	sum = (sums[0] + sums[1]) + (sums[2] + sums[3]);
+
+	for (; i < count; i++)
+		sum += data[i] * data[i];
+
+	return sum;
+}
+
+/* returns the largest absolute sample value */
+static inline float audio_kernel_abs_max(const float *data, size_t count)
+{
+	const __m128 sign = _mm_set1_ps(-0.0f);
+	__m128 peak = _mm_setzero_ps();
+	float peaks[4];
+	float r;
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4) {
+		__m128 v = _mm_andnot_ps(sign, _mm_loadu_ps(data + i));
+		peak = _mm_max_ps(peak, v);
+	}
+
+	_mm_storeu_ps(peaks, peak);
+	r = fmaxf(fmaxf(peaks[0], peaks[1]), fmaxf(peaks[2], peaks[3]));
+
+	for (; i < count; i++)
+		r = fmaxf(r, fabsf(data[i]));
+
+	return r;
+}
+
+/* returns true if every sample is zero (digital silence) */
+static inline bool audio_kernel_is_silent(const float *data, size_t count)
+{
+	const __m128 zero = _mm_setzero_ps();
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		__m128 a0 = _mm_cmpneq_ps(_mm_loadu_ps(data + i), zero);
+		__m128 a1 = _mm_cmpneq_ps(_mm_loadu_ps(data + i + 4), zero);
+		if (_mm_movemask_ps(_mm_or_ps(a0, a1)))
+			return false;
+	}
+
+	for (; i < count; i++) {
+		if (data[i] != 0.0f)
+			return false;
+	}
+
+	return true;
+}
+
+/* clamps samples to [-1, 1], replacing NaNs with silence */
+static inline void audio_kernel_clamp(float *data, size_t count)
+{
+	const __m128 lo = _mm_set1_ps(-1.0f);
+	const __m128 hi = _mm_set1_ps(1.0f);
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4) {
+		__m128 v = _mm_loadu_ps(data + i);
+		v = _mm_and_ps(v, _mm_cmpeq_ps(v, v));
+		v = _mm_min_ps(_mm_max_ps(v, lo), hi);
+		_mm_storeu_ps(data + i, v);
+	}
+
+	for (; i < count; i++) {
+		float val = data[i];
+		val = (val == val) ? val : 0.0f;
+		val = (val > 1.0f) ? 1.0f : val;
+		val = (val < -1.0f) ? -1.0f : val;
+		data[i] = val;
+	}
+}
+
+/* dst[i] = max(dst[i], fabs(src[i])) */
+static inline void audio_kernel_abs_max_buf(float *dst, const float *src,
+					    size_t count)
+{
+	const __m128 sign = _mm_set1_ps(-0.0f);
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4) {
+		__m128 v = _mm_andnot_ps(sign, _mm_loadu_ps(src + i));
+		_mm_storeu_ps(dst + i, _mm_max_ps(_mm_loadu_ps(dst + i), v));
+	}
+
+	for (; i < count; i++)
+		dst[i] = fmaxf(dst[i], fabsf(src[i]));
+}
+
+/* ------------------------------------------------------------------------- */
+/* Gain computers
+ *
+ * The dynamics filters convert every envelope sample to dB and every gain
+ * back again.  These replace log10f/powf with polynomial approximations of
+ * log2/exp2: log2 is within 2e-5 and exp2 within 1e-6 relative, which is far
+ * below 0.001 dB.  Silence (and anything below FLT_MIN) maps to about
+ * -758 dB instead of -inf, and gains are limited to +-126 octaves. */
+
+#define AUDIO_DB_PER_OCTAVE 6.0205999f /* 20 * log10(2) */
+#define AUDIO_MIN_OCTAVE -126.0f
+#define AUDIO_MAX_OCTAVE 126.0f
+
+static inline float audio_fast_log2f(float x)
+{
+	union {
+		float f;
+		uint32_t i;
+	} v;
+	float e, t;
+
+	v.f = x > FLT_MIN ? x : FLT_MIN;
+	e = (float)((int)(v.i >> 23) - 127);
+	v.i = (v.i & 0x7fffff) | 0x3f800000;
+	t = v.f - 1.0f;
+
+	return e + t * (1.4418799f +
+			t * (-0.70886522f +
+			     t * (0.41524556f +
+				  t * (-0.19351652f + t * 0.045268292f))));
+}
+
+static inline float audio_fast_exp2f(float x)
+{
+	union {
+		float f;
+		uint32_t i;
+	} v;
+	float fl, t, p;
+
+	x = x > AUDIO_MIN_OCTAVE ? x : AUDIO_MIN_OCTAVE;
+	x = x < AUDIO_MAX_OCTAVE ? x : AUDIO_MAX_OCTAVE;
+	fl = floorf(x);
+	t = x - fl;
+
+	p = 1.0f +
+	    t * (0.69315308f +
+		 t * (0.24015361f +
+		      t * (0.05582631f + t * (0.00898934f + t * 0.00187757f))));
+
+	v.i = (uint32_t)((int)fl + 127) << 23;
+	return p * v.f;
+}
+
+static inline __m128 audio_kernel_log2_ps(__m128 x)
+{
+	const __m128 one = _mm_set1_ps(1.0f);
+	__m128i bits = _mm_castps_si128(_mm_max_ps(x, _mm_set1_ps(FLT_MIN)));
+	__m128i exp = _mm_sub_epi32(_mm_srli_epi32(bits, 23),
+				    _mm_set1_epi32(127));
+	__m128i mant = _mm_or_si128(
+		_mm_and_si128(bits, _mm_set1_epi32(0x7fffff)),
+		_mm_set1_epi32(0x3f800000));
+	__m128 t = _mm_sub_ps(_mm_castsi128_ps(mant), one);
+	__m128 p;
+
+	p = _mm_set1_ps(0.045268292f);
+	p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(-0.19351652f));
+	p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(0.41524556f));
+	p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(-0.70886522f));
+	p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(1.4418799f));
+
+	return _mm_add_ps(_mm_cvtepi32_ps(exp), _mm_mul_ps(p, t));
+}
+
+static inline __m128 audio_kernel_exp2_ps(__m128 x)
+{
+	__m128 fl, t, p;
+	__m128i i;
+
+	x = _mm_max_ps(x, _mm_set1_ps(AUDIO_MIN_OCTAVE));
+	x = _mm_min_ps(x, _mm_set1_ps(AUDIO_MAX_OCTAVE));
+
+	/* floor: truncate, then step down where truncation rounded up */
+	i = _mm_cvttps_epi32(x);
+	fl = _mm_cvtepi32_ps(i);
+	i = _mm_add_epi32(i, _mm_castps_si128(_mm_cmpgt_ps(fl, x)));
+	t = _mm_sub_ps(x, _mm_cvtepi32_ps(i));
+
+	p = _mm_set1_ps(0.00187757f);
+	p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(0.00898934f));
+	p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(0.05582631f));
+	p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(0.24015361f));
+	p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(0.69315308f));
+	p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(1.0f));
+
+	i = _mm_slli_epi32(_mm_add_epi32(i, _mm_set1_epi32(127)), 23);
+	return _mm_mul_ps(p, _mm_castsi128_ps(i));
+}
+
+/* dst[i] = mul_to_db(src[i]) */
+static inline void audio_kernel_mul_to_db(float *dst, const float *src,
+					  size_t count)
+{
+	const __m128 scale = _mm_set1_ps(AUDIO_DB_PER_OCTAVE);
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4) {
+		__m128 v = audio_kernel_log2_ps(_mm_loadu_ps(src + i));
+		_mm_storeu_ps(dst + i, _mm_mul_ps(v, scale));
+	}
+
+	for (; i < count; i++)
+		dst[i] = audio_fast_log2f(src[i]) * AUDIO_DB_PER_OCTAVE;
+}
+
+/* dst[i] = db_to_mul(src[i]) * mul */
+static inline void audio_kernel_db_to_mul(float *dst, const float *src,
+					  float mul, size_t count)
+{
+	const __m128 scale = _mm_set1_ps(1.0f / AUDIO_DB_PER_OCTAVE);
+	const __m128 m = _mm_set1_ps(mul);
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4) {
+		__m128 v = _mm_mul_ps(_mm_loadu_ps(src + i), scale);
+		_mm_storeu_ps(dst + i, _mm_mul_ps(audio_kernel_exp2_ps(v), m));
+	}
+
+	for (; i < count; i++)
+		dst[i] = audio_fast_exp2f(src[i] / AUDIO_DB_PER_OCTAVE) * mul;
+}
+
+/* Downward compression gain for each envelope sample:
+ * gain[i] = db_to_mul(min(0, slope * (threshold_db - mul_to_db(env[i])))) *
+ *           mul */
+static inline void audio_kernel_compress_gain(float *gain, const float *env,
+					      float threshold_db, float slope,
+					      float mul, size_t count)
+{
+	const float thresh = threshold_db / AUDIO_DB_PER_OCTAVE;
+	const __m128 t = _mm_set1_ps(thresh);
+	const __m128 s = _mm_set1_ps(slope);
+	const __m128 m = _mm_set1_ps(mul);
+	const __m128 zero = _mm_setzero_ps();
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4) {
+		__m128 v = audio_kernel_log2_ps(_mm_loadu_ps(env + i));
+		v = _mm_min_ps(_mm_mul_ps(s, _mm_sub_ps(t, v)), zero);
+		_mm_storeu_ps(gain + i, _mm_mul_ps(audio_kernel_exp2_ps(v), m));
+	}
+
+	for (; i < count; i++) {
+		float v = slope * (thresh - audio_fast_log2f(env[i]));
+		gain[i] = audio_fast_exp2f(v < 0.0f ? v : 0.0f) * mul;
+	}
+}
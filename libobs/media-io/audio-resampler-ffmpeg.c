@@ -19,6 +19,7 @@
 #include "audio-resampler.h"
 #include "audio-io.h"
 #include <libavutil/avutil.h>
+#include <libavutil/opt.h>
 #include <libavformat/avformat.h>
 #include <libswresample/swresample.h>
 
@@ -93,6 +94,28 @@ static inline uint64_t convert_speaker_layout(enum speaker_layout layout)
 
 audio_resampler_t *audio_resampler_create(const struct resample_info *dst,
 					  const struct resample_info *src)
+{
+	return audio_resampler_create2(dst, src,
+				       AUDIO_RESAMPLER_QUALITY_DEFAULT);
+}
+
+static void set_quality(struct SwrContext *context,
+			enum audio_resampler_quality quality)
+{
+	if (quality != AUDIO_RESAMPLER_QUALITY_LOW_LATENCY)
+		return;
+
+	/* the default 32 tap filter delays output by roughly 16 input
+	 * frames on top of whatever the device buffers */
+	av_opt_set_int(context, "filter_size", 8, 0);
+	av_opt_set_int(context, "phase_shift", 6, 0);
+	av_opt_set_int(context, "linear_interp", 1, 0);
+}
+
+audio_resampler_t *
+audio_resampler_create2(const struct resample_info *dst,
+			const struct resample_info *src,
+			enum audio_resampler_quality quality)
 {
 	struct audio_resampler *rs = bzalloc(sizeof(struct audio_resampler));
 	int errcode;
@@ -137,6 +160,8 @@ audio_resampler_t *audio_resampler_create(const struct resample_info *dst,
 			     "swr_set_matrix failed for mono upmix\n");
 	}
 
+	set_quality(rs->context, quality);
+
 	errcode = swr_init(rs->context);
 	if (errcode != 0) {
 		blog(LOG_ERROR, "avresample_open failed: error code %d",
@@ -203,3 +228,18 @@ bool audio_resampler_resample(audio_resampler_t *rs, uint8_t *output[],
 	*out_frames = (uint32_t)ret;
 	return true;
 }
+
+bool audio_resampler_set_compensation(audio_resampler_t *rs, int sample_delta,
+				      int distance)
+{
+	if (!rs)
+		return false;
+
+	int ret = swr_set_compensation(rs->context, sample_delta, distance);
+	if (ret < 0) {
+		blog(LOG_ERROR, "swr_set_compensation failed: %d", ret);
+		return false;
+	}
+
+	return true;
+}
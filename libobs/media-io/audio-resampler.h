@@ -33,9 +33,20 @@ struct resample_info {
 	enum speaker_layout speakers;
 };
 
+enum audio_resampler_quality {
+	AUDIO_RESAMPLER_QUALITY_DEFAULT,
+	/* shorter filter, for paths such as monitoring where delay matters
+	 * more than quality */
+	AUDIO_RESAMPLER_QUALITY_LOW_LATENCY,
+};
+
 EXPORT audio_resampler_t *
 audio_resampler_create(const struct resample_info *dst,
 		       const struct resample_info *src);
+EXPORT audio_resampler_t *
+audio_resampler_create2(const struct resample_info *dst,
+			const struct resample_info *src,
+			enum audio_resampler_quality quality);
 EXPORT void audio_resampler_destroy(audio_resampler_t *resampler);
 
 EXPORT bool audio_resampler_resample(audio_resampler_t *resampler,
@@ -44,6 +55,12 @@ EXPORT bool audio_resampler_resample(audio_resampler_t *resampler,
 				     const uint8_t *const input[],
 				     uint32_t in_frames);
 
+/** Adds (or drops, if negative) sample_delta output samples spread over the
+ * next distance output samples, for slowly speeding up or slowing down
+ * audio without a change in pitch being noticeable */
+EXPORT bool audio_resampler_set_compensation(audio_resampler_t *resampler,
+					     int sample_delta, int distance);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,192 @@
+/******************************************************************************
+    Copyright (C) 2023 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+/* Kept apart from format-conversion.c, where SIMDe's SSE aliases would clash
+ * with the definitions in immintrin.h.  Only called once the CPU is known to
+ * support AVX2. */
+
+#if (defined(_M_X64) && !defined(_M_ARM64EC)) || defined(_M_IX86) || \
+	defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+#include "format-conversion-avx2.h"
+
+#ifdef _MSC_VER
+#define AVX2_FUNC
+#else
+#define AVX2_FUNC __attribute__((target("avx2")))
+#endif
+
+/* loads eight pixels and sorts them into Y, U and V in the first three
+ * qwords, leaving the last one zeroed */
+AVX2_FUNC static inline __m256i split_uyvx_avx2(const uint8_t *img)
+{
+	const __m256i shuf = _mm256_setr_epi8(
+		1, 5, 9, 13, 0, 4, 8, 12, 2, 6, 10, 14, -1, -1, -1, -1, //
+		1, 5, 9, 13, 0, 4, 8, 12, 2, 6, 10, 14, -1, -1, -1, -1);
+	const __m256i perm = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+	__m256i val = _mm256_loadu_si256((const __m256i *)img);
+	val = _mm256_shuffle_epi8(val, shuf);
+	return _mm256_permutevar8x32_epi32(val, perm);
+}
+
+AVX2_FUNC uint32_t compress_420_line_avx2(const uint8_t *img,
+					  uint32_t in_linesize, uint8_t *lum,
+					  uint32_t lum_linesize, uint8_t *u,
+					  uint8_t *v, bool nv12, uint32_t x,
+					  uint32_t width)
+{
+	const __m256i ones = _mm256_set1_epi8(1);
+
+	for (; x + 8 <= width; x += 8) {
+		const uint8_t *line = img + x * 4;
+		__m256i line1 = split_uyvx_avx2(line);
+		__m256i line2 = split_uyvx_avx2(line + in_linesize);
+
+		_mm_storel_epi64((__m128i *)(lum + x),
+				 _mm256_castsi256_si128(line1));
+		_mm_storel_epi64((__m128i *)(lum + lum_linesize + x),
+				 _mm256_castsi256_si128(line2));
+
+		/* add up horizontal pairs, then the two lines */
+		__m256i sum1 = _mm256_maddubs_epi16(line1, ones);
+		__m256i sum2 = _mm256_maddubs_epi16(line2, ones);
+		__m256i sum = _mm256_add_epi16(sum1, sum2);
+		sum = _mm256_srli_epi16(sum, 2);
+		sum = _mm256_packus_epi16(sum, sum);
+
+		__m128i ch_u = _mm_srli_si128(_mm256_castsi256_si128(sum), 4);
+		__m128i ch_v = _mm256_extracti128_si256(sum, 1);
+
+		if (nv12) {
+			_mm_storel_epi64((__m128i *)(u + x),
+					 _mm_unpacklo_epi8(ch_u, ch_v));
+		} else {
+			*(uint32_t *)(u + x / 2) = _mm_cvtsi128_si32(ch_u);
+			*(uint32_t *)(v + x / 2) = _mm_cvtsi128_si32(ch_v);
+		}
+	}
+
+	return x;
+}
+
+AVX2_FUNC uint32_t convert_444_line_avx2(const uint8_t *img,
+					 uint32_t in_linesize, uint8_t *lum,
+					 uint8_t *u, uint8_t *v,
+					 uint32_t out_linesize, uint32_t x,
+					 uint32_t width)
+{
+	for (; x + 8 <= width; x += 8) {
+		for (uint32_t i = 0; i < 2; i++) {
+			uint32_t pos = i * out_linesize + x;
+			__m256i val =
+				split_uyvx_avx2(img + i * in_linesize + x * 4);
+			__m128i lo = _mm256_castsi256_si128(val);
+
+			_mm_storel_epi64((__m128i *)(lum + pos), lo);
+			_mm_storel_epi64((__m128i *)(u + pos),
+					 _mm_unpackhi_epi64(lo, lo));
+			_mm_storel_epi64((__m128i *)(v + pos),
+					 _mm256_extracti128_si256(val, 1));
+		}
+	}
+
+	return x;
+}
+
+AVX2_FUNC uint32_t
+decompress_420_line_avx2(const uint8_t *chroma0, const uint8_t *chroma1,
+			 const uint8_t *lum0, const uint8_t *lum1,
+			 uint32_t *output0, uint32_t *output1, uint32_t x,
+			 uint32_t width_d2)
+{
+	for (; x + 4 <= width_d2; x += 4) {
+		__m128i c0 = _mm_cvtsi32_si128(*(const int *)(chroma0 + x));
+		__m128i c1 = _mm_cvtsi32_si128(*(const int *)(chroma1 + x));
+		__m128i l0 = _mm_loadl_epi64((const __m128i *)(lum0 + x * 2));
+		__m128i l1 = _mm_loadl_epi64((const __m128i *)(lum1 + x * 2));
+
+		c0 = _mm_unpacklo_epi8(c0, c0);
+		c1 = _mm_unpacklo_epi8(c1, c1);
+
+		__m256i out = _mm256_or_si256(
+			_mm256_slli_epi32(_mm256_cvtepu8_epi32(c0), 8),
+			_mm256_cvtepu8_epi32(c1));
+		__m256i out0 = _mm256_or_si256(
+			out, _mm256_slli_epi32(_mm256_cvtepu8_epi32(l0), 16));
+		__m256i out1 = _mm256_or_si256(
+			out, _mm256_slli_epi32(_mm256_cvtepu8_epi32(l1), 16));
+
+		_mm256_storeu_si256((__m256i *)(output0 + x * 2), out0);
+		_mm256_storeu_si256((__m256i *)(output1 + x * 2), out1);
+	}
+
+	return x;
+}
+
+AVX2_FUNC uint32_t
+decompress_nv12_line_avx2(const uint16_t *chroma, const uint8_t *lum0,
+			  const uint8_t *lum1, uint32_t *output0,
+			  uint32_t *output1, uint32_t x, uint32_t width_d2)
+{
+	for (; x + 4 <= width_d2; x += 4) {
+		__m128i c = _mm_loadl_epi64((const __m128i *)(chroma + x));
+		__m128i l0 = _mm_loadl_epi64((const __m128i *)(lum0 + x * 2));
+		__m128i l1 = _mm_loadl_epi64((const __m128i *)(lum1 + x * 2));
+
+		__m256i out = _mm256_cvtepu16_epi32(_mm_unpacklo_epi16(c, c));
+		out = _mm256_slli_epi32(out, 8);
+
+		_mm256_storeu_si256(
+			(__m256i *)(output0 + x * 2),
+			_mm256_or_si256(out, _mm256_cvtepu8_epi32(l0)));
+		_mm256_storeu_si256(
+			(__m256i *)(output1 + x * 2),
+			_mm256_or_si256(out, _mm256_cvtepu8_epi32(l1)));
+	}
+
+	return x;
+}
+
+AVX2_FUNC uint32_t decompress_422_line_avx2(const uint32_t *input32,
+					    uint32_t *output32,
+					    bool leading_lum, uint32_t x,
+					    uint32_t width_d2)
+{
+	const __m256i dup = _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+	const __m256i keep =
+		_mm256_set1_epi32(leading_lum ? (int)0xFFFFFF00 : 0xFFFF00FF);
+	const __m256i take =
+		_mm256_set1_epi32(leading_lum ? 0x000000FF : 0x0000FF00);
+
+	for (; x + 4 <= width_d2; x += 4) {
+		__m128i in = _mm_loadu_si128((const __m128i *)(input32 + x));
+		__m256i dw = _mm256_permutevar8x32_epi32(
+			_mm256_castsi128_si256(in), dup);
+		__m256i dw2 = _mm256_or_si256(
+			_mm256_and_si256(dw, keep),
+			_mm256_and_si256(_mm256_srli_epi32(dw, 16), take));
+
+		_mm256_storeu_si256((__m256i *)(output32 + x * 2),
+				    _mm256_blend_epi32(dw, dw2, 0xAA));
+	}
+
+	return x;
+}
+#endif
@@ -0,0 +1,51 @@
+/******************************************************************************
+    Copyright (C) 2023 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+
+#pragma once
+
+#include "../util/c99defs.h"
+
+/*
+ * AVX2 line kernels used by format-conversion.c.  Each one converts as much
+ * of the line as it can from x on and returns the x it stopped at.
+ */
+
+uint32_t compress_420_line_avx2(const uint8_t *img, uint32_t in_linesize,
+				uint8_t *lum, uint32_t lum_linesize,
+				uint8_t *u, uint8_t *v, bool nv12, uint32_t x,
+				uint32_t width);
+
+uint32_t convert_444_line_avx2(const uint8_t *img, uint32_t in_linesize,
+			       uint8_t *lum, uint8_t *u, uint8_t *v,
+			       uint32_t out_linesize, uint32_t x,
+			       uint32_t width);
+
+uint32_t decompress_420_line_avx2(const uint8_t *chroma0,
+				  const uint8_t *chroma1, const uint8_t *lum0,
+				  const uint8_t *lum1, uint32_t *output0,
+				  uint32_t *output1, uint32_t x,
+				  uint32_t width_d2);
+
+uint32_t decompress_nv12_line_avx2(const uint16_t *chroma, const uint8_t *lum0,
+				   const uint8_t *lum1, uint32_t *output0,
+				   uint32_t *output1, uint32_t x,
+				   uint32_t width_d2);
+
+uint32_t decompress_422_line_avx2(const uint32_t *input32, uint32_t *output32,
+				  bool leading_lum, uint32_t x,
+				  uint32_t width_d2);
@@ -17,8 +17,163 @@
 
 #include "format-conversion.h"
 
+#if defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define USE_NEON
+#elif (defined(_M_X64) && !defined(_M_ARM64EC)) || defined(_M_IX86) || \
+	defined(__x86_64__) || defined(__i386__)
+#include "format-conversion-avx2.h"
+#define USE_AVX2
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
 #include "../util/sse-intrin.h"
 
+/* Each kernel converts a line (or pair of lines) at a time.  The widest
+ * kernel the CPU supports goes first and returns how far it got, and the
+ * scalar version finishes off whatever is left of the line.  NEON is always
+ * available on ARM64, AVX2 is checked for at runtime. */
+
+#ifdef USE_AVX2
+static bool has_avx2(void)
+{
+	static volatile int avx2 = -1;
+
+	if (avx2 == -1) {
+#ifdef _MSC_VER
+		int info[4];
+		bool supported = false;
+
+		__cpuid(info, 0);
+		if (info[0] >= 7) {
+			__cpuid(info, 1);
+			bool osxsave = (info[2] & (1 << 27)) != 0;
+
+			__cpuidex(info, 7, 0);
+			supported = osxsave && (info[1] & (1 << 5)) != 0 &&
+				    (_xgetbv(0) & 6) == 6;
+		}
+		avx2 = supported;
+#else
+		avx2 = __builtin_cpu_supports("avx2") ? 1 : 0;
+#endif
+	}
+
+	return avx2 != 0;
+}
+#endif
+
+static FORCE_INLINE uint32_t min_uint32(uint32_t a, uint32_t b)
+{
+	return a < b ? a : b;
+}
+
+/* ------------------------------------------------------------------------- */
+/* scalar                                                                    */
+
+static void compress_420_line(const uint8_t *img, uint32_t in_linesize,
+			      uint8_t *lum, uint32_t lum_linesize, uint8_t *u,
+			      uint8_t *v, bool nv12, uint32_t x, uint32_t width)
+{
+	uint32_t uv_step = nv12 ? 2 : 1;
+
+	for (; x < width; x += 2) {
+		const uint8_t *p0 = img + x * 4;
+		const uint8_t *p1 = p0 + in_linesize;
+		uint32_t pos = x / 2 * uv_step;
+
+		lum[x] = p0[1];
+		lum[x + 1] = p0[5];
+		lum[lum_linesize + x] = p1[1];
+		lum[lum_linesize + x + 1] = p1[5];
+
+		u[pos] = (uint8_t)((p0[0] + p0[4] + p1[0] + p1[4]) >> 2);
+		v[pos] = (uint8_t)((p0[2] + p0[6] + p1[2] + p1[6]) >> 2);
+	}
+}
+
+static void convert_444_line(const uint8_t *img, uint32_t in_linesize,
+			     uint8_t *lum, uint8_t *u, uint8_t *v,
+			     uint32_t out_linesize, uint32_t x, uint32_t width)
+{
+	for (; x < width; x++) {
+		const uint8_t *p0 = img + x * 4;
+		const uint8_t *p1 = p0 + in_linesize;
+
+		lum[x] = p0[1];
+		u[x] = p0[0];
+		v[x] = p0[2];
+		lum[out_linesize + x] = p1[1];
+		u[out_linesize + x] = p1[0];
+		v[out_linesize + x] = p1[2];
+	}
+}
+
+static void decompress_420_line(const uint8_t *chroma0,
+				const uint8_t *chroma1, const uint8_t *lum0,
+				const uint8_t *lum1, uint32_t *output0,
+				uint32_t *output1, uint32_t x,
+				uint32_t width_d2)
+{
+	for (; x < width_d2; x++) {
+		uint32_t out = (chroma0[x] << 8) | chroma1[x];
+
+		output0[x * 2] = (lum0[x * 2] << 16) | out;
+		output0[x * 2 + 1] = (lum0[x * 2 + 1] << 16) | out;
+
+		output1[x * 2] = (lum1[x * 2] << 16) | out;
+		output1[x * 2 + 1] = (lum1[x * 2 + 1] << 16) | out;
+	}
+}
+
+static void decompress_nv12_line(const uint16_t *chroma, const uint8_t *lum0,
+				 const uint8_t *lum1, uint32_t *output0,
+				 uint32_t *output1, uint32_t x,
+				 uint32_t width_d2)
+{
+	for (; x < width_d2; x++) {
+		uint32_t out = chroma[x] << 8;
+
+		output0[x * 2] = lum0[x * 2] | out;
+		output0[x * 2 + 1] = lum0[x * 2 + 1] | out;
+
+		output1[x * 2] = lum1[x * 2] | out;
+		output1[x * 2 + 1] = lum1[x * 2 + 1] | out;
+	}
+}
+
+static void decompress_422_line(const uint32_t *input32, uint32_t *output32,
+				bool leading_lum, uint32_t x,
+				uint32_t width_d2)
+{
+	if (leading_lum) {
+		for (; x < width_d2; x++) {
+			register uint32_t dw = input32[x];
+
+			output32[x * 2] = dw;
+			dw &= 0xFFFFFF00;
+			dw |= (uint8_t)(dw >> 16);
+			output32[x * 2 + 1] = dw;
+		}
+	} else {
+		for (; x < width_d2; x++) {
+			register uint32_t dw = input32[x];
+
+			output32[x * 2] = dw;
+			dw &= 0xFFFF00FF;
+			dw |= (dw >> 16) & 0xFF00;
+			output32[x * 2 + 1] = dw;
+		}
+	}
+}
+
+
+#ifndef USE_NEON
+/* ------------------------------------------------------------------------- */
+/* SSE2                                                                      */
+
 /* ...surprisingly, if I don't use a macro to force inlining, it causes the
  * CPU usage to boost by a tremendous amount in debug builds. */
 
@@ -85,45 +240,246 @@
 			(uint16_t)(packed_vals >> 16);                         \
 	} while (false)
 
-static FORCE_INLINE uint32_t min_uint32(uint32_t a, uint32_t b)
+static uint32_t compress_420_line_sse2(const uint8_t *img,
+				       uint32_t in_linesize, uint8_t *lum,
+				       uint32_t lum_linesize, uint8_t *u,
+				       uint8_t *v, bool nv12, uint32_t x,
+				       uint32_t width)
 {
-	return a < b ? a : b;
+	__m128i lum_mask = _mm_set1_epi32(0x0000FF00);
+	__m128i uv_mask = _mm_set1_epi16(0x00FF);
+
+	for (; x + 4 <= width; x += 4) {
+		const uint8_t *line = img + x * 4;
+		uint32_t lum_pos0 = x;
+		uint32_t lum_pos1 = lum_pos0 + lum_linesize;
+
+		__m128i line1 = _mm_load_si128((const __m128i *)line);
+		__m128i line2 =
+			_mm_load_si128((const __m128i *)(line + in_linesize));
+
+		pack_shift(lum, lum_pos0, lum_pos1, line1, line2, lum_mask, 1);
+		if (nv12)
+			pack_ch_1plane(u, x, line1, line2, uv_mask);
+		else
+			pack_ch_2plane(u, v, (x >> 1), line1, line2, uv_mask);
+	}
+
+	return x;
+}
+
+static uint32_t convert_444_line_sse2(const uint8_t *img, uint32_t in_linesize,
+				      uint8_t *lum, uint8_t *u, uint8_t *v,
+				      uint32_t out_linesize, uint32_t x,
+				      uint32_t width)
+{
+	__m128i lum_mask = _mm_set1_epi32(0x0000FF00);
+	__m128i u_mask = _mm_set1_epi32(0x000000FF);
+	__m128i v_mask = _mm_set1_epi32(0x00FF0000);
+
+	for (; x + 4 <= width; x += 4) {
+		const uint8_t *line = img + x * 4;
+		uint32_t lum_pos0 = x;
+		uint32_t lum_pos1 = lum_pos0 + out_linesize;
+
+		__m128i line1 = _mm_load_si128((const __m128i *)line);
+		__m128i line2 =
+			_mm_load_si128((const __m128i *)(line + in_linesize));
+
+		pack_shift(lum, lum_pos0, lum_pos1, line1, line2, lum_mask, 1);
+		pack_val(u, lum_pos0, lum_pos1, line1, line2, u_mask);
+		pack_shift(v, lum_pos0, lum_pos1, line1, line2, v_mask, 2);
+	}
+
+	return x;
+}
+#endif
+
+#ifdef USE_NEON
+/* ------------------------------------------------------------------------- */
+/* NEON                                                                      */
+
+static inline uint8x16_t dup_u8_neon(uint8x8_t val)
+{
+	return vcombine_u8(vzip1_u8(val, val), vzip2_u8(val, val));
+}
+
+static uint32_t compress_420_line_neon(const uint8_t *img, uint32_t in_linesize,
+				       uint8_t *lum, uint32_t lum_linesize,
+				       uint8_t *u, uint8_t *v, bool nv12,
+				       uint32_t x, uint32_t width)
+{
+	for (; x + 16 <= width; x += 16) {
+		const uint8_t *line = img + x * 4;
+		uint8x16x4_t line1 = vld4q_u8(line);
+		uint8x16x4_t line2 = vld4q_u8(line + in_linesize);
+
+		vst1q_u8(lum + x, line1.val[1]);
+		vst1q_u8(lum + lum_linesize + x, line2.val[1]);
+
+		/* add up horizontal pairs, then the two lines */
+		uint16x8_t sum_u =
+			vpadalq_u8(vpaddlq_u8(line1.val[0]), line2.val[0]);
+		uint16x8_t sum_v =
+			vpadalq_u8(vpaddlq_u8(line1.val[2]), line2.val[2]);
+		uint8x8_t ch_u = vshrn_n_u16(sum_u, 2);
+		uint8x8_t ch_v = vshrn_n_u16(sum_v, 2);
+
+		if (nv12) {
+			uint8x8x2_t uv;
+			uv.val[0] = ch_u;
+			uv.val[1] = ch_v;
+			vst2_u8(u + x, uv);
+		} else {
+			vst1_u8(u + x / 2, ch_u);
+			vst1_u8(v + x / 2, ch_v);
+		}
+	}
+
+	return x;
+}
+
+static uint32_t convert_444_line_neon(const uint8_t *img, uint32_t in_linesize,
+				      uint8_t *lum, uint8_t *u, uint8_t *v,
+				      uint32_t out_linesize, uint32_t x,
+				      uint32_t width)
+{
+	for (; x + 16 <= width; x += 16) {
+		for (uint32_t i = 0; i < 2; i++) {
+			uint32_t pos = i * out_linesize + x;
+			uint8x16x4_t val =
+				vld4q_u8(img + i * in_linesize + x * 4);
+
+			vst1q_u8(lum + pos, val.val[1]);
+			vst1q_u8(u + pos, val.val[0]);
+			vst1q_u8(v + pos, val.val[2]);
+		}
+	}
+
+	return x;
+}
+
+static uint32_t decompress_420_line_neon(const uint8_t *chroma0,
+					 const uint8_t *chroma1,
+					 const uint8_t *lum0,
+					 const uint8_t *lum1,
+					 uint32_t *output0, uint32_t *output1,
+					 uint32_t x, uint32_t width_d2)
+{
+	uint8x16x4_t px;
+	px.val[3] = vdupq_n_u8(0);
+
+	for (; x + 8 <= width_d2; x += 8) {
+		px.val[0] = dup_u8_neon(vld1_u8(chroma1 + x));
+		px.val[1] = dup_u8_neon(vld1_u8(chroma0 + x));
+
+		px.val[2] = vld1q_u8(lum0 + x * 2);
+		vst4q_u8((uint8_t *)(output0 + x * 2), px);
+
+		px.val[2] = vld1q_u8(lum1 + x * 2);
+		vst4q_u8((uint8_t *)(output1 + x * 2), px);
+	}
+
+	return x;
+}
+
+static uint32_t decompress_nv12_line_neon(const uint16_t *chroma,
+					  const uint8_t *lum0,
+					  const uint8_t *lum1,
+					  uint32_t *output0, uint32_t *output1,
+					  uint32_t x, uint32_t width_d2)
+{
+	uint8x16x4_t px;
+	px.val[3] = vdupq_n_u8(0);
+
+	for (; x + 8 <= width_d2; x += 8) {
+		uint8x8x2_t uv = vld2_u8((const uint8_t *)(chroma + x));
+		px.val[1] = dup_u8_neon(uv.val[0]);
+		px.val[2] = dup_u8_neon(uv.val[1]);
+
+		px.val[0] = vld1q_u8(lum0 + x * 2);
+		vst4q_u8((uint8_t *)(output0 + x * 2), px);
+
+		px.val[0] = vld1q_u8(lum1 + x * 2);
+		vst4q_u8((uint8_t *)(output1 + x * 2), px);
+	}
+
+	return x;
+}
+
+static uint32_t decompress_422_line_neon(const uint32_t *input32,
+					 uint32_t *output32, bool leading_lum,
+					 uint32_t x, uint32_t width_d2)
+{
+	/* the second pixel of each pair takes the second luma sample */
+	const int lum_dst = leading_lum ? 0 : 1;
+	const int lum_src = leading_lum ? 2 : 3;
+
+	for (; x + 16 <= width_d2; x += 16) {
+		uint8x16x4_t in = vld4q_u8((const uint8_t *)(input32 + x));
+		uint8x16x4_t lo, hi;
+
+		for (int i = 0; i < 4; i++) {
+			uint8x16_t second = i == lum_dst ? in.val[lum_src]
+							 : in.val[i];
+			lo.val[i] = vzip1q_u8(in.val[i], second);
+			hi.val[i] = vzip2q_u8(in.val[i], second);
+		}
+
+		vst4q_u8((uint8_t *)(output32 + x * 2), lo);
+		vst4q_u8((uint8_t *)(output32 + x * 2 + 16), hi);
+	}
+
+	return x;
+}
+#endif
+
+/* ------------------------------------------------------------------------- */
+
+static inline uint32_t compress_420_line_simd(const uint8_t *img,
+					      uint32_t in_linesize,
+					      uint8_t *lum,
+					      uint32_t lum_linesize,
+					      uint8_t *u, uint8_t *v,
+					      bool nv12, uint32_t width)
+{
+	uint32_t x = 0;
+
+#ifdef USE_NEON
+	x = compress_420_line_neon(img, in_linesize, lum, lum_linesize, u, v,
+				   nv12, x, width);
+#else
+#ifdef USE_AVX2
+	if (has_avx2())
+		x = compress_420_line_avx2(img, in_linesize, lum, lum_linesize,
+					   u, v, nv12, x, width);
+#endif
+	x = compress_420_line_sse2(img, in_linesize, lum, lum_linesize, u, v,
+				   nv12, x, width);
+#endif
+
+	return x;
 }
 
 void compress_uyvx_to_i420(const uint8_t *input, uint32_t in_linesize,
 			   uint32_t start_y, uint32_t end_y, uint8_t *output[],
 			   const uint32_t out_linesize[])
 {
-	uint8_t *lum_plane = output[0];
-	uint8_t *u_plane = output[1];
-	uint8_t *v_plane = output[2];
 	uint32_t width = min_uint32(in_linesize, out_linesize[0]);
 	uint32_t y;
 
-	__m128i lum_mask = _mm_set1_epi32(0x0000FF00);
-	__m128i uv_mask = _mm_set1_epi16(0x00FF);
-
 	for (y = start_y; y < end_y; y += 2) {
-		uint32_t y_pos = y * in_linesize;
+		const uint8_t *img = input + y * in_linesize;
 		uint32_t chroma_y_pos = (y >> 1) * out_linesize[1];
-		uint32_t lum_y_pos = y * out_linesize[0];
-		uint32_t x;
-
-		for (x = 0; x < width; x += 4) {
-			const uint8_t *img = input + y_pos + x * 4;
-			uint32_t lum_pos0 = lum_y_pos + x;
-			uint32_t lum_pos1 = lum_pos0 + out_linesize[0];
-
-			__m128i line1 = _mm_load_si128((const __m128i *)img);
-			__m128i line2 = _mm_load_si128(
-				(const __m128i *)(img + in_linesize));
-
-			pack_shift(lum_plane, lum_pos0, lum_pos1, line1, line2,
-				   lum_mask, 1);
-			pack_ch_2plane(u_plane, v_plane,
-				       chroma_y_pos + (x >> 1), line1, line2,
-				       uv_mask);
-		}
+		uint8_t *lum = output[0] + y * out_linesize[0];
+		uint8_t *u = output[1] + chroma_y_pos;
+		uint8_t *v = output[2] + chroma_y_pos;
+
+		uint32_t x = compress_420_line_simd(img, in_linesize, lum,
+						    out_linesize[0], u, v,
+						    false, width);
+		compress_420_line(img, in_linesize, lum, out_linesize[0], u, v,
+				  false, x, width);
 	}
 }
 
@@ -131,34 +487,19 @@ void compress_uyvx_to_nv12(const uint8_t *input, uint32_t in_linesize,
 			   uint32_t start_y, uint32_t end_y, uint8_t *output[],
 			   const uint32_t out_linesize[])
 {
-	uint8_t *lum_plane = output[0];
-	uint8_t *chroma_plane = output[1];
 	uint32_t width = min_uint32(in_linesize, out_linesize[0]);
 	uint32_t y;
 
-	__m128i lum_mask = _mm_set1_epi32(0x0000FF00);
-	__m128i uv_mask = _mm_set1_epi16(0x00FF);
-
 	for (y = start_y; y < end_y; y += 2) {
-		uint32_t y_pos = y * in_linesize;
-		uint32_t chroma_y_pos = (y >> 1) * out_linesize[1];
-		uint32_t lum_y_pos = y * out_linesize[0];
-		uint32_t x;
-
-		for (x = 0; x < width; x += 4) {
-			const uint8_t *img = input + y_pos + x * 4;
-			uint32_t lum_pos0 = lum_y_pos + x;
-			uint32_t lum_pos1 = lum_pos0 + out_linesize[0];
-
-			__m128i line1 = _mm_load_si128((const __m128i *)img);
-			__m128i line2 = _mm_load_si128(
-				(const __m128i *)(img + in_linesize));
-
-			pack_shift(lum_plane, lum_pos0, lum_pos1, line1, line2,
-				   lum_mask, 1);
-			pack_ch_1plane(chroma_plane, chroma_y_pos + x, line1,
-				       line2, uv_mask);
-		}
+		const uint8_t *img = input + y * in_linesize;
+		uint8_t *lum = output[0] + y * out_linesize[0];
+		uint8_t *chroma = output[1] + (y >> 1) * out_linesize[1];
+
+		uint32_t x = compress_420_line_simd(img, in_linesize, lum,
+						    out_linesize[0], chroma,
+						    chroma + 1, true, width);
+		compress_420_line(img, in_linesize, lum, out_linesize[0],
+				  chroma, chroma + 1, true, x, width);
 	}
 }
 
@@ -166,37 +507,31 @@ void convert_uyvx_to_i444(const uint8_t *input, uint32_t in_linesize,
 			  uint32_t start_y, uint32_t end_y, uint8_t *output[],
 			  const uint32_t out_linesize[])
 {
-	uint8_t *lum_plane = output[0];
-	uint8_t *u_plane = output[1];
-	uint8_t *v_plane = output[2];
 	uint32_t width = min_uint32(in_linesize, out_linesize[0]);
 	uint32_t y;
 
-	__m128i lum_mask = _mm_set1_epi32(0x0000FF00);
-	__m128i u_mask = _mm_set1_epi32(0x000000FF);
-	__m128i v_mask = _mm_set1_epi32(0x00FF0000);
-
 	for (y = start_y; y < end_y; y += 2) {
-		uint32_t y_pos = y * in_linesize;
+		const uint8_t *img = input + y * in_linesize;
 		uint32_t lum_y_pos = y * out_linesize[0];
-		uint32_t x;
-
-		for (x = 0; x < width; x += 4) {
-			const uint8_t *img = input + y_pos + x * 4;
-			uint32_t lum_pos0 = lum_y_pos + x;
-			uint32_t lum_pos1 = lum_pos0 + out_linesize[0];
-
-			__m128i line1 = _mm_load_si128((const __m128i *)img);
-			__m128i line2 = _mm_load_si128(
-				(const __m128i *)(img + in_linesize));
-
-			pack_shift(lum_plane, lum_pos0, lum_pos1, line1, line2,
-				   lum_mask, 1);
-			pack_val(u_plane, lum_pos0, lum_pos1, line1, line2,
-				 u_mask);
-			pack_shift(v_plane, lum_pos0, lum_pos1, line1, line2,
-				   v_mask, 2);
-		}
+		uint8_t *lum = output[0] + lum_y_pos;
+		uint8_t *u = output[1] + lum_y_pos;
+		uint8_t *v = output[2] + lum_y_pos;
+		uint32_t x = 0;
+
+#ifdef USE_NEON
+		x = convert_444_line_neon(img, in_linesize, lum, u, v,
+					  out_linesize[0], x, width);
+#else
+#ifdef USE_AVX2
+		if (has_avx2())
+			x = convert_444_line_avx2(img, in_linesize, lum, u, v,
+						  out_linesize[0], x, width);
+#endif
+		x = convert_444_line_sse2(img, in_linesize, lum, u, v,
+					  out_linesize[0], x, width);
+#endif
+		convert_444_line(img, in_linesize, lum, u, v, out_linesize[0],
+				 x, width);
 	}
 }
 
@@ -212,25 +547,26 @@ void decompress_420(const uint8_t *const input[], const uint32_t in_linesize[],
 	for (y = start_y_d2; y < height_d2; y++) {
 		const uint8_t *chroma0 = input[1] + y * in_linesize[1];
 		const uint8_t *chroma1 = input[2] + y * in_linesize[2];
-		register const uint8_t *lum0, *lum1;
-		register uint32_t *output0, *output1;
-		uint32_t x;
+		const uint8_t *lum0, *lum1;
+		uint32_t *output0, *output1;
+		uint32_t x = 0;
 
 		lum0 = input[0] + y * 2 * in_linesize[0];
 		lum1 = lum0 + in_linesize[0];
 		output0 = (uint32_t *)(output + y * 2 * out_linesize);
 		output1 = (uint32_t *)((uint8_t *)output0 + out_linesize);
 
-		for (x = 0; x < width_d2; x++) {
-			uint32_t out;
-			out = (*(chroma0++) << 8) | *(chroma1++);
-
-			*(output0++) = (*(lum0++) << 16) | out;
-			*(output0++) = (*(lum0++) << 16) | out;
-
-			*(output1++) = (*(lum1++) << 16) | out;
-			*(output1++) = (*(lum1++) << 16) | out;
-		}
+#if defined(USE_NEON)
+		x = decompress_420_line_neon(chroma0, chroma1, lum0, lum1,
+					     output0, output1, x, width_d2);
+#elif defined(USE_AVX2)
+		if (has_avx2())
+			x = decompress_420_line_avx2(chroma0, chroma1, lum0,
+						     lum1, output0, output1, x,
+						     width_d2);
+#endif
+		decompress_420_line(chroma0, chroma1, lum0, lum1, output0,
+				    output1, x, width_d2);
 	}
 }
 
@@ -245,9 +581,9 @@ void decompress_nv12(const uint8_t *const input[], const uint32_t in_linesize[],
 
 	for (y = start_y_d2; y < height_d2; y++) {
 		const uint16_t *chroma;
-		register const uint8_t *lum0, *lum1;
-		register uint32_t *output0, *output1;
-		uint32_t x;
+		const uint8_t *lum0, *lum1;
+		uint32_t *output0, *output1;
+		uint32_t x = 0;
 
 		chroma = (const uint16_t *)(input[1] + y * in_linesize[1]);
 		lum0 = input[0] + y * 2 * in_linesize[0];
@@ -255,15 +591,17 @@ void decompress_nv12(const uint8_t *const input[], const uint32_t in_linesize[],
 		output0 = (uint32_t *)(output + y * 2 * out_linesize);
 		output1 = (uint32_t *)((uint8_t *)output0 + out_linesize);
 
-		for (x = 0; x < width_d2; x++) {
-			uint32_t out = *(chroma++) << 8;
-
-			*(output0++) = *(lum0++) | out;
-			*(output0++) = *(lum0++) | out;
-
-			*(output1++) = *(lum1++) | out;
-			*(output1++) = *(lum1++) | out;
-		}
+#if defined(USE_NEON)
+		x = decompress_nv12_line_neon(chroma, lum0, lum1, output0,
+					      output1, x, width_d2);
+#elif defined(USE_AVX2)
+		if (has_avx2())
+			x = decompress_nv12_line_avx2(chroma, lum0, lum1,
+						      output0, output1, x,
+						      width_d2);
+#endif
+		decompress_nv12_line(chroma, lum0, lum1, output0, output1, x,
+				     width_d2);
 	}
 }
 
@@ -274,45 +612,21 @@ void decompress_422(const uint8_t *input, uint32_t in_linesize,
 	uint32_t width_d2 = min_uint32(in_linesize, out_linesize) / 2;
 	uint32_t y;
 
-	register const uint32_t *input32;
-	register const uint32_t *input32_end;
-	register uint32_t *output32;
-
-	if (leading_lum) {
-		for (y = start_y; y < end_y; y++) {
-			input32 = (const uint32_t *)(input + y * in_linesize);
-			input32_end = input32 + width_d2;
-			output32 = (uint32_t *)(output + y * out_linesize);
-
-			while (input32 < input32_end) {
-				register uint32_t dw = *input32;
-
-				output32[0] = dw;
-				dw &= 0xFFFFFF00;
-				dw |= (uint8_t)(dw >> 16);
-				output32[1] = dw;
-
-				output32 += 2;
-				input32++;
-			}
-		}
-	} else {
-		for (y = start_y; y < end_y; y++) {
-			input32 = (const uint32_t *)(input + y * in_linesize);
-			input32_end = input32 + width_d2;
-			output32 = (uint32_t *)(output + y * out_linesize);
-
-			while (input32 < input32_end) {
-				register uint32_t dw = *input32;
-
-				output32[0] = dw;
-				dw &= 0xFFFF00FF;
-				dw |= (dw >> 16) & 0xFF00;
-				output32[1] = dw;
-
-				output32 += 2;
-				input32++;
-			}
-		}
+	for (y = start_y; y < end_y; y++) {
+		const uint32_t *input32 =
+			(const uint32_t *)(input + y * in_linesize);
+		uint32_t *output32 = (uint32_t *)(output + y * out_linesize);
+		uint32_t x = 0;
+
+#if defined(USE_NEON)
+		x = decompress_422_line_neon(input32, output32, leading_lum, x,
+					     width_d2);
+#elif defined(USE_AVX2)
+		if (has_avx2())
+			x = decompress_422_line_avx2(input32, output32,
+						     leading_lum, x, width_d2);
+#endif
+		decompress_422_line(input32, output32, leading_lum, x,
+				    width_d2);
 	}
 }
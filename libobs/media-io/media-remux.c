@@ -19,6 +19,7 @@
 
 #include "../util/base.h"
 #include "../util/bmem.h"
+#include "../util/dstr.h"
 #include "../util/platform.h"
 
 #include <libavformat/avformat.h>
@@ -34,11 +35,99 @@
 #define CODEC_FLAG_GLOBAL_H CODEC_FLAG_GLOBAL_HEADER
 #endif
 
+/* Files are read and written through our own AVIO contexts with large
+ * buffers and unbuffered stdio, so each read or write hits the disk in
+ * big chunks instead of FFmpeg's default 32 KB ones.  This matters most
+ * when several files are remuxed at once from the same drive. */
+#define REMUX_IO_BUFFER_SIZE (4 * 1024 * 1024)
+
 struct media_remux_job {
 	int64_t in_size;
 	AVFormatContext *ifmt_ctx, *ofmt_ctx;
+	FILE *in_file, *out_file;
+	AVIOContext *in_io, *out_io;
+	uint64_t start_time;
 };
 
+static int remux_read(void *opaque, uint8_t *buf, int size)
+{
+	size_t read = fread(buf, 1, size, opaque);
+	return read ? (int)read : AVERROR_EOF;
+}
+
+static int remux_write(void *opaque, uint8_t *buf, int size)
+{
+	size_t written = fwrite(buf, 1, size, opaque);
+	return written == (size_t)size ? size : AVERROR(EIO);
+}
+
+static int64_t remux_seek(void *opaque, int64_t offset, int whence)
+{
+	FILE *file = opaque;
+
+	if (whence == AVSEEK_SIZE) {
+		int64_t pos = os_ftelli64(file);
+		int64_t size;
+
+		if (os_fseeki64(file, 0, SEEK_END) != 0)
+			return -1;
+		size = os_ftelli64(file);
+		os_fseeki64(file, pos, SEEK_SET);
+		return size;
+	}
+
+	whence &= ~AVSEEK_FORCE;
+	if (os_fseeki64(file, offset, whence) != 0)
+		return -1;
+	return os_ftelli64(file);
+}
+
+static AVIOContext *open_io(FILE **file, const char *path, bool write)
+{
+	uint8_t *buf;
+	AVIOContext *io;
+
+	*file = os_fopen(path, write ? "wb" : "rb");
+	if (!*file)
+		return NULL;
+
+	setvbuf(*file, NULL, _IONBF, 0);
+
+	buf = av_malloc(REMUX_IO_BUFFER_SIZE);
+	if (!buf)
+		return NULL;
+
+	io = avio_alloc_context(buf, REMUX_IO_BUFFER_SIZE, write, *file,
+				write ? NULL : remux_read,
+				write ? remux_write : NULL, remux_seek);
+	if (!io)
+		av_free(buf);
+	return io;
+}
+
+static void close_io(FILE **file, AVIOContext **io)
+{
+	if (*io) {
+		av_freep(&(*io)->buffer);
+#if LIBAVFORMAT_VERSION_INT >= AV_VERSION_INT(57, 80, 100)
+		avio_context_free(io);
+#else
+		av_freep(io);
+#endif
+	}
+	if (*file) {
+		fclose(*file);
+		*file = NULL;
+	}
+}
+
+/* playlists reference other files, which FFmpeg has to open itself */
+static inline bool use_custom_io(const char *filename)
+{
+	const char *ext = os_get_path_extension(filename);
+	return !ext || astrcmpi(ext, ".m3u8") != 0;
+}
+
 static inline void init_size(media_remux_job_t job, const char *in_filename)
 {
 #ifdef _MSC_VER
@@ -53,7 +142,26 @@ static inline void init_size(media_remux_job_t job, const char *in_filename)
 
 static inline bool init_input(media_remux_job_t job, const char *in_filename)
 {
-	int ret = avformat_open_input(&job->ifmt_ctx, in_filename, NULL, NULL);
+	int ret;
+
+	if (use_custom_io(in_filename)) {
+		job->in_io = open_io(&job->in_file, in_filename, false);
+		if (!job->in_io) {
+			blog(LOG_ERROR,
+			     "media_remux: Could not open input file '%s'",
+			     in_filename);
+			return false;
+		}
+
+		job->ifmt_ctx = avformat_alloc_context();
+		if (!job->ifmt_ctx)
+			return false;
+
+		job->ifmt_ctx->pb = job->in_io;
+		job->ifmt_ctx->flags |= AVFMT_FLAG_CUSTOM_IO;
+	}
+
+	ret = avformat_open_input(&job->ifmt_ctx, in_filename, NULL, NULL);
 	if (ret < 0) {
 		blog(LOG_ERROR, "media_remux: Could not open input file '%s'",
 		     in_filename);
@@ -163,15 +271,17 @@ static inline bool init_output(media_remux_job_t job, const char *out_filename)
 #endif
 
 	if (!(job->ofmt_ctx->oformat->flags & AVFMT_NOFILE)) {
-		ret = avio_open(&job->ofmt_ctx->pb, out_filename,
-				AVIO_FLAG_WRITE);
-		if (ret < 0) {
+		job->out_io = open_io(&job->out_file, out_filename, true);
+		if (!job->out_io) {
 			blog(LOG_ERROR,
 			     "media_remux: Failed to open output"
 			     " file '%s'",
 			     out_filename);
 			return false;
 		}
+
+		job->ofmt_ctx->pb = job->out_io;
+		job->ofmt_ctx->flags |= AVFMT_FLAG_CUSTOM_IO;
 	}
 
 	return true;
@@ -293,6 +403,7 @@ bool media_remux_job_process(media_remux_job_t job,
 	if (callback != NULL)
 		callback(data, 0.f);
 
+	job->start_time = os_gettime_ns();
 	ret = process_packets(job, callback, data);
 	success = ret >= 0 || ret == AVERROR_EOF;
 
@@ -306,6 +417,16 @@ bool media_remux_job_process(media_remux_job_t job,
 	if (callback != NULL)
 		callback(data, 100.f);
 
+	if (success) {
+		double seconds =
+			(double)(os_gettime_ns() - job->start_time) / 1e9;
+		double mb = (double)job->in_size / (1024.0 * 1024.0);
+
+		blog(LOG_INFO,
+		     "media_remux: Remuxed %.1f MB in %.2f s (%.1f MB/s)", mb,
+		     seconds, seconds > 0.0 ? mb / seconds : 0.0);
+	}
+
 	return success;
 }
 
@@ -315,11 +436,10 @@ void media_remux_job_destroy(media_remux_job_t job)
 		return;
 
 	avformat_close_input(&job->ifmt_ctx);
-
-	if (job->ofmt_ctx && !(job->ofmt_ctx->oformat->flags & AVFMT_NOFILE))
-		avio_close(job->ofmt_ctx->pb);
+	close_io(&job->in_file, &job->in_io);
 
 	avformat_free_context(job->ofmt_ctx);
+	close_io(&job->out_file, &job->out_io);
 
 	bfree(job);
 }
@@ -0,0 +1,297 @@
+/******************************************************************************
+    Copyright (C) 2023 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include <string.h>
+
+#include "../util/darray.h"
+#include "../util/platform.h"
+#include "../util/threading.h"
+#include "../util/sse-intrin.h"
+#include "video-copy.h"
+
+/* a 4K NV12 frame is about 12MB, 1080p about 3MB */
+#define LARGE_COPY_SIZE (6 * 1024 * 1024)
+#define BAND_SIZE (1024 * 1024)
+
+/* copies are limited by memory bandwidth, more threads don't help much */
+#define MAX_COPY_THREADS 3
+
+struct copy_job {
+	volatile long remaining;
+	os_event_t *done;
+};
+
+struct copy_band {
+	struct copy_job *job;
+	uint8_t *dst;
+	const uint8_t *src;
+	uint32_t dst_linesize;
+	uint32_t src_linesize;
+	uint32_t bytes;
+	uint32_t lines;
+};
+
+static pthread_mutex_t copy_mutex = PTHREAD_MUTEX_INITIALIZER;
+static DARRAY(struct copy_band) copy_bands;
+static DARRAY(pthread_t) copy_threads;
+static os_sem_t *copy_semaphore;
+static volatile bool copy_stop;
+static bool copy_threads_failed;
+
+static void copy_stream(uint8_t *dst, const uint8_t *src, size_t size)
+{
+	size_t head = (16 - ((uintptr_t)dst & 15)) & 15;
+	if (head > size)
+		head = size;
+
+	memcpy(dst, src, head);
+	dst += head;
+	src += head;
+	size -= head;
+
+	for (; size >= 64; size -= 64, dst += 64, src += 64) {
+		__m128i a = _mm_loadu_si128((const __m128i *)src);
+		__m128i b = _mm_loadu_si128((const __m128i *)(src + 16));
+		__m128i c = _mm_loadu_si128((const __m128i *)(src + 32));
+		__m128i d = _mm_loadu_si128((const __m128i *)(src + 48));
+		_mm_stream_si128((__m128i *)dst, a);
+		_mm_stream_si128((__m128i *)(dst + 16), b);
+		_mm_stream_si128((__m128i *)(dst + 32), c);
+		_mm_stream_si128((__m128i *)(dst + 48), d);
+	}
+
+	memcpy(dst, src, size);
+}
+
+static void copy_band(const struct copy_band *band, bool stream)
+{
+	if (band->dst_linesize == band->src_linesize) {
+		size_t size = (size_t)band->dst_linesize * band->lines;
+
+		if (stream)
+			copy_stream(band->dst, band->src, size);
+		else
+			memcpy(band->dst, band->src, size);
+
+	} else {
+		for (uint32_t y = 0; y < band->lines; y++) {
+			size_t dst_pos = (size_t)y * band->dst_linesize;
+			size_t src_pos = (size_t)y * band->src_linesize;
+			uint8_t *dst = band->dst + dst_pos;
+			const uint8_t *src = band->src + src_pos;
+
+			if (stream)
+				copy_stream(dst, src, band->bytes);
+			else
+				memcpy(dst, src, band->bytes);
+		}
+	}
+
+	if (stream)
+		_mm_sfence();
+}
+
+static void run_copy_bands(void)
+{
+	for (;;) {
+		struct copy_band band;
+
+		pthread_mutex_lock(&copy_mutex);
+		if (!copy_bands.num) {
+			pthread_mutex_unlock(&copy_mutex);
+			break;
+		}
+		band = copy_bands.array[copy_bands.num - 1];
+		da_pop_back(copy_bands);
+		pthread_mutex_unlock(&copy_mutex);
+
+		copy_band(&band, true);
+
+		if (os_atomic_dec_long(&band.job->remaining) == 0)
+			os_event_signal(band.job->done);
+	}
+}
+
+static void *copy_thread(void *unused)
+{
+	os_set_thread_name("video copy thread");
+
+	while (os_sem_wait(copy_semaphore) == 0) {
+		if (os_atomic_load_bool(&copy_stop))
+			break;
+
+		run_copy_bands();
+	}
+
+	UNUSED_PARAMETER(unused);
+	return NULL;
+}
+
+/* called with copy_mutex held */
+static bool init_copy_threads(void)
+{
+	int num;
+
+	if (copy_threads.num)
+		return true;
+	if (copy_threads_failed)
+		return false;
+
+	num = os_get_logical_cores() - 1;
+	if (num > MAX_COPY_THREADS)
+		num = MAX_COPY_THREADS;
+
+	copy_threads_failed = true;
+	if (num < 1)
+		return false;
+	if (os_sem_init(&copy_semaphore, 0) != 0)
+		return false;
+
+	copy_stop = false;
+
+	for (int i = 0; i < num; i++) {
+		pthread_t thread;
+		if (pthread_create(&thread, NULL, copy_thread, NULL) != 0)
+			break;
+		da_push_back(copy_threads, &thread);
+	}
+
+	copy_threads_failed = !copy_threads.num;
+	return !!copy_threads.num;
+}
+
+static inline uint32_t min_uint32(uint32_t a, uint32_t b)
+{
+	return a < b ? a : b;
+}
+
+static bool copy_parallel(const struct video_copy_plane *planes, size_t num)
+{
+	struct copy_job job = {0};
+	size_t bands = 0;
+	size_t wake;
+
+	if (os_event_init(&job.done, OS_EVENT_TYPE_MANUAL) != 0)
+		return false;
+
+	pthread_mutex_lock(&copy_mutex);
+
+	if (!init_copy_threads()) {
+		pthread_mutex_unlock(&copy_mutex);
+		os_event_destroy(job.done);
+		return false;
+	}
+
+	for (size_t i = 0; i < num; i++) {
+		const struct video_copy_plane *plane = planes + i;
+		uint32_t bytes = min_uint32(plane->dst_linesize,
+					    plane->src_linesize);
+		uint32_t band_lines;
+
+		if (!plane->dst || !plane->src || !bytes)
+			continue;
+
+		band_lines = BAND_SIZE / plane->dst_linesize;
+		if (!band_lines)
+			band_lines = 1;
+
+		for (uint32_t y = 0; y < plane->lines; y += band_lines) {
+			size_t dst_pos = (size_t)y * plane->dst_linesize;
+			size_t src_pos = (size_t)y * plane->src_linesize;
+
+			struct copy_band *band = da_push_back_new(copy_bands);
+			band->job = &job;
+			band->dst = plane->dst + dst_pos;
+			band->src = plane->src + src_pos;
+			band->dst_linesize = plane->dst_linesize;
+			band->src_linesize = plane->src_linesize;
+			band->bytes = bytes;
+			band->lines = min_uint32(band_lines, plane->lines - y);
+			bands++;
+		}
+	}
+
+	os_atomic_set_long(&job.remaining, (long)bands);
+	wake = bands ? bands - 1 : 0;
+	if (wake > copy_threads.num)
+		wake = copy_threads.num;
+
+	pthread_mutex_unlock(&copy_mutex);
+
+	for (size_t i = 0; i < wake; i++)
+		os_sem_post(copy_semaphore);
+
+	/* help out rather than just waiting, this may also run bands of
+	 * other copies that are in flight at the same time */
+	run_copy_bands();
+	if (bands)
+		os_event_wait(job.done);
+
+	os_event_destroy(job.done);
+	return true;
+}
+
+void video_copy_planes(const struct video_copy_plane *planes, size_t num)
+{
+	size_t total = 0;
+
+	for (size_t i = 0; i < num; i++)
+		total += (size_t)planes[i].dst_linesize * planes[i].lines;
+
+	if (total >= LARGE_COPY_SIZE && copy_parallel(planes, num))
+		return;
+
+	for (size_t i = 0; i < num; i++) {
+		const struct video_copy_plane *plane = planes + i;
+		struct copy_band band = {
+			.dst = plane->dst,
+			.src = plane->src,
+			.dst_linesize = plane->dst_linesize,
+			.src_linesize = plane->src_linesize,
+			.bytes = min_uint32(plane->dst_linesize,
+					    plane->src_linesize),
+			.lines = plane->lines,
+		};
+
+		if (band.dst && band.src && band.bytes)
+			copy_band(&band, total >= LARGE_COPY_SIZE);
+	}
+}
+
+void video_copy_free(void)
+{
+	/* the threads take the mutex to look for work, so they're joined
+	 * without holding it */
+	os_atomic_set_bool(&copy_stop, true);
+	for (size_t i = 0; i < copy_threads.num; i++)
+		os_sem_post(copy_semaphore);
+	for (size_t i = 0; i < copy_threads.num; i++)
+		pthread_join(copy_threads.array[i], NULL);
+
+	pthread_mutex_lock(&copy_mutex);
+
+	da_free(copy_threads);
+	da_free(copy_bands);
+
+	if (copy_semaphore) {
+		os_sem_destroy(copy_semaphore);
+		copy_semaphore = NULL;
+	}
+
+	copy_threads_failed = false;
+	pthread_mutex_unlock(&copy_mutex);
+}
@@ -0,0 +1,52 @@
+/******************************************************************************
+    Copyright (C) 2023 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+#include "../util/c99defs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Copies the planes of large video frames.  Big copies are split into bands
+ * of lines that are spread over a few worker threads, and written with
+ * non-temporal stores so a frame that's about to be uploaded doesn't push
+ * everything else out of the cache.  Small copies are just done in place.
+ */
+
+struct video_copy_plane {
+	uint8_t *dst;
+	const uint8_t *src;
+	uint32_t dst_linesize;
+	uint32_t src_linesize;
+	uint32_t lines;
+};
+
+/* copies each plane, the smaller of the two line sizes per line.  planes
+ * with a NULL source or destination are skipped */
+EXPORT void video_copy_planes(const struct video_copy_plane *planes,
+			      size_t num);
+
+/* stops the worker threads, no copies may be in progress.  the threads are
+ * started again by the next large copy */
+EXPORT void video_copy_free(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -16,6 +16,7 @@
 ******************************************************************************/
 
 #include "video-frame.h"
+#include "video-copy.h"
 
 #define ALIGN_SIZE(size, align) size = (((size) + (align - 1)) & (~(align - 1)))
 
@@ -306,24 +307,39 @@ void video_frame_init(struct video_frame *frame, enum video_format format,
 	}
 }
 
+/* the destination is assumed to have the same line sizes as the source */
+static inline void copy_plane(struct video_copy_plane *planes,
+			      struct video_frame *dst,
+			      const struct video_frame *src, int plane,
+			      uint32_t lines)
+{
+	planes[plane].dst = dst->data[plane];
+	planes[plane].src = src->data[plane];
+	planes[plane].dst_linesize = src->linesize[plane];
+	planes[plane].src_linesize = src->linesize[plane];
+	planes[plane].lines = lines;
+}
+
 void video_frame_copy(struct video_frame *dst, const struct video_frame *src,
 		      enum video_format format, uint32_t cy)
 {
+	struct video_copy_plane planes[MAX_AV_PLANES] = {0};
+
 	switch (format) {
 	case VIDEO_FORMAT_NONE:
 		return;
 
 	case VIDEO_FORMAT_I420:
 	case VIDEO_FORMAT_I010:
-		memcpy(dst->data[0], src->data[0], src->linesize[0] * cy);
-		memcpy(dst->data[1], src->data[1], src->linesize[1] * cy / 2);
-		memcpy(dst->data[2], src->data[2], src->linesize[2] * cy / 2);
+		copy_plane(planes, dst, src, 0, cy);
+		copy_plane(planes, dst, src, 1, cy / 2);
+		copy_plane(planes, dst, src, 2, cy / 2);
 		break;
 
 	case VIDEO_FORMAT_NV12:
 	case VIDEO_FORMAT_P010:
-		memcpy(dst->data[0], src->data[0], src->linesize[0] * cy);
-		memcpy(dst->data[1], src->data[1], src->linesize[1] * cy / 2);
+		copy_plane(planes, dst, src, 0, cy);
+		copy_plane(planes, dst, src, 1, cy / 2);
 		break;
 
 	case VIDEO_FORMAT_Y800:
@@ -335,32 +351,34 @@ void video_frame_copy(struct video_frame *dst, const struct video_frame *src,
 	case VIDEO_FORMAT_BGRX:
 	case VIDEO_FORMAT_BGR3:
 	case VIDEO_FORMAT_AYUV:
-		memcpy(dst->data[0], src->data[0], src->linesize[0] * cy);
+		copy_plane(planes, dst, src, 0, cy);
 		break;
 
 	case VIDEO_FORMAT_I444:
 	case VIDEO_FORMAT_I422:
 	case VIDEO_FORMAT_I210:
 	case VIDEO_FORMAT_I412:
-		memcpy(dst->data[0], src->data[0], src->linesize[0] * cy);
-		memcpy(dst->data[1], src->data[1], src->linesize[1] * cy);
-		memcpy(dst->data[2], src->data[2], src->linesize[2] * cy);
+		copy_plane(planes, dst, src, 0, cy);
+		copy_plane(planes, dst, src, 1, cy);
+		copy_plane(planes, dst, src, 2, cy);
 		break;
 
 	case VIDEO_FORMAT_I40A:
-		memcpy(dst->data[0], src->data[0], src->linesize[0] * cy);
-		memcpy(dst->data[1], src->data[1], src->linesize[1] * cy / 2);
-		memcpy(dst->data[2], src->data[2], src->linesize[2] * cy / 2);
-		memcpy(dst->data[3], src->data[3], src->linesize[3] * cy);
+		copy_plane(planes, dst, src, 0, cy);
+		copy_plane(planes, dst, src, 1, cy / 2);
+		copy_plane(planes, dst, src, 2, cy / 2);
+		copy_plane(planes, dst, src, 3, cy);
 		break;
 
 	case VIDEO_FORMAT_I42A:
 	case VIDEO_FORMAT_YUVA:
 	case VIDEO_FORMAT_YA2L:
-		memcpy(dst->data[0], src->data[0], src->linesize[0] * cy);
-		memcpy(dst->data[1], src->data[1], src->linesize[1] * cy);
-		memcpy(dst->data[2], src->data[2], src->linesize[2] * cy);
-		memcpy(dst->data[3], src->data[3], src->linesize[3] * cy);
+		copy_plane(planes, dst, src, 0, cy);
+		copy_plane(planes, dst, src, 1, cy);
+		copy_plane(planes, dst, src, 2, cy);
+		copy_plane(planes, dst, src, 3, cy);
 		break;
 	}
+
+	video_copy_planes(planes, MAX_AV_PLANES);
 }
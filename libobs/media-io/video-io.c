@@ -33,12 +33,27 @@
 extern profiler_name_store_t *obs_get_profiler_name_store(void);
 
 #define MAX_CONVERT_BUFFERS 3
-#define MAX_CACHE_SIZE 16
+#define MAX_CACHE_SIZE 64
+#define MAX_CACHE_MEMORY (512ULL * 1024 * 1024)
+
+/* number of frames the cache has to stay at most half full for before a
+ * frame is freed again */
+#define CACHE_SHRINK_FRAMES 300
 
 struct cached_frame_info {
 	struct video_data frame;
 	int skipped;
 	int count;
+
+	/* set when the planes are borrowed from the caller instead of being
+	 * copied into the cached frame, see video_output_lock_external_frame */
+	uint8_t *external_data[MAX_AV_PLANES];
+	uint32_t external_linesize[MAX_AV_PLANES];
+	void (*release)(void *param);
+	void *release_param;
+
+	/* whether the frame has been compared against the previous one */
+	bool static_checked;
 };
 
 struct video_input {
@@ -46,6 +61,7 @@ struct video_input {
 	video_scaler_t *scaler;
 	struct video_frame frame[MAX_CONVERT_BUFFERS];
 	int cur_frame;
+	bool scaled;
 
 	void (*callback)(void *param, struct video_data *frame);
 	void *param;
@@ -78,22 +94,99 @@ struct video_output {
 	size_t available_frames;
 	size_t first_added;
 	size_t last_added;
-	struct cached_frame_info cache[MAX_CACHE_SIZE];
+	struct cached_frame_info *cache[MAX_CACHE_SIZE];
+
+	/* cache_depth is the number of frames currently allocated, the rest
+	 * are only touched with data_mutex held */
+	size_t cache_depth;
+	size_t max_cache_depth;
+	size_t memory_cache_depth;
+	size_t peak_queued;
+	uint32_t underused_frames;
+	uint32_t lag_skipped_frames;
+	uint32_t memory_skipped_frames;
+	volatile long texture_skipped_frames;
 
 	volatile bool raw_active;
 	volatile long gpu_refs;
+
+	/* frames are hashed to detect unchanged ones while any input wants
+	 * VIDEO_FRAME_STATIC, see video_output_inc_static_detection */
+	volatile long static_refs;
+	uint64_t last_hash;
+	bool have_last_hash;
 };
 
 /* ------------------------------------------------------------------------- */
 
-static inline bool scale_video_output(struct video_input *input,
+static inline void release_external_frame(struct cached_frame_info *cfi)
+{
+	if (cfi->release) {
+		void (*release)(void *param) = cfi->release;
+		cfi->release = NULL;
+		release(cfi->release_param);
+	}
+}
+
+static void release_external_frames(struct video_output *video)
+{
+	pthread_mutex_lock(&video->data_mutex);
+	for (size_t i = 0; i < video->cache_depth; i++)
+		release_external_frame(video->cache[i]);
+	pthread_mutex_unlock(&video->data_mutex);
+}
+
+static inline bool same_conversion(const struct video_scale_info *a,
+				   const struct video_scale_info *b)
+{
+	return a->width == b->width && a->height == b->height &&
+	       a->format == b->format && a->range == b->range &&
+	       a->colorspace == b->colorspace;
+}
+
+/* inputs that request the same conversion share the frame scaled by the
+ * first of them instead of each doing their own scale pass */
+static const struct video_input *find_scaled_input(struct video_output *video,
+						   size_t idx)
+{
+	const struct video_input *input = video->inputs.array + idx;
+
+	for (size_t i = 0; i < idx; i++) {
+		const struct video_input *other = video->inputs.array + i;
+		if (other->scaled &&
+		    same_conversion(&other->conversion, &input->conversion))
+			return other;
+	}
+
+	return NULL;
+}
+
+static inline void set_scaled_data(struct video_data *data,
+				   const struct video_frame *frame)
+{
+	for (size_t i = 0; i < MAX_AV_PLANES; i++) {
+		data->data[i] = frame->data[i];
+		data->linesize[i] = frame->linesize[i];
+	}
+}
+
+static inline bool scale_video_output(struct video_output *video, size_t idx,
 				      struct video_data *data)
 {
+	struct video_input *input = video->inputs.array + idx;
 	bool success = true;
 
+	input->scaled = false;
+
 	if (input->scaler) {
+		const struct video_input *shared = find_scaled_input(video, idx);
 		struct video_frame *frame;
 
+		if (shared) {
+			set_scaled_data(data, &shared->frame[shared->cur_frame]);
+			return true;
+		}
+
 		if (++input->cur_frame == MAX_CONVERT_BUFFERS)
 			input->cur_frame = 0;
 
@@ -105,10 +198,8 @@ static inline bool scale_video_output(struct video_input *input,
 					     data->linesize);
 
 		if (success) {
-			for (size_t i = 0; i < MAX_AV_PLANES; i++) {
-				data->data[i] = frame->data[i];
-				data->linesize[i] = frame->linesize[i];
-			}
+			set_scaled_data(data, frame);
+			input->scaled = true;
 		} else {
 			blog(LOG_WARNING, "video-io: Could not scale frame!");
 		}
@@ -117,6 +208,198 @@ static inline bool scale_video_output(struct video_input *input,
 	return success;
 }
 
+/* rows in each plane of the formats that static detection handles */
+static bool get_plane_rows(const struct video_output_info *info,
+			   uint32_t rows[MAX_AV_PLANES])
+{
+	const uint32_t half_height = (info->height + 1) / 2;
+
+	memset(rows, 0, sizeof(uint32_t) * MAX_AV_PLANES);
+
+	switch (info->format) {
+	case VIDEO_FORMAT_I420:
+	case VIDEO_FORMAT_I010:
+		rows[0] = info->height;
+		rows[1] = half_height;
+		rows[2] = half_height;
+		return true;
+	case VIDEO_FORMAT_NV12:
+	case VIDEO_FORMAT_P010:
+		rows[0] = info->height;
+		rows[1] = half_height;
+		return true;
+	case VIDEO_FORMAT_I444:
+		rows[0] = info->height;
+		rows[1] = info->height;
+		rows[2] = info->height;
+		return true;
+	case VIDEO_FORMAT_RGBA:
+	case VIDEO_FORMAT_BGRA:
+	case VIDEO_FORMAT_BGRX:
+		rows[0] = info->height;
+		return true;
+	default:
+		return false;
+	}
+}
+
+static inline uint64_t hash_mix64(uint64_t h)
+{
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	return h;
+}
+
+/* every step is invertible, so changing any single word always changes the
+ * hash.  whole linesizes are hashed, padding included, which can only ever
+ * make a static frame look changed and not the other way around. */
+static uint64_t hash_plane(uint64_t seed, const uint8_t *data, size_t size)
+{
+	const uint64_t prime = 0x100000001b3ULL;
+	uint64_t h[4] = {seed, seed ^ 1, seed ^ 2, seed ^ 3};
+	size_t i = 0;
+
+	for (; i + 32 <= size; i += 32) {
+		uint64_t w[4];
+		memcpy(w, data + i, sizeof(w));
+		h[0] = (h[0] ^ w[0]) * prime;
+		h[1] = (h[1] ^ w[1]) * prime;
+		h[2] = (h[2] ^ w[2]) * prime;
+		h[3] = (h[3] ^ w[3]) * prime;
+	}
+
+	for (; i < size; i++)
+		h[0] = (h[0] ^ data[i]) * prime;
+
+	return hash_mix64(h[0]) ^ hash_mix64(h[1] + 1) ^
+	       hash_mix64(h[2] + 2) ^ hash_mix64(h[3] + 3);
+}
+
+static void check_static_frame(struct video_output *video,
+			       struct video_data *frame)
+{
+	uint32_t rows[MAX_AV_PLANES];
+	uint64_t hash = 0xcbf29ce484222325ULL;
+
+	if (!get_plane_rows(&video->info, rows)) {
+		video->have_last_hash = false;
+		return;
+	}
+
+	for (size_t i = 0; i < MAX_AV_PLANES && frame->data[i]; i++)
+		hash = hash_plane(hash, frame->data[i],
+				  (size_t)frame->linesize[i] * rows[i]);
+
+	if (video->have_last_hash && hash == video->last_hash)
+		frame->flags |= VIDEO_FRAME_STATIC;
+
+	video->last_hash = hash;
+	video->have_last_hash = true;
+}
+
+static struct cached_frame_info *
+create_cached_frame(const struct video_output *video)
+{
+	struct cached_frame_info *cfi = bzalloc(sizeof(*cfi));
+
+	video_frame_init((struct video_frame *)&cfi->frame, video->info.format,
+			 video->info.width, video->info.height);
+	return cfi;
+}
+
+static void destroy_cached_frame(struct cached_frame_info *cfi)
+{
+	video_frame_free((struct video_frame *)&cfi->frame);
+	bfree(cfi);
+}
+
+/* only called with every frame in use, in which case the newest frame is
+ * right before the oldest one, so the new frame goes in between them */
+static bool grow_cache(struct video_output *video)
+{
+	size_t pos = video->last_added + 1;
+
+	if (video->cache_depth >= video->max_cache_depth ||
+	    video->cache_depth >= video->memory_cache_depth)
+		return false;
+
+	memmove(&video->cache[pos + 1], &video->cache[pos],
+		(video->cache_depth - pos) * sizeof(video->cache[0]));
+	video->cache[pos] = create_cached_frame(video);
+
+	if (video->first_added >= pos)
+		video->first_added++;
+
+	video->cache_depth++;
+	video->available_frames++;
+	video->underused_frames = 0;
+	return true;
+}
+
+/* the frame after the newest one is free whenever two or more are available,
+ * even if the graphics thread is in the middle of filling in a frame */
+static void shrink_cache(struct video_output *video)
+{
+	size_t queued = video->cache_depth - video->available_frames;
+	size_t pos;
+
+	if (video->cache_depth <= video->info.cache_size)
+		return;
+
+	if (queued * 2 > video->cache_depth) {
+		video->underused_frames = 0;
+		return;
+	}
+
+	if (++video->underused_frames < CACHE_SHRINK_FRAMES ||
+	    video->available_frames < 2)
+		return;
+
+	pos = (video->last_added + 1) % video->cache_depth;
+	destroy_cached_frame(video->cache[pos]);
+	memmove(&video->cache[pos], &video->cache[pos + 1],
+		(video->cache_depth - pos - 1) * sizeof(video->cache[0]));
+
+	if (video->first_added > pos)
+		video->first_added--;
+	if (video->last_added > pos)
+		video->last_added--;
+
+	video->cache_depth--;
+	video->available_frames--;
+	video->underused_frames = 0;
+}
+
+/* when there's no free frame and the cache can't grow, the newest frame is
+ * repeated instead */
+static bool reserve_frame(struct video_output *video, int count)
+{
+	struct cached_frame_info *cfi;
+
+	if (video->available_frames || grow_cache(video))
+		return true;
+
+	cfi = video->cache[video->last_added];
+	cfi->count += count;
+	cfi->skipped += count;
+
+	if (video->cache_depth < video->max_cache_depth)
+		video->memory_skipped_frames += count;
+	else
+		video->lag_skipped_frames += count;
+	return false;
+}
+
+static inline void update_peak_queued(struct video_output *video)
+{
+	size_t queued = video->cache_depth - video->available_frames;
+	if (queued > video->peak_queued)
+		video->peak_queued = queued;
+}
+
 static inline bool video_output_cur_frame(struct video_output *video)
 {
 	struct cached_frame_info *frame_info;
@@ -127,19 +410,38 @@ static inline bool video_output_cur_frame(struct video_output *video)
 
 	pthread_mutex_lock(&video->data_mutex);
 
-	frame_info = &video->cache[video->first_added];
+	frame_info = video->cache[video->first_added];
 
 	pthread_mutex_unlock(&video->data_mutex);
 
 	/* -------------------------------- */
 
+	struct video_data base = frame_info->frame;
+
+	if (frame_info->release) {
+		memcpy(base.data, frame_info->external_data, sizeof(base.data));
+		memcpy(base.linesize, frame_info->external_linesize,
+		       sizeof(base.linesize));
+	}
+
+	if (!frame_info->static_checked) {
+		frame_info->static_checked = true;
+
+		if (os_atomic_load_long(&video->static_refs)) {
+			check_static_frame(video, &base);
+			frame_info->frame.flags = base.flags;
+		} else {
+			video->have_last_hash = false;
+		}
+	}
+
 	pthread_mutex_lock(&video->input_mutex);
 
 	for (size_t i = 0; i < video->inputs.num; i++) {
 		struct video_input *input = video->inputs.array + i;
-		struct video_data frame = frame_info->frame;
+		struct video_data frame = base;
 
-		if (scale_video_output(input, &frame))
+		if (scale_video_output(video, i, &frame))
 			input->callback(input->param, &frame);
 	}
 
@@ -151,14 +453,22 @@ static inline bool video_output_cur_frame(struct video_output *video)
 
 	frame_info->frame.timestamp += video->frame_time;
 	complete = --frame_info->count == 0;
+
+	/* any repeats of this frame are the same picture again */
+	frame_info->frame.flags &= ~VIDEO_FRAME_SCENE_CUT;
+	frame_info->frame.flags |= VIDEO_FRAME_STATIC;
 	skipped = frame_info->skipped > 0;
 
 	if (complete) {
-		if (++video->first_added == video->info.cache_size)
+		release_external_frame(frame_info);
+
+		if (++video->first_added == video->cache_depth)
 			video->first_added = 0;
 
-		if (++video->available_frames == video->info.cache_size)
+		if (++video->available_frames == video->cache_depth)
 			video->last_added = video->first_added;
+
+		shrink_cache(video);
 	} else if (skipped) {
 		--frame_info->skipped;
 		os_atomic_inc_long(&video->skipped_frames);
@@ -174,6 +484,7 @@ static inline bool video_output_cur_frame(struct video_output *video)
 static void *video_thread(void *param)
 {
 	struct video_output *video = param;
+	os_thread_role_t *role = os_set_thread_role(OS_THREAD_ROLE_ENCODE);
 
 	os_set_thread_name("video-io: video thread");
 
@@ -196,6 +507,7 @@ static void *video_thread(void *param)
 		profile_reenable_thread();
 	}
 
+	os_reset_thread_role(role);
 	return NULL;
 }
 
@@ -207,20 +519,42 @@ static inline bool valid_video_params(const struct video_output_info *info)
 	       info->fps_num != 0;
 }
 
+/* an upper bound, chroma planes are counted at full height */
+static size_t cached_frame_size(const struct video_output *video)
+{
+	const struct video_data *frame = &video->cache[0]->frame;
+	size_t size = 0;
+
+	for (size_t i = 0; i < MAX_AV_PLANES; i++)
+		size += (size_t)frame->linesize[i] * video->info.height;
+	return size;
+}
+
 static inline void init_cache(struct video_output *video)
 {
+	size_t max_size = video->info.max_cache_size;
+	size_t frame_size;
+
 	if (video->info.cache_size > MAX_CACHE_SIZE)
 		video->info.cache_size = MAX_CACHE_SIZE;
 
-	for (size_t i = 0; i < video->info.cache_size; i++) {
-		struct video_frame *frame;
-		frame = (struct video_frame *)&video->cache[i];
-
-		video_frame_init(frame, video->info.format, video->info.width,
-				 video->info.height);
-	}
+	for (size_t i = 0; i < video->info.cache_size; i++)
+		video->cache[i] = create_cached_frame(video);
 
+	video->cache_depth = video->info.cache_size;
 	video->available_frames = video->info.cache_size;
+
+	if (max_size > MAX_CACHE_SIZE)
+		max_size = MAX_CACHE_SIZE;
+	if (max_size < video->info.cache_size)
+		max_size = video->info.cache_size;
+	video->max_cache_depth = max_size;
+
+	frame_size = video->cache_depth ? cached_frame_size(video) : 0;
+	video->memory_cache_depth =
+		frame_size ? (size_t)(MAX_CACHE_MEMORY / frame_size) : max_size;
+	if (video->memory_cache_depth < video->info.cache_size)
+		video->memory_cache_depth = video->info.cache_size;
 }
 
 int video_output_open(video_t **video, struct video_output_info *info)
@@ -276,8 +610,8 @@ void video_output_close(video_t *video)
 		video_input_free(&video->inputs.array[i]);
 	da_free(video->inputs);
 
-	for (size_t i = 0; i < video->info.cache_size; i++)
-		video_frame_free((struct video_frame *)&video->cache[i]);
+	for (size_t i = 0; i < video->cache_depth; i++)
+		destroy_cached_frame(video->cache[i]);
 
 	bfree(video);
 }
@@ -365,6 +699,13 @@ static inline void reset_frames(video_t *video)
 {
 	os_atomic_set_long(&video->skipped_frames, 0);
 	os_atomic_set_long(&video->total_frames, 0);
+	os_atomic_set_long(&video->texture_skipped_frames, 0);
+
+	pthread_mutex_lock(&video->data_mutex);
+	video->lag_skipped_frames = 0;
+	video->memory_skipped_frames = 0;
+	video->peak_queued = 0;
+	pthread_mutex_unlock(&video->data_mutex);
 }
 
 bool video_output_connect(
@@ -430,6 +771,17 @@ static void log_skipped(video_t *video)
 		     "%ld/%ld (%0.1f%%)",
 		     video->skipped_frames, video->total_frames,
 		     percentage_skipped);
+
+	struct video_cache_stats stats;
+	video_output_get_cache_stats(video, &stats);
+
+	if (stats.peak_queued > video->info.cache_size)
+		blog(LOG_INFO,
+		     "Video frame cache peaked at %zu/%zu frames, "
+		     "skipped frames: %" PRIu32 " at the frame limit, "
+		     "%" PRIu32 " at the memory limit",
+		     stats.peak_queued, stats.max_depth, stats.lag_skipped,
+		     stats.memory_skipped);
 }
 
 void video_output_disconnect(video_t *video,
@@ -481,21 +833,22 @@ bool video_output_lock_frame(video_t *video, struct video_frame *frame,
 
 	pthread_mutex_lock(&video->data_mutex);
 
-	if (video->available_frames == 0) {
-		video->cache[video->last_added].count += count;
-		video->cache[video->last_added].skipped += count;
+	if (!reserve_frame(video, count)) {
 		locked = false;
 
 	} else {
-		if (video->available_frames != video->info.cache_size) {
-			if (++video->last_added == video->info.cache_size)
+		if (video->available_frames != video->cache_depth) {
+			if (++video->last_added == video->cache_depth)
 				video->last_added = 0;
 		}
 
-		cfi = &video->cache[video->last_added];
+		cfi = video->cache[video->last_added];
 		cfi->frame.timestamp = timestamp;
+		cfi->frame.flags = 0;
+		cfi->frame.transition_progress = 0.0f;
 		cfi->count = count;
 		cfi->skipped = 0;
+		cfi->static_checked = false;
 
 		memcpy(frame, &cfi->frame, sizeof(*frame));
 
@@ -507,6 +860,75 @@ bool video_output_lock_frame(video_t *video, struct video_frame *frame,
 	return locked;
 }
 
+bool video_output_lock_external_frame(video_t *video,
+				      const struct video_data *frame, int count,
+				      void (*release)(void *param),
+				      void *param)
+{
+	struct cached_frame_info *cfi;
+	bool locked;
+
+	if (!video || !release)
+		return false;
+
+	pthread_mutex_lock(&video->data_mutex);
+
+	if (video->stop) {
+		locked = false;
+
+	} else if (!reserve_frame(video, count)) {
+		locked = false;
+
+	} else {
+		if (video->available_frames != video->cache_depth) {
+			if (++video->last_added == video->cache_depth)
+				video->last_added = 0;
+		}
+
+		cfi = video->cache[video->last_added];
+		cfi->frame.timestamp = frame->timestamp;
+		cfi->frame.flags = frame->flags;
+		cfi->frame.transition_progress = frame->transition_progress;
+		cfi->count = count;
+		cfi->skipped = 0;
+		cfi->static_checked = false;
+
+		memcpy(cfi->external_data, frame->data,
+		       sizeof(cfi->external_data));
+		memcpy(cfi->external_linesize, frame->linesize,
+		       sizeof(cfi->external_linesize));
+		cfi->release = release;
+		cfi->release_param = param;
+
+		video->available_frames--;
+		update_peak_queued(video);
+		os_sem_post(video->update_semaphore);
+
+		locked = true;
+	}
+
+	pthread_mutex_unlock(&video->data_mutex);
+
+	return locked;
+}
+
+void video_output_set_frame_flags(video_t *video, uint32_t flags,
+				  float transition_progress)
+{
+	struct cached_frame_info *cfi;
+
+	if (!video)
+		return;
+
+	pthread_mutex_lock(&video->data_mutex);
+
+	cfi = video->cache[video->last_added];
+	cfi->frame.flags = flags;
+	cfi->frame.transition_progress = transition_progress;
+
+	pthread_mutex_unlock(&video->data_mutex);
+}
+
 void video_output_unlock_frame(video_t *video)
 {
 	if (!video)
@@ -515,6 +937,7 @@ void video_output_unlock_frame(video_t *video)
 	pthread_mutex_lock(&video->data_mutex);
 
 	video->available_frames--;
+	update_peak_queued(video);
 	os_sem_post(video->update_semaphore);
 
 	pthread_mutex_unlock(&video->data_mutex);
@@ -538,6 +961,10 @@ void video_output_stop(video_t *video)
 		os_sem_post(video->update_semaphore);
 		pthread_join(video->thread, &thread_ret);
 
+		/* nothing will consume borrowed frames anymore, so give them
+		 * back before the graphics thread is waited on */
+		release_external_frames(video);
+
 		if (video == obs->video.main_mix->video) {
 			// The graphics thread must end before mutexes are destroyed
 			if (obs->video.thread_initialized) {
@@ -595,6 +1022,27 @@ uint32_t video_output_get_total_frames(const video_t *video)
 	return video ? (uint32_t)os_atomic_load_long(&video->total_frames) : 0;
 }
 
+void video_output_get_cache_stats(video_t *video,
+				  struct video_cache_stats *stats)
+{
+	if (!video || !stats)
+		return;
+
+	pthread_mutex_lock(&video->data_mutex);
+	stats->depth = video->cache_depth;
+	stats->max_depth = video->max_cache_depth < video->memory_cache_depth
+				   ? video->max_cache_depth
+				   : video->memory_cache_depth;
+	stats->queued = video->cache_depth - video->available_frames;
+	stats->peak_queued = video->peak_queued;
+	stats->lag_skipped = video->lag_skipped_frames;
+	stats->memory_skipped = video->memory_skipped_frames;
+	pthread_mutex_unlock(&video->data_mutex);
+
+	stats->texture_skipped =
+		(uint32_t)os_atomic_load_long(&video->texture_skipped_frames);
+}
+
 /* Note: These four functions below are a very slight bit of a hack.  If the
  * texture encoder thread is active while the raw encoder thread is active, the
  * total frame count will just be doubled while they're both active.  Which is
@@ -617,6 +1065,18 @@ void video_output_dec_texture_encoders(video_t *video)
 	}
 }
 
+void video_output_inc_static_detection(video_t *video)
+{
+	if (video)
+		os_atomic_inc_long(&video->static_refs);
+}
+
+void video_output_dec_static_detection(video_t *video)
+{
+	if (video)
+		os_atomic_dec_long(&video->static_refs);
+}
+
 void video_output_inc_texture_frames(video_t *video)
 {
 	os_atomic_inc_long(&video->total_frames);
@@ -625,4 +1085,5 @@ void video_output_inc_texture_frames(video_t *video)
 void video_output_inc_texture_skipped_frames(video_t *video)
 {
 	os_atomic_inc_long(&video->skipped_frames);
+	os_atomic_inc_long(&video->texture_skipped_frames);
 }
@@ -106,10 +106,24 @@ enum video_range_type {
 	VIDEO_RANGE_FULL,
 };
 
+/* the frame is identical to the one before it */
+#define VIDEO_FRAME_STATIC (1 << 0)
+/* the frame abruptly shows different content than the one before it, such
+ * as when cutting to another scene */
+#define VIDEO_FRAME_SCENE_CUT (1 << 1)
+/* the frame is part of a transition, see transition_progress */
+#define VIDEO_FRAME_TRANSITION (1 << 2)
+/* a keyframe was requested, the encoder should start a new GOP here */
+#define VIDEO_FRAME_KEYFRAME (1 << 3)
+
 struct video_data {
 	uint8_t *data[MAX_AV_PLANES];
 	uint32_t linesize[MAX_AV_PLANES];
 	uint64_t timestamp;
+
+	/* VIDEO_FRAME_* flags describing the frame's content */
+	uint32_t flags;
+	float transition_progress;
 };
 
 struct video_output_info {
@@ -124,6 +138,25 @@ struct video_output_info {
 
 	enum video_colorspace colorspace;
 	enum video_range_type range;
+
+	/* the frame cache starts out at cache_size frames and grows up to
+	 * max_cache_size (within a memory limit) when inputs fall behind, then
+	 * shrinks back once they catch up.  0 keeps it at cache_size. */
+	size_t max_cache_size;
+};
+
+struct video_cache_stats {
+	size_t depth;
+	size_t max_depth;
+	size_t queued;
+	size_t peak_queued;
+
+	/* frames skipped because the cache was full at max_cache_size, or
+	 * because it couldn't grow any further without going over the memory
+	 * limit.  texture_skipped counts frames skipped by texture encoders. */
+	uint32_t lag_skipped;
+	uint32_t memory_skipped;
+	uint32_t texture_skipped;
 };
 
 static inline bool format_is_yuv(enum video_format format)
@@ -296,6 +329,26 @@ video_output_get_info(const video_t *video);
 EXPORT bool video_output_lock_frame(video_t *video, struct video_frame *frame,
 				    int count, uint64_t timestamp);
 EXPORT void video_output_unlock_frame(video_t *video);
+
+/**
+ * Sets the VIDEO_FRAME_* flags of the frame locked with
+ * video_output_lock_frame.  Must be called before video_output_unlock_frame.
+ */
+EXPORT void video_output_set_frame_flags(video_t *video, uint32_t flags,
+					 float transition_progress);
+
+/**
+ * Queues a frame whose planes are owned by the caller instead of copying them
+ * into the frame cache.  The planes must stay valid until release is called,
+ * which happens once every input has received the frame (or the output is
+ * stopped).  Returns false if the frame was not queued, in which case release
+ * is not called.
+ */
+EXPORT bool video_output_lock_external_frame(video_t *video,
+					     const struct video_data *frame,
+					     int count,
+					     void (*release)(void *param),
+					     void *param);
 EXPORT uint64_t video_output_get_frame_time(const video_t *video);
 EXPORT void video_output_stop(video_t *video);
 EXPORT bool video_output_stopped(video_t *video);
@@ -307,11 +360,15 @@ EXPORT double video_output_get_frame_rate(const video_t *video);
 
 EXPORT uint32_t video_output_get_skipped_frames(const video_t *video);
 EXPORT uint32_t video_output_get_total_frames(const video_t *video);
+EXPORT void video_output_get_cache_stats(video_t *video,
+					 struct video_cache_stats *stats);
 
 extern void video_output_inc_texture_encoders(video_t *video);
 extern void video_output_dec_texture_encoders(video_t *video);
 extern void video_output_inc_texture_frames(video_t *video);
 extern void video_output_inc_texture_skipped_frames(video_t *video);
+extern void video_output_inc_static_detection(video_t *video);
+extern void video_output_dec_static_detection(video_t *video);
 
 #ifdef __cplusplus
 }
@@ -22,6 +22,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "util/threading.h"
 #include "util/bmem.h"
 #include "media-io/audio-math.h"
+#include "media-io/audio-kernels.h"
 #include "obs.h"
 #include "obs-internal.h"
 
@@ -74,10 +75,6 @@ struct obs_volmeter {
 
 	enum obs_peak_meter_type peak_meter_type;
 	unsigned int update_ms;
-	float prev_samples[MAX_AUDIO_CHANNELS][4];
-
-	float magnitude[MAX_AUDIO_CHANNELS];
-	float peak[MAX_AUDIO_CHANNELS];
 };
 
 static float cubic_def_to_db(const float def)
@@ -343,7 +340,7 @@ static float get_true_peak(__m128 previous_samples, const float *samples,
 	__m128 work = previous_samples;
 	__m128 peak = previous_samples;
 	for (size_t i = 0; (i + 3) < nr_samples; i += 4) {
-		__m128 new_work = _mm_load_ps(&samples[i]);
+		__m128 new_work = _mm_loadu_ps(&samples[i]);
 		__m128 intrp_samples;
 
 		/* Include the actual sample values in the peak. */
@@ -381,7 +378,7 @@ static float get_sample_peak(__m128 previous_samples, const float *samples,
 {
 	__m128 peak = previous_samples;
 	for (size_t i = 0; (i + 3) < nr_samples; i += 4) {
-		__m128 new_work = _mm_load_ps(&samples[i]);
+		__m128 new_work = _mm_loadu_ps(&samples[i]);
 		peak = _mm_max_ps(peak, abs_ps(new_work));
 	}
 
@@ -390,8 +387,8 @@ static float get_sample_peak(__m128 previous_samples, const float *samples,
 	return r;
 }
 
-static void volmeter_process_peak_last_samples(obs_volmeter_t *volmeter,
-					       int channel_nr, float *samples,
+static void volmeter_process_peak_last_samples(float prev_samples[4],
+					       float *samples,
 					       size_t nr_samples)
 {
 	/* Take the last 4 samples that need to be used for the next peak
@@ -402,64 +399,50 @@ static void volmeter_process_peak_last_samples(obs_volmeter_t *volmeter,
 	case 0:
 		break;
 	case 1:
-		volmeter->prev_samples[channel_nr][0] =
-			volmeter->prev_samples[channel_nr][1];
-		volmeter->prev_samples[channel_nr][1] =
-			volmeter->prev_samples[channel_nr][2];
-		volmeter->prev_samples[channel_nr][2] =
-			volmeter->prev_samples[channel_nr][3];
-		volmeter->prev_samples[channel_nr][3] = samples[nr_samples - 1];
+		prev_samples[0] = prev_samples[1];
+		prev_samples[1] = prev_samples[2];
+		prev_samples[2] = prev_samples[3];
+		prev_samples[3] = samples[nr_samples - 1];
 		break;
 	case 2:
-		volmeter->prev_samples[channel_nr][0] =
-			volmeter->prev_samples[channel_nr][2];
-		volmeter->prev_samples[channel_nr][1] =
-			volmeter->prev_samples[channel_nr][3];
-		volmeter->prev_samples[channel_nr][2] = samples[nr_samples - 2];
-		volmeter->prev_samples[channel_nr][3] = samples[nr_samples - 1];
+		prev_samples[0] = prev_samples[2];
+		prev_samples[1] = prev_samples[3];
+		prev_samples[2] = samples[nr_samples - 2];
+		prev_samples[3] = samples[nr_samples - 1];
 		break;
 	case 3:
-		volmeter->prev_samples[channel_nr][0] =
-			volmeter->prev_samples[channel_nr][3];
-		volmeter->prev_samples[channel_nr][1] = samples[nr_samples - 3];
-		volmeter->prev_samples[channel_nr][2] = samples[nr_samples - 2];
-		volmeter->prev_samples[channel_nr][3] = samples[nr_samples - 1];
+		prev_samples[0] = prev_samples[3];
+		prev_samples[1] = samples[nr_samples - 3];
+		prev_samples[2] = samples[nr_samples - 2];
+		prev_samples[3] = samples[nr_samples - 1];
 		break;
 	default:
-		volmeter->prev_samples[channel_nr][0] = samples[nr_samples - 4];
-		volmeter->prev_samples[channel_nr][1] = samples[nr_samples - 3];
-		volmeter->prev_samples[channel_nr][2] = samples[nr_samples - 2];
-		volmeter->prev_samples[channel_nr][3] = samples[nr_samples - 1];
+		prev_samples[0] = samples[nr_samples - 4];
+		prev_samples[1] = samples[nr_samples - 3];
+		prev_samples[2] = samples[nr_samples - 2];
+		prev_samples[3] = samples[nr_samples - 1];
 	}
 }
 
-static void volmeter_process_peak(obs_volmeter_t *volmeter,
+static void volmeter_process_peak(struct audio_meter_bus *bus,
+				  enum obs_peak_meter_type peak_meter_type,
 				  const struct audio_data *data,
 				  int nr_channels)
 {
-	int nr_samples = data->frames;
+	size_t nr_samples = data->frames;
+	size_t nr_tail = nr_samples & 3;
 	int channel_nr = 0;
 	for (int plane_nr = 0; channel_nr < nr_channels; plane_nr++) {
 		float *samples = (float *)data->data[plane_nr];
 		if (!samples) {
 			continue;
 		}
-		if (((uintptr_t)samples & 0xf) > 0) {
-			printf("Audio plane %i is not aligned %p skipping "
-			       "peak volume measurement.\n",
-			       plane_nr, samples);
-			volmeter->peak[channel_nr] = 1.0;
-			channel_nr++;
-			continue;
-		}
 
-		/* volmeter->prev_samples may not be aligned to 16 bytes;
-		 * use unaligned load. */
 		__m128 previous_samples =
-			_mm_loadu_ps(volmeter->prev_samples[channel_nr]);
+			_mm_loadu_ps(bus->prev_samples[channel_nr]);
 
 		float peak;
-		switch (volmeter->peak_meter_type) {
+		switch (peak_meter_type) {
 		case TRUE_PEAK_METER:
 			peak = get_true_peak(previous_samples, samples,
 					     nr_samples);
@@ -472,21 +455,26 @@ static void volmeter_process_peak(obs_volmeter_t *volmeter,
 			break;
 		}
 
-		volmeter_process_peak_last_samples(volmeter, channel_nr,
+		/* the vector loops only cover whole sets of four */
+		peak = fmaxf(peak, audio_kernel_abs_max(
+					   samples + nr_samples - nr_tail,
+					   nr_tail));
+
+		volmeter_process_peak_last_samples(bus->prev_samples[channel_nr],
 						   samples, nr_samples);
 
-		volmeter->peak[channel_nr] = peak;
+		bus->peak[channel_nr] = peak;
 
 		channel_nr++;
 	}
 
 	/* Clear the peak of the channels that have not been handled. */
 	for (; channel_nr < MAX_AUDIO_CHANNELS; channel_nr++) {
-		volmeter->peak[channel_nr] = 0.0;
+		bus->peak[channel_nr] = 0.0;
 	}
 }
 
-static void volmeter_process_magnitude(obs_volmeter_t *volmeter,
+static void volmeter_process_magnitude(struct audio_meter_bus *bus,
 				       const struct audio_data *data,
 				       int nr_channels)
 {
@@ -499,24 +487,21 @@ static void volmeter_process_magnitude(obs_volmeter_t *volmeter,
 			continue;
 		}
 
-		float sum = 0.0;
-		for (size_t i = 0; i < nr_samples; i++) {
-			float sample = samples[i];
-			sum += sample * sample;
-		}
-		volmeter->magnitude[channel_nr] = sqrtf(sum / nr_samples);
+		float sum = audio_kernel_sum_squares(samples, nr_samples);
+		bus->magnitude[channel_nr] = sqrtf(sum / nr_samples);
 
 		channel_nr++;
 	}
 }
 
-static void volmeter_process_audio_data(obs_volmeter_t *volmeter,
+static void volmeter_process_audio_data(struct audio_meter_bus *bus,
+					enum obs_peak_meter_type type,
 					const struct audio_data *data)
 {
 	int nr_channels = get_nr_channels_from_audio_data(data);
 
-	volmeter_process_peak(volmeter, data, nr_channels);
-	volmeter_process_magnitude(volmeter, data, nr_channels);
+	volmeter_process_peak(bus, type, data, nr_channels);
+	volmeter_process_magnitude(bus, data, nr_channels);
 }
 
 static void volmeter_source_data_received(void *vptr, obs_source_t *source,
@@ -524,6 +509,7 @@ static void volmeter_source_data_received(void *vptr, obs_source_t *source,
 					  bool muted)
 {
 	struct obs_volmeter *volmeter = (struct obs_volmeter *)vptr;
+	struct audio_meter_bus *bus;
 	float mul;
 	float magnitude[MAX_AUDIO_CHANNELS];
 	float peak[MAX_AUDIO_CHANNELS];
@@ -531,7 +517,15 @@ static void volmeter_source_data_received(void *vptr, obs_source_t *source,
 
 	pthread_mutex_lock(&volmeter->mutex);
 
-	volmeter_process_audio_data(volmeter, data);
+	/* audio capture callbacks run under the source's audio_cb_mutex, so
+	 * the first meter of each peak type to see a packet computes its
+	 * levels and the rest reuse them */
+	bus = &source->meter_bus[volmeter->peak_meter_type == TRUE_PEAK_METER];
+	if (bus->serial != source->audio_cb_serial) {
+		volmeter_process_audio_data(bus, volmeter->peak_meter_type,
+					    data);
+		bus->serial = source->audio_cb_serial;
+	}
 
 	// Adjust magnitude/peak based on the volume level set by the user.
 	// And convert to dB.
@@ -540,12 +534,12 @@ static void volmeter_source_data_received(void *vptr, obs_source_t *source,
 	for (int channel_nr = 0; channel_nr < MAX_AUDIO_CHANNELS;
 	     channel_nr++) {
 		magnitude[channel_nr] =
-			mul_to_db(volmeter->magnitude[channel_nr] * mul);
-		peak[channel_nr] = mul_to_db(volmeter->peak[channel_nr] * mul);
+			mul_to_db(bus->magnitude[channel_nr] * mul);
+		peak[channel_nr] = mul_to_db(bus->peak[channel_nr] * mul);
 
 		/* The input-peak is NOT adjusted with volume, so that the user
 		 * can check the input-gain. */
-		input_peak[channel_nr] = mul_to_db(volmeter->peak[channel_nr]);
+		input_peak[channel_nr] = mul_to_db(bus->peak[channel_nr]);
 	}
 
 	pthread_mutex_unlock(&volmeter->mutex);
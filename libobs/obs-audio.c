@@ -18,6 +18,7 @@
 #include <inttypes.h>
 #include "obs-internal.h"
 #include "util/util_uint64.h"
+#include "media-io/audio-kernels.h"
 
 struct ts_info {
 	uint64_t start;
@@ -40,6 +41,159 @@ bool get_cached_multiple_rendering(void)
 	return audio_multiple_rendering;
 }
 
+#define MAX_AUDIO_RENDER_THREADS 4
+
+/* submix sources mix and run their whole filter chain on the audio thread,
+ * and depend on no other source's output, so they can render concurrently */
+static inline bool render_in_parallel(const struct obs_source *source)
+{
+	return source->info.audio_mix && !source->info.audio_render;
+}
+
+static void run_audio_render_jobs(struct obs_core_audio *audio)
+{
+	for (;;) {
+		struct obs_source *source = NULL;
+
+		pthread_mutex_lock(&audio->render_mutex);
+		if (audio->render_cursor < audio->render_jobs.num)
+			source = audio->render_jobs
+					 .array[audio->render_cursor++];
+		pthread_mutex_unlock(&audio->render_mutex);
+
+		if (!source)
+			break;
+
+		obs_source_audio_render(source, audio->render_mixers,
+					audio->render_channels,
+					audio->render_sample_rate,
+					audio->render_size);
+
+		if (os_atomic_dec_long(&audio->render_remaining) == 0)
+			os_event_signal(audio->render_done);
+	}
+}
+
+static void *audio_render_thread(void *param)
+{
+	struct obs_core_audio *audio = param;
+	os_thread_role_t *role = os_set_thread_role(OS_THREAD_ROLE_AUDIO);
+
+	os_set_thread_name("obs audio render thread");
+
+	while (os_sem_wait(audio->render_semaphore) == 0) {
+		if (os_atomic_load_bool(&audio->render_stop))
+			break;
+
+		run_audio_render_jobs(audio);
+	}
+
+	os_reset_thread_role(role);
+	return NULL;
+}
+
+static bool init_audio_render_threads(struct obs_core_audio *audio)
+{
+	int num = os_get_logical_cores() - 1;
+	if (num > MAX_AUDIO_RENDER_THREADS)
+		num = MAX_AUDIO_RENDER_THREADS;
+	if (num < 1)
+		return false;
+
+	audio->render_stop = false;
+
+	if (os_sem_init(&audio->render_semaphore, 0) != 0)
+		return false;
+	if (os_event_init(&audio->render_done, OS_EVENT_TYPE_MANUAL) != 0)
+		return false;
+
+	for (int i = 0; i < num; i++) {
+		pthread_t thread;
+		if (pthread_create(&thread, NULL, audio_render_thread, audio) !=
+		    0)
+			break;
+		da_push_back(audio->render_threads, &thread);
+	}
+
+	return audio->render_threads.num > 0;
+}
+
+void free_audio_render_threads(void)
+{
+	struct obs_core_audio *audio = &obs->audio;
+
+	os_atomic_set_bool(&audio->render_stop, true);
+	for (size_t i = 0; i < audio->render_threads.num; i++)
+		os_sem_post(audio->render_semaphore);
+	for (size_t i = 0; i < audio->render_threads.num; i++)
+		pthread_join(audio->render_threads.array[i], NULL);
+	da_free(audio->render_threads);
+	da_free(audio->render_jobs);
+
+	if (audio->render_semaphore) {
+		os_sem_destroy(audio->render_semaphore);
+		audio->render_semaphore = NULL;
+	}
+	if (audio->render_done) {
+		os_event_destroy(audio->render_done);
+		audio->render_done = NULL;
+	}
+}
+
+/* renders the independent sources of the render order ahead of the rest,
+ * spread over the render threads, and waits for all of them to finish */
+static const char *render_audio_parallel_name = "render_audio_parallel";
+static void render_audio_parallel(struct obs_core_audio *audio,
+				  uint32_t mixers, size_t channels,
+				  size_t sample_rate, size_t size)
+{
+	pthread_mutex_lock(&audio->render_mutex);
+	da_resize(audio->render_jobs, 0);
+	for (size_t i = 0; i < audio->render_order.num; i++) {
+		obs_source_t *source = audio->render_order.array[i];
+		if (render_in_parallel(source))
+			da_push_back(audio->render_jobs, &source);
+	}
+	pthread_mutex_unlock(&audio->render_mutex);
+
+	size_t num = audio->render_jobs.num;
+	if (!num)
+		return;
+
+	profile_start(render_audio_parallel_name);
+
+	if (num > 1 && !audio->render_threads.num && !audio->render_semaphore)
+		init_audio_render_threads(audio);
+
+	pthread_mutex_lock(&audio->render_mutex);
+	audio->render_cursor = 0;
+	audio->render_mixers = mixers;
+	audio->render_channels = channels;
+	audio->render_sample_rate = sample_rate;
+	audio->render_size = size;
+	os_atomic_set_long(&audio->render_remaining, (long)num);
+	os_event_reset(audio->render_done);
+	pthread_mutex_unlock(&audio->render_mutex);
+
+	size_t wake = num > 1 ? num - 1 : 0;
+	if (wake > audio->render_threads.num)
+		wake = audio->render_threads.num;
+
+	for (size_t i = 0; i < wake; i++)
+		os_sem_post(audio->render_semaphore);
+
+	run_audio_render_jobs(audio);
+	if (wake)
+		os_event_wait(audio->render_done);
+
+	pthread_mutex_lock(&audio->render_mutex);
+	da_resize(audio->render_jobs, 0);
+	audio->render_cursor = 0;
+	pthread_mutex_unlock(&audio->render_mutex);
+
+	profile_end(render_audio_parallel_name);
+}
+
 static void push_audio_tree(obs_source_t *parent, obs_source_t *source, void *p)
 {
 	struct obs_core_audio *audio = p;
@@ -59,8 +213,9 @@ static inline size_t convert_time_to_frames(size_t sample_rate, uint64_t t)
 }
 
 static inline void mix_audio(struct audio_output_data *mixes,
-			     obs_source_t *source, size_t channels,
-			     size_t sample_rate, struct ts_info *ts)
+			     obs_source_t *source, uint32_t mixers,
+			     size_t channels, size_t sample_rate,
+			     struct ts_info *ts)
 {
 	size_t total_floats = AUDIO_OUTPUT_FRAMES;
 	size_t start_point = 0;
@@ -68,6 +223,10 @@ static inline void mix_audio(struct audio_output_data *mixes,
 	if (source->audio_ts < ts->start || ts->end <= source->audio_ts)
 		return;
 
+	/* nothing to add, the source's output buffers are all zero */
+	if (source->audio_silent)
+		return;
+
 	if (source->audio_ts != ts->start) {
 		start_point = convert_time_to_frames(
 			sample_rate, source->audio_ts - ts->start);
@@ -78,17 +237,17 @@ static inline void mix_audio(struct audio_output_data *mixes,
 	}
 
 	for (size_t mix_idx = 0; mix_idx < MAX_AUDIO_MIXES; mix_idx++) {
-		for (size_t ch = 0; ch < channels; ch++) {
-			register float *mix = mixes[mix_idx].data[ch];
-			register float *aud =
-				source->audio_output_buf[mix_idx][ch];
-			register float *end;
+		uint32_t mix_bit = 1 << mix_idx;
+
+		/* unconnected mixes, or mixes the source is excluded from */
+		if ((mixers & source->audio_mixers & mix_bit) == 0)
+			continue;
 
-			mix += start_point;
-			end = aud + total_floats;
+		for (size_t ch = 0; ch < channels; ch++) {
+			float *mix = mixes[mix_idx].data[ch];
+			float *aud = source->audio_output_buf[mix_idx][ch];
 
-			while (aud < end)
-				*(mix++) += *(aud++);
+			audio_kernel_add(mix + start_point, aud, total_floats);
 		}
 	}
 }
@@ -328,6 +487,7 @@ static void set_fixed_audio_buffering(struct obs_core_audio *audio,
 
 	total_ms = audio->total_buffering_ticks * AUDIO_OUTPUT_FRAMES * 1000 /
 		   sample_rate;
+	obs_metric_set(obs->metrics.audio_buffering_ms, (int64_t)total_ms);
 
 	blog(LOG_INFO,
 	     "Enabling fixed audio buffering, total "
@@ -360,6 +520,13 @@ static void set_fixed_audio_buffering(struct obs_core_audio *audio,
 	*ts = new_ts;
 }
 
+static inline void reset_buffering_window(struct obs_core_audio *audio)
+{
+	audio->buffering_window_ticks = 0;
+	audio->buffering_min_slack = UINT64_MAX;
+	audio->buffering_shrink_ticks = 0;
+}
+
 static void add_audio_buffering(struct obs_core_audio *audio,
 				size_t sample_rate, struct ts_info *ts,
 				uint64_t min_ts, const char *buffering_name)
@@ -382,6 +549,7 @@ static void add_audio_buffering(struct obs_core_audio *audio,
 	ticks = (int)((frames + AUDIO_OUTPUT_FRAMES - 1) / AUDIO_OUTPUT_FRAMES);
 
 	audio->total_buffering_ticks += ticks;
+	reset_buffering_window(audio);
 
 	if (audio->total_buffering_ticks >= audio->max_buffering_ticks) {
 		ticks -= audio->total_buffering_ticks -
@@ -393,6 +561,7 @@ static void add_audio_buffering(struct obs_core_audio *audio,
 	ms = ticks * AUDIO_OUTPUT_FRAMES * 1000 / sample_rate;
 	total_ms = audio->total_buffering_ticks * AUDIO_OUTPUT_FRAMES * 1000 /
 		   sample_rate;
+	obs_metric_set(obs->metrics.audio_buffering_ms, (int64_t)total_ms);
 
 	blog(LOG_INFO,
 	     "adding %d milliseconds of audio buffering, total "
@@ -528,6 +697,304 @@ static inline void execute_audio_tasks(void)
 	}
 }
 
+/* ------------------------------------------------------------------------- */
+/* audio tick journal                                                         */
+
+#define OVERRUN_LOG_INTERVAL_NS 5000000000ULL
+
+void free_audio_tick_journal(struct obs_core_audio *audio)
+{
+	for (size_t i = 0; i < AUDIO_TICK_JOURNAL_SIZE; i++) {
+		obs_weak_source_release(audio->journal[i].slowest_source);
+		audio->journal[i].slowest_source = NULL;
+	}
+}
+
+/* filters usually run on their source's capture thread, so the slowest one
+ * is looked up across all audio sources rather than the tick's render */
+static obs_source_t *find_slowest_filter(struct obs_core_data *data,
+					 obs_source_t **parent, uint64_t *ns)
+{
+	obs_weak_source_t *weak_filter = NULL;
+	obs_weak_source_t *weak_parent = NULL;
+	obs_source_t *filter;
+
+	*ns = 0;
+
+	pthread_mutex_lock(&data->audio_sources_mutex);
+
+	obs_source_t *source = data->first_audio_source;
+	while (source) {
+		pthread_mutex_lock(&source->filter_mutex);
+		for (size_t i = 0; i < source->filters.num; i++) {
+			obs_source_t *cur = source->filters.array[i];
+			if (cur->audio_filter_ns <= *ns)
+				continue;
+
+			obs_weak_source_release(weak_filter);
+			obs_weak_source_release(weak_parent);
+			weak_filter = obs_source_get_weak_source(cur);
+			weak_parent = obs_source_get_weak_source(source);
+			*ns = cur->audio_filter_ns;
+		}
+		pthread_mutex_unlock(&source->filter_mutex);
+
+		source = (struct obs_source *)source->next_audio_source;
+	}
+
+	pthread_mutex_unlock(&data->audio_sources_mutex);
+
+	filter = obs_weak_source_get_source(weak_filter);
+	*parent = obs_weak_source_get_source(weak_parent);
+	obs_weak_source_release(weak_filter);
+	obs_weak_source_release(weak_parent);
+	return filter;
+}
+
+static void log_audio_overrun(struct obs_core_audio *audio,
+			      const struct audio_tick_entry *entry,
+			      uint64_t budget)
+{
+	const struct obs_audio_tick_stats *s = &entry->stats;
+	obs_source_t *source = obs_weak_source_get_source(entry->slowest_source);
+	obs_source_t *filter_parent;
+	uint64_t filter_ns;
+	obs_source_t *filter =
+		find_slowest_filter(&obs->data, &filter_parent, &filter_ns);
+	uint64_t max_total = 0;
+	uint64_t sum_total = 0;
+
+	for (size_t i = 0; i < audio->journal_count; i++) {
+		uint64_t total = audio->journal[i].stats.total_ns;
+		sum_total += total;
+		if (total > max_total)
+			max_total = total;
+	}
+
+	blog(LOG_WARNING,
+	     "Audio tick took %.2f ms, over its %.2f ms budget "
+	     "(render %.2f ms, mix %.2f ms, outputs %.2f ms)",
+	     s->total_ns / 1000000.0, budget / 1000000.0,
+	     s->render_ns / 1000000.0, s->mix_ns / 1000000.0,
+	     s->output_ns / 1000000.0);
+	blog(LOG_WARNING, "\tslowest source: '%s' (%.2f ms)",
+	     source ? obs_source_get_name(source) : "(none)",
+	     entry->slowest_source_ns / 1000000.0);
+	blog(LOG_WARNING, "\tslowest audio filter: '%s' on '%s' (%.2f ms)",
+	     filter ? obs_source_get_name(filter) : "(none)",
+	     filter_parent ? obs_source_get_name(filter_parent) : "(none)",
+	     filter_ns / 1000000.0);
+	blog(LOG_WARNING,
+	     "\tlast %d ticks: average %.2f ms, max %.2f ms, "
+	     "%ld earlier overruns not logged",
+	     (int)audio->journal_count,
+	     sum_total / 1000000.0 / (double)audio->journal_count,
+	     max_total / 1000000.0, audio->overruns_suppressed);
+
+	obs_source_release(filter_parent);
+	obs_source_release(filter);
+	obs_source_release(source);
+}
+
+/* the previous tick's outputs ran after its callback returned, so its entry
+ * is completed and checked at the start of this one */
+static void finish_tick_entry(struct obs_core_audio *audio, size_t sample_rate,
+			      uint64_t cur_time)
+{
+	const uint64_t budget =
+		audio_frames_to_ns(sample_rate, AUDIO_OUTPUT_FRAMES);
+	struct audio_tick_entry *entry;
+
+	if (!audio->journal_pending)
+		return;
+
+	pthread_mutex_lock(&audio->journal_mutex);
+	entry = &audio->journal[audio->journal_pos];
+	entry->stats.output_ns = audio_output_get_output_time_ns(audio->audio);
+	entry->stats.total_ns += entry->stats.output_ns;
+	audio->journal_pos = (audio->journal_pos + 1) % AUDIO_TICK_JOURNAL_SIZE;
+	if (audio->journal_count < AUDIO_TICK_JOURNAL_SIZE)
+		audio->journal_count++;
+	audio->journal_pending = false;
+	pthread_mutex_unlock(&audio->journal_mutex);
+
+	if (entry->stats.total_ns <= budget)
+		return;
+
+	if (cur_time - audio->last_overrun_log < OVERRUN_LOG_INTERVAL_NS) {
+		audio->overruns_suppressed++;
+		return;
+	}
+
+	log_audio_overrun(audio, entry, budget);
+	audio->last_overrun_log = cur_time;
+	audio->overruns_suppressed = 0;
+}
+
+static void start_tick_entry(struct obs_core_audio *audio, uint64_t start,
+			     uint64_t render_ns, uint64_t mix_ns)
+{
+	struct audio_tick_entry *entry = &audio->journal[audio->journal_pos];
+	obs_source_t *slowest = NULL;
+	uint64_t slowest_ns = 0;
+
+	for (size_t i = 0; i < audio->render_order.num; i++) {
+		obs_source_t *source = audio->render_order.array[i];
+		if (source->audio_render_ns > slowest_ns) {
+			slowest_ns = source->audio_render_ns;
+			slowest = source;
+		}
+	}
+
+	pthread_mutex_lock(&audio->journal_mutex);
+	obs_weak_source_release(entry->slowest_source);
+	entry->slowest_source =
+		slowest ? obs_source_get_weak_source(slowest) : NULL;
+	entry->slowest_source_ns = slowest_ns;
+	entry->stats.timestamp = start;
+	entry->stats.render_ns = render_ns;
+	entry->stats.mix_ns = mix_ns;
+	entry->stats.output_ns = 0;
+	entry->stats.total_ns = os_gettime_ns() - start;
+	audio->journal_pending = true;
+	pthread_mutex_unlock(&audio->journal_mutex);
+}
+
+size_t obs_get_audio_tick_stats(struct obs_audio_tick_stats *stats,
+				size_t count)
+{
+	struct obs_core_audio *audio;
+	size_t copied = 0;
+
+	if (!obs || !stats)
+		return 0;
+
+	audio = &obs->audio;
+
+	pthread_mutex_lock(&audio->journal_mutex);
+	size_t pos = audio->journal_pos;
+	while (copied < count && copied < audio->journal_count) {
+		pos = (pos + AUDIO_TICK_JOURNAL_SIZE - 1) %
+		      AUDIO_TICK_JOURNAL_SIZE;
+		stats[copied++] = audio->journal[pos].stats;
+	}
+	pthread_mutex_unlock(&audio->journal_mutex);
+
+	return copied;
+}
+
+/* ------------------------------------------------------------------------- */
+
+#define BUFFERING_WINDOW_SEC 10
+
+/* how far past the tick about to be discarded a source's audio already
+ * extends, i.e. how much of the current buffering it did not need */
+static void sample_buffering_slack(struct obs_core_audio *audio,
+				   obs_source_t *source, size_t sample_rate,
+				   const struct ts_info *ts)
+{
+	uint64_t data_end;
+	size_t frames;
+
+	if (source->info.audio_render || source->audio_pending ||
+	    !source->audio_ts)
+		return;
+
+	frames = source->audio_input_buf[0].size / sizeof(float);
+	data_end = source->audio_ts + audio_frames_to_ns(sample_rate, frames);
+
+	if (data_end <= ts->end)
+		audio->buffering_min_slack = 0;
+	else if (data_end - ts->end < audio->buffering_min_slack)
+		audio->buffering_min_slack = data_end - ts->end;
+}
+
+/* once per window, works out how many ticks of buffering went unused by
+ * every source and schedules that many (less one tick of headroom) to be
+ * removed.  outputs count audio frames rather than following timestamps,
+ * so this waits until nothing is encoding. */
+static void update_adaptive_buffering(struct obs_core_audio *audio,
+				      size_t sample_rate)
+{
+	const uint64_t tick_ns =
+		audio_frames_to_ns(sample_rate, AUDIO_OUTPUT_FRAMES);
+	const size_t window =
+		BUFFERING_WINDOW_SEC * sample_rate / AUDIO_OUTPUT_FRAMES;
+	int ticks;
+
+	if (!audio->adaptive_buffer || audio->fixed_buffer)
+		return;
+	if (++audio->buffering_window_ticks < window)
+		return;
+
+	if (audio->buffering_wait_ticks || audio->buffering_shrink_ticks ||
+	    !audio->total_buffering_ticks ||
+	    audio->buffering_min_slack == UINT64_MAX ||
+	    audio_output_active(audio->audio)) {
+		audio->buffering_window_ticks = 0;
+		audio->buffering_min_slack = UINT64_MAX;
+		return;
+	}
+
+	ticks = (int)(audio->buffering_min_slack / tick_ns) - 1;
+	if (ticks > audio->total_buffering_ticks)
+		ticks = audio->total_buffering_ticks;
+
+	reset_buffering_window(audio);
+
+	if (ticks > 0) {
+		blog(LOG_INFO,
+		     "removing %d milliseconds of unused audio buffering",
+		     (int)(ticks * AUDIO_OUTPUT_FRAMES * 1000 / sample_rate));
+		audio->buffering_shrink_ticks = ticks;
+	}
+}
+
+/* drops the oldest buffered tick, discarding the matching audio from every
+ * source so they stay aligned with the new, later output timestamp */
+static void shrink_audio_buffering(struct obs_core_data *data,
+				   struct obs_core_audio *audio,
+				   size_t channels, size_t sample_rate,
+				   struct ts_info *ts)
+{
+	struct ts_info skipped;
+	obs_source_t *source;
+
+	if (!audio->buffering_shrink_ticks || audio->buffering_wait_ticks)
+		return;
+	if (audio->buffered_timestamps.size <= sizeof(*ts))
+		return;
+
+	circlebuf_pop_front(&audio->buffered_timestamps, &skipped,
+			    sizeof(skipped));
+
+	pthread_mutex_lock(&data->audio_sources_mutex);
+
+	source = data->first_audio_source;
+	while (source) {
+		pthread_mutex_lock(&source->audio_buf_mutex);
+		obs_source_drain_audio_packets(source);
+		discard_audio(audio, source, channels, sample_rate, &skipped);
+		pthread_mutex_unlock(&source->audio_buf_mutex);
+
+		source = (struct obs_source *)source->next_audio_source;
+	}
+
+	pthread_mutex_unlock(&data->audio_sources_mutex);
+
+	audio->total_buffering_ticks--;
+	audio->buffering_shrink_ticks--;
+
+	circlebuf_peek_front(&audio->buffered_timestamps, ts, sizeof(*ts));
+
+	if (!audio->buffering_shrink_ticks) {
+		int total_ms = (int)(audio->total_buffering_ticks *
+				     AUDIO_OUTPUT_FRAMES * 1000 / sample_rate);
+		blog(LOG_INFO, "audio buffering is now %d milliseconds",
+		     total_ms);
+	}
+}
+
 bool audio_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in,
 		    uint64_t *out_ts, uint32_t mixers,
 		    struct audio_output_data *mixes)
@@ -538,14 +1005,22 @@ bool audio_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in,
 	size_t sample_rate = audio_output_get_sample_rate(audio->audio);
 	size_t channels = audio_output_get_channels(audio->audio);
 	struct ts_info ts = {start_ts_in, end_ts_in};
+	uint64_t tick_start = os_gettime_ns();
+	uint64_t render_ns;
+	uint64_t mix_start;
 	size_t audio_size;
 	uint64_t min_ts;
 
+	obs_heartbeat_begin(&audio->heartbeat);
+
+	finish_tick_entry(audio, sample_rate, tick_start);
+
 	da_resize(audio->render_order, 0);
 	da_resize(audio->root_nodes, 0);
 
 	circlebuf_push_back(&audio->buffered_timestamps, &ts, sizeof(ts));
 	circlebuf_peek_front(&audio->buffered_timestamps, &ts, sizeof(ts));
+	shrink_audio_buffering(data, audio, channels, sample_rate, &ts);
 	min_ts = ts.start;
 
 	audio_size = AUDIO_OUTPUT_FRAMES * sizeof(float);
@@ -580,10 +1055,16 @@ bool audio_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in,
 
 	/* ------------------------------------------------ */
 	/* render audio data */
+	uint64_t render_start = os_gettime_ns();
+
+	render_audio_parallel(audio, mixers, channels, sample_rate,
+			      audio_size);
+
 	for (size_t i = 0; i < audio->render_order.num; i++) {
 		obs_source_t *source = audio->render_order.array[i];
-		obs_source_audio_render(source, mixers, channels, sample_rate,
-					audio_size);
+		if (!render_in_parallel(source))
+			obs_source_audio_render(source, mixers, channels,
+						sample_rate, audio_size);
 
 		/* if a source has gone backward in time and we can no
 		 * longer buffer, drop some or all of its audio */
@@ -618,6 +1099,8 @@ bool audio_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in,
 		}
 	}
 
+	render_ns = os_gettime_ns() - render_start;
+
 	/* ------------------------------------------------ */
 	/* get minimum audio timestamp */
 	pthread_mutex_lock(&data->audio_sources_mutex);
@@ -637,6 +1120,8 @@ bool audio_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in,
 
 	/* ------------------------------------------------ */
 	/* mix audio */
+	mix_start = os_gettime_ns();
+
 	if (!audio->buffering_wait_ticks) {
 		for (size_t i = 0; i < audio->root_nodes.num; i++) {
 			obs_source_t *source = audio->root_nodes.array[i];
@@ -647,8 +1132,8 @@ bool audio_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in,
 			pthread_mutex_lock(&source->audio_buf_mutex);
 
 			if (source->audio_output_buf[0][0] && source->audio_ts)
-				mix_audio(mixes, source, channels, sample_rate,
-					  &ts);
+				mix_audio(mixes, source, mixers, channels,
+					  sample_rate, &ts);
 
 			pthread_mutex_unlock(&source->audio_buf_mutex);
 		}
@@ -661,6 +1146,8 @@ bool audio_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in,
 	source = data->first_audio_source;
 	while (source) {
 		pthread_mutex_lock(&source->audio_buf_mutex);
+		obs_source_drain_audio_packets(source);
+		sample_buffering_slack(audio, source, sample_rate, &ts);
 		discard_audio(audio, source, channels, sample_rate, &ts);
 		pthread_mutex_unlock(&source->audio_buf_mutex);
 
@@ -669,6 +1156,11 @@ bool audio_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in,
 
 	pthread_mutex_unlock(&data->audio_sources_mutex);
 
+	update_adaptive_buffering(audio, sample_rate);
+
+	start_tick_entry(audio, tick_start, render_ns,
+			 os_gettime_ns() - mix_start);
+
 	/* ------------------------------------------------ */
 	/* release audio sources */
 	release_audio_sources(audio);
@@ -679,11 +1171,14 @@ bool audio_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in,
 
 	if (audio->buffering_wait_ticks) {
 		audio->buffering_wait_ticks--;
+		obs_heartbeat_end(&audio->heartbeat);
 		return false;
 	}
 
 	execute_audio_tasks();
 
+	obs_heartbeat_end(&audio->heartbeat);
+
 	UNUSED_PARAMETER(param);
 	return true;
 }
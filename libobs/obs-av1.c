@@ -0,0 +1,371 @@
+/******************************************************************************
+    Copyright (C) 2023 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "obs-av1.h"
+
+#include "obs.h"
+#include "obs-nal.h"
+#include "util/array-serializer.h"
+#include "util/bitstream.h"
+
+struct obu {
+	const uint8_t *start;
+	const uint8_t *payload;
+	size_t size;
+	size_t payload_size;
+	int type;
+};
+
+static bool read_leb128(const uint8_t **p, const uint8_t *end, size_t *val)
+{
+	uint64_t v = 0;
+
+	for (int i = 0; i < 8; i++) {
+		if (*p >= end)
+			return false;
+
+		uint8_t byte = *(*p)++;
+		v |= (uint64_t)(byte & 0x7F) << (i * 7);
+		if (!(byte & 0x80)) {
+			*val = (size_t)v;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/* reads the OBU starting at *p and advances past it; encoders always set
+ * obu_has_size_field for the low overhead bitstream format */
+static bool next_obu(const uint8_t **p, const uint8_t *end, struct obu *obu)
+{
+	const uint8_t *cur = *p;
+	uint8_t header;
+
+	if (cur >= end)
+		return false;
+
+	obu->start = cur;
+	header = *cur++;
+	obu->type = (header >> 3) & 0xF;
+
+	if (header & 0x4)
+		cur++;
+
+	if (header & 0x2) {
+		if (!read_leb128(&cur, end, &obu->payload_size))
+			return false;
+	} else {
+		if (cur > end)
+			return false;
+		obu->payload_size = end - cur;
+	}
+
+	if (obu->payload_size > (size_t)(end - cur))
+		return false;
+
+	obu->payload = cur;
+	obu->size = cur + obu->payload_size - obu->start;
+	*p = cur + obu->payload_size;
+	return true;
+}
+
+void obs_parse_av1_packet(struct encoder_packet *av1_packet,
+			  const struct encoder_packet *src)
+{
+	struct array_output_data output;
+	struct serializer s;
+	const uint8_t *p = src->data;
+	const uint8_t *end = src->data + src->size;
+	struct obu obu;
+	long ref = 1;
+
+	array_output_serializer_init(&s, &output);
+	*av1_packet = *src;
+
+	serialize(&s, &ref, sizeof(ref));
+
+	while (next_obu(&p, end, &obu)) {
+		if (obu.type == OBS_OBU_TEMPORAL_DELIMITER ||
+		    obu.type == OBS_OBU_PADDING)
+			continue;
+
+		s_write(&s, obu.start, obu.size);
+	}
+
+	/* AV1 has no per-frame reference marking like NAL ref_idc, so every
+	 * frame is treated as one other frames depend on */
+	av1_packet->priority = src->keyframe ? OBS_NAL_PRIORITY_HIGHEST
+					     : OBS_NAL_PRIORITY_HIGH;
+	av1_packet->drop_priority = av1_packet->priority;
+	av1_packet->data = output.bytes.array + sizeof(ref);
+	av1_packet->size = output.bytes.num - sizeof(ref);
+}
+
+static inline uint32_t read_bits32(struct bitstream_reader *r, int bits)
+{
+	uint32_t val = 0;
+
+	while (bits > 0) {
+		int n = bits > 8 ? 8 : bits;
+		val = (val << n) | bitstream_reader_read_bits(r, n);
+		bits -= n;
+	}
+
+	return val;
+}
+
+static inline void skip_bits(struct bitstream_reader *r, int bits)
+{
+	read_bits32(r, bits);
+}
+
+static void skip_uvlc(struct bitstream_reader *r)
+{
+	int leading_zeros = 0;
+
+	while (leading_zeros < 32 && !bitstream_reader_read_bits(r, 1))
+		leading_zeros++;
+
+	skip_bits(r, leading_zeros);
+}
+
+struct av1_seq_info {
+	uint8_t profile;
+	uint8_t level;
+	uint8_t tier;
+	uint8_t high_bitdepth;
+	uint8_t twelve_bit;
+	uint8_t monochrome;
+	uint8_t subsampling_x;
+	uint8_t subsampling_y;
+	uint8_t chroma_sample_position;
+};
+
+/* only goes as far into sequence_header_obu() as av1C needs, see section
+ * 5.5 of the AV1 specification */
+static void parse_sequence_header(const struct obu *obu,
+				  struct av1_seq_info *info)
+{
+	struct bitstream_reader r;
+	size_t len = obu->payload_size;
+	uint8_t reduced_still_picture_header;
+	uint8_t timing_info_present = 0;
+	uint8_t decoder_model_info_present = 0;
+	uint8_t initial_display_delay_present = 0;
+	uint8_t buffer_delay_length = 0;
+	uint8_t enable_order_hint = 0;
+	uint8_t seq_force_screen_content_tools = 2;
+	int frame_width_bits, frame_height_bits;
+
+	/* the reader's position is 8 bits wide, more than enough for the
+	 * fields needed here */
+	if (len > 255)
+		len = 255;
+
+	bitstream_reader_init(&r, (uint8_t *)obu->payload, len);
+
+	info->profile = bitstream_reader_read_bits(&r, 3);
+	skip_bits(&r, 1); /* still_picture */
+	reduced_still_picture_header = bitstream_reader_read_bits(&r, 1);
+
+	if (reduced_still_picture_header) {
+		info->level = bitstream_reader_read_bits(&r, 5);
+		info->tier = 0;
+	} else {
+		uint8_t operating_points;
+
+		timing_info_present = bitstream_reader_read_bits(&r, 1);
+		if (timing_info_present) {
+			/* num_units_in_display_tick, time_scale */
+			skip_bits(&r, 32);
+			skip_bits(&r, 32);
+			if (bitstream_reader_read_bits(&r, 1))
+				skip_uvlc(&r);
+
+			decoder_model_info_present =
+				bitstream_reader_read_bits(&r, 1);
+			if (decoder_model_info_present) {
+				buffer_delay_length =
+					bitstream_reader_read_bits(&r, 5) + 1;
+				/* num_units_in_decoding_tick,
+				 * buffer_removal_time_length_minus_1,
+				 * frame_presentation_time_length_minus_1 */
+				skip_bits(&r, 32);
+				skip_bits(&r, 10);
+			}
+		}
+
+		initial_display_delay_present =
+			bitstream_reader_read_bits(&r, 1);
+		operating_points = bitstream_reader_read_bits(&r, 5) + 1;
+
+		for (uint8_t i = 0; i < operating_points; i++) {
+			uint8_t level, tier = 0;
+
+			skip_bits(&r, 12); /* operating_point_idc */
+			level = bitstream_reader_read_bits(&r, 5);
+			if (level > 7)
+				tier = bitstream_reader_read_bits(&r, 1);
+
+			if (decoder_model_info_present &&
+			    bitstream_reader_read_bits(&r, 1)) {
+				/* decoder/encoder_buffer_delay,
+				 * low_delay_mode_flag */
+				skip_bits(&r, buffer_delay_length * 2 + 1);
+			}
+
+			if (initial_display_delay_present &&
+			    bitstream_reader_read_bits(&r, 1))
+				skip_bits(&r, 4);
+
+			if (i == 0) {
+				info->level = level;
+				info->tier = tier;
+			}
+		}
+	}
+
+	frame_width_bits = bitstream_reader_read_bits(&r, 4) + 1;
+	frame_height_bits = bitstream_reader_read_bits(&r, 4) + 1;
+	skip_bits(&r, frame_width_bits);
+	skip_bits(&r, frame_height_bits);
+
+	if (!reduced_still_picture_header && bitstream_reader_read_bits(&r, 1))
+		skip_bits(&r, 7); /* frame id lengths */
+
+	/* use_128x128_superblock, enable_filter_intra,
+	 * enable_intra_edge_filter */
+	skip_bits(&r, 3);
+
+	if (!reduced_still_picture_header) {
+		/* enable_interintra_compound, enable_masked_compound,
+		 * enable_warped_motion, enable_dual_filter */
+		skip_bits(&r, 4);
+
+		enable_order_hint = bitstream_reader_read_bits(&r, 1);
+		if (enable_order_hint)
+			skip_bits(&r, 2); /* jnt_comp, ref_frame_mvs */
+
+		if (!bitstream_reader_read_bits(&r, 1))
+			seq_force_screen_content_tools =
+				bitstream_reader_read_bits(&r, 1);
+
+		if (seq_force_screen_content_tools > 0 &&
+		    !bitstream_reader_read_bits(&r, 1))
+			skip_bits(&r, 1); /* seq_force_integer_mv */
+
+		if (enable_order_hint)
+			skip_bits(&r, 3); /* order_hint_bits_minus_1 */
+	}
+
+	/* enable_superres, enable_cdef, enable_restoration */
+	skip_bits(&r, 3);
+
+	/* color_config() */
+	info->high_bitdepth = bitstream_reader_read_bits(&r, 1);
+	if (info->profile == 2 && info->high_bitdepth)
+		info->twelve_bit = bitstream_reader_read_bits(&r, 1);
+
+	if (info->profile != 1)
+		info->monochrome = bitstream_reader_read_bits(&r, 1);
+
+	uint8_t color_primaries = 2;
+	uint8_t transfer_characteristics = 2;
+	uint8_t matrix_coefficients = 2;
+
+	if (bitstream_reader_read_bits(&r, 1)) {
+		color_primaries = bitstream_reader_r8(&r);
+		transfer_characteristics = bitstream_reader_r8(&r);
+		matrix_coefficients = bitstream_reader_r8(&r);
+	}
+
+	if (info->monochrome) {
+		info->subsampling_x = 1;
+		info->subsampling_y = 1;
+		return;
+	}
+
+	/* sRGB, which is always 4:4:4 */
+	if (color_primaries == 1 && transfer_characteristics == 13 &&
+	    matrix_coefficients == 0)
+		return;
+
+	skip_bits(&r, 1); /* color_range */
+
+	if (info->profile == 0) {
+		info->subsampling_x = 1;
+		info->subsampling_y = 1;
+	} else if (info->profile == 2 && info->twelve_bit) {
+		info->subsampling_x = bitstream_reader_read_bits(&r, 1);
+		if (info->subsampling_x)
+			info->subsampling_y = bitstream_reader_read_bits(&r, 1);
+	} else if (info->profile == 2) {
+		info->subsampling_x = 1;
+	}
+
+	if (info->subsampling_x && info->subsampling_y)
+		info->chroma_sample_position =
+			bitstream_reader_read_bits(&r, 2);
+}
+
+size_t obs_parse_av1_header(uint8_t **header, const uint8_t *data, size_t size)
+{
+	struct array_output_data output;
+	struct serializer s;
+	struct av1_seq_info info = {0};
+	const uint8_t *p = data;
+	const uint8_t *end = data + size;
+	struct obu obu;
+	bool found = false;
+
+	if (!size)
+		return 0;
+
+	/* already an AV1CodecConfigurationRecord (marker and version 1) */
+	if (data[0] == 0x81) {
+		*header = bmemdup(data, size);
+		return size;
+	}
+
+	while (next_obu(&p, end, &obu)) {
+		if (obu.type == OBS_OBU_SEQUENCE_HEADER) {
+			found = true;
+			break;
+		}
+	}
+
+	if (!found)
+		return 0;
+
+	parse_sequence_header(&obu, &info);
+
+	array_output_serializer_init(&s, &output);
+
+	s_w8(&s, 0x81);
+	s_w8(&s, (info.profile << 5) | info.level);
+	s_w8(&s, (info.tier << 7) | (info.high_bitdepth << 6) |
+			 (info.twelve_bit << 5) | (info.monochrome << 4) |
+			 (info.subsampling_x << 3) |
+			 (info.subsampling_y << 2) |
+			 info.chroma_sample_position);
+	s_w8(&s, 0);
+	s_write(&s, obu.start, obu.size);
+
+	*header = output.bytes.array;
+	return output.bytes.num;
+}
@@ -26,12 +26,16 @@
 #include "graphics/quat.h"
 #include "obs-data.h"
 
-#include <jansson.h>
+#include <errno.h>
+#include <locale.h>
+#include <math.h>
 
 struct obs_data_item {
 	volatile long ref;
 	struct obs_data *parent;
 	struct obs_data_item *next;
+	struct obs_data_item *hash_next;
+	uint32_t hash;
 	enum obs_data_type type;
 	size_t name_len;
 	size_t data_len;
@@ -42,10 +46,19 @@ struct obs_data_item {
 	size_t capacity;
 };
 
+/* Items stay in a list sorted by name, which is the order they're iterated
+ * and serialized in.  Once an object has more than INDEX_THRESHOLD items, a
+ * hash index is built on top of the list so lookups by name don't have to
+ * walk it. */
+#define INDEX_THRESHOLD 16
+
 struct obs_data {
 	volatile long ref;
 	char *json;
 	struct obs_data_item *first_item;
+	size_t num_items;
+	struct obs_data_item **buckets;
+	size_t num_buckets;
 };
 
 struct obs_data_array {
@@ -88,6 +101,82 @@ static inline char *get_item_name(struct obs_data_item *item)
 	return (char *)item + sizeof(struct obs_data_item);
 }
 
+static inline uint32_t hash_name(const char *name)
+{
+	uint32_t hash = 2166136261u;
+
+	while (*name) {
+		hash ^= (uint8_t)*name++;
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+static inline struct obs_data_item **get_bucket(struct obs_data *data,
+						uint32_t hash)
+{
+	return &data->buckets[hash & (data->num_buckets - 1)];
+}
+
+static inline void index_insert(struct obs_data *data,
+				struct obs_data_item *item)
+{
+	if (!data->buckets)
+		return;
+
+	struct obs_data_item **bucket = get_bucket(data, item->hash);
+	item->hash_next = *bucket;
+	*bucket = item;
+}
+
+/* old_ptr may already have been freed by a realloc, only its address is
+ * compared */
+static inline void index_replace(struct obs_data *data, uint32_t hash,
+				 struct obs_data_item *old_ptr,
+				 struct obs_data_item *new_ptr)
+{
+	if (!data->buckets)
+		return;
+
+	struct obs_data_item **cur = get_bucket(data, hash);
+	while (*cur) {
+		if (*cur == old_ptr) {
+			*cur = new_ptr;
+			return;
+		}
+		cur = &(*cur)->hash_next;
+	}
+}
+
+static inline void index_remove(struct obs_data *data,
+				struct obs_data_item *item)
+{
+	index_replace(data, item->hash, item, item->hash_next);
+	item->hash_next = NULL;
+}
+
+static void index_grow(struct obs_data *data)
+{
+	size_t num_buckets = data->num_buckets ? data->num_buckets
+					       : INDEX_THRESHOLD;
+
+	if (data->num_items <= INDEX_THRESHOLD ||
+	    data->num_items <= data->num_buckets)
+		return;
+
+	while (num_buckets < data->num_items * 2)
+		num_buckets *= 2;
+
+	bfree(data->buckets);
+	data->buckets = bzalloc(num_buckets * sizeof(*data->buckets));
+	data->num_buckets = num_buckets;
+
+	for (struct obs_data_item *item = data->first_item; item;
+	     item = item->next)
+		index_insert(data, item);
+}
+
 static inline void *get_data_ptr(obs_data_item_t *item)
 {
 	return (uint8_t *)get_item_name(item) + item->name_len;
@@ -297,6 +386,7 @@ static struct obs_data_item *obs_data_item_create(const char *name,
 
 	strcpy(get_item_name(item), name);
 	memcpy(get_item_data(item), data, size);
+	item->hash = hash_name(name);
 
 	item_data_addref(item);
 	return item;
@@ -330,6 +420,9 @@ static inline void obs_data_item_detach(struct obs_data_item *item)
 	if (prev_next) {
 		*prev_next = item->next;
 		item->next = NULL;
+
+		index_remove(item->parent, item);
+		item->parent->num_items--;
 	}
 }
 
@@ -339,8 +432,11 @@ static inline void obs_data_item_reattach(struct obs_data_item *old_ptr,
 	struct obs_data_item **prev_next =
 		get_item_prev_next(new_ptr->parent, old_ptr);
 
-	if (prev_next)
+	if (prev_next) {
 		*prev_next = new_ptr;
+		index_replace(new_ptr->parent, new_ptr->hash, old_ptr,
+			      new_ptr);
+	}
 }
 
 static struct obs_data_item *
@@ -470,205 +566,877 @@ obs_data_item_set_autoselect_data(struct obs_data_item **p_item,
 
 /* ------------------------------------------------------------------------- */
 
-static void obs_data_add_json_item(obs_data_t *data, const char *key,
-				   json_t *json);
+/* JSON is read and written directly from/to obs_data rather than going
+ * through a jansson tree, so large files such as scene collections never
+ * exist in memory twice, and files are read and written in chunks.  The
+ * output matches what jansson produced with JSON_PRESERVE_ORDER. */
+
+#define JSON_MAX_DEPTH 2048
+#define JSON_BUFFER_SIZE (64 * 1024)
+
+static struct obs_data_item *get_item(struct obs_data *data,
+				      const char *name);
+
+/* returns the length of the UTF-8 sequence at str, or 0 if invalid */
+static size_t utf8_seq_len(const uint8_t *str, size_t size)
+{
+	uint32_t cp, min;
+	size_t len;
+
+	if (str[0] < 0x80)
+		return 1;
+	else if (str[0] >= 0xC2 && str[0] <= 0xDF)
+		len = 2, cp = str[0] & 0x1F, min = 0x80;
+	else if (str[0] >= 0xE0 && str[0] <= 0xEF)
+		len = 3, cp = str[0] & 0xF, min = 0x800;
+	else if (str[0] >= 0xF0 && str[0] <= 0xF4)
+		len = 4, cp = str[0] & 0x7, min = 0x10000;
+	else
+		return 0;
+
+	if (size < len)
+		return 0;
+
+	for (size_t i = 1; i < len; i++) {
+		if ((str[i] & 0xC0) != 0x80)
+			return 0;
+		cp = (cp << 6) | (str[i] & 0x3F);
+	}
+
+	if (cp < min || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF))
+		return 0;
+
+	return len;
+}
 
-static inline void obs_data_add_json_object_data(obs_data_t *data, json_t *jobj)
+static bool utf8_valid(const char *str)
 {
-	const char *item_key;
-	json_t *jitem;
+	const uint8_t *pos = (const uint8_t *)str;
+	size_t size = strlen(str);
 
-	json_object_foreach (jobj, item_key, jitem) {
-		obs_data_add_json_item(data, item_key, jitem);
+	while (size) {
+		size_t len = utf8_seq_len(pos, size);
+		if (!len)
+			return false;
+
+		pos += len;
+		size -= len;
 	}
+
+	return true;
 }
 
-static inline void obs_data_add_json_object(obs_data_t *data, const char *key,
-					    json_t *jobj)
+static void utf8_cat_codepoint(struct dstr *str, uint32_t cp)
 {
-	obs_data_t *sub_obj = obs_data_create();
+	char seq[4];
+	size_t len;
+
+	if (cp < 0x80) {
+		seq[0] = (char)cp;
+		len = 1;
+	} else if (cp < 0x800) {
+		seq[0] = (char)(0xC0 | (cp >> 6));
+		seq[1] = (char)(0x80 | (cp & 0x3F));
+		len = 2;
+	} else if (cp < 0x10000) {
+		seq[0] = (char)(0xE0 | (cp >> 12));
+		seq[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+		seq[2] = (char)(0x80 | (cp & 0x3F));
+		len = 3;
+	} else {
+		seq[0] = (char)(0xF0 | (cp >> 18));
+		seq[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+		seq[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+		seq[3] = (char)(0x80 | (cp & 0x3F));
+		len = 4;
+	}
 
-	obs_data_add_json_object_data(sub_obj, jobj);
-	obs_data_set_obj(data, key, sub_obj);
-	obs_data_release(sub_obj);
+	dstr_ncat(str, seq, len);
 }
 
-static void obs_data_add_json_array(obs_data_t *data, const char *key,
-				    json_t *jarray)
+static inline void clear_text(struct dstr *str)
 {
-	obs_data_array_t *array = obs_data_array_create();
-	size_t idx;
-	json_t *jitem;
+	str->len = 0;
+	if (str->array)
+		*str->array = 0;
+}
+
+/* ------------------------------------------------------------------------- */
 
-	json_array_foreach (jarray, idx, jitem) {
-		obs_data_t *item;
+struct json_reader {
+	FILE *file;
+	char *file_buf;
+	const char *buf;
+	size_t pos;
+	size_t len;
 
-		if (!json_is_object(jitem))
-			continue;
+	int line;
+	int depth;
+	struct dstr text;
+
+	const char *error;
+	int error_line;
+};
+
+static void json_reader_init_string(struct json_reader *r, const char *str)
+{
+	memset(r, 0, sizeof(*r));
+	r->buf = str;
+	r->len = strlen(str);
+	r->line = 1;
+}
+
+static bool json_reader_fill(struct json_reader *r)
+{
+	const char *nul;
+
+	if (!r->file)
+		return false;
 
-		item = obs_data_create();
-		obs_data_add_json_object_data(item, jitem);
-		obs_data_array_push_back(array, item);
-		obs_data_release(item);
+	r->len = fread(r->file_buf, 1, JSON_BUFFER_SIZE, r->file);
+	r->pos = 0;
+
+	/* files used to be read as a single string, so a nul ends them */
+	nul = memchr(r->file_buf, 0, r->len);
+	if (nul) {
+		r->len = nul - r->file_buf;
+		r->file = NULL;
+	} else if (r->len < JSON_BUFFER_SIZE) {
+		r->file = NULL;
 	}
 
-	obs_data_set_array(data, key, array);
-	obs_data_array_release(array);
+	return r->len != 0;
 }
 
-static void obs_data_add_json_item(obs_data_t *data, const char *key,
-				   json_t *json)
+static void json_reader_init_file(struct json_reader *r, FILE *file)
 {
-	if (json_is_object(json))
-		obs_data_add_json_object(data, key, json);
-	else if (json_is_array(json))
-		obs_data_add_json_array(data, key, json);
-	else if (json_is_string(json))
-		obs_data_set_string(data, key, json_string_value(json));
-	else if (json_is_integer(json))
-		obs_data_set_int(data, key, json_integer_value(json));
-	else if (json_is_real(json))
-		obs_data_set_double(data, key, json_real_value(json));
-	else if (json_is_true(json))
-		obs_data_set_bool(data, key, true);
-	else if (json_is_false(json))
-		obs_data_set_bool(data, key, false);
+	memset(r, 0, sizeof(*r));
+	r->file = file;
+	r->file_buf = bmalloc(JSON_BUFFER_SIZE);
+	r->buf = r->file_buf;
+	r->line = 1;
+
+	if (json_reader_fill(r) && r->len >= 3 &&
+	    memcmp(r->buf, "\xEF\xBB\xBF", 3) == 0)
+		r->pos = 3;
 }
 
-/* ------------------------------------------------------------------------- */
+static void json_reader_free(struct json_reader *r)
+{
+	dstr_free(&r->text);
+	bfree(r->file_buf);
+}
+
+static inline int json_peek(struct json_reader *r)
+{
+	if (r->pos == r->len && !json_reader_fill(r))
+		return EOF;
 
-static inline void set_json_string(json_t *json, const char *name,
-				   obs_data_item_t *item)
+	return (uint8_t)r->buf[r->pos];
+}
+
+static inline int json_next(struct json_reader *r)
 {
-	const char *val = obs_data_item_get_string(item);
-	json_object_set_new(json, name, json_string(val));
+	int c = json_peek(r);
+
+	if (c != EOF) {
+		r->pos++;
+		if (c == '\n')
+			r->line++;
+	}
+
+	return c;
 }
 
-static inline void set_json_number(json_t *json, const char *name,
-				   obs_data_item_t *item)
+static inline int json_skip_space(struct json_reader *r)
 {
-	enum obs_data_number_type type = obs_data_item_numtype(item);
+	int c;
+
+	while ((c = json_peek(r)) == ' ' || c == '\t' || c == '\n' ||
+	       c == '\r')
+		json_next(r);
+
+	return c;
+}
+
+static bool json_fail(struct json_reader *r, const char *error)
+{
+	if (!r->error) {
+		r->error = error;
+		r->error_line = r->line;
+	}
+
+	return false;
+}
+
+static bool json_read_hex4(struct json_reader *r, uint32_t *val)
+{
+	*val = 0;
+
+	for (int i = 0; i < 4; i++) {
+		int c = json_next(r);
+
+		if (c >= '0' && c <= '9')
+			c -= '0';
+		else if (c >= 'a' && c <= 'f')
+			c -= 'a' - 10;
+		else if (c >= 'A' && c <= 'F')
+			c -= 'A' - 10;
+		else
+			return json_fail(r, "invalid escape");
+
+		*val = (*val << 4) | (uint32_t)c;
+	}
+
+	return true;
+}
+
+static bool json_read_unicode_escape(struct json_reader *r, struct dstr *str)
+{
+	uint32_t cp, low;
+
+	if (!json_read_hex4(r, &cp))
+		return false;
+
+	if (cp >= 0xDC00 && cp <= 0xDFFF)
+		return json_fail(r, "invalid Unicode escape");
+
+	if (cp >= 0xD800 && cp <= 0xDBFF) {
+		if (json_next(r) != '\\' || json_next(r) != 'u')
+			return json_fail(r, "invalid Unicode escape");
+		if (!json_read_hex4(r, &low))
+			return false;
+		if (low < 0xDC00 || low > 0xDFFF)
+			return json_fail(r, "invalid Unicode escape");
+
+		cp = 0x10000 + (((cp & 0x3FF) << 10) | (low & 0x3FF));
+	}
+
+	if (!cp)
+		return json_fail(r, "\\u0000 is not allowed");
+
+	utf8_cat_codepoint(str, cp);
+	return true;
+}
+
+static bool json_read_escape(struct json_reader *r, struct dstr *str)
+{
+	int c = json_next(r);
+
+	switch (c) {
+	case '"':
+	case '\\':
+	case '/':
+		dstr_cat_ch(str, (char)c);
+		return true;
+	case 'b':
+		dstr_cat_ch(str, '\b');
+		return true;
+	case 'f':
+		dstr_cat_ch(str, '\f');
+		return true;
+	case 'n':
+		dstr_cat_ch(str, '\n');
+		return true;
+	case 'r':
+		dstr_cat_ch(str, '\r');
+		return true;
+	case 't':
+		dstr_cat_ch(str, '\t');
+		return true;
+	case 'u':
+		return json_read_unicode_escape(r, str);
+	}
+
+	return json_fail(r, "invalid escape");
+}
+
+static bool json_read_utf8(struct json_reader *r, int c, struct dstr *str)
+{
+	uint8_t seq[4];
+	size_t len = 1;
+
+	seq[0] = (uint8_t)c;
+	if (seq[0] >= 0xC2 && seq[0] <= 0xDF)
+		len = 2;
+	else if (seq[0] >= 0xE0 && seq[0] <= 0xEF)
+		len = 3;
+	else if (seq[0] >= 0xF0 && seq[0] <= 0xF4)
+		len = 4;
+
+	for (size_t i = 1; i < len; i++) {
+		c = json_next(r);
+		if (c == EOF)
+			return json_fail(r, "premature end of input");
+		seq[i] = (uint8_t)c;
+	}
+
+	if (utf8_seq_len(seq, len) != len || len == 1)
+		return json_fail(r, "invalid UTF-8");
+
+	dstr_ncat(str, (const char *)seq, len);
+	return true;
+}
+
+/* the opening quote has already been read */
+static bool json_read_string(struct json_reader *r, struct dstr *str)
+{
+	clear_text(str);
+
+	for (;;) {
+		size_t start = r->pos;
+		int c;
+
+		while (r->pos < r->len) {
+			uint8_t ch = (uint8_t)r->buf[r->pos];
+			if (ch == '"' || ch == '\\' || ch < 0x20 || ch >= 0x80)
+				break;
+			r->pos++;
+		}
+
+		if (r->pos != start)
+			dstr_ncat(str, r->buf + start, r->pos - start);
+
+		c = json_next(r);
+		if (c == '"') {
+			break;
+		} else if (c == '\\') {
+			if (!json_read_escape(r, str))
+				return false;
+		} else if (c >= 0x80) {
+			if (!json_read_utf8(r, c, str))
+				return false;
+		} else if (c == EOF) {
+			return json_fail(r, "premature end of input");
+		} else if (c < 0x20) {
+			return json_fail(r, "control character in string");
+		} else {
+			/* the plain run was cut short by the buffer end */
+			dstr_cat_ch(str, (char)c);
+		}
+	}
+
+	if (!str->array)
+		dstr_copy(str, "");
+	return true;
+}
+
+static inline bool is_digit(int c)
+{
+	return c >= '0' && c <= '9';
+}
+
+static bool json_read_digits(struct json_reader *r, struct dstr *str)
+{
+	if (!is_digit(json_peek(r)))
+		return json_fail(r, "invalid number");
+
+	while (is_digit(json_peek(r)))
+		dstr_cat_ch(str, (char)json_next(r));
+	return true;
+}
+
+static double json_strtod(char *str)
+{
+	const char *point = localeconv()->decimal_point;
+	char *dot;
+
+	if (*point != '.' && (dot = strchr(str, '.')) != NULL)
+		*dot = *point;
+
+	return strtod(str, NULL);
+}
+
+static bool json_read_number(struct json_reader *r, obs_data_t *data,
+			     const char *key)
+{
+	struct dstr *str = &r->text;
+	bool real = false;
+
+	clear_text(str);
+
+	if (json_peek(r) == '-')
+		dstr_cat_ch(str, (char)json_next(r));
+
+	if (json_peek(r) == '0') {
+		dstr_cat_ch(str, (char)json_next(r));
+		if (is_digit(json_peek(r)))
+			return json_fail(r, "invalid number");
+	} else if (!json_read_digits(r, str)) {
+		return false;
+	}
+
+	if (json_peek(r) == '.') {
+		dstr_cat_ch(str, (char)json_next(r));
+		if (!json_read_digits(r, str))
+			return false;
+		real = true;
+	}
+
+	if (json_peek(r) == 'e' || json_peek(r) == 'E') {
+		dstr_cat_ch(str, (char)json_next(r));
+		if (json_peek(r) == '+' || json_peek(r) == '-')
+			dstr_cat_ch(str, (char)json_next(r));
+		if (!json_read_digits(r, str))
+			return false;
+		real = true;
+	}
+
+	if (real) {
+		double val = json_strtod(str->array);
+		if (isinf(val))
+			return json_fail(r, "real number overflow");
+		if (data)
+			obs_data_set_double(data, key, val);
 
-	if (type == OBS_DATA_NUM_INT) {
-		long long val = obs_data_item_get_int(item);
-		json_object_set_new(json, name, json_integer(val));
 	} else {
-		double val = obs_data_item_get_double(item);
-		json_object_set_new(json, name, json_real(val));
+		long long val;
+
+		errno = 0;
+		val = strtoll(str->array, NULL, 10);
+		if (errno == ERANGE)
+			return json_fail(r, "too big integer");
+		if (data)
+			obs_data_set_int(data, key, val);
 	}
+
+	return true;
 }
 
-static inline void set_json_bool(json_t *json, const char *name,
-				 obs_data_item_t *item)
+static bool json_read_literal(struct json_reader *r, const char *literal)
 {
-	bool val = obs_data_item_get_bool(item);
-	json_object_set_new(json, name, val ? json_true() : json_false());
+	while (*literal) {
+		if (json_next(r) != *(literal++))
+			return json_fail(r, "invalid token");
+	}
+
+	return true;
 }
 
-static json_t *obs_data_to_json(obs_data_t *data);
-static json_t *obs_data_to_full_json(obs_data_t *data);
+static bool json_read_object(struct json_reader *r, obs_data_t *data);
+static bool json_read_array(struct json_reader *r, obs_data_array_t *array);
 
-static inline void set_json_obj(json_t *json, const char *name,
-				obs_data_item_t *item)
+/* reads a value and stores it in data as key, or discards it if data is
+ * NULL.  as before, null values are dropped. */
+static bool json_read_value(struct json_reader *r, obs_data_t *data,
+			    const char *key)
 {
-	obs_data_t *obj = obs_data_item_get_obj(item);
-	json_object_set_new(json, name, obs_data_to_json(obj));
-	obs_data_release(obj);
+	int c = json_skip_space(r);
+
+	if (c == '{') {
+		obs_data_t *obj = obs_data_create();
+		bool success = json_read_object(r, obj);
+
+		if (success && data)
+			obs_data_set_obj(data, key, obj);
+		obs_data_release(obj);
+		return success;
+
+	} else if (c == '[') {
+		obs_data_array_t *array = data ? obs_data_array_create() : NULL;
+		bool success = json_read_array(r, array);
+
+		if (success && data)
+			obs_data_set_array(data, key, array);
+		obs_data_array_release(array);
+		return success;
+
+	} else if (c == '"') {
+		json_next(r);
+		if (!json_read_string(r, &r->text))
+			return false;
+		if (data)
+			obs_data_set_string(data, key, r->text.array);
+		return true;
+
+	} else if (c == '-' || is_digit(c)) {
+		return json_read_number(r, data, key);
+
+	} else if (c == 't') {
+		if (!json_read_literal(r, "true"))
+			return false;
+		if (data)
+			obs_data_set_bool(data, key, true);
+		return true;
+
+	} else if (c == 'f') {
+		if (!json_read_literal(r, "false"))
+			return false;
+		if (data)
+			obs_data_set_bool(data, key, false);
+		return true;
+
+	} else if (c == 'n') {
+		return json_read_literal(r, "null");
+	}
+
+	return json_fail(r, c == EOF ? "premature end of input"
+				     : "invalid token");
 }
 
-static inline void set_full_json_obj(json_t *json, const char *name,
-				     obs_data_item_t *item)
+static bool json_read_object(struct json_reader *r, obs_data_t *data)
 {
-	obs_data_t *obj = obs_data_item_get_obj(item);
-	json_object_set_new(json, name, obs_data_to_full_json(obj));
-	obs_data_release(obj);
+	struct dstr key = {0};
+	bool success = false;
+	int c;
+
+	json_next(r);
+
+	if (++r->depth > JSON_MAX_DEPTH) {
+		json_fail(r, "maximum parsing depth reached");
+		goto fail;
+	}
+
+	c = json_skip_space(r);
+	if (c == '}') {
+		json_next(r);
+		success = true;
+		goto fail;
+	}
+
+	for (;;) {
+		if (json_next(r) != '"') {
+			json_fail(r, "string or '}' expected");
+			goto fail;
+		}
+		if (!json_read_string(r, &key))
+			goto fail;
+		if (get_item(data, key.array)) {
+			json_fail(r, "duplicate object key");
+			goto fail;
+		}
+
+		if (json_skip_space(r) != ':') {
+			json_fail(r, "':' expected");
+			goto fail;
+		}
+		json_next(r);
+
+		if (!json_read_value(r, data, key.array))
+			goto fail;
+
+		c = json_skip_space(r);
+		json_next(r);
+		if (c == '}')
+			break;
+		if (c != ',') {
+			json_fail(r, "'}' expected");
+			goto fail;
+		}
+
+		json_skip_space(r);
+	}
+
+	success = true;
+
+fail:
+	r->depth--;
+	dstr_free(&key);
+	return success;
 }
 
-static inline void set_json_array(json_t *json, const char *name,
-				  obs_data_item_t *item)
+/* only objects are kept in obs_data arrays, anything else is discarded */
+static bool json_read_array(struct json_reader *r, obs_data_array_t *array)
 {
-	json_t *jarray = json_array();
-	obs_data_array_t *array = obs_data_item_get_array(item);
-	size_t count = obs_data_array_count(array);
+	bool success = false;
+	int c;
 
-	for (size_t idx = 0; idx < count; idx++) {
-		obs_data_t *sub_item = obs_data_array_item(array, idx);
-		json_t *jitem = obs_data_to_json(sub_item);
-		json_array_append_new(jarray, jitem);
-		obs_data_release(sub_item);
+	json_next(r);
+
+	if (++r->depth > JSON_MAX_DEPTH) {
+		json_fail(r, "maximum parsing depth reached");
+		goto fail;
 	}
 
-	json_object_set_new(json, name, jarray);
-	obs_data_array_release(array);
+	c = json_skip_space(r);
+	if (c == ']') {
+		json_next(r);
+		success = true;
+		goto fail;
+	}
+
+	for (;;) {
+		if (array && c == '{') {
+			obs_data_t *obj = obs_data_create();
+			bool obj_success = json_read_object(r, obj);
+
+			if (obj_success)
+				obs_data_array_push_back(array, obj);
+			obs_data_release(obj);
+
+			if (!obj_success)
+				goto fail;
+
+		} else if (!json_read_value(r, NULL, NULL)) {
+			goto fail;
+		}
+
+		c = json_skip_space(r);
+		json_next(r);
+		if (c == ']')
+			break;
+		if (c != ',') {
+			json_fail(r, "']' expected");
+			goto fail;
+		}
+
+		c = json_skip_space(r);
+	}
+
+	success = true;
+
+fail:
+	r->depth--;
+	return success;
+}
+
+static obs_data_t *json_read_root(struct json_reader *r)
+{
+	obs_data_t *data = obs_data_create();
+	int c = json_skip_space(r);
+	bool success;
+
+	/* a root array was accepted before and resulted in empty data */
+	if (c == '{')
+		success = json_read_object(r, data);
+	else if (c == '[')
+		success = json_read_array(r, NULL);
+	else
+		success = json_fail(r, "'[' or '{' expected");
+
+	if (success && json_skip_space(r) != EOF)
+		success = json_fail(r, "end of file expected");
+
+	if (!success) {
+		obs_data_release(data);
+		data = NULL;
+	}
+
+	return data;
+}
+
+/* ------------------------------------------------------------------------- */
+
+struct json_writer {
+	FILE *file;
+	struct dstr buf;
+	bool full;
+	int indent;
+	bool failed;
+};
+
+static void json_writer_flush(struct json_writer *w)
+{
+	if (!w->file || !w->buf.len)
+		return;
+
+	if (fwrite(w->buf.array, 1, w->buf.len, w->file) != w->buf.len)
+		w->failed = true;
+
+	clear_text(&w->buf);
+}
+
+static inline void json_write(struct json_writer *w, const char *str,
+			      size_t len)
+{
+	dstr_ncat(&w->buf, str, len);
+
+	if (w->file && w->buf.len >= JSON_BUFFER_SIZE)
+		json_writer_flush(w);
+}
+
+static inline void json_write_indent(struct json_writer *w, int depth)
+{
+	if (!w->indent)
+		return;
+
+	json_write(w, "\n", 1);
+	for (int i = 0; i < depth * w->indent; i++)
+		json_write(w, " ", 1);
+}
+
+static void json_write_string(struct json_writer *w, const char *str)
+{
+	const char *start = str;
+
+	json_write(w, "\"", 1);
+
+	for (; *str; str++) {
+		uint8_t ch = (uint8_t)*str;
+		char seq[7];
+		const char *esc;
+
+		if (ch != '"' && ch != '\\' && ch >= 0x20)
+			continue;
+
+		json_write(w, start, str - start);
+		start = str + 1;
+
+		switch (ch) {
+		case '"':
+			esc = "\\\"";
+			break;
+		case '\\':
+			esc = "\\\\";
+			break;
+		case '\b':
+			esc = "\\b";
+			break;
+		case '\f':
+			esc = "\\f";
+			break;
+		case '\n':
+			esc = "\\n";
+			break;
+		case '\r':
+			esc = "\\r";
+			break;
+		case '\t':
+			esc = "\\t";
+			break;
+		default:
+			snprintf(seq, sizeof(seq), "\\u%04X", ch);
+			esc = seq;
+		}
+
+		json_write(w, esc, strlen(esc));
+	}
+
+	json_write(w, start, str - start);
+	json_write(w, "\"", 1);
 }
 
-static inline void set_full_json_array(json_t *json, const char *name,
-				       obs_data_item_t *item)
+/* jansson refused to store these, so they were left out of the output */
+static bool json_item_writable(obs_data_item_t *item)
+{
+	enum obs_data_type type = obs_data_item_gettype(item);
+
+	if (!utf8_valid(get_item_name(item)))
+		return false;
+
+	if (type == OBS_DATA_STRING) {
+		const char *str = obs_data_item_get_string(item);
+		return str && utf8_valid(str);
+
+	} else if (type == OBS_DATA_NUMBER) {
+		if (obs_data_item_numtype(item) == OBS_DATA_NUM_INT)
+			return true;
+		return isfinite(obs_data_item_get_double(item));
+	}
+
+	return type != OBS_DATA_NULL;
+}
+
+static void json_write_data(struct json_writer *w, obs_data_t *data,
+			    int depth);
+
+static void json_write_array(struct json_writer *w, obs_data_item_t *item,
+			     int depth)
 {
-	json_t *jarray = json_array();
 	obs_data_array_t *array = obs_data_item_get_array(item);
 	size_t count = obs_data_array_count(array);
 
+	json_write(w, "[", 1);
+
 	for (size_t idx = 0; idx < count; idx++) {
 		obs_data_t *sub_item = obs_data_array_item(array, idx);
-		json_t *jitem = obs_data_to_full_json(sub_item);
-		json_array_append_new(jarray, jitem);
+
+		if (idx)
+			json_write(w, ",", 1);
+		json_write_indent(w, depth + 1);
+		json_write_data(w, sub_item, depth + 1);
 		obs_data_release(sub_item);
 	}
 
-	json_object_set_new(json, name, jarray);
+	if (count)
+		json_write_indent(w, depth);
+	json_write(w, "]", 1);
+
 	obs_data_array_release(array);
 }
 
-static json_t *obs_data_to_json(obs_data_t *data)
+static void json_write_item(struct json_writer *w, obs_data_item_t *item,
+			    int depth)
+{
+	enum obs_data_type type = obs_data_item_gettype(item);
+	char num[64];
+	int len;
+
+	if (type == OBS_DATA_STRING) {
+		json_write_string(w, obs_data_item_get_string(item));
+
+	} else if (type == OBS_DATA_NUMBER) {
+		/* os_dtostr doesn't keep the string terminated when it trims
+		 * the exponent, only the returned length is reliable */
+		if (obs_data_item_numtype(item) == OBS_DATA_NUM_INT)
+			len = snprintf(num, sizeof(num), "%lld",
+				       obs_data_item_get_int(item));
+		else
+			len = os_dtostr(obs_data_item_get_double(item), num,
+					sizeof(num));
+		if (len > 0)
+			json_write(w, num, (size_t)len);
+
+	} else if (type == OBS_DATA_BOOLEAN) {
+		if (obs_data_item_get_bool(item))
+			json_write(w, "true", 4);
+		else
+			json_write(w, "false", 5);
+
+	} else if (type == OBS_DATA_OBJECT) {
+		obs_data_t *obj = obs_data_item_get_obj(item);
+		json_write_data(w, obj, depth);
+		obs_data_release(obj);
+
+	} else if (type == OBS_DATA_ARRAY) {
+		json_write_array(w, item, depth);
+	}
+}
+
+static void json_write_data(struct json_writer *w, obs_data_t *data, int depth)
 {
-	json_t *json = json_object();
 	obs_data_item_t *item = NULL;
+	bool empty = true;
 
-	for (item = obs_data_first(data); item; obs_data_item_next(&item)) {
-		enum obs_data_type type = obs_data_item_gettype(item);
-		const char *name = get_item_name(item);
+	json_write(w, "{", 1);
 
-		if (!obs_data_item_has_user_value(item))
+	for (item = obs_data_first(data); item; obs_data_item_next(&item)) {
+		if (!w->full && !obs_data_item_has_user_value(item))
+			continue;
+		if (!json_item_writable(item))
 			continue;
 
-		if (type == OBS_DATA_STRING)
-			set_json_string(json, name, item);
-		else if (type == OBS_DATA_NUMBER)
-			set_json_number(json, name, item);
-		else if (type == OBS_DATA_BOOLEAN)
-			set_json_bool(json, name, item);
-		else if (type == OBS_DATA_OBJECT)
-			set_json_obj(json, name, item);
-		else if (type == OBS_DATA_ARRAY)
-			set_json_array(json, name, item);
+		if (!empty)
+			json_write(w, ",", 1);
+		json_write_indent(w, depth + 1);
+		json_write_string(w, get_item_name(item));
+		json_write(w, w->indent ? ": " : ":", w->indent ? 2 : 1);
+		json_write_item(w, item, depth + 1);
+		empty = false;
 	}
 
-	return json;
+	if (!empty)
+		json_write_indent(w, depth);
+	json_write(w, "}", 1);
 }
 
-static json_t *obs_data_to_full_json(obs_data_t *data)
+static bool json_write_file(obs_data_t *data, const char *path)
 {
-	json_t *json = json_object();
-	obs_data_item_t *item = NULL;
+	struct json_writer w = {0};
 
-	for (item = obs_data_first(data); item; obs_data_item_next(&item)) {
-		enum obs_data_type type = obs_data_item_gettype(item);
-		const char *name = get_item_name(item);
+	w.file = os_fopen(path, "wb");
+	if (!w.file)
+		return false;
 
-		if (type == OBS_DATA_STRING)
-			set_json_string(json, name, item);
-		else if (type == OBS_DATA_NUMBER)
-			set_json_number(json, name, item);
-		else if (type == OBS_DATA_BOOLEAN)
-			set_json_bool(json, name, item);
-		else if (type == OBS_DATA_OBJECT)
-			set_full_json_obj(json, name, item);
-		else if (type == OBS_DATA_ARRAY)
-			set_full_json_array(json, name, item);
-	}
+	json_write_data(&w, data, 0);
+	json_writer_flush(&w);
 
-	return json;
+	if (fflush(w.file) != 0)
+		w.failed = true;
+	fclose(w.file);
+	dstr_free(&w.buf);
+
+	return !w.failed;
 }
 
 /* ------------------------------------------------------------------------- */
@@ -683,36 +1451,47 @@ obs_data_t *obs_data_create()
 
 obs_data_t *obs_data_create_from_json(const char *json_string)
 {
-	obs_data_t *data = obs_data_create();
+	struct json_reader r;
+	obs_data_t *data;
 
-	json_error_t error;
-	json_t *root = json_loads(json_string, JSON_REJECT_DUPLICATES, &error);
+	json_reader_init_string(&r, json_string);
+	data = json_read_root(&r);
 
-	if (root) {
-		obs_data_add_json_object_data(data, root);
-		json_decref(root);
-	} else {
+	if (!data) {
 		blog(LOG_ERROR,
 		     "obs-data.c: [obs_data_create_from_json] "
 		     "Failed reading json string (%d): %s",
-		     error.line, error.text);
-		obs_data_release(data);
-		data = NULL;
+		     r.error_line, r.error);
 	}
 
+	json_reader_free(&r);
 	return data;
 }
 
 obs_data_t *obs_data_create_from_json_file(const char *json_file)
 {
-	char *file_data = os_quick_read_utf8_file(json_file);
+	FILE *file = os_fopen(json_file, "rb");
+	struct json_reader r;
 	obs_data_t *data = NULL;
 
-	if (file_data) {
-		data = obs_data_create_from_json(file_data);
-		bfree(file_data);
+	if (!file)
+		return NULL;
+
+	json_reader_init_file(&r, file);
+
+	/* empty files are treated like missing ones */
+	if (r.pos != r.len) {
+		data = json_read_root(&r);
+		if (!data) {
+			blog(LOG_ERROR,
+			     "obs-data.c: [obs_data_create_from_json_file] "
+			     "Failed reading json file '%s' (%d): %s",
+			     json_file, r.error_line, r.error);
+		}
 	}
 
+	json_reader_free(&r);
+	fclose(file);
 	return data;
 }
 
@@ -759,12 +1538,18 @@ static inline void obs_data_destroy(struct obs_data *data)
 
 	while (item) {
 		struct obs_data_item *next = item->next;
+
+		/* an item that's still referenced elsewhere outlives its
+		 * parent, so it mustn't try to detach from it later */
+		item->parent = NULL;
+		item->next = NULL;
+		item->hash_next = NULL;
 		obs_data_item_release(&item);
 		item = next;
 	}
 
-	/* NOTE: don't use bfree for json text, allocated by json */
-	free(data->json);
+	bfree(data->json);
+	bfree(data->buckets);
 	bfree(data);
 }
 
@@ -782,14 +1567,12 @@ const char *obs_data_get_json(obs_data_t *data)
 	if (!data)
 		return NULL;
 
-	/* NOTE: don't use libobs bfree for json text */
-	free(data->json);
-	data->json = NULL;
+	struct json_writer w = {0};
 
-	json_t *root = obs_data_to_json(data);
-	data->json = json_dumps(root, JSON_PRESERVE_ORDER | JSON_COMPACT);
-	json_decref(root);
+	json_write_data(&w, data, 0);
 
+	bfree(data->json);
+	data->json = w.buf.array;
 	return data->json;
 }
 
@@ -798,14 +1581,14 @@ const char *obs_data_get_full_json(obs_data_t *data)
 	if (!data)
 		return NULL;
 
-	/* NOTE: don't use libobs bfree for json text */
-	free(data->json);
-	data->json = NULL;
+	struct json_writer w = {0};
 
-	json_t *root = obs_data_to_full_json(data);
-	data->json = json_dumps(root, JSON_PRESERVE_ORDER | JSON_INDENT(4));
-	json_decref(root);
+	w.full = true;
+	w.indent = 4;
+	json_write_data(&w, data, 0);
 
+	bfree(data->json);
+	data->json = w.buf.array;
 	return data->json;
 }
 
@@ -816,27 +1599,52 @@ const char *obs_data_get_last_json(obs_data_t *data)
 
 bool obs_data_save_json(obs_data_t *data, const char *file)
 {
-	const char *json = obs_data_get_json(data);
-
-	if (json && *json) {
-		return os_quick_write_utf8_file(file, json, strlen(json),
-						false);
-	}
-
-	return false;
+	return data ? json_write_file(data, file) : false;
 }
 
 bool obs_data_save_json_safe(obs_data_t *data, const char *file,
 			     const char *temp_ext, const char *backup_ext)
 {
-	const char *json = obs_data_get_json(data);
+	struct dstr backup_path = {0};
+	struct dstr temp_path = {0};
+	bool success = false;
 
-	if (json && *json) {
-		return os_quick_write_utf8_file_safe(
-			file, json, strlen(json), false, temp_ext, backup_ext);
+	if (!data)
+		return false;
+
+	if (!temp_ext || !*temp_ext) {
+		blog(LOG_ERROR, "obs_data_save_json_safe: invalid "
+				"temporary extension specified");
+		return false;
 	}
 
-	return false;
+	dstr_copy(&temp_path, file);
+	if (*temp_ext != '.')
+		dstr_cat(&temp_path, ".");
+	dstr_cat(&temp_path, temp_ext);
+
+	if (!json_write_file(data, temp_path.array)) {
+		blog(LOG_ERROR,
+		     "obs_data_save_json_safe: failed to "
+		     "write to %s",
+		     temp_path.array);
+		goto cleanup;
+	}
+
+	if (backup_ext && *backup_ext) {
+		dstr_copy(&backup_path, file);
+		if (*backup_ext != '.')
+			dstr_cat(&backup_path, ".");
+		dstr_cat(&backup_path, backup_ext);
+	}
+
+	if (os_safe_replace(file, temp_path.array, backup_path.array) == 0)
+		success = true;
+
+cleanup:
+	dstr_free(&backup_path);
+	dstr_free(&temp_path);
+	return success;
 }
 
 static void get_defaults_array_cb(obs_data_t *data, void *vp)
@@ -936,6 +1744,21 @@ static struct obs_data_item *get_item(struct obs_data *data, const char *name)
 	if (!data)
 		return NULL;
 
+	if (data->buckets) {
+		const uint32_t hash = hash_name(name);
+		struct obs_data_item *item = *get_bucket(data, hash);
+
+		while (item) {
+			if (item->hash == hash &&
+			    strcmp(get_item_name(item), name) == 0)
+				return item;
+
+			item = item->hash_next;
+		}
+
+		return NULL;
+	}
+
 	struct obs_data_item *item = data->first_item;
 
 	while (item) {
@@ -984,6 +1807,10 @@ static void set_item_data(struct obs_data *data, struct obs_data_item **item,
 		obs_data_item_release(&prev);
 		obs_data_item_release(&next);
 
+		data->num_items++;
+		index_insert(data, new_item);
+		index_grow(data);
+
 	} else if (default_data) {
 		obs_data_item_set_default_data(item, ptr, size, type);
 	} else if (autoselect_data) {
@@ -61,6 +61,7 @@ bool obs_display_init(struct obs_display *display,
 	}
 
 	display->enabled = true;
+	display->redraw = true;
 	return true;
 }
 
@@ -159,6 +160,8 @@ void obs_display_add_draw_callback(obs_display_t *display,
 	pthread_mutex_lock(&display->draw_callbacks_mutex);
 	da_push_back(display->draw_callbacks, &data);
 	pthread_mutex_unlock(&display->draw_callbacks_mutex);
+
+	os_atomic_set_bool(&display->redraw, true);
 }
 
 void obs_display_remove_draw_callback(obs_display_t *display,
@@ -174,6 +177,8 @@ void obs_display_remove_draw_callback(obs_display_t *display,
 	pthread_mutex_lock(&display->draw_callbacks_mutex);
 	da_erase_item(display->draw_callbacks, &data);
 	pthread_mutex_unlock(&display->draw_callbacks_mutex);
+
+	os_atomic_set_bool(&display->redraw, true);
 }
 
 static inline bool render_display_begin(struct obs_display *display,
@@ -236,6 +241,26 @@ static inline void render_display_end()
 	gs_end_scene();
 }
 
+/* a display with a lower rate renders on the output frame nearest to when
+ * it's due, on demand displays only render when something changed */
+static bool display_render_due(struct obs_display *display, uint32_t cx,
+			       uint32_t cy, bool update_color_space)
+{
+	const uint64_t now = obs->video.video_time;
+	const uint64_t slack = obs->video.video_frame_interval_ns / 2;
+	const bool changed = update_color_space || display->cx != cx ||
+			     display->cy != cy;
+
+	if (os_atomic_set_bool(&display->redraw, false) || changed)
+		return true;
+	if (display->on_demand)
+		return false;
+
+	return !display->render_interval_ns ||
+	       now - display->last_render_time + slack >=
+		       display->render_interval_ns;
+}
+
 void render_display(struct obs_display *display)
 {
 	uint32_t cx, cy;
@@ -252,7 +277,13 @@ void render_display(struct obs_display *display)
 	cy = display->next_cy;
 	update_color_space = display->update_color_space;
 
+	if (!display_render_due(display, cx, cy, update_color_space)) {
+		pthread_mutex_unlock(&display->draw_info_mutex);
+		return;
+	}
+
 	display->update_color_space = false;
+	display->last_render_time = obs->video.video_time;
 
 	pthread_mutex_unlock(&display->draw_info_mutex);
 
@@ -291,6 +322,35 @@ bool obs_display_enabled(obs_display_t *display)
 	return display ? display->enabled : false;
 }
 
+void obs_display_set_max_fps(obs_display_t *display, double fps)
+{
+	if (!display)
+		return;
+
+	pthread_mutex_lock(&display->draw_info_mutex);
+	display->render_interval_ns =
+		fps > 0.0 ? (uint64_t)(1000000000.0 / fps) : 0;
+	pthread_mutex_unlock(&display->draw_info_mutex);
+}
+
+void obs_display_set_on_demand(obs_display_t *display, bool on_demand)
+{
+	if (!display)
+		return;
+
+	pthread_mutex_lock(&display->draw_info_mutex);
+	display->on_demand = on_demand;
+	pthread_mutex_unlock(&display->draw_info_mutex);
+
+	os_atomic_set_bool(&display->redraw, true);
+}
+
+void obs_display_request_redraw(obs_display_t *display)
+{
+	if (display)
+		os_atomic_set_bool(&display->redraw, true);
+}
+
 void obs_display_set_background_color(obs_display_t *display, uint32_t color)
 {
 	if (display)
@@ -15,6 +15,8 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 ******************************************************************************/
 
+#include <inttypes.h>
+
 #include "obs.h"
 #include "obs-internal.h"
 #include "util/util_uint64.h"
@@ -50,6 +52,7 @@ static bool init_encoder(struct obs_encoder *encoder, const char *name,
 	pthread_mutex_init_value(&encoder->callbacks_mutex);
 	pthread_mutex_init_value(&encoder->outputs_mutex);
 	pthread_mutex_init_value(&encoder->pause.mutex);
+	pthread_mutex_init_value(&encoder->audio_frames_mutex);
 
 	if (!obs_context_data_init(&encoder->context, OBS_OBJ_TYPE_ENCODER,
 				   settings, name, hotkey_data, false))
@@ -62,6 +65,10 @@ static bool init_encoder(struct obs_encoder *encoder, const char *name,
 		return false;
 	if (pthread_mutex_init(&encoder->pause.mutex, NULL) != 0)
 		return false;
+	if (pthread_mutex_init(&encoder->audio_frames_mutex, NULL) != 0)
+		return false;
+
+	obs_heartbeat_init(&encoder->encode_heartbeat, "encoder", name);
 
 	if (encoder->orig_info.get_defaults) {
 		encoder->orig_info.get_defaults(encoder->context.settings);
@@ -110,7 +117,8 @@ create_encoder(const char *id, enum obs_encoder_type type, const char *name,
 	obs_context_init_control(&encoder->context, encoder,
 				 (obs_destroy_cb)obs_encoder_destroy);
 	obs_context_data_insert(&encoder->context, &obs->data.encoders_mutex,
-				&obs->data.first_encoder);
+				&obs->data.first_encoder,
+				&obs->data.encoder_index);
 
 	blog(LOG_DEBUG, "encoder '%s' (%s) created (0x%I64X)", name, id,
 	     encoder);
@@ -139,6 +147,14 @@ obs_encoder_t *obs_audio_encoder_create(const char *id, const char *name,
 
 static void receive_video(void *param, struct video_data *frame);
 static void receive_audio(void *param, size_t mix_idx, struct audio_data *data);
+static void finish_audio_frames(struct obs_encoder *encoder);
+
+/* a frame of audio waiting to be encoded, with its planes one after another */
+struct encoder_audio_frame {
+	uint8_t *data;
+	int64_t pts;
+	uint64_t queued_ts;
+};
 
 static inline void get_audio_info(const struct obs_encoder *encoder,
 				  struct audio_convert_info *info)
@@ -193,12 +209,223 @@ static inline bool gpu_encode_available(const struct obs_encoder *encoder)
 		encoder->video->using_nv12_tex);
 }
 
+static inline void obs_encoder_start_internal(
+	obs_encoder_t *encoder,
+	void (*new_packet)(void *param, struct encoder_packet *packet),
+	void *param);
+static inline bool obs_encoder_stop_internal(
+	obs_encoder_t *encoder,
+	void (*new_packet)(void *param, struct encoder_packet *packet),
+	void *param);
+static inline void send_packet(struct obs_encoder *encoder,
+			       struct encoder_callback *cb,
+			       struct encoder_packet *packet);
+
+/* ------------------------------------------------------------------------- */
+/* shared audio encoding                                                      */
+
+static bool outputs_can_pause(struct obs_encoder *encoder)
+{
+	bool can_pause = false;
+
+	pthread_mutex_lock(&encoder->outputs_mutex);
+	for (size_t i = 0; i < encoder->outputs.num; i++) {
+		struct obs_output *output = encoder->outputs.array[i];
+		if ((output->info.flags & OBS_OUTPUT_CAN_PAUSE) != 0) {
+			can_pause = true;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&encoder->outputs_mutex);
+
+	return can_pause;
+}
+
+/* pausing a leader would cut the audio of every encoder sharing it, so only
+ * encoders whose outputs can't pause are shared */
+static inline bool can_share_audio(struct obs_encoder *leader,
+				   struct obs_encoder *encoder)
+{
+	if (leader == encoder || leader->info.type != OBS_ENCODER_AUDIO)
+		return false;
+	if (!encoder_active(leader) || leader->shared_leader)
+		return false;
+	if (leader->media != encoder->media ||
+	    leader->mixer_idx != encoder->mixer_idx)
+		return false;
+	if (strcmp(leader->info.id, encoder->info.id) != 0)
+		return false;
+	if (strcmp(obs_data_get_json(leader->context.settings),
+		   obs_data_get_json(encoder->context.settings)) != 0)
+		return false;
+
+	return !outputs_can_pause(leader);
+}
+
+static struct obs_encoder *find_shared_audio(struct obs_encoder *encoder)
+{
+	struct obs_encoder *leader;
+
+	pthread_mutex_lock(&obs->data.encoders_mutex);
+
+	leader = obs->data.first_encoder;
+	while (leader) {
+		if (can_share_audio(leader, encoder))
+			break;
+		leader = (struct obs_encoder *)leader->context.next;
+	}
+
+	pthread_mutex_unlock(&obs->data.encoders_mutex);
+	return leader;
+}
+
+/* shared packets arrive with the leader's timeline, so time spent paused on
+ * this encoder is cut out of the packets here instead of the raw audio */
+static bool shared_pause_check(struct obs_encoder *encoder,
+			       struct encoder_packet *pkt)
+{
+	struct pause_data *pause = &encoder->pause;
+	uint64_t ts = (uint64_t)pkt->dts_usec * 1000;
+	bool paused = false;
+
+	pthread_mutex_lock(&pause->mutex);
+	if (pause->ts_start && ts >= pause->ts_start) {
+		if (!pause->ts_end || ts < pause->ts_end) {
+			paused = true;
+		} else {
+			pause->ts_start = 0;
+			pause->ts_end = 0;
+		}
+	}
+	pthread_mutex_unlock(&pause->mutex);
+
+	if (paused) {
+		encoder->shared_pts_offset +=
+			util_mul_div64(encoder->framesize, pkt->timebase_den,
+				       (uint64_t)encoder->samplerate *
+					       pkt->timebase_num);
+		encoder->shared_dts_usec_offset += util_mul_div64(
+			encoder->framesize, 1000000ULL, encoder->samplerate);
+	}
+
+	return paused;
+}
+
+static void receive_shared_packet(void *param, struct encoder_packet *packet)
+{
+	struct obs_encoder *encoder = param;
+	struct encoder_packet pkt = *packet;
+
+	if (shared_pause_check(encoder, &pkt))
+		return;
+
+	pkt.encoder = encoder;
+	pkt.pts -= encoder->shared_pts_offset;
+	pkt.dts -= encoder->shared_pts_offset;
+	pkt.dts_usec -= encoder->shared_dts_usec_offset;
+
+	pthread_mutex_lock(&encoder->callbacks_mutex);
+
+	for (size_t i = encoder->callbacks.num; i > 0; i--) {
+		struct encoder_callback *cb;
+		cb = encoder->callbacks.array + (i - 1);
+		send_packet(encoder, cb, &pkt);
+	}
+
+	pthread_mutex_unlock(&encoder->callbacks_mutex);
+}
+
+static bool attach_shared_audio(struct obs_encoder *encoder)
+{
+	struct obs_encoder *leader = find_shared_audio(encoder);
+	struct obs_encoder *video = encoder->paired_encoder;
+
+	if (!leader)
+		return false;
+
+	pthread_mutex_lock(&leader->init_mutex);
+	if (!encoder_active(leader) || !leader->context.data) {
+		pthread_mutex_unlock(&leader->init_mutex);
+		return false;
+	}
+
+	encoder->shared_leader = leader;
+	encoder->shared_pts_offset = 0;
+	encoder->shared_dts_usec_offset = 0;
+	obs_encoder_start_internal(leader, receive_shared_packet, encoder);
+	pthread_mutex_unlock(&leader->init_mutex);
+
+	/* the leader is already running, so there's nothing to sync the start
+	 * of the paired video encoder with; outputs trim early audio instead */
+	if (video) {
+		pthread_mutex_lock(&video->init_mutex);
+		video->paired_encoder = NULL;
+		pthread_mutex_unlock(&video->init_mutex);
+
+		encoder->paired_encoder = NULL;
+		encoder->wait_for_video = false;
+	}
+
+	blog(LOG_INFO, "audio encoder '%s' shares packets of '%s'",
+	     encoder->context.name, leader->context.name);
+	return true;
+}
+
+static void detach_shared_audio(struct obs_encoder *encoder)
+{
+	struct obs_encoder *leader = encoder->shared_leader;
+
+	encoder->shared_leader = NULL;
+
+	pthread_mutex_lock(&leader->init_mutex);
+	if (!obs_encoder_stop_internal(leader, receive_shared_packet, encoder))
+		pthread_mutex_unlock(&leader->init_mutex);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* with GPU scaling, raw frames come from a mix of their own that's rendered
+ * at the scaled resolution instead of being rescaled by video-io */
+static video_t *raw_video_output(struct obs_encoder *encoder,
+				 struct video_scale_info *info)
+{
+	struct obs_core_video_mix *mix;
+
+	if (encoder->gpu_scale_type == OBS_SCALE_DISABLE ||
+	    !has_scaling(encoder))
+		return encoder->media;
+
+	mix = obs_create_scaled_video_mix(encoder->media, info->width,
+					  info->height,
+					  encoder->gpu_scale_type);
+	if (!mix) {
+		blog(LOG_WARNING,
+		     "encoder '%s': Failed to create GPU scaled mix, "
+		     "scaling on the CPU instead",
+		     obs_encoder_get_name(encoder));
+		return encoder->media;
+	}
+
+	encoder->gpu_scale_mix = mix;
+	return mix->video;
+}
+
 static void add_connection(struct obs_encoder *encoder)
 {
 	if (encoder->info.type == OBS_ENCODER_AUDIO) {
 		struct audio_convert_info audio_info = {0};
+
+		if (attach_shared_audio(encoder)) {
+			set_encoder_active(encoder, true);
+			return;
+		}
+
 		get_audio_info(encoder, &audio_info);
 
+		/* without a queue, frames are encoded on the audio thread */
+		if (!encoder->audio_encode_queue)
+			encoder->audio_encode_queue = os_task_queue_create();
+
 		audio_output_connect(encoder->media, encoder->mixer_idx,
 				     &audio_info, receive_audio, encoder);
 	} else {
@@ -208,8 +435,11 @@ static void add_connection(struct obs_encoder *encoder)
 		if (gpu_encode_available(encoder)) {
 			start_gpu_encode(encoder);
 		} else {
-			start_raw_video(encoder->media, &info, receive_video,
-					encoder);
+			video_t *video = raw_video_output(encoder, &info);
+
+			if (encoder->info.caps & OBS_ENCODER_CAP_STATIC_FRAMES)
+				video_output_inc_static_detection(video);
+			start_raw_video(video, &info, receive_video, encoder);
 		}
 	}
 
@@ -218,14 +448,27 @@ static void add_connection(struct obs_encoder *encoder)
 
 static void remove_connection(struct obs_encoder *encoder, bool shutdown)
 {
-	if (encoder->info.type == OBS_ENCODER_AUDIO) {
+	if (encoder->shared_leader) {
+		detach_shared_audio(encoder);
+	} else if (encoder->info.type == OBS_ENCODER_AUDIO) {
 		audio_output_disconnect(encoder->media, encoder->mixer_idx,
 					receive_audio, encoder);
+		finish_audio_frames(encoder);
 	} else {
 		if (gpu_encode_available(encoder)) {
 			stop_gpu_encode(encoder);
 		} else {
-			stop_raw_video(encoder->media, receive_video, encoder);
+			struct obs_core_video_mix *mix = encoder->gpu_scale_mix;
+			video_t *video = mix ? mix->video : encoder->media;
+
+			stop_raw_video(video, receive_video, encoder);
+			if (encoder->info.caps & OBS_ENCODER_CAP_STATIC_FRAMES)
+				video_output_dec_static_detection(video);
+
+			if (mix) {
+				obs_remove_scaled_video_mix(mix);
+				encoder->gpu_scale_mix = NULL;
+			}
 		}
 	}
 
@@ -241,11 +484,22 @@ static void remove_connection(struct obs_encoder *encoder, bool shutdown)
 
 static inline void free_audio_buffers(struct obs_encoder *encoder)
 {
-	for (size_t i = 0; i < MAX_AV_PLANES; i++) {
+	for (size_t i = 0; i < MAX_AV_PLANES; i++)
 		circlebuf_free(&encoder->audio_input_buffer[i]);
-		bfree(encoder->audio_output_buffer[i]);
-		encoder->audio_output_buffer[i] = NULL;
+
+	pthread_mutex_lock(&encoder->audio_frames_mutex);
+	while (encoder->audio_frames.size) {
+		struct encoder_audio_frame frame;
+		circlebuf_pop_front(&encoder->audio_frames, &frame,
+				    sizeof(frame));
+		bfree(frame.data);
 	}
+	circlebuf_free(&encoder->audio_frames);
+
+	for (size_t i = 0; i < encoder->audio_frame_pool.num; i++)
+		bfree(encoder->audio_frame_pool.array[i]);
+	da_free(encoder->audio_frame_pool);
+	pthread_mutex_unlock(&encoder->audio_frames_mutex);
 }
 
 static void obs_encoder_actually_destroy(obs_encoder_t *encoder)
@@ -262,6 +516,7 @@ static void obs_encoder_actually_destroy(obs_encoder_t *encoder)
 		blog(LOG_DEBUG, "encoder '%s' destroyed (0x%I64X)",
 		     encoder->context.name, encoder);
 
+		os_task_queue_destroy(encoder->audio_encode_queue);
 		free_audio_buffers(encoder);
 
 		if (encoder->context.data)
@@ -271,6 +526,9 @@ static void obs_encoder_actually_destroy(obs_encoder_t *encoder)
 		pthread_mutex_destroy(&encoder->callbacks_mutex);
 		pthread_mutex_destroy(&encoder->outputs_mutex);
 		pthread_mutex_destroy(&encoder->pause.mutex);
+		pthread_mutex_destroy(&encoder->audio_frames_mutex);
+		if (encoder->encode_heartbeat.name)
+			obs_heartbeat_free(&encoder->encode_heartbeat);
 		obs_context_data_free(&encoder->context);
 		if (encoder->owns_info_id)
 			bfree((void *)encoder->info.id);
@@ -426,11 +684,10 @@ obs_data_t *obs_encoder_get_settings(const obs_encoder_t *encoder)
 
 static inline void reset_audio_buffers(struct obs_encoder *encoder)
 {
+	/* pooled frames may have the size of a previous configuration */
 	free_audio_buffers(encoder);
-
-	for (size_t i = 0; i < encoder->planes; i++)
-		encoder->audio_output_buffer[i] =
-			bmalloc(encoder->framesize_bytes);
+	encoder->audio_frames_dropped = 0;
+	encoder->audio_latency_ns = 0;
 }
 
 static void intitialize_audio_encoder(struct obs_encoder *encoder)
@@ -710,6 +967,38 @@ bool obs_encoder_scaling_enabled(const obs_encoder_t *encoder)
 	return encoder->scaled_width || encoder->scaled_height;
 }
 
+void obs_encoder_set_gpu_scale_type(obs_encoder_t *encoder,
+				    enum obs_scale_type gpu_scale_type)
+{
+	if (!obs_encoder_valid(encoder, "obs_encoder_set_gpu_scale_type"))
+		return;
+	if (encoder->info.type != OBS_ENCODER_VIDEO) {
+		blog(LOG_WARNING,
+		     "obs_encoder_set_gpu_scale_type: "
+		     "encoder '%s' is not a video encoder",
+		     obs_encoder_get_name(encoder));
+		return;
+	}
+	if (encoder_active(encoder)) {
+		blog(LOG_WARNING,
+		     "encoder '%s': Cannot change GPU scaling "
+		     "while the encoder is active",
+		     obs_encoder_get_name(encoder));
+		return;
+	}
+
+	encoder->gpu_scale_type = gpu_scale_type;
+}
+
+enum obs_scale_type
+obs_encoder_get_gpu_scale_type(const obs_encoder_t *encoder)
+{
+	if (!obs_encoder_valid(encoder, "obs_encoder_get_gpu_scale_type"))
+		return OBS_SCALE_DISABLE;
+
+	return encoder->gpu_scale_type;
+}
+
 uint32_t obs_encoder_get_width(const obs_encoder_t *encoder)
 {
 	if (!obs_encoder_valid(encoder, "obs_encoder_get_width"))
@@ -897,6 +1186,7 @@ static void send_first_video_packet(struct obs_encoder *encoder,
 	first_packet = *packet;
 	first_packet.data = data.array;
 	first_packet.size = data.num;
+	first_packet.refcounted = false;
 
 	cb->new_packet(cb->param, &first_packet);
 	cb->sent_first_packet = true;
@@ -932,15 +1222,37 @@ void full_stop(struct obs_encoder *encoder)
 		}
 		pthread_mutex_unlock(&encoder->outputs_mutex);
 
+		DARRAY(struct obs_encoder *) shared;
+		da_init(shared);
+
 		pthread_mutex_lock(&encoder->callbacks_mutex);
+		for (size_t i = 0; i < encoder->callbacks.num; i++) {
+			struct encoder_callback *cb = &encoder->callbacks.array[i];
+			if (cb->new_packet == receive_shared_packet)
+				da_push_back(shared, &cb->param);
+		}
 		da_free(encoder->callbacks);
 		pthread_mutex_unlock(&encoder->callbacks_mutex);
 
+		/* encoders sharing this one's packets stop along with it */
+		for (size_t i = 0; i < shared.num; i++) {
+			shared.array[i]->shared_leader = NULL;
+			full_stop(shared.array[i]);
+		}
+		da_free(shared);
+
 		remove_connection(encoder, false);
 		encoder->initialized = false;
 	}
 }
 
+static inline void obs_encoder_packet_release_data(struct encoder_packet *pkt)
+{
+	packet_data_release(pkt->data);
+	pkt->data = NULL;
+	pkt->refcounted = false;
+}
+
 void send_off_encoder_packet(obs_encoder_t *encoder, bool success,
 			     bool received, struct encoder_packet *pkt)
 {
@@ -948,7 +1260,7 @@ void send_off_encoder_packet(obs_encoder_t *encoder, bool success,
 		blog(LOG_ERROR, "Error encoding with encoder '%s'",
 		     encoder->context.name);
 		full_stop(encoder);
-		return;
+		goto release;
 	}
 
 	if (received) {
@@ -969,6 +1281,13 @@ void send_off_encoder_packet(obs_encoder_t *encoder, bool success,
 
 		pthread_mutex_lock(&encoder->callbacks_mutex);
 
+		/* copy the data once for all outputs rather than once each */
+		if (!pkt->refcounted && encoder->callbacks.num > 1) {
+			struct encoder_packet copy;
+			obs_encoder_packet_create_instance(&copy, pkt);
+			*pkt = copy;
+		}
+
 		for (size_t i = encoder->callbacks.num; i > 0; i--) {
 			struct encoder_callback *cb;
 			cb = encoder->callbacks.array + (i - 1);
@@ -977,6 +1296,12 @@ void send_off_encoder_packet(obs_encoder_t *encoder, bool success,
 
 		pthread_mutex_unlock(&encoder->callbacks_mutex);
 	}
+
+release:
+	/* the encoder's reference to data from obs_encoder_packet_alloc is
+	 * handed over to libobs along with the packet */
+	if (pkt->refcounted)
+		obs_encoder_packet_release_data(pkt);
 }
 
 static const char *do_encode_name = "do_encode";
@@ -1002,10 +1327,15 @@ bool do_encode(struct obs_encoder *encoder, struct encoder_frame *frame)
 	pkt.timebase_den = encoder->timebase_den;
 	pkt.encoder = encoder;
 
+	uint64_t start = os_gettime_ns();
+
 	profile_start(encoder->profile_encoder_encode_name);
+	obs_heartbeat_begin(&encoder->encode_heartbeat);
 	success = encoder->info.encode(encoder->context.data, frame, &pkt,
 				       &received);
+	obs_heartbeat_end(&encoder->encode_heartbeat);
 	profile_end(encoder->profile_encoder_encode_name);
+	obs_encoder_update_encode_time(encoder, start);
 	send_off_encoder_packet(encoder, success, received, &pkt);
 
 	profile_end(do_encode_name);
@@ -1074,6 +1404,9 @@ static void receive_video(void *param, struct video_data *frame)
 
 	enc_frame.frames = 1;
 	enc_frame.pts = encoder->cur_pts;
+	enc_frame.flags =
+		frame->flags | obs_encoder_take_keyframe_request(encoder);
+	enc_frame.transition_progress = frame->transition_progress;
 
 	if (do_encode(encoder, &enc_frame))
 		encoder->cur_pts += encoder->timebase_num;
@@ -1186,29 +1519,115 @@ fail:
 	return success;
 }
 
-static bool send_audio_data(struct obs_encoder *encoder)
+/* about a second of audio; past this the encoder can't keep up, and it's
+ * better to drop its oldest frames than to grow without bound */
+#define MAX_QUEUED_AUDIO_SEC 1
+
+/* runs on the audio encode queue, or on the audio thread without one */
+static void encode_audio_frames(void *param)
 {
-	struct encoder_frame enc_frame;
+	struct obs_encoder *encoder = param;
+	struct encoder_audio_frame frame;
 
-	memset(&enc_frame, 0, sizeof(struct encoder_frame));
+	for (;;) {
+		pthread_mutex_lock(&encoder->audio_frames_mutex);
+		if (!encoder->audio_frames.size) {
+			pthread_mutex_unlock(&encoder->audio_frames_mutex);
+			break;
+		}
+		circlebuf_pop_front(&encoder->audio_frames, &frame,
+				    sizeof(frame));
+		pthread_mutex_unlock(&encoder->audio_frames_mutex);
+
+		/* frames left over after an encode error are discarded */
+		if (encoder_active(encoder) && encoder->context.data) {
+			struct encoder_frame enc_frame = {0};
+
+			for (size_t i = 0; i < encoder->planes; i++) {
+				enc_frame.data[i] =
+					frame.data +
+					i * encoder->framesize_bytes;
+				enc_frame.linesize[i] =
+					(uint32_t)encoder->framesize_bytes;
+			}
+
+			enc_frame.frames = (uint32_t)encoder->framesize;
+			enc_frame.pts = frame.pts;
+
+			do_encode(encoder, &enc_frame);
+
+			uint64_t ns = os_gettime_ns() - frame.queued_ts;
+			uint64_t avg = encoder->audio_latency_ns;
+			encoder->audio_latency_ns =
+				avg ? (avg * 15 + ns) / 16 : ns;
+		}
+
+		pthread_mutex_lock(&encoder->audio_frames_mutex);
+		da_push_back(encoder->audio_frame_pool, &frame.data);
+		pthread_mutex_unlock(&encoder->audio_frames_mutex);
+	}
+}
+
+/* the audio thread's part of encoding: copy a frame out of the input
+ * buffer and queue it */
+static void queue_audio_frame(struct obs_encoder *encoder, uint64_t ts)
+{
+	const size_t max_frames = encoder->samplerate * MAX_QUEUED_AUDIO_SEC /
+				  encoder->framesize;
+	struct encoder_audio_frame frame = {NULL, encoder->cur_pts, ts};
+	struct encoder_audio_frame old;
+	bool dropped = false;
+
+	pthread_mutex_lock(&encoder->audio_frames_mutex);
+	if (encoder->audio_frame_pool.num) {
+		frame.data = *(uint8_t **)da_end(encoder->audio_frame_pool);
+		da_pop_back(encoder->audio_frame_pool);
+	}
+	pthread_mutex_unlock(&encoder->audio_frames_mutex);
+
+	if (!frame.data)
+		frame.data =
+			bmalloc(encoder->framesize_bytes * encoder->planes);
 
-	for (size_t i = 0; i < encoder->planes; i++) {
+	for (size_t i = 0; i < encoder->planes; i++)
 		circlebuf_pop_front(&encoder->audio_input_buffer[i],
-				    encoder->audio_output_buffer[i],
+				    frame.data + i * encoder->framesize_bytes,
 				    encoder->framesize_bytes);
 
-		enc_frame.data[i] = encoder->audio_output_buffer[i];
-		enc_frame.linesize[i] = (uint32_t)encoder->framesize_bytes;
+	encoder->cur_pts += encoder->framesize;
+
+	pthread_mutex_lock(&encoder->audio_frames_mutex);
+	if (encoder->audio_frames.size >= max_frames * sizeof(frame)) {
+		circlebuf_pop_front(&encoder->audio_frames, &old, sizeof(old));
+		da_push_back(encoder->audio_frame_pool, &old.data);
+		dropped = encoder->audio_frames_dropped++ == 0;
 	}
+	circlebuf_push_back(&encoder->audio_frames, &frame, sizeof(frame));
+	pthread_mutex_unlock(&encoder->audio_frames_mutex);
 
-	enc_frame.frames = (uint32_t)encoder->framesize;
-	enc_frame.pts = encoder->cur_pts;
+	if (dropped)
+		blog(LOG_WARNING,
+		     "audio encoder '%s' can't keep up, "
+		     "dropping audio frames",
+		     encoder->context.name);
+}
 
-	if (!do_encode(encoder, &enc_frame))
-		return false;
+/* encodes whatever is still queued once the audio thread has let go of the
+ * encoder */
+static void finish_audio_frames(struct obs_encoder *encoder)
+{
+	os_task_queue_t *queue = encoder->audio_encode_queue;
 
-	encoder->cur_pts += encoder->framesize;
-	return true;
+	/* on encode errors this is called from the queue itself */
+	if (queue && !os_task_queue_inside(queue))
+		os_task_queue_wait(queue);
+
+	if (encoder->audio_frames_dropped) {
+		blog(LOG_WARNING, "audio encoder '%s' dropped %" PRIu64
+				  " frames it couldn't encode in time",
+		     encoder->context.name, encoder->audio_frames_dropped);
+		encoder->audio_frames_dropped = 0;
+	}
 }
 
 static void pause_audio(struct pause_data *pause, struct audio_data *data,
@@ -1303,12 +1722,17 @@ static void receive_audio(void *param, size_t mix_idx, struct audio_data *in)
 	if (!buffer_audio(encoder, &audio))
 		goto end;
 
+	if (encoder->audio_input_buffer[0].size < encoder->framesize_bytes)
+		goto end;
+
+	uint64_t ts = os_gettime_ns();
 	while (encoder->audio_input_buffer[0].size >=
-	       encoder->framesize_bytes) {
-		if (!send_audio_data(encoder)) {
-			break;
-		}
-	}
+	       encoder->framesize_bytes)
+		queue_audio_frame(encoder, ts);
+
+	if (!os_task_queue_queue_task(encoder->audio_encode_queue,
+				      encode_audio_frames, encoder))
+		encode_audio_frames(encoder);
 
 	UNUSED_PARAMETER(mix_idx);
 
@@ -1341,15 +1765,33 @@ void obs_encoder_remove_output(struct obs_encoder *encoder,
 void obs_encoder_packet_create_instance(struct encoder_packet *dst,
 					const struct encoder_packet *src)
 {
-	long *p_refs;
+	/* packet data that's already reference counted is shared between
+	 * outputs instead of copied */
+	if (src->refcounted) {
+		obs_encoder_packet_ref(dst, (struct encoder_packet *)src);
+		return;
+	}
 
 	*dst = *src;
-	p_refs = bmalloc(src->size + sizeof(long));
-	dst->data = (void *)(p_refs + 1);
-	*p_refs = 1;
+	dst->data = packet_pool_alloc(src->size);
+	dst->refcounted = true;
 	memcpy(dst->data, src->data, src->size);
 }
 
+uint8_t *obs_encoder_packet_alloc(struct encoder_packet *packet, size_t size)
+{
+	if (!obs_ptr_valid(packet, "obs_encoder_packet_alloc"))
+		return NULL;
+
+	if (packet->refcounted)
+		obs_encoder_packet_release_data(packet);
+
+	packet->data = packet_pool_alloc(size);
+	packet->size = size;
+	packet->refcounted = true;
+	return packet->data;
+}
+
 /* OBS_DEPRECATED */
 void obs_duplicate_encoder_packet(struct encoder_packet *dst,
 				  const struct encoder_packet *src)
@@ -1369,10 +1811,8 @@ void obs_encoder_packet_ref(struct encoder_packet *dst,
 	if (!src)
 		return;
 
-	if (src->data) {
-		long *p_refs = ((long *)src->data) - 1;
-		os_atomic_inc_long(p_refs);
-	}
+	if (src->data)
+		packet_data_addref(src->data);
 
 	*dst = *src;
 }
@@ -1382,11 +1822,8 @@ void obs_encoder_packet_release(struct encoder_packet *pkt)
 	if (!pkt)
 		return;
 
-	if (pkt->data) {
-		long *p_refs = ((long *)pkt->data) - 1;
-		if (os_atomic_dec_long(p_refs) == 0)
-			bfree(p_refs);
-	}
+	if (pkt->data)
+		packet_data_release(pkt->data);
 
 	memset(pkt, 0, sizeof(struct encoder_packet));
 }
@@ -1578,3 +2015,38 @@ uint64_t obs_encoder_get_pause_offset(const obs_encoder_t *encoder)
 {
 	return encoder ? encoder->pause.ts_offset : 0;
 }
+
+uint64_t obs_encoder_get_encode_time_ns(const obs_encoder_t *encoder)
+{
+	return obs_encoder_valid(encoder, "obs_encoder_get_encode_time_ns")
+		       ? encoder->encode_time_ns
+		       : 0;
+}
+
+uint64_t obs_encoder_get_audio_latency_ns(const obs_encoder_t *encoder)
+{
+	return obs_encoder_valid(encoder, "obs_encoder_get_audio_latency_ns")
+		       ? encoder->audio_latency_ns
+		       : 0;
+}
+
+void obs_encoder_request_keyframe(obs_encoder_t *encoder)
+{
+	if (!obs_encoder_valid(encoder, "obs_encoder_request_keyframe"))
+		return;
+	if (encoder->info.type != OBS_ENCODER_VIDEO)
+		return;
+
+	os_atomic_set_bool(&encoder->keyframe_requested, true);
+}
+
+uint32_t obs_encoder_get_frame_flags(const obs_encoder_t *encoder,
+				     float *transition_progress)
+{
+	if (!obs_encoder_valid(encoder, "obs_encoder_get_frame_flags"))
+		return 0;
+
+	if (transition_progress)
+		*transition_progress = encoder->frame_transition_progress;
+	return encoder->frame_flags;
+}
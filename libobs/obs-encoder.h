@@ -33,6 +33,7 @@ extern "C" {
 #define OBS_ENCODER_CAP_PASS_TEXTURE (1 << 1)
 #define OBS_ENCODER_CAP_DYN_BITRATE (1 << 2)
 #define OBS_ENCODER_CAP_INTERNAL (1 << 3)
+#define OBS_ENCODER_CAP_STATIC_FRAMES (1 << 4)
 
 /** Specifies the encoder type */
 enum obs_encoder_type {
@@ -85,6 +86,9 @@ struct encoder_packet {
 
 	/** Encoder from which the track originated from */
 	obs_encoder_t *encoder;
+
+	/** Data is reference counted (see obs_encoder_packet_alloc) */
+	bool refcounted;
 };
 
 /** Encoder input frame */
@@ -100,6 +104,13 @@ struct encoder_frame {
 
 	/** Presentation timestamp */
 	int64_t pts;
+
+	/** VIDEO_FRAME_* flags describing the frame's content (video only) */
+	uint32_t flags;
+
+	/** How far along the transition is, from 0.0 to 1.0, if flags has
+	 * VIDEO_FRAME_TRANSITION set (video only) */
+	float transition_progress;
 };
 
 /**
@@ -0,0 +1,272 @@
+/******************************************************************************
+    Copyright (C) 2023 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "obs-internal.h"
+
+/* Timestamp queries are recorded into one of GPU_TIMING_FRAMES frames and
+ * only read back once the frame comes around again, by which point the GPU
+ * has almost always finished with them.  Results that still aren't ready are
+ * dropped rather than waited on. */
+
+#define MAX_GPU_TIMERS_PER_FRAME 1024
+#define GPU_TIMING_STALE_FRAMES 8
+
+static inline uint64_t smooth_ns(uint64_t avg, uint64_t val)
+{
+	return avg ? (avg * 15 + val) / 16 : val;
+}
+
+static void release_frame_sources(struct gpu_timing_frame *frame)
+{
+	for (size_t i = 0; i < frame->num_used; i++) {
+		struct gpu_timer_entry *entry = &frame->entries.array[i];
+		obs_weak_source_release(entry->source);
+		entry->source = NULL;
+	}
+
+	frame->num_used = 0;
+	frame->pending = false;
+}
+
+static void add_source_time(struct obs_gpu_timing *timing,
+			    obs_weak_source_t *weak, uint64_t ns)
+{
+	obs_source_t *source = obs_weak_source_get_source(weak);
+	if (!source)
+		return;
+
+	if (source->gpu_timing_serial != timing->serial) {
+		if (timing->serial - source->gpu_timing_serial >
+		    GPU_TIMING_STALE_FRAMES)
+			source->gpu_time_ns = 0;
+
+		source->gpu_timing_serial = timing->serial;
+		source->gpu_frame_ns = 0;
+
+		/* keep the reference until the frame total is known */
+		da_push_back(timing->sources, &source);
+	} else {
+		obs_source_release(source);
+	}
+
+	source->gpu_frame_ns += ns;
+}
+
+static void collect_frame(struct obs_gpu_timing *timing,
+			  struct gpu_timing_frame *frame)
+{
+	uint64_t stage_ns[OBS_GPU_STAGE_COUNT] = {0};
+	uint64_t frequency = 0;
+	bool disjoint = true;
+
+	if (!gs_timer_range_ready(frame->range))
+		goto finish;
+	if (!gs_timer_range_get_data(frame->range, &disjoint, &frequency))
+		goto finish;
+	if (disjoint || !frequency)
+		goto finish;
+
+	timing->serial++;
+
+	for (size_t i = 0; i < frame->num_used; i++) {
+		struct gpu_timer_entry *entry = &frame->entries.array[i];
+		uint64_t ticks;
+		uint64_t ns;
+
+		if (!gs_timer_ready(entry->timer))
+			continue;
+		if (!gs_timer_get_data(entry->timer, &ticks))
+			continue;
+
+		ns = util_mul_div64(ticks, 1000000000ULL, frequency);
+
+		if (entry->source)
+			add_source_time(timing, entry->source, ns);
+		else
+			stage_ns[entry->stage] += ns;
+	}
+
+	for (size_t i = 0; i < timing->sources.num; i++) {
+		obs_source_t *source = timing->sources.array[i];
+		source->gpu_time_ns =
+			smooth_ns(source->gpu_time_ns, source->gpu_frame_ns);
+		obs_source_release(source);
+	}
+	da_resize(timing->sources, 0);
+
+	for (size_t i = 0; i < OBS_GPU_STAGE_COUNT; i++)
+		timing->stage_ns[i] = smooth_ns(timing->stage_ns[i],
+						stage_ns[i]);
+
+finish:
+	release_frame_sources(frame);
+}
+
+static void reset_gpu_timing(struct obs_gpu_timing *timing)
+{
+	for (size_t i = 0; i < GPU_TIMING_FRAMES; i++)
+		if (timing->frames[i].pending)
+			release_frame_sources(&timing->frames[i]);
+
+	memset(timing->stage_ns, 0, sizeof(timing->stage_ns));
+}
+
+void obs_gpu_timing_begin_frame(void)
+{
+	struct obs_gpu_timing *timing = &obs->video.gpu_timing;
+	struct gpu_timing_frame *frame;
+
+	if (!timing->enabled) {
+		reset_gpu_timing(timing);
+		return;
+	}
+
+	gs_enter_context(obs->video.graphics);
+
+	frame = &timing->frames[timing->cur_frame];
+	if (frame->pending)
+		collect_frame(timing, frame);
+
+	if (!frame->range)
+		frame->range = gs_timer_range_create();
+
+	/* OpenGL has no disjoint query and always hands back a NULL range */
+	if (frame->range || gs_get_device_type() == GS_DEVICE_OPENGL) {
+		gs_timer_range_begin(frame->range);
+		timing->active = true;
+	}
+
+	gs_leave_context();
+}
+
+void obs_gpu_timing_end_frame(void)
+{
+	struct obs_gpu_timing *timing = &obs->video.gpu_timing;
+	struct gpu_timing_frame *frame;
+
+	if (!timing->active)
+		return;
+
+	gs_enter_context(obs->video.graphics);
+
+	frame = &timing->frames[timing->cur_frame];
+	gs_timer_range_end(frame->range);
+	frame->pending = true;
+
+	timing->cur_frame = (timing->cur_frame + 1) % GPU_TIMING_FRAMES;
+	timing->active = false;
+
+	gs_leave_context();
+}
+
+void obs_gpu_timing_free(void)
+{
+	struct obs_gpu_timing *timing = &obs->video.gpu_timing;
+
+	for (size_t i = 0; i < GPU_TIMING_FRAMES; i++) {
+		struct gpu_timing_frame *frame = &timing->frames[i];
+
+		release_frame_sources(frame);
+		for (size_t j = 0; j < frame->entries.num; j++)
+			gs_timer_destroy(frame->entries.array[j].timer);
+
+		gs_timer_range_destroy(frame->range);
+		da_free(frame->entries);
+		frame->range = NULL;
+	}
+
+	da_free(timing->sources);
+	timing->active = false;
+}
+
+static gs_timer_t *begin_timer(obs_source_t *source, enum obs_gpu_stage stage)
+{
+	struct obs_gpu_timing *timing = &obs->video.gpu_timing;
+	struct gpu_timing_frame *frame = &timing->frames[timing->cur_frame];
+	struct gpu_timer_entry *entry;
+
+	if (frame->num_used == frame->entries.num) {
+		if (frame->entries.num == MAX_GPU_TIMERS_PER_FRAME)
+			return NULL;
+
+		gs_timer_t *timer = gs_timer_create();
+		if (!timer)
+			return NULL;
+
+		entry = da_push_back_new(frame->entries);
+		entry->timer = timer;
+	}
+
+	entry = &frame->entries.array[frame->num_used++];
+	entry->source = source ? obs_source_get_weak_source(source) : NULL;
+	entry->stage = stage;
+
+	gs_timer_begin(entry->timer);
+	return entry->timer;
+}
+
+gs_timer_t *obs_gpu_timing_begin_stage(enum obs_gpu_stage stage)
+{
+	if (!obs->video.gpu_timing.active)
+		return NULL;
+
+	return begin_timer(NULL, stage);
+}
+
+gs_timer_t *obs_gpu_timing_begin_source(obs_source_t *source)
+{
+	if (!obs->video.gpu_timing.active)
+		return NULL;
+
+	return begin_timer(source, OBS_GPU_STAGE_COUNT);
+}
+
+void obs_set_gpu_timing_enabled(bool enabled)
+{
+	if (!obs)
+		return;
+
+	obs->video.gpu_timing.enabled = enabled;
+}
+
+bool obs_gpu_timing_enabled(void)
+{
+	return obs ? obs->video.gpu_timing.enabled : false;
+}
+
+uint64_t obs_get_gpu_stage_time_ns(enum obs_gpu_stage stage)
+{
+	if (!obs || !obs->video.gpu_timing.enabled)
+		return 0;
+	if (stage >= OBS_GPU_STAGE_COUNT)
+		return 0;
+
+	return obs->video.gpu_timing.stage_ns[stage];
+}
+
+uint64_t obs_source_get_gpu_time_ns(const obs_source_t *source)
+{
+	if (!obs_source_valid(source, "obs_source_get_gpu_time_ns"))
+		return 0;
+	if (!obs->video.gpu_timing.enabled)
+		return 0;
+	if (obs->video.gpu_timing.serial - source->gpu_timing_serial >
+	    GPU_TIMING_STALE_FRAMES)
+		return 0;
+
+	return source->gpu_time_ns;
+}
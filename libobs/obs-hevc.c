@@ -17,9 +17,11 @@
 
 #include "obs-hevc.h"
 
-#include "obs.h"
+#include "obs-internal.h"
 #include "obs-nal.h"
 #include "util/array-serializer.h"
+#include "util/bitstream.h"
+#include "util/darray.h"
 
 enum {
 	OBS_HEVC_NAL_TRAIL_N = 0,
@@ -113,8 +115,8 @@ static int compute_hevc_keyframe_priority(const uint8_t *nal_start,
 	return priority;
 }
 
-static void serialize_hevc_data(struct serializer *s, const uint8_t *data,
-				size_t size, bool *is_keyframe, int *priority)
+static void get_hevc_priority(const uint8_t *data, size_t size,
+			      bool *is_keyframe, int *priority)
 {
 	const uint8_t *const end = data + size;
 	const uint8_t *nal_start = obs_nal_find_startcode(data, end);
@@ -128,31 +130,27 @@ static void serialize_hevc_data(struct serializer *s, const uint8_t *data,
 		*priority = compute_hevc_keyframe_priority(
 			nal_start, is_keyframe, *priority);
 
-		const uint8_t *const nal_end =
-			obs_nal_find_startcode(nal_start, end);
-		const size_t nal_size = nal_end - nal_start;
-		s_wb32(s, (uint32_t)nal_size);
-		s_write(s, nal_start, nal_size);
-		nal_start = nal_end;
+		nal_start = obs_nal_find_startcode(nal_start, end);
 	}
 }
 
+/* the converted size is known up front, so the length prefixed NAL units are
+ * written straight into a pooled packet buffer instead of being grown
+ * through a serializer */
 void obs_parse_hevc_packet(struct encoder_packet *hevc_packet,
 			   const struct encoder_packet *src)
 {
-	struct array_output_data output;
-	struct serializer s;
-	long ref = 1;
+	const size_t size = obs_nal_length_prefixed_size(src->data, src->size);
+	uint8_t *data = packet_pool_alloc(size);
 
-	array_output_serializer_init(&s, &output);
 	*hevc_packet = *src;
 
-	serialize(&s, &ref, sizeof(ref));
-	serialize_hevc_data(&s, src->data, src->size, &hevc_packet->keyframe,
-			    &hevc_packet->priority);
+	get_hevc_priority(src->data, src->size, &hevc_packet->keyframe,
+			  &hevc_packet->priority);
+	obs_nal_write_length_prefixed(data, src->data, src->size);
 
-	hevc_packet->data = output.bytes.array + sizeof(ref);
-	hevc_packet->size = output.bytes.num - sizeof(ref);
+	hevc_packet->data = data;
+	hevc_packet->size = size;
 	hevc_packet->drop_priority = hevc_packet->priority;
 }
 
@@ -237,3 +235,223 @@ void obs_extract_hevc_headers(const uint8_t *packet, size_t size,
 	*sei_data = sei.array;
 	*sei_size = sei.num;
 }
+
+static inline bool has_start_code(const uint8_t *data)
+{
+	if (data[0] != 0 || data[1] != 0)
+		return false;
+
+	return data[2] == 1 || (data[2] == 0 && data[3] == 1);
+}
+
+/* the parts of the SPS that go into the decoder configuration record */
+struct hevc_sps_info {
+	uint8_t profile_tier_space;
+	uint8_t compatibility_flags[4];
+	uint8_t constraint_flags[6];
+	uint8_t level;
+	uint8_t chroma_format;
+	uint8_t bit_depth_luma_minus8;
+	uint8_t bit_depth_chroma_minus8;
+	uint8_t max_sub_layers;
+	uint8_t temporal_id_nested;
+};
+
+static uint32_t read_ue(struct bitstream_reader *r)
+{
+	int leading_zeros = 0;
+	uint32_t val = 0;
+
+	while (leading_zeros < 31 && !bitstream_reader_read_bits(r, 1))
+		leading_zeros++;
+
+	for (int i = 0; i < leading_zeros; i++)
+		val = (val << 1) | bitstream_reader_read_bits(r, 1);
+
+	return (1U << leading_zeros) - 1 + val;
+}
+
+static bool parse_hevc_sps(const uint8_t *nal, size_t size,
+			   struct hevc_sps_info *info)
+{
+	struct bitstream_reader r;
+	uint8_t rbsp[255];
+	size_t len = 0;
+	uint8_t sub_layer_profile[8] = {0};
+	uint8_t sub_layer_level[8] = {0};
+
+	/* strip emulation prevention bytes, only the start of the SPS is
+	 * needed so it can be cut short */
+	for (size_t i = 2; i < size && len < sizeof(rbsp); i++) {
+		if (i + 2 < size && nal[i] == 0 && nal[i + 1] == 0 &&
+		    nal[i + 2] == 3) {
+			rbsp[len++] = 0;
+			if (len < sizeof(rbsp))
+				rbsp[len++] = 0;
+			i += 2;
+			continue;
+		}
+		rbsp[len++] = nal[i];
+	}
+
+	if (len < 13)
+		return false;
+
+	bitstream_reader_init(&r, rbsp, len);
+
+	bitstream_reader_read_bits(&r, 4); /* sps_video_parameter_set_id */
+	info->max_sub_layers = bitstream_reader_read_bits(&r, 3) + 1;
+	info->temporal_id_nested = bitstream_reader_read_bits(&r, 1);
+
+	/* profile_tier_level() */
+	info->profile_tier_space = bitstream_reader_r8(&r);
+	for (size_t i = 0; i < 4; i++)
+		info->compatibility_flags[i] = bitstream_reader_r8(&r);
+	for (size_t i = 0; i < 6; i++)
+		info->constraint_flags[i] = bitstream_reader_r8(&r);
+	info->level = bitstream_reader_r8(&r);
+
+	for (uint8_t i = 0; i < info->max_sub_layers - 1; i++) {
+		sub_layer_profile[i] = bitstream_reader_read_bits(&r, 1);
+		sub_layer_level[i] = bitstream_reader_read_bits(&r, 1);
+	}
+
+	if (info->max_sub_layers > 1) {
+		for (uint8_t i = info->max_sub_layers - 1; i < 8; i++)
+			bitstream_reader_read_bits(&r, 2);
+	}
+
+	for (uint8_t i = 0; i < info->max_sub_layers - 1; i++) {
+		if (sub_layer_profile[i]) {
+			for (size_t j = 0; j < 11; j++)
+				bitstream_reader_r8(&r);
+		}
+		if (sub_layer_level[i])
+			bitstream_reader_r8(&r);
+	}
+
+	read_ue(&r); /* sps_seq_parameter_set_id */
+	info->chroma_format = (uint8_t)read_ue(&r);
+	if (info->chroma_format == 3)
+		bitstream_reader_read_bits(&r, 1);
+
+	read_ue(&r); /* pic_width_in_luma_samples */
+	read_ue(&r); /* pic_height_in_luma_samples */
+
+	if (bitstream_reader_read_bits(&r, 1)) {
+		/* conformance window offsets */
+		for (size_t i = 0; i < 4; i++)
+			read_ue(&r);
+	}
+
+	info->bit_depth_luma_minus8 = (uint8_t)read_ue(&r);
+	info->bit_depth_chroma_minus8 = (uint8_t)read_ue(&r);
+	return true;
+}
+
+struct hevc_nal {
+	const uint8_t *data;
+	size_t size;
+};
+
+typedef DARRAY(struct hevc_nal) hevc_nal_array_t;
+
+static void write_nal_array(struct serializer *s, hevc_nal_array_t *nals,
+			    uint8_t type)
+{
+	s_w8(s, 0x80 | type);
+	s_wb16(s, (uint16_t)nals->num);
+
+	for (size_t i = 0; i < nals->num; i++) {
+		s_wb16(s, (uint16_t)nals->array[i].size);
+		s_write(s, nals->array[i].data, nals->array[i].size);
+	}
+}
+
+/* builds an HEVCDecoderConfigurationRecord (ISO/IEC 14496-15 8.3.3) from the
+ * VPS, SPS and PPS in the encoder's extra data */
+size_t obs_parse_hevc_header(uint8_t **header, const uint8_t *data,
+			     size_t size)
+{
+	struct array_output_data output;
+	struct serializer s;
+	struct hevc_sps_info info = {0};
+	hevc_nal_array_t vps, sps, pps;
+	const uint8_t *nal_start, *nal_end;
+	const uint8_t *end = data + size;
+	size_t ret = 0;
+
+	if (size <= 6)
+		return 0;
+
+	/* already a decoder configuration record */
+	if (!has_start_code(data)) {
+		*header = bmemdup(data, size);
+		return size;
+	}
+
+	da_init(vps);
+	da_init(sps);
+	da_init(pps);
+
+	nal_start = obs_nal_find_startcode(data, end);
+	while (true) {
+		while (nal_start < end && !*(nal_start++))
+			;
+
+		if (nal_start == end)
+			break;
+
+		nal_end = obs_nal_find_startcode(nal_start, end);
+
+		struct hevc_nal nal = {nal_start, nal_end - nal_start};
+		const uint8_t type = (nal_start[0] & 0x7F) >> 1;
+
+		if (type == OBS_HEVC_NAL_VPS)
+			da_push_back(vps, &nal);
+		else if (type == OBS_HEVC_NAL_SPS)
+			da_push_back(sps, &nal);
+		else if (type == OBS_HEVC_NAL_PPS)
+			da_push_back(pps, &nal);
+
+		nal_start = nal_end;
+	}
+
+	if (!vps.num || !sps.num || !pps.num)
+		goto fail;
+	if (!parse_hevc_sps(sps.array[0].data, sps.array[0].size, &info))
+		goto fail;
+
+	array_output_serializer_init(&s, &output);
+
+	s_w8(&s, 1); /* configurationVersion */
+	s_w8(&s, info.profile_tier_space);
+	s_write(&s, info.compatibility_flags, 4);
+	s_write(&s, info.constraint_flags, 6);
+	s_w8(&s, info.level);
+	s_wb16(&s, 0xF000); /* min_spatial_segmentation_idc unknown */
+	s_w8(&s, 0xFC);     /* parallelismType unknown */
+	s_w8(&s, 0xFC | info.chroma_format);
+	s_w8(&s, 0xF8 | info.bit_depth_luma_minus8);
+	s_w8(&s, 0xF8 | info.bit_depth_chroma_minus8);
+	s_wb16(&s, 0); /* avgFrameRate unknown */
+
+	/* constantFrameRate 0, numTemporalLayers, temporalIdNested,
+	 * lengthSizeMinusOne 3 */
+	s_w8(&s, (info.max_sub_layers << 3) | (info.temporal_id_nested << 2) |
+			 3);
+
+	s_w8(&s, 3); /* numOfArrays */
+	write_nal_array(&s, &vps, OBS_HEVC_NAL_VPS);
+	write_nal_array(&s, &sps, OBS_HEVC_NAL_SPS);
+	write_nal_array(&s, &pps, OBS_HEVC_NAL_PPS);
+
+	*header = output.bytes.array;
+	ret = output.bytes.num;
+
+fail:
+	da_free(vps);
+	da_free(sps);
+	da_free(pps);
+	return ret;
+}
@@ -634,6 +634,7 @@ static inline void create_binding(obs_hotkey_t *hotkey,
 	binding->key = combo;
 	binding->hotkey_id = hotkey->id;
 	binding->hotkey = hotkey;
+	obs->hotkeys.key_bindings_dirty = true;
 	unlock();
 }
 
@@ -978,6 +979,7 @@ static inline void remove_bindings(obs_hotkey_id id)
 			release_pressed_binding(binding);
 
 		da_erase(obs->hotkeys.bindings, idx);
+		obs->hotkeys.key_bindings_dirty = true;
 	}
 }
 
@@ -1143,6 +1145,8 @@ void obs_hotkeys_free(void)
 		release_registerer(&hotkeys[i]);
 	}
 	da_free(obs->hotkeys.bindings);
+	da_free(obs->hotkeys.key_bindings);
+	obs->hotkeys.key_bindings_dirty = true;
 	da_free(obs->hotkeys.hotkeys);
 	da_free(obs->hotkeys.hotkey_pairs);
 
@@ -1201,6 +1205,25 @@ static inline bool is_pressed(obs_key_t key)
 					       key);
 }
 
+enum key_state {
+	KEY_STATE_UNKNOWN,
+	KEY_STATE_RELEASED,
+	KEY_STATE_PRESSED,
+};
+
+/* many bindings tend to share keys, so each key is only queried from the
+ * platform once per poll */
+static inline bool is_pressed_cached(uint8_t *key_states, obs_key_t key)
+{
+	if (key <= OBS_KEY_NONE || key >= OBS_KEY_LAST_VALUE)
+		return is_pressed(key);
+
+	if (key_states[key] == KEY_STATE_UNKNOWN)
+		key_states[key] = is_pressed(key) ? KEY_STATE_PRESSED
+						  : KEY_STATE_RELEASED;
+	return key_states[key] == KEY_STATE_PRESSED;
+}
+
 static inline void press_released_binding(obs_hotkey_binding_t *binding)
 {
 	binding->pressed = true;
@@ -1233,7 +1256,8 @@ static inline void release_pressed_binding(obs_hotkey_binding_t *binding)
 
 static inline void handle_binding(obs_hotkey_binding_t *binding,
 				  uint32_t modifiers, bool no_press,
-				  bool strict_modifiers, bool *pressed)
+				  bool strict_modifiers, uint8_t *key_states,
+				  bool *pressed)
 {
 	bool modifiers_match_ =
 		modifiers_match(binding, modifiers, strict_modifiers);
@@ -1252,7 +1276,7 @@ static inline void handle_binding(obs_hotkey_binding_t *binding,
 		goto reset;
 
 	if ((pressed && !*pressed) ||
-	    (!pressed && !is_pressed(binding->key.key)))
+	    (!pressed && !is_pressed_cached(key_states, binding->key.key)))
 		goto reset;
 
 	if (binding->pressed || no_press)
@@ -1275,6 +1299,72 @@ struct obs_hotkey_internal_inject {
 	bool strict_modifiers;
 };
 
+static void update_key_bindings(void)
+{
+	struct obs_core_hotkeys *hotkeys = &obs->hotkeys;
+	size_t *offsets = hotkeys->key_binding_offsets;
+
+	memset(offsets, 0, sizeof(hotkeys->key_binding_offsets));
+	for (size_t i = 0; i < hotkeys->bindings.num; i++) {
+		obs_key_t key = hotkeys->bindings.array[i].key.key;
+		if (key >= OBS_KEY_NONE && key < OBS_KEY_LAST_VALUE)
+			offsets[key + 1]++;
+	}
+
+	for (size_t i = 0; i < OBS_KEY_LAST_VALUE; i++)
+		offsets[i + 1] += offsets[i];
+
+	/* counting sort, the indices for each key stay in binding order */
+	da_resize(hotkeys->key_bindings, offsets[OBS_KEY_LAST_VALUE]);
+	for (size_t i = 0; i < hotkeys->bindings.num; i++) {
+		obs_key_t key = hotkeys->bindings.array[i].key.key;
+		if (key >= OBS_KEY_NONE && key < OBS_KEY_LAST_VALUE)
+			hotkeys->key_bindings.array[offsets[key]++] = i;
+	}
+
+	/* the fill shifted every offset up to the start of the next key */
+	memmove(offsets + 1, offsets, sizeof(*offsets) * OBS_KEY_LAST_VALUE);
+	offsets[0] = 0;
+
+	hotkeys->key_bindings_dirty = false;
+}
+
+/* only bindings for the key itself or for modifiers alone can be affected
+ * by an event, so those two groups are merged back in to binding order */
+static void enum_key_bindings(obs_key_t key,
+			      obs_hotkey_binding_internal_enum_func func,
+			      void *data)
+{
+	struct obs_core_hotkeys *hotkeys = &obs->hotkeys;
+	const size_t *offsets = hotkeys->key_binding_offsets;
+	const size_t *indices = hotkeys->key_bindings.array;
+	size_t none_idx, none_end, key_idx = 0, key_end = 0;
+
+	if (hotkeys->key_bindings_dirty)
+		update_key_bindings();
+
+	none_idx = offsets[OBS_KEY_NONE];
+	none_end = offsets[OBS_KEY_NONE + 1];
+	if (key > OBS_KEY_NONE && key < OBS_KEY_LAST_VALUE) {
+		key_idx = offsets[key];
+		key_end = offsets[key + 1];
+	}
+
+	while (none_idx < none_end || key_idx < key_end) {
+		size_t idx;
+
+		if (key_idx == key_end ||
+		    (none_idx < none_end &&
+		     indices[none_idx] < indices[key_idx]))
+			idx = indices[none_idx++];
+		else
+			idx = indices[key_idx++];
+
+		if (!func(data, idx, &hotkeys->bindings.array[idx]))
+			break;
+	}
+}
+
 static inline bool inject_hotkey(void *data, size_t idx,
 				 obs_hotkey_binding_t *binding)
 {
@@ -1308,7 +1398,7 @@ void obs_hotkey_inject_event(obs_key_combination_t hotkey, bool pressed)
 		pressed,
 		obs->hotkeys.strict_modifiers,
 	};
-	enum_bindings(inject_hotkey, &event);
+	enum_key_bindings(hotkey.key, inject_hotkey, &event);
 	unlock();
 }
 
@@ -1334,6 +1424,7 @@ struct obs_query_hotkeys_helper {
 	uint32_t modifiers;
 	bool no_press;
 	bool strict_modifiers;
+	uint8_t *key_states;
 };
 
 static inline bool query_hotkey(void *data, size_t idx,
@@ -1344,27 +1435,34 @@ static inline bool query_hotkey(void *data, size_t idx,
 	struct obs_query_hotkeys_helper *param =
 		(struct obs_query_hotkeys_helper *)data;
 	handle_binding(binding, param->modifiers, param->no_press,
-		       param->strict_modifiers, NULL);
+		       param->strict_modifiers, param->key_states, NULL);
 
 	return true;
 }
 
 static inline void query_hotkeys()
 {
+	uint8_t key_states[OBS_KEY_LAST_VALUE] = {0};
 	uint32_t modifiers = 0;
-	if (is_pressed(OBS_KEY_SHIFT))
+
+	/* nothing to press or release, so skip querying the platform */
+	if (!obs->hotkeys.bindings.num)
+		return;
+
+	if (is_pressed_cached(key_states, OBS_KEY_SHIFT))
 		modifiers |= INTERACT_SHIFT_KEY;
-	if (is_pressed(OBS_KEY_CONTROL))
+	if (is_pressed_cached(key_states, OBS_KEY_CONTROL))
 		modifiers |= INTERACT_CONTROL_KEY;
-	if (is_pressed(OBS_KEY_ALT))
+	if (is_pressed_cached(key_states, OBS_KEY_ALT))
 		modifiers |= INTERACT_ALT_KEY;
-	if (is_pressed(OBS_KEY_META))
+	if (is_pressed_cached(key_states, OBS_KEY_META))
 		modifiers |= INTERACT_COMMAND_KEY;
 
 	struct obs_query_hotkeys_helper param = {
 		modifiers,
 		obs->hotkeys.thread_disable_press,
 		obs->hotkeys.strict_modifiers,
+		key_states,
 	};
 	enum_bindings(query_hotkey, &param);
 }
@@ -0,0 +1,450 @@
+/******************************************************************************
+    Copyright (C) 2023 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include <sys/stat.h>
+
+#include "graphics/image-file.h"
+#include "obs-internal.h"
+
+/* Still images are shared by every source that loads the same file with the
+ * same alpha mode, minimum size and format.  They're decoded on the libobs
+ * job pool and only uploaded the first time the graphics thread asks for the
+ * texture.  Images nothing references any more stay cached until the total
+ * size of all images goes past the budget, then the least recently used ones
+ * are freed first, so hiding and showing an image again or switching back to
+ * a scene doesn't decode it again. */
+
+#define DEFAULT_IMAGE_CACHE_BUDGET (512ULL * 1024 * 1024)
+
+struct obs_cached_image {
+	char *file;
+	time_t mtime;
+	enum gs_image_alpha_mode alpha_mode;
+	uint32_t min_cx;
+	uint32_t min_cy;
+	enum gs_color_format target_format;
+
+	/* protected by cache_mutex */
+	long refs;
+	uint64_t last_used;
+	bool stale;
+
+	volatile bool claimed;
+	volatile long state;
+	os_event_t *loaded;
+
+	enum gs_color_format format;
+	enum gs_color_space space;
+	uint32_t cx;
+	uint32_t cy;
+	uint64_t size;
+
+	/* only touched by the graphics thread once loaded */
+	uint8_t *data;
+	gs_texture_t *texture;
+	bool uploaded;
+};
+
+static pthread_mutex_t cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static DARRAY(obs_cached_image_t *) cache_images;
+static uint64_t cache_size = 0;
+static uint64_t cache_use_counter = 0;
+static volatile int64_t cache_budget = DEFAULT_IMAGE_CACHE_BUDGET;
+
+static time_t get_modified_timestamp(const char *file)
+{
+	struct stat stats;
+	if (os_stat(file, &stats) != 0)
+		return -1;
+	return stats.st_mtime;
+}
+
+static void decode_image(obs_cached_image_t *image)
+{
+	gs_image_file4_t if4;
+	gs_image_file_t *file = &if4.image3.image2.image;
+	long state = OBS_CACHED_IMAGE_FAILED;
+
+	/* animations are left to the source, the frame limit only keeps
+	 * finding out that it is one cheap */
+	gs_image_file4_init_ex(&if4, image->file, image->alpha_mode,
+			       image->min_cx, image->min_cy, 1);
+
+	if (file->is_animated_gif) {
+		state = OBS_CACHED_IMAGE_ANIMATED;
+		goto finish;
+	}
+	if (!file->loaded || !file->texture_data)
+		goto finish;
+
+	image->cx = file->cx;
+	image->cy = file->cy;
+	image->space = if4.space;
+
+	/* only 8 bit RGBA images are reduced to their first channel, anything
+	 * else is kept as it was decoded */
+	if (image->target_format == GS_R8 &&
+	    (file->format == GS_RGBA || file->format == GS_BGRA ||
+	     file->format == GS_BGRX)) {
+		const size_t pixels = (size_t)file->cx * file->cy;
+		const size_t offset = file->format == GS_RGBA ? 0 : 2;
+
+		image->data = bmalloc(pixels);
+		for (size_t i = 0; i < pixels; i++)
+			image->data[i] = file->texture_data[i * 4 + offset];
+
+		image->format = GS_R8;
+	} else {
+		image->data = file->texture_data;
+		image->format = file->format;
+		file->texture_data = NULL;
+	}
+
+	image->size = (uint64_t)image->cx * image->cy *
+		      gs_get_format_bpp(image->format) / 8;
+	state = OBS_CACHED_IMAGE_LOADED;
+
+finish:
+	gs_image_file4_free(&if4);
+
+	pthread_mutex_lock(&cache_mutex);
+	cache_size += image->size;
+	pthread_mutex_unlock(&cache_mutex);
+
+	os_atomic_set_long(&image->state, state);
+	os_event_signal(image->loaded);
+}
+
+/* whichever of the job and the first waiter gets to the image first
+ * decodes it */
+static void claim_and_decode(obs_cached_image_t *image)
+{
+	if (!os_atomic_exchange_bool(&image->claimed, true))
+		decode_image(image);
+}
+
+static void decode_task(void *param)
+{
+	obs_cached_image_t *image = param;
+
+	claim_and_decode(image);
+	obs_cached_image_release(image);
+}
+
+static void free_cached_image(obs_cached_image_t *image)
+{
+	os_event_destroy(image->loaded);
+	bfree(image->data);
+	bfree(image->file);
+	bfree(image);
+}
+
+static void free_cached_images(obs_cached_image_t **images, size_t num)
+{
+	bool textures = false;
+
+	for (size_t i = 0; i < num; i++)
+		textures = textures || images[i]->texture;
+
+	if (textures) {
+		obs_enter_graphics();
+		for (size_t i = 0; i < num; i++)
+			gs_texture_destroy(images[i]->texture);
+		obs_leave_graphics();
+	}
+
+	for (size_t i = 0; i < num; i++)
+		free_cached_image(images[i]);
+}
+
+static inline bool can_evict(const obs_cached_image_t *image)
+{
+	return !image->refs && os_atomic_load_long(&image->state) !=
+				       OBS_CACHED_IMAGE_LOADING;
+}
+
+static void remove_image(size_t idx, struct darray *evicted)
+{
+	obs_cached_image_t *image = cache_images.array[idx];
+
+	cache_size -= image->size;
+	da_erase(cache_images, idx);
+	darray_push_back(sizeof(image), evicted, &image);
+}
+
+/* called with cache_mutex held, images that failed to load or are out of
+ * date are freed straight away, the rest once the budget is exceeded */
+static void evict_images(struct darray *evicted)
+{
+	uint64_t budget = (uint64_t)os_atomic_load_int64(&cache_budget);
+
+	for (size_t i = cache_images.num; i > 0; i--) {
+		obs_cached_image_t *image = cache_images.array[i - 1];
+		long state = os_atomic_load_long(&image->state);
+
+		if (!can_evict(image))
+			continue;
+		if (image->stale || state != OBS_CACHED_IMAGE_LOADED)
+			remove_image(i - 1, evicted);
+	}
+
+	while (cache_size > budget) {
+		size_t oldest = DARRAY_INVALID;
+
+		for (size_t i = 0; i < cache_images.num; i++) {
+			obs_cached_image_t *image = cache_images.array[i];
+
+			if (!can_evict(image))
+				continue;
+			if (oldest == DARRAY_INVALID ||
+			    image->last_used <
+				    cache_images.array[oldest]->last_used)
+				oldest = i;
+		}
+
+		if (oldest == DARRAY_INVALID)
+			break;
+
+		remove_image(oldest, evicted);
+	}
+}
+
+static inline bool image_matches(const obs_cached_image_t *image,
+				 const char *file, time_t mtime,
+				 enum gs_image_alpha_mode alpha_mode,
+				 uint32_t min_cx, uint32_t min_cy,
+				 enum gs_color_format format)
+{
+	return !image->stale && image->mtime == mtime &&
+	       image->alpha_mode == alpha_mode && image->min_cx == min_cx &&
+	       image->min_cy == min_cy && image->target_format == format &&
+	       strcmp(image->file, file) == 0;
+}
+
+obs_cached_image_t *obs_image_cache_get(const char *file,
+					enum gs_image_alpha_mode alpha_mode,
+					uint32_t min_cx, uint32_t min_cy,
+					enum gs_color_format format)
+{
+	DARRAY(obs_cached_image_t *) evicted = {0};
+	obs_cached_image_t *image = NULL;
+	time_t mtime;
+
+	if (!file || !*file)
+		return NULL;
+	if (format != GS_R8)
+		format = GS_UNKNOWN;
+
+	mtime = get_modified_timestamp(file);
+
+	pthread_mutex_lock(&cache_mutex);
+
+	for (size_t i = 0; i < cache_images.num; i++) {
+		obs_cached_image_t *cur = cache_images.array[i];
+
+		if (image_matches(cur, file, mtime, alpha_mode, min_cx, min_cy,
+				  format)) {
+			image = cur;
+			break;
+		}
+
+		/* the file changed, sources still using the old image keep
+		 * it until they load the new one */
+		if (!cur->stale && cur->mtime != mtime &&
+		    strcmp(cur->file, file) == 0)
+			cur->stale = true;
+	}
+
+	if (image) {
+		image->refs++;
+		image->last_used = ++cache_use_counter;
+		evict_images(&evicted.da);
+		pthread_mutex_unlock(&cache_mutex);
+
+		free_cached_images(evicted.array, evicted.num);
+		da_free(evicted);
+		return image;
+	}
+
+	image = bzalloc(sizeof(*image));
+	image->file = bstrdup(file);
+	image->mtime = mtime;
+	image->alpha_mode = alpha_mode;
+	image->min_cx = min_cx;
+	image->min_cy = min_cy;
+	image->target_format = format;
+	image->state = OBS_CACHED_IMAGE_LOADING;
+	image->space = GS_CS_SRGB;
+	image->last_used = ++cache_use_counter;
+
+	/* one reference for the caller, one for the decode task */
+	image->refs = 2;
+
+	if (os_event_init(&image->loaded, OS_EVENT_TYPE_MANUAL) != 0) {
+		pthread_mutex_unlock(&cache_mutex);
+		bfree(image->file);
+		bfree(image);
+		return NULL;
+	}
+
+	da_push_back(cache_images, &image);
+	evict_images(&evicted.da);
+	pthread_mutex_unlock(&cache_mutex);
+
+	free_cached_images(evicted.array, evicted.num);
+	da_free(evicted);
+
+	obs_queue_task(OBS_TASK_WORKER, decode_task, image, false);
+	return image;
+}
+
+void obs_cached_image_release(obs_cached_image_t *image)
+{
+	DARRAY(obs_cached_image_t *) evicted = {0};
+
+	if (!image)
+		return;
+
+	pthread_mutex_lock(&cache_mutex);
+	if (--image->refs == 0)
+		evict_images(&evicted.da);
+	pthread_mutex_unlock(&cache_mutex);
+
+	free_cached_images(evicted.array, evicted.num);
+	da_free(evicted);
+}
+
+enum obs_cached_image_state
+obs_cached_image_get_state(const obs_cached_image_t *image)
+{
+	if (!image)
+		return OBS_CACHED_IMAGE_FAILED;
+
+	return (enum obs_cached_image_state)os_atomic_load_long(&image->state);
+}
+
+enum obs_cached_image_state obs_cached_image_wait(obs_cached_image_t *image)
+{
+	if (!image)
+		return OBS_CACHED_IMAGE_FAILED;
+
+	/* decode it here if no worker has started on it yet, rather than
+	 * waiting behind whatever else is queued */
+	claim_and_decode(image);
+	os_event_wait(image->loaded);
+
+	return obs_cached_image_get_state(image);
+}
+
+gs_texture_t *obs_cached_image_get_texture(obs_cached_image_t *image)
+{
+	if (!image || obs_cached_image_get_state(image) !=
+			      OBS_CACHED_IMAGE_LOADED)
+		return NULL;
+
+	if (!image->uploaded) {
+		const uint8_t *data = image->data;
+
+		image->texture = gs_texture_create(image->cx, image->cy,
+						   image->format, 1, &data, 0);
+		bfree(image->data);
+		image->data = NULL;
+		image->uploaded = true;
+	}
+
+	return image->texture;
+}
+
+static inline bool image_loaded(const obs_cached_image_t *image)
+{
+	return obs_cached_image_get_state(image) == OBS_CACHED_IMAGE_LOADED;
+}
+
+uint32_t obs_cached_image_get_width(const obs_cached_image_t *image)
+{
+	return image_loaded(image) ? image->cx : 0;
+}
+
+uint32_t obs_cached_image_get_height(const obs_cached_image_t *image)
+{
+	return image_loaded(image) ? image->cy : 0;
+}
+
+enum gs_color_space
+obs_cached_image_get_color_space(const obs_cached_image_t *image)
+{
+	return image_loaded(image) ? image->space : GS_CS_SRGB;
+}
+
+uint64_t obs_cached_image_get_mem_usage(const obs_cached_image_t *image)
+{
+	return image_loaded(image) ? image->size : 0;
+}
+
+void obs_set_image_cache_budget(uint64_t bytes)
+{
+	DARRAY(obs_cached_image_t *) evicted = {0};
+
+	os_atomic_store_int64(&cache_budget, (int64_t)bytes);
+
+	pthread_mutex_lock(&cache_mutex);
+	evict_images(&evicted.da);
+	pthread_mutex_unlock(&cache_mutex);
+
+	free_cached_images(evicted.array, evicted.num);
+	da_free(evicted);
+}
+
+uint64_t obs_get_image_cache_budget(void)
+{
+	return (uint64_t)os_atomic_load_int64(&cache_budget);
+}
+
+uint64_t obs_get_image_cache_size(void)
+{
+	uint64_t size;
+
+	pthread_mutex_lock(&cache_mutex);
+	size = cache_size;
+	pthread_mutex_unlock(&cache_mutex);
+	return size;
+}
+
+/* called after the job pool is gone, so no image is still decoding */
+void obs_free_image_cache(void)
+{
+	DARRAY(obs_cached_image_t *) images;
+
+	pthread_mutex_lock(&cache_mutex);
+	images.da = cache_images.da;
+	memset(&cache_images, 0, sizeof(cache_images));
+	cache_size = 0;
+	pthread_mutex_unlock(&cache_mutex);
+
+	for (size_t i = 0; i < images.num; i++) {
+		obs_cached_image_t *image = images.array[i];
+
+		if (image->refs)
+			blog(LOG_WARNING,
+			     "Image cache: '%s' still has %ld references "
+			     "at shutdown",
+			     image->file, image->refs);
+	}
+
+	free_cached_images(images.array, images.num);
+	da_free(images);
+}
@@ -38,6 +38,8 @@
 #include "obs.h"
 
 #define NUM_TEXTURES 2
+#define MIN_TEXTURES 2
+#define MAX_TEXTURES 6
 #define NUM_CHANNELS 3
 #define MICROSECOND_DEN 1000000
 #define NUM_ENCODE_TEXTURES 10
@@ -89,8 +91,15 @@ struct obs_module {
 	char *data_path;
 	void *module;
 	bool loaded;
+	uint64_t load_time_ns;
+
+	/* obs_module_load runs on its own thread while the other modules
+	 * load, see OBS_MODULE_LOAD_INDEPENDENT */
+	bool load_threaded;
+	pthread_t load_thread;
 
 	bool (*load)(void);
+	bool (*load_independent)(void);
 	void (*unload)(void);
 	void (*post_load)(void);
 	void (*set_locale)(const char *locale);
@@ -214,6 +223,12 @@ struct obs_display {
 	DARRAY(struct draw_callback) draw_callbacks;
 	bool use_clear_workaround;
 
+	/* 0 renders every output frame */
+	uint64_t render_interval_ns;
+	uint64_t last_render_time;
+	bool on_demand;
+	volatile bool redraw;
+
 	struct obs_display *next;
 	struct obs_display **prev_next;
 };
@@ -222,12 +237,49 @@ extern bool obs_display_init(struct obs_display *display,
 			     const struct gs_init_data *graphics_data);
 extern void obs_display_free(struct obs_display *display);
 
+/* ------------------------------------------------------------------------- */
+/* watchdog */
+
+/* marks a thread as busy with a unit of work (a frame, an audio tick, an
+ * encode call), busy_since is 0 while it's idle */
+struct obs_heartbeat {
+	char *name;
+	volatile int64_t busy_since;
+
+	/* only touched by the watchdog */
+	int64_t reported_since;
+};
+
+extern void obs_heartbeat_init(struct obs_heartbeat *hb, const char *type,
+			       const char *name);
+extern void obs_heartbeat_free(struct obs_heartbeat *hb);
+
+static inline void obs_heartbeat_begin(struct obs_heartbeat *hb)
+{
+	os_atomic_store_int64(&hb->busy_since, (int64_t)os_gettime_ns());
+}
+
+static inline void obs_heartbeat_end(struct obs_heartbeat *hb)
+{
+	os_atomic_store_int64(&hb->busy_since, 0);
+}
+
+extern void obs_watchdog_start(void);
+extern void obs_watchdog_stop(void);
+
+/* ------------------------------------------------------------------------- */
+/* image cache */
+
+extern void obs_free_image_cache(void);
+
 /* ------------------------------------------------------------------------- */
 /* core */
 
 struct obs_vframe_info {
 	uint64_t timestamp;
 	int count;
+	uint32_t flags;
+	float transition_progress;
 };
 
 struct obs_tex_frame {
@@ -237,6 +289,8 @@ struct obs_tex_frame {
 	uint64_t timestamp;
 	uint64_t lock_key;
 	int count;
+	uint32_t flags;
+	float transition_progress;
 	bool released;
 };
 
@@ -248,24 +302,32 @@ struct obs_task_info {
 struct obs_core_video_mix {
 	struct obs_view *view;
 
-	gs_stagesurf_t *active_copy_surfaces[NUM_TEXTURES][NUM_CHANNELS];
-	gs_stagesurf_t *copy_surfaces[NUM_TEXTURES][NUM_CHANNELS];
+	size_t num_textures;
+	gs_stagesurf_t *(*active_copy_surfaces)[NUM_CHANNELS];
+	gs_stagesurf_t *(*copy_surfaces)[NUM_CHANNELS];
 	gs_texture_t *convert_textures[NUM_CHANNELS];
 #ifdef _WIN32
-	gs_stagesurf_t *copy_surfaces_encode[NUM_TEXTURES];
+	gs_stagesurf_t **copy_surfaces_encode;
 	gs_texture_t *convert_textures_encode[NUM_CHANNELS];
 #endif
 	gs_texture_t *render_texture;
 	gs_texture_t *output_texture;
 	enum gs_color_space render_space;
 	bool texture_rendered;
-	bool textures_copied[NUM_TEXTURES];
+	bool *textures_copied;
 	bool texture_converted;
 	bool using_nv12_tex;
 	bool using_p010_tex;
 	struct circlebuf vframe_info_buffer;
 	struct circlebuf vframe_info_buffer_gpu;
 	gs_stagesurf_t *mapped_surfaces[NUM_CHANNELS];
+
+	/* VIDEO_FRAME_* flags of the last rendered frame.  the program source
+	 * is only ever compared against, never dereferenced. */
+	uint32_t frame_flags;
+	float frame_transition_progress;
+	const obs_source_t *last_program_source;
+	bool last_transitioning;
 	int cur_texture;
 	volatile long raw_active;
 	volatile long gpu_encoder_active;
@@ -282,6 +344,15 @@ struct obs_core_video_mix {
 	bool gpu_encode_thread_initialized;
 	volatile bool gpu_encode_stop;
 
+	bool zero_copy_readback;
+	struct video_data readback_frame;
+	int readback_count;
+	os_sem_t *readback_semaphore;
+	os_event_t *readback_idle;
+	pthread_t readback_thread;
+	bool readback_thread_initialized;
+	volatile bool readback_stop;
+
 	video_t *video;
 
 	bool gpu_conversion;
@@ -292,12 +363,82 @@ struct obs_core_video_mix {
 
 	float color_matrix[16];
 	enum obs_scale_type scale_type;
+
+	/* scaled mixes don't render anything themselves, they only rescale
+	 * the render texture of another mix on the GPU for raw encoders that
+	 * use a different resolution.  scale_source is cleared if the source
+	 * mix goes away first, and the mix is freed once scale_removed is
+	 * set. */
+	struct obs_core_video_mix *scale_source;
+	bool scaled_mix;
+	bool scale_removed;
+
+	uint32_t base_width;
+	uint32_t base_height;
+
+	/* extra canvases have their own base size and a frame rate no higher
+	 * than the main loop's.  they're rendered on the first tick at or
+	 * after their next frame time, canvas_frame_count is the number of
+	 * canvas frames that render stands for, or 0 if it didn't render on
+	 * the current tick. */
+	bool canvas;
+	uint64_t canvas_interval_ns;
+	uint64_t canvas_next_time;
+	int canvas_frame_count;
 };
 
 extern struct obs_core_video_mix *
 obs_create_video_mix(struct obs_video_info *ovi);
 extern void obs_free_video_mix(struct obs_core_video_mix *video);
 
+extern struct obs_core_video_mix *get_mix_for_video(video_t *v);
+
+extern struct obs_core_video_mix *
+obs_create_scaled_video_mix(video_t *video, uint32_t width, uint32_t height,
+			    enum obs_scale_type scale_type);
+extern void obs_remove_scaled_video_mix(struct obs_core_video_mix *mix);
+
+extern bool init_video_readback(struct obs_core_video_mix *video);
+extern void free_video_readback(struct obs_core_video_mix *video);
+
+extern void free_tick_threads(void);
+
+#define GPU_TIMING_FRAMES 4
+
+struct gpu_timer_entry {
+	gs_timer_t *timer;
+	obs_weak_source_t *source;
+	enum obs_gpu_stage stage;
+};
+
+struct gpu_timing_frame {
+	gs_timer_range_t *range;
+	DARRAY(struct gpu_timer_entry) entries;
+	size_t num_used;
+	bool pending;
+};
+
+struct obs_gpu_timing {
+	volatile bool enabled;
+	bool active;
+	struct gpu_timing_frame frames[GPU_TIMING_FRAMES];
+	size_t cur_frame;
+	uint64_t serial;
+	DARRAY(struct obs_source *) sources;
+	uint64_t stage_ns[OBS_GPU_STAGE_COUNT];
+};
+
+extern void obs_gpu_timing_begin_frame(void);
+extern void obs_gpu_timing_end_frame(void);
+extern void obs_gpu_timing_free(void);
+extern gs_timer_t *obs_gpu_timing_begin_stage(enum obs_gpu_stage stage);
+extern gs_timer_t *obs_gpu_timing_begin_source(obs_source_t *source);
+
+struct obs_fused_effect {
+	char *key;
+	gs_effect_t *effect;
+};
+
 struct obs_core_video {
 	graphics_t *graphics;
 	gs_effect_t *default_effect;
@@ -317,10 +458,21 @@ struct obs_core_video {
 	uint64_t video_frame_interval_ns;
 	uint64_t video_half_frame_interval_ns;
 	uint64_t video_avg_frame_time_ns;
+	uint64_t video_avg_wake_delay_ns;
 	double video_fps;
 	pthread_t video_thread;
 	uint32_t total_frames;
 	uint32_t lagged_frames;
+	struct obs_heartbeat graphics_heartbeat;
+
+	/* set for a frame when every mix outputs 8-bit SDR and nothing HDR
+	 * was rendered in the previous frame.  sources that could render
+	 * either way are then kept in 8-bit sRGB rather than 16-bit float,
+	 * which halves the bandwidth of their texrenders and filters.
+	 * hdr_content is set by any source that picks an HDR color space
+	 * even though sRGB was allowed */
+	bool sdr_only;
+	volatile bool hdr_content;
 	bool thread_initialized;
 
 	uint32_t base_width;
@@ -336,6 +488,11 @@ struct obs_core_video {
 	gs_effect_t *deinterlace_blend_2x_effect;
 	gs_effect_t *deinterlace_yadif_effect;
 	gs_effect_t *deinterlace_yadif_2x_effect;
+	gs_effect_t *deinterlace_motion_adaptive_effect;
+	gs_effect_t *deinterlace_motion_adaptive_2x_effect;
+	gs_effect_t *deinterlace_yuv_effect;
+
+	DARRAY(struct obs_fused_effect) fused_effects;
 
 	struct obs_video_info ovi;
 	float sdr_white_level;
@@ -344,6 +501,18 @@ struct obs_core_video {
 	pthread_mutex_t task_mutex;
 	struct circlebuf tasks;
 
+	pthread_mutex_t tick_mutex;
+	DARRAY(pthread_t) tick_threads;
+	DARRAY(struct obs_source *) tick_jobs;
+	size_t tick_cursor;
+	float tick_seconds;
+	volatile long tick_remaining;
+	os_sem_t *tick_semaphore;
+	os_event_t *tick_done;
+	volatile bool tick_stop;
+
+	struct obs_gpu_timing gpu_timing;
+
 	pthread_mutex_t mixes_mutex;
 	DARRAY(struct obs_core_video_mix *) mixes;
 	struct obs_core_video_mix *main_mix;
@@ -353,6 +522,14 @@ struct obs_core_video {
 
 struct audio_monitor;
 
+#define AUDIO_TICK_JOURNAL_SIZE 64
+
+struct audio_tick_entry {
+	struct obs_audio_tick_stats stats;
+	obs_weak_source_t *slowest_source;
+	uint64_t slowest_source_ns;
+};
+
 struct obs_core_audio {
 	audio_t *audio;
 
@@ -366,17 +543,64 @@ struct obs_core_audio {
 	int max_buffering_ticks;
 	bool fixed_buffer;
 
+	/* adaptive buffering: smallest margin any source had over the
+	 * current window, and ticks still to be removed */
+	bool adaptive_buffer;
+	size_t buffering_window_ticks;
+	uint64_t buffering_min_slack;
+	int buffering_shrink_ticks;
+
 	float user_volume;
 
 	pthread_mutex_t monitoring_mutex;
 	DARRAY(struct audio_monitor *) monitors;
 	char *monitoring_device_name;
 	char *monitoring_device_id;
+	bool monitoring_low_latency;
 
 	pthread_mutex_t task_mutex;
 	struct circlebuf tasks;
+
+	pthread_mutex_t render_mutex;
+	DARRAY(pthread_t) render_threads;
+	DARRAY(struct obs_source *) render_jobs;
+	size_t render_cursor;
+	uint32_t render_mixers;
+	size_t render_channels;
+	size_t render_sample_rate;
+	size_t render_size;
+	volatile long render_remaining;
+	os_sem_t *render_semaphore;
+	os_event_t *render_done;
+	volatile bool render_stop;
+
+	/* timings of recent ticks.  the newest entry only gets its output
+	 * time, and is only checked against the budget, on the next tick. */
+	pthread_mutex_t journal_mutex;
+	struct audio_tick_entry journal[AUDIO_TICK_JOURNAL_SIZE];
+	size_t journal_pos;
+	size_t journal_count;
+	bool journal_pending;
+	uint64_t last_overrun_log;
+	long overruns_suppressed;
+
+	struct obs_heartbeat heartbeat;
 };
 
+extern void free_audio_tick_journal(struct obs_core_audio *audio);
+
+extern void free_audio_render_threads(void);
+
+/* hashes the names of non-private contexts so name lookups don't have to walk
+ * the whole list, protected by the mutex of the list it indexes */
+struct obs_context_index {
+	struct obs_context_data **buckets;
+	size_t num_buckets;
+	size_t count;
+};
+
+extern void obs_context_index_free(struct obs_context_index *index);
+
 /* user sources, output channels, and displays */
 struct obs_core_data {
 	struct obs_source *first_source;
@@ -386,6 +610,11 @@ struct obs_core_data {
 	struct obs_encoder *first_encoder;
 	struct obs_service *first_service;
 
+	struct obs_context_index source_index;
+	struct obs_context_index output_index;
+	struct obs_context_index encoder_index;
+	struct obs_context_index service_index;
+
 	pthread_mutex_t sources_mutex;
 	pthread_mutex_t displays_mutex;
 	pthread_mutex_t outputs_mutex;
@@ -402,6 +631,9 @@ struct obs_core_data {
 
 	long long unnamed_index;
 
+	/* how long a source is hidden before it is hibernated, 0 if never */
+	uint64_t hibernate_delay_ns;
+
 	obs_data_t *private_data;
 
 	volatile bool valid;
@@ -423,6 +655,12 @@ struct obs_core_hotkeys {
 	bool reroute_hotkeys;
 	DARRAY(obs_hotkey_binding_t) bindings;
 
+	/* binding indices grouped by key, so injected events only have to
+	 * look at the bindings for that key; rebuilt when bindings change */
+	DARRAY(size_t) key_bindings;
+	size_t key_binding_offsets[OBS_KEY_LAST_VALUE + 1];
+	bool key_bindings_dirty;
+
 	obs_hotkey_callback_router_func router_func;
 	void *router_func_data;
 
@@ -442,6 +680,41 @@ struct obs_core_hotkeys {
 	char *sceneitem_hide;
 };
 
+/* ------------------------------------------------------------------------- */
+/* metrics */
+
+struct obs_core_metrics {
+	obs_metric_t *frames_rendered;
+	obs_metric_t *frames_lagged;
+	obs_metric_t *frame_time_ns;
+	obs_metric_t *wake_delay_ns;
+	obs_metric_t *audio_buffering_ms;
+};
+
+extern void obs_metrics_free(void);
+
+/* ------------------------------------------------------------------------- */
+/* screenshots */
+
+extern void obs_process_screenshots(void);
+extern void obs_free_screenshots(void);
+
+/* ------------------------------------------------------------------------- */
+/* deferred graphics object destruction */
+
+enum obs_gs_object_type {
+	OBS_GS_TEXTURE,
+	OBS_GS_MAPPED_TEXTURE,
+	OBS_GS_TEXRENDER,
+};
+
+/* objects are destroyed in one batch per frame by the graphics thread, so
+ * threads tearing things down don't have to wait for the graphics context */
+extern void obs_defer_gs_destroy(enum obs_gs_object_type type, void *obj);
+extern void obs_free_deferred_gs_objects(void);
+
+/* ------------------------------------------------------------------------- */
+
 struct obs_core {
 	struct obs_module *first_module;
 	DARRAY(struct obs_module_path) module_paths;
@@ -470,13 +743,15 @@ struct obs_core {
 	struct obs_core_audio audio;
 	struct obs_core_data data;
 	struct obs_core_hotkeys hotkeys;
+	struct obs_core_metrics metrics;
 
 	bool multiple_rendering;
 	enum obs_replay_buffer_rendering_mode replay_buffer_rendering_mode;
 	enum obs_video_rendering_mode video_rendering_mode;
 	enum obs_audio_rendering_mode audio_rendering_mode;
 
-	os_task_queue_t *destruction_task_thread;
+	os_job_pool_t *task_pool;
+	os_task_queue_t *upload_task_thread;
 
 	obs_task_handler_t ui_task_handler;
 };
@@ -489,6 +764,8 @@ struct obs_graphics_context {
 	uint64_t frame_time_total_ns;
 	uint64_t fps_total_ns;
 	uint32_t fps_total_frames;
+	uint64_t wake_delay_total_ns;
+	uint32_t wake_total_frames;
 	const char *video_thread_name;
 };
 
@@ -505,6 +782,14 @@ extern gs_effect_t *obs_load_effect(gs_effect_t **effect, const char *file);
 extern bool audio_callback(void *param, uint64_t start_ts_in,
 			   uint64_t end_ts_in, uint64_t *out_ts,
 			   uint32_t mixers, struct audio_output_data *mixes);
+
+extern bool obs_source_video_static(obs_source_t *source);
+extern long obs_source_get_content_generation(const obs_source_t *source);
+
+extern bool obs_source_renders_same_in_modes(obs_source_t *source,
+					     enum obs_video_rendering_mode a,
+					     enum obs_video_rendering_mode b);
+
 extern void cache_multiple_rendering(void);
 extern bool get_cached_multiple_rendering(void);
 
@@ -551,6 +836,10 @@ struct obs_context_data {
 	struct obs_context_data *next;
 	struct obs_context_data **prev_next;
 
+	struct obs_context_index *index;
+	struct obs_context_data *hash_next;
+	uint32_t name_hash;
+
 	bool private;
 
 	DARRAY(char *) rename_cache;
@@ -566,7 +855,8 @@ extern void obs_context_init_control(struct obs_context_data *context,
 extern void obs_context_data_free(struct obs_context_data *context);
 
 extern void obs_context_data_insert(struct obs_context_data *context,
-				    pthread_mutex_t *mutex, void *first);
+				    pthread_mutex_t *mutex, void *first,
+				    struct obs_context_index *index);
 extern void obs_context_data_remove(struct obs_context_data *context);
 extern void obs_context_wait(struct obs_context_data *context);
 
@@ -640,6 +930,24 @@ struct audio_action {
 	};
 };
 
+/* must be a power of two */
+#define AUDIO_INPUT_PACKETS 32
+
+/* audio handed from the thread calling obs_source_output_audio to the audio
+ * thread, which does the timestamp-based placement into audio_input_buf */
+struct audio_input_packet {
+	uint64_t timestamp;
+	uint32_t frames;
+	bool push_back;
+
+	/* clear the buffered audio and restart at reset_ts before placing */
+	bool reset;
+	uint64_t reset_ts;
+
+	float *data[MAX_AUDIO_CHANNELS];
+	size_t capacity;
+};
+
 struct obs_weak_source {
 	struct obs_weak_ref ref;
 	struct obs_source *source;
@@ -650,6 +958,15 @@ struct audio_cb_info {
 	void *param;
 };
 
+/* levels of the source's latest audio packet for one peak meter type,
+ * shared by every volume meter attached to the source */
+struct audio_meter_bus {
+	uint64_t serial;
+	float prev_samples[MAX_AUDIO_CHANNELS][4];
+	float magnitude[MAX_AUDIO_CHANNELS];
+	float peak[MAX_AUDIO_CHANNELS];
+};
+
 struct caption_cb_info {
 	obs_source_caption_t callback;
 	void *param;
@@ -670,6 +987,20 @@ struct obs_source {
 	/* signals to call the source update in the video thread */
 	long defer_update_count;
 
+	/* info.create held back until the source is first shown, see
+	 * obs_load_sources_deferred */
+	volatile long create_state;
+
+	/* incremented whenever the rendered output of the source may have
+	 * changed, used to cache the output of OBS_SOURCE_STATIC_VIDEO
+	 * sources */
+	volatile long content_generation;
+
+	/* GPU timing, written by the graphics thread */
+	uint64_t gpu_time_ns;
+	uint64_t gpu_frame_ns;
+	volatile uint64_t gpu_timing_serial;
+
 	/* ensures show/hide are only called once */
 	volatile long show_refs;
 
@@ -690,6 +1021,12 @@ struct obs_source {
 	bool active;
 	bool showing;
 
+	/* GPU resources are released while the source has been hidden for
+	 * longer than the hibernation delay, see update_hibernation */
+	uint64_t hidden_since;
+	volatile bool prefetch;
+	bool hibernating;
+
 	/* used to temporarily disable sources if needed */
 	bool enabled;
 
@@ -710,6 +1047,7 @@ struct obs_source {
 	/* audio */
 	bool audio_failed;
 	bool audio_pending;
+	bool audio_silent; /* output buffers hold only zeros this tick */
 	bool pending_stop;
 	bool audio_active;
 	bool user_muted;
@@ -719,6 +1057,18 @@ struct obs_source {
 	uint64_t audio_ts;
 	struct circlebuf audio_input_buf[MAX_AUDIO_CHANNELS];
 	size_t last_audio_input_buf_size;
+
+	/* wait-free single-producer/single-consumer ring feeding
+	 * audio_input_buf.  producers are serialized by audio_mutex, the
+	 * consumer by audio_buf_mutex.  when the ring is full the newest
+	 * packet is dropped and the next one is placed by timestamp. */
+	struct audio_input_packet audio_packets[AUDIO_INPUT_PACKETS];
+	volatile long audio_packet_write;
+	volatile long audio_packet_read;
+	volatile long audio_packets_dropped;
+	bool audio_packet_discontinuity;
+	bool audio_reset_pending;
+	uint64_t audio_reset_ts;
 	DARRAY(struct audio_action) audio_actions;
 	float *audio_output_buf[MAX_AUDIO_MIXES][MAX_AUDIO_CHANNELS];
 	float *audio_mix_buf[MAX_AUDIO_CHANNELS];
@@ -729,6 +1079,13 @@ struct obs_source {
 	pthread_mutex_t audio_mutex;
 	pthread_mutex_t audio_cb_mutex;
 	DARRAY(struct audio_cb_info) audio_cb_list;
+	uint64_t audio_cb_serial;
+	struct audio_meter_bus meter_bus[2];
+
+	/* how long the last audio render (or, for filters, the last
+	 * filter_audio call) took, for the audio tick journal */
+	uint64_t audio_render_ns;
+	uint64_t audio_filter_ns;
 	struct obs_audio_data audio_data;
 	size_t audio_storage_size;
 	uint32_t audio_mixers;
@@ -746,6 +1103,7 @@ struct obs_source {
 	enum video_format async_format;
 	bool async_full_range;
 	uint8_t async_trc;
+	bool async_sdr_only;
 	enum video_format async_cache_format;
 	bool async_cache_full_range;
 	uint8_t async_cache_trc;
@@ -769,6 +1127,36 @@ struct obs_source {
 	uint32_t async_convert_width[MAX_AV_PLANES];
 	uint32_t async_convert_height[MAX_AV_PLANES];
 
+	/* the next frame is copied into a mapped set of staging textures on
+	 * the upload thread, so the graphics thread only has to unmap it.
+	 * guarded by the graphics context */
+	gs_texture_t *async_staging[2][MAX_AV_PLANES];
+	uint8_t *async_staging_data[MAX_AV_PLANES];
+	uint32_t async_staging_linesize[MAX_AV_PLANES];
+	int async_staging_idx;
+	bool async_staging_mapped;
+	struct obs_source_frame *async_staging_frame;
+	os_event_t *async_staging_done;
+
+	/* adaptive jitter buffer.  arrival delays of recent frames relative
+	 * to async_jitter_ref are kept in a ring, and frames are shown at
+	 * timestamp + ref + delay, where delay converges on the configured
+	 * percentile of those.  the delay is moved by stretching the audio
+	 * when the source has audio, otherwise directly by video */
+	float async_jitter_percentile;
+	DARRAY(int64_t) async_jitter_samples;
+	size_t async_jitter_pos;
+	size_t async_jitter_updates;
+	int64_t async_jitter_ref;
+	bool async_jitter_ref_set;
+	volatile int64_t async_jitter_target;
+	volatile int64_t async_jitter_delay;
+	int64_t async_jitter_frames;
+	int64_t async_jitter_audio_delay;
+	int32_t async_jitter_stretch;
+	volatile uint64_t async_jitter_audio_time;
+	uint64_t async_jitter_sys_ts;
+
 	pthread_mutex_t caption_cb_mutex;
 	DARRAY(struct caption_cb_info) caption_cb_list;
 
@@ -784,6 +1172,15 @@ struct obs_source {
 	bool deinterlace_top_first;
 	bool deinterlace_rendered;
 
+	/* frames that need GPU conversion are deinterlaced plane by plane
+	 * before conversion, deinterlace_conv_frame keeps the conversion
+	 * parameters of the current frame */
+	gs_texrender_t *deinterlace_planes[MAX_AV_PLANES];
+	struct obs_source_frame deinterlace_conv_frame;
+	bool deinterlace_yuv;
+	bool deinterlace_yuv_dirty;
+	bool deinterlace_yuv_frame2;
+
 	/* filters */
 	struct obs_source *filter_parent;
 	struct obs_source *filter_target;
@@ -850,6 +1247,19 @@ extern bool obs_source_init_context(struct obs_source *source,
 				    obs_data_t *settings, const char *name,
 				    obs_data_t *hotkey_data, bool private);
 
+enum obs_source_create_state {
+	OBS_SOURCE_CREATED,
+	OBS_SOURCE_CREATE_DEFERRED,
+	OBS_SOURCE_CREATE_QUEUED,
+	OBS_SOURCE_CREATE_RUNNING,
+};
+
+extern obs_source_t *obs_source_create_deferred(const char *id,
+						const char *name,
+						obs_data_t *settings,
+						obs_data_t *hotkey_data,
+						uint32_t last_obs_ver);
+
 extern bool obs_transition_init(obs_source_t *transition);
 extern void obs_transition_free(obs_source_t *transition);
 extern void obs_transition_tick(obs_source_t *transition, float t);
@@ -858,10 +1268,32 @@ extern void obs_transition_enum_sources(obs_source_t *transition,
 					void *param);
 extern void obs_transition_save(obs_source_t *source, obs_data_t *data);
 extern void obs_transition_load(obs_source_t *source, obs_data_t *data);
+extern bool obs_transition_get_frame_state(obs_source_t *transition, float *t,
+					   const obs_source_t **showing);
 
 struct audio_monitor *audio_monitor_create(obs_source_t *source);
 void audio_monitor_reset(struct audio_monitor *monitor);
 extern void audio_monitor_destroy(struct audio_monitor *monitor);
+extern uint64_t audio_monitor_get_latency_ns(struct audio_monitor *monitor);
+
+/* time since the monitored audio was captured, based on the timestamp the
+ * source's audio capture callbacks receive */
+static inline uint64_t audio_monitor_input_lag_ns(const obs_source_t *source,
+						  uint64_t timestamp)
+{
+	uint64_t sys_ts = timestamp + source->timing_adjust;
+	uint64_t cur_time = os_gettime_ns();
+
+	if (sys_ts >= cur_time || cur_time - sys_ts > 5000000000ULL)
+		return 0;
+	return cur_time - sys_ts;
+}
+
+static inline uint64_t audio_monitor_smooth_latency(uint64_t avg,
+						    uint64_t val)
+{
+	return avg ? (avg * 7 + val) / 8 : val;
+}
 
 extern obs_source_t *
 obs_source_create_set_last_ver(const char *id, const char *name,
@@ -901,8 +1333,11 @@ static inline bool frame_out_of_bounds(const obs_source_t *source, uint64_t ts)
 		return ((ts - source->last_frame_ts) > MAX_TS_VAR);
 }
 
+/* sdr_only converts high bit depth SDR video to 8-bit sRGB like everything
+ * else, see obs_core_video::sdr_only */
 static inline enum gs_color_format
-convert_video_format(enum video_format format, enum video_trc trc)
+convert_video_format(enum video_format format, enum video_trc trc,
+		     bool sdr_only)
 {
 	switch (trc) {
 	case VIDEO_TRC_PQ:
@@ -922,8 +1357,9 @@ convert_video_format(enum video_format format, enum video_trc trc)
 		case VIDEO_FORMAT_P010:
 		case VIDEO_FORMAT_I210:
 		case VIDEO_FORMAT_I412:
+			return sdr_only ? GS_BGRX : GS_RGBA16F;
 		case VIDEO_FORMAT_YA2L:
-			return GS_RGBA16F;
+			return sdr_only ? GS_BGRA : GS_RGBA16F;
 		default:
 			return GS_BGRX;
 		}
@@ -931,10 +1367,11 @@ convert_video_format(enum video_format format, enum video_trc trc)
 }
 
 static inline enum gs_color_space convert_video_space(enum video_format format,
-						      enum video_trc trc)
+						      enum video_trc trc,
+						      bool sdr_only)
 {
 	enum gs_color_space space = GS_CS_SRGB;
-	if (convert_video_format(format, trc) == GS_RGBA16F) {
+	if (convert_video_format(format, trc, sdr_only) == GS_RGBA16F) {
 		switch (trc) {
 		case VIDEO_TRC_DEFAULT:
 		case VIDEO_TRC_SRGB:
@@ -960,6 +1397,7 @@ extern float obs_source_get_target_volume(obs_source_t *source,
 extern void obs_source_audio_render(obs_source_t *source, uint32_t mixers,
 				    size_t channels, size_t sample_rate,
 				    size_t size);
+extern void obs_source_drain_audio_packets(obs_source_t *source);
 
 extern void add_alignment(struct vec2 *v, uint32_t align, int cx, int cy);
 
@@ -972,6 +1410,10 @@ extern bool update_async_textures(struct obs_source *source,
 				  const struct obs_source_frame *frame,
 				  gs_texture_t *tex[MAX_AV_PLANES],
 				  gs_texrender_t *texrender);
+extern bool update_async_texrender(struct obs_source *source,
+				   const struct obs_source_frame *frame,
+				   gs_texture_t *tex[MAX_AV_PLANES],
+				   gs_texrender_t *texrender, bool upload);
 extern bool set_async_texture_size(struct obs_source *source,
 				   const struct obs_source_frame *frame);
 extern void remove_async_frame(obs_source_t *source,
@@ -983,6 +1425,13 @@ extern void deinterlace_process_last_frame(obs_source_t *source,
 extern void deinterlace_update_async_video(obs_source_t *source);
 extern void deinterlace_render(obs_source_t *s);
 
+extern bool obs_source_render_fused_filters(obs_source_t *filter);
+extern void obs_free_fused_effects(void);
+extern void deinterlace_set_yuv_frame(obs_source_t *s,
+				      const struct obs_source_frame *frame);
+extern bool deinterlace_convert_yuv(obs_source_t *s);
+extern void deinterlace_free_planes(obs_source_t *s);
+
 /* ------------------------------------------------------------------------- */
 /* outputs  */
 
@@ -992,10 +1441,23 @@ enum delay_msg {
 	DELAY_MSG_STOP,
 };
 
+/* one file of spilled delay packet data, deleted once every packet
+ * written to it has been sent */
+struct delay_spill_segment {
+	FILE *file;
+	char *path;
+	int64_t size;
+	size_t refs;
+};
+
 struct delay_data {
 	enum delay_msg msg;
 	uint64_t ts;
 	struct encoder_packet packet;
+
+	/* if set, packet.data is NULL and the data is in this segment */
+	struct delay_spill_segment *spill_segment;
+	int64_t spill_offset;
 };
 
 typedef void (*encoded_callback_t)(void *data, struct encoder_packet *packet);
@@ -1033,18 +1495,22 @@ struct obs_output {
 	/* indicates ownership of the info.id buffer */
 	bool owns_info_id;
 
+	/* received_video is set once every video track has had a keyframe */
 	bool received_video;
+	bool received_video_tracks[MAX_OUTPUT_VIDEO_ENCODERS];
 	bool received_audio;
 	volatile bool data_active;
 	volatile bool end_data_capture_thread_active;
-	int64_t video_offset;
+	int64_t video_offsets[MAX_OUTPUT_VIDEO_ENCODERS];
 	int64_t audio_offsets[MAX_AUDIO_MIXES];
 	int64_t highest_audio_ts;
-	int64_t highest_video_ts;
+	int64_t highest_video_ts[MAX_OUTPUT_VIDEO_ENCODERS];
 	pthread_t end_data_capture_thread;
 	os_event_t *stopping_event;
 	pthread_mutex_t interleaved_mutex;
 	DARRAY(struct encoder_packet) interleaved_packets;
+	/* packets before this index have already been sent */
+	size_t interleaved_head;
 	int stop_code;
 
 	int reconnect_retry_sec;
@@ -1067,7 +1533,7 @@ struct obs_output {
 	volatile bool paused;
 	video_t *video;
 	audio_t *audio;
-	obs_encoder_t *video_encoder;
+	obs_encoder_t *video_encoders[MAX_OUTPUT_VIDEO_ENCODERS];
 	obs_encoder_t *audio_encoders[MAX_AUDIO_MIXES];
 	obs_service_t *service;
 	size_t mixer_mask;
@@ -1109,6 +1575,24 @@ struct obs_output {
 	volatile long delay_restart_refs;
 	volatile bool delay_active;
 	volatile bool delay_capturing;
+	size_t delay_mem_size;
+	uint32_t delay_spill_count;
+	bool delay_spill_failed;
+	DARRAY(struct delay_spill_segment *) delay_spill_segments;
+
+	/* encoded packets are delivered on a thread per output */
+	encoded_callback_t packet_callback;
+	struct circlebuf packet_queue; /* struct encoder_packet */
+	pthread_mutex_t packet_mutex;
+	os_sem_t *packet_sem;
+	os_event_t *packet_space_event;
+	pthread_t packet_thread;
+	bool packet_thread_active;
+	bool packet_queue_full_logged;
+	volatile bool packet_thread_stop;
+	volatile long packet_queue_depth;
+	volatile long packet_queue_peak;
+	struct obs_heartbeat packet_heartbeat;
 
 	char *last_error_message;
 
@@ -1124,6 +1608,11 @@ static inline void do_output_signal(struct obs_output *output,
 	calldata_free(&params);
 }
 
+extern void queue_encoded_packet(void *data, struct encoder_packet *packet);
+extern bool obs_output_packet_queue_start(obs_output_t *output,
+					  encoded_callback_t callback);
+extern void obs_output_packet_queue_stop(obs_output_t *output);
+
 extern void process_delay(void *data, struct encoder_packet *packet);
 extern void obs_output_cleanup_delay(obs_output_t *output);
 extern bool obs_output_delay_start(obs_output_t *output);
@@ -1176,6 +1665,8 @@ struct obs_encoder {
 	uint32_t scaled_width;
 	uint32_t scaled_height;
 	enum video_format preferred_format;
+	enum obs_scale_type gpu_scale_type;
+	struct obs_core_video_mix *gpu_scale_mix;
 
 	volatile bool active;
 	volatile bool paused;
@@ -1190,7 +1681,21 @@ struct obs_encoder {
 	int64_t cur_pts;
 
 	struct circlebuf audio_input_buffer[MAX_AV_PLANES];
-	uint8_t *audio_output_buffer[MAX_AV_PLANES];
+
+	/* the audio thread cuts whole frames out of audio_input_buffer and
+	 * queues them here, audio_encode_queue encodes them so encoding
+	 * doesn't hold up audio mixing */
+	os_task_queue_t *audio_encode_queue;
+	pthread_mutex_t audio_frames_mutex;
+	struct circlebuf audio_frames;
+	DARRAY(uint8_t *) audio_frame_pool;
+	uint64_t audio_frames_dropped;
+
+	/* smoothed time from an audio frame being queued to being encoded */
+	uint64_t audio_latency_ns;
+
+	/* busy while the encoder's encode callback runs */
+	struct obs_heartbeat encode_heartbeat;
 
 	/* if a video encoder is paired with an audio encoder, make it start
 	 * up at the specific timestamp.  if this is the audio encoder,
@@ -1222,8 +1727,41 @@ struct obs_encoder {
 	/* reconfigure encoder at next possible opportunity */
 	bool reconfigure_requested;
 	struct obs_core_video_mix *video;
+
+	/* audio encoder with the same id, settings and mix whose packets are
+	 * forwarded rather than encoding the same audio twice */
+	struct obs_encoder *shared_leader;
+	int64_t shared_pts_offset;
+	int64_t shared_dts_usec_offset;
+
+	/* smoothed time spent in each encode call */
+	uint64_t encode_time_ns;
+
+	/* VIDEO_FRAME_* flags of the texture being passed to encode_texture */
+	uint32_t frame_flags;
+	float frame_transition_progress;
+
+	/* set by obs_encoder_request_keyframe, consumed by the next frame */
+	volatile bool keyframe_requested;
 };
 
+static inline uint32_t
+obs_encoder_take_keyframe_request(struct obs_encoder *encoder)
+{
+	return os_atomic_set_bool(&encoder->keyframe_requested, false)
+		       ? VIDEO_FRAME_KEYFRAME
+		       : 0;
+}
+
+static inline void obs_encoder_update_encode_time(struct obs_encoder *encoder,
+						  uint64_t start)
+{
+	uint64_t ns = os_gettime_ns() - start;
+	uint64_t avg = encoder->encode_time_ns;
+
+	encoder->encode_time_ns = avg ? (avg * 15 + ns) / 16 : ns;
+}
+
 extern struct obs_encoder_info *find_encoder(const char *id);
 
 extern bool obs_encoder_initialize(obs_encoder_t *encoder);
@@ -1238,6 +1776,11 @@ extern void obs_encoder_stop(obs_encoder_t *encoder,
 						struct encoder_packet *packet),
 			     void *param);
 
+extern uint8_t *packet_pool_alloc(size_t size);
+extern void packet_data_addref(uint8_t *data);
+extern void packet_data_release(uint8_t *data);
+extern void packet_pool_free(void);
+
 extern void obs_encoder_add_output(struct obs_encoder *encoder,
 				   struct obs_output *output);
 extern void obs_encoder_remove_output(struct obs_encoder *encoder,
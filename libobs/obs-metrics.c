@@ -0,0 +1,135 @@
+/******************************************************************************
+    Copyright (C) 2023 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "obs-internal.h"
+
+/* Metrics are only ever added to the registry, never removed until
+ * shutdown, so the mutex is only needed to create and enumerate them.
+ * Writers just hold on to the metric and update its value atomically. */
+
+struct obs_metric {
+	char *name;
+	enum obs_metric_type type;
+	volatile int64_t value;
+};
+
+static pthread_mutex_t metrics_mutex = PTHREAD_MUTEX_INITIALIZER;
+static DARRAY(struct obs_metric *) metrics;
+
+static struct obs_metric *find_metric(const char *name)
+{
+	for (size_t i = 0; i < metrics.num; i++) {
+		struct obs_metric *metric = metrics.array[i];
+		if (strcmp(metric->name, name) == 0)
+			return metric;
+	}
+
+	return NULL;
+}
+
+obs_metric_t *obs_metric_create(const char *name, enum obs_metric_type type)
+{
+	struct obs_metric *metric;
+
+	if (!name || !*name)
+		return NULL;
+
+	pthread_mutex_lock(&metrics_mutex);
+
+	metric = find_metric(name);
+	if (!metric) {
+		metric = bzalloc(sizeof(*metric));
+		metric->name = bstrdup(name);
+		metric->type = type;
+		da_push_back(metrics, &metric);
+
+	} else if (metric->type != type) {
+		blog(LOG_WARNING,
+		     "obs_metric_create: Metric '%s' already exists "
+		     "with a different type",
+		     name);
+		metric = NULL;
+	}
+
+	pthread_mutex_unlock(&metrics_mutex);
+	return metric;
+}
+
+void obs_metric_add(obs_metric_t *metric, int64_t value)
+{
+	if (metric)
+		os_atomic_add_int64(&metric->value, value);
+}
+
+void obs_metric_set(obs_metric_t *metric, int64_t value)
+{
+	if (metric)
+		os_atomic_store_int64(&metric->value, value);
+}
+
+int64_t obs_metric_get(const obs_metric_t *metric)
+{
+	return metric ? os_atomic_load_int64(&metric->value) : 0;
+}
+
+int64_t obs_get_metric(const char *name)
+{
+	struct obs_metric *metric;
+	int64_t value = 0;
+
+	if (!name)
+		return 0;
+
+	pthread_mutex_lock(&metrics_mutex);
+	metric = find_metric(name);
+	if (metric)
+		value = os_atomic_load_int64(&metric->value);
+	pthread_mutex_unlock(&metrics_mutex);
+
+	return value;
+}
+
+void obs_enum_metrics(obs_enum_metric_proc_t enum_proc, void *param)
+{
+	if (!enum_proc)
+		return;
+
+	pthread_mutex_lock(&metrics_mutex);
+
+	for (size_t i = 0; i < metrics.num; i++) {
+		struct obs_metric *metric = metrics.array[i];
+		int64_t value = os_atomic_load_int64(&metric->value);
+
+		if (!enum_proc(param, metric->name, metric->type, value))
+			break;
+	}
+
+	pthread_mutex_unlock(&metrics_mutex);
+}
+
+void obs_metrics_free(void)
+{
+	pthread_mutex_lock(&metrics_mutex);
+
+	for (size_t i = 0; i < metrics.num; i++) {
+		bfree(metrics.array[i]->name);
+		bfree(metrics.array[i]);
+	}
+	da_free(metrics);
+
+	pthread_mutex_unlock(&metrics_mutex);
+}
@@ -48,6 +48,8 @@ static int load_module_exports(struct obs_module *mod, const char *path)
 		return req_func_not_found("obs_module_ver", path);
 
 	/* optional exports */
+	mod->load_independent =
+		os_dlsym(mod->module, "obs_module_load_independent");
 	mod->unload = os_dlsym(mod->module, "obs_module_unload");
 	mod->post_load = os_dlsym(mod->module, "obs_module_post_load");
 	mod->set_locale = os_dlsym(mod->module, "obs_module_set_locale");
@@ -171,6 +173,7 @@ bool obs_init_module(obs_module_t *module)
 	const char *profile_name =
 		profile_store_name(obs_get_profiler_name_store(),
 				   "obs_init_module(%s)", module->file);
+	uint64_t start = os_gettime_ns();
 	profile_start(profile_name);
 
 	module->loaded = module->load();
@@ -179,6 +182,7 @@ bool obs_init_module(obs_module_t *module)
 		     module->file);
 
 	profile_end(profile_name);
+	module->load_time_ns = os_gettime_ns() - start;
 	return module->loaded;
 }
 
@@ -188,6 +192,13 @@ void obs_log_loaded_modules(void)
 
 	for (obs_module_t *mod = obs->first_module; !!mod; mod = mod->next)
 		blog(LOG_INFO, "    %s", mod->file);
+
+	blog(LOG_INFO, "  Module load times:");
+
+	for (obs_module_t *mod = obs->first_module; !!mod; mod = mod->next)
+		blog(LOG_INFO, "    %s: %.1f ms%s", mod->file,
+		     (double)mod->load_time_ns / 1000000.0,
+		     mod->load_threaded ? " (background)" : "");
 }
 
 const char *obs_get_module_file_name(obs_module_t *module)
@@ -296,9 +307,54 @@ struct fail_info {
 	size_t fail_count;
 };
 
+struct load_all_info {
+	struct fail_info *fail_info;
+	DARRAY(obs_module_t *) threaded;
+};
+
+static void *module_load_thread(void *param)
+{
+	obs_module_t *module = param;
+
+	os_set_thread_name("obs_module_load");
+	obs_init_module(module);
+	return NULL;
+}
+
+static bool load_module_threaded(struct load_all_info *load_info,
+				 obs_module_t *module)
+{
+	if (!module->load_independent || !module->load_independent())
+		return false;
+
+	if (pthread_create(&module->load_thread, NULL, module_load_thread,
+			   module) != 0)
+		return false;
+
+	module->load_threaded = true;
+	da_push_back(load_info->threaded, &module);
+	return true;
+}
+
+/* modules are only freed here, on the thread that started the loads, so the
+ * module list isn't modified while the other modules are opened */
+static void finish_threaded_loads(struct load_all_info *load_info)
+{
+	for (size_t i = 0; i < load_info->threaded.num; i++) {
+		obs_module_t *module = load_info->threaded.array[i];
+
+		pthread_join(module->load_thread, NULL);
+		if (!module->loaded)
+			free_module(module);
+	}
+
+	da_free(load_info->threaded);
+}
+
 static void load_all_callback(void *param, const struct obs_module_info2 *info)
 {
-	struct fail_info *fail_info = param;
+	struct load_all_info *load_info = param;
+	struct fail_info *fail_info = load_info->fail_info;
 	obs_module_t *module = NULL;
 
 	bool is_obs_plugin;
@@ -345,10 +401,11 @@ static void load_all_callback(void *param, const struct obs_module_info2 *info)
 		return;
 	}
 
+	if (load_module_threaded(load_info, module))
+		return;
+
 	if (!obs_init_module(module))
 		free_module(module);
-
-	UNUSED_PARAMETER(param);
 	return;
 
 load_failure:
@@ -366,8 +423,11 @@ static const char *reset_win32_symbol_paths_name = "reset_win32_symbol_paths";
 
 void obs_load_all_modules(void)
 {
+	struct load_all_info load_info = {0};
+
 	profile_start(obs_load_all_modules_name);
-	obs_find_modules2(load_all_callback, NULL);
+	obs_find_modules2(load_all_callback, &load_info);
+	finish_threaded_loads(&load_info);
 #ifdef _WIN32
 	profile_start(reset_win32_symbol_paths_name);
 	reset_win32_symbol_paths();
@@ -381,10 +441,12 @@ static const char *obs_load_all_modules2_name = "obs_load_all_modules2";
 void obs_load_all_modules2(struct obs_module_failure_info *mfi)
 {
 	struct fail_info fail_info = {0};
+	struct load_all_info load_info = {.fail_info = &fail_info};
 	memset(mfi, 0, sizeof(*mfi));
 
 	profile_start(obs_load_all_modules2_name);
-	obs_find_modules2(load_all_callback, &fail_info);
+	obs_find_modules2(load_all_callback, &load_info);
+	finish_threaded_loads(&load_info);
 #ifdef _WIN32
 	profile_start(reset_win32_symbol_paths_name);
 	reset_win32_symbol_paths();
@@ -727,7 +789,7 @@ cleanup:
 #define service_warn(format, ...) \
 	blog(LOG_WARNING, "obs_register_service: " format, ##__VA_ARGS__)
 
-void obs_register_source_s(const struct obs_source_info *info, size_t size)
+static void register_source(const struct obs_source_info *info, size_t size)
 {
 	struct obs_source_info data = {0};
 	struct darray *array = NULL;
@@ -833,7 +895,7 @@ error:
 	HANDLE_ERROR(size, obs_source_info, info);
 }
 
-void obs_register_output_s(const struct obs_output_info *info, size_t size)
+static void register_output(const struct obs_output_info *info, size_t size)
 {
 	if (find_output(info->id)) {
 		output_warn("Output id '%s' already exists!  "
@@ -876,7 +938,7 @@ error:
 	HANDLE_ERROR(size, obs_output_info, info);
 }
 
-void obs_register_encoder_s(const struct obs_encoder_info *info, size_t size)
+static void register_encoder(const struct obs_encoder_info *info, size_t size)
 {
 	if (find_encoder(info->id)) {
 		encoder_warn("Encoder id '%s' already exists!  "
@@ -907,7 +969,7 @@ error:
 	HANDLE_ERROR(size, obs_encoder_info, info);
 }
 
-void obs_register_service_s(const struct obs_service_info *info, size_t size)
+static void register_service(const struct obs_service_info *info, size_t size)
 {
 	if (find_service(info->id)) {
 		service_warn("Service id '%s' already exists!  "
@@ -930,7 +992,7 @@ error:
 	HANDLE_ERROR(size, obs_service_info, info);
 }
 
-void obs_register_modal_ui_s(const struct obs_modal_ui *info, size_t size)
+static void register_modal_ui(const struct obs_modal_ui *info, size_t size)
 {
 #define CHECK_REQUIRED_VAL_(info, val, func) \
 	CHECK_REQUIRED_VAL(struct obs_modal_ui, info, val, func)
@@ -946,7 +1008,7 @@ error:
 	HANDLE_ERROR(size, obs_modal_ui, info);
 }
 
-void obs_register_modeless_ui_s(const struct obs_modeless_ui *info, size_t size)
+static void register_modeless_ui(const struct obs_modeless_ui *info, size_t size)
 {
 #define CHECK_REQUIRED_VAL_(info, val, func) \
 	CHECK_REQUIRED_VAL(struct obs_modeless_ui, info, val, func)
@@ -962,3 +1024,24 @@ void obs_register_modeless_ui_s(const struct obs_modeless_ui *info, size_t size)
 error:
 	HANDLE_ERROR(size, obs_modeless_ui, info);
 }
+
+/* independent modules can register types while other modules load */
+static pthread_mutex_t register_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+#define LOCKED_REGISTER(func, structure)                                \
+	void obs_register_##func##_s(const struct structure *info,      \
+				     size_t size)                       \
+	{                                                               \
+		pthread_mutex_lock(&register_mutex);                    \
+		register_##func(info, size);                            \
+		pthread_mutex_unlock(&register_mutex);                  \
+	}
+
+LOCKED_REGISTER(source, obs_source_info)
+LOCKED_REGISTER(output, obs_output_info)
+LOCKED_REGISTER(encoder, obs_encoder_info)
+LOCKED_REGISTER(service, obs_service_info)
+LOCKED_REGISTER(modal_ui, obs_modal_ui)
+LOCKED_REGISTER(modeless_ui, obs_modeless_ui)
+
+#undef LOCKED_REGISTER
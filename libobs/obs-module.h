@@ -102,6 +102,18 @@ MODULE_EXPORT void obs_module_unload(void);
 /** Optional: Called when all modules have finished loading */
 MODULE_EXPORT void obs_module_post_load(void);
 
+/**
+ * Optional: Use this macro in a module whose obs_module_load neither depends
+ * on nor is depended on by other modules, and that's safe to call from
+ * another thread.  obs_load_all_modules then loads it in the background while
+ * the rest of the modules load, which helps modules that scan for devices or
+ * do other slow I/O when loading.  It has still finished loading by the time
+ * obs_load_all_modules returns.
+ */
+#define OBS_MODULE_LOAD_INDEPENDENT()                          \
+	MODULE_EXPORT bool obs_module_load_independent(void); \
+	bool obs_module_load_independent(void) { return true; }
+
 /** Called to set the current locale data for the module.  */
 MODULE_EXPORT void obs_module_set_locale(const char *locale);
 
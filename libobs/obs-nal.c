@@ -15,53 +15,118 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 ******************************************************************************/
 
+#include <string.h>
+
 #include "obs-nal.h"
 
-/* NOTE: I noticed that FFmpeg does some unusual special handling of certain
- * scenarios that I was unaware of, so instead of just searching for {0, 0, 1}
- * we'll just use the code from FFmpeg - http://www.ffmpeg.org/ */
-static const uint8_t *ff_avc_find_startcode_internal(const uint8_t *p,
-						     const uint8_t *end)
+#include "util/sse-intrin.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+static inline int lowest_bit(uint32_t mask)
 {
-	const uint8_t *a = p + 4 - ((intptr_t)p & 3);
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return (int)index;
+#else
+	return __builtin_ctz(mask);
+#endif
+}
 
-	for (end -= 3; p < a && p < end; p++) {
-		if (p[0] == 0 && p[1] == 0 && p[2] == 1)
-			return p;
-	}
+/* Same results as FFmpeg's ff_avc_find_startcode_internal, including never
+ * matching a start code in the last three bytes, but checks 16 candidate
+ * positions at a time with overlapping loads instead of looking for zero
+ * bytes a dword at a time.  SIMDe maps this to NEON on ARM. */
+static const uint8_t *find_startcode_internal(const uint8_t *p,
+					      const uint8_t *end)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i one = _mm_set1_epi8(1);
+
+	/* the last candidate of a block reads two bytes past it, and
+	 * candidates in the last three bytes aren't considered */
+	while (end - p >= 19) {
+		__m128i b0 = _mm_loadu_si128((const __m128i *)p);
+		__m128i b1 = _mm_loadu_si128((const __m128i *)(p + 1));
+		__m128i b2 = _mm_loadu_si128((const __m128i *)(p + 2));
+
+		__m128i match = _mm_and_si128(
+			_mm_and_si128(_mm_cmpeq_epi8(b0, zero),
+				      _mm_cmpeq_epi8(b1, zero)),
+			_mm_cmpeq_epi8(b2, one));
+
+		uint32_t mask = (uint32_t)_mm_movemask_epi8(match);
+		if (mask)
+			return p + lowest_bit(mask);
 
-	for (end -= 3; p < end; p += 4) {
-		uint32_t x = *(const uint32_t *)p;
-
-		if ((x - 0x01010101) & (~x) & 0x80808080) {
-			if (p[1] == 0) {
-				if (p[0] == 0 && p[2] == 1)
-					return p;
-				if (p[2] == 0 && p[3] == 1)
-					return p + 1;
-			}
-
-			if (p[3] == 0) {
-				if (p[2] == 0 && p[4] == 1)
-					return p + 2;
-				if (p[4] == 0 && p[5] == 1)
-					return p + 3;
-			}
-		}
+		p += 16;
 	}
 
-	for (end += 3; p < end; p++) {
+	for (; end - p > 3; p++) {
 		if (p[0] == 0 && p[1] == 0 && p[2] == 1)
 			return p;
 	}
 
-	return end + 3;
+	return end;
 }
 
 const uint8_t *obs_nal_find_startcode(const uint8_t *p, const uint8_t *end)
 {
-	const uint8_t *out = ff_avc_find_startcode_internal(p, end);
+	const uint8_t *out = find_startcode_internal(p, end);
 	if (p < out && out < end && !out[-1])
 		out--;
 	return out;
 }
+
+size_t obs_nal_length_prefixed_size(const uint8_t *data, size_t size)
+{
+	const uint8_t *const end = data + size;
+	const uint8_t *nal_start = obs_nal_find_startcode(data, end);
+	size_t out_size = 0;
+
+	while (true) {
+		while (nal_start < end && !*(nal_start++))
+			;
+
+		if (nal_start == end)
+			break;
+
+		const uint8_t *const nal_end =
+			obs_nal_find_startcode(nal_start, end);
+		out_size += 4 + (size_t)(nal_end - nal_start);
+		nal_start = nal_end;
+	}
+
+	return out_size;
+}
+
+void obs_nal_write_length_prefixed(uint8_t *out, const uint8_t *data,
+				   size_t size)
+{
+	const uint8_t *const end = data + size;
+	const uint8_t *nal_start = obs_nal_find_startcode(data, end);
+
+	while (true) {
+		while (nal_start < end && !*(nal_start++))
+			;
+
+		if (nal_start == end)
+			break;
+
+		const uint8_t *const nal_end =
+			obs_nal_find_startcode(nal_start, end);
+		const size_t nal_size = nal_end - nal_start;
+
+		out[0] = (uint8_t)(nal_size >> 24);
+		out[1] = (uint8_t)(nal_size >> 16);
+		out[2] = (uint8_t)(nal_size >> 8);
+		out[3] = (uint8_t)nal_size;
+		memcpy(out + 4, nal_start, nal_size);
+
+		out += 4 + nal_size;
+		nal_start = nal_end;
+	}
+}
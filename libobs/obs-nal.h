@@ -33,6 +33,15 @@ enum {
 EXPORT const uint8_t *obs_nal_find_startcode(const uint8_t *p,
 					     const uint8_t *end);
 
+/**
+ * Gets the size of Annex B data once its start codes are replaced with 4 byte
+ * big endian NAL unit lengths (as used by AVCC/HVCC/FLV), and writes it.  The
+ * output buffer must be at least obs_nal_length_prefixed_size bytes.
+ */
+EXPORT size_t obs_nal_length_prefixed_size(const uint8_t *data, size_t size);
+EXPORT void obs_nal_write_length_prefixed(uint8_t *out, const uint8_t *data,
+					  size_t size);
+
 #ifdef __cplusplus
 }
 #endif
@@ -28,16 +28,147 @@ static inline bool delay_capturing(const struct obs_output *output)
 	return os_atomic_load_bool(&output->delay_capturing);
 }
 
+/* With OBS_OUTPUT_DELAY_SPILL, packet data past the memory limit is
+ * appended to segment files instead, and read back when it's due.  The
+ * delay queue itself stays in memory and serves as the index.  Segments
+ * are deleted once all of their packets have been sent, so disk use
+ * follows the active delay. */
+
+#define DELAY_SPILL_MEM_LIMIT (32 * 1024 * 1024)
+#define DELAY_SPILL_SEGMENT_SIZE (256LL * 1024 * 1024)
+
+static inline bool spill_active(const struct obs_output *output)
+{
+	return (output->delay_cur_flags & OBS_OUTPUT_DELAY_SPILL) != 0 &&
+	       !output->delay_spill_failed;
+}
+
+static void free_spill_segment(struct obs_output *output,
+			       struct delay_spill_segment *seg)
+{
+	da_erase_item(output->delay_spill_segments, &seg);
+
+	fclose(seg->file);
+	if (os_unlink(seg->path) != 0)
+		blog(LOG_WARNING, "Output '%s': failed to delete '%s'",
+		     output->context.name, seg->path);
+	bfree(seg->path);
+	bfree(seg);
+}
+
+static struct delay_spill_segment *new_spill_segment(struct obs_output *output)
+{
+	struct delay_spill_segment *seg;
+	char *dir = os_get_config_path_ptr("obs-studio/delay");
+	struct dstr path = {0};
+	FILE *file = NULL;
+
+	if (dir && os_mkdirs(dir) != MKDIR_ERROR) {
+		dstr_printf(&path, "%s/%p-%" PRIu32 ".bin", dir, output,
+			    output->delay_spill_count++);
+		file = os_fopen(path.array, "w+b");
+	}
+
+	bfree(dir);
+
+	if (!file) {
+		blog(LOG_WARNING,
+		     "Output '%s': failed to create delay spill file '%s', "
+		     "keeping delayed packets in memory",
+		     output->context.name, path.array ? path.array : "");
+		output->delay_spill_failed = true;
+		dstr_free(&path);
+		return NULL;
+	}
+
+	seg = bzalloc(sizeof(*seg));
+	seg->file = file;
+	seg->path = path.array;
+	da_push_back(output->delay_spill_segments, &seg);
+	return seg;
+}
+
+static bool spill_packet(struct obs_output *output, struct delay_data *dd,
+			 const struct encoder_packet *packet)
+{
+	struct delay_spill_segment *seg = NULL;
+	size_t num = output->delay_spill_segments.num;
+
+	if (num)
+		seg = output->delay_spill_segments.array[num - 1];
+	if (!seg || seg->size >= DELAY_SPILL_SEGMENT_SIZE)
+		seg = new_spill_segment(output);
+	if (!seg)
+		return false;
+
+	if (os_fseeki64(seg->file, seg->size, SEEK_SET) != 0 ||
+	    fwrite(packet->data, 1, packet->size, seg->file) != packet->size) {
+		blog(LOG_WARNING,
+		     "Output '%s': failed to write to delay spill file, "
+		     "keeping delayed packets in memory",
+		     output->context.name);
+		output->delay_spill_failed = true;
+		if (!seg->refs)
+			free_spill_segment(output, seg);
+		return false;
+	}
+
+	dd->packet = *packet;
+	dd->packet.data = NULL;
+	dd->packet.refcounted = false;
+	dd->spill_segment = seg;
+	dd->spill_offset = seg->size;
+
+	seg->size += (int64_t)packet->size;
+	seg->refs++;
+	return true;
+}
+
+/* loads a spilled packet's data back into memory */
+static bool unspill_packet(struct obs_output *output, struct delay_data *dd)
+{
+	struct delay_spill_segment *seg = dd->spill_segment;
+	size_t size = dd->packet.size;
+	bool success = false;
+	uint8_t *data;
+
+	dd->spill_segment = NULL;
+
+	data = obs_encoder_packet_alloc(&dd->packet, size);
+	if (fflush(seg->file) == 0 &&
+	    os_fseeki64(seg->file, dd->spill_offset, SEEK_SET) == 0)
+		success = fread(data, 1, size, seg->file) == size;
+
+	if (!success) {
+		blog(LOG_WARNING,
+		     "Output '%s': failed to read from delay spill file",
+		     output->context.name);
+		obs_encoder_packet_release(&dd->packet);
+	}
+
+	if (--seg->refs == 0)
+		free_spill_segment(output, seg);
+
+	return success;
+}
+
 static inline void push_packet(struct obs_output *output,
 			       struct encoder_packet *packet, uint64_t t)
 {
-	struct delay_data dd;
+	struct delay_data dd = {0};
 
 	dd.msg = DELAY_MSG_PACKET;
 	dd.ts = t;
-	obs_encoder_packet_create_instance(&dd.packet, packet);
 
 	pthread_mutex_lock(&output->delay_mutex);
+
+	if (!spill_active(output) ||
+	    output->delay_mem_size + packet->size <= DELAY_SPILL_MEM_LIMIT ||
+	    !spill_packet(output, &dd, packet)) {
+		obs_encoder_packet_create_instance(&dd.packet, packet);
+		output->delay_mem_size += packet->size;
+	}
+
 	circlebuf_push_back(&output->delay_data, &dd, sizeof(dd));
 	pthread_mutex_unlock(&output->delay_mutex);
 }
@@ -72,6 +203,12 @@ void obs_output_cleanup_delay(obs_output_t *output)
 		}
 	}
 
+	while (output->delay_spill_segments.num)
+		free_spill_segment(output,
+				   output->delay_spill_segments.array[0]);
+
+	output->delay_mem_size = 0;
+	output->delay_spill_failed = false;
 	output->active_delay_ns = 0;
 	os_atomic_set_long(&output->delay_restart_refs, 0);
 }
@@ -81,6 +218,7 @@ static inline bool pop_packet(struct obs_output *output, uint64_t t)
 	uint64_t elapsed_time;
 	struct delay_data dd;
 	bool popped = false;
+	bool loaded = true;
 	bool preserve;
 
 	/* ------------------------------------------------ */
@@ -100,6 +238,11 @@ static inline bool pop_packet(struct obs_output *output, uint64_t t)
 			circlebuf_pop_front(&output->delay_data, NULL,
 					    sizeof(dd));
 			popped = true;
+
+			if (dd.msg == DELAY_MSG_PACKET && dd.spill_segment)
+				loaded = unspill_packet(output, &dd);
+			else if (dd.msg == DELAY_MSG_PACKET)
+				output->delay_mem_size -= dd.packet.size;
 		}
 	}
 
@@ -107,7 +250,7 @@ static inline bool pop_packet(struct obs_output *output, uint64_t t)
 
 	/* ------------------------------------------------ */
 
-	if (popped)
+	if (popped && loaded)
 		process_delay_data(output, &dd);
 
 	return popped;
@@ -0,0 +1,178 @@
+/******************************************************************************
+    Copyright (C) 2023 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "obs-internal.h"
+
+/* Encoders hand packets to each output through its own queue, and a thread
+ * per output delivers them, so an output stalling on disk or network
+ * doesn't hold up its encoders or the other outputs sharing them.  If an
+ * output falls so far behind that its queue fills up, the encoder waits
+ * for it rather than dropping packets. */
+
+#define MAX_QUEUED_PACKETS 2048
+
+static inline size_t queued_packets(const struct obs_output *output)
+{
+	return output->packet_queue.size / sizeof(struct encoder_packet);
+}
+
+void queue_encoded_packet(void *data, struct encoder_packet *packet)
+{
+	struct obs_output *output = data;
+	struct encoder_packet pkt;
+	size_t depth;
+
+	obs_encoder_packet_create_instance(&pkt, packet);
+
+	pthread_mutex_lock(&output->packet_mutex);
+
+	while (queued_packets(output) >= MAX_QUEUED_PACKETS) {
+		if (!output->packet_queue_full_logged) {
+			blog(LOG_WARNING,
+			     "Output '%s': packet queue is full, "
+			     "encoders are waiting on it",
+			     output->context.name);
+			output->packet_queue_full_logged = true;
+		}
+
+		pthread_mutex_unlock(&output->packet_mutex);
+		os_event_wait(output->packet_space_event);
+		pthread_mutex_lock(&output->packet_mutex);
+	}
+
+	circlebuf_push_back(&output->packet_queue, &pkt, sizeof(pkt));
+
+	depth = queued_packets(output);
+	os_atomic_set_long(&output->packet_queue_depth, (long)depth);
+	if ((long)depth > os_atomic_load_long(&output->packet_queue_peak))
+		os_atomic_set_long(&output->packet_queue_peak, (long)depth);
+
+	pthread_mutex_unlock(&output->packet_mutex);
+
+	os_sem_post(output->packet_sem);
+}
+
+static void *packet_thread(void *data)
+{
+	struct obs_output *output = data;
+	os_thread_role_t *role = os_set_thread_role(OS_THREAD_ROLE_IO);
+
+	os_set_thread_name("obs-output: packet delivery");
+
+	for (;;) {
+		struct encoder_packet pkt;
+		bool have_packet;
+
+		if (os_sem_wait(output->packet_sem) != 0)
+			break;
+
+		pthread_mutex_lock(&output->packet_mutex);
+		have_packet = output->packet_queue.size != 0;
+		if (have_packet) {
+			circlebuf_pop_front(&output->packet_queue, &pkt,
+					    sizeof(pkt));
+			os_atomic_set_long(&output->packet_queue_depth,
+					   (long)queued_packets(output));
+		}
+		pthread_mutex_unlock(&output->packet_mutex);
+
+		/* the stop post comes after every packet, so an empty queue
+		 * means everything has been delivered */
+		if (!have_packet) {
+			if (os_atomic_load_bool(&output->packet_thread_stop))
+				break;
+			continue;
+		}
+
+		os_event_signal(output->packet_space_event);
+
+		obs_heartbeat_begin(&output->packet_heartbeat);
+		output->packet_callback(output, &pkt);
+		obs_heartbeat_end(&output->packet_heartbeat);
+		obs_encoder_packet_release(&pkt);
+	}
+
+	os_reset_thread_role(role);
+	return NULL;
+}
+
+bool obs_output_packet_queue_start(obs_output_t *output,
+				   encoded_callback_t callback)
+{
+	output->packet_callback = callback;
+	output->packet_queue_full_logged = false;
+	os_atomic_set_bool(&output->packet_thread_stop, false);
+	os_atomic_set_long(&output->packet_queue_depth, 0);
+	os_atomic_set_long(&output->packet_queue_peak, 0);
+
+	if (os_sem_init(&output->packet_sem, 0) != 0)
+		goto fail;
+	if (os_event_init(&output->packet_space_event, OS_EVENT_TYPE_AUTO) !=
+	    0)
+		goto fail;
+	if (pthread_create(&output->packet_thread, NULL, packet_thread,
+			   output) != 0)
+		goto fail;
+
+	output->packet_thread_active = true;
+	return true;
+
+fail:
+	blog(LOG_WARNING,
+	     "Output '%s': failed to start packet delivery thread, "
+	     "delivering packets from encoders directly",
+	     output->context.name);
+	os_event_destroy(output->packet_space_event);
+	os_sem_destroy(output->packet_sem);
+	output->packet_space_event = NULL;
+	output->packet_sem = NULL;
+	return false;
+}
+
+/* must be called after the output's encoders have been stopped */
+void obs_output_packet_queue_stop(obs_output_t *output)
+{
+	if (!output->packet_thread_active)
+		return;
+
+	os_atomic_set_bool(&output->packet_thread_stop, true);
+	os_sem_post(output->packet_sem);
+	pthread_join(output->packet_thread, NULL);
+	output->packet_thread_active = false;
+
+	os_event_destroy(output->packet_space_event);
+	os_sem_destroy(output->packet_sem);
+	output->packet_space_event = NULL;
+	output->packet_sem = NULL;
+
+	os_atomic_set_long(&output->packet_queue_depth, 0);
+}
+
+size_t obs_output_get_packet_queue_depth(const obs_output_t *output)
+{
+	return obs_output_valid(output, "obs_output_get_packet_queue_depth")
+		       ? (size_t)os_atomic_load_long(
+				 &output->packet_queue_depth)
+		       : 0;
+}
+
+size_t obs_output_get_packet_queue_peak(const obs_output_t *output)
+{
+	return obs_output_valid(output, "obs_output_get_packet_queue_peak")
+		       ? (size_t)os_atomic_load_long(&output->packet_queue_peak)
+		       : 0;
+}
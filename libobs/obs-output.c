@@ -108,6 +108,7 @@ obs_output_t *obs_output_create(const char *id, const char *name,
 	pthread_mutex_init_value(&output->delay_mutex);
 	pthread_mutex_init_value(&output->caption_mutex);
 	pthread_mutex_init_value(&output->pause.mutex);
+	pthread_mutex_init_value(&output->packet_mutex);
 
 	if (pthread_mutex_init(&output->interleaved_mutex, NULL) != 0)
 		goto fail;
@@ -117,6 +118,9 @@ obs_output_t *obs_output_create(const char *id, const char *name,
 		goto fail;
 	if (pthread_mutex_init(&output->pause.mutex, NULL) != 0)
 		goto fail;
+	if (pthread_mutex_init(&output->packet_mutex, NULL) != 0)
+		goto fail;
+	obs_heartbeat_init(&output->packet_heartbeat, "output", name);
 	if (os_event_init(&output->stopping_event, OS_EVENT_TYPE_MANUAL) != 0)
 		goto fail;
 	if (!init_output_handlers(output, name, settings, hotkey_data))
@@ -151,7 +155,8 @@ obs_output_t *obs_output_create(const char *id, const char *name,
 	obs_context_init_control(&output->context, output,
 				 (obs_destroy_cb)obs_output_destroy);
 	obs_context_data_insert(&output->context, &obs->data.outputs_mutex,
-				&obs->data.first_output);
+				&obs->data.first_output,
+				&obs->data.output_index);
 
 	if (info)
 		output->context.data =
@@ -169,10 +174,12 @@ fail:
 
 static inline void free_packets(struct obs_output *output)
 {
-	for (size_t i = 0; i < output->interleaved_packets.num; i++)
+	for (size_t i = output->interleaved_head;
+	     i < output->interleaved_packets.num; i++)
 		obs_encoder_packet_release(output->interleaved_packets.array +
 					   i);
 	da_free(output->interleaved_packets);
+	output->interleaved_head = 0;
 }
 
 static inline void clear_audio_buffers(obs_output_t *output)
@@ -218,9 +225,11 @@ void obs_output_destroy(obs_output_t *output)
 
 		free_packets(output);
 
-		if (output->video_encoder) {
-			obs_encoder_remove_output(output->video_encoder,
-						  output);
+		for (size_t i = 0; i < MAX_OUTPUT_VIDEO_ENCODERS; i++) {
+			if (output->video_encoders[i]) {
+				obs_encoder_remove_output(
+					output->video_encoders[i], output);
+			}
 		}
 
 		for (size_t i = 0; i < MAX_AUDIO_MIXES; i++) {
@@ -237,10 +246,15 @@ void obs_output_destroy(obs_output_t *output)
 		pthread_mutex_destroy(&output->caption_mutex);
 		pthread_mutex_destroy(&output->interleaved_mutex);
 		pthread_mutex_destroy(&output->delay_mutex);
+		pthread_mutex_destroy(&output->packet_mutex);
+		if (output->packet_heartbeat.name)
+			obs_heartbeat_free(&output->packet_heartbeat);
 		os_event_destroy(output->reconnect_stop_event);
 		obs_context_data_free(&output->context);
 		circlebuf_free(&output->delay_data);
+		da_free(output->delay_spill_segments);
 		circlebuf_free(&output->caption_data);
+		circlebuf_free(&output->packet_queue);
 		if (output->owns_info_id)
 			bfree((void *)output->info.id);
 		if (output->last_error_message)
@@ -594,7 +608,7 @@ static bool obs_encoded_output_pause(obs_output_t *output, bool pause)
 	uint64_t closest_v_ts;
 	bool success = false;
 
-	venc = output->video_encoder;
+	venc = output->video_encoders[0];
 	for (size_t i = 0; i < MAX_AUDIO_MIXES; i++)
 		aenc[i] = output->audio_encoders[i];
 
@@ -816,19 +830,21 @@ void obs_output_remove_encoder(struct obs_output *output,
 	if (!obs_output_valid(output, "obs_output_remove_encoder"))
 		return;
 
-	if (output->video_encoder == encoder) {
-		output->video_encoder = NULL;
-	} else {
-		for (size_t i = 0; i < MAX_AUDIO_MIXES; i++) {
-			if (output->audio_encoders[i] == encoder)
-				output->audio_encoders[i] = NULL;
-		}
+	for (size_t i = 0; i < MAX_OUTPUT_VIDEO_ENCODERS; i++) {
+		if (output->video_encoders[i] == encoder)
+			output->video_encoders[i] = NULL;
+	}
+
+	for (size_t i = 0; i < MAX_AUDIO_MIXES; i++) {
+		if (output->audio_encoders[i] == encoder)
+			output->audio_encoders[i] = NULL;
 	}
 }
 
-void obs_output_set_video_encoder(obs_output_t *output, obs_encoder_t *encoder)
+void obs_output_set_video_encoder2(obs_output_t *output, obs_encoder_t *encoder,
+				   size_t idx)
 {
-	if (!obs_output_valid(output, "obs_output_set_video_encoder"))
+	if (!obs_output_valid(output, "obs_output_set_video_encoder2"))
 		return;
 	if (encoder && encoder->info.type != OBS_ENCODER_VIDEO) {
 		blog(LOG_WARNING, "obs_output_set_video_encoder: "
@@ -837,26 +853,41 @@ void obs_output_set_video_encoder(obs_output_t *output, obs_encoder_t *encoder)
 	}
 	if (active(output)) {
 		blog(LOG_WARNING,
-		     "%s: tried to set video encoder on output \"%s\" "
+		     "%s: tried to set video encoder %d on output \"%s\" "
 		     "while the output is still active!",
-		     __FUNCTION__, output->context.name);
+		     __FUNCTION__, (int)idx, output->context.name);
 		return;
 	}
 
-	if (output->video_encoder == encoder)
+	if ((output->info.flags & OBS_OUTPUT_MULTI_TRACK_VIDEO) != 0) {
+		if (idx >= MAX_OUTPUT_VIDEO_ENCODERS) {
+			return;
+		}
+	} else {
+		if (idx > 0) {
+			return;
+		}
+	}
+
+	if (output->video_encoders[idx] == encoder)
 		return;
 
-	obs_encoder_remove_output(output->video_encoder, output);
+	obs_encoder_remove_output(output->video_encoders[idx], output);
 	obs_encoder_add_output(encoder, output);
-	output->video_encoder = encoder;
+	output->video_encoders[idx] = encoder;
 
-	/* set the preferred resolution on the encoder */
-	if (output->scaled_width && output->scaled_height)
-		obs_encoder_set_scaled_size(output->video_encoder,
-					    output->scaled_width,
+	/* set the preferred resolution on the encoder, additional tracks are
+	 * renditions with their own size */
+	if (idx == 0 && output->scaled_width && output->scaled_height)
+		obs_encoder_set_scaled_size(encoder, output->scaled_width,
 					    output->scaled_height);
 }
 
+void obs_output_set_video_encoder(obs_output_t *output, obs_encoder_t *encoder)
+{
+	obs_output_set_video_encoder2(output, encoder, 0);
+}
+
 void obs_output_set_audio_encoder(obs_output_t *output, obs_encoder_t *encoder,
 				  size_t idx)
 {
@@ -893,10 +924,29 @@ void obs_output_set_audio_encoder(obs_output_t *output, obs_encoder_t *encoder,
 	output->audio_encoders[idx] = encoder;
 }
 
+obs_encoder_t *obs_output_get_video_encoder2(const obs_output_t *output,
+					     size_t idx)
+{
+	if (!obs_output_valid(output, "obs_output_get_video_encoder2"))
+		return NULL;
+
+	if ((output->info.flags & OBS_OUTPUT_MULTI_TRACK_VIDEO) != 0) {
+		if (idx >= MAX_OUTPUT_VIDEO_ENCODERS) {
+			return NULL;
+		}
+	} else {
+		if (idx > 0) {
+			return NULL;
+		}
+	}
+
+	return output->video_encoders[idx];
+}
+
 obs_encoder_t *obs_output_get_video_encoder(const obs_output_t *output)
 {
 	return obs_output_valid(output, "obs_output_get_video_encoder")
-		       ? output->video_encoder
+		       ? output->video_encoders[0]
 		       : NULL;
 }
 
@@ -1000,8 +1050,8 @@ void obs_output_set_preferred_size(obs_output_t *output, uint32_t width,
 	output->scaled_height = height;
 
 	if (output->info.flags & OBS_OUTPUT_ENCODED) {
-		if (output->video_encoder)
-			obs_encoder_set_scaled_size(output->video_encoder,
+		if (output->video_encoders[0])
+			obs_encoder_set_scaled_size(output->video_encoders[0],
 						    width, height);
 	}
 }
@@ -1014,7 +1064,7 @@ uint32_t obs_output_get_width(const obs_output_t *output)
 		return 0;
 
 	if (output->info.flags & OBS_OUTPUT_ENCODED)
-		return obs_encoder_get_width(output->video_encoder);
+		return obs_encoder_get_width(output->video_encoders[0]);
 	else
 		return output->scaled_width != 0
 			       ? output->scaled_width
@@ -1029,7 +1079,7 @@ uint32_t obs_output_get_height(const obs_output_t *output)
 		return 0;
 
 	if (output->info.flags & OBS_OUTPUT_ENCODED)
-		return obs_encoder_get_height(output->video_encoder);
+		return obs_encoder_get_height(output->video_encoders[0]);
 	else
 		return output->scaled_height != 0
 			       ? output->scaled_height
@@ -1078,6 +1128,24 @@ static inline size_t num_audio_mixes(const struct obs_output *output)
 	return mix_count;
 }
 
+static inline size_t num_video_tracks(const struct obs_output *output)
+{
+	size_t track_count = 1;
+
+	if ((output->info.flags & OBS_OUTPUT_MULTI_TRACK_VIDEO) != 0) {
+		track_count = 0;
+
+		for (size_t i = 0; i < MAX_OUTPUT_VIDEO_ENCODERS; i++) {
+			if (!output->video_encoders[i])
+				break;
+
+			track_count++;
+		}
+	}
+
+	return track_count;
+}
+
 static inline bool audio_valid(const struct obs_output *output, bool encoded)
 {
 	if (encoded) {
@@ -1104,7 +1172,7 @@ static bool can_begin_data_capture(const struct obs_output *output,
 {
 	if (has_video) {
 		if (encoded) {
-			if (!output->video_encoder)
+			if (!output->video_encoders[0])
 				return false;
 		} else {
 			if (!output->video)
@@ -1172,23 +1240,41 @@ get_audio_conversion(struct obs_output *output)
 static size_t get_track_index(const struct obs_output *output,
 			      struct encoder_packet *pkt)
 {
-	for (size_t i = 0; i < MAX_AUDIO_MIXES; i++) {
-		struct obs_encoder *encoder = output->audio_encoders[i];
-
-		if (pkt->encoder == encoder)
-			return i;
+	if (pkt->type == OBS_ENCODER_VIDEO) {
+		for (size_t i = 0; i < MAX_OUTPUT_VIDEO_ENCODERS; i++) {
+			if (pkt->encoder == output->video_encoders[i])
+				return i;
+		}
+	} else {
+		for (size_t i = 0; i < MAX_AUDIO_MIXES; i++) {
+			if (pkt->encoder == output->audio_encoders[i])
+				return i;
+		}
 	}
 
 	assert(false);
 	return 0;
 }
 
+static inline void reset_received_video(struct obs_output *output)
+{
+	output->received_video = false;
+	for (size_t i = 0; i < MAX_OUTPUT_VIDEO_ENCODERS; i++)
+		output->received_video_tracks[i] = false;
+}
+
 static inline void check_received(struct obs_output *output,
 				  struct encoder_packet *out)
 {
 	if (out->type == OBS_ENCODER_VIDEO) {
-		if (!output->received_video)
-			output->received_video = true;
+		size_t tracks = num_video_tracks(output);
+		bool all = true;
+
+		output->received_video_tracks[out->track_idx] = true;
+		for (size_t i = 0; i < tracks; i++)
+			all = all && output->received_video_tracks[i];
+
+		output->received_video = all;
 	} else {
 		if (!output->received_audio)
 			output->received_audio = true;
@@ -1205,7 +1291,7 @@ static inline void apply_interleaved_packet_offset(struct obs_output *output,
 	 * current dts as offset and subtract that value from the dts/pts
 	 * of the output packet. */
 	offset = (out->type == OBS_ENCODER_VIDEO)
-			 ? output->video_offset
+			 ? output->video_offsets[out->track_idx]
 			 : output->audio_offsets[out->track_idx];
 
 	out->dts -= offset;
@@ -1220,13 +1306,27 @@ static inline void apply_interleaved_packet_offset(struct obs_output *output,
 	out->dts_usec = packet_dts_usec(out);
 }
 
+/* with several video tracks, a packet also waits for the other video tracks
+ * to catch up, so that timestamps stay monotonic across the whole stream */
 static inline bool has_higher_opposing_ts(struct obs_output *output,
 					  struct encoder_packet *packet)
 {
-	if (packet->type == OBS_ENCODER_VIDEO)
-		return output->highest_audio_ts > packet->dts_usec;
-	else
-		return output->highest_video_ts > packet->dts_usec;
+	size_t tracks = num_video_tracks(output);
+	bool video = packet->type == OBS_ENCODER_VIDEO;
+
+	if (video && output->highest_audio_ts <= packet->dts_usec)
+		return false;
+
+	for (size_t i = 0; i < tracks; i++) {
+		if (video && i == packet->track_idx)
+			continue;
+		if (output->highest_video_ts[i] < packet->dts_usec)
+			return false;
+		if (!video && output->highest_video_ts[i] == packet->dts_usec)
+			return false;
+	}
+
+	return true;
 }
 
 static const uint8_t nal_start[4] = {0, 0, 0, 1};
@@ -1327,9 +1427,21 @@ static bool add_caption(struct obs_output *output, struct encoder_packet *out)
 
 double last_caption_timestamp = 0;
 
+#define MIN_INTERLEAVED_COMPACT 64
+
+/* sent packets are skipped over rather than erased one at a time, and only
+ * moved out once they make up half of the array */
+static inline void compact_interleaved_packets(struct obs_output *output)
+{
+	da_erase_range(output->interleaved_packets, 0,
+		       output->interleaved_head);
+	output->interleaved_head = 0;
+}
+
 static inline void send_interleaved(struct obs_output *output)
 {
-	struct encoder_packet out = output->interleaved_packets.array[0];
+	size_t head = output->interleaved_head;
+	struct encoder_packet out = output->interleaved_packets.array[head];
 
 	/* do not send an interleaved packet if there's no packet of the
 	 * opposing type of a higher timestamp in the interleave buffer.
@@ -1337,9 +1449,13 @@ static inline void send_interleaved(struct obs_output *output)
 	if (!has_higher_opposing_ts(output, &out))
 		return;
 
-	da_erase(output->interleaved_packets, 0);
+	output->interleaved_head = ++head;
+	if (head >= MIN_INTERLEAVED_COMPACT &&
+	    head * 2 >= output->interleaved_packets.num)
+		compact_interleaved_packets(output);
 
-	if (out.type == OBS_ENCODER_VIDEO) {
+	/* captions are only inserted into the main video track */
+	if (out.type == OBS_ENCODER_VIDEO && out.track_idx == 0) {
 		output->total_frames++;
 
 		pthread_mutex_lock(&output->caption_mutex);
@@ -1379,8 +1495,9 @@ static inline void set_higher_ts(struct obs_output *output,
 				 struct encoder_packet *packet)
 {
 	if (packet->type == OBS_ENCODER_VIDEO) {
-		if (output->highest_video_ts < packet->dts_usec)
-			output->highest_video_ts = packet->dts_usec;
+		int64_t *highest = &output->highest_video_ts[packet->track_idx];
+		if (*highest < packet->dts_usec)
+			*highest = packet->dts_usec;
 	} else {
 		if (output->highest_audio_ts < packet->dts_usec)
 			output->highest_audio_ts = packet->dts_usec;
@@ -1389,10 +1506,10 @@ static inline void set_higher_ts(struct obs_output *output,
 
 static inline struct encoder_packet *
 find_first_packet_type(struct obs_output *output, enum obs_encoder_type type,
-		       size_t audio_idx);
+		       size_t track_idx);
 static int find_first_packet_type_idx(struct obs_output *output,
 				      enum obs_encoder_type type,
-				      size_t audio_idx);
+				      size_t track_idx);
 
 /* gets the point where audio and video are closest together */
 static size_t get_interleaved_start_idx(struct obs_output *output)
@@ -1408,8 +1525,9 @@ static size_t get_interleaved_start_idx(struct obs_output *output)
 			&output->interleaved_packets.array[i];
 		int64_t diff;
 
+		/* keep the first keyframe of every video track */
 		if (packet->type != OBS_ENCODER_AUDIO) {
-			if (packet == first_video)
+			if (video_idx == DARRAY_INVALID)
 				video_idx = i;
 			continue;
 		}
@@ -1436,7 +1554,7 @@ static int prune_premature_packets(struct obs_output *output)
 
 	video_idx = find_first_packet_type_idx(output, OBS_ENCODER_VIDEO, 0);
 	if (video_idx == -1) {
-		output->received_video = false;
+		reset_received_video(output);
 		return -1;
 	}
 
@@ -1513,15 +1631,14 @@ static bool prune_interleaved_packets(struct obs_output *output)
 
 static int find_first_packet_type_idx(struct obs_output *output,
 				      enum obs_encoder_type type,
-				      size_t audio_idx)
+				      size_t track_idx)
 {
 	for (size_t i = 0; i < output->interleaved_packets.num; i++) {
 		struct encoder_packet *packet =
 			&output->interleaved_packets.array[i];
 
 		if (packet->type == type) {
-			if (type == OBS_ENCODER_AUDIO &&
-			    packet->track_idx != audio_idx) {
+			if (packet->track_idx != track_idx) {
 				continue;
 			}
 
@@ -1534,15 +1651,14 @@ static int find_first_packet_type_idx(struct obs_output *output,
 
 static int find_last_packet_type_idx(struct obs_output *output,
 				     enum obs_encoder_type type,
-				     size_t audio_idx)
+				     size_t track_idx)
 {
 	for (size_t i = output->interleaved_packets.num; i > 0; i--) {
 		struct encoder_packet *packet =
 			&output->interleaved_packets.array[i - 1];
 
 		if (packet->type == type) {
-			if (type == OBS_ENCODER_AUDIO &&
-			    packet->track_idx != audio_idx) {
+			if (packet->track_idx != track_idx) {
 				continue;
 			}
 
@@ -1555,28 +1671,35 @@ static int find_last_packet_type_idx(struct obs_output *output,
 
 static inline struct encoder_packet *
 find_first_packet_type(struct obs_output *output, enum obs_encoder_type type,
-		       size_t audio_idx)
+		       size_t track_idx)
 {
-	int idx = find_first_packet_type_idx(output, type, audio_idx);
+	int idx = find_first_packet_type_idx(output, type, track_idx);
 	return (idx != -1) ? &output->interleaved_packets.array[idx] : NULL;
 }
 
 static inline struct encoder_packet *
 find_last_packet_type(struct obs_output *output, enum obs_encoder_type type,
-		      size_t audio_idx)
+		      size_t track_idx)
 {
-	int idx = find_last_packet_type_idx(output, type, audio_idx);
+	int idx = find_last_packet_type_idx(output, type, track_idx);
 	return (idx != -1) ? &output->interleaved_packets.array[idx] : NULL;
 }
 
 static bool get_audio_and_video_packets(struct obs_output *output,
 					struct encoder_packet **video,
 					struct encoder_packet **audio,
-					size_t audio_mixes)
+					size_t video_tracks, size_t audio_mixes)
 {
-	*video = find_first_packet_type(output, OBS_ENCODER_VIDEO, 0);
-	if (!*video)
-		output->received_video = false;
+	bool have_video = true;
+
+	for (size_t i = 0; i < video_tracks; i++) {
+		video[i] = find_first_packet_type(output, OBS_ENCODER_VIDEO, i);
+		if (!video[i])
+			have_video = false;
+	}
+
+	if (!have_video)
+		reset_received_video(output);
 
 	for (size_t i = 0; i < audio_mixes; i++) {
 		audio[i] = find_first_packet_type(output, OBS_ENCODER_AUDIO, i);
@@ -1586,7 +1709,7 @@ static bool get_audio_and_video_packets(struct obs_output *output,
 		}
 	}
 
-	if (!*video) {
+	if (!have_video) {
 		return false;
 	}
 
@@ -1595,15 +1718,20 @@ static bool get_audio_and_video_packets(struct obs_output *output,
 
 static bool initialize_interleaved_packets(struct obs_output *output)
 {
+	struct encoder_packet *videos[MAX_OUTPUT_VIDEO_ENCODERS];
 	struct encoder_packet *video;
 	struct encoder_packet *audio[MAX_AUDIO_MIXES];
 	struct encoder_packet *last_audio[MAX_AUDIO_MIXES];
+	size_t video_tracks = num_video_tracks(output);
 	size_t audio_mixes = num_audio_mixes(output);
 	size_t start_idx;
 
-	if (!get_audio_and_video_packets(output, &video, audio, audio_mixes))
+	if (!get_audio_and_video_packets(output, videos, audio, video_tracks,
+					 audio_mixes))
 		return false;
 
+	video = videos[0];
+
 	for (size_t i = 0; i < audio_mixes; i++)
 		last_audio[i] =
 			find_last_packet_type(output, OBS_ENCODER_AUDIO, i);
@@ -1620,13 +1748,24 @@ static bool initialize_interleaved_packets(struct obs_output *output)
 	start_idx = get_interleaved_start_idx(output);
 	if (start_idx) {
 		discard_to_idx(output, start_idx);
-		if (!get_audio_and_video_packets(output, &video, audio,
-						 audio_mixes))
+		if (!get_audio_and_video_packets(output, videos, audio,
+						 video_tracks, audio_mixes))
 			return false;
+
+		video = videos[0];
 	}
 
-	/* get new offsets */
-	output->video_offset = video->pts;
+	/* get new offsets.  additional video tracks are offset so they share
+	 * the main track's start time, their first keyframe may come later */
+	output->video_offsets[0] = video->pts;
+	for (size_t i = 1; i < video_tracks; i++) {
+		struct encoder_packet *v = videos[i];
+		int64_t delay = v->dts_usec - video->dts_usec;
+
+		output->video_offsets[i] =
+			v->pts - delay * v->timebase_den /
+					 (v->timebase_num * 1000000LL);
+	}
 	for (size_t i = 0; i < audio_mixes; i++)
 		output->audio_offsets[i] = audio[i]->dts;
 
@@ -1645,7 +1784,8 @@ static bool initialize_interleaved_packets(struct obs_output *output)
 	if (audio_mixes > 0)
 		output->highest_audio_ts -= audio[0]->dts_usec;
 
-	output->highest_video_ts -= video->dts_usec;
+	for (size_t i = 0; i < video_tracks; i++)
+		output->highest_video_ts[i] -= video->dts_usec;
 
 	/* apply new offsets to all existing packet DTS/PTS values */
 	for (size_t i = 0; i < output->interleaved_packets.num; i++) {
@@ -1657,23 +1797,35 @@ static bool initialize_interleaved_packets(struct obs_output *output)
 	return true;
 }
 
+/* packets are kept sorted by DTS, with video placed before audio of the
+ * same DTS.  new packets almost always belong at the end, so check there
+ * before falling back to a binary search */
 static inline void insert_interleaved_packet(struct obs_output *output,
 					     struct encoder_packet *out)
 {
-	size_t idx;
-	for (idx = 0; idx < output->interleaved_packets.num; idx++) {
-		struct encoder_packet *cur_packet;
-		cur_packet = output->interleaved_packets.array + idx;
+	struct encoder_packet *array = output->interleaved_packets.array;
+	bool video = out->type == OBS_ENCODER_VIDEO;
+	size_t lo = output->interleaved_head;
+	size_t hi = output->interleaved_packets.num;
 
-		if (out->dts_usec == cur_packet->dts_usec &&
-		    out->type == OBS_ENCODER_VIDEO) {
-			break;
-		} else if (out->dts_usec < cur_packet->dts_usec) {
-			break;
-		}
+	if (lo < hi) {
+		int64_t last = array[hi - 1].dts_usec;
+
+		if (last < out->dts_usec || (!video && last == out->dts_usec))
+			lo = hi;
+	}
+
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		int64_t cur = array[mid].dts_usec;
+
+		if (cur < out->dts_usec || (!video && cur == out->dts_usec))
+			lo = mid + 1;
+		else
+			hi = mid;
 	}
 
-	da_insert(output->interleaved_packets, idx, out);
+	da_insert(output->interleaved_packets, lo, out);
 }
 
 static void resort_interleaved_packets(struct obs_output *output)
@@ -1707,6 +1859,16 @@ static void discard_unused_audio_packets(struct obs_output *output,
 		discard_to_idx(output, idx);
 }
 
+static inline bool has_received_any_video(const struct obs_output *output)
+{
+	for (size_t i = 0; i < MAX_OUTPUT_VIDEO_ENCODERS; i++) {
+		if (output->received_video_tracks[i])
+			return true;
+	}
+
+	return false;
+}
+
 static void interleave_packets(void *data, struct encoder_packet *packet)
 {
 	struct obs_output *output = data;
@@ -1716,15 +1878,22 @@ static void interleave_packets(void *data, struct encoder_packet *packet)
 	if (!active(output))
 		return;
 
-	if (packet->type == OBS_ENCODER_AUDIO)
-		packet->track_idx = get_track_index(output, packet);
+	packet->track_idx = get_track_index(output, packet);
 
 	pthread_mutex_lock(&output->interleaved_mutex);
 
+	/* startup handling works on the whole array */
+	if (output->interleaved_head &&
+	    !(output->received_audio && output->received_video))
+		compact_interleaved_packets(output);
+
 	/* if first video frame is not a keyframe, discard until received */
-	if (!output->received_video && packet->type == OBS_ENCODER_VIDEO &&
+	if (packet->type == OBS_ENCODER_VIDEO &&
+	    !output->received_video_tracks[packet->track_idx] &&
 	    !packet->keyframe) {
-		discard_unused_audio_packets(output, packet->dts_usec);
+		/* other tracks may already have packets queued */
+		if (!has_received_any_video(output))
+			discard_unused_audio_packets(output, packet->dts_usec);
 		pthread_mutex_unlock(&output->interleaved_mutex);
 
 		if (output->active_delay_ns)
@@ -1770,12 +1939,11 @@ static void default_encoded_callback(void *param, struct encoder_packet *packet)
 	struct obs_output *output = param;
 
 	if (data_active(output)) {
-		if (packet->type == OBS_ENCODER_AUDIO)
-			packet->track_idx = get_track_index(output, packet);
+		packet->track_idx = get_track_index(output, packet);
 
 		output->info.encoded_packet(output->context.data, packet);
 
-		if (packet->type == OBS_ENCODER_VIDEO)
+		if (packet->type == OBS_ENCODER_VIDEO && packet->track_idx == 0)
 			output->total_frames++;
 	}
 
@@ -1922,10 +2090,13 @@ static inline void start_raw_audio(obs_output_t *output)
 static void reset_packet_data(obs_output_t *output)
 {
 	output->received_audio = false;
-	output->received_video = false;
+	reset_received_video(output);
 	output->highest_audio_ts = 0;
-	output->highest_video_ts = 0;
-	output->video_offset = 0;
+
+	for (size_t i = 0; i < MAX_OUTPUT_VIDEO_ENCODERS; i++) {
+		output->highest_video_ts[i] = 0;
+		output->video_offsets[i] = 0;
+	}
 
 	for (size_t i = 0; i < MAX_AUDIO_MIXES; i++)
 		output->audio_offsets[i] = 0;
@@ -1938,6 +2109,17 @@ static inline bool preserve_active(struct obs_output *output)
 	return (output->delay_flags & OBS_OUTPUT_DELAY_PRESERVE) != 0;
 }
 
+static inline void start_video_encoders(struct obs_output *output,
+					encoded_callback_t encoded_callback)
+{
+	size_t num_tracks = num_video_tracks(output);
+
+	for (size_t i = 0; i < num_tracks; i++) {
+		obs_encoder_start(output->video_encoders[i], encoded_callback,
+				  output);
+	}
+}
+
 static void hook_data_capture(struct obs_output *output, bool encoded,
 			      bool has_video, bool has_audio)
 {
@@ -1962,16 +2144,23 @@ static void hook_data_capture(struct obs_output *output, bool encoded,
 
 			blog(LOG_INFO,
 			     "Output '%s': %" PRIu32 " second delay "
-			     "active, preserve on disconnect is %s",
+			     "active, preserve on disconnect is %s, "
+			     "spill to disk is %s",
 			     output->context.name, output->delay_sec,
-			     preserve_active(output) ? "on" : "off");
+			     preserve_active(output) ? "on" : "off",
+			     (output->delay_cur_flags &
+			      OBS_OUTPUT_DELAY_SPILL) != 0
+				     ? "on"
+				     : "off");
 		}
 
+		if (obs_output_packet_queue_start(output, encoded_callback))
+			encoded_callback = queue_encoded_packet;
+
 		if (has_audio)
 			start_audio_encoders(output, encoded_callback);
 		if (has_video)
-			obs_encoder_start(output->video_encoder,
-					  encoded_callback, output);
+			start_video_encoders(output, encoded_callback);
 	} else {
 		if (has_video)
 			start_raw_video(output->video,
@@ -2073,7 +2262,8 @@ static inline bool initialize_audio_encoders(obs_output_t *output,
 	for (size_t i = 0; i < num_mixes; i++) {
 
 		if (output->audio_encoders[i] && force_encoder)
-			ensure_force_initialize_encoder(output->video_encoder);
+			ensure_force_initialize_encoder(
+				output->video_encoders[0]);
 
 		if (!obs_encoder_initialize(output->audio_encoders[i])) {
 			obs_output_set_last_error(
@@ -2086,6 +2276,26 @@ static inline bool initialize_audio_encoders(obs_output_t *output,
 	return true;
 }
 
+static inline bool initialize_video_encoders(obs_output_t *output,
+					     size_t num_tracks,
+					     bool force_encoder)
+{
+	for (size_t i = 0; i < num_tracks; i++) {
+		obs_encoder_t *video = output->video_encoders[i];
+
+		if (video && force_encoder)
+			ensure_force_initialize_encoder(video);
+
+		if (!obs_encoder_initialize(video)) {
+			obs_output_set_last_error(
+				output, obs_encoder_get_last_error(video));
+			return false;
+		}
+	}
+
+	return true;
+}
+
 static inline obs_encoder_t *find_inactive_audio_encoder(obs_output_t *output,
 							 size_t num_mixes)
 {
@@ -2101,7 +2311,7 @@ static inline obs_encoder_t *find_inactive_audio_encoder(obs_output_t *output,
 
 static inline void pair_encoders(obs_output_t *output, size_t num_mixes)
 {
-	struct obs_encoder *video = output->video_encoder;
+	struct obs_encoder *video = output->video_encoders[0];
 	struct obs_encoder *audio =
 		find_inactive_audio_encoder(output, num_mixes);
 
@@ -2136,17 +2346,12 @@ bool obs_output_initialize_encoders(obs_output_t *output, uint32_t flags)
 	convert_flags(output, flags, &encoded, &has_video, &has_audio,
 		      &has_service, &force_encoder);
 
-	if (output->video_encoder && force_encoder)
-		ensure_force_initialize_encoder(output->video_encoder);
-
 	if (!encoded)
 		return false;
-	if (has_video && !obs_encoder_initialize(output->video_encoder)) {
-		obs_output_set_last_error(
-			output,
-			obs_encoder_get_last_error(output->video_encoder));
+	if (has_video &&
+	    !initialize_video_encoders(output, num_video_tracks(output),
+				       force_encoder))
 		return false;
-	}
 	if (has_audio &&
 	    !initialize_audio_encoders(output, num_mixes, force_encoder))
 		return false;
@@ -2290,6 +2495,17 @@ static inline void stop_raw_audio(obs_output_t *output)
 	}
 }
 
+static inline void stop_video_encoders(obs_output_t *output,
+				       encoded_callback_t encoded_callback)
+{
+	size_t num_tracks = num_video_tracks(output);
+
+	for (size_t i = 0; i < num_tracks; i++) {
+		obs_encoder_stop(output->video_encoders[i], encoded_callback,
+				 output);
+	}
+}
+
 static void *end_data_capture_thread(void *data)
 {
 	bool encoded, has_video, has_audio, has_service, force_encoder;
@@ -2300,7 +2516,9 @@ static void *end_data_capture_thread(void *data)
 		      &force_encoder);
 
 	if (encoded) {
-		if (output->active_delay_ns)
+		if (output->packet_thread_active)
+			encoded_callback = queue_encoded_packet;
+		else if (output->active_delay_ns)
 			encoded_callback = process_delay;
 		else
 			encoded_callback = (has_video && has_audio)
@@ -2308,10 +2526,12 @@ static void *end_data_capture_thread(void *data)
 						   : default_encoded_callback;
 
 		if (has_video)
-			obs_encoder_stop(output->video_encoder,
-					 encoded_callback, output);
+			stop_video_encoders(output, encoded_callback);
 		if (has_audio)
 			stop_audio_encoders(output, encoded_callback);
+
+		/* deliver whatever the encoders queued before stopping */
+		obs_output_packet_queue_stop(output);
 	} else {
 		if (has_video)
 			stop_raw_video(output->video,
@@ -2671,9 +2891,11 @@ const char *obs_output_get_last_error(obs_output_t *output)
 	if (output->last_error_message) {
 		return output->last_error_message;
 	} else {
-		obs_encoder_t *vencoder = output->video_encoder;
-		if (vencoder && vencoder->last_error_message) {
-			return vencoder->last_error_message;
+		for (size_t i = 0; i < MAX_OUTPUT_VIDEO_ENCODERS; i++) {
+			obs_encoder_t *vencoder = output->video_encoders[i];
+			if (vencoder && vencoder->last_error_message) {
+				return vencoder->last_error_message;
+			}
 		}
 
 		for (size_t i = 0; i < MAX_AUDIO_MIXES; i++) {
@@ -0,0 +1,166 @@
+/******************************************************************************
+    Copyright (C) 2023 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "obs-internal.h"
+
+/* Encoded packet data is reference counted through a long stored right
+ * before the data.  Packet data from the pool additionally stores its size
+ * class before the reference count and marks the count with
+ * PACKET_POOL_FLAG, so data allocated elsewhere with the plain long prefix
+ * (parsed AVC/HEVC packets, captions) keeps working unchanged.
+ *
+ * Size classes are powers of two from 256 bytes to 4 megabytes.  Freed
+ * blocks are cached per class up to a byte budget; anything larger is
+ * allocated and freed directly. */
+
+#define PACKET_POOL_FLAG 0x40000000L
+#define PACKET_POOL_MIN_SHIFT 8
+#define PACKET_POOL_CLASSES 15
+#define PACKET_POOL_CLASS_BUDGET (8 * 1024 * 1024)
+#define PACKET_POOL_MAX_CACHED 64
+#define PACKET_POOL_UNPOOLED -1L
+
+struct packet_header {
+	long size_class;
+	volatile long refs;
+};
+
+struct free_block {
+	struct free_block *next;
+};
+
+struct packet_class {
+	struct free_block *free;
+	size_t num_free;
+};
+
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct packet_class pool_classes[PACKET_POOL_CLASSES];
+
+static inline size_t class_size(long size_class)
+{
+	return (size_t)1 << (PACKET_POOL_MIN_SHIFT + size_class);
+}
+
+static inline size_t class_max_cached(long size_class)
+{
+	size_t max = PACKET_POOL_CLASS_BUDGET / class_size(size_class);
+	return max < PACKET_POOL_MAX_CACHED ? max : PACKET_POOL_MAX_CACHED;
+}
+
+static long get_size_class(size_t size)
+{
+	for (long i = 0; i < PACKET_POOL_CLASSES; i++) {
+		if (size <= class_size(i))
+			return i;
+	}
+
+	return PACKET_POOL_UNPOOLED;
+}
+
+static inline struct packet_header *get_header(uint8_t *data)
+{
+	return ((struct packet_header *)data) - 1;
+}
+
+uint8_t *packet_pool_alloc(size_t size)
+{
+	long size_class = get_size_class(size);
+	struct packet_header *header = NULL;
+
+	if (size_class != PACKET_POOL_UNPOOLED) {
+		struct packet_class *pc = &pool_classes[size_class];
+
+		pthread_mutex_lock(&pool_mutex);
+		if (pc->free) {
+			header = (struct packet_header *)pc->free;
+			pc->free = pc->free->next;
+			pc->num_free--;
+		}
+		pthread_mutex_unlock(&pool_mutex);
+
+		if (!header)
+			header = bmalloc(sizeof(*header) +
+					 class_size(size_class));
+	} else {
+		header = bmalloc(sizeof(*header) + size);
+	}
+
+	header->size_class = size_class;
+	header->refs = PACKET_POOL_FLAG | 1;
+	return (uint8_t *)(header + 1);
+}
+
+static void packet_pool_recycle(struct packet_header *header)
+{
+	long size_class = header->size_class;
+
+	/* the pool is flushed on shutdown, so stop caching once libobs is
+	 * gone to keep late releases from showing up as leaks */
+	if (size_class != PACKET_POOL_UNPOOLED && obs) {
+		struct packet_class *pc = &pool_classes[size_class];
+		struct free_block *block = (struct free_block *)header;
+		bool cached = false;
+
+		pthread_mutex_lock(&pool_mutex);
+		if (pc->num_free < class_max_cached(size_class)) {
+			block->next = pc->free;
+			pc->free = block;
+			pc->num_free++;
+			cached = true;
+		}
+		pthread_mutex_unlock(&pool_mutex);
+
+		if (cached)
+			return;
+	}
+
+	bfree(header);
+}
+
+void packet_data_addref(uint8_t *data)
+{
+	os_atomic_inc_long(((long *)data) - 1);
+}
+
+void packet_data_release(uint8_t *data)
+{
+	long *p_refs = ((long *)data) - 1;
+	long refs = os_atomic_dec_long(p_refs);
+
+	if (refs == PACKET_POOL_FLAG)
+		packet_pool_recycle(get_header(data));
+	else if (refs == 0)
+		bfree(p_refs);
+}
+
+void packet_pool_free(void)
+{
+	pthread_mutex_lock(&pool_mutex);
+	for (size_t i = 0; i < PACKET_POOL_CLASSES; i++) {
+		struct packet_class *pc = &pool_classes[i];
+
+		while (pc->free) {
+			struct free_block *next = pc->free->next;
+			bfree(pc->free);
+			pc->free = next;
+		}
+
+		pc->num_free = 0;
+	}
+	pthread_mutex_unlock(&pool_mutex);
+}
@@ -446,6 +446,7 @@ static void update_item_transform(struct obs_scene_item *item, bool update_tex)
 	scale = item->scale;
 	item->last_width = width;
 	item->last_height = height;
+	item->output_cached = false;
 
 	width = cx;
 	height = cy;
@@ -547,9 +548,83 @@ static inline bool item_texture_enabled(const struct obs_scene_item *item)
 	       (item_is_scene(item) && !item->is_group);
 }
 
+/*
+ * Consecutive items drawn from their item texture with the same effect,
+ * technique, sampler and blend mode share one technique pass instead of
+ * beginning and ending it for every item.  Only the texture, the transform
+ * and a few effect parameters change between their draws, which the
+ * backends upload per draw.  Anything that renders in between (sources
+ * drawn directly, or item textures being updated) ends the batch first.
+ */
+struct item_batch {
+	gs_effect_t *effect;
+	gs_technique_t *tech;
+	const char *tech_name;
+	enum obs_blending_type blend_type;
+	bool point;
+	bool active;
+};
+
+static void end_item_batch(struct item_batch *batch)
+{
+	if (!batch->active)
+		return;
+
+	gs_technique_end_pass(batch->tech);
+	gs_technique_end(batch->tech);
+	gs_blend_state_pop();
+	batch->active = false;
+}
+
+static inline bool item_batch_matches(const struct item_batch *batch,
+				      gs_effect_t *effect,
+				      const char *tech_name,
+				      enum obs_blending_type blend_type,
+				      bool point)
+{
+	return batch->active && batch->effect == effect &&
+	       batch->blend_type == blend_type && batch->point == point &&
+	       strcmp(batch->tech_name, tech_name) == 0;
+}
+
+static bool begin_item_batch(struct item_batch *batch, gs_effect_t *effect,
+			     const char *tech_name,
+			     enum obs_blending_type blend_type, bool point)
+{
+	gs_technique_t *tech = gs_effect_get_technique(effect, tech_name);
+
+	if (!tech || gs_get_effect())
+		return false;
+
+	gs_blend_state_push();
+	gs_blend_function_separate(obs_blend_mode_params[blend_type].src_color,
+				   obs_blend_mode_params[blend_type].dst_color,
+				   obs_blend_mode_params[blend_type].src_alpha,
+				   obs_blend_mode_params[blend_type].dst_alpha);
+	gs_blend_op(obs_blend_mode_params[blend_type].op);
+
+	/* multi-pass techniques are drawn item by item */
+	if (gs_technique_begin(tech) != 1) {
+		gs_technique_end(tech);
+		gs_blend_state_pop();
+		return false;
+	}
+
+	gs_technique_begin_pass(tech, 0);
+
+	batch->effect = effect;
+	batch->tech = tech;
+	batch->tech_name = tech_name;
+	batch->blend_type = blend_type;
+	batch->point = point;
+	batch->active = true;
+	return true;
+}
+
 static void render_item_texture(struct obs_scene_item *item,
 				enum gs_color_space current_space,
-				enum gs_color_space source_space)
+				enum gs_color_space source_space,
+				struct item_batch *batch)
 {
 	gs_texture_t *tex = gs_texrender_get_texture(item->item_render);
 	if (!tex) {
@@ -565,12 +640,11 @@ static void render_item_texture(struct obs_scene_item *item,
 	uint32_t cy = gs_texture_get_height(tex);
 
 	bool upscale = false;
+	bool point = false;
+	bool set_base_dimension = false;
 	if (type != OBS_SCALE_DISABLE) {
 		if (type == OBS_SCALE_POINT) {
-			gs_eparam_t *image =
-				gs_effect_get_param_by_name(effect, "image");
-			gs_effect_set_next_sampler(image,
-						   obs->video.point_sampler);
+			point = true;
 
 		} else if (!close_float(item->output_scale.x, 1.0f, EPSILON) ||
 			   !close_float(item->output_scale.y, 1.0f, EPSILON)) {
@@ -587,24 +661,7 @@ static void render_item_texture(struct obs_scene_item *item,
 					  (item->output_scale.y >= 1.0f);
 			}
 
-			gs_eparam_t *const scale_param =
-				gs_effect_get_param_by_name(effect,
-							    "base_dimension");
-			if (scale_param) {
-				struct vec2 base_res = {(float)cx, (float)cy};
-
-				gs_effect_set_vec2(scale_param, &base_res);
-			}
-
-			gs_eparam_t *const scale_i_param =
-				gs_effect_get_param_by_name(effect,
-							    "base_dimension_i");
-			if (scale_i_param) {
-				struct vec2 base_res_i = {1.0f / (float)cx,
-							  1.0f / (float)cy};
-
-				gs_effect_set_vec2(scale_i_param, &base_res_i);
-			}
+			set_base_dimension = true;
 		}
 	}
 
@@ -692,24 +749,59 @@ static void render_item_texture(struct obs_scene_item *item,
 		}
 	}
 
+	if (!item_batch_matches(batch, effect, tech_name, item->blend_type,
+				point))
+		end_item_batch(batch);
+
+	if (point) {
+		gs_eparam_t *image =
+			gs_effect_get_param_by_name(effect, "image");
+		gs_effect_set_next_sampler(image, obs->video.point_sampler);
+	}
+
+	if (set_base_dimension) {
+		gs_eparam_t *const scale_param =
+			gs_effect_get_param_by_name(effect, "base_dimension");
+		if (scale_param) {
+			struct vec2 base_res = {(float)cx, (float)cy};
+
+			gs_effect_set_vec2(scale_param, &base_res);
+		}
+
+		gs_eparam_t *const scale_i_param =
+			gs_effect_get_param_by_name(effect, "base_dimension_i");
+		if (scale_i_param) {
+			struct vec2 base_res_i = {1.0f / (float)cx,
+						  1.0f / (float)cy};
+
+			gs_effect_set_vec2(scale_i_param, &base_res_i);
+		}
+	}
+
 	gs_eparam_t *const multiplier_param =
 		gs_effect_get_param_by_name(effect, "multiplier");
 	if (multiplier_param)
 		gs_effect_set_float(multiplier_param, multiplier);
 
-	gs_blend_state_push();
+	if (batch->active ||
+	    begin_item_batch(batch, effect, tech_name, item->blend_type,
+			     point)) {
+		obs_source_draw(tex, 0, 0, 0, 0, 0);
+	} else {
+		gs_blend_state_push();
 
-	gs_blend_function_separate(
-		obs_blend_mode_params[item->blend_type].src_color,
-		obs_blend_mode_params[item->blend_type].dst_color,
-		obs_blend_mode_params[item->blend_type].src_alpha,
-		obs_blend_mode_params[item->blend_type].dst_alpha);
-	gs_blend_op(obs_blend_mode_params[item->blend_type].op);
+		gs_blend_function_separate(
+			obs_blend_mode_params[item->blend_type].src_color,
+			obs_blend_mode_params[item->blend_type].dst_color,
+			obs_blend_mode_params[item->blend_type].src_alpha,
+			obs_blend_mode_params[item->blend_type].dst_alpha);
+		gs_blend_op(obs_blend_mode_params[item->blend_type].op);
 
-	while (gs_effect_loop(effect, tech_name))
-		obs_source_draw(tex, 0, 0, 0, 0, 0);
+		while (gs_effect_loop(effect, tech_name))
+			obs_source_draw(tex, 0, 0, 0, 0, 0);
 
-	gs_blend_state_pop();
+		gs_blend_state_pop();
+	}
 
 	GS_DEBUG_MARKER_END();
 }
@@ -728,12 +820,32 @@ static bool are_texcoords_centered(struct matrix4 *m)
 	return memcmp(m, &copy, sizeof(*m)) == 0;
 }
 
-static inline void render_item(struct obs_scene_item *item)
+/* static sources are rendered to a texture once and reused until their
+ * content generation changes */
+static inline bool item_output_cacheable(struct obs_scene_item *item)
+{
+	return !transition_active(item->show_transition) &&
+	       !transition_active(item->hide_transition) &&
+	       obs_source_video_static(item->source);
+}
+
+static inline bool item_output_cache_valid(struct obs_scene_item *item,
+					   long generation,
+					   enum gs_color_space space)
+{
+	return item->output_cached && item->cached_generation == generation &&
+	       item->cached_space == space &&
+	       gs_texrender_get_texture(item->item_render);
+}
+
+static inline void render_item(struct obs_scene_item *item,
+			       struct item_batch *batch)
 {
 	GS_DEBUG_MARKER_BEGIN_FORMAT(GS_DEBUG_COLOR_ITEM, "Item: %s",
 				     obs_source_get_name(item->source));
 
-	const bool use_texrender = item_texture_enabled(item);
+	const bool cache_output = item_output_cacheable(item);
+	const bool use_texrender = item_texture_enabled(item) || cache_output;
 
 	obs_source_t *const source = item->source;
 	const enum gs_color_space current_space = gs_get_color_space();
@@ -747,6 +859,7 @@ static inline void render_item(struct obs_scene_item *item)
 	     (gs_texrender_get_format(item->item_render) != format))) {
 		gs_texrender_destroy(item->item_render);
 		item->item_render = NULL;
+		item->output_cached = false;
 	}
 
 	if (!item->item_render && use_texrender) {
@@ -763,10 +876,19 @@ static inline void render_item(struct obs_scene_item *item)
 
 		uint32_t cx = calc_cx(item, width);
 		uint32_t cy = calc_cy(item, height);
-
-		if (cx && cy &&
-		    gs_texrender_begin_with_color_space(item->item_render, cx,
-							cy, source_space)) {
+		long generation = obs_source_get_content_generation(source);
+		const bool reuse_output =
+			cache_output &&
+			item_output_cache_valid(item, generation, source_space);
+
+		if (!reuse_output)
+			end_item_batch(batch);
+
+		if (reuse_output) {
+			/* reuse last output */
+		} else if (cx && cy &&
+			   gs_texrender_begin_with_color_space(
+				   item->item_render, cx, cy, source_space)) {
 			float cx_scale = (float)width / (float)cx;
 			float cy_scale = (float)height / (float)cy;
 			struct vec4 clear_color;
@@ -807,6 +929,10 @@ static inline void render_item(struct obs_scene_item *item)
 			}
 
 			gs_texrender_end(item->item_render);
+
+			item->output_cached = cache_output;
+			item->cached_generation = generation;
+			item->cached_space = source_space;
 		}
 	}
 
@@ -816,8 +942,11 @@ static inline void render_item(struct obs_scene_item *item)
 	const bool previous = gs_set_linear_srgb(linear_srgb);
 	gs_matrix_push();
 	gs_matrix_mul(&item->draw_transform);
+	if (!item->item_render)
+		end_item_batch(batch);
+
 	if (item->item_render) {
-		render_item_texture(item, current_space, source_space);
+		render_item_texture(item, current_space, source_space, batch);
 	} else if (item->user_visible &&
 		   transition_active(item->show_transition)) {
 		const int cx = obs_source_get_width(item->source);
@@ -912,6 +1041,7 @@ static void scene_video_render(void *data, gs_effect_t *effect)
 	DARRAY(struct obs_scene_item *) remove_items;
 	struct obs_scene *scene = data;
 	struct obs_scene_item *item;
+	struct item_batch batch = {0};
 
 	da_init(remove_items);
 
@@ -932,21 +1062,21 @@ static void scene_video_render(void *data, gs_effect_t *effect)
 			case OBS_MAIN_VIDEO_RENDERING: {
 				if (item->user_visible ||
 				    transition_active(item->hide_transition))
-					render_item(item);
+					render_item(item, &batch);
 				break;
 			}
 			case OBS_STREAMING_VIDEO_RENDERING: {
 				if ((item->user_visible ||
 				     transition_active(item->hide_transition)) &&
 				    item->stream_visible)
-					render_item(item);
+					render_item(item, &batch);
 				break;
 			}
 			case OBS_RECORDING_VIDEO_RENDERING: {
 				if ((item->user_visible ||
 				     transition_active(item->hide_transition)) &&
 				    item->recording_visible)
-					render_item(item);
+					render_item(item, &batch);
 				break;
 			}
 			}
@@ -955,12 +1085,13 @@ static void scene_video_render(void *data, gs_effect_t *effect)
 		} else {
 			if (item->user_visible ||
 			    transition_active(item->hide_transition))
-				render_item(item);
+				render_item(item, &batch);
 		}
 
 		item = item->next;
 	}
 
+	end_item_batch(&batch);
 	gs_blend_state_pop();
 
 	video_unlock(scene);
@@ -972,6 +1103,65 @@ static void scene_video_render(void *data, gs_effect_t *effect)
 	UNUSED_PARAMETER(effect);
 }
 
+static inline bool item_rendered_in_mode(struct obs_scene_item *item,
+					 enum obs_video_rendering_mode mode)
+{
+	if (!item->user_visible && !transition_active(item->hide_transition))
+		return false;
+
+	switch (mode) {
+	case OBS_STREAMING_VIDEO_RENDERING:
+		return item->stream_visible;
+	case OBS_RECORDING_VIDEO_RENDERING:
+		return item->recording_visible;
+	case OBS_MAIN_VIDEO_RENDERING:
+		break;
+	}
+
+	return true;
+}
+
+bool obs_source_renders_same_in_modes(obs_source_t *source,
+				      enum obs_video_rendering_mode a,
+				      enum obs_video_rendering_mode b)
+{
+	bool same = true;
+
+	if (!source || a == b)
+		return true;
+
+	if (source->info.type == OBS_SOURCE_TYPE_TRANSITION) {
+		/* don't risk lock ordering issues with this already being
+		 * under a scene lock, just assume it differs */
+		if (pthread_mutex_trylock(&source->transition_mutex) != 0)
+			return false;
+		for (size_t i = 0; same && i < 2; i++)
+			same = obs_source_renders_same_in_modes(
+				source->transition_sources[i], a, b);
+		pthread_mutex_unlock(&source->transition_mutex);
+		return same;
+	}
+
+	if (!obs_source_is_scene(source) && !obs_source_is_group(source))
+		return true;
+
+	obs_scene_t *scene = source->context.data;
+	video_lock(scene);
+
+	for (struct obs_scene_item *item = scene->first_item; item && same;
+	     item = item->next) {
+		bool rendered = item_rendered_in_mode(item, a);
+		if (rendered != item_rendered_in_mode(item, b))
+			same = false;
+		else if (rendered)
+			same = obs_source_renders_same_in_modes(item->source,
+								a, b);
+	}
+
+	video_unlock(scene);
+	return same;
+}
+
 static void set_visibility(struct obs_scene_item *item, bool vis)
 {
 	pthread_mutex_lock(&item->actions_mutex);
@@ -2591,7 +2781,8 @@ bool obs_sceneitem_selected(const obs_sceneitem_t *item)
 
 #define do_update_transform(item)                                          \
 	do {                                                               \
-		if (!item->parent || item->parent->is_group)               \
+		if (!item->parent || item->parent->is_group ||             \
+		    item->parent->defer_transform_updates)                 \
 			os_atomic_set_bool(&item->update_transform, true); \
 		else                                                       \
 			update_item_transform(item, false);                \
@@ -3132,6 +3323,34 @@ bool obs_scene_reorder_items(obs_scene_t *scene,
 	return true;
 }
 
+/* assumes scene is locked.  items inside groups are left flagged, the next
+ * render updates them along with their group. */
+static void apply_deferred_transforms(obs_scene_t *scene)
+{
+	struct obs_scene_item *item = scene->first_item;
+
+	while (item) {
+		if (item->is_group &&
+		    os_atomic_load_bool(&item->update_group_resize)) {
+			obs_scene_t *group_scene = item->source->context.data;
+
+			full_lock(group_scene);
+			resize_group(item);
+			full_unlock(group_scene);
+
+			/* resizing already updated the group's transform */
+			if (!os_atomic_load_bool(&item->update_group_resize))
+				os_atomic_set_bool(&item->update_transform,
+						   false);
+		}
+
+		if (os_atomic_load_bool(&item->update_transform))
+			update_item_transform(item, true);
+
+		item = item->next;
+	}
+}
+
 void obs_scene_atomic_update(obs_scene_t *scene,
 			     obs_scene_atomic_update_func func, void *data)
 {
@@ -3143,7 +3362,10 @@ void obs_scene_atomic_update(obs_scene_t *scene,
 		return;
 
 	full_lock(scene);
+	scene->defer_transform_updates++;
 	func(data, scene);
+	if (--scene->defer_transform_updates == 0)
+		apply_deferred_transforms(scene);
 	full_unlock(scene);
 	obs_scene_release(scene);
 }
@@ -3443,6 +3665,11 @@ static void resize_group(obs_sceneitem_t *group)
 	if (os_atomic_load_long(&group->defer_group_resize) > 0)
 		return;
 
+	if (group->parent && group->parent->defer_transform_updates) {
+		os_atomic_set_bool(&group->update_group_resize, true);
+		return;
+	}
+
 	if (!resize_scene_base(scene, &minv, &maxv, &scale))
 		return;
 
@@ -52,6 +52,12 @@ struct obs_scene_item {
 	gs_texrender_t *item_render;
 	struct obs_sceneitem_crop crop;
 
+	/* item_render holds the output of a static source as of this content
+	 * generation, and doesn't need to be rendered again */
+	bool output_cached;
+	long cached_generation;
+	enum gs_color_space cached_space;
+
 	struct vec2 pos;
 	struct vec2 scale;
 	float rot;
@@ -106,4 +112,9 @@ struct obs_scene {
 	pthread_mutex_t video_mutex;
 	pthread_mutex_t audio_mutex;
 	struct obs_scene_item *first_item;
+
+	/* nonzero inside obs_scene_atomic_update, protected by the scene
+	 * locks.  transform changes and group resizes are only flagged and
+	 * then applied once when the update ends. */
+	long defer_transform_updates;
 };
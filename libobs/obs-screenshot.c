@@ -0,0 +1,380 @@
+/******************************************************************************
+    Copyright (C) 2023 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include <libavcodec/avcodec.h>
+#include <libavutil/imgutils.h>
+#include <libswscale/swscale.h>
+
+#include "util/task.h"
+#include "obs-internal.h"
+
+/* A screenshot is rendered and staged on one frame, then mapped a few frames
+ * later once the GPU has long since finished the copy, so the graphics thread
+ * doesn't stall waiting on it.  The pixels are then handed off to a task
+ * thread to be encoded and written. */
+
+#define SCREENSHOT_MAP_DELAY 2
+
+struct obs_screenshot {
+	obs_weak_source_t *source;
+	bool main_texture;
+	char *path;
+	enum AVCodecID codec_id;
+	uint32_t cx;
+	uint32_t cy;
+	obs_screenshot_cb_t callback;
+	void *param;
+
+	gs_texrender_t *texrender;
+	gs_stagesurf_t *stagesurf;
+	int frames;
+
+	uint8_t *data;
+	uint32_t linesize;
+};
+
+static pthread_mutex_t screenshots_mutex = PTHREAD_MUTEX_INITIALIZER;
+static DARRAY(struct obs_screenshot *) screenshots;
+static os_task_queue_t *screenshot_tasks;
+
+static enum AVCodecID get_codec_id(const char *path)
+{
+	const char *ext = strrchr(path, '.');
+	if (!ext)
+		return AV_CODEC_ID_NONE;
+
+	ext++;
+	if (astrcmpi(ext, "png") == 0)
+		return AV_CODEC_ID_PNG;
+	if (astrcmpi(ext, "jpg") == 0 || astrcmpi(ext, "jpeg") == 0)
+		return AV_CODEC_ID_MJPEG;
+	if (astrcmpi(ext, "webp") == 0)
+		return AV_CODEC_ID_WEBP;
+
+	return AV_CODEC_ID_NONE;
+}
+
+/* graphics objects are destroyed in finish_screenshot, before this point */
+static void screenshot_free(struct obs_screenshot *ss)
+{
+	obs_weak_source_release(ss->source);
+	bfree(ss->data);
+	bfree(ss->path);
+	bfree(ss);
+}
+
+/* ------------------------------------------------------------------------- */
+/* encoding (task thread)                                                    */
+
+static bool convert_frame(AVFrame *frame, const struct obs_screenshot *ss,
+			  bool full_range)
+{
+	const uint8_t *src[4] = {ss->data};
+	const int src_linesize[4] = {(int)ss->linesize};
+	struct SwsContext *sws;
+	const int *coeffs;
+
+	if (frame->format == AV_PIX_FMT_RGBA) {
+		av_image_copy(frame->data, frame->linesize, src, src_linesize,
+			      AV_PIX_FMT_RGBA, ss->cx, ss->cy);
+		return true;
+	}
+
+	sws = sws_getContext(ss->cx, ss->cy, AV_PIX_FMT_RGBA, ss->cx, ss->cy,
+			     frame->format, SWS_BICUBIC, NULL, NULL, NULL);
+	if (!sws)
+		return false;
+
+	coeffs = sws_getCoefficients(SWS_CS_ITU601);
+	sws_setColorspaceDetails(sws, coeffs, 1, coeffs, full_range, 0,
+				 1 << 16, 1 << 16);
+
+	sws_scale(sws, src, src_linesize, 0, ss->cy, frame->data,
+		  frame->linesize);
+	sws_freeContext(sws);
+	return true;
+}
+
+static bool encode_screenshot(const struct obs_screenshot *ss)
+{
+	const AVCodec *codec = avcodec_find_encoder(ss->codec_id);
+	enum AVPixelFormat format = AV_PIX_FMT_RGBA;
+	AVCodecContext *context = NULL;
+	AVFrame *frame = NULL;
+	AVPacket *packet = NULL;
+	bool full_range = ss->codec_id == AV_CODEC_ID_MJPEG;
+	bool success = false;
+	FILE *file = NULL;
+
+	if (!codec) {
+		blog(LOG_WARNING, "Screenshot: No encoder for '%s'", ss->path);
+		return false;
+	}
+
+	if (codec->pix_fmts)
+		format = avcodec_find_best_pix_fmt_of_list(
+			codec->pix_fmts, AV_PIX_FMT_RGBA, 0, NULL);
+
+	context = avcodec_alloc_context3(codec);
+	if (!context)
+		goto fail;
+
+	context->width = ss->cx;
+	context->height = ss->cy;
+	context->pix_fmt = format;
+	context->time_base = (AVRational){1, 1};
+	context->color_range = full_range ? AVCOL_RANGE_JPEG : AVCOL_RANGE_MPEG;
+
+	if (avcodec_open2(context, codec, NULL) < 0)
+		goto fail;
+
+	frame = av_frame_alloc();
+	packet = av_packet_alloc();
+	if (!frame || !packet)
+		goto fail;
+
+	frame->format = format;
+	frame->width = ss->cx;
+	frame->height = ss->cy;
+	if (av_frame_get_buffer(frame, 0) < 0)
+		goto fail;
+	if (!convert_frame(frame, ss, full_range))
+		goto fail;
+
+	if (avcodec_send_frame(context, frame) < 0)
+		goto fail;
+	avcodec_send_frame(context, NULL);
+
+	file = os_fopen(ss->path, "wb");
+	if (!file)
+		goto fail;
+
+	/* still image encoders output the whole file as one packet */
+	while (avcodec_receive_packet(context, packet) == 0) {
+		success = fwrite(packet->data, 1, packet->size, file) ==
+			  (size_t)packet->size;
+		av_packet_unref(packet);
+	}
+
+	fclose(file);
+
+fail:
+	av_packet_free(&packet);
+	av_frame_free(&frame);
+	avcodec_free_context(&context);
+	return success;
+}
+
+static void screenshot_task(void *param)
+{
+	struct obs_screenshot *ss = param;
+	bool success = encode_screenshot(ss);
+
+	if (success)
+		blog(LOG_INFO, "Saved screenshot to '%s'", ss->path);
+	else
+		blog(LOG_WARNING, "Failed to save screenshot to '%s'",
+		     ss->path);
+
+	if (ss->callback)
+		ss->callback(ss->param, ss->path, success);
+
+	screenshot_free(ss);
+}
+
+/* ------------------------------------------------------------------------- */
+/* rendering (graphics thread)                                               */
+
+static bool render_screenshot(struct obs_screenshot *ss)
+{
+	obs_source_t *source = NULL;
+	uint32_t base_cx, base_cy;
+
+	if (!ss->main_texture) {
+		source = obs_weak_source_get_source(ss->source);
+		if (!source)
+			return false;
+
+		base_cx = obs_source_get_base_width(source);
+		base_cy = obs_source_get_base_height(source);
+	} else {
+		struct obs_video_info ovi;
+		obs_get_video_info(&ovi);
+		base_cx = ovi.base_width;
+		base_cy = ovi.base_height;
+	}
+
+	if (!ss->cx || !ss->cy) {
+		ss->cx = base_cx;
+		ss->cy = base_cy;
+	}
+
+	if (!base_cx || !base_cy || !ss->cx || !ss->cy) {
+		obs_source_release(source);
+		return false;
+	}
+
+	/* tonemapped to SDR, none of the formats here can store HDR */
+	ss->texrender = gs_texrender_create(GS_RGBA, GS_ZS_NONE);
+	ss->stagesurf = gs_stagesurface_create(ss->cx, ss->cy, GS_RGBA);
+
+	if (!ss->texrender || !ss->stagesurf) {
+		obs_source_release(source);
+		return false;
+	}
+
+	if (gs_texrender_begin_with_color_space(ss->texrender, ss->cx, ss->cy,
+						GS_CS_SRGB)) {
+		struct vec4 zero;
+		vec4_zero(&zero);
+
+		gs_clear(GS_CLEAR_COLOR, &zero, 0.0f, 0);
+		gs_ortho(0.0f, (float)base_cx, 0.0f, (float)base_cy, -100.0f,
+			 100.0f);
+
+		gs_blend_state_push();
+		gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
+
+		if (source) {
+			obs_source_inc_showing(source);
+			obs_source_video_render(source);
+			obs_source_dec_showing(source);
+		} else {
+			obs_render_main_texture();
+		}
+
+		gs_blend_state_pop();
+		gs_texrender_end(ss->texrender);
+	}
+
+	obs_source_release(source);
+
+	gs_stage_texture(ss->stagesurf,
+			 gs_texrender_get_texture(ss->texrender));
+	return true;
+}
+
+static bool copy_screenshot(struct obs_screenshot *ss)
+{
+	uint8_t *data;
+	uint32_t linesize;
+
+	if (!gs_stagesurface_map(ss->stagesurf, &data, &linesize))
+		return false;
+
+	ss->linesize = ss->cx * 4;
+	ss->data = bmalloc((size_t)ss->linesize * ss->cy);
+
+	for (uint32_t y = 0; y < ss->cy; y++)
+		memcpy(ss->data + y * ss->linesize, data + y * linesize,
+		       ss->linesize);
+
+	gs_stagesurface_unmap(ss->stagesurf);
+	return true;
+}
+
+static void finish_screenshot(struct obs_screenshot *ss, bool success)
+{
+	gs_stagesurface_destroy(ss->stagesurf);
+	gs_texrender_destroy(ss->texrender);
+	ss->stagesurf = NULL;
+	ss->texrender = NULL;
+
+	if (success && screenshot_tasks &&
+	    os_task_queue_queue_task(screenshot_tasks, screenshot_task, ss))
+		return;
+
+	if (ss->callback)
+		ss->callback(ss->param, ss->path, false);
+	screenshot_free(ss);
+}
+
+void obs_process_screenshots(void)
+{
+	pthread_mutex_lock(&screenshots_mutex);
+
+	for (size_t i = screenshots.num; i > 0; i--) {
+		struct obs_screenshot *ss = screenshots.array[i - 1];
+
+		if (!ss->stagesurf) {
+			if (!render_screenshot(ss)) {
+				da_erase(screenshots, i - 1);
+				finish_screenshot(ss, false);
+			}
+
+		} else if (++ss->frames >= SCREENSHOT_MAP_DELAY) {
+			da_erase(screenshots, i - 1);
+			finish_screenshot(ss, copy_screenshot(ss));
+		}
+	}
+
+	pthread_mutex_unlock(&screenshots_mutex);
+}
+
+void obs_free_screenshots(void)
+{
+	pthread_mutex_lock(&screenshots_mutex);
+
+	obs_enter_graphics();
+	for (size_t i = 0; i < screenshots.num; i++)
+		finish_screenshot(screenshots.array[i], false);
+	obs_leave_graphics();
+	da_free(screenshots);
+
+	pthread_mutex_unlock(&screenshots_mutex);
+
+	os_task_queue_destroy(screenshot_tasks);
+	screenshot_tasks = NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+
+bool obs_save_screenshot(obs_source_t *source, const char *path, uint32_t cx,
+			 uint32_t cy, obs_screenshot_cb_t callback, void *param)
+{
+	struct obs_screenshot *ss;
+	enum AVCodecID codec_id;
+
+	if (!obs || !path || !*path)
+		return false;
+
+	codec_id = get_codec_id(path);
+	if (codec_id == AV_CODEC_ID_NONE) {
+		blog(LOG_WARNING,
+		     "obs_save_screenshot: Unsupported image format for '%s'",
+		     path);
+		return false;
+	}
+
+	ss = bzalloc(sizeof(*ss));
+	ss->source = source ? obs_source_get_weak_source(source) : NULL;
+	ss->main_texture = !source;
+	ss->path = bstrdup(path);
+	ss->codec_id = codec_id;
+	ss->cx = cx;
+	ss->cy = cy;
+	ss->callback = callback;
+	ss->param = param;
+
+	pthread_mutex_lock(&screenshots_mutex);
+	if (!screenshot_tasks)
+		screenshot_tasks = os_task_queue_create();
+	da_push_back(screenshots, &ss);
+	pthread_mutex_unlock(&screenshots_mutex);
+
+	return true;
+}
@@ -231,7 +231,8 @@ void deinterlace_process_last_frame(obs_source_t *s, uint64_t sys_time)
 void set_deinterlace_texture_size(obs_source_t *source)
 {
 	const enum gs_color_format format =
-		convert_video_format(source->async_format, source->async_trc);
+		convert_video_format(source->async_format, source->async_trc,
+				     source->async_sdr_only);
 
 	if (source->async_gpu_conversion) {
 		source->async_prev_texrender =
@@ -243,6 +244,15 @@ void set_deinterlace_texture_size(obs_source_t *source)
 				source->async_convert_height[c],
 				source->async_texture_formats[c], 1, NULL,
 				GS_DYNAMIC);
+
+		if (obs_load_effect(&obs->video.deinterlace_yuv_effect,
+				    "deinterlace_yuv.effect")) {
+			for (int c = 0; c < source->async_channel_count; c++)
+				source->deinterlace_planes[c] =
+					gs_texrender_create(
+						source->async_texture_formats[c],
+						GS_ZS_NONE);
+		}
 	} else {
 		source->async_prev_textures[0] = gs_texture_create(
 			source->async_width, source->async_height, format, 1,
@@ -250,6 +260,16 @@ void set_deinterlace_texture_size(obs_source_t *source)
 	}
 }
 
+void deinterlace_free_planes(obs_source_t *source)
+{
+	for (size_t c = 0; c < MAX_AV_PLANES; c++) {
+		gs_texrender_destroy(source->deinterlace_planes[c]);
+		source->deinterlace_planes[c] = NULL;
+	}
+
+	source->deinterlace_yuv = false;
+}
+
 static inline struct obs_source_frame *get_prev_frame(obs_source_t *source,
 						      bool *updated)
 {
@@ -338,6 +358,44 @@ static inline gs_effect_t *get_effect(enum obs_deinterlace_mode mode)
 	case OBS_DEINTERLACE_MODE_YADIF_2X:
 		return obs_load_effect(&obs->video.deinterlace_yadif_2x_effect,
 				       "deinterlace_yadif_2x.effect");
+	case OBS_DEINTERLACE_MODE_MOTION_ADAPTIVE:
+		return obs_load_effect(
+			&obs->video.deinterlace_motion_adaptive_effect,
+			"deinterlace_motion_adaptive.effect");
+	case OBS_DEINTERLACE_MODE_MOTION_ADAPTIVE_2X:
+		return obs_load_effect(
+			&obs->video.deinterlace_motion_adaptive_2x_effect,
+			"deinterlace_motion_adaptive_2x.effect");
+	}
+
+	return NULL;
+}
+
+static inline const char *get_yuv_technique(enum obs_deinterlace_mode mode)
+{
+	switch (mode) {
+	case OBS_DEINTERLACE_MODE_DISABLE:
+		return NULL;
+	case OBS_DEINTERLACE_MODE_DISCARD:
+		return "Discard";
+	case OBS_DEINTERLACE_MODE_RETRO:
+		return "Retro";
+	case OBS_DEINTERLACE_MODE_BLEND:
+		return "Blend";
+	case OBS_DEINTERLACE_MODE_BLEND_2X:
+		return "Blend2x";
+	case OBS_DEINTERLACE_MODE_LINEAR:
+		return "Linear";
+	case OBS_DEINTERLACE_MODE_LINEAR_2X:
+		return "Linear2x";
+	case OBS_DEINTERLACE_MODE_YADIF:
+		return "Yadif";
+	case OBS_DEINTERLACE_MODE_YADIF_2X:
+		return "Yadif2x";
+	case OBS_DEINTERLACE_MODE_MOTION_ADAPTIVE:
+		return "MotionAdaptive";
+	case OBS_DEINTERLACE_MODE_MOTION_ADAPTIVE_2X:
+		return "MotionAdaptive2x";
 	}
 
 	return NULL;
@@ -356,12 +414,110 @@ static bool deinterlace_linear_required(enum obs_deinterlace_mode mode)
 	case OBS_DEINTERLACE_MODE_LINEAR_2X:
 	case OBS_DEINTERLACE_MODE_YADIF:
 	case OBS_DEINTERLACE_MODE_YADIF_2X:
+	case OBS_DEINTERLACE_MODE_MOTION_ADAPTIVE:
+	case OBS_DEINTERLACE_MODE_MOTION_ADAPTIVE_2X:
 		return true;
 	}
 
 	return false;
 }
 
+/* whether the second field of the current frame is due */
+static inline bool deinterlace_frame2(const obs_source_t *s)
+{
+	const uint64_t frame2_ts =
+		s->deinterlace_frame_ts + s->deinterlace_offset +
+		s->deinterlace_half_duration - TWOX_TOLERANCE;
+	return obs->video.video_time >= frame2_ts;
+}
+
+void deinterlace_set_yuv_frame(obs_source_t *s,
+			       const struct obs_source_frame *frame)
+{
+	s->deinterlace_conv_frame = *frame;
+	memset(s->deinterlace_conv_frame.data, 0,
+	       sizeof(s->deinterlace_conv_frame.data));
+	s->deinterlace_yuv_dirty = true;
+}
+
+/* deinterlaces each plane of the raw current and previous frames and then
+ * converts the result into the async texrender.  the planes are at most
+ * half the size of the RGBA textures the other path samples, and the
+ * previous frame never has to be converted.  the result is kept until the
+ * frame or field changes, so rendering the source more than once per frame
+ * doesn't redo it */
+bool deinterlace_convert_yuv(obs_source_t *s)
+{
+	gs_effect_t *effect = obs->video.deinterlace_yuv_effect;
+	const char *tech_name = get_yuv_technique(s->deinterlace_mode);
+	gs_texture_t *planes[MAX_AV_PLANES] = {0};
+	bool frame2;
+
+	if (!s->deinterlace_yuv || !effect || !tech_name ||
+	    !s->async_texrender)
+		return false;
+
+	frame2 = deinterlace_frame2(s);
+	if (!s->deinterlace_yuv_dirty && frame2 == s->deinterlace_yuv_frame2)
+		return true;
+
+	gs_eparam_t *image = gs_effect_get_param_by_name(effect, "image");
+	gs_eparam_t *prev =
+		gs_effect_get_param_by_name(effect, "previous_image");
+	gs_eparam_t *field = gs_effect_get_param_by_name(effect, "field_order");
+	gs_eparam_t *frame2_param =
+		gs_effect_get_param_by_name(effect, "frame2");
+	gs_eparam_t *dimensions =
+		gs_effect_get_param_by_name(effect, "dimensions");
+
+	GS_DEBUG_MARKER_BEGIN(GS_DEBUG_COLOR_CONVERT_FORMAT,
+			      "Deinterlace Planes");
+
+	const bool previous = gs_framebuffer_srgb_enabled();
+	gs_enable_framebuffer_srgb(false);
+	gs_enable_blending(false);
+
+	for (int c = 0; c < s->async_channel_count; c++) {
+		gs_texrender_t *texrender = s->deinterlace_planes[c];
+		const uint32_t cx = s->async_convert_width[c];
+		const uint32_t cy = s->async_convert_height[c];
+		struct vec2 size = {(float)cx, (float)cy};
+
+		if (!texrender || !s->async_textures[c] ||
+		    !s->async_prev_textures[c])
+			break;
+
+		gs_texrender_reset(texrender);
+		if (!gs_texrender_begin(texrender, cx, cy))
+			break;
+
+		gs_effect_set_texture(image, s->async_textures[c]);
+		gs_effect_set_texture(prev, s->async_prev_textures[c]);
+		gs_effect_set_int(field, s->deinterlace_top_first);
+		gs_effect_set_bool(frame2_param, frame2);
+		gs_effect_set_vec2(dimensions, &size);
+
+		while (gs_effect_loop(effect, tech_name))
+			gs_draw_sprite(NULL, 0, cx, cy);
+
+		gs_texrender_end(texrender);
+		planes[c] = gs_texrender_get_texture(texrender);
+	}
+
+	gs_enable_blending(true);
+	gs_enable_framebuffer_srgb(previous);
+
+	GS_DEBUG_MARKER_END();
+
+	if (planes[s->async_channel_count - 1])
+		update_async_texrender(s, &s->deinterlace_conv_frame, planes,
+				       s->async_texrender, false);
+
+	s->deinterlace_yuv_dirty = false;
+	s->deinterlace_yuv_frame2 = frame2;
+	return true;
+}
+
 void deinterlace_render(obs_source_t *s)
 {
 	gs_effect_t *effect = s->deinterlace_effect;
@@ -389,8 +545,8 @@ void deinterlace_render(obs_source_t *s)
 	if (!cur_tex || !prev_tex || !s->async_width || !s->async_height)
 		return;
 
-	const enum gs_color_space source_space =
-		convert_video_space(s->async_format, s->async_trc);
+	const enum gs_color_space source_space = convert_video_space(
+		s->async_format, s->async_trc, s->async_sdr_only);
 
 	const bool linear_srgb =
 		(source_space != GS_CS_SRGB) || gs_get_linear_srgb() ||
@@ -446,11 +602,7 @@ void deinterlace_render(obs_source_t *s)
 	gs_effect_set_float(multiplier_param, multiplier);
 	gs_effect_set_int(field, s->deinterlace_top_first);
 	gs_effect_set_vec2(dimensions, &size);
-
-	const uint64_t frame2_ts =
-		s->deinterlace_frame_ts + s->deinterlace_offset +
-		s->deinterlace_half_duration - TWOX_TOLERANCE;
-	gs_effect_set_bool(frame2, obs->video.video_time >= frame2_ts);
+	gs_effect_set_bool(frame2, deinterlace_frame2(s));
 
 	while (gs_effect_loop(effect, tech_name))
 		gs_draw_sprite(NULL, s->async_flip ? GS_FLIP_V : 0,
@@ -488,6 +640,7 @@ static void disable_deinterlacing(obs_source_t *source)
 	gs_texture_destroy(source->async_prev_textures[1]);
 	gs_texture_destroy(source->async_prev_textures[2]);
 	gs_texrender_destroy(source->async_prev_texrender);
+	deinterlace_free_planes(source);
 	source->deinterlace_mode = OBS_DEINTERLACE_MODE_DISABLE;
 	source->async_prev_textures[0] = NULL;
 	source->async_prev_textures[1] = NULL;
@@ -512,6 +665,7 @@ void obs_source_set_deinterlace_mode(obs_source_t *source,
 		obs_enter_graphics();
 		source->deinterlace_mode = mode;
 		source->deinterlace_effect = get_effect(mode);
+		source->deinterlace_yuv_dirty = true;
 		obs_leave_graphics();
 	}
 }
@@ -532,6 +686,7 @@ void obs_source_set_deinterlace_field_order(
 
 	source->deinterlace_top_first = field_order ==
 					OBS_DEINTERLACE_FIELD_ORDER_TOP;
+	source->deinterlace_yuv_dirty = true;
 }
 
 enum obs_deinterlace_field_order
@@ -0,0 +1,271 @@
+/******************************************************************************
+    Copyright (C) 2023 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "obs-internal.h"
+
+/* Filters are rendered from the outermost one, whose target is the next
+ * filter towards the parent.  When the filter being rendered and the ones
+ * behind it all have a pixel stage, the outermost one renders the target of
+ * the innermost one and applies every stage in a single generated effect,
+ * skipping the render target each of them would otherwise draw into. */
+
+#define MAX_FUSED_STAGES 8
+
+static const char *fused_effect_header =
+	"uniform float4x4 ViewProj;\n"
+	"uniform texture2d image;\n"
+	"\n"
+	"sampler_state textureSampler {\n"
+	"\tFilter   = Linear;\n"
+	"\tAddressU = Clamp;\n"
+	"\tAddressV = Clamp;\n"
+	"};\n"
+	"\n"
+	"struct VertData {\n"
+	"\tfloat4 pos : POSITION;\n"
+	"\tfloat2 uv  : TEXCOORD0;\n"
+	"};\n"
+	"\n"
+	"VertData VSDefault(VertData v_in)\n"
+	"{\n"
+	"\tVertData vert_out;\n"
+	"\tvert_out.pos = mul(float4(v_in.pos.xyz, 1.0), ViewProj);\n"
+	"\tvert_out.uv  = v_in.uv;\n"
+	"\treturn vert_out;\n"
+	"}\n\n";
+
+static const char *fused_effect_footer =
+	"\treturn rgba;\n"
+	"}\n"
+	"\n"
+	"technique Draw\n"
+	"{\n"
+	"\tpass\n"
+	"\t{\n"
+	"\t\tvertex_shader = VSDefault(v_in);\n"
+	"\t\tpixel_shader  = PSFused(v_in);\n"
+	"\t}\n"
+	"}\n";
+
+static inline void stage_prefix(char *prefix, size_t size, size_t idx)
+{
+	snprintf(prefix, size, "s%d_", (int)idx);
+}
+
+static gs_effect_t *create_fused_effect(const struct obs_pixel_stage **stages,
+					size_t count, const char *key)
+{
+	struct dstr code = {0};
+	struct dstr stage = {0};
+	char prefix[16];
+	char *errors = NULL;
+	gs_effect_t *effect;
+
+	dstr_copy(&code, fused_effect_header);
+
+	for (size_t i = 0; i < count; i++) {
+		stage_prefix(prefix, sizeof(prefix), i);
+		dstr_copy(&stage, stages[i]->code);
+		dstr_replace(&stage, "$", prefix);
+		dstr_cat_dstr(&code, &stage);
+		dstr_cat(&code, "\n");
+	}
+
+	dstr_cat(&code, "float4 PSFused(VertData v_in) : TARGET\n"
+			"{\n"
+			"\tfloat4 rgba = image.Sample(textureSampler, "
+			"v_in.uv);\n");
+
+	for (size_t i = 0; i < count; i++) {
+		stage_prefix(prefix, sizeof(prefix), i);
+		dstr_catf(&code, "\trgba = %sprocess(rgba);\n", prefix);
+	}
+
+	dstr_cat(&code, fused_effect_footer);
+
+	effect = gs_effect_create(code.array, key, &errors);
+	if (!effect)
+		blog(LOG_WARNING, "Failed to create fused filter effect '%s': %s",
+		     key, errors ? errors : "unknown error");
+
+	bfree(errors);
+	dstr_free(&stage);
+	dstr_free(&code);
+	return effect;
+}
+
+/* effects are kept for the lifetime of the graphics subsystem, there are
+ * only ever a handful of distinct filter combinations.  a failed effect is
+ * kept as NULL so it isn't compiled again every frame */
+static gs_effect_t *get_fused_effect(const struct obs_pixel_stage **stages,
+				     size_t count)
+{
+	struct obs_core_video *video = &obs->video;
+	struct obs_fused_effect *fused;
+	struct dstr key = {0};
+
+	for (size_t i = 0; i < count; i++) {
+		if (i)
+			dstr_cat_ch(&key, '+');
+		dstr_cat(&key, stages[i]->name);
+	}
+
+	for (size_t i = 0; i < video->fused_effects.num; i++) {
+		fused = &video->fused_effects.array[i];
+		if (strcmp(fused->key, key.array) == 0) {
+			dstr_free(&key);
+			return fused->effect;
+		}
+	}
+
+	fused = da_push_back_new(video->fused_effects);
+	fused->effect = create_fused_effect(stages, count, key.array);
+	fused->key = key.array;
+	return fused->effect;
+}
+
+void obs_free_fused_effects(void)
+{
+	struct obs_core_video *video = &obs->video;
+
+	for (size_t i = 0; i < video->fused_effects.num; i++) {
+		struct obs_fused_effect *fused = &video->fused_effects.array[i];
+		gs_effect_destroy(fused->effect);
+		bfree(fused->key);
+	}
+
+	da_free(video->fused_effects);
+}
+
+gs_eparam_t *obs_pixel_stage_get_param(gs_effect_t *effect, const char *prefix,
+				       const char *name)
+{
+	char full_name[128];
+
+	snprintf(full_name, sizeof(full_name), "%s%s", prefix, name);
+	return gs_effect_get_param_by_name(effect, full_name);
+}
+
+static const struct obs_pixel_stage *get_stage(obs_source_t *filter,
+					       uint32_t srgb_flag)
+{
+	if (!filter->info.get_pixel_stage || !filter->context.data)
+		return NULL;
+	if ((filter->info.output_flags & OBS_SOURCE_SRGB) != srgb_flag)
+		return NULL;
+
+	return filter->info.get_pixel_stage(filter->context.data);
+}
+
+bool obs_source_render_fused_filters(obs_source_t *filter)
+{
+	const enum gs_color_space preferred_spaces[] = {GS_CS_SRGB};
+	const struct obs_pixel_stage *stages[MAX_FUSED_STAGES];
+	obs_source_t *filters[MAX_FUSED_STAGES];
+	obs_source_t *parent = filter->filter_parent;
+	size_t count = 0;
+	uint32_t srgb_flag;
+	gs_effect_t *effect;
+	obs_source_t *last;
+	size_t idx;
+
+	if (!parent || !filter->info.get_pixel_stage)
+		return false;
+	if (gs_get_color_space() != GS_CS_SRGB)
+		return false;
+
+	srgb_flag = filter->info.output_flags & OBS_SOURCE_SRGB;
+
+	/* disabled filters pass their target through, so they don't end a
+	 * run of stages */
+	pthread_mutex_lock(&parent->filter_mutex);
+	idx = da_find(parent->filters, &filter, 0);
+	for (size_t i = idx; i < parent->filters.num; i++) {
+		obs_source_t *cur = parent->filters.array[i];
+		const struct obs_pixel_stage *stage;
+
+		if (!cur->enabled)
+			continue;
+		if (count == MAX_FUSED_STAGES)
+			break;
+
+		stage = get_stage(cur, srgb_flag);
+		if (!stage)
+			break;
+
+		filters[count] = obs_source_get_ref(cur);
+		stages[count] = stage;
+		if (!filters[count])
+			break;
+
+		count++;
+	}
+	pthread_mutex_unlock(&parent->filter_mutex);
+
+	if (idx == DARRAY_INVALID || count < 2)
+		goto fail;
+
+	last = filters[count - 1];
+
+	if (obs_source_get_color_space(obs_filter_get_target(last),
+				       OBS_COUNTOF(preferred_spaces),
+				       preferred_spaces) != GS_CS_SRGB)
+		goto fail;
+
+	/* stages are applied from the one closest to the parent outwards */
+	for (size_t i = 0; i < count / 2; i++) {
+		const struct obs_pixel_stage *stage = stages[i];
+		obs_source_t *cur = filters[i];
+
+		stages[i] = stages[count - 1 - i];
+		stages[count - 1 - i] = stage;
+		filters[i] = filters[count - 1 - i];
+		filters[count - 1 - i] = cur;
+	}
+
+	effect = get_fused_effect(stages, count);
+	if (!effect)
+		goto fail;
+
+	if (obs_source_process_filter_begin(last, GS_RGBA,
+					    OBS_ALLOW_DIRECT_RENDERING)) {
+		char prefix[16];
+
+		for (size_t i = 0; i < count; i++) {
+			stage_prefix(prefix, sizeof(prefix), i);
+			if (stages[i]->set_params)
+				stages[i]->set_params(filters[i]->context.data,
+						      effect, prefix);
+		}
+
+		gs_blend_state_push();
+		gs_blend_function(GS_BLEND_ONE, GS_BLEND_INVSRCALPHA);
+
+		obs_source_process_filter_end(last, effect, 0, 0);
+
+		gs_blend_state_pop();
+	}
+
+	for (size_t i = 0; i < count; i++)
+		obs_source_release(filters[i]);
+	return true;
+
+fail:
+	for (size_t i = 0; i < count; i++)
+		obs_source_release(filters[i]);
+	return false;
+}
@@ -739,6 +739,24 @@ void obs_transition_video_render2(
 	obs_source_t *transition,
 	obs_transition_video_render_callback_t callback,
 	gs_texture_t *placeholder_texture)
+{
+	obs_transition_video_render3(transition, callback, placeholder_texture,
+				     NULL);
+}
+
+static inline bool target_needed(obs_source_t *transition,
+				 obs_transition_video_target_callback_t needed,
+				 size_t idx, float t)
+{
+	return !needed || needed(transition->context.data,
+				 (enum obs_transition_target)idx, t);
+}
+
+void obs_transition_video_render3(
+	obs_source_t *transition,
+	obs_transition_video_render_callback_t callback,
+	gs_texture_t *placeholder_texture,
+	obs_transition_video_target_callback_t needed)
 {
 	struct transition_state state;
 	struct matrix4 matrices[2];
@@ -781,8 +799,19 @@ void obs_transition_video_render2(
 		const enum gs_color_space source_space =
 			obs_source_get_color_space(transition, 1,
 						   &current_space);
+
+		/* transitioning between a source and itself (with the same
+		 * transform) only has to render it once */
+		const bool shared = state.s[0] && state.s[0] == state.s[1] &&
+				    memcmp(&matrices[0], &matrices[1],
+					   sizeof(matrices[0])) == 0;
+
 		for (size_t i = 0; i < 2; i++) {
-			if (state.s[i]) {
+			if (shared && i == 1 &&
+			    target_needed(transition, needed, 0, t)) {
+				tex[1] = tex[0];
+			} else if (state.s[i] &&
+				   target_needed(transition, needed, i, t)) {
 				render_child(transition, state.s[i], i,
 					     source_space);
 				tex[i] = get_texture(transition, i);
@@ -824,6 +853,15 @@ void obs_transition_video_render2(
 	if (locked)
 		unlock_textures(transition);
 
+	/* the textures are only needed while transitioning */
+	if (video_stopped && trylock_textures(transition) == 0) {
+		gs_texrender_release_buffers(
+			transition->transition_texrender[0]);
+		gs_texrender_release_buffers(
+			transition->transition_texrender[1]);
+		unlock_textures(transition);
+	}
+
 	obs_source_release(state.s[0]);
 	obs_source_release(state.s[1]);
 
@@ -1095,6 +1133,23 @@ void obs_transition_enable_fixed(obs_source_t *transition, bool enable,
 	transition->transition_fixed_duration = duration;
 }
 
+/* returns whether the transition is mid-way through for the frame that was
+ * just rendered, along with how far along it is, or otherwise the source it
+ * is showing */
+bool obs_transition_get_frame_state(obs_source_t *transition, float *t,
+				    const obs_source_t **showing)
+{
+	bool transitioning;
+
+	lock_transition(transition);
+	transitioning = transition->transitioning_video;
+	*showing = transition->transition_sources[0];
+	unlock_transition(transition);
+
+	*t = transitioning ? get_video_time(transition) : 0.0f;
+	return transitioning;
+}
+
 bool obs_transition_fixed(obs_source_t *transition)
 {
 	return transition_valid(transition, "obs_transition_fixed")
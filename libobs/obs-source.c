@@ -20,7 +20,9 @@
 
 #include "media-io/format-conversion.h"
 #include "media-io/video-frame.h"
+#include "media-io/video-copy.h"
 #include "media-io/audio-io.h"
+#include "media-io/audio-kernels.h"
 #include "util/threading.h"
 #include "util/platform.h"
 #include "util/util_uint64.h"
@@ -245,7 +247,8 @@ static void obs_source_init_finalize(struct obs_source *source)
 	}
 
 	obs_context_data_insert(&source->context, &obs->data.sources_mutex,
-				&obs->data.first_source);
+				&obs->data.first_source,
+				&obs->data.source_index);
 }
 
 static bool obs_source_hotkey_mute(void *data, obs_hotkey_pair_id id,
@@ -339,10 +342,19 @@ static void obs_source_init_audio_hotkeys(struct obs_source *source)
 		obs_source_hotkey_push_to_talk, source);
 }
 
+/* only video inputs are deferred, audio-only inputs can be heard or monitored
+ * without ever being shown, and the creation is queued to the UI thread */
+static inline bool can_defer_create(const struct obs_source_info *info)
+{
+	return info && info->create && info->type == OBS_SOURCE_TYPE_INPUT &&
+	       (info->output_flags & OBS_SOURCE_VIDEO) != 0 &&
+	       obs->ui_task_handler;
+}
+
 static obs_source_t *
 obs_source_create_internal(const char *id, const char *name,
 			   obs_data_t *settings, obs_data_t *hotkey_data,
-			   bool private, uint32_t last_obs_ver)
+			   bool private, uint32_t last_obs_ver, bool defer)
 {
 	struct obs_source *source = bzalloc(sizeof(struct obs_source));
 
@@ -392,14 +404,17 @@ obs_source_create_internal(const char *id, const char *name,
 
 	/* allow the source to be created even if creation fails so that the
 	 * user's data doesn't become lost */
-	if (info && info->create)
+	if (defer && can_defer_create(info))
+		source->create_state = OBS_SOURCE_CREATE_DEFERRED;
+	else if (info && info->create)
 		source->context.data =
 			info->create(source->context.settings, source);
-	if ((!info || info->create) && !source->context.data)
+	if ((!info || info->create) && !source->context.data &&
+	    !source->create_state)
 		blog(LOG_ERROR, "Failed to create source '%s'!", name);
 
-	blog(LOG_DEBUG, "%ssource '%s' (%s) created", private ? "private " : "",
-	     name, id);
+	blog(LOG_DEBUG, "%ssource '%s' (%s) %s", private ? "private " : "",
+	     name, id, source->create_state ? "deferred" : "created");
 
 	source->flags = source->default_flags;
 	source->enabled = true;
@@ -421,14 +436,14 @@ obs_source_t *obs_source_create(const char *id, const char *name,
 				obs_data_t *settings, obs_data_t *hotkey_data)
 {
 	return obs_source_create_internal(id, name, settings, hotkey_data,
-					  false, LIBOBS_API_VER);
+					  false, LIBOBS_API_VER, false);
 }
 
 obs_source_t *obs_source_create_private(const char *id, const char *name,
 					obs_data_t *settings)
 {
 	return obs_source_create_internal(id, name, settings, NULL, true,
-					  LIBOBS_API_VER);
+					  LIBOBS_API_VER, false);
 }
 
 obs_source_t *obs_source_create_set_last_ver(const char *id, const char *name,
@@ -438,7 +453,66 @@ obs_source_t *obs_source_create_set_last_ver(const char *id, const char *name,
 					     bool is_private)
 {
 	return obs_source_create_internal(id, name, settings, hotkey_data,
-					  is_private, last_obs_ver);
+					  is_private, last_obs_ver, false);
+}
+
+obs_source_t *obs_source_create_deferred(const char *id, const char *name,
+					 obs_data_t *settings,
+					 obs_data_t *hotkey_data,
+					 uint32_t last_obs_ver)
+{
+	return obs_source_create_internal(id, name, settings, hotkey_data,
+					  false, last_obs_ver, true);
+}
+
+static void obs_source_create_now(obs_source_t *source)
+{
+	long state = os_atomic_load_long(&source->create_state);
+	void *data;
+
+	if (state != OBS_SOURCE_CREATE_DEFERRED &&
+	    state != OBS_SOURCE_CREATE_QUEUED)
+		return;
+	if (!os_atomic_compare_swap_long(&source->create_state, state,
+					 OBS_SOURCE_CREATE_RUNNING))
+		return;
+
+	data = source->info.create(source->context.settings, source);
+	if (!data)
+		blog(LOG_ERROR, "Failed to create source '%s'!",
+		     source->context.name);
+
+	blog(LOG_DEBUG, "deferred source '%s' (%s) created",
+	     source->context.name, source->info.id);
+
+	/* the video tick leaves the source alone until the state is reset, so
+	 * show/activate are only called once it's been loaded */
+	source->context.data = data;
+	obs_source_load2(source);
+	os_atomic_set_long(&source->create_state, OBS_SOURCE_CREATED);
+}
+
+static void create_deferred_task(void *param)
+{
+	obs_source_t *source = param;
+
+	if (!obs_source_removed(source))
+		obs_source_create_now(source);
+	obs_source_release(source);
+}
+
+static void queue_deferred_create(obs_source_t *source)
+{
+	obs_source_t *ref;
+
+	if (!os_atomic_compare_swap_long(&source->create_state,
+					 OBS_SOURCE_CREATE_DEFERRED,
+					 OBS_SOURCE_CREATE_QUEUED))
+		return;
+
+	ref = obs_source_get_ref(source);
+	if (ref)
+		obs_queue_task(OBS_TASK_UI, create_deferred_task, ref, false);
 }
 
 static char *get_new_filter_name(obs_source_t *dst, const char *name)
@@ -619,6 +693,10 @@ static inline void obs_source_frame_decref(struct obs_source_frame *frame)
 static bool obs_source_filter_remove_refless(obs_source_t *source,
 					     obs_source_t *filter);
 static void obs_source_destroy_defer(struct obs_source *source);
+static void free_async_staging(struct obs_source *source);
+static void defer_free_async_staging(struct obs_source *source);
+static void queue_async_upload(struct obs_source *source,
+			       struct obs_source_frame *frame);
 
 void obs_source_destroy(struct obs_source *source)
 {
@@ -664,8 +742,8 @@ void obs_source_destroy(struct obs_source *source)
 	obs_context_data_remove(&source->context);
 
 	/* defer source destroy */
-	os_task_queue_queue_task(obs->destruction_task_thread,
-				 (os_task_t)obs_source_destroy_defer, source);
+	os_job_pool_queue_task(obs->task_pool, OS_JOB_PRIORITY_LOW,
+			       (os_task_t)obs_source_destroy_defer, source);
 }
 
 static void obs_source_destroy_defer(struct obs_source *source)
@@ -698,6 +776,9 @@ static void obs_source_destroy_defer(struct obs_source *source)
 	obs_hotkey_unregister(source->push_to_mute_key);
 	obs_hotkey_pair_unregister(source->mute_unmute_key);
 
+	defer_free_async_staging(source);
+	os_event_destroy(source->async_staging_done);
+
 	for (i = 0; i < source->async_cache.num; i++) {
 		struct obs_source_frame *frame =
 			source->async_cache.array[i].frame;
@@ -705,25 +786,24 @@ static void obs_source_destroy_defer(struct obs_source *source)
 			obs_source_frame_decref(frame);
 	}
 
-	gs_enter_context(obs->video.graphics);
-	if (source->async_texrender)
-		gs_texrender_destroy(source->async_texrender);
-	if (source->async_prev_texrender)
-		gs_texrender_destroy(source->async_prev_texrender);
+	obs_defer_gs_destroy(OBS_GS_TEXRENDER, source->async_texrender);
+	obs_defer_gs_destroy(OBS_GS_TEXRENDER, source->async_prev_texrender);
 	for (size_t c = 0; c < MAX_AV_PLANES; c++) {
-		gs_texture_destroy(source->async_textures[c]);
-		gs_texture_destroy(source->async_prev_textures[c]);
+		obs_defer_gs_destroy(OBS_GS_TEXTURE, source->async_textures[c]);
+		obs_defer_gs_destroy(OBS_GS_TEXTURE,
+				     source->async_prev_textures[c]);
+		obs_defer_gs_destroy(OBS_GS_TEXRENDER,
+				     source->deinterlace_planes[c]);
 	}
-	if (source->filter_texrender)
-		gs_texrender_destroy(source->filter_texrender);
-	if (source->color_space_texrender)
-		gs_texrender_destroy(source->color_space_texrender);
-	gs_leave_context();
+	obs_defer_gs_destroy(OBS_GS_TEXRENDER, source->filter_texrender);
+	obs_defer_gs_destroy(OBS_GS_TEXRENDER, source->color_space_texrender);
 
 	for (i = 0; i < MAX_AV_PLANES; i++)
 		bfree(source->audio_data.data[i]);
 	for (i = 0; i < MAX_AUDIO_CHANNELS; i++)
 		circlebuf_free(&source->audio_input_buf[i]);
+	for (i = 0; i < AUDIO_INPUT_PACKETS; i++)
+		bfree(source->audio_packets[i].data[0]);
 	audio_resampler_destroy(source->resampler);
 	bfree(source->audio_output_buf[0][0]);
 	bfree(source->audio_mix_buf[0]);
@@ -738,6 +818,7 @@ static void obs_source_destroy_defer(struct obs_source *source)
 	da_free(source->caption_cb_list);
 	da_free(source->async_cache);
 	da_free(source->async_frames);
+	da_free(source->async_jitter_samples);
 	da_free(source->filters);
 	pthread_mutex_destroy(&source->filter_mutex);
 	pthread_mutex_destroy(&source->audio_actions_mutex);
@@ -938,6 +1019,12 @@ bool obs_source_configurable(const obs_source_t *source)
 
 obs_properties_t *obs_source_properties(const obs_source_t *source)
 {
+	if (!obs_source_valid(source, "obs_source_properties"))
+		return NULL;
+
+	/* properties may depend on the instance, so it has to exist now */
+	obs_source_create_now((obs_source_t *)source);
+
 	if (!data_valid(source, "obs_source_properties"))
 		return NULL;
 
@@ -971,6 +1058,49 @@ uint32_t obs_get_source_output_flags(const char *id)
 	return info ? info->output_flags : 0;
 }
 
+static inline void content_changed(obs_source_t *source)
+{
+	os_atomic_inc_long(&source->content_generation);
+
+	/* filters change the output of the source they're attached to */
+	obs_source_t *parent = source->filter_parent;
+	if (parent)
+		os_atomic_inc_long(&parent->content_generation);
+}
+
+void obs_source_content_changed(obs_source_t *source)
+{
+	if (!obs_source_valid(source, "obs_source_content_changed"))
+		return;
+
+	content_changed(source);
+}
+
+long obs_source_get_content_generation(const obs_source_t *source)
+{
+	return os_atomic_load_long(&source->content_generation);
+}
+
+bool obs_source_video_static(obs_source_t *source)
+{
+	bool is_static = true;
+
+	if ((source->info.output_flags & OBS_SOURCE_STATIC_VIDEO) == 0 ||
+	    (source->info.output_flags & OBS_SOURCE_ASYNC) != 0)
+		return false;
+
+	pthread_mutex_lock(&source->filter_mutex);
+	for (size_t i = 0; is_static && i < source->filters.num; i++) {
+		obs_source_t *filter = source->filters.array[i];
+		if (filter->enabled &&
+		    (filter->info.output_flags & OBS_SOURCE_STATIC_VIDEO) == 0)
+			is_static = false;
+	}
+	pthread_mutex_unlock(&source->filter_mutex);
+
+	return is_static;
+}
+
 static void obs_source_deferred_update(obs_source_t *source)
 {
 	if (source->context.data && source->info.update) {
@@ -979,6 +1109,7 @@ static void obs_source_deferred_update(obs_source_t *source)
 				    source->context.settings);
 		os_atomic_compare_swap_long(&source->defer_update_count, count,
 					    0);
+		content_changed(source);
 	}
 }
 
@@ -996,6 +1127,7 @@ void obs_source_update(obs_source_t *source, obs_data_t *settings)
 	} else if (source->context.data && source->info.update) {
 		source->info.update(source->context.data,
 				    source->context.settings);
+		content_changed(source);
 	}
 }
 
@@ -1197,6 +1329,111 @@ static inline struct obs_source_frame *get_closest_frame(obs_source_t *source,
 							 uint64_t sys_time);
 bool set_async_texture_size(struct obs_source *source,
 			    const struct obs_source_frame *frame);
+static inline void free_async_cache(struct obs_source *source);
+
+/* everything released here is created again when it's next needed, the
+ * async textures once the next frame is uploaded and the texrenders once
+ * the source is rendered again */
+static void release_gpu_resources(obs_source_t *source)
+{
+	gs_texrender_destroy(source->filter_texrender);
+	gs_texrender_destroy(source->color_space_texrender);
+	source->filter_texrender = NULL;
+	source->color_space_texrender = NULL;
+
+	if ((source->info.output_flags & OBS_SOURCE_ASYNC) == 0)
+		return;
+
+	free_async_staging(source);
+
+	for (size_t c = 0; c < MAX_AV_PLANES; c++) {
+		gs_texture_destroy(source->async_textures[c]);
+		gs_texture_destroy(source->async_prev_textures[c]);
+		source->async_textures[c] = NULL;
+		source->async_prev_textures[c] = NULL;
+	}
+
+	gs_texrender_destroy(source->async_texrender);
+	gs_texrender_destroy(source->async_prev_texrender);
+	source->async_texrender = NULL;
+	source->async_prev_texrender = NULL;
+	deinterlace_free_planes(source);
+
+	source->async_width = 0;
+	source->async_height = 0;
+	source->async_update_texture = false;
+}
+
+static void hibernate_source(obs_source_t *source)
+{
+	obs_enter_graphics();
+	release_gpu_resources(source);
+	for (size_t i = source->filters.num; i > 0; i--)
+		release_gpu_resources(source->filters.array[i - 1]);
+	obs_leave_graphics();
+
+	if ((source->info.output_flags & OBS_SOURCE_ASYNC) != 0) {
+		pthread_mutex_lock(&source->async_mutex);
+		free_async_cache(source);
+		pthread_mutex_unlock(&source->async_mutex);
+	}
+
+	if (source->context.data && source->info.hibernate)
+		source->info.hibernate(source->context.data);
+
+	for (size_t i = source->filters.num; i > 0; i--) {
+		obs_source_t *filter = source->filters.array[i - 1];
+		if (filter->context.data && filter->info.hibernate)
+			filter->info.hibernate(filter->context.data);
+	}
+
+	source->hibernating = true;
+	blog(LOG_DEBUG, "Hibernated source '%s'", source->context.name);
+}
+
+static void wake_source(obs_source_t *source)
+{
+	if (source->context.data && source->info.wake)
+		source->info.wake(source->context.data);
+
+	for (size_t i = source->filters.num; i > 0; i--) {
+		obs_source_t *filter = source->filters.array[i - 1];
+		if (filter->context.data && filter->info.wake)
+			filter->info.wake(filter->context.data);
+	}
+
+	source->hibernating = false;
+	blog(LOG_DEBUG, "Woke source '%s'", source->context.name);
+}
+
+/* filters have no views of their own and are handled with their parent */
+static void update_hibernation(obs_source_t *source)
+{
+	uint64_t delay = obs->data.hibernate_delay_ns;
+	uint64_t now = obs->video.video_time;
+	bool prefetch;
+
+	if ((source->info.output_flags & OBS_SOURCE_VIDEO) == 0 ||
+	    source->info.type == OBS_SOURCE_TYPE_FILTER)
+		return;
+
+	prefetch = os_atomic_exchange_bool(&source->prefetch, false);
+
+	if (prefetch || os_atomic_load_long(&source->show_refs)) {
+		if (source->hibernating)
+			wake_source(source);
+		source->hidden_since = now;
+		return;
+	}
+
+	if (!delay || source->hibernating)
+		return;
+
+	if (!source->hidden_since)
+		source->hidden_since = now;
+	else if (now - source->hidden_since >= delay)
+		hibernate_source(source);
+}
 
 static void async_tick(obs_source_t *source)
 {
@@ -1218,9 +1455,12 @@ static void async_tick(obs_source_t *source)
 	source->last_sys_timestamp = sys_time;
 	pthread_mutex_unlock(&source->async_mutex);
 
-	if (source->cur_async_frame)
+	if (source->cur_async_frame && !source->hibernating) {
 		source->async_update_texture =
 			set_async_texture_size(source, source->cur_async_frame);
+		if (source->async_update_texture)
+			queue_async_upload(source, source->cur_async_frame);
+	}
 }
 
 void obs_source_video_tick(obs_source_t *source, float seconds)
@@ -1230,6 +1470,14 @@ void obs_source_video_tick(obs_source_t *source, float seconds)
 	if (!obs_source_valid(source, "obs_source_video_tick"))
 		return;
 
+	if (os_atomic_load_long(&source->create_state)) {
+		if (os_atomic_load_long(&source->show_refs))
+			queue_deferred_create(source);
+		return;
+	}
+
+	update_hibernation(source);
+
 	if (source->info.type == OBS_SOURCE_TYPE_TRANSITION)
 		obs_transition_tick(source, seconds);
 
@@ -1250,6 +1498,18 @@ void obs_source_video_tick(obs_source_t *source, float seconds)
 			show_source(source);
 		} else {
 			hide_source(source);
+
+			/* these are rendered again every frame, so there's
+			 * no need to hold on to them while hidden */
+			if (source->filter_texrender ||
+			    source->color_space_texrender) {
+				obs_enter_graphics();
+				gs_texrender_release_buffers(
+					source->filter_texrender);
+				gs_texrender_release_buffers(
+					source->color_space_texrender);
+				obs_leave_graphics();
+			}
 		}
 
 		if (source->filters.num) {
@@ -1321,6 +1581,28 @@ static inline size_t conv_time_to_frames(const size_t sample_rate,
  * possible */
 #define TS_SMOOTHING_THRESHOLD 70000000ULL
 
+/* adaptive jitter buffer: number of frame arrivals the target percentile is
+ * taken from, how often the target is recomputed, and the deepest the
+ * buffer may get (bounded by MAX_ASYNC_FRAMES) */
+#define ASYNC_JITTER_WINDOW 128
+#define ASYNC_JITTER_UPDATE_INTERVAL 16
+#define MAX_ASYNC_JITTER_DELAY 300000000LL
+
+/* the buffer depth changes by at most 1/200th of the elapsed time, so audio
+ * is stretched by half a percent at most, which isn't audible */
+#define ASYNC_JITTER_SLEW_DIV 200
+
+/* audio drives the buffer depth as long as it has been received recently */
+#define ASYNC_JITTER_AUDIO_TIMEOUT 1000000000ULL
+
+static inline bool jitter_audio_active(const obs_source_t *source,
+				       uint64_t os_time)
+{
+	uint64_t audio_time = source->async_jitter_audio_time;
+	return audio_time && os_time >= audio_time &&
+	       os_time - audio_time < ASYNC_JITTER_AUDIO_TIMEOUT;
+}
+
 static inline void reset_audio_timing(obs_source_t *source, uint64_t timestamp,
 				      uint64_t os_time)
 {
@@ -1338,9 +1620,35 @@ static void reset_audio_data(obs_source_t *source, uint64_t os_time)
 
 	source->last_audio_input_buf_size = 0;
 	source->audio_ts = os_time;
+}
+
+/* called with audio_mutex held.  the buffered audio itself belongs to the
+ * audio thread, so the reset travels with the next packet. */
+static inline void request_audio_reset(obs_source_t *source, uint64_t os_time)
+{
+	source->audio_reset_pending = true;
+	source->audio_reset_ts = os_time;
 	source->next_audio_sys_ts_min = os_time;
 }
 
+static void queue_audio_packet(obs_source_t *source,
+			       const struct audio_data *in, bool push_back);
+
+/* for resets from outside of obs_source_output_audio, which otherwise would
+ * wait for the source's next packet */
+static void reset_audio(obs_source_t *source, uint64_t timestamp,
+			uint64_t os_time, bool reset_timing)
+{
+	pthread_mutex_lock(&source->audio_mutex);
+	if (reset_timing)
+		reset_audio_timing(source, timestamp, os_time);
+	else
+		source->timing_set = false;
+	request_audio_reset(source, os_time);
+	queue_audio_packet(source, NULL, false);
+	pthread_mutex_unlock(&source->audio_mutex);
+}
+
 static void handle_ts_jump(obs_source_t *source, uint64_t expected, uint64_t ts,
 			   uint64_t diff, uint64_t os_time)
 {
@@ -1349,10 +1657,8 @@ static void handle_ts_jump(obs_source_t *source, uint64_t expected, uint64_t ts,
 	     "expected value %" PRIu64 ", input value %" PRIu64,
 	     source->context.name, diff, expected, ts);
 
-	pthread_mutex_lock(&source->audio_buf_mutex);
 	reset_audio_timing(source, ts, os_time);
-	reset_audio_data(source, os_time);
-	pthread_mutex_unlock(&source->audio_buf_mutex);
+	request_audio_reset(source, os_time);
 }
 
 static void source_signal_audio_data(obs_source_t *source,
@@ -1360,6 +1666,8 @@ static void source_signal_audio_data(obs_source_t *source,
 {
 	pthread_mutex_lock(&source->audio_cb_mutex);
 
+	source->audio_cb_serial++;
+
 	for (size_t i = source->audio_cb_list.num; i > 0; i--) {
 		struct audio_cb_info info = source->audio_cb_list.array[i - 1];
 		info.callback(info.param, source, in, muted);
@@ -1437,6 +1745,105 @@ static inline void source_output_audio_push_back(obs_source_t *source,
 	source->last_audio_input_buf_size = 0;
 }
 
+static bool reserve_audio_packet(struct audio_input_packet *packet,
+				 size_t channels, size_t size)
+{
+	if (packet->capacity < size) {
+		float *data = brealloc(packet->data[0], size * channels);
+		if (!data)
+			return false;
+
+		packet->data[0] = data;
+		packet->capacity = size;
+	}
+
+	for (size_t i = 1; i < channels; i++)
+		packet->data[i] = packet->data[0] + (packet->capacity * i /
+						     sizeof(float));
+	return true;
+}
+
+/* producer side, called with audio_mutex held.  a NULL 'in' only passes
+ * along a pending reset. */
+static void queue_audio_packet(obs_source_t *source,
+			       const struct audio_data *in, bool push_back)
+{
+	long write = source->audio_packet_write;
+	long read = os_atomic_load_long(&source->audio_packet_read);
+	struct audio_input_packet *packet;
+
+	if ((unsigned long)(write - read) >= AUDIO_INPUT_PACKETS) {
+		if (in) {
+			os_atomic_inc_long(&source->audio_packets_dropped);
+			source->audio_packet_discontinuity = true;
+		}
+		return;
+	}
+
+	packet = &source->audio_packets[write & (AUDIO_INPUT_PACKETS - 1)];
+	packet->reset = source->audio_reset_pending;
+	packet->reset_ts = source->audio_reset_ts;
+	packet->frames = 0;
+	source->audio_reset_pending = false;
+
+	if (in) {
+		size_t channels = audio_output_get_channels(obs->audio.audio);
+		size_t size = in->frames * sizeof(float);
+
+		if (reserve_audio_packet(packet, channels, size)) {
+			for (size_t i = 0; i < channels; i++)
+				memcpy(packet->data[i], in->data[i], size);
+
+			packet->frames = in->frames;
+			packet->timestamp = in->timestamp;
+			packet->push_back = push_back &&
+					    !source->audio_packet_discontinuity;
+			source->audio_packet_discontinuity = false;
+		}
+	}
+
+	os_atomic_set_long(&source->audio_packet_write, write + 1);
+}
+
+/* consumer side, called with audio_buf_mutex held */
+void obs_source_drain_audio_packets(obs_source_t *source)
+{
+	long read = source->audio_packet_read;
+	long write = os_atomic_load_long(&source->audio_packet_write);
+	long dropped;
+
+	while (read != write) {
+		struct audio_input_packet *packet =
+			&source->audio_packets[read & (AUDIO_INPUT_PACKETS - 1)];
+
+		if (packet->reset)
+			reset_audio_data(source, packet->reset_ts);
+
+		if (packet->frames) {
+			struct audio_data in = {0};
+
+			for (size_t i = 0; i < MAX_AUDIO_CHANNELS; i++)
+				in.data[i] = (uint8_t *)packet->data[i];
+			in.frames = packet->frames;
+			in.timestamp = packet->timestamp;
+
+			if (packet->push_back && source->audio_ts)
+				source_output_audio_push_back(source, &in);
+			else
+				source_output_audio_place(source, &in);
+		}
+
+		os_atomic_set_long(&source->audio_packet_read, ++read);
+	}
+
+	dropped = os_atomic_set_long(&source->audio_packets_dropped, 0);
+	if (dropped)
+		blog(LOG_DEBUG,
+		     "Source '%s' dropped %ld audio packets, audio "
+		     "thread fell behind",
+		     source->context.name, dropped);
+}
+
 static inline bool source_muted(obs_source_t *source, uint64_t os_time)
 {
 	if (source->push_to_mute_enabled && source->user_push_to_mute_pressed)
@@ -1465,9 +1872,22 @@ static void source_output_audio_data(obs_source_t *source,
 	uint64_t diff;
 	uint64_t os_time = os_gettime_ns();
 	int64_t sync_offset;
+	int64_t jitter_delay = 0;
+	uint32_t src_frames = in.frames;
 	bool using_direct_ts = false;
 	bool push_back = false;
 
+	/* stretched audio covers a different amount of source time than it
+	 * plays for, the difference is added to the buffer delay */
+	if (source->async_jitter_percentile > 0.0f) {
+		int64_t stretch = source->async_jitter_stretch;
+
+		jitter_delay = source->async_jitter_audio_delay;
+		if ((int64_t)in.frames > stretch)
+			src_frames = (uint32_t)((int64_t)in.frames - stretch);
+		source->async_jitter_stretch = 0;
+	}
+
 	/* detects 'directly' set timestamps as long as they're within
 	 * a certain threshold */
 	if (uint64_diff(in.timestamp, os_time) < MAX_TS_VAR) {
@@ -1495,11 +1915,9 @@ static void source_output_audio_data(obs_source_t *source,
 
 	source->last_audio_ts = in.timestamp;
 	source->next_audio_ts_min =
-		in.timestamp + conv_frames_to_time(sample_rate, in.frames);
+		in.timestamp + conv_frames_to_time(sample_rate, src_frames);
 
-	in.timestamp += source->timing_adjust;
-
-	pthread_mutex_lock(&source->audio_buf_mutex);
+	in.timestamp += source->timing_adjust + jitter_delay;
 
 	if (source->next_audio_sys_ts_min == in.timestamp) {
 		push_back = true;
@@ -1518,7 +1936,8 @@ static void source_output_audio_data(obs_source_t *source,
 			 * just clear the audio data in that small window and force a
 			 * resync.  This handles all cases rather than just looping. */
 			reset_audio_timing(source, data->timestamp, os_time);
-			in.timestamp = data->timestamp + source->timing_adjust;
+			in.timestamp = data->timestamp + source->timing_adjust +
+				       jitter_delay;
 		}
 	}
 
@@ -1526,8 +1945,9 @@ static void source_output_audio_data(obs_source_t *source,
 	in.timestamp += sync_offset;
 	in.timestamp -= source->resample_offset;
 
-	source->next_audio_sys_ts_min =
-		source->next_audio_ts_min + source->timing_adjust;
+	source->next_audio_sys_ts_min = source->next_audio_ts_min +
+					source->timing_adjust +
+					source->async_jitter_delay;
 
 	if (source->last_sync_offset != sync_offset) {
 		if (source->last_sync_offset)
@@ -1535,14 +1955,8 @@ static void source_output_audio_data(obs_source_t *source,
 		source->last_sync_offset = sync_offset;
 	}
 
-	if (source->monitoring_type != OBS_MONITORING_TYPE_MONITOR_ONLY) {
-		if (push_back && source->audio_ts)
-			source_output_audio_push_back(source, &in);
-		else
-			source_output_audio_place(source, &in);
-	}
-
-	pthread_mutex_unlock(&source->audio_buf_mutex);
+	if (source->monitoring_type != OBS_MONITORING_TYPE_MONITOR_ONLY)
+		queue_audio_packet(source, &in, push_back);
 
 	source_signal_audio_data(source, data, source_muted(source, os_time));
 }
@@ -1860,8 +2274,8 @@ static inline bool set_rgb_limited_sizes(struct obs_source *source,
 {
 	source->async_convert_width[0] = frame->width;
 	source->async_convert_height[0] = frame->height;
-	source->async_texture_formats[0] =
-		convert_video_format(frame->format, frame->trc);
+	source->async_texture_formats[0] = convert_video_format(
+		frame->format, frame->trc, source->async_sdr_only);
 	source->async_channel_count = 1;
 	return true;
 }
@@ -1977,6 +2391,175 @@ static inline bool init_gpu_conversion(struct obs_source *source,
 	return false;
 }
 
+/* waits for the queued staging copy and drops its frame reference */
+static void finish_async_upload(struct obs_source *source)
+{
+	struct obs_source_frame *frame = source->async_staging_frame;
+
+	if (!frame)
+		return;
+
+	os_event_wait(source->async_staging_done);
+	source->async_staging_frame = NULL;
+
+	pthread_mutex_lock(&source->async_mutex);
+	if (os_atomic_dec_long(&frame->refs) == 0)
+		obs_source_frame_destroy(frame);
+	pthread_mutex_unlock(&source->async_mutex);
+}
+
+static void unmap_async_staging(struct obs_source *source)
+{
+	gs_texture_t **tex = source->async_staging[source->async_staging_idx];
+
+	if (!source->async_staging_mapped)
+		return;
+
+	for (int c = 0; c < source->async_channel_count; c++)
+		gs_texture_unmap(tex[c]);
+	source->async_staging_mapped = false;
+}
+
+static void map_async_staging(struct obs_source *source)
+{
+	gs_texture_t **tex = source->async_staging[source->async_staging_idx];
+	int c;
+
+	if (!tex[0])
+		return;
+
+	for (c = 0; c < source->async_channel_count; c++) {
+		if (!gs_texture_map(tex[c], &source->async_staging_data[c],
+				    &source->async_staging_linesize[c]))
+			break;
+	}
+
+	if (c < source->async_channel_count) {
+		while (c-- > 0)
+			gs_texture_unmap(tex[c]);
+		return;
+	}
+
+	source->async_staging_mapped = true;
+}
+
+static void free_async_staging(struct obs_source *source)
+{
+	finish_async_upload(source);
+	unmap_async_staging(source);
+
+	for (size_t i = 0; i < 2; i++) {
+		for (size_t c = 0; c < MAX_AV_PLANES; c++) {
+			gs_texture_destroy(source->async_staging[i][c]);
+			source->async_staging[i][c] = NULL;
+		}
+	}
+}
+
+/* like free_async_staging, but leaves the textures to the graphics thread,
+ * for sources that are being destroyed */
+static void defer_free_async_staging(struct obs_source *source)
+{
+	finish_async_upload(source);
+
+	for (size_t i = 0; i < 2; i++) {
+		bool mapped = source->async_staging_mapped &&
+			      (int)i == source->async_staging_idx;
+
+		for (size_t c = 0; c < MAX_AV_PLANES; c++) {
+			bool unmap = mapped &&
+				     (int)c < source->async_channel_count;
+
+			obs_defer_gs_destroy(unmap ? OBS_GS_MAPPED_TEXTURE
+						   : OBS_GS_TEXTURE,
+					     source->async_staging[i][c]);
+			source->async_staging[i][c] = NULL;
+		}
+	}
+
+	source->async_staging_mapped = false;
+}
+
+static void create_async_staging(struct obs_source *source)
+{
+	if (!source->async_staging_done &&
+	    os_event_init(&source->async_staging_done, OS_EVENT_TYPE_MANUAL) !=
+		    0)
+		return;
+
+	for (size_t i = 0; i < 2; i++) {
+		for (int c = 0; c < source->async_channel_count; c++) {
+			source->async_staging[i][c] = gs_texture_create(
+				source->async_convert_width[c],
+				source->async_convert_height[c],
+				source->async_texture_formats[c], 1, NULL,
+				GS_DYNAMIC);
+
+			if (!source->async_staging[i][c]) {
+				free_async_staging(source);
+				return;
+			}
+		}
+	}
+
+	source->async_staging_idx = 0;
+	map_async_staging(source);
+}
+
+static void async_upload_task(void *param)
+{
+	struct obs_source *source = param;
+	struct obs_source_frame *frame = source->async_staging_frame;
+
+	for (int c = 0; c < source->async_channel_count; c++) {
+		uint8_t *dst = source->async_staging_data[c];
+		const uint8_t *src = frame->data[c];
+		uint32_t dst_linesize = source->async_staging_linesize[c];
+		uint32_t src_linesize = frame->linesize[c];
+		uint32_t rows = source->async_convert_height[c];
+
+		if (dst_linesize == src_linesize) {
+			memcpy(dst, src, (size_t)src_linesize * rows);
+			continue;
+		}
+
+		uint32_t row_size = dst_linesize < src_linesize ? dst_linesize
+								: src_linesize;
+		for (uint32_t y = 0; y < rows; y++)
+			memcpy(dst + (size_t)y * dst_linesize,
+			       src + (size_t)y * src_linesize, row_size);
+	}
+
+	os_event_signal(source->async_staging_done);
+}
+
+/* starts copying the frame picked for this tick into the mapped staging
+ * textures, the graphics thread picks it up when the source is rendered */
+static void queue_async_upload(struct obs_source *source,
+			       struct obs_source_frame *frame)
+{
+	gs_enter_context(obs->video.graphics);
+
+	finish_async_upload(source);
+
+	if (!source->async_staging_mapped || !source->async_gpu_conversion ||
+	    deinterlacing_enabled(source) || frame->gpu.get_textures)
+		goto finish;
+
+	os_atomic_inc_long(&frame->refs);
+	source->async_staging_frame = frame;
+	os_event_reset(source->async_staging_done);
+
+	if (!os_task_queue_queue_task(obs->upload_task_thread,
+				      async_upload_task, source)) {
+		os_event_signal(source->async_staging_done);
+		finish_async_upload(source);
+	}
+
+finish:
+	gs_leave_context();
+}
+
 bool set_async_texture_size(struct obs_source *source,
 			    const struct obs_source_frame *frame)
 {
@@ -1987,7 +2570,8 @@ bool set_async_texture_size(struct obs_source *source,
 	    source->async_height == frame->height &&
 	    source->async_format == frame->format &&
 	    source->async_full_range == frame->full_range &&
-	    source->async_trc == frame->trc)
+	    source->async_trc == frame->trc &&
+	    source->async_sdr_only == obs->video.sdr_only)
 		return true;
 
 	source->async_width = frame->width;
@@ -1995,9 +2579,12 @@ bool set_async_texture_size(struct obs_source *source,
 	source->async_format = frame->format;
 	source->async_full_range = frame->full_range;
 	source->async_trc = frame->trc;
+	source->async_sdr_only = obs->video.sdr_only;
 
 	gs_enter_context(obs->video.graphics);
 
+	free_async_staging(source);
+
 	for (size_t c = 0; c < MAX_AV_PLANES; c++) {
 		gs_texture_destroy(source->async_textures[c]);
 		source->async_textures[c] = NULL;
@@ -2009,9 +2596,10 @@ bool set_async_texture_size(struct obs_source *source,
 	gs_texrender_destroy(source->async_prev_texrender);
 	source->async_texrender = NULL;
 	source->async_prev_texrender = NULL;
+	deinterlace_free_planes(source);
 
-	const enum gs_color_format format =
-		convert_video_format(frame->format, frame->trc);
+	const enum gs_color_format format = convert_video_format(
+		frame->format, frame->trc, source->async_sdr_only);
 	const bool async_gpu_conversion = (cur != CONVERT_NONE) &&
 					  init_gpu_conversion(source, frame);
 	source->async_gpu_conversion = async_gpu_conversion;
@@ -2025,6 +2613,8 @@ bool set_async_texture_size(struct obs_source *source,
 				source->async_convert_height[c],
 				source->async_texture_formats[c], 1, NULL,
 				GS_DYNAMIC);
+
+		create_async_staging(source);
 	} else {
 		source->async_textures[0] =
 			gs_texture_create(frame->width, frame->height, format,
@@ -2202,16 +2792,26 @@ static inline void set_eparami(gs_effect_t *effect, const char *name, int val)
 	gs_effect_set_int(param, val);
 }
 
-static bool update_async_texrender(struct obs_source *source,
-				   const struct obs_source_frame *frame,
-				   gs_texture_t *tex[MAX_AV_PLANES],
-				   gs_texrender_t *texrender)
+bool update_async_texrender(struct obs_source *source,
+			    const struct obs_source_frame *frame,
+			    gs_texture_t *tex[MAX_AV_PLANES],
+			    gs_texrender_t *texrender, bool upload)
 {
+	gs_texture_t *gpu_tex[MAX_AV_PLANES] = {0};
+
 	GS_DEBUG_MARKER_BEGIN(GS_DEBUG_COLOR_CONVERT_FORMAT, "Convert Format");
 
 	gs_texrender_reset(texrender);
 
-	upload_raw_frame(tex, frame);
+	if (frame->gpu.get_textures) {
+		if (!frame->gpu.get_textures(frame->gpu.param, gpu_tex)) {
+			GS_DEBUG_MARKER_END();
+			return false;
+		}
+		tex = gpu_tex;
+	} else if (upload) {
+		upload_raw_frame(tex, frame);
+	}
 
 	uint32_t cx = source->async_width;
 	uint32_t cy = source->async_height;
@@ -2332,8 +2932,24 @@ bool update_async_textures(struct obs_source *source,
 	source->async_linear_alpha =
 		(frame->flags & OBS_SOURCE_FRAME_LINEAR_ALPHA) != 0;
 
-	if (source->async_gpu_conversion && texrender)
-		return update_async_texrender(source, frame, tex, texrender);
+	if (source->async_gpu_conversion && texrender) {
+		/* conversion is done after deinterlacing the planes */
+		source->deinterlace_yuv = deinterlacing_enabled(source) &&
+					  source->deinterlace_planes[0] &&
+					  !frame->gpu.get_textures;
+		if (source->deinterlace_yuv) {
+			upload_raw_frame(tex, frame);
+			deinterlace_set_yuv_frame(source, frame);
+			return true;
+		}
+
+		return update_async_texrender(source, frame, tex, texrender,
+					      true);
+	}
+
+	/* GPU frames are only supported for formats that need conversion */
+	if (frame->gpu.get_textures)
+		return false;
 
 	type = get_convert_type(frame->format, frame->full_range, frame->trc);
 	if (type == CONVERT_NONE) {
@@ -2345,6 +2961,40 @@ bool update_async_textures(struct obs_source *source,
 	return false;
 }
 
+/* converts the frame from the staging textures if the upload thread already
+ * copied it there */
+static bool update_async_staged_textures(struct obs_source *source,
+					 const struct obs_source_frame *frame)
+{
+	struct obs_source_frame *staged = source->async_staging_frame;
+	bool success;
+
+	if (!staged)
+		return false;
+
+	finish_async_upload(source);
+
+	if (staged != frame || !source->async_staging_mapped ||
+	    !source->async_gpu_conversion || !source->async_texrender)
+		return false;
+
+	unmap_async_staging(source);
+
+	source->async_flip = frame->flip;
+	source->async_linear_alpha =
+		(frame->flags & OBS_SOURCE_FRAME_LINEAR_ALPHA) != 0;
+
+	success = update_async_texrender(
+		source, frame, source->async_staging[source->async_staging_idx],
+		source->async_texrender, false);
+
+	/* the other set is mapped now, so it's not written to while the
+	 * GPU may still be reading this one */
+	source->async_staging_idx ^= 1;
+	map_async_staging(source);
+	return success;
+}
+
 static inline void obs_source_draw_texture(struct obs_source *source,
 					   gs_effect_t *effect)
 {
@@ -2417,9 +3067,12 @@ static void obs_source_update_async_video(obs_source_t *source)
 			}
 
 			if (source->async_update_texture) {
-				update_async_textures(source, frame,
-						      source->async_textures,
-						      source->async_texrender);
+				if (!update_async_staged_textures(source,
+								  frame))
+					update_async_textures(
+						source, frame,
+						source->async_textures,
+						source->async_texrender);
 				source->async_update_texture = false;
 			}
 
@@ -2453,8 +3106,10 @@ static void rotate_async_video(obs_source_t *source, long rotation)
 static inline void obs_source_render_async_video(obs_source_t *source)
 {
 	if (source->async_textures[0] && source->async_active) {
-		const enum gs_color_space source_space = convert_video_space(
-			source->async_format, source->async_trc);
+		const enum gs_color_space source_space =
+			convert_video_space(source->async_format,
+					    source->async_trc,
+					    source->async_sdr_only);
 
 		gs_effect_t *const effect =
 			obs_get_base_effect(OBS_EFFECT_DEFAULT);
@@ -2764,6 +3419,10 @@ static inline void obs_source_main_render(obs_source_t *source)
 			      source->filters.num == 0 && !custom_draw;
 	bool previous_srgb = false;
 
+	/* a filter may draw the filters behind it along with itself */
+	if (obs_source_render_fused_filters(source))
+		return;
+
 	if (!srgb_aware) {
 		previous_srgb = gs_get_linear_srgb();
 		gs_set_linear_srgb(false);
@@ -2835,7 +3494,9 @@ static inline void render_video(obs_source_t *source)
 	else if (source->filter_target)
 		obs_source_video_render(source->filter_target);
 
-	else if (deinterlacing_enabled(source))
+	/* planes deinterlaced before conversion draw like any other frame */
+	else if (deinterlacing_enabled(source) &&
+		 !deinterlace_convert_yuv(source))
 		deinterlace_render(source);
 
 	else
@@ -2851,7 +3512,9 @@ void obs_source_video_render(obs_source_t *source)
 
 	source = obs_source_get_ref(source);
 	if (source) {
+		gs_timer_t *timer = obs_gpu_timing_begin_source(source);
 		render_video(source);
+		gs_timer_end(timer);
 		obs_source_release(source);
 	}
 }
@@ -2905,13 +3568,10 @@ uint32_t obs_source_get_height(obs_source_t *source)
 		       : get_base_height(source);
 }
 
-enum gs_color_space
-obs_source_get_color_space(obs_source_t *source, size_t count,
-			   const enum gs_color_space *preferred_spaces)
+static enum gs_color_space
+source_get_color_space(obs_source_t *source, size_t count,
+		       const enum gs_color_space *preferred_spaces)
 {
-	if (!data_valid(source, "obs_source_get_color_space"))
-		return GS_CS_SRGB;
-
 	if (source->info.type != OBS_SOURCE_TYPE_FILTER &&
 	    (source->info.output_flags & OBS_SOURCE_VIDEO) == 0) {
 		if (source->filter_parent)
@@ -2926,8 +3586,10 @@ obs_source_get_color_space(obs_source_t *source, size_t count,
 	}
 
 	if (source->info.output_flags & OBS_SOURCE_ASYNC) {
-		const enum gs_color_space video_space = convert_video_space(
-			source->async_format, source->async_trc);
+		const enum gs_color_space video_space =
+			convert_video_space(source->async_format,
+					    source->async_trc,
+					    source->async_sdr_only);
 
 		enum gs_color_space space = video_space;
 		for (size_t i = 0; i < count; ++i) {
@@ -2946,6 +3608,52 @@ obs_source_get_color_space(obs_source_t *source, size_t count,
 		       : GS_CS_SRGB;
 }
 
+/* only applies where the caller would also take sRGB, so callers that ask
+ * for an HDR space specifically neither count as HDR content nor get sRGB */
+static enum gs_color_space
+apply_sdr_only(enum gs_color_space space, size_t count,
+	       const enum gs_color_space *preferred_spaces)
+{
+	bool srgb_allowed = false;
+
+	for (size_t i = 0; i < count; ++i) {
+		if (preferred_spaces[i] == GS_CS_SRGB) {
+			srgb_allowed = true;
+			break;
+		}
+	}
+
+	if (!srgb_allowed)
+		return space;
+
+	switch (space) {
+	case GS_CS_709_EXTENDED:
+	case GS_CS_709_SCRGB:
+		os_atomic_store_bool(&obs->video.hdr_content, true);
+		break;
+	case GS_CS_SRGB_16F:
+		if (obs->video.sdr_only)
+			space = GS_CS_SRGB;
+		break;
+	case GS_CS_SRGB:
+		break;
+	}
+
+	return space;
+}
+
+enum gs_color_space
+obs_source_get_color_space(obs_source_t *source, size_t count,
+			   const enum gs_color_space *preferred_spaces)
+{
+	if (!data_valid(source, "obs_source_get_color_space"))
+		return GS_CS_SRGB;
+
+	enum gs_color_space space =
+		source_get_color_space(source, count, preferred_spaces);
+	return apply_sdr_only(space, count, preferred_spaces);
+}
+
 uint32_t obs_source_get_base_width(obs_source_t *source)
 {
 	if (!data_valid(source, "obs_source_get_base_width"))
@@ -3026,6 +3734,8 @@ void obs_source_filter_add(obs_source_t *source, obs_source_t *filter)
 
 	pthread_mutex_unlock(&source->filter_mutex);
 
+	content_changed(source);
+
 	calldata_init_fixed(&cd, stack, sizeof(stack));
 	calldata_set_ptr(&cd, "source", source);
 	calldata_set_ptr(&cd, "filter", filter);
@@ -3064,6 +3774,8 @@ static bool obs_source_filter_remove_refless(obs_source_t *source,
 
 	pthread_mutex_unlock(&source->filter_mutex);
 
+	content_changed(source);
+
 	calldata_init_fixed(&cd, stack, sizeof(stack));
 	calldata_set_ptr(&cd, "source", source);
 	calldata_set_ptr(&cd, "filter", filter);
@@ -3191,8 +3903,10 @@ void obs_source_filter_set_order(obs_source_t *source, obs_source_t *filter,
 	success = move_filter_dir(source, filter, movement);
 	pthread_mutex_unlock(&source->filter_mutex);
 
-	if (success)
+	if (success) {
+		content_changed(source);
 		obs_source_dosignal(source, NULL, "reorder_filters");
+	}
 }
 
 obs_data_t *obs_source_get_settings(const obs_source_t *source)
@@ -3217,6 +3931,11 @@ struct obs_source_frame *filter_async_video(obs_source_t *source,
 		if (!filter->enabled)
 			continue;
 
+		/* async filters work on frame data, which GPU frames don't
+		 * have */
+		if (in->gpu.get_textures)
+			break;
+
 		if (filter->context.data && filter->info.filter_video) {
 			in = filter->info.filter_video(filter->context.data,
 						       in);
@@ -3230,39 +3949,23 @@ struct obs_source_frame *filter_async_video(obs_source_t *source,
 	return in;
 }
 
-static inline void copy_frame_data_line(struct obs_source_frame *dst,
-					const struct obs_source_frame *src,
-					uint32_t plane, uint32_t y)
-{
-	uint32_t pos_src = y * src->linesize[plane];
-	uint32_t pos_dst = y * dst->linesize[plane];
-	uint32_t bytes = dst->linesize[plane] < src->linesize[plane]
-				 ? dst->linesize[plane]
-				 : src->linesize[plane];
-
-	if (dst->data[plane] + pos_dst != NULL &&
-	    src->data[plane] + pos_src != NULL)
-		memcpy(dst->data[plane] + pos_dst, src->data[plane] + pos_src,
-		       bytes);
-}
-
-static inline void copy_frame_data_plane(struct obs_source_frame *dst,
+static inline void copy_frame_data_plane(struct video_copy_plane *planes,
+					 struct obs_source_frame *dst,
 					 const struct obs_source_frame *src,
 					 uint32_t plane, uint32_t lines)
 {
-	if (dst->linesize[plane] != src->linesize[plane]) {
-		for (uint32_t y = 0; y < lines; y++)
-			copy_frame_data_line(dst, src, plane, y);
-	} else {
-		if (dst->data[plane] != NULL && src->data[plane] != NULL)
-			memcpy(dst->data[plane], src->data[plane],
-			       (size_t)dst->linesize[plane] * (size_t)lines);
-	}
+	planes[plane].dst = dst->data[plane];
+	planes[plane].src = src->data[plane];
+	planes[plane].dst_linesize = dst->linesize[plane];
+	planes[plane].src_linesize = src->linesize[plane];
+	planes[plane].lines = lines;
 }
 
 static void copy_frame_data(struct obs_source_frame *dst,
 			    const struct obs_source_frame *src)
 {
+	struct video_copy_plane planes[MAX_AV_PLANES] = {0};
+
 	dst->duration = src->duration;
 	dst->flip = src->flip;
 	dst->flags = src->flags;
@@ -3286,9 +3989,9 @@ static void copy_frame_data(struct obs_source_frame *dst,
 	case VIDEO_FORMAT_I010: {
 		const uint32_t height = dst->height;
 		const uint32_t half_height = (height + 1) / 2;
-		copy_frame_data_plane(dst, src, 0, height);
-		copy_frame_data_plane(dst, src, 1, half_height);
-		copy_frame_data_plane(dst, src, 2, half_height);
+		copy_frame_data_plane(planes, dst, src, 0, height);
+		copy_frame_data_plane(planes, dst, src, 1, half_height);
+		copy_frame_data_plane(planes, dst, src, 2, half_height);
 		break;
 	}
 
@@ -3296,8 +3999,8 @@ static void copy_frame_data(struct obs_source_frame *dst,
 	case VIDEO_FORMAT_P010: {
 		const uint32_t height = dst->height;
 		const uint32_t half_height = (height + 1) / 2;
-		copy_frame_data_plane(dst, src, 0, height);
-		copy_frame_data_plane(dst, src, 1, half_height);
+		copy_frame_data_plane(planes, dst, src, 0, height);
+		copy_frame_data_plane(planes, dst, src, 1, half_height);
 		break;
 	}
 
@@ -3305,9 +4008,9 @@ static void copy_frame_data(struct obs_source_frame *dst,
 	case VIDEO_FORMAT_I422:
 	case VIDEO_FORMAT_I210:
 	case VIDEO_FORMAT_I412:
-		copy_frame_data_plane(dst, src, 0, dst->height);
-		copy_frame_data_plane(dst, src, 1, dst->height);
-		copy_frame_data_plane(dst, src, 2, dst->height);
+		copy_frame_data_plane(planes, dst, src, 0, dst->height);
+		copy_frame_data_plane(planes, dst, src, 1, dst->height);
+		copy_frame_data_plane(planes, dst, src, 2, dst->height);
 		break;
 
 	case VIDEO_FORMAT_YVYU:
@@ -3320,28 +4023,30 @@ static void copy_frame_data(struct obs_source_frame *dst,
 	case VIDEO_FORMAT_Y800:
 	case VIDEO_FORMAT_BGR3:
 	case VIDEO_FORMAT_AYUV:
-		copy_frame_data_plane(dst, src, 0, dst->height);
+		copy_frame_data_plane(planes, dst, src, 0, dst->height);
 		break;
 
 	case VIDEO_FORMAT_I40A: {
 		const uint32_t height = dst->height;
 		const uint32_t half_height = (height + 1) / 2;
-		copy_frame_data_plane(dst, src, 0, height);
-		copy_frame_data_plane(dst, src, 1, half_height);
-		copy_frame_data_plane(dst, src, 2, half_height);
-		copy_frame_data_plane(dst, src, 3, height);
+		copy_frame_data_plane(planes, dst, src, 0, height);
+		copy_frame_data_plane(planes, dst, src, 1, half_height);
+		copy_frame_data_plane(planes, dst, src, 2, half_height);
+		copy_frame_data_plane(planes, dst, src, 3, height);
 		break;
 	}
 
 	case VIDEO_FORMAT_I42A:
 	case VIDEO_FORMAT_YUVA:
 	case VIDEO_FORMAT_YA2L:
-		copy_frame_data_plane(dst, src, 0, dst->height);
-		copy_frame_data_plane(dst, src, 1, dst->height);
-		copy_frame_data_plane(dst, src, 2, dst->height);
-		copy_frame_data_plane(dst, src, 3, dst->height);
+		copy_frame_data_plane(planes, dst, src, 0, dst->height);
+		copy_frame_data_plane(planes, dst, src, 1, dst->height);
+		copy_frame_data_plane(planes, dst, src, 2, dst->height);
+		copy_frame_data_plane(planes, dst, src, 3, dst->height);
 		break;
 	}
+
+	video_copy_planes(planes, MAX_AV_PLANES);
 }
 
 void obs_source_frame_copy(struct obs_source_frame *dst,
@@ -3381,13 +4086,19 @@ static inline void free_async_cache(struct obs_source *source)
 #define MAX_UNUSED_FRAME_DURATION 5
 
 /* frees frame allocations if they haven't been used for a specific period
- * of time */
+ * of time.  a large cache (frames held by a delay filter) waits for a full
+ * cycle through it instead, so frames that were all released at once are
+ * reused rather than freed and allocated again one by one */
 static void clean_cache(obs_source_t *source)
 {
+	long max_unused = MAX_UNUSED_FRAME_DURATION;
+	if (source->async_cache.num > MAX_UNUSED_FRAME_DURATION)
+		max_unused = (long)source->async_cache.num;
+
 	for (size_t i = source->async_cache.num; i > 0; i--) {
 		struct async_frame *af = &source->async_cache.array[i - 1];
 		if (!af->used) {
-			if (++af->unused_count == MAX_UNUSED_FRAME_DURATION) {
+			if (++af->unused_count >= max_unused) {
 				obs_source_frame_destroy(af->frame);
 				da_erase(source->async_cache, i - 1);
 			}
@@ -3395,12 +4106,179 @@ static void clean_cache(obs_source_t *source)
 	}
 }
 
-#define MAX_ASYNC_FRAMES 30
-//if return value is not null then do (os_atomic_dec_long(&output->refs) == 0) && obs_source_frame_destroy(output)
-static inline struct obs_source_frame *
-cache_video(struct obs_source *source, const struct obs_source_frame *frame)
+#define MAX_ASYNC_FRAMES 30
+
+/* takes an unused frame from the cache or adds a new one, async_mutex must
+ * be locked.  the frame is returned with an extra reference and marked as
+ * in use so the cache won't free it while it's being written to */
+static struct obs_source_frame *claim_cache_frame(struct obs_source *source,
+						  enum video_format format,
+						  uint32_t width,
+						  uint32_t height)
+{
+	struct obs_source_frame *new_frame = NULL;
+
+	for (size_t i = 0; i < source->async_cache.num; i++) {
+		struct async_frame *af = &source->async_cache.array[i];
+		if (!af->used) {
+			new_frame = af->frame;
+			new_frame->format = format;
+			af->used = true;
+			af->unused_count = 0;
+			break;
+		}
+	}
+
+	clean_cache(source);
+
+	if (!new_frame) {
+		struct async_frame new_af;
+
+		new_frame = obs_source_frame_create(format, width, height);
+		new_af.frame = new_frame;
+		new_af.used = true;
+		new_af.unused_count = 0;
+		new_frame->refs = 1;
+
+		da_push_back(source->async_cache, &new_af);
+	}
+
+	os_atomic_inc_long(&new_frame->refs);
+
+	new_frame->in_use = true;
+	return new_frame;
+}
+
+//if return value is not null then do (os_atomic_dec_long(&output->refs) == 0) && obs_source_frame_destroy(output)
+static inline struct obs_source_frame *
+cache_video(struct obs_source *source, const struct obs_source_frame *frame)
+{
+	struct obs_source_frame *new_frame = NULL;
+
+	pthread_mutex_lock(&source->async_mutex);
+
+	if (source->async_frames.num >= MAX_ASYNC_FRAMES) {
+		free_async_cache(source);
+		source->last_frame_ts = 0;
+		pthread_mutex_unlock(&source->async_mutex);
+		return NULL;
+	}
+
+	if (async_texture_changed(source, frame)) {
+		free_async_cache(source);
+		source->async_cache_width = frame->width;
+		source->async_cache_height = frame->height;
+	}
+
+	const enum video_format format = frame->format;
+	source->async_cache_format = format;
+	source->async_cache_full_range = frame->full_range;
+	source->async_cache_trc = frame->trc;
+
+	new_frame = claim_cache_frame(source, format, frame->width,
+				      frame->height);
+
+	pthread_mutex_unlock(&source->async_mutex);
+
+	copy_frame_data(new_frame, frame);
+
+	new_frame->in_use = false;
+
+	return new_frame;
+}
+
+static int cmp_int64(const void *a, const void *b)
+{
+	int64_t val_a = *(const int64_t *)a;
+	int64_t val_b = *(const int64_t *)b;
+	return (val_a > val_b) - (val_a < val_b);
+}
+
+static void update_jitter_target(struct obs_source *source)
+{
+	int64_t sorted[ASYNC_JITTER_WINDOW];
+	size_t count = source->async_jitter_samples.num;
+	size_t idx;
+	int64_t target;
+
+	memcpy(sorted, source->async_jitter_samples.array,
+	       count * sizeof(int64_t));
+	qsort(sorted, count, sizeof(int64_t), cmp_int64);
+
+	idx = (size_t)((double)(count - 1) *
+		       (double)source->async_jitter_percentile / 100.0);
+	target = sorted[idx];
+
+	if (target < 0)
+		target = 0;
+	else if (target > MAX_ASYNC_JITTER_DELAY)
+		target = MAX_ASYNC_JITTER_DELAY;
+
+	source->async_jitter_target = target;
+}
+
+/* records how late a frame arrived relative to its timestamp, async_mutex
+ * must be locked */
+static void async_jitter_frame_arrived(struct obs_source *source,
+				       const struct obs_source_frame *frame)
+{
+	if (source->async_jitter_percentile <= 0.0f)
+		return;
+
+	uint64_t os_time = os_gettime_ns();
+	bool audio_active = jitter_audio_active(source, os_time);
+	int64_t transit = (int64_t)(os_time - frame->timestamp);
+	int64_t ref;
+	int64_t sample;
+
+	/* video is placed on the same timeline as audio when there is any,
+	 * otherwise relative to the delay of the first frame */
+	if (audio_active)
+		ref = (int64_t)source->timing_adjust;
+	else if (source->async_jitter_ref_set)
+		ref = source->async_jitter_ref;
+	else
+		ref = transit;
+
+	sample = transit - ref;
+
+	if (sample > (int64_t)MAX_TS_VAR || sample < -(int64_t)MAX_TS_VAR) {
+		/* timestamp jump, the audio timing resets itself shortly */
+		if (audio_active)
+			return;
+		ref = transit;
+		sample = 0;
+	}
+
+	if (!source->async_jitter_ref_set || ref != source->async_jitter_ref) {
+		da_resize(source->async_jitter_samples, 0);
+		source->async_jitter_pos = 0;
+		source->async_jitter_updates = 0;
+		source->async_jitter_ref = ref;
+		source->async_jitter_ref_set = true;
+	}
+
+	if (source->async_jitter_samples.num < ASYNC_JITTER_WINDOW) {
+		da_push_back(source->async_jitter_samples, &sample);
+	} else {
+		size_t pos = source->async_jitter_pos;
+		source->async_jitter_samples.array[pos] = sample;
+		source->async_jitter_pos = (pos + 1) % ASYNC_JITTER_WINDOW;
+	}
+
+	/* converge quickly at the start, then only every so often */
+	if (source->async_jitter_samples.num < ASYNC_JITTER_UPDATE_INTERVAL ||
+	    ++source->async_jitter_updates % ASYNC_JITTER_UPDATE_INTERVAL == 0)
+		update_jitter_target(source);
+}
+
+/* GPU frames can't be copied into the cache, the frame is queued as is and
+ * added to the cache only so the usual cleanup releases it */
+static void output_gpu_frame(struct obs_source *source,
+			     const struct obs_source_frame *frame)
 {
-	struct obs_source_frame *new_frame = NULL;
+	struct obs_source_frame *new_frame;
+	struct async_frame af;
 
 	pthread_mutex_lock(&source->async_mutex);
 
@@ -3408,7 +4286,8 @@ cache_video(struct obs_source *source, const struct obs_source_frame *frame)
 		free_async_cache(source);
 		source->last_frame_ts = 0;
 		pthread_mutex_unlock(&source->async_mutex);
-		return NULL;
+		frame->gpu.release(frame->gpu.param);
+		return;
 	}
 
 	if (async_texture_changed(source, frame)) {
@@ -3417,48 +4296,26 @@ cache_video(struct obs_source *source, const struct obs_source_frame *frame)
 		source->async_cache_height = frame->height;
 	}
 
-	const enum video_format format = frame->format;
-	source->async_cache_format = format;
+	source->async_cache_format = frame->format;
 	source->async_cache_full_range = frame->full_range;
 	source->async_cache_trc = frame->trc;
 
-	for (size_t i = 0; i < source->async_cache.num; i++) {
-		struct async_frame *af = &source->async_cache.array[i];
-		if (!af->used) {
-			new_frame = af->frame;
-			new_frame->format = format;
-			af->used = true;
-			af->unused_count = 0;
-			break;
-		}
-	}
-
-	clean_cache(source);
-
-	if (!new_frame) {
-		struct async_frame new_af;
-
-		new_frame = obs_source_frame_create(format, frame->width,
-						    frame->height);
-		new_af.frame = new_frame;
-		new_af.used = true;
-		new_af.unused_count = 0;
-		new_frame->refs = 1;
-
-		da_push_back(source->async_cache, &new_af);
-	}
+	new_frame = bmemdup(frame, sizeof(*frame));
+	memset(new_frame->data, 0, sizeof(new_frame->data));
+	new_frame->refs = 1;
+	new_frame->prev_frame = false;
+	new_frame->in_use = false;
 
-	os_atomic_inc_long(&new_frame->refs);
+	af.frame = new_frame;
+	af.used = true;
+	af.unused_count = 0;
+	da_push_back(source->async_cache, &af);
 
-	new_frame->in_use = true;
+	async_jitter_frame_arrived(source, new_frame);
+	da_push_back(source->async_frames, &new_frame);
+	source->async_active = true;
 
 	pthread_mutex_unlock(&source->async_mutex);
-
-	copy_frame_data(new_frame, frame);
-
-	new_frame->in_use = false;
-
-	return new_frame;
 }
 
 static void
@@ -3477,6 +4334,11 @@ obs_source_output_video_internal(obs_source_t *source,
 		return;
 	}
 
+	if (frame->gpu.get_textures) {
+		output_gpu_frame(source, frame);
+		return;
+	}
+
 	struct obs_source_frame *output = cache_video(source, frame);
 
 	/* ------------------------------------------- */
@@ -3486,6 +4348,7 @@ obs_source_output_video_internal(obs_source_t *source,
 			obs_source_frame_destroy(output);
 			output = NULL;
 		} else {
+			async_jitter_frame_arrived(source, output);
 			da_push_back(source->async_frames, &output);
 			source->async_active = true;
 		}
@@ -3496,8 +4359,11 @@ obs_source_output_video_internal(obs_source_t *source,
 void obs_source_output_video(obs_source_t *source,
 			     const struct obs_source_frame *frame)
 {
-	if (destroying(source))
+	if (destroying(source)) {
+		if (frame && frame->gpu.release)
+			frame->gpu.release(frame->gpu.param);
 		return;
+	}
 	if (!frame) {
 		obs_source_output_video_internal(source, NULL);
 		return;
@@ -3549,6 +4415,127 @@ void obs_source_output_video2(obs_source_t *source,
 	obs_source_output_video_internal(source, &new_frame);
 }
 
+struct obs_source_frame *obs_source_frame_acquire(obs_source_t *source,
+						  enum video_format format,
+						  uint32_t width,
+						  uint32_t height)
+{
+	struct obs_source_frame *frame;
+
+	if (!obs_source_valid(source, "obs_source_frame_acquire"))
+		return NULL;
+	if (destroying(source))
+		return NULL;
+
+	pthread_mutex_lock(&source->async_mutex);
+
+	if (source->async_frames.num >= MAX_ASYNC_FRAMES) {
+		free_async_cache(source);
+		source->last_frame_ts = 0;
+		pthread_mutex_unlock(&source->async_mutex);
+		return NULL;
+	}
+
+	/* the range and transfer function aren't known yet, those are checked
+	 * again on submit */
+	if (source->async_cache_width != width ||
+	    source->async_cache_height != height ||
+	    get_convert_type(source->async_cache_format,
+			     source->async_cache_full_range,
+			     source->async_cache_trc) !=
+		    get_convert_type(format, source->async_cache_full_range,
+				     source->async_cache_trc)) {
+		free_async_cache(source);
+		source->async_cache_width = width;
+		source->async_cache_height = height;
+	}
+
+	source->async_cache_format = format;
+
+	frame = claim_cache_frame(source, format, width, height);
+
+	pthread_mutex_unlock(&source->async_mutex);
+
+	frame->timestamp = 0;
+	frame->max_luminance = 0;
+	frame->flip = false;
+	frame->flags = 0;
+	frame->trc = VIDEO_TRC_DEFAULT;
+	frame->full_range = false;
+	video_format_get_parameters_for_format(VIDEO_CS_DEFAULT,
+					       VIDEO_RANGE_PARTIAL, format,
+					       frame->color_matrix,
+					       frame->color_range_min,
+					       frame->color_range_max);
+	return frame;
+}
+
+/* finds a frame handed out by obs_source_frame_acquire, async_mutex must be
+ * locked.  returns false if the cache has been reset since */
+static bool release_acquired_frame(struct obs_source *source,
+				   struct obs_source_frame *frame,
+				   bool submitted)
+{
+	for (size_t i = 0; i < source->async_cache.num; i++) {
+		struct async_frame *af = &source->async_cache.array[i];
+		if (af->frame == frame) {
+			if (!submitted)
+				af->used = false;
+			frame->in_use = false;
+			os_atomic_dec_long(&frame->refs);
+			return true;
+		}
+	}
+
+	/* the cache dropped the frame while it was acquired, so this was the
+	 * last reference */
+	obs_source_frame_destroy(frame);
+	return false;
+}
+
+void obs_source_frame_submit(obs_source_t *source,
+			     struct obs_source_frame *frame)
+{
+	if (!obs_source_valid(source, "obs_source_frame_submit"))
+		return;
+	if (!obs_ptr_valid(frame, "obs_source_frame_submit"))
+		return;
+
+	if (!format_is_yuv(frame->format))
+		frame->full_range = true;
+
+	pthread_mutex_lock(&source->async_mutex);
+
+	if (async_texture_changed(source, frame)) {
+		/* only the range or transfer function can differ from what
+		 * was acquired, the next frame will use the new values */
+		release_acquired_frame(source, frame, false);
+		free_async_cache(source);
+		source->async_cache_full_range = frame->full_range;
+		source->async_cache_trc = frame->trc;
+
+	} else if (release_acquired_frame(source, frame, true)) {
+		async_jitter_frame_arrived(source, frame);
+		da_push_back(source->async_frames, &frame);
+		source->async_active = true;
+	}
+
+	pthread_mutex_unlock(&source->async_mutex);
+}
+
+void obs_source_frame_discard(obs_source_t *source,
+			      struct obs_source_frame *frame)
+{
+	if (!obs_source_valid(source, "obs_source_frame_discard"))
+		return;
+	if (!frame)
+		return;
+
+	pthread_mutex_lock(&source->async_mutex);
+	release_acquired_frame(source, frame, false);
+	pthread_mutex_unlock(&source->async_mutex);
+}
+
 void obs_source_reset_video(obs_source_t *source)
 {
 	obs_source_output_video(source, NULL);
@@ -3727,13 +4714,10 @@ void obs_source_show_preloaded_video(obs_source_t *source)
 
 	obs_leave_graphics();
 
-	pthread_mutex_lock(&source->audio_buf_mutex);
 	sys_ts = (source->monitoring_type != OBS_MONITORING_TYPE_MONITOR_ONLY)
 			 ? os_gettime_ns()
 			 : 0;
-	reset_audio_timing(source, source->last_frame_ts, sys_ts);
-	reset_audio_data(source, sys_ts);
-	pthread_mutex_unlock(&source->audio_buf_mutex);
+	reset_audio(source, source->last_frame_ts, sys_ts, true);
 }
 
 static void
@@ -3830,8 +4814,10 @@ filter_async_audio(obs_source_t *source, struct obs_audio_data *in)
 			continue;
 
 		if (filter->context.data && filter->info.filter_audio) {
+			uint64_t start = os_gettime_ns();
 			in = filter->info.filter_audio(filter->context.data,
 						       in);
+			filter->audio_filter_ns = os_gettime_ns() - start;
 			if (!in)
 				return NULL;
 		}
@@ -3860,9 +4846,11 @@ static inline void reset_resampler(obs_source_t *source,
 	source->resampler = NULL;
 	source->resample_offset = 0;
 
+	/* the jitter buffer needs the resampler to stretch audio with */
 	if (source->sample_info.samples_per_sec == obs_info->samples_per_sec &&
 	    source->sample_info.format == obs_info->format &&
-	    source->sample_info.speakers == obs_info->speakers) {
+	    source->sample_info.speakers == obs_info->speakers &&
+	    source->async_jitter_percentile <= 0.0f) {
 		source->audio_failed = false;
 		return;
 	}
@@ -3926,31 +4914,66 @@ static void process_audio_balancing(struct obs_source *source, uint32_t frames,
 				    float balance, enum obs_balance_type type)
 {
 	float **data = (float **)source->audio_data.data;
+	float left, right;
 
 	switch (type) {
 	case OBS_BALANCE_TYPE_SINE_LAW:
-		for (uint32_t frame = 0; frame < frames; frame++) {
-			data[0][frame] = data[0][frame] *
-					 sinf((1.0f - balance) * (M_PI / 2.0f));
-			data[1][frame] =
-				data[1][frame] * sinf(balance * (M_PI / 2.0f));
-		}
+		left = sinf((1.0f - balance) * (M_PI / 2.0f));
+		right = sinf(balance * (M_PI / 2.0f));
 		break;
 	case OBS_BALANCE_TYPE_SQUARE_LAW:
-		for (uint32_t frame = 0; frame < frames; frame++) {
-			data[0][frame] = data[0][frame] * sqrtf(1.0f - balance);
-			data[1][frame] = data[1][frame] * sqrtf(balance);
-		}
+		left = sqrtf(1.0f - balance);
+		right = sqrtf(balance);
 		break;
 	case OBS_BALANCE_TYPE_LINEAR:
-		for (uint32_t frame = 0; frame < frames; frame++) {
-			data[0][frame] = data[0][frame] * (1.0f - balance);
-			data[1][frame] = data[1][frame] * balance;
-		}
+		left = 1.0f - balance;
+		right = balance;
 		break;
 	default:
-		break;
+		return;
 	}
+
+	audio_kernel_mul(data[0], left, frames);
+	audio_kernel_mul(data[1], right, frames);
+}
+
+/* asks the resampler to add or drop a few samples over the next packet so
+ * that the buffer delay converges on the jitter buffer target */
+static void stretch_jitter_audio(obs_source_t *source,
+				 const struct obs_source_audio *audio)
+{
+	int64_t rate = (int64_t)audio_output_get_sample_rate(obs->audio.audio);
+	int64_t out_frames = (int64_t)util_mul_div64(audio->frames, rate,
+						     audio->samples_per_sec);
+	int64_t max_step = out_frames / ASYNC_JITTER_SLEW_DIV;
+	int64_t diff, delta;
+	uint64_t os_time = os_gettime_ns();
+
+	/* take over from wherever video had moved the delay to */
+	if (!jitter_audio_active(source, os_time))
+		source->async_jitter_frames =
+			source->async_jitter_delay * rate / 1000000000LL;
+
+	source->async_jitter_audio_time = os_time;
+	source->async_jitter_audio_delay = source->async_jitter_delay;
+	source->async_jitter_stretch = 0;
+
+	diff = source->async_jitter_target - source->async_jitter_delay;
+	delta = diff * rate / 1000000000LL;
+	if (delta > max_step)
+		delta = max_step;
+	else if (delta < -max_step)
+		delta = -max_step;
+
+	if (!delta || !audio_resampler_set_compensation(source->resampler,
+							 (int)delta,
+							 (int)out_frames))
+		return;
+
+	source->async_jitter_stretch = (int32_t)delta;
+	source->async_jitter_frames += delta;
+	source->async_jitter_delay =
+		source->async_jitter_frames * 1000000000LL / rate;
 }
 
 /* resamples/remixes new audio to the designated main audio output format */
@@ -3973,6 +4996,9 @@ static void process_audio(obs_source_t *source,
 
 		memset(output, 0, sizeof(output));
 
+		if (source->async_jitter_percentile > 0.0f)
+			stretch_jitter_audio(source, audio);
+
 		audio_resampler_resample(source->resampler, output, &frames,
 					 &source->resample_offset, audio->data,
 					 audio->frames);
@@ -4047,7 +5073,14 @@ void remove_async_frame(obs_source_t *source, struct obs_source_frame *frame)
 		struct async_frame *f = &source->async_cache.array[i];
 
 		if (f->frame == frame) {
-			f->used = false;
+			/* GPU frames usually hold on to decoder surfaces, so
+			 * they're released right away rather than reused */
+			if (frame->gpu.get_textures) {
+				da_erase(source->async_cache, i);
+				obs_source_frame_decref(frame);
+			} else {
+				f->used = false;
+			}
 			break;
 		}
 	}
@@ -4145,12 +5178,87 @@ static bool ready_async_frame(obs_source_t *source, uint64_t sys_time)
 	return frame != NULL;
 }
 
+/* moves the buffer depth towards the target when there's no audio to stretch
+ * instead */
+static int64_t slew_jitter_delay(obs_source_t *source, uint64_t sys_time)
+{
+	int64_t delay = source->async_jitter_delay;
+	int64_t diff = source->async_jitter_target - delay;
+	uint64_t elapsed = source->async_jitter_sys_ts
+				   ? sys_time - source->async_jitter_sys_ts
+				   : 0;
+	int64_t max_step;
+
+	source->async_jitter_sys_ts = sys_time;
+
+	if (elapsed > MAX_TS_VAR)
+		elapsed = 0;
+
+	max_step = (int64_t)(elapsed / ASYNC_JITTER_SLEW_DIV);
+	if (diff > max_step)
+		diff = max_step;
+	else if (diff < -max_step)
+		diff = -max_step;
+
+	delay += diff;
+	source->async_jitter_delay = delay;
+	return delay;
+}
+
+/* in jitter buffer mode a frame is due once the buffer delay has passed
+ * since it would have arrived without any jitter.  the newest due frame is
+ * kept and any older ones are dropped */
+static bool ready_jitter_frame(obs_source_t *source, uint64_t sys_time)
+{
+	int64_t delay = source->async_jitter_delay;
+	size_t due = 0;
+
+	if (!jitter_audio_active(source, os_gettime_ns()))
+		delay = slew_jitter_delay(source, sys_time);
+	else
+		source->async_jitter_sys_ts = sys_time;
+
+	for (size_t i = 0; i < source->async_frames.num; i++) {
+		struct obs_source_frame *frame = source->async_frames.array[i];
+		int64_t late = (int64_t)(sys_time - frame->timestamp) -
+			       source->async_jitter_ref - delay;
+
+		/* frames that are far off after a timestamp jump are shown
+		 * right away rather than held */
+		if (late < 0 && late > -(int64_t)MAX_TS_VAR)
+			break;
+
+		due = i + 1;
+	}
+
+	if (!due)
+		return false;
+
+	while (--due) {
+		struct obs_source_frame *frame = source->async_frames.array[0];
+		da_erase(source->async_frames, 0);
+		remove_async_frame(source, frame);
+	}
+
+	source->last_frame_ts = source->async_frames.array[0]->timestamp;
+	return true;
+}
+
 static inline struct obs_source_frame *get_closest_frame(obs_source_t *source,
 							 uint64_t sys_time)
 {
 	if (!source->async_frames.num)
 		return NULL;
 
+	if (source->async_jitter_percentile > 0.0f) {
+		if (!ready_jitter_frame(source, sys_time))
+			return NULL;
+
+		struct obs_source_frame *frame = source->async_frames.array[0];
+		da_erase(source->async_frames, 0);
+		return frame;
+	}
+
 	if (!source->last_frame_ts || ready_async_frame(source, sys_time)) {
 		struct obs_source_frame *frame = source->async_frames.array[0];
 		da_erase(source->async_frames, 0);
@@ -4486,7 +5594,8 @@ void obs_source_skip_video_filter(obs_source_t *filter)
 			obs_source_default_render(target);
 		else if (target->info.video_render)
 			obs_source_main_render(target);
-		else if (deinterlacing_enabled(target))
+		else if (deinterlacing_enabled(target) &&
+			 !deinterlace_convert_yuv(target))
 			deinterlace_render(target);
 		else
 			obs_source_render_async_video(target);
@@ -4815,6 +5924,44 @@ bool obs_source_showing(const obs_source_t *source)
 		       : false;
 }
 
+void obs_set_source_hibernate_delay(uint32_t delay_ms)
+{
+	if (!obs)
+		return;
+
+	obs->data.hibernate_delay_ns = (uint64_t)delay_ms * 1000000ULL;
+}
+
+uint32_t obs_get_source_hibernate_delay(void)
+{
+	return obs ? (uint32_t)(obs->data.hibernate_delay_ns / 1000000ULL) : 0;
+}
+
+bool obs_source_hibernating(const obs_source_t *source)
+{
+	return obs_source_valid(source, "obs_source_hibernating")
+		       ? source->hibernating
+		       : false;
+}
+
+static void prefetch_tree(obs_source_t *parent, obs_source_t *child,
+			  void *param)
+{
+	os_atomic_set_bool(&child->prefetch, true);
+
+	UNUSED_PARAMETER(parent);
+	UNUSED_PARAMETER(param);
+}
+
+void obs_source_prefetch(obs_source_t *source)
+{
+	if (!obs_source_valid(source, "obs_source_prefetch"))
+		return;
+
+	os_atomic_set_bool(&source->prefetch, true);
+	obs_source_enum_active_tree(source, prefetch_tree, NULL);
+}
+
 static inline void signal_flags_updated(obs_source_t *source)
 {
 	struct calldata data;
@@ -5060,6 +6207,7 @@ void obs_source_set_enabled(obs_source_t *source, bool enabled)
 		return;
 
 	source->enabled = enabled;
+	content_changed(source);
 
 	calldata_init_fixed(&data, stack, sizeof(stack));
 	calldata_set_ptr(&data, "source", source);
@@ -5277,24 +6425,16 @@ static float get_source_volume(obs_source_t *source, uint64_t os_time)
 static inline void multiply_output_audio(obs_source_t *source, size_t mix,
 					 size_t channels, float vol)
 {
-	register float *out = source->audio_output_buf[mix][0];
-	register float *end = out + AUDIO_OUTPUT_FRAMES * channels;
-
-	while (out < end)
-		*(out++) *= vol;
+	audio_kernel_mul(source->audio_output_buf[mix][0], vol,
+			 AUDIO_OUTPUT_FRAMES * channels);
 }
 
 static inline void multiply_vol_data(obs_source_t *source, size_t mix,
 				     size_t channels, float *vol_data)
 {
-	for (size_t ch = 0; ch < channels; ch++) {
-		register float *out = source->audio_output_buf[mix][ch];
-		register float *end = out + AUDIO_OUTPUT_FRAMES;
-		register float *vol = vol_data;
-
-		while (out < end)
-			*(out++) *= *(vol++);
-	}
+	for (size_t ch = 0; ch < channels; ch++)
+		audio_kernel_mul_buf(source->audio_output_buf[mix][ch],
+				     vol_data, AUDIO_OUTPUT_FRAMES);
 }
 
 static inline void apply_audio_action(obs_source_t *source,
@@ -5395,6 +6535,7 @@ static void apply_audio_volume(obs_source_t *source, uint32_t mixers,
 		memset(source->audio_output_buf[0][0], 0,
 		       AUDIO_OUTPUT_FRAMES * sizeof(float) *
 			       MAX_AUDIO_CHANNELS * MAX_AUDIO_MIXES);
+		source->audio_silent = true;
 		return;
 	}
 
@@ -5482,6 +6623,17 @@ static void audio_submix(obs_source_t *source, size_t channels,
 	obs_source_output_audio(source, &audio);
 }
 
+static inline bool audio_actions_pending(obs_source_t *source)
+{
+	bool pending;
+
+	pthread_mutex_lock(&source->audio_actions_mutex);
+	pending = source->audio_actions.num > 0;
+	pthread_mutex_unlock(&source->audio_actions_mutex);
+
+	return pending;
+}
+
 static inline void process_audio_source_tick(obs_source_t *source,
 					     uint32_t mixers, size_t channels,
 					     size_t sample_rate, size_t size)
@@ -5490,6 +6642,8 @@ static inline void process_audio_source_tick(obs_source_t *source,
 
 	pthread_mutex_lock(&source->audio_buf_mutex);
 
+	obs_source_drain_audio_packets(source);
+
 	if (source->audio_input_buf[0].size < size) {
 		source->audio_pending = true;
 		pthread_mutex_unlock(&source->audio_buf_mutex);
@@ -5502,6 +6656,20 @@ static inline void process_audio_source_tick(obs_source_t *source,
 
 	pthread_mutex_unlock(&source->audio_buf_mutex);
 
+	/* digital silence needs no copies, volume or mixing; pending audio
+	 * actions still go through the regular path so they apply on time */
+	if (!audio_submix &&
+	    audio_kernel_is_silent(source->audio_output_buf[0][0],
+				   size / sizeof(float) * channels) &&
+	    !audio_actions_pending(source)) {
+		memset(source->audio_output_buf[0][0], 0,
+		       AUDIO_OUTPUT_FRAMES * sizeof(float) *
+			       MAX_AUDIO_CHANNELS * MAX_AUDIO_MIXES);
+		source->audio_silent = true;
+		source->audio_pending = false;
+		return;
+	}
+
 	for (size_t mix = 1; mix < MAX_AUDIO_MIXES; mix++) {
 		uint32_t mix_and_val = (1 << mix);
 
@@ -5537,14 +6705,17 @@ static inline void process_audio_source_tick(obs_source_t *source,
 	source->audio_pending = false;
 }
 
-void obs_source_audio_render(obs_source_t *source, uint32_t mixers,
-			     size_t channels, size_t sample_rate, size_t size)
+static void source_audio_render(obs_source_t *source, uint32_t mixers,
+				size_t channels, size_t sample_rate,
+				size_t size)
 {
 	if (!source->audio_output_buf[0][0]) {
 		source->audio_pending = true;
 		return;
 	}
 
+	source->audio_silent = false;
+
 	if (source->info.audio_render) {
 		if (!source->context.data) {
 			source->audio_pending = true;
@@ -5566,6 +6737,14 @@ void obs_source_audio_render(obs_source_t *source, uint32_t mixers,
 	process_audio_source_tick(source, mixers, channels, sample_rate, size);
 }
 
+void obs_source_audio_render(obs_source_t *source, uint32_t mixers,
+			     size_t channels, size_t sample_rate, size_t size)
+{
+	uint64_t start = os_gettime_ns();
+	source_audio_render(source, mixers, channels, sample_rate, size);
+	source->audio_render_ns = os_gettime_ns() - start;
+}
+
 bool obs_source_audio_pending(const obs_source_t *source)
 {
 	if (!obs_source_valid(source, "obs_source_audio_pending"))
@@ -5662,6 +6841,15 @@ void obs_source_set_monitoring_type(obs_source_t *source,
 	source->monitoring_type = type;
 }
 
+uint64_t obs_source_get_monitoring_latency_ns(const obs_source_t *source)
+{
+	if (!obs_source_valid(source, "obs_source_get_monitoring_latency_ns"))
+		return 0;
+
+	return source->monitor ? audio_monitor_get_latency_ns(source->monitor)
+			       : 0;
+}
+
 enum obs_monitoring_type
 obs_source_get_monitoring_type(const obs_source_t *source)
 {
@@ -5685,6 +6873,56 @@ bool obs_source_async_unbuffered(const obs_source_t *source)
 		       : false;
 }
 
+void obs_source_set_async_jitter_buffer(obs_source_t *source, float percentile)
+{
+	if (!obs_source_valid(source, "obs_source_set_async_jitter_buffer"))
+		return;
+
+	if (percentile < 0.0f)
+		percentile = 0.0f;
+	else if (percentile > 100.0f)
+		percentile = 100.0f;
+
+	pthread_mutex_lock(&source->async_mutex);
+
+	bool was_enabled = source->async_jitter_percentile > 0.0f;
+	source->async_jitter_percentile = percentile;
+
+	if (was_enabled != (percentile > 0.0f)) {
+		da_resize(source->async_jitter_samples, 0);
+		source->async_jitter_pos = 0;
+		source->async_jitter_updates = 0;
+		source->async_jitter_ref_set = false;
+		source->async_jitter_target = 0;
+		source->async_jitter_delay = 0;
+		source->async_jitter_frames = 0;
+		source->async_jitter_audio_time = 0;
+		source->async_jitter_sys_ts = 0;
+
+		/* recreates the resampler on the next audio packet */
+		source->sample_info.samples_per_sec = 0;
+	}
+
+	pthread_mutex_unlock(&source->async_mutex);
+}
+
+float obs_source_async_jitter_buffer(const obs_source_t *source)
+{
+	return obs_source_valid(source, "obs_source_async_jitter_buffer")
+		       ? source->async_jitter_percentile
+		       : 0.0f;
+}
+
+uint64_t obs_source_get_async_jitter_depth(const obs_source_t *source)
+{
+	if (!obs_source_valid(source, "obs_source_get_async_jitter_depth"))
+		return 0;
+	if (source->async_jitter_percentile <= 0.0f)
+		return 0;
+
+	return (uint64_t)source->async_jitter_delay;
+}
+
 obs_data_t *obs_source_get_private_settings(obs_source_t *source)
 {
 	if (!obs_ptr_valid(source, "obs_source_get_private_settings"))
@@ -5700,12 +6938,8 @@ void obs_source_set_async_decoupled(obs_source_t *source, bool decouple)
 		return;
 
 	source->async_decoupled = decouple;
-	if (decouple) {
-		pthread_mutex_lock(&source->audio_buf_mutex);
-		source->timing_set = false;
-		reset_audio_data(source, 0);
-		pthread_mutex_unlock(&source->audio_buf_mutex);
-	}
+	if (decouple)
+		reset_audio(source, 0, 0, false);
 }
 
 bool obs_source_async_decoupled(const obs_source_t *source)
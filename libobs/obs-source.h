@@ -203,6 +203,20 @@ enum obs_media_state {
  */
 #define OBS_SOURCE_CAP_DONT_SHOW_PROPERTIES (1 << 16)
 
+/**
+ * Source (or filter) output only changes when its settings change or when it
+ * calls obs_source_content_changed, which allows scenes to reuse the last
+ * rendered output of the source.
+ */
+#define OBS_SOURCE_STATIC_VIDEO (1 << 17)
+
+/**
+ * Source type's video_tick and update callbacks may be called off of the
+ * graphics thread, in parallel with those of other sources.  They must use
+ * obs_enter_graphics/obs_leave_graphics for any graphics calls.
+ */
+#define OBS_SOURCE_PARALLEL_TICK (1 << 18)
+
 /** @} */
 
 typedef void (*obs_source_enum_proc_t)(obs_source_t *parent,
@@ -212,6 +226,33 @@ struct obs_source_audio_mix {
 	struct audio_output_data output[MAX_AUDIO_MIXES];
 };
 
+/**
+ * Per-pixel shader stage of a filter
+ *
+ * Adjacent filters that only change each pixel on its own can be drawn in
+ * a single pass instead of each rendering to its own texture.  The code
+ * defines a function "float4 $process(float4 rgba)" that takes and returns
+ * premultiplied color, along with the uniforms and helper functions it
+ * needs.  Every '$' is replaced with a prefix unique to the stage within
+ * the fused effect, so all of its identifiers should start with one.
+ */
+struct obs_pixel_stage {
+	/** Unique name of the stage, the same name must mean the same code */
+	const char *name;
+
+	/** Shader code of the stage */
+	const char *code;
+
+	/**
+	 * Sets the uniforms of the stage on the fused effect
+	 *
+	 * @param  data    Filter data
+	 * @param  effect  Fused effect
+	 * @param  prefix  Stage prefix, see obs_pixel_stage_get_param
+	 */
+	void (*set_params)(void *data, gs_effect_t *effect, const char *prefix);
+};
+
 /**
  * Source definition structure
  */
@@ -560,6 +601,33 @@ struct obs_source_info {
 	enum gs_color_space (*video_get_color_space)(
 		void *data, size_t count,
 		const enum gs_color_space *preferred_spaces);
+
+	/**
+	 * Returns the per-pixel stage the filter currently renders as, or
+	 * NULL if it can't be fused with other filters right now.  Only used
+	 * for SDR filters, rendering falls back to video_render otherwise.
+	 *
+	 * @param  data  Filter data
+	 * @return       The pixel stage of the filter
+	 */
+	const struct obs_pixel_stage *(*get_pixel_stage)(void *data);
+
+	/**
+	 * Called once the source has been hidden for longer than the
+	 * hibernation delay.  The source should free whatever it can rebuild
+	 * later, such as textures and decoded images.
+	 *
+	 * @param  data  Source data
+	 */
+	void (*hibernate)(void *data);
+
+	/**
+	 * Called before a hibernated source is shown or prefetched, to rebuild
+	 * what was freed in hibernate.
+	 *
+	 * @param  data  Source data
+	 */
+	void (*wake)(void *data);
 };
 
 EXPORT void obs_register_source_s(const struct obs_source_info *info,
@@ -17,6 +17,24 @@
 
 #include "obs-internal.h"
 
+/* encoders take turns on the shared texture, so let the ones that finish
+ * quickest go first rather than queue behind slower ones */
+static void sort_by_encode_time(obs_encoder_t **encoders, size_t num)
+{
+	for (size_t i = 1; i < num; i++) {
+		obs_encoder_t *encoder = encoders[i];
+		size_t j = i;
+
+		while (j > 0 &&
+		       encoders[j - 1]->encode_time_ns > encoder->encode_time_ns) {
+			encoders[j] = encoders[j - 1];
+			j--;
+		}
+
+		encoders[j] = encoder;
+	}
+}
+
 static void *gpu_encode_thread(struct obs_core_video_mix *video)
 {
 	uint64_t interval = video_output_get_frame_time(video->video);
@@ -25,6 +43,7 @@ static void *gpu_encode_thread(struct obs_core_video_mix *video)
 
 	da_init(encoders);
 
+	os_thread_role_t *role = os_set_thread_role(OS_THREAD_ROLE_ENCODE);
 	os_set_thread_name("obs gpu encode thread");
 
 	while (os_sem_wait(video->gpu_encode_semaphore) == 0) {
@@ -64,6 +83,8 @@ static void *gpu_encode_thread(struct obs_core_video_mix *video)
 
 		pthread_mutex_unlock(&video->gpu_encoder_mutex);
 
+		sort_by_encode_time(encoders.array, encoders.num);
+
 		/* -------------- */
 
 		for (size_t i = 0; i < encoders.num; i++) {
@@ -102,10 +123,21 @@ static void *gpu_encode_thread(struct obs_core_video_mix *video)
 			else
 				next_key++;
 
+			encoder->frame_flags =
+				tf.flags |
+				obs_encoder_take_keyframe_request(encoder);
+			encoder->frame_transition_progress =
+				tf.transition_progress;
+
+			uint64_t start = os_gettime_ns();
+
+			obs_heartbeat_begin(&encoder->encode_heartbeat);
 			success = encoder->info.encode_texture(
 				encoder->context.data, tf.handle,
 				encoder->cur_pts, lock_key, &next_key, &pkt,
 				&received);
+			obs_heartbeat_end(&encoder->encode_heartbeat);
+			obs_encoder_update_encode_time(encoder, start);
 			send_off_encoder_packet(encoder, success, received,
 						&pkt);
 
@@ -122,6 +154,8 @@ static void *gpu_encode_thread(struct obs_core_video_mix *video)
 
 		if (--tf.count) {
 			tf.timestamp += interval;
+			tf.flags &= ~VIDEO_FRAME_SCENE_CUT;
+			tf.flags |= VIDEO_FRAME_STATIC;
 			circlebuf_push_front(&video->gpu_encoder_queue, &tf,
 					     sizeof(tf));
 
@@ -144,6 +178,7 @@ static void *gpu_encode_thread(struct obs_core_video_mix *video)
 	}
 
 	da_free(encoders);
+	os_reset_thread_role(role);
 	blog(LOG_INFO, "Exit gpu encode thread");
 	return NULL;
 }
@@ -29,6 +29,144 @@
 #include <windows.h>
 #endif
 
+#define MAX_TICK_THREADS 4
+
+static inline bool tick_in_parallel(const struct obs_source *source)
+{
+	return (source->info.output_flags & OBS_SOURCE_PARALLEL_TICK) != 0;
+}
+
+/* workers (and the graphics thread) pull sources off of the shared job list
+ * until it's empty, so one slow source doesn't hold up the others */
+static void run_tick_jobs(struct obs_core_video *video)
+{
+	for (;;) {
+		struct obs_source *source = NULL;
+
+		pthread_mutex_lock(&video->tick_mutex);
+		if (video->tick_cursor < video->tick_jobs.num)
+			source = video->tick_jobs.array[video->tick_cursor++];
+		pthread_mutex_unlock(&video->tick_mutex);
+
+		if (!source)
+			break;
+
+		obs_source_video_tick(source, video->tick_seconds);
+
+		if (os_atomic_dec_long(&video->tick_remaining) == 0)
+			os_event_signal(video->tick_done);
+	}
+}
+
+static void *tick_thread(void *param)
+{
+	struct obs_core_video *video = param;
+	os_thread_role_t *role = os_set_thread_role(OS_THREAD_ROLE_RENDER);
+
+	os_set_thread_name("obs video tick thread");
+
+	while (os_sem_wait(video->tick_semaphore) == 0) {
+		if (os_atomic_load_bool(&video->tick_stop))
+			break;
+
+		run_tick_jobs(video);
+	}
+
+	os_reset_thread_role(role);
+	return NULL;
+}
+
+static bool init_tick_threads(struct obs_core_video *video)
+{
+	int num = os_get_logical_cores() - 1;
+	if (num > MAX_TICK_THREADS)
+		num = MAX_TICK_THREADS;
+	if (num < 1)
+		return false;
+
+	video->tick_stop = false;
+
+	if (os_sem_init(&video->tick_semaphore, 0) != 0)
+		return false;
+	if (os_event_init(&video->tick_done, OS_EVENT_TYPE_MANUAL) != 0)
+		return false;
+
+	for (int i = 0; i < num; i++) {
+		pthread_t thread;
+		if (pthread_create(&thread, NULL, tick_thread, video) != 0)
+			break;
+		da_push_back(video->tick_threads, &thread);
+	}
+
+	return video->tick_threads.num > 0;
+}
+
+void free_tick_threads(void)
+{
+	struct obs_core_video *video = &obs->video;
+
+	os_atomic_set_bool(&video->tick_stop, true);
+	for (size_t i = 0; i < video->tick_threads.num; i++)
+		os_sem_post(video->tick_semaphore);
+	for (size_t i = 0; i < video->tick_threads.num; i++)
+		pthread_join(video->tick_threads.array[i], NULL);
+	da_free(video->tick_threads);
+	da_free(video->tick_jobs);
+
+	if (video->tick_semaphore) {
+		os_sem_destroy(video->tick_semaphore);
+		video->tick_semaphore = NULL;
+	}
+	if (video->tick_done) {
+		os_event_destroy(video->tick_done);
+		video->tick_done = NULL;
+	}
+}
+
+static const char *tick_sources_parallel_name = "tick_sources_parallel";
+static void tick_sources_parallel(struct obs_core_video *video,
+				  struct obs_source **sources, size_t num,
+				  float seconds)
+{
+	if (!num)
+		return;
+
+	profile_start(tick_sources_parallel_name);
+
+	if (num > 1 && !video->tick_threads.num && !video->tick_semaphore)
+		init_tick_threads(video);
+
+	if (video->tick_threads.num) {
+		size_t wake = num - 1;
+		if (wake > video->tick_threads.num)
+			wake = video->tick_threads.num;
+
+		pthread_mutex_lock(&video->tick_mutex);
+		da_copy_array(video->tick_jobs, sources, num);
+		video->tick_cursor = 0;
+		video->tick_seconds = seconds;
+		os_atomic_set_long(&video->tick_remaining, (long)num);
+		os_event_reset(video->tick_done);
+		pthread_mutex_unlock(&video->tick_mutex);
+
+		for (size_t i = 0; i < wake; i++)
+			os_sem_post(video->tick_semaphore);
+
+		run_tick_jobs(video);
+		os_event_wait(video->tick_done);
+
+		pthread_mutex_lock(&video->tick_mutex);
+		da_resize(video->tick_jobs, 0);
+		video->tick_cursor = 0;
+		pthread_mutex_unlock(&video->tick_mutex);
+	} else {
+		for (size_t i = 0; i < num; i++)
+			obs_source_video_tick(sources[i], seconds);
+	}
+
+	profile_end(tick_sources_parallel_name);
+}
+
 static uint64_t tick_sources(uint64_t cur_time, uint64_t last_time)
 {
 	struct obs_core_data *data = &obs->data;
@@ -54,18 +192,47 @@ static uint64_t tick_sources(uint64_t cur_time, uint64_t last_time)
 
 	pthread_mutex_unlock(&obs->data.draw_callbacks_mutex);
 
+	/* ------------------------------------- */
+	/* tick thread-safe sources on the tick threads.  the sources mutex is
+	 * released while doing so, because a tick callback may need it */
+
+	DARRAY(struct obs_source *) parallel;
+	da_init(parallel);
+
+	pthread_mutex_lock(&data->sources_mutex);
+
+	struct obs_source *source = data->first_source;
+	while (source) {
+		if (tick_in_parallel(source)) {
+			struct obs_source *ref = obs_source_get_ref(source);
+			if (ref)
+				da_push_back(parallel, &ref);
+		}
+		source = (struct obs_source *)source->context.next;
+	}
+
+	pthread_mutex_unlock(&data->sources_mutex);
+
+	tick_sources_parallel(&obs->video, parallel.array, parallel.num,
+			      seconds);
+
+	for (size_t i = 0; i < parallel.num; i++)
+		obs_source_release(parallel.array[i]);
+	da_free(parallel);
+
 	/* ------------------------------------- */
 	/* call the tick function of each source */
 
 	pthread_mutex_lock(&data->sources_mutex);
 
-	struct obs_source *source = obs_source_get_ref(data->first_source);
+	source = obs_source_get_ref(data->first_source);
 
 	while (source) {
 		struct obs_source *next_source = obs_source_get_ref(
 			(struct obs_source *)source->context.next);
 
-		obs_source_video_tick(source, seconds);
+		if (!tick_in_parallel(source))
+			obs_source_video_tick(source, seconds);
 		obs_source_release(source);
 
 		source = next_source;
@@ -88,6 +255,8 @@ static inline void render_displays(void)
 
 	gs_enter_context(obs->video.graphics);
 
+	gs_timer_t *timer = obs_gpu_timing_begin_stage(OBS_GPU_STAGE_DISPLAYS);
+
 	/* render extra displays/swaps */
 	pthread_mutex_lock(&obs->data.displays_mutex);
 
@@ -99,6 +268,8 @@ static inline void render_displays(void)
 
 	pthread_mutex_unlock(&obs->data.displays_mutex);
 
+	gs_timer_end(timer);
+
 	gs_leave_context();
 }
 
@@ -124,12 +295,14 @@ static inline void unmap_last_surface(struct obs_core_video_mix *video)
 static const char *render_main_texture_name = "render_main_texture";
 static inline void render_main_texture(struct obs_core_video_mix *video)
 {
-	uint32_t base_width = obs->video.base_width;
-	uint32_t base_height = obs->video.base_height;
+	uint32_t base_width = video->base_width;
+	uint32_t base_height = video->base_height;
 
 	profile_start(render_main_texture_name);
 	GS_DEBUG_MARKER_BEGIN(GS_DEBUG_COLOR_MAIN_TEXTURE,
 			      render_main_texture_name);
+	gs_timer_t *timer =
+		obs_gpu_timing_begin_stage(OBS_GPU_STAGE_MAIN_TEXTURE);
 
 	struct vec4 clear_color;
 	vec4_set(&clear_color, 0.0f, 0.0f, 0.0f, 0.0f);
@@ -140,21 +313,26 @@ static inline void render_main_texture(struct obs_core_video_mix *video)
 
 	set_render_size(base_width, base_height);
 
-	pthread_mutex_lock(&obs->data.draw_callbacks_mutex);
+	/* main render callbacks draw in main canvas coordinates */
+	if (!video->canvas) {
+		pthread_mutex_lock(&obs->data.draw_callbacks_mutex);
 
-	for (size_t i = obs->data.draw_callbacks.num; i > 0; i--) {
-		struct draw_callback *callback;
-		callback = obs->data.draw_callbacks.array + (i - 1);
+		for (size_t i = obs->data.draw_callbacks.num; i > 0; i--) {
+			struct draw_callback *callback;
+			callback = obs->data.draw_callbacks.array + (i - 1);
 
-		callback->draw(callback->param, base_width, base_height);
-	}
+			callback->draw(callback->param, base_width,
+				       base_height);
+		}
 
-	pthread_mutex_unlock(&obs->data.draw_callbacks_mutex);
+		pthread_mutex_unlock(&obs->data.draw_callbacks_mutex);
+	}
 
 	obs_view_render(video->view);
 
 	video->texture_rendered = true;
 
+	gs_timer_end(timer);
 	GS_DEBUG_MARKER_END();
 	profile_end(render_main_texture_name);
 }
@@ -169,8 +347,8 @@ get_scale_effect_internal(struct obs_core_video_mix *mix)
 	/* if the dimension is under half the size of the original image,
 	 * bicubic/lanczos can't sample enough pixels to create an accurate
 	 * image, so use the bilinear low resolution effect instead */
-	if (info->width < (video->base_width / 2) &&
-	    info->height < (video->base_height / 2)) {
+	if (info->width < (mix->base_width / 2) &&
+	    info->height < (mix->base_height / 2)) {
 		return video->bilinear_lowres_effect;
 	}
 
@@ -188,11 +366,11 @@ get_scale_effect_internal(struct obs_core_video_mix *mix)
 	return video->bicubic_effect;
 }
 
-static inline bool resolution_close(struct obs_core_video *video,
+static inline bool resolution_close(struct obs_core_video_mix *mix,
 				    uint32_t width, uint32_t height)
 {
-	long width_cmp = (long)video->base_width - (long)width;
-	long height_cmp = (long)video->base_height - (long)height;
+	long width_cmp = (long)mix->base_width - (long)width;
+	long height_cmp = (long)mix->base_height - (long)height;
 
 	return labs(width_cmp) <= 16 && labs(height_cmp) <= 16;
 }
@@ -202,7 +380,7 @@ static inline gs_effect_t *get_scale_effect(struct obs_core_video_mix *mix,
 {
 	struct obs_core_video *video = &obs->video;
 
-	if (resolution_close(video, width, height)) {
+	if (resolution_close(mix, width, height)) {
 		return video->default_effect;
 	} else {
 		/* if the scale method couldn't be loaded, use either bicubic
@@ -221,7 +399,9 @@ static inline gs_texture_t *
 render_output_texture(struct obs_core_video_mix *mix)
 {
 	struct obs_core_video *video = &obs->video;
-	gs_texture_t *texture = mix->render_texture;
+	gs_texture_t *texture = mix->scale_source
+					? mix->scale_source->render_texture
+					: mix->render_texture;
 	gs_texture_t *target = mix->output_texture;
 	uint32_t width = gs_texture_get_width(target);
 	uint32_t height = gs_texture_get_height(target);
@@ -232,14 +412,15 @@ render_output_texture(struct obs_core_video_mix *mix)
 	if (video_output_get_format(mix->video) == VIDEO_FORMAT_RGBA) {
 		tech = gs_effect_get_technique(effect, "DrawAlphaDivide");
 	} else {
-		if ((width == video->base_width) &&
-		    (height == video->base_height))
+		if ((width == mix->base_width) && (height == mix->base_height))
 			return texture;
 
 		tech = gs_effect_get_technique(effect, "Draw");
 	}
 
 	profile_start(render_output_texture_name);
+	gs_timer_t *timer =
+		obs_gpu_timing_begin_stage(OBS_GPU_STAGE_OUTPUT_TEXTURE);
 
 	gs_eparam_t *image = gs_effect_get_param_by_name(effect, "image");
 	gs_eparam_t *bres =
@@ -253,15 +434,15 @@ render_output_texture(struct obs_core_video_mix *mix)
 
 	if (bres) {
 		struct vec2 base;
-		vec2_set(&base, (float)video->base_width,
-			 (float)video->base_height);
+		vec2_set(&base, (float)mix->base_width,
+			 (float)mix->base_height);
 		gs_effect_set_vec2(bres, &base);
 	}
 
 	if (bres_i) {
 		struct vec2 base_i;
-		vec2_set(&base_i, 1.0f / (float)video->base_width,
-			 1.0f / (float)video->base_height);
+		vec2_set(&base_i, 1.0f / (float)mix->base_width,
+			 1.0f / (float)mix->base_height);
 		gs_effect_set_vec2(bres_i, &base_i);
 	}
 
@@ -279,6 +460,7 @@ render_output_texture(struct obs_core_video_mix *mix)
 	gs_enable_blending(true);
 	gs_enable_framebuffer_srgb(false);
 
+	gs_timer_end(timer);
 	profile_end(render_output_texture_name);
 
 	return target;
@@ -310,6 +492,8 @@ static void render_convert_texture(struct obs_core_video_mix *video,
 				   gs_texture_t *texture)
 {
 	profile_start(render_convert_texture_name);
+	gs_timer_t *timer =
+		obs_gpu_timing_begin_stage(OBS_GPU_STAGE_CONVERT_TEXTURE);
 
 	gs_effect_t *effect = obs->video.conversion_effect;
 	gs_eparam_t *color_vec0 =
@@ -383,9 +567,21 @@ static void render_convert_texture(struct obs_core_video_mix *video,
 
 	video->texture_converted = true;
 
+	gs_timer_end(timer);
 	profile_end(render_convert_texture_name);
 }
 
+static const char *wait_video_readback_name = "wait_video_readback";
+static inline void wait_video_readback(struct obs_core_video_mix *video)
+{
+	if (!video->readback_thread_initialized)
+		return;
+
+	profile_start(wait_video_readback_name);
+	os_event_wait(video->readback_idle);
+	profile_end(wait_video_readback_name);
+}
+
 static const char *stage_output_texture_name = "stage_output_texture";
 static inline void
 stage_output_texture(struct obs_core_video_mix *video, int cur_texture,
@@ -395,8 +591,14 @@ stage_output_texture(struct obs_core_video_mix *video, int cur_texture,
 {
 	profile_start(stage_output_texture_name);
 
+	/* the readback thread may still be copying out of the mapped
+	 * surfaces from the last frame */
+	wait_video_readback(video);
 	unmap_last_surface(video);
 
+	gs_timer_t *timer =
+		obs_gpu_timing_begin_stage(OBS_GPU_STAGE_STAGE_TEXTURE);
+
 	if (!video->gpu_conversion) {
 		gs_stagesurf_t *copy = copy_surfaces[0];
 		if (copy)
@@ -421,6 +623,7 @@ stage_output_texture(struct obs_core_video_mix *video, int cur_texture,
 		video->textures_copied[cur_texture] = true;
 	}
 
+	gs_timer_end(timer);
 	profile_end(stage_output_texture_name);
 }
 
@@ -475,6 +678,8 @@ static inline bool queue_frame(struct obs_core_video_mix *video,
 
 	tf.count = 1;
 	tf.timestamp = vframe_info->timestamp;
+	tf.flags = vframe_info->flags;
+	tf.transition_progress = vframe_info->transition_progress;
 	tf.released = true;
 	tf.handle = gs_texture_get_shared_handle(tf.tex);
 	gs_texture_release_sync(tf.tex, ++tf.lock_key);
@@ -519,7 +724,18 @@ end:
 }
 #endif
 
+static const char *copy_main_texture_name = "copy_main_texture";
+static inline void copy_main_texture(struct obs_core_video_mix *video,
+				     struct obs_core_video_mix *shared)
+{
+	profile_start(copy_main_texture_name);
+	gs_copy_texture(video->render_texture, shared->render_texture);
+	video->texture_rendered = true;
+	profile_end(copy_main_texture_name);
+}
+
 static inline void render_video(struct obs_core_video_mix *video,
+				struct obs_core_video_mix *shared,
 				bool raw_active, const bool gpu_active,
 				int cur_texture)
 {
@@ -528,7 +744,10 @@ static inline void render_video(struct obs_core_video_mix *video,
 	gs_enable_depth_test(false);
 	gs_set_cull_mode(GS_NEITHER);
 
-	render_main_texture(video);
+	if (shared)
+		copy_main_texture(video, shared);
+	else if (!video->scaled_mix)
+		render_main_texture(video);
 
 	if (raw_active || gpu_active) {
 		gs_texture_t *const *convert_textures = video->convert_textures;
@@ -569,24 +788,33 @@ static inline void render_video(struct obs_core_video_mix *video,
 	gs_end_scene();
 }
 
+static const char *download_frame_map_name = "gs_stagesurface_map";
 static inline bool download_frame(struct obs_core_video_mix *video,
 				  int prev_texture, struct video_data *frame)
 {
+	bool success = true;
+
 	if (!video->textures_copied[prev_texture])
 		return false;
 
+	profile_start(download_frame_map_name);
+
 	for (int channel = 0; channel < NUM_CHANNELS; ++channel) {
 		gs_stagesurf_t *surface =
 			video->active_copy_surfaces[prev_texture][channel];
 		if (surface) {
 			if (!gs_stagesurface_map(surface, &frame->data[channel],
-						 &frame->linesize[channel]))
-				return false;
+						 &frame->linesize[channel])) {
+				success = false;
+				break;
+			}
 
 			video->mapped_surfaces[channel] = surface;
 		}
 	}
-	return true;
+
+	profile_end(download_frame_map_name);
+	return success;
 }
 
 static const uint8_t *set_gpu_converted_plane(uint32_t width, uint32_t height,
@@ -785,6 +1013,9 @@ static inline void output_video_data(struct obs_core_video_mix *video,
 	locked = video_output_lock_frame(video->video, &output_frame, count,
 					 input_frame->timestamp);
 	if (locked) {
+		video_output_set_frame_flags(video->video, input_frame->flags,
+					     input_frame->transition_progress);
+
 		if (video->gpu_conversion) {
 			set_gpu_converted_data(&output_frame, input_frame,
 					       info);
@@ -796,15 +1027,167 @@ static inline void output_video_data(struct obs_core_video_mix *video,
 	}
 }
 
-static inline void video_sleep(struct obs_core_video *video, uint64_t *p_time,
-			       uint64_t interval_ns)
+static void *video_readback_thread(void *param)
+{
+	struct obs_core_video_mix *video = param;
+
+	os_set_thread_name("obs video readback thread");
+
+	while (os_sem_wait(video->readback_semaphore) == 0) {
+		if (os_atomic_load_bool(&video->readback_stop))
+			break;
+
+		output_video_data(video, &video->readback_frame,
+				  video->readback_count);
+
+		os_event_signal(video->readback_idle);
+	}
+
+	os_event_signal(video->readback_idle);
+	return NULL;
+}
+
+bool init_video_readback(struct obs_core_video_mix *video)
+{
+	video->readback_stop = false;
+
+	if (os_sem_init(&video->readback_semaphore, 0) != 0)
+		goto fail;
+	if (os_event_init(&video->readback_idle, OS_EVENT_TYPE_MANUAL) != 0)
+		goto fail;
+
+	os_event_signal(video->readback_idle);
+
+	if (pthread_create(&video->readback_thread, NULL,
+			   video_readback_thread, video) != 0)
+		goto fail;
+
+	video->readback_thread_initialized = true;
+	return true;
+
+fail:
+	free_video_readback(video);
+	return false;
+}
+
+void free_video_readback(struct obs_core_video_mix *video)
+{
+	if (video->readback_thread_initialized) {
+		os_atomic_set_bool(&video->readback_stop, true);
+		os_sem_post(video->readback_semaphore);
+		pthread_join(video->readback_thread, NULL);
+		video->readback_thread_initialized = false;
+	}
+
+	if (video->readback_semaphore) {
+		os_sem_destroy(video->readback_semaphore);
+		video->readback_semaphore = NULL;
+	}
+	if (video->readback_idle) {
+		os_event_destroy(video->readback_idle);
+		video->readback_idle = NULL;
+	}
+}
+
+static void release_zero_copy_frame(void *param)
+{
+	struct obs_core_video_mix *video = param;
+	os_event_signal(video->readback_idle);
+}
+
+static bool get_zero_copy_planes(struct obs_core_video_mix *video,
+				 struct video_data *frame)
+{
+	const struct video_output_info *info =
+		video_output_get_info(video->video);
+
+	if (!video->gpu_conversion)
+		return info->format == VIDEO_FORMAT_RGBA ||
+		       info->format == VIDEO_FORMAT_BGRA ||
+		       info->format == VIDEO_FORMAT_BGRX;
+
+	switch (info->format) {
+	case VIDEO_FORMAT_NV12:
+	case VIDEO_FORMAT_P010:
+		/* single surface with the chroma plane directly after luma */
+		if (!frame->linesize[1]) {
+			frame->data[1] = frame->data[0] +
+					 frame->linesize[0] * info->height;
+			frame->linesize[1] = frame->linesize[0];
+		}
+		return true;
+	case VIDEO_FORMAT_I420:
+	case VIDEO_FORMAT_I444:
+	case VIDEO_FORMAT_I010:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static inline bool output_zero_copy_frame(struct obs_core_video_mix *video,
+					  struct video_data *frame, int count)
+{
+	struct video_data planes = *frame;
+
+	if (!get_zero_copy_planes(video, &planes))
+		return false;
+
+	/* the surfaces stay mapped until video-io releases the frame */
+	os_event_reset(video->readback_idle);
+	if (!video_output_lock_external_frame(video->video, &planes, count,
+					      release_zero_copy_frame, video))
+		os_event_signal(video->readback_idle);
+	return true;
+}
+
+/* hands the mapped frame off to the readback thread, which does the copy
+ * into the video output while the graphics thread moves on to the next
+ * frame.  the surfaces stay mapped until the next stage_output_texture. */
+static inline void queue_video_readback(struct obs_core_video_mix *video,
+					struct video_data *frame, int count)
+{
+	if (!video->readback_thread_initialized) {
+		output_video_data(video, frame, count);
+		return;
+	}
+
+	if (video->zero_copy_readback &&
+	    output_zero_copy_frame(video, frame, count))
+		return;
+
+	video->readback_frame = *frame;
+	video->readback_count = count;
+
+	os_event_reset(video->readback_idle);
+	os_sem_post(video->readback_semaphore);
+}
+
+/* frames are paced against a fixed grid of deadlines (video_time advances by
+ * exactly one interval per frame), so lateness in waking up never shifts the
+ * next deadline.  returns how late the thread woke up past the deadline. */
+/* extra canvases (and mixes scaling them) only have frame info queued when
+ * they rendered on this tick */
+static inline int get_mix_frame_count(const struct obs_core_video_mix *mix,
+				      int count)
+{
+	if (mix->scaled_mix && mix->scale_source)
+		mix = mix->scale_source;
+	return mix->canvas ? mix->canvas_frame_count : count;
+}
+
+static inline uint64_t video_sleep(struct obs_core_video *video,
+				   uint64_t *p_time, uint64_t interval_ns)
 {
 	struct obs_vframe_info vframe_info;
 	uint64_t cur_time = *p_time;
 	uint64_t t = cur_time + interval_ns;
+	uint64_t wake_delay = 0;
 	int count;
 
 	if (os_sleepto_ns(t)) {
+		const uint64_t now = os_gettime_ns();
+		wake_delay = now > t ? now - t : 0;
 		*p_time = t;
 		count = 1;
 	} else if (interval_ns > 0) {
@@ -818,20 +1201,31 @@ static inline void video_sleep(struct obs_core_video *video, uint64_t *p_time,
 		*p_time = cur_time + interval_ns * count;
 	} else {
 		*p_time = cur_time;
-		return;
+		return 0;
 	}
 
 	video->total_frames += count;
 	video->lagged_frames += count - 1;
 
+	obs_metric_add(obs->metrics.frames_rendered, count);
+	obs_metric_add(obs->metrics.frames_lagged, count - 1);
+
 	vframe_info.timestamp = cur_time;
-	vframe_info.count = count;
 
 	pthread_mutex_lock(&obs->video.mixes_mutex);
 	for (size_t i = 0, num = obs->video.mixes.num; i < num; i++) {
 		struct obs_core_video_mix *video = obs->video.mixes.array[i];
 		bool raw_active = video->raw_was_active;
 		bool gpu_active = video->gpu_was_active;
+		int mix_count = get_mix_frame_count(video, count);
+
+		if (!mix_count)
+			continue;
+
+		vframe_info.count = mix_count;
+		vframe_info.flags = video->frame_flags;
+		vframe_info.transition_progress =
+			video->frame_transition_progress;
 
 		if (raw_active)
 			circlebuf_push_back(&video->vframe_info_buffer,
@@ -841,6 +1235,122 @@ static inline void video_sleep(struct obs_core_video *video, uint64_t *p_time,
 					    &vframe_info, sizeof(vframe_info));
 	}
 	pthread_mutex_unlock(&obs->video.mixes_mutex);
+
+	return wake_delay;
+}
+
+static bool channels_render_same_in_modes(enum obs_video_rendering_mode a,
+					  enum obs_video_rendering_mode b)
+{
+	struct obs_view *view = &obs->data.main_view;
+	bool same = true;
+
+	pthread_mutex_lock(&view->channels_mutex);
+	for (size_t i = 0; same && i < MAX_CHANNELS; i++)
+		same = obs_source_renders_same_in_modes(view->channels[i], a,
+							b);
+	pthread_mutex_unlock(&view->channels_mutex);
+
+	return same;
+}
+
+/* with multiple rendering, the stream and recording views share the channel
+ * sources of the main view and only differ by per-item visibility.  if the
+ * visibility works out the same as that of a mix that has already been
+ * rendered this frame, its main texture can be reused as-is. */
+static struct obs_core_video_mix *
+find_shared_mix(struct obs_core_video_mix *video,
+		enum obs_video_rendering_mode mode)
+{
+	struct obs_core_video_mix *candidates[] = {obs->video.main_mix,
+						   obs->video.stream_mix};
+	enum obs_video_rendering_mode modes[] = {OBS_MAIN_VIDEO_RENDERING,
+						 OBS_STREAMING_VIDEO_RENDERING};
+
+	for (size_t i = 0; i < 2; i++) {
+		struct obs_core_video_mix *mix = candidates[i];
+
+		if (!mix || mix == video)
+			break;
+		if (!mix->texture_rendered || !mix->render_texture)
+			continue;
+		if (channels_render_same_in_modes(modes[i], mode))
+			return mix;
+	}
+
+	return NULL;
+}
+
+/* works out how the frame the mix just rendered relates to the previous one
+ * from the state of the transition in its first channel.  switching sources
+ * without any transitioning frames in between counts as a cut. */
+static void update_frame_flags(struct obs_core_video_mix *video)
+{
+	struct obs_view *view = video->view;
+	const obs_source_t *program = NULL;
+	bool transitioning = false;
+	obs_source_t *source;
+	float t = 0.0f;
+	uint32_t flags = 0;
+
+	if (video->scaled_mix) {
+		video->frame_flags = video->scale_source->frame_flags;
+		video->frame_transition_progress =
+			video->scale_source->frame_transition_progress;
+		return;
+	}
+
+	pthread_mutex_lock(&view->channels_mutex);
+	source = view->channels[0];
+	if (source && source->info.type == OBS_SOURCE_TYPE_TRANSITION)
+		transitioning =
+			obs_transition_get_frame_state(source, &t, &program);
+	else
+		program = source;
+	pthread_mutex_unlock(&view->channels_mutex);
+
+	if (transitioning)
+		flags |= VIDEO_FRAME_TRANSITION;
+	else if (!video->last_transitioning &&
+		 program != video->last_program_source)
+		flags |= VIDEO_FRAME_SCENE_CUT;
+
+	video->frame_flags = flags;
+	video->frame_transition_progress = t;
+	video->last_program_source = program;
+	video->last_transitioning = transitioning;
+}
+
+/* a scaled mix that has nothing to scale still has frame info queued for it,
+ * which would otherwise just pile up */
+static void drop_frame_info(struct obs_core_video_mix *video)
+{
+	struct obs_vframe_info vframe_info;
+
+	if (video->raw_was_active && video->vframe_info_buffer.size)
+		circlebuf_pop_front(&video->vframe_info_buffer, &vframe_info,
+				    sizeof(vframe_info));
+}
+
+/* main loop ticks rarely line up exactly with a canvas's own frame times, so
+ * a frame counts as due up to half a main frame early.  canvas frames the
+ * main loop skipped over are submitted as repeats, like lagged frames. */
+static bool canvas_frame_due(struct obs_core_video_mix *video)
+{
+	const uint64_t t =
+		obs->video.video_time + obs->video.video_half_frame_interval_ns;
+	int count = 0;
+
+	if (!video->canvas_next_time)
+		video->canvas_next_time = obs->video.video_time;
+
+	while (video->canvas_next_time <= t) {
+		video->canvas_next_time += video->canvas_interval_ns;
+		count++;
+	}
+
+	video->canvas_frame_count = count;
+	return count > 0;
 }
 
 static const char *output_frame_gs_context_name = "gs_context(video->graphics)";
@@ -850,7 +1360,24 @@ static const char *output_frame_gs_flush_name = "gs_flush";
 static const char *output_frame_output_video_data_name = "output_video_data";
 static inline void output_frame(struct obs_core_video_mix *video)
 {
-	if (obs_get_multiple_rendering()) {
+	struct obs_core_video_mix *shared = NULL;
+
+	if (video->scaled_mix) {
+		/* mixes are rendered in order, so the source mix has already
+		 * been rendered by now if it's going to be */
+		if (!video->scale_source ||
+		    !video->scale_source->texture_rendered) {
+			drop_frame_info(video);
+			return;
+		}
+		if (video->scale_source->canvas &&
+		    !video->scale_source->canvas_frame_count)
+			return;
+	} else if (video->canvas) {
+		if (!canvas_frame_due(video))
+			return;
+		obs_set_video_rendering_mode(OBS_MAIN_VIDEO_RENDERING);
+	} else if (obs_get_multiple_rendering()) {
 		if (video == obs->video.main_mix)
 			obs_set_video_rendering_mode(OBS_MAIN_VIDEO_RENDERING);
 		else if (video == obs->video.stream_mix)
@@ -861,6 +1388,10 @@ static inline void output_frame(struct obs_core_video_mix *video)
 				OBS_RECORDING_VIDEO_RENDERING);
 		else
 			return;
+
+		if (video != obs->video.main_mix)
+			shared = find_shared_mix(
+				video, obs_get_video_rendering_mode());
 	} else {
 		if (video == obs->video.stream_mix ||
 		    video == obs->video.record_mix)
@@ -872,9 +1403,10 @@ static inline void output_frame(struct obs_core_video_mix *video)
 	const bool raw_active = video->raw_was_active;
 	const bool gpu_active = video->gpu_was_active;
 
+	/* the oldest staged surface is the one that will be overwritten next,
+	 * which gives the GPU (num_textures - 1) frames to finish the copy */
 	int cur_texture = video->cur_texture;
-	int prev_texture = cur_texture == 0 ? NUM_TEXTURES - 1
-					    : cur_texture - 1;
+	int prev_texture = (cur_texture + 1) % (int)video->num_textures;
 	struct video_data frame;
 	bool frame_ready = 0;
 
@@ -886,7 +1418,7 @@ static inline void output_frame(struct obs_core_video_mix *video)
 	profile_start(output_frame_render_video_name);
 	GS_DEBUG_MARKER_BEGIN(GS_DEBUG_COLOR_RENDER_VIDEO,
 			      output_frame_render_video_name);
-	render_video(video, raw_active, gpu_active, cur_texture);
+	render_video(video, shared, raw_active, gpu_active, cur_texture);
 	GS_DEBUG_MARKER_END();
 	profile_end(output_frame_render_video_name);
 
@@ -903,30 +1435,47 @@ static inline void output_frame(struct obs_core_video_mix *video)
 	gs_leave_context();
 	profile_end(output_frame_gs_context_name);
 
+	if (raw_active || gpu_active)
+		update_frame_flags(video);
+
 	if (raw_active && frame_ready) {
 		struct obs_vframe_info vframe_info;
 		circlebuf_pop_front(&video->vframe_info_buffer, &vframe_info,
 				    sizeof(vframe_info));
 
 		frame.timestamp = vframe_info.timestamp;
+		frame.flags = vframe_info.flags;
+		frame.transition_progress = vframe_info.transition_progress;
 		profile_start(output_frame_output_video_data_name);
-		output_video_data(video, &frame, vframe_info.count);
+		queue_video_readback(video, &frame, vframe_info.count);
 		profile_end(output_frame_output_video_data_name);
 	}
 
-	if (++video->cur_texture == NUM_TEXTURES)
+	if (++video->cur_texture == (int)video->num_textures)
 		video->cur_texture = 0;
 }
 
+static void clear_scale_source(struct obs_core_video_mix *source)
+{
+	for (size_t i = 0; i < obs->video.mixes.num; i++) {
+		struct obs_core_video_mix *mix = obs->video.mixes.array[i];
+		if (mix && mix->scale_source == source)
+			mix->scale_source = NULL;
+	}
+}
+
 static inline void output_frames(void)
 {
 	pthread_mutex_lock(&obs->video.mixes_mutex);
 	for (size_t i = 0, num = obs->video.mixes.num; i < num; i++) {
 		struct obs_core_video_mix *mix = obs->video.mixes.array[i];
-		if (mix->view) {
+		bool keep = mix->scaled_mix ? !mix->scale_removed : !!mix->view;
+
+		if (keep) {
 			output_frame(mix);
 		} else {
 			obs->video.mixes.array[i] = NULL;
+			clear_scale_source(mix);
 			obs_free_video_mix(mix);
 			da_erase(obs->video.mixes, i);
 			i--;
@@ -948,8 +1497,11 @@ static void clear_base_frame_data(struct obs_core_video_mix *video)
 
 static void clear_raw_frame_data(struct obs_core_video_mix *video)
 {
-	memset(video->textures_copied, 0, sizeof(video->textures_copied));
+	memset(video->textures_copied, 0,
+	       sizeof(*video->textures_copied) * video->num_textures);
 	circlebuf_free(&video->vframe_info_buffer);
+	circlebuf_reserve(&video->vframe_info_buffer,
+			  sizeof(struct obs_vframe_info) * video->num_textures);
 }
 
 #ifdef _WIN32
@@ -959,6 +1511,55 @@ static void clear_gpu_frame_data(struct obs_core_video_mix *video)
 }
 #endif
 
+struct deferred_gs_object {
+	enum obs_gs_object_type type;
+	void *obj;
+};
+
+static pthread_mutex_t deferred_gs_mutex = PTHREAD_MUTEX_INITIALIZER;
+static DARRAY(struct deferred_gs_object) deferred_gs_objects;
+
+void obs_defer_gs_destroy(enum obs_gs_object_type type, void *obj)
+{
+	struct deferred_gs_object item = {type, obj};
+
+	if (!obj)
+		return;
+
+	pthread_mutex_lock(&deferred_gs_mutex);
+	da_push_back(deferred_gs_objects, &item);
+	pthread_mutex_unlock(&deferred_gs_mutex);
+}
+
+/* must be called within the graphics context */
+void obs_free_deferred_gs_objects(void)
+{
+	DARRAY(struct deferred_gs_object) objects;
+
+	pthread_mutex_lock(&deferred_gs_mutex);
+	objects.da = deferred_gs_objects.da;
+	da_init(deferred_gs_objects);
+	pthread_mutex_unlock(&deferred_gs_mutex);
+
+	for (size_t i = 0; i < objects.num; i++) {
+		struct deferred_gs_object *item = &objects.array[i];
+
+		switch (item->type) {
+		case OBS_GS_MAPPED_TEXTURE:
+			gs_texture_unmap(item->obj);
+			/* fall through */
+		case OBS_GS_TEXTURE:
+			gs_texture_destroy(item->obj);
+			break;
+		case OBS_GS_TEXRENDER:
+			gs_texrender_destroy(item->obj);
+			break;
+		}
+	}
+
+	da_free(objects);
+}
+
 extern THREAD_LOCAL bool is_graphics_thread;
 
 static void execute_graphics_tasks(void)
@@ -1100,6 +1701,32 @@ static inline void update_active_states(void)
 	pthread_mutex_unlock(&obs->video.mixes_mutex);
 }
 
+/* decides whether this frame can be rendered in 8-bit sRGB throughout,
+ * going by what was rendered in the previous one */
+static void update_sdr_only(void)
+{
+	struct obs_core_video *video = &obs->video;
+	bool hdr_content = os_atomic_exchange_bool(&video->hdr_content, false);
+	bool sdr_output = true;
+	bool sdr_only;
+
+	pthread_mutex_lock(&video->mixes_mutex);
+	for (size_t i = 0, num = video->mixes.num; i < num; i++) {
+		if (video->mixes.array[i]->render_space != GS_CS_SRGB) {
+			sdr_output = false;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&video->mixes_mutex);
+
+	sdr_only = sdr_output && !hdr_content;
+	if (video->sdr_only != sdr_only) {
+		blog(LOG_DEBUG, "SDR-only rendering %s",
+		     sdr_only ? "enabled" : "disabled");
+		video->sdr_only = sdr_only;
+	}
+}
+
 static inline bool stop_requested(void)
 {
 	bool success = true;
@@ -1122,7 +1749,10 @@ bool obs_graphics_thread_loop(struct obs_graphics_context *context)
 	uint64_t frame_start = os_gettime_ns();
 	uint64_t frame_time_ns;
 
+	obs_heartbeat_begin(&obs->video.graphics_heartbeat);
+
 	update_active_states();
+	update_sdr_only();
 
 	profile_start(context->video_thread_name);
 
@@ -1130,6 +1760,8 @@ bool obs_graphics_thread_loop(struct obs_graphics_context *context)
 	gs_begin_frame();
 	gs_leave_context();
 
+	obs_gpu_timing_begin_frame();
+
 	profile_start(tick_sources_name);
 	context->last_time =
 		tick_sources(obs->video.video_time, context->last_time);
@@ -1151,15 +1783,26 @@ bool obs_graphics_thread_loop(struct obs_graphics_context *context)
 	render_displays();
 	profile_end(render_displays_name);
 
+	gs_enter_context(obs->video.graphics);
+	obs_process_screenshots();
+	obs_free_deferred_gs_objects();
+	gs_leave_context();
+
+	obs_gpu_timing_end_frame();
+
 	execute_graphics_tasks();
 
+	obs_heartbeat_end(&obs->video.graphics_heartbeat);
+
 	frame_time_ns = os_gettime_ns() - frame_start;
 
 	profile_end(context->video_thread_name);
 
 	profile_reenable_thread();
 
-	video_sleep(&obs->video, &obs->video.video_time, context->interval);
+	context->wake_delay_total_ns += video_sleep(
+		&obs->video, &obs->video.video_time, context->interval);
+	context->wake_total_frames++;
 
 	context->frame_time_total_ns += frame_time_ns;
 	context->fps_total_ns += (obs->video.video_time - context->last_time);
@@ -1172,7 +1815,17 @@ bool obs_graphics_thread_loop(struct obs_graphics_context *context)
 		obs->video.video_avg_frame_time_ns =
 			context->frame_time_total_ns /
 			(uint64_t)context->fps_total_frames;
+		obs->video.video_avg_wake_delay_ns =
+			context->wake_delay_total_ns /
+			(uint64_t)context->wake_total_frames;
 
+		obs_metric_set(obs->metrics.frame_time_ns,
+			       (int64_t)obs->video.video_avg_frame_time_ns);
+		obs_metric_set(obs->metrics.wake_delay_ns,
+			       (int64_t)obs->video.video_avg_wake_delay_ns);
+
+		context->wake_delay_total_ns = 0;
+		context->wake_total_frames = 0;
 		context->frame_time_total_ns = 0;
 		context->fps_total_ns = 0;
 		context->fps_total_frames = 0;
@@ -1194,6 +1847,7 @@ void *obs_graphics_thread(void *param)
 
 	obs->video.video_time = os_gettime_ns();
 
+	os_thread_role_t *role = os_set_thread_role(OS_THREAD_ROLE_RENDER);
 	os_set_thread_name("libobs: graphics thread");
 
 	const char *video_thread_name = profile_store_name(
@@ -1208,6 +1862,8 @@ void *obs_graphics_thread(void *param)
 	context.frame_time_total_ns = 0;
 	context.fps_total_ns = 0;
 	context.fps_total_frames = 0;
+	context.wake_delay_total_ns = 0;
+	context.wake_total_frames = 0;
 	context.last_time = 0;
 	context.video_thread_name = video_thread_name;
 
@@ -1218,6 +1874,12 @@ void *obs_graphics_thread(void *param)
 #endif
 		;
 
+	gs_enter_context(obs->video.graphics);
+	obs_gpu_timing_free();
+	gs_leave_context();
+
+	os_reset_thread_role(role);
+
 #ifdef _WIN32
 	uninit_winrt_state(&winrt);
 #endif
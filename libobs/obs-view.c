@@ -17,6 +17,7 @@
 
 #include "obs.h"
 #include "obs-internal.h"
+#include "util/util_uint64.h"
 
 bool obs_view_init(struct obs_view *view)
 {
@@ -237,6 +238,52 @@ video_t *obs_record_view_add(obs_view_t *view)
 	return mix->video;
 }
 
+video_t *obs_view_add_canvas(obs_view_t *view,
+			     const struct obs_video_info *ovi)
+{
+	struct obs_video_info canvas_ovi;
+	uint64_t interval;
+
+	if (!view || !ovi || !obs->video.main_mix)
+		return NULL;
+
+	if (!ovi->fps_num || !ovi->fps_den || !ovi->base_width ||
+	    !ovi->base_height || !ovi->output_width || !ovi->output_height) {
+		blog(LOG_WARNING, "obs_view_add_canvas: Invalid canvas size "
+				  "or frame rate");
+		return NULL;
+	}
+
+	interval = util_mul_div64(1000000000ULL, ovi->fps_den, ovi->fps_num);
+	if (interval < obs->video.video_frame_interval_ns) {
+		blog(LOG_WARNING,
+		     "obs_view_add_canvas: Canvas frame rate %u/%u is higher "
+		     "than the main frame rate",
+		     ovi->fps_num, ovi->fps_den);
+		return NULL;
+	}
+
+	canvas_ovi = *ovi;
+	canvas_ovi.graphics_module = obs->video.ovi.graphics_module;
+	canvas_ovi.adapter = obs->video.ovi.adapter;
+
+	struct obs_core_video_mix *mix = obs_create_video_mix(&canvas_ovi);
+	if (!mix)
+		return NULL;
+
+	mix->view = view;
+	mix->canvas = true;
+	mix->canvas_interval_ns = interval;
+
+	pthread_mutex_lock(&obs->video.mixes_mutex);
+	da_push_back(obs->video.mixes, &mix);
+	pthread_mutex_unlock(&obs->video.mixes_mutex);
+
+	blog(LOG_INFO, "Added %ux%u canvas at %u/%u fps", ovi->base_width,
+	     ovi->base_height, ovi->fps_num, ovi->fps_den);
+	return mix->video;
+}
+
 void obs_view_remove(obs_view_t *view)
 {
 	if (!view)
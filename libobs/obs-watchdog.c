@@ -0,0 +1,174 @@
+/******************************************************************************
+    Copyright (C) 2023 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include <inttypes.h>
+
+#include "obs-internal.h"
+
+/* The graphics, audio, encoder and output packet threads mark when they
+ * start and finish each unit of work with a heartbeat.  The watchdog thread
+ * checks how long each one has been busy, and if any goes past the deadline
+ * it logs which one, along with the stacks of all threads where the
+ * platform supports it.  Nothing is terminated, the point is to find out
+ * where rare stalls (driver hangs, deadlocked plugins) come from. */
+
+#define DEFAULT_WATCHDOG_TIMEOUT_MS 5000
+#define MAX_WATCHDOG_INTERVAL_MS 500
+
+#ifdef _WIN32
+extern void log_thread_stacks(void);
+#endif
+
+static pthread_mutex_t heartbeats_mutex = PTHREAD_MUTEX_INITIALIZER;
+static DARRAY(struct obs_heartbeat *) heartbeats;
+
+static volatile long watchdog_timeout_ms = DEFAULT_WATCHDOG_TIMEOUT_MS;
+static os_event_t *watchdog_stop_event;
+static pthread_t watchdog_thread;
+static bool watchdog_active;
+
+void obs_heartbeat_init(struct obs_heartbeat *hb, const char *type,
+			const char *name)
+{
+	struct dstr str = {0};
+
+	if (name)
+		dstr_printf(&str, "%s '%s'", type, name);
+	else
+		dstr_copy(&str, type);
+
+	hb->name = str.array;
+	hb->busy_since = 0;
+	hb->reported_since = 0;
+
+	pthread_mutex_lock(&heartbeats_mutex);
+	da_push_back(heartbeats, &hb);
+	pthread_mutex_unlock(&heartbeats_mutex);
+}
+
+void obs_heartbeat_free(struct obs_heartbeat *hb)
+{
+	pthread_mutex_lock(&heartbeats_mutex);
+	da_erase_item(heartbeats, &hb);
+	if (!heartbeats.num)
+		da_free(heartbeats);
+	pthread_mutex_unlock(&heartbeats_mutex);
+
+	bfree(hb->name);
+	hb->name = NULL;
+}
+
+/* returns true if a heartbeat newly went past the deadline */
+static bool check_heartbeats(uint64_t timeout_ns)
+{
+	int64_t now = (int64_t)os_gettime_ns();
+	bool stalled = false;
+
+	pthread_mutex_lock(&heartbeats_mutex);
+
+	for (size_t i = 0; i < heartbeats.num; i++) {
+		struct obs_heartbeat *hb = heartbeats.array[i];
+		int64_t since = os_atomic_load_int64(&hb->busy_since);
+
+		if (hb->reported_since && hb->reported_since != since) {
+			blog(LOG_WARNING,
+			     "Watchdog: %s thread is running again", hb->name);
+			hb->reported_since = 0;
+		}
+
+		if (!since || since == hb->reported_since)
+			continue;
+		if (now - since < (int64_t)timeout_ns)
+			continue;
+
+		blog(LOG_WARNING,
+		     "Watchdog: %s thread has been stuck for %" PRId64 " ms",
+		     hb->name, (now - since) / 1000000);
+		hb->reported_since = since;
+		stalled = true;
+	}
+
+	pthread_mutex_unlock(&heartbeats_mutex);
+	return stalled;
+}
+
+static void *watchdog_thread_func(void *unused)
+{
+	os_set_thread_name("obs watchdog");
+
+	for (;;) {
+		long timeout_ms = os_atomic_load_long(&watchdog_timeout_ms);
+		long interval_ms = timeout_ms / 4;
+
+		if (interval_ms <= 0 || interval_ms > MAX_WATCHDOG_INTERVAL_MS)
+			interval_ms = MAX_WATCHDOG_INTERVAL_MS;
+
+		if (os_event_timedwait(watchdog_stop_event,
+				       (unsigned long)interval_ms) != ETIMEDOUT)
+			break;
+		if (timeout_ms <= 0)
+			continue;
+
+		if (check_heartbeats((uint64_t)timeout_ms * 1000000ULL)) {
+#ifdef _WIN32
+			blog(LOG_WARNING, "Watchdog: thread stacks follow");
+			log_thread_stacks();
+#endif
+		}
+	}
+
+	UNUSED_PARAMETER(unused);
+	return NULL;
+}
+
+void obs_watchdog_start(void)
+{
+	if (os_event_init(&watchdog_stop_event, OS_EVENT_TYPE_MANUAL) != 0)
+		return;
+
+	if (pthread_create(&watchdog_thread, NULL, watchdog_thread_func,
+			   NULL) != 0) {
+		blog(LOG_WARNING, "Failed to create watchdog thread");
+		os_event_destroy(watchdog_stop_event);
+		watchdog_stop_event = NULL;
+		return;
+	}
+
+	watchdog_active = true;
+}
+
+void obs_watchdog_stop(void)
+{
+	if (watchdog_active) {
+		os_event_signal(watchdog_stop_event);
+		pthread_join(watchdog_thread, NULL);
+		watchdog_active = false;
+	}
+
+	os_event_destroy(watchdog_stop_event);
+	watchdog_stop_event = NULL;
+}
+
+void obs_set_watchdog_timeout(uint32_t timeout_ms)
+{
+	os_atomic_set_long(&watchdog_timeout_ms, (long)timeout_ms);
+}
+
+uint32_t obs_get_watchdog_timeout(void)
+{
+	return (uint32_t)os_atomic_load_long(&watchdog_timeout_ms);
+}
@@ -93,6 +93,7 @@ struct exception_handler_data {
 
 	HMODULE dbghelp;
 	SYMBOL_INFOW *sym_info;
+	PREAD_PROCESS_MEMORY_ROUTINE64 read_memory;
 	PEXCEPTION_POINTERS exception;
 	struct win_version_info win_version;
 	SYSTEMTIME time_info;
@@ -329,7 +330,7 @@ static inline bool walk_stack(struct exception_handler_data *data,
 
 	bool success = data->stack_walk64(trace->image_type, data->process,
 					  thread, &trace->frame,
-					  &trace->context, NULL,
+					  &trace->context, data->read_memory,
 					  data->sym_function_table_access64,
 					  data->sym_get_module_base64, NULL);
 	if (!success)
@@ -575,3 +576,154 @@ void initialize_crash_handler(void)
 		initialized = true;
 	}
 }
+
+/* ------------------------------------------------------------------------- */
+/* Stack traces of a running process, for the watchdog.  A suspended thread
+ * might be holding the heap lock, so each thread is only suspended while its
+ * context and the top of its stack are copied, and the stack is walked from
+ * that copy afterwards. */
+
+#define STACK_SNAPSHOT_SIZE (64 * 1024)
+
+static struct {
+	DWORD64 base;
+	SIZE_T size;
+	uint8_t data[STACK_SNAPSHOT_SIZE];
+} stack_snapshot;
+
+static BOOL CALLBACK read_snapshot_memory(HANDLE process, DWORD64 addr,
+					  PVOID buffer, DWORD size,
+					  LPDWORD bytes_read)
+{
+	SIZE_T read = 0;
+	BOOL success;
+
+	if (addr >= stack_snapshot.base &&
+	    addr + size <= stack_snapshot.base + stack_snapshot.size) {
+		size_t offset = (size_t)(addr - stack_snapshot.base);
+		memcpy(buffer, stack_snapshot.data + offset, size);
+		*bytes_read = size;
+		return true;
+	}
+
+	success = ReadProcessMemory(process, (LPCVOID)(uintptr_t)addr, buffer,
+				    size, &read);
+	*bytes_read = (DWORD)read;
+	return success;
+}
+
+/* doesn't touch the heap, the thread is suspended at this point */
+static inline void snapshot_stack(DWORD64 stack_ptr)
+{
+	MEMORY_BASIC_INFORMATION mbi;
+	SIZE_T size = 0;
+
+	stack_snapshot.base = stack_ptr;
+	stack_snapshot.size = 0;
+
+	if (!VirtualQuery((LPCVOID)(uintptr_t)stack_ptr, &mbi, sizeof(mbi)))
+		return;
+
+	size = (SIZE_T)((uintptr_t)mbi.BaseAddress + mbi.RegionSize -
+			(uintptr_t)stack_ptr);
+	if (size > STACK_SNAPSHOT_SIZE)
+		size = STACK_SNAPSHOT_SIZE;
+
+	ReadProcessMemory(GetCurrentProcess(), (LPCVOID)(uintptr_t)stack_ptr,
+			  stack_snapshot.data, size, &stack_snapshot.size);
+}
+
+static inline void write_live_thread_trace(struct exception_handler_data *data,
+					   THREADENTRY32 *entry)
+{
+	struct stack_trace trace = {0};
+	HANDLE thread;
+	char *thread_name;
+	bool captured = false;
+
+	if (entry->th32OwnerProcessID != GetCurrentProcessId())
+		return;
+	if (entry->th32ThreadID == GetCurrentThreadId())
+		return;
+
+	thread = OpenThread(THREAD_ALL_ACCESS, false, entry->th32ThreadID);
+	if (!thread)
+		return;
+
+	thread_name = get_thread_name(thread);
+	dstr_catf(&data->str, "\r\nThread %lX:%s\r\n" TRACE_TOP,
+		  entry->th32ThreadID, thread_name ? thread_name : "");
+	bfree(thread_name);
+
+	trace.context.ContextFlags = CONTEXT_ALL;
+
+	if (SuspendThread(thread) != (DWORD)-1) {
+		captured = !!GetThreadContext(thread, &trace.context);
+		if (captured) {
+			init_instruction_data(&trace);
+			snapshot_stack(trace.frame.AddrStack.Offset);
+		}
+		ResumeThread(thread);
+	}
+
+	if (captured) {
+		while (walk_stack(data, thread, &trace))
+			;
+	}
+
+	CloseHandle(thread);
+}
+
+static void log_lines(const char *str)
+{
+	while (*str) {
+		const char *end = strchr(str, '\n');
+		size_t len = end ? (size_t)(end - str) : strlen(str);
+
+		if (len && str[len - 1] == '\r')
+			len--;
+
+		blog(LOG_WARNING, "%.*s", (int)len, str);
+
+		if (!end)
+			break;
+		str = end + 1;
+	}
+}
+
+void log_thread_stacks(void)
+{
+	struct exception_handler_data data = {0};
+	THREADENTRY32 entry = {0};
+	HANDLE snapshot;
+	bool success;
+
+	if (!get_dbghelp_imports(&data))
+		goto cleanup;
+
+	data.process = GetCurrentProcess();
+	data.read_memory = read_snapshot_memory;
+
+	init_sym_info(&data);
+	sym_initialize_called = true;
+
+	snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD,
+					    GetCurrentProcessId());
+	if (snapshot == INVALID_HANDLE_VALUE)
+		goto cleanup;
+
+	entry.dwSize = sizeof(entry);
+
+	success = !!Thread32First(snapshot, &entry);
+	while (success) {
+		write_live_thread_trace(&data, &entry);
+		success = !!Thread32Next(snapshot, &entry);
+	}
+
+	CloseHandle(snapshot);
+
+	log_lines(data.str.array ? data.str.array : "");
+
+cleanup:
+	exception_handler_data_free(&data);
+}
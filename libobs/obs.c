@@ -20,6 +20,7 @@
 
 #include "graphics/matrix4.h"
 #include "callback/calldata.h"
+#include "media-io/video-copy.h"
 
 #include "obs.h"
 #include "obs-internal.h"
@@ -44,6 +45,7 @@ static inline void make_video_info(struct video_output_info *vi,
 	vi->range = ovi->range;
 	vi->colorspace = ovi->colorspace;
 	vi->cache_size = 6;
+	vi->max_cache_size = 30;
 }
 
 static inline void calc_gpu_conversion_sizes(struct obs_core_video_mix *video)
@@ -339,7 +341,7 @@ static bool obs_init_textures(struct obs_core_video_mix *video)
 
 	bool success = true;
 
-	for (size_t i = 0; i < NUM_TEXTURES; i++) {
+	for (size_t i = 0; i < video->num_textures; i++) {
 #ifdef _WIN32
 		if (video->using_nv12_tex) {
 			video->copy_surfaces_encode[i] =
@@ -400,7 +402,7 @@ static bool obs_init_textures(struct obs_core_video_mix *video)
 	}
 
 	video->render_texture =
-		gs_texture_create(obs->video.base_width, obs->video.base_height,
+		gs_texture_create(video->base_width, video->base_height,
 				  format, 1, NULL, GS_RENDER_TARGET);
 	if (!video->render_texture)
 		success = false;
@@ -413,7 +415,7 @@ static bool obs_init_textures(struct obs_core_video_mix *video)
 	if (success) {
 		video->render_space = space;
 	} else {
-		for (size_t i = 0; i < NUM_TEXTURES; i++) {
+		for (size_t i = 0; i < video->num_textures; i++) {
 			for (size_t c = 0; c < NUM_CHANNELS; c++) {
 				if (video->copy_surfaces[i][c]) {
 					gs_stagesurface_destroy(
@@ -580,15 +582,63 @@ static inline void set_video_matrix(struct obs_core_video_mix *video,
 	memcpy(video->color_matrix, &mat, sizeof(float) * 16);
 }
 
+static inline size_t get_num_textures(const struct obs_video_info *ovi)
+{
+	uint32_t num = ovi->staging_surfaces;
+
+	if (!num)
+		return NUM_TEXTURES;
+	if (num < MIN_TEXTURES)
+		return MIN_TEXTURES;
+	if (num > MAX_TEXTURES)
+		return MAX_TEXTURES;
+	return num;
+}
+
+static void obs_init_staging_arrays(struct obs_core_video_mix *video,
+				    const struct obs_video_info *ovi)
+{
+	size_t num = get_num_textures(ovi);
+
+	video->num_textures = num;
+	video->copy_surfaces = bzalloc(sizeof(*video->copy_surfaces) * num);
+	video->active_copy_surfaces =
+		bzalloc(sizeof(*video->active_copy_surfaces) * num);
+	video->textures_copied = bzalloc(sizeof(*video->textures_copied) * num);
+#ifdef _WIN32
+	video->copy_surfaces_encode =
+		bzalloc(sizeof(*video->copy_surfaces_encode) * num);
+#endif
+}
+
+static void obs_free_staging_arrays(struct obs_core_video_mix *video)
+{
+	bfree(video->copy_surfaces);
+	bfree(video->active_copy_surfaces);
+	bfree(video->textures_copied);
+	video->copy_surfaces = NULL;
+	video->active_copy_surfaces = NULL;
+	video->textures_copied = NULL;
+#ifdef _WIN32
+	bfree(video->copy_surfaces_encode);
+	video->copy_surfaces_encode = NULL;
+#endif
+	video->num_textures = 0;
+}
+
 static int obs_init_video_mix(struct obs_video_info *ovi,
 			      struct obs_core_video_mix *video)
 {
 	struct video_output_info vi;
 
 	pthread_mutex_init_value(&video->gpu_encoder_mutex);
+	obs_init_staging_arrays(video, ovi);
 
 	make_video_info(&vi, ovi);
+	video->base_width = ovi->base_width;
+	video->base_height = ovi->base_height;
 	video->gpu_conversion = ovi->gpu_conversion;
+	video->zero_copy_readback = ovi->zero_copy_readback;
 	video->scale_type = ovi->scale_type;
 	video->gpu_was_active = false;
 	video->raw_was_active = false;
@@ -619,6 +669,11 @@ static int obs_init_video_mix(struct obs_video_info *ovi,
 
 	gs_leave_context();
 
+	if (!init_video_readback(video))
+		blog(LOG_WARNING, "Failed to start video readback thread, "
+				  "frames will be copied on the graphics "
+				  "thread");
+
 	return OBS_VIDEO_SUCCESS;
 }
 
@@ -627,12 +682,59 @@ struct obs_core_video_mix *obs_create_video_mix(struct obs_video_info *ovi)
 	struct obs_core_video_mix *video =
 		bzalloc(sizeof(struct obs_core_video_mix));
 	if (obs_init_video_mix(ovi, video) != OBS_VIDEO_SUCCESS) {
+		obs_free_staging_arrays(video);
 		bfree(video);
 		video = NULL;
 	}
 	return video;
 }
 
+struct obs_core_video_mix *
+obs_create_scaled_video_mix(video_t *video, uint32_t width, uint32_t height,
+			    enum obs_scale_type scale_type)
+{
+	struct obs_core_video_mix *source = get_mix_for_video(video);
+	const struct video_output_info *voi = video_output_get_info(video);
+	struct obs_video_info ovi = obs->video.ovi;
+	struct obs_core_video_mix *mix;
+
+	if (!source || !voi)
+		return NULL;
+
+	/* the source mix may be an extra canvas */
+	ovi.base_width = source->base_width;
+	ovi.base_height = source->base_height;
+	ovi.fps_num = voi->fps_num;
+	ovi.fps_den = voi->fps_den;
+	ovi.output_width = width;
+	ovi.output_height = height;
+	ovi.output_format = voi->format;
+	ovi.colorspace = voi->colorspace;
+	ovi.range = voi->range;
+	ovi.scale_type = scale_type;
+
+	mix = obs_create_video_mix(&ovi);
+	if (!mix)
+		return NULL;
+
+	mix->scale_source = source;
+	mix->scaled_mix = true;
+
+	pthread_mutex_lock(&obs->video.mixes_mutex);
+	da_push_back(obs->video.mixes, &mix);
+	pthread_mutex_unlock(&obs->video.mixes_mutex);
+	return mix;
+}
+
+/* the mix itself is freed by the graphics thread */
+void obs_remove_scaled_video_mix(struct obs_core_video_mix *mix)
+{
+	pthread_mutex_lock(&obs->video.mixes_mutex);
+	mix->scale_source = NULL;
+	mix->scale_removed = true;
+	pthread_mutex_unlock(&obs->video.mixes_mutex);
+}
+
 static int obs_init_video(struct obs_video_info *ovi)
 {
 	struct obs_core_video *video = &obs->video;
@@ -647,6 +749,8 @@ static int obs_init_video(struct obs_video_info *ovi)
 		return OBS_VIDEO_FAIL;
 	if (pthread_mutex_init(&video->mixes_mutex, NULL) < 0)
 		return OBS_VIDEO_FAIL;
+	if (pthread_mutex_init(&video->tick_mutex, NULL) < 0)
+		return OBS_VIDEO_FAIL;
 
 	video->ovi = *ovi;
 
@@ -706,7 +810,7 @@ static void obs_free_render_textures(struct obs_core_video_mix *video)
 		}
 	}
 
-	for (size_t i = 0; i < NUM_TEXTURES; i++) {
+	for (size_t i = 0; i < video->num_textures; i++) {
 		for (size_t c = 0; c < NUM_CHANNELS; c++) {
 			if (video->copy_surfaces[i][c]) {
 				gs_stagesurface_destroy(
@@ -748,6 +852,8 @@ static void obs_free_render_textures(struct obs_core_video_mix *video)
 
 void obs_free_video_mix(struct obs_core_video_mix *video)
 {
+	free_video_readback(video);
+
 	if (video->video) {
 		video_output_close(video->video);
 		video->video = NULL;
@@ -758,8 +864,6 @@ void obs_free_video_mix(struct obs_core_video_mix *video)
 		circlebuf_free(&video->vframe_info_buffer_gpu);
 
 		video->texture_rendered = false;
-		memset(video->textures_copied, 0,
-		       sizeof(video->textures_copied));
 		video->texture_converted = false;
 
 		pthread_mutex_destroy(&video->gpu_encoder_mutex);
@@ -769,6 +873,7 @@ void obs_free_video_mix(struct obs_core_video_mix *video)
 		video->gpu_encoder_active = 0;
 		video->cur_texture = 0;
 	}
+	obs_free_staging_arrays(video);
 	bfree(video);
 }
 
@@ -791,6 +896,10 @@ static void obs_free_video(void)
 	pthread_mutex_destroy(&obs->video.task_mutex);
 	pthread_mutex_init_value(&obs->video.task_mutex);
 	circlebuf_free(&obs->video.tasks);
+
+	free_tick_threads();
+	pthread_mutex_destroy(&obs->video.tick_mutex);
+	pthread_mutex_init_value(&obs->video.tick_mutex);
 }
 
 static void obs_free_graphics(void)
@@ -800,6 +909,7 @@ static void obs_free_graphics(void)
 	if (video->graphics) {
 		gs_enter_context(video->graphics);
 
+		obs_free_deferred_gs_objects();
 		gs_texture_destroy(video->transparent_texture);
 
 		gs_samplerstate_destroy(video->point_sampler);
@@ -814,6 +924,7 @@ static void obs_free_graphics(void)
 		gs_effect_destroy(video->lanczos_effect);
 		gs_effect_destroy(video->area_effect);
 		gs_effect_destroy(video->bilinear_lowres_effect);
+		obs_free_fused_effects();
 		video->default_effect = NULL;
 
 		gs_leave_context();
@@ -836,6 +947,10 @@ static bool obs_init_audio(struct audio_output_info *ai)
 		return false;
 	if (pthread_mutex_init(&audio->task_mutex, NULL) != 0)
 		return false;
+	if (pthread_mutex_init(&audio->render_mutex, NULL) != 0)
+		return false;
+	if (pthread_mutex_init(&audio->journal_mutex, NULL) != 0)
+		return false;
 
 	struct obs_task_info audio_init = {.task = set_audio_thread};
 	circlebuf_push_back(&audio->tasks, &audio_init, sizeof(audio_init));
@@ -872,6 +987,9 @@ static void obs_free_audio(void)
 	if (audio->audio)
 		audio_output_close(audio->audio);
 
+	free_audio_render_threads();
+	free_audio_tick_journal(audio);
+
 	circlebuf_free(&audio->buffered_timestamps);
 	da_free(audio->render_order);
 	da_free(audio->root_nodes);
@@ -881,6 +999,8 @@ static void obs_free_audio(void)
 	bfree(audio->monitoring_device_id);
 	circlebuf_free(&audio->tasks);
 	pthread_mutex_destroy(&audio->task_mutex);
+	pthread_mutex_destroy(&audio->render_mutex);
+	pthread_mutex_destroy(&audio->journal_mutex);
 	pthread_mutex_destroy(&audio->monitoring_mutex);
 
 	memset(audio, 0, sizeof(struct obs_core_audio));
@@ -969,7 +1089,12 @@ static void obs_free_data(void)
 	FREE_OBS_LINKED_LIST(display);
 	FREE_OBS_LINKED_LIST(service);
 
-	os_task_queue_wait(obs->destruction_task_thread);
+	os_job_pool_wait(obs->task_pool);
+
+	obs_context_index_free(&data->source_index);
+	obs_context_index_free(&data->output_index);
+	obs_context_index_free(&data->encoder_index);
+	obs_context_index_free(&data->service_index);
 
 	pthread_mutex_destroy(&data->sources_mutex);
 	pthread_mutex_destroy(&data->audio_sources_mutex);
@@ -1122,6 +1247,22 @@ const struct obs_source_info audio_line_info = {
 
 extern void log_system_info(void);
 
+static void obs_init_metrics(void)
+{
+	struct obs_core_metrics *metrics = &obs->metrics;
+
+	metrics->frames_rendered =
+		obs_metric_create("video.frames_rendered", OBS_METRIC_COUNTER);
+	metrics->frames_lagged =
+		obs_metric_create("video.frames_lagged", OBS_METRIC_COUNTER);
+	metrics->frame_time_ns =
+		obs_metric_create("video.frame_time_ns", OBS_METRIC_GAUGE);
+	metrics->wake_delay_ns =
+		obs_metric_create("video.wake_delay_ns", OBS_METRIC_GAUGE);
+	metrics->audio_buffering_ms =
+		obs_metric_create("audio.buffering_ms", OBS_METRIC_GAUGE);
+}
+
 static bool obs_init(const char *locale, const char *module_config_path,
 		     profiler_name_store_t *store)
 {
@@ -1148,8 +1289,18 @@ static bool obs_init(const char *locale, const char *module_config_path,
 	if (!obs_init_hotkeys())
 		return false;
 
-	obs->destruction_task_thread = os_task_queue_create();
-	if (!obs->destruction_task_thread)
+	obs_init_metrics();
+
+	obs_heartbeat_init(&obs->video.graphics_heartbeat, "graphics", NULL);
+	obs_heartbeat_init(&obs->audio.heartbeat, "audio", NULL);
+	obs_watchdog_start();
+
+	obs->task_pool = os_job_pool_create(0);
+	if (!obs->task_pool)
+		return false;
+
+	obs->upload_task_thread = os_task_queue_create();
+	if (!obs->upload_task_thread)
 		return false;
 
 	if (module_config_path)
@@ -1317,9 +1468,11 @@ void obs_shutdown(void)
 	da_free(obs->filter_types);
 	da_free(obs->transition_types);
 
+	obs_watchdog_stop();
 	stop_video();
 	stop_audio();
 	stop_hotkeys();
+	obs_free_screenshots();
 
 	module = obs->first_module;
 	while (module) {
@@ -1332,7 +1485,11 @@ void obs_shutdown(void)
 	obs_free_data();
 	obs_free_audio();
 	obs_free_video();
-	os_task_queue_destroy(obs->destruction_task_thread);
+	obs_heartbeat_free(&obs->video.graphics_heartbeat);
+	obs_heartbeat_free(&obs->audio.heartbeat);
+	os_job_pool_destroy(obs->task_pool);
+	os_task_queue_destroy(obs->upload_task_thread);
+	obs_free_image_cache();
 	obs_free_hotkeys();
 	obs_free_graphics();
 	proc_handler_destroy(obs->procs);
@@ -1351,6 +1508,9 @@ void obs_shutdown(void)
 	bfree(obs->locale);
 	bfree(obs);
 	obs = NULL;
+	packet_pool_free();
+	video_copy_free();
+	obs_metrics_free();
 	bfree(cmdline_args.argv);
 
 #ifdef _WIN32
@@ -1470,11 +1630,13 @@ int obs_reset_video(struct obs_video_info *ovi)
 	     "\tdownscale filter:  %s\n"
 	     "\tfps:               %d/%d\n"
 	     "\tformat:            %s\n"
-	     "\tYUV mode:          %s%s%s",
+	     "\tYUV mode:          %s%s%s\n"
+	     "\tstaging surfaces:  %zu",
 	     ovi->base_width, ovi->base_height, ovi->output_width,
 	     ovi->output_height, scale_type_name, ovi->fps_num, ovi->fps_den,
 	     get_video_format_name(ovi->output_format),
-	     yuv ? yuv_format : "None", yuv ? "/" : "", yuv ? yuv_range : "");
+	     yuv ? yuv_format : "None", yuv ? "/" : "", yuv ? yuv_range : "",
+	     get_num_textures(ovi));
 
 	return obs_init_video(ovi);
 }
@@ -1505,6 +1667,8 @@ bool obs_reset_audio2(const struct obs_audio_info2 *oai)
 		audio->max_buffering_ticks = 45;
 	}
 	audio->fixed_buffer = oai->fixed_buffering;
+	audio->adaptive_buffer = oai->adaptive_buffering;
+	audio->buffering_min_slack = UINT64_MAX;
 
 	int max_buffering_ms = audio->max_buffering_ticks *
 			       AUDIO_OUTPUT_FRAMES * SEC_TO_MSEC /
@@ -1524,7 +1688,9 @@ bool obs_reset_audio2(const struct obs_audio_info2 *oai)
 	     "\tmax buffering:   %d milliseconds\n"
 	     "\tbuffering type:  %s",
 	     (int)ai.samples_per_sec, (int)ai.speakers, max_buffering_ms,
-	     oai->fixed_buffering ? "fixed" : "dynamically increasing");
+	     oai->fixed_buffering      ? "fixed"
+	     : oai->adaptive_buffering ? "adaptive"
+				       : "dynamically increasing");
 
 	return obs_init_audio(&ai);
 }
@@ -1957,22 +2123,99 @@ void obs_enum_services(bool (*enum_proc)(void *, obs_service_t *), void *param)
 		 param);
 }
 
-static inline void *get_context_by_name(void *vfirst, const char *name,
+static inline uint32_t hash_context_name(const char *name)
+{
+	/* FNV-1a */
+	uint32_t hash = 2166136261u;
+	while (*name) {
+		hash ^= (uint8_t)*name++;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+static void index_insert(struct obs_context_index *index,
+			 struct obs_context_data *context)
+{
+	struct obs_context_data **bucket;
+
+	if (index->count >= index->num_buckets * 2) {
+		size_t num_buckets =
+			index->num_buckets ? index->num_buckets * 2 : 64;
+		struct obs_context_data **buckets =
+			bzalloc(num_buckets * sizeof(*buckets));
+
+		for (size_t i = 0; i < index->num_buckets; i++) {
+			struct obs_context_data *item = index->buckets[i];
+			while (item) {
+				struct obs_context_data *next = item->hash_next;
+				bucket = &buckets[item->name_hash &
+						  (num_buckets - 1)];
+				item->hash_next = *bucket;
+				*bucket = item;
+				item = next;
+			}
+		}
+
+		bfree(index->buckets);
+		index->buckets = buckets;
+		index->num_buckets = num_buckets;
+	}
+
+	context->name_hash = hash_context_name(context->name);
+	bucket = &index->buckets[context->name_hash &
+				 (index->num_buckets - 1)];
+	context->hash_next = *bucket;
+	*bucket = context;
+	index->count++;
+}
+
+static void index_remove(struct obs_context_index *index,
+			 struct obs_context_data *context)
+{
+	struct obs_context_data **item;
+
+	if (!index->num_buckets)
+		return;
+
+	item = &index->buckets[context->name_hash & (index->num_buckets - 1)];
+	while (*item) {
+		if (*item == context) {
+			*item = context->hash_next;
+			context->hash_next = NULL;
+			index->count--;
+			return;
+		}
+		item = &(*item)->hash_next;
+	}
+}
+
+void obs_context_index_free(struct obs_context_index *index)
+{
+	bfree(index->buckets);
+	memset(index, 0, sizeof(*index));
+}
+
+static inline void *get_context_by_name(struct obs_context_index *index,
+					const char *name,
 					pthread_mutex_t *mutex,
 					void *(*addref)(void *))
 {
-	struct obs_context_data **first = vfirst;
-	struct obs_context_data *context;
+	struct obs_context_data *context = NULL;
+	uint32_t hash = hash_context_name(name);
 
 	pthread_mutex_lock(mutex);
 
-	context = *first;
+	if (index->num_buckets)
+		context = index->buckets[hash & (index->num_buckets - 1)];
+
 	while (context) {
-		if (!context->private && strcmp(context->name, name) == 0) {
+		if (context->name_hash == hash &&
+		    strcmp(context->name, name) == 0) {
 			context = addref(context);
 			break;
 		}
-		context = context->next;
+		context = context->hash_next;
 	}
 
 	pthread_mutex_unlock(mutex);
@@ -2006,7 +2249,7 @@ static inline void *obs_id_(void *data)
 
 obs_source_t *obs_get_source_by_name(const char *name)
 {
-	return get_context_by_name(&obs->data.first_source, name,
+	return get_context_by_name(&obs->data.source_index, name,
 				   &obs->data.sources_mutex,
 				   obs_source_addref_safe_);
 }
@@ -2034,21 +2277,21 @@ obs_source_t *obs_get_transition_by_name(const char *name)
 
 obs_output_t *obs_get_output_by_name(const char *name)
 {
-	return get_context_by_name(&obs->data.first_output, name,
+	return get_context_by_name(&obs->data.output_index, name,
 				   &obs->data.outputs_mutex,
 				   obs_output_addref_safe_);
 }
 
 obs_encoder_t *obs_get_encoder_by_name(const char *name)
 {
-	return get_context_by_name(&obs->data.first_encoder, name,
+	return get_context_by_name(&obs->data.encoder_index, name,
 				   &obs->data.encoders_mutex,
 				   obs_encoder_addref_safe_);
 }
 
 obs_service_t *obs_get_service_by_name(const char *name)
 {
-	return get_context_by_name(&obs->data.first_service, name,
+	return get_context_by_name(&obs->data.service_index, name,
 				   &obs->data.services_mutex,
 				   obs_service_addref_safe_);
 }
@@ -2273,7 +2516,7 @@ float obs_get_master_volume(void)
 }
 
 static obs_source_t *obs_load_source_type(obs_data_t *source_data,
-					  bool is_private)
+					  bool is_private, bool defer)
 {
 	obs_data_array_t *filters = obs_data_get_array(source_data, "filters");
 	obs_source_t *source;
@@ -2298,8 +2541,12 @@ static obs_source_t *obs_load_source_type(obs_data_t *source_data,
 	if (!*v_id)
 		v_id = id;
 
-	source = obs_source_create_set_last_ver(v_id, name, settings, hotkeys,
-						prev_ver, is_private);
+	if (defer && !is_private)
+		source = obs_source_create_deferred(v_id, name, settings,
+						    hotkeys, prev_ver);
+	else
+		source = obs_source_create_set_last_ver(
+			v_id, name, settings, hotkeys, prev_ver, is_private);
 	if (source->owns_info_id) {
 		bfree((void *)source->info.unversioned_id);
 		source->info.unversioned_id = bstrdup(id);
@@ -2387,7 +2634,7 @@ static obs_source_t *obs_load_source_type(obs_data_t *source_data,
 				obs_data_array_item(filters, i);
 
 			obs_source_t *filter =
-				obs_load_source_type(filter_data, true);
+				obs_load_source_type(filter_data, true, false);
 			if (filter) {
 				obs_source_filter_add(source, filter);
 				obs_source_release(filter);
@@ -2406,16 +2653,24 @@ static obs_source_t *obs_load_source_type(obs_data_t *source_data,
 
 obs_source_t *obs_load_source(obs_data_t *source_data)
 {
-	return obs_load_source_type(source_data, false);
+	return obs_load_source_type(source_data, false, false);
 }
 
 obs_source_t *obs_load_private_source(obs_data_t *source_data)
 {
-	return obs_load_source_type(source_data, true);
+	return obs_load_source_type(source_data, true, false);
 }
 
 void obs_load_sources(obs_data_array_t *array, obs_load_source_cb cb,
 		      void *private_data)
+{
+	obs_load_sources_deferred(array, cb, private_data, NULL, NULL);
+}
+
+void obs_load_sources_deferred(obs_data_array_t *array, obs_load_source_cb cb,
+			       void *private_data,
+			       obs_load_source_defer_cb defer_cb,
+			       void *defer_data)
 {
 	struct obs_core_data *data = &obs->data;
 	DARRAY(obs_source_t *) sources;
@@ -2431,7 +2686,9 @@ void obs_load_sources(obs_data_array_t *array, obs_load_source_cb cb,
 
 	for (i = 0; i < count; i++) {
 		obs_data_t *source_data = obs_data_array_item(array, i);
-		obs_source_t *source = obs_load_source(source_data);
+		bool defer = defer_cb && defer_cb(defer_data, source_data);
+		obs_source_t *source =
+			obs_load_source_type(source_data, false, defer);
 
 		da_push_back(sources, &source);
 
@@ -2673,7 +2930,8 @@ void obs_context_init_control(struct obs_context_data *context, void *object,
 }
 
 void obs_context_data_insert(struct obs_context_data *context,
-			     pthread_mutex_t *mutex, void *pfirst)
+			     pthread_mutex_t *mutex, void *pfirst,
+			     struct obs_context_index *index)
 {
 	struct obs_context_data **first = pfirst;
 
@@ -2689,6 +2947,10 @@ void obs_context_data_insert(struct obs_context_data *context,
 	*first = context;
 	if (context->next)
 		context->next->prev_next = &context->next;
+	if (!context->private) {
+		context->index = index;
+		index_insert(index, context);
+	}
 	pthread_mutex_unlock(mutex);
 }
 
@@ -2700,6 +2962,10 @@ void obs_context_data_remove(struct obs_context_data *context)
 		if (context->next)
 			context->next->prev_next = context->prev_next;
 		context->prev_next = NULL;
+		if (context->index) {
+			index_remove(context->index, context);
+			context->index = NULL;
+		}
 		pthread_mutex_unlock(context->mutex);
 	}
 }
@@ -2713,6 +2979,17 @@ void obs_context_wait(struct obs_context_data *context)
 void obs_context_data_setname(struct obs_context_data *context,
 			      const char *name)
 {
+	struct obs_context_index *index = NULL;
+
+	/* the index has to be rehashed under the list mutex, which is taken
+	 * before any other lock here */
+	if (context->mutex) {
+		pthread_mutex_lock(context->mutex);
+		index = context->index;
+		if (index)
+			index_remove(index, context);
+	}
+
 	pthread_mutex_lock(&context->rename_cache_mutex);
 
 	if (context->name)
@@ -2720,6 +2997,12 @@ void obs_context_data_setname(struct obs_context_data *context,
 	context->name = dup_name(name, context->private);
 
 	pthread_mutex_unlock(&context->rename_cache_mutex);
+
+	if (context->mutex) {
+		if (index)
+			index_insert(index, context);
+		pthread_mutex_unlock(context->mutex);
+	}
 }
 
 profiler_name_store_t *obs_get_profiler_name_store(void)
@@ -2742,6 +3025,11 @@ uint64_t obs_get_average_frame_time_ns(void)
 	return obs->video.video_avg_frame_time_ns;
 }
 
+uint64_t obs_get_average_wake_delay_ns(void)
+{
+	return obs->video.video_avg_wake_delay_ns;
+}
+
 uint64_t obs_get_frame_interval_ns(void)
 {
 	return obs->video.video_frame_interval_ns;
@@ -2839,6 +3127,31 @@ void obs_get_audio_monitoring_device(const char **name, const char **id)
 		*id = obs->audio.monitoring_device_id;
 }
 
+void obs_set_audio_monitoring_low_latency(bool low_latency)
+{
+	if (!obs_audio_monitoring_available())
+		return;
+
+	pthread_mutex_lock(&obs->audio.monitoring_mutex);
+
+	if (obs->audio.monitoring_low_latency != low_latency) {
+		obs->audio.monitoring_low_latency = low_latency;
+
+		for (size_t i = 0; i < obs->audio.monitors.num; i++) {
+			struct audio_monitor *monitor =
+				obs->audio.monitors.array[i];
+			audio_monitor_reset(monitor);
+		}
+	}
+
+	pthread_mutex_unlock(&obs->audio.monitoring_mutex);
+}
+
+bool obs_audio_monitoring_low_latency(void)
+{
+	return obs ? obs->audio.monitoring_low_latency : false;
+}
+
 void obs_add_tick_callback(void (*tick)(void *param, float seconds),
 			   void *param)
 {
@@ -2881,6 +3194,20 @@ void obs_remove_main_render_callback(void (*draw)(void *param, uint32_t cx,
 	pthread_mutex_unlock(&obs->data.draw_callbacks_mutex);
 }
 
+uint32_t obs_get_audio_buffering_ms(void)
+{
+	struct obs_core_audio *audio;
+	uint32_t sample_rate;
+
+	if (!obs || !obs->audio.audio)
+		return 0;
+
+	audio = &obs->audio;
+	sample_rate = audio_output_get_sample_rate(audio->audio);
+	return (uint32_t)(audio->total_buffering_ticks * AUDIO_OUTPUT_FRAMES *
+			  1000 / sample_rate);
+}
+
 uint32_t obs_get_total_frames(void)
 {
 	return obs->video.total_frames;
@@ -3107,8 +3434,8 @@ bool obs_in_task_thread(enum obs_task_type type)
 		return is_audio_thread;
 	else if (type == OBS_TASK_UI)
 		return is_ui_thread;
-	else if (type == OBS_TASK_DESTROY)
-		return os_task_queue_inside(obs->destruction_task_thread);
+	else if (type == OBS_TASK_DESTROY || type == OBS_TASK_WORKER)
+		return os_job_pool_inside(obs->task_pool);
 
 	assert(false);
 	return false;
@@ -3156,9 +3483,14 @@ void obs_queue_task(enum obs_task_type type, obs_task_t task, void *param,
 			pthread_mutex_unlock(&audio->task_mutex);
 
 		} else if (type == OBS_TASK_DESTROY) {
-			os_task_t os_task = (os_task_t)task;
-			os_task_queue_queue_task(obs->destruction_task_thread,
-						 os_task, param);
+			os_job_pool_queue_task(obs->task_pool,
+					       OS_JOB_PRIORITY_LOW,
+					       (os_task_t)task, param);
+
+		} else if (type == OBS_TASK_WORKER) {
+			os_job_pool_queue_task(obs->task_pool,
+					       OS_JOB_PRIORITY_NORMAL,
+					       (os_task_t)task, param);
 		}
 	}
 }
@@ -3178,8 +3510,8 @@ bool obs_wait_for_destroy_queue(void)
 	os_event_wait(info.event);
 	os_event_destroy(info.event);
 
-	/* wait for destroy task queue */
-	return os_task_queue_wait(obs->destruction_task_thread);
+	/* wait for destroy tasks (and any other pool jobs) */
+	return os_job_pool_wait(obs->task_pool);
 }
 
 static void set_ui_thread(void *unused)
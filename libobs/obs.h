@@ -51,6 +51,8 @@ struct obs_service;
 struct obs_module;
 struct obs_fader;
 struct obs_volmeter;
+struct obs_metric;
+struct obs_cached_image;
 
 typedef struct obs_context_data obs_object_t;
 typedef struct obs_display obs_display_t;
@@ -64,6 +66,8 @@ typedef struct obs_service obs_service_t;
 typedef struct obs_module obs_module_t;
 typedef struct obs_fader obs_fader_t;
 typedef struct obs_volmeter obs_volmeter_t;
+typedef struct obs_metric obs_metric_t;
+typedef struct obs_cached_image obs_cached_image_t;
 
 typedef struct obs_weak_object obs_weak_object_t;
 typedef struct obs_weak_source obs_weak_source_t;
@@ -171,6 +175,15 @@ enum obs_replay_buffer_rendering_mode {
 	OBS_RECORDING_REPLAY_BUFFER_RENDERING,
 };
 
+enum obs_gpu_stage {
+	OBS_GPU_STAGE_MAIN_TEXTURE,
+	OBS_GPU_STAGE_OUTPUT_TEXTURE,
+	OBS_GPU_STAGE_CONVERT_TEXTURE,
+	OBS_GPU_STAGE_STAGE_TEXTURE,
+	OBS_GPU_STAGE_DISPLAYS,
+	OBS_GPU_STAGE_COUNT,
+};
+
 struct obs_transform_info {
 	struct vec2 pos;
 	float rot;
@@ -213,6 +226,21 @@ struct obs_video_info {
 	enum video_range_type range;      /**< YUV range (if YUV) */
 
 	enum obs_scale_type scale_type; /**< How to scale if scaling */
+
+	/**
+	 * Number of staging surfaces cycled for GPU readback (2-6).  Each
+	 * surface past the second adds one frame of latency to raw outputs,
+	 * but gives the GPU more time to finish the copy before it's mapped.
+	 * 0 uses the default of 2.
+	 */
+	uint32_t staging_surfaces;
+
+	/**
+	 * Hand mapped staging surfaces directly to raw outputs instead of
+	 * copying them into the video frame cache.  Saves a full frame copy,
+	 * but the graphics thread will wait on slow raw encoders.
+	 */
+	bool zero_copy_readback;
 };
 
 /**
@@ -229,6 +257,9 @@ struct obs_audio_info2 {
 
 	uint32_t max_buffering_ms;
 	bool fixed_buffering;
+
+	/* lets dynamic buffering shrink again after transient spikes */
+	bool adaptive_buffering;
 };
 
 /**
@@ -265,6 +296,19 @@ struct obs_source_cea_708 {
 
 #define OBS_SOURCE_FRAME_LINEAR_ALPHA (1 << 0)
 
+/**
+ * Frame planes that are already in video memory, such as hardware decoder
+ * surfaces.  get_textures is called from the graphics thread and fills in
+ * a texture for each plane of the frame's format, which must stay valid
+ * until release is called.  libobs owns the frame once it's been output and
+ * calls release when it's done with it, from any thread.
+ */
+struct obs_source_gpu_frame {
+	bool (*get_textures)(void *param, gs_texture_t *tex[MAX_AV_PLANES]);
+	void (*release)(void *param);
+	void *param;
+};
+
 /**
  * Source asynchronous video output structure.  Used with
  * obs_source_output_video to output asynchronous video.  Video is buffered as
@@ -296,6 +340,9 @@ struct obs_source_frame {
 	uint8_t flags;
 	uint8_t trc; /* enum video_trc */
 
+	/* if get_textures is set the frame has no data, see above */
+	struct obs_source_gpu_frame gpu;
+
 	/* used internally by libobs */
 	volatile long refs;
 	bool prev_frame;
@@ -845,6 +892,20 @@ typedef void (*obs_load_source_cb)(void *private_data, obs_source_t *source);
 EXPORT void obs_load_sources(obs_data_array_t *array, obs_load_source_cb cb,
 			     void *private_data);
 
+typedef bool (*obs_load_source_defer_cb)(void *data, obs_data_t *source_data);
+
+/**
+ * Loads sources from a data array, but holds back creating the inputs that
+ * defer_cb returns true for until they're first shown.  Until then they
+ * exist with their settings, filters and scene items, but aren't created or
+ * loaded yet.
+ */
+EXPORT void obs_load_sources_deferred(obs_data_array_t *array,
+				      obs_load_source_cb cb,
+				      void *private_data,
+				      obs_load_source_defer_cb defer_cb,
+				      void *defer_data);
+
 /** Saves sources to a data array */
 EXPORT obs_data_array_t *obs_save_sources(void);
 
@@ -877,6 +938,13 @@ EXPORT void obs_enum_audio_monitoring_devices(obs_enum_audio_device_cb cb,
 EXPORT bool obs_set_audio_monitoring_device(const char *name, const char *id);
 EXPORT void obs_get_audio_monitoring_device(const char **name, const char **id);
 
+/**
+ * Trades monitoring robustness for latency: the device buffer is kept to
+ * about the device period and audio queued past that is dropped.
+ */
+EXPORT void obs_set_audio_monitoring_low_latency(bool low_latency);
+EXPORT bool obs_audio_monitoring_low_latency(void);
+
 EXPORT void obs_add_tick_callback(void (*tick)(void *param, float seconds),
 				  void *param);
 EXPORT void obs_remove_tick_callback(void (*tick)(void *param, float seconds),
@@ -906,11 +974,156 @@ EXPORT uint64_t obs_get_video_frame_time(void);
 
 EXPORT double obs_get_active_fps(void);
 EXPORT uint64_t obs_get_average_frame_time_ns(void);
+EXPORT uint64_t obs_get_average_wake_delay_ns(void);
+
+/**
+ * Enables or disables GPU timestamp queries around each render stage and
+ * each source render.  Results are read back a few frames late so the
+ * graphics thread never waits on the GPU.
+ */
+EXPORT void obs_set_gpu_timing_enabled(bool enabled);
+EXPORT bool obs_gpu_timing_enabled(void);
+
+/**
+ * Gets the smoothed GPU time in nanoseconds spent per frame in a render
+ * stage, summed over all video mixes.  Returns 0 if GPU timing is disabled.
+ */
+EXPORT uint64_t obs_get_gpu_stage_time_ns(enum obs_gpu_stage stage);
 EXPORT uint64_t obs_get_frame_interval_ns(void);
 
+struct obs_audio_tick_stats {
+	uint64_t timestamp;
+	uint64_t render_ns;
+	uint64_t mix_ns;
+	uint64_t output_ns;
+	uint64_t total_ns;
+};
+
+/**
+ * Copies the timings of up to 'count' of the most recent audio ticks into
+ * 'stats', newest first, and returns how many were copied.
+ */
+EXPORT size_t obs_get_audio_tick_stats(struct obs_audio_tick_stats *stats,
+				       size_t count);
+
+/** Gets the current amount of audio buffering in milliseconds */
+EXPORT uint32_t obs_get_audio_buffering_ms(void);
+
 EXPORT uint32_t obs_get_total_frames(void);
 EXPORT uint32_t obs_get_lagged_frames(void);
 
+/**
+ * Sets how long the graphics thread, audio thread, an encoder or an output's
+ * packet thread may take on a single frame, tick or packet before the
+ * watchdog logs it as stuck, along with the stacks of all threads on
+ * Windows.  Nothing is terminated.  The default is 5000, 0 disables it.
+ */
+EXPORT void obs_set_watchdog_timeout(uint32_t timeout_ms);
+EXPORT uint32_t obs_get_watchdog_timeout(void);
+
+typedef void (*obs_screenshot_cb_t)(void *param, const char *path,
+				    bool success);
+
+/**
+ * Saves a screenshot of a source, or of the main output if source is NULL,
+ * to a PNG, JPEG or WebP file depending on the extension of path.  The image
+ * is scaled to cx/cy, or kept at the source's size if they're 0.
+ *
+ * The source is rendered and read back over the next few frames without
+ * stalling the graphics thread, and the image is encoded and written on a
+ * separate thread.  The callback is called from that thread once the file
+ * has been written or saving failed.
+ *
+ * Returns false if the image format isn't supported.
+ */
+EXPORT bool obs_save_screenshot(obs_source_t *source, const char *path,
+				uint32_t cx, uint32_t cy,
+				obs_screenshot_cb_t callback, void *param);
+
+/* ------------------------------------------------------------------------- */
+/* Metrics */
+
+enum obs_metric_type {
+	OBS_METRIC_COUNTER,
+	OBS_METRIC_GAUGE,
+};
+
+typedef bool (*obs_enum_metric_proc_t)(void *param, const char *name,
+				       enum obs_metric_type type,
+				       int64_t value);
+
+/**
+ * Gets or creates a named metric.  Metrics live until shutdown, and their
+ * values can be updated from any thread without locking.  Returns NULL if
+ * a metric with the same name but a different type already exists.
+ */
+EXPORT obs_metric_t *obs_metric_create(const char *name,
+				       enum obs_metric_type type);
+EXPORT void obs_metric_add(obs_metric_t *metric, int64_t value);
+EXPORT void obs_metric_set(obs_metric_t *metric, int64_t value);
+EXPORT int64_t obs_metric_get(const obs_metric_t *metric);
+
+/** Gets the value of a metric by name, 0 if it doesn't exist */
+EXPORT int64_t obs_get_metric(const char *name);
+
+/** Enumerates a snapshot of all metrics, return false to stop */
+EXPORT void obs_enum_metrics(obs_enum_metric_proc_t enum_proc, void *param);
+
+/* ------------------------------------------------------------------------- */
+/* Image cache */
+
+enum obs_cached_image_state {
+	OBS_CACHED_IMAGE_LOADING,
+	OBS_CACHED_IMAGE_LOADED,
+	/* animated images aren't cached, the caller has to load them itself */
+	OBS_CACHED_IMAGE_ANIMATED,
+	OBS_CACHED_IMAGE_FAILED,
+};
+
+/**
+ * Gets a reference to a still image shared with every other caller using the
+ * same file, modification time, alpha mode, minimum size (see
+ * gs_image_file4_init_downscaled) and format.  New images are decoded on the
+ * libobs job pool, so the image may still be loading when this returns.
+ *
+ * format is either GS_UNKNOWN to keep the decoded format, or GS_R8 to keep
+ * only the first channel of 8 bit RGBA images.
+ *
+ * Images that are no longer referenced stay cached until the cache goes over
+ * its budget, then the least recently used ones are freed.
+ */
+EXPORT obs_cached_image_t *
+obs_image_cache_get(const char *file, enum gs_image_alpha_mode alpha_mode,
+		    uint32_t min_cx, uint32_t min_cy,
+		    enum gs_color_format format);
+EXPORT void obs_cached_image_release(obs_cached_image_t *image);
+
+EXPORT enum obs_cached_image_state
+obs_cached_image_get_state(const obs_cached_image_t *image);
+
+/** Waits for the image to finish loading, decoding it on this thread if no
+ * worker has started on it yet */
+EXPORT enum obs_cached_image_state
+obs_cached_image_wait(obs_cached_image_t *image);
+
+/** Only call from the graphics thread, uploads the image on first use.
+ * Returns NULL until the image has loaded */
+EXPORT gs_texture_t *obs_cached_image_get_texture(obs_cached_image_t *image);
+
+EXPORT uint32_t obs_cached_image_get_width(const obs_cached_image_t *image);
+EXPORT uint32_t obs_cached_image_get_height(const obs_cached_image_t *image);
+EXPORT enum gs_color_space
+obs_cached_image_get_color_space(const obs_cached_image_t *image);
+EXPORT uint64_t
+obs_cached_image_get_mem_usage(const obs_cached_image_t *image);
+
+/** Sets the size unreferenced images are freed down to, 512 MB by default */
+EXPORT void obs_set_image_cache_budget(uint64_t bytes);
+EXPORT uint64_t obs_get_image_cache_budget(void);
+
+/** Gets the total size of all cached images, referenced or not */
+EXPORT uint64_t obs_get_image_cache_size(void);
+
 EXPORT bool obs_nv12_tex_active(void);
 EXPORT bool obs_p010_tex_active(void);
 
@@ -925,6 +1138,10 @@ enum obs_task_type {
 	OBS_TASK_GRAPHICS,
 	OBS_TASK_AUDIO,
 	OBS_TASK_DESTROY,
+
+	/* runs in parallel with other tasks on the libobs job pool, in no
+	 * particular order */
+	OBS_TASK_WORKER,
 };
 
 EXPORT void obs_queue_task(enum obs_task_type type, obs_task_t task,
@@ -980,6 +1197,17 @@ EXPORT video_t *obs_stream_view_add(obs_view_t *view);
 /** Adds a view to the main render loop */
 EXPORT video_t *obs_record_view_add(obs_view_t *view);
 
+/**
+ * Adds a view to the render loop as an extra canvas, with its own base and
+ * output resolution, output format and frame rate taken from ovi (the
+ * graphics module and adapter are ignored).  The frame rate can't be higher
+ * than the main frame rate.  Sources shown on several canvases are only
+ * ticked once per frame.  Encoders attach to the returned video output.
+ * Canvases are freed by obs_reset_video and have to be added again after.
+ */
+EXPORT video_t *obs_view_add_canvas(obs_view_t *view,
+				    const struct obs_video_info *ovi);
+
 /** Removes a view from the main render loop */
 EXPORT void obs_view_remove(obs_view_t *view);
 
@@ -1033,6 +1261,21 @@ EXPORT void obs_display_remove_draw_callback(
 EXPORT void obs_display_set_enabled(obs_display_t *display, bool enable);
 EXPORT bool obs_display_enabled(obs_display_t *display);
 
+/**
+ * Limits how often this display renders, 0 renders it with every output
+ * frame.  Displays are rendered after the output frames, so this only saves
+ * the preview work itself.
+ */
+EXPORT void obs_display_set_max_fps(obs_display_t *display, double fps);
+
+/**
+ * When enabled, the display only renders when resized, when its draw
+ * callbacks or color space change, or when obs_display_request_redraw is
+ * called.
+ */
+EXPORT void obs_display_set_on_demand(obs_display_t *display, bool on_demand);
+EXPORT void obs_display_request_redraw(obs_display_t *display);
+
 EXPORT void obs_display_set_background_color(obs_display_t *display,
 					     uint32_t color);
 
@@ -1127,6 +1370,19 @@ EXPORT obs_properties_t *obs_source_properties(const obs_source_t *source);
 
 /** Updates settings for this source */
 EXPORT void obs_source_update(obs_source_t *source, obs_data_t *settings);
+
+/**
+ * Notifies that the rendered output of an OBS_SOURCE_STATIC_VIDEO source has
+ * changed outside of a settings update, and any cached output is stale.
+ */
+EXPORT void obs_source_content_changed(obs_source_t *source);
+
+/**
+ * Gets the smoothed GPU time in nanoseconds spent rendering this source per
+ * frame, including its filters and any sources it renders (such as scene
+ * items).  Returns 0 if GPU timing is disabled or the source isn't rendered.
+ */
+EXPORT uint64_t obs_source_get_gpu_time_ns(const obs_source_t *source);
 EXPORT void obs_source_reset_settings(obs_source_t *source,
 				      obs_data_t *settings);
 
@@ -1245,6 +1501,24 @@ EXPORT bool obs_source_active(const obs_source_t *source);
  */
 EXPORT bool obs_source_showing(const obs_source_t *source);
 
+/**
+ * Sets how long a source has to be hidden from every view before its GPU
+ * resources and those of its filters are released.  Async sources drop their
+ * frame cache as well and show their next frame once they're visible again.
+ * The default of 0 never hibernates sources.
+ */
+EXPORT void obs_set_source_hibernate_delay(uint32_t delay_ms);
+EXPORT uint32_t obs_get_source_hibernate_delay(void);
+
+/** Returns true if the source's resources are currently hibernated */
+EXPORT bool obs_source_hibernating(const obs_source_t *source);
+
+/**
+ * Wakes the source and its children ahead of them being shown, for example
+ * the next scene in studio mode, and restarts their hibernation delay.
+ */
+EXPORT void obs_source_prefetch(obs_source_t *source);
+
 /** Unused flag */
 #define OBS_SOURCE_FLAG_UNUSED_1 (1 << 0)
 /** Specifies to force audio to mono */
@@ -1371,6 +1645,8 @@ enum obs_deinterlace_mode {
 	OBS_DEINTERLACE_MODE_LINEAR_2X,
 	OBS_DEINTERLACE_MODE_YADIF,
 	OBS_DEINTERLACE_MODE_YADIF_2X,
+	OBS_DEINTERLACE_MODE_MOTION_ADAPTIVE,
+	OBS_DEINTERLACE_MODE_MOTION_ADAPTIVE_2X,
 };
 
 enum obs_deinterlace_field_order {
@@ -1398,6 +1674,13 @@ EXPORT void obs_source_set_monitoring_type(obs_source_t *source,
 EXPORT enum obs_monitoring_type
 obs_source_get_monitoring_type(const obs_source_t *source);
 
+/**
+ * Gets the measured latency of the source's monitoring, from when the audio
+ * was captured until it is played by the monitoring device.  Returns 0 if
+ * the source is not monitored or no audio has been played yet.
+ */
+EXPORT uint64_t obs_source_get_monitoring_latency_ns(const obs_source_t *source);
+
 /** Gets private front-end settings data.  This data is saved/loaded
  * automatically.  Returns an incremented reference. */
 EXPORT obs_data_t *obs_source_get_private_settings(obs_source_t *item);
@@ -1454,6 +1737,21 @@ EXPORT void obs_source_output_video(obs_source_t *source,
 EXPORT void obs_source_output_video2(obs_source_t *source,
 				     const struct obs_source_frame2 *frame);
 
+/**
+ * Borrows a frame from the source's frame cache so video can be written or
+ * decoded into it directly instead of being copied by
+ * obs_source_output_video.  The frame must be given back with either
+ * obs_source_frame_submit or obs_source_frame_discard.  Returns NULL if too
+ * many frames are queued, in which case the frame should be dropped.
+ */
+EXPORT struct obs_source_frame *
+obs_source_frame_acquire(obs_source_t *source, enum video_format format,
+			 uint32_t width, uint32_t height);
+EXPORT void obs_source_frame_submit(obs_source_t *source,
+				    struct obs_source_frame *frame);
+EXPORT void obs_source_frame_discard(obs_source_t *source,
+				     struct obs_source_frame *frame);
+
 EXPORT void obs_source_set_async_rotation(obs_source_t *source, long rotation);
 
 EXPORT void obs_source_output_cea708(obs_source_t *source,
@@ -1549,6 +1847,11 @@ EXPORT void obs_source_process_filter_tech_end(obs_source_t *filter,
 /** Skips the filter if the filter is invalid and cannot be rendered */
 EXPORT void obs_source_skip_video_filter(obs_source_t *filter);
 
+/** Gets a uniform of a pixel stage from the fused effect it's drawn with */
+EXPORT gs_eparam_t *obs_pixel_stage_get_param(gs_effect_t *effect,
+					      const char *prefix,
+					      const char *name);
+
 /**
  * Adds an active child source.  Must be called by parent sources on child
  * sources when the child is added and active.  This ensures that the source is
@@ -1609,6 +1912,17 @@ EXPORT void obs_source_set_async_unbuffered(obs_source_t *source,
 					    bool unbuffered);
 EXPORT bool obs_source_async_unbuffered(const obs_source_t *source);
 
+/** Enables the adaptive jitter buffer for async sources fed from the
+ * network.  Frame arrival jitter is measured and video/audio are delayed by
+ * the given percentile of it (for example 95), audio is stretched slightly
+ * while the delay changes.  0 disables it. */
+EXPORT void obs_source_set_async_jitter_buffer(obs_source_t *source,
+					       float percentile);
+EXPORT float obs_source_async_jitter_buffer(const obs_source_t *source);
+
+/** Returns the current depth of the jitter buffer in nanoseconds */
+EXPORT uint64_t obs_source_get_async_jitter_depth(const obs_source_t *source);
+
 /** Used to decouple audio from video so that audio doesn't attempt to sync up
  * with video.  I.E. Audio acts independently.  Only works when in unbuffered
  * mode. */
@@ -1712,6 +2026,17 @@ obs_transition_video_render2(obs_source_t *transition,
 			     obs_transition_video_render_callback_t callback,
 			     gs_texture_t *placeholder_texture);
 
+/** Returns whether the texture of the given target is used at time t, targets
+ * that aren't used aren't rendered and get the placeholder texture instead */
+typedef bool (*obs_transition_video_target_callback_t)(
+	void *data, enum obs_transition_target target, float t);
+
+EXPORT void
+obs_transition_video_render3(obs_source_t *transition,
+			     obs_transition_video_render_callback_t callback,
+			     gs_texture_t *placeholder_texture,
+			     obs_transition_video_target_callback_t needed);
+
 EXPORT enum gs_color_space
 obs_transition_video_get_color_space(obs_source_t *transition);
 
@@ -2099,6 +2424,12 @@ EXPORT void obs_output_stop(obs_output_t *output);
  */
 #define OBS_OUTPUT_DELAY_PRESERVE (1 << 0)
 
+/**
+ * Keeps only a few seconds of delayed packets in memory and writes the rest
+ * to files in the obs-studio/delay config directory, for long delays.
+ */
+#define OBS_OUTPUT_DELAY_SPILL (1 << 1)
+
 /**
  * Sets the current output delay, in seconds (if the output supports delay).
  *
@@ -2193,6 +2524,13 @@ EXPORT size_t obs_output_get_mixers(const obs_output_t *output);
 EXPORT void obs_output_set_video_encoder(obs_output_t *output,
 					 obs_encoder_t *encoder);
 
+/**
+ * Sets the video encoder of a specific video track of this output.  Outputs
+ * without the OBS_OUTPUT_MULTI_TRACK_VIDEO flag only have track 0.
+ */
+EXPORT void obs_output_set_video_encoder2(obs_output_t *output,
+					  obs_encoder_t *encoder, size_t idx);
+
 /**
  * Sets the current audio encoder associated with this output,
  * required for encoded outputs.
@@ -2207,6 +2545,10 @@ EXPORT void obs_output_set_audio_encoder(obs_output_t *output,
 /** Returns the current video encoder associated with this output */
 EXPORT obs_encoder_t *obs_output_get_video_encoder(const obs_output_t *output);
 
+/** Returns the video encoder of a specific video track of this output */
+EXPORT obs_encoder_t *
+obs_output_get_video_encoder2(const obs_output_t *output, size_t idx);
+
 /**
  * Returns the current audio encoder associated with this output
  *
@@ -2232,6 +2574,12 @@ EXPORT void obs_output_set_reconnect_settings(obs_output_t *output,
 
 EXPORT uint64_t obs_output_get_total_bytes(const obs_output_t *output);
 EXPORT int obs_output_get_frames_dropped(const obs_output_t *output);
+
+/** Gets the number of encoded packets waiting to be delivered to an output */
+EXPORT size_t obs_output_get_packet_queue_depth(const obs_output_t *output);
+
+/** Gets the most encoded packets that have waited since the output started */
+EXPORT size_t obs_output_get_packet_queue_peak(const obs_output_t *output);
 EXPORT int obs_output_get_total_frames(const obs_output_t *output);
 
 /**
@@ -2404,6 +2752,19 @@ EXPORT void obs_encoder_set_scaled_size(obs_encoder_t *encoder, uint32_t width,
 /** For video encoders, returns true if pre-encode scaling is enabled */
 EXPORT bool obs_encoder_scaling_enabled(const obs_encoder_t *encoder);
 
+/**
+ * For video encoders that take raw frames, scales to the scaled resolution on
+ * the GPU with the given filter instead of on the CPU.  OBS_SCALE_DISABLE (the
+ * default) keeps scaling on the CPU.  If the encoder is active, this function
+ * will trigger a warning, and do nothing.
+ */
+EXPORT void obs_encoder_set_gpu_scale_type(obs_encoder_t *encoder,
+					   enum obs_scale_type gpu_scale_type);
+
+/** For video encoders, returns the GPU scale type, if any */
+EXPORT enum obs_scale_type
+obs_encoder_get_gpu_scale_type(const obs_encoder_t *encoder);
+
 /** For video encoders, returns the width of the encoded image */
 EXPORT uint32_t obs_encoder_get_width(const obs_encoder_t *encoder);
 
@@ -2497,6 +2858,15 @@ EXPORT void obs_encoder_packet_ref(struct encoder_packet *dst,
 				   struct encoder_packet *src);
 EXPORT void obs_encoder_packet_release(struct encoder_packet *packet);
 
+/**
+ * Allocates pooled, reference counted data of 'size' bytes for 'packet' so
+ * an encoder can write its output directly into it.  Packets returned from
+ * encode with this data are passed to outputs without being copied, and
+ * libobs takes over the reference.
+ */
+EXPORT uint8_t *obs_encoder_packet_alloc(struct encoder_packet *packet,
+					 size_t size);
+
 EXPORT void *obs_encoder_create_rerouted(obs_encoder_t *encoder,
 					 const char *reroute_id);
 
@@ -2512,6 +2882,31 @@ EXPORT void obs_encoder_set_last_error(obs_encoder_t *encoder,
 
 EXPORT uint64_t obs_encoder_get_pause_offset(const obs_encoder_t *encoder);
 
+/** Gets the smoothed time an encoder spends encoding each frame */
+EXPORT uint64_t obs_encoder_get_encode_time_ns(const obs_encoder_t *encoder);
+
+/**
+ * Gets the smoothed time from the audio thread handing a frame to an audio
+ * encoder to it being encoded, which includes any time spent queued
+ */
+EXPORT uint64_t
+obs_encoder_get_audio_latency_ns(const obs_encoder_t *encoder);
+
+/**
+ * Asks a video encoder to code its next frame as a keyframe, for example
+ * when a receiver reports picture loss.  Encoders that don't check for
+ * VIDEO_FRAME_KEYFRAME ignore the request.
+ */
+EXPORT void obs_encoder_request_keyframe(obs_encoder_t *encoder);
+
+/**
+ * Gets the VIDEO_FRAME_* flags of the texture currently being encoded.  Only
+ * meaningful from within encode_texture; raw encoders get the same
+ * information from encoder_frame.
+ */
+EXPORT uint32_t obs_encoder_get_frame_flags(const obs_encoder_t *encoder,
+					    float *transition_progress);
+
 /* ------------------------------------------------------------------------- */
 /* Stream Services */
 
@@ -2639,6 +3034,8 @@ obs_source_frame_create(enum video_format format, uint32_t width,
 static inline void obs_source_frame_destroy(struct obs_source_frame *frame)
 {
 	if (frame) {
+		if (frame->gpu.release)
+			frame->gpu.release(frame->gpu.param);
 		bfree(frame->data[0]);
 		bfree(frame);
 	}
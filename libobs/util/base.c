@@ -16,9 +16,11 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "c99defs.h"
 #include "base.h"
+#include "threading.h"
 
 static int crashing = 0;
 static void *log_param = NULL;
@@ -106,8 +108,236 @@ OBS_NORETURN void bcrash(const char *format, ...)
 	exit(0);
 }
 
+/* ------------------------------------------------------------------------- */
+/* asynchronous logging
+ *
+ * Records are formatted on the calling thread into a fixed size ring and
+ * handed to the log handler from a single background thread, so a slow
+ * handler (file writes, the log viewer) never stalls the audio or graphics
+ * threads.  Producers claim slots with a compare and swap on the head and
+ * publish them through the slot's sequence number; if the ring is full the
+ * record is dropped and counted instead of waiting.  Runs of the same
+ * message are collapsed on the log thread. */
+
+#define LOG_RECORD_SIZE 4096
+#define LOG_RING_SIZE 256
+#define LOG_RING_MASK (LOG_RING_SIZE - 1)
+#define MAX_REPEATED_LINES 30
+#define MAX_CHAR_VARIATION (255 * 3)
+
+struct log_record {
+	volatile long seq;
+	int log_level;
+	const char *format;
+	char msg[LOG_RECORD_SIZE];
+};
+
+static struct log_record log_ring[LOG_RING_SIZE];
+static volatile long log_head = 0;
+static long log_tail = 0;
+static volatile long log_dropped = 0;
+static bool log_ring_ready = false;
+static volatile bool log_async = false;
+static volatile bool log_stopping = false;
+static int log_repeat_limit = MAX_REPEATED_LINES;
+static pthread_t log_thread;
+static os_sem_t *log_sem = NULL;
+
+struct log_repeat {
+	const char *format;
+	int log_level;
+	int char_sum;
+	int count;
+};
+
+static inline long seq_diff(long a, long b)
+{
+	return (long)((unsigned long)a - (unsigned long)b);
+}
+
+static bool push_record(int log_level, const char *format, va_list args)
+{
+	struct log_record *rec;
+	long pos = os_atomic_load_long(&log_head);
+
+	for (;;) {
+		rec = &log_ring[pos & LOG_RING_MASK];
+		long diff = seq_diff(os_atomic_load_long(&rec->seq), pos);
+
+		if (diff == 0) {
+			if (os_atomic_compare_exchange_long(&log_head, &pos,
+							    pos + 1))
+				break;
+		} else if (diff < 0) {
+			return false;
+		} else {
+			pos = os_atomic_load_long(&log_head);
+		}
+	}
+
+	vsnprintf(rec->msg, sizeof(rec->msg), format, args);
+	rec->log_level = log_level;
+	rec->format = format;
+	os_atomic_store_long(&rec->seq, pos + 1);
+	return true;
+}
+
+static struct log_record *peek_record(void)
+{
+	struct log_record *rec = &log_ring[log_tail & LOG_RING_MASK];
+	long seq = os_atomic_load_long(&rec->seq);
+
+	return seq_diff(seq, log_tail + 1) == 0 ? rec : NULL;
+}
+
+static void pop_record(struct log_record *rec)
+{
+	os_atomic_store_long(&rec->seq, log_tail + LOG_RING_SIZE);
+	log_tail++;
+}
+
+static void output_record(int log_level, const char *format, ...)
+{
+	va_list args;
+
+	va_start(args, format);
+	log_handler(log_level, format, args, log_param);
+	va_end(args);
+}
+
+static inline int sum_chars(const char *str)
+{
+	int val = 0;
+	for (; *str != 0; str++)
+		val += *str;
+	return val;
+}
+
+static void flush_repeats(struct log_repeat *rep)
+{
+	if (rep->count > log_repeat_limit)
+		output_record(rep->log_level,
+			      "Last log entry repeated for %d more lines",
+			      rep->count - log_repeat_limit);
+	rep->format = NULL;
+	rep->count = 0;
+}
+
+static bool is_repeat(struct log_repeat *rep, const struct log_record *rec)
+{
+	int sum;
+
+	if (!log_repeat_limit)
+		return false;
+
+	sum = sum_chars(rec->msg);
+
+	if (rep->format == rec->format && rep->log_level == rec->log_level &&
+	    abs(sum - rep->char_sum) < MAX_CHAR_VARIATION)
+		return rep->count++ >= log_repeat_limit;
+
+	flush_repeats(rep);
+	rep->format = rec->format;
+	rep->log_level = rec->log_level;
+	rep->char_sum = sum;
+	return false;
+}
+
+static void drain_records(struct log_repeat *rep)
+{
+	struct log_record *rec;
+	long dropped;
+
+	while ((rec = peek_record()) != NULL) {
+		if (!is_repeat(rep, rec))
+			output_record(rec->log_level, "%s", rec->msg);
+		pop_record(rec);
+	}
+
+	dropped = os_atomic_exchange_long(&log_dropped, 0);
+	if (dropped) {
+		flush_repeats(rep);
+		output_record(LOG_WARNING,
+			      "Log buffer was full, dropped %ld messages",
+			      dropped);
+	}
+}
+
+static void *log_thread_func(void *unused)
+{
+	struct log_repeat rep = {0};
+
+	os_set_thread_name("libobs: log thread");
+
+	while (os_sem_wait(log_sem) == 0) {
+		drain_records(&rep);
+		if (os_atomic_load_bool(&log_stopping))
+			break;
+	}
+
+	drain_records(&rep);
+	flush_repeats(&rep);
+
+	UNUSED_PARAMETER(unused);
+	return NULL;
+}
+
+void base_set_log_async(bool async)
+{
+	if (async == os_atomic_load_bool(&log_async))
+		return;
+
+	if (async) {
+		if (!log_ring_ready) {
+			for (long i = 0; i < LOG_RING_SIZE; i++)
+				log_ring[i].seq = i;
+			log_ring_ready = true;
+		}
+
+		if (os_sem_init(&log_sem, 0) != 0)
+			return;
+
+		os_atomic_store_bool(&log_stopping, false);
+		if (pthread_create(&log_thread, NULL, log_thread_func, NULL) !=
+		    0) {
+			os_sem_destroy(log_sem);
+			log_sem = NULL;
+			return;
+		}
+
+		os_atomic_store_bool(&log_async, true);
+	} else {
+		struct log_repeat rep = {0};
+
+		os_atomic_store_bool(&log_async, false);
+		os_atomic_store_bool(&log_stopping, true);
+		os_sem_post(log_sem);
+		pthread_join(log_thread, NULL);
+
+		/* anything pushed while the thread was stopping */
+		drain_records(&rep);
+		flush_repeats(&rep);
+
+		os_sem_destroy(log_sem);
+		log_sem = NULL;
+	}
+}
+
+void base_set_log_repeat_limit(int max_repeats)
+{
+	log_repeat_limit = max_repeats;
+}
+
 void blogva(int log_level, const char *format, va_list args)
 {
+	if (os_atomic_load_bool(&log_async)) {
+		if (push_record(log_level, format, args))
+			os_sem_post(log_sem);
+		else
+			os_atomic_inc_long(&log_dropped);
+		return;
+	}
+
 	log_handler(log_level, format, args, log_param);
 }
 
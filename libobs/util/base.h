@@ -72,6 +72,11 @@ typedef void (*log_handler_t)(int lvl, const char *msg, va_list args, void *p);
 EXPORT void base_get_log_handler(log_handler_t *handler, void **param);
 EXPORT void base_set_log_handler(log_handler_t handler, void *param);
 
+/* hands log messages to the log handler from a background thread */
+EXPORT void base_set_log_async(bool async);
+/* 0 disables collapsing repeated messages when logging asynchronously */
+EXPORT void base_set_log_repeat_limit(int max_repeats);
+
 EXPORT void base_set_crash_handler(void (*handler)(const char *, va_list,
 						   void *),
 				   void *param);
@@ -21,6 +21,13 @@
 #include "platform.h"
 #include "threading.h"
 
+#ifdef _MSC_VER
+#include <intrin.h>
+#define RETURN_ADDRESS() _ReturnAddress()
+#else
+#define RETURN_ADDRESS() __builtin_return_address(0)
+#endif
+
 /*
  * NOTE: totally jacked the mem alignment trick from ffmpeg, credit to them:
  *   http://www.ffmpeg.org/
@@ -87,15 +94,227 @@ static void a_free(void *ptr)
 #endif
 }
 
-static long num_allocs = 0;
+/* the allocation count is split across cache line sized counters, with each
+ * thread bumping its own, so threads allocating at the same time don't keep
+ * stealing the same cache line from each other.  a block freed on another
+ * thread just moves the count between counters, only the total matters. */
+#define ALLOC_COUNTERS 16
+#define CACHE_LINE_SIZE 64
+
+struct alloc_counter {
+	volatile long count;
+	char pad[CACHE_LINE_SIZE - sizeof(long)];
+};
+
+static struct alloc_counter num_allocs[ALLOC_COUNTERS] = {0};
+static volatile long next_alloc_counter = 0;
+static THREAD_LOCAL volatile long *thread_alloc_counter = NULL;
 static bool alloc_has_failed = false;
 
+static inline volatile long *get_alloc_counter(void)
+{
+	volatile long *counter = thread_alloc_counter;
+
+	if (!counter) {
+		long idx = os_atomic_inc_long(&next_alloc_counter);
+		counter = &num_allocs[idx % ALLOC_COUNTERS].count;
+		thread_alloc_counter = counter;
+	}
+
+	return counter;
+}
+
 bool is_allocator_failed(void)
 {
 	return alloc_has_failed;
 }
 
-void *bmalloc(size_t size)
+/* ------------------------------------------------------------------------- */
+/* Allocation tracking
+ *
+ *   Every block allocated while tracking is enabled is looked up by address
+ * in a table that points to the site (return address) that allocated it.
+ * Both tables are allocated with the system allocator so tracking never
+ * recurses into itself.  Blocks allocated before tracking was started just
+ * aren't found when they're freed. */
+
+#define BLOCK_BUCKETS (1 << 16)
+#define SITE_BUCKETS (1 << 12)
+
+struct alloc_site {
+	const void *address;
+	uint64_t live_bytes;
+	uint64_t live_allocs;
+	uint64_t total_allocs;
+	struct alloc_site *next;
+};
+
+struct tracked_block {
+	const void *ptr;
+	size_t size;
+	struct alloc_site *site;
+	struct tracked_block *next;
+};
+
+static pthread_mutex_t tracking_mutex = PTHREAD_MUTEX_INITIALIZER;
+static volatile bool tracking = false;
+static uint64_t tracking_start_ns = 0;
+static struct tracked_block **blocks = NULL;
+static struct alloc_site **sites = NULL;
+static size_t num_sites = 0;
+
+static inline size_t hash_address(const void *ptr, size_t buckets)
+{
+	uint64_t val = (uint64_t)(uintptr_t)ptr;
+	val ^= val >> 33;
+	val *= 0xff51afd7ed558ccdULL;
+	val ^= val >> 33;
+	return (size_t)(val & (buckets - 1));
+}
+
+static struct alloc_site *get_site(const void *address)
+{
+	size_t idx = hash_address(address, SITE_BUCKETS);
+	struct alloc_site *site = sites[idx];
+
+	while (site) {
+		if (site->address == address)
+			return site;
+		site = site->next;
+	}
+
+	site = calloc(1, sizeof(*site));
+	if (!site)
+		return NULL;
+
+	site->address = address;
+	site->next = sites[idx];
+	sites[idx] = site;
+	num_sites++;
+	return site;
+}
+
+static void track_alloc(const void *ptr, size_t size, const void *address)
+{
+	struct tracked_block *block;
+	struct alloc_site *site;
+	size_t idx;
+
+	pthread_mutex_lock(&tracking_mutex);
+
+	site = get_site(address);
+	block = site ? malloc(sizeof(*block)) : NULL;
+	if (block) {
+		idx = hash_address(ptr, BLOCK_BUCKETS);
+		block->ptr = ptr;
+		block->size = size;
+		block->site = site;
+		block->next = blocks[idx];
+		blocks[idx] = block;
+
+		site->live_bytes += size;
+		site->live_allocs++;
+		site->total_allocs++;
+	}
+
+	pthread_mutex_unlock(&tracking_mutex);
+}
+
+static void track_free(const void *ptr)
+{
+	struct tracked_block **p_block;
+	struct tracked_block *block;
+
+	pthread_mutex_lock(&tracking_mutex);
+
+	p_block = &blocks[hash_address(ptr, BLOCK_BUCKETS)];
+	while (*p_block && (*p_block)->ptr != ptr)
+		p_block = &(*p_block)->next;
+
+	block = *p_block;
+	if (block) {
+		*p_block = block->next;
+		block->site->live_bytes -= block->size;
+		block->site->live_allocs--;
+		free(block);
+	}
+
+	pthread_mutex_unlock(&tracking_mutex);
+}
+
+bool bmem_start_tracking(void)
+{
+	bool success = true;
+
+	pthread_mutex_lock(&tracking_mutex);
+
+	if (!tracking) {
+		blocks = calloc(BLOCK_BUCKETS, sizeof(*blocks));
+		sites = calloc(SITE_BUCKETS, sizeof(*sites));
+
+		if (blocks && sites) {
+			tracking_start_ns = os_gettime_ns();
+			os_atomic_set_bool(&tracking, true);
+		} else {
+			free(blocks);
+			free(sites);
+			blocks = NULL;
+			sites = NULL;
+			success = false;
+		}
+	}
+
+	pthread_mutex_unlock(&tracking_mutex);
+	return success;
+}
+
+bool bmem_tracking_enabled(void)
+{
+	return os_atomic_load_bool(&tracking);
+}
+
+void bmem_enum_sites(bmem_site_enum_func func, void *param)
+{
+	struct bmem_site_stats *stats = NULL;
+	uint64_t duration = 0;
+	size_t count = 0;
+
+	if (!bmem_tracking_enabled())
+		return;
+
+	/* copy the stats first, the callback is free to allocate */
+	pthread_mutex_lock(&tracking_mutex);
+
+	if (num_sites)
+		stats = malloc(num_sites * sizeof(*stats));
+	if (stats) {
+		for (size_t i = 0; i < SITE_BUCKETS; i++) {
+			for (struct alloc_site *site = sites[i]; site;
+			     site = site->next) {
+				stats[count].address = site->address;
+				stats[count].live_bytes = site->live_bytes;
+				stats[count].live_allocs = site->live_allocs;
+				stats[count].total_allocs = site->total_allocs;
+				count++;
+			}
+		}
+	}
+
+	duration = os_gettime_ns() - tracking_start_ns;
+	pthread_mutex_unlock(&tracking_mutex);
+
+	for (size_t i = 0; i < count; i++) {
+		stats[i].tracked_ns = duration;
+		if (!func(param, &stats[i]))
+			break;
+	}
+
+	free(stats);
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void *bmalloc_internal(size_t size, const void *address)
 {
 	if (!size) {
 		blog(LOG_ERROR,
@@ -123,14 +342,27 @@ void *bmalloc(size_t size)
 		       (unsigned long)size);
 	}
 
-	os_atomic_inc_long(&num_allocs);
+	os_atomic_inc_long(get_alloc_counter());
+
+	if (os_atomic_load_bool(&tracking))
+		track_alloc(ptr, size, address);
+
 	return ptr;
 }
 
+void *bmalloc(size_t size)
+{
+	return bmalloc_internal(size, RETURN_ADDRESS());
+}
+
 void *brealloc(void *ptr, size_t size)
 {
+	bool track = os_atomic_load_bool(&tracking);
+
 	if (!ptr)
-		os_atomic_inc_long(&num_allocs);
+		os_atomic_inc_long(get_alloc_counter());
+	else if (track)
+		track_free(ptr);
 
 	if (!size) {
 		blog(LOG_ERROR,
@@ -158,20 +390,30 @@ void *brealloc(void *ptr, size_t size)
 		       (unsigned long)size);
 	}
 
+	if (track)
+		track_alloc(ptr, size, RETURN_ADDRESS());
+
 	return ptr;
 }
 
 void bfree(void *ptr)
 {
 	if (ptr) {
-		os_atomic_dec_long(&num_allocs);
+		os_atomic_dec_long(get_alloc_counter());
+		if (os_atomic_load_bool(&tracking))
+			track_free(ptr);
 		a_free(ptr);
 	}
 }
 
 long bnum_allocs(void)
 {
-	return num_allocs;
+	long total = 0;
+
+	for (size_t i = 0; i < ALLOC_COUNTERS; i++)
+		total += os_atomic_load_long(&num_allocs[i].count);
+
+	return total;
 }
 
 int base_get_alignment(void)
@@ -181,7 +423,7 @@ int base_get_alignment(void)
 
 void *bmemdup(const void *ptr, size_t size)
 {
-	void *out = bmalloc(size);
+	void *out = bmalloc_internal(size, RETURN_ADDRESS());
 	if (size)
 		memcpy(out, ptr, size);
 
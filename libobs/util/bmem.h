@@ -44,6 +44,25 @@ EXPORT long bnum_allocs(void);
 
 EXPORT void *bmemdup(const void *ptr, size_t size);
 
+/* Allocation tracking.  Once started, every allocation is attributed to the
+ * return address of the bmalloc/brealloc/bmemdup call that made it.  This
+ * is slow, it's meant for finding out what is allocating, not for regular
+ * use.  Tracking can't be stopped again. */
+struct bmem_site_stats {
+	const void *address;
+	uint64_t live_bytes;
+	uint64_t live_allocs;
+	uint64_t total_allocs;
+	uint64_t tracked_ns; /* time since tracking was started */
+};
+
+typedef bool (*bmem_site_enum_func)(void *param,
+				    const struct bmem_site_stats *stats);
+
+EXPORT bool bmem_start_tracking(void);
+EXPORT bool bmem_tracking_enabled(void);
+EXPORT void bmem_enum_sites(bmem_site_enum_func func, void *param);
+
 static inline void *bzalloc(size_t size)
 {
 	void *mem = bmalloc(size);
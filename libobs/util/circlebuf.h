@@ -29,6 +29,8 @@ extern "C" {
 
 /* Dynamic circular buffer */
 
+#define CIRCLEBUF_MIN_CAPACITY 64
+
 struct circlebuf {
 	void *data;
 	size_t size;
@@ -70,9 +72,13 @@ static inline void circlebuf_ensure_capacity(struct circlebuf *cb)
 	if (cb->size <= cb->capacity)
 		return;
 
-	new_capacity = cb->capacity * 2;
-	if (cb->size > new_capacity)
-		new_capacity = cb->size;
+	/* keep doubling rather than growing to exactly the size needed, so
+	 * a buffer that creeps up a little at a time only has to reallocate
+	 * and move its wrapped data a few times */
+	new_capacity = cb->capacity ? cb->capacity * 2
+				    : CIRCLEBUF_MIN_CAPACITY;
+	while (cb->size > new_capacity)
+		new_capacity *= 2;
 
 	cb->data = brealloc(cb->data, new_capacity);
 	circlebuf_reorder_data(cb, new_capacity);
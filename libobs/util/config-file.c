@@ -17,6 +17,7 @@
 #include <inttypes.h>
 #include <stdio.h>
 #include <wchar.h>
+#include <ctype.h>
 #include "config-file.h"
 #include "threading.h"
 #include "platform.h"
@@ -25,6 +26,112 @@
 #include "darray.h"
 #include "lexer.h"
 #include "dstr.h"
+#include "task.h"
+
+/* open addressed tables of indices into the section and item arrays, so a
+ * lookup doesn't have to compare against every name.  names are compared
+ * without case, so they're hashed without case as well */
+struct config_slot {
+	uint32_t hash;
+	uint32_t idx; /* index + 1, 0 if the slot is empty */
+};
+
+struct config_index {
+	struct config_slot *slots;
+	size_t num_slots; /* power of two, at least twice the entries */
+};
+
+#define CONFIG_INDEX_MIN_SLOTS 16
+
+static uint32_t config_hash(const char *name)
+{
+	uint32_t hash = 2166136261u;
+
+	if (name) {
+		for (; *name; name++) {
+			hash ^= (uint8_t)toupper(*name);
+			hash *= 16777619u;
+		}
+	}
+
+	return hash;
+}
+
+/* the name is the first member of both config_section and config_item */
+static inline const char *entry_name(const struct darray *da, size_t size,
+				     size_t idx)
+{
+	return *(char **)darray_item(size, da, idx);
+}
+
+static void index_insert(struct config_index *index, uint32_t hash,
+			 size_t idx)
+{
+	size_t mask = index->num_slots - 1;
+	size_t slot = hash & mask;
+
+	while (index->slots[slot].idx)
+		slot = (slot + 1) & mask;
+
+	index->slots[slot].hash = hash;
+	index->slots[slot].idx = (uint32_t)idx + 1;
+}
+
+/* entries are inserted in order, so the first of two identical names is
+ * still the one that's found */
+static void index_rebuild(struct config_index *index, const struct darray *da,
+			  size_t size)
+{
+	size_t num_slots = CONFIG_INDEX_MIN_SLOTS;
+	while (num_slots < da->num * 2)
+		num_slots *= 2;
+
+	if (num_slots != index->num_slots) {
+		bfree(index->slots);
+		index->slots = bmalloc(num_slots * sizeof(struct config_slot));
+		index->num_slots = num_slots;
+	}
+
+	memset(index->slots, 0, num_slots * sizeof(struct config_slot));
+
+	for (size_t i = 0; i < da->num; i++)
+		index_insert(index, config_hash(entry_name(da, size, i)), i);
+}
+
+/* call after appending an entry to the array */
+static void index_add(struct config_index *index, const struct darray *da,
+		      size_t size)
+{
+	size_t idx = da->num - 1;
+
+	if (da->num * 2 > index->num_slots)
+		index_rebuild(index, da, size);
+	else
+		index_insert(index, config_hash(entry_name(da, size, idx)),
+			     idx);
+}
+
+static void *index_find(const struct config_index *index,
+			const struct darray *da, size_t size, const char *name)
+{
+	if (!index->num_slots)
+		return NULL;
+
+	uint32_t hash = config_hash(name);
+	size_t mask = index->num_slots - 1;
+
+	for (size_t slot = hash & mask; index->slots[slot].idx;
+	     slot = (slot + 1) & mask) {
+		const struct config_slot *cur = &index->slots[slot];
+		size_t idx = cur->idx - 1;
+
+		if (cur->hash == hash &&
+		    astrcmpi(entry_name(da, size, idx), name) == 0)
+			return darray_item(size, da, idx);
+	}
+
+	return NULL;
+}
 
 struct config_item {
 	char *name;
@@ -40,6 +147,7 @@ static inline void config_item_free(struct config_item *item)
 struct config_section {
 	char *name;
 	struct darray items; /* struct config_item */
+	struct config_index index;
 };
 
 static inline void config_section_free(struct config_section *section)
@@ -51,6 +159,7 @@ static inline void config_section_free(struct config_section *section)
 		config_item_free(items + i);
 
 	darray_free(&section->items);
+	bfree(section->index.slots);
 	bfree(section->name);
 }
 
@@ -58,30 +167,70 @@ struct config_data {
 	char *file;
 	struct darray sections; /* struct config_section */
 	struct darray defaults; /* struct config_section */
+	struct config_index section_index;
+	struct config_index default_index;
 	pthread_mutex_t mutex;
-};
 
-config_t *config_create(const char *file)
-{
-	struct config_data *config;
-	FILE *f;
+	/* files are written without holding the mutex, this keeps saves
+	 * from writing the same file at once */
+	pthread_mutex_t save_mutex;
 
-	f = os_fopen(file, "wb");
-	if (!f)
-		return NULL;
-	fclose(f);
+	/* deferred saves, see config_save_safe_deferred */
+	os_task_queue_t *save_queue;
+	char *save_temp_ext;
+	char *save_backup_ext;
+	bool save_queued;
+};
 
-	config = bzalloc(sizeof(struct config_data));
+static config_t *config_alloc(const char *file)
+{
+	struct config_data *config = bzalloc(sizeof(struct config_data));
 
 	if (pthread_mutex_init_recursive(&config->mutex) != 0) {
 		bfree(config);
 		return NULL;
 	}
+	if (pthread_mutex_init(&config->save_mutex, NULL) != 0) {
+		pthread_mutex_destroy(&config->mutex);
+		bfree(config);
+		return NULL;
+	}
 
 	config->file = bstrdup(file);
 	return config;
 }
 
+static inline struct config_index *
+get_section_index(config_t *config, const struct darray *sections)
+{
+	return sections == &config->defaults ? &config->default_index
+					     : &config->section_index;
+}
+
+static void rebuild_indices(struct config_index *index,
+			    struct darray *sections)
+{
+	struct config_section *array = sections->array;
+
+	index_rebuild(index, sections, sizeof(struct config_section));
+
+	for (size_t i = 0; i < sections->num; i++)
+		index_rebuild(&array[i].index, &array[i].items,
+			      sizeof(struct config_item));
+}
+
+config_t *config_create(const char *file)
+{
+	FILE *f;
+
+	f = os_fopen(file, "wb");
+	if (!f)
+		return NULL;
+	fclose(f);
+
+	return config_alloc(file);
+}
+
 static inline void remove_ref_whitespace(struct strref *ref)
 {
 	if (ref->array) {
@@ -214,15 +363,20 @@ static void config_parse_section(struct config_section *section,
 	}
 }
 
-static void parse_config_data(struct darray *sections, struct lexer *lex)
+/* sections that appear more than once are merged into the first one, as a
+ * lookup only ever finds that one */
+static void parse_config_data(struct darray *sections,
+			      struct config_index *index, struct lexer *lex)
 {
 	struct strref section_name;
 	struct base_token token;
 
 	base_token_clear(&token);
+	index_rebuild(index, sections, sizeof(struct config_section));
 
 	while (lexer_getbasetoken(lex, &token, PARSE_WHITESPACE)) {
 		struct config_section *section;
+		char *name;
 
 		while (token.type == BASETOKEN_WHITESPACE) {
 			if (!lexer_getbasetoken(lex, &token, PARSE_WHITESPACE))
@@ -244,14 +398,28 @@ static void parse_config_data(struct darray *sections, struct lexer *lex)
 		if (!section_name.len)
 			return;
 
-		section = darray_push_back_new(sizeof(struct config_section),
-					       sections);
-		section->name = bstrdup_n(section_name.array, section_name.len);
+		name = bstrdup_n(section_name.array, section_name.len);
+		section = index_find(index, sections,
+				     sizeof(struct config_section), name);
+
+		if (section) {
+			bfree(name);
+		} else {
+			section = darray_push_back_new(
+				sizeof(struct config_section), sections);
+			section->name = name;
+			index_add(index, sections,
+				  sizeof(struct config_section));
+		}
+
 		config_parse_section(section, lex);
 	}
+
+	rebuild_indices(index, sections);
 }
 
-static int config_parse_file(struct darray *sections, const char *file,
+static int config_parse_file(struct darray *sections,
+			     struct config_index *index, const char *file,
 			     bool always_open)
 {
 	char *file_data;
@@ -273,7 +441,7 @@ static int config_parse_file(struct darray *sections, const char *file,
 	lexer_init(&lex);
 	lexer_start_move(&lex, file_data);
 
-	parse_config_data(sections, &lex);
+	parse_config_data(sections, index, &lex);
 
 	lexer_free(&lex);
 	return CONFIG_SUCCESS;
@@ -288,18 +456,13 @@ int config_open(config_t **config, const char *file,
 	if (!config)
 		return CONFIG_ERROR;
 
-	*config = bzalloc(sizeof(struct config_data));
+	*config = config_alloc(file);
 	if (!*config)
 		return CONFIG_ERROR;
 
-	if (pthread_mutex_init_recursive(&(*config)->mutex) != 0) {
-		bfree(*config);
-		return CONFIG_ERROR;
-	}
-
-	(*config)->file = bstrdup(file);
-
-	errorcode = config_parse_file(&(*config)->sections, file, always_open);
+	errorcode = config_parse_file(&(*config)->sections,
+				      &(*config)->section_index, file,
+				      always_open);
 
 	if (errorcode != CONFIG_SUCCESS) {
 		config_close(*config);
@@ -316,20 +479,14 @@ int config_open_string(config_t **config, const char *str)
 	if (!config)
 		return CONFIG_ERROR;
 
-	*config = bzalloc(sizeof(struct config_data));
+	*config = config_alloc(NULL);
 	if (!*config)
 		return CONFIG_ERROR;
 
-	if (pthread_mutex_init_recursive(&(*config)->mutex) != 0) {
-		bfree(*config);
-		return CONFIG_ERROR;
-	}
-
-	(*config)->file = NULL;
-
 	lexer_init(&lex);
 	lexer_start(&lex, str);
-	parse_config_data(&(*config)->sections, &lex);
+	parse_config_data(&(*config)->sections, &(*config)->section_index,
+			  &lex);
 	lexer_free(&lex);
 
 	return CONFIG_SUCCESS;
@@ -340,42 +497,33 @@ int config_open_defaults(config_t *config, const char *file)
 	if (!config)
 		return CONFIG_ERROR;
 
-	return config_parse_file(&config->defaults, file, false);
+	int ret;
+
+	pthread_mutex_lock(&config->mutex);
+	ret = config_parse_file(&config->defaults, &config->default_index,
+				file, false);
+	pthread_mutex_unlock(&config->mutex);
+
+	return ret;
 }
 
-int config_save(config_t *config)
+static void config_serialize(config_t *config, struct dstr *str)
 {
-	FILE *f;
-	struct dstr str, tmp;
+	struct dstr tmp = {0};
 	size_t i, j;
-	int ret = CONFIG_ERROR;
-
-	if (!config)
-		return CONFIG_ERROR;
-	if (!config->file)
-		return CONFIG_ERROR;
-
-	dstr_init(&str);
-	dstr_init(&tmp);
 
 	pthread_mutex_lock(&config->mutex);
 
-	f = os_fopen(config->file, "wb");
-	if (!f) {
-		pthread_mutex_unlock(&config->mutex);
-		return CONFIG_FILENOTFOUND;
-	}
-
 	for (i = 0; i < config->sections.num; i++) {
 		struct config_section *section = darray_item(
 			sizeof(struct config_section), &config->sections, i);
 
 		if (i)
-			dstr_cat(&str, "\n");
+			dstr_cat(str, "\n");
 
-		dstr_cat(&str, "[");
-		dstr_cat(&str, section->name);
-		dstr_cat(&str, "]\n");
+		dstr_cat(str, "[");
+		dstr_cat(str, section->name);
+		dstr_cat(str, "]\n");
 
 		for (j = 0; j < section->items.num; j++) {
 			struct config_item *item = darray_item(
@@ -386,29 +534,59 @@ int config_save(config_t *config)
 			dstr_replace(&tmp, "\r", "\\r");
 			dstr_replace(&tmp, "\n", "\\n");
 
-			dstr_cat(&str, item->name);
-			dstr_cat(&str, "=");
-			dstr_cat(&str, tmp.array);
-			dstr_cat(&str, "\n");
+			dstr_cat(str, item->name);
+			dstr_cat(str, "=");
+			dstr_cat(str, tmp.array);
+			dstr_cat(str, "\n");
 		}
 	}
 
+	pthread_mutex_unlock(&config->mutex);
+	dstr_free(&tmp);
+}
+
+/* the values are copied out first, so the file itself is written without
+ * holding up anything reading or changing the config in the meantime.
+ * save_mutex must be locked */
+static int config_save_to(config_t *config, const char *file)
+{
+	struct dstr str = {0};
+	int ret = CONFIG_ERROR;
+	FILE *f;
+
+	f = os_fopen(file, "wb");
+	if (!f)
+		return CONFIG_FILENOTFOUND;
+
+	config_serialize(config, &str);
+
 #ifdef _WIN32
 	if (fwrite("\xEF\xBB\xBF", 1, 3, f) != 3)
 		goto cleanup;
 #endif
-	if (fwrite(str.array, 1, str.len, f) != str.len)
+	if (str.len && fwrite(str.array, 1, str.len, f) != str.len)
 		goto cleanup;
 
 	ret = CONFIG_SUCCESS;
 
 cleanup:
 	fclose(f);
+	dstr_free(&str);
+	return ret;
+}
 
-	pthread_mutex_unlock(&config->mutex);
+int config_save(config_t *config)
+{
+	int ret;
 
-	dstr_free(&tmp);
-	dstr_free(&str);
+	if (!config)
+		return CONFIG_ERROR;
+	if (!config->file)
+		return CONFIG_ERROR;
+
+	pthread_mutex_lock(&config->save_mutex);
+	ret = config_save_to(config, config->file);
+	pthread_mutex_unlock(&config->save_mutex);
 
 	return ret;
 }
@@ -426,17 +604,17 @@ int config_save_safe(config_t *config, const char *temp_ext,
 				"temporary extension specified");
 		return CONFIG_ERROR;
 	}
+	if (!file)
+		return CONFIG_ERROR;
 
-	pthread_mutex_lock(&config->mutex);
+	pthread_mutex_lock(&config->save_mutex);
 
-	dstr_copy(&temp_file, config->file);
+	dstr_copy(&temp_file, file);
 	if (*temp_ext != '.')
 		dstr_cat(&temp_file, ".");
 	dstr_cat(&temp_file, temp_ext);
 
-	config->file = temp_file.array;
-	ret = config_save(config);
-	config->file = file;
+	ret = config_save_to(config, temp_file.array);
 
 	if (ret != CONFIG_SUCCESS) {
 		blog(LOG_ERROR,
@@ -447,7 +625,7 @@ int config_save_safe(config_t *config, const char *temp_ext,
 	}
 
 	if (backup_ext && *backup_ext) {
-		dstr_copy(&backup_file, config->file);
+		dstr_copy(&backup_file, file);
 		if (*backup_ext != '.')
 			dstr_cat(&backup_file, ".");
 		dstr_cat(&backup_file, backup_ext);
@@ -457,12 +635,77 @@ int config_save_safe(config_t *config, const char *temp_ext,
 		ret = CONFIG_ERROR;
 
 cleanup:
-	pthread_mutex_unlock(&config->mutex);
+	pthread_mutex_unlock(&config->save_mutex);
 	dstr_free(&temp_file);
 	dstr_free(&backup_file);
 	return ret;
 }
 
+static void deferred_save_task(void *param)
+{
+	config_t *config = param;
+	char *temp_ext;
+	char *backup_ext;
+
+	/* anything changed from here on queues another save */
+	pthread_mutex_lock(&config->mutex);
+	config->save_queued = false;
+	temp_ext = bstrdup(config->save_temp_ext);
+	backup_ext = bstrdup(config->save_backup_ext);
+	pthread_mutex_unlock(&config->mutex);
+
+	config_save_safe(config, temp_ext, backup_ext);
+
+	bfree(temp_ext);
+	bfree(backup_ext);
+}
+
+void config_save_safe_deferred(config_t *config, const char *temp_ext,
+			       const char *backup_ext)
+{
+	bool queued = true;
+
+	if (!config || !config->file)
+		return;
+
+	pthread_mutex_lock(&config->mutex);
+
+	if (!config->save_queue)
+		config->save_queue = os_task_queue_create();
+
+	bfree(config->save_temp_ext);
+	bfree(config->save_backup_ext);
+	config->save_temp_ext = bstrdup(temp_ext);
+	config->save_backup_ext = bstrdup(backup_ext);
+
+	if (!config->save_queued) {
+		queued = config->save_queue &&
+			 os_task_queue_queue_task(config->save_queue,
+						  deferred_save_task, config);
+		config->save_queued = queued;
+	}
+
+	pthread_mutex_unlock(&config->mutex);
+
+	if (!queued)
+		config_save_safe(config, temp_ext, backup_ext);
+}
+
+void config_flush(config_t *config)
+{
+	os_task_queue_t *queue;
+
+	if (!config)
+		return;
+
+	pthread_mutex_lock(&config->mutex);
+	queue = config->save_queue;
+	pthread_mutex_unlock(&config->mutex);
+
+	if (queue && !os_task_queue_inside(queue))
+		os_task_queue_wait(queue);
+}
+
 void config_close(config_t *config)
 {
 	struct config_section *defaults, *sections;
@@ -471,6 +714,11 @@ void config_close(config_t *config)
 	if (!config)
 		return;
 
+	config_flush(config);
+	os_task_queue_destroy(config->save_queue);
+	bfree(config->save_temp_ext);
+	bfree(config->save_backup_ext);
+
 	defaults = config->defaults.array;
 	sections = config->sections.array;
 
@@ -481,7 +729,10 @@ void config_close(config_t *config)
 
 	darray_free(&config->defaults);
 	darray_free(&config->sections);
+	bfree(config->default_index.slots);
+	bfree(config->section_index.slots);
 	bfree(config->file);
+	pthread_mutex_destroy(&config->save_mutex);
 	pthread_mutex_destroy(&config->mutex);
 	bfree(config);
 }
@@ -510,70 +761,57 @@ unlock:
 	return name;
 }
 
-static const struct config_item *config_find_item(const struct darray *sections,
+static inline struct config_section *
+config_find_section(config_t *config, const struct darray *sections,
+		    const char *section)
+{
+	return index_find(get_section_index(config, sections), sections,
+			  sizeof(struct config_section), section);
+}
+
+static const struct config_item *config_find_item(config_t *config,
+						  const struct darray *sections,
 						  const char *section,
 						  const char *name)
 {
-	size_t i, j;
-
-	for (i = 0; i < sections->num; i++) {
-		const struct config_section *sec =
-			darray_item(sizeof(struct config_section), sections, i);
-
-		if (astrcmpi(sec->name, section) == 0) {
-			for (j = 0; j < sec->items.num; j++) {
-				struct config_item *item =
-					darray_item(sizeof(struct config_item),
-						    &sec->items, j);
-
-				if (astrcmpi(item->name, name) == 0)
-					return item;
-			}
-		}
-	}
+	struct config_section *sec =
+		config_find_section(config, sections, section);
 
-	return NULL;
+	return sec ? index_find(&sec->index, &sec->items,
+				sizeof(struct config_item), name)
+		   : NULL;
 }
 
 static void config_set_item(config_t *config, struct darray *sections,
 			    const char *section, const char *name, char *value)
 {
-	struct config_section *sec = NULL;
-	struct config_section *array = sections->array;
+	struct config_section *sec;
 	struct config_item *item;
-	size_t i, j;
 
 	pthread_mutex_lock(&config->mutex);
 
-	for (i = 0; i < sections->num; i++) {
-		struct config_section *cur_sec = array + i;
-		struct config_item *items = cur_sec->items.array;
-
-		if (astrcmpi(cur_sec->name, section) == 0) {
-			for (j = 0; j < cur_sec->items.num; j++) {
-				item = items + j;
+	sec = config_find_section(config, sections, section);
 
-				if (astrcmpi(item->name, name) == 0) {
-					bfree(item->value);
-					item->value = value;
-					goto unlock;
-				}
-			}
-
-			sec = cur_sec;
-			break;
+	if (sec) {
+		item = index_find(&sec->index, &sec->items,
+				  sizeof(struct config_item), name);
+		if (item) {
+			bfree(item->value);
+			item->value = value;
+			goto unlock;
 		}
-	}
-
-	if (!sec) {
+	} else {
 		sec = darray_push_back_new(sizeof(struct config_section),
 					   sections);
 		sec->name = bstrdup(section);
+		index_add(get_section_index(config, sections), sections,
+			  sizeof(struct config_section));
 	}
 
 	item = darray_push_back_new(sizeof(struct config_item), &sec->items);
 	item->name = bstrdup(name);
 	item->value = value;
+	index_add(&sec->index, &sec->items, sizeof(struct config_item));
 
 unlock:
 	pthread_mutex_unlock(&config->mutex);
@@ -672,9 +910,10 @@ const char *config_get_string(config_t *config, const char *section,
 
 	pthread_mutex_lock(&config->mutex);
 
-	item = config_find_item(&config->sections, section, name);
+	item = config_find_item(config, &config->sections, section, name);
 	if (!item)
-		item = config_find_item(&config->defaults, section, name);
+		item = config_find_item(config, &config->defaults, section,
+					name);
 	if (item)
 		value = item->value;
 
@@ -745,30 +984,26 @@ double config_get_double(config_t *config, const char *section,
 bool config_remove_value(config_t *config, const char *section,
 			 const char *name)
 {
-	struct darray *sections = &config->sections;
+	struct config_section *sec;
+	struct config_item *item;
 	bool success = false;
 
 	pthread_mutex_lock(&config->mutex);
 
-	for (size_t i = 0; i < sections->num; i++) {
-		struct config_section *sec =
-			darray_item(sizeof(struct config_section), sections, i);
-
-		if (astrcmpi(sec->name, section) != 0)
-			continue;
+	sec = config_find_section(config, &config->sections, section);
+	if (!sec)
+		goto unlock;
 
-		for (size_t j = 0; j < sec->items.num; j++) {
-			struct config_item *item = darray_item(
-				sizeof(struct config_item), &sec->items, j);
+	item = index_find(&sec->index, &sec->items, sizeof(struct config_item),
+			  name);
+	if (item) {
+		size_t idx = item - (struct config_item *)sec->items.array;
 
-			if (astrcmpi(item->name, name) == 0) {
-				config_item_free(item);
-				darray_erase(sizeof(struct config_item),
-					     &sec->items, j);
-				success = true;
-				goto unlock;
-			}
-		}
+		config_item_free(item);
+		darray_erase(sizeof(struct config_item), &sec->items, idx);
+		index_rebuild(&sec->index, &sec->items,
+			      sizeof(struct config_item));
+		success = true;
 	}
 
 unlock:
@@ -784,7 +1019,7 @@ const char *config_get_default_string(config_t *config, const char *section,
 
 	pthread_mutex_lock(&config->mutex);
 
-	item = config_find_item(&config->defaults, section, name);
+	item = config_find_item(config, &config->defaults, section, name);
 	if (item)
 		value = item->value;
 
@@ -837,7 +1072,8 @@ bool config_has_user_value(config_t *config, const char *section,
 {
 	bool success;
 	pthread_mutex_lock(&config->mutex);
-	success = config_find_item(&config->sections, section, name) != NULL;
+	success = config_find_item(config, &config->sections, section,
+				   name) != NULL;
 	pthread_mutex_unlock(&config->mutex);
 	return success;
 }
@@ -847,7 +1083,8 @@ bool config_has_default_value(config_t *config, const char *section,
 {
 	bool success;
 	pthread_mutex_lock(&config->mutex);
-	success = config_find_item(&config->defaults, section, name) != NULL;
+	success = config_find_item(config, &config->defaults, section,
+				   name) != NULL;
 	pthread_mutex_unlock(&config->mutex);
 	return success;
 }
@@ -48,6 +48,16 @@ EXPORT int config_open_string(config_t **config, const char *str);
 EXPORT int config_save(config_t *config);
 EXPORT int config_save_safe(config_t *config, const char *temp_ext,
 			    const char *backup_ext);
+
+/*
+ * Like config_save_safe, but the file is written on a background thread.
+ * Saves requested before a pending one has started are coalesced into it, so
+ * this is fine to call after every change.  config_close writes any pending
+ * save before returning, config_flush waits for them at any other point.
+ */
+EXPORT void config_save_safe_deferred(config_t *config, const char *temp_ext,
+				      const char *backup_ext);
+EXPORT void config_flush(config_t *config);
 EXPORT void config_close(config_t *config);
 
 EXPORT size_t config_num_sections(config_t *config);
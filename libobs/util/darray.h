@@ -37,6 +37,7 @@ extern "C" {
  */
 
 #define DARRAY_INVALID ((size_t)-1)
+#define DARRAY_MIN_ALLOC_SIZE 64
 
 struct darray {
 	void *array;
@@ -110,10 +111,20 @@ static inline void darray_ensure_capacity(const size_t element_size,
 	new_cap = (!dst->capacity) ? new_size : dst->capacity * 2;
 	if (new_size > new_cap)
 		new_cap = new_size;
+
+	/* skip the first few tiny allocations of arrays that grow one item
+	 * at a time */
+	if (element_size * new_cap < DARRAY_MIN_ALLOC_SIZE)
+		new_cap = DARRAY_MIN_ALLOC_SIZE / element_size;
+
 	ptr = bmalloc(element_size * new_cap);
 	if (dst->array) {
-		if (dst->capacity)
-			memcpy(ptr, dst->array, element_size * dst->capacity);
+		/* num may already include the items being added, none of which
+		 * have been written yet */
+		size_t copy_num = dst->num < dst->capacity ? dst->num
+							    : dst->capacity;
+		if (copy_num)
+			memcpy(ptr, dst->array, element_size * copy_num);
 
 		bfree(dst->array);
 	}
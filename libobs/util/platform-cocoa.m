@@ -317,6 +317,7 @@ void os_inhibit_sleep_destroy(os_inhibit_t *info)
 
 static int physical_cores = 0;
 static int logical_cores = 0;
+static int performance_cores = 0;
 static bool core_count_initialized = false;
 
 bool os_get_emulation_status(void)
@@ -352,6 +353,13 @@ static void os_get_cores_internal(void)
 
 	ret = sysctlbyname("machdep.cpu.thread_count", &logical_cores, &size,
 			   NULL, 0);
+
+	/* perflevel0 is the fastest core type on Apple silicon, and doesn't
+	 * exist on Intel Macs */
+	size = sizeof(performance_cores);
+	if (sysctlbyname("hw.perflevel0.physicalcpu", &performance_cores,
+			 &size, NULL, 0) != 0)
+		performance_cores = 0;
 }
 
 int os_get_physical_cores(void)
@@ -368,6 +376,13 @@ int os_get_logical_cores(void)
 	return logical_cores;
 }
 
+int os_get_performance_cores(void)
+{
+	if (!core_count_initialized)
+		os_get_cores_internal();
+	return performance_cores ? performance_cores : physical_cores;
+}
+
 static inline bool os_get_sys_memory_usage_internal(vm_statistics_t vmstat)
 {
 	mach_msg_type_number_t out_count = HOST_VM_INFO_COUNT;
@@ -174,3 +174,40 @@ void dbus_inhibit_sleep(struct dbus_sleep_info *info, const char *reason,
 	else
 		info->cookie = 0;
 }
+
+bool dbus_rtkit_set_thread_priority(uint64_t tid, bool realtime, int priority)
+{
+	g_autoptr(GDBusConnection) c = NULL;
+	g_autoptr(GVariant) reply = NULL;
+	g_autoptr(GError) error = NULL;
+	const char *method;
+	GVariant *params;
+
+	c = g_bus_get_sync(G_BUS_TYPE_SYSTEM, NULL, &error);
+	if (!c) {
+		blog(LOG_DEBUG, "Could not connect to the system bus: %s",
+		     error->message);
+		return false;
+	}
+
+	if (realtime) {
+		method = "MakeThreadRealtime";
+		params = g_variant_new("(tu)", tid, (uint32_t)priority);
+	} else {
+		method = "MakeThreadHighPriority";
+		params = g_variant_new("(ti)", tid, (int32_t)priority);
+	}
+
+	reply = g_dbus_connection_call_sync(
+		c, "org.freedesktop.RealtimeKit1",
+		"/org/freedesktop/RealtimeKit1", "org.freedesktop.RealtimeKit1",
+		method, params, NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL, &error);
+
+	if (!reply) {
+		blog(LOG_DEBUG, "RealtimeKit %s failed: %s", method,
+		     error->message);
+		return false;
+	}
+
+	return true;
+}
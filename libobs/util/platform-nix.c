@@ -16,8 +16,12 @@
 
 #include "obsconfig.h"
 
-#if !defined(__APPLE__) && OBS_QT_VERSION == 6
+#if !defined(__APPLE__)
+/* for dladdr */
 #define _GNU_SOURCE
+#endif
+
+#if !defined(__APPLE__) && OBS_QT_VERSION == 6
 #include <link.h>
 #include <stdlib.h>
 #endif
@@ -102,6 +106,29 @@ void os_dlclose(void *module)
 		dlclose(module);
 }
 
+char *os_get_address_name(const void *address)
+{
+	struct dstr name = {0};
+	const char *module;
+	Dl_info info;
+
+	if (!dladdr(address, &info) || !info.dli_fname)
+		return NULL;
+
+	module = strrchr(info.dli_fname, '/');
+	module = module ? module + 1 : info.dli_fname;
+
+	if (info.dli_sname && info.dli_saddr)
+		dstr_printf(&name, "%s!%s+0x%lx", module, info.dli_sname,
+			    (unsigned long)((const char *)address -
+					    (const char *)info.dli_saddr));
+	else
+		dstr_printf(&name, "%s+0x%lx", module,
+			    (unsigned long)((const char *)address -
+					    (const char *)info.dli_fbase));
+	return name.array;
+}
+
 #if !defined(__APPLE__) && OBS_QT_VERSION == 6
 int module_has_qt5_check(const char *path)
 {
@@ -217,6 +244,22 @@ bool os_sleepto_ns(uint64_t time_target)
 	if (time_target < current)
 		return false;
 
+#if !defined(__APPLE__)
+	/* sleep to the absolute deadline on the same clock os_gettime_ns uses,
+	 * so time spent being interrupted or rescheduled doesn't add up */
+	struct timespec deadline;
+	deadline.tv_sec = (time_t)(time_target / 1000000000);
+	deadline.tv_nsec = (long)(time_target % 1000000000);
+
+	int ret;
+	while ((ret = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME,
+				      &deadline, NULL)) == EINTR)
+		;
+
+	if (ret == 0)
+		return true;
+#endif
+
 	time_target -= current;
 
 	struct timespec req, remain;
@@ -847,8 +890,57 @@ void os_breakpoint()
 #ifndef __APPLE__
 static int physical_cores = 0;
 static int logical_cores = 0;
+static int performance_cores = 0;
 static bool core_count_initialized = false;
 
+#if defined(__linux__)
+/* counts the CPUs in a sysfs cpu list such as "0-7,16-23" */
+static int count_cpu_list(const char *list)
+{
+	int count = 0;
+
+	while (list && *list && *list != '\n') {
+		char *end;
+		long first = strtol(list, &end, 10);
+		long last = first;
+
+		if (end == list)
+			break;
+		if (*end == '-') {
+			list = end + 1;
+			last = strtol(list, &end, 10);
+			if (end == list)
+				break;
+		}
+
+		if (last >= first)
+			count += (int)(last - first + 1);
+
+		list = (*end == ',') ? end + 1 : end;
+	}
+
+	return count;
+}
+
+/* Intel hybrid CPUs expose their P-cores and E-cores as separate PMUs.
+ * E-cores don't have SMT, so every logical CPU outside of cpu_core is a
+ * physical E-core. */
+static int get_performance_cores(void)
+{
+	char *text = os_quick_read_utf8_file("/sys/devices/cpu_core/cpus");
+	int p_logical = count_cpu_list(text);
+	int e_cores = logical_cores - p_logical;
+	int cores = physical_cores;
+
+	bfree(text);
+
+	if (p_logical > 0 && e_cores > 0 && e_cores < physical_cores)
+		cores = physical_cores - e_cores;
+
+	return cores;
+}
+#endif
+
 static void os_get_cores_internal(void)
 {
 	if (core_count_initialized)
@@ -916,6 +1008,8 @@ static void os_get_cores_internal(void)
 	dstr_free(&proc_phys_ids);
 	dstr_free(&proc_phys_id);
 	free(line);
+
+	performance_cores = get_performance_cores();
 #elif defined(__FreeBSD__)
 	char *text = os_quick_read_utf8_file("/var/run/dmesg.boot");
 	char *core_count = text;
@@ -989,6 +1083,13 @@ int os_get_logical_cores(void)
 	return logical_cores;
 }
 
+int os_get_performance_cores(void)
+{
+	if (!core_count_initialized)
+		os_get_cores_internal();
+	return performance_cores ? performance_cores : physical_cores;
+}
+
 #ifdef __FreeBSD__
 uint64_t os_get_sys_free_size(void)
 {
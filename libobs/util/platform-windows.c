@@ -137,6 +137,34 @@ void os_dlclose(void *module)
 	FreeLibrary(module);
 }
 
+/* symbol names would need dbghelp, the module and offset are enough to look
+ * the address up afterwards */
+char *os_get_address_name(const void *address)
+{
+	struct dstr name = {0};
+	wchar_t path[MAX_PATH];
+	const wchar_t *module;
+	char *module_utf8 = NULL;
+	HMODULE handle;
+
+	if (!GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS |
+					GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+				(LPCWSTR)address, &handle))
+		return NULL;
+	if (!GetModuleFileNameW(handle, path, MAX_PATH))
+		return NULL;
+
+	module = wcsrchr(path, L'\\');
+	module = module ? module + 1 : path;
+	os_wcs_to_utf8_ptr(module, 0, &module_utf8);
+
+	dstr_printf(&name, "%s+0x%llx", module_utf8 ? module_utf8 : "?",
+		    (unsigned long long)((const char *)address -
+					 (const char *)handle));
+	bfree(module_utf8);
+	return name.array;
+}
+
 #if OBS_QT_VERSION == 6
 static bool has_qt5_import(VOID *base, PIMAGE_NT_HEADERS nt_headers)
 {
@@ -1320,8 +1348,50 @@ DWORD num_logical_cores(ULONG_PTR mask)
 
 static int physical_cores = 0;
 static int logical_cores = 0;
+static int performance_cores = 0;
 static bool core_count_initialized = false;
 
+/* EfficiencyClass is only filled in on Windows 10 and up, and is 0 for every
+ * core on CPUs with a single core type */
+static void get_performance_cores(void)
+{
+	PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX info = NULL;
+	DWORD len = 0;
+	BYTE max_class = 0;
+
+	GetLogicalProcessorInformationEx(RelationProcessorCore, NULL, &len);
+	if (GetLastError() != ERROR_INSUFFICIENT_BUFFER)
+		return;
+
+	info = malloc(len);
+	if (!info)
+		return;
+
+	if (GetLogicalProcessorInformationEx(RelationProcessorCore, info,
+					     &len)) {
+		for (int pass = 0; pass < 2; pass++) {
+			BYTE *cur = (BYTE *)info;
+			BYTE *end = cur + len;
+
+			while (cur < end) {
+				PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX core =
+					(PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX)
+						cur;
+				BYTE eff = core->Processor.EfficiencyClass;
+
+				if (pass == 0 && eff > max_class)
+					max_class = eff;
+				else if (pass == 1 && eff == max_class)
+					performance_cores++;
+
+				cur += core->Size;
+			}
+		}
+	}
+
+	free(info);
+}
+
 static void os_get_cores_internal(void)
 {
 	PSYSTEM_LOGICAL_PROCESSOR_INFORMATION info = NULL, temp = NULL;
@@ -1359,6 +1429,8 @@ static void os_get_cores_internal(void)
 
 		free(info);
 	}
+
+	get_performance_cores();
 }
 
 int os_get_physical_cores(void)
@@ -1375,6 +1447,13 @@ int os_get_logical_cores(void)
 	return logical_cores;
 }
 
+int os_get_performance_cores(void)
+{
+	if (!core_count_initialized)
+		os_get_cores_internal();
+	return performance_cores ? performance_cores : physical_cores;
+}
+
 static inline bool os_get_sys_memory_usage_internal(MEMORYSTATUSEX *msex)
 {
 	if (!GlobalMemoryStatusEx(msex))
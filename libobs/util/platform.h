@@ -84,6 +84,10 @@ EXPORT int os_dtostr(double value, char *dst, size_t size);
 EXPORT void *os_dlopen(const char *path);
 EXPORT void *os_dlsym(void *module, const char *func);
 EXPORT void os_dlclose(void *module);
+
+/* returns a bmalloc'd "module+offset" or "module!symbol+offset" description
+ * of a code address, or NULL if it isn't in any loaded module */
+EXPORT char *os_get_address_name(const void *address);
 EXPORT bool os_is_obs_plugin(const char *path);
 
 struct os_cpu_usage_info;
@@ -188,6 +192,11 @@ EXPORT void os_breakpoint(void);
 EXPORT int os_get_physical_cores(void);
 EXPORT int os_get_logical_cores(void);
 
+/* number of physical cores of the fastest type on hybrid CPUs (Intel P-cores,
+ * Apple performance cores, ARM big cores).  the same as
+ * os_get_physical_cores on CPUs with only one type of core. */
+EXPORT int os_get_performance_cores(void);
+
 EXPORT uint64_t os_get_sys_free_size(void);
 
 struct os_proc_memory_usage {
@@ -14,6 +14,7 @@
 
 struct profiler_snapshot {
 	DARRAY(profiler_snapshot_entry_t) roots;
+	DARRAY(profiler_alloc_site_t) alloc_sites;
 };
 
 struct profiler_snapshot_entry {
@@ -32,6 +33,8 @@ struct profiler_snapshot_entry {
 
 typedef struct profiler_time_entry profiler_time_entry;
 
+#define NO_CALL ((size_t)-1)
+
 typedef struct profile_call profile_call;
 struct profile_call {
 	const char *name;
@@ -43,9 +46,21 @@ struct profile_call {
 #ifdef TRACK_OVERHEAD
 	uint64_t overhead_end;
 #endif
-	uint64_t expected_time_between_calls;
-	DARRAY(profile_call) children;
-	profile_call *parent;
+	size_t parent;
+};
+
+typedef struct profile_entry profile_entry;
+
+/* Calls are stored flat in the order they were started, so the calls of a
+ * root are a pre-order walk of its call tree.  The arrays are emptied rather
+ * than freed once the root has been merged, so after the first few roots a
+ * thread can profile without allocating. */
+typedef struct profile_thread profile_thread;
+struct profile_thread {
+	DARRAY(profile_call) calls;
+	DARRAY(profile_entry *) entries;
+	size_t current;
+	profile_thread *next;
 };
 
 typedef struct profile_times_table_entry profile_times_table_entry;
@@ -66,7 +81,6 @@ struct profile_times_table {
 	profile_times_table_entry *old_entries;
 };
 
-typedef struct profile_entry profile_entry;
 struct profile_entry {
 	const char *name;
 	profile_times_table times;
@@ -83,7 +97,7 @@ struct profile_root_entry {
 	pthread_mutex_t *mutex;
 	const char *name;
 	profile_entry *entry;
-	profile_call *prev_call;
+	uint64_t prev_start_time;
 };
 
 static inline uint64_t diff_ns_to_usec(uint64_t prev, uint64_t next)
@@ -228,19 +242,13 @@ static profile_entry *get_child(profile_entry *parent, const char *name)
 	return init_entry(da_push_back_new(parent->children), name);
 }
 
-static void merge_call(profile_entry *entry, profile_call *call,
-		       profile_call *prev_call)
+static void merge_call(profile_entry *entry, const profile_call *call,
+		       uint64_t prev_start_time)
 {
-	const size_t num = call->children.num;
-	for (size_t i = 0; i < num; i++) {
-		profile_call *child = &call->children.array[i];
-		merge_call(get_child(entry, child->name), child, NULL);
-	}
-
-	if (entry->expected_time_between_calls != 0 && prev_call) {
+	if (entry->expected_time_between_calls != 0 && prev_start_time) {
 		migrate_old_entries(&entry->times_between_calls, true);
-		uint64_t usec = diff_ns_to_usec(prev_call->start_time,
-						call->start_time);
+		uint64_t usec =
+			diff_ns_to_usec(prev_start_time, call->start_time);
 		add_hashmap_entry(&entry->times_between_calls, usec, 1);
 	}
 
@@ -256,13 +264,83 @@ static void merge_call(profile_entry *entry, profile_call *call,
 #endif
 }
 
+/* a call's parent always comes before it, and the parent's entry pointer
+ * stays valid until one of the parent's siblings is added, which in pre-order
+ * only happens after the parent's whole subtree */
+static void merge_calls(profile_entry *root, profile_thread *thread,
+			uint64_t prev_start_time)
+{
+	const size_t num = thread->calls.num;
+
+	da_resize(thread->entries, num);
+
+	for (size_t i = 0; i < num; i++) {
+		profile_call *call = &thread->calls.array[i];
+		profile_entry *entry =
+			call->parent == NO_CALL
+				? root
+				: get_child(thread->entries.array[call->parent],
+					    call->name);
+
+		thread->entries.array[i] = entry;
+		merge_call(entry, call, i == 0 ? prev_start_time : 0);
+	}
+}
+
 static bool enabled = false;
 static pthread_mutex_t root_mutex = PTHREAD_MUTEX_INITIALIZER;
 static DARRAY(profile_root_entry) root_entries;
 
-static THREAD_LOCAL profile_call *thread_context = NULL;
+static pthread_mutex_t threads_mutex = PTHREAD_MUTEX_INITIALIZER;
+static profile_thread *profile_threads = NULL;
+static volatile long profile_threads_generation = 0;
+
+static THREAD_LOCAL profile_thread *thread_profile = NULL;
+static THREAD_LOCAL long thread_profile_generation = 0;
 static THREAD_LOCAL bool thread_enabled = true;
 
+static profile_thread *get_profile_thread(bool create)
+{
+	profile_thread *thread = thread_profile;
+	long generation = os_atomic_load_long(&profile_threads_generation);
+
+	if (thread && thread_profile_generation == generation)
+		return thread;
+	if (!create)
+		return NULL;
+
+	thread = bzalloc(sizeof(*thread));
+	thread->current = NO_CALL;
+
+	pthread_mutex_lock(&threads_mutex);
+	thread->next = profile_threads;
+	profile_threads = thread;
+	pthread_mutex_unlock(&threads_mutex);
+
+	thread_profile = thread;
+	thread_profile_generation = generation;
+	return thread;
+}
+
+static void free_profile_threads(void)
+{
+	profile_thread *thread;
+
+	pthread_mutex_lock(&threads_mutex);
+	os_atomic_inc_long(&profile_threads_generation);
+	thread = profile_threads;
+	profile_threads = NULL;
+	pthread_mutex_unlock(&threads_mutex);
+
+	while (thread) {
+		profile_thread *next = thread->next;
+		da_free(thread->calls);
+		da_free(thread->entries);
+		bfree(thread);
+		thread = next;
+	}
+}
+
 void profiler_start(void)
 {
 	pthread_mutex_lock(&root_mutex);
@@ -334,76 +412,287 @@ void profile_register_root(const char *name,
 	pthread_mutex_unlock(&root_mutex);
 }
 
-static void free_call_context(profile_call *context);
-
-static void merge_context(profile_call *context)
+static void merge_context(profile_thread *thread)
 {
 	pthread_mutex_t *mutex = NULL;
 	profile_entry *entry = NULL;
-	profile_call *prev_call = NULL;
+	profile_call *root = &thread->calls.array[0];
+	uint64_t prev_start_time;
 
 	if (!lock_root()) {
-		free_call_context(context);
+		thread->calls.num = 0;
 		return;
 	}
 
-	profile_root_entry *r_entry = get_root_entry(context->name);
+	profile_root_entry *r_entry = get_root_entry(root->name);
 
 	mutex = r_entry->mutex;
 	entry = r_entry->entry;
-	prev_call = r_entry->prev_call;
+	prev_start_time = r_entry->prev_start_time;
 
-	r_entry->prev_call = context;
+	r_entry->prev_start_time = root->start_time;
 
 	pthread_mutex_lock(mutex);
 	pthread_mutex_unlock(&root_mutex);
 
-	merge_call(entry, context, prev_call);
+	merge_calls(entry, thread, prev_start_time);
 
 	pthread_mutex_unlock(mutex);
 
-	free_call_context(prev_call);
+	thread->calls.num = 0;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Tracing
+ *
+ *   While tracing, every profile_start/profile_end also records a timestamped
+ * event into a ring buffer owned by the calling thread.  Only that thread
+ * ever writes to its buffer, and it publishes each event by bumping the
+ * buffer's count, so recording never locks.  Buffers are only created (once
+ * per thread) and freed (in profiler_free) under trace_mutex. */
+
+#define TRACE_EVENTS_PER_THREAD 32768 /* must be a power of two */
+
+struct trace_event {
+	const char *name;
+	uint64_t time;
+	bool begin;
+};
+
+struct trace_buffer {
+	struct trace_event *events;
+	volatile long count;
+	const char *thread_name; /* name of the first root on the thread */
+	long thread_id;
+	struct trace_buffer *next;
+};
+
+static volatile bool tracing = false;
+static volatile long trace_generation = 0;
+static uint64_t trace_start_time = 0;
+static pthread_mutex_t trace_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct trace_buffer *trace_buffers = NULL;
+static long num_trace_buffers = 0;
+
+static THREAD_LOCAL struct trace_buffer *thread_trace = NULL;
+static THREAD_LOCAL long thread_trace_generation = 0;
+
+static struct trace_buffer *get_thread_trace(const char *name)
+{
+	struct trace_buffer *buf = thread_trace;
+	long generation = os_atomic_load_long(&trace_generation);
+
+	if (buf && thread_trace_generation == generation)
+		return buf;
+
+	buf = bzalloc(sizeof(*buf));
+	buf->events =
+		bmalloc(TRACE_EVENTS_PER_THREAD * sizeof(struct trace_event));
+	buf->thread_name = name;
+
+	pthread_mutex_lock(&trace_mutex);
+	buf->thread_id = ++num_trace_buffers;
+	buf->next = trace_buffers;
+	trace_buffers = buf;
+	pthread_mutex_unlock(&trace_mutex);
+
+	thread_trace = buf;
+	thread_trace_generation = generation;
+	return buf;
+}
+
+static void trace_event(const char *name, bool begin)
+{
+	struct trace_buffer *buf = get_thread_trace(name);
+	unsigned long pos = (unsigned long)buf->count;
+	struct trace_event *event =
+		&buf->events[pos & (TRACE_EVENTS_PER_THREAD - 1)];
+
+	event->name = name;
+	event->time = os_gettime_ns();
+	event->begin = begin;
+	os_atomic_set_long(&buf->count, (long)(pos + 1));
+}
+
+void profiler_trace_start(void)
+{
+	pthread_mutex_lock(&trace_mutex);
+	trace_start_time = os_gettime_ns();
+	os_atomic_set_bool(&tracing, true);
+	pthread_mutex_unlock(&trace_mutex);
+}
+
+void profiler_trace_stop(void)
+{
+	os_atomic_set_bool(&tracing, false);
+}
+
+bool profiler_trace_active(void)
+{
+	return os_atomic_load_bool(&tracing);
+}
+
+static void trace_write_string(FILE *f, const char *str)
+{
+	fputc('"', f);
+
+	for (; *str; str++) {
+		unsigned char ch = (unsigned char)*str;
+
+		if (ch == '"' || ch == '\\')
+			fprintf(f, "\\%c", ch);
+		else if (ch < 0x20)
+			fprintf(f, "\\u%04x", ch);
+		else
+			fputc(ch, f);
+	}
+
+	fputc('"', f);
+}
+
+/* copies the events still in the buffer, dropping any that were (or may have
+ * been in the middle of being) overwritten while copying */
+static size_t trace_copy_events(struct trace_buffer *buf,
+				struct trace_event *events)
+{
+	const unsigned long capacity = TRACE_EVENTS_PER_THREAD;
+	unsigned long end = (unsigned long)os_atomic_load_long(&buf->count);
+	unsigned long num = end < capacity ? end : capacity;
+	unsigned long start = end - num;
+	unsigned long written, free_slots, skip = 0;
+
+	for (unsigned long i = 0; i < num; i++)
+		events[i] = buf->events[(start + i) & (capacity - 1)];
+
+	written = (unsigned long)os_atomic_load_long(&buf->count) - end + 1;
+	free_slots = capacity - num;
+	if (written > free_slots)
+		skip = written - free_slots;
+	if (skip > num)
+		skip = num;
+
+	memmove(events, events + skip, (num - skip) * sizeof(*events));
+	return num - skip;
+}
+
+static void trace_write_events(FILE *f, struct trace_buffer *buf,
+			       struct trace_event *events, bool *first)
+{
+	size_t num = trace_copy_events(buf, events);
+
+	fprintf(f, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+		   "\"tid\":%ld,\"args\":{\"name\":",
+		*first ? "" : ",", buf->thread_id);
+	trace_write_string(f, buf->thread_name);
+	fputs("}}", f);
+	*first = false;
+
+	for (size_t i = 0; i < num; i++) {
+		struct trace_event *event = &events[i];
+
+		if (event->time < trace_start_time)
+			continue;
+
+		fputs(",\n{\"name\":", f);
+		trace_write_string(f, event->name);
+		fprintf(f,
+			",\"ph\":\"%c\",\"pid\":1,\"tid\":%ld,"
+			"\"ts\":%" PRIu64 ".%03" PRIu64 "}",
+			event->begin ? 'B' : 'E', buf->thread_id,
+			(event->time - trace_start_time) / 1000,
+			(event->time - trace_start_time) % 1000);
+	}
+}
+
+bool profiler_trace_dump_json(const char *filename)
+{
+	struct trace_event *events;
+	bool first = true;
+	FILE *f;
+
+	f = os_fopen(filename, "wb");
+	if (!f)
+		return false;
+
+	events = bmalloc(TRACE_EVENTS_PER_THREAD * sizeof(struct trace_event));
+
+	fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", f);
+
+	pthread_mutex_lock(&trace_mutex);
+	for (struct trace_buffer *buf = trace_buffers; buf; buf = buf->next)
+		trace_write_events(f, buf, events, &first);
+	pthread_mutex_unlock(&trace_mutex);
+
+	fputs("\n]}\n", f);
+
+	bfree(events);
+	return fclose(f) == 0;
 }
 
+static void free_trace_buffers(void)
+{
+	struct trace_buffer *buf;
+
+	pthread_mutex_lock(&trace_mutex);
+	os_atomic_set_bool(&tracing, false);
+	os_atomic_inc_long(&trace_generation);
+	buf = trace_buffers;
+	trace_buffers = NULL;
+	pthread_mutex_unlock(&trace_mutex);
+
+	while (buf) {
+		struct trace_buffer *next = buf->next;
+		bfree(buf->events);
+		bfree(buf);
+		buf = next;
+	}
+}
+
+/* ------------------------------------------------------------------------- */
+
 void profile_start(const char *name)
 {
+	if (os_atomic_load_bool(&tracing))
+		trace_event(name, true);
+
 	if (!thread_enabled)
 		return;
 
-	profile_call new_call = {
-		.name = name,
 #ifdef TRACK_OVERHEAD
-		.overhead_start = os_gettime_ns(),
+	uint64_t overhead_start = os_gettime_ns();
 #endif
-		.parent = thread_context,
-	};
+	profile_thread *thread = get_profile_thread(true);
+	profile_call *call = da_push_back_new(thread->calls);
 
-	profile_call *call = NULL;
-
-	if (new_call.parent) {
-		size_t idx = da_push_back(new_call.parent->children, &new_call);
-		call = &new_call.parent->children.array[idx];
-	} else {
-		call = bmalloc(sizeof(profile_call));
-		memcpy(call, &new_call, sizeof(profile_call));
-	}
+	call->name = name;
+#ifdef TRACK_OVERHEAD
+	call->overhead_start = overhead_start;
+#endif
+	call->parent = thread->current;
 
-	thread_context = call;
+	thread->current = thread->calls.num - 1;
 	call->start_time = os_gettime_ns();
 }
 
 void profile_end(const char *name)
 {
 	uint64_t end = os_gettime_ns();
+
+	if (os_atomic_load_bool(&tracing))
+		trace_event(name, false);
+
 	if (!thread_enabled)
 		return;
 
-	profile_call *call = thread_context;
-	if (!call) {
+	profile_thread *thread = get_profile_thread(false);
+	if (!thread || thread->current == NO_CALL) {
 		blog(LOG_ERROR, "Called profile end with no active profile");
 		return;
 	}
 
+	profile_call *calls = thread->calls.array;
+	profile_call *call = &calls[thread->current];
+
 	if (!call->name)
 		call->name = name;
 
@@ -413,30 +702,31 @@ void profile_end(const char *name)
 		     "start(\"%s\"[%p]) <-> end(\"%s\"[%p])",
 		     call->name, call->name, name, name);
 
-		profile_call *parent = call->parent;
-		while (parent && parent->parent && parent->name != name)
-			parent = parent->parent;
+		size_t parent = call->parent;
+		while (parent != NO_CALL && calls[parent].parent != NO_CALL &&
+		       calls[parent].name != name)
+			parent = calls[parent].parent;
 
-		if (!parent || parent->name != name)
+		if (parent == NO_CALL || calls[parent].name != name)
 			return;
 
 		while (call->name != name) {
 			profile_end(call->name);
-			call = call->parent;
+			call = &calls[thread->current];
 		}
 	}
 
-	thread_context = call->parent;
+	thread->current = call->parent;
 
 	call->end_time = end;
 #ifdef TRACK_OVERHEAD
 	call->overhead_end = os_gettime_ns();
 #endif
 
-	if (call->parent)
+	if (call->parent != NO_CALL)
 		return;
 
-	merge_context(call);
+	merge_context(thread);
 }
 
 static int profiler_time_entry_compare(const void *first, const void *second)
@@ -759,22 +1049,34 @@ void profiler_print_time_between_calls(profiler_snapshot_t *snap)
 			   profile_print_entry_expected, snap);
 }
 
-static void free_call_children(profile_call *call)
+void profiler_print_alloc_sites(profiler_snapshot_t *snap, size_t max_sites)
 {
-	if (!call)
-		return;
-
-	const size_t num = call->children.num;
-	for (size_t i = 0; i < num; i++)
-		free_call_children(&call->children.array[i]);
+	bool free_snapshot = !snap;
+	if (!snap)
+		snap = profile_snapshot_create();
 
-	da_free(call->children);
-}
+	if (snap->alloc_sites.num) {
+		size_t count = snap->alloc_sites.num;
+		if (max_sites && count > max_sites)
+			count = max_sites;
+
+		blog(LOG_INFO,
+		     "== Allocation Sites ===============================");
+		for (size_t i = 0; i < count; i++) {
+			profiler_alloc_site_t *site =
+				&snap->alloc_sites.array[i];
+			blog(LOG_INFO,
+			     "%s: %.1f allocs/s, %" PRIu64 " live (%" PRIu64
+			     " bytes)",
+			     site->name, site->allocs_per_sec,
+			     site->live_allocs, site->live_bytes);
+		}
+		blog(LOG_INFO,
+		     "=================================================");
+	}
 
-static void free_call_context(profile_call *context)
-{
-	free_call_children(context);
-	bfree(context);
+	if (free_snapshot)
+		profile_snapshot_free(snap);
 }
 
 static void free_hashmap(profile_times_table *map)
@@ -818,8 +1120,6 @@ void profiler_free(void)
 		bfree(entry->mutex);
 		entry->mutex = NULL;
 
-		free_call_context(entry->prev_call);
-
 		free_profile_entry(entry->entry);
 		bfree(entry->entry);
 	}
@@ -827,6 +1127,9 @@ void profiler_free(void)
 	da_free(old_root_entries);
 
 	pthread_mutex_destroy(&root_mutex);
+
+	free_profile_threads();
+	free_trace_buffers();
 }
 
 /* ------------------------------------------------------------------------- */
@@ -927,6 +1230,41 @@ static void sort_snapshot_entry(profiler_snapshot_entry_t *entry)
 		sort_snapshot_entry(&entry->children.array[i]);
 }
 
+static bool add_alloc_site(void *param, const struct bmem_site_stats *stats)
+{
+	profiler_snapshot_t *snap = param;
+	profiler_alloc_site_t *site = da_push_back_new(snap->alloc_sites);
+	char *name = os_get_address_name(stats->address);
+
+	if (!name) {
+		struct dstr str = {0};
+		dstr_printf(&str, "%p", stats->address);
+		name = str.array;
+	}
+
+	site->name = name;
+	site->address = stats->address;
+	site->live_bytes = stats->live_bytes;
+	site->live_allocs = stats->live_allocs;
+	site->total_allocs = stats->total_allocs;
+	site->allocs_per_sec =
+		stats->tracked_ns
+			? (double)stats->total_allocs * 1000000000.0 /
+				  (double)stats->tracked_ns
+			: 0.0;
+	return true;
+}
+
+static int alloc_site_compare(const void *first, const void *second)
+{
+	const profiler_alloc_site_t *a = first;
+	const profiler_alloc_site_t *b = second;
+
+	if (a->total_allocs == b->total_allocs)
+		return 0;
+	return a->total_allocs > b->total_allocs ? -1 : 1;
+}
+
 profiler_snapshot_t *profile_snapshot_create(void)
 {
 	profiler_snapshot_t *snap = bzalloc(sizeof(profiler_snapshot_t));
@@ -944,6 +1282,11 @@ profiler_snapshot_t *profile_snapshot_create(void)
 	for (size_t i = 0; i < snap->roots.num; i++)
 		sort_snapshot_entry(&snap->roots.array[i]);
 
+	bmem_enum_sites(add_alloc_site, snap);
+	if (snap->alloc_sites.num)
+		qsort(snap->alloc_sites.array, snap->alloc_sites.num,
+		      sizeof(profiler_alloc_site_t), alloc_site_compare);
+
 	return snap;
 }
 
@@ -964,8 +1307,11 @@ void profile_snapshot_free(profiler_snapshot_t *snap)
 
 	for (size_t i = 0; i < snap->roots.num; i++)
 		free_snapshot_entry(&snap->roots.array[i]);
+	for (size_t i = 0; i < snap->alloc_sites.num; i++)
+		bfree((char *)snap->alloc_sites.array[i].name);
 
 	da_free(snap->roots);
+	da_free(snap->alloc_sites);
 	bfree(snap);
 }
 
@@ -1180,3 +1526,20 @@ uint64_t profiler_snapshot_entry_overall_between_calls_count(
 {
 	return entry ? entry->overall_between_calls_count : 0;
 }
+
+size_t profiler_snapshot_num_alloc_sites(profiler_snapshot_t *snap)
+{
+	return snap ? snap->alloc_sites.num : 0;
+}
+
+void profiler_snapshot_enumerate_alloc_sites(profiler_snapshot_t *snap,
+					     profiler_alloc_site_enum_func func,
+					     void *context)
+{
+	if (!snap)
+		return;
+
+	for (size_t i = 0; i < snap->alloc_sites.num; i++)
+		if (!func(context, &snap->alloc_sites.array[i]))
+			break;
+}
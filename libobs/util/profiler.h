@@ -10,6 +10,7 @@ extern "C" {
 typedef struct profiler_snapshot profiler_snapshot_t;
 typedef struct profiler_snapshot_entry profiler_snapshot_entry_t;
 typedef struct profiler_time_entry profiler_time_entry_t;
+typedef struct profiler_alloc_site profiler_alloc_site_t;
 
 /* ------------------------------------------------------------------------- */
 /* Profiling */
@@ -30,9 +31,23 @@ EXPORT void profiler_stop(void);
 
 EXPORT void profiler_print(profiler_snapshot_t *snap);
 EXPORT void profiler_print_time_between_calls(profiler_snapshot_t *snap);
+EXPORT void profiler_print_alloc_sites(profiler_snapshot_t *snap,
+				       size_t max_sites);
 
 EXPORT void profiler_free(void);
 
+/* ------------------------------------------------------------------------- */
+/* Tracing
+ *
+ *   Records every profile_start/profile_end as a timestamped event in a per
+ * thread ring buffer, and exports the most recent events in the Chrome trace
+ * event format (chrome://tracing, ui.perfetto.dev). */
+
+EXPORT void profiler_trace_start(void);
+EXPORT void profiler_trace_stop(void);
+EXPORT bool profiler_trace_active(void);
+EXPORT bool profiler_trace_dump_json(const char *filename);
+
 /* ------------------------------------------------------------------------- */
 /* Profiler name storage */
 
@@ -114,6 +129,26 @@ EXPORT uint64_t profiler_snapshot_entry_max_time_between_calls(
 EXPORT uint64_t profiler_snapshot_entry_overall_between_calls_count(
 	profiler_snapshot_entry_t *entry);
 
+/* allocation sites are only recorded while bmem allocation tracking is
+ * enabled (see bmem_start_tracking), and are sorted by allocation rate */
+struct profiler_alloc_site {
+	const char *name;
+	const void *address;
+	uint64_t live_bytes;
+	uint64_t live_allocs;
+	uint64_t total_allocs;
+	double allocs_per_sec; /* averaged since tracking was started */
+};
+
+typedef bool (*profiler_alloc_site_enum_func)(
+	void *context, const profiler_alloc_site_t *site);
+
+EXPORT size_t profiler_snapshot_num_alloc_sites(profiler_snapshot_t *snap);
+EXPORT void
+profiler_snapshot_enumerate_alloc_sites(profiler_snapshot_t *snap,
+					profiler_alloc_site_enum_func func,
+					void *context);
+
 #ifdef __cplusplus
 }
 #endif
@@ -2,6 +2,8 @@
 #include "bmem.h"
 #include "threading.h"
 #include "circlebuf.h"
+#include "darray.h"
+#include "platform.h"
 
 struct os_task_queue {
 	pthread_t thread;
@@ -163,3 +165,357 @@ static void *tiny_tubular_task_thread(void *param)
 
 	return NULL;
 }
+
+/* ------------------------------------------------------------------------- */
+
+#define NUM_JOB_PRIORITIES 3
+#define MAX_JOB_POOL_THREADS 8
+
+struct os_job {
+	volatile long refs;
+	struct os_job_pool *pool;
+	enum os_job_priority priority;
+	os_task_t task;
+	void *param;
+
+	/* unfinished dependencies, plus one while the job is being added */
+	volatile long pending;
+
+	pthread_mutex_t mutex;
+	bool done;
+	os_event_t *done_event;
+	DARRAY(struct os_job *) dependents;
+};
+
+struct job_worker {
+	struct os_job_pool *pool;
+	pthread_t thread;
+	bool thread_created;
+
+	pthread_mutex_t mutex;
+	struct circlebuf jobs[NUM_JOB_PRIORITIES];
+};
+
+/* the semaphore is posted once for every runnable job and a worker only takes
+ * a job after waking up for one, so there's always a job for every worker
+ * that finds itself awake */
+struct os_job_pool {
+	struct job_worker *workers;
+	size_t num_workers;
+	volatile long next_worker;
+	os_sem_t *sem;
+	volatile bool stop;
+
+	pthread_mutex_t mutex;
+	size_t outstanding;
+	os_event_t *idle_event;
+};
+
+static THREAD_LOCAL struct job_worker *cur_worker = NULL;
+
+static inline void job_addref(struct os_job *job)
+{
+	os_atomic_inc_long(&job->refs);
+}
+
+void os_job_release(os_job_t *job)
+{
+	if (!job || os_atomic_dec_long(&job->refs) != 0)
+		return;
+
+	da_free(job->dependents);
+	os_event_destroy(job->done_event);
+	pthread_mutex_destroy(&job->mutex);
+	bfree(job);
+}
+
+/* jobs queued from one of the pool's own workers stay on that worker, the
+ * rest are spread out between them */
+static void push_job(struct os_job_pool *pool, struct os_job *job)
+{
+	struct job_worker *worker = cur_worker;
+
+	if (!worker || worker->pool != pool) {
+		size_t idx = (size_t)os_atomic_inc_long(&pool->next_worker);
+		worker = &pool->workers[idx % pool->num_workers];
+	}
+
+	pthread_mutex_lock(&worker->mutex);
+	circlebuf_push_back(&worker->jobs[job->priority], &job, sizeof(job));
+	pthread_mutex_unlock(&worker->mutex);
+
+	os_sem_post(pool->sem);
+}
+
+static struct os_job *pop_job(struct job_worker *worker, size_t priority,
+			      bool steal)
+{
+	struct circlebuf *jobs = &worker->jobs[priority];
+	struct os_job *job = NULL;
+
+	pthread_mutex_lock(&worker->mutex);
+	if (jobs->size) {
+		if (steal)
+			circlebuf_pop_back(jobs, &job, sizeof(job));
+		else
+			circlebuf_pop_front(jobs, &job, sizeof(job));
+	}
+	pthread_mutex_unlock(&worker->mutex);
+
+	return job;
+}
+
+/* a worker takes its own oldest jobs first and steals the newest jobs of the
+ * others, but never a lower priority job while a higher one is queued */
+static struct os_job *take_job(struct job_worker *worker)
+{
+	struct os_job_pool *pool = worker->pool;
+	size_t self = (size_t)(worker - pool->workers);
+
+	for (size_t p = 0; p < NUM_JOB_PRIORITIES; p++) {
+		struct os_job *job = pop_job(worker, p, false);
+		if (job)
+			return job;
+
+		for (size_t i = 1; i < pool->num_workers; i++) {
+			size_t idx = (self + i) % pool->num_workers;
+			job = pop_job(&pool->workers[idx], p, true);
+			if (job)
+				return job;
+		}
+	}
+
+	return NULL;
+}
+
+static void finish_job(struct os_job *job)
+{
+	struct os_job_pool *pool = job->pool;
+	DARRAY(struct os_job *) dependents;
+
+	pthread_mutex_lock(&job->mutex);
+	job->done = true;
+	dependents.da = job->dependents.da;
+	da_init(job->dependents);
+	pthread_mutex_unlock(&job->mutex);
+
+	os_event_signal(job->done_event);
+
+	for (size_t i = 0; i < dependents.num; i++) {
+		struct os_job *dependent = dependents.array[i];
+		if (os_atomic_dec_long(&dependent->pending) == 0)
+			push_job(pool, dependent);
+		os_job_release(dependent);
+	}
+	da_free(dependents);
+
+	pthread_mutex_lock(&pool->mutex);
+	if (--pool->outstanding == 0)
+		os_event_signal(pool->idle_event);
+	pthread_mutex_unlock(&pool->mutex);
+
+	os_job_release(job);
+}
+
+static void *job_worker_thread(void *param)
+{
+	struct job_worker *worker = param;
+	struct os_job_pool *pool = worker->pool;
+
+	cur_worker = worker;
+	os_set_thread_name("libobs: job pool worker");
+
+	while (os_sem_wait(pool->sem) == 0) {
+		struct os_job *job;
+
+		if (os_atomic_load_bool(&pool->stop))
+			break;
+
+		/* the job this wakeup is for may still be on its way into
+		 * another worker's queue */
+		while (!(job = take_job(worker)))
+			os_sleep_ms(0);
+
+		job->task(job->param);
+		finish_job(job);
+	}
+
+	return NULL;
+}
+
+static size_t default_pool_threads(void)
+{
+	int cores = os_get_logical_cores() - 1;
+
+	if (cores < 2)
+		return 2;
+	if (cores > MAX_JOB_POOL_THREADS)
+		return MAX_JOB_POOL_THREADS;
+	return (size_t)cores;
+}
+
+os_job_pool_t *os_job_pool_create(size_t threads)
+{
+	struct os_job_pool *pool = bzalloc(sizeof(*pool));
+
+	if (!threads)
+		threads = default_pool_threads();
+
+	pool->num_workers = threads;
+	pool->workers = bzalloc(sizeof(struct job_worker) * threads);
+
+	if (pthread_mutex_init(&pool->mutex, NULL) != 0)
+		goto fail1;
+	if (os_sem_init(&pool->sem, 0) != 0)
+		goto fail2;
+	if (os_event_init(&pool->idle_event, OS_EVENT_TYPE_MANUAL) != 0)
+		goto fail3;
+
+	os_event_signal(pool->idle_event);
+
+	for (size_t i = 0; i < threads; i++) {
+		struct job_worker *worker = &pool->workers[i];
+		worker->pool = pool;
+		pthread_mutex_init(&worker->mutex, NULL);
+	}
+
+	for (size_t i = 0; i < threads; i++) {
+		struct job_worker *worker = &pool->workers[i];
+		if (pthread_create(&worker->thread, NULL, job_worker_thread,
+				   worker) != 0) {
+			os_job_pool_destroy(pool);
+			return NULL;
+		}
+		worker->thread_created = true;
+	}
+
+	return pool;
+
+fail3:
+	os_sem_destroy(pool->sem);
+fail2:
+	pthread_mutex_destroy(&pool->mutex);
+fail1:
+	bfree(pool->workers);
+	bfree(pool);
+	return NULL;
+}
+
+void os_job_pool_destroy(os_job_pool_t *pool)
+{
+	if (!pool)
+		return;
+
+	os_job_pool_wait(pool);
+
+	os_atomic_set_bool(&pool->stop, true);
+	for (size_t i = 0; i < pool->num_workers; i++)
+		os_sem_post(pool->sem);
+
+	for (size_t i = 0; i < pool->num_workers; i++) {
+		struct job_worker *worker = &pool->workers[i];
+
+		if (worker->thread_created)
+			pthread_join(worker->thread, NULL);
+		for (size_t p = 0; p < NUM_JOB_PRIORITIES; p++)
+			circlebuf_free(&worker->jobs[p]);
+		pthread_mutex_destroy(&worker->mutex);
+	}
+
+	os_event_destroy(pool->idle_event);
+	os_sem_destroy(pool->sem);
+	pthread_mutex_destroy(&pool->mutex);
+	bfree(pool->workers);
+	bfree(pool);
+}
+
+os_job_t *os_job_pool_add(os_job_pool_t *pool, enum os_job_priority priority,
+			  os_task_t task, void *param, os_job_t *const *deps,
+			  size_t num_deps)
+{
+	struct os_job *job;
+
+	if (!pool || !task)
+		return NULL;
+	if ((size_t)priority >= NUM_JOB_PRIORITIES)
+		priority = OS_JOB_PRIORITY_NORMAL;
+
+	job = bzalloc(sizeof(*job));
+	job->refs = 2;
+	job->pending = 1;
+	job->pool = pool;
+	job->priority = priority;
+	job->task = task;
+	job->param = param;
+	pthread_mutex_init(&job->mutex, NULL);
+	os_event_init(&job->done_event, OS_EVENT_TYPE_MANUAL);
+
+	pthread_mutex_lock(&pool->mutex);
+	if (pool->outstanding++ == 0)
+		os_event_reset(pool->idle_event);
+	pthread_mutex_unlock(&pool->mutex);
+
+	for (size_t i = 0; i < num_deps; i++) {
+		struct os_job *dep = deps[i];
+		if (!dep)
+			continue;
+
+		pthread_mutex_lock(&dep->mutex);
+		if (!dep->done) {
+			os_atomic_inc_long(&job->pending);
+			job_addref(job);
+			da_push_back(dep->dependents, &job);
+		}
+		pthread_mutex_unlock(&dep->mutex);
+	}
+
+	if (os_atomic_dec_long(&job->pending) == 0)
+		push_job(pool, job);
+
+	return job;
+}
+
+bool os_job_pool_queue_task(os_job_pool_t *pool, enum os_job_priority priority,
+			    os_task_t task, void *param)
+{
+	os_job_t *job = os_job_pool_add(pool, priority, task, param, NULL, 0);
+	os_job_release(job);
+	return !!job;
+}
+
+bool os_job_pool_wait(os_job_pool_t *pool)
+{
+	bool had_jobs;
+
+	if (!pool)
+		return false;
+
+	pthread_mutex_lock(&pool->mutex);
+	had_jobs = pool->outstanding != 0;
+	pthread_mutex_unlock(&pool->mutex);
+
+	for (;;) {
+		bool idle;
+
+		pthread_mutex_lock(&pool->mutex);
+		idle = pool->outstanding == 0;
+		pthread_mutex_unlock(&pool->mutex);
+
+		if (idle)
+			break;
+		os_event_wait(pool->idle_event);
+	}
+
+	return had_jobs;
+}
+
+bool os_job_pool_inside(os_job_pool_t *pool)
+{
+	return pool && cur_worker && cur_worker->pool == pool;
+}
+
+void os_job_wait(os_job_t *job)
+{
+	if (job)
+		os_event_wait(job->done_event);
+}
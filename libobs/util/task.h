@@ -18,6 +18,57 @@ EXPORT void os_task_queue_destroy(os_task_queue_t *tt);
 EXPORT bool os_task_queue_wait(os_task_queue_t *tt);
 EXPORT bool os_task_queue_inside(os_task_queue_t *tt);
 
+/* ------------------------------------------------------------------------- */
+/* job pool: unordered tasks spread across a pool of worker threads, which
+ * steal from each other when they run out of work.  a job can depend on other
+ * jobs, in which case it only runs once they have all finished.  tasks that
+ * have to run in order should use a task queue instead. */
+
+struct os_job_pool;
+struct os_job;
+typedef struct os_job_pool os_job_pool_t;
+typedef struct os_job os_job_t;
+
+enum os_job_priority {
+	OS_JOB_PRIORITY_HIGH,
+	OS_JOB_PRIORITY_NORMAL,
+	OS_JOB_PRIORITY_LOW,
+};
+
+/** Creates a pool with the given number of threads, 0 to pick from the
+ * number of logical cores */
+EXPORT os_job_pool_t *os_job_pool_create(size_t threads);
+
+/** Waits for every queued job to finish, then stops the pool */
+EXPORT void os_job_pool_destroy(os_job_pool_t *pool);
+
+/**
+ * Queues a job that runs once all of the given jobs have finished (NULL
+ * entries are skipped).  Returns a reference to the job, which has to be
+ * released with os_job_release.
+ */
+EXPORT os_job_t *os_job_pool_add(os_job_pool_t *pool,
+				 enum os_job_priority priority, os_task_t task,
+				 void *param, os_job_t *const *deps,
+				 size_t num_deps);
+
+/** Queues a job without dependencies that nothing needs to wait on */
+EXPORT bool os_job_pool_queue_task(os_job_pool_t *pool,
+				   enum os_job_priority priority,
+				   os_task_t task, void *param);
+
+/**
+ * Waits until the pool has no jobs left.  Returns true if there were any
+ * jobs to wait for.  Must not be called from one of the pool's jobs.
+ */
+EXPORT bool os_job_pool_wait(os_job_pool_t *pool);
+EXPORT bool os_job_pool_inside(os_job_pool_t *pool);
+
+/** Waits for a job to finish.  Jobs in the same pool should use dependencies
+ * instead, waiting on another job from inside a job can deadlock. */
+EXPORT void os_job_wait(os_job_t *job);
+EXPORT void os_job_release(os_job_t *job);
+
 #ifdef __cplusplus
 }
 #endif
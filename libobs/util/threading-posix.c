@@ -30,6 +30,15 @@
 #include <pthread_np.h>
 #endif
 
+#if defined(__linux__)
+#include <errno.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include "obsconfig.h"
+#endif
+
 #include "bmem.h"
 #include "threading.h"
 
@@ -271,3 +280,145 @@ void os_set_thread_name(const char *name)
 	}
 #endif
 }
+
+#if defined(__APPLE__)
+
+struct os_thread_role_data {
+	qos_class_t qos;
+};
+
+static const qos_class_t role_qos[] = {
+	[OS_THREAD_ROLE_RENDER] = QOS_CLASS_USER_INTERACTIVE,
+	[OS_THREAD_ROLE_AUDIO] = QOS_CLASS_USER_INTERACTIVE,
+	[OS_THREAD_ROLE_ENCODE] = QOS_CLASS_USER_INITIATED,
+	[OS_THREAD_ROLE_IO] = QOS_CLASS_USER_INITIATED,
+};
+
+os_thread_role_t *os_set_thread_role(enum os_thread_role role)
+{
+	struct os_thread_role_data *data = bzalloc(sizeof(*data));
+	int relpri;
+
+	if (pthread_get_qos_class_np(pthread_self(), &data->qos, &relpri) != 0)
+		data->qos = QOS_CLASS_DEFAULT;
+
+	pthread_set_qos_class_self_np(role_qos[role], 0);
+	return data;
+}
+
+void os_reset_thread_role(os_thread_role_t *data)
+{
+	if (!data)
+		return;
+
+	pthread_set_qos_class_self_np(data->qos, 0);
+	bfree(data);
+}
+
+#elif defined(__linux__)
+
+#if defined(GIO_FOUND)
+extern bool dbus_rtkit_set_thread_priority(uint64_t tid, bool realtime,
+					   int priority);
+#endif
+
+/* RealtimeKit only hands out real-time priorities up to 20 by default, and
+ * only to processes that limit how long a real-time thread may run without
+ * blocking */
+#define RTKIT_RTTIME_USEC 200000
+
+struct thread_role_info {
+	bool realtime;
+	int priority;
+};
+
+static const struct thread_role_info role_info[] = {
+	[OS_THREAD_ROLE_RENDER] = {true, 5},
+	[OS_THREAD_ROLE_AUDIO] = {true, 10},
+	[OS_THREAD_ROLE_ENCODE] = {false, -5},
+	[OS_THREAD_ROLE_IO] = {false, -5},
+};
+
+struct os_thread_role_data {
+	pid_t tid;
+	int policy;
+	struct sched_param param;
+	int nice;
+};
+
+static bool rtkit_set_priority(pid_t tid, const struct thread_role_info *info)
+{
+#if defined(GIO_FOUND)
+	struct rlimit rl;
+
+	if (info->realtime && getrlimit(RLIMIT_RTTIME, &rl) == 0 &&
+	    (rl.rlim_max == RLIM_INFINITY || rl.rlim_max > RTKIT_RTTIME_USEC)) {
+		rl.rlim_cur = rl.rlim_max = RTKIT_RTTIME_USEC;
+		setrlimit(RLIMIT_RTTIME, &rl);
+	}
+
+	return dbus_rtkit_set_thread_priority((uint64_t)tid, info->realtime,
+					      info->priority);
+#else
+	UNUSED_PARAMETER(tid);
+	UNUSED_PARAMETER(info);
+	return false;
+#endif
+}
+
+os_thread_role_t *os_set_thread_role(enum os_thread_role role)
+{
+	struct os_thread_role_data *data = bzalloc(sizeof(*data));
+	const struct thread_role_info *info = &role_info[role];
+	bool success;
+
+	data->tid = (pid_t)syscall(SYS_gettid);
+	pthread_getschedparam(pthread_self(), &data->policy, &data->param);
+	errno = 0;
+	data->nice = getpriority(PRIO_PROCESS, (id_t)data->tid);
+	if (errno != 0)
+		data->nice = 0;
+
+	if (info->realtime) {
+		struct sched_param param = {.sched_priority = info->priority};
+		success = pthread_setschedparam(pthread_self(), SCHED_RR,
+						&param) == 0;
+	} else {
+		success = setpriority(PRIO_PROCESS, (id_t)data->tid,
+				      info->priority) == 0;
+	}
+
+	if (!success && !rtkit_set_priority(data->tid, info))
+		blog(LOG_DEBUG,
+		     "os_set_thread_role: Could not raise the priority of "
+		     "thread %d",
+		     (int)data->tid);
+
+	return data;
+}
+
+/* lowering priority is always permitted, so this never needs RealtimeKit */
+void os_reset_thread_role(os_thread_role_t *data)
+{
+	if (!data)
+		return;
+
+	pthread_setschedparam(pthread_self(), data->policy, &data->param);
+	setpriority(PRIO_PROCESS, (id_t)data->tid, data->nice);
+	bfree(data);
+}
+
+#else
+
+os_thread_role_t *os_set_thread_role(enum os_thread_role role)
+{
+	UNUSED_PARAMETER(role);
+	return NULL;
+}
+
+void os_reset_thread_role(os_thread_role_t *data)
+{
+	UNUSED_PARAMETER(data);
+}
+
+#endif
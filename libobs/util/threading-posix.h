@@ -79,3 +79,18 @@ static inline bool os_atomic_load_bool(const volatile bool *ptr)
 {
 	return __atomic_load_n(ptr, __ATOMIC_SEQ_CST);
 }
+
+static inline int64_t os_atomic_add_int64(volatile int64_t *val, int64_t add)
+{
+	return __atomic_add_fetch(val, add, __ATOMIC_SEQ_CST);
+}
+
+static inline void os_atomic_store_int64(volatile int64_t *ptr, int64_t val)
+{
+	__atomic_store_n(ptr, val, __ATOMIC_SEQ_CST);
+}
+
+static inline int64_t os_atomic_load_int64(const volatile int64_t *ptr)
+{
+	return __atomic_load_n(ptr, __ATOMIC_SEQ_CST);
+}
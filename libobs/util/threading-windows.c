@@ -20,6 +20,7 @@
 
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
+#include <avrt.h>
 #include <KnownFolders.h>
 #include <ShlObj_core.h>
 
@@ -224,3 +225,48 @@ void os_set_thread_name(const char *name)
 		FreeLibrary(hModule);
 	}
 }
+
+struct os_thread_role_data {
+	HANDLE mmcss;
+	int priority;
+};
+
+/* roles without an MMCSS task just get a raised thread priority */
+static const wchar_t *const role_tasks[] = {
+	[OS_THREAD_ROLE_RENDER] = L"Capture",
+	[OS_THREAD_ROLE_AUDIO] = L"Pro Audio",
+	[OS_THREAD_ROLE_ENCODE] = NULL,
+	[OS_THREAD_ROLE_IO] = NULL,
+};
+
+os_thread_role_t *os_set_thread_role(enum os_thread_role role)
+{
+	struct os_thread_role_data *data = bzalloc(sizeof(*data));
+	const wchar_t *task = role_tasks[role];
+
+	data->priority = GetThreadPriority(GetCurrentThread());
+
+	if (task) {
+		DWORD task_index = 0;
+		data->mmcss = AvSetMmThreadCharacteristicsW(task, &task_index);
+	}
+
+	if (!data->mmcss)
+		SetThreadPriority(GetCurrentThread(),
+				  THREAD_PRIORITY_ABOVE_NORMAL);
+
+	return data;
+}
+
+void os_reset_thread_role(os_thread_role_t *data)
+{
+	if (!data)
+		return;
+
+	if (data->mmcss)
+		AvRevertMmThreadCharacteristics(data->mmcss);
+	else
+		SetThreadPriority(GetCurrentThread(), data->priority);
+
+	bfree(data);
+}
@@ -144,3 +144,19 @@ static inline bool os_atomic_load_bool(const volatile bool *ptr)
 
 	return b;
 }
+
+static inline int64_t os_atomic_add_int64(volatile int64_t *val, int64_t add)
+{
+	return _InterlockedExchangeAdd64(val, add) + add;
+}
+
+static inline void os_atomic_store_int64(volatile int64_t *ptr, int64_t val)
+{
+	_InterlockedExchange64(ptr, val);
+}
+
+static inline int64_t os_atomic_load_int64(const volatile int64_t *ptr)
+{
+	/* also atomic on 32-bit targets, unlike a plain 64-bit load */
+	return _InterlockedCompareExchange64((volatile int64_t *)ptr, 0, 0);
+}
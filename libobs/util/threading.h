@@ -92,6 +92,26 @@ EXPORT int os_sem_wait(os_sem_t *sem);
 
 EXPORT void os_set_thread_name(const char *name);
 
+enum os_thread_role {
+	OS_THREAD_ROLE_RENDER,
+	OS_THREAD_ROLE_AUDIO,
+	OS_THREAD_ROLE_ENCODE,
+	OS_THREAD_ROLE_IO,
+};
+
+struct os_thread_role_data;
+typedef struct os_thread_role_data os_thread_role_t;
+
+/**
+ * Raises the scheduling priority of the calling thread to suit what it does:
+ * MMCSS on Windows, real-time or raised priority (through RealtimeKit if
+ * needed) on Linux, and QoS classes on macOS.  If that isn't permitted, the
+ * thread just keeps its priority.  Pass the result to os_reset_thread_role
+ * on the same thread before it exits.
+ */
+EXPORT os_thread_role_t *os_set_thread_role(enum os_thread_role role);
+EXPORT void os_reset_thread_role(os_thread_role_t *data);
+
 #ifdef _MSC_VER
 #define THREAD_LOCAL __declspec(thread)
 #else
@@ -242,6 +242,46 @@ static inline bool TransferAudio(CNTV2Card *card,
 	return true;
 }
 
+/* DMA the card frame straight into a cached async frame so it doesn't have to
+ * be copied again by obs_source_output_video2.  Only works when the card and
+ * libobs agree on the row pitch, otherwise the caller falls back to the
+ * intermediate DMA buffer. */
+static bool DMAReadToCachedFrame(obs_source_t *source, CNTV2Card *card,
+				 ULWord cardFrame, const NTV2FormatDesc &fd,
+				 enum video_format format,
+				 video_colorspace colorspace)
+{
+	if (format == VIDEO_FORMAT_NONE)
+		return false;
+
+	const uint32_t width = fd.GetRasterWidth();
+	const uint32_t height = fd.GetRasterHeight();
+	const ULWord rowBytes = fd.GetBytesPerRow();
+
+	obs_source_frame *frame =
+		obs_source_frame_acquire(source, format, width, height);
+	if (!frame)
+		return false;
+
+	if (frame->linesize[0] != rowBytes ||
+	    !card->DMAReadFrame(cardFrame, (ULWord *)frame->data[0],
+				rowBytes * height)) {
+		obs_source_frame_discard(source, frame);
+		return false;
+	}
+
+	frame->timestamp = os_gettime_ns();
+	frame->flip = false;
+	frame->full_range = false;
+	video_format_get_parameters_for_format(colorspace, VIDEO_RANGE_PARTIAL,
+					       format, frame->color_matrix,
+					       frame->color_range_min,
+					       frame->color_range_max);
+
+	obs_source_frame_submit(source, frame);
+	return true;
+}
+
 void AJASource::CaptureThread(AJAThread *thread, void *data)
 {
 	UNUSED_PARAMETER(thread);
@@ -356,9 +396,6 @@ void AJASource::CaptureThread(AJAThread *thread, void *data)
 			continue;
 		}
 
-		card->DMAReadFrame(currentCardFrame, ajaSource->mVideoBuffer,
-				   ajaSource->mVideoBuffer.GetByteCount());
-
 		auto actualVideoFormat = videoFormat;
 		if (aja::Is3GLevelB(card, channel))
 			actualVideoFormat = aja::GetLevelAFormatForLevelBFormat(
@@ -369,6 +406,20 @@ void AJASource::CaptureThread(AJAThread *thread, void *data)
 				sourceProps.pixelFormat);
 
 		NTV2FormatDesc fd(actualVideoFormat, pixelFormat);
+		video_colorspace colorspace = VIDEO_CS_709;
+		if (NTV2_IS_SD_VIDEO_FORMAT(actualVideoFormat))
+			colorspace = VIDEO_CS_601;
+
+		if (DMAReadToCachedFrame(ajaSource->mSource, card,
+					 currentCardFrame, fd, obs_vid_fmt,
+					 colorspace)) {
+			card->SetInputFrame(channel, currentCardFrame);
+			continue;
+		}
+
+		card->DMAReadFrame(currentCardFrame, ajaSource->mVideoBuffer,
+				   ajaSource->mVideoBuffer.GetByteCount());
+
 		struct obs_source_frame2 obsFrame;
 		obsFrame.flip = false;
 		obsFrame.timestamp = os_gettime_ns();
@@ -378,9 +429,6 @@ void AJASource::CaptureThread(AJAThread *thread, void *data)
 		obsFrame.data[0] = reinterpret_cast<uint8_t *>(
 			(ULWord *)ajaSource->mVideoBuffer.GetHostPointer());
 		obsFrame.linesize[0] = fd.GetBytesPerRow();
-		video_colorspace colorspace = VIDEO_CS_709;
-		if (NTV2_IS_SD_VIDEO_FORMAT(actualVideoFormat))
-			colorspace = VIDEO_CS_601;
 		video_format_get_parameters_for_format(
 			colorspace, VIDEO_RANGE_PARTIAL, obs_vid_fmt,
 			obsFrame.color_matrix, obsFrame.color_range_min,
@@ -4,6 +4,7 @@
 
 OBS_DECLARE_MODULE()
 OBS_MODULE_USE_DEFAULT_LOCALE("aja", "en-US")
+OBS_MODULE_LOAD_INDEPENDENT()
 
 MODULE_EXPORT const char *obs_module_description(void)
 {
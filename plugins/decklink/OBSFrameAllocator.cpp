@@ -0,0 +1,125 @@
+#include "OBSFrameAllocator.h"
+
+#include <util/bmem.h>
+#include <util/threading.h>
+
+#include <algorithm>
+
+OBSFrameAllocator::OBSFrameAllocator(obs_source_t *source) : source(source)
+{
+}
+
+void OBSFrameAllocator::SetFormat(enum video_format format_, uint32_t width_,
+				  uint32_t height_, uint32_t rowBytes_)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	format = format_;
+	width = width_;
+	height = height_;
+	rowBytes = rowBytes_;
+}
+
+obs_source_frame *OBSFrameAllocator::ClaimFrame(void *buffer)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto it = std::find_if(frames.begin(), frames.end(),
+			       [buffer](obs_source_frame *frame) {
+				       return frame->data[0] == buffer;
+			       });
+	if (it == frames.end())
+		return nullptr;
+
+	obs_source_frame *frame = *it;
+	frames.erase(it);
+	submitted.push_back(buffer);
+	return frame;
+}
+
+HRESULT STDMETHODCALLTYPE
+OBSFrameAllocator::AllocateBuffer(uint32_t bufferSize, void **allocatedBuffer)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	if (format != VIDEO_FORMAT_NONE && bufferSize == rowBytes * height) {
+		obs_source_frame *frame = obs_source_frame_acquire(
+			source, format, width, height);
+
+		if (frame && frame->linesize[0] == rowBytes) {
+			frames.push_back(frame);
+			*allocatedBuffer = frame->data[0];
+			return S_OK;
+		}
+
+		obs_source_frame_discard(source, frame);
+	}
+
+	*allocatedBuffer = bmalloc(bufferSize);
+	return S_OK;
+}
+
+HRESULT STDMETHODCALLTYPE OBSFrameAllocator::ReleaseBuffer(void *buffer)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	/* submitted frames belong to libobs now */
+	auto done = std::find(submitted.begin(), submitted.end(), buffer);
+	if (done != submitted.end()) {
+		submitted.erase(done);
+		return S_OK;
+	}
+
+	auto it = std::find_if(frames.begin(), frames.end(),
+			       [buffer](obs_source_frame *frame) {
+				       return frame->data[0] == buffer;
+			       });
+	if (it != frames.end()) {
+		obs_source_frame_discard(source, *it);
+		frames.erase(it);
+		return S_OK;
+	}
+
+	bfree(buffer);
+	return S_OK;
+}
+
+HRESULT STDMETHODCALLTYPE OBSFrameAllocator::Commit()
+{
+	return S_OK;
+}
+
+HRESULT STDMETHODCALLTYPE OBSFrameAllocator::Decommit()
+{
+	return S_OK;
+}
+
+HRESULT STDMETHODCALLTYPE OBSFrameAllocator::QueryInterface(REFIID iid,
+							    LPVOID *ppv)
+{
+	CFUUIDBytes unknown = CFUUIDGetUUIDBytes(IUnknownUUID);
+	if (memcmp(&iid, &unknown, sizeof(REFIID)) == 0 ||
+	    memcmp(&iid, &IID_IDeckLinkMemoryAllocator, sizeof(REFIID)) == 0) {
+		*ppv = static_cast<IDeckLinkMemoryAllocator *>(this);
+		AddRef();
+		return S_OK;
+	}
+
+	*ppv = nullptr;
+	return E_NOINTERFACE;
+}
+
+ULONG STDMETHODCALLTYPE OBSFrameAllocator::AddRef()
+{
+	return os_atomic_inc_long(&refCount);
+}
+
+ULONG STDMETHODCALLTYPE OBSFrameAllocator::Release()
+{
+	const long newRefCount = os_atomic_dec_long(&refCount);
+	if (newRefCount == 0) {
+		delete this;
+		return 0;
+	}
+
+	return newRefCount;
+}
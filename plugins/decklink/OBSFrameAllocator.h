@@ -0,0 +1,51 @@
+#pragma once
+
+#include "platform.hpp"
+
+#include <obs.h>
+
+#include <mutex>
+#include <vector>
+
+/* Hands DeckLink buffers from the source's async frame cache so captured
+ * frames can be submitted to libobs without being copied.  Buffers of any
+ * other size, or requested while no frames are available, come from the
+ * heap and go through the usual obs_source_output_video2 path. */
+class OBSFrameAllocator : public IDeckLinkMemoryAllocator {
+private:
+	obs_source_t *source;
+	volatile long refCount = 1;
+
+	std::mutex mutex;
+	enum video_format format = VIDEO_FORMAT_NONE;
+	uint32_t width = 0;
+	uint32_t height = 0;
+	uint32_t rowBytes = 0;
+
+	/* frames lent to the driver, and the buffers of frames that were
+	 * already submitted but not yet released by the driver */
+	std::vector<obs_source_frame *> frames;
+	std::vector<void *> submitted;
+
+public:
+	explicit OBSFrameAllocator(obs_source_t *source);
+	virtual ~OBSFrameAllocator() = default;
+
+	void SetFormat(enum video_format format, uint32_t width,
+		       uint32_t height, uint32_t rowBytes);
+
+	/* returns the cache frame that owns the buffer, or nullptr if the
+	 * buffer is a heap one.  The frame must be submitted right away */
+	obs_source_frame *ClaimFrame(void *buffer);
+
+	HRESULT STDMETHODCALLTYPE AllocateBuffer(uint32_t bufferSize,
+						 void **allocatedBuffer) override;
+	HRESULT STDMETHODCALLTYPE ReleaseBuffer(void *buffer) override;
+	HRESULT STDMETHODCALLTYPE Commit() override;
+	HRESULT STDMETHODCALLTYPE Decommit() override;
+
+	HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid,
+						 LPVOID *ppv) override;
+	ULONG STDMETHODCALLTYPE AddRef() override;
+	ULONG STDMETHODCALLTYPE Release() override;
+};
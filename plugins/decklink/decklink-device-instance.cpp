@@ -190,9 +190,27 @@ void DeckLinkDeviceInstance::HandleVideoFrame(
 	if (currentFrame.width == 0 || currentFrame.height == 0)
 		return;
 
-	obs_source_output_video2(
-		static_cast<DeckLinkInput *>(decklink)->GetSource(),
-		&currentFrame);
+	obs_source_t *source =
+		static_cast<DeckLinkInput *>(decklink)->GetSource();
+
+	/* the driver captured straight into a cached frame */
+	obs_source_frame *obsFrame =
+		frameAllocator ? frameAllocator->ClaimFrame(bytes) : nullptr;
+	if (obsFrame) {
+		obsFrame->timestamp = timestamp;
+		obsFrame->full_range = colorRange == VIDEO_RANGE_FULL;
+		memcpy(obsFrame->color_matrix, currentFrame.color_matrix,
+		       sizeof(obsFrame->color_matrix));
+		memcpy(obsFrame->color_range_min, currentFrame.color_range_min,
+		       sizeof(obsFrame->color_range_min));
+		memcpy(obsFrame->color_range_max, currentFrame.color_range_max,
+		       sizeof(obsFrame->color_range_max));
+
+		obs_source_frame_submit(source, obsFrame);
+		return;
+	}
+
+	obs_source_output_video2(source, &currentFrame);
 }
 
 void DeckLinkDeviceInstance::HandleCaptionPacket(
@@ -348,6 +366,21 @@ void DeckLinkDeviceInstance::SetupVideoFormat(DeckLinkDeviceMode *mode_)
 	convertFrame = new OBSVideoFrame(mode_->GetWidth(), mode_->GetHeight(),
 					 convertFormat);
 
+	/* frames that need converting can't be captured into the cache */
+	if (frameAllocator) {
+		const uint32_t width = (uint32_t)mode_->GetWidth();
+		const uint32_t height = (uint32_t)mode_->GetHeight();
+
+		if (pixelFormat == bmdFormat8BitYUV)
+			frameAllocator->SetFormat(format, width, height,
+						  width * 2);
+		else if (pixelFormat == bmdFormat8BitBGRA)
+			frameAllocator->SetFormat(format, width, height,
+						  width * 4);
+		else
+			frameAllocator->SetFormat(VIDEO_FORMAT_NONE, 0, 0, 0);
+	}
+
 #ifdef LOG_SETUP_VIDEO_FORMAT
 	LOG(LOG_INFO, "Setup video format: %s, %s, %s",
 	    pixelFormat == bmdFormat8BitYUV ? "YUV" : "RGB",
@@ -424,6 +457,16 @@ bool DeckLinkDeviceInstance::StartCapture(DeckLinkDeviceMode *mode_,
 
 	allow10Bit = allow10Bit_;
 
+	if (!frameAllocator)
+		frameAllocator.Set(new OBSFrameAllocator(
+			static_cast<DeckLinkInput *>(decklink)->GetSource()));
+
+	if (input->SetVideoInputFrameMemoryAllocator(frameAllocator) != S_OK) {
+		LOG(LOG_WARNING,
+		    "Failed to set frame allocator, frames will be copied");
+		frameAllocator.Clear();
+	}
+
 	const HRESULT videoResult =
 		input->EnableVideoInput(displayMode, pixelFormat, flags);
 	if (videoResult != S_OK) {
@@ -537,9 +580,14 @@ bool DeckLinkDeviceInstance::StartOutput(DeckLinkDeviceMode *mode_)
 	if (decklinkOutput == nullptr)
 		return false;
 
-	int rowBytes = decklinkOutput->GetWidth() * 2;
+	if (!mode_->GetFrameRate(&frameDuration, &frameTimescale)) {
+		LOG(LOG_ERROR, "Failed to get output frame rate");
+		return false;
+	}
+
+	outputRowBytes = decklinkOutput->GetWidth() * 2;
 	if (decklinkOutput->keyerMode != 0) {
-		rowBytes = decklinkOutput->GetWidth() * 4;
+		outputRowBytes = decklinkOutput->GetWidth() * 4;
 	}
 
 	BMDPixelFormat pixelFormat = bmdFormat8BitYUV;
@@ -547,16 +595,39 @@ bool DeckLinkDeviceInstance::StartOutput(DeckLinkDeviceMode *mode_)
 		pixelFormat = bmdFormat8BitBGRA;
 	}
 
-	HRESULT result;
-	result = output->CreateVideoFrame(decklinkOutput->GetWidth(),
-					  decklinkOutput->GetHeight(), rowBytes,
-					  pixelFormat, bmdFrameFlagDefault,
-					  &decklinkOutputFrame);
-	if (result != S_OK) {
-		blog(LOG_ERROR, "failed to make frame 0x%X", result);
-		return false;
+	prerollFrames = std::clamp(decklinkOutput->prerollFrames, 1, 16);
+
+	/* enough frames to fill the preroll, plus one being displayed and
+	 * one being written to */
+	const int poolSize = prerollFrames + 2;
+
+	std::lock_guard<std::mutex> lock(outputFramesMutex);
+	for (int i = 0; i < poolSize; i++) {
+		ComPtr<IDeckLinkMutableVideoFrame> frame;
+		HRESULT result = output->CreateVideoFrame(
+			decklinkOutput->GetWidth(), decklinkOutput->GetHeight(),
+			outputRowBytes, pixelFormat, bmdFrameFlagDefault,
+			&frame);
+		if (result != S_OK) {
+			blog(LOG_ERROR, "failed to make frame 0x%X", result);
+			outputFrames.clear();
+			freeOutputFrames.clear();
+			return false;
+		}
+
+		freeOutputFrames.push_back(frame);
+		outputFrames.push_back(std::move(frame));
 	}
 
+	lastScheduledTime = -1;
+	scheduledFrames = 0;
+	playbackStarted = false;
+	droppedOutputFrames = 0;
+	lateOutputFrames = 0;
+
+	output->SetScheduledFrameCompletionCallback(this);
+	output->BeginAudioPreroll();
+
 	return true;
 }
 
@@ -568,11 +639,24 @@ bool DeckLinkDeviceInstance::StopOutput()
 	LOG(LOG_INFO, "Stopping output of '%s'...",
 	    GetDevice()->GetDisplayName().c_str());
 
+	if (playbackStarted)
+		output->StopScheduledPlayback(0, nullptr, 0);
+
 	output->DisableVideoOutput();
 	output->DisableAudioOutput();
-
-	if (decklinkOutputFrame != nullptr)
-		decklinkOutputFrame = nullptr;
+	output->SetScheduledFrameCompletionCallback(nullptr);
+
+	if (droppedOutputFrames || lateOutputFrames)
+		LOG(LOG_INFO,
+		    "Output frames dropped: %llu, displayed late: %llu",
+		    (unsigned long long)droppedOutputFrames,
+		    (unsigned long long)lateOutputFrames);
+
+	std::lock_guard<std::mutex> lock(outputFramesMutex);
+	freeOutputFrames.clear();
+	outputFrames.clear();
+	playbackStarted = false;
+	mode = nullptr;
 
 	return true;
 }
@@ -583,27 +667,107 @@ void DeckLinkDeviceInstance::DisplayVideoFrame(video_data *frame)
 	if (decklinkOutput == nullptr)
 		return;
 
+	IDeckLinkMutableVideoFrame *outputFrame = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(outputFramesMutex);
+		if (!freeOutputFrames.empty()) {
+			outputFrame = freeOutputFrames.back();
+			freeOutputFrames.pop_back();
+		}
+	}
+
+	/* the card is still holding on to every frame in the pool, so it's
+	 * that far behind already */
+	if (!outputFrame) {
+		droppedOutputFrames++;
+		return;
+	}
+
 	uint8_t *destData;
-	decklinkOutputFrame->GetBytes((void **)&destData);
+	outputFrame->GetBytes((void **)&destData);
 
-	uint8_t *outData = frame->data[0];
+	const uint8_t *outData = frame->data[0];
+	const uint32_t height = decklinkOutput->GetHeight();
 
-	int rowBytes = decklinkOutput->GetWidth() * 2;
-	if (device->GetKeyerMode()) {
-		rowBytes = decklinkOutput->GetWidth() * 4;
+	if (frame->linesize[0] == outputRowBytes) {
+		memcpy(destData, outData, (size_t)outputRowBytes * height);
+	} else {
+		for (uint32_t y = 0; y < height; y++)
+			memcpy(destData + y * outputRowBytes,
+			       outData + y * frame->linesize[0],
+			       outputRowBytes);
+	}
+
+	/* frames are placed on the card's timeline by their timestamp rather
+	 * than by count, so a frame skipped by OBS doesn't pull the video out
+	 * of sync with the audio scheduled alongside it */
+	uint64_t elapsed = frame->timestamp - decklinkOutput->start_timestamp;
+	BMDTimeValue displayTime =
+		(BMDTimeValue)util_mul_div64(elapsed, frameTimescale,
+					     1000000000ULL);
+	displayTime = (displayTime + frameDuration / 2) / frameDuration *
+		      frameDuration;
+	if (displayTime <= lastScheduledTime)
+		displayTime = lastScheduledTime + frameDuration;
+
+	HRESULT result = output->ScheduleVideoFrame(
+		outputFrame, displayTime, frameDuration, frameTimescale);
+	if (result != S_OK) {
+		std::lock_guard<std::mutex> lock(outputFramesMutex);
+		freeOutputFrames.push_back(outputFrame);
+		droppedOutputFrames++;
+		return;
 	}
 
-	std::copy(outData, outData + (decklinkOutput->GetHeight() * rowBytes),
-		  destData);
+	lastScheduledTime = displayTime;
 
-	output->DisplayVideoFrameSync(decklinkOutputFrame);
+	if (!playbackStarted && ++scheduledFrames >= prerollFrames) {
+		output->EndAudioPreroll();
+		result = output->StartScheduledPlayback(0, frameTimescale, 1.0);
+		if (result != S_OK)
+			LOG(LOG_ERROR, "Failed to start scheduled playback");
+		playbackStarted = true;
+	}
 }
 
 void DeckLinkDeviceInstance::WriteAudio(audio_data *frames)
 {
+	auto decklinkOutput = dynamic_cast<DeckLinkOutput *>(decklink);
+	if (decklinkOutput == nullptr)
+		return;
+
+	uint64_t elapsed = frames->timestamp - decklinkOutput->start_timestamp;
+	BMDTimeValue streamTime =
+		(BMDTimeValue)util_mul_div64(elapsed, 48000, 1000000000ULL);
+
 	uint32_t sampleFramesWritten;
-	output->WriteAudioSamplesSync(frames->data[0], frames->frames,
-				      &sampleFramesWritten);
+	output->ScheduleAudioSamples(frames->data[0], frames->frames,
+				     streamTime, 48000, &sampleFramesWritten);
+}
+
+HRESULT STDMETHODCALLTYPE DeckLinkDeviceInstance::ScheduledFrameCompleted(
+	IDeckLinkVideoFrame *completedFrame,
+	BMDOutputFrameCompletionResult result)
+{
+	std::lock_guard<std::mutex> lock(outputFramesMutex);
+
+	if (result == bmdOutputFrameDisplayedLate ||
+	    result == bmdOutputFrameDropped)
+		lateOutputFrames++;
+
+	for (auto &frame : outputFrames) {
+		if (frame.Get() == completedFrame) {
+			freeOutputFrames.push_back(frame);
+			break;
+		}
+	}
+
+	return S_OK;
+}
+
+HRESULT STDMETHODCALLTYPE DeckLinkDeviceInstance::ScheduledPlaybackHasStopped()
+{
+	return S_OK;
 }
 
 #define TIME_BASE 1000000000
@@ -716,6 +880,11 @@ HRESULT STDMETHODCALLTYPE DeckLinkDeviceInstance::QueryInterface(REFIID iid,
 		*ppv = (IDeckLinkNotificationCallback *)this;
 		AddRef();
 		result = S_OK;
+	} else if (memcmp(&iid, &IID_IDeckLinkVideoOutputCallback,
+			  sizeof(REFIID)) == 0) {
+		*ppv = (IDeckLinkVideoOutputCallback *)this;
+		AddRef();
+		result = S_OK;
 	}
 
 	return result;
@@ -7,11 +7,16 @@
 #include <media-io/video-scaler.h>
 #include "decklink-device.hpp"
 #include "OBSVideoFrame.h"
+#include "OBSFrameAllocator.h"
+
+#include <mutex>
+#include <vector>
 
 class AudioRepacker;
 class DecklinkBase;
 
-class DeckLinkDeviceInstance : public IDeckLinkInputCallback {
+class DeckLinkDeviceInstance : public IDeckLinkInputCallback,
+			       public IDeckLinkVideoOutputCallback {
 protected:
 	ComPtr<IDeckLinkConfiguration> deckLinkConfiguration;
 	struct obs_source_frame2 currentFrame;
@@ -39,7 +44,22 @@ protected:
 	bool allow10Bit;
 
 	OBSVideoFrame *convertFrame = nullptr;
-	ComPtr<IDeckLinkMutableVideoFrame> decklinkOutputFrame;
+	ComPtr<OBSFrameAllocator> frameAllocator;
+
+	/* output frames are scheduled ahead of time, and go back to the free
+	 * list once the card reports that it's finished with them */
+	std::mutex outputFramesMutex;
+	std::vector<ComPtr<IDeckLinkMutableVideoFrame>> outputFrames;
+	std::vector<IDeckLinkMutableVideoFrame *> freeOutputFrames;
+	BMDTimeValue frameDuration = 0;
+	BMDTimeScale frameTimescale = 0;
+	BMDTimeValue lastScheduledTime = -1;
+	uint32_t outputRowBytes = 0;
+	int prerollFrames = 0;
+	int scheduledFrames = 0;
+	bool playbackStarted = false;
+	uint64_t droppedOutputFrames = 0;
+	uint64_t lateOutputFrames = 0;
 
 	void FinalizeStream();
 	void SetupVideoFormat(DeckLinkDeviceMode *mode_);
@@ -103,6 +123,11 @@ public:
 		IDeckLinkDisplayMode *newMode,
 		BMDDetectedVideoInputFormatFlags detectedSignalFlags);
 
+	HRESULT STDMETHODCALLTYPE
+	ScheduledFrameCompleted(IDeckLinkVideoFrame *completedFrame,
+				BMDOutputFrameCompletionResult result);
+	HRESULT STDMETHODCALLTYPE ScheduledPlaybackHasStopped(void);
+
 	ULONG STDMETHODCALLTYPE AddRef(void);
 	HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, LPVOID *ppv);
 	ULONG STDMETHODCALLTYPE Release(void);
@@ -74,6 +74,12 @@ bool DeckLinkDeviceMode::IsEqualFrameRate(int64_t num, int64_t den)
 	return equal;
 }
 
+bool DeckLinkDeviceMode::GetFrameRate(BMDTimeValue *duration,
+				      BMDTimeScale *scale)
+{
+	return mode && SUCCEEDED(mode->GetFrameRate(duration, scale));
+}
+
 void DeckLinkDeviceMode::SetMode(IDeckLinkDisplayMode *mode_)
 {
 	mode = mode_;
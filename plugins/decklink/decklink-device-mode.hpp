@@ -22,6 +22,7 @@ public:
 	long long GetId(void) const;
 	const std::string &GetName(void) const;
 	bool IsEqualFrameRate(int64_t num, int64_t den);
+	bool GetFrameRate(BMDTimeValue *duration, BMDTimeScale *scale);
 
 	void SetMode(IDeckLinkDisplayMode *mode);
 
@@ -24,6 +24,8 @@ static void *decklink_output_create(obs_data_t *settings, obs_output_t *output)
 	decklinkOutput->deviceHash = obs_data_get_string(settings, DEVICE_HASH);
 	decklinkOutput->modeID = obs_data_get_int(settings, MODE_ID);
 	decklinkOutput->keyerMode = (int)obs_data_get_int(settings, KEYER);
+	decklinkOutput->prerollFrames =
+		(int)obs_data_get_int(settings, PREROLL);
 
 	return decklinkOutput;
 }
@@ -35,6 +37,7 @@ static void decklink_output_update(void *data, obs_data_t *settings)
 	decklink->deviceHash = obs_data_get_string(settings, DEVICE_HASH);
 	decklink->modeID = obs_data_get_int(settings, MODE_ID);
 	decklink->keyerMode = (int)obs_data_get_int(settings, KEYER);
+	decklink->prerollFrames = (int)obs_data_get_int(settings, PREROLL);
 }
 
 static bool decklink_output_start(void *data)
@@ -268,9 +271,16 @@ static obs_properties_t *decklink_output_properties(void *unused)
 	obs_properties_add_list(props, KEYER, TEXT_ENABLE_KEYER,
 				OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT);
 
+	obs_properties_add_int(props, PREROLL, TEXT_PREROLL, 1, 16, 1);
+
 	return props;
 }
 
+static void decklink_output_get_defaults(obs_data_t *settings)
+{
+	obs_data_set_default_int(settings, PREROLL, 3);
+}
+
 static const char *decklink_output_get_name(void *)
 {
 	return obs_module_text("BlackmagicDevice");
@@ -288,6 +298,7 @@ struct obs_output_info create_decklink_output_info()
 	decklink_output_info.start = decklink_output_start;
 	decklink_output_info.stop = decklink_output_stop;
 	decklink_output_info.get_properties = decklink_output_properties;
+	decklink_output_info.get_defaults = decklink_output_get_defaults;
 	decklink_output_info.raw_video = decklink_output_raw_video;
 	decklink_output_info.raw_audio = decklink_output_raw_audio;
 	decklink_output_info.update = decklink_output_update;
@@ -3,6 +3,10 @@
 
 OBS_DECLARE_MODULE()
 OBS_MODULE_USE_DEFAULT_LOCALE("decklink", "en-US")
+#ifndef _WIN32
+/* the Windows SDK is COM based, and the load thread doesn't initialize COM */
+OBS_MODULE_LOAD_INDEPENDENT()
+#endif
 MODULE_EXPORT const char *obs_module_description(void)
 {
 	return "Blackmagic DeckLink source";
@@ -18,12 +18,18 @@ struct image_source {
 	char *file;
 	bool persistent;
 	bool linear_alpha;
+	uint32_t downscale_cx;
+	uint32_t downscale_cy;
+	uint64_t anim_mem_limit;
 	time_t file_timestamp;
 	float update_time_elapsed;
 	uint64_t last_time;
 	bool active;
 	bool restart_gif;
 
+	/* still images come from the shared image cache, animated images are
+	 * loaded into if4 instead */
+	obs_cached_image_t *cached;
 	gs_image_file4_t if4;
 };
 
@@ -41,37 +47,68 @@ static const char *image_source_get_name(void *unused)
 	return obs_module_text("ImageInput");
 }
 
-static void image_source_load(struct image_source *context)
+static void image_source_free_image(struct image_source *context)
 {
-	char *file = context->file;
+	obs_cached_image_release(context->cached);
+	context->cached = NULL;
 
 	obs_enter_graphics();
 	gs_image_file4_free(&context->if4);
 	obs_leave_graphics();
+}
+
+static void image_source_load(struct image_source *context)
+{
+	char *file = context->file;
+
+	image_source_free_image(context);
 
 	if (file && *file) {
+		const enum gs_image_alpha_mode alpha_mode =
+			context->linear_alpha ? GS_IMAGE_ALPHA_PREMULTIPLY_SRGB
+					      : GS_IMAGE_ALPHA_PREMULTIPLY;
+		enum obs_cached_image_state state;
+
 		debug("loading texture '%s'", file);
 		context->file_timestamp = get_modified_timestamp(file);
-		gs_image_file4_init(&context->if4, file,
-				    context->linear_alpha
-					    ? GS_IMAGE_ALPHA_PREMULTIPLY_SRGB
-					    : GS_IMAGE_ALPHA_PREMULTIPLY);
 		context->update_time_elapsed = 0;
 
-		obs_enter_graphics();
-		gs_image_file4_init_texture(&context->if4);
-		obs_leave_graphics();
+		/* waits so the size is known straight away, the slideshow
+		 * relies on it */
+		context->cached = obs_image_cache_get(file, alpha_mode,
+						      context->downscale_cx,
+						      context->downscale_cy,
+						      GS_UNKNOWN);
+		state = obs_cached_image_wait(context->cached);
+
+		if (state == OBS_CACHED_IMAGE_ANIMATED) {
+			obs_cached_image_release(context->cached);
+			context->cached = NULL;
+
+			gs_image_file4_init_ex(&context->if4, file, alpha_mode,
+					       context->downscale_cx,
+					       context->downscale_cy,
+					       context->anim_mem_limit);
 
-		if (!context->if4.image3.image2.image.loaded)
+			obs_enter_graphics();
+			gs_image_file4_init_texture(&context->if4);
+			obs_leave_graphics();
+
+			if (!context->if4.image3.image2.image.loaded)
+				state = OBS_CACHED_IMAGE_FAILED;
+		}
+
+		if (state == OBS_CACHED_IMAGE_FAILED)
 			warn("failed to load texture '%s'", file);
 	}
+
+	obs_source_content_changed(context->source);
 }
 
 static void image_source_unload(struct image_source *context)
 {
-	obs_enter_graphics();
-	gs_image_file4_free(&context->if4);
-	obs_leave_graphics();
+	image_source_free_image(context);
+	obs_source_content_changed(context->source);
 }
 
 static void image_source_update(void *data, obs_data_t *settings)
@@ -80,12 +117,21 @@ static void image_source_update(void *data, obs_data_t *settings)
 	const char *file = obs_data_get_string(settings, "file");
 	const bool unload = obs_data_get_bool(settings, "unload");
 	const bool linear_alpha = obs_data_get_bool(settings, "linear_alpha");
+	const int64_t anim_mem_limit_mb =
+		obs_data_get_int(settings, "anim_mem_limit_mb");
 
 	if (context->file)
 		bfree(context->file);
 	context->file = bstrdup(file);
 	context->persistent = !unload;
 	context->linear_alpha = linear_alpha;
+	context->anim_mem_limit = (uint64_t)anim_mem_limit_mb * 1024 * 1024;
+
+	/* not a property, set by the slideshow to match its output size */
+	context->downscale_cx =
+		(uint32_t)obs_data_get_int(settings, "downscale_cx");
+	context->downscale_cy =
+		(uint32_t)obs_data_get_int(settings, "downscale_cy");
 
 	/* Load the image if the source is persistent or showing */
 	if (context->persistent || obs_source_showing(context->source))
@@ -98,6 +144,8 @@ static void image_source_defaults(obs_data_t *settings)
 {
 	obs_data_set_default_bool(settings, "unload", false);
 	obs_data_set_default_bool(settings, "linear_alpha", false);
+	obs_data_set_default_int(settings, "anim_mem_limit_mb",
+				 GS_IMAGE_ANIM_MEM_LIMIT / (1024 * 1024));
 }
 
 static void image_source_show(void *data)
@@ -116,6 +164,23 @@ static void image_source_hide(void *data)
 		image_source_unload(context);
 }
 
+/* non-persistent images are already unloaded while hidden */
+static void image_source_hibernate(void *data)
+{
+	struct image_source *context = data;
+
+	if (context->persistent)
+		image_source_unload(context);
+}
+
+static void image_source_wake(void *data)
+{
+	struct image_source *context = data;
+
+	if (context->persistent)
+		image_source_load(context);
+}
+
 static void restart_gif(void *data)
 {
 	struct image_source *context = data;
@@ -129,6 +194,7 @@ static void restart_gif(void *data)
 		gs_image_file4_update_texture(&context->if4);
 		obs_leave_graphics();
 
+		obs_source_content_changed(context->source);
 		context->restart_gif = false;
 	}
 }
@@ -162,12 +228,16 @@ static void image_source_destroy(void *data)
 static uint32_t image_source_getwidth(void *data)
 {
 	struct image_source *context = data;
+	if (context->cached)
+		return obs_cached_image_get_width(context->cached);
 	return context->if4.image3.image2.image.cx;
 }
 
 static uint32_t image_source_getheight(void *data)
 {
 	struct image_source *context = data;
+	if (context->cached)
+		return obs_cached_image_get_height(context->cached);
 	return context->if4.image3.image2.image.cy;
 }
 
@@ -176,7 +246,9 @@ static void image_source_render(void *data, gs_effect_t *effect)
 	struct image_source *context = data;
 
 	struct gs_image_file *const image = &context->if4.image3.image2.image;
-	gs_texture_t *const texture = image->texture;
+	gs_texture_t *const texture =
+		context->cached ? obs_cached_image_get_texture(context->cached)
+				: image->texture;
 	if (!texture)
 		return;
 
@@ -189,7 +261,8 @@ static void image_source_render(void *data, gs_effect_t *effect)
 	gs_eparam_t *const param = gs_effect_get_param_by_name(effect, "image");
 	gs_effect_set_texture_srgb(param, texture);
 
-	gs_draw_sprite(texture, 0, image->cx, image->cy);
+	gs_draw_sprite(texture, 0, gs_texture_get_width(texture),
+		       gs_texture_get_height(texture));
 
 	gs_blend_state_pop();
 
@@ -242,6 +315,8 @@ static void image_source_tick(void *data, float seconds)
 			obs_enter_graphics();
 			gs_image_file4_update_texture(&context->if4);
 			obs_leave_graphics();
+
+			obs_source_content_changed(context->source);
 		}
 	}
 
@@ -250,13 +325,13 @@ static void image_source_tick(void *data, float seconds)
 
 static const char *image_filter =
 #ifdef _WIN32
-	"All formats (*.bmp *.tga *.png *.jpeg *.jpg *.jxr *.gif *.psd *.webp);;"
+	"All formats (*.bmp *.tga *.png *.apng *.jpeg *.jpg *.jxr *.gif *.psd *.webp);;"
 #else
-	"All formats (*.bmp *.tga *.png *.jpeg *.jpg *.gif *.psd *.webp);;"
+	"All formats (*.bmp *.tga *.png *.apng *.jpeg *.jpg *.gif *.psd *.webp);;"
 #endif
 	"BMP Files (*.bmp);;"
 	"Targa Files (*.tga);;"
-	"PNG Files (*.png);;"
+	"PNG Files (*.png *.apng);;"
 	"JPEG Files (*.jpeg *.jpg);;"
 #ifdef _WIN32
 	"JXR Files (*.jxr);;"
@@ -289,6 +364,13 @@ static obs_properties_t *image_source_properties(void *data)
 				obs_module_text("UnloadWhenNotShowing"));
 	obs_properties_add_bool(props, "linear_alpha",
 				obs_module_text("LinearAlpha"));
+
+	obs_property_t *p = obs_properties_add_int(
+		props, "anim_mem_limit_mb",
+		obs_module_text("AnimationMemoryLimit"), 16, 8192, 16);
+	obs_property_int_set_suffix(p, " MB");
+	obs_property_set_long_description(
+		p, obs_module_text("AnimationMemoryLimit.ToolTip"));
 	dstr_free(&path);
 
 	return props;
@@ -297,6 +379,8 @@ static obs_properties_t *image_source_properties(void *data)
 uint64_t image_source_get_memory_usage(void *data)
 {
 	struct image_source *s = data;
+	if (s->cached)
+		return obs_cached_image_get_mem_usage(s->cached);
 	return s->if4.image3.image2.mem_usage;
 }
 
@@ -340,13 +424,16 @@ image_source_get_color_space(void *data, size_t count,
 
 	struct image_source *const s = data;
 	gs_image_file4_t *const if4 = &s->if4;
+	if (s->cached)
+		return obs_cached_image_get_color_space(s->cached);
 	return if4->image3.image2.image.texture ? if4->space : GS_CS_SRGB;
 }
 
 static struct obs_source_info image_source_info = {
 	.id = "image_source",
 	.type = OBS_SOURCE_TYPE_INPUT,
-	.output_flags = OBS_SOURCE_VIDEO | OBS_SOURCE_SRGB,
+	.output_flags = OBS_SOURCE_VIDEO | OBS_SOURCE_SRGB |
+			OBS_SOURCE_STATIC_VIDEO | OBS_SOURCE_PARALLEL_TICK,
 	.get_name = image_source_get_name,
 	.create = image_source_create,
 	.destroy = image_source_destroy,
@@ -363,6 +450,8 @@ static struct obs_source_info image_source_info = {
 	.icon_type = OBS_ICON_TYPE_IMAGE,
 	.activate = image_source_activate,
 	.video_get_color_space = image_source_get_color_space,
+	.hibernate = image_source_hibernate,
+	.wake = image_source_wake,
 };
 
 OBS_DECLARE_MODULE()
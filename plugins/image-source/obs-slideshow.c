@@ -61,11 +61,7 @@
 
 /* ------------------------------------------------------------------------- */
 
-extern uint64_t image_source_get_memory_usage(void *data);
-
-#define BYTES_TO_MBYTES (1024 * 1024)
-#define MAX_MEM_USAGE (400 * BYTES_TO_MBYTES)
-
+/* source is NULL while the image isn't loaded */
 struct image_file_data {
 	char *path;
 	obs_source_t *source;
@@ -97,10 +93,21 @@ struct slideshow {
 
 	float elapsed;
 	size_t cur_item;
+	size_t prev_item;
+	size_t next_item;
 
 	uint32_t cx;
 	uint32_t cy;
-	uint64_t mem_usage;
+
+	/* only the previous, current and next images are kept loaded.  the
+	 * loader thread loads them ahead of time, shrunk to the load size */
+	uint32_t load_cx;
+	uint32_t load_cy;
+	long files_gen;
+	os_sem_t *load_sem;
+	pthread_t load_thread;
+	bool load_thread_valid;
+	volatile bool stop_loading;
 
 	pthread_mutex_t mutex;
 	DARRAY(struct image_file_data) files;
@@ -158,13 +165,16 @@ static obs_source_t *get_source(struct darray *array, const char *path)
 	return source;
 }
 
-static obs_source_t *create_source_from_file(const char *file)
+static obs_source_t *create_source_from_file(struct slideshow *ss,
+					     const char *file)
 {
 	obs_data_t *settings = obs_data_create();
 	obs_source_t *source;
 
 	obs_data_set_string(settings, "file", file);
 	obs_data_set_bool(settings, "unload", false);
+	obs_data_set_int(settings, "downscale_cx", ss->load_cx);
+	obs_data_set_int(settings, "downscale_cy", ss->load_cy);
 	source = obs_source_create_private("image_source", NULL, settings);
 
 	obs_data_release(settings);
@@ -192,49 +202,180 @@ static inline size_t random_file(struct slideshow *ss)
 	return (size_t)rand() % ss->files.num;
 }
 
+static size_t pick_next_file(struct slideshow *ss)
+{
+	if (ss->randomize && ss->files.num > 1) {
+		size_t next = ss->cur_item;
+		while (next == ss->cur_item)
+			next = random_file(ss);
+		return next;
+	}
+
+	return ss->cur_item + 1 < ss->files.num ? ss->cur_item + 1 : 0;
+}
+
 /* ------------------------------------------------------------------------- */
 
-static const char *ss_getname(void *unused)
+static inline bool in_window(struct slideshow *ss, size_t idx)
 {
-	UNUSED_PARAMETER(unused);
-	return obs_module_text("SlideShow");
+	return idx == ss->cur_item || idx == ss->next_item ||
+	       idx == ss->prev_item;
 }
 
-static void add_file(struct slideshow *ss, struct darray *array,
-		     const char *path, uint32_t *cx, uint32_t *cy)
+static bool slide_loaded(struct slideshow *ss, size_t idx)
 {
-	DARRAY(struct image_file_data) new_files;
-	struct image_file_data data;
-	obs_source_t *new_source;
+	bool loaded;
 
-	new_files.da = *array;
+	pthread_mutex_lock(&ss->mutex);
+	loaded = idx < ss->files.num && ss->files.array[idx].source;
+	pthread_mutex_unlock(&ss->mutex);
+
+	return loaded;
+}
+
+static void store_slide(struct slideshow *ss, size_t idx, long gen,
+			obs_source_t *source)
+{
+	pthread_mutex_lock(&ss->mutex);
+	if (gen == ss->files_gen && idx < ss->files.num &&
+	    !ss->files.array[idx].source)
+		ss->files.array[idx].source = obs_source_get_ref(source);
+	pthread_mutex_unlock(&ss->mutex);
+}
+
+/* returns a new reference, loading the image right away if the loader
+ * thread hasn't gotten to it yet */
+static obs_source_t *get_slide(struct slideshow *ss, size_t idx)
+{
+	obs_source_t *source = NULL;
+	char *path = NULL;
+	long gen;
+
+	pthread_mutex_lock(&ss->mutex);
+	if (idx < ss->files.num) {
+		source = obs_source_get_ref(ss->files.array[idx].source);
+		if (!source)
+			path = bstrdup(ss->files.array[idx].path);
+	}
+	gen = ss->files_gen;
+	pthread_mutex_unlock(&ss->mutex);
+
+	if (path) {
+		source = create_source_from_file(ss, path);
+		store_slide(ss, idx, gen, source);
+		bfree(path);
+	}
+
+	return source;
+}
+
+static void update_window(struct slideshow *ss)
+{
+	DARRAY(obs_source_t *) unload;
+
+	da_init(unload);
 
 	pthread_mutex_lock(&ss->mutex);
-	new_source = get_source(&ss->files.da, path);
+	ss->next_item = pick_next_file(ss);
+	ss->prev_item = ss->cur_item ? ss->cur_item - 1
+				     : (ss->files.num ? ss->files.num - 1 : 0);
+
+	for (size_t i = 0; i < ss->files.num; i++) {
+		struct image_file_data *file = &ss->files.array[i];
+		if (file->source && !in_window(ss, i)) {
+			da_push_back(unload, &file->source);
+			file->source = NULL;
+		}
+	}
 	pthread_mutex_unlock(&ss->mutex);
 
-	if (!new_source)
-		new_source = get_source(&new_files.da, path);
-	if (!new_source)
-		new_source = create_source_from_file(path);
+	/* the transition keeps its own reference to an image it's still
+	 * showing */
+	for (size_t i = 0; i < unload.num; i++)
+		obs_source_release(unload.array[i]);
+	da_free(unload);
+
+	os_sem_post(ss->load_sem);
+}
+
+static void *load_thread(void *data)
+{
+	struct slideshow *ss = data;
+
+	os_set_thread_name("slideshow: image loader");
+
+	while (os_sem_wait(ss->load_sem) == 0) {
+		if (os_atomic_load_bool(&ss->stop_loading))
+			break;
+
+		for (;;) {
+			obs_source_t *source;
+			char *path = NULL;
+			size_t idx = 0;
+			long gen;
+
+			pthread_mutex_lock(&ss->mutex);
+			const size_t window[] = {ss->cur_item, ss->next_item,
+						 ss->prev_item};
+			for (size_t i = 0; i < 3; i++) {
+				idx = window[i];
+				if (idx < ss->files.num &&
+				    !ss->files.array[idx].source) {
+					path = bstrdup(
+						ss->files.array[idx].path);
+					break;
+				}
+			}
+			gen = ss->files_gen;
+			pthread_mutex_unlock(&ss->mutex);
+
+			if (!path)
+				break;
+
+			source = create_source_from_file(ss, path);
+			bfree(path);
 
-	if (new_source) {
-		uint32_t new_cx = obs_source_get_width(new_source);
-		uint32_t new_cy = obs_source_get_height(new_source);
+			if (!source)
+				break;
 
-		data.path = bstrdup(path);
-		data.source = new_source;
-		da_push_back(new_files, &data);
+			store_slide(ss, idx, gen, source);
+			obs_source_release(source);
+
+			if (os_atomic_load_bool(&ss->stop_loading))
+				break;
+		}
+	}
+
+	return NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static const char *ss_getname(void *unused)
+{
+	UNUSED_PARAMETER(unused);
+	return obs_module_text("SlideShow");
+}
+
+/* images are only loaded once they're about to be shown, images that are
+ * already loaded are kept if they were loaded at the same size */
+static void add_file(struct slideshow *ss, struct darray *array,
+		     const char *path, bool reuse)
+{
+	DARRAY(struct image_file_data) new_files;
+	struct image_file_data data = {0};
 
-		if (new_cx > *cx)
-			*cx = new_cx;
-		if (new_cy > *cy)
-			*cy = new_cy;
+	new_files.da = *array;
 
-		void *source_data = obs_obj_get_data(new_source);
-		ss->mem_usage += image_source_get_memory_usage(source_data);
+	if (reuse) {
+		pthread_mutex_lock(&ss->mutex);
+		data.source = get_source(&ss->files.da, path);
+		pthread_mutex_unlock(&ss->mutex);
 	}
 
+	data.path = bstrdup(path);
+	da_push_back(new_files, &data);
+
 	*array = new_files.da;
 }
 
@@ -260,15 +401,17 @@ static void do_transition(void *data, bool to_null)
 {
 	struct slideshow *ss = data;
 	bool valid = item_valid(ss);
+	obs_source_t *source = NULL;
+
+	if (valid && (ss->use_cut || !to_null))
+		source = get_slide(ss, ss->cur_item);
 
 	if (valid && ss->use_cut) {
-		obs_transition_set(ss->transition,
-				   ss->files.array[ss->cur_item].source);
+		obs_transition_set(ss->transition, source);
 
 	} else if (valid && !to_null) {
 		obs_transition_start(ss->transition, OBS_TRANSITION_MODE_AUTO,
-				     ss->tr_speed,
-				     ss->files.array[ss->cur_item].source);
+				     ss->tr_speed, source);
 
 	} else {
 		obs_transition_start(ss->transition, OBS_TRANSITION_MODE_AUTO,
@@ -276,6 +419,9 @@ static void do_transition(void *data, bool to_null)
 		set_media_state(ss, OBS_MEDIA_STATE_ENDED);
 		obs_source_media_ended(ss->source);
 	}
+
+	obs_source_release(source);
+	update_window(ss);
 }
 
 static void ss_update(void *data, obs_data_t *settings)
@@ -291,9 +437,12 @@ static void ss_update(void *data, obs_data_t *settings)
 	uint32_t new_speed;
 	uint32_t cx = 0;
 	uint32_t cy = 0;
+	uint32_t load_cx, load_cy;
+	struct obs_video_info ovi;
 	size_t count;
 	const char *behavior;
 	const char *mode;
+	bool reuse;
 
 	/* ------------------------------------- */
 	/* get settings data */
@@ -336,10 +485,42 @@ static void ss_update(void *data, obs_data_t *settings)
 	array = obs_data_get_array(settings, S_FILES);
 	count = obs_data_array_count(array);
 
-	/* ------------------------------------- */
-	/* create new list of sources */
+	const char *res_str = obs_data_get_string(settings, S_CUSTOM_SIZE);
+	bool aspect_only = false, use_auto = true;
+	int cx_in = 0, cy_in = 0;
 
-	ss->mem_usage = 0;
+	if (strcmp(res_str, T_CUSTOM_SIZE_AUTO) != 0) {
+		int ret = sscanf(res_str, "%dx%d", &cx_in, &cy_in);
+		if (ret == 2) {
+			aspect_only = false;
+			use_auto = false;
+		} else {
+			ret = sscanf(res_str, "%d:%d", &cx_in, &cy_in);
+			if (ret == 2) {
+				aspect_only = true;
+				use_auto = false;
+			}
+		}
+	}
+
+	/* images never need to be bigger than what they're drawn at */
+	if (!use_auto && !aspect_only && cx_in > 0 && cy_in > 0) {
+		load_cx = (uint32_t)cx_in;
+		load_cy = (uint32_t)cy_in;
+	} else if (obs_get_video_info(&ovi)) {
+		load_cx = ovi.base_width;
+		load_cy = ovi.base_height;
+	} else {
+		load_cx = 0;
+		load_cy = 0;
+	}
+
+	reuse = load_cx == ss->load_cx && load_cy == ss->load_cy;
+	ss->load_cx = load_cx;
+	ss->load_cy = load_cy;
+
+	/* ------------------------------------- */
+	/* create new list of files */
 
 	for (size_t i = 0; i < count; i++) {
 		obs_data_t *item = obs_data_array_item(array, i);
@@ -366,23 +547,17 @@ static void ss_update(void *data, obs_data_t *settings)
 				dstr_copy(&dir_path, path);
 				dstr_cat_ch(&dir_path, '/');
 				dstr_cat(&dir_path, ent->d_name);
-				add_file(ss, &new_files.da, dir_path.array, &cx,
-					 &cy);
-
-				if (ss->mem_usage >= MAX_MEM_USAGE)
-					break;
+				add_file(ss, &new_files.da, dir_path.array,
+					 reuse);
 			}
 
 			dstr_free(&dir_path);
 			os_closedir(dir);
 		} else {
-			add_file(ss, &new_files.da, path, &cx, &cy);
+			add_file(ss, &new_files.da, path, reuse);
 		}
 
 		obs_data_release(item);
-
-		if (ss->mem_usage >= MAX_MEM_USAGE)
-			break;
 	}
 
 	/* ------------------------------------- */
@@ -392,6 +567,8 @@ static void ss_update(void *data, obs_data_t *settings)
 
 	old_files.da = ss->files.da;
 	ss->files.da = new_files.da;
+	ss->files_gen++;
+	ss->cur_item = 0;
 	if (new_tr) {
 		old_tr = ss->transition;
 		ss->transition = new_tr;
@@ -422,22 +599,16 @@ static void ss_update(void *data, obs_data_t *settings)
 
 	/* ------------------------- */
 
-	const char *res_str = obs_data_get_string(settings, S_CUSTOM_SIZE);
-	bool aspect_only = false, use_auto = true;
-	int cx_in = 0, cy_in = 0;
+	if (ss->randomize && ss->files.num)
+		ss->cur_item = random_file(ss);
 
-	if (strcmp(res_str, T_CUSTOM_SIZE_AUTO) != 0) {
-		int ret = sscanf(res_str, "%dx%d", &cx_in, &cy_in);
-		if (ret == 2) {
-			aspect_only = false;
-			use_auto = false;
-		} else {
-			ret = sscanf(res_str, "%d:%d", &cx_in, &cy_in);
-			if (ret == 2) {
-				aspect_only = true;
-				use_auto = false;
-			}
-		}
+	/* the size isn't known without loading every image, so the first
+	 * image decides it */
+	if (ss->files.num) {
+		obs_source_t *first = get_slide(ss, ss->cur_item);
+		cx = obs_source_get_width(first);
+		cy = obs_source_get_height(first);
+		obs_source_release(first);
 	}
 
 	if (!use_auto) {
@@ -464,15 +635,12 @@ static void ss_update(void *data, obs_data_t *settings)
 
 	ss->cx = cx;
 	ss->cy = cy;
-	ss->cur_item = 0;
 	ss->elapsed = 0.0f;
 	obs_transition_set_size(ss->transition, cx, cy);
 	obs_transition_set_alignment(ss->transition, OBS_ALIGN_CENTER);
 	obs_transition_set_scale_type(ss->transition,
 				      OBS_TRANSITION_SCALE_ASPECT);
 
-	if (ss->randomize && ss->files.num)
-		ss->cur_item = random_file(ss);
 	if (new_tr)
 		obs_source_add_active_child(ss->source, new_tr);
 	if (ss->files.num) {
@@ -633,6 +801,13 @@ static void ss_destroy(void *data)
 {
 	struct slideshow *ss = data;
 
+	if (ss->load_thread_valid) {
+		os_atomic_set_bool(&ss->stop_loading, true);
+		os_sem_post(ss->load_sem);
+		pthread_join(ss->load_thread, NULL);
+	}
+	os_sem_destroy(ss->load_sem);
+
 	// obs_scene_t is an undefined type here, can't check if OBS_SOURCE_TYPE_SCENE, but obs_scene_is_present has sanity check
 	if (obs_scene_is_present((obs_scene_t *)ss->transition) ||
 	    obs_source_is_present(ss->transition)) {
@@ -678,6 +853,11 @@ static void *ss_create(obs_data_t *settings, obs_source_t *source)
 	pthread_mutex_init_value(&ss->mutex);
 	if (pthread_mutex_init(&ss->mutex, NULL) != 0)
 		goto error;
+	if (os_sem_init(&ss->load_sem, 0) != 0)
+		goto error;
+	if (pthread_create(&ss->load_thread, NULL, load_thread, ss) != 0)
+		goto error;
+	ss->load_thread_valid = true;
 
 	obs_source_update(source, NULL);
 
@@ -739,9 +919,9 @@ static void ss_video_tick(void *data, float seconds)
 	ss->elapsed += seconds;
 
 	if (ss->elapsed > ss->slide_time) {
-		ss->elapsed -= ss->slide_time;
-
 		if (!ss->loop && ss->cur_item == ss->files.num - 1) {
+			ss->elapsed -= ss->slide_time;
+
 			if (ss->hide)
 				do_transition(ss, true);
 			else
@@ -750,17 +930,17 @@ static void ss_video_tick(void *data, float seconds)
 			return;
 		}
 
-		if (ss->randomize) {
-			size_t next = ss->cur_item;
-			if (ss->files.num > 1) {
-				while (next == ss->cur_item)
-					next = random_file(ss);
-			}
-			ss->cur_item = next;
+		/* keep showing the current image until the next one has
+		 * loaded rather than stalling the graphics thread on it */
+		if (ss->files.num && !slide_loaded(ss, ss->next_item))
+			return;
 
-		} else if (++ss->cur_item >= ss->files.num) {
-			ss->cur_item = 0;
-		}
+		ss->elapsed -= ss->slide_time;
+		if (ss->elapsed > ss->slide_time)
+			ss->elapsed = 0.0f;
+
+		if (ss->next_item < ss->files.num)
+			ss->cur_item = ss->next_item;
 
 		if (ss->files.num)
 			do_transition(ss, false);
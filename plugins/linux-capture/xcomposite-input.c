@@ -6,6 +6,7 @@
 #include <X11/Xlib-xcb.h>
 #include <xcb/xcb.h>
 #include <xcb/composite.h>
+#include <xcb/damage.h>
 #include <pthread.h>
 
 #include <stdlib.h>
@@ -15,6 +16,12 @@
 #include <stdio.h>
 #include <ctype.h>
 
+#ifdef ENABLE_XCB_DRI3
+#include <unistd.h>
+#include <xcb/dri3.h>
+#include <libdrm/drm_fourcc.h>
+#endif
+
 #include "xhelpers.h"
 #include "xcursor-xcb.h"
 #include "xcomposite-input.h"
@@ -27,6 +34,12 @@
 
 static Display *disp = NULL;
 static xcb_connection_t *conn = NULL;
+// 0 if the damage extension isn't available
+static uint8_t damage_event_base = 0;
+#ifdef ENABLE_XCB_DRI3
+static bool have_dri3 = false;
+static uint32_t dri3_minor_version = 0;
+#endif
 // Atoms used throughout our plugin
 xcb_atom_t ATOM_UTF8_STRING;
 xcb_atom_t ATOM_STRING;
@@ -61,6 +74,11 @@ struct xcompcap {
 	Pixmap pixmap;
 	gs_texture_t *gltex;
 
+	// The texture shares the window pixmap's buffer, damage only tells
+	// us that the window drew something since the last tick.
+	xcb_damage_damage_t damage;
+	bool damaged;
+
 	pthread_mutex_t lock;
 
 	bool show_cursor;
@@ -389,6 +407,119 @@ static int silence_x11_errors(Display *display, XErrorEvent *err)
 	return 0;
 }
 
+#ifdef ENABLE_XCB_DRI3
+static bool dri3_format(uint8_t depth, uint8_t bpp, uint32_t *drm_format,
+			enum gs_color_format *format)
+{
+	if (bpp != 32)
+		return false;
+
+	if (depth == 32) {
+		*drm_format = DRM_FORMAT_ARGB8888;
+		*format = GS_BGRA;
+	} else if (depth == 24) {
+		*drm_format = DRM_FORMAT_XRGB8888;
+		*format = GS_BGRX;
+	} else {
+		return false;
+	}
+
+	return true;
+}
+
+// Imports the pixmap's buffer as DMA-BUF, for drivers that can export
+// pixmaps through DRI3 but don't support EGL_KHR_image_pixmap.
+static gs_texture_t *xcomp_import_dri3_pixmap(xcb_connection_t *conn,
+					      struct xcompcap *s)
+{
+	int fds[4];
+	uint32_t strides[4];
+	uint32_t offsets[4];
+	uint64_t modifiers[4];
+	uint64_t modifier = DRM_FORMAT_MOD_INVALID;
+	uint32_t n_planes;
+	uint32_t width;
+	uint32_t height;
+	uint8_t depth;
+	uint8_t bpp;
+
+	if (!have_dri3)
+		return NULL;
+
+	if (dri3_minor_version >= 2) {
+		xcb_dri3_buffers_from_pixmap_cookie_t cookie =
+			xcb_dri3_buffers_from_pixmap(conn, s->pixmap);
+		xcb_dri3_buffers_from_pixmap_reply_t *reply =
+			xcb_dri3_buffers_from_pixmap_reply(conn, cookie, NULL);
+		if (!reply)
+			return NULL;
+
+		int *reply_fds =
+			xcb_dri3_buffers_from_pixmap_reply_fds(conn, reply);
+		uint32_t *reply_strides =
+			xcb_dri3_buffers_from_pixmap_strides(reply);
+		uint32_t *reply_offsets =
+			xcb_dri3_buffers_from_pixmap_offsets(reply);
+
+		n_planes = reply->nfd;
+		if (n_planes > 4) {
+			for (uint32_t i = 0; i < n_planes; i++)
+				close(reply_fds[i]);
+			free(reply);
+			return NULL;
+		}
+
+		for (uint32_t i = 0; i < n_planes; i++) {
+			fds[i] = reply_fds[i];
+			strides[i] = reply_strides[i];
+			offsets[i] = reply_offsets[i];
+			modifiers[i] = reply->modifier;
+		}
+
+		modifier = reply->modifier;
+		width = reply->width;
+		height = reply->height;
+		depth = reply->depth;
+		bpp = reply->bpp;
+		free(reply);
+	} else {
+		xcb_dri3_buffer_from_pixmap_cookie_t cookie =
+			xcb_dri3_buffer_from_pixmap(conn, s->pixmap);
+		xcb_dri3_buffer_from_pixmap_reply_t *reply =
+			xcb_dri3_buffer_from_pixmap_reply(conn, cookie, NULL);
+		if (!reply)
+			return NULL;
+
+		n_planes = 1;
+		fds[0] = xcb_dri3_buffer_from_pixmap_reply_fds(conn, reply)[0];
+		strides[0] = reply->stride;
+		offsets[0] = 0;
+		width = reply->width;
+		height = reply->height;
+		depth = reply->depth;
+		bpp = reply->bpp;
+		free(reply);
+	}
+
+	gs_texture_t *tex = NULL;
+	uint32_t drm_format;
+	enum gs_color_format format;
+
+	if (n_planes && dri3_format(depth, bpp, &drm_format, &format)) {
+		bool use_modifiers = modifier != DRM_FORMAT_MOD_INVALID;
+		tex = gs_texture_create_from_dmabuf(
+			width, height, drm_format, format, n_planes, fds,
+			strides, offsets, use_modifiers ? modifiers : NULL);
+	}
+
+	// EGL keeps its own reference to the buffer
+	for (uint32_t i = 0; i < n_planes; i++)
+		close(fds[i]);
+
+	return tex;
+}
+#endif
+
 void xcomp_create_pixmap(xcb_connection_t *conn, struct xcompcap *s,
 			 int log_level)
 {
@@ -436,6 +567,11 @@ void xcomp_create_pixmap(xcb_connection_t *conn, struct xcompcap *s,
 						 GS_BGRA_UNORM, GL_TEXTURE_2D,
 						 (void *)s->pixmap);
 	XSetErrorHandler(prev);
+
+#ifdef ENABLE_XCB_DRI3
+	if (!s->gltex)
+		s->gltex = xcomp_import_dri3_pixmap(conn, s);
+#endif
 }
 
 struct reg_item {
@@ -458,6 +594,13 @@ void watcher_register(xcb_connection_t *conn, struct xcompcap *s)
 		xcb_composite_redirect_window(conn, s->win,
 					      XCB_COMPOSITE_REDIRECT_AUTOMATIC);
 
+		if (damage_event_base) {
+			s->damage = xcb_generate_id(conn);
+			xcb_damage_create(conn, s->damage, s->win,
+					  XCB_DAMAGE_REPORT_LEVEL_NON_EMPTY);
+			s->damaged = false;
+		}
+
 		da_push_back(watcher_registry, (&(struct reg_item){s, s->win}));
 	}
 
@@ -484,6 +627,14 @@ void watcher_unregister(xcb_connection_t *conn, struct xcompcap *s)
 
 	da_erase(watcher_registry, idx);
 
+	if (s->damage) {
+		// Fails harmlessly if the window is already gone, the server
+		// frees its damage objects along with it.
+		xcb_damage_destroy(conn, s->damage);
+		s->damage = 0;
+		s->damaged = false;
+	}
+
 	// Check if there are still sources listening for the same window.
 	bool windowInUse = false;
 	for (size_t i = 0; i < watcher_registry.num; i++) {
@@ -514,14 +665,35 @@ void watcher_process(xcb_generic_event_t *ev)
 
 	pthread_mutex_lock(&watcher_lock);
 	xcb_window_t win = 0;
+	uint8_t type = ev->response_type & ~0x80;
+
+	if (damage_event_base &&
+	    type == damage_event_base + XCB_DAMAGE_NOTIFY) {
+		xcb_damage_damage_t damage =
+			((xcb_damage_notify_event_t *)ev)->damage;
+
+		for (size_t i = 0; i < watcher_registry.num; i++) {
+			struct reg_item *item = (struct reg_item *)darray_item(
+				sizeof(struct reg_item), &watcher_registry.da,
+				i);
+			if (item->src->damage == damage)
+				item->src->damaged = true;
+		}
 
-	switch (ev->response_type & ~0x80) {
+		pthread_mutex_unlock(&watcher_lock);
+		return;
+	}
+
+	switch (type) {
 	case XCB_CONFIGURE_NOTIFY:
 		win = ((xcb_configure_notify_event_t *)ev)->event;
 		break;
 	case XCB_MAP_NOTIFY:
 		win = ((xcb_map_notify_event_t *)ev)->event;
 		break;
+	case XCB_UNMAP_NOTIFY:
+		win = ((xcb_unmap_notify_event_t *)ev)->event;
+		break;
 	case XCB_EXPOSE:
 		win = ((xcb_expose_event_t *)ev)->window;
 		break;
@@ -621,12 +793,17 @@ static void xcompcap_video_tick(void *data, float seconds)
 	pthread_mutex_lock(&s->lock);
 
 	xcb_generic_event_t *event;
-	while ((event = xcb_poll_for_queued_event(conn)))
+	while ((event = xcb_poll_for_event(conn))) {
 		watcher_process(event);
+		free(event);
+	}
 
 	// Reacquire window after interval or immediately if reconfigured.
+	// Unmapping or destroying the window sets window_changed, so there
+	// is no need to query the window every tick. A mapped window that
+	// couldn't be bound is only retried once it draws something.
 	s->window_check_time += seconds;
-	bool window_lost = !xcomp_window_exists(conn, s->win) || !s->gltex;
+	bool window_lost = !s->gltex && (!s->damage || s->damaged);
 	if ((window_lost && s->window_check_time > FIND_WINDOW_INTERVAL) ||
 	    s->window_changed) {
 		watcher_unregister(conn, s);
@@ -645,6 +822,12 @@ static void xcompcap_video_tick(void *data, float seconds)
 				   s->cursor->y_org + s->crop_top);
 	}
 
+	if (s->damaged) {
+		xcb_damage_subtract(conn, s->damage, XCB_NONE, XCB_NONE);
+		s->damaged = false;
+	}
+	xcb_flush(conn);
+
 	if (!s->gltex)
 		goto done;
 
@@ -823,6 +1006,8 @@ static void xcompcap_update(void *data, obs_data_t *settings)
 	s->include_border = obs_data_get_bool(settings, "include_border");
 	s->exclude_alpha = obs_data_get_bool(settings, "exclude_alpha");
 
+	watcher_unregister(conn, s);
+
 	s->windowName = obs_data_get_string(settings, "capture_window");
 	s->win = xcomp_find_window(conn, disp, s->windowName);
 	if (s->win && s->windowName) {
@@ -882,6 +1067,35 @@ void xcomposite_load(void)
 	}
 	free(version);
 
+	const xcb_query_extension_reply_t *damage_ext =
+		xcb_get_extension_data(conn, &xcb_damage_id);
+	if (damage_ext->present) {
+		xcb_damage_query_version_cookie_t damage_cookie =
+			xcb_damage_query_version(conn, 1, 1);
+		xcb_damage_query_version_reply_t *damage_version =
+			xcb_damage_query_version_reply(conn, damage_cookie,
+						       NULL);
+		if (damage_version)
+			damage_event_base = damage_ext->first_event;
+		free(damage_version);
+	}
+
+#ifdef ENABLE_XCB_DRI3
+	const xcb_query_extension_reply_t *dri3_ext =
+		xcb_get_extension_data(conn, &xcb_dri3_id);
+	if (dri3_ext->present) {
+		xcb_dri3_query_version_cookie_t dri3_cookie =
+			xcb_dri3_query_version(conn, 1, 2);
+		xcb_dri3_query_version_reply_t *dri3_version =
+			xcb_dri3_query_version_reply(conn, dri3_cookie, NULL);
+		if (dri3_version) {
+			have_dri3 = true;
+			dri3_minor_version = dri3_version->minor_version;
+		}
+		free(dri3_version);
+	}
+#endif
+
 	// Must be done before other helpers called.
 	xcomp_gather_atoms(conn);
 
@@ -18,6 +18,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <stdio.h>
 #include <stdlib.h>
 #include <inttypes.h>
+#include <xcb/damage.h>
 #include <xcb/randr.h>
 #include <xcb/shm.h>
 #include <xcb/xfixes.h>
@@ -49,6 +50,13 @@ struct xshm_data {
 
 	gs_texture_t *texture;
 
+	/* with damage tracking only the changed parts of the screen are read
+	 * back into frame, which always holds the whole captured area */
+	xcb_damage_damage_t damage;
+	xcb_xfixes_region_t damage_region;
+	uint8_t *frame;
+	bool damage_full;
+
 	int_fast32_t cut_top;
 	int_fast32_t cut_left;
 	int_fast32_t cut_right;
@@ -98,9 +106,56 @@ static bool xshm_check_extensions(xcb_connection_t *xcb)
 	if (!xcb_get_extension_data(xcb, &xcb_randr_id)->present)
 		blog(LOG_INFO, "Missing Randr extension !");
 
+	if (!xcb_get_extension_data(xcb, &xcb_damage_id)->present)
+		blog(LOG_INFO, "Missing Damage extension, capturing every "
+			       "frame !");
+
 	return ok;
 }
 
+/**
+ * Start tracking damage on the root window
+ *
+ * @return false if the damage extension can't be used
+ */
+static bool xshm_damage_init(struct xshm_data *data)
+{
+	if (!xcb_get_extension_data(data->xcb, &xcb_damage_id)->present)
+		return false;
+
+	xcb_damage_query_version_cookie_t ver_c =
+		xcb_damage_query_version(data->xcb, 1, 1);
+	xcb_damage_query_version_reply_t *ver =
+		xcb_damage_query_version_reply(data->xcb, ver_c, NULL);
+	if (!ver)
+		return false;
+	free(ver);
+
+	data->damage = xcb_generate_id(data->xcb);
+	xcb_damage_create(data->xcb, data->damage, data->xcb_screen->root,
+			  XCB_DAMAGE_REPORT_LEVEL_NON_EMPTY);
+
+	data->damage_region = xcb_generate_id(data->xcb);
+	xcb_xfixes_create_region(data->xcb, data->damage_region, 0, NULL);
+
+	data->frame = bmalloc(data->adj_width * data->adj_height * 4);
+	data->damage_full = true;
+	return true;
+}
+
+static void xshm_damage_free(struct xshm_data *data)
+{
+	if (data->damage) {
+		xcb_damage_destroy(data->xcb, data->damage);
+		xcb_xfixes_destroy_region(data->xcb, data->damage_region);
+		data->damage = 0;
+		data->damage_region = 0;
+	}
+
+	bfree(data->frame);
+	data->frame = NULL;
+}
+
 /**
  * Update the capture
  *
@@ -201,6 +256,9 @@ static void xshm_capture_stop(struct xshm_data *data)
 
 	obs_leave_graphics();
 
+	if (data->xcb)
+		xshm_damage_free(data);
+
 	if (data->xshm) {
 		xshm_xcb_detach(data->xshm);
 		data->xshm = NULL;
@@ -252,6 +310,10 @@ static void xshm_capture_start(struct xshm_data *data)
 	data->cursor = xcb_xcursor_init(data->xcb);
 	xcb_xcursor_offset(data->cursor, data->adj_x_org, data->adj_y_org);
 
+	/* xfixes was initialized along with the cursor */
+	if (xshm_damage_init(data))
+		blog(LOG_INFO, "Using damage tracking");
+
 	obs_enter_graphics();
 
 	xshm_resize_texture(data);
@@ -474,6 +536,148 @@ static void *xshm_create(obs_data_t *settings, obs_source_t *source)
 	return data;
 }
 
+#define MAX_DAMAGE_RECTS 32
+
+struct damage_fetch {
+	xcb_shm_get_image_cookie_t cookie;
+	xcb_rectangle_t rect;
+	uint32_t offset;
+};
+
+/**
+ * Clip a damaged rectangle to the captured area
+ *
+ * @return false if nothing of it is captured
+ */
+static bool xshm_clip_rect(const struct xshm_data *data,
+			   const xcb_rectangle_t *in, xcb_rectangle_t *out)
+{
+	int_fast32_t x1 = in->x - data->adj_x_org;
+	int_fast32_t y1 = in->y - data->adj_y_org;
+	int_fast32_t x2 = x1 + in->width;
+	int_fast32_t y2 = y1 + in->height;
+
+	if (x1 < 0)
+		x1 = 0;
+	if (y1 < 0)
+		y1 = 0;
+	if (x2 > data->adj_width)
+		x2 = data->adj_width;
+	if (y2 > data->adj_height)
+		y2 = data->adj_height;
+
+	if (x1 >= x2 || y1 >= y2)
+		return false;
+
+	out->x = (int16_t)x1;
+	out->y = (int16_t)y1;
+	out->width = (uint16_t)(x2 - x1);
+	out->height = (uint16_t)(y2 - y1);
+	return true;
+}
+
+/**
+ * Read back only what was damaged since the last tick
+ *
+ * The damaged rectangles are disjoint, so they're all requested at once
+ * into consecutive parts of the shm segment and then copied into the frame.
+ *
+ * @return true if the frame changed
+ */
+static bool xshm_update_damaged(struct xshm_data *data)
+{
+	xcb_generic_event_t *event;
+	while ((event = xcb_poll_for_event(data->xcb)) != NULL)
+		free(event);
+
+	xcb_damage_subtract(data->xcb, data->damage, XCB_NONE,
+			    data->damage_region);
+
+	xcb_xfixes_fetch_region_cookie_t region_c =
+		xcb_xfixes_fetch_region(data->xcb, data->damage_region);
+	xcb_xfixes_fetch_region_reply_t *region =
+		xcb_xfixes_fetch_region_reply(data->xcb, region_c, NULL);
+	if (!region)
+		return false;
+
+	const xcb_rectangle_t full = {(int16_t)data->adj_x_org,
+				      (int16_t)data->adj_y_org,
+				      (uint16_t)data->adj_width,
+				      (uint16_t)data->adj_height};
+	const xcb_rectangle_t *rects =
+		xcb_xfixes_fetch_region_rectangles(region);
+	int count = xcb_xfixes_fetch_region_rectangles_length(region);
+	xcb_rectangle_t bounds = region->extents;
+
+	/* too many small rects cost more in round trips than reading their
+	 * bounding box */
+	if (count > MAX_DAMAGE_RECTS) {
+		rects = &bounds;
+		count = 1;
+	}
+	if (data->damage_full) {
+		rects = &full;
+		count = 1;
+	}
+
+	struct damage_fetch fetches[MAX_DAMAGE_RECTS];
+	const uint32_t shm_size =
+		(uint32_t)(data->adj_width * data->adj_height * 4);
+	uint32_t offset = 0;
+	size_t num = 0;
+
+	for (int i = 0; i < count; i++) {
+		struct damage_fetch *fetch = &fetches[num];
+		if (!xshm_clip_rect(data, &rects[i], &fetch->rect))
+			continue;
+
+		const uint32_t size =
+			(uint32_t)fetch->rect.width * fetch->rect.height * 4;
+		if (offset + size > shm_size)
+			break;
+
+		fetch->offset = offset;
+		fetch->cookie = xcb_shm_get_image_unchecked(
+			data->xcb, data->xcb_screen->root,
+			data->adj_x_org + fetch->rect.x,
+			data->adj_y_org + fetch->rect.y, fetch->rect.width,
+			fetch->rect.height, ~0, XCB_IMAGE_FORMAT_Z_PIXMAP,
+			data->xshm->seg, offset);
+
+		offset += size;
+		num++;
+	}
+
+	free(region);
+
+	bool success = true;
+	for (size_t i = 0; i < num; i++) {
+		xcb_shm_get_image_reply_t *img_r = xcb_shm_get_image_reply(
+			data->xcb, fetches[i].cookie, NULL);
+		if (!img_r) {
+			success = false;
+			continue;
+		}
+		free(img_r);
+
+		const xcb_rectangle_t *r = &fetches[i].rect;
+		const size_t src_pitch = (size_t)r->width * 4;
+		const size_t dst_pitch = (size_t)data->adj_width * 4;
+		const uint8_t *src = data->xshm->data + fetches[i].offset;
+		uint8_t *dst = data->frame + r->y * dst_pitch + r->x * 4;
+
+		for (uint16_t y = 0; y < r->height; y++) {
+			memcpy(dst, src, src_pitch);
+			src += src_pitch;
+			dst += dst_pitch;
+		}
+	}
+
+	/* whatever failed is lost from the damage region, so start over */
+	data->damage_full = !success;
+	return num > 0 && success;
+}
+
 /**
  * Prepare the capture data
  */
@@ -487,6 +691,18 @@ static void xshm_video_tick(void *vptr, float seconds)
 	if (!obs_source_showing(data->source))
 		return;
 
+	if (data->damage) {
+		const bool changed = xshm_update_damaged(data);
+
+		obs_enter_graphics();
+		if (changed)
+			gs_texture_set_image(data->texture, data->frame,
+					     data->adj_width * 4, false);
+		xcb_xcursor_update(data->xcb, data->cursor);
+		obs_leave_graphics();
+		return;
+	}
+
 	xcb_shm_get_image_cookie_t img_c;
 	xcb_shm_get_image_reply_t *img_r;
 
@@ -23,6 +23,7 @@
 #include <obs-nix-platform.h>
 
 #include <pipewire/pipewire.h>
+#include "pipewire-audio.h"
 #include "screencast-portal.h"
 
 OBS_DECLARE_MODULE()
@@ -37,6 +38,7 @@ bool obs_module_load(void)
 	pw_init(NULL, NULL);
 
 	screencast_portal_load();
+	pipewire_audio_load();
 
 	return true;
 }
@@ -0,0 +1,537 @@
+/* pipewire-audio.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "pipewire-audio.h"
+
+#include <util/darray.h>
+#include <util/platform.h>
+#include <util/util_uint64.h>
+
+#include <pipewire/pipewire.h>
+#include <spa/param/audio/format-utils.h>
+
+/* Captures audio straight from the PipeWire graph rather than through the
+ * PulseAudio compatibility layer.  Data arrives once per graph cycle, in
+ * whatever quantum the graph runs at, and is converted by PipeWire to the
+ * rate and layout OBS mixes at so it's passed along without resampling. */
+
+struct audio_node {
+	uint32_t id;
+	char *name;
+	char *description;
+	bool sink;
+};
+
+struct obs_pw_audio {
+	obs_source_t *source;
+	bool output;
+
+	struct pw_thread_loop *thread_loop;
+	struct pw_context *context;
+	struct pw_core *core;
+	struct spa_hook core_listener;
+	struct pw_registry *registry;
+	struct spa_hook registry_listener;
+	struct pw_stream *stream;
+	struct spa_hook stream_listener;
+	int sync_seq;
+
+	/* sources or sinks in the graph, for the device list */
+	DARRAY(struct audio_node) nodes;
+
+	char *target;
+	enum speaker_layout speakers;
+	uint32_t sample_rate;
+	uint32_t frame_size;
+};
+
+/* channel order of each OBS speaker layout */
+static const enum spa_audio_channel channel_positions[] = {
+	SPA_AUDIO_CHANNEL_FL,  SPA_AUDIO_CHANNEL_FR, SPA_AUDIO_CHANNEL_FC,
+	SPA_AUDIO_CHANNEL_LFE, SPA_AUDIO_CHANNEL_RL, SPA_AUDIO_CHANNEL_RR,
+	SPA_AUDIO_CHANNEL_SL,  SPA_AUDIO_CHANNEL_SR,
+};
+
+static void get_channel_positions(enum speaker_layout speakers,
+				  struct spa_audio_info_raw *info)
+{
+	info->channels = get_audio_channels(speakers);
+
+	switch (speakers) {
+	case SPEAKERS_MONO:
+		info->position[0] = SPA_AUDIO_CHANNEL_MONO;
+		break;
+	case SPEAKERS_2POINT1:
+		memcpy(info->position, channel_positions,
+		       2 * sizeof(*channel_positions));
+		info->position[2] = SPA_AUDIO_CHANNEL_LFE;
+		break;
+	case SPEAKERS_4POINT0:
+		memcpy(info->position, channel_positions,
+		       3 * sizeof(*channel_positions));
+		info->position[3] = SPA_AUDIO_CHANNEL_RC;
+		break;
+	case SPEAKERS_4POINT1:
+		memcpy(info->position, channel_positions,
+		       4 * sizeof(*channel_positions));
+		info->position[4] = SPA_AUDIO_CHANNEL_RC;
+		break;
+	default:
+		memcpy(info->position, channel_positions,
+		       info->channels * sizeof(*channel_positions));
+		break;
+	}
+}
+
+/* ------------------------------------------------------------------------- */
+/* stream                                                                    */
+
+/* the graph time is taken on the monotonic clock, the same one as
+ * os_gettime_ns.  the delay is how long ago the data at the start of the
+ * graph was captured by the device */
+static uint64_t get_timestamp(struct obs_pw_audio *pwa, uint32_t frames)
+{
+	uint64_t duration = util_mul_div64(frames, SPA_NSEC_PER_SEC,
+					   pwa->sample_rate);
+	struct pw_time t = {0};
+
+#if PW_CHECK_VERSION(0, 3, 50)
+	int ret = pw_stream_get_time_n(pwa->stream, &t, sizeof(t));
+#else
+	int ret = pw_stream_get_time(pwa->stream, &t);
+#endif
+
+	if (ret == 0 && t.now > 0 && t.rate.denom) {
+		uint64_t delay = 0;
+		if (t.delay > 0)
+			delay = util_mul_div64((uint64_t)t.delay,
+					       SPA_NSEC_PER_SEC * t.rate.num,
+					       t.rate.denom);
+
+		return (uint64_t)t.now - delay - duration;
+	}
+
+	return os_gettime_ns() - duration;
+}
+
+static void on_process_cb(void *data)
+{
+	struct obs_pw_audio *pwa = data;
+	struct pw_buffer *b = pw_stream_dequeue_buffer(pwa->stream);
+	if (!b)
+		return;
+
+	struct spa_data *d = &b->buffer->datas[0];
+	if (!d->data || !d->chunk || !d->chunk->size)
+		goto queue;
+
+	uint32_t offset = SPA_MIN(d->chunk->offset, d->maxsize);
+	uint32_t size = SPA_MIN(d->chunk->size, d->maxsize - offset);
+
+	struct obs_source_audio out = {0};
+	out.data[0] = (uint8_t *)d->data + offset;
+	out.frames = size / pwa->frame_size;
+	out.speakers = pwa->speakers;
+	out.format = AUDIO_FORMAT_FLOAT;
+	out.samples_per_sec = pwa->sample_rate;
+	out.timestamp = get_timestamp(pwa, out.frames);
+
+	if (out.frames)
+		obs_source_output_audio(pwa->source, &out);
+
+queue:
+	pw_stream_queue_buffer(pwa->stream, b);
+}
+
+static void on_state_changed_cb(void *data, enum pw_stream_state old,
+				enum pw_stream_state state, const char *error)
+{
+	struct obs_pw_audio *pwa = data;
+
+	UNUSED_PARAMETER(old);
+
+	blog(LOG_INFO, "[pipewire-audio] '%s' stream state: \"%s\" (%s)",
+	     obs_source_get_name(pwa->source),
+	     pw_stream_state_as_string(state), error ? error : "no error");
+}
+
+static const struct pw_stream_events stream_events = {
+	PW_VERSION_STREAM_EVENTS,
+	.state_changed = on_state_changed_cb,
+	.process = on_process_cb,
+};
+
+/* thread loop must be locked */
+static void destroy_stream(struct obs_pw_audio *pwa)
+{
+	if (!pwa->stream)
+		return;
+
+	spa_hook_remove(&pwa->stream_listener);
+	pw_stream_disconnect(pwa->stream);
+	pw_stream_destroy(pwa->stream);
+	pwa->stream = NULL;
+}
+
+/* thread loop must be locked */
+static void create_stream(struct obs_pw_audio *pwa)
+{
+	struct obs_audio_info oai;
+	uint8_t buffer[1024];
+	struct spa_pod_builder b = SPA_POD_BUILDER_INIT(buffer, sizeof(buffer));
+	const struct spa_pod *params[1];
+
+	if (!pwa->core)
+		return;
+
+	obs_get_audio_info(&oai);
+
+	struct spa_audio_info_raw info = {
+		.format = SPA_AUDIO_FORMAT_F32,
+		.rate = oai.samples_per_sec,
+	};
+	get_channel_positions(oai.speakers, &info);
+
+	pwa->speakers = oai.speakers;
+	pwa->sample_rate = oai.samples_per_sec;
+	pwa->frame_size = info.channels * sizeof(float);
+
+	params[0] = spa_format_audio_raw_build(&b, SPA_PARAM_EnumFormat, &info);
+
+	struct pw_properties *props = pw_properties_new(
+		PW_KEY_MEDIA_TYPE, "Audio", PW_KEY_MEDIA_CATEGORY, "Capture",
+		PW_KEY_MEDIA_ROLE, "Production", PW_KEY_NODE_NAME,
+		obs_source_get_name(pwa->source), PW_KEY_NODE_DESCRIPTION,
+		obs_source_get_name(pwa->source), NULL);
+
+#ifdef PW_KEY_STREAM_CAPTURE_SINK
+	if (pwa->output)
+		pw_properties_set(props, PW_KEY_STREAM_CAPTURE_SINK, "true");
+#endif
+
+#if PW_CHECK_VERSION(0, 3, 44)
+	if (pwa->target && *pwa->target && strcmp(pwa->target, "default") != 0)
+		pw_properties_set(props, PW_KEY_TARGET_OBJECT, pwa->target);
+#endif
+
+	pwa->stream = pw_stream_new(pwa->core, "OBS Studio", props);
+	if (!pwa->stream) {
+		blog(LOG_WARNING, "[pipewire-audio] Failed to create stream");
+		return;
+	}
+
+	pw_stream_add_listener(pwa->stream, &pwa->stream_listener,
+			       &stream_events, pwa);
+
+	pw_stream_connect(pwa->stream, PW_DIRECTION_INPUT, PW_ID_ANY,
+			  PW_STREAM_FLAG_AUTOCONNECT |
+				  PW_STREAM_FLAG_MAP_BUFFERS |
+				  PW_STREAM_FLAG_RT_PROCESS,
+			  params, 1);
+}
+
+/* ------------------------------------------------------------------------- */
+/* registry                                                                  */
+
+static void free_node(struct audio_node *node)
+{
+	bfree(node->name);
+	bfree(node->description);
+}
+
+static void on_global_cb(void *data, uint32_t id, uint32_t permissions,
+			 const char *type, uint32_t version,
+			 const struct spa_dict *props)
+{
+	struct obs_pw_audio *pwa = data;
+
+	UNUSED_PARAMETER(permissions);
+	UNUSED_PARAMETER(version);
+
+	if (!props || strcmp(type, PW_TYPE_INTERFACE_Node) != 0)
+		return;
+
+	const char *media_class = spa_dict_lookup(props, PW_KEY_MEDIA_CLASS);
+	const char *name = spa_dict_lookup(props, PW_KEY_NODE_NAME);
+	const char *description =
+		spa_dict_lookup(props, PW_KEY_NODE_DESCRIPTION);
+
+	if (!media_class || !name)
+		return;
+
+	bool sink = strcmp(media_class, "Audio/Sink") == 0;
+	if (!sink && strcmp(media_class, "Audio/Source") != 0)
+		return;
+
+	struct audio_node *node = da_push_back_new(pwa->nodes);
+	node->id = id;
+	node->name = bstrdup(name);
+	node->description = bstrdup(description ? description : name);
+	node->sink = sink;
+}
+
+static void on_global_remove_cb(void *data, uint32_t id)
+{
+	struct obs_pw_audio *pwa = data;
+
+	for (size_t i = 0; i < pwa->nodes.num; i++) {
+		if (pwa->nodes.array[i].id == id) {
+			free_node(&pwa->nodes.array[i]);
+			da_erase(pwa->nodes, i);
+			break;
+		}
+	}
+}
+
+static const struct pw_registry_events registry_events = {
+	PW_VERSION_REGISTRY_EVENTS,
+	.global = on_global_cb,
+	.global_remove = on_global_remove_cb,
+};
+
+static void on_core_done_cb(void *data, uint32_t id, int seq)
+{
+	struct obs_pw_audio *pwa = data;
+
+	if (id == PW_ID_CORE && seq == pwa->sync_seq)
+		pw_thread_loop_signal(pwa->thread_loop, false);
+}
+
+static void on_core_error_cb(void *data, uint32_t id, int seq, int res,
+			     const char *message)
+{
+	struct obs_pw_audio *pwa = data;
+
+	blog(LOG_WARNING, "[pipewire-audio] Error id:%u seq:%d res:%d: %s", id,
+	     seq, res, message);
+
+	pw_thread_loop_signal(pwa->thread_loop, false);
+}
+
+static const struct pw_core_events core_events = {
+	PW_VERSION_CORE_EVENTS,
+	.done = on_core_done_cb,
+	.error = on_core_error_cb,
+};
+
+/* ------------------------------------------------------------------------- */
+
+static void teardown_pipewire(struct obs_pw_audio *pwa)
+{
+	if (pwa->thread_loop) {
+		pw_thread_loop_lock(pwa->thread_loop);
+		destroy_stream(pwa);
+
+		if (pwa->registry) {
+			spa_hook_remove(&pwa->registry_listener);
+			pw_proxy_destroy((struct pw_proxy *)pwa->registry);
+		}
+		if (pwa->core) {
+			spa_hook_remove(&pwa->core_listener);
+			pw_core_disconnect(pwa->core);
+		}
+		pw_thread_loop_unlock(pwa->thread_loop);
+
+		pw_thread_loop_stop(pwa->thread_loop);
+	}
+
+	if (pwa->context)
+		pw_context_destroy(pwa->context);
+	if (pwa->thread_loop)
+		pw_thread_loop_destroy(pwa->thread_loop);
+
+	pwa->registry = NULL;
+	pwa->core = NULL;
+	pwa->context = NULL;
+	pwa->thread_loop = NULL;
+}
+
+static bool setup_pipewire(struct obs_pw_audio *pwa)
+{
+	pwa->thread_loop = pw_thread_loop_new("PipeWire audio loop", NULL);
+	if (!pwa->thread_loop)
+		return false;
+
+	pwa->context = pw_context_new(pw_thread_loop_get_loop(pwa->thread_loop),
+				      NULL, 0);
+	if (!pwa->context || pw_thread_loop_start(pwa->thread_loop) < 0)
+		return false;
+
+	pw_thread_loop_lock(pwa->thread_loop);
+
+	pwa->core = pw_context_connect(pwa->context, NULL, 0);
+	if (!pwa->core) {
+		blog(LOG_WARNING, "[pipewire-audio] Failed to connect: %m");
+		pw_thread_loop_unlock(pwa->thread_loop);
+		return false;
+	}
+
+	pw_core_add_listener(pwa->core, &pwa->core_listener, &core_events,
+			     pwa);
+
+	pwa->registry = pw_core_get_registry(pwa->core, PW_VERSION_REGISTRY, 0);
+	pw_registry_add_listener(pwa->registry, &pwa->registry_listener,
+				 &registry_events, pwa);
+
+	/* wait for the current nodes to be listed */
+	pwa->sync_seq = pw_core_sync(pwa->core, PW_ID_CORE, 0);
+	pw_thread_loop_wait(pwa->thread_loop);
+
+	pw_thread_loop_unlock(pwa->thread_loop);
+	return true;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static const char *pipewire_audio_input_get_name(void *unused)
+{
+	UNUSED_PARAMETER(unused);
+	return obs_module_text("PipeWireAudioInput");
+}
+
+static const char *pipewire_audio_output_get_name(void *unused)
+{
+	UNUSED_PARAMETER(unused);
+	return obs_module_text("PipeWireAudioOutput");
+}
+
+static void pipewire_audio_update(void *data, obs_data_t *settings)
+{
+	struct obs_pw_audio *pwa = data;
+	const char *target = obs_data_get_string(settings, "device_id");
+
+	if (pwa->target && strcmp(pwa->target, target) == 0 && pwa->stream)
+		return;
+
+	bfree(pwa->target);
+	pwa->target = bstrdup(target);
+
+	if (!pwa->thread_loop)
+		return;
+
+	pw_thread_loop_lock(pwa->thread_loop);
+	destroy_stream(pwa);
+	create_stream(pwa);
+	pw_thread_loop_unlock(pwa->thread_loop);
+}
+
+static void *pipewire_audio_create(obs_data_t *settings, obs_source_t *source,
+				   bool output)
+{
+	struct obs_pw_audio *pwa = bzalloc(sizeof(*pwa));
+	pwa->source = source;
+	pwa->output = output;
+
+	if (!setup_pipewire(pwa)) {
+		blog(LOG_WARNING, "[pipewire-audio] Failed to set up PipeWire");
+		teardown_pipewire(pwa);
+	}
+
+	pipewire_audio_update(pwa, settings);
+	return pwa;
+}
+
+static void *pipewire_audio_input_create(obs_data_t *settings,
+					 obs_source_t *source)
+{
+	return pipewire_audio_create(settings, source, false);
+}
+
+static void *pipewire_audio_output_create(obs_data_t *settings,
+					  obs_source_t *source)
+{
+	return pipewire_audio_create(settings, source, true);
+}
+
+static void pipewire_audio_destroy(void *data)
+{
+	struct obs_pw_audio *pwa = data;
+
+	teardown_pipewire(pwa);
+
+	for (size_t i = 0; i < pwa->nodes.num; i++)
+		free_node(&pwa->nodes.array[i]);
+	da_free(pwa->nodes);
+
+	bfree(pwa->target);
+	bfree(pwa);
+}
+
+static void pipewire_audio_defaults(obs_data_t *settings)
+{
+	obs_data_set_default_string(settings, "device_id", "default");
+}
+
+static obs_properties_t *pipewire_audio_properties(void *data)
+{
+	struct obs_pw_audio *pwa = data;
+	obs_properties_t *props = obs_properties_create();
+	obs_property_t *devices = obs_properties_add_list(
+		props, "device_id", obs_module_text("PipeWireAudioDevice"),
+		OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_STRING);
+
+	obs_property_list_add_string(
+		devices, obs_module_text("PipeWireAudioDefault"), "default");
+
+	if (!pwa || !pwa->thread_loop)
+		return props;
+
+	pw_thread_loop_lock(pwa->thread_loop);
+	for (size_t i = 0; i < pwa->nodes.num; i++) {
+		const struct audio_node *node = &pwa->nodes.array[i];
+		if (node->sink == pwa->output)
+			obs_property_list_add_string(
+				devices, node->description, node->name);
+	}
+	pw_thread_loop_unlock(pwa->thread_loop);
+
+	return props;
+}
+
+void pipewire_audio_load(void)
+{
+	const struct obs_source_info input_info = {
+		.id = "pipewire_audio_input_capture",
+		.type = OBS_SOURCE_TYPE_INPUT,
+		.output_flags = OBS_SOURCE_AUDIO | OBS_SOURCE_DO_NOT_DUPLICATE,
+		.get_name = pipewire_audio_input_get_name,
+		.create = pipewire_audio_input_create,
+		.destroy = pipewire_audio_destroy,
+		.update = pipewire_audio_update,
+		.get_defaults = pipewire_audio_defaults,
+		.get_properties = pipewire_audio_properties,
+		.icon_type = OBS_ICON_TYPE_AUDIO_INPUT,
+	};
+
+	const struct obs_source_info output_info = {
+		.id = "pipewire_audio_output_capture",
+		.type = OBS_SOURCE_TYPE_INPUT,
+		.output_flags = OBS_SOURCE_AUDIO | OBS_SOURCE_DO_NOT_DUPLICATE |
+				OBS_SOURCE_DO_NOT_SELF_MONITOR,
+		.get_name = pipewire_audio_output_get_name,
+		.create = pipewire_audio_output_create,
+		.destroy = pipewire_audio_destroy,
+		.update = pipewire_audio_update,
+		.get_defaults = pipewire_audio_defaults,
+		.get_properties = pipewire_audio_properties,
+		.icon_type = OBS_ICON_TYPE_AUDIO_OUTPUT,
+	};
+
+	obs_register_source(&input_info);
+	obs_register_source(&output_info);
+}
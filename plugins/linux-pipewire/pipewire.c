@@ -40,6 +40,9 @@
 	(sizeof(struct spa_meta_cursor) + sizeof(struct spa_meta_bitmap) + \
 	 width * height * 4)
 
+#define MAX_DMABUF_PLANES 4
+#define MAX_DMABUF_TEXTURES 16
+
 struct obs_pw_version {
 	int major;
 	int minor;
@@ -52,11 +55,40 @@ struct format_info {
 	DARRAY(uint64_t) modifiers;
 };
 
+/* PipeWire recycles a small set of buffers, so a texture imported from one
+ * stays valid until the buffer is removed from the stream */
+struct dmabuf_texture {
+	uint32_t n_planes;
+	int fds[MAX_DMABUF_PLANES];
+	uint32_t offsets[MAX_DMABUF_PLANES];
+	uint32_t strides[MAX_DMABUF_PLANES];
+	uint32_t width, height;
+	uint32_t spa_format;
+	uint64_t modifier;
+	gs_texture_t *texture;
+};
+
+enum frame_path {
+	FRAME_PATH_NONE,
+	FRAME_PATH_DMABUF,
+	FRAME_PATH_SHM,
+};
+
 struct _obs_pipewire_data {
 	uint32_t pipewire_node;
 	int pipewire_fd;
 
 	gs_texture_t *texture;
+	bool texture_imported;
+
+	DARRAY(struct dmabuf_texture) dmabuf_textures;
+
+	struct {
+		enum frame_path path;
+		uint64_t frames;
+		uint64_t imports;
+		uint64_t uploads;
+	} stats;
 
 	struct pw_thread_loop *thread_loop;
 	struct pw_context *context;
@@ -146,14 +178,73 @@ static void teardown_pipewire(obs_pipewire_data *obs_pw)
 	obs_pw->negotiated = false;
 }
 
+/* textures imported from DMA-BUFs belong to dmabuf_textures */
+static void release_frame_texture(obs_pipewire_data *obs_pw)
+{
+	if (!obs_pw->texture_imported)
+		g_clear_pointer(&obs_pw->texture, gs_texture_destroy);
+
+	obs_pw->texture = NULL;
+	obs_pw->texture_imported = false;
+}
+
+static void clear_dmabuf_textures(obs_pipewire_data *obs_pw)
+{
+	if (obs_pw->texture_imported)
+		release_frame_texture(obs_pw);
+
+	for (size_t i = 0; i < obs_pw->dmabuf_textures.num; i++)
+		gs_texture_destroy(obs_pw->dmabuf_textures.array[i].texture);
+	da_free(obs_pw->dmabuf_textures);
+}
+
 static void destroy_session(obs_pipewire_data *obs_pw)
 {
 	obs_enter_graphics();
 	g_clear_pointer(&obs_pw->cursor.texture, gs_texture_destroy);
-	g_clear_pointer(&obs_pw->texture, gs_texture_destroy);
+	release_frame_texture(obs_pw);
+	clear_dmabuf_textures(obs_pw);
 	obs_leave_graphics();
 }
 
+static const char *frame_path_name(enum frame_path path)
+{
+	switch (path) {
+	case FRAME_PATH_DMABUF:
+		return "DMA-BUF";
+	case FRAME_PATH_SHM:
+		return "SHM";
+	case FRAME_PATH_NONE:
+		break;
+	}
+	return "none";
+}
+
+static void update_frame_path(obs_pipewire_data *obs_pw, enum frame_path path)
+{
+	obs_pw->stats.frames++;
+
+	if (obs_pw->stats.path == path)
+		return;
+
+	blog(LOG_INFO, "[pipewire] Stream %p receives %s frames",
+	     obs_pw->stream, frame_path_name(path));
+	obs_pw->stats.path = path;
+}
+
+static void log_stats(obs_pipewire_data *obs_pw)
+{
+	if (!obs_pw->stats.frames)
+		return;
+
+	blog(LOG_INFO,
+	     "[pipewire] Stream %p stats: %s path, %" PRIu64 " frames, "
+	     "%" PRIu64 " DMA-BUF imports, %" PRIu64 " SHM uploads",
+	     obs_pw->stream, frame_path_name(obs_pw->stats.path),
+	     obs_pw->stats.frames, obs_pw->stats.imports,
+	     obs_pw->stats.uploads);
+}
+
 static inline bool has_effective_crop(obs_pipewire_data *obs_pw)
 {
 	return obs_pw->crop.valid &&
@@ -290,12 +381,28 @@ static inline struct spa_pod *build_format(struct spa_pod_builder *b,
 	return spa_pod_builder_pop(b, &format_frame);
 }
 
+/* every format is offered once with its modifiers and once without, the
+ * fixed properties of a format pod take well under 256 bytes */
+static size_t format_params_size(obs_pipewire_data *obs_pw)
+{
+	size_t size = 0;
+
+	for (size_t i = 0; i < obs_pw->format_info.num; i++) {
+		size += 2 * 256;
+		size += (obs_pw->format_info.array[i].modifiers.num + 1) *
+			sizeof(uint64_t);
+	}
+
+	return size;
+}
+
 static bool build_format_params(obs_pipewire_data *obs_pw,
 				struct spa_pod_builder *pod_builder,
 				const struct spa_pod ***param_list,
 				uint32_t *n_params)
 {
 	uint32_t params_count = 0;
+	struct spa_pod *param;
 
 	const struct spa_pod **params;
 	params =
@@ -314,19 +421,27 @@ static bool build_format_params(obs_pipewire_data *obs_pw,
 		if (obs_pw->format_info.array[i].modifiers.num == 0) {
 			continue;
 		}
-		params[params_count++] = build_format(
+		param = build_format(
 			pod_builder, &obs_pw->video_info,
 			obs_pw->format_info.array[i].spa_format,
 			obs_pw->format_info.array[i].modifiers.array,
 			obs_pw->format_info.array[i].modifiers.num);
+		if (param)
+			params[params_count++] = param;
 	}
 
 build_shm:
 	for (size_t i = 0; i < obs_pw->format_info.num; i++) {
-		params[params_count++] = build_format(
-			pod_builder, &obs_pw->video_info,
-			obs_pw->format_info.array[i].spa_format, NULL, 0);
+		param = build_format(pod_builder, &obs_pw->video_info,
+				     obs_pw->format_info.array[i].spa_format,
+				     NULL, 0);
+		if (param)
+			params[params_count++] = param;
 	}
+
+	if (pod_builder->state.offset > pod_builder->size)
+		blog(LOG_WARNING, "[pipewire] Format params were truncated");
+
 	*param_list = params;
 	*n_params = params_count;
 	return true;
@@ -434,23 +549,109 @@ static void renegotiate_format(void *data, uint64_t expirations)
 
 	pw_thread_loop_lock(obs_pw->thread_loop);
 
-	uint8_t params_buffer[2048];
+	size_t params_size = format_params_size(obs_pw);
+	uint8_t *params_buffer = bmalloc(params_size);
 	struct spa_pod_builder pod_builder =
-		SPA_POD_BUILDER_INIT(params_buffer, sizeof(params_buffer));
+		SPA_POD_BUILDER_INIT(params_buffer, params_size);
 	uint32_t n_params;
 	if (!build_format_params(obs_pw, &pod_builder, &params, &n_params)) {
 		teardown_pipewire(obs_pw);
 		pw_thread_loop_unlock(obs_pw->thread_loop);
+		bfree(params_buffer);
 		return;
 	}
 
 	pw_stream_update_params(obs_pw->stream, params, n_params);
 	pw_thread_loop_unlock(obs_pw->thread_loop);
 	bfree(params);
+	bfree(params_buffer);
 }
 
 /* ------------------------------------------------- */
 
+static bool dmabuf_texture_matches(const struct dmabuf_texture *tex,
+				   const struct dmabuf_texture *key)
+{
+	if (tex->n_planes != key->n_planes || tex->width != key->width ||
+	    tex->height != key->height || tex->spa_format != key->spa_format ||
+	    tex->modifier != key->modifier)
+		return false;
+
+	for (uint32_t plane = 0; plane < key->n_planes; plane++) {
+		if (tex->fds[plane] != key->fds[plane] ||
+		    tex->offsets[plane] != key->offsets[plane] ||
+		    tex->strides[plane] != key->strides[plane])
+			return false;
+	}
+
+	return true;
+}
+
+static gs_texture_t *import_dmabuf_texture(obs_pipewire_data *obs_pw,
+					   struct dmabuf_texture *key,
+					   uint32_t drm_format)
+{
+	uint64_t modifiers[MAX_DMABUF_PLANES];
+	bool use_modifiers;
+
+	for (size_t i = 0; i < obs_pw->dmabuf_textures.num; i++) {
+		struct dmabuf_texture *tex = &obs_pw->dmabuf_textures.array[i];
+		if (dmabuf_texture_matches(tex, key))
+			return tex->texture;
+	}
+
+	for (uint32_t plane = 0; plane < key->n_planes; plane++)
+		modifiers[plane] = key->modifier;
+
+	use_modifiers = key->modifier != DRM_FORMAT_MOD_INVALID;
+	key->texture = gs_texture_create_from_dmabuf(
+		key->width, key->height, drm_format, GS_BGRX, key->n_planes,
+		key->fds, key->strides, key->offsets,
+		use_modifiers ? modifiers : NULL);
+	if (!key->texture)
+		return NULL;
+
+	obs_pw->stats.imports++;
+
+	/* buffers that never got removed, don't let them pile up */
+	if (obs_pw->dmabuf_textures.num >= MAX_DMABUF_TEXTURES) {
+		struct dmabuf_texture *old = &obs_pw->dmabuf_textures.array[0];
+		if (obs_pw->texture == old->texture)
+			release_frame_texture(obs_pw);
+		gs_texture_destroy(old->texture);
+		da_erase(obs_pw->dmabuf_textures, 0);
+	}
+
+	da_push_back(obs_pw->dmabuf_textures, key);
+	return key->texture;
+}
+
+static void on_remove_buffer_cb(void *user_data, struct pw_buffer *b)
+{
+	obs_pipewire_data *obs_pw = user_data;
+	struct spa_buffer *buffer = b->buffer;
+
+	if (buffer->n_datas == 0 || buffer->datas[0].type != SPA_DATA_DmaBuf)
+		return;
+
+	obs_enter_graphics();
+
+	/* the fd may be reused for another buffer once this one is gone */
+	for (size_t i = obs_pw->dmabuf_textures.num; i > 0; i--) {
+		struct dmabuf_texture *tex =
+			&obs_pw->dmabuf_textures.array[i - 1];
+		if (tex->fds[0] != buffer->datas[0].fd)
+			continue;
+
+		if (obs_pw->texture == tex->texture)
+			release_frame_texture(obs_pw);
+		gs_texture_destroy(tex->texture);
+		da_erase(obs_pw->dmabuf_textures, i - 1);
+	}
+
+	obs_leave_graphics();
+}
+
 static void on_process_cb(void *user_data)
 {
 	obs_pipewire_data *obs_pw = user_data;
@@ -488,12 +689,9 @@ static void on_process_cb(void *user_data)
 		goto read_metadata;
 
 	if (buffer->datas[0].type == SPA_DATA_DmaBuf) {
+		struct dmabuf_texture key = {0};
 		uint32_t planes = buffer->n_datas;
-		uint32_t offsets[planes];
-		uint32_t strides[planes];
-		uint64_t modifiers[planes];
-		int fds[planes];
-		bool use_modifiers;
+		gs_texture_t *texture;
 
 		blog(LOG_DEBUG,
 		     "[pipewire] DMA-BUF info: fd:%ld, stride:%d, offset:%u, size:%dx%d",
@@ -511,24 +709,34 @@ static void on_process_cb(void *user_data)
 			goto read_metadata;
 		}
 
+		if (planes > MAX_DMABUF_PLANES) {
+			blog(LOG_ERROR,
+			     "[pipewire] unsupported DMA buffer plane count: %u",
+			     planes);
+			goto read_metadata;
+		}
+
+		key.n_planes = planes;
+		key.width = obs_pw->format.info.raw.size.width;
+		key.height = obs_pw->format.info.raw.size.height;
+		key.spa_format = obs_pw->format.info.raw.format;
+		key.modifier = obs_pw->format.info.raw.modifier;
+
 		for (uint32_t plane = 0; plane < planes; plane++) {
-			fds[plane] = buffer->datas[plane].fd;
-			offsets[plane] = buffer->datas[plane].chunk->offset;
-			strides[plane] = buffer->datas[plane].chunk->stride;
-			modifiers[plane] = obs_pw->format.info.raw.modifier;
+			key.fds[plane] = buffer->datas[plane].fd;
+			key.offsets[plane] = buffer->datas[plane].chunk->offset;
+			key.strides[plane] = buffer->datas[plane].chunk->stride;
 		}
 
-		g_clear_pointer(&obs_pw->texture, gs_texture_destroy);
+		texture = import_dmabuf_texture(obs_pw, &key, drm_format);
 
-		use_modifiers = obs_pw->format.info.raw.modifier !=
-				DRM_FORMAT_MOD_INVALID;
-		obs_pw->texture = gs_texture_create_from_dmabuf(
-			obs_pw->format.info.raw.size.width,
-			obs_pw->format.info.raw.size.height, drm_format,
-			GS_BGRX, planes, fds, strides, offsets,
-			use_modifiers ? modifiers : NULL);
+		release_frame_texture(obs_pw);
+		obs_pw->texture = texture;
+		obs_pw->texture_imported = texture != NULL;
 
-		if (obs_pw->texture == NULL) {
+		if (texture) {
+			update_frame_path(obs_pw, FRAME_PATH_DMABUF);
+		} else {
 			remove_modifier_from_format(
 				obs_pw, obs_pw->format.info.raw.format,
 				obs_pw->format.info.raw.modifier);
@@ -549,11 +757,32 @@ static void on_process_cb(void *user_data)
 			goto read_metadata;
 		}
 
-		g_clear_pointer(&obs_pw->texture, gs_texture_destroy);
-		obs_pw->texture = gs_texture_create(
-			obs_pw->format.info.raw.size.width,
-			obs_pw->format.info.raw.size.height, gs_format, 1,
-			(const uint8_t **)&buffer->datas[0].data, GS_DYNAMIC);
+		uint32_t width = obs_pw->format.info.raw.size.width;
+		uint32_t height = obs_pw->format.info.raw.size.height;
+		uint32_t stride = buffer->datas[0].chunk->stride;
+
+		if (!stride)
+			stride = width * 4;
+
+		/* reuse the texture as long as the frame layout stays */
+		if (obs_pw->texture && !obs_pw->texture_imported &&
+		    gs_texture_get_width(obs_pw->texture) == width &&
+		    gs_texture_get_height(obs_pw->texture) == height &&
+		    gs_texture_get_color_format(obs_pw->texture) == gs_format &&
+		    stride == width * 4) {
+			gs_texture_set_image(obs_pw->texture,
+					     buffer->datas[0].data, stride,
+					     false);
+		} else {
+			release_frame_texture(obs_pw);
+			obs_pw->texture = gs_texture_create(
+				width, height, gs_format, 1,
+				(const uint8_t **)&buffer->datas[0].data,
+				GS_DYNAMIC);
+		}
+
+		obs_pw->stats.uploads++;
+		update_frame_path(obs_pw, FRAME_PATH_SHM);
 	}
 
 	if (swap_red_blue)
@@ -718,6 +947,7 @@ static const struct pw_stream_events stream_events = {
 	PW_VERSION_STREAM_EVENTS,
 	.state_changed = on_state_changed_cb,
 	.param_changed = on_param_changed_cb,
+	.remove_buffer = on_remove_buffer_cb,
 	.process = on_process_cb,
 };
 
@@ -759,7 +989,8 @@ static void play_pipewire_stream(obs_pipewire_data *obs_pw)
 	struct spa_pod_builder pod_builder;
 	const struct spa_pod **params = NULL;
 	uint32_t n_params;
-	uint8_t params_buffer[2048];
+	uint8_t *params_buffer;
+	size_t params_size;
 
 	obs_pw->thread_loop = pw_thread_loop_new("PipeWire thread loop", NULL);
 	obs_pw->context = pw_context_new(
@@ -807,14 +1038,16 @@ static void play_pipewire_stream(obs_pipewire_data *obs_pw)
 	blog(LOG_INFO, "[pipewire] Created stream %p", obs_pw->stream);
 
 	/* Stream parameters */
-	pod_builder =
-		SPA_POD_BUILDER_INIT(params_buffer, sizeof(params_buffer));
+	params_size = format_params_size(obs_pw);
+	params_buffer = bmalloc(params_size);
+	pod_builder = SPA_POD_BUILDER_INIT(params_buffer, params_size);
 
 	obs_get_video_info(&obs_pw->video_info);
 
 	if (!build_format_params(obs_pw, &pod_builder, &params, &n_params)) {
 		pw_thread_loop_unlock(obs_pw->thread_loop);
 		teardown_pipewire(obs_pw);
+		bfree(params_buffer);
 		return;
 	}
 
@@ -827,6 +1060,7 @@ static void play_pipewire_stream(obs_pipewire_data *obs_pw)
 
 	pw_thread_loop_unlock(obs_pw->thread_loop);
 	bfree(params);
+	bfree(params_buffer);
 }
 
 /* obs_source_info methods */
@@ -849,6 +1083,7 @@ void obs_pipewire_destroy(obs_pipewire_data *obs_pw)
 	if (!obs_pw)
 		return;
 
+	log_stats(obs_pw);
 	teardown_pipewire(obs_pw);
 	destroy_session(obs_pw);
 
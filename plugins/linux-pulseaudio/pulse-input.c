@@ -35,6 +35,7 @@ struct pulse_data {
 	/* user settings */
 	char *device;
 	bool input;
+	uint_fast32_t latency_ms;
 
 	/* server info */
 	enum speaker_layout speakers;
@@ -170,6 +171,22 @@ static inline uint64_t get_sample_time(size_t frames, uint_fast32_t rate)
 	return os_gettime_ns() - samples_to_ns(frames, rate);
 }
 
+/* for record streams the latency is how long ago the data at the read index
+ * was captured, which is more accurate than assuming it arrived just now.
+ * it isn't known until the first timing update, or while the stream is
+ * corked, so this falls back to the time at which the data was received */
+static uint64_t get_stream_time(struct pulse_data *data, size_t frames)
+{
+	pa_usec_t latency;
+	int negative;
+
+	if (pa_stream_get_latency(data->stream, &latency, &negative) == 0 &&
+	    !negative)
+		return os_gettime_ns() - latency * 1000;
+
+	return get_sample_time(frames, data->samples_per_sec);
+}
+
 #define STARTUP_TIMEOUT_NS (500 * NSEC_PER_MSEC)
 
 /**
@@ -208,7 +225,7 @@ static void pulse_stream_read(pa_stream *p, size_t nbytes, void *userdata)
 	out.format = pulse_to_obs_audio_format(data->format);
 	out.data[0] = (uint8_t *)frames;
 	out.frames = bytes / data->bytes_per_frame;
-	out.timestamp = get_sample_time(out.frames, out.samples_per_sec);
+	out.timestamp = get_stream_time(data, out.frames);
 
 	if (!data->first_ts)
 		data->first_ts = out.timestamp + STARTUP_TIMEOUT_NS;
@@ -371,14 +388,18 @@ static int_fast32_t pulse_start_recording(struct pulse_data *data)
 				    (void *)data);
 	pulse_unlock();
 
+	/* the fragment size is how much the server collects before waking us
+	 * up, with ADJUST_LATENCY the source latency is lowered to match */
 	pa_buffer_attr attr;
-	attr.fragsize = pa_usec_to_bytes(25000, &spec);
+	attr.fragsize = pa_usec_to_bytes(data->latency_ms * 1000, &spec);
 	attr.maxlength = (uint32_t)-1;
 	attr.minreq = (uint32_t)-1;
 	attr.prebuf = (uint32_t)-1;
 	attr.tlength = (uint32_t)-1;
 
-	pa_stream_flags_t flags = PA_STREAM_ADJUST_LATENCY;
+	pa_stream_flags_t flags = PA_STREAM_ADJUST_LATENCY |
+				  PA_STREAM_INTERPOLATE_TIMING |
+				  PA_STREAM_AUTO_TIMING_UPDATE;
 
 	pulse_lock();
 	int_fast32_t ret = pa_stream_connect_record(data->stream, data->device,
@@ -390,7 +411,8 @@ static int_fast32_t pulse_start_recording(struct pulse_data *data)
 		return -1;
 	}
 
-	blog(LOG_INFO, "Started recording from '%s'", data->device);
+	blog(LOG_INFO, "Started recording from '%s' (%" PRIuFAST32 " ms)",
+	     data->device, data->latency_ms);
 	return 0;
 }
 
@@ -474,6 +496,10 @@ static obs_properties_t *pulse_properties(bool input)
 		obs_property_list_insert_string(
 			devices, 0, obs_module_text("Default"), "default");
 
+	obs_property_t *latency = obs_properties_add_int(
+		props, "latency_ms", obs_module_text("Latency"), 2, 200, 1);
+	obs_property_int_set_suffix(latency, " ms");
+
 	return props;
 }
 
@@ -497,6 +523,7 @@ static obs_properties_t *pulse_output_properties(void *unused)
 static void pulse_defaults(obs_data_t *settings)
 {
 	obs_data_set_default_string(settings, "device_id", "default");
+	obs_data_set_default_int(settings, "latency_ms", 25);
 }
 
 /**
@@ -541,6 +568,7 @@ static void pulse_update(void *vptr, obs_data_t *settings)
 	PULSE_DATA(vptr);
 	bool restart = false;
 	const char *new_device;
+	uint_fast32_t latency_ms;
 
 	new_device = obs_data_get_string(settings, "device_id");
 	if (!data->device || strcmp(data->device, new_device) != 0) {
@@ -550,6 +578,12 @@ static void pulse_update(void *vptr, obs_data_t *settings)
 		restart = true;
 	}
 
+	latency_ms = (uint_fast32_t)obs_data_get_int(settings, "latency_ms");
+	if (data->latency_ms != latency_ms) {
+		data->latency_ms = latency_ms;
+		restart = true;
+	}
+
 	if (!restart)
 		return;
 
@@ -27,6 +27,7 @@ MODULE_EXPORT const char *obs_module_description(void)
 extern struct obs_source_info v4l2_input;
 extern struct obs_output_info virtualcam_info;
 extern bool loopback_module_available();
+extern void v4l2_free_device_cache(void);
 
 bool obs_module_load(void)
 {
@@ -48,3 +49,8 @@ bool obs_module_load(void)
 
 	return true;
 }
+
+void obs_module_unload(void)
+{
+	v4l2_free_device_cache();
+}
@@ -17,13 +17,53 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <obs-module.h>
 #include <linux/videodev2.h>
+#include <libavutil/hwcontext.h>
 
 #include "v4l2-decoder.h"
 
 #define blog(level, msg, ...) \
 	blog(level, "v4l2-input: decoder: " msg, ##__VA_ARGS__)
 
-int v4l2_init_decoder(struct v4l2_decoder *decoder, int pixfmt)
+static bool has_vaapi(const AVCodec *codec)
+{
+	for (int i = 0;; i++) {
+		const AVCodecHWConfig *config = avcodec_get_hw_config(codec, i);
+		if (!config)
+			return false;
+
+		if (config->methods & AV_CODEC_HW_CONFIG_METHOD_HW_DEVICE_CTX &&
+		    config->device_type == AV_HWDEVICE_TYPE_VAAPI)
+			return true;
+	}
+}
+
+static void init_hw_decoder(struct v4l2_decoder *decoder)
+{
+	if (!has_vaapi(decoder->codec)) {
+		blog(LOG_INFO, "no VAAPI support for %s, decoding in software",
+		     decoder->codec->name);
+		return;
+	}
+
+	if (av_hwdevice_ctx_create(&decoder->hw_device_ctx,
+				   AV_HWDEVICE_TYPE_VAAPI, NULL, NULL,
+				   0) < 0) {
+		blog(LOG_WARNING,
+		     "failed to create VAAPI device, decoding in software");
+		return;
+	}
+
+	decoder->hw_frame = av_frame_alloc();
+	if (!decoder->hw_frame) {
+		av_buffer_unref(&decoder->hw_device_ctx);
+		return;
+	}
+
+	decoder->context->hw_device_ctx = av_buffer_ref(decoder->hw_device_ctx);
+	decoder->hw = true;
+}
+
+int v4l2_init_decoder(struct v4l2_decoder *decoder, int pixfmt, bool use_hw)
 {
 	if (pixfmt == V4L2_PIX_FMT_MJPEG) {
 		decoder->codec = avcodec_find_decoder(AV_CODEC_ID_MJPEG);
@@ -56,12 +96,16 @@ int v4l2_init_decoder(struct v4l2_decoder *decoder, int pixfmt)
 
 	decoder->context->flags2 |= AV_CODEC_FLAG2_FAST;
 
+	if (use_hw)
+		init_hw_decoder(decoder);
+
 	if (avcodec_open2(decoder->context, decoder->codec, NULL) < 0) {
 		blog(LOG_ERROR, "failed to open codec");
 		return -1;
 	}
 
-	blog(LOG_DEBUG, "initialized avcodec");
+	blog(LOG_INFO, "initialized avcodec, %s decoding",
+	     decoder->hw ? "VAAPI" : "software");
 
 	return 0;
 }
@@ -73,6 +117,10 @@ void v4l2_destroy_decoder(struct v4l2_decoder *decoder)
 		av_frame_free(&decoder->frame);
 	}
 
+	if (decoder->hw_frame) {
+		av_frame_free(&decoder->hw_frame);
+	}
+
 	if (decoder->packet) {
 		av_packet_free(&decoder->packet);
 	}
@@ -81,11 +129,19 @@ void v4l2_destroy_decoder(struct v4l2_decoder *decoder)
 		avcodec_close(decoder->context);
 		avcodec_free_context(&decoder->context);
 	}
+
+	if (decoder->hw_device_ctx) {
+		av_buffer_unref(&decoder->hw_device_ctx);
+	}
+
+	decoder->hw = false;
 }
 
 int v4l2_decode_frame(struct obs_source_frame *out, uint8_t *data,
 		      size_t length, struct v4l2_decoder *decoder)
 {
+	AVFrame *frame = decoder->hw ? decoder->hw_frame : decoder->frame;
+
 	decoder->packet->data = data;
 	decoder->packet->size = length;
 	if (avcodec_send_packet(decoder->context, decoder->packet) < 0) {
@@ -93,17 +149,31 @@ int v4l2_decode_frame(struct obs_source_frame *out, uint8_t *data,
 		return -1;
 	}
 
-	if (avcodec_receive_frame(decoder->context, decoder->frame) < 0) {
+	if (avcodec_receive_frame(decoder->context, frame) < 0) {
 		blog(LOG_ERROR, "failed to receive frame from codec");
 		return -1;
 	}
 
+	/* the hwaccel hands back frames in system memory for streams it
+	 * can't decode, those are used as is */
+	if (frame->format == AV_PIX_FMT_VAAPI) {
+		av_frame_unref(decoder->frame);
+		if (av_hwframe_transfer_data(decoder->frame, frame, 0) < 0) {
+			blog(LOG_ERROR, "failed to download frame from GPU");
+			return -1;
+		}
+		frame = decoder->frame;
+	}
+
 	for (uint_fast32_t i = 0; i < MAX_AV_PLANES; ++i) {
-		out->data[i] = decoder->frame->data[i];
-		out->linesize[i] = decoder->frame->linesize[i];
+		out->data[i] = frame->data[i];
+		out->linesize[i] = frame->linesize[i];
 	}
 
-	switch (decoder->context->pix_fmt) {
+	switch (frame->format) {
+	case AV_PIX_FMT_NV12:
+		out->format = VIDEO_FORMAT_NV12;
+		break;
 	case AV_PIX_FMT_YUVJ422P:
 	case AV_PIX_FMT_YUV422P:
 		out->format = VIDEO_FORMAT_I422;
@@ -21,6 +21,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 extern "C" {
 #endif
 
+#include <stdbool.h>
 #include <libavcodec/avcodec.h>
 #include <libavformat/avformat.h>
 #include <libavutil/pixfmt.h>
@@ -33,17 +34,25 @@ struct v4l2_decoder {
 	AVCodecContext *context;
 	AVPacket *packet;
 	AVFrame *frame;
+
+	AVBufferRef *hw_device_ctx;
+	AVFrame *hw_frame;
+	bool hw;
 };
 
 /**
  * Initialize the decoder.
  * The decoder must be destroyed on failure.
  *
+ * If hardware decoding is requested but VAAPI can't be used for the codec
+ * the decoder silently falls back to software decoding.
+ *
  * @param decoder the decoder structure
  * @param pixfmt which codec is used
+ * @param use_hw try to decode with VAAPI
  * @return non-zero on failure
  */
-int v4l2_init_decoder(struct v4l2_decoder *decoder, int pixfmt);
+int v4l2_init_decoder(struct v4l2_decoder *decoder, int pixfmt, bool use_hw);
 
 /**
  * Free any data associated with the decoder.
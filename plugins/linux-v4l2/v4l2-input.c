@@ -31,6 +31,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <util/threading.h>
 #include <util/bmem.h>
+#include <util/darray.h>
 #include <util/dstr.h>
 #include <util/platform.h>
 #include <obs-module.h>
@@ -76,6 +77,7 @@ struct v4l2_data {
 	int resolution;
 	int framerate;
 	int color_range;
+	bool hw_decode;
 
 	/* internal data */
 	obs_source_t *source;
@@ -317,6 +319,7 @@ static void v4l2_defaults(obs_data_t *settings)
 	obs_data_set_default_bool(settings, "buffering", true);
 	obs_data_set_default_bool(settings, "auto_reset", false);
 	obs_data_set_default_int(settings, "timeout_frames", 5);
+	obs_data_set_default_bool(settings, "hw_decode", false);
 }
 
 /**
@@ -344,16 +347,46 @@ static void v4l2_props_set_enabled(obs_properties_t *props,
 }
 
 /*
- * List available devices
+ * Opening and querying every device can take a while with many cameras
+ * attached, so the device list is cached for as long as udev is watching
+ * for devices being added or removed.
  */
-static void v4l2_device_list(obs_property_t *prop, obs_data_t *settings)
+struct v4l2_device_entry {
+	char *name;
+	char *path;
+};
+
+static pthread_mutex_t device_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static DARRAY(struct v4l2_device_entry) device_cache;
+static long device_cache_serial = 0;
+
+static void device_cache_clear(void)
+{
+	for (size_t i = 0; i < device_cache.num; i++) {
+		bfree(device_cache.array[i].name);
+		bfree(device_cache.array[i].path);
+	}
+	da_resize(device_cache, 0);
+}
+
+void v4l2_free_device_cache(void)
+{
+	pthread_mutex_lock(&device_cache_mutex);
+	device_cache_clear();
+	da_free(device_cache);
+	pthread_mutex_unlock(&device_cache_mutex);
+}
+
+/*
+ * Enumerate available devices into the cache
+ */
+static void v4l2_enum_devices(void)
 {
 	DIR *dirp;
 	struct dirent *dp;
 	struct dstr device;
-	bool cur_device_found;
-	size_t cur_device_index;
-	const char *cur_device_name;
+
+	device_cache_clear();
 
 #ifdef __FreeBSD__
 	dirp = opendir("/dev");
@@ -363,11 +396,6 @@ static void v4l2_device_list(obs_property_t *prop, obs_data_t *settings)
 	if (!dirp)
 		return;
 
-	cur_device_found = false;
-	cur_device_name = obs_data_get_string(settings, "device_id");
-
-	obs_property_list_clear(prop);
-
 	dstr_init_copy(&device, "/dev/");
 
 	while ((dp = readdir(dirp)) != NULL) {
@@ -418,27 +446,64 @@ static void v4l2_device_list(obs_property_t *prop, obs_data_t *settings)
 		char unique_device_name[68];
 		sprintf(unique_device_name, "%s (%s)", video_cap.card,
 			video_cap.bus_info);
-		obs_property_list_add_string(prop, unique_device_name,
-					     device.array);
+
+		struct v4l2_device_entry *entry =
+			da_push_back_new(device_cache);
+		entry->name = bstrdup(unique_device_name);
+		entry->path = bstrdup(device.array);
 		blog(LOG_INFO, "Found device '%s' at %s", video_cap.card,
 		     device.array);
 
+		v4l2_close(fd);
+	}
+
+	closedir(dirp);
+	dstr_free(&device);
+}
+
+/*
+ * List available devices
+ */
+static void v4l2_device_list(obs_property_t *prop, obs_data_t *settings)
+{
+	bool cur_device_found = false;
+	size_t cur_device_index;
+	const char *cur_device_name;
+	long serial = 0;
+
+#if HAVE_UDEV
+	serial = v4l2_get_udev_serial();
+#endif
+
+	cur_device_name = obs_data_get_string(settings, "device_id");
+
+	obs_property_list_clear(prop);
+
+	pthread_mutex_lock(&device_cache_mutex);
+
+	if (!serial || serial != device_cache_serial) {
+		v4l2_enum_devices();
+		device_cache_serial = serial;
+	}
+
+	for (size_t i = 0; i < device_cache.num; i++) {
+		struct v4l2_device_entry *entry = &device_cache.array[i];
+
+		obs_property_list_add_string(prop, entry->name, entry->path);
+
 		/* check if this is the currently used device */
-		if (cur_device_name && !strcmp(cur_device_name, device.array))
+		if (cur_device_name && !strcmp(cur_device_name, entry->path))
 			cur_device_found = true;
-
-		v4l2_close(fd);
 	}
 
+	pthread_mutex_unlock(&device_cache_mutex);
+
 	/* add currently selected device if not present, but disable it ... */
 	if (!cur_device_found && cur_device_name && strlen(cur_device_name)) {
 		cur_device_index = obs_property_list_add_string(
 			prop, cur_device_name, cur_device_name);
 		obs_property_list_item_disable(prop, cur_device_index, true);
 	}
-
-	closedir(dirp);
-	dstr_free(&device);
 }
 
 /*
@@ -885,6 +950,9 @@ static obs_properties_t *v4l2_properties(void *vptr)
 			       obs_module_text("FramesUntilTimeout"), 2, 120,
 			       1);
 
+	obs_properties_add_bool(props, "hw_decode",
+				obs_module_text("HardwareDecode"));
+
 	// a group to contain the camera control
 	obs_properties_t *ctrl_props = obs_properties_create();
 	obs_properties_add_group(props, "controls",
@@ -1034,7 +1102,8 @@ static void v4l2_init(struct v4l2_data *data)
 
 	if (data->pixfmt == V4L2_PIX_FMT_MJPEG ||
 	    data->pixfmt == V4L2_PIX_FMT_H264) {
-		if (v4l2_init_decoder(&data->decoder, data->pixfmt) < 0) {
+		if (v4l2_init_decoder(&data->decoder, data->pixfmt,
+				      data->hw_decode) < 0) {
 			blog(LOG_ERROR, "Failed to initialize decoder");
 			goto fail;
 		}
@@ -1108,6 +1177,8 @@ static bool v4l2_settings_changed(struct v4l2_data *data, obs_data_t *settings)
 
 		res |= data->color_range !=
 		       obs_data_get_int(settings, "color_range");
+		res |= data->hw_decode !=
+		       obs_data_get_bool(settings, "hw_decode");
 	} else {
 		res = true;
 	}
@@ -1145,6 +1216,7 @@ static void v4l2_update(void *vptr, obs_data_t *settings)
 	data->color_range = obs_data_get_int(settings, "color_range");
 	data->auto_reset = obs_data_get_bool(settings, "auto_reset");
 	data->timeout_frames = obs_data_get_int(settings, "timeout_frames");
+	data->hw_decode = obs_data_get_bool(settings, "hw_decode");
 
 	v4l2_update_source_flags(data, settings);
 
@@ -40,6 +40,7 @@ static const char *udev_signals[] = {"void device_added(string device)",
 /* global data */
 static uint_fast32_t udev_refs = 0;
 static pthread_mutex_t udev_mutex = PTHREAD_MUTEX_INITIALIZER;
+static volatile long udev_serial = 0;
 
 static pthread_t udev_thread;
 static os_event_t *udev_event;
@@ -86,6 +87,9 @@ static inline void udev_signal_event(struct udev_device *dev)
 
 	calldata_set_string(&data, "device", node);
 
+	if (action != UDEV_ACTION_UNKNOWN)
+		os_atomic_inc_long(&udev_serial);
+
 	switch (action) {
 	case UDEV_ACTION_ADDED:
 		signal_handler_signal(udev_signalhandler, "device_added",
@@ -180,6 +184,9 @@ void v4l2_init_udev(void)
 			goto fail;
 		}
 		signal_handler_add_array(udev_signalhandler, udev_signals);
+
+		/* devices may have changed while nothing was watching */
+		os_atomic_inc_long(&udev_serial);
 	}
 	udev_refs++;
 
@@ -211,3 +218,15 @@ signal_handler_t *v4l2_get_udev_signalhandler(void)
 {
 	return udev_signalhandler;
 }
+
+long v4l2_get_udev_serial(void)
+{
+	long serial = 0;
+
+	pthread_mutex_lock(&udev_mutex);
+	if (udev_refs)
+		serial = os_atomic_load_long(&udev_serial);
+	pthread_mutex_unlock(&udev_mutex);
+
+	return serial;
+}
@@ -42,6 +42,13 @@ void v4l2_unref_udev(void);
  */
 signal_handler_t *v4l2_get_udev_signalhandler(void);
 
+/**
+ * Get a counter that changes whenever a device is added or removed
+ *
+ * @return the counter, 0 if devices are not being watched
+ */
+long v4l2_get_udev_serial(void);
+
 #ifdef __cplusplus
 }
 #endif
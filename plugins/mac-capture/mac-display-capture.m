@@ -155,11 +155,19 @@ static bool init_display_stream(struct display_capture *dc)
 	CFBooleanRef show_cursor_cf = dc->hide_cursor ? kCFBooleanFalse
 						      : kCFBooleanTrue;
 
+	/* don't deliver frames faster than OBS renders them */
+	struct obs_video_info ovi;
+	double frame_time = 0.0;
+	if (obs_get_video_info(&ovi))
+		frame_time = (double)ovi.fps_den / (double)ovi.fps_num;
+
 	NSDictionary *dict = @{
 		(__bridge NSString *)kCGDisplayStreamSourceRect: rect_dict,
 		(__bridge NSString *)kCGDisplayStreamQueueDepth: @5,
 		(__bridge NSString *)
 		kCGDisplayStreamShowCursor: (id)show_cursor_cf,
+		(__bridge NSString *)
+		kCGDisplayStreamMinimumFrameTime: @(frame_time),
 	};
 
 	os_event_init(&dc->disp_finished, OS_EVENT_TYPE_MANUAL);
@@ -460,7 +460,16 @@ static bool init_screen_stream(struct screen_capture *sc)
 	} break;
 	}
 	os_sem_post(sc->shareable_content_available);
-	[sc->stream_properties setQueueDepth:8];
+
+	/* frames beyond the output rate would only be thrown away, and the
+	 * queue only needs to cover the two surfaces held here plus the one
+	 * being delivered */
+	struct obs_video_info ovi;
+	if (obs_get_video_info(&ovi))
+		[sc->stream_properties
+			setMinimumFrameInterval:CMTimeMake(ovi.fps_den,
+							   ovi.fps_num)];
+	[sc->stream_properties setQueueDepth:5];
 	[sc->stream_properties setShowsCursor:!sc->hide_cursor];
 	[sc->stream_properties setColorSpaceName:kCGColorSpaceSRGB];
 	[sc->stream_properties setPixelFormat:'BGRA'];
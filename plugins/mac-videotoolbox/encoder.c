@@ -317,7 +317,7 @@ create_encoder_spec(const char *vt_encoder_id)
 static inline CFMutableDictionaryRef create_pixbuf_spec(struct vt_encoder *enc)
 {
 	CFMutableDictionaryRef pixbuf_spec = CFDictionaryCreateMutable(
-		kCFAllocatorDefault, 3, &kCFTypeDictionaryKeyCallBacks,
+		kCFAllocatorDefault, 4, &kCFTypeDictionaryKeyCallBacks,
 		&kCFTypeDictionaryValueCallBacks);
 
 	CFNumberRef n =
@@ -333,6 +333,16 @@ static inline CFMutableDictionaryRef create_pixbuf_spec(struct vt_encoder *enc)
 	CFDictionaryAddValue(pixbuf_spec, kCVPixelBufferHeightKey, n);
 	CFRelease(n);
 
+	/* IOSurface backed buffers go to the hardware encoder as they are,
+	 * otherwise VideoToolbox copies every frame in to one itself */
+	CFDictionaryRef iosurface_props = CFDictionaryCreate(
+		kCFAllocatorDefault, NULL, NULL, 0,
+		&kCFTypeDictionaryKeyCallBacks,
+		&kCFTypeDictionaryValueCallBacks);
+	CFDictionaryAddValue(pixbuf_spec, kCVPixelBufferIOSurfacePropertiesKey,
+			     iosurface_props);
+	CFRelease(iosurface_props);
+
 	return pixbuf_spec;
 }
 
@@ -841,11 +851,21 @@ static bool vt_encode(void *data, struct encoder_frame *frame,
 		size_t plane_linesize =
 			CVPixelBufferGetBytesPerRowOfPlane(pixbuf, i);
 		size_t plane_height = CVPixelBufferGetHeightOfPlane(pixbuf, i);
+		size_t linesize = frame->linesize[i];
+
+		if (plane_linesize == linesize) {
+			memcpy(p, f, linesize * plane_height);
+			continue;
+		}
+
+		/* the buffer's rows can be narrower than the frame's */
+		size_t row_size = linesize < plane_linesize ? linesize
+							     : plane_linesize;
 
 		for (size_t j = 0; j < plane_height; j++) {
-			memcpy(p, f, frame->linesize[i]);
+			memcpy(p, f, row_size);
 			p += plane_linesize;
-			f += frame->linesize[i];
+			f += linesize;
 		}
 	}
 
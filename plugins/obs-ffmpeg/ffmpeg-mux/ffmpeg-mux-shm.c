@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2023 Hugh Bailey <obs.jim@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <util/threading.h>
+#include "ffmpeg-mux.h"
+
+#define SHM_SIZE (FFM_SHM_DATA_OFFSET + FFM_SHM_RING_SIZE)
+
+struct ffm_shm {
+#ifdef _WIN32
+	HANDLE mapping;
+#endif
+	uint8_t *mem;
+};
+
+static volatile long shm_count = 0;
+
+#ifdef _WIN32
+struct ffm_shm *ffm_shm_create(char *name, size_t name_size)
+{
+	struct ffm_shm *shm = calloc(1, sizeof(*shm));
+
+	snprintf(name, name_size, "Local\\obs-ffmpeg-mux-%lu-%ld",
+		 (unsigned long)GetCurrentProcessId(),
+		 os_atomic_inc_long(&shm_count));
+
+	shm->mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL,
+					  PAGE_READWRITE, 0, SHM_SIZE, name);
+	if (!shm->mapping)
+		goto fail;
+
+	shm->mem = MapViewOfFile(shm->mapping, FILE_MAP_ALL_ACCESS, 0, 0,
+				 SHM_SIZE);
+	if (!shm->mem)
+		goto fail;
+
+	return shm;
+
+fail:
+	ffm_shm_close(shm);
+	return NULL;
+}
+
+struct ffm_shm *ffm_shm_open(const char *name)
+{
+	struct ffm_shm *shm = calloc(1, sizeof(*shm));
+
+	shm->mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, false, name);
+	if (!shm->mapping)
+		goto fail;
+
+	shm->mem = MapViewOfFile(shm->mapping, FILE_MAP_ALL_ACCESS, 0, 0,
+				 SHM_SIZE);
+	if (!shm->mem)
+		goto fail;
+
+	return shm;
+
+fail:
+	ffm_shm_close(shm);
+	return NULL;
+}
+
+void ffm_shm_close(struct ffm_shm *shm)
+{
+	if (!shm)
+		return;
+
+	if (shm->mem)
+		UnmapViewOfFile(shm->mem);
+	if (shm->mapping)
+		CloseHandle(shm->mapping);
+	free(shm);
+}
+
+#else
+
+static struct ffm_shm *map_shm(int fd)
+{
+	struct ffm_shm *shm;
+	void *mem;
+
+	mem = mmap(NULL, SHM_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if (mem == MAP_FAILED)
+		return NULL;
+
+	shm = calloc(1, sizeof(*shm));
+	shm->mem = mem;
+	return shm;
+}
+
+struct ffm_shm *ffm_shm_create(char *name, size_t name_size)
+{
+	int fd;
+
+	snprintf(name, name_size, "/obs-ffmpeg-mux-%ld-%ld", (long)getpid(),
+		 os_atomic_inc_long(&shm_count));
+
+	fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+	if (fd == -1)
+		return NULL;
+
+	if (ftruncate(fd, SHM_SIZE) != 0) {
+		close(fd);
+		shm_unlink(name);
+		return NULL;
+	}
+
+	/* the child unlinks the name once it's mapped it, this only matters
+	 * if it never gets that far */
+	struct ffm_shm *shm = map_shm(fd);
+	if (!shm)
+		shm_unlink(name);
+	return shm;
+}
+
+struct ffm_shm *ffm_shm_open(const char *name)
+{
+	int fd = shm_open(name, O_RDWR, 0600);
+	if (fd == -1)
+		return NULL;
+
+	shm_unlink(name);
+	return map_shm(fd);
+}
+
+void ffm_shm_close(struct ffm_shm *shm)
+{
+	if (!shm)
+		return;
+
+	munmap(shm->mem, SHM_SIZE);
+	free(shm);
+}
+#endif
+
+struct ffm_shm_header *ffm_shm_header(struct ffm_shm *shm)
+{
+	return (struct ffm_shm_header *)shm->mem;
+}
+
+uint8_t *ffm_shm_data(struct ffm_shm *shm)
+{
+	return shm->mem + FFM_SHM_DATA_OFFSET;
+}
@@ -17,9 +17,16 @@
 #ifdef _WIN32
 #include <io.h>
 #include <fcntl.h>
+#include <malloc.h>
 #include <windows.h>
 #define inline __inline
 
+#else
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+#include <fcntl.h>
+#include <unistd.h>
 #endif
 
 #include <stdio.h>
@@ -102,6 +109,9 @@ struct main_params {
 	int max_luminance;
 	char *acodec;
 	char *muxer_settings;
+	int direct_io;
+	int64_t preallocate;
+	char *format;
 };
 
 struct audio_params {
@@ -136,8 +146,21 @@ struct io_buffer {
 	pthread_t io_thread;
 	pthread_mutex_t data_mutex;
 	FILE *output_file;
+	uint64_t file_pos;
+	uint64_t write_pos;
 	struct circlebuf data;
 	uint64_t next_pos;
+
+	/* unbuffered writes, see io_write */
+	bool direct;
+#ifdef _WIN32
+	HANDLE direct_handle;
+#else
+	int direct_fd;
+#endif
+	uint8_t *direct_buf;
+	size_t direct_used;
+	uint64_t direct_pos;
 };
 
 struct ffmpeg_mux {
@@ -153,7 +176,34 @@ struct ffmpeg_mux {
 	int num_audio_streams;
 	bool initialized;
 	struct io_buffer io;
+#ifdef FFMPEG_MUX_LIBRARY
+	struct ffmpeg_mux_lib *lib;
+#endif
+};
+
+struct file_finisher {
+	pthread_t thread;
+	bool active;
+};
+
+#ifdef FFMPEG_MUX_LIBRARY
+/* the muxer used inside obs-ffmpeg instead of in its own process, see
+ * ffmpeg_mux_lib_open */
+struct ffmpeg_mux_lib {
+	struct ffmpeg_mux *ffm;
+	struct file_finisher finisher;
+	int argc;
+	char **argv;
+
+	/* headers arrive as the first packets, and the muxer can only be
+	 * initialized once it has all of them */
+	int num_headers;
+	int next_header;
+	int expected_headers;
+	struct header *headers;
+	struct ffm_packet_info *header_info;
 };
+#endif
 
 static void header_free(struct header *header)
 {
@@ -281,6 +331,7 @@ static bool get_audio_params(struct audio_params *audio, int *argc,
 	return true;
 }
 
+#ifndef FFMPEG_MUX_LIBRARY
 static void ffmpeg_log_callback(void *param, int level, const char *format,
 				va_list args)
 {
@@ -320,6 +371,7 @@ static void ffmpeg_log_callback(void *param, int level, const char *format,
 #endif
 	UNUSED_PARAMETER(param);
 }
+#endif
 
 static bool init_params(int *argc, char ***argv, struct main_params *params,
 			struct audio_params **p_audio)
@@ -401,10 +453,25 @@ static bool init_params(int *argc, char ***argv, struct main_params *params,
 			     "{stream_key}");
 	}
 
+#ifndef FFMPEG_MUX_LIBRARY
+	/* inside obs-ffmpeg, its own callback stays in place */
 	av_log_set_callback(ffmpeg_log_callback);
+#endif
 
 	get_opt_str(argc, argv, &params->muxer_settings, "muxer settings");
 
+	/* added after the muxer settings, older frontends don't send it */
+	if (*argc >= 2) {
+		char *preallocate;
+		get_opt_int(argc, argv, &params->direct_io, "direct io");
+		get_opt_str(argc, argv, &preallocate, "preallocate size");
+		params->preallocate = strtoll(preallocate, NULL, 10);
+	}
+
+	/* overrides guessing the muxer from the file name */
+	if (*argc >= 1)
+		get_opt_str(argc, argv, &params->format, "format");
+
 	return true;
 }
 
@@ -604,6 +671,19 @@ static void ffmpeg_mux_header(struct ffmpeg_mux *ffm, uint8_t *data,
 	}
 }
 
+#ifdef FFMPEG_MUX_LIBRARY
+static bool ffmpeg_mux_get_header(struct ffmpeg_mux *ffm)
+{
+	struct ffmpeg_mux_lib *lib = ffm->lib;
+	int idx = lib->next_header++;
+
+	if (idx >= lib->num_headers)
+		return false;
+
+	ffmpeg_mux_header(ffm, lib->headers[idx].data, &lib->header_info[idx]);
+	return true;
+}
+#else
 static size_t safe_read(void *vdata, size_t size)
 {
 	uint8_t *data = vdata;
@@ -640,6 +720,7 @@ static bool ffmpeg_mux_get_header(struct ffmpeg_mux *ffm)
 
 	return success;
 }
+#endif
 
 static inline bool ffmpeg_mux_get_extra_data(struct ffmpeg_mux *ffm)
 {
@@ -664,6 +745,254 @@ static inline bool ffmpeg_mux_get_extra_data(struct ffmpeg_mux *ffm)
 
 #define CHUNK_SIZE 1048576
 
+/* In direct mode, appends are collected into an aligned buffer and written
+ * to an unbuffered handle in CHUNK_SIZE blocks, so hours of recording don't
+ * fill the page cache.  The rare writes behind direct_pos (muxers updating
+ * headers) and the unaligned tail at the end go through the buffered FILE,
+ * which is fine as the two never write the same range. */
+#define DIRECT_ALIGN 4096
+#define DIRECT_BUF_SIZE (CHUNK_SIZE * 2)
+
+static bool io_buffered_write(struct io_buffer *io, uint64_t offset,
+			      const uint8_t *data, size_t size)
+{
+	if (offset != io->file_pos &&
+	    os_fseeki64(io->output_file, (int64_t)offset, SEEK_SET) != 0)
+		return false;
+	if (fwrite(data, size, 1, io->output_file) != 1)
+		return false;
+
+	io->file_pos = offset + size;
+	return true;
+}
+
+static bool io_direct_write_block(struct io_buffer *io, uint64_t offset,
+				  const uint8_t *data, size_t size)
+{
+#ifdef _WIN32
+	OVERLAPPED ov = {0};
+	DWORD written = 0;
+
+	ov.Offset = (DWORD)offset;
+	ov.OffsetHigh = (DWORD)(offset >> 32);
+	return WriteFile(io->direct_handle, data, (DWORD)size, &written,
+			 &ov) &&
+	       written == size;
+#else
+	while (size) {
+		ssize_t ret = pwrite(io->direct_fd, data, size, (off_t)offset);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			return false;
+
+		data += ret;
+		offset += ret;
+		size -= ret;
+	}
+	return true;
+#endif
+}
+
+static void io_free_direct(struct io_buffer *io)
+{
+#ifdef _WIN32
+	if (io->direct_handle != INVALID_HANDLE_VALUE)
+		CloseHandle(io->direct_handle);
+	io->direct_handle = INVALID_HANDLE_VALUE;
+	_aligned_free(io->direct_buf);
+#else
+	if (io->direct_fd != -1)
+		close(io->direct_fd);
+	io->direct_fd = -1;
+	free(io->direct_buf);
+#endif
+	io->direct_buf = NULL;
+	io->direct = false;
+}
+
+/* writes out whatever direct writes are pending and goes back to the
+ * buffered FILE for everything */
+static bool io_stop_direct(struct io_buffer *io)
+{
+	bool success = true;
+
+	if (!io->direct)
+		return true;
+
+	if (io->direct_used)
+		success = io_buffered_write(io, io->direct_pos, io->direct_buf,
+					    io->direct_used);
+
+	io_free_direct(io);
+	return success;
+}
+
+static bool io_open_direct(struct ffmpeg_mux *ffm)
+{
+	struct io_buffer *io = &ffm->io;
+
+#ifdef _WIN32
+	wchar_t *path = NULL;
+
+	io->direct_handle = INVALID_HANDLE_VALUE;
+	io->direct_buf = _aligned_malloc(DIRECT_BUF_SIZE, DIRECT_ALIGN);
+
+	if (os_utf8_to_wcs_ptr(ffm->params.file, 0, &path)) {
+		io->direct_handle = CreateFileW(
+			path, GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+			NULL, OPEN_EXISTING,
+			FILE_FLAG_NO_BUFFERING | FILE_FLAG_WRITE_THROUGH, NULL);
+		bfree(path);
+	}
+
+	io->direct = io->direct_buf &&
+		     io->direct_handle != INVALID_HANDLE_VALUE;
+#else
+	void *buf = NULL;
+
+	io->direct_buf = NULL;
+	if (posix_memalign(&buf, DIRECT_ALIGN, DIRECT_BUF_SIZE) == 0)
+		io->direct_buf = buf;
+
+#ifdef O_DIRECT
+	io->direct_fd = open(ffm->params.file, O_WRONLY | O_DIRECT);
+#else
+	io->direct_fd = open(ffm->params.file, O_WRONLY);
+#ifdef F_NOCACHE
+	if (io->direct_fd != -1)
+		fcntl(io->direct_fd, F_NOCACHE, 1);
+#endif
+#endif
+
+	io->direct = io->direct_buf && io->direct_fd != -1;
+#endif
+
+	if (!io->direct) {
+		fprintf(stderr, "Couldn't open '%s' for direct writes, "
+				"using buffered writes\n",
+			ffm->params.printable_file.array);
+		io_free_direct(io);
+		return false;
+	}
+
+	io->direct_used = 0;
+	io->direct_pos = 0;
+	return true;
+}
+
+/* reserves space for the whole recording up front so the file isn't
+ * fragmented, without changing its size */
+static void io_preallocate(struct ffmpeg_mux *ffm, int64_t size)
+{
+#ifdef _WIN32
+	HANDLE h = (HANDLE)_get_osfhandle(_fileno(ffm->io.output_file));
+	FILE_ALLOCATION_INFO info;
+
+	info.AllocationSize.QuadPart = size;
+	if (!SetFileInformationByHandle(h, FileAllocationInfo, &info,
+					sizeof(info)))
+		fprintf(stderr, "Failed to preallocate '%s': %lu\n",
+			ffm->params.printable_file.array, GetLastError());
+#elif defined(__linux__)
+	int fd = fileno(ffm->io.output_file);
+
+	if (fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, (off_t)size) != 0)
+		fprintf(stderr, "Failed to preallocate '%s': %s\n",
+			ffm->params.printable_file.array, strerror(errno));
+#elif defined(F_PREALLOCATE)
+	int fd = fileno(ffm->io.output_file);
+	fstore_t store = {F_ALLOCATECONTIG, F_PEOFPOSMODE, 0, size, 0};
+
+	if (fcntl(fd, F_PREALLOCATE, &store) == -1) {
+		store.fst_flags = F_ALLOCATEALL;
+		if (fcntl(fd, F_PREALLOCATE, &store) == -1)
+			fprintf(stderr, "Failed to preallocate '%s': %s\n",
+				ffm->params.printable_file.array,
+				strerror(errno));
+	}
+#else
+	UNUSED_PARAMETER(ffm);
+	UNUSED_PARAMETER(size);
+#endif
+}
+
+static bool io_direct_append(struct io_buffer *io, const uint8_t *data,
+			     size_t size)
+{
+	while (size) {
+		size_t n = DIRECT_BUF_SIZE - io->direct_used;
+		if (n > size)
+			n = size;
+
+		memcpy(io->direct_buf + io->direct_used, data, n);
+		io->direct_used += n;
+		data += n;
+		size -= n;
+
+		if (io->direct_used < CHUNK_SIZE)
+			continue;
+
+		if (!io_direct_write_block(io, io->direct_pos, io->direct_buf,
+					   CHUNK_SIZE))
+			return false;
+
+		io->direct_used -= CHUNK_SIZE;
+		io->direct_pos += CHUNK_SIZE;
+		memmove(io->direct_buf, io->direct_buf + CHUNK_SIZE,
+			io->direct_used);
+	}
+
+	return true;
+}
+
+/* writes at io->write_pos and advances it */
+static bool io_write(struct io_buffer *io, const uint8_t *data, size_t size)
+{
+	uint64_t offset = io->write_pos;
+	uint64_t end = io->direct_pos + io->direct_used;
+
+	io->write_pos += size;
+
+	if (!io->direct)
+		return io_buffered_write(io, offset, data, size);
+
+	/* already written out */
+	if (offset < io->direct_pos) {
+		size_t n = (size_t)(io->direct_pos - offset);
+		if (n > size)
+			n = size;
+
+		if (!io_buffered_write(io, offset, data, n))
+			return false;
+
+		offset += n;
+		data += n;
+		size -= n;
+	}
+
+	/* still pending */
+	if (size && offset < end) {
+		size_t n = (size_t)(end - offset);
+		if (n > size)
+			n = size;
+
+		memcpy(io->direct_buf + (offset - io->direct_pos), data, n);
+		offset += n;
+		data += n;
+		size -= n;
+	}
+
+	if (!size)
+		return true;
+	if (offset == end)
+		return io_direct_append(io, data, size);
+
+	/* skipping ahead would need zero filling, not worth it for the
+	 * muxers that do it */
+	return io_stop_direct(io) && io_buffered_write(io, offset, data, size);
+}
+
 static void *ffmpeg_mux_io_thread(void *data)
 {
 	struct ffmpeg_mux *ffm = data;
@@ -778,8 +1107,7 @@ static void *ffmpeg_mux_io_thread(void *data)
 
 			// Seek if we need to
 			if (want_seek) {
-				os_fseeki64(ffm->io.output_file,
-					    next_seek_position, SEEK_SET);
+				ffm->io.write_pos = next_seek_position;
 
 				// Update the next virtual position, making sure to take
 				// into account the size of the chunk we're about to write.
@@ -790,8 +1118,7 @@ static void *ffmpeg_mux_io_thread(void *data)
 			}
 
 			// Write the current chunk to the output file
-			if (fwrite(chunk, chunk_used, 1, ffm->io.output_file) !=
-			    1) {
+			if (!io_write(&ffm->io, chunk, chunk_used)) {
 				os_atomic_set_bool(&ffm->io.output_error, true);
 				fprintf(stderr, "Error writing to '%s', %s\n",
 					ffm->params.printable_file.array,
@@ -812,6 +1139,12 @@ error:
 	if (chunk)
 		free(chunk);
 
+	if (!io_stop_direct(&ffm->io)) {
+		os_atomic_set_bool(&ffm->io.output_error, true);
+		fprintf(stderr, "Error writing to '%s', %s\n",
+			ffm->params.printable_file.array, strerror(errno));
+	}
+
 	fclose(ffm->io.output_file);
 	return NULL;
 }
@@ -920,6 +1253,14 @@ static inline int open_output_file(struct ffmpeg_mux *ffm)
 				return FFM_ERROR;
 			}
 
+			ffm->io.file_pos = 0;
+			ffm->io.write_pos = 0;
+
+			if (ffm->params.preallocate > 0)
+				io_preallocate(ffm, ffm->params.preallocate);
+			if (ffm->params.direct_io)
+				io_open_direct(ffm);
+
 			// Start at 1MB, this can grow up to 256 MB depending
 			// how fast data is going in and out (limited in
 			// ffmpeg_mux_write_av_buffer)
@@ -1009,7 +1350,9 @@ static int ffmpeg_mux_init_context(struct ffmpeg_mux *ffm)
 		avformat_network_init();
 	}
 
-	if (is_network && !is_http)
+	if (ffm->params.format && *ffm->params.format)
+		output_format = av_guess_format(ffm->params.format, NULL, NULL);
+	else if (is_network && !is_http)
 		output_format = av_guess_format("mpegts", NULL, "video/M2PT");
 	else
 		output_format = av_guess_format(NULL, ffm->params.file, NULL);
@@ -1177,9 +1520,134 @@ static inline bool ffmpeg_mux_packet(struct ffmpeg_mux *ffm, uint8_t *buf,
 	return ret >= 0;
 }
 
-static inline bool read_change_file(struct ffmpeg_mux *ffm, uint32_t size,
-				    struct resize_buf *filename, int argc,
-				    char **argv)
+/* ------------------------------------------------------------------------- */
+/* Changing files writes the old file's trailer and flushes its I/O on a
+ * separate thread, so the next file's packets keep being read meanwhile
+ * instead of backing up the pipe.  The trailer of a long MP4 recording
+ * alone can take a noticeable amount of time to write. */
+
+static void *finish_file_thread(void *data)
+{
+	struct ffmpeg_mux *ffm = data;
+
+	os_set_thread_name("ffmpeg-mux: finish file");
+	ffmpeg_mux_free(ffm);
+	free(ffm);
+	return NULL;
+}
+
+static void finisher_wait(struct file_finisher *finisher)
+{
+	if (finisher->active) {
+		pthread_join(finisher->thread, NULL);
+		finisher->active = false;
+	}
+}
+
+/* takes ownership of ffm, which must have been allocated with malloc */
+static void finish_file(struct file_finisher *finisher, struct ffmpeg_mux *ffm)
+{
+	/* one file finishes at a time, with splits minutes apart the
+	 * previous one is long done by now */
+	finisher_wait(finisher);
+
+	if (pthread_create(&finisher->thread, NULL, finish_file_thread, ffm) ==
+	    0)
+		finisher->active = true;
+	else
+		finish_file_thread(ffm);
+}
+
+#ifdef FFMPEG_MUX_LIBRARY
+static void free_lib_headers(struct ffmpeg_mux_lib *lib)
+{
+	for (int i = 0; i < lib->num_headers; i++)
+		header_free(&lib->headers[i]);
+	lib->num_headers = 0;
+}
+
+/* takes the same arguments as the ffmpeg-mux executable, the muxer is set
+ * up once the headers have been passed to ffmpeg_mux_lib_packet */
+struct ffmpeg_mux_lib *ffmpeg_mux_lib_open(int argc, char **argv)
+{
+	struct ffmpeg_mux_lib *lib;
+
+	if (argc < 4)
+		return NULL;
+
+	lib = calloc(1, sizeof(*lib));
+	lib->ffm = calloc(1, sizeof(*lib->ffm));
+	lib->argc = argc;
+	lib->argv = calloc(argc, sizeof(char *));
+	for (int i = 0; i < argc; i++)
+		lib->argv[i] = strdup(argv[i]);
+
+	lib->expected_headers = (atoi(argv[2]) ? 1 : 0) + atoi(argv[3]);
+	if (lib->expected_headers < 1)
+		lib->expected_headers = 1;
+
+	lib->headers = calloc(lib->expected_headers, sizeof(*lib->headers));
+	lib->header_info =
+		calloc(lib->expected_headers, sizeof(*lib->header_info));
+	return lib;
+}
+
+int ffmpeg_mux_lib_packet(struct ffmpeg_mux_lib *lib, uint8_t *data,
+			  struct ffm_packet_info *info)
+{
+	int ret;
+
+	if (lib->ffm->initialized)
+		return ffmpeg_mux_packet(lib->ffm, data, info) ? FFM_SUCCESS
+								: FFM_ERROR;
+
+	set_header(&lib->headers[lib->num_headers], data, info->size);
+	lib->header_info[lib->num_headers++] = *info;
+
+	if (lib->num_headers < lib->expected_headers)
+		return FFM_SUCCESS;
+
+	lib->ffm->lib = lib;
+	lib->next_header = 0;
+	ret = ffmpeg_mux_init(lib->ffm, lib->argc, lib->argv);
+	free_lib_headers(lib);
+	return ret;
+}
+
+/* finishes the current file, the next one starts with its headers */
+void ffmpeg_mux_lib_change_file(struct ffmpeg_mux_lib *lib, const char *file)
+{
+	finish_file(&lib->finisher, lib->ffm);
+	lib->ffm = calloc(1, sizeof(*lib->ffm));
+	free_lib_headers(lib);
+
+	free(lib->argv[1]);
+	lib->argv[1] = strdup(file);
+}
+
+void ffmpeg_mux_lib_close(struct ffmpeg_mux_lib *lib)
+{
+	if (!lib)
+		return;
+
+	ffmpeg_mux_free(lib->ffm);
+	free(lib->ffm);
+	finisher_wait(&lib->finisher);
+	free_lib_headers(lib);
+	free(lib->headers);
+	free(lib->header_info);
+
+	for (int i = 0; i < lib->argc; i++)
+		free(lib->argv[i]);
+	free(lib->argv);
+	free(lib);
+}
+
+#else
+static inline bool read_change_file(struct ffmpeg_mux **ffm,
+				    struct file_finisher *finisher,
+				    uint32_t size, struct resize_buf *filename,
+				    int argc, char **argv)
 {
 	resize_buf_resize(filename, size + 1);
 	if (safe_read(filename->buf, size) != size) {
@@ -1195,9 +1663,10 @@ static inline bool read_change_file(struct ffmpeg_mux *ffm, uint32_t size,
 	char *argv1_backup = argv[1];
 	argv[1] = (char *)filename->buf;
 
-	ffmpeg_mux_free(ffm);
+	finish_file(finisher, *ffm);
+	*ffm = calloc(1, sizeof(**ffm));
 
-	ret = ffmpeg_mux_init(ffm, argc, argv);
+	ret = ffmpeg_mux_init(*ffm, argc, argv);
 	if (ret != FFM_SUCCESS) {
 		fprintf(stderr, "Couldn't initialize muxer\n");
 		return false;
@@ -1208,6 +1677,49 @@ static inline bool read_change_file(struct ffmpeg_mux *ffm, uint32_t size,
 	return true;
 }
 
+static inline bool read_shm_init(struct ffm_shm **shm, uint32_t size,
+				 struct resize_buf *name)
+{
+	resize_buf_resize(name, size + 1);
+	if (safe_read(name->buf, size) != size) {
+		return false;
+	}
+	name->buf[size] = 0;
+
+	/* the parent keeps using the pipe until attached is set, so this
+	 * isn't fatal */
+	*shm = ffm_shm_open((const char *)name->buf);
+	if (!*shm) {
+		fprintf(stderr, "Failed to open shared memory '%s'\n",
+			name->buf);
+		return true;
+	}
+
+	os_atomic_set_long(&ffm_shm_header(*shm)->attached, 1);
+	return true;
+}
+
+static inline bool read_shared_packet(struct ffmpeg_mux *ffm,
+				      struct ffm_shm *shm,
+				      struct ffm_packet_info *info)
+{
+	uint32_t offset = info->shm_pos & (FFM_SHM_RING_SIZE - 1);
+	bool success;
+
+	if (!shm || info->size > FFM_SHM_RING_SIZE - offset) {
+		fprintf(stderr, "Invalid shared packet\n");
+		return false;
+	}
+
+	uint8_t *data = ffm_shm_data(shm) + offset;
+	success = ffmpeg_mux_packet(ffm, data, info);
+
+	/* the muxer copies what it keeps for interleaving */
+	os_atomic_set_long(&ffm_shm_header(shm)->read_pos,
+			   (long)(info->shm_pos + info->size));
+	return success;
+}
+
 /* ------------------------------------------------------------------------- */
 
 #ifdef _WIN32
@@ -1217,9 +1729,11 @@ int main(int argc, char *argv[])
 #endif
 {
 	struct ffm_packet_info info = {0};
-	struct ffmpeg_mux ffm = {0};
+	struct ffmpeg_mux *ffm = calloc(1, sizeof(*ffm));
+	struct file_finisher finisher = {0};
 	struct resize_buf rb = {0};
 	struct resize_buf rb_filename = {0};
+	struct ffm_shm *shm = NULL;
 	bool fail = false;
 	int ret;
 
@@ -1245,7 +1759,7 @@ int main(int argc, char *argv[])
 #endif
 	setvbuf(stderr, NULL, _IONBF, 0);
 
-	ret = ffmpeg_mux_init(&ffm, argc, argv);
+	ret = ffmpeg_mux_init(ffm, argc, argv);
 	if (ret != FFM_SUCCESS) {
 		fprintf(stderr, "Couldn't initialize muxer\n");
 		return ret;
@@ -1253,21 +1767,34 @@ int main(int argc, char *argv[])
 
 	while (!fail && safe_read(&info, sizeof(info)) == sizeof(info)) {
 		if (info.type == FFM_PACKET_CHANGE_FILE) {
-			fail = !read_change_file(&ffm, info.size, &rb_filename,
-						 argc, argv);
+			fail = !read_change_file(&ffm, &finisher, info.size,
+						 &rb_filename, argc, argv);
+			continue;
+		}
+
+		if (info.type == FFM_PACKET_SHM_INIT) {
+			fail = !read_shm_init(&shm, info.size, &rb_filename);
+			continue;
+		}
+
+		if (info.shared) {
+			fail = !read_shared_packet(ffm, shm, &info);
 			continue;
 		}
 
 		resize_buf_resize(&rb, info.size);
 
 		if (safe_read(rb.buf, info.size) == info.size) {
-			fail = !ffmpeg_mux_packet(&ffm, rb.buf, &info);
+			fail = !ffmpeg_mux_packet(ffm, rb.buf, &info);
 		} else {
 			fail = true;
 		}
 	}
 
-	ffmpeg_mux_free(&ffm);
+	ffmpeg_mux_free(ffm);
+	free(ffm);
+	finisher_wait(&finisher);
+	ffm_shm_close(shm);
 	resize_buf_free(&rb);
 	resize_buf_free(&rb_filename);
 
@@ -1278,3 +1805,4 @@ int main(int argc, char *argv[])
 #endif
 	return 0;
 }
+#endif
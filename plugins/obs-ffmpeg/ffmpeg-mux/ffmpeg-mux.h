@@ -17,12 +17,14 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 enum ffm_packet_type {
 	FFM_PACKET_VIDEO,
 	FFM_PACKET_AUDIO,
 	FFM_PACKET_CHANGE_FILE,
+	FFM_PACKET_SHM_INIT,
 };
 
 #define FFM_SUCCESS 0
@@ -36,4 +38,41 @@ struct ffm_packet_info {
 	uint32_t index;
 	enum ffm_packet_type type;
 	bool keyframe;
+	bool shared;
+	uint32_t shm_pos;
 };
+
+/* Packet data can go through a shared memory ring instead of the pipe.
+ * The parent sends FFM_PACKET_SHM_INIT with the name of the mapping, and
+ * once the child has mapped it and set attached, packets with shared set
+ * have their data at shm_pos in the ring instead of after the info
+ * structure.  Positions only ever increase and wrap at 2^32, the ring size
+ * is a power of two so they map to offsets directly.  The child sets
+ * read_pos to the end of each packet once it's done with it. */
+#define FFM_SHM_RING_SIZE (64 * 1024 * 1024)
+#define FFM_SHM_DATA_OFFSET 64
+
+struct ffm_shm_header {
+	volatile long attached;
+	volatile long read_pos;
+};
+
+struct ffm_shm;
+
+extern struct ffm_shm *ffm_shm_create(char *name, size_t name_size);
+extern struct ffm_shm *ffm_shm_open(const char *name);
+extern void ffm_shm_close(struct ffm_shm *shm);
+extern struct ffm_shm_header *ffm_shm_header(struct ffm_shm *shm);
+extern uint8_t *ffm_shm_data(struct ffm_shm *shm);
+
+/* the muxer built into obs-ffmpeg, for outputs that don't use a separate
+ * ffmpeg-mux process.  argv is the ffmpeg-mux command line, and packets
+ * are passed in the same order they'd be sent through the pipe. */
+struct ffmpeg_mux_lib;
+
+extern struct ffmpeg_mux_lib *ffmpeg_mux_lib_open(int argc, char **argv);
+extern int ffmpeg_mux_lib_packet(struct ffmpeg_mux_lib *lib, uint8_t *data,
+				 struct ffm_packet_info *info);
+extern void ffmpeg_mux_lib_change_file(struct ffmpeg_mux_lib *lib,
+				       const char *file);
+extern void ffmpeg_mux_lib_close(struct ffmpeg_mux_lib *lib);
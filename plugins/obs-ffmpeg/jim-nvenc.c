@@ -2,6 +2,7 @@
 #include <util/circlebuf.h>
 #include <util/darray.h>
 #include <util/dstr.h>
+#include <util/threading.h>
 #include <obs-avc.h>
 #include <libavutil/rational.h>
 #define INITGUID
@@ -21,6 +22,12 @@
 
 #define EXTRA_BUFFERS 5
 
+/* how long the retrieval thread waits on a completion event before checking
+ * whether the encoder is being torn down, and how many such waits it allows
+ * itself once it is */
+#define ASYNC_WAIT_MS 100
+#define ASYNC_DRAIN_WAITS 10
+
 #define do_log(level, format, ...)               \
 	blog(level, "[jim-nvenc: '%s'] " format, \
 	     obs_encoder_get_name(enc->encoder), ##__VA_ARGS__)
@@ -73,6 +80,20 @@ struct nvenc_data {
 	int64_t packet_pts;
 	bool packet_keyframe;
 
+	/* async mode: submitted frames are retrieved by retrieve_thread, which
+	 * pushes finished encoder_packets to ready_packets */
+	bool async;
+	bool retrieve_thread_active;
+	pthread_t retrieve_thread;
+	os_sem_t *retrieve_sem;
+	os_event_t *ready_event;
+	pthread_mutex_t ready_mutex;
+	struct circlebuf ready_packets;
+	size_t retrieve_bitstream;
+	volatile long submitted;
+	volatile bool retrieve_stop;
+	volatile bool retrieve_failed;
+
 	ID3D11Device *device;
 	ID3D11DeviceContext *context;
 
@@ -91,6 +112,7 @@ struct nvenc_data {
 
 struct nv_bitstream {
 	void *ptr;
+	HANDLE event;
 };
 
 #define NV_FAIL(format, ...) nv_fail(enc->encoder, format, __VA_ARGS__)
@@ -106,11 +128,42 @@ static bool nv_bitstream_init(struct nvenc_data *enc, struct nv_bitstream *bs)
 	}
 
 	bs->ptr = buf.bitstreamBuffer;
+	bs->event = NULL;
+
+	if (enc->async) {
+		NV_ENC_EVENT_PARAMS params = {NV_ENC_EVENT_PARAMS_VER};
+
+		bs->event = CreateEvent(NULL, FALSE, FALSE, NULL);
+		if (!bs->event) {
+			error("Failed to create completion event");
+			goto fail;
+		}
+
+		params.completionEvent = bs->event;
+		if (NV_FAILED(nv.nvEncRegisterAsyncEvent(enc->session,
+							 &params))) {
+			CloseHandle(bs->event);
+			bs->event = NULL;
+			goto fail;
+		}
+	}
+
 	return true;
+
+fail:
+	nv.nvEncDestroyBitstreamBuffer(enc->session, bs->ptr);
+	bs->ptr = NULL;
+	return false;
 }
 
 static void nv_bitstream_free(struct nvenc_data *enc, struct nv_bitstream *bs)
 {
+	if (bs->event) {
+		NV_ENC_EVENT_PARAMS params = {NV_ENC_EVENT_PARAMS_VER};
+		params.completionEvent = bs->event;
+		nv.nvEncUnregisterAsyncEvent(enc->session, &params);
+		CloseHandle(bs->event);
+	}
 	if (bs->ptr) {
 		nv.nvEncDestroyBitstreamBuffer(enc->session, bs->ptr);
 	}
@@ -455,6 +508,7 @@ static bool init_encoder_h264(struct nvenc_data *enc, obs_data_t *settings,
 	initialize_params(&enc->params, &NV_ENC_CODEC_H264_GUID, &nv_preset,
 			  voi->width, voi->height, voi->fps_num, voi->fps_den,
 			  &enc->config);
+	enc->params.enableEncodeAsync = enc->async;
 	config->gopLength = gop_size;
 	config->frameIntervalP = 1 + bf;
 	h264_config->idrPeriod = gop_size;
@@ -714,6 +768,7 @@ static bool init_encoder_hevc(struct nvenc_data *enc, obs_data_t *settings,
 	initialize_params(&enc->params, &NV_ENC_CODEC_HEVC_GUID, &nv_preset,
 			  voi->width, voi->height, voi->fps_num, voi->fps_den,
 			  &enc->config);
+	enc->params.enableEncodeAsync = enc->async;
 	config->gopLength = gop_size;
 	config->frameIntervalP = 1 + bf;
 	hevc_config->idrPeriod = gop_size;
@@ -923,6 +978,221 @@ static bool init_textures(struct nvenc_data *enc)
 	return true;
 }
 
+/* ------------------------------------------------------------------------- */
+/* Async Bitstream Retrieval                                                 */
+
+/* on the first packet, splits the headers and SEI off into enc->header and
+ * enc->sei, returning the rest of the packet data, which must be freed */
+static uint8_t *extract_first_packet(struct nvenc_data *enc,
+				     const NV_ENC_LOCK_BITSTREAM *lock,
+				     size_t *size)
+{
+	uint8_t *new_packet;
+
+	enc->first_packet = false;
+#ifdef ENABLE_HEVC
+	if (enc->hevc) {
+		obs_extract_hevc_headers(lock->bitstreamBufferPtr,
+					 lock->bitstreamSizeInBytes,
+					 &new_packet, size, &enc->header,
+					 &enc->header_size, &enc->sei,
+					 &enc->sei_size);
+	} else
+#endif
+	{
+		obs_extract_avc_headers(lock->bitstreamBufferPtr,
+					lock->bitstreamSizeInBytes, &new_packet,
+					size, &enc->header, &enc->header_size,
+					&enc->sei, &enc->sei_size);
+	}
+
+	return new_packet;
+}
+
+static bool wait_for_bitstream(struct nvenc_data *enc, struct nv_bitstream *bs)
+{
+	int drain_waits = 0;
+
+	for (;;) {
+		DWORD ret = WaitForSingleObject(bs->event, ASYNC_WAIT_MS);
+		if (ret == WAIT_OBJECT_0)
+			return true;
+
+		if (ret != WAIT_TIMEOUT) {
+			error("Failed to wait on completion event");
+			return false;
+		}
+		if (os_atomic_load_bool(&enc->retrieve_stop) &&
+		    ++drain_waits == ASYNC_DRAIN_WAITS) {
+			warn("Timed out draining encoded frames");
+			return false;
+		}
+	}
+}
+
+static bool retrieve_bitstream(struct nvenc_data *enc)
+{
+	struct nv_bitstream *bs =
+		&enc->bitstreams.array[enc->retrieve_bitstream];
+	struct encoder_packet pkt = {0};
+	void *s = enc->session;
+
+	if (!wait_for_bitstream(enc, bs))
+		return false;
+
+	NV_ENC_LOCK_BITSTREAM lock = {NV_ENC_LOCK_BITSTREAM_VER};
+	lock.outputBitstream = bs->ptr;
+	lock.doNotWait = false;
+
+	if (NV_FAILED(nv.nvEncLockBitstream(s, &lock))) {
+		return false;
+	}
+
+	if (enc->first_packet) {
+		size_t size;
+		uint8_t *new_packet = extract_first_packet(enc, &lock, &size);
+
+		memcpy(obs_encoder_packet_alloc(&pkt, size), new_packet, size);
+		bfree(new_packet);
+	} else {
+		memcpy(obs_encoder_packet_alloc(&pkt,
+						lock.bitstreamSizeInBytes),
+		       lock.bitstreamBufferPtr, lock.bitstreamSizeInBytes);
+	}
+
+	pkt.pts = (int64_t)lock.outputTimeStamp;
+	pkt.keyframe = lock.pictureType == NV_ENC_PIC_TYPE_IDR;
+
+	if (NV_FAILED(nv.nvEncUnlockBitstream(s, bs->ptr))) {
+		obs_encoder_packet_release(&pkt);
+		return false;
+	}
+
+	if (++enc->retrieve_bitstream == enc->buf_count)
+		enc->retrieve_bitstream = 0;
+
+	pthread_mutex_lock(&enc->ready_mutex);
+	circlebuf_push_back(&enc->ready_packets, &pkt, sizeof(pkt));
+	pthread_mutex_unlock(&enc->ready_mutex);
+
+	os_event_signal(enc->ready_event);
+	return true;
+}
+
+static void *retrieve_thread(void *data)
+{
+	struct nvenc_data *enc = data;
+	long retrieved = 0;
+
+	os_set_thread_name("jim-nvenc: bitstream retrieval");
+
+	while (os_sem_wait(enc->retrieve_sem) == 0) {
+		/* the stop post comes after every submitted frame's post, so
+		 * nothing left to retrieve means everything has been */
+		if (retrieved == os_atomic_load_long(&enc->submitted)) {
+			if (os_atomic_load_bool(&enc->retrieve_stop))
+				break;
+			continue;
+		}
+
+		if (!retrieve_bitstream(enc)) {
+			os_atomic_set_bool(&enc->retrieve_failed, true);
+			os_event_signal(enc->ready_event);
+			break;
+		}
+
+		retrieved++;
+	}
+
+	return NULL;
+}
+
+static bool start_retrieve_thread(struct nvenc_data *enc)
+{
+	if (pthread_mutex_init(&enc->ready_mutex, NULL) != 0)
+		return false;
+	if (os_sem_init(&enc->retrieve_sem, 0) != 0)
+		return false;
+	if (os_event_init(&enc->ready_event, OS_EVENT_TYPE_AUTO) != 0)
+		return false;
+	if (pthread_create(&enc->retrieve_thread, NULL, retrieve_thread,
+			   enc) != 0) {
+		error("Failed to create bitstream retrieval thread");
+		return false;
+	}
+
+	enc->retrieve_thread_active = true;
+	return true;
+}
+
+/* the retrieval thread drains whatever has been submitted before exiting,
+ * so this must come after the EOS picture has been sent */
+static void stop_retrieve_thread(struct nvenc_data *enc)
+{
+	if (enc->retrieve_thread_active) {
+		os_atomic_set_bool(&enc->retrieve_stop, true);
+		os_sem_post(enc->retrieve_sem);
+		pthread_join(enc->retrieve_thread, NULL);
+		enc->retrieve_thread_active = false;
+	}
+
+	while (enc->ready_packets.size) {
+		struct encoder_packet pkt;
+		circlebuf_pop_front(&enc->ready_packets, &pkt, sizeof(pkt));
+		obs_encoder_packet_release(&pkt);
+	}
+}
+
+/* takes the oldest retrieved packet, if there is one, and unmaps the surface
+ * it was encoded from.  when every surface is in flight, this waits for one
+ * to come back so the next frame has somewhere to go. */
+static bool pop_ready_packet(struct nvenc_data *enc,
+			     struct encoder_packet *pkt, bool *have_packet)
+{
+	const bool wait = enc->buffers_queued == enc->buf_count;
+
+	for (;;) {
+		pthread_mutex_lock(&enc->ready_mutex);
+		if (enc->ready_packets.size) {
+			circlebuf_pop_front(&enc->ready_packets, pkt,
+					    sizeof(*pkt));
+			*have_packet = true;
+		}
+		pthread_mutex_unlock(&enc->ready_mutex);
+
+		if (*have_packet || !wait)
+			break;
+		if (os_atomic_load_bool(&enc->retrieve_failed))
+			return false;
+
+		os_event_wait(enc->ready_event);
+	}
+
+	if (!*have_packet)
+		return true;
+
+	struct nv_texture *nvtex = &enc->textures.array[enc->cur_bitstream];
+	if (nvtex->mapped_res) {
+		NVENCSTATUS err;
+		err = nv.nvEncUnmapInputResource(enc->session,
+						 nvtex->mapped_res);
+		nvtex->mapped_res = NULL;
+		if (nv_failed(enc->encoder, err, __FUNCTION__, "unmap")) {
+			obs_encoder_packet_release(pkt);
+			*have_packet = false;
+			return false;
+		}
+	}
+
+	if (++enc->cur_bitstream == enc->buf_count)
+		enc->cur_bitstream = 0;
+
+	enc->buffers_queued--;
+	return true;
+}
+
+/* ------------------------------------------------------------------------- */
+
 static void nvenc_destroy(void *data);
 
 static bool init_specific_encoder(struct nvenc_data *enc, bool hevc,
@@ -979,6 +1249,15 @@ static bool init_encoder(struct nvenc_data *enc, bool hevc,
 		return false;
 	}
 
+#ifdef ENABLE_HEVC
+	enc->async = hevc ? nv_get_cap_hevc(enc,
+					    NV_ENC_CAPS_ASYNC_ENCODE_SUPPORT)
+			  : nv_get_cap_h264(enc,
+					    NV_ENC_CAPS_ASYNC_ENCODE_SUPPORT);
+#else
+	enc->async = nv_get_cap_h264(enc, NV_ENC_CAPS_ASYNC_ENCODE_SUPPORT);
+#endif
+
 	if (!init_specific_encoder(enc, hevc, settings, bf, psycho_aq)) {
 		if (!psycho_aq)
 			return false;
@@ -1003,6 +1282,7 @@ static void *nvenc_create_internal(bool hevc, obs_data_t *settings,
 	struct nvenc_data *enc = bzalloc(sizeof(*enc));
 	enc->encoder = encoder;
 	enc->first_packet = true;
+	pthread_mutex_init_value(&enc->ready_mutex);
 
 	if (!init_nvenc(encoder)) {
 		goto fail;
@@ -1025,6 +1305,9 @@ static void *nvenc_create_internal(bool hevc, obs_data_t *settings,
 	if (!init_textures(enc)) {
 		goto fail;
 	}
+	if (enc->async && !start_retrieve_thread(enc)) {
+		goto fail;
+	}
 
 #ifdef ENABLE_HEVC
 	enc->hevc = hevc;
@@ -1098,9 +1381,16 @@ static void nvenc_destroy(void *data)
 
 		NV_ENC_PIC_PARAMS params = {NV_ENC_PIC_PARAMS_VER};
 		params.encodePicFlags = NV_ENC_PIC_FLAG_EOS;
+		if (enc->async) {
+			/* async mode requires an event even for EOS */
+			params.completionEvent =
+				enc->bitstreams.array[next_bitstream].event;
+		}
 		nv.nvEncEncodePicture(enc->session, &params);
-		get_encoded_packet(enc, true);
+		if (!enc->async)
+			get_encoded_packet(enc, true);
 	}
+	stop_retrieve_thread(enc);
 	for (size_t i = 0; i < enc->textures.num; i++) {
 		nv_texture_free(enc, &enc->textures.array[i]);
 	}
@@ -1126,6 +1416,10 @@ static void nvenc_destroy(void *data)
 	bfree(enc->header);
 	bfree(enc->sei);
 	circlebuf_free(&enc->dts_list);
+	circlebuf_free(&enc->ready_packets);
+	os_event_destroy(enc->ready_event);
+	os_sem_destroy(enc->retrieve_sem);
+	pthread_mutex_destroy(&enc->ready_mutex);
 	da_free(enc->textures);
 	da_free(enc->bitstreams);
 	da_free(enc->input_textures);
@@ -1206,26 +1500,9 @@ static bool get_encoded_packet(struct nvenc_data *enc, bool finalize)
 		}
 
 		if (enc->first_packet) {
-			uint8_t *new_packet;
 			size_t size;
-
-			enc->first_packet = false;
-#ifdef ENABLE_HEVC
-			if (enc->hevc) {
-				obs_extract_hevc_headers(
-					lock.bitstreamBufferPtr,
-					lock.bitstreamSizeInBytes, &new_packet,
-					&size, &enc->header, &enc->header_size,
-					&enc->sei, &enc->sei_size);
-			} else
-#endif
-			{
-				obs_extract_avc_headers(
-					lock.bitstreamBufferPtr,
-					lock.bitstreamSizeInBytes, &new_packet,
-					&size, &enc->header, &enc->header_size,
-					&enc->sei, &enc->sei_size);
-			}
+			uint8_t *new_packet =
+				extract_first_packet(enc, &lock, &size);
 
 			da_copy_array(enc->packet_data, new_packet, size);
 			bfree(new_packet);
@@ -1277,6 +1554,8 @@ static bool nvenc_encode_tex(void *data, uint32_t handle, int64_t pts,
 	IDXGIKeyedMutex *km;
 	struct nv_texture *nvtex;
 	struct nv_bitstream *bs;
+	struct encoder_packet ready = {0};
+	bool have_ready = false;
 	NVENCSTATUS err;
 
 	if (handle == GS_INVALID_HANDLE) {
@@ -1285,6 +1564,11 @@ static bool nvenc_encode_tex(void *data, uint32_t handle, int64_t pts,
 		return false;
 	}
 
+	if (enc->async && !pop_ready_packet(enc, &ready, &have_ready)) {
+		*next_key = lock_key;
+		return false;
+	}
+
 	bs = &enc->bitstreams.array[enc->next_bitstream];
 	nvtex = &enc->textures.array[enc->next_bitstream];
 
@@ -1292,6 +1576,7 @@ static bool nvenc_encode_tex(void *data, uint32_t handle, int64_t pts,
 	output_tex = nvtex->tex;
 
 	if (!input_tex) {
+		obs_encoder_packet_release(&ready);
 		*next_key = lock_key;
 		return false;
 	}
@@ -1314,6 +1599,7 @@ static bool nvenc_encode_tex(void *data, uint32_t handle, int64_t pts,
 	NV_ENC_MAP_INPUT_RESOURCE map = {NV_ENC_MAP_INPUT_RESOURCE_VER};
 	map.registeredResource = nvtex->res;
 	if (NV_FAILED(nv.nvEncMapInputResource(enc->session, &map))) {
+		obs_encoder_packet_release(&ready);
 		return false;
 	}
 
@@ -1330,15 +1616,23 @@ static bool nvenc_encode_tex(void *data, uint32_t handle, int64_t pts,
 				   ? NV_ENC_BUFFER_FORMAT_YUV420_10BIT
 				   : NV_ENC_BUFFER_FORMAT_NV12;
 	params.inputTimeStamp = (uint64_t)pts;
+	uint32_t frame_flags = obs_encoder_get_frame_flags(enc->encoder, NULL);
+	if (frame_flags & VIDEO_FRAME_KEYFRAME)
+		params.encodePicFlags |= NV_ENC_PIC_FLAG_FORCEIDR |
+					 NV_ENC_PIC_FLAG_OUTPUT_SPSPPS;
+	else if (frame_flags & VIDEO_FRAME_SCENE_CUT)
+		params.encodePicFlags |= NV_ENC_PIC_FLAG_FORCEINTRA;
 	params.inputWidth = enc->cx;
 	params.inputHeight = enc->cy;
 	params.inputPitch = enc->cx;
 	params.outputBitstream = bs->ptr;
+	params.completionEvent = bs->event;
 
 	err = nv.nvEncEncodePicture(enc->session, &params);
 	if (err != NV_ENC_SUCCESS && err != NV_ENC_ERR_NEED_MORE_INPUT) {
 		nv_failed(enc->encoder, err, __FUNCTION__,
 			  "nvEncEncodePicture");
+		obs_encoder_packet_release(&ready);
 		return false;
 	}
 
@@ -1349,17 +1643,22 @@ static bool nvenc_encode_tex(void *data, uint32_t handle, int64_t pts,
 		enc->next_bitstream = 0;
 	}
 
+	if (enc->async) {
+		os_atomic_inc_long(&enc->submitted);
+		os_sem_post(enc->retrieve_sem);
+	}
+
 	/* ------------------------------------ */
 	/* check for encoded packet and parse   */
 
-	if (!get_encoded_packet(enc, false)) {
+	if (!enc->async && !get_encoded_packet(enc, false)) {
 		return false;
 	}
 
 	/* ------------------------------------ */
 	/* output encoded packet                */
 
-	if (enc->packet_data.num) {
+	if (have_ready || enc->packet_data.num) {
 		int64_t dts;
 		circlebuf_pop_front(&enc->dts_list, &dts, sizeof(dts));
 
@@ -1367,12 +1666,20 @@ static bool nvenc_encode_tex(void *data, uint32_t handle, int64_t pts,
 		dts -= (int64_t)enc->bframes * packet->timebase_num;
 
 		*received_packet = true;
-		packet->data = enc->packet_data.array;
-		packet->size = enc->packet_data.num;
+		if (have_ready) {
+			packet->data = ready.data;
+			packet->size = ready.size;
+			packet->refcounted = true;
+			packet->pts = ready.pts;
+			packet->keyframe = ready.keyframe;
+		} else {
+			packet->data = enc->packet_data.array;
+			packet->size = enc->packet_data.num;
+			packet->pts = enc->packet_pts;
+			packet->keyframe = enc->packet_keyframe;
+		}
 		packet->type = OBS_ENCODER_VIDEO;
-		packet->pts = enc->packet_pts;
 		packet->dts = dts;
-		packet->keyframe = enc->packet_keyframe;
 	} else {
 		*received_packet = false;
 	}
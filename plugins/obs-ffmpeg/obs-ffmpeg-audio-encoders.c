@@ -48,7 +48,6 @@ struct enc_encoder {
 	AVFrame *aframe;
 	int64_t total_samples;
 
-	DARRAY(uint8_t) packet_buffer;
 
 	size_t audio_planes;
 	size_t audio_size;
@@ -109,7 +108,6 @@ static void enc_destroy(void *data)
 	if (enc->aframe)
 		av_frame_free(&enc->aframe);
 
-	da_free(enc->packet_buffer);
 	bfree(enc);
 }
 
@@ -339,13 +337,12 @@ static bool do_encode(struct enc_encoder *enc, struct encoder_packet *packet,
 	if (!got_packet)
 		return true;
 
-	da_resize(enc->packet_buffer, 0);
-	da_push_back_array(enc->packet_buffer, avpacket.data, avpacket.size);
+	/* write into pooled packet data so libobs doesn't copy it again */
+	memcpy(obs_encoder_packet_alloc(packet, avpacket.size), avpacket.data,
+	       avpacket.size);
 
 	packet->pts = rescale_ts(avpacket.pts, enc->context, time_base);
 	packet->dts = rescale_ts(avpacket.dts, enc->context, time_base);
-	packet->data = enc->packet_buffer.array;
-	packet->size = avpacket.size;
 	packet->type = OBS_ENCODER_AUDIO;
 	packet->timebase_num = 1;
 	packet->timebase_den = (int32_t)enc->context->sample_rate;
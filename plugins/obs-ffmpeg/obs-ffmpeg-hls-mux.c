@@ -43,7 +43,7 @@ void ffmpeg_hls_mux_destroy(void *data)
 		da_free(stream->mux_packets);
 		circlebuf_free(&stream->packets);
 
-		os_process_pipe_destroy(stream->pipe);
+		stop_pipe(stream);
 		dstr_free(&stream->path);
 		dstr_free(&stream->printable_path);
 		dstr_free(&stream->stream_key);
@@ -113,6 +113,36 @@ static void *write_thread(void *data)
 	return NULL;
 }
 
+/* Low latency mode uses FFmpeg's DASH muxer in its LHLS mode instead of
+ * the HLS muxer.  Each segment is written as a series of short CMAF
+ * fragments, the fragments go out over one chunked PUT per segment as
+ * soon as they're muxed, and the playlists carry a prefetch hint for the
+ * segment still being uploaded, so players don't have to wait for whole
+ * segments.  The HLS playlist ends up as master.m3u8 next to the manifest. */
+static void set_low_latency_params(struct ffmpeg_muxer *stream,
+				   struct dstr *path, int keyint_sec,
+				   obs_data_t *settings)
+{
+	int64_t part_ms = obs_data_get_int(settings, "part_duration_ms");
+	const char *ext = os_get_path_extension(path->array);
+
+	if (ext && astrcmpi(ext, ".m3u8") == 0)
+		dstr_resize(path, ext - path->array);
+	dstr_cat(path, ".mpd");
+
+	if (part_ms <= 0)
+		part_ms = 500;
+
+	stream->format_name = "dash";
+	dstr_catf(&stream->muxer_settings,
+		  " streaming=1 lhls=1 hls_playlist=1 ldash=1"
+		  " use_template=1 use_timeline=0 window_size=6"
+		  " frag_type=duration frag_duration=%lld.%03lld"
+		  " seg_duration=%d",
+		  (long long)(part_ms / 1000), (long long)(part_ms % 1000),
+		  keyint_sec ? keyint_sec : 2);
+}
+
 bool ffmpeg_hls_mux_start(void *data)
 {
 	struct ffmpeg_muxer *stream = data;
@@ -145,17 +175,24 @@ bool ffmpeg_hls_mux_start(void *data)
 	vencoder = obs_output_get_video_encoder(stream->output);
 	settings = obs_encoder_get_settings(vencoder);
 	keyint_sec = (int)obs_data_get_int(settings, "keyint_sec");
-	if (keyint_sec) {
+	stream->keyint_sec = keyint_sec;
+	obs_data_release(settings);
+
+	settings = obs_output_get_settings(stream->output);
+	stream->format_name = NULL;
+	if (obs_data_get_bool(settings, "low_latency")) {
+		set_low_latency_params(stream, &path, keyint_sec, settings);
+		info("Using low latency HLS");
+	} else if (keyint_sec) {
 		dstr_catf(&stream->muxer_settings, " hls_time=%d", keyint_sec);
-		stream->keyint_sec = keyint_sec;
 	}
-
 	obs_data_release(settings);
 
+	stream->is_hls = true;
 	start_pipe(stream, path.array);
 	dstr_free(&path);
 
-	if (!stream->pipe) {
+	if (!pipe_started(stream)) {
 		obs_output_set_last_error(
 			stream->output, obs_module_text("HelperProcessFailed"));
 		warn("Failed to create process pipe");
@@ -169,7 +206,6 @@ bool ffmpeg_hls_mux_start(void *data)
 	/* write headers and start capture */
 	os_atomic_set_bool(&stream->active, true);
 	os_atomic_set_bool(&stream->capturing, true);
-	stream->is_hls = true;
 	stream->total_bytes = 0;
 	stream->dropped_frames = 0;
 	stream->min_priority = 0;
@@ -333,6 +369,12 @@ void ffmpeg_hls_mux_data(void *data, struct encoder_packet *packet)
 		obs_encoder_packet_release(&new_packet);
 }
 
+static void ffmpeg_hls_mux_defaults(obs_data_t *settings)
+{
+	obs_data_set_default_bool(settings, "low_latency", false);
+	obs_data_set_default_int(settings, "part_duration_ms", 500);
+}
+
 struct obs_output_info ffmpeg_hls_muxer = {
 	.id = "ffmpeg_hls_muxer",
 	.flags = OBS_OUTPUT_AV | OBS_OUTPUT_ENCODED | OBS_OUTPUT_MULTI_TRACK |
@@ -351,5 +393,6 @@ struct obs_output_info ffmpeg_hls_muxer = {
 	.encoded_packet = ffmpeg_hls_mux_data,
 	.get_total_bytes = ffmpeg_mux_total_bytes,
 	.get_dropped_frames = hls_stream_dropped_frames,
+	.get_defaults = ffmpeg_hls_mux_defaults,
 	.is_ready_to_update = ffmpeg_hls_is_ready_to_update,
 };
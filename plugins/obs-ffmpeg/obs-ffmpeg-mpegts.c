@@ -354,6 +354,95 @@ fail:
 	return err;
 }
 
+/* Encoders emit keyframes as one large burst, which SRT and RIST would
+ * otherwise push out at line rate and overflow the receiver's latency
+ * window.  The stream is paced to at most pacing_peak_ratio times its
+ * average rate, the average being the configured bitrate or the measured
+ * rate, whichever is higher, so the pacer never falls behind the
+ * encoders. */
+
+#define PACING_BURST_NS 2000000ULL
+#define PACING_WINDOW_NS 1000000000ULL
+#define SRT_STATS_INTERVAL_NS 1000000000ULL
+
+static void pace_write(struct ffmpeg_output *stream, int size)
+{
+	uint64_t now = os_gettime_ns();
+	uint64_t elapsed;
+	uint64_t avg_rate;
+	uint64_t peak_rate;
+
+	if (!stream->pacing_window_ns)
+		stream->pacing_window_ns = now;
+
+	stream->pacing_window_bytes += size;
+	elapsed = now - stream->pacing_window_ns;
+
+	if (elapsed >= PACING_WINDOW_NS) {
+		uint64_t rate = stream->pacing_window_bytes * 1000000000ULL /
+				elapsed;
+
+		stream->pacing_measured_rate =
+			stream->pacing_measured_rate
+				? (stream->pacing_measured_rate * 3 + rate) / 4
+				: rate;
+		stream->pacing_window_ns = now;
+		stream->pacing_window_bytes = 0;
+	}
+
+	if (stream->pacing_peak_ratio < 1.0 || stopping(stream))
+		return;
+
+	avg_rate = stream->pacing_min_rate > stream->pacing_measured_rate
+			   ? stream->pacing_min_rate
+			   : stream->pacing_measured_rate;
+	if (!avg_rate)
+		return;
+
+	peak_rate = (uint64_t)((double)avg_rate * stream->pacing_peak_ratio);
+
+	/* don't save up credit while idle, only allow a small burst */
+	if (stream->pacing_next_ns + PACING_BURST_NS < now)
+		stream->pacing_next_ns = now - PACING_BURST_NS;
+	if (stream->pacing_next_ns > now)
+		os_sleepto_ns(stream->pacing_next_ns);
+
+	stream->pacing_next_ns += (uint64_t)size * 1000000000ULL / peak_rate;
+}
+
+static void poll_srt_stats(struct ffmpeg_output *stream)
+{
+	uint64_t now = os_gettime_ns();
+	SRT_TRACEBSTATS perf;
+
+	if (now - stream->srt_stats_ns < SRT_STATS_INTERVAL_NS)
+		return;
+
+	stream->srt_stats_ns = now;
+	if (libsrt_get_stats(stream->h, &perf) < 0)
+		return;
+
+	pthread_mutex_lock(&stream->write_mutex);
+	stream->srt_rtt_ms = perf.msRTT;
+	stream->srt_pkt_retransmitted = perf.pktRetransTotal;
+	stream->srt_send_buffer_bytes = perf.byteSndBuf;
+	stream->srt_send_buffer_ms = perf.msSndBuf;
+	pthread_mutex_unlock(&stream->write_mutex);
+}
+
+static int mpegts_url_write(void *opaque, const uint8_t *buf, int size)
+{
+	struct ffmpeg_output *stream = opaque;
+
+	pace_write(stream, size);
+
+	if (is_rist(stream))
+		return librist_write(stream->h, buf, size);
+
+	poll_srt_stats(stream);
+	return libsrt_write(stream->h, buf, size);
+}
+
 static inline int allocate_custom_aviocontext(struct ffmpeg_output *stream,
 					      bool is_rist)
 {
@@ -369,18 +458,12 @@ static inline int allocate_custom_aviocontext(struct ffmpeg_output *stream,
 	if (!buffer)
 		return AVERROR(ENOMEM);
 	/* allocate custom avio_context */
-	if (is_rist)
-		s = avio_alloc_context(
-			buffer, buffer_size, AVIO_FLAG_WRITE, h, NULL,
-			(int (*)(void *, uint8_t *, int))librist_write, NULL);
-	else
-		s = avio_alloc_context(
-			buffer, buffer_size, AVIO_FLAG_WRITE, h, NULL,
-			(int (*)(void *, uint8_t *, int))libsrt_write, NULL);
+	s = avio_alloc_context(
+		buffer, buffer_size, AVIO_FLAG_WRITE, stream, NULL,
+		(int (*)(void *, uint8_t *, int))mpegts_url_write, NULL);
 	if (!s)
 		goto fail;
 	s->max_packet_size = h->max_packet_size;
-	s->opaque = h;
 	stream->s = s;
 	stream->ff_data.output->pb = s;
 
@@ -521,7 +604,7 @@ static void close_mpegts_url(struct ffmpeg_output *stream, bool is_rist)
 	AVIOContext *s = stream->s;
 	if (!s)
 		return;
-	URLContext *h = s->opaque;
+	URLContext *h = stream->h;
 	if (!h)
 		return; /* can happen when opening the url fails */
 
@@ -532,7 +615,7 @@ static void close_mpegts_url(struct ffmpeg_output *stream, bool is_rist)
 		err = libsrt_close(h);
 	}
 	av_freep(&h->priv_data);
-	av_freep(h);
+	av_freep(&stream->h);
 
 	/* close custom avio_context for srt or rist */
 	avio_flush(stream->s);
@@ -659,6 +742,19 @@ static void ffmpeg_mpegts_log_callback(void *param, int level,
 	UNUSED_PARAMETER(param);
 }
 
+static void get_srt_stats_proc(void *data, calldata_t *cd)
+{
+	struct ffmpeg_output *stream = data;
+
+	pthread_mutex_lock(&stream->write_mutex);
+	calldata_set_float(cd, "rtt_ms", stream->srt_rtt_ms);
+	calldata_set_int(cd, "packets_retransmitted",
+			 stream->srt_pkt_retransmitted);
+	calldata_set_int(cd, "send_buffer_bytes", stream->srt_send_buffer_bytes);
+	calldata_set_int(cd, "send_buffer_ms", stream->srt_send_buffer_ms);
+	pthread_mutex_unlock(&stream->write_mutex);
+}
+
 static void *ffmpeg_mpegts_create(obs_data_t *settings, obs_output_t *output)
 {
 	struct ffmpeg_output *data = bzalloc(sizeof(struct ffmpeg_output));
@@ -674,6 +770,13 @@ static void *ffmpeg_mpegts_create(obs_data_t *settings, obs_output_t *output)
 
 	av_log_set_callback(ffmpeg_mpegts_log_callback);
 
+	proc_handler_t *ph = obs_output_get_proc_handler(output);
+	proc_handler_add(ph,
+			 "void get_srt_stats(out float rtt_ms, "
+			 "out int packets_retransmitted, "
+			 "out int send_buffer_bytes, out int send_buffer_ms)",
+			 get_srt_stats_proc, data);
+
 	UNUSED_PARAMETER(settings);
 	return data;
 
@@ -934,9 +1037,21 @@ static bool set_config(struct ffmpeg_output *stream)
 	settings = obs_output_get_settings(stream->output);
 	obs_data_set_default_string(settings, "muxer_settings", "");
 	config.muxer_settings = obs_data_get_string(settings, "muxer_settings");
+	obs_data_set_default_double(settings, "pacing_peak_ratio", 2.0);
+	stream->pacing_peak_ratio =
+		obs_data_get_double(settings, "pacing_peak_ratio");
 	obs_data_release(settings);
 	config.protocol_settings = "";
 
+	stream->pacing_min_rate =
+		(uint64_t)(config.video_bitrate + config.audio_bitrate) * 1000 /
+		8;
+	stream->pacing_next_ns = 0;
+	stream->pacing_window_ns = 0;
+	stream->pacing_window_bytes = 0;
+	stream->pacing_measured_rate = 0;
+	stream->srt_stats_ns = 0;
+
 	/* 5. unused ffmpeg codec settings */
 	config.video_settings = "";
 	config.audio_settings = "";
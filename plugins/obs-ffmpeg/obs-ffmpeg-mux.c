@@ -17,6 +17,7 @@
 #include "ffmpeg-mux/ffmpeg-mux.h"
 #include "obs-internal.h"
 #include "obs-ffmpeg-mux.h"
+#include "obs-ffmpeg-replay-store.h"
 
 #ifdef _WIN32
 #include "util/windows/win-version.h"
@@ -50,7 +51,7 @@ static inline void replay_buffer_clear(struct ffmpeg_muxer *stream)
 	while (stream->packets.size > 0) {
 		struct encoder_packet pkt;
 		circlebuf_pop_front(&stream->packets, &pkt, sizeof(pkt));
-		obs_encoder_packet_release(&pkt);
+		replay_store_release(stream->store, &pkt);
 	}
 
 	circlebuf_free(&stream->packets);
@@ -59,7 +60,10 @@ static inline void replay_buffer_clear(struct ffmpeg_muxer *stream)
 	stream->max_size = 0;
 	stream->max_time = 0;
 	stream->save_ts = 0;
-	stream->keyframes = 0;
+	stream->save_range = 0;
+	stream->first_seq = 0;
+	stream->next_seq = 0;
+	circlebuf_free(&stream->keyframe_index);
 }
 
 static void ffmpeg_mux_destroy(void *data)
@@ -73,8 +77,9 @@ static void ffmpeg_mux_destroy(void *data)
 		obs_encoder_packet_release(&stream->mux_packets.array[i]);
 	da_free(stream->mux_packets);
 	circlebuf_free(&stream->packets);
+	replay_store_destroy(stream->store);
 
-	os_process_pipe_destroy(stream->pipe);
+	stop_pipe(stream);
 	dstr_free(&stream->path);
 	dstr_free(&stream->printable_path);
 	dstr_free(&stream->stream_key);
@@ -258,19 +263,57 @@ static void add_stream_key(struct dstr *cmd, struct ffmpeg_muxer *stream)
 			  : stream->stream_key.array);
 }
 
+static bool is_mp4_path(const char *path)
+{
+	const char *ext = os_get_path_extension(path);
+
+	return ext && (astrcmpi(ext, ".mp4") == 0 ||
+		       astrcmpi(ext, ".m4v") == 0 ||
+		       astrcmpi(ext, ".mov") == 0);
+}
+
+/* fragmented MP4 writes a moof/mdat pair per fragment instead of one moov
+ * at the end, so the file is playable up to the last fragment even if the
+ * recording never finishes, and the muxer only ever holds one fragment */
+static void add_fragment_params(struct dstr *mux, struct ffmpeg_muxer *stream,
+				obs_data_t *settings)
+{
+	int64_t duration_ms = obs_data_get_int(settings, "fragment_duration_ms");
+
+	if (!obs_data_get_bool(settings, "fragmented"))
+		return;
+	if (stream->is_network || stream->is_hls ||
+	    !is_mp4_path(stream->path.array))
+		return;
+
+	if (mux->array && strstr(mux->array, "movflags")) {
+		info("Muxer settings already set movflags, not fragmenting");
+		return;
+	}
+
+	if (!dstr_is_empty(mux))
+		dstr_cat_ch(mux, ' ');
+	dstr_cat(mux, "movflags=frag_keyframe+empty_moov+default_base_moof");
+	if (duration_ms > 0)
+		dstr_catf(mux, " frag_duration=%lld",
+			  (long long)duration_ms * 1000);
+}
+
 static void add_muxer_params(struct dstr *cmd, struct ffmpeg_muxer *stream)
 {
+	obs_data_t *settings = obs_output_get_settings(stream->output);
 	struct dstr mux = {0};
 
 	if (dstr_is_empty(&stream->muxer_settings)) {
-		obs_data_t *settings = obs_output_get_settings(stream->output);
 		dstr_copy(&mux,
 			  obs_data_get_string(settings, "muxer_settings"));
-		obs_data_release(settings);
 	} else {
 		dstr_copy(&mux, stream->muxer_settings.array);
 	}
 
+	add_fragment_params(&mux, stream, settings);
+	obs_data_release(settings);
+
 	log_muxer_params(stream, mux.array);
 
 	dstr_replace(&mux, "\"", "\\\"");
@@ -280,6 +323,66 @@ static void add_muxer_params(struct dstr *cmd, struct ffmpeg_muxer *stream)
 	dstr_free(&mux);
 }
 
+static int64_t encoder_bitrate(obs_encoder_t *encoder)
+{
+	obs_data_t *settings = obs_encoder_get_settings(encoder);
+	int64_t bitrate = obs_data_get_int(settings, "bitrate");
+	obs_data_release(settings);
+	return bitrate;
+}
+
+/* size to reserve for the file, from the bitrate and how long the
+ * recording is expected to run */
+static int64_t get_preallocate_size(struct ffmpeg_muxer *stream,
+				    obs_data_t *settings)
+{
+	int64_t duration = obs_data_get_int(settings, "expected_duration_sec");
+	obs_encoder_t *vencoder = obs_output_get_video_encoder(stream->output);
+	int64_t kbps = 0;
+	int64_t size;
+
+	if (stream->is_network || duration <= 0)
+		return 0;
+
+	if (stream->split_file && stream->max_time > 0 &&
+	    duration > stream->max_time / 1000000)
+		duration = stream->max_time / 1000000;
+
+	if (vencoder)
+		kbps += encoder_bitrate(vencoder);
+	for (size_t i = 0; i < MAX_AUDIO_MIXES; i++) {
+		obs_encoder_t *aencoder =
+			obs_output_get_audio_encoder(stream->output, i);
+		if (!aencoder)
+			break;
+		kbps += encoder_bitrate(aencoder);
+	}
+
+	/* a bit extra for container overhead and rate control overshoot */
+	size = kbps * 1000 / 8 * duration;
+	size += size / 20;
+
+	if (stream->split_file && stream->max_size > 0 &&
+	    size > stream->max_size)
+		size = stream->max_size;
+
+	return size;
+}
+
+static void add_io_params(struct dstr *cmd, struct ffmpeg_muxer *stream)
+{
+	obs_data_t *settings = obs_output_get_settings(stream->output);
+	bool direct_io = !stream->is_network &&
+			 obs_data_get_bool(settings, "direct_io");
+	int64_t preallocate = get_preallocate_size(stream, settings);
+
+	obs_data_release(settings);
+
+	dstr_catf(cmd, "%d %lld ", direct_io ? 1 : 0, (long long)preallocate);
+	dstr_catf(cmd, "\"%s\" ",
+		  stream->format_name ? stream->format_name : "");
+}
+
 static void build_command_line(struct ffmpeg_muxer *stream, struct dstr *cmd,
 			       const char *path)
 {
@@ -320,14 +423,139 @@ static void build_command_line(struct ffmpeg_muxer *stream, struct dstr *cmd,
 
 	add_stream_key(cmd, stream);
 	add_muxer_params(cmd, stream);
+	add_io_params(cmd, stream);
+}
+
+/* moves packet data through shared memory instead of the pipe, see
+ * ffmpeg-mux.h; without it everything still goes through the pipe */
+static void start_shm(struct ffmpeg_muxer *stream)
+{
+	char name[64];
+	struct ffm_packet_info info = {.type = FFM_PACKET_SHM_INIT};
+	struct ffm_shm *shm = ffm_shm_create(name, sizeof(name));
+
+	if (!shm) {
+		warn("Failed to create shared memory for ffmpeg-mux, "
+		     "sending packets through the pipe");
+		return;
+	}
+
+	info.size = (uint32_t)strlen(name);
+
+	if (os_process_pipe_write(stream->pipe, (const uint8_t *)&info,
+				  sizeof(info)) != sizeof(info) ||
+	    os_process_pipe_write(stream->pipe, (const uint8_t *)name,
+				  info.size) != info.size) {
+		ffm_shm_close(shm);
+		return;
+	}
+
+	stream->shm = shm;
+	stream->shm_write_pos = 0;
+}
+
+/* splits the ffmpeg-mux command line the way the child's argv would see
+ * it, the strings point into cmd */
+static void split_command_line(char *cmd, struct darray *args)
+{
+	DARRAY(char *) argv;
+	char *in = cmd;
+
+	argv.da = *args;
+
+	while (*in) {
+		char *out;
+		bool quoted = false;
+
+		while (*in == ' ')
+			in++;
+		if (!*in)
+			break;
+
+		out = in;
+		da_push_back(argv, &out);
+
+		for (; *in; in++) {
+			if (quoted && in[0] == '\\' && in[1] == '"') {
+				*out++ = *++in;
+			} else if (quoted && in[0] == '"' && in[1] == '"') {
+				*out++ = *++in;
+			} else if (*in == '"') {
+				quoted = !quoted;
+			} else if (*in == ' ' && !quoted) {
+				in++;
+				break;
+			} else {
+				*out++ = *in;
+			}
+		}
+
+		*out = 0;
+	}
+
+	*args = argv.da;
+}
+
+static bool in_process(struct ffmpeg_muxer *stream)
+{
+	obs_data_t *settings;
+	bool enabled;
+
+	if (stream->is_network || stream->is_hls)
+		return false;
+
+	settings = obs_output_get_settings(stream->output);
+	enabled = obs_data_get_bool(settings, "in_process");
+	obs_data_release(settings);
+	return enabled;
+}
+
+static void start_in_process(struct ffmpeg_muxer *stream, struct dstr *cmd)
+{
+	DARRAY(char *) argv = {0};
+
+	split_command_line(cmd->array, &argv.da);
+	stream->inproc = ffmpeg_mux_lib_open((int)argv.num, argv.array);
+	stream->inproc_ret = FFM_SUCCESS;
+	da_free(argv);
+
+	if (stream->inproc)
+		info("Muxing in process");
 }
 
 void start_pipe(struct ffmpeg_muxer *stream, const char *path)
 {
 	struct dstr cmd;
 	build_command_line(stream, &cmd, path);
+
+	if (in_process(stream)) {
+		start_in_process(stream, &cmd);
+		dstr_free(&cmd);
+		return;
+	}
+
 	stream->pipe = os_process_pipe_create(cmd.array, "w");
 	dstr_free(&cmd);
+
+	if (stream->pipe)
+		start_shm(stream);
+}
+
+int stop_pipe(struct ffmpeg_muxer *stream)
+{
+	if (stream->inproc) {
+		ffmpeg_mux_lib_close(stream->inproc);
+		stream->inproc = NULL;
+		return stream->inproc_ret;
+	}
+
+	int ret = os_process_pipe_destroy(stream->pipe);
+	stream->pipe = NULL;
+
+	/* the child has exited by now, it can't be using the ring anymore */
+	ffm_shm_close(stream->shm);
+	stream->shm = NULL;
+	return ret;
 }
 
 static void set_file_not_readable_error(struct ffmpeg_muxer *stream,
@@ -452,7 +680,7 @@ static inline bool ffmpeg_mux_start_internal(struct ffmpeg_muxer *stream,
 
 	start_pipe(stream, path);
 
-	if (!stream->pipe) {
+	if (!pipe_started(stream)) {
 		obs_output_set_last_error(
 			stream->output, obs_module_text("HelperProcessFailed"));
 		warn("Failed to create process pipe");
@@ -494,8 +722,7 @@ int deactivate(struct ffmpeg_muxer *stream, int code)
 	}
 
 	if (active(stream)) {
-		ret = os_process_pipe_destroy(stream->pipe);
-		stream->pipe = NULL;
+		ret = stop_pipe(stream);
 
 		os_atomic_set_bool(&stream->active, false);
 		os_atomic_set_bool(&stream->sent_headers, false);
@@ -551,8 +778,10 @@ static void signal_failure(struct ffmpeg_muxer *stream)
 
 	size_t len;
 
-	len = os_process_pipe_read_err(stream->pipe, (uint8_t *)error,
-				       sizeof(error) - 1);
+	len = stream->pipe ? os_process_pipe_read_err(stream->pipe,
+						      (uint8_t *)error,
+						      sizeof(error) - 1)
+			   : 0;
 
 	if (len > 0) {
 		error[len] = 0;
@@ -636,6 +865,43 @@ static void generate_filename(struct ffmpeg_muxer *stream, struct dstr *dst,
 	obs_data_release(settings);
 }
 
+/* copies the packet data into the shared ring if the child is using it and
+ * there's room, otherwise it's sent through the pipe after the info */
+static void write_shared(struct ffmpeg_muxer *stream,
+			 struct encoder_packet *packet,
+			 struct ffm_packet_info *info)
+{
+	struct ffm_shm_header *header;
+	uint32_t pos = stream->shm_write_pos;
+	uint32_t size = (uint32_t)packet->size;
+	uint32_t offset, pad, used;
+
+	if (!stream->shm || size > FFM_SHM_RING_SIZE / 4)
+		return;
+
+	header = ffm_shm_header(stream->shm);
+	if (!os_atomic_load_long(&header->attached))
+		return;
+
+	/* packets are kept contiguous, skip to the start if it doesn't fit
+	 * before the end */
+	offset = pos & (FFM_SHM_RING_SIZE - 1);
+	pad = offset + size > FFM_SHM_RING_SIZE ? FFM_SHM_RING_SIZE - offset
+						 : 0;
+	used = pos - (uint32_t)os_atomic_load_long(&header->read_pos);
+
+	if (used + pad + size > FFM_SHM_RING_SIZE)
+		return;
+
+	pos += pad;
+	memcpy(ffm_shm_data(stream->shm) + (pos & (FFM_SHM_RING_SIZE - 1)),
+	       packet->data, size);
+
+	info->shared = true;
+	info->shm_pos = pos;
+	stream->shm_write_pos = pos + size;
+}
+
 bool write_packet(struct ffmpeg_muxer *stream, struct encoder_packet *packet)
 {
 	bool is_video = packet->type == OBS_ENCODER_VIDEO;
@@ -659,6 +925,23 @@ bool write_packet(struct ffmpeg_muxer *stream, struct encoder_packet *packet)
 		}
 	}
 
+	if (stream->inproc) {
+		stream->inproc_ret =
+			ffmpeg_mux_lib_packet(stream->inproc, packet->data, &info);
+		if (stream->inproc_ret != FFM_SUCCESS) {
+			warn("In process muxing failed");
+			signal_failure(stream);
+			return false;
+		}
+
+		stream->total_bytes += packet->size;
+		if (stream->split_file)
+			stream->cur_size += packet->size;
+		return true;
+	}
+
+	write_shared(stream, packet, &info);
+
 	ret = os_process_pipe_write(stream->pipe, (const uint8_t *)&info,
 				    sizeof(info));
 	if (ret != sizeof(info)) {
@@ -667,11 +950,14 @@ bool write_packet(struct ffmpeg_muxer *stream, struct encoder_packet *packet)
 		return false;
 	}
 
-	ret = os_process_pipe_write(stream->pipe, packet->data, packet->size);
-	if (ret != packet->size) {
-		warn("os_process_pipe_write for packet data failed");
-		signal_failure(stream);
-		return false;
+	if (!info.shared) {
+		ret = os_process_pipe_write(stream->pipe, packet->data,
+					    packet->size);
+		if (ret != packet->size) {
+			warn("os_process_pipe_write for packet data failed");
+			signal_failure(stream);
+			return false;
+		}
 	}
 
 	stream->total_bytes += packet->size;
@@ -760,6 +1046,11 @@ static bool send_new_filename(struct ffmpeg_muxer *stream, const char *filename)
 	struct ffm_packet_info info = {.type = FFM_PACKET_CHANGE_FILE,
 				       .size = size};
 
+	if (stream->inproc) {
+		ffmpeg_mux_lib_change_file(stream->inproc, filename);
+		return true;
+	}
+
 	ret = os_process_pipe_write(stream->pipe, (const uint8_t *)&info,
 				    sizeof(info));
 	if (ret != sizeof(info)) {
@@ -906,12 +1197,32 @@ static obs_properties_t *ffmpeg_mux_properties(void *unused)
 	UNUSED_PARAMETER(unused);
 
 	obs_properties_t *props = obs_properties_create();
+	obs_property_t *p;
 
 	obs_properties_add_text(props, "path", obs_module_text("FilePath"),
 				OBS_TEXT_DEFAULT);
+	obs_properties_add_bool(props, "direct_io",
+				obs_module_text("DirectIO"));
+	obs_properties_add_bool(props, "in_process",
+				obs_module_text("InProcessMuxing"));
+	p = obs_properties_add_int(props, "expected_duration_sec",
+				   obs_module_text("ExpectedDuration"), 0,
+				   86400 * 7, 60);
+	obs_property_int_set_suffix(p, " s");
+	obs_properties_add_bool(props, "fragmented",
+				obs_module_text("FragmentedMP4"));
+	p = obs_properties_add_int(props, "fragment_duration_ms",
+				   obs_module_text("FragmentDuration"), 0,
+				   60000, 100);
+	obs_property_int_set_suffix(p, " ms");
 	return props;
 }
 
+static void ffmpeg_mux_defaults(obs_data_t *settings)
+{
+	obs_data_set_default_int(settings, "fragment_duration_ms", 2000);
+}
+
 uint64_t ffmpeg_mux_total_bytes(void *data)
 {
 	struct ffmpeg_muxer *stream = data;
@@ -930,6 +1241,7 @@ struct obs_output_info ffmpeg_muxer = {
 	.encoded_packet = ffmpeg_mux_data,
 	.get_total_bytes = ffmpeg_mux_total_bytes,
 	.get_properties = ffmpeg_mux_properties,
+	.get_defaults = ffmpeg_mux_defaults,
 	.is_ready_to_update = ffmpeg_mux_is_ready_to_update,
 };
 
@@ -974,17 +1286,9 @@ static const char *replay_buffer_getname(void *type)
 	return obs_module_text("ReplayBuffer");
 }
 
-static void replay_buffer_hotkey(void *data, obs_hotkey_id id,
-				 obs_hotkey_t *hotkey, bool pressed)
+/* a range of 0 saves the whole buffer */
+static void request_save(struct ffmpeg_muxer *stream, int64_t range)
 {
-	UNUSED_PARAMETER(id);
-	UNUSED_PARAMETER(hotkey);
-
-	if (!pressed)
-		return;
-
-	struct ffmpeg_muxer *stream = data;
-
 	if (os_atomic_load_bool(&stream->active)) {
 		obs_encoder_t *vencoder =
 			obs_output_get_video_encoder(stream->output);
@@ -993,16 +1297,35 @@ static void replay_buffer_hotkey(void *data, obs_hotkey_id id,
 			return;
 		}
 
+		stream->save_range = range;
 		stream->save_ts = os_gettime_ns() / 1000LL;
 	}
 }
 
+static void replay_buffer_hotkey(void *data, obs_hotkey_id id,
+				 obs_hotkey_t *hotkey, bool pressed)
+{
+	UNUSED_PARAMETER(id);
+	UNUSED_PARAMETER(hotkey);
+
+	if (!pressed)
+		return;
+
+	request_save(data, 0);
+}
+
 static void save_replay_proc(void *data, calldata_t *cd)
 {
-	replay_buffer_hotkey(data, 0, NULL, true);
+	request_save(data, 0);
 	UNUSED_PARAMETER(cd);
 }
 
+static void save_replay_range_proc(void *data, calldata_t *cd)
+{
+	long long seconds = calldata_int(cd, "seconds");
+	request_save(data, seconds > 0 ? seconds * 1000000LL : 0);
+}
+
 static void *replay_buffer_create(obs_data_t *settings, obs_output_t *output)
 {
 	UNUSED_PARAMETER(settings);
@@ -1016,6 +1339,8 @@ static void *replay_buffer_create(obs_data_t *settings, obs_output_t *output)
 
 	proc_handler_t *ph = obs_output_get_proc_handler(output);
 	proc_handler_add(ph, "void save()", save_replay_proc, stream);
+	proc_handler_add(ph, "void save_range(in int seconds)",
+			 save_replay_range_proc, stream);
 	proc_handler_add(ph, "void get_last_file(out string path)",
 			 get_last_file, stream);
 
@@ -1045,8 +1370,12 @@ static bool replay_buffer_start(void *data)
 	obs_data_t *s = obs_output_get_settings(stream->output);
 	stream->max_time = obs_data_get_int(s, "max_time_sec") * 1000000LL;
 	stream->max_size = obs_data_get_int(s, "max_size_mb") * (1024 * 1024);
+	stream->use_store = obs_data_get_bool(s, "segment_store");
 	obs_data_release(s);
 
+	if (stream->use_store && !stream->store)
+		stream->store = replay_store_create();
+
 	os_atomic_set_bool(&stream->active, true);
 	os_atomic_set_bool(&stream->capturing, true);
 	stream->total_bytes = 0;
@@ -1055,6 +1384,56 @@ static bool replay_buffer_start(void *data)
 	return true;
 }
 
+/* every video keyframe in the buffer, oldest first, so a save can find
+ * where to start without walking the packets */
+struct replay_keyframe {
+	uint64_t seq;
+	int64_t dts_usec;
+};
+
+static inline size_t num_keyframes(struct ffmpeg_muxer *stream)
+{
+	return stream->keyframe_index.size / sizeof(struct replay_keyframe);
+}
+
+static inline struct replay_keyframe *get_keyframe(struct ffmpeg_muxer *stream,
+						   size_t idx)
+{
+	return circlebuf_data(&stream->keyframe_index,
+			      idx * sizeof(struct replay_keyframe));
+}
+
+/* returns the index of the first packet to save, the latest keyframe that
+ * still covers the requested range */
+static size_t find_save_start(struct ffmpeg_muxer *stream, int64_t range)
+{
+	struct encoder_packet *last;
+	size_t num = num_keyframes(stream);
+	size_t lo = 0;
+	size_t hi = num;
+	int64_t start_dts;
+
+	if (!range || !num || !stream->packets.size)
+		return 0;
+
+	last = circlebuf_data(&stream->packets,
+			      stream->packets.size - sizeof(*last));
+	start_dts = last->dts_usec - range;
+
+	/* first keyframe after start_dts */
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		if (get_keyframe(stream, mid)->dts_usec <= start_dts)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if (lo)
+		lo--;
+	return (size_t)(get_keyframe(stream, lo)->seq - stream->first_seq);
+}
+
 static bool purge_front(struct ffmpeg_muxer *stream)
 {
 	struct encoder_packet pkt;
@@ -1066,11 +1445,13 @@ static bool purge_front(struct ffmpeg_muxer *stream)
 		return false;
 
 	circlebuf_pop_front(&stream->packets, &pkt, sizeof(pkt));
+	stream->first_seq++;
 
 	keyframe = pkt.type == OBS_ENCODER_VIDEO && pkt.keyframe;
 
 	if (keyframe)
-		stream->keyframes--;
+		circlebuf_pop_front(&stream->keyframe_index, NULL,
+				    sizeof(struct replay_keyframe));
 
 	if (!stream->packets.size) {
 		stream->cur_size = 0;
@@ -1082,7 +1463,7 @@ static bool purge_front(struct ffmpeg_muxer *stream)
 		stream->cur_size -= (int64_t)pkt.size;
 	}
 
-	obs_encoder_packet_release(&pkt);
+	replay_store_release(stream->store, &pkt);
 	return keyframe;
 }
 
@@ -1107,7 +1488,7 @@ static inline void purge(struct ffmpeg_muxer *stream)
 static inline void replay_buffer_purge(struct ffmpeg_muxer *stream,
 				       struct encoder_packet *pkt)
 {
-	if (!stream->packets.size || stream->keyframes <= 2)
+	if (!stream->packets.size || num_keyframes(stream) <= 2)
 		return;
 
 	if (stream->max_size) {
@@ -1116,7 +1497,7 @@ static inline void replay_buffer_purge(struct ffmpeg_muxer *stream,
 			purge(stream);
 	}
 
-	if (!stream->packets.size || stream->keyframes <= 2)
+	if (!stream->packets.size || num_keyframes(stream) <= 2)
 		return;
 
 	while ((pkt->dts_usec - stream->cur_time) > stream->max_time &&
@@ -1124,16 +1505,21 @@ static inline void replay_buffer_purge(struct ffmpeg_muxer *stream,
 		purge(stream);
 }
 
-static void insert_packet(struct darray *array, struct encoder_packet *packet,
-			  int64_t video_offset, int64_t *audio_offsets,
-			  int64_t video_pts_offset, int64_t *audio_dts_offsets)
+static void insert_packet(struct ffmpeg_muxer *stream, struct darray *array,
+			  struct encoder_packet *packet, int64_t video_offset,
+			  int64_t *audio_offsets, int64_t video_pts_offset,
+			  int64_t *audio_dts_offsets)
 {
 	struct encoder_packet pkt;
 	DARRAY(struct encoder_packet) packets;
 	packets.da = *array;
 	size_t idx;
 
-	obs_encoder_packet_ref(&pkt, packet);
+	/* stored packets are kept alive by pinning the store instead */
+	if (replay_store_contains(stream->store, packet->data))
+		pkt = *packet;
+	else
+		obs_encoder_packet_ref(&pkt, packet);
 
 	if (pkt.type == OBS_ENCODER_VIDEO) {
 		pkt.dts_usec -= video_offset;
@@ -1155,6 +1541,13 @@ static void insert_packet(struct darray *array, struct encoder_packet *packet,
 	*array = packets.da;
 }
 
+static inline void release_mux_packet(struct ffmpeg_muxer *stream,
+				      struct encoder_packet *pkt)
+{
+	if (!replay_store_contains(stream->store, pkt->data))
+		obs_encoder_packet_release(pkt);
+}
+
 static void *replay_buffer_mux_thread(void *data)
 {
 	bool hasFailed = false;
@@ -1166,7 +1559,7 @@ static void *replay_buffer_mux_thread(void *data)
 
 	start_pipe(stream, stream->path.array);
 
-	if (!stream->pipe) {
+	if (!pipe_started(stream)) {
 		warn("Failed to create process pipe");
 		do_output_signal(stream->output, "writing_error");
 		hasFailed = true;
@@ -1190,7 +1583,7 @@ static void *replay_buffer_mux_thread(void *data)
 			hasFailed = !write_packet(stream, pkt);
 		}
 
-		obs_encoder_packet_release(pkt);
+		release_mux_packet(stream, pkt);
 	}
 
 	if (!hasFailed) {
@@ -1198,14 +1591,14 @@ static void *replay_buffer_mux_thread(void *data)
 	}
 
 error:
-	ret = os_process_pipe_destroy(stream->pipe);
-	stream->pipe = NULL;
+	ret = stop_pipe(stream);
 	if (error) {
 		for (size_t i = 0; i < stream->mux_packets.num; i++)
-			obs_encoder_packet_release(
-				&stream->mux_packets.array[i]);
+			release_mux_packet(stream,
+					   &stream->mux_packets.array[i]);
 	}
 	da_free(stream->mux_packets);
+	replay_store_unpin(stream->store);
 	os_atomic_set_bool(&stream->muxing, false);
 	if (ret < 0) {
 		signal_failure(stream);
@@ -1227,8 +1620,10 @@ static void replay_buffer_save(struct ffmpeg_muxer *stream)
 {
 	const size_t size = sizeof(struct encoder_packet);
 	size_t num_packets = stream->packets.size / size;
+	size_t start = find_save_start(stream, stream->save_range);
 
-	da_reserve(stream->mux_packets, num_packets);
+	da_reserve(stream->mux_packets, num_packets - start);
+	replay_store_pin(stream->store);
 
 	/* ---------------------------- */
 	/* reorder packets */
@@ -1240,7 +1635,7 @@ static void replay_buffer_save(struct ffmpeg_muxer *stream)
 	int64_t audio_offsets[MAX_AUDIO_MIXES] = {0};
 	int64_t audio_dts_offsets[MAX_AUDIO_MIXES] = {0};
 
-	for (size_t i = 0; i < num_packets; i++) {
+	for (size_t i = start; i < num_packets; i++) {
 		struct encoder_packet *pkt;
 		pkt = circlebuf_data(&stream->packets, i * size);
 
@@ -1259,8 +1654,8 @@ static void replay_buffer_save(struct ffmpeg_muxer *stream)
 			}
 		}
 
-		insert_packet(&stream->mux_packets.da, pkt, video_offset,
-			      audio_offsets, video_pts_offset,
+		insert_packet(stream, &stream->mux_packets.da, pkt,
+			      video_offset, audio_offsets, video_pts_offset,
 			      audio_dts_offsets);
 	}
 
@@ -1272,6 +1667,11 @@ static void replay_buffer_save(struct ffmpeg_muxer *stream)
 						     stream) == 0;
 	if (!stream->mux_thread_joinable) {
 		warn("Failed to create muxer thread");
+		for (size_t i = 0; i < stream->mux_packets.num; i++)
+			release_mux_packet(stream,
+					   &stream->mux_packets.array[i]);
+		da_free(stream->mux_packets);
+		replay_store_unpin(stream->store);
 		os_atomic_set_bool(&stream->muxing, false);
 	}
 }
@@ -1318,10 +1718,18 @@ static void replay_buffer_data(void *data, struct encoder_packet *packet)
 		stream->cur_time = pkt.dts_usec;
 	stream->cur_size += pkt.size;
 
-	circlebuf_push_back(&stream->packets, packet, sizeof(*packet));
+	if (stream->use_store)
+		replay_store_add(stream->store, &pkt);
 
-	if (packet->type == OBS_ENCODER_VIDEO && packet->keyframe)
-		stream->keyframes++;
+	circlebuf_push_back(&stream->packets, &pkt, sizeof(pkt));
+
+	if (packet->type == OBS_ENCODER_VIDEO && packet->keyframe) {
+		struct replay_keyframe kf = {stream->next_seq,
+					     packet->dts_usec};
+		circlebuf_push_back(&stream->keyframe_index, &kf, sizeof(kf));
+	}
+
+	stream->next_seq++;
 
 	if (stream->save_ts && packet->sys_dts_usec >= stream->save_ts) {
 		if (os_atomic_load_bool(&stream->muxing))
@@ -1332,8 +1740,9 @@ static void replay_buffer_data(void *data, struct encoder_packet *packet)
 			stream->mux_thread_joinable = false;
 		}
 
-		stream->save_ts = 0;
 		replay_buffer_save(stream);
+		stream->save_ts = 0;
+		stream->save_range = 0;
 	}
 }
 
@@ -1344,6 +1753,7 @@ static void replay_buffer_defaults(obs_data_t *s)
 	obs_data_set_default_string(s, "format", "%CCYY-%MM-%DD %hh-%mm-%ss");
 	obs_data_set_default_string(s, "extension", "mp4");
 	obs_data_set_default_bool(s, "allow_spaces", true);
+	obs_data_set_default_bool(s, "segment_store", false);
 }
 
 struct obs_output_info replay_buffer = {
@@ -12,6 +12,12 @@
 struct ffmpeg_muxer {
 	obs_output_t *output;
 	os_process_pipe_t *pipe;
+	struct ffm_shm *shm;
+	uint32_t shm_write_pos;
+
+	/* muxing in this process instead of through ffmpeg-mux */
+	struct ffmpeg_mux_lib *inproc;
+	int inproc_ret;
 	int64_t stop_ts;
 	uint64_t total_bytes;
 	bool sent_headers;
@@ -31,10 +37,15 @@ struct ffmpeg_muxer {
 
 	/* replay buffer */
 	int64_t save_ts;
-	int keyframes;
+	int64_t save_range;
+	uint64_t first_seq;
+	uint64_t next_seq;
+	struct circlebuf keyframe_index;
 	obs_hotkey_id hotkey;
 	volatile bool muxing;
 	DARRAY(struct encoder_packet) mux_packets;
+	struct replay_store *store;
+	bool use_store;
 
 	/* split file */
 	bool found_video;
@@ -55,6 +66,7 @@ struct ffmpeg_muxer {
 	os_sem_t *write_sem;
 	os_event_t *stop_event;
 	bool is_hls;
+	const char *format_name;
 	int dropped_frames;
 	int min_priority;
 	int64_t last_dts_usec;
@@ -67,6 +79,12 @@ struct ffmpeg_muxer {
 bool stopping(struct ffmpeg_muxer *stream);
 bool active(struct ffmpeg_muxer *stream);
 void start_pipe(struct ffmpeg_muxer *stream, const char *path);
+int stop_pipe(struct ffmpeg_muxer *stream);
+
+static inline bool pipe_started(struct ffmpeg_muxer *stream)
+{
+	return stream->pipe || stream->inproc;
+}
 bool write_packet(struct ffmpeg_muxer *stream, struct encoder_packet *packet);
 bool send_headers(struct ffmpeg_muxer *stream);
 int deactivate(struct ffmpeg_muxer *stream, int code);
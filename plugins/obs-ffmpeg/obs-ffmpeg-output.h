@@ -106,6 +106,21 @@ struct ffmpeg_output {
 	URLContext *h;
 	AVIOContext *s;
 	bool got_headers;
+
+	/* sender-side pacing of the muxed stream, in bytes per second */
+	double pacing_peak_ratio;
+	uint64_t pacing_min_rate;
+	uint64_t pacing_next_ns;
+	uint64_t pacing_window_ns;
+	uint64_t pacing_window_bytes;
+	uint64_t pacing_measured_rate;
+
+	/* SRT stats, polled by the write thread and guarded by write_mutex */
+	uint64_t srt_stats_ns;
+	double srt_rtt_ms;
+	int64_t srt_pkt_retransmitted;
+	int srt_send_buffer_bytes;
+	int srt_send_buffer_ms;
 #endif
 };
 bool ffmpeg_data_init(struct ffmpeg_data *data, struct ffmpeg_cfg *config);
@@ -0,0 +1,353 @@
+/******************************************************************************
+    Copyright (C) 2023 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <obs-module.h>
+#include <util/darray.h>
+#include <util/dstr.h>
+#include <util/platform.h>
+#include <util/threading.h>
+#include "obs-ffmpeg-replay-store.h"
+
+/* Packets are appended to the newest segment.  A segment goes back to the
+ * unused list once the last packet in it has been purged, and a few unused
+ * segments are kept around so a steady buffer doesn't keep creating files.
+ * The files are deleted as soon as they're mapped (or on close on Windows),
+ * so nothing is left behind if OBS exits uncleanly. */
+
+#define SEGMENT_SIZE (64 * 1024 * 1024)
+#define MAX_UNUSED_SEGMENTS 2
+
+struct replay_segment {
+#ifdef _WIN32
+	HANDLE file;
+	HANDLE mapping;
+#endif
+	uint8_t *mem;
+	size_t used;
+	long packets;
+};
+
+struct replay_store {
+	pthread_mutex_t mutex;
+	DARRAY(struct replay_segment *) segments;
+	DARRAY(struct replay_segment *) unused;
+	struct dstr dir;
+	long pins;
+	long count;
+};
+
+static void free_segment(struct replay_segment *seg)
+{
+#ifdef _WIN32
+	if (seg->mem)
+		UnmapViewOfFile(seg->mem);
+	if (seg->mapping)
+		CloseHandle(seg->mapping);
+	if (seg->file != INVALID_HANDLE_VALUE)
+		CloseHandle(seg->file);
+#else
+	if (seg->mem)
+		munmap(seg->mem, SEGMENT_SIZE);
+#endif
+	bfree(seg);
+}
+
+#ifdef _WIN32
+static bool map_segment(struct replay_segment *seg, const char *path)
+{
+	wchar_t *wpath = NULL;
+
+	os_utf8_to_wcs_ptr(path, 0, &wpath);
+	seg->file = CreateFileW(wpath, GENERIC_READ | GENERIC_WRITE, 0, NULL,
+				CREATE_NEW,
+				FILE_ATTRIBUTE_TEMPORARY |
+					FILE_FLAG_DELETE_ON_CLOSE,
+				NULL);
+	bfree(wpath);
+
+	if (seg->file == INVALID_HANDLE_VALUE)
+		return false;
+
+	seg->mapping = CreateFileMappingW(seg->file, NULL, PAGE_READWRITE, 0,
+					  SEGMENT_SIZE, NULL);
+	if (!seg->mapping)
+		return false;
+
+	seg->mem = MapViewOfFile(seg->mapping, FILE_MAP_ALL_ACCESS, 0, 0,
+				 SEGMENT_SIZE);
+	return !!seg->mem;
+}
+#else
+static bool map_segment(struct replay_segment *seg, const char *path)
+{
+	void *mem;
+	int fd;
+
+	fd = open(path, O_RDWR | O_CREAT | O_EXCL, 0600);
+	if (fd == -1)
+		return false;
+
+	unlink(path);
+
+	if (ftruncate(fd, SEGMENT_SIZE) != 0) {
+		close(fd);
+		return false;
+	}
+
+	mem = mmap(NULL, SEGMENT_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+		   0);
+	close(fd);
+
+	if (mem == MAP_FAILED)
+		return false;
+
+	seg->mem = mem;
+	return true;
+}
+#endif
+
+static inline unsigned long proc_id(void)
+{
+#ifdef _WIN32
+	return (unsigned long)GetCurrentProcessId();
+#else
+	return (unsigned long)getpid();
+#endif
+}
+
+static struct replay_segment *new_segment(struct replay_store *store)
+{
+	struct replay_segment *seg;
+	struct dstr path = {0};
+
+	if (store->unused.num) {
+		seg = store->unused.array[store->unused.num - 1];
+		da_pop_back(store->unused);
+		return seg;
+	}
+
+	seg = bzalloc(sizeof(*seg));
+#ifdef _WIN32
+	seg->file = INVALID_HANDLE_VALUE;
+#endif
+
+	dstr_printf(&path, "%s/segment-%lu-%ld.bin", store->dir.array,
+		    proc_id(), store->count++);
+
+	if (!map_segment(seg, path.array)) {
+		blog(LOG_WARNING,
+		     "[replay store] Failed to create segment file '%s', "
+		     "keeping packets in memory",
+		     path.array);
+		free_segment(seg);
+		seg = NULL;
+	}
+
+	dstr_free(&path);
+	return seg;
+}
+
+static void recycle_segment(struct replay_store *store,
+			    struct replay_segment *seg)
+{
+	seg->used = 0;
+
+	if (store->unused.num >= MAX_UNUSED_SEGMENTS) {
+		free_segment(seg);
+		return;
+	}
+
+#if defined(MADV_REMOVE)
+	/* the old data is never read again, free it rather than have it
+	 * written back to the file */
+	madvise(seg->mem, SEGMENT_SIZE, MADV_REMOVE);
+#elif !defined(_WIN32)
+	madvise(seg->mem, SEGMENT_SIZE, MADV_DONTNEED);
+#endif
+	da_push_back(store->unused, &seg);
+}
+
+/* the newest segment is still being written to, so it never gets recycled */
+static void recycle_segments(struct replay_store *store)
+{
+	if (store->pins)
+		return;
+
+	for (size_t i = store->segments.num; i > 1; i--) {
+		struct replay_segment *seg = store->segments.array[i - 2];
+		if (!seg->packets) {
+			da_erase(store->segments, i - 2);
+			recycle_segment(store, seg);
+		}
+	}
+}
+
+static struct replay_segment *find_segment(struct replay_store *store,
+					   const uint8_t *data)
+{
+	for (size_t i = 0; i < store->segments.num; i++) {
+		struct replay_segment *seg = store->segments.array[i];
+		if (data >= seg->mem && data < seg->mem + SEGMENT_SIZE)
+			return seg;
+	}
+
+	return NULL;
+}
+
+struct replay_store *replay_store_create(void)
+{
+	struct replay_store *store = bzalloc(sizeof(*store));
+	char *dir = obs_module_config_path("replay");
+
+	dstr_copy(&store->dir, dir);
+	bfree(dir);
+
+	if (os_mkdirs(store->dir.array) == MKDIR_ERROR) {
+		blog(LOG_WARNING,
+		     "[replay store] Failed to create directory '%s'",
+		     store->dir.array);
+		dstr_free(&store->dir);
+		bfree(store);
+		return NULL;
+	}
+
+	pthread_mutex_init(&store->mutex, NULL);
+	return store;
+}
+
+void replay_store_destroy(struct replay_store *store)
+{
+	if (!store)
+		return;
+
+	for (size_t i = 0; i < store->segments.num; i++)
+		free_segment(store->segments.array[i]);
+	for (size_t i = 0; i < store->unused.num; i++)
+		free_segment(store->unused.array[i]);
+
+	da_free(store->segments);
+	da_free(store->unused);
+	dstr_free(&store->dir);
+	pthread_mutex_destroy(&store->mutex);
+	bfree(store);
+}
+
+bool replay_store_add(struct replay_store *store, struct encoder_packet *pkt)
+{
+	struct replay_segment *seg = NULL;
+	uint8_t *data;
+
+	if (!store || !pkt->data || pkt->size > SEGMENT_SIZE)
+		return false;
+
+	pthread_mutex_lock(&store->mutex);
+
+	if (store->segments.num)
+		seg = store->segments.array[store->segments.num - 1];
+
+	if (!seg || seg->used + pkt->size > SEGMENT_SIZE) {
+		seg = new_segment(store);
+		if (!seg) {
+			pthread_mutex_unlock(&store->mutex);
+			return false;
+		}
+
+		da_push_back(store->segments, &seg);
+		recycle_segments(store);
+	}
+
+	data = seg->mem + seg->used;
+	memcpy(data, pkt->data, pkt->size);
+	seg->used += pkt->size;
+	seg->packets++;
+
+	pthread_mutex_unlock(&store->mutex);
+
+	struct encoder_packet stored = *pkt;
+	obs_encoder_packet_release(pkt);
+
+	*pkt = stored;
+	pkt->data = data;
+	pkt->refcounted = false;
+	return true;
+}
+
+void replay_store_release(struct replay_store *store,
+			  struct encoder_packet *pkt)
+{
+	struct replay_segment *seg = NULL;
+
+	if (!store) {
+		obs_encoder_packet_release(pkt);
+		return;
+	}
+
+	pthread_mutex_lock(&store->mutex);
+	seg = find_segment(store, pkt->data);
+	if (seg) {
+		seg->packets--;
+		recycle_segments(store);
+	}
+	pthread_mutex_unlock(&store->mutex);
+
+	if (seg)
+		memset(pkt, 0, sizeof(*pkt));
+	else
+		obs_encoder_packet_release(pkt);
+}
+
+bool replay_store_contains(struct replay_store *store, const uint8_t *data)
+{
+	bool found;
+
+	if (!store)
+		return false;
+
+	pthread_mutex_lock(&store->mutex);
+	found = find_segment(store, data) != NULL;
+	pthread_mutex_unlock(&store->mutex);
+	return found;
+}
+
+void replay_store_pin(struct replay_store *store)
+{
+	if (!store)
+		return;
+
+	pthread_mutex_lock(&store->mutex);
+	store->pins++;
+	pthread_mutex_unlock(&store->mutex);
+}
+
+void replay_store_unpin(struct replay_store *store)
+{
+	if (!store)
+		return;
+
+	pthread_mutex_lock(&store->mutex);
+	if (--store->pins == 0)
+		recycle_segments(store);
+	pthread_mutex_unlock(&store->mutex);
+}
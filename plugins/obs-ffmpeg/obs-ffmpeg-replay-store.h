@@ -0,0 +1,26 @@
+#pragma once
+
+#include <obs.h>
+
+/* Keeps the replay buffer's packet data in fixed size memory mapped segment
+ * files instead of on the heap.  The packets themselves stay in the replay
+ * buffer's queue, only their data points into a segment. */
+struct replay_store;
+
+struct replay_store *replay_store_create(void);
+void replay_store_destroy(struct replay_store *store);
+
+/* moves the data of a referenced packet into the store, on failure the
+ * packet keeps its heap data */
+bool replay_store_add(struct replay_store *store, struct encoder_packet *pkt);
+
+/* releases a buffered packet, whether its data is in the store or not */
+void replay_store_release(struct replay_store *store,
+			  struct encoder_packet *pkt);
+
+bool replay_store_contains(struct replay_store *store, const uint8_t *data);
+
+/* keeps every segment from being reused while a replay is being saved, so
+ * the save can read packet data straight from the segments */
+void replay_store_pin(struct replay_store *store);
+void replay_store_unpin(struct replay_store *store);
@@ -51,15 +51,19 @@ struct ffmpeg_source {
 	char *input_format;
 	char *ffmpeg_options;
 	int buffering_mb;
+	int read_ahead_ms;
+	int read_ahead_mb;
 	int speed_percent;
 	bool is_looping;
 	bool is_local_file;
+	bool jitter_buffer;
 	bool is_hw_decoding;
 	bool is_clear_on_media_end;
 	bool restart_on_activate;
 	bool close_when_inactive;
 	bool seekable;
 	bool enable_caching;
+	int cache_budget_mb;
 	int64_t volume;
 
 	pthread_t reconnect_thread;
@@ -99,20 +103,32 @@ static bool is_local_file_modified(obs_properties_t *props,
 	obs_property_t *local_file = obs_properties_get(props, "local_file");
 	obs_property_t *looping = obs_properties_get(props, "looping");
 	obs_property_t *buffering = obs_properties_get(props, "buffering_mb");
+	obs_property_t *read_ahead_ms =
+		obs_properties_get(props, "read_ahead_ms");
+	obs_property_t *read_ahead_mb =
+		obs_properties_get(props, "read_ahead_mb");
 	obs_property_t *seekable = obs_properties_get(props, "seekable");
 	obs_property_t *speed = obs_properties_get(props, "speed_percent");
 	obs_property_t *caching = obs_properties_get(props, "caching");
+	obs_property_t *cache_budget =
+		obs_properties_get(props, "cache_budget_mb");
 	obs_property_t *reconnect_delay_sec =
 		obs_properties_get(props, "reconnect_delay_sec");
+	obs_property_t *jitter_buffer =
+		obs_properties_get(props, "jitter_buffer");
 	obs_property_set_visible(input, !enabled);
 	obs_property_set_visible(input_format, !enabled);
 	obs_property_set_visible(buffering, !enabled);
+	obs_property_set_visible(read_ahead_ms, !enabled);
+	obs_property_set_visible(read_ahead_mb, !enabled);
 	obs_property_set_visible(local_file, enabled);
 	obs_property_set_visible(looping, enabled);
 	obs_property_set_visible(speed, enabled);
 	obs_property_set_visible(seekable, !enabled);
-	obs_property_set_visible(caching, false);
+	obs_property_set_visible(caching, enabled);
+	obs_property_set_visible(cache_budget, enabled);
 	obs_property_set_visible(reconnect_delay_sec, !enabled);
+	obs_property_set_visible(jitter_buffer, !enabled);
 
 	return true;
 }
@@ -126,8 +142,12 @@ static void ffmpeg_source_defaults(obs_data_t *settings)
 	obs_data_set_default_bool(settings, "linear_alpha", false);
 	obs_data_set_default_int(settings, "reconnect_delay_sec", 10);
 	obs_data_set_default_int(settings, "buffering_mb", 2);
+	obs_data_set_default_int(settings, "read_ahead_ms", 0);
+	obs_data_set_default_int(settings, "read_ahead_mb", 16);
+	obs_data_set_default_bool(settings, "jitter_buffer", false);
 	obs_data_set_default_int(settings, "speed_percent", 100);
 	obs_data_set_default_bool(settings, "caching", false);
+	obs_data_set_default_int(settings, "cache_budget_mb", 1024);
 	obs_data_set_default_int(settings, "volume", 100);
 }
 
@@ -189,6 +209,23 @@ static obs_properties_t *ffmpeg_source_getproperties(void *data)
 					     16, 1);
 	obs_property_int_set_suffix(prop, " MB");
 
+	prop = obs_properties_add_int(props, "read_ahead_ms",
+				      obs_module_text("ReadAhead"), 0, 30000,
+				      100);
+	obs_property_int_set_suffix(prop, " ms");
+	obs_property_set_long_description(
+		prop, obs_module_text("ReadAhead.ToolTip"));
+
+	prop = obs_properties_add_int_slider(props, "read_ahead_mb",
+					     obs_module_text("ReadAheadMB"), 1,
+					     64, 1);
+	obs_property_int_set_suffix(prop, " MB");
+
+	prop = obs_properties_add_bool(props, "jitter_buffer",
+				       obs_module_text("JitterBuffer"));
+	obs_property_set_long_description(
+		prop, obs_module_text("JitterBuffer.ToolTip"));
+
 	obs_properties_add_text(props, "input", obs_module_text("Input"),
 				OBS_TEXT_DEFAULT);
 
@@ -239,6 +276,13 @@ static obs_properties_t *ffmpeg_source_getproperties(void *data)
 	obs_properties_add_bool(props, "caching",
 				obs_module_text("EnableCaching"));
 
+	prop = obs_properties_add_int(props, "cache_budget_mb",
+				      obs_module_text("CacheBudgetMB"), 0,
+				      16384, 64);
+	obs_property_int_set_suffix(prop, " MB");
+	obs_property_set_long_description(
+		prop, obs_module_text("CacheBudgetMB.ToolTip"));
+
 	prop = obs_properties_add_text(props, "ffmpeg_options",
 				       obs_module_text("FFmpegOpts"),
 				       OBS_TEXT_DEFAULT);
@@ -263,6 +307,7 @@ static void dump_source_info(struct ffmpeg_source *s, const char *input,
 		"\trestart_on_activate:     %s\n"
 		"\tclose_when_inactive:     %s\n"
 		"\tenable_caching:          %s\n"
+		"\tcache_budget_mb:         %d\n"
 		"\tffmpeg_options:          %s",
 		input ? input : "(null)",
 		input_format ? input_format : "(null)", s->speed_percent,
@@ -271,7 +316,8 @@ static void dump_source_info(struct ffmpeg_source *s, const char *input,
 		s->is_clear_on_media_end ? "yes" : "no",
 		s->restart_on_activate ? "yes" : "no",
 		s->close_when_inactive ? "yes" : "no",
-		s->enable_caching ? "yes" : "no", s->ffmpeg_options);
+		s->enable_caching ? "yes" : "no", s->cache_budget_mb,
+		s->ffmpeg_options);
 }
 
 static void get_frame(void *opaque, struct obs_source_frame *f)
@@ -347,6 +393,8 @@ static void ffmpeg_source_open(struct ffmpeg_source *s)
 			.path = s->input,
 			.format = s->input_format,
 			.buffering = s->buffering_mb * 1024 * 1024,
+			.read_ahead_ms = s->read_ahead_ms,
+			.read_ahead_bytes = s->read_ahead_mb * 1024 * 1024,
 			.speed = s->speed_percent,
 			.force_range = s->range,
 			.is_linear_alpha = s->is_linear_alpha,
@@ -354,6 +402,8 @@ static void ffmpeg_source_open(struct ffmpeg_source *s)
 			.ffmpeg_options = s->ffmpeg_options,
 			.is_local_file = s->is_local_file || s->seekable,
 			.enable_caching = s->enable_caching,
+			.cache_budget = (int64_t)s->cache_budget_mb * 1024 *
+					1024,
 			.reconnecting = s->reconnecting,
 			.volume = s->volume,
 		};
@@ -432,6 +482,9 @@ static void ffmpeg_source_tick(void *data, float seconds)
 #define SRT_PROTO "srt"
 #define RIST_PROTO "rist"
 
+/* buffers for all but the latest 5% of frames */
+#define JITTER_BUFFER_PERCENTILE 95.0f
+
 static bool requires_mpegts(const char *path)
 {
 	return !astrcmpi_n(path, SRT_PROTO, sizeof(SRT_PROTO) - 1) ||
@@ -500,8 +553,16 @@ static void ffmpeg_source_update(void *data, obs_data_t *settings)
 							   "color_range");
 	s->is_linear_alpha = obs_data_get_bool(settings, "linear_alpha");
 	s->buffering_mb = (int)obs_data_get_int(settings, "buffering_mb");
+	s->read_ahead_ms = is_local_file ? 0
+					 : (int)obs_data_get_int(settings,
+								"read_ahead_ms");
+	s->read_ahead_mb = (int)obs_data_get_int(settings, "read_ahead_mb");
+	s->cache_budget_mb =
+		(int)obs_data_get_int(settings, "cache_budget_mb");
 	s->speed_percent = (int)obs_data_get_int(settings, "speed_percent");
 	s->is_local_file = is_local_file;
+	s->jitter_buffer = !is_local_file &&
+			   obs_data_get_bool(settings, "jitter_buffer");
 	s->seekable = obs_data_get_bool(settings, "seekable");
 	s->volume = obs_data_get_int(settings, "volume");
 	s->ffmpeg_options = ffmpeg_options ? bstrdup(ffmpeg_options) : NULL;
@@ -509,6 +570,9 @@ static void ffmpeg_source_update(void *data, obs_data_t *settings)
 	if (s->speed_percent < 1 || s->speed_percent > 200)
 		s->speed_percent = 100;
 
+	obs_source_set_async_jitter_buffer(
+		s->source, s->jitter_buffer ? JITTER_BUFFER_PERCENTILE : 0.0f);
+
 	if (s->media_valid) {
 		mp_media_free(&s->media);
 		s->media_valid = false;
@@ -549,6 +613,21 @@ static void restart_proc(void *data, calldata_t *cd)
 	UNUSED_PARAMETER(cd);
 }
 
+static void prefetch_proc(void *data, calldata_t *cd)
+{
+	struct ffmpeg_source *s = data;
+
+	if (!s->enable_caching)
+		return;
+
+	if (!s->media_valid)
+		ffmpeg_source_open(s);
+	if (s->media_valid)
+		mp_media_prefetch(&s->media);
+
+	UNUSED_PARAMETER(cd);
+}
+
 static void get_duration(void *data, calldata_t *cd)
 {
 	struct ffmpeg_source *s = data;
@@ -631,11 +710,14 @@ static void get_file_info(void *data, calldata_t *cd)
 			       .height = 0,
 			       .pix_format = 0,
 			       .have_video = false};
+	struct mp_media_io_stats io_stats = {0};
 
 	if (!s->media.fmt) {
 		goto end;
 	}
 
+	mp_media_get_io_stats(&s->media, &io_stats);
+
 	pthread_mutex_lock(&s->media.mutex);
 
 	if (s->media.stopping || !s->media.active) {
@@ -653,6 +735,10 @@ end:
 	calldata_set_int(cd, "height", fi.height);
 	calldata_set_int(cd, "pix_format", fi.pix_format);
 	calldata_set_bool(cd, "have_video", fi.have_video);
+	calldata_set_int(cd, "buffered_bytes", io_stats.buffered_bytes);
+	calldata_set_int(cd, "buffered_ms", io_stats.buffered_ms);
+	calldata_set_int(cd, "underruns", (long long)io_stats.underruns);
+	calldata_set_int(cd, "rebuffer_ms", (long long)io_stats.rebuffer_ms);
 }
 
 static void get_playing(void *data, calldata_t *cd)
@@ -743,6 +829,7 @@ static void *ffmpeg_source_create(obs_data_t *settings, obs_source_t *source)
 
 	proc_handler_t *ph = obs_source_get_proc_handler(source);
 	proc_handler_add(ph, "void restart()", restart_proc, s);
+	proc_handler_add(ph, "void prefetch()", prefetch_proc, s);
 	proc_handler_add(ph, "void get_duration(out int duration)",
 			 get_duration, s);
 	proc_handler_add(ph, "void get_nb_frames(out int num_frames)",
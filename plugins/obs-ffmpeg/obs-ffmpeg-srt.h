@@ -71,6 +71,7 @@ typedef struct SRTContext {
 	int minversion;
 	char *streamid;
 	char *smoother;
+	char *packetfilter;
 	int messageapi;
 	SRT_TRANSTYPE transtype;
 	int linger;
@@ -386,6 +387,12 @@ static int libsrt_set_options_pre(URLContext *h, SRTSOCKET fd)
 	    (s->smoother &&
 	     libsrt_setsockopt(h, fd, SRTO_SMOOTHER, "SRTO_SMOOTHER",
 			       s->smoother, (int)strlen(s->smoother)) < 0) ||
+#endif
+#if SRT_VERSION_VALUE >= 0x010400
+	    (s->packetfilter &&
+	     libsrt_setsockopt(h, fd, SRTO_PACKETFILTER, "SRTO_PACKETFILTER",
+			       s->packetfilter,
+			       (int)strlen(s->packetfilter)) < 0) ||
 #endif
 	    (s->messageapi >= 0 &&
 	     libsrt_setsockopt(h, fd, SRTO_MESSAGEAPI, "SRTO_MESSAGEAPI",
@@ -594,6 +601,7 @@ static void libsrt_set_defaults(SRTContext *s)
 	s->minversion = -1;
 	s->streamid = NULL;
 	s->smoother = NULL;
+	s->packetfilter = NULL;
 	s->messageapi = -1;
 	s->transtype = SRTT_LIVE;
 	s->linger = -1;
@@ -729,6 +737,15 @@ static int libsrt_open(URLContext *h, const char *uri)
 				goto err;
 			}
 		}
+		/* FEC configuration, e.g. fec,cols:10,rows:5,layout:staircase */
+		if (av_find_info_tag(buf, sizeof(buf), "packetfilter", p)) {
+			av_freep(&s->packetfilter);
+			s->packetfilter = av_strdup(buf);
+			if (!s->packetfilter) {
+				ret = AVERROR(ENOMEM);
+				goto err;
+			}
+		}
 		if (av_find_info_tag(buf, sizeof(buf), "messageapi", p)) {
 			s->messageapi = strtol(buf, NULL, 10);
 		}
@@ -764,6 +781,7 @@ static int libsrt_open(URLContext *h, const char *uri)
 
 err:
 	av_freep(&s->smoother);
+	av_freep(&s->packetfilter);
 	av_freep(&s->streamid);
 	srt_cleanup();
 	return ret;
@@ -811,6 +829,12 @@ static int libsrt_write(URLContext *h, const uint8_t *buf, int size)
 	return ret;
 }
 
+static int libsrt_get_stats(URLContext *h, SRT_TRACEBSTATS *perf)
+{
+	SRTContext *s = (SRTContext *)h->priv_data;
+	return srt_bstats(s->fd, perf, 0);
+}
+
 static int libsrt_close(URLContext *h)
 {
 	SRTContext *s = (SRTContext *)h->priv_data;
@@ -840,6 +864,7 @@ static int libsrt_close(URLContext *h)
 		return -1;
 	}
 
+	av_freep(&s->packetfilter);
 	srt_cleanup();
 	blog(LOG_INFO, "[obs-ffmpeg mpegts muxer / libsrt] : closing srt");
 
@@ -132,7 +132,8 @@ static bool vaapi_init_codec(struct vaapi_encoder *enc, const char *path)
 		return false;
 	}
 
-	/* 2. Create software frame and picture */
+	/* 2. Create software frame, which wraps the raw frame's planes for
+	 * uploading rather than holding its own copy */
 	enc->vframe = av_frame_alloc();
 	if (!enc->vframe) {
 		warn("Failed to allocate video frame");
@@ -145,12 +146,6 @@ static bool vaapi_init_codec(struct vaapi_encoder *enc, const char *path)
 	enc->vframe->colorspace = enc->context->colorspace;
 	enc->vframe->color_range = enc->context->color_range;
 
-	ret = av_frame_get_buffer(enc->vframe, base_get_alignment());
-	if (ret < 0) {
-		warn("Failed to allocate vframe: %s", av_err2str(ret));
-		return false;
-	}
-
 	/* 3. set up codec */
 	enc->context->pix_fmt = AV_PIX_FMT_VAAPI;
 	enc->context->hw_frames_ctx = av_buffer_ref(enc->vaframes_ref);
@@ -378,29 +373,11 @@ fail:
 	return NULL;
 }
 
-static inline void copy_data(AVFrame *pic, const struct encoder_frame *frame,
-			     int height, enum AVPixelFormat format)
+static inline void wrap_frame(AVFrame *pic, const struct encoder_frame *frame)
 {
-	int h_chroma_shift, v_chroma_shift;
-	av_pix_fmt_get_chroma_sub_sample(format, &h_chroma_shift,
-					 &v_chroma_shift);
 	for (int plane = 0; plane < MAX_AV_PLANES; plane++) {
-		if (!frame->data[plane])
-			continue;
-
-		int frame_rowsize = (int)frame->linesize[plane];
-		int pic_rowsize = pic->linesize[plane];
-		int bytes = frame_rowsize < pic_rowsize ? frame_rowsize
-							: pic_rowsize;
-		int plane_height = height >> (plane ? v_chroma_shift : 0);
-
-		for (int y = 0; y < plane_height; y++) {
-			int pos_frame = y * frame_rowsize;
-			int pos_pic = y * pic_rowsize;
-
-			memcpy(pic->data[plane] + pos_pic,
-			       frame->data[plane] + pos_frame, bytes);
-		}
+		pic->data[plane] = frame->data[plane];
+		pic->linesize[plane] = (int)frame->linesize[plane];
 	}
 }
 
@@ -425,7 +402,8 @@ static bool vaapi_encode(void *data, struct encoder_frame *frame,
 		goto fail;
 	}
 
-	copy_data(enc->vframe, frame, enc->height, enc->context->pix_fmt);
+	/* the upload copies straight from the raw frame into the surface */
+	wrap_frame(enc->vframe, frame);
 
 	enc->vframe->pts = frame->pts;
 	hwframe->pts = frame->pts;
@@ -478,15 +456,17 @@ static bool vaapi_encode(void *data, struct encoder_frame *frame,
 
 			da_copy_array(enc->buffer, new_packet, size);
 			bfree(new_packet);
+
+			packet->data = enc->buffer.array;
+			packet->size = enc->buffer.num;
 		} else {
-			da_copy_array(enc->buffer, enc->packet->data,
-				      enc->packet->size);
+			memcpy(obs_encoder_packet_alloc(packet,
+							enc->packet->size),
+			       enc->packet->data, enc->packet->size);
 		}
 
 		packet->pts = enc->packet->pts;
 		packet->dts = enc->packet->dts;
-		packet->data = enc->buffer.array;
-		packet->size = enc->buffer.num;
 		packet->type = OBS_ENCODER_VIDEO;
 		packet->keyframe = obs_avc_keyframe(packet->data, packet->size);
 		*received_packet = true;
@@ -200,6 +200,13 @@ static inline void copy_data(AVFrame *pic, const struct encoder_frame *frame,
 							: pic_rowsize;
 		int plane_height = height >> (plane ? v_chroma_shift : 0);
 
+		/* matching strides are the common case, copy planes whole */
+		if (frame_rowsize == pic_rowsize) {
+			memcpy(pic->data[plane], frame->data[plane],
+			       (size_t)pic_rowsize * plane_height);
+			continue;
+		}
+
 		for (int y = 0; y < plane_height; y++) {
 			int pos_frame = y * frame_rowsize;
 			int pos_pic = y * pic_rowsize;
@@ -250,14 +257,18 @@ bool ffmpeg_video_encode(struct ffmpeg_video_encoder *enc,
 			enc->on_first_packet(enc->parent, &av_pkt,
 					     &enc->buffer.da);
 			enc->first_packet = false;
+
+			packet->data = enc->buffer.array;
+			packet->size = enc->buffer.num;
 		} else {
-			da_copy_array(enc->buffer, av_pkt.data, av_pkt.size);
+			/* write into pooled packet data so libobs doesn't
+			 * copy it again for outputs */
+			memcpy(obs_encoder_packet_alloc(packet, av_pkt.size),
+			       av_pkt.data, av_pkt.size);
 		}
 
 		packet->pts = av_pkt.pts;
 		packet->dts = av_pkt.dts;
-		packet->data = enc->buffer.array;
-		packet->size = enc->buffer.num;
 		packet->type = OBS_ENCODER_VIDEO;
 		packet->keyframe = !!(av_pkt.flags & AV_PKT_FLAG_KEY);
 		*received_packet = true;
@@ -26,6 +26,16 @@ static void amf_apply_opt(amf_base *enc, obs_option *opt)
 		else
 			set_hevc_opt(NUM_GOPS_PER_IDR, val);
 
+	} else if (strcmp(opt->name, "async_depth") == 0) {
+
+		int val = atoi(opt->value);
+		if (val < 1 || val > 16) {
+			warn("Invalid value for %s: %s", opt->name, opt->value);
+			return;
+		}
+
+		enc->async_depth = val;
+
 	} else if (strcmp(opt->name, "usage") == 0) {
 
 		if (strcmp(opt->value, "transcoding") == 0) {
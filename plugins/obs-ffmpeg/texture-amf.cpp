@@ -5,11 +5,14 @@
 
 #include "obs-ffmpeg-config.h"
 
+#include <condition_variable>
 #include <unordered_map>
 #include <cstdlib>
 #include <memory>
 #include <string>
 #include <vector>
+#include <thread>
+#include <chrono>
 #include <mutex>
 #include <deque>
 #include <map>
@@ -94,7 +97,22 @@ struct amf_base {
 	AMFRate amf_frame_rate;
 	AMFBufferPtr header;
 
+	/* output is polled for on its own thread, so encode calls only submit
+	 * and pick up whatever has already come out */
+	std::thread query_thread;
+	std::mutex packets_mutex;
+	std::condition_variable packets_cv;
 	std::deque<AMFDataPtr> queued_packets;
+	std::unordered_map<int64_t, uint64_t> submit_times;
+	AMF_RESULT query_result = AMF_OK;
+	int in_flight = 0;
+	int async_depth = 4;
+	bool stop_query = false;
+
+	obs_metric_t *latency_metric = nullptr;
+	uint64_t latency_total = 0;
+	uint64_t latency_max = 0;
+	uint64_t latency_frames = 0;
 
 	AMF_VIDEO_CONVERTER_COLOR_PROFILE_ENUM amf_color_profile;
 	AMF_COLOR_TRANSFER_CHARACTERISTIC_ENUM amf_characteristic;
@@ -484,53 +502,166 @@ static void convert_to_encoder_packet(amf_base *enc, AMFDataPtr &data,
 #define SEC_TO_NSEC 1000000000ULL
 #endif
 
+static void record_latency(amf_base *enc, AMFDataPtr &data, uint64_t ts)
+{
+	int64_t pts;
+	if (data->GetProperty(L"PTS", &pts) != AMF_OK)
+		return;
+
+	auto it = enc->submit_times.find(pts);
+	if (it == enc->submit_times.end())
+		return;
+
+	uint64_t latency = ts - it->second;
+	enc->submit_times.erase(it);
+
+	enc->latency_total += latency;
+	enc->latency_frames++;
+	if (latency > enc->latency_max)
+		enc->latency_max = latency;
+
+	obs_metric_set(enc->latency_metric, (int64_t)latency);
+}
+
+static void amf_query_thread(amf_base *enc)
+{
+	std::unique_lock<std::mutex> lock(enc->packets_mutex);
+
+	while (!enc->stop_query) {
+		if (!enc->in_flight) {
+			enc->packets_cv.wait(lock);
+			continue;
+		}
+
+		lock.unlock();
+
+		AMFDataPtr new_packet;
+		AMF_RESULT res = enc->amf_encoder->QueryOutput(&new_packet);
+		uint64_t ts = os_gettime_ns();
+
+		/* only sleep if the driver doesn't support waiting in
+		 * QueryOutput itself */
+		if (res == AMF_REPEAT && !new_packet)
+			os_sleep_ms(1);
+
+		lock.lock();
+
+		if (res != AMF_REPEAT && res != AMF_OK) {
+			enc->query_result = res;
+			enc->packets_cv.notify_all();
+			break;
+		}
+
+		if (new_packet) {
+			record_latency(enc, new_packet, ts);
+			enc->queued_packets.push_back(new_packet);
+			enc->in_flight--;
+			enc->packets_cv.notify_all();
+		}
+	}
+}
+
+static void start_query_thread(amf_base *enc)
+{
+	const wchar_t *timeout = enc->codec == amf_codec_type::HEVC
+					 ? AMF_VIDEO_ENCODER_HEVC_QUERY_TIMEOUT
+					 : AMF_VIDEO_ENCODER_QUERY_TIMEOUT;
+
+	/* not supported by older drivers, which just don't wait */
+	enc->amf_encoder->SetProperty(timeout, (amf_int64)50);
+
+	std::string name = "amf.";
+	name += obs_encoder_get_name(enc->encoder);
+	name += ".latency_ns";
+	enc->latency_metric = obs_metric_create(name.c_str(), OBS_METRIC_GAUGE);
+
+	enc->query_thread = std::thread(amf_query_thread, enc);
+}
+
+static void stop_query_thread(amf_base *enc)
+{
+	if (!enc->query_thread.joinable())
+		return;
+
+	{
+		std::scoped_lock lock(enc->packets_mutex);
+		enc->stop_query = true;
+		enc->packets_cv.notify_all();
+	}
+
+	enc->query_thread.join();
+
+	if (enc->latency_frames) {
+		double avg = (double)enc->latency_total /
+			     (double)enc->latency_frames / 1000000.0;
+		info("encode latency: %.2f ms average, %.2f ms max", avg,
+		     (double)enc->latency_max / 1000000.0);
+	}
+}
+
 static void amf_encode_base(amf_base *enc, AMFSurface *amf_surf,
 			    encoder_packet *packet, bool *received_packet)
 {
 	auto &queued_packets = enc->queued_packets;
 	uint64_t ts_start = os_gettime_ns();
 	AMF_RESULT res;
+	int64_t pts = 0;
 
 	*received_packet = false;
 
-	bool waiting = true;
-	while (waiting) {
-		/* ----------------------------------- */
-		/* submit frame                        */
+	if (!enc->query_thread.joinable())
+		start_query_thread(enc);
 
-		res = enc->amf_encoder->SubmitInput(amf_surf);
+	amf_surf->GetProperty(L"PTS", &pts);
 
-		if (res == AMF_OK || res == AMF_NEED_MORE_INPUT) {
-			waiting = false;
+	{
+		std::scoped_lock lock(enc->packets_mutex);
+		enc->submit_times[pts] = ts_start;
+	}
 
-		} else if (res == AMF_INPUT_FULL) {
-			os_sleep_ms(1);
+	/* ----------------------------------- */
+	/* submit frame                        */
 
-			uint64_t duration = os_gettime_ns() - ts_start;
-			constexpr uint64_t timeout = 5 * SEC_TO_NSEC;
+	for (;;) {
+		res = enc->amf_encoder->SubmitInput(amf_surf);
 
-			if (duration >= timeout) {
-				throw amf_error("SubmitInput timed out", res);
-			}
-		} else {
+		if (res == AMF_OK || res == AMF_NEED_MORE_INPUT)
+			break;
+		if (res != AMF_INPUT_FULL)
 			throw amf_error("SubmitInput failed", res);
+
+		/* the query thread makes room as packets come out */
+		os_sleep_ms(1);
+
+		uint64_t duration = os_gettime_ns() - ts_start;
+		constexpr uint64_t timeout = 5 * SEC_TO_NSEC;
+
+		if (duration >= timeout) {
+			throw amf_error("SubmitInput timed out", res);
 		}
+	}
 
-		/* ----------------------------------- */
-		/* query as many packets as possible   */
+	std::unique_lock<std::mutex> lock(enc->packets_mutex);
 
-		AMFDataPtr new_packet;
-		do {
-			res = enc->amf_encoder->QueryOutput(&new_packet);
-			if (new_packet)
-				queued_packets.push_back(new_packet);
-
-			if (res != AMF_REPEAT && res != AMF_OK) {
-				throw amf_error("QueryOutput failed", res);
-			}
-		} while (!!new_packet);
+	enc->in_flight++;
+	enc->packets_cv.notify_all();
+
+	/* keep the number of frames in the encoder bounded, but only wait up
+	 * to a frame for output, as frames held back for b-frames or
+	 * lookahead only come out once more input is submitted */
+	if (enc->in_flight > enc->async_depth && queued_packets.empty()) {
+		auto frame_time = std::chrono::nanoseconds(
+			SEC_TO_NSEC * enc->fps_den / enc->fps_num);
+
+		enc->packets_cv.wait_for(lock, frame_time, [enc] {
+			return !enc->queued_packets.empty() ||
+			       enc->query_result != AMF_OK;
+		});
 	}
 
+	if (enc->query_result != AMF_OK)
+		throw amf_error("QueryOutput failed", enc->query_result);
+
 	/* ----------------------------------- */
 	/* return a packet if available        */
 
@@ -539,6 +670,7 @@ static void amf_encode_base(amf_base *enc, AMFSurface *amf_surf,
 
 		amf_out = queued_packets.front();
 		queued_packets.pop_front();
+		lock.unlock();
 
 		*received_packet = true;
 		convert_to_encoder_packet(enc, amf_out, packet);
@@ -888,6 +1020,7 @@ try {
 static void amf_destroy(void *data)
 {
 	amf_base *enc = (amf_base *)data;
+	stop_query_thread(enc);
 	delete enc;
 }
 
@@ -1678,24 +1811,107 @@ static void register_hevc()
 #endif //ENABLE_HEVC
 
 /* ========================================================================= */
-/* Global Stuff                                                              */
+/* Capability Cache                                                          */
 
-extern "C" void amf_load(void)
-try {
-	AMF_RESULT res;
-	HMODULE amf_module_test;
+/* obs-amf-test.exe creates an AMF context on every adapter, which can take
+ * a while on machines with several GPUs, so its output is cached in the
+ * module config directory and reused until the adapters or their drivers
+ * change.  Adapter LUIDs only stay the same until the next reboot, so
+ * adapters are identified by position, PCI IDs and driver version instead. */
 
-	/* Check if the DLL is present before running the more expensive */
-	/* obs-amf-test.exe, but load it as data so it can't crash us    */
-	amf_module_test =
-		LoadLibraryExW(AMF_DLL_NAME, nullptr, LOAD_LIBRARY_AS_DATAFILE);
-	if (!amf_module_test)
-		throw "No AMF library";
-	FreeLibrary(amf_module_test);
+#define AMF_CAPS_CACHE "amf-caps.ini"
 
-	/* ----------------------------------- */
-	/* Check for AVC/HEVC support          */
+static std::string get_adapters_key()
+{
+	HMODULE dxgi = get_lib("DXGI.dll");
+	CREATEDXGIFACTORY1PROC create_dxgi;
+	ComPtr<IDXGIFactory1> factory;
+	ComPtr<IDXGIAdapter1> adapter;
+	std::string key;
+	HRESULT hr;
+
+	if (!dxgi)
+		return key;
+
+	create_dxgi = (CREATEDXGIFACTORY1PROC)GetProcAddress(
+		dxgi, "CreateDXGIFactory1");
+	if (!create_dxgi)
+		return key;
+
+	hr = create_dxgi(__uuidof(IDXGIFactory1), (void **)&factory);
+	if (FAILED(hr))
+		return key;
+
+	for (UINT i = 0; factory->EnumAdapters1(i, &adapter) == S_OK; i++) {
+		DXGI_ADAPTER_DESC1 desc;
+		LARGE_INTEGER umd_ver;
+		char str[96];
+
+		if (FAILED(adapter->GetDesc1(&desc)))
+			return std::string();
+
+		/* the only way DXGI reports the driver version */
+		hr = adapter->CheckInterfaceSupport(__uuidof(IDXGIDevice),
+						    &umd_ver);
+		if (FAILED(hr))
+			umd_ver.QuadPart = 0;
+
+		snprintf(str, sizeof(str), "%u:%04X:%04X:%08X:%02X:%016llX;",
+			 i, desc.VendorId, desc.DeviceId, desc.SubSysId,
+			 desc.Revision, (unsigned long long)umd_ver.QuadPart);
+		key += str;
+	}
+
+	return key;
+}
+
+static inline std::string get_cache_key_line(const std::string &key)
+{
+	return "# adapters: " + key + "\n";
+}
+
+static bool load_cached_caps(const std::string &key, std::string &caps_str)
+{
+	if (key.empty())
+		return false;
+
+	BPtr<char> path = obs_module_config_path(AMF_CAPS_CACHE);
+	if (!path)
+		return false;
+
+	BPtr<char> cache = os_quick_read_utf8_file(path);
+	if (!cache)
+		return false;
+
+	std::string key_line = get_cache_key_line(key);
+	if (strncmp(cache, key_line.c_str(), key_line.size()) != 0)
+		return false;
+
+	/* the key line is an ini comment, so the whole file can be parsed */
+	caps_str = cache.Get();
+	return caps_str.size() > key_line.size();
+}
+
+static void save_cached_caps(const std::string &key,
+			     const std::string &caps_str)
+{
+	if (key.empty())
+		return;
+
+	BPtr<char> dir = obs_module_config_path(nullptr);
+	BPtr<char> path = obs_module_config_path(AMF_CAPS_CACHE);
+	if (!dir || !path)
+		return;
+
+	std::string cache = get_cache_key_line(key) + caps_str;
 
+	os_mkdirs(dir);
+	os_quick_write_utf8_file_safe(path, cache.c_str(), cache.size(),
+				      false, "tmp", nullptr);
+}
+
+static std::string run_amf_test()
+{
 	BPtr<char> test_exe = os_get_executable_path_ptr("obs-amf-test.exe");
 	std::string caps_str;
 
@@ -1714,11 +1930,43 @@ try {
 	}
 
 	os_process_pipe_destroy(pp);
+	return caps_str;
+}
+
+/* ========================================================================= */
+/* Global Stuff                                                              */
+
+extern "C" void amf_load(void)
+try {
+	AMF_RESULT res;
+	HMODULE amf_module_test;
 
-	if (caps_str.empty())
-		throw "Seems the AMF test subprocess crashed. "
-		      "Better there than here I guess. "
-		      "Let's just skip loading AMF then I suppose.";
+	/* Check if the DLL is present before running the more expensive */
+	/* obs-amf-test.exe, but load it as data so it can't crash us    */
+	amf_module_test =
+		LoadLibraryExW(AMF_DLL_NAME, nullptr, LOAD_LIBRARY_AS_DATAFILE);
+	if (!amf_module_test)
+		throw "No AMF library";
+	FreeLibrary(amf_module_test);
+
+	/* ----------------------------------- */
+	/* Check for AVC/HEVC support          */
+
+	std::string adapters_key = get_adapters_key();
+	std::string caps_str;
+
+	if (load_cached_caps(adapters_key, caps_str)) {
+		blog(LOG_DEBUG, "%s: using cached AMF caps", __FUNCTION__);
+	} else {
+		caps_str = run_amf_test();
+
+		if (caps_str.empty())
+			throw "Seems the AMF test subprocess crashed. "
+			      "Better there than here I guess. "
+			      "Let's just skip loading AMF then I suppose.";
+
+		save_cached_caps(adapters_key, caps_str);
+	}
 
 	ConfigFile config;
 	if (config.OpenString(caps_str.c_str()) != 0)
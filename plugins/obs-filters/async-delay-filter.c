@@ -1,6 +1,8 @@
 #include <obs-module.h>
 #include <util/circlebuf.h>
+#include <util/dstr.h>
 #include <util/util_uint64.h>
+#include <inttypes.h>
 
 #ifndef SEC_TO_NSEC
 #define SEC_TO_NSEC 1000000000ULL
@@ -11,15 +13,24 @@
 #endif
 
 #define SETTING_DELAY_MS "delay_ms"
+#define SETTING_MAX_MEMORY "max_memory_mb"
 
 #define TEXT_DELAY_MS obs_module_text("DelayMs")
+#define TEXT_MAX_MEMORY obs_module_text("AsyncDelay.MaxMemory")
+#define TEXT_MEMORY_USAGE obs_module_text("AsyncDelay.MemoryUsage")
 
 struct async_delay_data {
 	obs_source_t *context;
 
-	/* contains struct obs_source_frame* */
+	/* contains struct obs_source_frame*, the frames themselves stay in
+	 * the parent's async frame cache and go back to it when released */
 	struct circlebuf video_frames;
 
+	/* only read elsewhere for display purposes */
+	uint64_t video_bytes;
+	uint64_t max_video_bytes;
+	bool budget_warned;
+
 	/* stores the audio data */
 	struct circlebuf audio_frames;
 	struct obs_audio_data audio_output;
@@ -40,6 +51,35 @@ static const char *async_delay_filter_name(void *unused)
 	return obs_module_text("AsyncDelayFilter");
 }
 
+static inline bool half_height_plane(enum video_format format, size_t plane)
+{
+	switch (format) {
+	case VIDEO_FORMAT_I420:
+	case VIDEO_FORMAT_NV12:
+	case VIDEO_FORMAT_I010:
+	case VIDEO_FORMAT_P010:
+		return plane > 0;
+	case VIDEO_FORMAT_I40A:
+		return plane == 1 || plane == 2;
+	default:
+		return false;
+	}
+}
+
+static uint64_t frame_size(const struct obs_source_frame *frame)
+{
+	uint64_t size = 0;
+
+	for (size_t i = 0; i < MAX_AV_PLANES && frame->data[i]; i++) {
+		uint32_t height = half_height_plane(frame->format, i)
+					  ? (frame->height + 1) / 2
+					  : frame->height;
+		size += (uint64_t)frame->linesize[i] * height;
+	}
+
+	return size;
+}
+
 static void free_video_data(struct async_delay_data *filter,
 			    obs_source_t *parent)
 {
@@ -50,6 +90,8 @@ static void free_video_data(struct async_delay_data *filter,
 				    sizeof(struct obs_source_frame *));
 		obs_source_release_frame(parent, frame);
 	}
+
+	filter->video_bytes = 0;
 }
 
 static inline void free_audio_packet(struct obs_audio_data *audio)
@@ -80,6 +122,10 @@ static void async_delay_filter_update(void *data, obs_data_t *settings)
 	if (new_interval < filter->interval)
 		free_video_data(filter, obs_filter_get_parent(filter->context));
 
+	filter->max_video_bytes =
+		(uint64_t)obs_data_get_int(settings, SETTING_MAX_MEMORY) *
+		1024 * 1024;
+	filter->budget_warned = false;
 	filter->reset_audio = true;
 	filter->reset_video = true;
 	filter->interval = new_interval;
@@ -120,10 +166,33 @@ static obs_properties_t *async_delay_filter_properties(void *data)
 						   TEXT_DELAY_MS, 0, 20000, 1);
 	obs_property_int_set_suffix(p, " ms");
 
-	UNUSED_PARAMETER(data);
+	p = obs_properties_add_int(props, SETTING_MAX_MEMORY, TEXT_MAX_MEMORY,
+				   64, 65536, 64);
+	obs_property_int_set_suffix(p, " MB");
+
+	if (data) {
+		struct async_delay_data *filter = data;
+		struct dstr usage = {0};
+		char mb[32];
+
+		snprintf(mb, sizeof(mb), "%.1f",
+			 (double)filter->video_bytes / (1024.0 * 1024.0));
+		dstr_copy(&usage, TEXT_MEMORY_USAGE);
+		dstr_replace(&usage, "%1", mb);
+
+		obs_properties_add_text(props, "memory_usage", usage.array,
+					OBS_TEXT_INFO);
+		dstr_free(&usage);
+	}
+
 	return props;
 }
 
+static void async_delay_filter_defaults(obs_data_t *settings)
+{
+	obs_data_set_default_int(settings, SETTING_MAX_MEMORY, 2048);
+}
+
 static void async_delay_filter_remove(void *data, obs_source_t *parent)
 {
 	struct async_delay_data *filter = data;
@@ -162,13 +231,30 @@ async_delay_filter_video(void *data, struct obs_source_frame *frame)
 			    sizeof(struct obs_source_frame *));
 	circlebuf_peek_front(&filter->video_frames, &output,
 			     sizeof(struct obs_source_frame *));
+	filter->video_bytes += frame_size(frame);
 
 	cur_interval = frame->timestamp - output->timestamp;
-	if (!filter->video_delay_reached && cur_interval < filter->interval)
-		return NULL;
+	if (!filter->video_delay_reached && cur_interval < filter->interval) {
+		if (filter->video_bytes <= filter->max_video_bytes)
+			return NULL;
+
+		/* letting the oldest frame out early is what keeps the
+		 * buffer within budget, at the cost of a shorter delay */
+		if (!filter->budget_warned) {
+			blog(LOG_WARNING,
+			     "[async delay: '%s'] Delayed frames would use more "
+			     "than %" PRIu64 " MB, limiting delay to %" PRIu64
+			     " ms",
+			     obs_source_get_name(filter->context),
+			     filter->max_video_bytes / (1024 * 1024),
+			     (uint64_t)(cur_interval / MSEC_TO_NSEC));
+			filter->budget_warned = true;
+		}
+	}
 
 	circlebuf_pop_front(&filter->video_frames, NULL,
 			    sizeof(struct obs_source_frame *));
+	filter->video_bytes -= frame_size(output);
 
 	if (!filter->video_delay_reached)
 		filter->video_delay_reached = true;
@@ -240,6 +326,7 @@ struct obs_source_info async_delay_filter = {
 	.destroy = async_delay_filter_destroy,
 	.update = async_delay_filter_update,
 	.get_properties = async_delay_filter_properties,
+	.get_defaults = async_delay_filter_defaults,
 	.filter_video = async_delay_filter_video,
 #ifdef DELAY_AUDIO
 	.filter_audio = async_delay_filter_audio,
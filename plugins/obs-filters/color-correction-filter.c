@@ -727,6 +727,49 @@ static void color_correction_filter_defaults_v2(obs_data_t *settings)
 	obs_data_set_default_int(settings, SETTING_COLOR_ADD, 0x00000000);
 }
 
+/*
+ * When the filters around this one only change each pixel on their own as
+ * well, OBS can draw all of them in a single pass.  The stage below does the
+ * same thing as PSColorFilterRGBA in the .effect file.
+ */
+static const char color_correction_stage_code[] =
+	"uniform float $gamma;\n"
+	"uniform float4x4 $color_matrix;\n"
+	"\n"
+	"float4 $process(float4 rgba)\n"
+	"{\n"
+	"\trgba.rgb = max(float3(0.0, 0.0, 0.0), rgba.rgb / rgba.a);\n"
+	"\trgba.rgb = pow(rgba.rgb, float3($gamma, $gamma, $gamma));\n"
+	"\trgba = mul($color_matrix, rgba);\n"
+	"\trgba.rgb *= rgba.a;\n"
+	"\treturn rgba;\n"
+	"}\n";
+
+static void color_correction_stage_set_params(void *data, gs_effect_t *effect,
+					      const char *prefix)
+{
+	struct color_correction_filter_data_v2 *filter = data;
+
+	gs_effect_set_float(obs_pixel_stage_get_param(effect, prefix, "gamma"),
+			    filter->gamma);
+	gs_effect_set_matrix4(obs_pixel_stage_get_param(effect, prefix,
+							"color_matrix"),
+			      &filter->final_matrix);
+}
+
+static const struct obs_pixel_stage color_correction_stage = {
+	.name = "color_filter",
+	.code = color_correction_stage_code,
+	.set_params = color_correction_stage_set_params,
+};
+
+static const struct obs_pixel_stage *
+color_correction_filter_get_pixel_stage(void *data)
+{
+	UNUSED_PARAMETER(data);
+	return &color_correction_stage;
+}
+
 static enum gs_color_space color_correction_filter_get_color_space(
 	void *data, size_t count, const enum gs_color_space *preferred_spaces)
 {
@@ -780,4 +823,5 @@ struct obs_source_info color_filter_v2 = {
 	.get_properties = color_correction_filter_properties_v2,
 	.get_defaults = color_correction_filter_defaults_v2,
 	.video_get_color_space = color_correction_filter_get_color_space,
+	.get_pixel_stage = color_correction_filter_get_pixel_stage,
 };
@@ -3,6 +3,8 @@
 #include <graphics/image-file.h>
 #include <util/dstr.h>
 #include <util/platform.h>
+#include <util/threading.h>
+#include <sys/stat.h>
 
 /* clang-format off */
 
@@ -25,15 +27,43 @@ enum clut_dimension {
 	CLUT_3D,
 };
 
+/* LUTs are shared by every filter using the same file.  They're parsed on a
+ * thread of their own and uploaded the first time a filter renders with
+ * them, the filter passes its source through until then.  Parsed .cube files
+ * are also cached in the module's config directory, so each one only ever
+ * has to be parsed once. */
+struct clut {
+	struct clut *next;
+	char *file;
+	long refs;
+
+	pthread_t thread;
+	bool thread_created;
+	os_event_t *loaded;
+
+	enum clut_dimension dim;
+	uint32_t width;
+	enum gs_color_format format;
+	bool is_image;
+	struct vec3 domain_min;
+	struct vec3 domain_max;
+	void *data;
+
+	gs_texture_t *texture;
+	bool uploaded;
+};
+
+static pthread_mutex_t cluts_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct clut *first_clut = NULL;
+
 struct lut_filter_data {
 	obs_source_t *context;
 	gs_effect_t *effect;
 	gs_texture_t *target;
 
-	gs_image_file_t image;
-
-	uint32_t cube_width;
-	void *cube_data;
+	struct clut *clut;
+	bool clut_ready;
+	bool passthrough_alpha;
 
 	char *file;
 	float clut_amount;
@@ -51,10 +81,10 @@ static const char *color_grade_filter_get_name(void *unused)
 	return obs_module_text("ColorGradeFilter");
 }
 
-static gs_texture_t *make_clut_texture_png(const enum gs_color_format format,
-					   const uint32_t image_width,
-					   const uint32_t image_height,
-					   const uint8_t *data)
+static uint8_t *make_clut_data_png(const enum gs_color_format format,
+				   const uint32_t image_width,
+				   const uint32_t image_height,
+				   const uint8_t *data)
 {
 	if (image_width % LUT_WIDTH != 0)
 		return NULL;
@@ -91,12 +121,7 @@ static gs_texture_t *make_clut_texture_png(const enum gs_color_format format,
 		}
 	}
 
-	gs_texture_t *const texture =
-		gs_voltexture_create(LUT_WIDTH, LUT_WIDTH, LUT_WIDTH, format, 1,
-				     (const uint8_t **)&buffer, 0);
-	bfree(buffer);
-
-	return texture;
+	return buffer;
 }
 
 static bool get_cube_entry(FILE *const file, float *const red,
@@ -248,130 +273,426 @@ static void *load_cube_file(const char *const path, uint32_t *const width,
 	return data;
 }
 
-static void color_grade_filter_update(void *data, obs_data_t *settings)
+struct clut_cache_header {
+	char magic[8];
+	int64_t source_size;
+	int64_t source_mtime;
+	uint32_t path_len;
+	uint32_t dim;
+	uint32_t width;
+	float domain_min[3];
+	float domain_max[3];
+};
+
+static const char clut_cache_magic[8] = {'O', 'B', 'S', 'C',
+					 'L', 'U', 'T', '1'};
+
+static inline size_t clut_data_size(enum clut_dimension dim, uint32_t width)
 {
-	struct lut_filter_data *filter = data;
+	const size_t texels = dim == CLUT_1D
+				      ? (size_t)width
+				      : (size_t)width * width * width;
+	return texels * 4 * sizeof(struct half);
+}
 
-	const char *path = obs_data_get_string(settings, SETTING_IMAGE_PATH);
-	if (path && (*path == '\0'))
-		path = NULL;
+static char *get_clut_cache_path(const char *file)
+{
+	struct dstr name = {0};
+	uint64_t hash = 14695981039346656037ULL;
+	char *path;
 
-	const double clut_amount =
-		obs_data_get_double(settings, SETTING_CLUT_AMOUNT);
-	const bool passthrough_alpha =
-		obs_data_get_bool(settings, SETTING_PASSTHROUGH_ALPHA);
+	for (const char *c = file; *c; c++) {
+		hash ^= (uint8_t)*c;
+		hash *= 1099511628211ULL;
+	}
 
-	bfree(filter->file);
-	if (path)
-		filter->file = bstrdup(path);
-	else
-		filter->file = NULL;
+	dstr_printf(&name, "lut_cache/%016llx.bin", (unsigned long long)hash);
+	path = obs_module_config_path(name.array);
+	dstr_free(&name);
+	return path;
+}
 
-	bfree(filter->cube_data);
-	filter->cube_data = NULL;
+static void fill_clut_cache_header(struct clut_cache_header *header,
+				   const char *file)
+{
+	struct stat st;
 
-	obs_enter_graphics();
-	gs_image_file_free(&filter->image);
-	gs_voltexture_destroy(filter->target);
-	filter->target = NULL;
-	obs_leave_graphics();
+	memset(header, 0, sizeof(*header));
+	memcpy(header->magic, clut_cache_magic, sizeof(header->magic));
+	header->path_len = (uint32_t)strlen(file);
 
-	enum clut_dimension clut_dim = CLUT_3D;
-	const char *clut_texture_name = "clut_3d";
-	const char *tech_name = "Draw3D";
+	if (os_stat(file, &st) == 0) {
+		header->source_size = (int64_t)st.st_size;
+		header->source_mtime = (int64_t)st.st_mtime;
+	}
+}
+
+static bool read_clut_cache(struct clut *clut)
+{
+	struct clut_cache_header expected;
+	struct clut_cache_header header;
+	char *cache_path = get_clut_cache_path(clut->file);
+	char *cached_file = NULL;
+	bool success = false;
+	FILE *f;
+
+	fill_clut_cache_header(&expected, clut->file);
+
+	f = cache_path ? os_fopen(cache_path, "rb") : NULL;
+	bfree(cache_path);
+	if (!f)
+		return false;
+
+	if (fread(&header, sizeof(header), 1, f) != 1)
+		goto fail;
+	if (memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 ||
+	    header.source_size != expected.source_size ||
+	    header.source_mtime != expected.source_mtime ||
+	    header.path_len != expected.path_len)
+		goto fail;
+	if (header.dim != CLUT_1D && header.dim != CLUT_3D)
+		goto fail;
+	if (!header.width ||
+	    header.width > (header.dim == CLUT_1D ? 65536u : 256u))
+		goto fail;
+
+	cached_file = bmalloc(header.path_len + 1);
+	if (fread(cached_file, 1, header.path_len, f) != header.path_len)
+		goto fail;
+	cached_file[header.path_len] = 0;
+	if (strcmp(cached_file, clut->file) != 0)
+		goto fail;
+
+	const size_t size =
+		clut_data_size((enum clut_dimension)header.dim, header.width);
+	clut->data = bmalloc(size);
+	if (fread(clut->data, 1, size, f) != size) {
+		bfree(clut->data);
+		clut->data = NULL;
+		goto fail;
+	}
+
+	clut->dim = (enum clut_dimension)header.dim;
+	clut->width = header.width;
+	clut->format = GS_RGBA16F;
+	vec3_set(&clut->domain_min, header.domain_min[0], header.domain_min[1],
+		 header.domain_min[2]);
+	vec3_set(&clut->domain_max, header.domain_max[0], header.domain_max[1],
+		 header.domain_max[2]);
+	success = true;
+
+fail:
+	bfree(cached_file);
+	fclose(f);
+	return success;
+}
+
+static void write_clut_cache(const struct clut *clut)
+{
+	struct clut_cache_header header;
+	char *cache_path = get_clut_cache_path(clut->file);
+	struct dstr temp_path = {0};
+	bool success;
+	FILE *f;
+
+	if (!cache_path)
+		return;
+
+	fill_clut_cache_header(&header, clut->file);
+	header.dim = (uint32_t)clut->dim;
+	header.width = clut->width;
+	header.domain_min[0] = clut->domain_min.x;
+	header.domain_min[1] = clut->domain_min.y;
+	header.domain_min[2] = clut->domain_min.z;
+	header.domain_max[0] = clut->domain_max.x;
+	header.domain_max[1] = clut->domain_max.y;
+	header.domain_max[2] = clut->domain_max.z;
+
+	const size_t size = clut_data_size(clut->dim, clut->width);
+
+	char *dir = obs_module_config_path("lut_cache");
+	os_mkdirs(dir);
+	bfree(dir);
+
+	dstr_printf(&temp_path, "%s.tmp", cache_path);
+
+	f = os_fopen(temp_path.array, "wb");
+	if (f) {
+		success = fwrite(&header, sizeof(header), 1, f) == 1 &&
+			  fwrite(clut->file, 1, header.path_len, f) ==
+				  header.path_len &&
+			  fwrite(clut->data, 1, size, f) == size;
+		fclose(f);
+
+		if (!success || os_safe_replace(cache_path, temp_path.array,
+						NULL) != 0)
+			os_unlink(temp_path.array);
+	}
+
+	dstr_free(&temp_path);
+	bfree(cache_path);
+}
+
+static void load_clut(struct clut *clut)
+{
+	const char *const ext = os_get_path_extension(clut->file);
+
+	vec3_set(&clut->domain_min, 0.0f, 0.0f, 0.0f);
+	vec3_set(&clut->domain_max, 1.0f, 1.0f, 1.0f);
+
+	if (ext && astrcmpi(ext, ".cube") == 0) {
+		if (read_clut_cache(clut))
+			return;
+
+		clut->dim = CLUT_3D;
+		clut->format = GS_RGBA16F;
+		clut->data = load_cube_file(clut->file, &clut->width,
+					    &clut->domain_min,
+					    &clut->domain_max, &clut->dim);
+		if (clut->data)
+			write_clut_cache(clut);
+	} else {
+		gs_image_file_t image;
+
+		gs_image_file_init(&image, clut->file);
+		if (image.loaded && image.texture_data)
+			clut->data = make_clut_data_png(image.format, image.cx,
+							image.cy,
+							image.texture_data);
+
+		clut->dim = CLUT_3D;
+		clut->width = LUT_WIDTH;
+		clut->format = image.format;
+		clut->is_image = true;
+		gs_image_file_free(&image);
+	}
+}
+
+static void *clut_thread(void *data)
+{
+	struct clut *clut = data;
 
-	if (path) {
-		vec3_set(&filter->domain_min, 0.0f, 0.0f, 0.0f);
-		vec3_set(&filter->domain_max, 1.0f, 1.0f, 1.0f);
-
-		const char *const ext = os_get_path_extension(path);
-		if (ext && astrcmpi(ext, ".cube") == 0) {
-			filter->cube_data = load_cube_file(
-				path, &filter->cube_width, &filter->domain_min,
-				&filter->domain_max, &clut_dim);
-		} else {
-			gs_image_file_init(&filter->image, path);
-			filter->cube_width = LUT_WIDTH;
+	os_set_thread_name("color grade LUT loader");
+	load_clut(clut);
+	os_event_signal(clut->loaded);
+	return NULL;
+}
+
+static struct clut *clut_acquire(const char *file)
+{
+	struct clut *clut;
+
+	pthread_mutex_lock(&cluts_mutex);
+
+	for (clut = first_clut; clut; clut = clut->next) {
+		if (strcmp(clut->file, file) == 0) {
+			clut->refs++;
+			pthread_mutex_unlock(&cluts_mutex);
+			return clut;
 		}
+	}
+
+	clut = bzalloc(sizeof(*clut));
+	clut->file = bstrdup(file);
+	clut->refs = 1;
+	os_event_init(&clut->loaded, OS_EVENT_TYPE_MANUAL);
+
+	clut->thread_created =
+		pthread_create(&clut->thread, NULL, clut_thread, clut) == 0;
+	if (!clut->thread_created) {
+		load_clut(clut);
+		os_event_signal(clut->loaded);
+	}
+
+	clut->next = first_clut;
+	first_clut = clut;
+
+	pthread_mutex_unlock(&cluts_mutex);
+	return clut;
+}
+
+static void clut_release(struct clut *clut)
+{
+	struct clut **prev;
+
+	if (!clut)
+		return;
 
-		if (clut_dim == CLUT_1D) {
-			clut_texture_name = "clut_1d";
-			tech_name = "Draw1D";
-		} else if ((filter->domain_min.x > 0.f) ||
-			   (filter->domain_min.y > 0.f) ||
-			   (filter->domain_min.z > 0.f) ||
-			   (filter->domain_max.x < 1.f) ||
-			   (filter->domain_max.y < 1.f) ||
-			   (filter->domain_max.z < 1.f)) {
-			tech_name = "DrawDomain3D";
-		} else if (clut_amount < 1.0) {
-			tech_name = "DrawAmount3D";
-		} else if (!passthrough_alpha) {
-			tech_name = "DrawAlpha3D";
+	pthread_mutex_lock(&cluts_mutex);
+	if (--clut->refs > 0) {
+		pthread_mutex_unlock(&cluts_mutex);
+		return;
+	}
+
+	for (prev = &first_clut; *prev; prev = &(*prev)->next) {
+		if (*prev == clut) {
+			*prev = clut->next;
+			break;
 		}
 	}
+	pthread_mutex_unlock(&cluts_mutex);
+
+	if (clut->thread_created)
+		pthread_join(clut->thread, NULL);
 
 	obs_enter_graphics();
+	if (clut->dim == CLUT_1D)
+		gs_texture_destroy(clut->texture);
+	else
+		gs_voltexture_destroy(clut->texture);
+	obs_leave_graphics();
 
-	if (path) {
-		if (filter->image.loaded) {
-			filter->target = make_clut_texture_png(
-				filter->image.format, filter->image.cx,
-				filter->image.cy, filter->image.texture_data);
-			const float width_i = 1.0f / (float)LUT_WIDTH;
-			const float clut_scale = 1.0f - width_i;
-			const float offset = 0.5f * width_i;
-			vec3_set(&filter->clut_scale, clut_scale, clut_scale,
-				 clut_scale);
-			vec3_set(&filter->clut_offset, offset, offset, offset);
-		} else if (filter->cube_data) {
-			const uint32_t width = filter->cube_width;
-			if (clut_dim == CLUT_1D) {
-				filter->target = gs_texture_create(
-					width, 1, GS_RGBA16F, 1,
-					(const uint8_t **)&filter->cube_data,
-					0);
-			} else {
-				filter->target = gs_voltexture_create(
-					width, width, width, GS_RGBA16F, 1,
-					(const uint8_t **)&filter->cube_data,
-					0);
-			}
+	os_event_destroy(clut->loaded);
+	bfree(clut->data);
+	bfree(clut->file);
+	bfree(clut);
+}
+
+/* only called from the graphics thread, returns NULL while the LUT is still
+ * being parsed */
+static gs_texture_t *clut_get_texture(struct clut *clut, bool *ready)
+{
+	*ready = false;
+
+	if (!clut)
+		return NULL;
+
+	if (!clut->uploaded) {
+		if (os_event_try(clut->loaded) != 0)
+			return NULL;
+
+		if (clut->data) {
+			const uint8_t *data = clut->data;
+			const uint32_t width = clut->width;
+
+			if (clut->dim == CLUT_1D)
+				clut->texture = gs_texture_create(
+					width, 1, clut->format, 1, &data, 0);
+			else
+				clut->texture = gs_voltexture_create(
+					width, width, width, clut->format, 1,
+					&data, 0);
 
-			struct vec3 domain_scale;
-			vec3_sub(&domain_scale, &filter->domain_max,
-				 &filter->domain_min);
-
-			const float width_minus_one = (float)(width - 1);
-			vec3_set(&filter->clut_scale, width_minus_one,
-				 width_minus_one, width_minus_one);
-			vec3_div(&filter->clut_scale, &filter->clut_scale,
-				 &domain_scale);
-
-			vec3_neg(&filter->clut_offset, &filter->domain_min);
-			vec3_mul(&filter->clut_offset, &filter->clut_offset,
-				 &filter->clut_scale);
-
-			/* want normalized UVW */
-			vec3_divf(&filter->clut_scale, &filter->clut_scale,
-				  (float)width);
-			vec3_addf(&filter->clut_offset, &filter->clut_offset,
-				  0.5f);
-			vec3_divf(&filter->clut_offset, &filter->clut_offset,
-				  (float)width);
+			bfree(clut->data);
+			clut->data = NULL;
 		}
+
+		clut->uploaded = true;
+	}
+
+	*ready = true;
+	return clut->texture;
+}
+
+static void update_clut_params(struct lut_filter_data *filter,
+			       const struct clut *clut)
+{
+	const char *clut_texture_name = "clut_3d";
+	const char *tech_name = "Draw3D";
+
+	filter->domain_min = clut->domain_min;
+	filter->domain_max = clut->domain_max;
+
+	if (clut->dim == CLUT_1D) {
+		clut_texture_name = "clut_1d";
+		tech_name = "Draw1D";
+	} else if ((filter->domain_min.x > 0.f) ||
+		   (filter->domain_min.y > 0.f) ||
+		   (filter->domain_min.z > 0.f) ||
+		   (filter->domain_max.x < 1.f) ||
+		   (filter->domain_max.y < 1.f) ||
+		   (filter->domain_max.z < 1.f)) {
+		tech_name = "DrawDomain3D";
+	} else if (filter->clut_amount < 1.0f) {
+		tech_name = "DrawAmount3D";
+	} else if (!filter->passthrough_alpha) {
+		tech_name = "DrawAlpha3D";
+	}
+
+	if (clut->is_image) {
+		const float width_i = 1.0f / (float)LUT_WIDTH;
+		const float clut_scale = 1.0f - width_i;
+		const float offset = 0.5f * width_i;
+		vec3_set(&filter->clut_scale, clut_scale, clut_scale,
+			 clut_scale);
+		vec3_set(&filter->clut_offset, offset, offset, offset);
+	} else {
+		const uint32_t width = clut->width;
+
+		struct vec3 domain_scale;
+		vec3_sub(&domain_scale, &filter->domain_max,
+			 &filter->domain_min);
+
+		const float width_minus_one = (float)(width - 1);
+		vec3_set(&filter->clut_scale, width_minus_one, width_minus_one,
+			 width_minus_one);
+		vec3_div(&filter->clut_scale, &filter->clut_scale,
+			 &domain_scale);
+
+		vec3_neg(&filter->clut_offset, &filter->domain_min);
+		vec3_mul(&filter->clut_offset, &filter->clut_offset,
+			 &filter->clut_scale);
+
+		/* want normalized UVW */
+		vec3_divf(&filter->clut_scale, &filter->clut_scale,
+			  (float)width);
+		vec3_addf(&filter->clut_offset, &filter->clut_offset, 0.5f);
+		vec3_divf(&filter->clut_offset, &filter->clut_offset,
+			  (float)width);
 	}
 
-	filter->clut_amount = (float)clut_amount;
 	filter->clut_texture_name = clut_texture_name;
 	filter->tech_name = tech_name;
+}
 
-	char *effect_path = obs_module_file("color_grade_filter.effect");
-	gs_effect_destroy(filter->effect);
-	filter->effect = gs_effect_create_from_file(effect_path, NULL);
-	bfree(effect_path);
+static void color_grade_filter_update(void *data, obs_data_t *settings)
+{
+	struct lut_filter_data *filter = data;
+
+	const char *path = obs_data_get_string(settings, SETTING_IMAGE_PATH);
+	if (path && (*path == '\0'))
+		path = NULL;
+
+	const double clut_amount =
+		obs_data_get_double(settings, SETTING_CLUT_AMOUNT);
+	const bool passthrough_alpha =
+		obs_data_get_bool(settings, SETTING_PASSTHROUGH_ALPHA);
+
+	struct clut *old_clut = NULL;
+	struct clut *new_clut = NULL;
+
+	/* only pick up a different LUT if the file actually changed, the
+	 * amount and alpha settings don't need it parsed again */
+	const bool file_changed = !path || !filter->file ||
+				  strcmp(path, filter->file) != 0;
+	if (file_changed && path)
+		new_clut = clut_acquire(path);
+
+	obs_enter_graphics();
+
+	if (file_changed) {
+		old_clut = filter->clut;
+		filter->clut = new_clut;
+		filter->target = NULL;
+
+		bfree(filter->file);
+		filter->file = path ? bstrdup(path) : NULL;
+	}
+
+	filter->clut_amount = (float)clut_amount;
+	filter->passthrough_alpha = passthrough_alpha;
+	filter->clut_ready = false;
+
+	if (!filter->effect) {
+		char *effect_path =
+			obs_module_file("color_grade_filter.effect");
+		filter->effect = gs_effect_create_from_file(effect_path, NULL);
+		bfree(effect_path);
+	}
 
 	obs_leave_graphics();
+
+	clut_release(old_clut);
 }
 
 static void color_grade_filter_defaults(obs_data_t *settings)
@@ -437,11 +758,9 @@ static void color_grade_filter_destroy(void *data)
 
 	obs_enter_graphics();
 	gs_effect_destroy(filter->effect);
-	gs_voltexture_destroy(filter->target);
-	gs_image_file_free(&filter->image);
 	obs_leave_graphics();
 
-	bfree(filter->cube_data);
+	clut_release(filter->clut);
 	bfree(filter->file);
 	bfree(filter);
 }
@@ -453,6 +772,13 @@ static void color_grade_filter_render(void *data, gs_effect_t *effect)
 	struct lut_filter_data *filter = data;
 	obs_source_t *target = obs_filter_get_target(filter->context);
 
+	if (!filter->clut_ready) {
+		filter->target =
+			clut_get_texture(filter->clut, &filter->clut_ready);
+		if (filter->clut_ready)
+			update_clut_params(filter, filter->clut);
+	}
+
 	if (!target || !filter->target || !filter->effect) {
 		obs_source_skip_video_filter(filter->context);
 		return;
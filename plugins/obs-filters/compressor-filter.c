@@ -4,10 +4,13 @@
 
 #include <obs-module.h>
 #include <media-io/audio-math.h>
+#include <media-io/audio-kernels.h>
 #include <util/platform.h>
 #include <util/circlebuf.h>
 #include <util/threading.h>
 
+#include "sidechain.h"
+
 /* -------------------------------------------------------- */
 
 #define do_log(level, format, ...)                \
@@ -63,6 +66,7 @@
 struct compressor_data {
 	obs_source_t *context;
 	float *envelope_buf;
+	float *gain_buf;
 	size_t envelope_buf_len;
 
 	float ratio;
@@ -82,20 +86,13 @@ struct compressor_data {
 	char *sidechain_name;
 
 	pthread_mutex_t sidechain_mutex;
-	struct circlebuf sidechain_data[MAX_AUDIO_CHANNELS];
-	float *sidechain_buf[MAX_AUDIO_CHANNELS];
+	struct circlebuf sidechain_data;
+	float *sidechain_buf;
 	size_t max_sidechain_frames;
 };
 
 /* -------------------------------------------------------- */
 
-static inline obs_source_t *get_sidechain(struct compressor_data *cd)
-{
-	if (cd->weak_sidechain)
-		return obs_weak_source_get_source(cd->weak_sidechain);
-	return NULL;
-}
-
 static inline void get_sidechain_data(struct compressor_data *cd,
 				      const uint32_t num_samples)
 {
@@ -107,31 +104,26 @@ static inline void get_sidechain_data(struct compressor_data *cd,
 	if (cd->max_sidechain_frames < num_samples)
 		cd->max_sidechain_frames = num_samples;
 
-	if (cd->sidechain_data[0].size < data_size) {
+	if (cd->sidechain_data.size < data_size) {
 		pthread_mutex_unlock(&cd->sidechain_mutex);
 		goto clear;
 	}
 
-	for (size_t i = 0; i < cd->num_channels; i++)
-		circlebuf_pop_front(&cd->sidechain_data[i],
-				    cd->sidechain_buf[i], data_size);
+	circlebuf_pop_front(&cd->sidechain_data, cd->sidechain_buf, data_size);
 
 	pthread_mutex_unlock(&cd->sidechain_mutex);
 	return;
 
 clear:
-	for (size_t i = 0; i < cd->num_channels; i++)
-		memset(cd->sidechain_buf[i], 0, data_size);
+	memset(cd->sidechain_buf, 0, data_size);
 }
 
 static void resize_env_buffer(struct compressor_data *cd, size_t len)
 {
 	cd->envelope_buf_len = len;
 	cd->envelope_buf = brealloc(cd->envelope_buf, len * sizeof(float));
-
-	for (size_t i = 0; i < cd->num_channels; i++)
-		cd->sidechain_buf[i] =
-			brealloc(cd->sidechain_buf[i], len * sizeof(float));
+	cd->gain_buf = brealloc(cd->gain_buf, len * sizeof(float));
+	cd->sidechain_buf = brealloc(cd->sidechain_buf, len * sizeof(float));
 }
 
 static inline float gain_coefficient(uint32_t sample_rate, float time)
@@ -145,43 +137,31 @@ static const char *compressor_name(void *unused)
 	return obs_module_text("Compressor");
 }
 
-static void sidechain_capture(void *param, obs_source_t *source,
-			      const struct audio_data *audio_data, bool muted)
+/* peak is the channel-linked peak of the sidechain packet, shared with any
+ * other compressor keyed off the same source */
+static void sidechain_capture(void *param, const float *peak, size_t frames)
 {
 	struct compressor_data *cd = param;
 
-	UNUSED_PARAMETER(source);
-
 	pthread_mutex_lock(&cd->sidechain_mutex);
 
-	if (cd->max_sidechain_frames < audio_data->frames)
-		cd->max_sidechain_frames = audio_data->frames;
+	if (cd->max_sidechain_frames < frames)
+		cd->max_sidechain_frames = frames;
 
 	size_t expected_size = cd->max_sidechain_frames * sizeof(float);
 
 	if (!expected_size)
 		goto unlock;
 
-	if (cd->sidechain_data[0].size > expected_size * 2) {
-		for (size_t i = 0; i < cd->num_channels; i++) {
-			circlebuf_pop_front(&cd->sidechain_data[i], NULL,
-					    expected_size);
-		}
-	}
+	if (cd->sidechain_data.size > expected_size * 2)
+		circlebuf_pop_front(&cd->sidechain_data, NULL, expected_size);
 
-	if (muted) {
-		for (size_t i = 0; i < cd->num_channels; i++) {
-			circlebuf_push_back_zero(&cd->sidechain_data[i],
-						 audio_data->frames *
-							 sizeof(float));
-		}
-	} else {
-		for (size_t i = 0; i < cd->num_channels; i++) {
-			circlebuf_push_back(&cd->sidechain_data[i],
-					    audio_data->data[i],
-					    audio_data->frames * sizeof(float));
-		}
-	}
+	if (peak)
+		circlebuf_push_back(&cd->sidechain_data, peak,
+				    frames * sizeof(float));
+	else
+		circlebuf_push_back_zero(&cd->sidechain_data,
+					 frames * sizeof(float));
 
 unlock:
 	pthread_mutex_unlock(&cd->sidechain_mutex);
@@ -244,15 +224,8 @@ static void compressor_update(void *data, obs_data_t *s)
 	pthread_mutex_unlock(&cd->sidechain_update_mutex);
 
 	if (old_weak_sidechain) {
-		obs_source_t *old_sidechain =
-			obs_weak_source_get_source(old_weak_sidechain);
-
-		if (old_sidechain) {
-			obs_source_remove_audio_capture_callback(
-				old_sidechain, sidechain_capture, cd);
-			obs_source_release(old_sidechain);
-		}
-
+		sidechain_remove_listener(old_weak_sidechain, sidechain_capture,
+					  cd);
 		obs_weak_source_release(old_weak_sidechain);
 	}
 
@@ -288,25 +261,19 @@ static void compressor_destroy(void *data)
 	struct compressor_data *cd = data;
 
 	if (cd->weak_sidechain) {
-		obs_source_t *sidechain = get_sidechain(cd);
-		if (sidechain) {
-			obs_source_remove_audio_capture_callback(
-				sidechain, sidechain_capture, cd);
-			obs_source_release(sidechain);
-		}
-
+		sidechain_remove_listener(cd->weak_sidechain, sidechain_capture,
+					  cd);
 		obs_weak_source_release(cd->weak_sidechain);
 	}
 
-	for (size_t i = 0; i < MAX_AUDIO_CHANNELS; i++) {
-		circlebuf_free(&cd->sidechain_data[i]);
-		bfree(cd->sidechain_buf[i]);
-	}
+	circlebuf_free(&cd->sidechain_data);
+	bfree(cd->sidechain_buf);
 	pthread_mutex_destroy(&cd->sidechain_mutex);
 	pthread_mutex_destroy(&cd->sidechain_update_mutex);
 
 	bfree(cd->sidechain_name);
 	bfree(cd->envelope_buf);
+	bfree(cd->gain_buf);
 	bfree(cd);
 }
 
@@ -329,11 +296,9 @@ static void analyze_envelope(struct compressor_data *cd, float **samples,
 		float env = cd->envelope;
 		for (uint32_t i = 0; i < num_samples; ++i) {
 			const float env_in = fabsf(samples[chan][i]);
-			if (env < env_in) {
-				env = env_in + attack_gain * (env - env_in);
-			} else {
-				env = env_in + release_gain * (env - env_in);
-			}
+			const float gain = env < env_in ? attack_gain
+							: release_gain;
+			env = env_in + gain * (env - env_in);
 			envelope_buf[i] = fmaxf(envelope_buf[i], env);
 		}
 	}
@@ -351,42 +316,32 @@ static void analyze_sidechain(struct compressor_data *cd,
 
 	const float attack_gain = cd->attack_gain;
 	const float release_gain = cd->release_gain;
-	float **sidechain_buf = cd->sidechain_buf;
-
-	memset(cd->envelope_buf, 0, num_samples * sizeof(cd->envelope_buf[0]));
-	for (size_t chan = 0; chan < cd->num_channels; ++chan) {
-		if (!sidechain_buf[chan])
-			continue;
-
-		float *envelope_buf = cd->envelope_buf;
-		float env = cd->envelope;
-		for (uint32_t i = 0; i < num_samples; ++i) {
-			const float env_in = fabsf(sidechain_buf[chan][i]);
-
-			if (env < env_in) {
-				env = env_in + attack_gain * (env - env_in);
-			} else {
-				env = env_in + release_gain * (env - env_in);
-			}
-			envelope_buf[i] = fmaxf(envelope_buf[i], env);
-		}
+	const float *sidechain_buf = cd->sidechain_buf;
+
+	/* the sidechain data is already rectified and linked across
+	 * channels, so a single follower covers all of them */
+	float *envelope_buf = cd->envelope_buf;
+	float env = cd->envelope;
+	for (uint32_t i = 0; i < num_samples; ++i) {
+		const float env_in = sidechain_buf[i];
+		const float gain = env < env_in ? attack_gain : release_gain;
+		env = env_in + gain * (env - env_in);
+		envelope_buf[i] = env;
 	}
-	cd->envelope = cd->envelope_buf[num_samples - 1];
+	cd->envelope = env;
 }
 
 static inline void process_compression(const struct compressor_data *cd,
 				       float **samples, uint32_t num_samples)
 {
-	for (size_t i = 0; i < num_samples; ++i) {
-		const float env_db = mul_to_db(cd->envelope_buf[i]);
-		float gain = cd->slope * (cd->threshold - env_db);
-		gain = db_to_mul(fminf(0, gain));
-
-		for (size_t c = 0; c < cd->num_channels; ++c) {
-			if (samples[c]) {
-				samples[c][i] *= gain * cd->output_gain;
-			}
-		}
+	audio_kernel_compress_gain(cd->gain_buf, cd->envelope_buf,
+				   cd->threshold, cd->slope, cd->output_gain,
+				   num_samples);
+
+	for (size_t c = 0; c < cd->num_channels; ++c) {
+		if (samples[c])
+			audio_kernel_mul_buf(samples[c], cd->gain_buf,
+					     num_samples);
 	}
 }
 
@@ -426,8 +381,10 @@ static void compressor_tick(void *data, float seconds)
 		pthread_mutex_unlock(&cd->sidechain_update_mutex);
 
 		if (sidechain) {
-			obs_source_add_audio_capture_callback(
-				sidechain, sidechain_capture, cd);
+			/* only listen if the name didn't change meanwhile */
+			if (!weak_sidechain)
+				sidechain_add_listener(sidechain,
+						       sidechain_capture, cd);
 
 			obs_weak_source_release(weak_sidechain);
 			obs_source_release(sidechain);
@@ -4,6 +4,7 @@
 
 #include <obs-module.h>
 #include <media-io/audio-math.h>
+#include <media-io/audio-kernels.h>
 #include <util/platform.h>
 #include <util/circlebuf.h>
 #include <util/threading.h>
@@ -281,18 +282,18 @@ static void analyze_envelope(struct expander_data *cd, float **samples,
 		if (cd->detector == RMS_DETECT) {
 			runave[0] =
 				rmscoef * cd->runave[chan] +
-				(1 - rmscoef) * powf(samples[chan][0], 2.0f);
+				(1 - rmscoef) * samples[chan][0] *
+					samples[chan][0];
 			env_in[0] = sqrtf(fmaxf(runave[0], 0));
 			for (uint32_t i = 1; i < num_samples; ++i) {
-				runave[i] =
-					rmscoef * runave[i - 1] +
-					(1 - rmscoef) *
-						powf(samples[chan][i], 2.0f);
+				runave[i] = rmscoef * runave[i - 1] +
+					    (1 - rmscoef) * samples[chan][i] *
+						    samples[chan][i];
 				env_in[i] = sqrtf(runave[i]);
 			}
 		} else if (cd->detector == PEAK_DETECT) {
 			for (uint32_t i = 0; i < num_samples; ++i) {
-				runave[i] = powf(samples[chan][i], 2);
+				runave[i] = samples[chan][i] * samples[chan][i];
 				env_in[i] = fabsf(samples[chan][i]);
 			}
 		}
@@ -313,50 +314,38 @@ static inline void process_expansion(struct expander_data *cd, float **samples,
 
 	if (cd->gaindB_len < num_samples)
 		resize_gaindB_buffer(cd, num_samples);
-	for (int i = 0; i < MAX_AUDIO_CHANNELS; i++)
-		memset(cd->gaindB[i], 0,
-		       num_samples * sizeof(cd->gaindB[i][0]));
 
 	for (size_t chan = 0; chan < cd->num_channels; chan++) {
+		/* detection is done with env_in, so reuse it for the dB
+		 * envelope and then the linear gain */
+		float *env_db = cd->env_in;
+		float *gaindB = cd->gaindB[chan];
+		float prev = cd->gaindB_buf[chan];
+
+		audio_kernel_mul_to_db(env_db, cd->envelope_buf[chan],
+				       num_samples);
+
 		for (size_t i = 0; i < num_samples; ++i) {
 			// gain stage of expansion
-			float env_db = mul_to_db(cd->envelope_buf[chan][i]);
-			float gain =
-				cd->threshold - env_db > 0.0f
-					? fmaxf(cd->slope * (cd->threshold -
-							     env_db),
-						-60.0f)
-					: 0.0f;
+			const float diff = cd->threshold - env_db[i];
+			const float gain =
+				diff > 0.0f ? fmaxf(cd->slope * diff, -60.0f)
+					    : 0.0f;
 			// ballistics (attack/release)
-			if (i > 0) {
-				if (gain > cd->gaindB[chan][i - 1])
-					cd->gaindB[chan][i] =
-						attack_gain *
-							cd->gaindB[chan][i - 1] +
-						(1.0f - attack_gain) * gain;
-				else
-					cd->gaindB[chan][i] =
-						release_gain *
-							cd->gaindB[chan][i - 1] +
-						(1.0f - release_gain) * gain;
-			} else {
-				if (gain > cd->gaindB_buf[chan])
-					cd->gaindB[chan][i] =
-						attack_gain *
-							cd->gaindB_buf[chan] +
-						(1.0f - attack_gain) * gain;
-				else
-					cd->gaindB[chan][i] =
-						release_gain *
-							cd->gaindB_buf[chan] +
-						(1.0f - release_gain) * gain;
-			}
+			const float coef = gain > prev ? attack_gain
+						       : release_gain;
+			prev = coef * prev + (1.0f - coef) * gain;
+			gaindB[i] = prev;
+			env_db[i] = fminf(0, prev);
+		}
+		cd->gaindB_buf[chan] = prev;
 
-			gain = db_to_mul(fminf(0, cd->gaindB[chan][i]));
-			if (samples[chan])
-				samples[chan][i] *= gain * cd->output_gain;
+		if (samples[chan]) {
+			audio_kernel_db_to_mul(env_db, env_db, cd->output_gain,
+					       num_samples);
+			audio_kernel_mul_buf(samples[chan], env_db,
+					     num_samples);
 		}
-		cd->gaindB_buf[chan] = cd->gaindB[chan][num_samples - 1];
 	}
 }
 
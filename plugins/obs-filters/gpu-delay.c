@@ -1,27 +1,172 @@
 #include <obs-module.h>
 #include <util/circlebuf.h>
+#include <util/darray.h>
 #include <util/util_uint64.h>
+#include <inttypes.h>
 
 #define S_DELAY_MS "delay_ms"
+#define S_COMPRESS "compress"
 #define T_DELAY_MS obs_module_text("DelayMs")
+#define T_COMPRESS obs_module_text("GPUDelay.Compress")
 
+/* delayed frames of all delay filters together are kept below this */
+#define MAX_DELAY_VRAM (2048ULL * 1024 * 1024)
+
+/* how much a filter that was resized or re-created can get back from the
+ * textures other delay filters have let go of */
+#define MAX_IDLE_VRAM (256ULL * 1024 * 1024)
+
+/* SDR frames can be stored as full resolution luma and alpha plus half
+ * resolution chroma (see gpu_delay.effect), which takes 2.5 bytes per pixel
+ * instead of 4.  HDR frames are always stored as they are. */
 struct frame {
 	gs_texrender_t *render;
+	gs_texrender_t *render_uv;
+	enum gs_color_format format;
 	enum gs_color_space space;
+	uint32_t cx;
+	uint32_t cy;
 	uint64_t ts;
 };
 
 struct gpu_delay_filter_data {
 	obs_source_t *context;
+	gs_effect_t *effect;
+	gs_texrender_t *scratch;
 	struct circlebuf frames;
 	uint64_t delay_ns;
 	uint64_t interval_ns;
 	uint32_t cx;
 	uint32_t cy;
+	enum gs_color_space space;
+	bool compress;
 	bool target_valid;
 	bool processed_frame;
 };
 
+struct pooled_texrender {
+	gs_texrender_t *render;
+	enum gs_color_format format;
+	uint32_t cx;
+	uint32_t cy;
+};
+
+/* shared by every delay filter, only touched within the graphics context */
+static struct {
+	DARRAY(struct pooled_texrender) idle;
+	uint64_t idle_bytes;
+	uint64_t used_bytes;
+	long filters;
+} pool;
+
+static inline uint64_t texrender_bytes(enum gs_color_format format,
+				       uint32_t cx, uint32_t cy)
+{
+	return (uint64_t)gs_get_format_bpp(format) * cx * cy / 8;
+}
+
+static gs_texrender_t *pool_acquire(enum gs_color_format format, uint32_t cx,
+				    uint32_t cy)
+{
+	gs_texrender_t *render = NULL;
+
+	for (size_t i = 0; i < pool.idle.num; i++) {
+		struct pooled_texrender *entry = &pool.idle.array[i];
+
+		if (entry->format == format && entry->cx == cx &&
+		    entry->cy == cy) {
+			render = entry->render;
+			pool.idle_bytes -= texrender_bytes(format, cx, cy);
+			da_erase(pool.idle, i);
+			break;
+		}
+	}
+
+	if (!render)
+		render = gs_texrender_create(format, GS_ZS_NONE);
+
+	pool.used_bytes += texrender_bytes(format, cx, cy);
+	return render;
+}
+
+static void pool_destroy_oldest(void)
+{
+	struct pooled_texrender *entry = &pool.idle.array[0];
+
+	pool.idle_bytes -=
+		texrender_bytes(entry->format, entry->cx, entry->cy);
+	gs_texrender_destroy(entry->render);
+	da_erase(pool.idle, 0);
+}
+
+static void pool_release(gs_texrender_t *render, enum gs_color_format format,
+			 uint32_t cx, uint32_t cy)
+{
+	struct pooled_texrender entry = {render, format, cx, cy};
+	uint64_t bytes = texrender_bytes(format, cx, cy);
+
+	if (!render)
+		return;
+
+	pool.used_bytes -= bytes;
+	pool.idle_bytes += bytes;
+	da_push_back(pool.idle, &entry);
+
+	while (pool.idle.num && pool.idle_bytes > MAX_IDLE_VRAM)
+		pool_destroy_oldest();
+}
+
+static void pool_free_idle(void)
+{
+	while (pool.idle.num)
+		pool_destroy_oldest();
+	da_free(pool.idle);
+}
+
+static inline bool use_compression(struct gpu_delay_filter_data *f,
+				   enum gs_color_space space)
+{
+	return f->compress && f->effect && space == GS_CS_SRGB;
+}
+
+static inline uint64_t frame_bytes(struct gpu_delay_filter_data *f)
+{
+	if (use_compression(f, f->space))
+		return texrender_bytes(GS_R8G8, f->cx, f->cy) +
+		       texrender_bytes(GS_R8G8, (f->cx + 1) / 2,
+				       (f->cy + 1) / 2);
+
+	return texrender_bytes(gs_get_format_from_space(f->space), f->cx,
+			       f->cy);
+}
+
+static void frame_alloc(struct gpu_delay_filter_data *f, struct frame *frame)
+{
+	frame->space = f->space;
+	frame->cx = f->cx;
+	frame->cy = f->cy;
+
+	if (use_compression(f, f->space)) {
+		frame->format = GS_R8G8;
+		frame->render = pool_acquire(GS_R8G8, f->cx, f->cy);
+		frame->render_uv = pool_acquire(GS_R8G8, (f->cx + 1) / 2,
+						(f->cy + 1) / 2);
+	} else {
+		frame->format = gs_get_format_from_space(f->space);
+		frame->render = pool_acquire(frame->format, f->cx, f->cy);
+		frame->render_uv = NULL;
+	}
+}
+
+static void frame_free(struct frame *frame)
+{
+	pool_release(frame->render, frame->format, frame->cx, frame->cy);
+	pool_release(frame->render_uv, GS_R8G8, (frame->cx + 1) / 2,
+		     (frame->cy + 1) / 2);
+	frame->render = NULL;
+	frame->render_uv = NULL;
+}
+
 static const char *gpu_delay_filter_get_name(void *unused)
 {
 	UNUSED_PARAMETER(unused);
@@ -34,9 +179,11 @@ static void free_textures(struct gpu_delay_filter_data *f)
 	while (f->frames.size) {
 		struct frame frame;
 		circlebuf_pop_front(&f->frames, &frame, sizeof(frame));
-		gs_texrender_destroy(frame.render);
+		frame_free(&frame);
 	}
 	circlebuf_free(&f->frames);
+	gs_texrender_destroy(f->scratch);
+	f->scratch = NULL;
 	obs_leave_graphics();
 }
 
@@ -58,16 +205,32 @@ static void update_interval(struct gpu_delay_filter_data *f,
 
 	if (num > num_frames(&f->frames)) {
 		size_t prev_num = num_frames(&f->frames);
+		uint64_t bytes = frame_bytes(f);
 
 		obs_enter_graphics();
 
+		if (pool.used_bytes + (num - prev_num) * bytes >
+		    MAX_DELAY_VRAM) {
+			uint64_t left = MAX_DELAY_VRAM > pool.used_bytes
+						? MAX_DELAY_VRAM -
+							  pool.used_bytes
+						: 0;
+			num = prev_num + (size_t)(left / bytes);
+
+			blog(LOG_WARNING,
+			     "[gpu delay: '%s'] Delayed frames would use too "
+			     "much video memory, limiting delay to %" PRIu64
+			     " ms",
+			     obs_source_get_name(f->context),
+			     num * new_interval_ns / 1000000);
+		}
+
 		circlebuf_upsize(&f->frames, num * sizeof(struct frame));
 
 		for (size_t i = prev_num; i < num; i++) {
 			struct frame *frame =
 				circlebuf_data(&f->frames, i * sizeof(*frame));
-			frame->render =
-				gs_texrender_create(GS_RGBA, GS_ZS_NONE);
+			frame_alloc(f, frame);
 		}
 
 		obs_leave_graphics();
@@ -78,7 +241,7 @@ static void update_interval(struct gpu_delay_filter_data *f,
 		while (num_frames(&f->frames) > num) {
 			struct frame frame;
 			circlebuf_pop_front(&f->frames, &frame, sizeof(frame));
-			gs_texrender_destroy(frame.render);
+			frame_free(&frame);
 		}
 
 		obs_leave_graphics();
@@ -137,6 +300,7 @@ static void gpu_delay_filter_update(void *data, obs_data_t *s)
 	struct gpu_delay_filter_data *f = data;
 
 	f->delay_ns = (uint64_t)obs_data_get_int(s, S_DELAY_MS) * 1000000ULL;
+	f->compress = obs_data_get_bool(s, S_COMPRESS);
 
 	/* full reset */
 	f->cx = 0;
@@ -153,15 +317,32 @@ static obs_properties_t *gpu_delay_filter_properties(void *data)
 						   T_DELAY_MS, 0, 500, 1);
 	obs_property_int_set_suffix(p, " ms");
 
+	obs_properties_add_bool(props, S_COMPRESS, T_COMPRESS);
+
 	UNUSED_PARAMETER(data);
 	return props;
 }
 
+static void gpu_delay_filter_defaults(obs_data_t *settings)
+{
+	obs_data_set_default_bool(settings, S_COMPRESS, true);
+}
+
 static void *gpu_delay_filter_create(obs_data_t *settings,
 				     obs_source_t *context)
 {
 	struct gpu_delay_filter_data *f = bzalloc(sizeof(*f));
+	char *effect_path = obs_module_file("gpu_delay.effect");
+
 	f->context = context;
+	f->space = GS_CS_SRGB;
+
+	obs_enter_graphics();
+	f->effect = gs_effect_create_from_file(effect_path, NULL);
+	pool.filters++;
+	obs_leave_graphics();
+
+	bfree(effect_path);
 
 	obs_source_update(context, settings);
 	return f;
@@ -172,6 +353,13 @@ static void gpu_delay_filter_destroy(void *data)
 	struct gpu_delay_filter_data *f = data;
 
 	free_textures(f);
+
+	obs_enter_graphics();
+	gs_effect_destroy(f->effect);
+	if (--pool.filters == 0)
+		pool_free_idle();
+	obs_leave_graphics();
+
 	bfree(f);
 }
 
@@ -232,6 +420,34 @@ get_tech_name_and_multiplier(enum gs_color_space current_space,
 	return tech_name;
 }
 
+static void draw_compressed_frame(struct gpu_delay_filter_data *f,
+				  struct frame *frame, const char *technique,
+				  float multiplier)
+{
+	gs_texture_t *tex = gs_texrender_get_texture(frame->render);
+	gs_texture_t *tex_uv = gs_texrender_get_texture(frame->render_uv);
+
+	if (tex && tex_uv) {
+		const bool previous = gs_framebuffer_srgb_enabled();
+		gs_enable_framebuffer_srgb(true);
+
+		gs_effect_set_texture(gs_effect_get_param_by_name(f->effect,
+								  "image"),
+				      tex);
+		gs_effect_set_texture(gs_effect_get_param_by_name(f->effect,
+								  "image_uv"),
+				      tex_uv);
+		gs_effect_set_float(gs_effect_get_param_by_name(f->effect,
+								"multiplier"),
+				    multiplier);
+
+		while (gs_effect_loop(f->effect, technique))
+			gs_draw_sprite(tex, 0, f->cx, f->cy);
+
+		gs_enable_framebuffer_srgb(previous);
+	}
+}
+
 static void draw_frame(struct gpu_delay_filter_data *f)
 {
 	struct frame frame;
@@ -242,6 +458,11 @@ static void draw_frame(struct gpu_delay_filter_data *f)
 	const char *technique = get_tech_name_and_multiplier(
 		current_space, frame.space, &multiplier);
 
+	if (frame.render_uv) {
+		draw_compressed_frame(f, &frame, technique, multiplier);
+		return;
+	}
+
 	gs_effect_t *effect = obs_get_base_effect(OBS_EFFECT_DEFAULT);
 	gs_texture_t *tex = gs_texrender_get_texture(frame.render);
 	if (tex) {
@@ -261,6 +482,42 @@ static void draw_frame(struct gpu_delay_filter_data *f)
 	}
 }
 
+static void pack_plane(struct gpu_delay_filter_data *f, gs_texrender_t *render,
+		       uint32_t cx, uint32_t cy, const char *technique)
+{
+	gs_texture_t *tex = gs_texrender_get_texture(f->scratch);
+
+	gs_texrender_reset(render);
+
+	if (gs_texrender_begin(render, cx, cy)) {
+		gs_ortho(0.0f, (float)f->cx, 0.0f, (float)f->cy, -100.0f,
+			 100.0f);
+
+		gs_effect_set_texture(gs_effect_get_param_by_name(f->effect,
+								  "image"),
+				      tex);
+
+		while (gs_effect_loop(f->effect, technique))
+			gs_draw_sprite(tex, 0, f->cx, f->cy);
+
+		gs_texrender_end(render);
+	}
+}
+
+/* the scratch texture holds the frame as rendered (sRGB encoded, which is
+ * what gets converted), blending is already disabled by the caller */
+static void pack_frame(struct gpu_delay_filter_data *f, struct frame *frame)
+{
+	const bool previous = gs_framebuffer_srgb_enabled();
+	gs_enable_framebuffer_srgb(false);
+
+	pack_plane(f, frame->render, frame->cx, frame->cy, "PackYA");
+	pack_plane(f, frame->render_uv, (frame->cx + 1) / 2,
+		   (frame->cy + 1) / 2, "PackUV");
+
+	gs_enable_framebuffer_srgb(previous);
+}
+
 static void gpu_delay_filter_render(void *data, gs_effect_t *effect)
 {
 	struct gpu_delay_filter_data *f = data;
@@ -287,19 +544,28 @@ static void gpu_delay_filter_render(void *data, gs_effect_t *effect)
 	};
 	const enum gs_color_space space = obs_source_get_color_space(
 		target, OBS_COUNTOF(preferred_spaces), preferred_spaces);
-	const enum gs_color_format format = gs_get_format_from_space(space);
-	if (gs_texrender_get_format(frame.render) != format) {
-		gs_texrender_destroy(frame.render);
-		frame.render = gs_texrender_create(format, GS_ZS_NONE);
+
+	/* a frame only ever holds the layout of the space it was made for */
+	f->space = space;
+	if (frame.space != space) {
+		frame_free(&frame);
+		frame_alloc(f, &frame);
+	}
+
+	const bool compressed = !!frame.render_uv;
+	gs_texrender_t *render = frame.render;
+	if (compressed) {
+		if (!f->scratch)
+			f->scratch = gs_texrender_create(GS_RGBA, GS_ZS_NONE);
+		render = f->scratch;
 	}
 
-	gs_texrender_reset(frame.render);
+	gs_texrender_reset(render);
 
 	gs_blend_state_push();
 	gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
 
-	if (gs_texrender_begin_with_color_space(frame.render, f->cx, f->cy,
-						space)) {
+	if (gs_texrender_begin_with_color_space(render, f->cx, f->cy, space)) {
 		uint32_t parent_flags = obs_source_get_output_flags(target);
 		bool custom_draw = (parent_flags & OBS_SOURCE_CUSTOM_DRAW) != 0;
 		bool async = (parent_flags & OBS_SOURCE_ASYNC) != 0;
@@ -315,9 +581,10 @@ static void gpu_delay_filter_render(void *data, gs_effect_t *effect)
 		else
 			obs_source_video_render(target);
 
-		gs_texrender_end(frame.render);
+		gs_texrender_end(render);
 
-		frame.space = space;
+		if (compressed)
+			pack_frame(f, &frame);
 	}
 
 	gs_blend_state_pop();
@@ -362,6 +629,7 @@ struct obs_source_info gpu_delay_filter = {
 	.destroy = gpu_delay_filter_destroy,
 	.update = gpu_delay_filter_update,
 	.get_properties = gpu_delay_filter_properties,
+	.get_defaults = gpu_delay_filter_defaults,
 	.video_tick = gpu_delay_filter_tick,
 	.video_render = gpu_delay_filter_render,
 	.video_get_color_space = gpu_delay_filter_get_color_space,
@@ -4,6 +4,7 @@
 
 #include <obs-module.h>
 #include <media-io/audio-math.h>
+#include <media-io/audio-kernels.h>
 #include <util/platform.h>
 
 /* -------------------------------------------------------- */
@@ -48,6 +49,7 @@
 struct limiter_data {
 	obs_source_t *context;
 	float *envelope_buf;
+	float *gain_buf;
 	size_t envelope_buf_len;
 
 	float threshold;
@@ -67,6 +69,7 @@ static void resize_env_buffer(struct limiter_data *cd, size_t len)
 {
 	cd->envelope_buf_len = len;
 	cd->envelope_buf = brealloc(cd->envelope_buf, len * sizeof(float));
+	cd->gain_buf = brealloc(cd->gain_buf, len * sizeof(float));
 }
 
 static inline float gain_coefficient(uint32_t sample_rate, float time)
@@ -123,6 +126,7 @@ static void limiter_destroy(void *data)
 	struct limiter_data *cd = data;
 
 	bfree(cd->envelope_buf);
+	bfree(cd->gain_buf);
 	bfree(cd);
 }
 
@@ -145,11 +149,9 @@ static void analyze_envelope(struct limiter_data *cd, float **samples,
 		float env = cd->envelope;
 		for (uint32_t i = 0; i < num_samples; ++i) {
 			const float env_in = fabsf(samples[chan][i]);
-			if (env < env_in) {
-				env = env_in + attack_gain * (env - env_in);
-			} else {
-				env = env_in + release_gain * (env - env_in);
-			}
+			const float gain = env < env_in ? attack_gain
+							: release_gain;
+			env = env_in + gain * (env - env_in);
 			envelope_buf[i] = fmaxf(envelope_buf[i], env);
 		}
 	}
@@ -159,16 +161,14 @@ static void analyze_envelope(struct limiter_data *cd, float **samples,
 static inline void process_compression(const struct limiter_data *cd,
 				       float **samples, uint32_t num_samples)
 {
-	for (size_t i = 0; i < num_samples; ++i) {
-		const float env_db = mul_to_db(cd->envelope_buf[i]);
-		float gain = cd->slope * (cd->threshold - env_db);
-		gain = db_to_mul(fminf(0, gain));
-
-		for (size_t c = 0; c < cd->num_channels; ++c) {
-			if (samples[c]) {
-				samples[c][i] *= gain * cd->output_gain;
-			}
-		}
+	audio_kernel_compress_gain(cd->gain_buf, cd->envelope_buf,
+				   cd->threshold, cd->slope, cd->output_gain,
+				   num_samples);
+
+	for (size_t c = 0; c < cd->num_channels; ++c) {
+		if (samples[c])
+			audio_kernel_mul_buf(samples[c], cd->gain_buf,
+					     num_samples);
 	}
 }
 
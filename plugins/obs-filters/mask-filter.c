@@ -36,6 +36,9 @@ struct mask_filter_data {
 	time_t image_file_timestamp;
 	float update_time_elapsed;
 
+	/* still images come from the shared image cache, animated images are
+	 * loaded into image instead */
+	obs_cached_image_t *cached;
 	gs_texture_t *target;
 	gs_image_file_t image;
 	struct vec4 color;
@@ -58,6 +61,9 @@ static const char *mask_filter_get_name(void *unused)
 
 static void mask_filter_image_unload(struct mask_filter_data *filter)
 {
+	obs_cached_image_release(filter->cached);
+	filter->cached = NULL;
+
 	obs_enter_graphics();
 	gs_image_file_free(&filter->image);
 	obs_leave_graphics();
@@ -71,15 +77,25 @@ static void mask_filter_image_load(struct mask_filter_data *filter)
 
 	if (path && *path) {
 		filter->image_file_timestamp = get_modified_timestamp(path);
-		gs_image_file_init(&filter->image, path);
 		filter->update_time_elapsed = 0;
 
-		obs_enter_graphics();
-		gs_image_file_init_texture(&filter->image);
-		obs_leave_graphics();
-	}
+		/* waits so the source isn't shown unmasked while the image
+		 * decodes */
+		filter->cached = obs_image_cache_get(
+			path, GS_IMAGE_ALPHA_STRAIGHT, 0, 0, GS_UNKNOWN);
+
+		if (obs_cached_image_wait(filter->cached) ==
+		    OBS_CACHED_IMAGE_ANIMATED) {
+			obs_cached_image_release(filter->cached);
+			filter->cached = NULL;
 
-	filter->target = filter->image.texture;
+			gs_image_file_init(&filter->image, path);
+
+			obs_enter_graphics();
+			gs_image_file_init_texture(&filter->image);
+			obs_leave_graphics();
+		}
+	}
 }
 
 static void mask_filter_update_internal(void *data, obs_data_t *settings,
@@ -229,6 +245,8 @@ static void mask_filter_destroy(void *data)
 	if (filter->image_file)
 		bfree(filter->image_file);
 
+	obs_cached_image_release(filter->cached);
+
 	obs_enter_graphics();
 	gs_effect_destroy(filter->effect);
 	gs_image_file_free(&filter->image);
@@ -277,6 +295,10 @@ static void mask_filter_render(void *data, gs_effect_t *effect)
 	struct vec2 add_val = {0};
 	struct vec2 mul_val = {1.0f, 1.0f};
 
+	filter->target = filter->cached
+				 ? obs_cached_image_get_texture(filter->cached)
+				 : filter->image.texture;
+
 	if (!target || !filter->target || !filter->effect) {
 		obs_source_skip_video_filter(filter->context);
 		return;
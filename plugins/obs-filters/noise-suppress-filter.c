@@ -48,6 +48,7 @@ bool nvafx_loaded = false;
 #define S_METHOD_NVAFX_DENOISER "denoiser"
 #define S_METHOD_NVAFX_DEREVERB "dereverb"
 #define S_METHOD_NVAFX_DEREVERB_DENOISER "dereverb_denoiser"
+#define S_RNNOISE_WORKER "rnnoise_worker"
 
 #define MT_ obs_module_text
 #define TEXT_SUPPRESS_LEVEL MT_("NoiseSuppress.SuppressLevel")
@@ -55,6 +56,7 @@ bool nvafx_loaded = false;
 #define TEXT_METHOD MT_("NoiseSuppress.Method")
 #define TEXT_METHOD_SPEEX MT_("NoiseSuppress.Method.Speex")
 #define TEXT_METHOD_RNN MT_("NoiseSuppress.Method.RNNoise")
+#define TEXT_RNNOISE_WORKER MT_("NoiseSuppress.RNNoiseWorker")
 #define TEXT_METHOD_NVAFX_DENOISER MT_("NoiseSuppress.Method.Nvafx.Denoiser")
 #define TEXT_METHOD_NVAFX_DEREVERB MT_("NoiseSuppress.Method.Nvafx.Dereverb")
 #define TEXT_METHOD_NVAFX_DEREVERB_DENOISER \
@@ -107,6 +109,17 @@ struct noise_suppress_data {
 	/* Resampler */
 	audio_resampler_t *rnn_resampler;
 	audio_resampler_t *rnn_resampler_back;
+
+	/* Worker thread, owns the RNNoise state, resamplers and segment
+	 * buffers while a segment is pending */
+	volatile bool rnn_async;
+	volatile bool rnn_worker_stop;
+	bool rnn_worker_active;
+	bool rnn_pending;
+	pthread_t rnn_worker;
+	os_sem_t *rnn_work_sem;
+	os_sem_t *rnn_done_sem;
+	float *rnn_async_buffers[MAX_PREPROC_CHANNELS];
 #endif
 
 #ifdef LIBNVAFX_ENABLED
@@ -171,10 +184,74 @@ static const char *noise_suppress_name(void *unused)
 	return obs_module_text("NoiseSuppress");
 }
 
+#ifdef LIBRNNOISE_ENABLED
+static void *rnnoise_worker_thread(void *data);
+
+static void start_rnnoise_worker(struct noise_suppress_data *ng)
+{
+	if (os_sem_init(&ng->rnn_work_sem, 0) != 0)
+		return;
+	if (os_sem_init(&ng->rnn_done_sem, 0) != 0) {
+		os_sem_destroy(ng->rnn_work_sem);
+		return;
+	}
+
+	/* starts out silent, it's what gets output for the first segment */
+	ng->rnn_async_buffers[0] =
+		bzalloc(ng->frames * ng->channels * sizeof(float));
+	for (size_t c = 1; c < ng->channels; ++c)
+		ng->rnn_async_buffers[c] =
+			ng->rnn_async_buffers[c - 1] + ng->frames;
+
+	os_atomic_set_bool(&ng->rnn_worker_stop, false);
+	if (pthread_create(&ng->rnn_worker, NULL, rnnoise_worker_thread,
+			   ng) != 0) {
+		warn("Failed to create RNNoise worker thread");
+		os_sem_destroy(ng->rnn_work_sem);
+		os_sem_destroy(ng->rnn_done_sem);
+		bfree(ng->rnn_async_buffers[0]);
+		return;
+	}
+
+	ng->rnn_worker_active = true;
+}
+
+/* drops the pending segment, e.g. when the audio restarts or the worker is
+ * turned off */
+static inline void finish_rnnoise_async(struct noise_suppress_data *ng)
+{
+	if (!ng->rnn_pending)
+		return;
+
+	os_sem_wait(ng->rnn_done_sem);
+	memset(ng->rnn_async_buffers[0], 0,
+	       ng->frames * ng->channels * sizeof(float));
+	ng->rnn_pending = false;
+}
+
+static void stop_rnnoise_worker(struct noise_suppress_data *ng)
+{
+	if (!ng->rnn_worker_active)
+		return;
+
+	os_atomic_set_bool(&ng->rnn_worker_stop, true);
+	os_sem_post(ng->rnn_work_sem);
+	pthread_join(ng->rnn_worker, NULL);
+
+	os_sem_destroy(ng->rnn_work_sem);
+	os_sem_destroy(ng->rnn_done_sem);
+	bfree(ng->rnn_async_buffers[0]);
+	ng->rnn_worker_active = false;
+}
+#endif
+
 static void noise_suppress_destroy(void *data)
 {
 	struct noise_suppress_data *ng = data;
 
+#ifdef LIBRNNOISE_ENABLED
+	stop_rnnoise_worker(ng);
+#endif
 #ifdef LIBNVAFX_ENABLED
 	if (ng->nvafx_enabled)
 		pthread_mutex_lock(&ng->nvafx_mutex);
@@ -467,6 +544,15 @@ static void noise_suppress_update(void *data, obs_data_t *s)
 	ng->latency = 1000000000LL / (1000 / BUFFER_SIZE_MSEC);
 	ng->use_rnnoise = strcmp(method, S_METHOD_RNN) == 0;
 
+#ifdef LIBRNNOISE_ENABLED
+	bool rnn_async = ng->use_rnnoise &&
+			 obs_data_get_bool(s, S_RNNOISE_WORKER);
+
+	/* the worker hands back each segment one segment later */
+	if (rnn_async)
+		ng->latency *= 2;
+#endif
+
 	bool nvafx_requested =
 		strcmp(method, S_METHOD_NVAFX_DENOISER) == 0 ||
 		strcmp(method, S_METHOD_NVAFX_DEREVERB) == 0 ||
@@ -530,8 +616,10 @@ static void noise_suppress_update(void *data, obs_data_t *s)
 	ng->frames = frames;
 	ng->channels = channels;
 
-#ifdef LIBNVAFX_ENABLED
-
+#ifdef LIBRNNOISE_ENABLED
+	if (rnn_async && !ng->rnn_worker_active)
+		start_rnnoise_worker(ng);
+	os_atomic_set_bool(&ng->rnn_async, rnn_async && ng->rnn_worker_active);
 #endif
 	/* Ignore if already allocated */
 #if defined(LIBSPEEXDSP_ENABLED)
@@ -821,7 +909,7 @@ static inline void process_speexdsp(struct noise_suppress_data *ng)
 #endif
 }
 
-static inline void process_rnnoise(struct noise_suppress_data *ng)
+static void process_rnnoise(struct noise_suppress_data *ng, float **buffers)
 {
 #ifdef LIBRNNOISE_ENABLED
 	/* Adjust signal level to what RNNoise expects, resample if necessary */
@@ -831,7 +919,7 @@ static inline void process_rnnoise(struct noise_suppress_data *ng)
 		uint64_t ts_offset;
 		audio_resampler_resample(ng->rnn_resampler, (uint8_t **)output,
 					 &out_frames, &ts_offset,
-					 (const uint8_t **)ng->copy_buffers,
+					 (const uint8_t **)buffers,
 					 (uint32_t)ng->frames);
 
 		for (size_t i = 0; i < ng->channels; i++) {
@@ -850,7 +938,7 @@ static inline void process_rnnoise(struct noise_suppress_data *ng)
 		for (size_t i = 0; i < ng->channels; i++) {
 			for (size_t j = 0; j < RNNOISE_FRAME_SIZE; ++j) {
 				ng->rnn_segment_buffers[i][j] =
-					ng->copy_buffers[i][j] * 32768.0f;
+					buffers[i][j] * 32768.0f;
 			}
 		}
 	}
@@ -877,17 +965,17 @@ static inline void process_rnnoise(struct noise_suppress_data *ng)
 				     k = (ssize_t)out_frames - ng->frames;
 			     j < (ssize_t)ng->frames; ++j, ++k) {
 				if (k >= 0) {
-					ng->copy_buffers[i][j] =
+					buffers[i][j] =
 						output[i][k] / 32768.0f;
 				} else {
-					ng->copy_buffers[i][j] = 0;
+					buffers[i][j] = 0;
 				}
 			}
 		}
 	} else {
 		for (size_t i = 0; i < ng->channels; i++) {
 			for (size_t j = 0; j < RNNOISE_FRAME_SIZE; ++j) {
-				ng->copy_buffers[i][j] =
+				buffers[i][j] =
 					ng->rnn_segment_buffers[i][j] /
 					32768.0f;
 			}
@@ -895,9 +983,48 @@ static inline void process_rnnoise(struct noise_suppress_data *ng)
 	}
 #else
 	UNUSED_PARAMETER(ng);
+	UNUSED_PARAMETER(buffers);
 #endif
 }
 
+#ifdef LIBRNNOISE_ENABLED
+static void *rnnoise_worker_thread(void *data)
+{
+	struct noise_suppress_data *ng = data;
+
+	os_set_thread_name("noise suppress: rnnoise");
+
+	for (;;) {
+		os_sem_wait(ng->rnn_work_sem);
+		if (os_atomic_load_bool(&ng->rnn_worker_stop))
+			break;
+
+		process_rnnoise(ng, ng->rnn_async_buffers);
+		os_sem_post(ng->rnn_done_sem);
+	}
+
+	return NULL;
+}
+
+/* hands the segment to the worker and takes back the previous one, so the
+ * audio thread only waits when the worker has fallen behind */
+static inline void process_rnnoise_async(struct noise_suppress_data *ng)
+{
+	if (ng->rnn_pending)
+		os_sem_wait(ng->rnn_done_sem);
+
+	for (size_t i = 0; i < ng->channels; i++) {
+		float *buffer = ng->copy_buffers[i];
+		ng->copy_buffers[i] = ng->rnn_async_buffers[i];
+		ng->rnn_async_buffers[i] = buffer;
+	}
+
+	ng->rnn_pending = true;
+	os_sem_post(ng->rnn_work_sem);
+}
+#endif
+
+
 static inline void process_nvafx(struct noise_suppress_data *ng)
 {
 #ifdef LIBNVAFX_ENABLED
@@ -1011,7 +1138,14 @@ static inline void process(struct noise_suppress_data *ng)
 				    ng->frames * sizeof(float));
 
 	if (ng->use_rnnoise) {
-		process_rnnoise(ng);
+#ifdef LIBRNNOISE_ENABLED
+		if (os_atomic_load_bool(&ng->rnn_async)) {
+			process_rnnoise_async(ng);
+		} else {
+			finish_rnnoise_async(ng);
+			process_rnnoise(ng, ng->copy_buffers);
+		}
+#endif
 	} else if (ng->use_nvafx) {
 		if (nvafx_loaded) {
 			process_nvafx(ng);
@@ -1038,6 +1172,9 @@ static inline void clear_circlebuf(struct circlebuf *buf)
 
 static void reset_data(struct noise_suppress_data *ng)
 {
+#ifdef LIBRNNOISE_ENABLED
+	finish_rnnoise_async(ng);
+#endif
 	for (size_t i = 0; i < ng->channels; i++) {
 		clear_circlebuf(&ng->input_buffers[i]);
 		clear_circlebuf(&ng->output_buffers[i]);
@@ -1136,6 +1273,8 @@ static bool noise_suppress_method_modified(obs_properties_t *props,
 		obs_properties_get(props, S_SUPPRESS_LEVEL);
 	obs_property_t *p_navfx_intensity =
 		obs_properties_get(props, S_NVAFX_INTENSITY);
+	obs_property_t *p_rnnoise_worker =
+		obs_properties_get(props, S_RNNOISE_WORKER);
 
 	const char *method = obs_data_get_string(settings, S_METHOD);
 	bool enable_level = strcmp(method, S_METHOD_SPEEX) == 0;
@@ -1145,6 +1284,8 @@ static bool noise_suppress_method_modified(obs_properties_t *props,
 		strcmp(method, S_METHOD_NVAFX_DEREVERB_DENOISER) == 0;
 	obs_property_set_visible(p_suppress_level, enable_level);
 	obs_property_set_visible(p_navfx_intensity, enable_intensity);
+	obs_property_set_visible(p_rnnoise_worker,
+				 strcmp(method, S_METHOD_RNN) == 0);
 
 	UNUSED_PARAMETER(property);
 	return true;
@@ -1214,6 +1355,10 @@ static obs_properties_t *noise_suppress_properties(void *data)
 	obs_property_int_set_suffix(speex_slider, " dB");
 #endif
 
+#ifdef LIBRNNOISE_ENABLED
+	obs_properties_add_bool(ppts, S_RNNOISE_WORKER, TEXT_RNNOISE_WORKER);
+#endif
+
 #ifdef LIBNVAFX_ENABLED
 	obs_properties_add_float_slider(ppts, S_NVAFX_INTENSITY,
 					TEXT_NVAFX_INTENSITY, 0.0, 1.0, 0.01);
@@ -47,13 +47,12 @@ struct nv_greenscreen_data {
 
 	/* RTX SDK vars */
 	NvVFX_Handle handle;
-	CUstream stream;        // CUDA stream
+	CUstream stream;        // CUDA stream, see shared_runtime
 	int mode;               // 0 = quality, 1 = performance
 	NvCVImage *src_img;     // src img in obs format (RGBA ?) on GPU
 	NvCVImage *BGR_src_img; // src img in BGR on GPU
 	NvCVImage *A_dst_img;   // mask img on GPU
 	NvCVImage *dst_img;     // mask texture
-	NvCVImage *stage;       // planar stage img used for transfer to texture
 
 	/* alpha mask effect */
 	gs_effect_t *effect;
@@ -70,6 +69,111 @@ struct nv_greenscreen_data {
 	float threshold;
 };
 
+/* Every filter instance renders on the graphics thread, so instead of each
+ * one having its own CUDA stream and staging image, they all queue their
+ * transfers and inference on one stream and transfer through one staging
+ * image that is grown to fit the largest source.  Each instance still needs
+ * its own effect handle, as the model keeps per-source temporal state. */
+static struct {
+	pthread_mutex_t mutex;
+	CUstream stream;
+	NvCVImage *stage; // planar stage img used for transfer to texture
+	long refs;
+} shared_runtime = {PTHREAD_MUTEX_INITIALIZER};
+
+static bool shared_runtime_acquire(struct nv_greenscreen_data *filter)
+{
+	NvCV_Status vfxErr = NVCV_SUCCESS;
+
+	pthread_mutex_lock(&shared_runtime.mutex);
+	if (!shared_runtime.stream)
+		vfxErr = NvVFX_CudaStreamCreate(&shared_runtime.stream);
+	if (vfxErr == NVCV_SUCCESS) {
+		shared_runtime.refs++;
+		filter->stream = shared_runtime.stream;
+	}
+	pthread_mutex_unlock(&shared_runtime.mutex);
+
+	if (NVCV_SUCCESS != vfxErr) {
+		const char *errString = NvCV_GetErrorStringFromCode(vfxErr);
+		error("Error creating CUDA Stream; error %i: %s", vfxErr,
+		      errString);
+		return false;
+	}
+
+	return true;
+}
+
+static void shared_runtime_release(struct nv_greenscreen_data *filter)
+{
+	if (!filter->stream)
+		return;
+
+	pthread_mutex_lock(&shared_runtime.mutex);
+	if (--shared_runtime.refs == 0) {
+		NvVFX_CudaStreamDestroy(shared_runtime.stream);
+		NvCVImage_Destroy(shared_runtime.stage);
+		shared_runtime.stream = NULL;
+		shared_runtime.stage = NULL;
+	}
+	pthread_mutex_unlock(&shared_runtime.mutex);
+
+	filter->stream = NULL;
+}
+
+/* the first filter to be reset after a CUDA error replaces the stream, the
+ * others just pick up the new one */
+static bool shared_runtime_reset(struct nv_greenscreen_data *filter)
+{
+	NvCV_Status vfxErr = NVCV_SUCCESS;
+
+	pthread_mutex_lock(&shared_runtime.mutex);
+	if (filter->stream && filter->stream == shared_runtime.stream) {
+		NvVFX_CudaStreamDestroy(shared_runtime.stream);
+		NvCVImage_Destroy(shared_runtime.stage);
+		shared_runtime.stream = NULL;
+		shared_runtime.stage = NULL;
+		vfxErr = NvVFX_CudaStreamCreate(&shared_runtime.stream);
+	}
+	filter->stream = shared_runtime.stream;
+	pthread_mutex_unlock(&shared_runtime.mutex);
+
+	if (NVCV_SUCCESS != vfxErr) {
+		const char *errString = NvCV_GetErrorStringFromCode(vfxErr);
+		error("Error creating CUDA Stream; error %i: %s", vfxErr,
+		      errString);
+		return false;
+	}
+
+	return true;
+}
+
+static bool shared_runtime_fit_stage(uint32_t width, uint32_t height)
+{
+	NvCVImage *stage = shared_runtime.stage;
+
+	if (stage && stage->width >= width && stage->height >= height)
+		return true;
+
+	if (stage) {
+		if (stage->width > width)
+			width = stage->width;
+		if (stage->height > height)
+			height = stage->height;
+		return NvCVImage_Realloc(stage, width, height, NVCV_RGBA,
+					 NVCV_U8, NVCV_PLANAR, NVCV_GPU,
+					 1) == NVCV_SUCCESS;
+	}
+
+	if (NvCVImage_Create(width, height, NVCV_RGBA, NVCV_U8, NVCV_PLANAR,
+			     NVCV_GPU, 1, &shared_runtime.stage) != NVCV_SUCCESS)
+		return false;
+
+	return NvCVImage_Alloc(shared_runtime.stage, width, height, NVCV_RGBA,
+			       NVCV_U8, NVCV_PLANAR, NVCV_GPU,
+			       1) == NVCV_SUCCESS;
+}
+
 static const char *nv_greenscreen_filter_name(void *unused)
 {
 	UNUSED_PARAMETER(unused);
@@ -111,14 +215,11 @@ static void nv_greenscreen_filter_actual_destroy(void *data)
 		NvCVImage_Destroy(filter->BGR_src_img);
 		NvCVImage_Destroy(filter->A_dst_img);
 		NvCVImage_Destroy(filter->dst_img);
-		NvCVImage_Destroy(filter->stage);
-	}
-	if (filter->stream) {
-		NvVFX_CudaStreamDestroy(filter->stream);
 	}
 	if (filter->handle) {
 		NvVFX_DestroyEffect(filter->handle);
 	}
+	shared_runtime_release(filter);
 	if (filter->effect) {
 		obs_enter_graphics();
 		gs_effect_destroy(filter->effect);
@@ -141,9 +242,6 @@ static void nv_greenscreen_filter_reset(void *data, calldata_t *calldata)
 
 	os_atomic_set_bool(&filter->processing_stop, true);
 	// first destroy
-	if (filter->stream) {
-		NvVFX_CudaStreamDestroy(filter->stream);
-	}
 	if (filter->handle) {
 		NvVFX_DestroyEffect(filter->handle);
 	}
@@ -165,13 +263,8 @@ static void nv_greenscreen_filter_reset(void *data, calldata_t *calldata)
 	snprintf(modelDir, max_len, "%s\\models", buffer);
 	vfxErr = NvVFX_SetString(filter->handle, NVVFX_MODEL_DIRECTORY,
 				 modelDir);
-	vfxErr = NvVFX_CudaStreamCreate(&filter->stream);
-	if (NVCV_SUCCESS != vfxErr) {
-		const char *errString = NvCV_GetErrorStringFromCode(vfxErr);
-		error("Error creating CUDA Stream; error %i: %s", vfxErr,
-		      errString);
+	if (!shared_runtime_reset(filter))
 		nv_greenscreen_filter_destroy(filter);
-	}
 	vfxErr = NvVFX_SetCudaStream(filter->handle, NVVFX_CUDA_STREAM,
 				     filter->stream);
 	if (NVCV_SUCCESS != vfxErr) {
@@ -282,24 +375,10 @@ static void init_images_greenscreen(struct nv_greenscreen_data *filter)
 		}
 	}
 
-	/* 6. Create stage NvCVImage which will be used as buffer for transfer */
-	if (filter->stage) {
-		if (NvCVImage_Realloc(filter->stage, width, height, NVCV_RGBA,
-				      NVCV_U8, NVCV_PLANAR, NVCV_GPU,
-				      1) != NVCV_SUCCESS) {
-			goto fail;
-		}
-	} else {
-		if (NvCVImage_Create(width, height, NVCV_RGBA, NVCV_U8,
-				     NVCV_PLANAR, NVCV_GPU, 1,
-				     &filter->stage) != NVCV_SUCCESS) {
-			goto fail;
-		}
-		if (NvCVImage_Alloc(filter->stage, width, height, NVCV_RGBA,
-				    NVCV_U8, NVCV_PLANAR, NVCV_GPU,
-				    1) != NVCV_SUCCESS) {
-			goto fail;
-		}
+	/* 6. Make sure the shared stage NvCVImage used as buffer for transfer
+	 * fits this source */
+	if (!shared_runtime_fit_stage(width, height)) {
+		goto fail;
 	}
 
 	/* 7. Set input & output images for nv FX. */
@@ -334,7 +413,7 @@ static bool process_texture_greenscreen(struct nv_greenscreen_data *filter)
 
 	/* 2. Convert to BGR. */
 	vfxErr = NvCVImage_Transfer(filter->src_img, filter->BGR_src_img, 1.0f,
-				    filter->stream, filter->stage);
+				    filter->stream, shared_runtime.stage);
 	if (vfxErr != NVCV_SUCCESS) {
 		const char *errString = NvCV_GetErrorStringFromCode(vfxErr);
 		error("Error converting src to BGR img; error %i: %s", vfxErr,
@@ -368,7 +447,7 @@ static bool process_texture_greenscreen(struct nv_greenscreen_data *filter)
 	}
 
 	vfxErr = NvCVImage_Transfer(filter->A_dst_img, filter->dst_img, 1.0f,
-				    filter->stream, filter->stage);
+				    filter->stream, shared_runtime.stage);
 	if (vfxErr != NVCV_SUCCESS) {
 		const char *errString = NvCV_GetErrorStringFromCode(vfxErr);
 		error("Error transferring mask to alpha texture; error %i: %s ",
@@ -429,11 +508,7 @@ static void *nv_greenscreen_filter_create(obs_data_t *settings,
 	snprintf(modelDir, max_len, "%s\\models", buffer);
 	vfxErr = NvVFX_SetString(filter->handle, NVVFX_MODEL_DIRECTORY,
 				 modelDir);
-	vfxErr = NvVFX_CudaStreamCreate(&filter->stream);
-	if (NVCV_SUCCESS != vfxErr) {
-		const char *errString = NvCV_GetErrorStringFromCode(vfxErr);
-		error("Error creating CUDA Stream; error %i: %s", vfxErr,
-		      errString);
+	if (!shared_runtime_acquire(filter)) {
 		nv_greenscreen_filter_destroy(filter);
 		return NULL;
 	}
@@ -76,6 +76,18 @@ static OPUS_INLINE float relu(float x)
    return x < 0 ? 0 : x;
 }
 
+/* The weights are stored input-major, so the layers below accumulate one
+   input at a time across all neurons.  The inner loops then walk the weights
+   contiguously and get vectorized by the compiler (SSE2/NEON), while every
+   neuron still sums its terms in the same order as before. */
+
+static void accumulate(float *sum, const rnn_weight *weights, int count, float x)
+{
+   int i;
+   for (i=0;i<count;i++)
+      sum[i] += weights[i]*x;
+}
+
 static void compute_dense(const DenseLayer *layer, float *output, const float *input)
 {
    int i, j;
@@ -85,13 +97,11 @@ static void compute_dense(const DenseLayer *layer, float *output, const float *i
    N = layer->nb_neurons;
    stride = N;
    for (i=0;i<N;i++)
-   {
-      /* Compute update gate. */
-      float sum = layer->bias[i];
-      for (j=0;j<M;j++)
-         sum += layer->input_weights[j*stride + i]*input[j];
-      output[i] = WEIGHTS_SCALE*sum;
-   }
+      output[i] = layer->bias[i];
+   for (j=0;j<M;j++)
+      accumulate(output, &layer->input_weights[j*stride], N, input[j]);
+   for (i=0;i<N;i++)
+      output[i] = WEIGHTS_SCALE*output[i];
    if (layer->activation == ACTIVATION_SIGMOID) {
       for (i=0;i<N;i++)
          output[i] = sigmoid_approx(output[i]);
@@ -111,45 +121,43 @@ static void compute_gru(const GRULayer *gru, float *state, const float *input)
    int i, j;
    int N, M;
    int stride;
+   float sum[3*MAX_NEURONS];
    float z[MAX_NEURONS];
    float r[MAX_NEURONS];
    float h[MAX_NEURONS];
    M = gru->nb_inputs;
    N = gru->nb_neurons;
    stride = 3*N;
+   /* Inputs of the update gate, reset gate and output. */
+   for (i=0;i<3*N;i++)
+      sum[i] = gru->bias[i];
+   for (j=0;j<M;j++)
+      accumulate(sum, &gru->input_weights[j*stride], 3*N, input[j]);
+   /* Compute update and reset gates. */
+   for (j=0;j<N;j++)
+      accumulate(sum, &gru->recurrent_weights[j*stride], 2*N, state[j]);
    for (i=0;i<N;i++)
    {
-      /* Compute update gate. */
-      float sum = gru->bias[i];
-      for (j=0;j<M;j++)
-         sum += gru->input_weights[j*stride + i]*input[j];
-      for (j=0;j<N;j++)
-         sum += gru->recurrent_weights[j*stride + i]*state[j];
-      z[i] = sigmoid_approx(WEIGHTS_SCALE*sum);
+      z[i] = sigmoid_approx(WEIGHTS_SCALE*sum[i]);
+      r[i] = sigmoid_approx(WEIGHTS_SCALE*sum[N + i]);
    }
-   for (i=0;i<N;i++)
+   /* Compute output. */
+   for (j=0;j<N;j++)
    {
-      /* Compute reset gate. */
-      float sum = gru->bias[N + i];
-      for (j=0;j<M;j++)
-         sum += gru->input_weights[N + j*stride + i]*input[j];
-      for (j=0;j<N;j++)
-         sum += gru->recurrent_weights[N + j*stride + i]*state[j];
-      r[i] = sigmoid_approx(WEIGHTS_SCALE*sum);
+      const rnn_weight *weights = &gru->recurrent_weights[2*N + j*stride];
+      float s = state[j];
+      float reset = r[j];
+      for (i=0;i<N;i++)
+         sum[2*N + i] += weights[i]*s*reset;
    }
    for (i=0;i<N;i++)
    {
-      /* Compute output. */
-      float sum = gru->bias[2*N + i];
-      for (j=0;j<M;j++)
-         sum += gru->input_weights[2*N + j*stride + i]*input[j];
-      for (j=0;j<N;j++)
-         sum += gru->recurrent_weights[2*N + j*stride + i]*state[j]*r[j];
-      if (gru->activation == ACTIVATION_SIGMOID) sum = sigmoid_approx(WEIGHTS_SCALE*sum);
-      else if (gru->activation == ACTIVATION_TANH) sum = tansig_approx(WEIGHTS_SCALE*sum);
-      else if (gru->activation == ACTIVATION_RELU) sum = relu(WEIGHTS_SCALE*sum);
+      float out = sum[2*N + i];
+      if (gru->activation == ACTIVATION_SIGMOID) out = sigmoid_approx(WEIGHTS_SCALE*out);
+      else if (gru->activation == ACTIVATION_TANH) out = tansig_approx(WEIGHTS_SCALE*out);
+      else if (gru->activation == ACTIVATION_RELU) out = relu(WEIGHTS_SCALE*out);
       else *(int*)0=0;
-      h[i] = z[i]*state[i] + (1-z[i])*sum;
+      h[i] = z[i]*state[i] + (1-z[i])*out;
    }
    for (i=0;i<N;i++)
       state[i] = h[i];
@@ -0,0 +1,153 @@
+#include <util/darray.h>
+#include <util/threading.h>
+#include <media-io/audio-kernels.h>
+
+#include "sidechain.h"
+
+struct sidechain_listener {
+	sidechain_capture_t callback;
+	void *param;
+};
+
+struct sidechain {
+	/* weak references of one source are all the same pointer, so this
+	 * identifies the source even after it has been destroyed */
+	obs_weak_source_t *weak_source;
+
+	pthread_mutex_t mutex;
+	DARRAY(struct sidechain_listener) listeners;
+	float *peak;
+	size_t peak_len;
+};
+
+static pthread_mutex_t sidechains_mutex = PTHREAD_MUTEX_INITIALIZER;
+static DARRAY(struct sidechain *) sidechains;
+
+static void sidechain_capture(void *param, obs_source_t *source,
+			      const struct audio_data *audio_data, bool muted)
+{
+	struct sidechain *sc = param;
+	const size_t frames = audio_data->frames;
+	const float *peak = NULL;
+
+	UNUSED_PARAMETER(source);
+
+	pthread_mutex_lock(&sc->mutex);
+
+	if (!muted) {
+		const size_t channels =
+			audio_output_get_channels(obs_get_audio());
+
+		if (sc->peak_len < frames) {
+			sc->peak = brealloc(sc->peak, frames * sizeof(float));
+			sc->peak_len = frames;
+		}
+
+		memset(sc->peak, 0, frames * sizeof(float));
+		for (size_t i = 0; i < channels; i++) {
+			if (audio_data->data[i])
+				audio_kernel_abs_max_buf(
+					sc->peak,
+					(const float *)audio_data->data[i],
+					frames);
+		}
+
+		peak = sc->peak;
+	}
+
+	for (size_t i = 0; i < sc->listeners.num; i++) {
+		struct sidechain_listener *l = &sc->listeners.array[i];
+		l->callback(l->param, peak, frames);
+	}
+
+	pthread_mutex_unlock(&sc->mutex);
+}
+
+static struct sidechain *find_sidechain(obs_weak_source_t *weak_source,
+					size_t *idx)
+{
+	for (size_t i = 0; i < sidechains.num; i++) {
+		if (sidechains.array[i]->weak_source == weak_source) {
+			if (idx)
+				*idx = i;
+			return sidechains.array[i];
+		}
+	}
+
+	return NULL;
+}
+
+void sidechain_add_listener(obs_source_t *source, sidechain_capture_t callback,
+			    void *param)
+{
+	struct sidechain_listener l = {callback, param};
+	obs_weak_source_t *weak_source = obs_source_get_weak_source(source);
+	struct sidechain *sc;
+
+	pthread_mutex_lock(&sidechains_mutex);
+
+	sc = find_sidechain(weak_source, NULL);
+	if (sc) {
+		obs_weak_source_release(weak_source);
+
+		pthread_mutex_lock(&sc->mutex);
+		da_push_back(sc->listeners, &l);
+		pthread_mutex_unlock(&sc->mutex);
+	} else {
+		sc = bzalloc(sizeof(*sc));
+		sc->weak_source = weak_source;
+		pthread_mutex_init(&sc->mutex, NULL);
+		da_push_back(sc->listeners, &l);
+		da_push_back(sidechains, &sc);
+
+		obs_source_add_audio_capture_callback(source, sidechain_capture,
+						      sc);
+	}
+
+	pthread_mutex_unlock(&sidechains_mutex);
+}
+
+void sidechain_remove_listener(obs_weak_source_t *weak_source,
+			       sidechain_capture_t callback, void *param)
+{
+	struct sidechain_listener l = {callback, param};
+	struct sidechain *sc;
+	size_t idx;
+	bool empty;
+
+	pthread_mutex_lock(&sidechains_mutex);
+
+	sc = find_sidechain(weak_source, &idx);
+	if (!sc) {
+		pthread_mutex_unlock(&sidechains_mutex);
+		return;
+	}
+
+	pthread_mutex_lock(&sc->mutex);
+	da_erase_item(sc->listeners, &l);
+	empty = !sc->listeners.num;
+	pthread_mutex_unlock(&sc->mutex);
+
+	if (empty) {
+		obs_source_t *source = obs_weak_source_get_source(weak_source);
+
+		/* waits for a packet that is being captured right now */
+		if (source) {
+			obs_source_remove_audio_capture_callback(
+				source, sidechain_capture, sc);
+			obs_source_release(source);
+		}
+
+		da_erase(sidechains, idx);
+		if (!sidechains.num)
+			da_free(sidechains);
+
+		obs_weak_source_release(sc->weak_source);
+		pthread_mutex_destroy(&sc->mutex);
+		da_free(sc->listeners);
+		bfree(sc->peak);
+		bfree(sc);
+	}
+
+	pthread_mutex_unlock(&sidechains_mutex);
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <obs-module.h>
+
+/* Sidechain sources are shared between all filters keying off them, so
+ * when several compressors duck under the same source (music under a few
+ * mics, say) the source only gets one audio capture callback, and the
+ * channel-linked peak of each packet is computed once for all of them.
+ *
+ * The callback runs on the audio thread for every packet of the sidechain
+ * source.  peak holds the per-sample maximum absolute value across all
+ * channels, or is NULL when the source is muted. */
+typedef void (*sidechain_capture_t)(void *param, const float *peak,
+				    size_t frames);
+
+extern void sidechain_add_listener(obs_source_t *source,
+				   sidechain_capture_t callback, void *param);
+extern void sidechain_remove_listener(obs_weak_source_t *weak_source,
+				      sidechain_capture_t callback,
+				      void *param);
@@ -0,0 +1,180 @@
+/******************************************************************************
+    Copyright (C) 2023 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include <string.h>
+#include "dbr-model.h"
+
+#define NSEC_PER_SEC 1000000000ULL
+#define NSEC_PER_MSEC 1000000ULL
+
+/* how long the min RTT stays valid without being seen again */
+#define MIN_RTT_WINDOW (10ULL * NSEC_PER_SEC)
+
+/* length of each gain phase, long enough for the encoder to settle on a new
+ * bitrate and for the delivery rate to reflect it */
+#define PHASE_DURATION (1ULL * NSEC_PER_SEC)
+
+/* a queue this long, either in the socket (RTT above the minimum) or in
+ * front of it, means the bitrate is above what the link can carry */
+#define QUEUE_LIMIT_USEC 250000
+#define QUEUE_CLEAR_USEC 80000
+
+/* gains in percent, one probe phase, one drain phase, then cruise */
+static const int phase_gain[DBR_MODEL_CYCLE_PHASES] = {125, 80,  100, 100,
+						       100, 100, 100, 100};
+
+static inline long clamp_kbps(const struct dbr_model *model, long kbps)
+{
+	if (kbps < model->min_kbps)
+		return model->min_kbps;
+	if (kbps > model->max_kbps)
+		return model->max_kbps;
+	return kbps;
+}
+
+void dbr_model_init(struct dbr_model *model, long min_kbps, long max_kbps,
+		    uint64_t now)
+{
+	memset(model, 0, sizeof(*model));
+	model->min_kbps = min_kbps;
+	model->max_kbps = max_kbps;
+	model->target_kbps = max_kbps;
+	model->bw_slot_ts = now;
+	model->phase_ts = now;
+
+	/* start cruising, the first probe comes once there is an estimate */
+	model->phase = 2;
+}
+
+long dbr_model_bandwidth(const struct dbr_model *model)
+{
+	long bw = 0;
+
+	for (size_t i = 0; i < DBR_MODEL_BW_SLOTS; i++) {
+		if (model->bw_slots[i] > bw)
+			bw = model->bw_slots[i];
+	}
+
+	return bw;
+}
+
+static void advance_bw_slots(struct dbr_model *model, uint64_t now)
+{
+	while (now - model->bw_slot_ts >= NSEC_PER_SEC) {
+		model->bw_slot = (model->bw_slot + 1) % DBR_MODEL_BW_SLOTS;
+		model->bw_slots[model->bw_slot] = 0;
+		model->bw_slot_ts += NSEC_PER_SEC;
+	}
+}
+
+void dbr_model_add_sample(struct dbr_model *model, uint64_t now,
+			  long delivery_kbps, uint64_t rtt_us)
+{
+	advance_bw_slots(model, now);
+
+	/* while data is queued the sender is never idle, so what gets
+	 * delivered is the link's capacity.  otherwise it's only a lower
+	 * bound, which the max filter handles the same way. */
+	if (delivery_kbps > model->bw_slots[model->bw_slot])
+		model->bw_slots[model->bw_slot] = delivery_kbps;
+
+	model->delivery_kbps =
+		model->delivery_kbps
+			? (model->delivery_kbps * 3 + delivery_kbps) / 4
+			: delivery_kbps;
+
+	if (rtt_us) {
+		/* while draining the RTT is inflated by our own queue, so let
+		 * an old minimum stand until the queue is gone */
+		bool expired = now - model->min_rtt_ts > MIN_RTT_WINDOW &&
+			       !model->draining;
+
+		if (!model->min_rtt_us || rtt_us <= model->min_rtt_us ||
+		    expired) {
+			model->min_rtt_us = rtt_us;
+			model->min_rtt_ts = now;
+		}
+
+		model->srtt_us = model->srtt_us
+					 ? (model->srtt_us * 7 + rtt_us) / 8
+					 : rtt_us;
+	}
+}
+
+static inline int64_t queue_delay_usec(const struct dbr_model *model,
+				       int64_t queued_usec)
+{
+	int64_t rtt_queue = 0;
+
+	if (model->srtt_us > model->min_rtt_us)
+		rtt_queue = (int64_t)(model->srtt_us - model->min_rtt_us);
+
+	return queued_usec > rtt_queue ? queued_usec : rtt_queue;
+}
+
+long dbr_model_update(struct dbr_model *model, uint64_t now,
+		      int64_t queued_usec)
+{
+	int64_t queue = queue_delay_usec(model, queued_usec);
+	long bw;
+	int gain;
+
+	advance_bw_slots(model, now);
+
+	bw = dbr_model_bandwidth(model);
+	if (!bw)
+		return model->target_kbps;
+
+	if (queue > QUEUE_LIMIT_USEC) {
+		/* the link got slower.  with data queued the sender is never
+		 * idle, so the delivery rate is the link's capacity: replace
+		 * the old estimate with it instead of waiting for it to age
+		 * out, and stay below it until the queue has drained. */
+		if (model->delivery_kbps) {
+			memset(model->bw_slots, 0, sizeof(model->bw_slots));
+			model->bw_slots[model->bw_slot] = model->delivery_kbps;
+			bw = model->delivery_kbps;
+		}
+
+		model->draining = true;
+		model->target_kbps = clamp_kbps(model, bw * 85 / 100);
+		model->phase = 2;
+		model->phase_ts = now;
+		return model->target_kbps;
+	}
+
+	if (model->draining) {
+		if (queue > QUEUE_CLEAR_USEC)
+			return model->target_kbps;
+		model->draining = false;
+		model->phase_ts = now;
+	}
+
+	if (now - model->phase_ts >= PHASE_DURATION) {
+		model->phase = (model->phase + 1) % DBR_MODEL_CYCLE_PHASES;
+		model->phase_ts = now;
+	}
+
+	/* no point probing above the configured bitrate, nor draining the
+	 * queue a probe would have built */
+	gain = phase_gain[model->phase];
+	if (bw >= model->max_kbps)
+		gain = 100;
+
+	model->target_kbps = clamp_kbps(model, bw * gain / 100);
+	return model->target_kbps;
+}
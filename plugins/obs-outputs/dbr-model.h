@@ -0,0 +1,71 @@
+/******************************************************************************
+    Copyright (C) 2023 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+#include <util/c99defs.h>
+
+/* Model-based dynamic bitrate, loosely following BBR: the bottleneck
+ * bandwidth is the windowed max of the delivery rate and the propagation
+ * delay is the windowed min of the RTT.  The bitrate mostly sits at the
+ * bandwidth estimate, is periodically pushed slightly above it to find out
+ * whether more is available, and falls back to the measured delivery rate
+ * as soon as a queue starts building.
+ *
+ * Kept free of libobs and socket code so it can be replayed against
+ * recorded network traces. */
+
+#define DBR_MODEL_BW_SLOTS 10
+#define DBR_MODEL_CYCLE_PHASES 8
+
+struct dbr_model {
+	long min_kbps;
+	long max_kbps;
+
+	/* per-second max delivery rate over the last DBR_MODEL_BW_SLOTS s */
+	long bw_slots[DBR_MODEL_BW_SLOTS];
+	uint64_t bw_slot_ts;
+	size_t bw_slot;
+
+	/* smoothed recent delivery rate */
+	long delivery_kbps;
+
+	uint64_t min_rtt_us;
+	uint64_t min_rtt_ts;
+	uint64_t srtt_us;
+
+	long target_kbps;
+	int phase;
+	uint64_t phase_ts;
+	bool draining;
+};
+
+/* all times in nanoseconds, rates in kbps of video bitrate */
+extern void dbr_model_init(struct dbr_model *model, long min_kbps,
+			   long max_kbps, uint64_t now);
+
+/* delivery_kbps is the bitrate that made it out of the socket recently,
+ * rtt_us the RTT reported by the kernel, or 0 if unavailable */
+extern void dbr_model_add_sample(struct dbr_model *model, uint64_t now,
+				 long delivery_kbps, uint64_t rtt_us);
+
+/* returns the bitrate the encoder should use now, queued_usec being the
+ * duration of the data waiting to be sent */
+extern long dbr_model_update(struct dbr_model *model, uint64_t now,
+			     int64_t queued_usec);
+
+extern long dbr_model_bandwidth(const struct dbr_model *model);
@@ -16,6 +16,11 @@
 ******************************************************************************/
 
 #include <obs.h>
+#include <obs-avc.h>
+#include <obs-av1.h>
+#ifdef ENABLE_HEVC
+#include <obs-hevc.h>
+#endif
 #include <stdio.h>
 #include <util/dstr.h>
 #include <util/array-serializer.h>
@@ -23,8 +28,10 @@
 #include "obs-output-ver.h"
 #include "rtmp-helpers.h"
 
-/* TODO: FIXME: this is currently hard-coded to h264 and aac!  ..not that we'll
- * use anything else for a long time. */
+/* Audio is hard-coded to AAC.  H.264 video uses the legacy FLV video tag,
+ * HEVC and AV1 use Enhanced RTMP FourCC video tags.  Video packets with a
+ * track index above 0 are sent as Enhanced RTMP multitrack tags so several
+ * renditions can share one connection. */
 
 //#define DEBUG_TIMESTAMPS
 //#define WRITE_FLV_HEADER
@@ -33,6 +40,77 @@
 #define VIDEODATA_AVCVIDEOPACKET 7.0
 #define AUDIODATA_AAC 10.0
 
+#define FOURCC(a, b, c, d)                                       \
+	(((uint32_t)(a) << 24) | ((uint32_t)(b) << 16) |         \
+	 ((uint32_t)(c) << 8) | (uint32_t)(d))
+
+/* Enhanced RTMP video tag */
+#define EX_HEADER_FLAG 0x80
+#define FRAME_TYPE_KEY 1
+#define FRAME_TYPE_INTER 2
+
+enum ex_packet_type {
+	PACKET_TYPE_SEQUENCE_START = 0,
+	PACKET_TYPE_CODED_FRAMES = 1,
+	PACKET_TYPE_SEQUENCE_END = 2,
+	PACKET_TYPE_CODED_FRAMES_X = 3,
+	PACKET_TYPE_METADATA = 4,
+	PACKET_TYPE_MPEG2TS_SEQUENCE_START = 5,
+	PACKET_TYPE_MULTITRACK = 6,
+};
+
+#define MULTITRACK_TYPE_ONE_TRACK 0
+
+static const uint32_t codec_fourcc[] = {
+	[FLV_CODEC_AVC] = FOURCC('a', 'v', 'c', '1'),
+	[FLV_CODEC_HEVC] = FOURCC('h', 'v', 'c', '1'),
+	[FLV_CODEC_AV1] = FOURCC('a', 'v', '0', '1'),
+};
+
+enum flv_video_codec flv_get_video_codec(obs_encoder_t *encoder)
+{
+	const char *codec = encoder ? obs_encoder_get_codec(encoder) : NULL;
+
+	if (codec && strcmp(codec, "hevc") == 0)
+		return FLV_CODEC_HEVC;
+	if (codec && strcmp(codec, "av1") == 0)
+		return FLV_CODEC_AV1;
+	return FLV_CODEC_AVC;
+}
+
+void flv_parse_video_packet(struct encoder_packet *dst,
+			    const struct encoder_packet *src)
+{
+	switch (flv_get_video_codec(src->encoder)) {
+#ifdef ENABLE_HEVC
+	case FLV_CODEC_HEVC:
+		obs_parse_hevc_packet(dst, src);
+		return;
+#endif
+	case FLV_CODEC_AV1:
+		obs_parse_av1_packet(dst, src);
+		return;
+	default:
+		obs_parse_avc_packet(dst, src);
+		return;
+	}
+}
+
+size_t flv_parse_video_header(obs_encoder_t *encoder, uint8_t **header,
+			      const uint8_t *data, size_t size)
+{
+	switch (flv_get_video_codec(encoder)) {
+#ifdef ENABLE_HEVC
+	case FLV_CODEC_HEVC:
+		return obs_parse_hevc_header(header, data, size);
+#endif
+	case FLV_CODEC_AV1:
+		return obs_parse_av1_header(header, data, size);
+	default:
+		return obs_parse_avc_header(header, data, size);
+	}
+}
+
 static inline double encoder_bitrate(obs_encoder_t *encoder)
 {
 	obs_data_t *settings = obs_encoder_get_settings(encoder);
@@ -84,7 +162,10 @@ static void build_flv_meta_data(obs_output_t *context, uint8_t **output,
 	enc_num_val(&enc, end, "height",
 		    (double)obs_encoder_get_height(vencoder));
 
-	enc_num_val(&enc, end, "videocodecid", VIDEODATA_AVCVIDEOPACKET);
+	enum flv_video_codec codec = flv_get_video_codec(vencoder);
+	enc_num_val(&enc, end, "videocodecid",
+		    codec == FLV_CODEC_AVC ? VIDEODATA_AVCVIDEOPACKET
+					   : (double)codec_fourcc[codec]);
 	enc_num_val(&enc, end, "videodatarate", encoder_bitrate(vencoder));
 	enc_num_val(&enc, end, "framerate", video_output_get_frame_rate(video));
 
@@ -169,15 +250,77 @@ void flv_meta_data(obs_output_t *context, uint8_t **output, size_t *size,
 static int32_t last_time = 0;
 #endif
 
+static size_t flv_video_prefix(struct encoder_packet *packet, bool is_header,
+			       uint8_t prefix[FLV_BODY_PREFIX_MAX])
+{
+	enum flv_video_codec codec = flv_get_video_codec(packet->encoder);
+	int32_t offset = get_ms_time(packet, packet->pts - packet->dts);
+	uint8_t frame_type = packet->keyframe ? FRAME_TYPE_KEY
+					      : FRAME_TYPE_INTER;
+	bool multitrack = packet->track_idx > 0;
+	uint8_t packet_type;
+	uint32_t fourcc;
+	size_t size = 0;
+
+	if (codec == FLV_CODEC_AVC && !multitrack) {
+		prefix[0] = (frame_type << 4) | 7;
+		prefix[1] = is_header ? 0 : 1;
+		prefix[2] = (uint8_t)(offset >> 16);
+		prefix[3] = (uint8_t)(offset >> 8);
+		prefix[4] = (uint8_t)offset;
+		return 5;
+	}
+
+	/* only AVC and HEVC frames carry a composition time offset, send
+	 * HEVC frames without one more compactly */
+	if (is_header)
+		packet_type = PACKET_TYPE_SEQUENCE_START;
+	else if (codec == FLV_CODEC_AV1 ||
+		 (codec == FLV_CODEC_HEVC && offset == 0))
+		packet_type = PACKET_TYPE_CODED_FRAMES_X;
+	else
+		packet_type = PACKET_TYPE_CODED_FRAMES;
+
+	fourcc = codec_fourcc[codec];
+
+	if (multitrack) {
+		prefix[size++] = EX_HEADER_FLAG | (frame_type << 4) |
+				 PACKET_TYPE_MULTITRACK;
+		prefix[size++] = (MULTITRACK_TYPE_ONE_TRACK << 4) | packet_type;
+	} else {
+		prefix[size++] = EX_HEADER_FLAG | (frame_type << 4) |
+				 packet_type;
+	}
+
+	prefix[size++] = (uint8_t)(fourcc >> 24);
+	prefix[size++] = (uint8_t)(fourcc >> 16);
+	prefix[size++] = (uint8_t)(fourcc >> 8);
+	prefix[size++] = (uint8_t)fourcc;
+
+	if (multitrack)
+		prefix[size++] = (uint8_t)packet->track_idx;
+
+	if (packet_type == PACKET_TYPE_CODED_FRAMES) {
+		prefix[size++] = (uint8_t)(offset >> 16);
+		prefix[size++] = (uint8_t)(offset >> 8);
+		prefix[size++] = (uint8_t)offset;
+	}
+
+	return size;
+}
+
 static void flv_video(struct serializer *s, int32_t dts_offset,
 		      struct encoder_packet *packet, bool is_header)
 {
-	int64_t offset = packet->pts - packet->dts;
 	int32_t time_ms = get_ms_time(packet, packet->dts) - dts_offset;
+	uint8_t prefix[FLV_BODY_PREFIX_MAX];
+	size_t prefix_size;
 
 	if (!packet->data || !packet->size)
 		return;
 
+	prefix_size = flv_video_prefix(packet, is_header, prefix);
+
 	s_w8(s, RTMP_PACKET_TYPE_VIDEO);
 
 #ifdef DEBUG_TIMESTAMPS
@@ -189,15 +332,12 @@ static void flv_video(struct serializer *s, int32_t dts_offset,
 	last_time = time_ms;
 #endif
 
-	s_wb24(s, (uint32_t)packet->size + 5);
+	s_wb24(s, (uint32_t)(packet->size + prefix_size));
 	s_wb24(s, time_ms);
 	s_w8(s, (time_ms >> 24) & 0x7F);
 	s_wb24(s, 0);
 
-	/* these are the 5 extra bytes mentioned above */
-	s_w8(s, packet->keyframe ? 0x17 : 0x27);
-	s_w8(s, is_header ? 0 : 1);
-	s_wb24(s, get_ms_time(packet, offset));
+	s_write(s, prefix, prefix_size);
 	s_write(s, packet->data, packet->size);
 
 	/* write tag size (starting byte doesn't count) */
@@ -254,6 +394,26 @@ void flv_packet_mux(struct encoder_packet *packet, int32_t dts_offset,
 	*size = data.bytes.num;
 }
 
+/* writes the same bytes flv_video/flv_audio put in front of the packet data,
+ * for sending packets without muxing them into a new buffer */
+size_t flv_packet_body_prefix(struct encoder_packet *packet, int32_t dts_offset,
+			      bool is_header,
+			      uint8_t prefix[FLV_BODY_PREFIX_MAX],
+			      uint8_t *type, int32_t *time_ms)
+{
+	*time_ms = get_ms_time(packet, packet->dts) - dts_offset;
+
+	if (packet->type == OBS_ENCODER_VIDEO) {
+		*type = RTMP_PACKET_TYPE_VIDEO;
+		return flv_video_prefix(packet, is_header, prefix);
+	}
+
+	*type = RTMP_PACKET_TYPE_AUDIO;
+	prefix[0] = 0xaf;
+	prefix[1] = is_header ? 0 : 1;
+	return 2;
+}
+
 /* ------------------------------------------------------------------------- */
 /* stuff for additional media streams                                        */
 
@@ -34,6 +34,32 @@ extern void flv_additional_meta_data(obs_output_t *context, uint8_t **output,
 				     size_t *size);
 extern void flv_packet_mux(struct encoder_packet *packet, int32_t dts_offset,
 			   uint8_t **output, size_t *size, bool is_header);
+
+enum flv_video_codec {
+	FLV_CODEC_AVC,
+	FLV_CODEC_HEVC,
+	FLV_CODEC_AV1,
+};
+
+extern enum flv_video_codec flv_get_video_codec(obs_encoder_t *encoder);
+
+/* converts encoder output to what FLV video tags carry, and sets the
+ * packet's priority for frame dropping */
+extern void flv_parse_video_packet(struct encoder_packet *dst,
+				   const struct encoder_packet *src);
+
+/* builds the sequence header for a video encoder from its extra data */
+extern size_t flv_parse_video_header(obs_encoder_t *encoder, uint8_t **header,
+				     const uint8_t *data, size_t size);
+
+/* the part of an FLV audio/video tag body that comes before the packet data,
+ * at most an Enhanced RTMP multitrack video header */
+#define FLV_BODY_PREFIX_MAX 10
+
+extern size_t flv_packet_body_prefix(struct encoder_packet *packet,
+				     int32_t dts_offset, bool is_header,
+				     uint8_t prefix[FLV_BODY_PREFIX_MAX],
+				     uint8_t *type, int32_t *time_ms);
 extern void flv_additional_packet_mux(struct encoder_packet *packet,
 				      int32_t dts_offset, uint8_t **output,
 				      size_t *size, bool is_header,
@@ -131,12 +131,15 @@ static void write_video_header(struct flv_output *stream)
 	uint8_t *header;
 	size_t size;
 
-	struct encoder_packet packet = {
-		.type = OBS_ENCODER_VIDEO, .timebase_den = 1, .keyframe = true};
+	struct encoder_packet packet = {.type = OBS_ENCODER_VIDEO,
+					.timebase_den = 1,
+					.keyframe = true,
+					.encoder = vencoder};
 
 	if (!obs_encoder_get_extra_data(vencoder, &header, &size))
 		return;
-	packet.size = obs_parse_avc_header(&packet.data, header, size);
+	packet.size =
+		flv_parse_video_header(vencoder, &packet.data, header, size);
 	write_packet(stream, &packet, true);
 	bfree(packet.data);
 }
@@ -243,7 +246,7 @@ static void flv_output_data(void *data, struct encoder_packet *packet)
 			stream->got_first_video = true;
 		}
 
-		obs_parse_avc_packet(&parsed_packet, packet);
+		flv_parse_video_packet(&parsed_packet, packet);
 		write_packet(stream, &parsed_packet, false);
 		obs_encoder_packet_release(&parsed_packet);
 	} else {
@@ -275,7 +278,11 @@ static obs_properties_t *flv_output_properties(void *unused)
 struct obs_output_info flv_output_info = {
 	.id = "flv_output",
 	.flags = OBS_OUTPUT_AV | OBS_OUTPUT_ENCODED,
-	.encoded_video_codecs = "h264",
+#ifdef ENABLE_HEVC
+	.encoded_video_codecs = "h264;hevc;av1",
+#else
+	.encoded_video_codecs = "h264;av1",
+#endif
 	.encoded_audio_codecs = "aac",
 	.get_name = flv_output_getname,
 	.create = flv_output_create,
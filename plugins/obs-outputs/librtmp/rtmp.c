@@ -33,6 +33,11 @@
 #include "log.h"
 
 #include <util/platform.h>
+#include <util/threading.h>
+
+#if !defined(_WIN32)
+#include <sys/uio.h>
+#endif
 
 #if !defined(MSG_NOSIGNAL)
 #define MSG_NOSIGNAL 0
@@ -470,6 +475,7 @@ RTMP_Init(RTMP *r)
 {
     memset(r, 0, sizeof(RTMP));
     r->m_sb.sb_socket = -1;
+    r->m_standbySocket = INVALID_SOCKET;
     RTMP_Reset(r);
     RTMP_TLS_Init(r);
 }
@@ -753,11 +759,132 @@ int RTMP_AddStream(RTMP *r, const char *playpath)
     return idx;
 }
 
+#define RTMP_DNS_CACHE_SIZE 8
+#define RTMP_DNS_CACHE_TTL_NS (300 * 1000000000ULL)
+
+/* getaddrinfo doesn't tell us the record TTL, so resolved addresses are
+ * kept for a fixed time.  reconnects skip the lookup, and an entry is
+ * dropped as soon as none of its addresses can be connected to. */
+struct dns_cache_entry
+{
+    char host[256];
+    int port;
+    uint64_t expires;
+    struct rtmp_addr_list list;
+};
+
+static pthread_mutex_t dns_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct dns_cache_entry dns_cache[RTMP_DNS_CACHE_SIZE];
+
 static int
-add_addr_info(struct sockaddr_storage *service, socklen_t *addrlen, AVal *host, int port, socklen_t addrlen_hint, int *socket_error)
+dns_cache_lookup(const char *host, int port, struct rtmp_addr_list *list)
+{
+    uint64_t now = os_gettime_ns();
+    int found = FALSE;
+
+    pthread_mutex_lock(&dns_cache_mutex);
+    for (int i = 0; i < RTMP_DNS_CACHE_SIZE; i++)
+    {
+        struct dns_cache_entry *entry = &dns_cache[i];
+        if (entry->expires > now && entry->port == port &&
+            strcmp(entry->host, host) == 0)
+        {
+            *list = entry->list;
+            found = TRUE;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&dns_cache_mutex);
+
+    return found;
+}
+
+static void
+dns_cache_store(const char *host, int port, const struct rtmp_addr_list *list)
+{
+    struct dns_cache_entry *slot = &dns_cache[0];
+
+    if (strlen(host) >= sizeof(slot->host))
+        return;
+
+    pthread_mutex_lock(&dns_cache_mutex);
+    for (int i = 0; i < RTMP_DNS_CACHE_SIZE; i++)
+    {
+        struct dns_cache_entry *entry = &dns_cache[i];
+        if ((entry->port == port && strcmp(entry->host, host) == 0) ||
+            entry->expires < slot->expires)
+            slot = entry;
+        if (entry->port == port && strcmp(entry->host, host) == 0)
+            break;
+    }
+
+    strcpy(slot->host, host);
+    slot->port = port;
+    slot->list = *list;
+    slot->expires = os_gettime_ns() + RTMP_DNS_CACHE_TTL_NS;
+    pthread_mutex_unlock(&dns_cache_mutex);
+}
+
+static void
+dns_cache_remove(const AVal *host, int port)
+{
+    pthread_mutex_lock(&dns_cache_mutex);
+    for (int i = 0; i < RTMP_DNS_CACHE_SIZE; i++)
+    {
+        struct dns_cache_entry *entry = &dns_cache[i];
+        if (entry->port == port &&
+            (int)strlen(entry->host) <= host->av_len &&
+            strncmp(entry->host, host->av_val + (host->av_val[0] == '['),
+                    strlen(entry->host)) == 0)
+            entry->expires = 0;
+    }
+    pthread_mutex_unlock(&dns_cache_mutex);
+}
+
+/* orders the addresses for connecting: IPv4 still goes first, since lots of
+ * ISPs have broken IPv6 connectivity, but families alternate after that so
+ * a dead family only costs one connection attempt delay */
+static void
+add_sorted_addrs(struct rtmp_addr_list *list, struct addrinfo *result)
+{
+    struct addrinfo *v4 = result;
+    struct addrinfo *v6 = result;
+    int family = AF_INET;
+
+    list->count = 0;
+
+    while (list->count < RTMP_MAX_ADDRS)
+    {
+        struct addrinfo **next = family == AF_INET ? &v4 : &v6;
+        struct addrinfo *other = family == AF_INET ? v6 : v4;
+
+        while (*next && (*next)->ai_family != family)
+            *next = (*next)->ai_next;
+
+        if (*next)
+        {
+            memcpy(&list->addrs[list->count], (*next)->ai_addr,
+                   (*next)->ai_addrlen);
+            list->lens[list->count] = (socklen_t)(*next)->ai_addrlen;
+            list->count++;
+            *next = (*next)->ai_next;
+        }
+        else if (!other)
+        {
+            break;
+        }
+
+        family = family == AF_INET ? AF_INET6 : AF_INET;
+    }
+}
+
+static int
+resolve_addrs(struct rtmp_addr_list *list, AVal *host, int port, socklen_t addrlen_hint, int *socket_error)
 {
     char *hostname;
     int ret = TRUE;
+    struct rtmp_addr_list all;
+
     if (host->av_val[host->av_len] || host->av_val[0] == '[')
     {
         int v6 = host->av_val[0] == '[';
@@ -770,63 +897,54 @@ add_addr_info(struct sockaddr_storage *service, socklen_t *addrlen, AVal *host,
         hostname = host->av_val;
     }
 
-    struct addrinfo hints;
-    struct addrinfo *result = NULL;
-    struct addrinfo *ptr = NULL;
-
-    memset(&hints, 0, sizeof(hints));
+    if (!dns_cache_lookup(hostname, port, &all))
+    {
+        struct addrinfo hints;
+        struct addrinfo *result = NULL;
 
-    hints.ai_family = AF_UNSPEC;
-    hints.ai_socktype = SOCK_STREAM;
-    hints.ai_protocol = IPPROTO_TCP;
+        memset(&hints, 0, sizeof(hints));
 
-    service->ss_family = AF_UNSPEC;
-    *addrlen = 0;
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_protocol = IPPROTO_TCP;
 
-    char portStr[8];
+        char portStr[8];
 
-    sprintf(portStr, "%d", port);
+        sprintf(portStr, "%d", port);
 
-    int err = getaddrinfo(hostname, portStr, &hints, &result);
+        int err = getaddrinfo(hostname, portStr, &hints, &result);
 
-    if (err)
-    {
+        if (err)
+        {
 #ifndef _WIN32
 #define gai_strerrorA gai_strerror
 #endif
-        RTMP_Log(RTMP_LOGERROR, "Could not resolve %s: %s (%d)", hostname, gai_strerrorA(GetSockError()), GetSockError());
-        *socket_error = GetSockError();
-        ret = FALSE;
-        goto finish;
-    }
-
-    // prefer ipv4 results, since lots of ISPs have broken ipv6 connectivity
-    for (ptr = result; ptr != NULL; ptr = ptr->ai_next)
-    {
-        if (ptr->ai_family == AF_INET && (!addrlen_hint || ptr->ai_addrlen == addrlen_hint))
-        {
-            memcpy(service, ptr->ai_addr, ptr->ai_addrlen);
-            *addrlen = (socklen_t)ptr->ai_addrlen;
-            break;
+            RTMP_Log(RTMP_LOGERROR, "Could not resolve %s: %s (%d)", hostname, gai_strerrorA(GetSockError()), GetSockError());
+            *socket_error = GetSockError();
+            ret = FALSE;
+            goto finish;
         }
+
+        add_sorted_addrs(&all, result);
+        freeaddrinfo(result);
+
+        if (all.count)
+            dns_cache_store(hostname, port, &all);
     }
 
-    if (!*addrlen)
+    /* only keep addresses of the bound address's family */
+    list->count = 0;
+    for (int i = 0; i < all.count; i++)
     {
-        for (ptr = result; ptr != NULL; ptr = ptr->ai_next)
+        if (!addrlen_hint || all.lens[i] == addrlen_hint)
         {
-            if (ptr->ai_family == AF_INET6 && (!addrlen_hint || ptr->ai_addrlen == addrlen_hint))
-            {
-                memcpy(service, ptr->ai_addr, ptr->ai_addrlen);
-                *addrlen = (socklen_t)ptr->ai_addrlen;
-                break;
-            }
+            list->addrs[list->count] = all.addrs[i];
+            list->lens[list->count] = all.lens[i];
+            list->count++;
         }
     }
 
-    freeaddrinfo(result);
-
-    if (service->ss_family == AF_UNSPEC || *addrlen == 0)
+    if (list->count == 0)
     {
         // since we're handling multiple addresses internally, fake the correct error response
 #ifdef _WIN32
@@ -850,6 +968,22 @@ finish:
     return ret;
 }
 
+static int
+add_addr_info(struct sockaddr_storage *service, socklen_t *addrlen, AVal *host, int port, socklen_t addrlen_hint, int *socket_error)
+{
+    struct rtmp_addr_list list;
+
+    service->ss_family = AF_UNSPEC;
+    *addrlen = 0;
+
+    if (!resolve_addrs(&list, host, port, addrlen_hint, socket_error))
+        return FALSE;
+
+    *service = list.addrs[0];
+    *addrlen = list.lens[0];
+    return TRUE;
+}
+
 #ifdef _WIN32
 #define E_TIMEDOUT     WSAETIMEDOUT
 #define E_CONNREFUSED  WSAECONNREFUSED
@@ -860,79 +994,307 @@ finish:
 #define E_ACCES        EACCES
 #endif
 
-int
-RTMP_Connect0(RTMP *r, struct sockaddr * service, socklen_t addrlen)
+#ifdef _WIN32
+#define E_INPROGRESS   WSAEWOULDBLOCK
+#else
+#define E_INPROGRESS   EINPROGRESS
+#endif
+
+#define RTMP_CONNECT_ATTEMPT_DELAY_MS 250
+#define RTMP_CONNECT_TIMEOUT_SEC 20
+
+static void
+log_connect_error(const AVal *hostname, int err)
 {
-    int on = 1;
-    r->m_sb.sb_timedout = FALSE;
-    r->m_pausing = 0;
-    r->m_fDuration = 0.0;
+    if (err == E_CONNREFUSED)
+        RTMP_Log(RTMP_LOGERROR, "%s is offline. Try a different server (ECONNREFUSED).", hostname->av_val);
+    else if (err == E_ACCES)
+        RTMP_Log(RTMP_LOGERROR, "The connection is being blocked by a firewall or other security software (EACCES).");
+    else if (err == E_TIMEDOUT)
+        RTMP_Log(RTMP_LOGERROR, "The connection timed out. Try a different server, or check that the connection is not being blocked by a firewall or other security software (ETIMEDOUT).");
+    else
+        RTMP_Log(RTMP_LOGERROR, "%s, failed to connect socket: %s (%d)",
+                 __FUNCTION__, socketerror(err), err);
+}
+
+static int
+set_socket_nonblocking(SOCKET sock, int enable)
+{
+#ifdef _WIN32
+    u_long mode = enable ? 1 : 0;
+    return ioctlsocket(sock, FIONBIO, &mode) == 0;
+#else
+    int flags = fcntl(sock, F_GETFL, 0);
+    if (flags < 0)
+        return FALSE;
+    flags = enable ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK);
+    return fcntl(sock, F_SETFL, flags) == 0;
+#endif
+}
+
+static SOCKET
+start_connect(const struct sockaddr_storage *addr, socklen_t addrlen, const RTMP_BINDINFO *bindIP, int *socket_error)
+{
+    SOCKET sock;
 
     //best to be explicit, we need overlapped socket
 #ifdef _WIN32
-    r->m_sb.sb_socket = WSASocket(service->sa_family, SOCK_STREAM, IPPROTO_TCP, NULL, 0, WSA_FLAG_OVERLAPPED);
+    sock = WSASocket(addr->ss_family, SOCK_STREAM, IPPROTO_TCP, NULL, 0, WSA_FLAG_OVERLAPPED);
 #else
-    r->m_sb.sb_socket = socket(service->sa_family, SOCK_STREAM, IPPROTO_TCP);
+    sock = socket(addr->ss_family, SOCK_STREAM, IPPROTO_TCP);
 #endif
 
-    if (r->m_sb.sb_socket != INVALID_SOCKET)
+    if (sock == INVALID_SOCKET)
     {
+        *socket_error = GetSockError();
+        RTMP_Log(RTMP_LOGERROR, "%s, failed to create socket. Error: %d", __FUNCTION__,
+                 *socket_error);
+        return INVALID_SOCKET;
+    }
+
 #ifndef _WIN32
 #ifdef SO_NOSIGPIPE
-        setsockopt(r->m_sb.sb_socket, SOL_SOCKET, SO_NOSIGPIPE, &(int){ 1 }, sizeof(int));
+    setsockopt(sock, SOL_SOCKET, SO_NOSIGPIPE, &(int){ 1 }, sizeof(int));
 #endif
 #endif
-        if(r->m_bindIP.addrLen)
+
+    if (bindIP->addrLen)
+    {
+        if (bind(sock, (const struct sockaddr *)&bindIP->addr, bindIP->addrLen) < 0)
+        {
+            *socket_error = GetSockError();
+            RTMP_Log(RTMP_LOGERROR, "%s, failed to bind socket: %s (%d)",
+                     __FUNCTION__, socketerror(*socket_error), *socket_error);
+            closesocket(sock);
+            return INVALID_SOCKET;
+        }
+    }
+
+    if (!set_socket_nonblocking(sock, TRUE))
+    {
+        *socket_error = GetSockError();
+        closesocket(sock);
+        return INVALID_SOCKET;
+    }
+
+    if (connect(sock, (const struct sockaddr *)addr, addrlen) < 0)
+    {
+        int err = GetSockError();
+        if (err != E_INPROGRESS)
+        {
+            *socket_error = err;
+            closesocket(sock);
+            return INVALID_SOCKET;
+        }
+    }
+
+    return sock;
+}
+
+/* Connects to the first address that answers.  Attempts are started
+ * RTMP_CONNECT_ATTEMPT_DELAY_MS apart, or right away when the previous one
+ * fails, without abandoning the ones still in progress (RFC 8305). */
+static SOCKET
+connect_addrs(const struct rtmp_addr_list *list, const RTMP_BINDINFO *bindIP, int *socket_error)
+{
+    SOCKET socks[RTMP_MAX_ADDRS];
+    SOCKET result = INVALID_SOCKET;
+    uint64_t now = os_gettime_ns();
+    uint64_t deadline = now + RTMP_CONNECT_TIMEOUT_SEC * 1000000000ULL;
+    uint64_t next_attempt = now;
+    int started = 0;
+
+    *socket_error = 0;
+
+    for (int i = 0; i < RTMP_MAX_ADDRS; i++)
+        socks[i] = INVALID_SOCKET;
+
+    while (result == INVALID_SOCKET)
+    {
+        fd_set wfds, efds;
+        SOCKET maxfd = 0;
+        int pending = 0;
+        uint64_t wait_until;
+        struct timeval tv;
+
+        now = os_gettime_ns();
+        if (now >= deadline)
+        {
+            *socket_error = E_TIMEDOUT;
+            break;
+        }
+
+        if (started < list->count && now >= next_attempt)
+        {
+            socks[started] = start_connect(&list->addrs[started],
+                                           list->lens[started], bindIP,
+                                           socket_error);
+            next_attempt = socks[started] == INVALID_SOCKET
+                           ? now
+                           : now + RTMP_CONNECT_ATTEMPT_DELAY_MS * 1000000ULL;
+            started++;
+        }
+
+        FD_ZERO(&wfds);
+        FD_ZERO(&efds);
+
+        for (int i = 0; i < started; i++)
+        {
+            if (socks[i] == INVALID_SOCKET)
+                continue;
+
+            FD_SET(socks[i], &wfds);
+            FD_SET(socks[i], &efds);
+            if (socks[i] > maxfd)
+                maxfd = socks[i];
+            pending++;
+        }
+
+        if (!pending)
+        {
+            if (started == list->count)
+                break;
+            continue;
+        }
+
+        wait_until = started < list->count && next_attempt < deadline
+                     ? next_attempt
+                     : deadline;
+        now = os_gettime_ns();
+        if (wait_until < now)
+            wait_until = now;
+
+        tv.tv_sec = (long)((wait_until - now) / 1000000000ULL);
+        tv.tv_usec = (long)((wait_until - now) % 1000000000ULL / 1000);
+
+        if (select((int)maxfd + 1, NULL, &wfds, &efds, &tv) < 0)
+        {
+            int err = GetSockError();
+            if (err == EINTR)
+                continue;
+
+            *socket_error = err;
+            break;
+        }
+
+        for (int i = 0; i < started; i++)
         {
-            if (bind(r->m_sb.sb_socket, (const struct sockaddr *)&r->m_bindIP.addr, r->m_bindIP.addrLen) < 0)
+            int err = 0;
+            socklen_t len = sizeof(err);
+
+            if (socks[i] == INVALID_SOCKET ||
+                (!FD_ISSET(socks[i], &wfds) && !FD_ISSET(socks[i], &efds)))
+                continue;
+
+            if (getsockopt(socks[i], SOL_SOCKET, SO_ERROR, (char *)&err, &len) < 0)
+                err = GetSockError();
+
+            if (!err && FD_ISSET(socks[i], &wfds))
             {
-                int err = GetSockError();
-                RTMP_Log(RTMP_LOGERROR, "%s, failed to bind socket: %s (%d)",
-                         __FUNCTION__, socketerror(err), err);
-                r->last_error_code = err;
-                RTMP_Close(r);
-                return FALSE;
+                result = socks[i];
+                socks[i] = INVALID_SOCKET;
+                break;
             }
+
+            *socket_error = err ? err : E_CONNREFUSED;
+            closesocket(socks[i]);
+            socks[i] = INVALID_SOCKET;
+            next_attempt = os_gettime_ns();
         }
+    }
+
+    for (int i = 0; i < started; i++)
+    {
+        if (socks[i] != INVALID_SOCKET)
+            closesocket(socks[i]);
+    }
+
+    if (result != INVALID_SOCKET && !set_socket_nonblocking(result, FALSE))
+    {
+        *socket_error = GetSockError();
+        closesocket(result);
+        result = INVALID_SOCKET;
+    }
+
+    return result;
+}
+
+SOCKET
+RTMP_ConnectSocket(AVal *host, int port, const RTMP_BINDINFO *bindIP, int *socket_error)
+{
+    struct rtmp_addr_list list;
+    SOCKET sock;
+
+    if (!resolve_addrs(&list, host, port, bindIP->addrLen, socket_error))
+        return INVALID_SOCKET;
+
+    sock = connect_addrs(&list, bindIP, socket_error);
+    if (sock == INVALID_SOCKET)
+        dns_cache_remove(host, port);
+
+    return sock;
+}
+
+int
+RTMP_IsSocketIdle(SOCKET sock)
+{
+    struct timeval tv = {0};
+    fd_set fds;
+
+    FD_ZERO(&fds);
+    FD_SET(sock, &fds);
+
+    return select((int)sock + 1, &fds, NULL, NULL, &tv) == 0;
+}
+
+void
+RTMP_CloseSocket(SOCKET sock)
+{
+    closesocket(sock);
+}
+
+static int
+connect_list(RTMP *r, const struct rtmp_addr_list *list)
+{
+    int on = 1;
+    r->m_sb.sb_timedout = FALSE;
+    r->m_pausing = 0;
+    r->m_fDuration = 0.0;
 
+    if (r->m_standbySocket != INVALID_SOCKET)
+    {
+        /* already connected ahead of time by the caller */
+        r->m_sb.sb_socket = r->m_standbySocket;
+        r->m_standbySocket = INVALID_SOCKET;
+        r->connect_time_ms = 0;
+    }
+    else
+    {
+        int err = 0;
         uint64_t connect_start = os_gettime_ns();
 
-        if (connect(r->m_sb.sb_socket, service, addrlen) < 0)
+        r->m_sb.sb_socket = connect_addrs(list, &r->m_bindIP, &err);
+        if (r->m_sb.sb_socket == INVALID_SOCKET)
         {
-            int err = GetSockError();
-            if (err == E_CONNREFUSED)
-                RTMP_Log(RTMP_LOGERROR, "%s is offline. Try a different server (ECONNREFUSED).", r->Link.hostname.av_val);
-            else if (err == E_ACCES)
-                RTMP_Log(RTMP_LOGERROR, "The connection is being blocked by a firewall or other security software (EACCES).");
-            else if (err == E_TIMEDOUT)
-                RTMP_Log(RTMP_LOGERROR, "The connection timed out. Try a different server, or check that the connection is not being blocked by a firewall or other security software (ETIMEDOUT).");
-            else
-                RTMP_Log(RTMP_LOGERROR, "%s, failed to connect socket: %s (%d)",
-                     __FUNCTION__, socketerror(err), err);
+            log_connect_error(&r->Link.hostname, err);
             r->last_error_code = err;
             RTMP_Close(r);
             return FALSE;
         }
 
         r->connect_time_ms = (int)((os_gettime_ns() - connect_start) / 1000000);
+    }
 
-        if (r->Link.socksport)
+    if (r->Link.socksport)
+    {
+        RTMP_Log(RTMP_LOGDEBUG, "%s ... SOCKS negotiation", __FUNCTION__);
+        if (!SocksNegotiate(r))
         {
-            RTMP_Log(RTMP_LOGDEBUG, "%s ... SOCKS negotiation", __FUNCTION__);
-            if (!SocksNegotiate(r))
-            {
-                RTMP_Log(RTMP_LOGERROR, "%s, SOCKS negotiation failed.", __FUNCTION__);
-                RTMP_Close(r);
-                return FALSE;
-            }
+            RTMP_Log(RTMP_LOGERROR, "%s, SOCKS negotiation failed.", __FUNCTION__);
+            RTMP_Close(r);
+            return FALSE;
         }
     }
-    else
-    {
-        RTMP_Log(RTMP_LOGERROR, "%s, failed to create socket. Error: %d", __FUNCTION__,
-                 GetSockError());
-        return FALSE;
-    }
 
     /* set timeout */
     {
@@ -960,6 +1322,18 @@ RTMP_Connect0(RTMP *r, struct sockaddr * service, socklen_t addrlen)
     return TRUE;
 }
 
+int
+RTMP_Connect0(RTMP *r, struct sockaddr * service, socklen_t addrlen)
+{
+    struct rtmp_addr_list list;
+
+    memcpy(&list.addrs[0], service, addrlen);
+    list.lens[0] = addrlen;
+    list.count = 1;
+
+    return connect_list(r, &list);
+}
+
 int
 RTMP_Connect1(RTMP *r, RTMPPacket *cp)
 {
@@ -1071,8 +1445,7 @@ RTMP_Connect(RTMP *r, RTMPPacket *cp)
 #ifdef _WIN32
     HOSTENT *h;
 #endif
-    struct sockaddr_storage service;
-    socklen_t addrlen = 0;
+    struct rtmp_addr_list list;
     socklen_t addrlen_hint = 0;
     int socket_error = 0;
 
@@ -1090,15 +1463,18 @@ RTMP_Connect(RTMP *r, RTMPPacket *cp)
     }
 #endif
 
-    memset(&service, 0, sizeof(service));
-
     if (r->m_bindIP.addrLen)
         addrlen_hint = r->m_bindIP.addrLen;
 
-    if (r->Link.socksport)
+    if (r->m_standbySocket != INVALID_SOCKET)
+    {
+        /* the caller connected ahead of time, skip the lookup */
+        list.count = 0;
+    }
+    else if (r->Link.socksport)
     {
         /* Connect via SOCKS */
-        if (!add_addr_info(&service, &addrlen, &r->Link.sockshost, r->Link.socksport, addrlen_hint, &socket_error))
+        if (!resolve_addrs(&list, &r->Link.sockshost, r->Link.socksport, addrlen_hint, &socket_error))
         {
             r->last_error_code = socket_error;
             return FALSE;
@@ -1107,15 +1483,22 @@ RTMP_Connect(RTMP *r, RTMPPacket *cp)
     else
     {
         /* Connect directly */
-        if (!add_addr_info(&service, &addrlen, &r->Link.hostname, r->Link.port, addrlen_hint, &socket_error))
+        if (!resolve_addrs(&list, &r->Link.hostname, r->Link.port, addrlen_hint, &socket_error))
         {
             r->last_error_code = socket_error;
             return FALSE;
         }
     }
 
-    if (!RTMP_Connect0(r, (struct sockaddr *)&service, addrlen))
+    if (!connect_list(r, &list))
+    {
+        /* the addresses may have changed, look them up again next time */
+        if (r->Link.socksport)
+            dns_cache_remove(&r->Link.sockshost, r->Link.socksport);
+        else
+            dns_cache_remove(&r->Link.hostname, r->Link.port);
         return FALSE;
+    }
 
     r->m_bSendCounter = TRUE;
 
@@ -4062,18 +4445,19 @@ RTMP_SendChunk(RTMP *r, RTMPChunk *chunk)
     return wrote;
 }
 
-int
-RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue)
+/* Writes the header for the first chunk of a packet so that it ends right at
+ * hend, compressing it against the previous packet on the same channel.
+ * Returns the header size, or 0 on failure. */
+static int
+EncodePacketHeader(RTMP *r, RTMPPacket *packet, char *hend, char **pheader,
+                   char *pc, int *pcSize)
 {
     const RTMPPacket *prevPacket;
     uint32_t last = 0;
     int nSize;
     int hSize, cSize;
-    char *header, *hptr, *hend, hbuf[RTMP_MAX_HEADER_SIZE], c;
+    char *header, *hptr, c;
     uint32_t t;
-    char *buffer, *tbuf = NULL, *toff = NULL;
-    int nChunkSize;
-    int tlen;
 
     if (packet->m_nChannel >= r->m_channelsAllocatedOut)
     {
@@ -4084,7 +4468,7 @@ RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue)
             free(r->m_vecChannelsOut);
             r->m_vecChannelsOut = NULL;
             r->m_channelsAllocatedOut = 0;
-            return FALSE;
+            return 0;
         }
         r->m_vecChannelsOut = packets;
         memset(r->m_vecChannelsOut + r->m_channelsAllocatedOut, 0, sizeof(RTMPPacket*) * (n - r->m_channelsAllocatedOut));
@@ -4110,7 +4494,7 @@ RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue)
     {
         RTMP_Log(RTMP_LOGERROR, "sanity failed!! trying to send header of type: 0x%02x.",
                  (unsigned char)packet->m_headerType);
-        return FALSE;
+        return 0;
     }
 
     nSize = packetSize[packet->m_headerType];
@@ -4118,16 +4502,7 @@ RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue)
     cSize = 0;
     t = packet->m_nTimeStamp - last;
 
-    if (packet->m_body)
-    {
-        header = packet->m_body - nSize;
-        hend = packet->m_body;
-    }
-    else
-    {
-        header = hbuf + 6;
-        hend = hbuf + sizeof(hbuf);
-    }
+    header = hend - nSize;
 
     if (packet->m_nChannel > 319)
         cSize = 2;
@@ -4184,6 +4559,28 @@ RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue)
     if (nSize > 1 && t >= 0xffffff)
         hptr = AMF_EncodeInt32(hptr, hend, t);
 
+    *pheader = header;
+    *pc = c;
+    *pcSize = cSize;
+    return hSize;
+}
+
+int
+RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue)
+{
+    int nSize;
+    int hSize, cSize;
+    char *header, hbuf[RTMP_MAX_HEADER_SIZE], c;
+    char *buffer, *tbuf = NULL, *toff = NULL;
+    int nChunkSize;
+    int tlen;
+
+    hSize = EncodePacketHeader(r, packet,
+                               packet->m_body ? packet->m_body : hbuf + sizeof(hbuf),
+                               &header, &c, &cSize);
+    if (!hSize)
+        return FALSE;
+
     nSize = packet->m_nBodySize;
     buffer = packet->m_body;
     nChunkSize = r->m_outChunkSize;
@@ -4279,6 +4676,199 @@ RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue)
     return TRUE;
 }
 
+/* scatter/gather sending, used to send packet bodies without first copying
+ * them into a contiguous buffer with room for the chunk headers */
+
+#define RTMP_MAX_IOV 64
+
+#ifdef _WIN32
+typedef WSABUF RTMPIOV;
+#define IOV_BASE(v) ((v)->buf)
+#define IOV_LEN(v) ((int)(v)->len)
+#define IOV_SET(v, p, n) ((v)->buf = (char *)(p), (v)->len = (ULONG)(n))
+#else
+typedef struct iovec RTMPIOV;
+#define IOV_BASE(v) ((char *)(v)->iov_base)
+#define IOV_LEN(v) ((int)(v)->iov_len)
+#define IOV_SET(v, p, n) ((v)->iov_base = (void *)(p), (v)->iov_len = (size_t)(n))
+#endif
+
+static int
+RTMPSockBuf_SendV(RTMPSockBuf *sb, RTMPIOV *iov, int count)
+{
+#ifdef _WIN32
+    DWORD sent = 0;
+    if (WSASend(sb->sb_socket, iov, (DWORD)count, &sent, 0, NULL, NULL) != 0)
+        return -1;
+    return (int)sent;
+#else
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = count;
+    return (int)sendmsg(sb->sb_socket, &msg, MSG_NOSIGNAL);
+#endif
+}
+
+static int
+WriteV(RTMP *r, RTMPIOV *iov, int count)
+{
+    /* custom senders only take plain buffers */
+    if (r->m_bCustomSend && r->m_customSendFunc)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            if (IOV_LEN(&iov[i]) && !WriteN(r, IOV_BASE(&iov[i]), IOV_LEN(&iov[i])))
+                return FALSE;
+        }
+        return TRUE;
+    }
+
+    while (count > 0)
+    {
+        int nBytes = RTMPSockBuf_SendV(&r->m_sb, iov, count);
+
+        if (nBytes < 0)
+        {
+            int sockerr = GetSockError();
+            RTMP_Log(RTMP_LOGERROR, "%s, RTMP send error %d (%d buffers)", __FUNCTION__,
+                     sockerr, count);
+
+            if (sockerr == EINTR && !RTMP_ctrlC)
+                continue;
+
+            r->last_error_code = sockerr;
+
+            RTMP_Close(r);
+            return FALSE;
+        }
+
+        if (nBytes == 0)
+            return FALSE;
+
+        while (count > 0 && nBytes >= IOV_LEN(iov))
+        {
+            nBytes -= IOV_LEN(iov);
+            iov++;
+            count--;
+        }
+
+        if (count > 0 && nBytes)
+            IOV_SET(iov, IOV_BASE(iov) + nBytes, IOV_LEN(iov) - nBytes);
+    }
+
+    return TRUE;
+}
+
+/* Sends a packet whose body is prefix followed by payload, with the chunk
+ * headers kept in a small separate buffer rather than written over the body
+ * like RTMP_SendPacket does, so neither part has to be copied.  HTTP tunnels
+ * and TLS can't send scattered buffers and get a contiguous copy instead. */
+int
+RTMP_SendPacketV(RTMP *r, RTMPPacket *packet, const char *prefix, int prefixSize,
+                 const char *payload, int payloadSize)
+{
+    RTMPIOV iov[RTMP_MAX_IOV];
+    char hbuf[RTMP_MAX_HEADER_SIZE], cbuf[RTMP_MAX_IOV][3];
+    const char *seg[2] = {prefix, payload};
+    int segSize[2] = {prefixSize, payloadSize};
+    int s = 0, segOff = 0;
+    int niov = 0, nhdr = 0;
+    int remaining, nChunkSize;
+    int hSize, cSize;
+    char *header, c;
+
+    packet->m_nBodySize = prefixSize + payloadSize;
+    packet->m_body = NULL;
+
+#if defined(CRYPTO) && !defined(NO_SSL)
+    if (r->m_sb.sb_ssl && !(r->m_bCustomSend && r->m_customSendFunc))
+        goto copy;
+#endif
+    if (r->Link.protocol & RTMP_FEATURE_HTTP)
+        goto copy;
+
+    hSize = EncodePacketHeader(r, packet, hbuf + sizeof(hbuf), &header, &c, &cSize);
+    if (!hSize)
+        return FALSE;
+
+    IOV_SET(&iov[niov++], header, hSize);
+
+    remaining = packet->m_nBodySize;
+    nChunkSize = r->m_outChunkSize;
+
+    while (remaining > 0)
+    {
+        int chunk = remaining < nChunkSize ? remaining : nChunkSize;
+        remaining -= chunk;
+
+        while (chunk > 0 && s < 2)
+        {
+            int n = segSize[s] - segOff;
+            if (n > chunk)
+                n = chunk;
+            if (n > 0)
+                IOV_SET(&iov[niov++], seg[s] + segOff, n);
+
+            segOff += n;
+            chunk -= n;
+            if (segOff == segSize[s])
+            {
+                s++;
+                segOff = 0;
+            }
+        }
+
+        if (remaining > 0)
+        {
+            char *chdr;
+
+            /* room for this chunk header and the next chunk's data */
+            if (niov + 3 > RTMP_MAX_IOV)
+            {
+                if (!WriteV(r, iov, niov))
+                    return FALSE;
+                niov = 0;
+                nhdr = 0;
+            }
+
+            chdr = cbuf[nhdr++];
+            chdr[0] = (0xc0 | c);
+            if (cSize)
+            {
+                int tmp = packet->m_nChannel - 64;
+                chdr[1] = tmp & 0xff;
+                if (cSize == 2)
+                    chdr[2] = tmp >> 8;
+            }
+            IOV_SET(&iov[niov++], chdr, 1 + cSize);
+        }
+    }
+
+    if (niov && !WriteV(r, iov, niov))
+        return FALSE;
+
+    if (!r->m_vecChannelsOut[packet->m_nChannel])
+        r->m_vecChannelsOut[packet->m_nChannel] = malloc(sizeof(RTMPPacket));
+    memcpy(r->m_vecChannelsOut[packet->m_nChannel], packet, sizeof(RTMPPacket));
+    return TRUE;
+
+copy:
+    {
+        int ret;
+
+        if (!RTMPPacket_Alloc(packet, packet->m_nBodySize))
+            return FALSE;
+
+        memcpy(packet->m_body, prefix, prefixSize);
+        memcpy(packet->m_body + prefixSize, payload, payloadSize);
+
+        ret = RTMP_SendPacket(r, packet, FALSE);
+        RTMPPacket_Free(packet);
+        return ret;
+    }
+}
+
 void
 RTMP_Close(RTMP *r)
 {
@@ -5352,3 +5942,30 @@ RTMP_Write(RTMP *r, const char *buf, int size, int streamIdx)
     }
     return size+s2;
 }
+
+int
+RTMP_WriteV(RTMP *r, uint8_t packetType, uint32_t timestamp, const char *prefix,
+            int prefixSize, const char *payload, int payloadSize, int streamIdx)
+{
+    RTMPPacket pkt;
+
+    RTMPPacket_Reset(&pkt);
+    pkt.m_nChannel = 0x04;	/* source channel */
+    pkt.m_nInfoField2 = r->Link.streams[streamIdx].id;
+    pkt.m_packetType = packetType;
+    pkt.m_nTimeStamp = timestamp;
+    pkt.m_hasAbsTimestamp = 0;
+    pkt.m_body = NULL;
+
+    /* same header choice as RTMP_Write */
+    if ((packetType == RTMP_PACKET_TYPE_AUDIO
+            || packetType == RTMP_PACKET_TYPE_VIDEO) && !timestamp)
+        pkt.m_headerType = RTMP_PACKET_SIZE_LARGE;
+    else
+        pkt.m_headerType = RTMP_PACKET_SIZE_MEDIUM;
+
+    if (!RTMP_SendPacketV(r, &pkt, prefix, prefixSize, payload, payloadSize))
+        return -1;
+
+    return prefixSize + payloadSize;
+}
@@ -45,6 +45,9 @@
 #include <sys/socket.h>
 #include <netinet/in.h>
 #define SOCKET int
+#ifndef INVALID_SOCKET
+#define INVALID_SOCKET -1
+#endif
 #endif
 
 #include "amf.h"
@@ -393,6 +396,15 @@ extern "C"
         int addrLen;
     } RTMP_BINDINFO;
 
+#define RTMP_MAX_ADDRS 8
+
+    struct rtmp_addr_list
+    {
+        struct sockaddr_storage addrs[RTMP_MAX_ADDRS];
+        socklen_t lens[RTMP_MAX_ADDRS];
+        int count;
+    };
+
     typedef int (*CUSTOMSEND)(RTMPSockBuf*, const char *, int, void*);
 
     typedef struct RTMP
@@ -422,6 +434,10 @@ extern "C"
 
         RTMP_BINDINFO m_bindIP;
 
+        /* connected ahead of time with RTMP_ConnectSocket, used by the
+         * next RTMP_Connect instead of connecting */
+        SOCKET m_standbySocket;
+
         uint8_t m_bSendChunkSizeInfo;
 
         int m_numInvokes;
@@ -491,8 +507,20 @@ extern "C"
     int RTMP_Connect0(RTMP *r, struct sockaddr *svc, socklen_t addrlen);
     int RTMP_Connect1(RTMP *r, RTMPPacket *cp);
 
+    /* resolves (through the address cache) and connects a TCP socket,
+     * for handing to RTMP_Connect through m_standbySocket */
+    SOCKET RTMP_ConnectSocket(AVal *host, int port,
+                              const RTMP_BINDINFO *bindIP, int *socket_error);
+    /* TRUE while nothing has arrived on a socket from RTMP_ConnectSocket,
+     * servers send nothing before the handshake so anything else means
+     * the connection was closed */
+    int RTMP_IsSocketIdle(SOCKET sock);
+    void RTMP_CloseSocket(SOCKET sock);
+
     int RTMP_ReadPacket(RTMP *r, RTMPPacket *packet);
     int RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue);
+    int RTMP_SendPacketV(RTMP *r, RTMPPacket *packet, const char *prefix,
+                         int prefixSize, const char *payload, int payloadSize);
     int RTMP_SendChunk(RTMP *r, RTMPChunk *chunk);
     int RTMP_IsConnected(RTMP *r);
     SOCKET RTMP_Socket(RTMP *r);
@@ -541,6 +569,9 @@ extern "C"
     void RTMP_DropRequest(RTMP *r, int i, int freeit);
     int RTMP_Read(RTMP *r, char *buf, int size);
     int RTMP_Write(RTMP *r, const char *buf, int size, int streamIdx);
+    int RTMP_WriteV(RTMP *r, uint8_t packetType, uint32_t timestamp,
+                    const char *prefix, int prefixSize, const char *payload,
+                    int payloadSize, int streamIdx);
 
 #ifdef USE_HASHSWF
     /* hashswf.c */
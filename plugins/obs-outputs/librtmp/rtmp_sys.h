@@ -64,6 +64,7 @@
 #include <sys/times.h>
 #include <netdb.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #include <arpa/inet.h>
@@ -13,11 +13,17 @@ MODULE_EXPORT const char *obs_module_description(void)
 }
 
 extern struct obs_output_info rtmp_output_info;
+extern struct obs_output_info rtmp_simulcast_output_info;
 extern struct obs_output_info null_output_info;
 extern struct obs_output_info flv_output_info;
 #if defined(FTL_FOUND)
 extern struct obs_output_info ftl_output_info;
 #endif
+#if defined(LIBDATACHANNEL_FOUND)
+extern struct obs_output_info whip_output_info;
+#endif
+
+extern void rtmp_bandwidth_probe_register(void);
 
 #if defined(_WIN32) && defined(MBEDTLS_THREADING_ALT)
 void mbed_mutex_init(mbedtls_threading_mutex_t *m)
@@ -63,11 +69,17 @@ bool obs_module_load(void)
 #endif
 
 	obs_register_output(&rtmp_output_info);
+	obs_register_output(&rtmp_simulcast_output_info);
 	obs_register_output(&null_output_info);
 	obs_register_output(&flv_output_info);
 #if defined(FTL_FOUND)
 	obs_register_output(&ftl_output_info);
 #endif
+#if defined(LIBDATACHANNEL_FOUND)
+	obs_register_output(&whip_output_info);
+#endif
+
+	rtmp_bandwidth_probe_register();
 	return true;
 }
 
@@ -0,0 +1,218 @@
+/******************************************************************************
+    Copyright (C) 2023 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+/*
+ * Bandwidth probe used by the auto-configuration wizard.  Rather than
+ * running the whole RTMP output with a real encoder, it connects and
+ * publishes like the output does, then sends filler video for a short time
+ * at a fixed rate and measures how much of it the connection took.  The
+ * payload is H.264 filler data NAL units, which servers and decoders
+ * discard.  Probes are independent, so the wizard can run several servers
+ * at once.
+ */
+
+#include <obs-module.h>
+#include <util/platform.h>
+#include <util/threading.h>
+#include <util/dstr.h>
+#include "librtmp/rtmp.h"
+#include "net-if.h"
+
+#define do_log(level, format, ...)                                   \
+	blog(level, "[rtmp bandwidth probe: '%s'] " format, url.array, \
+	     ##__VA_ARGS__)
+
+#define warn(format, ...) do_log(LOG_WARNING, format, ##__VA_ARGS__)
+#define info(format, ...) do_log(LOG_INFO, format, ##__VA_ARGS__)
+
+#define PROBE_FPS 30
+#define PROBE_WARMUP_MS 1000
+#define MAX_PROBE_DURATION_MS 30000
+
+#define MSEC_TO_NSEC 1000000ULL
+
+static const AVal flash_ver = AVC("FMLE/3.0 (compatible; FMSc/1.0)");
+
+static void add_connect_data(char **penc, char *pend)
+{
+	const AVal val = AVC("supportsGoAway");
+	*penc = AMF_EncodeNamedBoolean(*penc, pend, &val, true);
+}
+
+/* one frame's worth of filler, as a length prefixed NAL unit */
+static uint8_t *create_filler(size_t size)
+{
+	uint8_t *data = bmalloc(size);
+	uint32_t nal_size = (uint32_t)size - 4;
+
+	data[0] = (uint8_t)(nal_size >> 24);
+	data[1] = (uint8_t)(nal_size >> 16);
+	data[2] = (uint8_t)(nal_size >> 8);
+	data[3] = (uint8_t)nal_size;
+	data[4] = 12; /* filler data */
+	memset(data + 5, 0xFF, size - 6);
+	data[size - 1] = 0x80;
+	return data;
+}
+
+static inline bool probe_stopped(os_event_t *stop_event)
+{
+	return stop_event && os_event_try(stop_event) == 0;
+}
+
+/* Returns the bitrate in kbps that the connection accepted after the
+ * warmup, or -1 on failure */
+static int send_filler(RTMP *rtmp, int bitrate, int duration_ms,
+		       os_event_t *stop_event)
+{
+	/* keyframe, AVC NALU, zero composition time */
+	static const uint8_t prefix[5] = {0x17, 0x01, 0, 0, 0};
+
+	const uint64_t interval = 1000000000ULL / PROBE_FPS;
+	const size_t frame_size = (size_t)bitrate * 1000 / 8 / PROBE_FPS;
+	uint8_t *filler = create_filler(frame_size > 16 ? frame_size : 16);
+	const int filler_size = (int)(frame_size > 16 ? frame_size : 16);
+
+	const uint64_t start = os_gettime_ns();
+	const uint64_t measure_start = start + PROBE_WARMUP_MS * MSEC_TO_NSEC;
+	const uint64_t end = measure_start + duration_ms * MSEC_TO_NSEC;
+	uint64_t measured_bytes = 0;
+	uint64_t next = start;
+	uint32_t ts = 0;
+	int result = -1;
+
+	for (;;) {
+		if (probe_stopped(stop_event))
+			goto fail;
+
+		int ret = RTMP_WriteV(rtmp, RTMP_PACKET_TYPE_VIDEO, ts,
+				      (const char *)prefix, sizeof(prefix),
+				      (const char *)filler, filler_size, 0);
+		if (ret <= 0)
+			goto fail;
+
+		uint64_t now = os_gettime_ns();
+		if (now >= end)
+			break;
+		if (now >= measure_start)
+			measured_bytes += 11 + sizeof(prefix) + filler_size + 4;
+
+		/* a slow link blocks the send, don't burst to catch up */
+		next += interval;
+		if (next < now)
+			next = now;
+		os_sleepto_ns(next);
+
+		ts = (uint32_t)((next - start) / MSEC_TO_NSEC);
+	}
+
+	uint64_t elapsed = os_gettime_ns() - measure_start;
+	result = (int)(measured_bytes * 8 * 1000000ULL / elapsed);
+
+fail:
+	bfree(filler);
+	return result;
+}
+
+static void rtmp_bandwidth_probe(void *data, calldata_t *cd)
+{
+	const char *key = calldata_string(cd, "key");
+	const char *bind_ip = calldata_string(cd, "bind_ip");
+	int bitrate = (int)calldata_int(cd, "bitrate");
+	int duration_ms = (int)calldata_int(cd, "duration_ms");
+	os_event_t *stop_event = calldata_ptr(cd, "stop_event");
+	struct dstr url = {0};
+	int measured = -1;
+	RTMP *rtmp;
+
+	UNUSED_PARAMETER(data);
+
+	calldata_set_bool(cd, "success", false);
+	calldata_set_int(cd, "connect_ms", 0);
+	calldata_set_int(cd, "measured_bitrate", 0);
+
+	dstr_copy(&url, calldata_string(cd, "server"));
+	if (dstr_is_empty(&url) || bitrate <= 0 || duration_ms <= 0 ||
+	    duration_ms > MAX_PROBE_DURATION_MS) {
+		dstr_free(&url);
+		return;
+	}
+
+	rtmp = bzalloc(sizeof(*rtmp));
+	RTMP_Init(rtmp);
+
+	if (!RTMP_SetupURL(rtmp, url.array)) {
+		warn("Bad URL");
+		goto free;
+	}
+
+	RTMP_EnableWrite(rtmp);
+
+	rtmp->Link.flashVer = flash_ver;
+	rtmp->Link.swfUrl = rtmp->Link.tcUrl;
+	rtmp->Link.customConnectEncode = add_connect_data;
+
+	if (bind_ip && *bind_ip && strcmp(bind_ip, "default") != 0)
+		netif_str_to_addr(&rtmp->m_bindIP.addr, &rtmp->m_bindIP.addrLen,
+				  bind_ip);
+
+	RTMP_AddStream(rtmp, key ? key : "");
+
+	rtmp->m_outChunkSize = 4096;
+	rtmp->m_bSendChunkSizeInfo = true;
+	rtmp->m_bUseNagle = true;
+
+	if (!RTMP_Connect(rtmp, NULL)) {
+		warn("Connection failed");
+		goto close;
+	}
+
+	calldata_set_int(cd, "connect_ms", rtmp->connect_time_ms);
+
+	if (!RTMP_ConnectStream(rtmp, 0)) {
+		warn("Publishing failed");
+		goto close;
+	}
+
+	measured = send_filler(rtmp, bitrate, duration_ms, stop_event);
+	if (measured >= 0) {
+		info("Connected in %d ms, %d of %d kbps",
+		     rtmp->connect_time_ms, measured, bitrate);
+		calldata_set_int(cd, "measured_bitrate", measured);
+		calldata_set_bool(cd, "success", true);
+	} else if (!probe_stopped(stop_event)) {
+		warn("Disconnected during the probe");
+	}
+
+close:
+	RTMP_Close(rtmp);
+free:
+	RTMP_TLS_Free(rtmp);
+	bfree(rtmp);
+	dstr_free(&url);
+}
+
+void rtmp_bandwidth_probe_register(void)
+{
+	proc_handler_add(obs_get_proc_handler(),
+			 "void rtmp_bandwidth_probe(in string server, "
+			 "in string key, in string bind_ip, in int bitrate, "
+			 "in int duration_ms, in ptr stop_event, "
+			 "out bool success, out int connect_ms, "
+			 "out int measured_bitrate)",
+			 rtmp_bandwidth_probe, NULL);
+}
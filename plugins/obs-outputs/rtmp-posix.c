@@ -0,0 +1,372 @@
+#ifndef _WIN32
+#include "rtmp-stream.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#else
+#include <sys/event.h>
+#endif
+
+/* Same loop as socket_thread_windows, waiting on the socket with epoll or
+ * kqueue instead of WSAEventSelect.  socket_queue_data wakes it up through
+ * wake_pipe when new data has been queued. */
+
+#define SOCK_EVENT_READ (1 << 0)
+#define SOCK_EVENT_WRITE (1 << 1)
+#define SOCK_EVENT_CLOSE (1 << 2)
+#define SOCK_EVENT_WAKE (1 << 3)
+
+struct socket_poll {
+	int fd;
+	int sock;
+	int wake;
+	bool want_write;
+};
+
+#ifdef __linux__
+static bool poll_update(struct socket_poll *sp, int op)
+{
+	struct epoll_event ev = {0};
+	ev.events = EPOLLIN | EPOLLRDHUP | (sp->want_write ? EPOLLOUT : 0);
+	ev.data.fd = sp->sock;
+	return epoll_ctl(sp->fd, op, sp->sock, &ev) == 0;
+}
+
+static bool poll_init(struct socket_poll *sp)
+{
+	struct epoll_event ev = {0};
+
+	sp->fd = epoll_create1(EPOLL_CLOEXEC);
+	if (sp->fd == -1)
+		return false;
+
+	ev.events = EPOLLIN;
+	ev.data.fd = sp->wake;
+	if (epoll_ctl(sp->fd, EPOLL_CTL_ADD, sp->wake, &ev) != 0)
+		return false;
+
+	return poll_update(sp, EPOLL_CTL_ADD);
+}
+
+static bool poll_set_write(struct socket_poll *sp, bool want_write)
+{
+	if (sp->want_write == want_write)
+		return true;
+
+	sp->want_write = want_write;
+	return poll_update(sp, EPOLL_CTL_MOD);
+}
+
+static bool poll_wait(struct socket_poll *sp, uint32_t *events)
+{
+	struct epoll_event evs[2];
+	int count;
+
+	*events = 0;
+
+	do {
+		count = epoll_wait(sp->fd, evs, 2, -1);
+	} while (count == -1 && errno == EINTR);
+
+	if (count == -1)
+		return false;
+
+	for (int i = 0; i < count; i++) {
+		uint32_t e = evs[i].events;
+
+		if (evs[i].data.fd == sp->wake) {
+			*events |= SOCK_EVENT_WAKE;
+			continue;
+		}
+
+		if (e & EPOLLIN)
+			*events |= SOCK_EVENT_READ;
+		if (e & EPOLLOUT)
+			*events |= SOCK_EVENT_WRITE;
+		if (e & (EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+			*events |= SOCK_EVENT_CLOSE;
+	}
+
+	return true;
+}
+#else
+static bool poll_init(struct socket_poll *sp)
+{
+	struct kevent evs[3];
+
+	sp->fd = kqueue();
+	if (sp->fd == -1)
+		return false;
+
+	EV_SET(&evs[0], sp->wake, EVFILT_READ, EV_ADD, 0, 0, NULL);
+	EV_SET(&evs[1], sp->sock, EVFILT_READ, EV_ADD, 0, 0, NULL);
+	EV_SET(&evs[2], sp->sock, EVFILT_WRITE,
+	       EV_ADD | (sp->want_write ? EV_ENABLE : EV_DISABLE), 0, 0, NULL);
+	return kevent(sp->fd, evs, 3, NULL, 0, NULL) == 0;
+}
+
+static bool poll_set_write(struct socket_poll *sp, bool want_write)
+{
+	struct kevent ev;
+
+	if (sp->want_write == want_write)
+		return true;
+
+	sp->want_write = want_write;
+	EV_SET(&ev, sp->sock, EVFILT_WRITE, want_write ? EV_ENABLE : EV_DISABLE,
+	       0, 0, NULL);
+	return kevent(sp->fd, &ev, 1, NULL, 0, NULL) == 0;
+}
+
+static bool poll_wait(struct socket_poll *sp, uint32_t *events)
+{
+	struct kevent evs[3];
+	int count;
+
+	*events = 0;
+
+	do {
+		count = kevent(sp->fd, NULL, 0, evs, 3, NULL);
+	} while (count == -1 && errno == EINTR);
+
+	if (count == -1)
+		return false;
+
+	for (int i = 0; i < count; i++) {
+		if ((int)evs[i].ident == sp->wake) {
+			*events |= SOCK_EVENT_WAKE;
+			continue;
+		}
+
+		if (evs[i].filter == EVFILT_READ)
+			*events |= SOCK_EVENT_READ;
+		if (evs[i].filter == EVFILT_WRITE)
+			*events |= SOCK_EVENT_WRITE;
+		if (evs[i].flags & (EV_EOF | EV_ERROR))
+			*events |= SOCK_EVENT_CLOSE;
+	}
+
+	return true;
+}
+#endif
+
+static void poll_free(struct socket_poll *sp)
+{
+	if (sp->fd != -1)
+		close(sp->fd);
+}
+
+static void drain_wake_pipe(struct rtmp_stream *stream)
+{
+	char discard[64];
+	while (read(stream->wake_pipe[0], discard, sizeof(discard)) > 0)
+		;
+}
+
+static int get_socket_error(int sock)
+{
+	int err = 0;
+	socklen_t size = sizeof(err);
+
+	if (getsockopt(sock, SOL_SOCKET, SO_ERROR, &err, &size) != 0)
+		err = errno;
+	return err;
+}
+
+static bool socket_event(struct rtmp_stream *stream, uint32_t events,
+			 bool *can_write, uint64_t last_send_time)
+{
+	int sock = stream->rtmp.m_sb.sb_socket;
+
+	if (events & SOCK_EVENT_WRITE)
+		*can_write = true;
+
+	if (events & SOCK_EVENT_READ) {
+		char discard[16384];
+
+		for (;;) {
+			ssize_t ret = recv(sock, discard, sizeof(discard), 0);
+			int err_code;
+
+			if (ret > 0)
+				continue;
+
+			if (ret == -1) {
+				err_code = errno;
+				if (err_code == EAGAIN ||
+				    err_code == EWOULDBLOCK)
+					break;
+				if (err_code == EINTR)
+					continue;
+			} else {
+				/* the close itself is logged below */
+				if (events & SOCK_EVENT_CLOSE)
+					break;
+				err_code = 0;
+			}
+
+			blog(LOG_ERROR,
+			     "socket_thread_posix: "
+			     "Socket error, recv() returned "
+			     "%d, errno %d",
+			     (int)ret, err_code);
+			stream->rtmp.last_error_code = err_code;
+			socket_loop_fatal_shutdown(stream);
+			return false;
+		}
+	}
+
+	if (events & SOCK_EVENT_CLOSE) {
+		int err_code = get_socket_error(sock);
+
+		if (last_send_time) {
+			uint32_t diff =
+				(os_gettime_ns() / 1000000) - last_send_time;
+
+			blog(LOG_ERROR,
+			     "socket_thread_posix: Socket "
+			     "closed, %u ms since last send "
+			     "(buffer: %d / %d)",
+			     diff, (int)stream->write_buf_len,
+			     (int)stream->write_buf_size);
+		}
+
+		if (os_event_try(stream->stop_event) != EAGAIN)
+			blog(LOG_ERROR,
+			     "socket_thread_posix: Aborting due "
+			     "to socket close during shutdown, "
+			     "%d bytes lost, error %d",
+			     (int)stream->write_buf_len, err_code);
+		else
+			blog(LOG_ERROR,
+			     "socket_thread_posix: Aborting due "
+			     "to socket close, error %d",
+			     err_code);
+
+		stream->rtmp.last_error_code = err_code;
+		socket_loop_fatal_shutdown(stream);
+		return false;
+	}
+
+	return true;
+}
+
+static inline void socket_thread_posix_internal(struct rtmp_stream *stream)
+{
+	struct socket_poll sp = {-1, stream->rtmp.m_sb.sb_socket,
+				 stream->wake_pipe[0], true};
+	bool can_write = false;
+
+	int delay_time;
+	size_t latency_packet_size;
+	uint64_t last_send_time = 0;
+
+	socket_loop_get_pacing(stream, &delay_time, &latency_packet_size);
+
+	if (!poll_init(&sp)) {
+		blog(LOG_ERROR,
+		     "socket_thread_posix: Aborting, failed to "
+		     "set up socket polling, errno %d",
+		     errno);
+		poll_free(&sp);
+		socket_loop_fatal_shutdown(stream);
+		return;
+	}
+
+	for (;;) {
+		uint32_t events;
+
+		if (socket_loop_should_exit(stream))
+			break;
+
+		if (!poll_wait(&sp, &events)) {
+			blog(LOG_ERROR,
+			     "socket_thread_posix: Aborting due "
+			     "to poll failure, errno %d",
+			     errno);
+			socket_loop_fatal_shutdown(stream);
+			poll_free(&sp);
+			return;
+		}
+
+		if (events & SOCK_EVENT_WAKE)
+			drain_wake_pipe(stream);
+
+		if (!socket_event(stream, events, &can_write,
+				  last_send_time)) {
+			poll_free(&sp);
+			return;
+		}
+
+		if (can_write) {
+			for (;;) {
+				enum data_ret ret = socket_loop_write_data(
+					stream, &can_write, &last_send_time,
+					latency_packet_size, delay_time);
+
+				switch (ret) {
+				case RET_BREAK:
+					goto exit_write_loop;
+				case RET_FATAL:
+					poll_free(&sp);
+					return;
+				case RET_CONTINUE:;
+				}
+			}
+		}
+	exit_write_loop:
+
+		/* only wait for writability after the socket has filled up,
+		 * otherwise the socket would wake the thread constantly */
+		if (!poll_set_write(&sp, !can_write)) {
+			blog(LOG_ERROR,
+			     "socket_thread_posix: Aborting due "
+			     "to poll update failure, errno %d",
+			     errno);
+			socket_loop_fatal_shutdown(stream);
+			poll_free(&sp);
+			return;
+		}
+	}
+
+	poll_free(&sp);
+	blog(LOG_INFO, "socket_thread_posix: Normal exit");
+}
+
+void *socket_thread_posix(void *data)
+{
+	struct rtmp_stream *stream = data;
+	os_set_thread_name("rtmp-stream: socket_thread");
+	socket_thread_posix_internal(stream);
+	return NULL;
+}
+
+bool socket_loop_posix_init(struct rtmp_stream *stream)
+{
+	if (pipe(stream->wake_pipe) != 0) {
+		stream->wake_pipe[0] = -1;
+		stream->wake_pipe[1] = -1;
+		return false;
+	}
+
+	for (size_t i = 0; i < 2; i++) {
+		int flags = fcntl(stream->wake_pipe[i], F_GETFL);
+		fcntl(stream->wake_pipe[i], F_SETFL, flags | O_NONBLOCK);
+		fcntl(stream->wake_pipe[i], F_SETFD, FD_CLOEXEC);
+	}
+
+	return true;
+}
+
+void socket_loop_posix_free(struct rtmp_stream *stream)
+{
+	for (size_t i = 0; i < 2; i++) {
+		if (stream->wake_pipe[i] != -1)
+			close(stream->wake_pipe[i]);
+		stream->wake_pipe[i] = -1;
+	}
+}
+#endif
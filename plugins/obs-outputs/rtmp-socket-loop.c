@@ -0,0 +1,159 @@
+#include "rtmp-stream.h"
+
+/* Send buffer handling shared by the platform socket threads.  Encoded data
+ * is queued into write_buf by socket_queue_data and written out from here
+ * whenever the socket can take more. */
+
+#ifdef _WIN32
+#define socket_error() WSAGetLastError()
+#define socket_would_block(err) ((err) == WSAEWOULDBLOCK)
+#else
+#define socket_error() errno
+#define socket_would_block(err) ((err) == EAGAIN || (err) == EWOULDBLOCK)
+#define closesocket close
+#endif
+
+#define LATENCY_FACTOR 20
+
+void socket_loop_fatal_shutdown(struct rtmp_stream *stream)
+{
+	closesocket(stream->rtmp.m_sb.sb_socket);
+	stream->rtmp.m_sb.sb_socket = -1;
+	stream->write_buf_len = 0;
+	os_event_signal(stream->buffer_space_available_event);
+}
+
+void socket_loop_get_pacing(struct rtmp_stream *stream, int *delay_time,
+			    size_t *latency_packet_size)
+{
+	if (stream->low_latency_mode) {
+		*delay_time = 1000 / LATENCY_FACTOR;
+		*latency_packet_size =
+			stream->write_buf_size / (LATENCY_FACTOR - 2);
+	} else {
+		*latency_packet_size = stream->write_buf_size;
+		*delay_time = 0;
+	}
+}
+
+enum data_ret socket_loop_write_data(struct rtmp_stream *stream,
+				     bool *can_write, uint64_t *last_send_time,
+				     size_t latency_packet_size,
+				     int delay_time)
+{
+	bool exit_loop = false;
+
+	pthread_mutex_lock(&stream->write_buf_mutex);
+
+	if (!stream->write_buf_len) {
+		/* this is now an expected occasional condition due to use of
+		 * auto-reset events, we could end up emptying the buffer as
+		 * it's filled in a previous loop cycle, especially if using
+		 * low latency mode. */
+		pthread_mutex_unlock(&stream->write_buf_mutex);
+		return RET_BREAK;
+	}
+
+	int ret;
+	if (stream->low_latency_mode) {
+		size_t send_len = latency_packet_size < stream->write_buf_len
+					  ? latency_packet_size
+					  : stream->write_buf_len;
+
+		ret = RTMPSockBuf_Send(&stream->rtmp.m_sb,
+				       (const char *)stream->write_buf,
+				       (int)send_len);
+	} else {
+		ret = RTMPSockBuf_Send(&stream->rtmp.m_sb,
+				       (const char *)stream->write_buf,
+				       (int)stream->write_buf_len);
+	}
+
+	if (ret > 0) {
+		if (stream->write_buf_len - ret)
+			memmove(stream->write_buf, stream->write_buf + ret,
+				stream->write_buf_len - ret);
+		stream->write_buf_len -= ret;
+
+		*last_send_time = os_gettime_ns() / 1000000;
+
+		os_event_signal(stream->buffer_space_available_event);
+	} else {
+		int err_code;
+		bool fatal_err = false;
+
+		if (ret == -1) {
+			err_code = socket_error();
+
+			if (socket_would_block(err_code)) {
+				*can_write = false;
+				pthread_mutex_unlock(&stream->write_buf_mutex);
+				return RET_BREAK;
+			}
+
+			fatal_err = true;
+		} else if (ret == 0) {
+			err_code = 0;
+			fatal_err = true;
+		}
+
+		if (fatal_err) {
+			/* connection closed, or connection was aborted /
+			 * socket closed / etc, that's a fatal error. */
+			blog(LOG_ERROR,
+			     "socket_thread: "
+			     "Socket error, send() returned %d, "
+			     "error %d",
+			     ret, err_code);
+
+			pthread_mutex_unlock(&stream->write_buf_mutex);
+			stream->rtmp.last_error_code = err_code;
+			socket_loop_fatal_shutdown(stream);
+			return RET_FATAL;
+		}
+	}
+
+	/* finish writing for now */
+	if (stream->write_buf_len <= 1000)
+		exit_loop = true;
+
+	pthread_mutex_unlock(&stream->write_buf_mutex);
+
+	if (delay_time)
+		os_sleep_ms(delay_time);
+
+	return exit_loop ? RET_BREAK : RET_CONTINUE;
+}
+
+/* true once the thread has been asked to exit and everything queued has
+ * been sent */
+bool socket_loop_should_exit(struct rtmp_stream *stream)
+{
+	bool exit = false;
+
+	if (os_event_try(stream->send_thread_signaled_exit) == EAGAIN)
+		return false;
+
+	pthread_mutex_lock(&stream->write_buf_mutex);
+	if (stream->write_buf_len == 0) {
+		os_event_reset(stream->send_thread_signaled_exit);
+		exit = true;
+	}
+	pthread_mutex_unlock(&stream->write_buf_mutex);
+
+	return exit;
+}
+
+void socket_loop_signal(struct rtmp_stream *stream)
+{
+	os_event_signal(stream->buffer_has_data_event);
+
+#ifndef _WIN32
+	/* the posix thread waits on the socket, not the event */
+	if (stream->wake_pipe[1] != -1) {
+		char c = 0;
+		ssize_t ret = write(stream->wake_pipe[1], &c, 1);
+		UNUSED_PARAMETER(ret);
+	}
+#endif
+}
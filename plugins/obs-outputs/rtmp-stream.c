@@ -37,6 +37,8 @@
 #define DBR_INC_RATE 5
 #define MIN_ESTIMATE_DURATION_MS 1000
 #define MAX_ESTIMATE_DURATION_MS 2000
+#define DBR_MODEL_SAMPLE_INTERVAL (100ULL * MSEC_TO_NSEC)
+#define DBR_MODEL_RAISE_INTERVAL (1ULL * SEC_TO_NSEC)
 
 typedef enum { LOW, NORMAL, HIGH } Severity;
 
@@ -107,6 +109,118 @@ static inline bool silently_reconnecting(struct rtmp_stream *stream)
 	return os_atomic_load_bool(&stream->silent_reconnect);
 }
 
+/* how often the standby connection is checked, and how long one is kept
+ * before it's replaced in case the server or a NAT quietly dropped it */
+#define STANDBY_CHECK_MS 5000
+#define STANDBY_MAX_AGE_NS (30 * 1000000000ULL)
+
+static void *standby_thread(void *data)
+{
+	struct rtmp_stream *stream = data;
+	AVal host;
+
+	os_set_thread_name("rtmp-stream: standby_thread");
+
+	host.av_val = stream->standby_host.array;
+	host.av_len = (int)stream->standby_host.len;
+
+	do {
+		SOCKET old = INVALID_SOCKET;
+		SOCKET sock;
+		int err = 0;
+
+		pthread_mutex_lock(&stream->standby_mutex);
+		if (stream->standby_socket != INVALID_SOCKET &&
+		    (os_gettime_ns() - stream->standby_ts >=
+			     STANDBY_MAX_AGE_NS ||
+		     !RTMP_IsSocketIdle(stream->standby_socket))) {
+			old = stream->standby_socket;
+			stream->standby_socket = INVALID_SOCKET;
+		}
+		sock = stream->standby_socket;
+		pthread_mutex_unlock(&stream->standby_mutex);
+
+		if (old != INVALID_SOCKET)
+			RTMP_CloseSocket(old);
+		if (sock != INVALID_SOCKET)
+			continue;
+
+		sock = RTMP_ConnectSocket(&host, stream->standby_port,
+					  &stream->standby_bind, &err);
+		if (sock == INVALID_SOCKET) {
+			debug("Failed to open standby connection: %d", err);
+			continue;
+		}
+
+		pthread_mutex_lock(&stream->standby_mutex);
+		stream->standby_socket = sock;
+		stream->standby_ts = os_gettime_ns();
+		pthread_mutex_unlock(&stream->standby_mutex);
+
+	} while (os_event_timedwait(stream->standby_stop_event,
+				    STANDBY_CHECK_MS) == ETIMEDOUT);
+
+	return NULL;
+}
+
+static void start_standby(struct rtmp_stream *stream)
+{
+	const AVal *host = &stream->rtmp.Link.hostname;
+
+	if (!stream->standby_enabled || stream->standby_thread_active)
+		return;
+
+	dstr_ncopy(&stream->standby_host, host->av_val, host->av_len);
+	stream->standby_port = stream->rtmp.Link.port;
+	stream->standby_bind = stream->rtmp.m_bindIP;
+
+	os_event_reset(stream->standby_stop_event);
+	stream->standby_thread_active =
+		pthread_create(&stream->standby_thread, NULL, standby_thread,
+			       stream) == 0;
+}
+
+static void stop_standby(struct rtmp_stream *stream)
+{
+	if (stream->standby_thread_active) {
+		os_event_signal(stream->standby_stop_event);
+		pthread_join(stream->standby_thread, NULL);
+		stream->standby_thread_active = false;
+	}
+
+	if (stream->standby_socket != INVALID_SOCKET) {
+		RTMP_CloseSocket(stream->standby_socket);
+		stream->standby_socket = INVALID_SOCKET;
+	}
+}
+
+/* hands the standby connection to the next RTMP_Connect */
+static void use_standby(struct rtmp_stream *stream)
+{
+	const AVal *host = &stream->rtmp.Link.hostname;
+	SOCKET sock = INVALID_SOCKET;
+
+	if (!stream->standby_thread_active || stream->rtmp.Link.socksport)
+		return;
+	if (stream->rtmp.Link.port != stream->standby_port ||
+	    (size_t)host->av_len != stream->standby_host.len ||
+	    strncmp(host->av_val, stream->standby_host.array, host->av_len))
+		return;
+
+	pthread_mutex_lock(&stream->standby_mutex);
+	if (stream->standby_socket != INVALID_SOCKET &&
+	    RTMP_IsSocketIdle(stream->standby_socket)) {
+		sock = stream->standby_socket;
+		stream->standby_socket = INVALID_SOCKET;
+	}
+	pthread_mutex_unlock(&stream->standby_mutex);
+
+	if (sock != INVALID_SOCKET) {
+		info("Using standby connection");
+		stream->rtmp.m_standbySocket = sock;
+	}
+}
+
 static void rtmp_stream_destroy(void *data)
 {
 	struct rtmp_stream *stream = data;
@@ -128,6 +242,8 @@ static void rtmp_stream_destroy(void *data)
 		}
 	}
 
+	stop_standby(stream);
+
 	RTMP_TLS_Free(&stream->rtmp);
 	free_packets(stream);
 	dstr_free(&stream->path);
@@ -136,7 +252,10 @@ static void rtmp_stream_destroy(void *data)
 	dstr_free(&stream->password);
 	dstr_free(&stream->encoder_name);
 	dstr_free(&stream->bind_ip);
+	dstr_free(&stream->standby_host);
 	os_event_destroy(stream->stop_event);
+	os_event_destroy(stream->standby_stop_event);
+	pthread_mutex_destroy(&stream->standby_mutex);
 	os_sem_destroy(stream->send_sem);
 	pthread_mutex_destroy(&stream->packets_mutex);
 	circlebuf_free(&stream->packets);
@@ -151,6 +270,9 @@ static void rtmp_stream_destroy(void *data)
 	os_event_destroy(stream->socket_available_event);
 	os_event_destroy(stream->send_thread_signaled_exit);
 	pthread_mutex_destroy(&stream->write_buf_mutex);
+#ifndef _WIN32
+	socket_loop_posix_free(stream);
+#endif
 
 	if (stream->write_buf)
 		bfree(stream->write_buf);
@@ -161,7 +283,13 @@ static void *rtmp_stream_create(obs_data_t *settings, obs_output_t *output)
 {
 	struct rtmp_stream *stream = bzalloc(sizeof(struct rtmp_stream));
 	stream->output = output;
+	stream->standby_socket = INVALID_SOCKET;
 	pthread_mutex_init_value(&stream->packets_mutex);
+	pthread_mutex_init_value(&stream->standby_mutex);
+#ifndef _WIN32
+	stream->wake_pipe[0] = -1;
+	stream->wake_pipe[1] = -1;
+#endif
 
 	RTMP_LogSetCallback(log_rtmp);
 	RTMP_LogSetLevel(RTMP_LOGWARNING);
@@ -181,6 +309,16 @@ static void *rtmp_stream_create(obs_data_t *settings, obs_output_t *output)
 		goto fail;
 	}
 
+	if (pthread_mutex_init(&stream->standby_mutex, NULL) != 0) {
+		warn("Failed to initialize standby mutex");
+		goto fail;
+	}
+	if (os_event_init(&stream->standby_stop_event, OS_EVENT_TYPE_MANUAL) !=
+	    0) {
+		warn("Failed to initialize standby event");
+		goto fail;
+	}
+
 	if (os_event_init(&stream->buffer_space_available_event,
 			  OS_EVENT_TYPE_AUTO) != 0) {
 		warn("Failed to initialize write buffer event");
@@ -201,6 +339,12 @@ static void *rtmp_stream_create(obs_data_t *settings, obs_output_t *output)
 		warn("Failed to initialize socket exit event");
 		goto fail;
 	}
+#ifndef _WIN32
+	if (!socket_loop_posix_init(stream)) {
+		warn("Failed to initialize socket wake pipe");
+		goto fail;
+	}
+#endif
 
 	UNUSED_PARAMETER(settings);
 	return stream;
@@ -220,6 +364,8 @@ static void rtmp_stream_stop(void *data, uint64_t ts)
 	if (connecting(stream))
 		pthread_join(stream->connect_thread, NULL);
 
+	stop_standby(stream);
+
 	stream->stop_ts = ts / 1000ULL;
 
 	if (ts)
@@ -420,11 +566,40 @@ retry_send:
 
 	pthread_mutex_unlock(&stream->write_buf_mutex);
 
-	os_event_signal(stream->buffer_has_data_event);
+	socket_loop_signal(stream);
 
 	return len;
 }
 
+/* sends the packet data straight from the encoder's buffer, with the FLV and
+ * RTMP headers gathered around it, instead of muxing it into an FLV tag that
+ * librtmp then copies again into chunks */
+static int send_packet_direct(struct rtmp_stream *stream,
+			      struct encoder_packet *packet)
+{
+	uint8_t prefix[FLV_BODY_PREFIX_MAX];
+	size_t prefix_size;
+	uint8_t type;
+	int32_t time_ms;
+
+	if (!packet->data || !packet->size)
+		return 0;
+
+	prefix_size = flv_packet_body_prefix(packet, stream->start_dts_offset,
+					     false, prefix, &type, &time_ms);
+
+	/* count the FLV tag header and trailer like the muxed path does */
+	stream->total_bytes_sent += 11 + prefix_size + packet->size + 4;
+
+#ifdef TEST_FRAMEDROPS
+	droptest_cap_data_rate(stream, 11 + prefix_size + packet->size + 4);
+#endif
+
+	return RTMP_WriteV(&stream->rtmp, type, (uint32_t)time_ms & 0x7FFFFFFF,
+			   (const char *)prefix, (int)prefix_size,
+			   (const char *)packet->data, (int)packet->size, 0);
+}
+
 static int send_packet(struct rtmp_stream *stream,
 		       struct encoder_packet *packet, bool is_header,
 		       size_t idx)
@@ -450,7 +625,17 @@ static int send_packet(struct rtmp_stream *stream,
 		}
 	}
 
-	if (idx > 0) {
+	/* additional video tracks go out as multitrack video tags, only
+	 * additional audio tracks need the additional media format */
+	bool additional = idx > 0 && packet->type == OBS_ENCODER_AUDIO;
+
+	if (!additional && !is_header) {
+		ret = send_packet_direct(stream, packet);
+		obs_encoder_packet_release(packet);
+		return ret;
+	}
+
+	if (additional) {
 		flv_additional_packet_mux(
 			packet, is_header ? 0 : stream->start_dts_offset, &data,
 			&size, is_header, idx);
@@ -594,6 +779,53 @@ static void dbr_add_frame(struct rtmp_stream *stream, struct dbr_frame *back)
 	}
 }
 
+/* smoothed RTT of the connection in microseconds, or 0 if the system doesn't
+ * say */
+static uint64_t get_tcp_rtt_usec(struct rtmp_stream *stream)
+{
+	RTMPSockBuf *sb = &stream->rtmp.m_sb;
+
+#if defined(_WIN32) && defined(SIO_TCP_INFO)
+	TCP_INFO_v0 tcp_info;
+	DWORD version = 0;
+	DWORD bytes = 0;
+
+	if (WSAIoctl(sb->sb_socket, SIO_TCP_INFO, &version, sizeof(version),
+		     &tcp_info, sizeof(tcp_info), &bytes, NULL, NULL) == 0)
+		return tcp_info.RttUs;
+#elif defined(__APPLE__) && defined(TCP_CONNECTION_INFO)
+	struct tcp_connection_info tcp_info;
+	socklen_t size = sizeof(tcp_info);
+
+	if (getsockopt(sb->sb_socket, IPPROTO_TCP, TCP_CONNECTION_INFO,
+		       &tcp_info, &size) == 0)
+		return (uint64_t)tcp_info.tcpi_srtt * 1000;
+#elif defined(TCP_INFO)
+	struct tcp_info tcp_info;
+	socklen_t size = sizeof(tcp_info);
+
+	if (getsockopt(sb->sb_socket, IPPROTO_TCP, TCP_INFO, &tcp_info,
+		       &size) == 0)
+		return tcp_info.tcpi_rtt;
+#else
+	UNUSED_PARAMETER(sb);
+#endif
+	return 0;
+}
+
+static void dbr_model_add_frame(struct rtmp_stream *stream, uint64_t now)
+{
+	if (now - stream->dbr_model_sample_ts < DBR_MODEL_SAMPLE_INTERVAL)
+		return;
+
+	stream->dbr_model_sample_ts = now;
+
+	if (stream->dbr_est_bitrate)
+		dbr_model_add_sample(&stream->dbr_model, now,
+				     stream->dbr_est_bitrate,
+				     get_tcp_rtt_usec(stream));
+}
+
 static void dbr_set_bitrate(struct rtmp_stream *stream);
 static bool rtmp_stream_start(void *data);
 
@@ -615,6 +847,7 @@ static void log_sndbuf_size(struct rtmp_stream *stream)
 static void *send_thread(void *data)
 {
 	struct rtmp_stream *stream = data;
+	os_thread_role_t *role = os_set_thread_role(OS_THREAD_ROLE_IO);
 
 	os_set_thread_name("rtmp-stream: send_thread");
 
@@ -688,6 +921,9 @@ static void *send_thread(void *data)
 
 			pthread_mutex_lock(&stream->dbr_mutex);
 			dbr_add_frame(stream, &dbr_frame);
+			if (stream->dbr_model_enabled)
+				dbr_model_add_frame(stream,
+						    dbr_frame.send_end);
 			pthread_mutex_unlock(&stream->dbr_mutex);
 		}
 	}
@@ -710,7 +946,7 @@ static void *send_thread(void *data)
 
 	if (stream->new_socket_loop) {
 		os_event_signal(stream->send_thread_signaled_exit);
-		os_event_signal(stream->buffer_has_data_event);
+		socket_loop_signal(stream);
 		pthread_join(stream->socket_thread, NULL);
 		stream->socket_thread_active = false;
 		stream->rtmp.m_bCustomSend = false;
@@ -763,6 +999,8 @@ static void *send_thread(void *data)
 		}
 	}
 
+	os_reset_thread_role(role);
+
 	if (silently_reconnecting(stream)) {
 		rtmp_stream_start(stream);
 	}
@@ -819,20 +1057,30 @@ static bool send_audio_header(struct rtmp_stream *stream, size_t idx,
 	return send_packet(stream, &packet, true, idx) >= 0;
 }
 
-static bool send_video_header(struct rtmp_stream *stream)
+static bool send_video_header(struct rtmp_stream *stream, size_t idx,
+			      bool *next)
 {
 	obs_output_t *context = stream->output;
-	obs_encoder_t *vencoder = obs_output_get_video_encoder(context);
+	obs_encoder_t *vencoder = obs_output_get_video_encoder2(context, idx);
 	uint8_t *header;
 	size_t size;
 
-	struct encoder_packet packet = {
-		.type = OBS_ENCODER_VIDEO, .timebase_den = 1, .keyframe = true};
+	struct encoder_packet packet = {.type = OBS_ENCODER_VIDEO,
+					.timebase_den = 1,
+					.keyframe = true,
+					.track_idx = idx,
+					.encoder = vencoder};
+
+	if (!vencoder) {
+		*next = false;
+		return idx > 0;
+	}
 
 	if (!obs_encoder_get_extra_data(vencoder, &header, &size))
 		return false;
-	packet.size = obs_parse_avc_header(&packet.data, header, size);
-	return send_packet(stream, &packet, true, 0) >= 0;
+	packet.size =
+		flv_parse_video_header(vencoder, &packet.data, header, size);
+	return send_packet(stream, &packet, true, idx) >= 0;
 }
 
 static inline bool send_headers(struct rtmp_stream *stream)
@@ -840,10 +1088,11 @@ static inline bool send_headers(struct rtmp_stream *stream)
 	stream->sent_headers = true;
 	size_t i = 0;
 	bool next = true;
+	bool next_video = true;
 
 	if (!send_audio_header(stream, i++, &next))
 		return false;
-	if (!send_video_header(stream))
+	if (!send_video_header(stream, 0, &next_video))
 		return false;
 
 	while (next) {
@@ -851,6 +1100,12 @@ static inline bool send_headers(struct rtmp_stream *stream)
 			return false;
 	}
 
+	/* renditions of a simulcast output, each in its own video track */
+	for (size_t v = 1; next_video; v++) {
+		if (!send_video_header(stream, v, &next_video))
+			return false;
+	}
+
 	return true;
 }
 
@@ -945,8 +1200,8 @@ static int init_send(struct rtmp_stream *stream)
 		ret = pthread_create(&stream->socket_thread, NULL,
 				     socket_thread_windows, stream);
 #else
-		warn("New socket loop not supported on this platform");
-		return OBS_OUTPUT_ERROR;
+		ret = pthread_create(&stream->socket_thread, NULL,
+				     socket_thread_posix, stream);
 #endif
 
 		if (ret != 0) {
@@ -1102,6 +1357,8 @@ static int try_connect(struct rtmp_stream *stream)
 	win32_log_interface_type(stream);
 #endif
 
+	use_standby(stream);
+
 	if (!RTMP_Connect(&stream->rtmp, NULL)) {
 		set_output_error(stream);
 		return OBS_OUTPUT_CONNECT_FAILED;
@@ -1112,6 +1369,8 @@ static int try_connect(struct rtmp_stream *stream)
 
 	info("Connection to %s successful", stream->path.array);
 
+	start_standby(stream);
+
 	return init_send(stream);
 }
 
@@ -1129,6 +1388,7 @@ static bool init_connect(struct rtmp_stream *stream)
 	}
 
 	free_packets(stream);
+	stop_standby(stream);
 
 	service = obs_output_get_service(stream->output);
 	if (!service)
@@ -1184,6 +1444,22 @@ static bool init_connect(struct rtmp_stream *stream)
 		info("Dynamic bitrate enabled.  Dropped frames begone!");
 	}
 
+	stream->dbr_model_enabled =
+		stream->dbr_enabled &&
+		obs_data_get_bool(settings, OPT_DYN_BITRATE_MODEL);
+
+	if (stream->dbr_model_enabled) {
+		long min_bitrate = stream->dbr_orig_bitrate / 10;
+		if (min_bitrate < 50)
+			min_bitrate = 50;
+
+		dbr_model_init(&stream->dbr_model, min_bitrate,
+			       stream->dbr_orig_bitrate, os_gettime_ns());
+		stream->dbr_model_sample_ts = 0;
+		stream->dbr_model_set_ts = 0;
+		info("Using bandwidth model for dynamic bitrate");
+	}
+
 	obs_data_release(vsettings);
 	obs_data_release(asettings);
 
@@ -1200,6 +1476,8 @@ static bool init_connect(struct rtmp_stream *stream)
 		obs_data_get_bool(settings, OPT_NEWSOCKETLOOP_ENABLED);
 	stream->low_latency_mode =
 		obs_data_get_bool(settings, OPT_LOWLATENCY_ENABLED);
+	stream->standby_enabled =
+		obs_data_get_bool(settings, OPT_STANDBY_CONNECTION);
 
 	// ugly hack for now, can be removed once new loop is reworked
 	if (stream->new_socket_loop &&
@@ -1276,13 +1554,48 @@ static inline size_t num_buffered_packets(struct rtmp_stream *stream)
 	return stream->packets.size / sizeof(struct encoder_packet);
 }
 
+/* returns the dts of the newest queued keyframe that has video queued ahead
+ * of it, everything before it can be dropped without breaking decoding */
+static bool find_last_keyframe(struct rtmp_stream *stream, int64_t *dts_usec)
+{
+	size_t count = stream->packets.size / sizeof(struct encoder_packet);
+	bool video_before = false;
+	bool found = false;
+
+	for (size_t i = 0; i < count; i++) {
+		struct encoder_packet *cur = circlebuf_data(
+			&stream->packets, i * sizeof(struct encoder_packet));
+		if (cur->type != OBS_ENCODER_VIDEO)
+			continue;
+
+		if (cur->keyframe && video_before) {
+			*dts_usec = cur->dts_usec;
+			found = true;
+		}
+
+		video_before = true;
+	}
+
+	return found;
+}
+
+/* Frames are dropped in order of how much they cost the picture:
+ *
+ * - non-reference frames first, nothing depends on them
+ * - then whole GOPs that are already superseded by a queued keyframe
+ * - only then reference frames, and only the ones still to come, since
+ *   everything already queued up to that point still decodes
+ *
+ * This runs again for every packet, so a short spike only costs the frames
+ * needed to get back under the threshold. */
 static void drop_frames(struct rtmp_stream *stream, const char *name,
 			int highest_priority, bool pframes)
 {
-	UNUSED_PARAMETER(pframes);
-
 	struct circlebuf new_buf = {0};
 	int num_frames_dropped = 0;
+	int64_t keyframe_dts = 0;
+	bool have_keyframe = false;
+	int drop_below = highest_priority;
 
 #ifdef _DEBUG
 	int start_packets = (int)num_buffered_packets(stream);
@@ -1290,27 +1603,41 @@ static void drop_frames(struct rtmp_stream *stream, const char *name,
 	UNUSED_PARAMETER(name);
 #endif
 
+	if (pframes) {
+		have_keyframe = find_last_keyframe(stream, &keyframe_dts);
+		drop_below = OBS_NAL_PRIORITY_HIGH;
+	}
+
 	circlebuf_reserve(&new_buf, sizeof(struct encoder_packet) * 8);
 
 	while (stream->packets.size) {
 		struct encoder_packet packet;
+		bool drop;
+
 		circlebuf_pop_front(&stream->packets, &packet, sizeof(packet));
 
-		/* do not drop audio data or video keyframes */
-		if (packet.type == OBS_ENCODER_AUDIO ||
-		    packet.drop_priority >= highest_priority) {
-			circlebuf_push_back(&new_buf, &packet, sizeof(packet));
+		/* never drop audio data */
+		if (packet.type == OBS_ENCODER_AUDIO)
+			drop = false;
+		else if (have_keyframe && packet.dts_usec < keyframe_dts)
+			drop = true;
+		else
+			drop = packet.drop_priority < drop_below;
 
-		} else {
+		if (drop) {
 			num_frames_dropped++;
 			obs_encoder_packet_release(&packet);
+		} else {
+			circlebuf_push_back(&new_buf, &packet, sizeof(packet));
 		}
 	}
 
 	circlebuf_free(&stream->packets);
 	stream->packets = new_buf;
 
-	if (stream->min_priority < highest_priority)
+	/* with nothing superseded to drop, stop queueing frames until the next
+	 * one at this priority, which for p-frames means the next keyframe */
+	if (!have_keyframe && stream->min_priority < highest_priority)
 		stream->min_priority = highest_priority;
 	if (!num_frames_dropped)
 		return;
@@ -1445,6 +1772,42 @@ static void dbr_inc_bitrate(struct rtmp_stream *stream)
 	}
 }
 
+static void dbr_model_check(struct rtmp_stream *stream)
+{
+	struct encoder_packet first;
+	int64_t queued_usec = 0;
+	uint64_t t = os_gettime_ns();
+	long cur = stream->dbr_cur_bitrate;
+	long target;
+
+	if (find_first_video_packet(stream, &first))
+		queued_usec = stream->last_dts_usec - first.dts_usec;
+
+	pthread_mutex_lock(&stream->dbr_mutex);
+	target = dbr_model_update(&stream->dbr_model, t, queued_usec);
+	pthread_mutex_unlock(&stream->dbr_mutex);
+
+	if (target == cur)
+		return;
+
+	/* reconfiguring the encoder isn't free, so only raise the bitrate in
+	 * meaningful steps, but always lower it right away */
+	if (target > cur) {
+		if (target - cur < cur / 20)
+			return;
+		if (t - stream->dbr_model_set_ts < DBR_MODEL_RAISE_INTERVAL)
+			return;
+	}
+
+	stream->dbr_cur_bitrate = target;
+	stream->dbr_model_set_ts = t;
+
+	debug("bandwidth estimate: %ld, bitrate %s to: %ld",
+	      dbr_model_bandwidth(&stream->dbr_model),
+	      target > cur ? "increased" : "decreased", target);
+	dbr_set_bitrate(stream);
+}
+
 static void check_to_drop_frames(struct rtmp_stream *stream, bool pframes)
 {
 	struct encoder_packet first;
@@ -1456,7 +1819,10 @@ static void check_to_drop_frames(struct rtmp_stream *stream, bool pframes)
 	int64_t drop_threshold = pframes ? stream->pframe_drop_threshold_usec
 					 : stream->drop_threshold_usec;
 
-	if (!pframes && stream->dbr_enabled) {
+	if (!pframes && stream->dbr_model_enabled) {
+		dbr_model_check(stream);
+
+	} else if (!pframes && stream->dbr_enabled) {
 		if (stream->dbr_inc_timeout) {
 			uint64_t t = os_gettime_ns();
 
@@ -1493,7 +1859,7 @@ static void check_to_drop_frames(struct rtmp_stream *stream, bool pframes)
 	if (stream->dbr_enabled) {
 		bool bitrate_changed = false;
 
-		if (pframes) {
+		if (pframes || stream->dbr_model_enabled) {
 			return;
 		}
 
@@ -1575,7 +1941,7 @@ static void rtmp_stream_data(void *data, struct encoder_packet *packet)
 			stream->got_first_video = true;
 		}
 
-		obs_parse_avc_packet(&new_packet, packet);
+		flv_parse_video_packet(&new_packet, packet);
 	} else {
 		obs_encoder_packet_ref(&new_packet, packet);
 	}
@@ -1604,6 +1970,8 @@ static void rtmp_stream_defaults(obs_data_t *defaults)
 	obs_data_set_default_string(defaults, OPT_BIND_IP, "default");
 	obs_data_set_default_bool(defaults, OPT_NEWSOCKETLOOP_ENABLED, false);
 	obs_data_set_default_bool(defaults, OPT_LOWLATENCY_ENABLED, false);
+	obs_data_set_default_bool(defaults, OPT_DYN_BITRATE_MODEL, false);
+	obs_data_set_default_bool(defaults, OPT_STANDBY_CONNECTION, false);
 }
 
 static obs_properties_t *rtmp_stream_properties(void *unused)
@@ -1637,6 +2005,10 @@ static obs_properties_t *rtmp_stream_properties(void *unused)
 				obs_module_text("RTMPStream.NewSocketLoop"));
 	obs_properties_add_bool(props, OPT_LOWLATENCY_ENABLED,
 				obs_module_text("RTMPStream.LowLatencyMode"));
+	obs_properties_add_bool(props, OPT_DYN_BITRATE_MODEL,
+				obs_module_text("RTMPStream.DynBitrateModel"));
+	obs_properties_add_bool(props, OPT_STANDBY_CONNECTION,
+				obs_module_text("RTMPStream.StandbyConnection"));
 
 	return props;
 }
@@ -1680,7 +2052,11 @@ struct obs_output_info rtmp_output_info = {
 	.id = "rtmp_output",
 	.flags = OBS_OUTPUT_AV | OBS_OUTPUT_ENCODED | OBS_OUTPUT_SERVICE |
 		 OBS_OUTPUT_MULTI_TRACK,
-	.encoded_video_codecs = "h264",
+#ifdef ENABLE_HEVC
+	.encoded_video_codecs = "h264;hevc;av1",
+#else
+	.encoded_video_codecs = "h264;av1",
+#endif
 	.encoded_audio_codecs = "aac",
 	.get_name = rtmp_stream_getname,
 	.create = rtmp_stream_create,
@@ -1696,3 +2072,36 @@ struct obs_output_info rtmp_output_info = {
 	.get_dropped_frames = rtmp_stream_dropped_frames,
 	.is_ready_to_update = rtmp_stream_is_ready_to_update,
 };
+
+static const char *rtmp_simulcast_getname(void *unused)
+{
+	UNUSED_PARAMETER(unused);
+	return obs_module_text("RTMPSimulcastStream");
+}
+
+/* sends several renditions of the same video over one connection, each
+ * video encoder gets its own Enhanced RTMP video track */
+struct obs_output_info rtmp_simulcast_output_info = {
+	.id = "rtmp_simulcast_output",
+	.flags = OBS_OUTPUT_AV | OBS_OUTPUT_ENCODED | OBS_OUTPUT_SERVICE |
+		 OBS_OUTPUT_MULTI_TRACK | OBS_OUTPUT_MULTI_TRACK_VIDEO,
+#ifdef ENABLE_HEVC
+	.encoded_video_codecs = "h264;hevc;av1",
+#else
+	.encoded_video_codecs = "h264;av1",
+#endif
+	.encoded_audio_codecs = "aac",
+	.get_name = rtmp_simulcast_getname,
+	.create = rtmp_stream_create,
+	.destroy = rtmp_stream_destroy,
+	.start = rtmp_stream_start,
+	.stop = rtmp_stream_stop,
+	.encoded_packet = rtmp_stream_data,
+	.get_defaults = rtmp_stream_defaults,
+	.get_properties = rtmp_stream_properties,
+	.get_total_bytes = rtmp_stream_total_bytes_sent,
+	.get_congestion = rtmp_stream_congestion,
+	.get_connect_time_ms = rtmp_stream_connect_time,
+	.get_dropped_frames = rtmp_stream_dropped_frames,
+	.is_ready_to_update = rtmp_stream_is_ready_to_update,
+};
@@ -9,6 +9,7 @@
 #include "librtmp/log.h"
 #include "flv-mux.h"
 #include "net-if.h"
+#include "dbr-model.h"
 
 #ifdef _WIN32
 #include <Iphlpapi.h>
@@ -25,6 +26,7 @@
 #define debug(format, ...) do_log(LOG_DEBUG, format, ##__VA_ARGS__)
 
 #define OPT_DYN_BITRATE "dyn_bitrate"
+#define OPT_DYN_BITRATE_MODEL "dyn_bitrate_model"
 #define OPT_DROP_THRESHOLD "drop_threshold_ms"
 #define OPT_PFRAME_DROP_THRESHOLD "pframe_drop_threshold_ms"
 #define OPT_MAX_SHUTDOWN_TIME_SEC "max_shutdown_time_sec"
@@ -32,6 +34,7 @@
 #define OPT_NEWSOCKETLOOP_ENABLED "new_socket_loop_enabled"
 #define OPT_LOWLATENCY_ENABLED "low_latency_mode_enabled"
 #define OPT_METADATA_MULTITRACK "metadata_multitrack"
+#define OPT_STANDBY_CONNECTION "standby_connection"
 
 //#define TEST_FRAMEDROPS
 //#define TEST_FRAMEDROPS_WITH_BITRATE_SHORTCUTS
@@ -117,8 +120,27 @@ struct rtmp_stream {
 	long dbr_inc_bitrate;
 	bool dbr_enabled;
 
+	/* model-based dynamic bitrate, see dbr-model.h */
+	bool dbr_model_enabled;
+	struct dbr_model dbr_model;
+	uint64_t dbr_model_sample_ts;
+	uint64_t dbr_model_set_ts;
+
 	RTMP rtmp;
 
+	/* idle TCP connection kept open to the server while streaming, so a
+	 * reconnect can skip name resolution and the TCP handshake */
+	bool standby_enabled;
+	bool standby_thread_active;
+	pthread_t standby_thread;
+	os_event_t *standby_stop_event;
+	pthread_mutex_t standby_mutex;
+	SOCKET standby_socket;
+	uint64_t standby_ts;
+	struct dstr standby_host;
+	int standby_port;
+	RTMP_BINDINFO standby_bind;
+
 	bool new_socket_loop;
 	bool low_latency_mode;
 	bool disable_send_window_optimization;
@@ -132,8 +154,28 @@ struct rtmp_stream {
 	os_event_t *buffer_has_data_event;
 	os_event_t *socket_available_event;
 	os_event_t *send_thread_signaled_exit;
+#ifndef _WIN32
+	int wake_pipe[2];
+#endif
 };
 
+enum data_ret { RET_BREAK, RET_FATAL, RET_CONTINUE };
+
+extern void socket_loop_fatal_shutdown(struct rtmp_stream *stream);
+extern void socket_loop_get_pacing(struct rtmp_stream *stream, int *delay_time,
+				   size_t *latency_packet_size);
+extern enum data_ret socket_loop_write_data(struct rtmp_stream *stream,
+					    bool *can_write,
+					    uint64_t *last_send_time,
+					    size_t latency_packet_size,
+					    int delay_time);
+extern bool socket_loop_should_exit(struct rtmp_stream *stream);
+extern void socket_loop_signal(struct rtmp_stream *stream);
+
 #ifdef _WIN32
 void *socket_thread_windows(void *data);
+#else
+extern bool socket_loop_posix_init(struct rtmp_stream *stream);
+extern void socket_loop_posix_free(struct rtmp_stream *stream);
+void *socket_thread_posix(void *data);
 #endif
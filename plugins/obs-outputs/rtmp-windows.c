@@ -1,14 +1,6 @@
 #ifdef _WIN32
 #include "rtmp-stream.h"
 
-static void fatal_sock_shutdown(struct rtmp_stream *stream)
-{
-	closesocket(stream->rtmp.m_sb.sb_socket);
-	stream->rtmp.m_sb.sb_socket = -1;
-	stream->write_buf_len = 0;
-	os_event_signal(stream->buffer_space_available_event);
-}
-
 static bool socket_event(struct rtmp_stream *stream, bool *can_write,
 			 uint64_t last_send_time)
 {
@@ -22,7 +14,7 @@ static bool socket_event(struct rtmp_stream *stream, bool *can_write,
 		     "socket_thread_windows: Aborting due to "
 		     "WSAEnumNetworkEvents failure, %d",
 		     WSAGetLastError());
-		fatal_sock_shutdown(stream);
+		socket_loop_fatal_shutdown(stream);
 		return false;
 	}
 
@@ -55,7 +47,7 @@ static bool socket_event(struct rtmp_stream *stream, bool *can_write,
 			     "to FD_CLOSE, error %d",
 			     net_events.iErrorCode[FD_CLOSE_BIT]);
 
-		fatal_sock_shutdown(stream);
+		socket_loop_fatal_shutdown(stream);
 		return false;
 	}
 
@@ -85,7 +77,7 @@ static bool socket_event(struct rtmp_stream *stream, bool *can_write,
 				     "%d, GetLastError() %d",
 				     ret, err_code);
 				stream->rtmp.last_error_code = err_code;
-				fatal_sock_shutdown(stream);
+				socket_loop_fatal_shutdown(stream);
 				return false;
 			}
 		}
@@ -139,99 +131,6 @@ static void ideal_send_backlog_event(struct rtmp_stream *stream,
 	}
 }
 
-enum data_ret { RET_BREAK, RET_FATAL, RET_CONTINUE };
-
-static enum data_ret write_data(struct rtmp_stream *stream, bool *can_write,
-				uint64_t *last_send_time,
-				size_t latency_packet_size, int delay_time)
-{
-	bool exit_loop = false;
-
-	pthread_mutex_lock(&stream->write_buf_mutex);
-
-	if (!stream->write_buf_len) {
-		/* this is now an expected occasional condition due to use of
-		 * auto-reset events, we could end up emptying the buffer as
-		 * it's filled in a previous loop cycle, especially if using
-		 * low latency mode. */
-		pthread_mutex_unlock(&stream->write_buf_mutex);
-		/* blog(LOG_DEBUG, "socket_thread_windows: Trying to send, "
-				"but no data available"); */
-		return RET_BREAK;
-	}
-
-	int ret;
-	if (stream->low_latency_mode) {
-		size_t send_len =
-			min(latency_packet_size, stream->write_buf_len);
-
-		ret = RTMPSockBuf_Send(&stream->rtmp.m_sb,
-				       (const char *)stream->write_buf,
-				       (int)send_len);
-	} else {
-		ret = RTMPSockBuf_Send(&stream->rtmp.m_sb,
-				       (const char *)stream->write_buf,
-				       (int)stream->write_buf_len);
-	}
-
-	if (ret > 0) {
-		if (stream->write_buf_len - ret)
-			memmove(stream->write_buf, stream->write_buf + ret,
-				stream->write_buf_len - ret);
-		stream->write_buf_len -= ret;
-
-		*last_send_time = os_gettime_ns() / 1000000;
-
-		os_event_signal(stream->buffer_space_available_event);
-	} else {
-		int err_code;
-		bool fatal_err = false;
-
-		if (ret == -1) {
-			err_code = WSAGetLastError();
-
-			if (err_code == WSAEWOULDBLOCK) {
-				*can_write = false;
-				pthread_mutex_unlock(&stream->write_buf_mutex);
-				return RET_BREAK;
-			}
-
-			fatal_err = true;
-		} else if (ret == 0) {
-			err_code = 0;
-			fatal_err = true;
-		}
-
-		if (fatal_err) {
-			/* connection closed, or connection was aborted /
-			 * socket closed / etc, that's a fatal error. */
-			blog(LOG_ERROR,
-			     "socket_thread_windows: "
-			     "Socket error, send() returned %d, "
-			     "GetLastError() %d",
-			     ret, err_code);
-
-			pthread_mutex_unlock(&stream->write_buf_mutex);
-			stream->rtmp.last_error_code = err_code;
-			fatal_sock_shutdown(stream);
-			return RET_FATAL;
-		}
-	}
-
-	/* finish writing for now */
-	if (stream->write_buf_len <= 1000)
-		exit_loop = true;
-
-	pthread_mutex_unlock(&stream->write_buf_mutex);
-
-	if (delay_time)
-		os_sleep_ms(delay_time);
-
-	return exit_loop ? RET_BREAK : RET_CONTINUE;
-}
-
-#define LATENCY_FACTOR 20
-
 static inline void socket_thread_windows_internal(struct rtmp_stream *stream)
 {
 	bool can_write = false;
@@ -251,14 +150,7 @@ static inline void socket_thread_windows_internal(struct rtmp_stream *stream)
 
 	send_backlog_event = CreateEvent(NULL, true, false, NULL);
 
-	if (stream->low_latency_mode) {
-		delay_time = 1000 / LATENCY_FACTOR;
-		latency_packet_size =
-			stream->write_buf_size / (LATENCY_FACTOR - 2);
-	} else {
-		latency_packet_size = stream->write_buf_size;
-		delay_time = 0;
-	}
+	socket_loop_get_pacing(stream, &delay_time, &latency_packet_size);
 
 	if (!stream->disable_send_window_optimization) {
 		memset(&send_backlog_overlapped, 0,
@@ -278,24 +170,14 @@ static inline void socket_thread_windows_internal(struct rtmp_stream *stream)
 	objs[2] = send_backlog_event;
 
 	for (;;) {
-		if (os_event_try(stream->send_thread_signaled_exit) != EAGAIN) {
-			pthread_mutex_lock(&stream->write_buf_mutex);
-			if (stream->write_buf_len == 0) {
-				//blog(LOG_DEBUG, "Exiting on empty buffer");
-				pthread_mutex_unlock(&stream->write_buf_mutex);
-				os_event_reset(
-					stream->send_thread_signaled_exit);
-				break;
-			}
-
-			pthread_mutex_unlock(&stream->write_buf_mutex);
-		}
+		if (socket_loop_should_exit(stream))
+			break;
 
 		int status = WaitForMultipleObjects(3, objs, false, INFINITE);
 		if (status == WAIT_ABANDONED || status == WAIT_FAILED) {
 			blog(LOG_ERROR, "socket_thread_windows: Aborting due "
 					"to WaitForMultipleObjects failure");
-			fatal_sock_shutdown(stream);
+			socket_loop_fatal_shutdown(stream);
 			return;
 		}
 
@@ -316,7 +198,7 @@ static inline void socket_thread_windows_internal(struct rtmp_stream *stream)
 
 		if (can_write) {
 			for (;;) {
-				enum data_ret ret = write_data(
+				enum data_ret ret = socket_loop_write_data(
 					stream, &can_write, &last_send_time,
 					latency_packet_size, delay_time);
 
@@ -0,0 +1,748 @@
+/******************************************************************************
+    Copyright (C) 2023 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include <obs-module.h>
+#include <util/platform.h>
+#include <util/dstr.h>
+#include <util/threading.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <math.h>
+#include <curl/curl.h>
+#include <rtc/rtc.h>
+
+/* WebRTC ingest through WHIP: the SDP offer is POSTed to the service URL,
+ * the answer sets up a send-only peer connection, and the encoders' H.264
+ * and Opus packets are sent over as is.  libdatachannel packetizes them
+ * into RTP much like the FTL output does, keeps a history for answering
+ * NACKs, and hands us PLIs, which turn into keyframe requests for the
+ * video encoder. */
+
+#define do_log(level, format, ...)                 \
+	blog(level, "[whip output: '%s'] " format, \
+	     obs_output_get_name(stream->output), ##__VA_ARGS__)
+
+#define warn(format, ...) do_log(LOG_WARNING, format, ##__VA_ARGS__)
+#define info(format, ...) do_log(LOG_INFO, format, ##__VA_ARGS__)
+#define debug(format, ...) do_log(LOG_DEBUG, format, ##__VA_ARGS__)
+
+#define VIDEO_CLOCK_RATE 90000
+#define AUDIO_CLOCK_RATE 48000
+#define VIDEO_PAYLOAD_TYPE 96
+#define AUDIO_PAYLOAD_TYPE 111
+#define MAX_FRAGMENT_SIZE 1200
+#define NACK_HISTORY_PACKETS 512
+#define CONNECT_TIMEOUT_MS 10000
+#define HTTP_TIMEOUT_SEC 10L
+#define STATS_WINDOW_NS 1000000000ULL
+
+struct whip_stream {
+	obs_output_t *output;
+
+	struct dstr endpoint;
+	struct dstr bearer_token;
+	struct dstr resource_url;
+
+	int pc;
+	int video_track;
+	int audio_track;
+	uint32_t video_ts_base;
+	uint32_t audio_ts_base;
+
+	os_event_t *gathered_event;
+	os_event_t *connected_event;
+
+	volatile bool connecting;
+	volatile bool active;
+	volatile bool disconnected;
+	pthread_t connect_thread;
+
+	int connect_time_ms;
+	uint64_t total_bytes;
+
+	/* SPS/PPS, prepended to keyframes so receivers can start decoding
+	 * at any of them */
+	uint8_t *video_header;
+	size_t video_header_size;
+
+	/* stats, guarded by stats_mutex.  jitter is measured on the sender
+	 * side the way RFC 3550 does it, comparing when frames are sent
+	 * against their timestamps */
+	pthread_mutex_t stats_mutex;
+	uint64_t window_start_ns;
+	uint64_t window_bytes;
+	int bitrate_kbps;
+	double jitter_usec;
+	bool have_last_video;
+	int64_t last_video_dts_usec;
+	uint64_t last_video_send_ns;
+	volatile long keyframe_requests;
+};
+
+static const char *whip_output_getname(void *unused)
+{
+	UNUSED_PARAMETER(unused);
+	return obs_module_text("WHIPOutput");
+}
+
+static void get_stats_proc(void *data, calldata_t *cd)
+{
+	struct whip_stream *stream = data;
+
+	pthread_mutex_lock(&stream->stats_mutex);
+	calldata_set_int(cd, "bitrate_kbps", stream->bitrate_kbps);
+	calldata_set_float(cd, "jitter_ms", stream->jitter_usec / 1000.0);
+	pthread_mutex_unlock(&stream->stats_mutex);
+
+	calldata_set_int(cd, "keyframe_requests",
+			 os_atomic_load_long(&stream->keyframe_requests));
+}
+
+static void *whip_output_create(obs_data_t *settings, obs_output_t *output)
+{
+	struct whip_stream *stream = bzalloc(sizeof(*stream));
+	stream->output = output;
+	stream->pc = -1;
+	stream->video_track = -1;
+	stream->audio_track = -1;
+	pthread_mutex_init_value(&stream->stats_mutex);
+
+	if (pthread_mutex_init(&stream->stats_mutex, NULL) != 0)
+		goto fail;
+	if (os_event_init(&stream->gathered_event, OS_EVENT_TYPE_MANUAL) != 0)
+		goto fail;
+	if (os_event_init(&stream->connected_event, OS_EVENT_TYPE_MANUAL) != 0)
+		goto fail;
+
+	proc_handler_t *ph = obs_output_get_proc_handler(output);
+	proc_handler_add(ph,
+			 "void get_stats(out int bitrate_kbps, "
+			 "out float jitter_ms, out int keyframe_requests)",
+			 get_stats_proc, stream);
+
+	UNUSED_PARAMETER(settings);
+	return stream;
+
+fail:
+	os_event_destroy(stream->gathered_event);
+	pthread_mutex_destroy(&stream->stats_mutex);
+	bfree(stream);
+	return NULL;
+}
+
+static void whip_output_destroy(void *data)
+{
+	struct whip_stream *stream = data;
+
+	if (os_atomic_load_bool(&stream->connecting))
+		pthread_join(stream->connect_thread, NULL);
+
+	dstr_free(&stream->endpoint);
+	dstr_free(&stream->bearer_token);
+	dstr_free(&stream->resource_url);
+	bfree(stream->video_header);
+	os_event_destroy(stream->gathered_event);
+	os_event_destroy(stream->connected_event);
+	pthread_mutex_destroy(&stream->stats_mutex);
+	bfree(stream);
+}
+
+/* ------------------------------------------------------------------------- */
+/* WHIP signaling                                                            */
+
+static size_t curl_write_cb(char *ptr, size_t size, size_t nmemb, void *param)
+{
+	struct dstr *body = param;
+	dstr_ncat(body, ptr, size * nmemb);
+	return size * nmemb;
+}
+
+static size_t curl_header_cb(char *ptr, size_t size, size_t nmemb, void *param)
+{
+	struct dstr *location = param;
+	size_t len = size * nmemb;
+
+	if (len > 9 && astrcmpi_n(ptr, "location:", 9) == 0) {
+		dstr_ncopy(location, ptr + 9, len - 9);
+		dstr_depad(location);
+	}
+
+	return len;
+}
+
+/* the Location header may be relative to the endpoint */
+static void set_resource_url(struct whip_stream *stream, struct dstr *location)
+{
+	const char *scheme_end;
+	const char *path;
+
+	if (dstr_is_empty(location) || location->array[0] != '/') {
+		dstr_copy_dstr(&stream->resource_url, location);
+		return;
+	}
+
+	scheme_end = strstr(stream->endpoint.array, "://");
+	path = scheme_end ? strchr(scheme_end + 3, '/') : NULL;
+
+	if (path)
+		dstr_ncopy(&stream->resource_url, stream->endpoint.array,
+			   path - stream->endpoint.array);
+	else
+		dstr_copy_dstr(&stream->resource_url, &stream->endpoint);
+
+	dstr_cat_dstr(&stream->resource_url, location);
+}
+
+static struct curl_slist *get_headers(struct whip_stream *stream,
+				      bool has_body)
+{
+	struct curl_slist *headers = NULL;
+
+	if (has_body)
+		headers = curl_slist_append(headers,
+					    "Content-Type: application/sdp");
+
+	if (!dstr_is_empty(&stream->bearer_token)) {
+		struct dstr auth = {0};
+		dstr_printf(&auth, "Authorization: Bearer %s",
+			    stream->bearer_token.array);
+		headers = curl_slist_append(headers, auth.array);
+		dstr_free(&auth);
+	}
+
+	return headers;
+}
+
+static bool send_offer(struct whip_stream *stream, const char *offer,
+		       struct dstr *answer)
+{
+	struct dstr location = {0};
+	struct curl_slist *headers = get_headers(stream, true);
+	long response_code = 0;
+	CURLcode res;
+	CURL *curl;
+
+	curl = curl_easy_init();
+	if (!curl) {
+		curl_slist_free_all(headers);
+		return false;
+	}
+
+	curl_easy_setopt(curl, CURLOPT_URL, stream->endpoint.array);
+	curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+	curl_easy_setopt(curl, CURLOPT_POSTFIELDS, offer);
+	curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, curl_write_cb);
+	curl_easy_setopt(curl, CURLOPT_WRITEDATA, answer);
+	curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, curl_header_cb);
+	curl_easy_setopt(curl, CURLOPT_HEADERDATA, &location);
+	curl_easy_setopt(curl, CURLOPT_TIMEOUT, HTTP_TIMEOUT_SEC);
+
+	res = curl_easy_perform(curl);
+	if (res == CURLE_OK)
+		curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
+
+	curl_easy_cleanup(curl);
+	curl_slist_free_all(headers);
+
+	if (res != CURLE_OK) {
+		warn("Failed to send offer: %s", curl_easy_strerror(res));
+		dstr_free(&location);
+		return false;
+	}
+	if (response_code != 200 && response_code != 201) {
+		warn("Endpoint rejected the offer: HTTP %ld", response_code);
+		dstr_free(&location);
+		return false;
+	}
+
+	set_resource_url(stream, &location);
+	dstr_free(&location);
+	return !dstr_is_empty(answer);
+}
+
+static void delete_resource(struct whip_stream *stream)
+{
+	struct curl_slist *headers;
+	CURL *curl;
+
+	if (dstr_is_empty(&stream->resource_url))
+		return;
+
+	curl = curl_easy_init();
+	if (curl) {
+		headers = get_headers(stream, false);
+		curl_easy_setopt(curl, CURLOPT_URL, stream->resource_url.array);
+		curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "DELETE");
+		curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+		curl_easy_setopt(curl, CURLOPT_TIMEOUT, HTTP_TIMEOUT_SEC);
+		curl_easy_perform(curl);
+		curl_easy_cleanup(curl);
+		curl_slist_free_all(headers);
+	}
+
+	dstr_free(&stream->resource_url);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Peer connection                                                           */
+
+static void RTC_API on_state_change(int pc, rtcState state, void *ptr)
+{
+	struct whip_stream *stream = ptr;
+	UNUSED_PARAMETER(pc);
+
+	switch (state) {
+	case RTC_CONNECTED:
+		os_event_signal(stream->connected_event);
+		break;
+	case RTC_DISCONNECTED:
+	case RTC_FAILED:
+	case RTC_CLOSED:
+		/* the packet callback reports it, stopping the output from
+		 * a libdatachannel thread would tear down the connection
+		 * from inside its own callback */
+		os_atomic_set_bool(&stream->disconnected, true);
+		os_event_signal(stream->connected_event);
+		break;
+	default:
+		break;
+	}
+}
+
+static void RTC_API on_gathering_state_change(int pc, rtcGatheringState state,
+					      void *ptr)
+{
+	struct whip_stream *stream = ptr;
+	UNUSED_PARAMETER(pc);
+
+	if (state == RTC_GATHERING_COMPLETE)
+		os_event_signal(stream->gathered_event);
+}
+
+static void RTC_API on_pli(int tr, void *ptr)
+{
+	struct whip_stream *stream = ptr;
+	UNUSED_PARAMETER(tr);
+
+	os_atomic_inc_long(&stream->keyframe_requests);
+	obs_encoder_request_keyframe(
+		obs_output_get_video_encoder(stream->output));
+}
+
+static int add_track(struct whip_stream *stream, rtcCodec codec,
+		     int payload_type, uint32_t clock_rate, const char *mid,
+		     uint32_t *ts_base)
+{
+	uint32_t ssrc = (uint32_t)rand() << 16 | (uint32_t)(rand() & 0xFFFF);
+	rtcTrackInit init = {0};
+	rtcPacketizerInit pkt_init = {0};
+	int tr;
+
+	init.direction = RTC_DIRECTION_SENDONLY;
+	init.codec = codec;
+	init.payloadType = payload_type;
+	init.ssrc = ssrc;
+	init.mid = mid;
+	init.name = mid;
+	init.msid = "obs";
+	init.trackId = mid;
+	if (codec == RTC_CODEC_H264)
+		init.profile = "profile-level-id=42e01f;packetization-mode=1;"
+			       "level-asymmetry-allowed=1";
+
+	tr = rtcAddTrackEx(stream->pc, &init);
+	if (tr < 0)
+		return tr;
+
+	rtcSetUserPointer(tr, stream);
+
+	*ts_base = (uint32_t)rand();
+
+	pkt_init.ssrc = ssrc;
+	pkt_init.cname = "obs";
+	pkt_init.payloadType = (uint8_t)payload_type;
+	pkt_init.clockRate = clock_rate;
+	pkt_init.sequenceNumber = (uint16_t)rand();
+	pkt_init.timestamp = *ts_base;
+	pkt_init.nalSeparator = RTC_NAL_SEPARATOR_START_SEQUENCE;
+	pkt_init.maxFragmentSize = MAX_FRAGMENT_SIZE;
+
+	if ((codec == RTC_CODEC_H264 ? rtcSetH264Packetizer(tr, &pkt_init)
+				     : rtcSetOpusPacketizer(tr, &pkt_init)) <
+		    0 ||
+	    rtcChainRtcpSrReporter(tr) < 0 ||
+	    rtcChainRtcpNackResponder(tr, NACK_HISTORY_PACKETS) < 0)
+		return -1;
+
+	if (codec == RTC_CODEC_H264 && rtcChainPliHandler(tr, on_pli) < 0)
+		return -1;
+
+	return tr;
+}
+
+static void close_connection(struct whip_stream *stream)
+{
+	if (stream->video_track >= 0)
+		rtcDeleteTrack(stream->video_track);
+	if (stream->audio_track >= 0)
+		rtcDeleteTrack(stream->audio_track);
+	if (stream->pc >= 0) {
+		rtcClosePeerConnection(stream->pc);
+		rtcDeletePeerConnection(stream->pc);
+	}
+
+	stream->video_track = -1;
+	stream->audio_track = -1;
+	stream->pc = -1;
+
+	delete_resource(stream);
+}
+
+static bool create_connection(struct whip_stream *stream)
+{
+	rtcConfiguration config = {0};
+
+	stream->pc = rtcCreatePeerConnection(&config);
+	if (stream->pc < 0)
+		return false;
+
+	rtcSetUserPointer(stream->pc, stream);
+	rtcSetStateChangeCallback(stream->pc, on_state_change);
+	rtcSetGatheringStateChangeCallback(stream->pc,
+					   on_gathering_state_change);
+
+	stream->video_track = add_track(stream, RTC_CODEC_H264,
+					VIDEO_PAYLOAD_TYPE, VIDEO_CLOCK_RATE,
+					"video", &stream->video_ts_base);
+	stream->audio_track = add_track(stream, RTC_CODEC_OPUS,
+					AUDIO_PAYLOAD_TYPE, AUDIO_CLOCK_RATE,
+					"audio", &stream->audio_ts_base);
+
+	return stream->video_track >= 0 && stream->audio_track >= 0;
+}
+
+/* candidates are gathered up front, WHIP endpoints aren't required to
+ * support trickle ICE */
+static bool get_offer(struct whip_stream *stream, struct dstr *offer)
+{
+	int size;
+
+	if (rtcSetLocalDescription(stream->pc, "offer") < 0)
+		return false;
+	if (os_event_timedwait(stream->gathered_event, CONNECT_TIMEOUT_MS) != 0)
+		return false;
+
+	size = rtcGetLocalDescription(stream->pc, NULL, 0);
+	if (size <= 0)
+		return false;
+
+	dstr_reserve(offer, size);
+	if (rtcGetLocalDescription(stream->pc, offer->array, size) < 0)
+		return false;
+
+	offer->len = strlen(offer->array);
+	return true;
+}
+
+static bool init_connect(struct whip_stream *stream)
+{
+	obs_service_t *service = obs_output_get_service(stream->output);
+	obs_encoder_t *vencoder = obs_output_get_video_encoder(stream->output);
+	uint8_t *header;
+	size_t size;
+
+	if (!service)
+		return false;
+
+	dstr_copy(&stream->endpoint, obs_service_get_url(service));
+	dstr_copy(&stream->bearer_token, obs_service_get_key(service));
+	dstr_depad(&stream->endpoint);
+
+	if (dstr_is_empty(&stream->endpoint)) {
+		warn("No WHIP endpoint");
+		return false;
+	}
+
+	bfree(stream->video_header);
+	stream->video_header = NULL;
+	stream->video_header_size = 0;
+
+	if (obs_encoder_get_extra_data(vencoder, &header, &size)) {
+		stream->video_header = bmemdup(header, size);
+		stream->video_header_size = size;
+	}
+
+	os_event_reset(stream->gathered_event);
+	os_event_reset(stream->connected_event);
+	os_atomic_set_bool(&stream->disconnected, false);
+
+	pthread_mutex_lock(&stream->stats_mutex);
+	stream->window_start_ns = 0;
+	stream->window_bytes = 0;
+	stream->bitrate_kbps = 0;
+	stream->jitter_usec = 0.0;
+	stream->have_last_video = false;
+	pthread_mutex_unlock(&stream->stats_mutex);
+
+	os_atomic_set_long(&stream->keyframe_requests, 0);
+	stream->total_bytes = 0;
+	return true;
+}
+
+static int try_connect(struct whip_stream *stream)
+{
+	struct dstr offer = {0};
+	struct dstr answer = {0};
+	uint64_t start = os_gettime_ns();
+	int ret = OBS_OUTPUT_CONNECT_FAILED;
+
+	info("Connecting to WHIP endpoint: %s", stream->endpoint.array);
+
+	if (!create_connection(stream)) {
+		warn("Failed to create the peer connection");
+		goto fail;
+	}
+	if (!get_offer(stream, &offer)) {
+		warn("Failed to gather ICE candidates for the offer");
+		goto fail;
+	}
+	if (!send_offer(stream, offer.array, &answer)) {
+		ret = OBS_OUTPUT_CONNECT_FAILED;
+		goto fail;
+	}
+	if (rtcSetRemoteDescription(stream->pc, answer.array, "answer") < 0) {
+		warn("Invalid answer from the endpoint");
+		ret = OBS_OUTPUT_INVALID_STREAM;
+		goto fail;
+	}
+
+	if (os_event_timedwait(stream->connected_event, CONNECT_TIMEOUT_MS) !=
+		    0 ||
+	    os_atomic_load_bool(&stream->disconnected)) {
+		warn("Peer connection failed to connect");
+		goto fail;
+	}
+
+	stream->connect_time_ms =
+		(int)((os_gettime_ns() - start) / 1000000ULL);
+	info("Connection to %s successful", stream->endpoint.array);
+
+	dstr_free(&offer);
+	dstr_free(&answer);
+
+	os_atomic_set_bool(&stream->active, true);
+	obs_output_begin_data_capture(stream->output, 0);
+	return OBS_OUTPUT_SUCCESS;
+
+fail:
+	dstr_free(&offer);
+	dstr_free(&answer);
+	close_connection(stream);
+	return ret;
+}
+
+static void *connect_thread(void *data)
+{
+	struct whip_stream *stream = data;
+	int ret;
+
+	os_set_thread_name("whip-output: connect_thread");
+
+	if (!init_connect(stream)) {
+		obs_output_signal_stop(stream->output, OBS_OUTPUT_BAD_PATH);
+		os_atomic_set_bool(&stream->connecting, false);
+		return NULL;
+	}
+
+	ret = try_connect(stream);
+	if (ret != OBS_OUTPUT_SUCCESS)
+		obs_output_signal_stop(stream->output, ret);
+
+	os_atomic_set_bool(&stream->connecting, false);
+	return NULL;
+}
+
+static bool whip_output_start(void *data)
+{
+	struct whip_stream *stream = data;
+
+	if (!obs_output_can_begin_data_capture(stream->output, 0))
+		return false;
+	if (!obs_output_initialize_encoders(stream->output, 0))
+		return false;
+
+	if (os_atomic_load_bool(&stream->connecting))
+		pthread_join(stream->connect_thread, NULL);
+
+	os_atomic_set_bool(&stream->connecting, true);
+	if (pthread_create(&stream->connect_thread, NULL, connect_thread,
+			   stream) != 0) {
+		os_atomic_set_bool(&stream->connecting, false);
+		return false;
+	}
+
+	return true;
+}
+
+static void whip_output_stop(void *data, uint64_t ts)
+{
+	struct whip_stream *stream = data;
+	UNUSED_PARAMETER(ts);
+
+	if (os_atomic_load_bool(&stream->connecting))
+		pthread_join(stream->connect_thread, NULL);
+	os_atomic_set_bool(&stream->connecting, false);
+
+	if (os_atomic_set_bool(&stream->active, false))
+		obs_output_end_data_capture(stream->output);
+	else
+		obs_output_signal_stop(stream->output, OBS_OUTPUT_SUCCESS);
+
+	close_connection(stream);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Media                                                                     */
+
+static void update_stats(struct whip_stream *stream,
+			 struct encoder_packet *packet, size_t size)
+{
+	uint64_t now = os_gettime_ns();
+
+	pthread_mutex_lock(&stream->stats_mutex);
+
+	if (!stream->window_start_ns)
+		stream->window_start_ns = now;
+
+	stream->window_bytes += size;
+	if (now - stream->window_start_ns >= STATS_WINDOW_NS) {
+		uint64_t elapsed = now - stream->window_start_ns;
+		stream->bitrate_kbps = (int)(stream->window_bytes * 8 *
+					     1000000ULL / elapsed);
+		stream->window_start_ns = now;
+		stream->window_bytes = 0;
+	}
+
+	if (packet->type == OBS_ENCODER_VIDEO) {
+		if (stream->have_last_video) {
+			int64_t send_delta =
+				(int64_t)(now - stream->last_video_send_ns) /
+				1000;
+			int64_t ts_delta = packet->dts_usec -
+					   stream->last_video_dts_usec;
+			double d = fabs((double)(send_delta - ts_delta));
+
+			stream->jitter_usec += (d - stream->jitter_usec) / 16.0;
+		}
+
+		stream->have_last_video = true;
+		stream->last_video_send_ns = now;
+		stream->last_video_dts_usec = packet->dts_usec;
+	}
+
+	pthread_mutex_unlock(&stream->stats_mutex);
+}
+
+static inline uint32_t get_rtp_timestamp(struct encoder_packet *packet,
+					 uint32_t clock_rate, uint32_t base)
+{
+	int64_t ts = packet->pts * (int64_t)clock_rate * packet->timebase_num /
+		     packet->timebase_den;
+	return base + (uint32_t)ts;
+}
+
+static void whip_output_data(void *data, struct encoder_packet *packet)
+{
+	struct whip_stream *stream = data;
+	bool video = packet && packet->type == OBS_ENCODER_VIDEO;
+	uint8_t *frame = NULL;
+	const uint8_t *payload;
+	size_t size;
+	int tr;
+
+	if (!packet) {
+		if (os_atomic_set_bool(&stream->active, false))
+			obs_output_signal_stop(stream->output,
+					       OBS_OUTPUT_ENCODE_ERROR);
+		return;
+	}
+
+	if (!os_atomic_load_bool(&stream->active))
+		return;
+
+	if (os_atomic_load_bool(&stream->disconnected)) {
+		if (os_atomic_set_bool(&stream->active, false)) {
+			warn("Peer connection lost");
+			obs_output_signal_stop(stream->output,
+					       OBS_OUTPUT_DISCONNECTED);
+		}
+		return;
+	}
+
+	tr = video ? stream->video_track : stream->audio_track;
+	payload = packet->data;
+	size = packet->size;
+
+	if (video && packet->keyframe && stream->video_header_size) {
+		size = stream->video_header_size + packet->size;
+		frame = bmalloc(size);
+		memcpy(frame, stream->video_header, stream->video_header_size);
+		memcpy(frame + stream->video_header_size, packet->data,
+		       packet->size);
+		payload = frame;
+	}
+
+	rtcSetTrackRtpTimestamp(
+		tr, get_rtp_timestamp(
+			    packet, video ? VIDEO_CLOCK_RATE : AUDIO_CLOCK_RATE,
+			    video ? stream->video_ts_base
+				  : stream->audio_ts_base));
+
+	if (rtcSendMessage(tr, (const char *)payload, (int)size) >= 0) {
+		stream->total_bytes += size;
+		update_stats(stream, packet, size);
+	}
+
+	bfree(frame);
+}
+
+static uint64_t whip_output_total_bytes(void *data)
+{
+	struct whip_stream *stream = data;
+	return stream->total_bytes;
+}
+
+static int whip_output_connect_time(void *data)
+{
+	struct whip_stream *stream = data;
+	return stream->connect_time_ms;
+}
+
+struct obs_output_info whip_output_info = {
+	.id = "whip_output",
+	.flags = OBS_OUTPUT_AV | OBS_OUTPUT_ENCODED | OBS_OUTPUT_SERVICE,
+	.encoded_video_codecs = "h264",
+	.encoded_audio_codecs = "opus",
+	.get_name = whip_output_getname,
+	.create = whip_output_create,
+	.destroy = whip_output_destroy,
+	.start = whip_output_start,
+	.stop = whip_output_stop,
+	.encoded_packet = whip_output_data,
+	.get_total_bytes = whip_output_total_bytes,
+	.get_connect_time_ms = whip_output_connect_time,
+};
@@ -609,6 +609,13 @@ mfxStatus QSV_Encoder_Internal::Encode_tex(uint64_t ts, uint32_t tex_handle,
 {
 	mfxStatus sts = MFX_ERR_NONE;
 	*pBS = NULL;
+
+	// shared textures can only be copied into D3D11 surfaces
+	if (!m_bUseD3D11) {
+		*next_key = lock_key;
+		return MFX_ERR_UNSUPPORTED;
+	}
+
 	int nTaskIdx = GetFreeTaskIndex(m_pTaskPool, m_nTaskPool);
 	int nSurfIdx = GetFreeSurfaceIndex(m_pmfxSurfaces, m_nSurfNum);
 
@@ -636,11 +643,9 @@ mfxStatus QSV_Encoder_Internal::Encode_tex(uint64_t ts, uint32_t tex_handle,
 	mfxFrameSurface1 *pSurface = m_pmfxSurfaces[nSurfIdx];
 	//copy to default surface directly
 	pSurface->Data.TimeStamp = ts;
-	if (m_bUseD3D11 || m_bD3D9HACK) {
-		sts = simple_copytex(m_mfxAllocator.pthis, pSurface->Data.MemId,
-				     tex_handle, lock_key, next_key);
-		MSDK_CHECK_RESULT(sts, MFX_ERR_NONE, sts);
-	}
+	sts = simple_copytex(m_mfxAllocator.pthis, pSurface->Data.MemId,
+			     tex_handle, lock_key, next_key);
+	MSDK_CHECK_RESULT(sts, MFX_ERR_NONE, sts);
 
 	for (;;) {
 		// Encode a frame asynchronously (returns immediately)
@@ -17,6 +17,19 @@ typedef struct {
 	mfxU16 rw;
 } CustomMemId;
 
+// OBS cycles through a handful of shared encode textures, so keep them open
+// instead of opening the shared resource again for every frame
+#define MAX_SHARED_TEXTURES 8
+
+typedef struct {
+	mfxU32 handle;
+	ID3D11Texture2D *tex;
+	IDXGIKeyedMutex *km;
+} SharedTexture;
+
+static SharedTexture sharedTextures[MAX_SHARED_TEXTURES];
+static mfxU32 sharedTextureNext;
+
 const struct {
 	mfxIMPL impl;     // actual implementation
 	mfxU32 adapterID; // device adapter number
@@ -110,9 +123,25 @@ void SetHWDeviceContext(CComPtr<ID3D11DeviceContext> devCtx)
 	devCtx->GetDevice(&g_pD3D11Device);
 }
 
+static void ReleaseSharedTextures()
+{
+	for (mfxU32 i = 0; i < MAX_SHARED_TEXTURES; i++) {
+		SharedTexture *shared = &sharedTextures[i];
+		if (shared->km)
+			shared->km->Release();
+		if (shared->tex)
+			shared->tex->Release();
+		*shared = {};
+	}
+
+	sharedTextureNext = 0;
+}
+
 // Free HW device context
 void CleanupHWDevice()
 {
+	ReleaseSharedTextures();
+
 	if (g_pAdapter) {
 		g_pAdapter->Release();
 		g_pAdapter = NULL;
@@ -423,13 +452,13 @@ mfxStatus simple_unlock(mfxHDL pthis, mfxMemId mid, mfxFrameData *ptr)
 	return MFX_ERR_NONE;
 }
 
-mfxStatus simple_copytex(mfxHDL pthis, mfxMemId mid, mfxU32 tex_handle,
-			 mfxU64 lock_key, mfxU64 *next_key)
+static SharedTexture *GetSharedTexture(mfxU32 tex_handle)
 {
-	pthis; // To suppress warning for this unused parameter
-
-	CustomMemId *memId = (CustomMemId *)mid;
-	ID3D11Texture2D *pSurface = (ID3D11Texture2D *)memId->memId;
+	for (mfxU32 i = 0; i < MAX_SHARED_TEXTURES; i++) {
+		if (sharedTextures[i].tex &&
+		    sharedTextures[i].handle == tex_handle)
+			return &sharedTextures[i];
+	}
 
 	IDXGIKeyedMutex *km;
 	ID3D11Texture2D *input_tex;
@@ -439,17 +468,47 @@ mfxStatus simple_copytex(mfxHDL pthis, mfxMemId mid, mfxU32 tex_handle,
 						IID_ID3D11Texture2D,
 						(void **)&input_tex);
 	if (FAILED(hr)) {
-		return MFX_ERR_INVALID_HANDLE;
+		return NULL;
 	}
 
 	hr = input_tex->QueryInterface(IID_IDXGIKeyedMutex, (void **)&km);
 	if (FAILED(hr)) {
 		input_tex->Release();
-		return MFX_ERR_INVALID_HANDLE;
+		return NULL;
 	}
 
 	input_tex->SetEvictionPriority(DXGI_RESOURCE_PRIORITY_MAXIMUM);
 
+	// replace the oldest entry once all of them are in use
+	SharedTexture *shared = &sharedTextures[sharedTextureNext];
+	sharedTextureNext = (sharedTextureNext + 1) % MAX_SHARED_TEXTURES;
+
+	if (shared->km)
+		shared->km->Release();
+	if (shared->tex)
+		shared->tex->Release();
+
+	shared->handle = tex_handle;
+	shared->tex = input_tex;
+	shared->km = km;
+	return shared;
+}
+
+mfxStatus simple_copytex(mfxHDL pthis, mfxMemId mid, mfxU32 tex_handle,
+			 mfxU64 lock_key, mfxU64 *next_key)
+{
+	pthis; // To suppress warning for this unused parameter
+
+	CustomMemId *memId = (CustomMemId *)mid;
+	ID3D11Texture2D *pSurface = (ID3D11Texture2D *)memId->memId;
+
+	SharedTexture *shared = GetSharedTexture(tex_handle);
+	if (!shared)
+		return MFX_ERR_INVALID_HANDLE;
+
+	IDXGIKeyedMutex *km = shared->km;
+	ID3D11Texture2D *input_tex = shared->tex;
+
 	km->AcquireSync(lock_key, INFINITE);
 
 	D3D11_TEXTURE2D_DESC desc = {0};
@@ -460,9 +519,6 @@ mfxStatus simple_copytex(mfxHDL pthis, mfxMemId mid, mfxU32 tex_handle,
 
 	km->ReleaseSync(*next_key);
 
-	km->Release();
-	input_tex->Release();
-
 	return MFX_ERR_NONE;
 }
 
@@ -186,10 +186,20 @@ struct TextSource {
 	Graphics graphics;
 
 	bool custom_font = false;
+	wstring custom_font_path;
 	PrivateFontCollection private_fonts;
 	InstalledFontCollection installed_fonts;
 
 	unique_ptr<FontFamily> family;
+	unique_ptr<Font> font;
+	HFONT hfont = nullptr;
+	bool font_dirty = true;
+
+	/* the texture is only re-rendered when the settings or the text
+	 * actually changed since the last render */
+	string rendered_settings;
+	wstring rendered_text;
+	bool render_dirty = true;
 
 	bool read_from_file = false;
 	string file;
@@ -244,6 +254,9 @@ struct TextSource {
 
 	inline ~TextSource()
 	{
+		font.reset();
+		if (hfont)
+			DeleteObject(hfont);
 		DeleteDC(hdc);
 
 		if (tex) {
@@ -255,6 +268,7 @@ struct TextSource {
 
 	void UpdateFont();
 	void UpdateCustomFont(const wchar_t *font_path);
+	void CreateRenderFont();
 	void GetStringFormat(StringFormat &format);
 	void RemoveNewlinePadding(Font *font, const StringFormat &format,
 				  RectF &box);
@@ -284,7 +298,11 @@ static time_t get_modified_timestamp(const char *filename)
 
 void TextSource::UpdateCustomFont(const wchar_t *font_path)
 {
-	private_fonts.AddFontFile(font_path);
+	/* the collection keeps every file added to it, so only add it once */
+	if (custom_font_path != font_path) {
+		private_fonts.AddFontFile(font_path);
+		custom_font_path = font_path;
+	}
 
 	family.reset(new FontFamily(face.c_str(), &private_fonts));
 }
@@ -503,25 +521,17 @@ void TextSource::RenderOutlineText(Graphics &graphics, const GraphicsPath &path,
 	warn_stat("graphics.FillPath");
 }
 
-void TextSource::RenderText()
+void TextSource::CreateRenderFont()
 {
-	StringFormat format(StringFormat::GenericTypographic());
-	Status stat;
-
-	RectF box;
-	SIZE size;
-
-	std::unique_ptr<Font> font;
-	HFONT hfont = NULL;
-
 	INT style = (underline ? FontStyleUnderline : 0) |
 		    (strikeout ? FontStyleStrikeout : 0) |
 		    (italic ? FontStyleItalic : 0) | (bold ? FontStyleBold : 0);
 
-	if (text_transform == S_TRANSFORM_UPPERCASE)
-		transform(text.begin(), text.end(), text.begin(), towupper);
-	else if (text_transform == S_TRANSFORM_LOWERCASE)
-		transform(text.begin(), text.end(), text.begin(), towlower);
+	font.reset();
+	if (hfont) {
+		DeleteObject(hfont);
+		hfont = nullptr;
+	}
 
 	/* This has gotten a bit messy. FIXME */
 	if (custom_font)
@@ -549,6 +559,31 @@ void TextSource::RenderText()
 			font.reset(new Font(hdc, hfont));
 	}
 
+	font_dirty = false;
+}
+
+void TextSource::RenderText()
+{
+	StringFormat format(StringFormat::GenericTypographic());
+	Status stat;
+
+	RectF box;
+	SIZE size;
+
+	if (tex && !render_dirty && text == rendered_text)
+		return;
+
+	rendered_text = text;
+	render_dirty = false;
+
+	if (text_transform == S_TRANSFORM_UPPERCASE)
+		transform(text.begin(), text.end(), text.begin(), towupper);
+	else if (text_transform == S_TRANSFORM_LOWERCASE)
+		transform(text.begin(), text.end(), text.begin(), towlower);
+
+	if (font_dirty)
+		CreateRenderFont();
+
 	GetStringFormat(format);
 	CalculateTextSizes(font.get(), format, box, size);
 
@@ -622,8 +657,6 @@ void TextSource::RenderText()
 		gs_texture_set_image(tex, bits.get(), size.cx * 4, false);
 		obs_leave_graphics();
 	}
-
-	DeleteObject(hfont);
 }
 
 const char *TextSource::GetMainString(const char *str)
@@ -742,24 +775,42 @@ inline void TextSource::Update(obs_data_t *s)
 	uint32_t new_bk_color = obs_data_get_uint32(s, S_BKCOLOR);
 	uint32_t new_bk_opacity = obs_data_get_uint32(s, S_BKOPACITY);
 
+	/* ----------------------------- */
+	const char *settings_json = obs_data_get_json(s);
+	if (!settings_json)
+		settings_json = "";
+	if (rendered_settings != settings_json) {
+		rendered_settings = settings_json;
+		render_dirty = true;
+	}
+
 	/* ----------------------------- */
 	wstring new_face = to_wide(font_face);
+	bool new_custom_font = strlen(custom_font_str) != 0;
+	wstring new_font_path = to_wide(custom_font_str);
+
+	if (face != new_face || face_size != font_size || bold != new_bold ||
+	    italic != new_italic || underline != new_underline ||
+	    strikeout != new_strikeout || custom_font != new_custom_font ||
+	    (new_custom_font && custom_font_path != new_font_path))
+		font_dirty = true;
 
 	face = new_face;
+
+	if (font_dirty || !family) {
+		if (new_custom_font)
+			UpdateCustomFont(new_font_path.c_str());
+		else
+			UpdateFont();
+		custom_font = new_custom_font;
+	}
+
 	face_size = font_size;
 	bold = new_bold;
 	italic = new_italic;
 	underline = new_underline;
 	strikeout = new_strikeout;
 
-	if (strlen(custom_font_str) != 0) {
-		custom_font = true;
-		UpdateCustomFont(to_wide(custom_font_str).c_str());
-	} else {
-		UpdateFont();
-		custom_font = false;
-	}
-
 	/* ----------------------------- */
 
 	new_color = rgb_to_bgr(new_color);
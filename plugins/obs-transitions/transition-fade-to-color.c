@@ -132,6 +132,19 @@ static void fade_to_color_callback(void *data, gs_texture_t *a, gs_texture_t *b,
 	gs_enable_framebuffer_srgb(previous);
 }
 
+/* only the outgoing scene is visible before the switch point and only the
+ * incoming one after it */
+static bool fade_to_color_target_needed(void *data,
+					enum obs_transition_target target,
+					float t)
+{
+	struct fade_to_color_info *fade_to_color = data;
+	const bool before_switch = t < fade_to_color->switch_point;
+
+	return target == OBS_TRANSITION_SOURCE_A ? before_switch
+						 : !before_switch;
+}
+
 static void fade_to_color_video_render(void *data, gs_effect_t *effect)
 {
 	UNUSED_PARAMETER(effect);
@@ -139,8 +152,11 @@ static void fade_to_color_video_render(void *data, gs_effect_t *effect)
 	const bool previous = gs_set_linear_srgb(true);
 
 	struct fade_to_color_info *fade_to_color = data;
-	obs_transition_video_render(fade_to_color->source,
-				    fade_to_color_callback);
+	/* the callback never draws the skipped side, so it needs no
+	 * placeholder */
+	obs_transition_video_render3(fade_to_color->source,
+				     fade_to_color_callback, NULL,
+				     fade_to_color_target_needed);
 
 	gs_set_linear_srgb(previous);
 }
@@ -1,5 +1,4 @@
 #include <obs-module.h>
-#include <graphics/image-file.h>
 #include <util/dstr.h>
 
 /* clang-format off */
@@ -25,7 +24,9 @@ struct luma_wipe_info {
 	gs_eparam_t *ep_invert;
 	gs_eparam_t *ep_softness;
 
-	gs_image_file_t luma_image;
+	/* shared with every luma wipe using the same image, decoded in the
+	 * background and only uploaded once the transition first renders */
+	obs_cached_image_t *luma_image;
 	bool invert_luma;
 	float softness;
 	obs_data_t *wipes_list;
@@ -51,16 +52,17 @@ static void luma_wipe_update(void *data, obs_data_t *settings)
 	dstr_cat(&path, name);
 
 	char *file = obs_module_file(path.array);
-
-	obs_enter_graphics();
-	gs_image_file_free(&lwipe->luma_image);
-	obs_leave_graphics();
-
-	gs_image_file_init(&lwipe->luma_image, file);
-
-	obs_enter_graphics();
-	gs_image_file_init_texture(&lwipe->luma_image);
-	obs_leave_graphics();
+	struct obs_video_info ovi = {0};
+	obs_cached_image_t *image;
+
+	/* big images are shrunk to the output size, which is the largest
+	 * they'll ever be drawn at, and the wipe only ever samples the first
+	 * channel */
+	obs_get_video_info(&ovi);
+	image = obs_image_cache_get(file, GS_IMAGE_ALPHA_STRAIGHT,
+				    ovi.base_width, ovi.base_height, GS_R8);
+	obs_cached_image_release(lwipe->luma_image);
+	lwipe->luma_image = image;
 
 	bfree(file);
 	dstr_free(&path);
@@ -116,9 +118,7 @@ static void luma_wipe_destroy(void *data)
 {
 	struct luma_wipe_info *lwipe = data;
 
-	obs_enter_graphics();
-	gs_image_file_free(&lwipe->luma_image);
-	obs_leave_graphics();
+	obs_cached_image_release(lwipe->luma_image);
 
 	obs_data_release(lwipe->wipes_list);
 
@@ -172,7 +172,9 @@ static void luma_wipe_callback(void *data, gs_texture_t *a, gs_texture_t *b,
 
 	gs_effect_set_texture_srgb(lwipe->ep_a_tex, a);
 	gs_effect_set_texture_srgb(lwipe->ep_b_tex, b);
-	gs_effect_set_texture(lwipe->ep_l_tex, lwipe->luma_image.texture);
+	obs_cached_image_wait(lwipe->luma_image);
+	gs_effect_set_texture(lwipe->ep_l_tex,
+			      obs_cached_image_get_texture(lwipe->luma_image));
 	gs_effect_set_float(lwipe->ep_progress, t);
 
 	gs_effect_set_bool(lwipe->ep_invert, lwipe->invert_luma);
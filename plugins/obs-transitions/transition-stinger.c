@@ -64,17 +64,29 @@ static float mix_b_fade_in_out(void *data, float t);
 static float mix_a_cross_fade(void *data, float t);
 static float mix_b_cross_fade(void *data, float t);
 
+/* decodes the media into its frame cache while the transition is idle, so
+ * the transition doesn't have to wait on the file being opened and decoded */
+static void prefetch_media(obs_source_t *media_source)
+{
+	calldata_t cd = {0};
+	proc_handler_t *ph = obs_source_get_proc_handler(media_source);
+	proc_handler_call(ph, "prefetch", &cd);
+	calldata_free(&cd);
+}
+
 static void stinger_update(void *data, obs_data_t *settings)
 {
 	struct stinger_info *s = data;
 	const char *path = obs_data_get_string(settings, "path");
 	bool hw_decode = obs_data_get_bool(settings, "hw_decode");
+	bool preload = obs_data_get_bool(settings, "preload");
 	int64_t volume = obs_data_get_int(settings, "volume");
 
 	obs_data_t *media_settings = obs_data_create();
 	obs_data_set_string(media_settings, "local_file", path);
 	obs_data_set_bool(media_settings, "hw_decode", hw_decode);
 	obs_data_set_bool(media_settings, "looping", false);
+	obs_data_set_bool(media_settings, "caching", preload);
 	obs_data_set_int(media_settings, "volume", volume);
 
 	obs_source_release(s->media_source);
@@ -86,6 +98,9 @@ static void stinger_update(void *data, obs_data_t *settings)
 	dstr_free(&name);
 	obs_data_release(media_settings);
 
+	if (preload)
+		prefetch_media(s->media_source);
+
 	int64_t point = obs_data_get_int(settings, "transition_point");
 
 	s->transition_point_is_frame = obs_data_get_int(settings, "tp_type") ==
@@ -123,6 +138,7 @@ static void stinger_update(void *data, obs_data_t *settings)
 		obs_data_t *tm_media_settings = obs_data_create();
 		obs_data_set_string(tm_media_settings, "local_file", tm_path);
 		obs_data_set_bool(tm_media_settings, "looping", false);
+		obs_data_set_bool(tm_media_settings, "caching", preload);
 
 		s->matte_source = obs_source_create_private(
 			"ffmpeg_source", NULL, tm_media_settings);
@@ -130,6 +146,9 @@ static void stinger_update(void *data, obs_data_t *settings)
 
 		// no need to output sound from the matte video
 		obs_source_set_muted(s->matte_source, true);
+
+		if (preload)
+			prefetch_media(s->matte_source);
 	}
 
 	s->monitoring_type =
@@ -227,6 +246,7 @@ static void stinger_destroy(void *data)
 static void stinger_defaults(obs_data_t *settings)
 {
 	obs_data_set_default_bool(settings, "hw_decode", true);
+	obs_data_set_default_bool(settings, "preload", false);
 	obs_data_set_default_int(settings, "volume", 100);
 }
 
@@ -762,6 +782,10 @@ static obs_properties_t *stinger_properties(void *data)
 		OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT);
 	obs_properties_add_bool(ppts, "hw_decode",
 				obs_module_text("HardwareDecode"));
+	obs_property_t *preload = obs_properties_add_bool(
+		ppts, "preload", obs_module_text("PreloadStinger"));
+	obs_property_set_long_description(
+		preload, obs_module_text("PreloadStinger.ToolTip"));
 	obs_property_list_add_int(p, obs_module_text("TransitionPointTypeTime"),
 				  TIMING_TIME);
 	obs_property_list_add_int(
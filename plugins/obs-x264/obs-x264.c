@@ -60,6 +60,12 @@ struct obs_x264 {
 	size_t extra_data_size;
 	size_t sei_size;
 
+#ifdef X264_MBINFO_CONSTANT
+	/* every macroblock marked constant, handed to x264 for frames libobs
+	 * flags as VIDEO_FRAME_STATIC */
+	uint8_t *static_mb_info;
+#endif
+
 	os_performance_token_t *performance_token;
 };
 
@@ -94,6 +100,9 @@ static void obs_x264_destroy(void *data)
 		os_end_high_performance(obsx264->performance_token);
 		clear_data(obsx264);
 		da_free(obsx264->packet_data);
+#ifdef X264_MBINFO_CONSTANT
+		bfree(obsx264->static_mb_info);
+#endif
 		bfree(obsx264);
 	}
 }
@@ -114,6 +123,7 @@ static void obs_x264_defaults(obs_data_t *settings)
 	obs_data_set_default_string(settings, "profile", "");
 	obs_data_set_default_string(settings, "tune", "");
 	obs_data_set_default_string(settings, "x264opts", "");
+	obs_data_set_default_bool(settings, "topology_threads", false);
 	obs_data_set_default_bool(settings, "repeat_headers", false);
 }
 
@@ -137,6 +147,7 @@ static inline void add_strings(obs_property_t *list, const char *const *strings)
 #define TEXT_TUNE obs_module_text("Tune")
 #define TEXT_NONE obs_module_text("None")
 #define TEXT_X264_OPTS obs_module_text("EncoderOptions")
+#define TEXT_TOPOLOGY_THREADS obs_module_text("TopologyThreads")
 
 static bool use_bufsize_modified(obs_properties_t *ppts, obs_property_t *p,
 				 obs_data_t *settings)
@@ -227,6 +238,9 @@ static obs_properties_t *obs_x264_props(void *unused)
 	obs_properties_add_bool(props, "vfr", TEXT_VFR);
 #endif
 
+	obs_properties_add_bool(props, "topology_threads",
+				TEXT_TOPOLOGY_THREADS);
+
 	obs_properties_add_text(props, "x264opts", TEXT_X264_OPTS,
 				OBS_TEXT_DEFAULT);
 
@@ -388,6 +402,39 @@ enum rate_control {
 	RATE_CONTROL_CRF
 };
 
+/* x264 sizes its thread pool from the logical core count, which on hybrid
+ * CPUs puts frame threads on efficiency cores that every other frame thread
+ * then ends up waiting on.  size it from the performance cores instead,
+ * leaving one for the graphics thread.  custom x264 options still apply on
+ * top of this. */
+static void set_topology_threads(struct obs_x264 *obsx264)
+{
+	int perf = os_get_performance_cores();
+	int physical = os_get_physical_cores();
+	int cores;
+	int threads;
+
+	if (perf <= 0)
+		return;
+
+	cores = perf > 2 ? perf - 1 : perf;
+
+	/* sliced threads (zerolatency) add a slice per thread, so keep them to
+	 * one per core.  frame threads follow x264's own 1.5x rule. */
+	if (obsx264->params.b_sliced_threads)
+		threads = cores;
+	else
+		threads = cores + cores / 2;
+
+	obsx264->params.i_threads = threads;
+	obsx264->params.i_lookahead_threads = threads >= 6 ? threads / 6 : 1;
+
+	info("topology threads: %d (%d performance of %d physical cores), "
+	     "lookahead threads: %d, sliced: %s",
+	     threads, perf, physical, obsx264->params.i_lookahead_threads,
+	     obsx264->params.b_sliced_threads ? "yes" : "no");
+}
+
 static void update_params(struct obs_x264 *obsx264, obs_data_t *settings,
 			  const struct obs_options *options, bool update)
 {
@@ -474,6 +521,10 @@ static void update_params(struct obs_x264 *obsx264, obs_data_t *settings,
 	if (obs_data_has_user_value(settings, "bf"))
 		obsx264->params.i_bframe = bf;
 
+	/* the thread count can't be changed once the encoder is open */
+	if (!update && obs_data_get_bool(settings, "topology_threads"))
+		set_topology_threads(obsx264);
+
 	static const char *const smpte170m = "smpte170m";
 	static const char *const bt709 = "bt709";
 	const char *colorprim = bt709;
@@ -718,6 +769,9 @@ static void *obs_x264_create(obs_data_t *settings, obs_encoder_t *encoder)
 	obsx264->encoder = encoder;
 
 	if (update_settings(obsx264, settings, false)) {
+#ifdef X264_MBINFO_CONSTANT
+		obsx264->params.analyse.b_mb_info = 1;
+#endif
 		obsx264->context = x264_encoder_open(&obsx264->params);
 
 		if (obsx264->context == NULL)
@@ -733,6 +787,13 @@ static void *obs_x264_create(obs_data_t *settings, obs_encoder_t *encoder)
 		return NULL;
 	}
 
+#ifdef X264_MBINFO_CONSTANT
+	size_t mb_count = (size_t)((obsx264->params.i_width + 15) / 16) *
+			  (size_t)((obsx264->params.i_height + 15) / 16);
+	obsx264->static_mb_info = bmalloc(mb_count);
+	memset(obsx264->static_mb_info, X264_MBINFO_CONSTANT, mb_count);
+#endif
+
 	obsx264->performance_token =
 		os_request_high_performance("x264 encoding");
 
@@ -770,6 +831,23 @@ static inline void init_pic_data(struct obs_x264 *obsx264, x264_picture_t *pic,
 	pic->i_pts = frame->pts;
 	pic->img.i_csp = obsx264->params.i_csp;
 
+	/* libobs knows about cuts before x264's own scenecut detection does,
+	 * but leave it alone if the user turned scenecut off */
+	if ((frame->flags & VIDEO_FRAME_SCENE_CUT) &&
+	    obsx264->params.i_scenecut_threshold)
+		pic->i_type = X264_TYPE_I;
+
+	if (frame->flags & VIDEO_FRAME_KEYFRAME)
+		pic->i_type = X264_TYPE_IDR;
+
+#ifdef X264_MBINFO_CONSTANT
+	/* nothing changed since the last frame, so let x264 skip its analysis
+	 * and code it as cheap skip blocks.  the frame is still encoded rather
+	 * than dropped to keep the frame rate and keyframe interval intact. */
+	if ((frame->flags & VIDEO_FRAME_STATIC) && obsx264->static_mb_info)
+		pic->prop.mb_info = obsx264->static_mb_info;
+#endif
+
 	if (obsx264->params.i_csp == X264_CSP_NV12)
 		pic->img.i_plane = 2;
 	else if (obsx264->params.i_csp == X264_CSP_I420)
@@ -871,5 +949,9 @@ struct obs_encoder_info obs_x264_encoder = {
 	.get_extra_data = obs_x264_extra_data,
 	.get_sei_data = obs_x264_sei,
 	.get_video_info = obs_x264_video_info,
+#ifdef X264_MBINFO_CONSTANT
+	.caps = OBS_ENCODER_CAP_DYN_BITRATE | OBS_ENCODER_CAP_STATIC_FRAMES,
+#else
 	.caps = OBS_ENCODER_CAP_DYN_BITRATE,
+#endif
 };
@@ -1,4 +1,6 @@
 #include <util/platform.h>
+#include <util/threading.h>
+#include <util/darray.h>
 #include <util/dstr.h>
 #include <obs-module.h>
 #include <jansson.h>
@@ -32,13 +34,38 @@ static const char *rtmp_common_getname(void *unused)
 	return obs_module_text("StreamingServices");
 }
 
+/* services.json is parsed once and shared by every service and properties
+ * view, with the service names (including alternate names) sorted for
+ * lookups.  When the file updater refreshes the file it's parsed again on
+ * the updater thread and swapped in.  Anyone still holding the previous
+ * catalog keeps it alive until they release it. */
+struct service_name {
+	const char *name;
+	json_t *service;
+	/* current name of the service if name is an alternate name */
+	const char *new_name;
+	size_t order;
+};
+
+struct services_catalog {
+	volatile long refs;
+	json_t *services;
+	DARRAY(struct service_name) names;
+};
+
+static pthread_mutex_t catalog_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct services_catalog *cur_catalog = NULL;
+
 static json_t *open_services_file(void);
-static inline json_t *find_service(json_t *root, const char *name,
-				   const char **p_new_name);
+static json_t *find_service(struct services_catalog *catalog,
+			    const char *name, const char **p_new_name);
 static inline bool get_bool_val(json_t *service, const char *key);
 static inline const char *get_string_val(json_t *service, const char *key);
 static inline int get_int_val(json_t *service, const char *key);
 
+static struct services_catalog *get_services_catalog(void);
+static void release_services_catalog(struct services_catalog *catalog);
+
 extern void twitch_ingests_refresh(int seconds);
 
 static void ensure_valid_url(struct rtmp_common *service, json_t *json,
@@ -132,10 +159,11 @@ static void rtmp_common_update(void *data, obs_data_t *settings)
 	service->supported_resolutions_count = 0;
 	service->max_fps = 0;
 
-	json_t *root = open_services_file();
-	if (root) {
+	struct services_catalog *catalog = get_services_catalog();
+	if (catalog) {
 		const char *new_name;
-		json_t *serv = find_service(root, service->service, &new_name);
+		json_t *serv =
+			find_service(catalog, service->service, &new_name);
 
 		if (new_name) {
 			bfree(service->service);
@@ -153,7 +181,7 @@ static void rtmp_common_update(void *data, obs_data_t *settings)
 			ensure_valid_url(service, serv, settings);
 		}
 	}
-	json_decref(root);
+	release_services_catalog(catalog);
 
 	if (!service->output)
 		service->output = bstrdup("rtmp_output");
@@ -245,9 +273,11 @@ static void add_service(obs_property_t *list, json_t *service, bool show_all,
 	obs_property_list_add_string(list, name, name);
 }
 
-static void add_services(obs_property_t *list, json_t *root, bool show_all,
+static void add_services(obs_property_t *list,
+			 struct services_catalog *catalog, bool show_all,
 			 const char *cur_service)
 {
+	json_t *root = catalog->services;
 	json_t *service;
 	size_t index;
 
@@ -261,7 +291,7 @@ static void add_services(obs_property_t *list, json_t *root, bool show_all,
 		add_service(list, service, show_all, cur_service);
 	}
 
-	service = find_service(root, cur_service, NULL);
+	service = find_service(catalog, cur_service, NULL);
 	if (!service && cur_service && *cur_service) {
 		obs_property_list_insert_string(list, 0, cur_service,
 						cur_service);
@@ -338,18 +368,137 @@ static json_t *open_services_file(void)
 	return root;
 }
 
-static void build_service_list(obs_property_t *list, json_t *root,
-			       bool show_all, const char *cur_service)
+static int cmp_service_name(const void *a, const void *b)
+{
+	const struct service_name *name_a = a;
+	const struct service_name *name_b = b;
+	int cmp = strcmp(name_a->name, name_b->name);
+
+	if (cmp != 0)
+		return cmp;
+	if (name_a->order == name_b->order)
+		return 0;
+	return name_a->order < name_b->order ? -1 : 1;
+}
+
+static inline void add_service_name(struct services_catalog *catalog,
+				    const char *name, json_t *service,
+				    const char *new_name)
+{
+	struct service_name *item = da_push_back_new(catalog->names);
+	item->name = name;
+	item->service = service;
+	item->new_name = new_name;
+	item->order = catalog->names.num - 1;
+}
+
+static struct services_catalog *create_services_catalog(json_t *services)
+{
+	struct services_catalog *catalog = bzalloc(sizeof(*catalog));
+	json_t *service;
+	size_t index;
+
+	catalog->refs = 1;
+	catalog->services = services;
+
+	json_array_foreach (services, index, service) {
+		const char *cur_name = get_string_val(service, "name");
+		json_t *alt_names = json_object_get(service, "alt_names");
+		size_t alt_name_idx;
+		json_t *alt_name_obj;
+
+		if (!cur_name)
+			continue;
+
+		add_service_name(catalog, cur_name, service, NULL);
+
+		json_array_foreach (alt_names, alt_name_idx, alt_name_obj) {
+			const char *alt_name = json_string_value(alt_name_obj);
+			if (alt_name)
+				add_service_name(catalog, alt_name, service,
+						 cur_name);
+		}
+	}
+
+	qsort(catalog->names.array, catalog->names.num,
+	      sizeof(struct service_name), cmp_service_name);
+
+	/* the first service listed with a name wins, same as searching the
+	 * list in order */
+	for (size_t i = catalog->names.num; i > 1; i--) {
+		if (strcmp(catalog->names.array[i - 1].name,
+			   catalog->names.array[i - 2].name) == 0)
+			da_erase(catalog->names, i - 1);
+	}
+
+	return catalog;
+}
+
+static void release_services_catalog(struct services_catalog *catalog)
+{
+	if (!catalog || os_atomic_dec_long(&catalog->refs) > 0)
+		return;
+
+	json_decref(catalog->services);
+	da_free(catalog->names);
+	bfree(catalog);
+}
+
+static struct services_catalog *get_services_catalog(void)
+{
+	struct services_catalog *catalog;
+
+	pthread_mutex_lock(&catalog_mutex);
+
+	if (!cur_catalog) {
+		json_t *services = open_services_file();
+		if (services)
+			cur_catalog = create_services_catalog(services);
+	}
+
+	catalog = cur_catalog;
+	if (catalog)
+		os_atomic_inc_long(&catalog->refs);
+
+	pthread_mutex_unlock(&catalog_mutex);
+	return catalog;
+}
+
+static void set_services_catalog(struct services_catalog *catalog)
+{
+	struct services_catalog *prev;
+
+	pthread_mutex_lock(&catalog_mutex);
+	prev = cur_catalog;
+	cur_catalog = catalog;
+	pthread_mutex_unlock(&catalog_mutex);
+
+	release_services_catalog(prev);
+}
+
+void reload_services_catalog(void)
+{
+	json_t *services = open_services_file();
+	if (services)
+		set_services_catalog(create_services_catalog(services));
+}
+
+void unload_services_catalog(void)
+{
+	set_services_catalog(NULL);
+}
+
+static void build_service_list(obs_property_t *list,
+			       struct services_catalog *catalog, bool show_all,
+			       const char *cur_service)
 {
 	obs_property_list_clear(list);
-	add_services(list, root, show_all, cur_service);
+	add_services(list, catalog, show_all, cur_service);
 }
 
 static void properties_data_destroy(void *data)
 {
-	json_t *root = data;
-	if (root)
-		json_decref(root);
+	release_services_catalog(data);
 }
 
 static bool fill_twitch_servers_locked(obs_property_t *servers_prop)
@@ -439,51 +588,44 @@ static void fill_stream_key_link(json_t *service, obs_data_t *settings)
 				    stream_key_link);
 }
 
-static inline json_t *find_service(json_t *root, const char *name,
-				   const char **p_new_name)
+static int cmp_find_service_name(const void *key, const void *item)
 {
-	size_t index;
-	json_t *service;
+	const struct service_name *service_name = item;
+	return strcmp(key, service_name->name);
+}
+
+static json_t *find_service(struct services_catalog *catalog,
+			    const char *name, const char **p_new_name)
+{
+	struct service_name *item;
 
 	if (p_new_name)
 		*p_new_name = NULL;
+	if (!catalog || !name)
+		return NULL;
 
-	json_array_foreach (root, index, service) {
-		const char *cur_name = get_string_val(service, "name");
-
-		if (strcmp(name, cur_name) == 0)
-			return service;
-
-		/* check for alternate names */
-		json_t *alt_names = json_object_get(service, "alt_names");
-		size_t alt_name_idx;
-		json_t *alt_name_obj;
-
-		json_array_foreach (alt_names, alt_name_idx, alt_name_obj) {
-			const char *alt_name = json_string_value(alt_name_obj);
-			if (alt_name && strcmp(name, alt_name) == 0) {
-				if (p_new_name)
-					*p_new_name = cur_name;
-				return service;
-			}
-		}
-	}
+	item = bsearch(name, catalog->names.array, catalog->names.num,
+		       sizeof(struct service_name), cmp_find_service_name);
+	if (!item)
+		return NULL;
 
-	return NULL;
+	if (p_new_name)
+		*p_new_name = item->new_name;
+	return item->service;
 }
 
 static bool service_selected(obs_properties_t *props, obs_property_t *p,
 			     obs_data_t *settings)
 {
 	const char *name = obs_data_get_string(settings, "service");
-	json_t *root = obs_properties_get_param(props);
+	struct services_catalog *catalog = obs_properties_get_param(props);
 	json_t *service;
 	const char *new_name;
 
 	if (!name || !*name)
 		return false;
 
-	service = find_service(root, name, &new_name);
+	service = find_service(catalog, name, &new_name);
 	if (!service) {
 		const char *server = obs_data_get_string(settings, "server");
 
@@ -512,12 +654,12 @@ static bool show_all_services_toggled(obs_properties_t *ppts, obs_property_t *p,
 	const char *cur_service = obs_data_get_string(settings, "service");
 	bool show_all = obs_data_get_bool(settings, "show_all");
 
-	json_t *root = obs_properties_get_param(ppts);
-	if (!root)
+	struct services_catalog *catalog = obs_properties_get_param(ppts);
+	if (!catalog)
 		return false;
 
-	build_service_list(obs_properties_get(ppts, "service"), root, show_all,
-			   cur_service);
+	build_service_list(obs_properties_get(ppts, "service"), catalog,
+			   show_all, cur_service);
 
 	UNUSED_PARAMETER(p);
 	return true;
@@ -529,11 +671,12 @@ static obs_properties_t *rtmp_common_properties(void *unused)
 
 	obs_properties_t *ppts = obs_properties_create();
 	obs_property_t *p;
-	json_t *root;
+	struct services_catalog *catalog;
 
-	root = open_services_file();
-	if (root)
-		obs_properties_set_param(ppts, root, properties_data_destroy);
+	catalog = get_services_catalog();
+	if (catalog)
+		obs_properties_set_param(ppts, catalog,
+					 properties_data_destroy);
 
 	p = obs_properties_add_list(ppts, "service", obs_module_text("Service"),
 				    OBS_COMBO_TYPE_LIST,
@@ -628,11 +771,12 @@ static void apply_audio_encoder_settings(obs_data_t *settings,
 	}
 }
 
-static void initialize_output(struct rtmp_common *service, json_t *root,
+static void initialize_output(struct rtmp_common *service,
+			      struct services_catalog *catalog,
 			      obs_data_t *video_settings,
 			      obs_data_t *audio_settings)
 {
-	json_t *json_service = find_service(root, service->service, NULL);
+	json_t *json_service = find_service(catalog, service->service, NULL);
 	json_t *recommended;
 
 	if (!json_service) {
@@ -658,12 +802,12 @@ static void rtmp_common_apply_settings(void *data, obs_data_t *video_settings,
 				       obs_data_t *audio_settings)
 {
 	struct rtmp_common *service = data;
-	json_t *root = open_services_file();
+	struct services_catalog *catalog = get_services_catalog();
 
-	if (root) {
-		initialize_output(service, root, video_settings,
+	if (catalog) {
+		initialize_output(service, catalog, video_settings,
 				  audio_settings);
-		json_decref(root);
+		release_services_catalog(catalog);
 	}
 }
 
@@ -813,13 +957,13 @@ static void rtmp_common_get_max_bitrate(void *data, int *video_bitrate,
 					int *audio_bitrate)
 {
 	struct rtmp_common *service = data;
-	json_t *root = open_services_file();
+	struct services_catalog *catalog = get_services_catalog();
 	json_t *item;
 
-	if (!root)
+	if (!catalog)
 		return;
 
-	json_t *json_service = find_service(root, service->service, NULL);
+	json_t *json_service = find_service(catalog, service->service, NULL);
 	if (!json_service) {
 		goto fail;
 	}
@@ -852,7 +996,7 @@ static void rtmp_common_get_max_bitrate(void *data, int *video_bitrate,
 	}
 
 fail:
-	json_decref(root);
+	release_services_catalog(catalog);
 }
 
 static const char **rtmp_common_get_supported_video_codecs(void *data)
@@ -863,11 +1007,11 @@ static const char **rtmp_common_get_supported_video_codecs(void *data)
 		return (const char **)service->video_codecs;
 
 	struct dstr codecs = {0};
-	json_t *root = open_services_file();
-	if (!root)
+	struct services_catalog *catalog = get_services_catalog();
+	if (!catalog)
 		return NULL;
 
-	json_t *json_service = find_service(root, service->service, NULL);
+	json_t *json_service = find_service(catalog, service->service, NULL);
 	if (!json_service) {
 		goto fail;
 	}
@@ -895,7 +1039,7 @@ static const char **rtmp_common_get_supported_video_codecs(void *data)
 	dstr_free(&codecs);
 
 fail:
-	json_decref(root);
+	release_services_catalog(catalog);
 	return (const char **)service->video_codecs;
 }
 
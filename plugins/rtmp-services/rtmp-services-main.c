@@ -24,6 +24,9 @@ MODULE_EXPORT const char *obs_module_description(void)
 extern struct obs_service_info rtmp_common_service;
 extern struct obs_service_info rtmp_custom_service;
 
+extern void reload_services_catalog(void);
+extern void unload_services_catalog(void);
+
 static update_info_t *update_info = NULL;
 static struct dstr module_name = {0};
 
@@ -53,6 +56,13 @@ static bool confirm_service_file(void *param, struct file_download_data *file)
 	return true;
 }
 
+static void services_updated(void *param)
+{
+	reload_services_catalog();
+
+	UNUSED_PARAMETER(param);
+}
+
 extern void init_twitch_data(void);
 extern void load_twitch_data(void);
 extern void unload_twitch_data(void);
@@ -92,10 +102,10 @@ bool obs_module_load(void)
 		 RTMP_SERVICES_FORMAT_VERSION);
 
 	if (cache_dir) {
-		update_info = update_info_create(RTMP_SERVICES_LOG_STR,
-						 module_name.array, update_url,
-						 local_dir, cache_dir,
-						 confirm_service_file, NULL);
+		update_info = update_info_create_with_finished_callback(
+			RTMP_SERVICES_LOG_STR, module_name.array, update_url,
+			local_dir, cache_dir, confirm_service_file,
+			services_updated, NULL);
 	}
 
 	load_twitch_data();
@@ -112,6 +122,7 @@ bool obs_module_load(void)
 void obs_module_unload(void)
 {
 	update_info_destroy(update_info);
+	unload_services_catalog();
 	unload_twitch_data();
 	free_showroom_data();
 	unload_dacast_data();
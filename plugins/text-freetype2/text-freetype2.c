@@ -17,6 +17,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <obs-module.h>
 #include <util/platform.h>
+#include <util/dstr.h>
 #include <ft2build.h>
 #include FT_FREETYPE_H
 #include <sys/stat.h>
@@ -104,6 +105,8 @@ bool obs_module_load()
 		bfree(config_dir);
 	}
 
+	init_glyph_atlases();
+
 	obs_register_source(&freetype2_source_info_v1);
 	obs_register_source(&freetype2_source_info_v2);
 
@@ -116,6 +119,8 @@ void obs_module_unload(void)
 		free_os_font_list();
 		FT_Done_FreeType(ft2_lib);
 	}
+
+	free_glyph_atlases();
 }
 
 static const char *ft2_source_get_name(void *unused)
@@ -201,12 +206,8 @@ static void ft2_source_destroy(void *data)
 		srcdata->font_face = NULL;
 	}
 
-	for (uint32_t i = 0; i < num_cache_slots; i++) {
-		if (srcdata->cacheglyphs[i] != NULL) {
-			bfree(srcdata->cacheglyphs[i]);
-			srcdata->cacheglyphs[i] = NULL;
-		}
-	}
+	glyph_atlas_release(srcdata->atlas);
+	srcdata->atlas = NULL;
 
 	if (srcdata->font_name != NULL)
 		bfree(srcdata->font_name);
@@ -214,8 +215,6 @@ static void ft2_source_destroy(void *data)
 		bfree(srcdata->font_style);
 	if (srcdata->text != NULL)
 		bfree(srcdata->text);
-	if (srcdata->texbuf != NULL)
-		bfree(srcdata->texbuf);
 	if (srcdata->colorbuf != NULL)
 		bfree(srcdata->colorbuf);
 	if (srcdata->text_file != NULL)
@@ -223,10 +222,6 @@ static void ft2_source_destroy(void *data)
 
 	obs_enter_graphics();
 
-	if (srcdata->tex != NULL) {
-		gs_texture_destroy(srcdata->tex);
-		srcdata->tex = NULL;
-	}
 	if (srcdata->vbuf != NULL) {
 		gs_vertexbuffer_destroy(srcdata->vbuf);
 		srcdata->vbuf = NULL;
@@ -247,7 +242,8 @@ static void ft2_source_render(void *data, gs_effect_t *effect)
 	if (srcdata == NULL)
 		return;
 
-	if (srcdata->tex == NULL || srcdata->vbuf == NULL)
+	if (srcdata->atlas == NULL || srcdata->atlas->tex == NULL ||
+	    srcdata->vbuf == NULL)
 		return;
 	if (srcdata->text == NULL || *srcdata->text == 0)
 		return;
@@ -258,7 +254,8 @@ static void ft2_source_render(void *data, gs_effect_t *effect)
 	if (srcdata->drop_shadow)
 		draw_drop_shadow(srcdata);
 
-	draw_uv_vbuffer(srcdata->vbuf, srcdata->tex, srcdata->draw_effect,
+	draw_uv_vbuffer(srcdata->vbuf, srcdata->atlas->tex,
+			srcdata->draw_effect,
 			(uint32_t)wcslen(srcdata->text) * 6);
 
 	UNUSED_PARAMETER(effect);
@@ -296,28 +293,59 @@ static void ft2_video_tick(void *data, float seconds)
 	UNUSED_PARAMETER(seconds);
 }
 
+static void release_font(struct ft2_source *srcdata)
+{
+	if (srcdata->font_face != NULL) {
+		FT_Done_Face(srcdata->font_face);
+		srcdata->font_face = NULL;
+	}
+
+	glyph_atlas_release(srcdata->atlas);
+	srcdata->atlas = NULL;
+}
+
 static bool init_font(struct ft2_source *srcdata, const char *custom_font)
 {
+	const char *path = custom_font;
+	FT_Long index = 0;
+	struct dstr key = {0};
+	bool success = true;
+
 	if (!custom_font || strcmp(custom_font, "") == 0) {
-		FT_Long index;
-		const char *path = get_font_path(srcdata->font_name,
-						 srcdata->font_size,
-						 srcdata->font_style,
-						 srcdata->font_flags, &index);
-		if (!path)
+		path = get_font_path(srcdata->font_name, srcdata->font_size,
+				     srcdata->font_style, srcdata->font_flags,
+				     &index);
+		if (!path) {
+			release_font(srcdata);
 			return false;
-
-		if (srcdata->font_face != NULL) {
-			FT_Done_Face(srcdata->font_face);
-			srcdata->font_face = NULL;
 		}
+	}
 
-		return FT_New_Face(ft2_lib, path, index, &srcdata->font_face) ==
-		       0;
-	} else {
-		return FT_New_Face(ft2_lib, custom_font, 0,
-				   &srcdata->font_face) == 0;
+	dstr_printf(&key, "%s|%ld|%u|%d", path, (long)index,
+		    (unsigned)srcdata->font_size, (int)srcdata->antialiasing);
+
+	/* the same face at the same size is already loaded and its glyphs
+	 * are already in the atlas, so there's nothing to do */
+	if (srcdata->font_face && srcdata->atlas &&
+	    strcmp(srcdata->atlas->key, key.array) == 0)
+		goto done;
+
+	release_font(srcdata);
+
+	if (FT_New_Face(ft2_lib, path, index, &srcdata->font_face) != 0) {
+		srcdata->font_face = NULL;
+		success = false;
+		goto done;
 	}
+
+	FT_Set_Pixel_Sizes(srcdata->font_face, 0, srcdata->font_size);
+	FT_Select_Charmap(srcdata->font_face, FT_ENCODING_UNICODE);
+
+	srcdata->atlas = glyph_atlas_acquire(key.array);
+
+done:
+	dstr_free(&key);
+	return success;
 }
 
 static void ft2_source_update(void *data, obs_data_t *settings)
@@ -389,8 +417,6 @@ static void ft2_source_update(void *data, obs_data_t *settings)
 	if (ft2_lib == NULL)
 		goto error;
 
-	const size_t texbuf_size = (size_t)texbuf_w * (size_t)texbuf_h;
-
 	if (srcdata->draw_effect == NULL) {
 		char *effect_file = NULL;
 		char *error_string = NULL;
@@ -412,15 +438,7 @@ static void ft2_source_update(void *data, obs_data_t *settings)
 	if (srcdata->font_size != font_size || srcdata->from_file != from_file)
 		vbuf_needs_update = true;
 
-	const bool new_aa_setting = obs_data_get_bool(settings, "antialiasing");
-	const bool aa_changed = srcdata->antialiasing != new_aa_setting;
-	if (aa_changed) {
-		srcdata->antialiasing = new_aa_setting;
-		if (srcdata->texbuf != NULL) {
-			memset(srcdata->texbuf, 0, texbuf_size);
-		}
-		cache_standard_glyphs(srcdata);
-	}
+	srcdata->antialiasing = obs_data_get_bool(settings, "antialiasing");
 
 	srcdata->file_load_failed = false;
 	srcdata->from_file = from_file;
@@ -443,16 +461,7 @@ static void ft2_source_update(void *data, obs_data_t *settings)
 		blog(LOG_WARNING, "FT2-text: Failed to load font %s",
 		     srcdata->font_name);
 		goto error;
-	} else {
-		FT_Set_Pixel_Sizes(srcdata->font_face, 0, srcdata->font_size);
-		FT_Select_Charmap(srcdata->font_face, FT_ENCODING_UNICODE);
-	}
-
-	if (srcdata->texbuf != NULL) {
-		bfree(srcdata->texbuf);
-		srcdata->texbuf = NULL;
 	}
-	srcdata->texbuf = bzalloc(texbuf_size);
 
 	if (srcdata->font_face)
 		cache_standard_glyphs(srcdata);
@@ -21,7 +21,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <ft2build.h>
 
 #define num_cache_slots 65535
-#define src_glyph srcdata->cacheglyphs[glyph_index]
+#define src_glyph srcdata->atlas->glyphs[glyph_index]
 
 struct glyph_info {
 	float u, v, u2, v2;
@@ -29,6 +29,22 @@ struct glyph_info {
 	int32_t xadv;
 };
 
+/* Glyphs are rasterized once per font file, face index, size and render
+ * mode, and the atlas is shared by every source using that combination.
+ * Glyphs are never evicted while the atlas lives, so the texture and glyph
+ * pointers stay valid for as long as a source holds a reference. */
+struct glyph_atlas {
+	char *key;
+	long refs;
+
+	struct glyph_info *glyphs[num_cache_slots];
+	uint8_t *texbuf;
+	uint32_t texbuf_x, texbuf_y, row_h;
+	gs_texture_t *tex;
+
+	struct glyph_atlas *next;
+};
+
 struct ft2_source {
 	char *font_name;
 	char *font_style;
@@ -46,20 +62,16 @@ struct ft2_source {
 
 	uint32_t cx, cy, max_h, custom_width;
 	uint32_t outline_width;
-	uint32_t texbuf_x, texbuf_y;
 	uint32_t color[2];
 	uint32_t *colorbuf;
 
 	int32_t cur_scroll, scroll_speed;
 
-	gs_texture_t *tex;
-
-	struct glyph_info *cacheglyphs[num_cache_slots];
-
+	struct glyph_atlas *atlas;
 	FT_Face font_face;
 
-	uint8_t *texbuf;
 	gs_vertbuffer_t *vbuf;
+	uint32_t vbuf_glyphs;
 
 	gs_effect_t *draw_effect;
 	bool outline_text, drop_shadow;
@@ -98,6 +110,11 @@ time_t get_modified_timestamp(char *filename);
 void load_text_from_file(struct ft2_source *srcdata, const char *filename);
 void read_from_end(struct ft2_source *srcdata, const char *filename);
 
+void init_glyph_atlases(void);
+void free_glyph_atlases(void);
+struct glyph_atlas *glyph_atlas_acquire(const char *key);
+void glyph_atlas_release(struct glyph_atlas *atlas);
+
 void cache_standard_glyphs(struct ft2_source *srcdata);
 void cache_glyphs(struct ft2_source *srcdata, wchar_t *cache_glyphs);
 
@@ -17,6 +17,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <obs-module.h>
 #include <util/platform.h>
+#include <util/threading.h>
 #include <ft2build.h>
 #include FT_FREETYPE_H
 #include <sys/stat.h>
@@ -28,6 +29,79 @@ float offsets[16] = {-2.0f, 0.0f, 0.0f, -2.0f, 2.0f,  0.0f, 2.0f,  0.0f,
 
 extern uint32_t texbuf_w, texbuf_h;
 
+static pthread_mutex_t atlas_mutex;
+static struct glyph_atlas *first_atlas = NULL;
+
+void init_glyph_atlases(void)
+{
+	pthread_mutex_init(&atlas_mutex, NULL);
+}
+
+void free_glyph_atlases(void)
+{
+	pthread_mutex_destroy(&atlas_mutex);
+}
+
+struct glyph_atlas *glyph_atlas_acquire(const char *key)
+{
+	struct glyph_atlas *atlas;
+
+	pthread_mutex_lock(&atlas_mutex);
+
+	for (atlas = first_atlas; atlas; atlas = atlas->next) {
+		if (strcmp(atlas->key, key) == 0) {
+			atlas->refs++;
+			pthread_mutex_unlock(&atlas_mutex);
+			return atlas;
+		}
+	}
+
+	atlas = bzalloc(sizeof(struct glyph_atlas));
+	atlas->key = bstrdup(key);
+	atlas->refs = 1;
+	atlas->texbuf = bzalloc((size_t)texbuf_w * (size_t)texbuf_h);
+	atlas->next = first_atlas;
+	first_atlas = atlas;
+
+	pthread_mutex_unlock(&atlas_mutex);
+	return atlas;
+}
+
+void glyph_atlas_release(struct glyph_atlas *atlas)
+{
+	struct glyph_atlas **prev;
+
+	if (!atlas)
+		return;
+
+	pthread_mutex_lock(&atlas_mutex);
+	if (--atlas->refs > 0) {
+		pthread_mutex_unlock(&atlas_mutex);
+		return;
+	}
+
+	for (prev = &first_atlas; *prev; prev = &(*prev)->next) {
+		if (*prev == atlas) {
+			*prev = atlas->next;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&atlas_mutex);
+
+	for (uint32_t i = 0; i < num_cache_slots; i++)
+		bfree(atlas->glyphs[i]);
+
+	if (atlas->tex) {
+		obs_enter_graphics();
+		gs_texture_destroy(atlas->tex);
+		obs_leave_graphics();
+	}
+
+	bfree(atlas->texbuf);
+	bfree(atlas->key);
+	bfree(atlas);
+}
+
 void draw_outlines(struct ft2_source *srcdata)
 {
 	// Horrible (hopefully temporary) solution for outlines.
@@ -45,7 +119,7 @@ void draw_outlines(struct ft2_source *srcdata)
 	for (int32_t i = 0; i < 8; i++) {
 		gs_matrix_translate3f(offsets[i * 2], offsets[(i * 2) + 1],
 				      0.0f);
-		draw_uv_vbuffer(srcdata->vbuf, srcdata->tex,
+		draw_uv_vbuffer(srcdata->vbuf, srcdata->atlas->tex,
 				srcdata->draw_effect,
 				(uint32_t)wcslen(srcdata->text) * 6);
 	}
@@ -70,7 +144,8 @@ void draw_drop_shadow(struct ft2_source *srcdata)
 
 	gs_matrix_push();
 	gs_matrix_translate3f(4.0f, 4.0f, 0.0f);
-	draw_uv_vbuffer(srcdata->vbuf, srcdata->tex, srcdata->draw_effect,
+	draw_uv_vbuffer(srcdata->vbuf, srcdata->atlas->tex,
+			srcdata->draw_effect,
 			(uint32_t)wcslen(srcdata->text) * 6);
 	gs_matrix_identity();
 	gs_matrix_pop();
@@ -84,7 +159,7 @@ void set_up_vertex_buffer(struct ft2_source *srcdata)
 	uint32_t x = 0, space_pos = 0, word_width = 0;
 	size_t len;
 
-	if (!srcdata->text)
+	if (!srcdata->text || !srcdata->atlas)
 		return;
 
 	if (srcdata->custom_width >= 100)
@@ -93,28 +168,40 @@ void set_up_vertex_buffer(struct ft2_source *srcdata)
 		srcdata->cx = get_ft2_text_width(srcdata->text, srcdata);
 	srcdata->cy = srcdata->max_h;
 
+	if (*srcdata->text == 0)
+		return;
+
+	/* the buffer is only recreated when the text outgrows it, otherwise
+	 * the vertices are rewritten in place and uploaded on the next draw */
+	len = wcslen(srcdata->text);
+
 	obs_enter_graphics();
-	if (srcdata->vbuf != NULL) {
-		gs_vertbuffer_t *tmpvbuf = srcdata->vbuf;
-		srcdata->vbuf = NULL;
-		gs_vertexbuffer_destroy(tmpvbuf);
+	if (srcdata->vbuf == NULL || len > srcdata->vbuf_glyphs) {
+		if (srcdata->vbuf != NULL)
+			gs_vertexbuffer_destroy(srcdata->vbuf);
+
+		srcdata->vbuf_glyphs = (uint32_t)len;
+		srcdata->vbuf = create_uv_vbuffer(srcdata->vbuf_glyphs * 6,
+						  true);
+
+		bfree(srcdata->colorbuf);
+		srcdata->colorbuf =
+			bmalloc(sizeof(uint32_t) * srcdata->vbuf_glyphs * 6);
+		for (size_t i = 0; i < srcdata->vbuf_glyphs * 6; i++)
+			srcdata->colorbuf[i] = 0xFF000000;
 	}
 
-	if (*srcdata->text == 0) {
+	if (srcdata->vbuf == NULL) {
+		srcdata->vbuf_glyphs = 0;
 		obs_leave_graphics();
 		return;
 	}
 
-	srcdata->vbuf =
-		create_uv_vbuffer((uint32_t)wcslen(srcdata->text) * 6, true);
-
 	if (srcdata->custom_width <= 100)
 		goto skip_word_wrap;
 	if (!srcdata->word_wrap)
 		goto skip_word_wrap;
 
-	len = wcslen(srcdata->text);
-
 	for (uint32_t i = 0; i <= len; i++) {
 		if (i == wcslen(srcdata->text))
 			goto eos_check;
@@ -170,16 +257,6 @@ void fill_vertex_buffer(struct ft2_source *srcdata)
 		dx = offset;
 	}
 
-	if (srcdata->colorbuf != NULL) {
-		bfree(srcdata->colorbuf);
-		srcdata->colorbuf = NULL;
-	}
-	srcdata->colorbuf =
-		bzalloc(sizeof(uint32_t) * wcslen(srcdata->text) * 6);
-	for (size_t i = 0; i < len * 6; i++) {
-		srcdata->colorbuf[i] = 0xFF000000;
-	}
-
 	for (size_t i = 0; i < len; i++) {
 	add_linebreak:;
 		if (srcdata->text[i] != L'\n')
@@ -226,21 +303,19 @@ void fill_vertex_buffer(struct ft2_source *srcdata)
 	skip_glyph:;
 	}
 
+	/* the buffer is reused, so clear whatever the previous text left
+	 * behind past the last glyph */
+	if (cur_glyph < srcdata->vbuf_glyphs) {
+		const size_t unused = (srcdata->vbuf_glyphs - cur_glyph) * 6;
+		memset(vdata->points + cur_glyph * 6, 0,
+		       sizeof(struct vec3) * unused);
+	}
+
 	srcdata->cy = max_y;
 }
 
 void cache_standard_glyphs(struct ft2_source *srcdata)
 {
-	for (uint32_t i = 0; i < num_cache_slots; i++) {
-		if (srcdata->cacheglyphs[i] != NULL) {
-			bfree(srcdata->cacheglyphs[i]);
-			srcdata->cacheglyphs[i] = NULL;
-		}
-	}
-
-	srcdata->texbuf_x = 0;
-	srcdata->texbuf_y = 0;
-
 	cache_glyphs(srcdata, L"abcdefghijklmnopqrstuvwxyz"
 			      L"ABCDEFGHIJKLMNOPQRSTUVWXYZ1234567890"
 			      L"!@#$%^&*()-_=+,<.>/?\\|[]{}`~ \'\"\0");
@@ -292,7 +367,7 @@ uint8_t get_pixel_value(const unsigned char *buf_row,
 	return pixel_set ? 255 : 0;
 }
 
-void rasterize(struct ft2_source *srcdata, FT_GlyphSlot slot,
+void rasterize(struct glyph_atlas *atlas, FT_GlyphSlot slot,
 	       const FT_Render_Mode render_mode, const uint32_t dx,
 	       const uint32_t dy)
 {
@@ -313,20 +388,24 @@ void rasterize(struct ft2_source *srcdata, FT_GlyphSlot slot,
 			const uint8_t pixel_value =
 				get_pixel_value(&slot->bitmap.buffer[row_start],
 						render_mode, x);
-			srcdata->texbuf[row_pixel_position + row] = pixel_value;
+			atlas->texbuf[row_pixel_position + row] = pixel_value;
 		}
 	}
 }
 
 void cache_glyphs(struct ft2_source *srcdata, wchar_t *cache_glyphs)
 {
-	if (!srcdata->font_face || !cache_glyphs)
+	struct glyph_atlas *atlas = srcdata->atlas;
+
+	if (!srcdata->font_face || !atlas || !cache_glyphs)
 		return;
 
 	FT_GlyphSlot slot = srcdata->font_face->glyph;
 
-	uint32_t dx = srcdata->texbuf_x;
-	uint32_t dy = srcdata->texbuf_y;
+	pthread_mutex_lock(&atlas_mutex);
+
+	uint32_t dx = atlas->texbuf_x;
+	uint32_t dy = atlas->texbuf_y;
 
 	int32_t cached_glyphs = 0;
 	const size_t len = wcslen(cache_glyphs);
@@ -337,7 +416,10 @@ void cache_glyphs(struct ft2_source *srcdata, wchar_t *cache_glyphs)
 		const FT_UInt glyph_index =
 			FT_Get_Char_Index(srcdata->font_face, cache_glyphs[i]);
 
+		/* another source may already have rasterized it */
 		if (src_glyph != NULL) {
+			if (srcdata->max_h < (uint32_t)src_glyph->h)
+				srcdata->max_h = src_glyph->h;
 			continue;
 		}
 
@@ -350,10 +432,13 @@ void cache_glyphs(struct ft2_source *srcdata, wchar_t *cache_glyphs)
 		if (srcdata->max_h < g_h) {
 			srcdata->max_h = g_h;
 		}
+		if (atlas->row_h < g_h) {
+			atlas->row_h = g_h;
+		}
 
 		if (dx + g_w >= texbuf_w) {
 			dx = 0;
-			dy += srcdata->max_h + 1;
+			dy += atlas->row_h + 1;
 		}
 
 		if (dy + g_h >= texbuf_h) {
@@ -362,37 +447,38 @@ void cache_glyphs(struct ft2_source *srcdata, wchar_t *cache_glyphs)
 			break;
 		}
 
+		rasterize(atlas, slot, render_mode, dx, dy);
 		src_glyph = init_glyph(slot, dx, dy, g_w, g_h);
-		rasterize(srcdata, slot, render_mode, dx, dy);
 
 		dx += (g_w + 1);
 		if (dx >= texbuf_w) {
 			dx = 0;
-			dy += srcdata->max_h;
+			dy += atlas->row_h;
 		}
 
 		cached_glyphs++;
 	}
 
-	srcdata->texbuf_x = dx;
-	srcdata->texbuf_y = dy;
-
-	if (cached_glyphs > 0) {
+	atlas->texbuf_x = dx;
+	atlas->texbuf_y = dy;
 
+	/* the texture is shared, so it's updated in place rather than
+	 * recreated to keep other sources' pointers to it valid */
+	if (cached_glyphs > 0 || !atlas->tex) {
 		obs_enter_graphics();
 
-		if (srcdata->tex != NULL) {
-			gs_texture_t *tmp_texture = srcdata->tex;
-			srcdata->tex = NULL;
-			gs_texture_destroy(tmp_texture);
-		}
-
-		srcdata->tex = gs_texture_create(
-			texbuf_w, texbuf_h, GS_A8, 1,
-			(const uint8_t **)&srcdata->texbuf, 0);
+		if (atlas->tex)
+			gs_texture_set_image(atlas->tex, atlas->texbuf,
+					     texbuf_w, false);
+		else
+			atlas->tex = gs_texture_create(
+				texbuf_w, texbuf_h, GS_A8, 1,
+				(const uint8_t **)&atlas->texbuf, GS_DYNAMIC);
 
 		obs_leave_graphics();
 	}
+
+	pthread_mutex_unlock(&atlas_mutex);
 }
 
 time_t get_modified_timestamp(char *filename)
@@ -568,13 +654,22 @@ uint32_t get_ft2_text_width(wchar_t *text, struct ft2_source *srcdata)
 	for (size_t i = 0; i < len; i++) {
 		const FT_UInt glyph_index =
 			FT_Get_Char_Index(srcdata->font_face, text[i]);
+		int32_t xadv;
 
-		load_glyph(srcdata, glyph_index, get_render_mode(srcdata));
+		/* cached glyphs already know their advance, so only glyphs
+		 * that didn't fit in the atlas have to be loaded again */
+		if (srcdata->atlas && src_glyph != NULL) {
+			xadv = src_glyph->xadv;
+		} else {
+			load_glyph(srcdata, glyph_index,
+				   get_render_mode(srcdata));
+			xadv = slot->advance.x >> 6;
+		}
 
 		if (text[i] == L'\n')
 			w = 0;
 		else {
-			w += slot->advance.x >> 6;
+			w += xadv;
 			if (w > max_w)
 				max_w = w;
 		}
@@ -174,6 +174,7 @@ struct game_capture {
 	bool capturing;
 	bool activate_hook;
 	bool process_is_64bit;
+	bool can_dup_handles;
 	bool error_acquiring;
 	bool dwm_capture;
 	bool initial_config;
@@ -192,6 +193,8 @@ struct game_capture {
 
 	ipc_pipe_server_t pipe;
 	gs_texture_t *texture;
+	gs_texture_t *shtex_textures[2];
+	int shtex_held;
 	gs_texture_t *extra_texture;
 	gs_texrender_t *extra_texrender;
 	bool is_10a2_2100pq;
@@ -207,6 +210,7 @@ struct game_capture {
 	HANDLE global_hook_info_map;
 	HANDLE target_process;
 	HANDLE texture_mutexes[2];
+	uint32_t shmem_frame_count;
 	wchar_t *app_sid;
 	int retrying;
 	float cursor_check_time;
@@ -429,6 +433,25 @@ static void free_whitelist(struct auto_game_capture *ac)
 	ReleaseMutex(ac->mutex);
 }
 
+/* with double buffered shared textures gc->texture is just whichever of the
+ * two is currently held */
+static void free_shtex_textures(struct game_capture *gc)
+{
+	if (!gc->shtex_textures[0])
+		return;
+
+	if (gc->shtex_held != -1)
+		gs_texture_release_sync(gc->shtex_textures[gc->shtex_held], 0);
+
+	for (size_t i = 0; i < 2; i++) {
+		gs_texture_destroy(gc->shtex_textures[i]);
+		gc->shtex_textures[i] = NULL;
+	}
+
+	gc->shtex_held = -1;
+	gc->texture = NULL;
+}
+
 static void stop_capture(struct game_capture *gc)
 {
 	ipc_pipe_server_free(&gc->pipe);
@@ -467,6 +490,7 @@ static void stop_capture(struct game_capture *gc)
 	gc->extra_texrender = NULL;
 	gs_texture_destroy(gc->extra_texture);
 	gc->extra_texture = NULL;
+	free_shtex_textures(gc);
 	gs_texture_destroy(gc->texture);
 	gc->texture = NULL;
 	obs_leave_graphics();
@@ -987,8 +1011,17 @@ static inline bool is_64bit_process(HANDLE process)
 
 static inline bool open_target_process(struct game_capture *gc)
 {
-	gc->target_process = open_process(
-		PROCESS_QUERY_INFORMATION | SYNCHRONIZE, false, gc->process_id);
+	/* duplicating handles lets hooks share textures by NT handle, but
+	 * some protected processes only allow the basic rights */
+	gc->target_process = open_process(PROCESS_QUERY_INFORMATION |
+						  SYNCHRONIZE |
+						  PROCESS_DUP_HANDLE,
+					  false, gc->process_id);
+	gc->can_dup_handles = !!gc->target_process;
+	if (!gc->target_process)
+		gc->target_process =
+			open_process(PROCESS_QUERY_INFORMATION | SYNCHRONIZE,
+				     false, gc->process_id);
 	if (!gc->target_process) {
 		warn("could not open process: %s", gc->config.executable);
 		return false;
@@ -1110,6 +1143,12 @@ static inline bool init_hook_info(struct game_capture *gc)
 		warn("init_hook_info: shared texture capture unavailable");
 		gc->global_hook_info->force_shmem = true;
 	}
+	/* keyed mutexes and NT handles are only supported by the D3D11
+	 * renderer */
+	const bool d3d11 = gs_get_device_type() == GS_DEVICE_DIRECT3D_11;
+	gc->global_hook_info->shtex_double_buffer = d3d11;
+	gc->global_hook_info->allow_nt_shared_handle = d3d11 &&
+						       gc->can_dup_handles;
 	obs_leave_graphics();
 
 	return true;
@@ -1889,6 +1928,11 @@ static void copy_shmem_tex(struct game_capture *gc)
 	if (!gc->shmem_data)
 		return;
 
+	/* read before last_tex, the hook updates them the other way round */
+	const uint32_t frame_count = gc->shmem_data->frame_count;
+	if (frame_count && frame_count == gc->shmem_frame_count)
+		return;
+
 	cur_texture = gc->shmem_data->last_tex;
 
 	if (cur_texture < 0 || cur_texture > 1)
@@ -1943,6 +1987,7 @@ static void copy_shmem_tex(struct game_capture *gc)
 		}
 
 		gs_texture_unmap(gc->texture);
+		gc->shmem_frame_count = frame_count;
 	}
 
 	ReleaseMutex(mutex);
@@ -1966,6 +2011,7 @@ static inline bool init_shmem_capture(struct game_capture *gc)
 	gc->extra_texrender = NULL;
 	gs_texture_destroy(gc->extra_texture);
 	gc->extra_texture = NULL;
+	free_shtex_textures(gc);
 	gs_texture_destroy(gc->texture);
 	gc->texture = NULL;
 	gs_texture_t *const texture =
@@ -1996,6 +2042,7 @@ static inline bool init_shmem_capture(struct game_capture *gc)
 			gc->extra_texture = NULL;
 			gc->extra_texrender = extra_texrender;
 			gc->linear_sample = linear_sample;
+			gc->shmem_frame_count = 0;
 			gc->copy_texture = copy_shmem_tex;
 		} else {
 			gs_texture_destroy(texture);
@@ -2007,6 +2054,48 @@ static inline bool init_shmem_capture(struct game_capture *gc)
 	return success;
 }
 
+/* switches to the newest complete frame.  the hook never waits on the
+ * texture being held here, and is only ever holding one for the length of a
+ * copy, so a failed acquire just means trying again next tick */
+static void copy_shtex_tex(struct game_capture *gc)
+{
+	const int last = gc->shtex_data->last_tex;
+
+	if (last < 0 || last > 1 || last == gc->shtex_held)
+		return;
+
+	gs_texture_t *next = gc->shtex_textures[last];
+	if (gs_texture_acquire_sync(next, 0, 0) != 0)
+		return;
+
+	if (gc->shtex_held != -1)
+		gs_texture_release_sync(gc->shtex_textures[gc->shtex_held], 0);
+
+	gc->shtex_held = last;
+	gc->texture = next;
+}
+
+/* the handle belongs to the game's process */
+static gs_texture_t *open_nt_shared_tex(struct game_capture *gc,
+					uint32_t handle)
+{
+	HANDLE dup = NULL;
+
+	if (!DuplicateHandle(gc->target_process, (HANDLE)(uintptr_t)handle,
+			     GetCurrentProcess(), &dup, 0, false,
+			     DUPLICATE_SAME_ACCESS)) {
+		warn("init_shtex_capture: failed to duplicate shared handle: "
+		     "%lu",
+		     GetLastError());
+		return NULL;
+	}
+
+	gs_texture_t *texture = gs_texture_open_nt_shared(
+		(uint32_t)(uintptr_t)dup);
+	CloseHandle(dup);
+	return texture;
+}
+
 static inline bool init_shtex_capture(struct game_capture *gc)
 {
 	obs_enter_graphics();
@@ -2014,11 +2103,33 @@ static inline bool init_shtex_capture(struct game_capture *gc)
 	gc->extra_texrender = NULL;
 	gs_texture_destroy(gc->extra_texture);
 	gc->extra_texture = NULL;
+	free_shtex_textures(gc);
 	gs_texture_destroy(gc->texture);
 	gc->texture = NULL;
+
+	/* older hooks only map the first handle */
+	const bool double_buffered =
+		gc->global_hook_info->map_size >= sizeof(struct shtex_data) &&
+		gc->shtex_data->tex_handle2 != 0;
+
+	const bool nt_handle =
+		gc->global_hook_info->map_size >= sizeof(struct shtex_data) &&
+		gc->shtex_data->nt_handle;
+
 	gs_texture_t *const texture =
-		gs_texture_open_shared(gc->shtex_data->tex_handle);
+		nt_handle ? open_nt_shared_tex(gc, gc->shtex_data->tex_handle)
+			  : gs_texture_open_shared(gc->shtex_data->tex_handle);
+	gs_texture_t *texture2 = NULL;
 	bool success = texture != NULL;
+	if (success && double_buffered) {
+		texture2 = gs_texture_open_shared(gc->shtex_data->tex_handle2);
+		success = texture2 != NULL;
+		if (!success) {
+			warn("init_shtex_capture: failed to open second shared "
+			     "handle");
+			gs_texture_destroy(texture);
+		}
+	}
 	if (success) {
 		enum gs_color_format format =
 			gs_texture_get_color_format(texture);
@@ -2048,14 +2159,23 @@ static inline bool init_shtex_capture(struct game_capture *gc)
 		}
 
 		if (success) {
-			gc->texture = texture;
 			gc->linear_sample = linear_sample;
 			gc->extra_texture = extra_texture;
 			gc->extra_texrender = extra_texrender;
+
+			if (double_buffered) {
+				gc->shtex_textures[0] = texture;
+				gc->shtex_textures[1] = texture2;
+				gc->shtex_held = -1;
+				gc->copy_texture = copy_shtex_tex;
+			} else {
+				gc->texture = texture;
+			}
 		} else {
 			gs_texture_destroy(texture);
+			gs_texture_destroy(texture2);
 		}
-	} else {
+	} else if (!texture) {
 		warn("init_shtex_capture: failed to open shared handle");
 	}
 	obs_leave_graphics();
@@ -70,10 +70,27 @@ struct shmem_data {
 	volatile int last_tex;
 	uint32_t tex1_offset;
 	uint32_t tex2_offset;
+
+	/* incremented after every completed copy, so the same frame isn't
+	 * uploaded again every tick.  always 0 with hooks older than 1.9 */
+	volatile uint32_t frame_count;
 };
 
 struct shtex_data {
 	uint32_t tex_handle;
+
+	/* only set when the hook agreed to double buffer (see
+	 * hook_info::shtex_double_buffer).  both textures are keyed mutex
+	 * textures, the hook copies into whichever one OBS isn't holding and
+	 * last_tex is the index of the most recently completed one, or -1
+	 * before the first frame */
+	uint32_t tex_handle2;
+	volatile int last_tex;
+
+	/* tex_handle is an NT handle in the hook's process, which OBS has to
+	 * duplicate before opening.  only used when the plugin sets
+	 * hook_info::allow_nt_shared_handle */
+	bool nt_handle;
 };
 
 enum capture_type {
@@ -114,11 +131,14 @@ struct hook_info {
 	bool force_shmem;
 	bool capture_overlay;
 	bool allow_srgb_alias;
+	bool shtex_double_buffer;
 
 	/* hook addresses */
 	struct graphics_offsets offsets;
 
-	uint32_t reserved[126];
+	bool allow_nt_shared_handle;
+
+	uint32_t reserved[125];
 };
 static_assert(sizeof(struct hook_info) == 648, "ABI compatibility");
 
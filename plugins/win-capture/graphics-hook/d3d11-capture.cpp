@@ -31,8 +31,10 @@ struct d3d11_data {
 		/* shared texture */
 		struct {
 			struct shtex_data *shtex_info;
-			ID3D11Texture2D *texture;
-			HANDLE handle;
+			ID3D11Texture2D *textures[2];
+			IDXGIKeyedMutex *keyed_mutexes[2];
+			HANDLE handles[2];
+			bool double_buffered;
 		};
 		/* shared memory */
 		struct {
@@ -49,6 +51,21 @@ struct d3d11_data {
 
 static struct d3d11_data data = {};
 
+static void d3d11_shtex_free_textures(void)
+{
+	for (size_t i = 0; i < 2; i++) {
+		if (data.keyed_mutexes[i]) {
+			data.keyed_mutexes[i]->Release();
+			data.keyed_mutexes[i] = nullptr;
+		}
+		if (data.textures[i]) {
+			data.textures[i]->Release();
+			data.textures[i] = nullptr;
+		}
+		data.handles[i] = nullptr;
+	}
+}
+
 void d3d11_free(void)
 {
 	if (data.scale_tex)
@@ -75,8 +92,7 @@ void d3d11_free(void)
 	capture_free();
 
 	if (data.using_shtex) {
-		if (data.texture)
-			data.texture->Release();
+		d3d11_shtex_free_textures();
 	} else {
 		for (size_t i = 0; i < NUM_BUFFERS; i++) {
 			if (data.copy_surfaces[i]) {
@@ -118,7 +134,7 @@ static bool create_d3d11_stage_surface(ID3D11Texture2D **tex)
 }
 
 static bool create_d3d11_tex(uint32_t cx, uint32_t cy, ID3D11Texture2D **tex,
-			     HANDLE *handle)
+			     HANDLE *handle, bool keyed_mutex)
 {
 	HRESULT hr;
 
@@ -132,7 +148,8 @@ static bool create_d3d11_tex(uint32_t cx, uint32_t cy, ID3D11Texture2D **tex,
 	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
 	desc.SampleDesc.Count = 1;
 	desc.Usage = D3D11_USAGE_DEFAULT;
-	desc.MiscFlags = D3D11_RESOURCE_MISC_SHARED;
+	desc.MiscFlags = keyed_mutex ? D3D11_RESOURCE_MISC_SHARED_KEYEDMUTEX
+				     : D3D11_RESOURCE_MISC_SHARED;
 
 	hr = data.device->CreateTexture2D(&desc, nullptr, tex);
 	if (FAILED(hr)) {
@@ -233,25 +250,72 @@ static bool d3d11_shmem_init(HWND window)
 	return true;
 }
 
+static bool d3d11_shtex_init_double_buffered(void)
+{
+	HRESULT hr;
+
+	for (size_t i = 0; i < 2; i++) {
+		if (!create_d3d11_tex(data.cx, data.cy, &data.textures[i],
+				      &data.handles[i], true)) {
+			hlog("d3d11_shtex_init: failed to create keyed mutex "
+			     "texture");
+			return false;
+		}
+
+		hr = data.textures[i]->QueryInterface(
+			__uuidof(IDXGIKeyedMutex),
+			(void **)&data.keyed_mutexes[i]);
+		if (FAILED(hr)) {
+			hlog_hr("d3d11_shtex_init: failed to query "
+				"IDXGIKeyedMutex interface from texture",
+				hr);
+			return false;
+		}
+	}
+
+	return true;
+}
+
 static bool d3d11_shtex_init(HWND window)
 {
 	bool success;
 
 	data.using_shtex = true;
 
-	success =
-		create_d3d11_tex(data.cx, data.cy, &data.texture, &data.handle);
+	/* two keyed mutex textures let the game always write into the one
+	 * OBS isn't reading, so neither side ever waits on the other and a
+	 * half copied frame is never shown */
+	data.double_buffered = global_hook_info->shtex_double_buffer &&
+			       d3d11_shtex_init_double_buffered();
+	if (global_hook_info->shtex_double_buffer && !data.double_buffered) {
+		hlog("d3d11_shtex_init: falling back to a single shared "
+		     "texture");
+		d3d11_shtex_free_textures();
+	}
 
-	if (!success) {
-		hlog("d3d11_shtex_init: failed to create texture");
-		return false;
+	if (data.double_buffered) {
+		success = capture_init_shtex2(&data.shtex_info, window,
+					      data.cx, data.cy, data.format,
+					      false, (uintptr_t)data.handles[0],
+					      (uintptr_t)data.handles[1]);
+	} else {
+		success = create_d3d11_tex(data.cx, data.cy, &data.textures[0],
+					   &data.handles[0], false);
+		if (!success) {
+			hlog("d3d11_shtex_init: failed to create texture");
+			return false;
+		}
+
+		success = capture_init_shtex(&data.shtex_info, window, data.cx,
+					     data.cy, data.format, false,
+					     (uintptr_t)data.handles[0]);
 	}
-	if (!capture_init_shtex(&data.shtex_info, window, data.cx, data.cy,
-				data.format, false, (uintptr_t)data.handle)) {
+
+	if (!success)
 		return false;
-	}
 
-	hlog("d3d11 shared texture capture successful");
+	hlog("d3d11 shared texture capture successful%s",
+	     data.double_buffered ? " (double buffered)" : "");
 	return true;
 }
 
@@ -293,7 +357,27 @@ static inline void d3d11_copy_texture(ID3D11Resource *dst, ID3D11Resource *src)
 
 static inline void d3d11_shtex_capture(ID3D11Resource *backbuffer)
 {
-	d3d11_copy_texture(data.texture, backbuffer);
+	if (!data.double_buffered) {
+		d3d11_copy_texture(data.textures[0], backbuffer);
+		return;
+	}
+
+	/* prefer the texture OBS isn't showing.  OBS only holds a texture
+	 * for as long as it takes to switch to a newer one, so if both are
+	 * busy the frame is skipped rather than stalling the game */
+	int idx = data.shtex_info->last_tex == 0 ? 1 : 0;
+
+	for (int i = 0; i < 2; i++, idx ^= 1) {
+		IDXGIKeyedMutex *km = data.keyed_mutexes[idx];
+
+		if (km->AcquireSync(0, 0) != S_OK)
+			continue;
+
+		d3d11_copy_texture(data.textures[idx], backbuffer);
+		km->ReleaseSync(0);
+		data.shtex_info->last_tex = idx;
+		return;
+	}
 }
 
 static void d3d11_shmem_capture_copy(int i)
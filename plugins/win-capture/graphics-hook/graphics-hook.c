@@ -559,9 +559,9 @@ static inline bool init_shared_info(size_t size, HWND window)
 	return true;
 }
 
-bool capture_init_shtex(struct shtex_data **data, HWND window, uint32_t cx,
-			uint32_t cy, uint32_t format, bool flip,
-			uintptr_t handle)
+static bool init_shtex(struct shtex_data **data, HWND window, uint32_t cx,
+		       uint32_t cy, uint32_t format, bool flip,
+		       uintptr_t handle1, uintptr_t handle2, bool nt_handle)
 {
 	if (!init_shared_info(sizeof(struct shtex_data), window)) {
 		hlog("capture_init_shtex: Failed to initialize memory");
@@ -569,7 +569,10 @@ bool capture_init_shtex(struct shtex_data **data, HWND window, uint32_t cx,
 	}
 
 	*data = shmem_info;
-	(*data)->tex_handle = (uint32_t)handle;
+	(*data)->tex_handle = (uint32_t)handle1;
+	(*data)->tex_handle2 = (uint32_t)handle2;
+	(*data)->last_tex = -1;
+	(*data)->nt_handle = nt_handle;
 
 	global_hook_info->hook_ver_major = HOOK_VER_MAJOR;
 	global_hook_info->hook_ver_minor = HOOK_VER_MINOR;
@@ -594,6 +597,28 @@ bool capture_init_shtex(struct shtex_data **data, HWND window, uint32_t cx,
 	return true;
 }
 
+bool capture_init_shtex(struct shtex_data **data, HWND window, uint32_t cx,
+			uint32_t cy, uint32_t format, bool flip,
+			uintptr_t handle)
+{
+	return init_shtex(data, window, cx, cy, format, flip, handle, 0, false);
+}
+
+bool capture_init_shtex2(struct shtex_data **data, HWND window, uint32_t cx,
+			 uint32_t cy, uint32_t format, bool flip,
+			 uintptr_t handle1, uintptr_t handle2)
+{
+	return init_shtex(data, window, cx, cy, format, flip, handle1, handle2,
+			  false);
+}
+
+bool capture_init_shtex_nt(struct shtex_data **data, HWND window,
+			   uint32_t cx, uint32_t cy, uint32_t format, bool flip,
+			   uintptr_t handle)
+{
+	return init_shtex(data, window, cx, cy, format, flip, handle, 0, true);
+}
+
 static DWORD CALLBACK copy_thread(LPVOID unused)
 {
 	uint32_t pitch = thread_data.pitch;
@@ -638,6 +663,7 @@ static DWORD CALLBACK copy_thread(LPVOID unused)
 				unlock_shmem_tex(lock_id);
 				((struct shmem_data *)shmem_info)->last_tex =
 					lock_id;
+				((struct shmem_data *)shmem_info)->frame_count++;
 
 				shmem_id = lock_id == 0 ? 1 : 0;
 			}
@@ -17,7 +17,10 @@ extern "C" {
 #endif
 #endif
 
-#define NUM_BUFFERS 3
+/* staging readback ring.  the texture mapped each frame was copied
+ * NUM_BUFFERS - 1 frames earlier, which gives slower cross adapter copies
+ * time to land before Map has to wait on them */
+#define NUM_BUFFERS 4
 #define HOOK_VERBOSE_LOGGING 0
 
 #if HOOK_VERBOSE_LOGGING
@@ -70,6 +73,13 @@ extern bool rehook_gl(void);
 extern bool capture_init_shtex(struct shtex_data **data, HWND window,
 			       uint32_t cx, uint32_t cy, uint32_t format,
 			       bool flip, uintptr_t handle);
+extern bool capture_init_shtex2(struct shtex_data **data, HWND window,
+				uint32_t cx, uint32_t cy, uint32_t format,
+				bool flip, uintptr_t handle1,
+				uintptr_t handle2);
+extern bool capture_init_shtex_nt(struct shtex_data **data, HWND window,
+				  uint32_t cx, uint32_t cy, uint32_t format,
+				  bool flip, uintptr_t handle);
 extern bool capture_init_shmem(struct shmem_data **data, HWND window,
 			       uint32_t cx, uint32_t cy, uint32_t pitch,
 			       uint32_t format, bool flip);
@@ -51,6 +51,7 @@ struct vk_swap_data {
 	uint32_t image_count;
 
 	HANDLE handle;
+	bool nt_handle;
 	struct shtex_data *shtex_info;
 	ID3D11Texture2D *d3d11_tex;
 	bool captured;
@@ -106,6 +107,11 @@ struct vk_data {
 
 	VkExternalMemoryProperties external_mem_props;
 
+	/* set when the image can be exported as a D3D11 NT handle directly,
+	 * which skips creating a D3D11 device in the game */
+	bool nt_export_supported;
+	VkExternalMemoryProperties nt_export_mem_props;
+
 	struct vk_inst_data *inst_data;
 
 	VkAllocationCallbacks ac_storage;
@@ -406,6 +412,23 @@ static void vk_shtex_wait_until_idle(struct vk_data *data)
 	queue_walk_end(data);
 }
 
+static void vk_shtex_free_export_tex(struct vk_data *data,
+				     struct vk_swap_data *swap)
+{
+	if (swap->export_image)
+		data->funcs.DestroyImage(data->device, swap->export_image,
+					 data->ac);
+	if (swap->export_mem)
+		data->funcs.FreeMemory(data->device, swap->export_mem, NULL);
+	if (swap->nt_handle && swap->handle != INVALID_HANDLE_VALUE)
+		CloseHandle(swap->handle);
+
+	swap->export_image = VK_NULL_HANDLE;
+	swap->export_mem = VK_NULL_HANDLE;
+	swap->handle = INVALID_HANDLE_VALUE;
+	swap->nt_handle = false;
+}
+
 static void vk_shtex_free(struct vk_data *data)
 {
 	capture_free();
@@ -415,22 +438,13 @@ static void vk_shtex_free(struct vk_data *data)
 	struct vk_swap_data *swap = swap_walk_begin(data);
 
 	while (swap) {
-		VkDevice device = data->device;
-		if (swap->export_image)
-			data->funcs.DestroyImage(device, swap->export_image,
-						 data->ac);
-
-		if (swap->export_mem)
-			data->funcs.FreeMemory(device, swap->export_mem, NULL);
+		vk_shtex_free_export_tex(data, swap);
 
 		if (swap->d3d11_tex) {
 			ID3D11Texture2D_Release(swap->d3d11_tex);
 		}
 
-		swap->handle = INVALID_HANDLE_VALUE;
 		swap->d3d11_tex = NULL;
-		swap->export_mem = VK_NULL_HANDLE;
-		swap->export_image = VK_NULL_HANDLE;
 
 		swap->captured = false;
 
@@ -668,12 +682,20 @@ static inline bool vk_shtex_init_d3d11_tex(struct vk_data *data,
 	return true;
 }
 
+/* with export_nt the image memory is allocated here and exported as an NT
+ * handle, otherwise the memory of the D3D11 texture is imported */
 static inline bool vk_shtex_init_vulkan_tex(struct vk_data *data,
-					    struct vk_swap_data *swap)
+					    struct vk_swap_data *swap,
+					    bool export_nt)
 {
 	struct vk_device_funcs *funcs = &data->funcs;
-	VkExternalMemoryFeatureFlags f =
-		data->external_mem_props.externalMemoryFeatures;
+	const VkExternalMemoryProperties *props =
+		export_nt ? &data->nt_export_mem_props
+			  : &data->external_mem_props;
+	VkExternalMemoryFeatureFlags f = props->externalMemoryFeatures;
+	const VkExternalMemoryHandleTypeFlagBits handle_type =
+		export_nt ? VK_EXTERNAL_MEMORY_HANDLE_TYPE_D3D11_TEXTURE_BIT
+			  : VK_EXTERNAL_MEMORY_HANDLE_TYPE_D3D11_TEXTURE_KMT_BIT;
 
 	/* -------------------------------------------------------- */
 	/* create texture                                           */
@@ -681,8 +703,7 @@ static inline bool vk_shtex_init_vulkan_tex(struct vk_data *data,
 	VkExternalMemoryImageCreateInfo emici;
 	emici.sType = VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_IMAGE_CREATE_INFO;
 	emici.pNext = NULL;
-	emici.handleTypes =
-		VK_EXTERNAL_MEMORY_HANDLE_TYPE_D3D11_TEXTURE_KMT_BIT;
+	emici.handleTypes = handle_type;
 
 	VkImageCreateInfo ici;
 	ici.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -760,13 +781,24 @@ static inline bool vk_shtex_init_vulkan_tex(struct vk_data *data,
 	imw32hi.sType = VK_STRUCTURE_TYPE_IMPORT_MEMORY_WIN32_HANDLE_INFO_KHR;
 	imw32hi.pNext = NULL;
 	imw32hi.name = NULL;
-	imw32hi.handleType =
-		VK_EXTERNAL_MEMORY_HANDLE_TYPE_D3D11_TEXTURE_KMT_BIT;
+	imw32hi.handleType = handle_type;
 	imw32hi.handle = swap->handle;
 
+	VkExportMemoryWin32HandleInfoKHR emw32hi;
+	emw32hi.sType = VK_STRUCTURE_TYPE_EXPORT_MEMORY_WIN32_HANDLE_INFO_KHR;
+	emw32hi.pNext = NULL;
+	emw32hi.pAttributes = NULL;
+	emw32hi.dwAccess = GENERIC_ALL;
+	emw32hi.name = NULL;
+
+	VkExportMemoryAllocateInfo emai;
+	emai.sType = VK_STRUCTURE_TYPE_EXPORT_MEMORY_ALLOCATE_INFO;
+	emai.pNext = &emw32hi;
+	emai.handleTypes = handle_type;
+
 	VkMemoryAllocateInfo mai;
 	mai.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	mai.pNext = &imw32hi;
+	mai.pNext = export_nt ? (void *)&emai : (void *)&imw32hi;
 	mai.allocationSize = mr.size;
 
 	VkMemoryDedicatedAllocateInfo mdai;
@@ -774,10 +806,12 @@ static inline bool vk_shtex_init_vulkan_tex(struct vk_data *data,
 	mdai.pNext = NULL;
 	mdai.buffer = VK_NULL_HANDLE;
 
-	if (data->external_mem_props.externalMemoryFeatures &
-	    VK_EXTERNAL_MEMORY_FEATURE_DEDICATED_ONLY_BIT) {
+	if (f & VK_EXTERNAL_MEMORY_FEATURE_DEDICATED_ONLY_BIT) {
 		mdai.image = swap->export_image;
-		imw32hi.pNext = &mdai;
+		if (export_nt)
+			emw32hi.pNext = &mdai;
+		else
+			imw32hi.pNext = &mdai;
 	}
 
 	bool allocated = false;
@@ -849,29 +883,72 @@ static inline bool vk_shtex_init_vulkan_tex(struct vk_data *data,
 		swap->export_image = VK_NULL_HANDLE;
 		return false;
 	}
+
+	if (export_nt) {
+		VkMemoryGetWin32HandleInfoKHR mgw32hi;
+		mgw32hi.sType =
+			VK_STRUCTURE_TYPE_MEMORY_GET_WIN32_HANDLE_INFO_KHR;
+		mgw32hi.pNext = NULL;
+		mgw32hi.memory = swap->export_mem;
+		mgw32hi.handleType = handle_type;
+
+		HANDLE handle = NULL;
+		res = funcs->GetMemoryWin32HandleKHR(device, &mgw32hi, &handle);
+		if (VK_SUCCESS != res) {
+			flog("failed to GetMemoryWin32HandleKHR: %s",
+			     result_to_str(res));
+			return false;
+		}
+
+		swap->handle = handle;
+		swap->nt_handle = true;
+	}
+
 	return true;
 }
 
-static bool vk_shtex_init(struct vk_data *data, HWND window,
-			  struct vk_swap_data *swap)
+/* exports the image straight from vulkan when both the driver and OBS
+ * support it, otherwise goes through a texture created on a D3D11 device */
+static bool vk_shtex_init_tex(struct vk_data *data, struct vk_swap_data *swap)
 {
+	if (data->nt_export_supported &&
+	    global_hook_info->allow_nt_shared_handle) {
+		if (vk_shtex_init_vulkan_tex(data, swap, true))
+			return true;
+
+		flog("failed to export image, falling back to D3D11 interop");
+		vk_shtex_free_export_tex(data, swap);
+	}
+
 	if (!vk_shtex_init_d3d11(data)) {
 		return false;
 	}
 	if (!vk_shtex_init_d3d11_tex(data, swap)) {
 		return false;
 	}
-	if (!vk_shtex_init_vulkan_tex(data, swap)) {
+	return vk_shtex_init_vulkan_tex(data, swap, false);
+}
+
+static bool vk_shtex_init(struct vk_data *data, HWND window,
+			  struct vk_swap_data *swap)
+{
+	if (!vk_shtex_init_tex(data, swap)) {
 		return false;
 	}
 
 	data->cur_swap = swap;
 
-	swap->captured = capture_init_shtex(&swap->shtex_info, window,
-					    swap->image_extent.width,
-					    swap->image_extent.height,
-					    (uint32_t)swap->format, false,
-					    (uintptr_t)swap->handle);
+	if (swap->nt_handle) {
+		swap->captured = capture_init_shtex_nt(
+			&swap->shtex_info, window, swap->image_extent.width,
+			swap->image_extent.height, (uint32_t)swap->format,
+			false, (uintptr_t)swap->handle);
+	} else {
+		swap->captured = capture_init_shtex(
+			&swap->shtex_info, window, swap->image_extent.width,
+			swap->image_extent.height, (uint32_t)swap->format,
+			false, (uintptr_t)swap->handle);
+	}
 
 	if (!swap->captured)
 		return false;
@@ -881,7 +958,8 @@ static bool vk_shtex_init(struct vk_data *data, HWND window,
 		     "unsupported; ignoring");
 	}
 
-	hlog("vulkan shared texture capture successful");
+	hlog("vulkan shared texture capture successful%s",
+	     swap->nt_handle ? " (exported directly)" : "");
 	return true;
 }
 
@@ -1378,6 +1456,8 @@ static bool
 vk_shared_tex_supported(struct vk_inst_funcs *funcs,
 			VkPhysicalDevice phy_device, VkFormat format,
 			VkImageUsageFlags usage,
+			VkExternalMemoryHandleTypeFlagBits handle_type,
+			VkExternalMemoryFeatureFlags required_features,
 			VkExternalMemoryProperties *external_mem_props)
 {
 	VkPhysicalDeviceImageFormatInfo2 info;
@@ -1386,8 +1466,7 @@ vk_shared_tex_supported(struct vk_inst_funcs *funcs,
 	external_info.sType =
 		VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTERNAL_IMAGE_FORMAT_INFO;
 	external_info.pNext = NULL;
-	external_info.handleType =
-		VK_EXTERNAL_MEMORY_HANDLE_TYPE_D3D11_TEXTURE_KMT_BIT;
+	external_info.handleType = handle_type;
 
 	info.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_IMAGE_FORMAT_INFO_2;
 	info.pNext = &external_info;
@@ -1415,7 +1494,7 @@ vk_shared_tex_supported(struct vk_inst_funcs *funcs,
 		external_mem_props->externalMemoryFeatures;
 
 	return ((VK_SUCCESS == result) &&
-		(features & VK_EXTERNAL_MEMORY_FEATURE_IMPORTABLE_BIT));
+		((features & required_features) == required_features));
 }
 
 static inline bool is_device_link_info(VkLayerDeviceCreateInfo *lici)
@@ -1531,6 +1610,7 @@ static VkResult VKAPI_CALL OBS_CreateDevice(VkPhysicalDevice phy_device,
 	GETADDR(DestroyFence);
 	GETADDR(WaitForFences);
 	GETADDR(ResetFences);
+	GETADDR(GetMemoryWin32HandleKHR);
 #undef GETADDR
 
 	if (!funcs_found) {
@@ -1590,12 +1670,21 @@ static VkResult VKAPI_CALL OBS_CreateDevice(VkPhysicalDevice phy_device,
 	VkImageUsageFlags usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
 				  VK_IMAGE_USAGE_TRANSFER_DST_BIT;
 
-	if (!vk_shared_tex_supported(ifuncs, phy_device, format, usage,
-				     &data->external_mem_props)) {
+	if (!vk_shared_tex_supported(
+		    ifuncs, phy_device, format, usage,
+		    VK_EXTERNAL_MEMORY_HANDLE_TYPE_D3D11_TEXTURE_KMT_BIT,
+		    VK_EXTERNAL_MEMORY_FEATURE_IMPORTABLE_BIT,
+		    &data->external_mem_props)) {
 		flog("texture sharing is not supported");
 		goto fail;
 	}
 
+	data->nt_export_supported = vk_shared_tex_supported(
+		ifuncs, phy_device, format, usage,
+		VK_EXTERNAL_MEMORY_HANDLE_TYPE_D3D11_TEXTURE_BIT,
+		VK_EXTERNAL_MEMORY_FEATURE_EXPORTABLE_BIT,
+		&data->nt_export_mem_props);
+
 	data->inst_data = idata;
 
 	data->ac = NULL;
@@ -1716,6 +1805,7 @@ OBS_CreateSwapchainKHR(VkDevice device, const VkSwapchainCreateInfoKHR *cinfo,
 			swap_data->export_mem = VK_NULL_HANDLE;
 			swap_data->image_count = count;
 			swap_data->handle = INVALID_HANDLE_VALUE;
+			swap_data->nt_handle = false;
 			swap_data->shtex_info = NULL;
 			swap_data->d3d11_tex = NULL;
 			swap_data->captured = false;
@@ -42,6 +42,7 @@ struct vk_device_funcs {
 	DEF_FUNC(DestroyFence);
 	DEF_FUNC(WaitForFences);
 	DEF_FUNC(ResetFences);
+	DEF_FUNC(GetMemoryWin32HandleKHR);
 };
 
 #undef DEF_FUNC
@@ -74,6 +74,39 @@ static void init_hw_decoder(struct ffmpeg_decode *d)
 }
 #endif
 
+/* MJPEG has no D3D11VA/DXVA2 hwaccel, but some vendors have their own
+ * decoders that output system memory frames */
+static const char *const mjpeg_hw_decoders[] = {
+	"mjpeg_qsv",
+	"mjpeg_cuvid",
+	NULL,
+};
+
+static bool init_mjpeg_hw_decoder(struct ffmpeg_decode *d)
+{
+	for (const char *const *name = mjpeg_hw_decoders; *name; name++) {
+		const AVCodec *codec = avcodec_find_decoder_by_name(*name);
+		if (!codec)
+			continue;
+
+		AVCodecContext *decoder = avcodec_alloc_context3(codec);
+		if (!decoder)
+			continue;
+
+		if (avcodec_open2(decoder, codec, NULL) == 0) {
+			blog(LOG_INFO, "Using %s for MJPEG decoding", *name);
+			d->codec = codec;
+			d->decoder = decoder;
+			d->hw_decoder = true;
+			return true;
+		}
+
+		avcodec_free_context(&decoder);
+	}
+
+	return false;
+}
+
 int ffmpeg_decode_init(struct ffmpeg_decode *decode, enum AVCodecID id,
 		       bool use_hw)
 {
@@ -83,6 +116,10 @@ int ffmpeg_decode_init(struct ffmpeg_decode *decode, enum AVCodecID id,
 	avcodec_register_all();
 #endif
 	memset(decode, 0, sizeof(*decode));
+	decode->hw_requested = use_hw;
+
+	if (use_hw && id == AV_CODEC_ID_MJPEG && init_mjpeg_hw_decoder(decode))
+		return 0;
 
 	decode->codec = avcodec_find_decoder(id);
 	if (!decode->codec)
@@ -90,8 +127,6 @@ int ffmpeg_decode_init(struct ffmpeg_decode *decode, enum AVCodecID id,
 
 	decode->decoder = avcodec_alloc_context3(decode->codec);
 
-	decode->decoder->thread_count = 0;
-
 #ifdef USE_NEW_HARDWARE_CODEC_METHOD
 	if (use_hw)
 		init_hw_decoder(decode);
@@ -99,6 +134,15 @@ int ffmpeg_decode_init(struct ffmpeg_decode *decode, enum AVCodecID id,
 	(void)use_hw;
 #endif
 
+	/* frame threads only add latency to a hardware decode */
+	if (decode->hw) {
+		decode->decoder->thread_count = 1;
+	} else {
+		decode->decoder->thread_count = 0;
+		decode->decoder->thread_type = FF_THREAD_FRAME |
+					       FF_THREAD_SLICE;
+	}
+
 	ret = avcodec_open2(decode->decoder, decode->codec, NULL);
 	if (ret < 0) {
 		ffmpeg_decode_free(decode);
@@ -122,6 +166,9 @@ void ffmpeg_decode_free(struct ffmpeg_decode *decode)
 	if (decode->frame)
 		av_frame_free(&decode->frame);
 
+	if (decode->packet)
+		av_packet_free(&decode->packet);
+
 	if (decode->hw_device_ctx)
 		av_buffer_unref(&decode->hw_device_ctx);
 
@@ -311,6 +358,43 @@ convert_color_space(enum AVColorSpace s, enum AVColorTransferCharacteristic trc,
 	}
 }
 
+#ifdef USE_NEW_HARDWARE_CODEC_METHOD
+/* mapping the frame skips the copy from the staging texture in to a
+ * separate buffer, libobs copies the data out before the next decode */
+static bool download_hw_frame(struct ffmpeg_decode *decode)
+{
+	AVFrame *dst = decode->frame;
+	AVFrame *src = decode->hw_frame;
+
+	if (av_hwframe_map(dst, src, AV_HWFRAME_MAP_READ) == 0)
+		return true;
+
+	av_frame_unref(dst);
+	if (av_hwframe_transfer_data(dst, src, 0) < 0)
+		return false;
+
+	av_frame_copy_props(dst, src);
+	return true;
+}
+#endif
+
+static bool fall_back_to_software(struct ffmpeg_decode *decode)
+{
+	enum AVCodecID id = decode->codec->id;
+
+	blog(LOG_WARNING, "%s failed to decode, falling back to software",
+	     decode->codec->name);
+
+	ffmpeg_decode_free(decode);
+	if (ffmpeg_decode_init(decode, id, false) < 0)
+		return false;
+
+	/* still counts as hardware decoding having been asked for, so the
+	 * decoder doesn't get recreated for every frame */
+	decode->hw_requested = true;
+	return true;
+}
+
 bool ffmpeg_decode_video(struct ffmpeg_decode *decode, uint8_t *data,
 			 size_t size, long long *ts,
 			 enum video_range_type range,
@@ -336,9 +420,19 @@ bool ffmpeg_decode_video(struct ffmpeg_decode *decode, uint8_t *data,
 		}
 	}
 
+	if (!decode->packet) {
+		decode->packet = av_packet_alloc();
+		if (!decode->packet)
+			return false;
+	}
+
+	/* releases the mapping of the last hardware frame */
+	if (decode->hw)
+		av_frame_unref(decode->frame);
+
 	out_frame = decode->hw ? decode->hw_frame : decode->frame;
 
-	AVPacket *packet = av_packet_alloc();
+	AVPacket *packet = decode->packet;
 	packet->data = decode->packet_buffer;
 	packet->size = (int)size;
 	packet->pts = *ts;
@@ -360,24 +454,26 @@ bool ffmpeg_decode_video(struct ffmpeg_decode *decode, uint8_t *data,
 		ret = avcodec_receive_frame(decode->decoder, out_frame);
 	}
 
-	av_packet_free(&packet);
+	packet->flags = 0;
 
 	got_frame = (ret == 0);
 
 	if (ret == AVERROR_EOF || ret == AVERROR(EAGAIN))
 		ret = 0;
 
-	if (ret < 0)
+	if (ret < 0) {
+		if (decode->hw_decoder && fall_back_to_software(decode))
+			return ffmpeg_decode_video(decode, data, size, ts,
+						   range, frame, got_output);
 		return false;
-	else if (!got_frame)
+	} else if (!got_frame) {
 		return true;
+	}
 
 #ifdef USE_NEW_HARDWARE_CODEC_METHOD
 	if (got_frame && decode->hw) {
-		ret = av_hwframe_transfer_data(decode->frame, out_frame, 0);
-		if (ret < 0) {
+		if (!download_hw_frame(decode))
 			return false;
-		}
 	}
 #endif
 
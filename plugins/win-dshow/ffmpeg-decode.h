@@ -43,8 +43,14 @@ struct ffmpeg_decode {
 
 	AVFrame *hw_frame;
 	AVFrame *frame;
+	AVPacket *packet;
+	bool hw_requested;
 	bool hw;
 
+	/* a standalone hardware decoder (e.g. mjpeg_qsv) rather than a
+	 * hwaccel, falls back to software if it can't decode the stream */
+	bool hw_decoder;
+
 	uint8_t *packet_buffer;
 	size_t packet_size;
 };
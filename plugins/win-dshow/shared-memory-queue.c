@@ -1,13 +1,31 @@
 #include <windows.h>
+#include <wchar.h>
+#include <stdlib.h>
 #include "shared-memory-queue.h"
 #include "tiny-nv12-scale.h"
 
 #define VIDEO_NAME L"SLDVirtualCamVideo"
+#define RENDITION_NAME L"SLDVirtualCamVideo_%ux%u"
+
+/* Readers that want a different size than the output ask for it in one of
+ * the header's rendition slots and keep bumping its heartbeat while they
+ * read.  The writer scales each requested size once per frame in to its own
+ * mapping (named after the size), and drops slots that stop being read, so
+ * any number of readers at the same size share one rendition. */
+
+#define QUEUE_FLAG_RENDITIONS 1
+#define RENDITION_TIMEOUT_WRITES 90
+#define RENDITION_MAX_SIZE 8192
 
 enum queue_type {
 	SHARED_QUEUE_TYPE_VIDEO,
 };
 
+struct queue_rendition {
+	volatile long size;
+	volatile long heartbeat;
+};
+
 struct queue_header {
 	volatile uint32_t write_idx;
 	volatile uint32_t read_idx;
@@ -21,7 +39,35 @@ struct queue_header {
 	uint32_t cy;
 	uint64_t interval;
 
-	uint32_t reserved[8];
+	uint32_t flags;
+	uint32_t reserved[7];
+
+	/* only valid with QUEUE_FLAG_RENDITIONS, older writers don't have
+	 * them */
+	struct queue_rendition renditions[VIDEO_QUEUE_MAX_RENDITIONS];
+};
+
+struct rendition_header {
+	volatile uint32_t write_idx;
+	volatile uint32_t read_idx;
+
+	uint32_t offsets[3];
+
+	uint32_t cx;
+	uint32_t cy;
+};
+
+struct rendition_frame_header {
+	uint64_t ts;
+	uint32_t source_inc;
+};
+
+struct rendition_map {
+	uint32_t size;
+	HANDLE handle;
+	struct rendition_header *header;
+	long last_heartbeat;
+	int idle;
 };
 
 struct video_queue {
@@ -33,11 +79,45 @@ struct video_queue {
 	long last_inc;
 	int dup_counter;
 	bool is_writer;
+	bool writable;
+	uint64_t last_ts;
+
+	/* the writer keeps one per slot, a reader only uses the first */
+	struct rendition_map renditions[VIDEO_QUEUE_MAX_RENDITIONS];
+	nv12_scale_t *convert;
 };
 
 #define ALIGN_SIZE(size, align) size = (((size) + (align - 1)) & (~(align - 1)))
 #define FRAME_HEADER_SIZE 32
 
+static DWORD get_layout(DWORD header_size, DWORD frame_size,
+			uint32_t offset_frame[3])
+{
+	DWORD size = header_size;
+
+	ALIGN_SIZE(size, 32);
+
+	for (size_t i = 0; i < 3; i++) {
+		offset_frame[i] = size;
+		size += frame_size + FRAME_HEADER_SIZE;
+		ALIGN_SIZE(size, 32);
+	}
+
+	return size;
+}
+
+static inline uint32_t pack_size(uint32_t cx, uint32_t cy)
+{
+	return (cx << 16) | cy;
+}
+
+/* sizes come from other processes, so keep them sane before using them */
+static inline bool valid_rendition_size(uint32_t cx, uint32_t cy)
+{
+	return cx && cy && cx <= RENDITION_MAX_SIZE &&
+	       cy <= RENDITION_MAX_SIZE && ((cx | cy) & 1) == 0;
+}
+
 video_queue_t *video_queue_create(uint32_t cx, uint32_t cy, uint64_t interval)
 {
 	struct video_queue vq = {0};
@@ -46,21 +126,8 @@ video_queue_t *video_queue_create(uint32_t cx, uint32_t cy, uint64_t interval)
 	uint32_t offset_frame[3];
 	DWORD size;
 
-	size = sizeof(struct queue_header);
-
-	ALIGN_SIZE(size, 32);
-
-	offset_frame[0] = size;
-	size += frame_size + FRAME_HEADER_SIZE;
-	ALIGN_SIZE(size, 32);
-
-	offset_frame[1] = size;
-	size += frame_size + FRAME_HEADER_SIZE;
-	ALIGN_SIZE(size, 32);
-
-	offset_frame[2] = size;
-	size += frame_size + FRAME_HEADER_SIZE;
-	ALIGN_SIZE(size, 32);
+	size = get_layout(sizeof(struct queue_header), frame_size,
+			  offset_frame);
 
 	struct queue_header header = {0};
 
@@ -68,7 +135,9 @@ video_queue_t *video_queue_create(uint32_t cx, uint32_t cy, uint64_t interval)
 	header.cx = cx;
 	header.cy = cy;
 	header.interval = interval;
+	header.flags = QUEUE_FLAG_RENDITIONS;
 	vq.is_writer = true;
+	vq.writable = true;
 
 	for (size_t i = 0; i < 3; i++) {
 		uint32_t off = offset_frame[i];
@@ -113,14 +182,22 @@ video_queue_t *video_queue_create(uint32_t cx, uint32_t cy, uint64_t interval)
 video_queue_t *video_queue_open()
 {
 	struct video_queue vq = {0};
+	DWORD access = FILE_MAP_READ | FILE_MAP_WRITE;
 
-	vq.handle = OpenFileMappingW(FILE_MAP_READ, false, VIDEO_NAME);
+	/* write access is only needed to request renditions */
+	vq.handle = OpenFileMappingW(access, false, VIDEO_NAME);
+	if (vq.handle) {
+		vq.writable = true;
+	} else {
+		access = FILE_MAP_READ;
+		vq.handle = OpenFileMappingW(access, false, VIDEO_NAME);
+	}
 	if (!vq.handle) {
 		return NULL;
 	}
 
-	vq.header = (struct queue_header *)MapViewOfFile(
-		vq.handle, FILE_MAP_READ, 0, 0, 0);
+	vq.header = (struct queue_header *)MapViewOfFile(vq.handle, access, 0,
+							 0, 0);
 	if (!vq.header) {
 		CloseHandle(vq.handle);
 		return NULL;
@@ -135,6 +212,63 @@ video_queue_t *video_queue_open()
 	return pvq;
 }
 
+static void close_rendition(struct rendition_map *map)
+{
+	if (map->header)
+		UnmapViewOfFile(map->header);
+	if (map->handle)
+		CloseHandle(map->handle);
+
+	map->header = NULL;
+	map->handle = NULL;
+}
+
+static bool open_rendition(struct rendition_map *map, bool writer)
+{
+	uint32_t cx = map->size >> 16;
+	uint32_t cy = map->size & 0xFFFF;
+	DWORD access = writer ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ;
+	uint32_t offsets[3];
+	wchar_t name[64];
+	DWORD size;
+
+	if (!valid_rendition_size(cx, cy))
+		return false;
+
+	swprintf(name, 64, RENDITION_NAME, cx, cy);
+	size = get_layout(sizeof(struct rendition_header), cx * cy * 3 / 2,
+			  offsets);
+
+	/* the name is unique to the size, so a mapping that's still open
+	 * from a previous request always has the right layout */
+	if (writer)
+		map->handle = CreateFileMappingW(INVALID_HANDLE_VALUE, NULL,
+						 PAGE_READWRITE, 0, size, name);
+	else
+		map->handle = OpenFileMappingW(FILE_MAP_READ, false, name);
+	if (!map->handle)
+		return false;
+
+	map->header = (struct rendition_header *)MapViewOfFile(
+		map->handle, access, 0, 0, 0);
+	if (!map->header) {
+		close_rendition(map);
+		return false;
+	}
+
+	if (writer) {
+		map->header->read_idx = 0;
+		map->header->cx = cx;
+		map->header->cy = cy;
+		memcpy(map->header->offsets, offsets, sizeof(offsets));
+	} else if (map->header->cx != cx || map->header->cy != cy) {
+		close_rendition(map);
+		return false;
+	}
+
+	return true;
+}
+
 void video_queue_close(video_queue_t *vq)
 {
 	if (!vq) {
@@ -144,8 +278,12 @@ void video_queue_close(video_queue_t *vq)
 		vq->header->state = SHARED_QUEUE_STATE_STOPPING;
 	}
 
+	for (size_t i = 0; i < VIDEO_QUEUE_MAX_RENDITIONS; i++)
+		close_rendition(&vq->renditions[i]);
+
 	UnmapViewOfFile(vq->header);
 	CloseHandle(vq->handle);
+	free(vq->convert);
 	free(vq);
 }
 
@@ -167,11 +305,27 @@ void video_queue_write(video_queue_t *vq, uint8_t **data, uint32_t *linesize,
 	long inc = ++qh->write_idx;
 
 	unsigned long idx = get_idx(inc);
-	size_t size = linesize[0] * qh->cy;
+	vq->last_ts = timestamp;
+	uint32_t cx = qh->cx;
+	uint32_t cy = qh->cy;
+	size_t size = (size_t)cx * cy;
+	uint8_t *dst = vq->frame[idx];
 
 	*vq->ts[idx] = timestamp;
-	memcpy(vq->frame[idx], data[0], size);
-	memcpy(vq->frame[idx] + size, data[1], size / 2);
+
+	/* the frame is stored packed, a padded source has to be copied a
+	 * line at a time so it doesn't overrun the slot */
+	if (linesize[0] == cx && linesize[1] == cx) {
+		memcpy(dst, data[0], size);
+		memcpy(dst + size, data[1], size / 2);
+	} else {
+		for (uint32_t y = 0; y < cy; y++)
+			memcpy(dst + y * cx, data[0] + y * linesize[0], cx);
+
+		dst += size;
+		for (uint32_t y = 0; y < cy / 2; y++)
+			memcpy(dst + y * cx, data[1] + y * linesize[1], cx);
+	}
 
 	qh->read_idx = inc;
 	qh->state = SHARED_QUEUE_STATE_READY;
@@ -197,6 +351,139 @@ enum queue_state video_queue_state(video_queue_t *vq)
 	return state;
 }
 
+static inline uint8_t *rendition_frame(struct rendition_header *rh,
+				       unsigned long idx,
+				       struct rendition_frame_header **fh)
+{
+	uint8_t *base = (uint8_t *)rh + rh->offsets[idx];
+	*fh = (struct rendition_frame_header *)base;
+	return base + FRAME_HEADER_SIZE;
+}
+
+void video_queue_write_renditions(video_queue_t *vq, video_queue_scale_t scale,
+				  void *param)
+{
+	struct queue_header *qh = vq->header;
+
+	for (size_t i = 0; i < VIDEO_QUEUE_MAX_RENDITIONS; i++) {
+		struct queue_rendition *req = &qh->renditions[i];
+		struct rendition_map *map = &vq->renditions[i];
+		uint32_t size = (uint32_t)req->size;
+		long heartbeat = req->heartbeat;
+
+		if (size != map->size) {
+			close_rendition(map);
+			map->size = size;
+			map->last_heartbeat = heartbeat;
+			map->idle = 0;
+
+			if (size)
+				open_rendition(map, true);
+		}
+
+		if (!size)
+			continue;
+
+		if (heartbeat != map->last_heartbeat) {
+			map->last_heartbeat = heartbeat;
+			map->idle = 0;
+
+		} else if (++map->idle >= RENDITION_TIMEOUT_WRITES) {
+			/* every reader of it has gone away */
+			InterlockedCompareExchange(&req->size, 0, (long)size);
+			close_rendition(map);
+			map->size = 0;
+			continue;
+		}
+
+		struct rendition_header *rh = map->header;
+		if (!rh)
+			continue;
+
+		struct rendition_frame_header *fh;
+		uint32_t inc = ++rh->write_idx;
+		uint8_t *frame = rendition_frame(rh, get_idx(inc), &fh);
+		uint8_t *data[2] = {frame, frame + rh->cx * rh->cy};
+		uint32_t linesize[2] = {rh->cx, rh->cx};
+
+		if (!scale(param, rh->cx, rh->cy, data, linesize))
+			continue;
+
+		fh->ts = vq->last_ts;
+		fh->source_inc = qh->read_idx;
+		rh->read_idx = inc;
+	}
+}
+
+static bool request_rendition(struct queue_header *qh, uint32_t size)
+{
+	for (size_t i = 0; i < VIDEO_QUEUE_MAX_RENDITIONS; i++) {
+		struct queue_rendition *req = &qh->renditions[i];
+		if ((uint32_t)req->size == size) {
+			InterlockedIncrement(&req->heartbeat);
+			return true;
+		}
+	}
+
+	for (size_t i = 0; i < VIDEO_QUEUE_MAX_RENDITIONS; i++) {
+		struct queue_rendition *req = &qh->renditions[i];
+		long prev = InterlockedCompareExchange(&req->size, (long)size,
+						       0);
+		if (prev == 0) {
+			InterlockedIncrement(&req->heartbeat);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static bool read_rendition(struct video_queue *vq, const nv12_scale_t *scale,
+			   void *dst, uint64_t *ts, long inc)
+{
+	struct queue_header *qh = vq->header;
+	struct rendition_map *map = &vq->renditions[0];
+	uint32_t cx = (uint32_t)scale->dst_cx;
+	uint32_t cy = (uint32_t)scale->dst_cy;
+	uint32_t size = pack_size(cx, cy);
+
+	if (!vq->writable || (qh->flags & QUEUE_FLAG_RENDITIONS) == 0)
+		return false;
+	if (!valid_rendition_size(cx, cy))
+		return false;
+	if (!request_rendition(qh, size))
+		return false;
+
+	if (map->size != size) {
+		close_rendition(map);
+		map->size = size;
+	}
+	if (!map->header && !open_rendition(map, false))
+		return false;
+
+	struct rendition_header *rh = map->header;
+	uint32_t rinc = rh->read_idx;
+	if (!rinc)
+		return false;
+
+	/* the writer stopped producing it, or is running behind */
+	struct rendition_frame_header *fh;
+	uint8_t *frame = rendition_frame(rh, get_idx(rinc), &fh);
+	if ((uint32_t)inc - fh->source_inc > 1)
+		return false;
+
+	if (!vq->convert) {
+		vq->convert = malloc(sizeof(*vq->convert));
+		if (!vq->convert)
+			return false;
+	}
+
+	nv12_scale_init(vq->convert, scale->format, cx, cy, cx, cy);
+	nv12_do_scale(vq->convert, dst, frame);
+	*ts = fh->ts;
+	return true;
+}
+
 bool video_queue_read(video_queue_t *vq, nv12_scale_t *scale, void *dst,
 		      uint64_t *ts)
 {
@@ -216,6 +503,11 @@ bool video_queue_read(video_queue_t *vq, nv12_scale_t *scale, void *dst,
 		vq->last_inc = inc;
 	}
 
+	if (scale->dst_cx != scale->src_cx || scale->dst_cy != scale->src_cy) {
+		if (read_rendition(vq, scale, dst, ts, inc))
+			return true;
+	}
+
 	unsigned long idx = get_idx(inc);
 
 	*ts = *vq->ts[idx];
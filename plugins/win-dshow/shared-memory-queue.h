@@ -12,6 +12,11 @@ struct nv12_scale;
 typedef struct video_queue video_queue_t;
 typedef struct nv12_scale nv12_scale_t;
 
+#define VIDEO_QUEUE_MAX_RENDITIONS 4
+
+typedef bool (*video_queue_scale_t)(void *param, uint32_t cx, uint32_t cy,
+				    uint8_t *data[2], uint32_t linesize[2]);
+
 enum queue_state {
 	SHARED_QUEUE_STATE_INVALID,
 	SHARED_QUEUE_STATE_STARTING,
@@ -28,6 +33,9 @@ extern void video_queue_get_info(video_queue_t *vq, uint32_t *cx, uint32_t *cy,
 				 uint64_t *interval);
 extern void video_queue_write(video_queue_t *vq, uint8_t **data,
 			      uint32_t *linesize, uint64_t timestamp);
+extern void video_queue_write_renditions(video_queue_t *vq,
+					 video_queue_scale_t scale,
+					 void *param);
 extern enum queue_state video_queue_state(video_queue_t *vq);
 extern bool video_queue_read(video_queue_t *vq, nv12_scale_t *scale, void *dst,
 			     uint64_t *ts);
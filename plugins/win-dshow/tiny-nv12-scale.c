@@ -16,6 +16,36 @@ void nv12_scale_init(nv12_scale_t *s, enum target_format format, int dst_cx,
 
 	s->dst_cx = dst_cx;
 	s->dst_cy = dst_cy;
+
+	if (src_cx == dst_cx && src_cy == dst_cy)
+		return;
+
+	const int src_cx_d2 = src_cx / 2;
+	const int dst_cx_d2 = dst_cx / 2;
+
+	for (int x = 0; x < dst_cx && x < NV12_SCALE_MAX_CX; x++)
+		s->lum_x[x] = (uint16_t)(x * src_cx / dst_cx);
+
+	/* yuy2 picks chroma from the half width planes directly */
+	for (int x = 0; x < dst_cx_d2 && x < NV12_SCALE_MAX_CX / 2; x++)
+		s->uv_x[x] = (uint16_t)(format == TARGET_FORMAT_YUY2
+						? x * src_cx_d2 / dst_cx_d2
+						: x * src_cx / dst_cx);
+}
+
+static inline int get_lum_x(const nv12_scale_t *s, int x)
+{
+	return x < NV12_SCALE_MAX_CX ? s->lum_x[x] : x * s->src_cx / s->dst_cx;
+}
+
+static inline int get_uv_x(const nv12_scale_t *s, int x)
+{
+	if (x < NV12_SCALE_MAX_CX / 2)
+		return s->uv_x[x];
+
+	return s->format == TARGET_FORMAT_YUY2
+		       ? x * (s->src_cx / 2) / (s->dst_cx / 2)
+		       : x * s->src_cx / s->dst_cx;
 }
 
 static void nv12_scale_nearest(nv12_scale_t *s, uint8_t *dst_start,
@@ -32,7 +62,7 @@ static void nv12_scale_nearest(nv12_scale_t *s, uint8_t *dst_start,
 		const int src_line = y * src_cy / dst_cy * s->src_cx;
 
 		for (int x = 0; x < dst_cx; x++) {
-			const int src_x = x * src_cx / dst_cx;
+			const int src_x = get_lum_x(s, x);
 
 			*(dst++) = src[src_line + src_x];
 		}
@@ -48,7 +78,7 @@ static void nv12_scale_nearest(nv12_scale_t *s, uint8_t *dst_start,
 		const int src_line = y * src_cy / dst_cy * src_cx;
 
 		for (int x = 0; x < dst_cx_d2; x++) {
-			const int src_x = x * src_cx / dst_cx * 2;
+			const int src_x = get_uv_x(s, x) * 2;
 			const int pos = src_line + src_x;
 
 			*(dst++) = src[pos];
@@ -72,7 +102,7 @@ static void nv12_scale_nearest_to_i420(nv12_scale_t *s, uint8_t *dst_start,
 		const int src_line = y * src_cy / dst_cy * s->src_cx;
 
 		for (int x = 0; x < dst_cx; x++) {
-			const int src_x = x * src_cx / dst_cx;
+			const int src_x = get_lum_x(s, x);
 
 			*(dst++) = src[src_line + src_x];
 		}
@@ -90,7 +120,7 @@ static void nv12_scale_nearest_to_i420(nv12_scale_t *s, uint8_t *dst_start,
 		const int src_line = y * src_cy / dst_cy * src_cx;
 
 		for (int x = 0; x < dst_cx_d2; x++) {
-			const int src_x = x * src_cx / dst_cx * 2;
+			const int src_x = get_uv_x(s, x) * 2;
 			const int pos = src_line + src_x;
 
 			*(dst++) = src[pos];
@@ -126,9 +156,7 @@ static void nv12_scale_nearest_to_yuy2(nv12_scale_t *s, uint8_t *dst_start,
 	const int src_cy = s->src_cy;
 	const int dst_cx = s->dst_cx;
 	const int dst_cy = s->dst_cy;
-	const int src_cx_d2 = src_cx / 2;
 	const int src_cy_d2 = src_cy / 2;
-	const int dst_cx_d2 = dst_cx / 2;
 	const int dst_cy_d2 = dst_cy / 2;
 	const int size = src_cx * src_cy;
 
@@ -142,8 +170,8 @@ static void nv12_scale_nearest_to_yuy2(nv12_scale_t *s, uint8_t *dst_start,
 			y / 2 * src_cy_d2 / dst_cy_d2 * s->src_cx;
 
 		for (int x = 0; x < dst_cx; x++) {
-			const int src_x = x * src_cx / dst_cx;
-			const int src_x_d2 = x / 2 * src_cx_d2 / dst_cx_d2;
+			const int src_x = get_lum_x(s, x);
+			const int src_x_d2 = get_uv_x(s, x / 2);
 			const int pos = src_line + src_x;
 			const int pos_uv = src_line_d2 + src_x_d2 * 2 + uv_flip;
 
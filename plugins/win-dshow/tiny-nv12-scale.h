@@ -13,6 +13,10 @@ enum target_format {
 	TARGET_FORMAT_YUY2,
 };
 
+/* source columns are looked up rather than divided out for every pixel,
+ * wider outputs fall back to dividing past this point */
+#define NV12_SCALE_MAX_CX 8192
+
 struct nv12_scale {
 	enum target_format format;
 
@@ -21,6 +25,9 @@ struct nv12_scale {
 
 	int dst_cx;
 	int dst_cy;
+
+	uint16_t lum_x[NV12_SCALE_MAX_CX];
+	uint16_t uv_x[NV12_SCALE_MAX_CX / 2];
 };
 
 typedef struct nv12_scale nv12_scale_t;
@@ -48,3 +48,41 @@ bool sleepto_100ns(uint64_t time_target)
 		Sleep(0);
 	}
 }
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+/* high resolution timers are Windows 10 1803 and up, older versions get no
+ * timer and keep spinning in sleepto_100ns */
+HANDLE create_frame_timer(void)
+{
+	return CreateWaitableTimerExW(NULL, NULL,
+				      CREATE_WAITABLE_TIMER_HIGH_RESOLUTION,
+				      TIMER_ALL_ACCESS);
+}
+
+/* returns false once the stop event has been signalled */
+bool waitto_100ns(HANDLE timer, HANDLE stop, uint64_t time_target)
+{
+	uint64_t t = gettime_100ns();
+	LARGE_INTEGER due;
+
+	if (!timer) {
+		sleepto_100ns(time_target);
+		return WaitForSingleObject(stop, 0) == WAIT_TIMEOUT;
+	}
+
+	if (t >= time_target)
+		return WaitForSingleObject(stop, 0) == WAIT_TIMEOUT;
+
+	/* negative is relative to now */
+	due.QuadPart = -(LONGLONG)(time_target - t);
+	if (!SetWaitableTimer(timer, &due, 0, NULL, NULL, false)) {
+		sleepto_100ns(time_target);
+		return WaitForSingleObject(stop, 0) == WAIT_TIMEOUT;
+	}
+
+	HANDLE h[2] = {timer, stop};
+	return WaitForMultipleObjects(2, h, false, INFINITE) == WAIT_OBJECT_0;
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <windows.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -9,6 +11,9 @@ extern "C" {
 extern uint64_t gettime_100ns(void);
 extern bool sleepto_100ns(uint64_t time_target);
 
+extern HANDLE create_frame_timer(void);
+extern bool waitto_100ns(HANDLE timer, HANDLE stop, uint64_t time_target);
+
 #ifdef __cplusplus
 }
 #endif
@@ -201,10 +201,14 @@ void VCamFilter::Thread()
 
 	UpdatePlaceholder();
 
+	/* waits on a timer rather than spinning until each frame is due */
+	WinHandle timer = create_frame_timer();
+
 	while (!stopped()) {
 		if (os_atomic_load_bool(&active))
 			Frame(filter_time);
-		sleepto_100ns(cur_time += interval);
+		if (!waitto_100ns(timer, thread_stop, cur_time += interval))
+			break;
 		filter_time += interval;
 	}
 }
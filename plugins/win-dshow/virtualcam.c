@@ -1,15 +1,37 @@
 #include <obs-module.h>
+#include <media-io/video-scaler.h>
 #include <util/platform.h>
 #include "util/threading.h"
 #include "shared-memory-queue.h"
 
+/* one per size readers have asked for, so each is only scaled once no
+ * matter how many readers want it */
+struct rendition_scaler {
+	uint32_t cx;
+	uint32_t cy;
+	video_scaler_t *scaler;
+	bool used;
+};
+
 struct virtualcam_data {
 	obs_output_t *output;
 	video_queue_t *vq;
 	volatile bool active;
 	volatile bool stopping;
+
+	struct video_scale_info vsi;
+	struct video_data *frame;
+	struct rendition_scaler scalers[VIDEO_QUEUE_MAX_RENDITIONS];
 };
 
+static void free_scalers(struct virtualcam_data *vcam)
+{
+	for (size_t i = 0; i < VIDEO_QUEUE_MAX_RENDITIONS; i++) {
+		video_scaler_destroy(vcam->scalers[i].scaler);
+		memset(&vcam->scalers[i], 0, sizeof(vcam->scalers[i]));
+	}
+}
+
 static const char *virtualcam_name(void *unused)
 {
 	UNUSED_PARAMETER(unused);
@@ -20,6 +42,7 @@ static void virtualcam_destroy(void *data)
 {
 	struct virtualcam_data *vcam = (struct virtualcam_data *)data;
 	video_queue_close(vcam->vq);
+	free_scalers(vcam);
 	bfree(data);
 }
 
@@ -64,6 +87,7 @@ static bool virtualcam_start(void *data)
 	vsi.width = width;
 	vsi.height = height;
 	obs_output_set_video_conversion(vcam->output, &vsi);
+	vcam->vsi = vsi;
 
 	os_atomic_set_bool(&vcam->active, true);
 	os_atomic_set_bool(&vcam->stopping, false);
@@ -77,6 +101,7 @@ static void virtualcam_deactive(struct virtualcam_data *vcam)
 	obs_output_end_data_capture(vcam->output);
 	video_queue_close(vcam->vq);
 	vcam->vq = NULL;
+	free_scalers(vcam);
 
 	os_atomic_set_bool(&vcam->active, false);
 	os_atomic_set_bool(&vcam->stopping, false);
@@ -94,6 +119,52 @@ static void virtualcam_stop(void *data, uint64_t ts)
 	UNUSED_PARAMETER(ts);
 }
 
+static video_scaler_t *get_scaler(struct virtualcam_data *vcam, uint32_t cx,
+				   uint32_t cy)
+{
+	struct rendition_scaler *free_rs = NULL;
+
+	for (size_t i = 0; i < VIDEO_QUEUE_MAX_RENDITIONS; i++) {
+		struct rendition_scaler *rs = &vcam->scalers[i];
+		if (rs->scaler && rs->cx == cx && rs->cy == cy) {
+			rs->used = true;
+			return rs->scaler;
+		}
+		if (!rs->scaler && !free_rs)
+			free_rs = rs;
+	}
+
+	if (!free_rs)
+		return NULL;
+
+	struct video_scale_info dst = vcam->vsi;
+	dst.width = cx;
+	dst.height = cy;
+
+	if (video_scaler_create(&free_rs->scaler, &dst, &vcam->vsi,
+				VIDEO_SCALE_BILINEAR) != VIDEO_SCALER_SUCCESS) {
+		free_rs->scaler = NULL;
+		return NULL;
+	}
+
+	free_rs->cx = cx;
+	free_rs->cy = cy;
+	free_rs->used = true;
+	return free_rs->scaler;
+}
+
+static bool scale_rendition(void *param, uint32_t cx, uint32_t cy,
+			    uint8_t *data[2], uint32_t linesize[2])
+{
+	struct virtualcam_data *vcam = (struct virtualcam_data *)param;
+	struct video_data *frame = vcam->frame;
+	video_scaler_t *scaler = get_scaler(vcam, cx, cy);
+
+	return scaler && video_scaler_scale(scaler, data, linesize,
+					    (const uint8_t *const *)frame->data,
+					    frame->linesize);
+}
+
 static void virtual_video(void *param, struct video_data *frame)
 {
 	struct virtualcam_data *vcam = (struct virtualcam_data *)param;
@@ -111,6 +182,22 @@ static void virtual_video(void *param, struct video_data *frame)
 
 	video_queue_write(vcam->vq, frame->data, frame->linesize,
 			  frame->timestamp);
+
+	for (size_t i = 0; i < VIDEO_QUEUE_MAX_RENDITIONS; i++)
+		vcam->scalers[i].used = false;
+
+	vcam->frame = frame;
+	video_queue_write_renditions(vcam->vq, scale_rendition, vcam);
+	vcam->frame = NULL;
+
+	/* sizes nobody reads any more */
+	for (size_t i = 0; i < VIDEO_QUEUE_MAX_RENDITIONS; i++) {
+		struct rendition_scaler *rs = &vcam->scalers[i];
+		if (rs->scaler && !rs->used) {
+			video_scaler_destroy(rs->scaler);
+			memset(rs, 0, sizeof(*rs));
+		}
+	}
 }
 
 struct obs_output_info virtualcam_info = {
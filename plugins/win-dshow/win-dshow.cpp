@@ -504,7 +504,7 @@ void DShowInput::OnEncodedVideoData(enum AVCodecID id, unsigned char *data,
 	/* If format or hw decode changes, recreate the decoder */
 	if (ffmpeg_decode_valid(video_decoder) &&
 	    ((video_decoder->codec->id != id) ||
-	     (video_decoder->hw != hw_decode))) {
+	     (video_decoder->hw_requested != hw_decode))) {
 		ffmpeg_decode_free(video_decoder);
 	}
 
@@ -252,6 +252,7 @@ class WASAPISource {
 	uint32_t sampleRate;
 
 	uint64_t framesProcessed = 0;
+	uint64_t processStartTs = 0;
 
 	static DWORD WINAPI ReconnectThread(LPVOID param);
 	static DWORD WINAPI CaptureThread(LPVOID param);
@@ -799,6 +800,44 @@ static DWORD GetSpeakerChannelMask(speaker_layout layout)
 	return (DWORD)layout;
 }
 
+/* IAudioClient3 lets a shared mode stream run at the smallest period the audio
+ * engine supports, often a few milliseconds rather than 10, so packets are
+ * delivered sooner.  loopback streams follow whatever period the render
+ * endpoint runs at, so this is only tried for input devices.  the period can
+ * be locked by another stream on the endpoint, in which case the regular
+ * initialization is used instead */
+static bool InitLowLatencyClient(IAudioClient *client, DWORD flags,
+				 const WAVEFORMATEX *pFormat)
+{
+	ComPtr<IAudioClient3> client3;
+	HRESULT res = client->QueryInterface(IID_PPV_ARGS(client3.Assign()));
+	if (FAILED(res))
+		return false;
+
+	UINT32 defaultPeriod, fundamentalPeriod, minPeriod, maxPeriod;
+	res = client3->GetSharedModeEnginePeriod(pFormat, &defaultPeriod,
+						 &fundamentalPeriod, &minPeriod,
+						 &maxPeriod);
+	if (FAILED(res) || minPeriod >= defaultPeriod)
+		return false;
+
+	res = client3->InitializeSharedAudioStream(flags, minPeriod, pFormat,
+						   nullptr);
+	if (FAILED(res)) {
+		blog(LOG_INFO,
+		     "[WASAPISource]: Low latency stream not available (%lX),"
+		     " using the default period",
+		     res);
+		return false;
+	}
+
+	blog(LOG_INFO,
+	     "[WASAPISource]: Using a %" PRIu32 " frame engine period"
+	     " (default %" PRIu32 ")",
+	     minPeriod, defaultPeriod);
+	return true;
+}
+
 ComPtr<IAudioClient> WASAPISource::InitClient(
 	IMMDevice *device, SourceType type, DWORD process_id,
 	PFN_ActivateAudioInterfaceAsync activate_audio_interface_async,
@@ -890,6 +929,9 @@ ComPtr<IAudioClient> WASAPISource::InitClient(
 	DWORD flags = AUDCLNT_STREAMFLAGS_EVENTCALLBACK;
 	if (type != SourceType::Input)
 		flags |= AUDCLNT_STREAMFLAGS_LOOPBACK;
+	else if (InitLowLatencyClient(client, flags, pFormat))
+		return client;
+
 	res = client->Initialize(AUDCLNT_SHAREMODE_SHARED, flags,
 				 BUFFER_TIME_100NS, 0, pFormat, nullptr);
 	if (FAILED(res))
@@ -1023,6 +1065,7 @@ void WASAPISource::Initialize()
 	}
 
 	ResetEvent(receiveSignal);
+	framesProcessed = 0;
 
 	ComPtr<IAudioClient> temp_client = InitClient(
 		device, sourceType, process_id, activate_audio_interface_async,
@@ -1129,6 +1172,23 @@ DWORD WINAPI WASAPISource::ReconnectThread(LPVOID param)
 	return 0;
 }
 
+/* QPC positions are in 100ns units of the same clock os_gettime_ns uses, and
+ * say when the first frame of the packet was captured.  some drivers report
+ * nonsense though, so a position is only trusted if it's reasonably close to
+ * when the packet is estimated to have started */
+#define MAX_QPC_POSITION_ERROR_NS 200000000ULL
+
+static inline bool QPCPositionValid(DWORD flags, uint64_t qpc_ns,
+				    uint64_t expected_ns)
+{
+	if ((flags & AUDCLNT_BUFFERFLAGS_TIMESTAMP_ERROR) != 0 || !qpc_ns)
+		return false;
+
+	uint64_t diff = qpc_ns > expected_ns ? qpc_ns - expected_ns
+					     : expected_ns - qpc_ns;
+	return diff < MAX_QPC_POSITION_ERROR_NS;
+}
+
 bool WASAPISource::ProcessCaptureData()
 {
 	HRESULT res;
@@ -1177,19 +1237,37 @@ bool WASAPISource::ProcessCaptureData()
 		data.speakers = speakers;
 		data.samples_per_sec = sampleRate;
 		data.format = format;
+
+		const uint64_t duration = util_mul_div64(
+			frames, UINT64_C(1000000000), sampleRate);
+		const uint64_t expected = os_gettime_ns() - duration;
+		const uint64_t qpc_ns = ts * 100;
+		const bool qpc_valid =
+			QPCPositionValid(flags, qpc_ns, expected);
+
 		if (sourceType == SourceType::ProcessOutput) {
-			data.timestamp = util_mul_div64(framesProcessed,
+			/* process loopback packets are counted from the start
+			 * of the stream so they stay evenly spaced, and are
+			 * only placed on the system clock again when the
+			 * stream starts or skips */
+			if (!framesProcessed ||
+			    (flags & AUDCLNT_BUFFERFLAGS_DATA_DISCONTINUITY)) {
+				processStartTs =
+					(qpc_valid ? qpc_ns : expected) -
+					util_mul_div64(framesProcessed,
+						       UINT64_C(1000000000),
+						       sampleRate);
+			}
+
+			data.timestamp = processStartTs +
+					 util_mul_div64(framesProcessed,
 							UINT64_C(1000000000),
 							sampleRate);
 			framesProcessed += frames;
+		} else if (useDeviceTiming || qpc_valid) {
+			data.timestamp = qpc_ns;
 		} else {
-			data.timestamp = useDeviceTiming ? ts * 100
-							 : os_gettime_ns();
-
-			if (!useDeviceTiming)
-				data.timestamp -= util_mul_div64(
-					frames, UINT64_C(1000000000),
-					sampleRate);
+			data.timestamp = expected;
 		}
 
 		obs_source_output_audio(source, &data);
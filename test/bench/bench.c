@@ -0,0 +1,747 @@
+/******************************************************************************
+    Copyright (C) 2023 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+
+#include <util/bmem.h>
+#include <util/dstr.h>
+#include <util/platform.h>
+#include <util/threading.h>
+#include <util/util_uint64.h>
+#include <obs.h>
+
+/* Headless throughput benchmark.  No display is ever created: the canvas is
+ * filled with synthetic sources, encoded into a null output, and the libobs
+ * timing counters are sampled once the run has settled and printed as JSON.
+ * Numbers are only comparable between runs on the same machine. */
+
+#ifndef M_PI
+#define M_PI 3.1415926535897932384626433832795
+#endif
+
+#define PATTERN_SIZE 256
+#define TONE_FRAMES 480
+
+struct bench_config {
+	uint32_t width;
+	uint32_t height;
+	uint32_t fps_num;
+	uint32_t fps_den;
+	int textures;
+	int async_sources;
+	int tones;
+	int warmup;
+	int duration;
+	const char *video_encoder;
+	const char *audio_encoder;
+	const char *graphics_module;
+	const char *output_path;
+};
+
+/* ------------------------------------------------------------------------- */
+/* procedural texture source (sync, re-uploaded every frame)                 */
+
+struct bench_texture {
+	gs_texture_t *tex;
+	uint32_t *pixels;
+	uint32_t frame;
+};
+
+static const char *bench_texture_get_name(void *unused)
+{
+	UNUSED_PARAMETER(unused);
+	return "Benchmark Texture";
+}
+
+static void *bench_texture_create(obs_data_t *settings, obs_source_t *source)
+{
+	struct bench_texture *bt = bzalloc(sizeof(*bt));
+	bt->pixels = bmalloc(PATTERN_SIZE * PATTERN_SIZE * 4);
+	bt->frame = (uint32_t)rand();
+
+	UNUSED_PARAMETER(settings);
+	UNUSED_PARAMETER(source);
+	return bt;
+}
+
+static void bench_texture_destroy(void *data)
+{
+	struct bench_texture *bt = data;
+
+	obs_enter_graphics();
+	gs_texture_destroy(bt->tex);
+	obs_leave_graphics();
+
+	bfree(bt->pixels);
+	bfree(bt);
+}
+
+static void fill_pattern(struct bench_texture *bt)
+{
+	const uint32_t f = bt->frame++;
+
+	for (uint32_t y = 0; y < PATTERN_SIZE; y++) {
+		uint32_t *line = bt->pixels + y * PATTERN_SIZE;
+
+		for (uint32_t x = 0; x < PATTERN_SIZE; x++)
+			line[x] = 0xFF000000 | (((x + f) & 0xFF) << 16) |
+				  (((y + f * 2) & 0xFF) << 8) |
+				  ((x ^ y ^ f) & 0xFF);
+	}
+}
+
+static void bench_texture_render(void *data, gs_effect_t *effect)
+{
+	struct bench_texture *bt = data;
+	struct obs_video_info ovi;
+
+	fill_pattern(bt);
+
+	if (!bt->tex)
+		bt->tex = gs_texture_create(PATTERN_SIZE, PATTERN_SIZE, GS_BGRA,
+					    1, NULL, GS_DYNAMIC);
+	if (!bt->tex)
+		return;
+
+	gs_texture_set_image(bt->tex, (const uint8_t *)bt->pixels,
+			     PATTERN_SIZE * 4, false);
+
+	obs_get_video_info(&ovi);
+	obs_source_draw(bt->tex, 0, 0, ovi.base_width, ovi.base_height, false);
+
+	UNUSED_PARAMETER(effect);
+}
+
+static uint32_t bench_texture_get_width(void *data)
+{
+	struct obs_video_info ovi;
+	obs_get_video_info(&ovi);
+
+	UNUSED_PARAMETER(data);
+	return ovi.base_width;
+}
+
+static uint32_t bench_texture_get_height(void *data)
+{
+	struct obs_video_info ovi;
+	obs_get_video_info(&ovi);
+
+	UNUSED_PARAMETER(data);
+	return ovi.base_height;
+}
+
+static struct obs_source_info bench_texture_info = {
+	.id = "bench_texture",
+	.type = OBS_SOURCE_TYPE_INPUT,
+	.output_flags = OBS_SOURCE_VIDEO,
+	.get_name = bench_texture_get_name,
+	.create = bench_texture_create,
+	.destroy = bench_texture_destroy,
+	.video_render = bench_texture_render,
+	.get_width = bench_texture_get_width,
+	.get_height = bench_texture_get_height,
+};
+
+/* ------------------------------------------------------------------------- */
+/* async source (NV12 frames at the canvas size and frame rate)              */
+
+struct bench_async {
+	obs_source_t *source;
+	os_event_t *stop_signal;
+	pthread_t thread;
+	bool initialized;
+};
+
+static const char *bench_async_get_name(void *unused)
+{
+	UNUSED_PARAMETER(unused);
+	return "Benchmark Async Video";
+}
+
+static void *bench_async_thread(void *data)
+{
+	struct bench_async *ba = data;
+	struct obs_video_info ovi;
+	struct obs_source_frame frame = {0};
+	uint64_t interval;
+	uint64_t cur_time;
+	uint8_t *mem;
+
+	obs_get_video_info(&ovi);
+	interval = util_mul_div64(1000000000ULL, ovi.fps_den, ovi.fps_num);
+
+	const uint32_t cx = ovi.base_width & ~1;
+	const uint32_t cy = ovi.base_height & ~1;
+	mem = bmalloc(cx * cy * 3 / 2);
+	memset(mem, 0x80, cx * cy * 3 / 2);
+
+	frame.data[0] = mem;
+	frame.data[1] = mem + cx * cy;
+	frame.linesize[0] = cx;
+	frame.linesize[1] = cx;
+	frame.width = cx;
+	frame.height = cy;
+	frame.format = VIDEO_FORMAT_NV12;
+	video_format_get_parameters_for_format(
+		VIDEO_CS_709, VIDEO_RANGE_PARTIAL, VIDEO_FORMAT_NV12,
+		frame.color_matrix, frame.color_range_min,
+		frame.color_range_max);
+
+	cur_time = os_gettime_ns();
+
+	for (uint32_t i = 0; os_event_try(ba->stop_signal) == EAGAIN; i++) {
+		/* touch one line per frame so every frame differs */
+		memset(mem + (i % cy) * cx, i & 0xFF, cx);
+
+		frame.timestamp = cur_time;
+		obs_source_output_video(ba->source, &frame);
+
+		if (!os_sleepto_ns(cur_time += interval))
+			cur_time = os_gettime_ns();
+	}
+
+	bfree(mem);
+	return NULL;
+}
+
+static void bench_async_destroy(void *data)
+{
+	struct bench_async *ba = data;
+
+	if (ba->initialized) {
+		os_event_signal(ba->stop_signal);
+		pthread_join(ba->thread, NULL);
+	}
+
+	os_event_destroy(ba->stop_signal);
+	bfree(ba);
+}
+
+static void *bench_async_create(obs_data_t *settings, obs_source_t *source)
+{
+	struct bench_async *ba = bzalloc(sizeof(*ba));
+	ba->source = source;
+
+	if (os_event_init(&ba->stop_signal, OS_EVENT_TYPE_MANUAL) != 0)
+		goto fail;
+	if (pthread_create(&ba->thread, NULL, bench_async_thread, ba) != 0)
+		goto fail;
+
+	ba->initialized = true;
+
+	UNUSED_PARAMETER(settings);
+	return ba;
+
+fail:
+	bench_async_destroy(ba);
+	return NULL;
+}
+
+static struct obs_source_info bench_async_info = {
+	.id = "bench_async",
+	.type = OBS_SOURCE_TYPE_INPUT,
+	.output_flags = OBS_SOURCE_ASYNC_VIDEO,
+	.get_name = bench_async_get_name,
+	.create = bench_async_create,
+	.destroy = bench_async_destroy,
+};
+
+/* ------------------------------------------------------------------------- */
+/* tone source (float stereo sine, each instance a different pitch)          */
+
+struct bench_tone {
+	obs_source_t *source;
+	os_event_t *stop_signal;
+	pthread_t thread;
+	double rate;
+	bool initialized;
+};
+
+static const char *bench_tone_get_name(void *unused)
+{
+	UNUSED_PARAMETER(unused);
+	return "Benchmark Tone";
+}
+
+static void *bench_tone_thread(void *data)
+{
+	struct bench_tone *bt = data;
+	float samples[TONE_FRAMES];
+	uint64_t cur_time = os_gettime_ns();
+	double phase = 0.0;
+
+	struct obs_source_audio audio = {
+		.data = {[0] = (uint8_t *)samples, [1] = (uint8_t *)samples},
+		.frames = TONE_FRAMES,
+		.speakers = SPEAKERS_STEREO,
+		.format = AUDIO_FORMAT_FLOAT_PLANAR,
+		.samples_per_sec = 48000,
+	};
+
+	while (os_event_try(bt->stop_signal) == EAGAIN) {
+		for (size_t i = 0; i < TONE_FRAMES; i++) {
+			phase += bt->rate * M_PI * 2.0;
+			if (phase > M_PI * 2.0)
+				phase -= M_PI * 2.0;
+			samples[i] = (float)(sin(phase) * 0.1);
+		}
+
+		audio.timestamp = cur_time;
+		obs_source_output_audio(bt->source, &audio);
+
+		if (!os_sleepto_ns(cur_time += 10000000))
+			cur_time = os_gettime_ns();
+	}
+
+	return NULL;
+}
+
+static void bench_tone_destroy(void *data)
+{
+	struct bench_tone *bt = data;
+
+	if (bt->initialized) {
+		os_event_signal(bt->stop_signal);
+		pthread_join(bt->thread, NULL);
+	}
+
+	os_event_destroy(bt->stop_signal);
+	bfree(bt);
+}
+
+static void *bench_tone_create(obs_data_t *settings, obs_source_t *source)
+{
+	struct bench_tone *bt = bzalloc(sizeof(*bt));
+	bt->source = source;
+	bt->rate = obs_data_get_double(settings, "frequency") / 48000.0;
+
+	if (os_event_init(&bt->stop_signal, OS_EVENT_TYPE_MANUAL) != 0)
+		goto fail;
+	if (pthread_create(&bt->thread, NULL, bench_tone_thread, bt) != 0)
+		goto fail;
+
+	bt->initialized = true;
+	return bt;
+
+fail:
+	bench_tone_destroy(bt);
+	return NULL;
+}
+
+static struct obs_source_info bench_tone_info = {
+	.id = "bench_tone",
+	.type = OBS_SOURCE_TYPE_INPUT,
+	.output_flags = OBS_SOURCE_AUDIO,
+	.get_name = bench_tone_get_name,
+	.create = bench_tone_create,
+	.destroy = bench_tone_destroy,
+};
+
+/* ------------------------------------------------------------------------- */
+/* results                                                                   */
+
+struct bench_results {
+	uint64_t frame_time_ns;
+	uint64_t stage_ns[OBS_GPU_STAGE_COUNT];
+	uint64_t encode_time_ns;
+	uint32_t rendered_frames;
+	uint32_t lagged_frames;
+	uint32_t encoded_frames;
+	uint32_t skipped_frames;
+	uint32_t audio_buffering_ms;
+	double cpu_usage;
+	double gpu_usage;
+};
+
+struct bench_counters {
+	uint32_t total;
+	uint32_t lagged;
+	uint32_t video_total;
+	uint32_t skipped;
+};
+
+static void get_counters(struct bench_counters *c)
+{
+	video_t *video = obs_get_video();
+
+	c->total = obs_get_total_frames();
+	c->lagged = obs_get_lagged_frames();
+	c->video_total = video_output_get_total_frames(video);
+	c->skipped = video_output_get_skipped_frames(video);
+}
+
+static void write_results(FILE *f, const struct bench_config *cfg,
+			  const struct bench_results *r)
+{
+	static const char *stage_names[OBS_GPU_STAGE_COUNT] = {
+		"main_texture", "output_texture", "convert_texture",
+		"stage_texture", "displays",
+	};
+
+	fprintf(f, "{\n");
+	fprintf(f, "\t\"canvas\": {\"width\": %u, \"height\": %u, "
+		   "\"fps_num\": %u, \"fps_den\": %u},\n",
+		cfg->width, cfg->height, cfg->fps_num, cfg->fps_den);
+	fprintf(f, "\t\"sources\": {\"textures\": %d, \"async\": %d, "
+		   "\"tones\": %d},\n",
+		cfg->textures, cfg->async_sources, cfg->tones);
+	fprintf(f, "\t\"video_encoder\": \"%s\",\n", cfg->video_encoder);
+	fprintf(f, "\t\"audio_encoder\": \"%s\",\n", cfg->audio_encoder);
+	fprintf(f, "\t\"duration_s\": %d,\n", cfg->duration);
+	fprintf(f, "\t\"render_time_ns\": %llu,\n",
+		(unsigned long long)r->frame_time_ns);
+	fprintf(f, "\t\"readback_time_ns\": %llu,\n",
+		(unsigned long long)r->stage_ns[OBS_GPU_STAGE_STAGE_TEXTURE]);
+	fprintf(f, "\t\"encode_latency_ns\": %llu,\n",
+		(unsigned long long)r->encode_time_ns);
+
+	fprintf(f, "\t\"gpu_stage_time_ns\": {");
+	for (int i = 0; i < OBS_GPU_STAGE_COUNT; i++)
+		fprintf(f, "%s\"%s\": %llu", i ? ", " : "", stage_names[i],
+			(unsigned long long)r->stage_ns[i]);
+	fprintf(f, "},\n");
+
+	fprintf(f, "\t\"rendered_frames\": %u,\n", r->rendered_frames);
+	fprintf(f, "\t\"lagged_frames\": %u,\n", r->lagged_frames);
+	fprintf(f, "\t\"encoded_frames\": %u,\n", r->encoded_frames);
+	fprintf(f, "\t\"skipped_frames\": %u,\n", r->skipped_frames);
+	fprintf(f, "\t\"audio_buffering_ms\": %u,\n", r->audio_buffering_ms);
+	fprintf(f, "\t\"cpu_usage\": %.2f,\n", r->cpu_usage);
+	fprintf(f, "\t\"gpu_usage\": %.2f\n", r->gpu_usage);
+	fprintf(f, "}\n");
+}
+
+/* ------------------------------------------------------------------------- */
+/* setup                                                                     */
+
+static const char *default_graphics_module(void)
+{
+#ifdef _WIN32
+	return DL_D3D11;
+#else
+	return DL_OPENGL;
+#endif
+}
+
+static bool reset_core(const struct bench_config *cfg)
+{
+	struct obs_video_info ovi = {
+		.graphics_module = cfg->graphics_module,
+		.fps_num = cfg->fps_num,
+		.fps_den = cfg->fps_den,
+		.base_width = cfg->width,
+		.base_height = cfg->height,
+		.output_width = cfg->width,
+		.output_height = cfg->height,
+		.output_format = VIDEO_FORMAT_NV12,
+		.gpu_conversion = true,
+		.colorspace = VIDEO_CS_709,
+		.range = VIDEO_RANGE_PARTIAL,
+		.scale_type = OBS_SCALE_BICUBIC,
+	};
+
+	struct obs_audio_info oai = {
+		.samples_per_sec = 48000,
+		.speakers = SPEAKERS_STEREO,
+	};
+
+	int ret = obs_reset_video(&ovi);
+	if (ret != OBS_VIDEO_SUCCESS) {
+		fprintf(stderr, "obs_reset_video failed (%d)\n", ret);
+		return false;
+	}
+
+	if (!obs_reset_audio(&oai)) {
+		fprintf(stderr, "obs_reset_audio failed\n");
+		return false;
+	}
+
+	return true;
+}
+
+static obs_scene_t *create_scene(const struct bench_config *cfg)
+{
+	obs_scene_t *scene = obs_scene_create("bench");
+	struct dstr name = {0};
+
+	for (int i = 0; i < cfg->textures; i++) {
+		dstr_printf(&name, "texture %d", i);
+		obs_source_t *source = obs_source_create_private(
+			"bench_texture", name.array, NULL);
+		obs_scene_add(scene, source);
+		obs_source_release(source);
+	}
+
+	for (int i = 0; i < cfg->async_sources; i++) {
+		dstr_printf(&name, "async %d", i);
+		obs_source_t *source = obs_source_create_private(
+			"bench_async", name.array, NULL);
+		obs_scene_add(scene, source);
+		obs_source_release(source);
+	}
+
+	for (int i = 0; i < cfg->tones; i++) {
+		obs_data_t *settings = obs_data_create();
+		obs_data_set_double(settings, "frequency", 220.0 + 55.0 * i);
+
+		dstr_printf(&name, "tone %d", i);
+		obs_source_t *source = obs_source_create_private(
+			"bench_tone", name.array, settings);
+		obs_scene_add(scene, source);
+		obs_source_release(source);
+		obs_data_release(settings);
+	}
+
+	dstr_free(&name);
+	return scene;
+}
+
+static void sleep_seconds(int seconds)
+{
+	for (int i = 0; i < seconds * 10; i++)
+		os_sleep_ms(100);
+}
+
+static bool run_bench(const struct bench_config *cfg, obs_output_t *output,
+		      obs_encoder_t *venc, struct bench_results *r)
+{
+	struct bench_counters start, end;
+	os_cpu_usage_info_t *cpu_info;
+	uint64_t interval;
+	uint64_t gpu_ns = 0;
+
+	if (!obs_output_start(output)) {
+		const char *err = obs_output_get_last_error(output);
+		fprintf(stderr, "Failed to start output: %s\n",
+			err ? err : "unknown error");
+		return false;
+	}
+
+	sleep_seconds(cfg->warmup);
+
+	get_counters(&start);
+	int encoded_start = obs_output_get_total_frames(output);
+	cpu_info = os_cpu_usage_info_start();
+
+	sleep_seconds(cfg->duration);
+
+	r->cpu_usage = os_cpu_usage_info_query(cpu_info);
+	get_counters(&end);
+	r->encoded_frames =
+		(uint32_t)(obs_output_get_total_frames(output) - encoded_start);
+
+	r->frame_time_ns = obs_get_average_frame_time_ns();
+	r->encode_time_ns = obs_encoder_get_encode_time_ns(venc);
+	r->audio_buffering_ms = obs_get_audio_buffering_ms();
+	for (int i = 0; i < OBS_GPU_STAGE_COUNT; i++) {
+		r->stage_ns[i] = obs_get_gpu_stage_time_ns(i);
+		gpu_ns += r->stage_ns[i];
+	}
+
+	r->rendered_frames = end.total - start.total;
+	r->lagged_frames = end.lagged - start.lagged;
+	r->skipped_frames = end.skipped - start.skipped;
+
+	/* only the time libobs itself spends on the GPU, not other processes */
+	interval = obs_get_frame_interval_ns();
+	r->gpu_usage = interval ? (double)gpu_ns * 100.0 / (double)interval
+				: 0.0;
+
+	os_cpu_usage_info_destroy(cpu_info);
+	obs_output_stop(output);
+	return true;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* keep stdout clean for the JSON results */
+static void log_handler(int log_level, const char *msg, va_list args,
+			void *param)
+{
+	if (log_level <= LOG_INFO) {
+		vfprintf(stderr, msg, args);
+		fputc('\n', stderr);
+	}
+
+	UNUSED_PARAMETER(param);
+}
+
+static void print_usage(const char *exe)
+{
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  --canvas WxH          canvas size (default 1920x1080)\n"
+		"  --fps NUM[/DEN]       frame rate (default 60)\n"
+		"  --textures N          procedural textures (default 1)\n"
+		"  --async N             async video sources (default 1)\n"
+		"  --tones N             audio tone sources (default 2)\n"
+		"  --warmup SECONDS      time before sampling (default 3)\n"
+		"  --duration SECONDS    sampling time (default 10)\n"
+		"  --video-encoder ID    (default obs_x264)\n"
+		"  --audio-encoder ID    (default ffmpeg_aac)\n"
+		"  --graphics MODULE     graphics module to load\n"
+		"  --json PATH           write results to PATH, not stdout\n",
+		exe);
+}
+
+static bool parse_args(int argc, char *argv[], struct bench_config *cfg)
+{
+	for (int i = 1; i < argc; i++) {
+		const char *arg = argv[i];
+		const char *val = i + 1 < argc ? argv[i + 1] : NULL;
+
+		if (!val)
+			return false;
+
+		if (strcmp(arg, "--canvas") == 0) {
+			if (sscanf(val, "%ux%u", &cfg->width, &cfg->height) !=
+			    2)
+				return false;
+		} else if (strcmp(arg, "--fps") == 0) {
+			cfg->fps_den = 1;
+			if (sscanf(val, "%u/%u", &cfg->fps_num,
+				   &cfg->fps_den) < 1)
+				return false;
+		} else if (strcmp(arg, "--textures") == 0) {
+			cfg->textures = atoi(val);
+		} else if (strcmp(arg, "--async") == 0) {
+			cfg->async_sources = atoi(val);
+		} else if (strcmp(arg, "--tones") == 0) {
+			cfg->tones = atoi(val);
+		} else if (strcmp(arg, "--warmup") == 0) {
+			cfg->warmup = atoi(val);
+		} else if (strcmp(arg, "--duration") == 0) {
+			cfg->duration = atoi(val);
+		} else if (strcmp(arg, "--video-encoder") == 0) {
+			cfg->video_encoder = val;
+		} else if (strcmp(arg, "--audio-encoder") == 0) {
+			cfg->audio_encoder = val;
+		} else if (strcmp(arg, "--graphics") == 0) {
+			cfg->graphics_module = val;
+		} else if (strcmp(arg, "--json") == 0) {
+			cfg->output_path = val;
+		} else {
+			return false;
+		}
+
+		i++;
+	}
+
+	return cfg->width && cfg->height && cfg->fps_num && cfg->fps_den &&
+	       cfg->duration > 0;
+}
+
+int main(int argc, char *argv[])
+{
+	struct bench_config cfg = {
+		.width = 1920,
+		.height = 1080,
+		.fps_num = 60,
+		.fps_den = 1,
+		.textures = 1,
+		.async_sources = 1,
+		.tones = 2,
+		.warmup = 3,
+		.duration = 10,
+		.video_encoder = "obs_x264",
+		.audio_encoder = "ffmpeg_aac",
+		.graphics_module = default_graphics_module(),
+	};
+	struct bench_results results = {0};
+	obs_encoder_t *venc = NULL;
+	obs_encoder_t *aenc = NULL;
+	obs_output_t *output = NULL;
+	obs_scene_t *scene = NULL;
+	int ret = EXIT_FAILURE;
+
+	if (!parse_args(argc, argv, &cfg)) {
+		print_usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	base_set_log_handler(log_handler, NULL);
+
+	if (!obs_startup("en-US", NULL, NULL)) {
+		fprintf(stderr, "obs_startup failed\n");
+		return EXIT_FAILURE;
+	}
+
+	if (!reset_core(&cfg))
+		goto fail;
+
+	obs_load_all_modules();
+	obs_post_load_modules();
+
+	obs_register_source(&bench_texture_info);
+	obs_register_source(&bench_async_info);
+	obs_register_source(&bench_tone_info);
+
+	obs_set_gpu_timing_enabled(true);
+
+	scene = create_scene(&cfg);
+	obs_set_output_source(0, obs_scene_get_source(scene));
+
+	venc = obs_video_encoder_create(cfg.video_encoder, "bench video", NULL,
+					NULL);
+	aenc = obs_audio_encoder_create(cfg.audio_encoder, "bench audio", NULL,
+					0, NULL);
+	output = obs_output_create("null_output", "bench output", NULL, NULL);
+
+	if (!venc || !aenc || !output) {
+		fprintf(stderr, "Failed to create %s\n",
+			!venc   ? cfg.video_encoder
+			: !aenc ? cfg.audio_encoder
+				: "null_output");
+		goto fail;
+	}
+
+	obs_encoder_set_video(venc, obs_get_video());
+	obs_encoder_set_audio(aenc, obs_get_audio());
+	obs_output_set_video_encoder(output, venc);
+	obs_output_set_audio_encoder(output, aenc, 0);
+
+	if (!run_bench(&cfg, output, venc, &results))
+		goto fail;
+
+	if (cfg.output_path) {
+		FILE *f = os_fopen(cfg.output_path, "w");
+		if (!f) {
+			fprintf(stderr, "Failed to open '%s'\n",
+				cfg.output_path);
+			goto fail;
+		}
+		write_results(f, &cfg, &results);
+		fclose(f);
+	} else {
+		write_results(stdout, &cfg, &results);
+	}
+
+	ret = EXIT_SUCCESS;
+
+fail:
+	obs_set_output_source(0, NULL);
+	obs_output_release(output);
+	obs_encoder_release(venc);
+	obs_encoder_release(aenc);
+	obs_scene_release(scene);
+	obs_shutdown();
+	return ret;
+}
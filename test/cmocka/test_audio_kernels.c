@@ -0,0 +1,164 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <math.h>
+#include <cmocka.h>
+
+#include <media-io/audio-kernels.h>
+#include <media-io/audio-math.h>
+
+/* odd sizes exercise both the vector body and the scalar tail */
+#define NUM_SAMPLES 37
+
+static void kernel_add_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	float dst[NUM_SAMPLES + 1];
+	float src[NUM_SAMPLES];
+
+	for (size_t i = 0; i < NUM_SAMPLES; i++) {
+		dst[i + 1] = (float)i;
+		src[i] = (float)i * 0.5f;
+	}
+
+	/* unaligned destination, as mix_audio offsets into the mix buffer */
+	audio_kernel_add(dst + 1, src, NUM_SAMPLES);
+
+	for (size_t i = 0; i < NUM_SAMPLES; i++)
+		assert_true(dst[i + 1] == (float)i * 1.5f);
+}
+
+static void kernel_mul_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	float data[NUM_SAMPLES];
+	float vol[NUM_SAMPLES];
+
+	for (size_t i = 0; i < NUM_SAMPLES; i++) {
+		data[i] = (float)i;
+		vol[i] = (i & 1) ? 0.0f : 2.0f;
+	}
+
+	audio_kernel_mul(data, 0.5f, NUM_SAMPLES);
+	for (size_t i = 0; i < NUM_SAMPLES; i++)
+		assert_true(data[i] == (float)i * 0.5f);
+
+	audio_kernel_mul_buf(data, vol, NUM_SAMPLES);
+	for (size_t i = 0; i < NUM_SAMPLES; i++)
+		assert_true(data[i] == ((i & 1) ? 0.0f : (float)i));
+}
+
+static void kernel_silent_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	float data[NUM_SAMPLES] = {0};
+
+	assert_true(audio_kernel_is_silent(data, NUM_SAMPLES));
+
+	data[NUM_SAMPLES - 1] = -0.0f;
+	assert_true(audio_kernel_is_silent(data, NUM_SAMPLES));
+
+	data[NUM_SAMPLES - 1] = 1e-30f;
+	assert_true(!audio_kernel_is_silent(data, NUM_SAMPLES));
+
+	data[NUM_SAMPLES - 1] = 0.0f;
+	data[5] = NAN;
+	assert_true(!audio_kernel_is_silent(data, NUM_SAMPLES));
+}
+
+static void kernel_clamp_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	float data[NUM_SAMPLES];
+
+	for (size_t i = 0; i < NUM_SAMPLES; i++)
+		data[i] = ((float)i - 18.0f) * 0.1f;
+	data[3] = NAN;
+	data[NUM_SAMPLES - 1] = NAN;
+
+	audio_kernel_clamp(data, NUM_SAMPLES);
+
+	for (size_t i = 0; i < NUM_SAMPLES; i++) {
+		float expected = ((float)i - 18.0f) * 0.1f;
+		if (i == 3 || i == NUM_SAMPLES - 1)
+			expected = 0.0f;
+		else if (expected > 1.0f)
+			expected = 1.0f;
+		else if (expected < -1.0f)
+			expected = -1.0f;
+
+		assert_true(data[i] == expected);
+	}
+}
+
+static void kernel_levels_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	float data[NUM_SAMPLES + 1];
+	float sum = 0.0f;
+
+	for (size_t i = 0; i < NUM_SAMPLES; i++) {
+		data[i + 1] = (i & 1) ? -0.25f : 0.5f;
+		sum += data[i + 1] * data[i + 1];
+	}
+
+	/* the loudest sample sits in the scalar tail */
+	data[NUM_SAMPLES] = -0.75f;
+	sum += 0.75f * 0.75f - 0.5f * 0.5f;
+
+	assert_true(fabsf(audio_kernel_sum_squares(data + 1, NUM_SAMPLES) -
+			  sum) < 1e-5f);
+	assert_true(audio_kernel_abs_max(data + 1, NUM_SAMPLES) == 0.75f);
+}
+
+static void kernel_gain_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	float env[NUM_SAMPLES];
+	float db[NUM_SAMPLES];
+	float mul[NUM_SAMPLES];
+	float gain[NUM_SAMPLES];
+
+	for (size_t i = 0; i < NUM_SAMPLES; i++)
+		env[i] = powf(10.0f, -(float)i / 10.0f);
+	env[0] = 0.0f;
+
+	audio_kernel_mul_to_db(db, env, NUM_SAMPLES);
+	audio_kernel_db_to_mul(mul, db, 0.5f, NUM_SAMPLES);
+	audio_kernel_compress_gain(gain, env, -18.0f, 0.9f, 1.0f,
+				   NUM_SAMPLES);
+
+	/* silence is far below any threshold rather than -inf */
+	assert_true(db[0] < -700.0f);
+	assert_true(mul[0] < 1e-30f);
+	assert_true(gain[0] == 1.0f);
+
+	for (size_t i = 1; i < NUM_SAMPLES; i++) {
+		float ref_db = mul_to_db(env[i]);
+		float ref_gain = db_to_mul(fminf(0, 0.9f * (-18.0f - ref_db)));
+
+		assert_true(fabsf(db[i] - ref_db) < 1e-3f);
+		assert_true(fabsf(mul[i] / (env[i] * 0.5f) - 1.0f) < 1e-4f);
+		assert_true(fabsf(gain[i] / ref_gain - 1.0f) < 1e-4f);
+	}
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(kernel_add_test),
+		cmocka_unit_test(kernel_mul_test),
+		cmocka_unit_test(kernel_silent_test),
+		cmocka_unit_test(kernel_clamp_test),
+		cmocka_unit_test(kernel_levels_test),
+		cmocka_unit_test(kernel_gain_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
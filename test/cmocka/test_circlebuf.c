@@ -0,0 +1,101 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <util/circlebuf.h>
+
+static void circlebuf_wrap_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	struct circlebuf cb;
+	uint32_t out[8];
+	uint32_t next_in = 0;
+	uint32_t next_out = 0;
+
+	circlebuf_init(&cb);
+
+	/* stays below the minimum capacity, so the data has to wrap */
+	for (int i = 0; i < 100; i++) {
+		uint32_t in[3] = {next_in, next_in + 1, next_in + 2};
+		circlebuf_push_back(&cb, in, sizeof(in));
+		next_in += 3;
+
+		circlebuf_pop_front(&cb, out, sizeof(in));
+		for (int j = 0; j < 3; j++)
+			assert_int_equal(out[j], next_out++);
+	}
+
+	assert_int_equal(cb.capacity, CIRCLEBUF_MIN_CAPACITY);
+	circlebuf_free(&cb);
+}
+
+static void circlebuf_grow_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	struct circlebuf cb;
+	uint32_t next_in = 0;
+	uint32_t next_out = 0;
+	uint32_t val;
+
+	circlebuf_init(&cb);
+
+	/* grows while wrapped, which has to move the wrapped data */
+	for (int i = 0; i < 1000; i++) {
+		for (int j = 0; j < 3; j++, next_in++)
+			circlebuf_push_back(&cb, &next_in, sizeof(next_in));
+
+		circlebuf_pop_front(&cb, &val, sizeof(val));
+		assert_int_equal(val, next_out++);
+	}
+
+	assert_int_equal(cb.size, (next_in - next_out) * sizeof(val));
+	assert_int_equal(cb.capacity & (cb.capacity - 1), 0);
+
+	circlebuf_peek_back(&cb, &val, sizeof(val));
+	assert_int_equal(val, next_in - 1);
+
+	while (cb.size) {
+		circlebuf_pop_front(&cb, &val, sizeof(val));
+		assert_int_equal(val, next_out++);
+	}
+
+	circlebuf_free(&cb);
+}
+
+static void circlebuf_front_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	struct circlebuf cb;
+	uint32_t vals[4] = {1, 2, 3, 4};
+	uint32_t out[6];
+
+	circlebuf_init(&cb);
+	circlebuf_push_back(&cb, &vals[2], sizeof(uint32_t) * 2);
+	circlebuf_push_front(&cb, vals, sizeof(uint32_t) * 2);
+	circlebuf_push_front_zero(&cb, sizeof(uint32_t));
+	circlebuf_push_back_zero(&cb, sizeof(uint32_t));
+
+	assert_int_equal(cb.size, sizeof(out));
+	circlebuf_pop_front(&cb, out, sizeof(out));
+
+	assert_int_equal(out[0], 0);
+	assert_memory_equal(&out[1], vals, sizeof(vals));
+	assert_int_equal(out[5], 0);
+
+	circlebuf_free(&cb);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(circlebuf_wrap_test),
+		cmocka_unit_test(circlebuf_grow_test),
+		cmocka_unit_test(circlebuf_front_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
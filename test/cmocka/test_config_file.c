@@ -0,0 +1,79 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <cmocka.h>
+
+#include <util/config-file.h>
+
+static const char *ini = "[General]\n"
+			 "A=1\n"
+			 "b=two\n"
+			 "\n"
+			 "[Video]\n"
+			 "X=3\n"
+			 "[general]\n"
+			 "C=4\n"
+			 "A=9\n";
+
+static void lookup_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	config_t *config;
+	assert_int_equal(config_open_string(&config, ini), CONFIG_SUCCESS);
+
+	/* the first value wins, and repeated sections are merged */
+	assert_int_equal(config_get_int(config, "GENERAL", "a"), 1);
+	assert_string_equal(config_get_string(config, "general", "B"), "two");
+	assert_int_equal(config_get_int(config, "General", "C"), 4);
+	assert_int_equal(config_get_int(config, "Video", "x"), 3);
+	assert_int_equal(config_num_sections(config), 2);
+
+	config_set_default_int(config, "Video", "Y", 7);
+	assert_int_equal(config_get_int(config, "Video", "Y"), 7);
+	config_set_int(config, "video", "y", 8);
+	assert_int_equal(config_get_int(config, "Video", "Y"), 8);
+
+	config_close(config);
+}
+
+static void many_values_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	config_t *config;
+	char name[32];
+
+	assert_int_equal(config_open_string(&config, ""), CONFIG_SUCCESS);
+
+	for (int i = 0; i < 500; i++) {
+		snprintf(name, sizeof(name), "k%d", i);
+		config_set_int(config, name, name, i);
+		config_set_int(config, "Values", name, i);
+	}
+
+	for (int i = 0; i < 500; i += 2) {
+		snprintf(name, sizeof(name), "K%d", i);
+		assert_true(config_remove_value(config, "Values", name));
+	}
+
+	for (int i = 0; i < 500; i++) {
+		snprintf(name, sizeof(name), "K%d", i);
+		assert_int_equal(config_get_int(config, name, name), i);
+		assert_int_equal(config_has_user_value(config, "Values", name),
+				 i & 1);
+	}
+
+	config_close(config);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(lookup_test),
+		cmocka_unit_test(many_values_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
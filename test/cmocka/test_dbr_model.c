@@ -0,0 +1,189 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cmocka.h>
+
+#include "dbr-model.h"
+
+/* Replays network traces against the dynamic bitrate model.  The link is
+ * simulated in 100 ms steps: the encoder produces at the model's target,
+ * the link delivers at most its bandwidth, and whatever doesn't fit waits
+ * in the send queue.
+ *
+ * Set DBR_MODEL_TRACE to a file of "time_ms,bandwidth_kbps,rtt_ms" lines to
+ * replay a recorded trace as well; each line applies until the next one. */
+
+#define STEP_MS 100
+#define STEP_NS (STEP_MS * 1000000ULL)
+#define MAX_KBPS 6000
+#define MIN_KBPS 600
+
+struct trace_point {
+	uint64_t time_ms;
+	long bandwidth_kbps;
+	uint64_t rtt_ms;
+};
+
+struct link_sim {
+	struct dbr_model model;
+	double queued_kbit;
+	long target_kbps;
+	uint64_t now;
+	int64_t max_queued_usec;
+};
+
+static void sim_init(struct link_sim *sim)
+{
+	memset(sim, 0, sizeof(*sim));
+	sim->now = STEP_NS;
+	dbr_model_init(&sim->model, MIN_KBPS, MAX_KBPS, sim->now);
+	sim->target_kbps = MAX_KBPS;
+}
+
+static void sim_step(struct link_sim *sim, long bandwidth_kbps, uint64_t rtt_ms)
+{
+	double capacity = (double)bandwidth_kbps * STEP_MS / 1000.0;
+	double delivered;
+	int64_t queued_usec;
+	uint64_t rtt_us;
+
+	sim->queued_kbit += (double)sim->target_kbps * STEP_MS / 1000.0;
+	delivered = sim->queued_kbit < capacity ? sim->queued_kbit : capacity;
+	sim->queued_kbit -= delivered;
+
+	queued_usec = (int64_t)(sim->queued_kbit * 1000000.0 /
+				(double)sim->target_kbps);
+	if (queued_usec > sim->max_queued_usec)
+		sim->max_queued_usec = queued_usec;
+
+	/* part of the queue sits in the socket buffer and shows up as RTT */
+	rtt_us = rtt_ms * 1000;
+	if (sim->queued_kbit > 0.0)
+		rtt_us += (uint64_t)(queued_usec / 4);
+
+	sim->now += STEP_NS;
+	dbr_model_add_sample(&sim->model, sim->now,
+			     (long)(delivered * 1000.0 / STEP_MS), rtt_us);
+	sim->target_kbps = dbr_model_update(&sim->model, sim->now, queued_usec);
+}
+
+static void sim_run(struct link_sim *sim, long bandwidth_kbps,
+		    uint64_t rtt_ms, uint64_t duration_ms)
+{
+	for (uint64_t t = 0; t < duration_ms; t += STEP_MS)
+		sim_step(sim, bandwidth_kbps, rtt_ms);
+}
+
+static void bandwidth_drop_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	struct link_sim sim;
+	sim_init(&sim);
+
+	sim_run(&sim, 8000, 40, 20000);
+	assert_int_equal(sim.target_kbps, MAX_KBPS);
+
+	/* link drops well below the configured bitrate */
+	sim.max_queued_usec = 0;
+	sim_run(&sim, 3000, 40, 20000);
+	assert_true(dbr_model_bandwidth(&sim.model) <= 3000);
+	assert_true(dbr_model_bandwidth(&sim.model) >= 3000 * 9 / 10);
+	assert_true(sim.queued_kbit < 3000.0 / 2.0);
+
+	/* the queue must drain in a few seconds, not grow until frames drop */
+	assert_true(sim.max_queued_usec < 4000000);
+}
+
+static void bandwidth_recovery_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	struct link_sim sim;
+	sim_init(&sim);
+
+	sim_run(&sim, 8000, 40, 10000);
+	sim_run(&sim, 2000, 40, 20000);
+	assert_true(dbr_model_bandwidth(&sim.model) <= 2000);
+
+	/* probing has to find the extra bandwidth again */
+	sim_run(&sim, 8000, 40, 60000);
+	assert_int_equal(sim.target_kbps, MAX_KBPS);
+	assert_true(sim.queued_kbit < 1.0);
+}
+
+static void stable_link_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	struct link_sim sim;
+	sim_init(&sim);
+
+	/* link slightly below the configured bitrate, with a long RTT */
+	sim_run(&sim, 4500, 200, 10000);
+	sim.max_queued_usec = 0;
+	sim_run(&sim, 4500, 200, 60000);
+
+	assert_true(dbr_model_bandwidth(&sim.model) >= 4500 * 9 / 10);
+	assert_true(sim.max_queued_usec < 1000000);
+}
+
+static void recorded_trace_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	const char *path = getenv("DBR_MODEL_TRACE");
+	struct trace_point points[4096];
+	size_t num = 0;
+	struct link_sim sim;
+	FILE *f;
+
+	if (!path || !*path)
+		skip();
+
+	f = fopen(path, "r");
+	assert_non_null(f);
+
+	while (num < 4096) {
+		unsigned long long time_ms, rtt_ms;
+		long bandwidth;
+
+		if (fscanf(f, "%llu,%ld,%llu", &time_ms, &bandwidth,
+			   &rtt_ms) != 3)
+			break;
+
+		points[num].time_ms = time_ms;
+		points[num].bandwidth_kbps = bandwidth;
+		points[num].rtt_ms = rtt_ms;
+		num++;
+	}
+
+	fclose(f);
+	assert_true(num > 1);
+
+	sim_init(&sim);
+
+	for (size_t i = 0; i + 1 < num; i++) {
+		uint64_t duration = points[i + 1].time_ms - points[i].time_ms;
+		sim_run(&sim, points[i].bandwidth_kbps, points[i].rtt_ms,
+			duration);
+
+		/* the queue should never reach the frame dropping range */
+		assert_true(sim.max_queued_usec < 4000000);
+	}
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(bandwidth_drop_test),
+		cmocka_unit_test(bandwidth_recovery_test),
+		cmocka_unit_test(stable_link_test),
+		cmocka_unit_test(recorded_trace_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,196 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <string.h>
+#include <cmocka.h>
+
+#include <util/bmem.h>
+#include <media-io/format-conversion.h>
+
+/* not a multiple of any vector width, so the scalar tails get used too */
+#define WIDTH 44
+#define HEIGHT 6
+
+static void fill(uint8_t *data, size_t size, uint32_t seed)
+{
+	for (size_t i = 0; i < size; i++) {
+		seed = seed * 1103515245 + 12345;
+		data[i] = (uint8_t)(seed >> 16);
+	}
+}
+
+static void compress_420_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	const uint32_t in_linesize = WIDTH * 4;
+	uint8_t *input = bmalloc(in_linesize * HEIGHT);
+	uint8_t *planes = bzalloc(WIDTH * HEIGHT * 2);
+	uint8_t *nv12 = bzalloc(WIDTH * HEIGHT * 2);
+
+	uint8_t *i420_out[] = {planes, planes + WIDTH * HEIGHT,
+			       planes + WIDTH * HEIGHT * 5 / 4};
+	const uint32_t i420_linesize[] = {WIDTH, WIDTH / 2, WIDTH / 2};
+	uint8_t *nv12_out[] = {nv12, nv12 + WIDTH * HEIGHT};
+	const uint32_t nv12_linesize[] = {WIDTH, WIDTH};
+
+	fill(input, in_linesize * HEIGHT, 1);
+	compress_uyvx_to_i420(input, in_linesize, 0, HEIGHT, i420_out,
+			      i420_linesize);
+	compress_uyvx_to_nv12(input, in_linesize, 0, HEIGHT, nv12_out,
+			      nv12_linesize);
+
+	for (uint32_t y = 0; y < HEIGHT; y++) {
+		for (uint32_t x = 0; x < WIDTH; x++) {
+			const uint8_t *px = input + y * in_linesize + x * 4;
+			assert_int_equal(i420_out[0][y * WIDTH + x], px[1]);
+			assert_int_equal(nv12_out[0][y * WIDTH + x], px[1]);
+		}
+	}
+
+	for (uint32_t y = 0; y < HEIGHT / 2; y++) {
+		for (uint32_t x = 0; x < WIDTH / 2; x++) {
+			const uint8_t *p0 =
+				input + y * 2 * in_linesize + x * 8;
+			const uint8_t *p1 = p0 + in_linesize;
+			uint8_t u = (p0[0] + p0[4] + p1[0] + p1[4]) >> 2;
+			uint8_t v = (p0[2] + p0[6] + p1[2] + p1[6]) >> 2;
+			uint32_t pos = y * (WIDTH / 2) + x;
+
+			assert_int_equal(i420_out[1][pos], u);
+			assert_int_equal(i420_out[2][pos], v);
+			assert_int_equal(nv12_out[1][y * WIDTH + x * 2], u);
+			assert_int_equal(nv12_out[1][y * WIDTH + x * 2 + 1], v);
+		}
+	}
+
+	bfree(input);
+	bfree(planes);
+	bfree(nv12);
+}
+
+static void convert_444_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	const uint32_t in_linesize = WIDTH * 4;
+	uint8_t *input = bmalloc(in_linesize * HEIGHT);
+	uint8_t *planes = bzalloc(WIDTH * HEIGHT * 3);
+
+	uint8_t *output[] = {planes, planes + WIDTH * HEIGHT,
+			     planes + WIDTH * HEIGHT * 2};
+	const uint32_t out_linesize[] = {WIDTH, WIDTH, WIDTH};
+
+	fill(input, in_linesize * HEIGHT, 2);
+	convert_uyvx_to_i444(input, in_linesize, 0, HEIGHT, output,
+			     out_linesize);
+
+	for (uint32_t y = 0; y < HEIGHT; y++) {
+		for (uint32_t x = 0; x < WIDTH; x++) {
+			const uint8_t *px = input + y * in_linesize + x * 4;
+			uint32_t pos = y * WIDTH + x;
+
+			assert_int_equal(output[0][pos], px[1]);
+			assert_int_equal(output[1][pos], px[0]);
+			assert_int_equal(output[2][pos], px[2]);
+		}
+	}
+
+	bfree(input);
+	bfree(planes);
+}
+
+static void decompress_420_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	uint8_t *planes = bmalloc(WIDTH * HEIGHT * 3 / 2);
+	uint32_t *output = bzalloc(WIDTH * HEIGHT * 4);
+	uint32_t *nv12_output = bzalloc(WIDTH * HEIGHT * 4);
+
+	const uint8_t *const i420_in[] = {planes, planes + WIDTH * HEIGHT,
+					  planes + WIDTH * HEIGHT * 5 / 4};
+	const uint32_t i420_linesize[] = {WIDTH, WIDTH / 2, WIDTH / 2};
+	const uint8_t *const nv12_in[] = {planes, planes + WIDTH * HEIGHT};
+	const uint32_t nv12_linesize[] = {WIDTH, WIDTH};
+
+	fill(planes, WIDTH * HEIGHT * 3 / 2, 3);
+	decompress_420(i420_in, i420_linesize, 0, HEIGHT, (uint8_t *)output,
+		       WIDTH * 4);
+	decompress_nv12(nv12_in, nv12_linesize, 0, HEIGHT,
+			(uint8_t *)nv12_output, WIDTH * 4);
+
+	for (uint32_t y = 0; y < HEIGHT; y++) {
+		for (uint32_t x = 0; x < WIDTH; x++) {
+			uint32_t lum = i420_in[0][y * WIDTH + x];
+			uint32_t c = (y / 2) * (WIDTH / 2) + x / 2;
+			uint32_t u = i420_in[1][c];
+			uint32_t v = i420_in[2][c];
+			const uint8_t *uv =
+				nv12_in[1] + (y / 2) * WIDTH + x / 2 * 2;
+
+			assert_int_equal(output[y * WIDTH + x],
+					 (lum << 16) | (u << 8) | v);
+			assert_int_equal(nv12_output[y * WIDTH + x],
+					 lum | (uv[0] << 8) | (uv[1] << 16));
+		}
+	}
+
+	bfree(planes);
+	bfree(output);
+	bfree(nv12_output);
+}
+
+static void decompress_422_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	/* half of the smaller line size is taken as the number of input
+	 * dwords, which reads past the end of each input line */
+	const uint32_t in_linesize = WIDTH * 2;
+	const uint32_t out_linesize = WIDTH * 8;
+	uint8_t *input = bmalloc(in_linesize * (HEIGHT + 1));
+	uint32_t *output = bzalloc(out_linesize * HEIGHT);
+
+	fill(input, in_linesize * (HEIGHT + 1), 4);
+
+	for (int leading_lum = 0; leading_lum < 2; leading_lum++) {
+		decompress_422(input, in_linesize, 0, HEIGHT,
+			       (uint8_t *)output, out_linesize, leading_lum);
+
+		for (uint32_t y = 0; y < HEIGHT; y++) {
+			const uint8_t *line = input + y * in_linesize;
+			const uint32_t *out = output + y * WIDTH * 2;
+
+			for (uint32_t x = 0; x < WIDTH; x++) {
+				const uint8_t *p = line + x * 4;
+				uint32_t dw = p[0] | (p[1] << 8) |
+					      (p[2] << 16) |
+					      ((uint32_t)p[3] << 24);
+				uint32_t dw2 = leading_lum
+						       ? (dw & 0xFFFFFF00) |
+								 p[2]
+						       : (dw & 0xFFFF00FF) |
+								 (p[3] << 8);
+
+				assert_int_equal(out[x * 2], dw);
+				assert_int_equal(out[x * 2 + 1], dw2);
+			}
+		}
+	}
+
+	bfree(input);
+	bfree(output);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(compress_420_test),
+		cmocka_unit_test(convert_444_test),
+		cmocka_unit_test(decompress_420_test),
+		cmocka_unit_test(decompress_422_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
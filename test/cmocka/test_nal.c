@@ -0,0 +1,98 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <string.h>
+#include <cmocka.h>
+
+#include <util/bmem.h>
+#include <obs-nal.h>
+
+#define BUF_SIZE 200
+
+static void fill(uint8_t *data, size_t size, uint32_t seed)
+{
+	for (size_t i = 0; i < size; i++) {
+		seed = seed * 1103515245 + 12345;
+		/* plenty of zero bytes so near misses get tested too */
+		data[i] = (seed >> 16) % 3 ? (uint8_t)(seed >> 20) : 0;
+	}
+}
+
+/* plain version of the FFmpeg search, including not matching start codes
+ * in the last three bytes */
+static const uint8_t *ref_find_startcode(const uint8_t *p, const uint8_t *end)
+{
+	const uint8_t *start = p;
+	const uint8_t *out = end;
+
+	for (; end - p > 3; p++) {
+		if (p[0] == 0 && p[1] == 0 && p[2] == 1) {
+			out = p;
+			break;
+		}
+	}
+
+	if (start < out && out < end && !out[-1])
+		out--;
+	return out;
+}
+
+static void find_startcode_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	uint8_t *buf = bmalloc(BUF_SIZE);
+
+	for (uint32_t seed = 0; seed < 64; seed++) {
+		fill(buf, BUF_SIZE, seed);
+
+		for (size_t start = 0; start < 20; start++) {
+			for (size_t size = 0; size < BUF_SIZE - start;
+			     size++) {
+				const uint8_t *p = buf + start;
+				const uint8_t *end = p + size;
+
+				assert_ptr_equal(obs_nal_find_startcode(p, end),
+						 ref_find_startcode(p, end));
+			}
+		}
+	}
+
+	bfree(buf);
+}
+
+static void length_prefixed_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	static const uint8_t annexb[] = {
+		0, 0, 0, 1, 0x67, 1,    2, 3, /* 4 byte start code */
+		0, 0, 1,    0x68, 4,    5,    /* 3 byte start code */
+		0, 0, 0, 1, 0x65, 0, 0, 2, 6, /* zeros inside the unit */
+	};
+	static const uint8_t expected[] = {
+		0, 0, 0, 4, 0x67, 1,    2, 3,       0, 0, 0,
+		3, 0x68, 4, 5,    0,    0, 0, 5,    0x65, 0, 0,
+		2, 6,
+	};
+
+	size_t size = obs_nal_length_prefixed_size(annexb, sizeof(annexb));
+	assert_int_equal(size, sizeof(expected));
+
+	uint8_t *out = bmalloc(size);
+	obs_nal_write_length_prefixed(out, annexb, sizeof(annexb));
+	assert_memory_equal(out, expected, size);
+	bfree(out);
+
+	assert_int_equal(obs_nal_length_prefixed_size(annexb, 3), 0);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(find_startcode_test),
+		cmocka_unit_test(length_prefixed_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,164 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <obs-data.h>
+#include <util/platform.h>
+#include <util/dstr.h>
+
+#define NUM_KEYS 500
+
+static void make_key(struct dstr *key, int i)
+{
+	/* spread the keys out so they aren't inserted in sorted order */
+	dstr_printf(key, "key_%05d", (i * 7919) % NUM_KEYS);
+}
+
+static void lookup_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	obs_data_t *data = obs_data_create();
+	struct dstr key = {0};
+
+	for (int i = 0; i < NUM_KEYS; i++) {
+		make_key(&key, i);
+		obs_data_set_int(data, key.array, i);
+	}
+
+	for (int i = 0; i < NUM_KEYS; i++) {
+		make_key(&key, i);
+		assert_int_equal(obs_data_get_int(data, key.array), i);
+	}
+
+	assert_false(obs_data_has_user_value(data, "missing"));
+
+	/* items stay sorted by name no matter the insertion order */
+	obs_data_item_t *item = obs_data_first(data);
+	const char *prev = NULL;
+	size_t count = 0;
+	for (; item; obs_data_item_next(&item)) {
+		const char *name = obs_data_item_get_name(item);
+		if (prev)
+			assert_true(strcmp(prev, name) < 0);
+		prev = name;
+		count++;
+	}
+	assert_int_equal(count, NUM_KEYS);
+
+	dstr_free(&key);
+	obs_data_release(data);
+}
+
+static void modify_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	obs_data_t *data = obs_data_create();
+	struct dstr key = {0};
+	struct dstr value = {0};
+
+	for (int i = 0; i < NUM_KEYS; i++) {
+		make_key(&key, i);
+		obs_data_set_string(data, key.array, "a");
+	}
+
+	/* growing the values reallocates the items */
+	for (int i = 0; i < NUM_KEYS; i++) {
+		make_key(&key, i);
+		dstr_printf(&value, "a much longer string value %d", i);
+		obs_data_set_string(data, key.array, value.array);
+	}
+
+	for (int i = 0; i < NUM_KEYS; i += 2) {
+		make_key(&key, i);
+		obs_data_erase(data, key.array);
+	}
+
+	for (int i = 0; i < NUM_KEYS; i++) {
+		make_key(&key, i);
+		if (i % 2 == 0) {
+			assert_false(obs_data_has_user_value(data, key.array));
+		} else {
+			dstr_printf(&value, "a much longer string value %d",
+				    i);
+			assert_string_equal(
+				obs_data_get_string(data, key.array),
+				value.array);
+		}
+	}
+
+	dstr_free(&key);
+	dstr_free(&value);
+	obs_data_release(data);
+}
+
+static void json_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	obs_data_t *data = obs_data_create();
+	struct dstr key = {0};
+
+	for (int i = 0; i < NUM_KEYS; i++) {
+		make_key(&key, i);
+		obs_data_set_int(data, key.array, i);
+	}
+
+	obs_data_t *copy = obs_data_create_from_json(obs_data_get_json(data));
+	assert_string_equal(obs_data_get_json(copy), obs_data_get_json(data));
+
+	for (int i = 0; i < NUM_KEYS; i++) {
+		make_key(&key, i);
+		assert_int_equal(obs_data_get_int(copy, key.array), i);
+	}
+
+	dstr_free(&key);
+	obs_data_release(copy);
+	obs_data_release(data);
+}
+
+/* not a pass/fail test, just reports how long lookups take */
+static void lookup_benchmark(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	obs_data_t *data = obs_data_create();
+	struct dstr key = {0};
+	long long sum = 0;
+
+	for (int i = 0; i < NUM_KEYS; i++) {
+		make_key(&key, i);
+		obs_data_set_int(data, key.array, i);
+	}
+
+	uint64_t start = os_gettime_ns();
+	for (int n = 0; n < 200; n++) {
+		for (int i = 0; i < NUM_KEYS; i++) {
+			make_key(&key, i);
+			sum += obs_data_get_int(data, key.array);
+		}
+	}
+	uint64_t elapsed = os_gettime_ns() - start;
+
+	print_message("%d lookups in %d keys: %.1f ns per lookup\n",
+		      200 * NUM_KEYS, NUM_KEYS,
+		      (double)elapsed / (200.0 * NUM_KEYS));
+	assert_int_equal(sum, 200LL * NUM_KEYS * (NUM_KEYS - 1) / 2);
+
+	dstr_free(&key);
+	obs_data_release(data);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(lookup_test),
+		cmocka_unit_test(modify_test),
+		cmocka_unit_test(json_test),
+		cmocka_unit_test(lookup_benchmark),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}